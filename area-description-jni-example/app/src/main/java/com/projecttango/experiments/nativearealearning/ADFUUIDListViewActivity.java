@@ -28,6 +28,7 @@ import android.content.Context;
 import android.content.Intent;
 import android.content.pm.PackageInfo;
 import android.os.Bundle;
+import android.os.Handler;
 import android.util.Log;
 import android.view.ContextMenu;
 import android.view.ContextMenu.ContextMenuInfo;
@@ -109,7 +110,7 @@ class AdfUuidArrayAdapter extends ArrayAdapter<String> {
  * - Deleting an ADF owned by the Tango Service.
  */
 public class ADFUUIDListViewActivity extends Activity implements
-      SetADFNameDialog.CallbackListener {
+      View.OnClickListener, SetADFNameDialog.CallbackListener {
   private static final String INTENT_CLASS_PACKAGE = "com.projecttango.tango";
   private static final String INTENT_REQUEST_PERMISSION_CLASSNAME =
       "com.google.atap.tango.RequestPermissionActivity";
@@ -122,12 +123,29 @@ public class ADFUUIDListViewActivity extends Activity implements
   private static final String EXTRA_KEY_SOURCE_FILE = "SOURCE_FILE";
   private static final String EXTRA_KEY_DESTINATION_UUID = "DESTINATION_UUID";
 
+  // The interval at which the ADF transfer status is polled in milliseconds.
+  private static final int kTransferUpdateIntervalMs = 500;
+
   private ListView mTangoSpaceAdfListView, mAppSpaceAdfListView;
   private AdfUuidArrayAdapter mTangoSpaceAdfListAdapter, mAppSpaceAdfListAdapter;
   private ArrayList<AdfData> mTangoSpaceAdfDataList, mAppSpaceAdfDataList;
   private String[] mTangoSpaceMenuStrings, mAppSpaceMenuStrings;
   private String mAppSpaceADFFolder;
 
+  // UUID of the ADF being imported, its cached information is dropped once the
+  // import activity returns.
+  private String mImportingUuid;
+
+  // Shows the state of bulk ADF transfers while they run.
+  private TextView mTransferTextView;
+  private Handler mHandler = new Handler();
+  private Runnable mTransferUpdater = new Runnable() {
+    @Override
+    public void run() {
+      updateTransferStatus();
+    }
+  };
+
   @Override
   protected void onCreate(Bundle savedInstanceState) {
     super.onCreate(savedInstanceState);
@@ -162,6 +180,10 @@ public class ADFUUIDListViewActivity extends Activity implements
 
     registerForContextMenu(mTangoSpaceAdfListView);
     registerForContextMenu(mAppSpaceAdfListView);
+
+    mTransferTextView = (TextView) findViewById(R.id.adf_transfer_textview);
+    findViewById(R.id.export_all_button).setOnClickListener(this);
+    findViewById(R.id.import_all_button).setOnClickListener(this);
   }
   
   @Override
@@ -170,6 +192,30 @@ public class ADFUUIDListViewActivity extends Activity implements
     updateList();
   }
 
+  @Override
+  protected void onPause() {
+    super.onPause();
+    mHandler.removeCallbacks(mTransferUpdater);
+    // Store the renames made while the list was shown.
+    TangoJNINative.flushAdfMetadata();
+  }
+
+  @Override
+  public void onClick(View v) {
+    // Handle button clicks.
+    switch (v.getId()) {
+      case R.id.export_all_button:
+        exportAllAdfs();
+        break;
+      case R.id.import_all_button:
+        importAllAdfs();
+        break;
+      default:
+        Log.w("ADFUUIDListViewActivity", "Unknown button click");
+        return;
+    }
+  }
+
   @Override
   public void onCreateContextMenu(ContextMenu menu, View v,
       ContextMenuInfo menuInfo) {
@@ -228,6 +274,10 @@ public class ADFUUIDListViewActivity extends Activity implements
             Toast.makeText(this, R.string.no_permissions, Toast.LENGTH_LONG)
                     .show();
         }
+        if (mImportingUuid != null) {
+            TangoJNINative.invalidateAdfCatalog(mImportingUuid);
+            mImportingUuid = null;
+        }
     }
     updateList();
   }
@@ -253,6 +303,7 @@ public class ADFUUIDListViewActivity extends Activity implements
    */
   private void importAdf(String uuid) {
     String filepath = mAppSpaceADFFolder + File.separator + uuid;
+    mImportingUuid = uuid;
     Intent importIntent = new Intent();
     importIntent.setClassName(INTENT_CLASS_PACKAGE, INTENT_IMPORT_EXPORT_CLASSNAME);
     importIntent.putExtra(EXTRA_KEY_SOURCE_FILE, filepath);
@@ -263,6 +314,8 @@ public class ADFUUIDListViewActivity extends Activity implements
    * Export an ADF from Tango space to app space.
    */
   private void exportAdf(String uuid) {
+    // The exported file carries the metadata, store queued renames first.
+    TangoJNINative.flushAdfMetadata();
     Intent exportIntent = new Intent();
     exportIntent.setClassName(INTENT_CLASS_PACKAGE, INTENT_IMPORT_EXPORT_CLASSNAME);
     exportIntent.putExtra(EXTRA_KEY_SOURCE_UUID, uuid);
@@ -270,6 +323,47 @@ public class ADFUUIDListViewActivity extends Activity implements
     startActivityForResult(exportIntent, TANGO_INTENT_ACTIVITY_CODE);
   }
 
+  /**
+   * Queue exports of all Tango space ADFs into app space. The transfers run in
+   * the background, the status shows their progress.
+   */
+  private void exportAllAdfs() {
+    String[] uuids = new String[mTangoSpaceAdfDataList.size()];
+    for (int i = 0; i < uuids.length; ++i) {
+      uuids[i] = mTangoSpaceAdfDataList.get(i).mUuid;
+    }
+    TangoJNINative.exportAdfs(uuids, mAppSpaceADFFolder);
+    updateTransferStatus();
+  }
+
+  /**
+   * Queue imports of all app space ADFs into Tango space.
+   */
+  private void importAllAdfs() {
+    String[] filePaths = new String[mAppSpaceAdfDataList.size()];
+    for (int i = 0; i < filePaths.length; ++i) {
+      filePaths[i] =
+          mAppSpaceADFFolder + File.separator + mAppSpaceAdfDataList.get(i).mUuid;
+    }
+    TangoJNINative.importAdfs(filePaths);
+    updateTransferStatus();
+  }
+
+  /**
+   * Shows the transfer status and polls it until all transfers finished, then
+   * refreshes the lists.
+   */
+  private void updateTransferStatus() {
+    mTransferTextView.setVisibility(View.VISIBLE);
+    mTransferTextView.setText(TangoJNINative.getAdfTransferString());
+    mHandler.removeCallbacks(mTransferUpdater);
+    if (TangoJNINative.getAdfTransferPendingCount() > 0) {
+      mHandler.postDelayed(mTransferUpdater, kTransferUpdateIntervalMs);
+    } else {
+      updateList();
+    }
+  }
+
   private void deleteAdfFromTangoSpace(String uuid) {
     TangoJNINative.deleteAdf(uuid);
   }
@@ -290,6 +384,8 @@ public class ADFUUIDListViewActivity extends Activity implements
   }
 
   private void updateTangoSpaceAdfList() {
+    // The native ADF catalog caches the list and metadata, this only costs
+    // service calls after ADFs changed.
     StringTokenizer tok =
         new StringTokenizer(TangoJNINative.getAllAdfUuids(), ",");
     mTangoSpaceAdfDataList.clear();
@@ -122,6 +122,7 @@ public class AreaDescriptionActivity extends Activity implements
     // between the application and Tango Service.
     // The activity object is used for checking if the API version is outdated.
     TangoJNINative.initialize(this);
+    TangoJNINative.setAdfCacheDirectory(getCacheDir().getAbsolutePath());
 
     // UI thread handles the task of updating all debug text.
     startUIThread();
@@ -244,7 +245,8 @@ public class AreaDescriptionActivity extends Activity implements
 
   /**
    * Save the current Area Description File.
-   * Performs saving on a background thread and displays a progress dialog.
+   * Performs saving on a native background thread and displays a progress
+   * dialog, rendering continues meanwhile.
    */
   private void saveAdf(String adfName) {
     mSaveAdfTask = new SaveAdfTask(this, this, adfName);
@@ -277,15 +279,19 @@ public class AreaDescriptionActivity extends Activity implements
   }
 
   /**
-   * Updates the save progress dialog (called from area_learning_app.cc).
+   * Reports the end of the ADF save (called from area_learning_app.cc).
    */
-  public void updateSavingAdfProgress(int progress) {
-    // Note: this method is not called from the UI thread. We read mSaveAdfTask into
-    // a local variable because the UI thread may null-out the member variable at any time.
-    SaveAdfTask saveAdfTask = mSaveAdfTask;
-    if (saveAdfTask != null) {
-      saveAdfTask.publishProgress(progress);
-    }
+  public void onAdfSaveFinished(final String adfUuid) {
+    // Note: this method is called from the native save thread. The save task is
+    // only touched on the UI thread.
+    runOnUiThread(new Runnable() {
+      @Override
+      public void run() {
+        if (mSaveAdfTask != null) {
+          mSaveAdfTask.onSaveFinished(adfUuid);
+        }
+      }
+    });
   }
 
   // Query user's input for the Tango Service configuration.
@@ -400,6 +406,11 @@ public class AreaDescriptionActivity extends Activity implements
     mADFTDevicePoseData.setText(TangoJNINative.getAdfTDeviceString());
     mADFTStartServicePoseData.setText(TangoJNINative.getAdfTStartServiceString());
 
+    // Poll the progress of a running ADF save.
+    if (mSaveAdfTask != null) {
+      mSaveAdfTask.updateProgress();
+    }
+
     // If Tango has relocalized, allow saving the ADF.
     // Note: Tango returns TANGO_INVALID if saveAdf() is called before relocalization.
     if (TangoJNINative.isRelocalized()) {
@@ -17,14 +17,12 @@
 package com.projecttango.experiments.nativearealearning;
 
 import android.content.Context;
-import android.os.AsyncTask;
-import android.widget.Toast;
 
 /**
- * Saves the ADF on a background thread and shows a progress dialog while
- * saving.
+ * Saves the ADF on a native background thread and shows a progress dialog
+ * while saving. All methods are called from the UI thread.
  */
-public class SaveAdfTask extends AsyncTask<Void, Integer, String> {
+public class SaveAdfTask {
 
   public interface SaveAdfListener {
     void onSaveAdfFailed(String adfName);
@@ -44,51 +42,32 @@ public class SaveAdfTask extends AsyncTask<Void, Integer, String> {
   }
 
   /**
-   * Call this method to marshall progress updates to the UI thread.
+   * Shows the progress dialog and starts the save. The native code names the
+   * ADF once it is saved.
    */
-  public void publishProgress(int progress) {
-    super.publishProgress(progress);
-  }
-
-
-  /**
-   * Sets up the progress dialog.
-   */
-  @Override
-  protected void onPreExecute() {
+  public void execute() {
     if (mProgressDialog != null) {
       mProgressDialog.show();
     }
-  }
-
-  /**
-   * Performs long-running save in the background.
-   */
-  @Override
-  protected String doInBackground(Void... params) {
-    // This example implementation returns an empty-string on failure.
-    String adfUuid = TangoJNINative.saveAdf();
-    if (!adfUuid.isEmpty()) {
-      TangoJNINative.setAdfMetadataValue(adfUuid, "name", mAdfName);
+    if (!TangoJNINative.startSaveAdf(mAdfName)) {
+      // This example implementation reports failure with an empty-string.
+      onSaveFinished("");
     }
-    return adfUuid;
   }
 
   /**
-   * Responds to progress updates events by updating the UI.
+   * Polls the native save progress and updates the UI.
    */
-  @Override
-  protected void onProgressUpdate(Integer... progress) {
+  public void updateProgress() {
     if (mProgressDialog != null) {
-      mProgressDialog.setProgress(progress[0]);
+      mProgressDialog.setProgress(TangoJNINative.getSaveAdfProgress());
     }
   }
 
   /**
    * Dismisses the progress dialog and call the activity.
    */
-  @Override
-  protected void onPostExecute(String adfUuid) {
+  public void onSaveFinished(String adfUuid) {
     if (mProgressDialog != null) {
       mProgressDialog.dismiss();
     }
@@ -132,10 +132,18 @@ public class TangoJNINative {
   public static native String getLoadedADFUUIDString();
 
   /**
-   * Save ADF in learning mode.
-   * @return The ADF UUID.
+   * Start saving the ADF in learning mode on a native background thread. The
+   * activity's onAdfSaveFinished() is called when the save is done.
+   * @param name The name stored in the ADF metadata.
+   * @return true if the save was started.
    */
-  public static native String saveAdf();
+  public static native boolean startSaveAdf(String name);
+
+  /**
+   * Get the progress of the running ADF save.
+   * @return The progress in percent, 0 to 100.
+   */
+  public static native int getSaveAdfProgress();
 
   /**
    * Query metadata from an exsiting ADF using the key.
@@ -143,10 +151,22 @@ public class TangoJNINative {
   public static native String getAdfMetadataValue(String uuid, String key);
 
   /**
-   * Assign a key value of a specific ADF's metadata.
+   * Assign a key value of a specific ADF's metadata. The write is queued until
+   * flushAdfMetadata() is called, queries see the new value at once.
    */
   public static native void setAdfMetadataValue(String uuid, String key, String value);
 
+  /**
+   * Store all queued ADF metadata writes into the Tango Service.
+   */
+  public static native void flushAdfMetadata();
+
+  /**
+   * Drop cached information of an ADF that changed outside of the native code,
+   * e.g. by an import.
+   */
+  public static native void invalidateAdfCatalog(String uuid);
+
   /**
    * Query all ADF file's UUID, the string includes all UUIDs saperated by comma.
    */
@@ -156,4 +176,77 @@ public class TangoJNINative {
    * Delete a ADF from Tango space.
    */
   public static native void deleteAdf(String uuid);
+
+  /**
+   * Queue imports of ADF files into Tango space. The transfers run on native
+   * background threads.
+   */
+  public static native void importAdfs(String[] filePaths);
+
+  /**
+   * Queue exports of ADFs from Tango space into a directory. The transfers run
+   * on native background threads.
+   */
+  public static native void exportAdfs(String[] uuids, String directory);
+
+  /**
+   * Set the directory ADFs are prefetched into for switching.
+   */
+  public static native void setAdfCacheDirectory(String directory);
+
+  /**
+   * Switch to another ADF on a native background thread without
+   * disconnecting. Returns false in learning mode, where ADFs can't be
+   * switched.
+   */
+  public static native boolean switchAdf(String uuid);
+
+  /**
+   * Export an ADF ahead of a switch to it, on a native background thread.
+   */
+  public static native void prefetchAdf(String uuid);
+
+  /**
+   * Check if an ADF switch is queued or running.
+   */
+  public static native boolean isSwitchingAdf();
+
+  /**
+   * Get the number of queued and running ADF transfers.
+   */
+  public static native int getAdfTransferPendingCount();
+
+  /**
+   * Get the state, size and throughput of the ADF transfers for display.
+   */
+  public static native String getAdfTransferString();
+
+  /**
+   * Set the directory the Tango Service records datasets into, for the dataset
+   * size accounting, and refresh the dataset inventory.
+   */
+  public static native void setDatasetDirectory(String directory);
+
+  /**
+   * Refresh the dataset inventory on a native background thread.
+   */
+  public static native void refreshDatasets();
+
+  /**
+   * Queue deletes of datasets. The deletes run in one batch on a native
+   * background thread.
+   */
+  public static native void deleteDatasets(String[] uuids);
+
+  /**
+   * Queue deletes of the least recently modified datasets until the others fit
+   * into maxBytes. The dataset being recorded is never deleted.
+   * @return The number of datasets queued for deletion.
+   */
+  public static native int enforceDatasetQuota(long maxBytes);
+
+  /**
+   * Get the datasets and their sizes for display.
+   */
+  public static native String getDatasetString();
 }
@@ -13,6 +13,12 @@
 # See the License for the specific language governing permissions and
 # limitations under the License.
 #
+# arm64-v8a is built as well once the 64-bit Tango libraries are in
+# tango_client_api/lib/arm64-v8a and tango_support_api/lib/arm64-v8a. It
+# needs android-21, which ndk-build uses for 64-bit ABIs.
 APP_ABI := armeabi-v7a
+ifneq ($(wildcard $(NDK_PROJECT_PATH)/../../../../tango_client_api/lib/arm64-v8a),)
+APP_ABI += arm64-v8a
+endif
 APP_STL := gnustl_static
 APP_PLATFORM := android-19
\ No newline at end of file
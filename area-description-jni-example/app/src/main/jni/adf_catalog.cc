@@ -0,0 +1,272 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <string.h>
+
+#include <tango_client_api.h>  // NOLINT
+#include <tango-gl/util.h>
+
+#include "tango-area-learning/adf_catalog.h"
+
+namespace {
+// Metadata fetches wait on service round trips rather than compute, four in
+// flight (three workers and the caller) hide most of the latency.
+const int kLoaderThreads = 3;
+
+// Split a comma separated list returned by the Tango Service.
+void SplitList(const char* list, std::vector<std::string>* items) {
+  if (list == nullptr) {
+    return;
+  }
+  const char* begin = list;
+  while (*begin != '\0') {
+    const char* end = strchr(begin, ',');
+    if (end == nullptr) {
+      end = begin + strlen(begin);
+    }
+    if (end != begin) {
+      items->push_back(std::string(begin, end));
+    }
+    begin = (*end == ',') ? end + 1 : end;
+  }
+}
+}  // namespace
+
+namespace tango_area_learning {
+
+AdfCatalog::AdfCatalog()
+    : worker_pool_(new tango_gl::WorkerPool(kLoaderThreads)),
+      is_list_valid_(false) {}
+
+AdfCatalog::~AdfCatalog() { Flush(); }
+
+void AdfCatalog::GetUuids(std::vector<std::string>* adf_list) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Refresh();
+  for (const Entry& entry : entries_) {
+    adf_list->push_back(entry.uuid);
+  }
+}
+
+bool AdfCatalog::GetValue(const std::string& uuid, const std::string& key,
+                          std::string* value) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Refresh();
+  auto index = entry_index_.find(uuid);
+  if (index == entry_index_.end()) {
+    LOGE("AdfCatalog: Unknown ADF %s", uuid.c_str());
+    return false;
+  }
+  const Entry& entry = entries_[index->second];
+  auto it = entry.values.find(key);
+  if (it == entry.values.end()) {
+    return false;
+  }
+  *value = it->second;
+  return true;
+}
+
+void AdfCatalog::SetValue(const std::string& uuid, const std::string& key,
+                          const std::string& value) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  pending_writes_[uuid][key] = value;
+  auto index = entry_index_.find(uuid);
+  if (index != entry_index_.end()) {
+    entries_[index->second].values[key] = value;
+  }
+}
+
+bool AdfCatalog::Flush() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (pending_writes_.empty()) {
+    return true;
+  }
+
+  std::vector<const std::string*> uuids;
+  std::vector<const std::map<std::string, std::string>*> values;
+  for (const auto& writes : pending_writes_) {
+    uuids.push_back(&writes.first);
+    values.push_back(&writes.second);
+  }
+  std::vector<char> succeeded(uuids.size());
+  worker_pool_->ParallelFor(static_cast<int>(uuids.size()), [&](int i) {
+    succeeded[i] = StoreValues(*uuids[i], *values[i]);
+  });
+
+  bool all_succeeded = true;
+  for (size_t i = 0; i < uuids.size(); ++i) {
+    if (!succeeded[i]) {
+      // The cache kept the value the service refused, reload it.
+      auto index = entry_index_.find(*uuids[i]);
+      if (index != entry_index_.end()) {
+        entries_[index->second].is_loaded = false;
+      }
+      all_succeeded = false;
+    }
+  }
+  pending_writes_.clear();
+  return all_succeeded;
+}
+
+void AdfCatalog::Delete(const std::string& uuid) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  pending_writes_.erase(uuid);
+  int ret = TangoService_deleteAreaDescription(uuid.c_str());
+  if (ret != TANGO_SUCCESS) {
+    LOGE("AdfCatalog: Failed to delete ADF with error code: %d", ret);
+    is_list_valid_ = false;
+    return;
+  }
+
+  auto index = entry_index_.find(uuid);
+  if (index == entry_index_.end()) {
+    return;
+  }
+  entries_.erase(entries_.begin() + index->second);
+  entry_index_.clear();
+  for (size_t i = 0; i < entries_.size(); ++i) {
+    entry_index_[entries_[i].uuid] = i;
+  }
+}
+
+void AdfCatalog::Invalidate() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  is_list_valid_ = false;
+}
+
+void AdfCatalog::InvalidateEntry(const std::string& uuid) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto index = entry_index_.find(uuid);
+  if (index != entry_index_.end()) {
+    entries_[index->second].is_loaded = false;
+  }
+}
+
+void AdfCatalog::Refresh() {
+  if (!is_list_valid_) {
+    char* uuid_list = nullptr;
+    int ret = TangoService_getAreaDescriptionUUIDList(&uuid_list);
+    // uuid_list will contain a comma separated list of UUIDs.
+    if (ret != TANGO_SUCCESS) {
+      LOGE("AdfCatalog: get ADF UUID failed with error code: %d", ret);
+      return;
+    }
+    std::vector<std::string> uuids;
+    SplitList(uuid_list, &uuids);
+
+    // Keep the metadata of ADFs that are still listed.
+    std::vector<Entry> entries(uuids.size());
+    std::unordered_map<std::string, size_t> entry_index;
+    for (size_t i = 0; i < uuids.size(); ++i) {
+      auto old_index = entry_index_.find(uuids[i]);
+      if (old_index != entry_index_.end()) {
+        entries[i] = std::move(entries_[old_index->second]);
+      } else {
+        entries[i].uuid = uuids[i];
+        entries[i].is_loaded = false;
+      }
+      entry_index[uuids[i]] = i;
+    }
+    entries_.swap(entries);
+    entry_index_.swap(entry_index);
+    is_list_valid_ = true;
+  }
+
+  std::vector<Entry*> to_load;
+  for (Entry& entry : entries_) {
+    if (!entry.is_loaded) {
+      to_load.push_back(&entry);
+    }
+  }
+  if (to_load.empty()) {
+    return;
+  }
+  worker_pool_->ParallelFor(static_cast<int>(to_load.size()),
+                            [&](int i) { LoadEntry(to_load[i]); });
+
+  // Queued writes win over the values the service still has.
+  for (Entry* entry : to_load) {
+    auto writes = pending_writes_.find(entry->uuid);
+    if (writes != pending_writes_.end()) {
+      for (const auto& write : writes->second) {
+        entry->values[write.first] = write.second;
+      }
+    }
+  }
+}
+
+void AdfCatalog::LoadEntry(Entry* entry) {
+  entry->values.clear();
+  // Marked as loaded even on failure so a broken ADF is not fetched on every
+  // query, its values stay empty.
+  entry->is_loaded = true;
+
+  TangoAreaDescriptionMetadata metadata;
+  int ret =
+      TangoService_getAreaDescriptionMetadata(entry->uuid.c_str(), &metadata);
+  if (ret != TANGO_SUCCESS) {
+    LOGE("AdfCatalog: Failed to get ADF metadata with error code: %d", ret);
+    return;
+  }
+
+  char* key_list = nullptr;
+  ret = TangoAreaDescriptionMetadata_listKeys(metadata, &key_list);
+  if (ret != TANGO_SUCCESS) {
+    LOGE("AdfCatalog: Failed to list ADF metadata keys with error code: %d",
+         ret);
+  }
+  std::vector<std::string> keys;
+  SplitList(key_list, &keys);
+  for (const std::string& key : keys) {
+    size_t size = 0;
+    char* value = nullptr;
+    ret = TangoAreaDescriptionMetadata_get(metadata, key.c_str(), &size,
+                                           &value);
+    if (ret == TANGO_SUCCESS && value != nullptr) {
+      entry->values[key] = std::string(value, size);
+    }
+  }
+  TangoAreaDescriptionMetadata_free(metadata);
+}
+
+bool AdfCatalog::StoreValues(
+    const std::string& uuid, const std::map<std::string, std::string>& values) {
+  TangoAreaDescriptionMetadata metadata;
+  int ret = TangoService_getAreaDescriptionMetadata(uuid.c_str(), &metadata);
+  if (ret != TANGO_SUCCESS) {
+    LOGE("AdfCatalog: Failed to get ADF metadata with error code: %d", ret);
+    return false;
+  }
+  for (const auto& value : values) {
+    ret = TangoAreaDescriptionMetadata_set(metadata, value.first.c_str(),
+                                           value.second.size(),
+                                           value.second.c_str());
+    if (ret != TANGO_SUCCESS) {
+      LOGE("AdfCatalog: Failed to set ADF metadata %s with error code: %d",
+           value.first.c_str(), ret);
+    }
+  }
+  ret = TangoService_saveAreaDescriptionMetadata(uuid.c_str(), metadata);
+  TangoAreaDescriptionMetadata_free(metadata);
+  if (ret != TANGO_SUCCESS) {
+    LOGE("AdfCatalog: Failed to save ADF metadata with error code: %d", ret);
+    return false;
+  }
+  return true;
+}
+
+}  // namespace tango_area_learning
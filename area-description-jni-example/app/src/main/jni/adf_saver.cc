@@ -0,0 +1,103 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <algorithm>
+
+#include <tango_client_api.h>  // NOLINT
+#include <tango-gl/util.h>
+
+#include "tango-area-learning/adf_saver.h"
+
+namespace tango_area_learning {
+
+AdfSaver::AdfSaver() : is_saving_(false), progress_(0) {}
+
+AdfSaver::~AdfSaver() { Join(); }
+
+bool AdfSaver::Start(const std::string& name,
+                     const CompletionCallback& on_finished) {
+  std::lock_guard<std::mutex> lock(thread_mutex_);
+  if (is_saving_) {
+    LOGE("AdfSaver: A save is already running.");
+    return false;
+  }
+
+  // The previous save finished, only its thread is left to reclaim.
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+  progress_ = 0;
+  is_saving_ = true;
+  thread_ = std::thread(&AdfSaver::SaveThread, this, name, on_finished);
+  return true;
+}
+
+void AdfSaver::Join() {
+  std::lock_guard<std::mutex> lock(thread_mutex_);
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+void AdfSaver::OnSaveProgress(double fraction) {
+  if (!is_saving_) {
+    return;
+  }
+  int progress = static_cast<int>(fraction * 100.0);
+  progress_ = std::max(0, std::min(100, progress));
+}
+
+void AdfSaver::SaveThread(std::string name, CompletionCallback on_finished) {
+  std::string adf_uuid_string;
+  TangoUUID uuid;
+  int ret = TangoService_saveAreaDescription(&uuid);
+  if (ret == TANGO_SUCCESS) {
+    LOGI("AdfSaver: Successfully saved ADF with UUID: %s", uuid);
+    adf_uuid_string = std::string(uuid);
+  } else {
+    // Note: uuid is set to a nullptr in this case, so don't always try to
+    // construct a string from it!
+    LOGE("AdfSaver: Failed to save ADF with error code: %d", ret);
+  }
+
+  if (!adf_uuid_string.empty() && !name.empty()) {
+    TangoAreaDescriptionMetadata metadata;
+    ret = TangoService_getAreaDescriptionMetadata(adf_uuid_string.c_str(),
+                                                  &metadata);
+    if (ret == TANGO_SUCCESS) {
+      ret = TangoAreaDescriptionMetadata_set(metadata, "name", name.size(),
+                                             name.c_str());
+    }
+    if (ret == TANGO_SUCCESS) {
+      ret = TangoService_saveAreaDescriptionMetadata(adf_uuid_string.c_str(),
+                                                     metadata);
+    }
+    if (ret != TANGO_SUCCESS) {
+      LOGE("AdfSaver: Failed to set the ADF name with error code: %d", ret);
+    }
+  }
+
+  if (!adf_uuid_string.empty()) {
+    progress_ = 100;
+  }
+  is_saving_ = false;
+  if (on_finished) {
+    on_finished(adf_uuid_string);
+  }
+}
+
+}  // namespace tango_area_learning
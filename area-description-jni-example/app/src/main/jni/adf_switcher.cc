@@ -0,0 +1,189 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include <tango_client_api.h>  // NOLINT
+#include <tango-gl/util.h>
+
+#include "tango-area-learning/adf_switcher.h"
+
+namespace {
+bool FileExists(const std::string& path) {
+  struct stat file_stat;
+  return stat(path.c_str(), &file_stat) == 0 && file_stat.st_size > 0;
+}
+
+// Ask the kernel to read a file into the page cache in the background, so
+// the service's load does not wait on storage.
+void ReadAhead(const std::string& path) {
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return;
+  }
+  posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+  close(fd);
+}
+}  // namespace
+
+namespace tango_area_learning {
+
+AdfSwitcher::AdfSwitcher()
+    : is_busy_(false), is_switching_(false), is_stopping_(false) {
+  thread_ = std::thread(&AdfSwitcher::WorkerLoop, this);
+}
+
+AdfSwitcher::~AdfSwitcher() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    is_stopping_ = true;
+    prefetches_.clear();
+    pending_switch_.clear();
+  }
+  work_available_.notify_all();
+  thread_.join();
+}
+
+void AdfSwitcher::SetCacheDirectory(const std::string& directory) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  cache_directory_ = directory;
+}
+
+void AdfSwitcher::Prefetch(const std::string& uuid) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (std::find(prefetches_.begin(), prefetches_.end(), uuid) !=
+        prefetches_.end()) {
+      return;
+    }
+    prefetches_.push_back(uuid);
+  }
+  work_available_.notify_one();
+}
+
+void AdfSwitcher::SwitchTo(const std::string& uuid) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    pending_switch_ = uuid;
+  }
+  work_available_.notify_one();
+}
+
+void AdfSwitcher::Invalidate(const std::string& uuid) {
+  std::string directory;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    directory = cache_directory_;
+  }
+  if (!directory.empty()) {
+    unlink((directory + "/" + uuid).c_str());
+  }
+}
+
+void AdfSwitcher::Cancel() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  prefetches_.clear();
+  pending_switch_.clear();
+  work_finished_.wait(lock, [this] { return !is_busy_; });
+}
+
+std::string AdfSwitcher::GetLoadedUuid() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return loaded_uuid_;
+}
+
+bool AdfSwitcher::IsSwitching() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return is_switching_ || !pending_switch_.empty();
+}
+
+void AdfSwitcher::WorkerLoop() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    work_available_.wait(lock, [this] {
+      return is_stopping_ || (!cache_directory_.empty() &&
+                              (!pending_switch_.empty() ||
+                               !prefetches_.empty()));
+    });
+    if (is_stopping_) {
+      return;
+    }
+    const std::string directory = cache_directory_;
+    std::string uuid;
+    const bool is_switch = !pending_switch_.empty();
+    if (is_switch) {
+      uuid.swap(pending_switch_);
+      is_switching_ = true;
+    } else {
+      uuid = prefetches_.front();
+      prefetches_.pop_front();
+    }
+    is_busy_ = true;
+    lock.unlock();
+
+    const std::string path = PrefetchFile(directory, uuid);
+    bool succeeded = !path.empty();
+    if (is_switch && succeeded) {
+      TangoErrorType ret =
+          TangoService_Experimental_loadAreaDescriptionFromFile(path.c_str());
+      succeeded = ret == TANGO_SUCCESS;
+      if (succeeded) {
+        LOGI("AdfSwitcher: Switched to ADF %s", uuid.c_str());
+      } else {
+        LOGE("AdfSwitcher: Failed to load %s with error code: %d",
+             path.c_str(), ret);
+      }
+    }
+
+    lock.lock();
+    if (is_switch) {
+      if (succeeded) {
+        loaded_uuid_ = uuid;
+      }
+      is_switching_ = false;
+      if (on_switched_) {
+        lock.unlock();
+        on_switched_(uuid, succeeded);
+        lock.lock();
+      }
+    }
+    is_busy_ = false;
+    work_finished_.notify_all();
+  }
+}
+
+std::string AdfSwitcher::PrefetchFile(const std::string& directory,
+                                      const std::string& uuid) {
+  const std::string path = directory + "/" + uuid;
+  if (!FileExists(path)) {
+    int ret = TangoService_exportAreaDescription(uuid.c_str(),
+                                                 directory.c_str());
+    if (ret != TANGO_SUCCESS || !FileExists(path)) {
+      LOGE("AdfSwitcher: Failed to export %s with error code: %d",
+           uuid.c_str(), ret);
+      return std::string();
+    }
+  }
+  ReadAhead(path);
+  return path;
+}
+
+}  // namespace tango_area_learning
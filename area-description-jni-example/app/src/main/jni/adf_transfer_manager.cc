@@ -0,0 +1,246 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <sys/stat.h>
+
+#include <tango_client_api.h>  // NOLINT
+#include <tango-gl/util.h>
+
+#include "tango-area-learning/adf_transfer_manager.h"
+
+namespace {
+// Return the size of a file, 0 if it does not exist.
+uint64_t GetFileSize(const std::string& path) {
+  struct stat file_stat;
+  if (stat(path.c_str(), &file_stat) != 0) {
+    return 0;
+  }
+  return static_cast<uint64_t>(file_stat.st_size);
+}
+
+// Return the last path component, the UUID of an ADF file.
+std::string GetFileName(const std::string& path) {
+  size_t separator = path.find_last_of('/');
+  return separator == std::string::npos ? path : path.substr(separator + 1);
+}
+}  // namespace
+
+namespace tango_area_learning {
+
+AdfTransferManager::AdfTransferManager(int thread_count)
+    : thread_count_(thread_count),
+      is_stopping_(false),
+      next_id_(0),
+      running_count_(0),
+      finished_bytes_(0),
+      busy_seconds_(0.0) {}
+
+AdfTransferManager::~AdfTransferManager() { Stop(); }
+
+int AdfTransferManager::EnqueueImport(const std::string& file_path) {
+  return Enqueue(kImport, GetFileName(file_path), file_path);
+}
+
+int AdfTransferManager::EnqueueExport(const std::string& uuid,
+                                      const std::string& directory) {
+  return Enqueue(kExport, uuid, directory);
+}
+
+int AdfTransferManager::Enqueue(Direction direction, const std::string& uuid,
+                                const std::string& path) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  // Threads are started by the first transfer, most sessions never sync.
+  if (threads_.empty()) {
+    is_stopping_ = false;
+    for (int i = 0; i < thread_count_; ++i) {
+      threads_.push_back(std::thread(&AdfTransferManager::WorkerLoop, this));
+    }
+  }
+
+  Transfer transfer;
+  transfer.id = next_id_++;
+  transfer.direction = direction;
+  transfer.uuid = uuid;
+  transfer.path = path;
+  transfer.state = kQueued;
+  transfer.bytes = 0;
+  transfer.seconds = 0.0;
+  queued_.push_back(transfers_.size());
+  transfers_.push_back(transfer);
+  start_times_.push_back(Clock::time_point());
+  work_available_.notify_one();
+  return transfer.id;
+}
+
+void AdfTransferManager::GetTransfers(std::vector<Transfer>* transfers) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Clock::time_point now = Clock::now();
+  *transfers = transfers_;
+  for (size_t i = 0; i < transfers->size(); ++i) {
+    Transfer& transfer = (*transfers)[i];
+    if (transfer.state == kRunning) {
+      transfer.seconds =
+          std::chrono::duration<double>(now - start_times_[i]).count();
+    }
+  }
+}
+
+AdfTransferManager::Stats AdfTransferManager::GetStats() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Stats stats;
+  stats.queued = static_cast<int>(queued_.size());
+  stats.running = running_count_;
+  stats.succeeded = 0;
+  stats.failed = 0;
+  for (const Transfer& transfer : transfers_) {
+    if (transfer.state == kSucceeded) {
+      ++stats.succeeded;
+    } else if (transfer.state == kFailed) {
+      ++stats.failed;
+    }
+  }
+  stats.bytes = finished_bytes_;
+  double busy_seconds = GetBusySeconds(Clock::now());
+  stats.bytes_per_second =
+      busy_seconds > 0.0 ? finished_bytes_ / busy_seconds : 0.0;
+  return stats;
+}
+
+void AdfTransferManager::ClearFinished() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  // Queued and running transfers keep their order, queued_ is rebuilt for
+  // the new indices.
+  std::vector<Transfer> transfers;
+  std::vector<Clock::time_point> start_times;
+  std::deque<size_t> queued;
+  for (size_t i = 0; i < transfers_.size(); ++i) {
+    if (transfers_[i].state == kQueued || transfers_[i].state == kRunning) {
+      if (transfers_[i].state == kQueued) {
+        queued.push_back(transfers.size());
+      }
+      transfers.push_back(transfers_[i]);
+      start_times.push_back(start_times_[i]);
+    }
+  }
+  transfers_.swap(transfers);
+  start_times_.swap(start_times);
+  queued_.swap(queued);
+}
+
+void AdfTransferManager::Stop() {
+  std::vector<std::thread> threads;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    is_stopping_ = true;
+    for (size_t index : queued_) {
+      transfers_[index].state = kFailed;
+    }
+    queued_.clear();
+    work_available_.notify_all();
+    threads.swap(threads_);
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+}
+
+void AdfTransferManager::WorkerLoop() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    work_available_.wait(lock,
+                         [this] { return is_stopping_ || !queued_.empty(); });
+    if (is_stopping_) {
+      return;
+    }
+
+    // Indices change when finished transfers are cleared, so the running
+    // transfer is found again by id.
+    Transfer transfer = transfers_[queued_.front()];
+    queued_.pop_front();
+    Clock::time_point start = Clock::now();
+    if (running_count_++ == 0) {
+      busy_start_ = start;
+    }
+    for (size_t i = 0; i < transfers_.size(); ++i) {
+      if (transfers_[i].id == transfer.id) {
+        transfers_[i].state = kRunning;
+        start_times_[i] = start;
+      }
+    }
+
+    lock.unlock();
+    bool succeeded = RunTransfer(&transfer);
+    Clock::time_point end = Clock::now();
+    transfer.state = succeeded ? kSucceeded : kFailed;
+    transfer.seconds = std::chrono::duration<double>(end - start).count();
+    lock.lock();
+
+    if (--running_count_ == 0) {
+      busy_seconds_ +=
+          std::chrono::duration<double>(end - busy_start_).count();
+    }
+    finished_bytes_ += transfer.bytes;
+    for (size_t i = 0; i < transfers_.size(); ++i) {
+      if (transfers_[i].id == transfer.id) {
+        transfers_[i] = transfer;
+      }
+    }
+
+    if (on_finished_) {
+      lock.unlock();
+      on_finished_(transfer);
+      lock.lock();
+    }
+  }
+}
+
+bool AdfTransferManager::RunTransfer(Transfer* transfer) {
+  if (transfer->direction == kImport) {
+    TangoUUID uuid;
+    int ret = TangoService_importAreaDescription(transfer->path.c_str(), &uuid);
+    if (ret != TANGO_SUCCESS) {
+      LOGE("AdfTransferManager: Failed to import %s with error code: %d",
+           transfer->path.c_str(), ret);
+      return false;
+    }
+    transfer->uuid = std::string(uuid);
+    transfer->bytes = GetFileSize(transfer->path);
+    LOGI("AdfTransferManager: Imported ADF %s", transfer->uuid.c_str());
+    return true;
+  }
+
+  int ret = TangoService_exportAreaDescription(transfer->uuid.c_str(),
+                                               transfer->path.c_str());
+  if (ret != TANGO_SUCCESS) {
+    LOGE("AdfTransferManager: Failed to export %s with error code: %d",
+         transfer->uuid.c_str(), ret);
+    return false;
+  }
+  transfer->bytes = GetFileSize(transfer->path + "/" + transfer->uuid);
+  LOGI("AdfTransferManager: Exported ADF %s", transfer->uuid.c_str());
+  return true;
+}
+
+double AdfTransferManager::GetBusySeconds(Clock::time_point now) const {
+  double busy_seconds = busy_seconds_;
+  if (running_count_ > 0) {
+    busy_seconds += std::chrono::duration<double>(now - busy_start_).count();
+  }
+  return busy_seconds;
+}
+
+}  // namespace tango_area_learning
@@ -17,12 +17,40 @@
 #include <sstream>
 
 #include <tango-gl/conversions.h>
+#include <tango-gl/device_extrinsics.h>
+#include <tango-gl/program_cache.h>
+#include <tango-gl/render_state.h>
 
 #include "tango-area-learning/area_learning_app.h"
 
 namespace {
 const int kVersionStringLength = 128;
 
+// ADF transfers are bound by storage and the service, a second one in flight
+// overlaps their latencies and more would only compete for the disk.
+const int kAdfTransferThreads = 2;
+
+const double kBytesPerMegabyte = 1024.0 * 1024.0;
+
+// The range of a depth frame is the average depth of one point in this many,
+// the footprint does not need more.
+const uint32_t kDepthSampleStride = 16;
+
+// Footprints queued while the GL thread is not rendering, the oldest are
+// dropped past this.
+const size_t kMaxPendingFootprints = 16;
+
+// Check if two poses place the frame at the same position and orientation.
+bool IsSamePose(const TangoPoseData& a, const TangoPoseData& b) {
+  for (int i = 0; i < 3; ++i) {
+    if (a.translation[i] != b.translation[i]) return false;
+  }
+  for (int i = 0; i < 4; ++i) {
+    if (a.orientation[i] != b.orientation[i]) return false;
+  }
+  return true;
+}
+
 // This function routes onPoseAvailable callbacks to the application object for
 // handling.
 //
@@ -46,30 +74,108 @@ void onTangoEventAvailableRouter(void* context, const TangoEvent* event) {
   AreaLearningApp* app = static_cast<AreaLearningApp*>(context);
   app->onTangoEventAvailable(event);
 }
+
+// This function routes onXYZijAvailable callbacks to the application object
+// for handling.
+//
+// @param context, context will be a pointer to a AreaLearningApp
+//        instance on which to call callbacks.
+// @param xyz_ij, point cloud to route to onXYZijAvailable function.
+void onXYZijAvailableRouter(void* context, const TangoXYZij* xyz_ij) {
+  using namespace tango_area_learning;
+  AreaLearningApp* app = static_cast<AreaLearningApp*>(context);
+  app->onXYZijAvailable(xyz_ij);
+}
 }  // namespace
 
 namespace tango_area_learning {
 void AreaLearningApp::onPoseAvailable(const TangoPoseData* pose) {
-  std::lock_guard<std::mutex> lock(pose_mutex_);
+  std::lock_guard<std::mutex> lock(pose_update_mutex_);
   pose_data_.UpdatePose(*pose);
 }
 
 void AreaLearningApp::onTangoEventAvailable(const TangoEvent* event) {
-  std::lock_guard<std::mutex> lock(tango_event_mutex_);
   tango_event_data_.UpdateTangoEvent(event);
+  event_bus_.Publish(event);
+}
+
+void AreaLearningApp::onXYZijAvailable(const TangoXYZij* xyz_ij) {
+  float depth_sum = 0.0f;
+  uint32_t sample_count = 0;
+  for (uint32_t i = 0; i < static_cast<uint32_t>(xyz_ij->xyz_count);
+       i += kDepthSampleStride) {
+    depth_sum += xyz_ij->xyz[i][2];
+    ++sample_count;
+  }
+  if (sample_count == 0) {
+    return;
+  }
 
-  if (event->type == TangoEventType::TANGO_EVENT_AREA_LEARNING &&
-      !strcmp(event->event_key, "AreaDescriptionSaveProgress")) {
-    OnAdfSavingProgressChanged(std::atof(event->event_value) * 100);
+  TangoCoordinateFramePair frame_pair;
+  frame_pair.base = TANGO_COORDINATE_FRAME_START_OF_SERVICE;
+  frame_pair.target = TANGO_COORDINATE_FRAME_DEVICE;
+  TangoPoseData start_service_T_device;
+  if (TangoService_getPoseAtTime(xyz_ij->timestamp, frame_pair,
+                                 &start_service_T_device) != TANGO_SUCCESS ||
+      start_service_T_device.status_code != TANGO_POSE_VALID) {
+    return;
   }
+  Footprint footprint;
+  footprint.start_service_T_device =
+      tango_gl::conversions::TransformFromVecAndQuat(
+          glm::vec3(start_service_T_device.translation[0],
+                    start_service_T_device.translation[1],
+                    start_service_T_device.translation[2]),
+          glm::quat(start_service_T_device.orientation[3],
+                    start_service_T_device.orientation[0],
+                    start_service_T_device.orientation[1],
+                    start_service_T_device.orientation[2]));
+  footprint.range = depth_sum / sample_count;
+
+  std::lock_guard<std::mutex> lock(footprint_mutex_);
+  if (pending_footprints_.size() >= kMaxPendingFootprints) {
+    pending_footprints_.erase(pending_footprints_.begin());
+  }
+  pending_footprints_.push_back(footprint);
 }
 
-AreaLearningApp::AreaLearningApp() {
+AreaLearningApp::AreaLearningApp()
+    : adf_T_start_service_(),
+      is_area_learning_enabled_(false),
+      has_adf_switched_(false),
+      adf_transfer_manager_(kAdfTransferThreads),
+      has_depth_calibration_(false),
+      is_depth_calibration_new_(false),
+      depth_intrinsics_(),
+      device_T_depth_(1.0f),
+      has_motion_tracking_reset_(false) {
   tango_core_version_string_ = "N/A";
   loaded_adf_string_ = "Loaded ADF: N/A";
+
+  adf_transfer_manager_.SetCompletionCallback(
+      [this](const AdfTransferManager::Transfer& transfer) {
+        // An import adds or replaces an ADF.
+        if (transfer.direction == AdfTransferManager::kImport &&
+            transfer.state == AdfTransferManager::kSucceeded) {
+          adf_catalog_.Invalidate();
+          adf_catalog_.InvalidateEntry(transfer.uuid);
+          adf_switcher_.Invalidate(transfer.uuid);
+        }
+      });
+  adf_switcher_.SetCompletionCallback(
+      [this](const std::string& uuid, bool succeeded) {
+        OnAdfSwitched(uuid, succeeded);
+      });
+  event_bus_.Subscribe(tango_gl::EventBus::kAreaDescriptionSaveProgress,
+                       [this](const tango_gl::EventBus::Event& event) {
+                         if (event.has_number) {
+                           adf_saver_.OnSaveProgress(event.number);
+                         }
+                       });
 }
 
 AreaLearningApp::~AreaLearningApp() {
+  adf_transfer_manager_.Stop();
   TangoConfig_free(tango_config_);
   JNIEnv* env;
   java_vm_->GetEnv(reinterpret_cast<void**>(&env), JNI_VERSION_1_6);
@@ -77,14 +183,17 @@ AreaLearningApp::~AreaLearningApp() {
 }
 
 int AreaLearningApp::TangoInitialize(JNIEnv* env, jobject caller_activity) {
+  // Linked shader programs are persisted in the app cache directory.
+  tango_gl::program_cache::SetBinaryCacheDirectory(env, caller_activity);
+
   // The first thing we need to do for any Tango enabled application is to
   // initialize the service. We'll do that here, passing on the JNI environment
   // and jobject corresponding to the Android activity that is calling us.
   int ret = TangoService_initialize(env, caller_activity);
 
   jclass cls = env->GetObjectClass(caller_activity);
-  on_saving_adf_progress_updated_ =
-      env->GetMethodID(cls, "updateSavingAdfProgress", "(I)V");
+  on_adf_save_finished_ =
+      env->GetMethodID(cls, "onAdfSaveFinished", "(Ljava/lang/String;)V");
 
   calling_activity_obj_ =
       reinterpret_cast<jobject>(env->NewGlobalRef(caller_activity));
@@ -112,20 +221,43 @@ int AreaLearningApp::TangoSetupConfig(bool is_area_learning_enabled,
     return ret;
   }
 
-  // If load ADF, load the most recent saved ADF.
+  // Depth only feeds the coverage heatmap, showing what the learned area
+  // covers so far.
+  ret = TangoConfig_setBool(tango_config_, "config_enable_depth", true);
+  if (ret != TANGO_SUCCESS) {
+    LOGE("AreaLearningApp: config_enable_depth failed with error code: %d",
+         ret);
+    return ret;
+  }
+
+  is_area_learning_enabled_ = is_area_learning_enabled;
+  initial_adf_uuid_.clear();
+
+  // If load ADF, load the most recent saved ADF. Without learning mode it is
+  // loaded once connected instead, an ADF set in the configuration could not
+  // be switched.
   if (is_loading_adf) {
     std::vector<std::string> adf_list;
-    GetAdfUuids(&adf_list);
+    adf_catalog_.GetUuids(&adf_list);
     if (!adf_list.empty()) {
       std::string adf_uuid = adf_list.back();
       std::ostringstream adf_str_stream;
       adf_str_stream << "Number of ADFs:" << adf_list.size()
                      << ", Loaded ADF: " << adf_uuid;
-      loaded_adf_string_ = adf_str_stream.str();
-      ret = TangoConfig_setString(
-          tango_config_, "config_load_area_description_UUID", adf_uuid.c_str());
-      if (ret != TANGO_SUCCESS) {
-        LOGE("AreaLearningApp: get ADF UUID failed with error code: %d", ret);
+      {
+        std::lock_guard<std::mutex> lock(loaded_adf_mutex_);
+        loaded_adf_string_ = adf_str_stream.str();
+      }
+      if (is_area_learning_enabled) {
+        ret = TangoConfig_setString(tango_config_,
+                                    "config_load_area_description_UUID",
+                                    adf_uuid.c_str());
+        if (ret != TANGO_SUCCESS) {
+          LOGE("AreaLearningApp: get ADF UUID failed with error code: %d",
+               ret);
+        }
+      } else {
+        initial_adf_uuid_ = adf_uuid;
       }
     }
   }
@@ -136,23 +268,26 @@ int AreaLearningApp::TangoSetupConfig(bool is_area_learning_enabled,
 }
 
 int AreaLearningApp::TangoConnectCallbacks() {
-  // Setting up the frame pair for the onPoseAvailable callback.
-  TangoCoordinateFramePair pairs[3] = {
-      {TANGO_COORDINATE_FRAME_START_OF_SERVICE, TANGO_COORDINATE_FRAME_DEVICE},
-      {TANGO_COORDINATE_FRAME_AREA_DESCRIPTION, TANGO_COORDINATE_FRAME_DEVICE},
-      {TANGO_COORDINATE_FRAME_AREA_DESCRIPTION,
-       TANGO_COORDINATE_FRAME_START_OF_SERVICE}};
-
-  // Attach onPoseAvailable callback.
+  // Attach onPoseAvailable callback for the frame pairs pose_data_ fans out.
   // The callback will be called after the service is connected.
-  int ret =
-      TangoService_connectOnPoseAvailable(3, pairs, onPoseAvailableRouter);
+  int ret = TangoService_connectOnPoseAvailable(
+      pose_data_.GetFramePairCount(), pose_data_.GetFramePairs(),
+      onPoseAvailableRouter);
   if (ret != TANGO_SUCCESS) {
     LOGE("AreaLearningApp: Failed to connect to pose callback with error"
          "code: %d", ret);
     return ret;
   }
 
+  // Attach onXYZijAvailable callback.
+  // The callback will be called after the service is connected.
+  ret = TangoService_connectOnXYZijAvailable(onXYZijAvailableRouter);
+  if (ret != TANGO_SUCCESS) {
+    LOGE("AreaLearningApp: Failed to connect to point cloud callback with "
+         "error code: %d", ret);
+    return ret;
+  }
+
   // Attach onEventAvailable callback.
   // The callback will be called after the service is connected.
   ret = TangoService_connectOnTangoEvent(onTangoEventAvailableRouter);
@@ -172,6 +307,24 @@ bool AreaLearningApp::TangoConnect() {
   if (!is_connected) {
     LOGE("AreaLearningApp: Failed to connect to the Tango service with"
          "error code: %d", ret);
+  } else {
+    if (!initial_adf_uuid_.empty()) {
+      adf_switcher_.SwitchTo(initial_adf_uuid_);
+    }
+    // Without the depth camera calibration the heatmap stays empty.
+    TangoCameraIntrinsics depth_intrinsics;
+    tango_gl::DeviceExtrinsics extrinsics;
+    if (TangoService_getCameraIntrinsics(TANGO_CAMERA_DEPTH,
+                                         &depth_intrinsics) == TANGO_SUCCESS &&
+        extrinsics.Query() == TANGO_SUCCESS) {
+      std::lock_guard<std::mutex> lock(footprint_mutex_);
+      depth_intrinsics_ = depth_intrinsics;
+      device_T_depth_ = extrinsics.GetDeviceTDepth();
+      has_depth_calibration_ = true;
+      is_depth_calibration_new_ = true;
+    } else {
+      LOGE("AreaLearningApp: Failed to get the depth camera calibration.");
+    }
   }
   return is_connected;
 }
@@ -181,7 +334,10 @@ void AreaLearningApp::TangoDisconnect() {
   // free your configuration object. Note that disconnecting from the service,
   // resets all configuration, and disconnects all callbacks. If an application
   // resumes after disconnecting, it must re-register configuration and
-  // callbacks with the service.
+  // callbacks with the service. A running save or ADF switch needs the
+  // connection, so it is waited for first.
+  adf_saver_.Join();
+  adf_switcher_.Cancel();
   TangoConfig_free(tango_config_);
   tango_config_ = nullptr;
   TangoService_disconnect();
@@ -189,135 +345,275 @@ void AreaLearningApp::TangoDisconnect() {
 
 void AreaLearningApp::TangoResetMotionTracking() {
   TangoService_resetMotionTracking();
+  has_motion_tracking_reset_ = true;
 }
 
-std::string AreaLearningApp::SaveAdf() {
-  std::string adf_uuid_string;
-  if(!pose_data_.IsRelocalized()) {
-    return adf_uuid_string;
+bool AreaLearningApp::StartSaveAdf(const std::string& name) {
+  if (!pose_data_.IsRelocalized()) {
+    LOGE("AreaLearningApp: Can't save the ADF before relocalization.");
+    return false;
   }
-  TangoUUID uuid;
-  int ret = TangoService_saveAreaDescription(&uuid);
-  if (ret == TANGO_SUCCESS) {
-    LOGI("AreaLearningApp: Successfully saved ADF with UUID: %s", uuid);
-    adf_uuid_string = std::string(uuid);
-  } else {
-    // Note: uuid is set to a nullptr in this case, so don't always try to
-    // construct a string from it!
-    LOGE("AreaLearningApp: Failed to save ADF with error code: %d", ret);
-  }
-  return adf_uuid_string;
+  return adf_saver_.Start(name, [this](const std::string& uuid) {
+    // The new ADF is picked up by the next catalog query.
+    adf_catalog_.Invalidate();
+    OnAdfSaveFinished(uuid);
+  });
 }
 
 std::string AreaLearningApp::GetAdfMetadataValue(const std::string& uuid,
                                                  const std::string& key) {
-  size_t size = 0;
-  char* output;
-  TangoAreaDescriptionMetadata metadata;
-
-  // Get the metadata object from the Tango Service.
-  int ret = TangoService_getAreaDescriptionMetadata(uuid.c_str(), &metadata);
-  if (ret != TANGO_SUCCESS) {
-    LOGE("AreaLearningApp: Failed to get ADF metadata with error code: %d",
-         ret);
-  }
-
-  // Query specific key-value from the metadata object.
-  ret = TangoAreaDescriptionMetadata_get(metadata, key.c_str(), &size, &output);
-  if (ret != TANGO_SUCCESS) {
-    LOGE(
-        "AreaLearningApp: Failed to get ADF metadata value with error "
-        "code: %d",
-        ret);
+  std::string value;
+  if (!adf_catalog_.GetValue(uuid, key, &value)) {
+    LOGE("AreaLearningApp: Failed to get ADF metadata value %s", key.c_str());
   }
-  return std::string(output);
+  // Values are returned as C strings.
+  return std::string(value.c_str());
 }
 
 void AreaLearningApp::SetAdfMetadataValue(const std::string& uuid,
                                           const std::string& key,
                                           const std::string& value) {
-  TangoAreaDescriptionMetadata metadata;
-  int ret = TangoService_getAreaDescriptionMetadata(uuid.c_str(), &metadata);
-  if (ret != TANGO_SUCCESS) {
-    LOGE("AreaLearningApp: Failed to get ADF metadata with error code: %d",
-         ret);
-  }
-  ret = TangoAreaDescriptionMetadata_set(metadata, key.c_str(), value.size(),
-                                         value.c_str());
-  if (ret != TANGO_SUCCESS) {
-    LOGE("AreaLearningApp: Failed to set ADF metadata with error code: %d",
-         ret);
+  adf_catalog_.SetValue(uuid, key, value);
+}
+
+std::string AreaLearningApp::GetAllAdfUuids() {
+  std::vector<std::string> adf_list;
+  adf_catalog_.GetUuids(&adf_list);
+  std::string uuid_list;
+  for (const std::string& uuid : adf_list) {
+    if (!uuid_list.empty()) {
+      uuid_list += ',';
+    }
+    uuid_list += uuid;
   }
-  ret = TangoService_saveAreaDescriptionMetadata(uuid.c_str(), metadata);
-  if (ret != TANGO_SUCCESS) {
-    LOGE("AreaLearningApp: Failed to save ADF metadata with error code: %d",
-         ret);
+  return uuid_list;
+}
+
+void AreaLearningApp::DeleteAdf(std::string uuid) {
+  adf_catalog_.Delete(uuid);
+  adf_switcher_.Invalidate(uuid);
+}
+
+void AreaLearningApp::InvalidateAdfCatalog(const std::string& uuid) {
+  adf_catalog_.Invalidate();
+  adf_catalog_.InvalidateEntry(uuid);
+}
+
+void AreaLearningApp::ImportAdf(const std::string& file_path) {
+  adf_transfer_manager_.EnqueueImport(file_path);
+}
+
+void AreaLearningApp::ExportAdf(const std::string& uuid,
+                                const std::string& directory) {
+  // The exported file carries the metadata, store queued writes first.
+  adf_catalog_.Flush();
+  adf_transfer_manager_.EnqueueExport(uuid, directory);
+}
+
+bool AreaLearningApp::SwitchAdf(const std::string& uuid) {
+  if (is_area_learning_enabled_) {
+    LOGE("AreaLearningApp: Can't switch ADFs in learning mode.");
+    return false;
   }
+  adf_switcher_.SwitchTo(uuid);
+  return true;
 }
 
-std::string AreaLearningApp::GetAllAdfUuids() {
-  TangoConfig tango_config_ = TangoService_getConfig(TANGO_CONFIG_DEFAULT);
-  if (tango_config_ == nullptr) {
-    LOGE("AreaLearningApp: Failed to get default config form");
+void AreaLearningApp::OnAdfSwitched(const std::string& uuid, bool succeeded) {
+  if (!succeeded) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(loaded_adf_mutex_);
+    loaded_adf_string_ = "Loaded ADF: " + uuid;
+  }
+  // Poses in the old ADF frame are meaningless now, wait for the new
+  // relocalization.
+  {
+    std::lock_guard<std::mutex> lock(pose_update_mutex_);
+    pose_data_.ResetPoseData();
   }
+  has_adf_switched_ = true;
 
-  // Get all ADF's uuids.
-  char* uuid_list = nullptr;
-  int ret = TangoService_getAreaDescriptionUUIDList(&uuid_list);
-  // uuid_list will contain a comma separated list of UUIDs.
-  if (ret != TANGO_SUCCESS) {
-    LOGE("AreaLearningApp: get ADF UUID failed with error code: %d", ret);
+  // Roaming devices mostly go back to the area they came from.
+  if (!previous_adf_uuid_.empty() && previous_adf_uuid_ != uuid) {
+    adf_switcher_.Prefetch(previous_adf_uuid_);
   }
-  return std::string(uuid_list);
+  previous_adf_uuid_ = uuid;
 }
 
-void AreaLearningApp::DeleteAdf(std::string uuid) {
-  TangoService_deleteAreaDescription(uuid.c_str());
+int AreaLearningApp::GetAdfTransferPendingCount() {
+  AdfTransferManager::Stats stats = adf_transfer_manager_.GetStats();
+  return stats.queued + stats.running;
+}
+
+std::string AreaLearningApp::GetAdfTransferString() {
+  static const char* kStateNames[] = {"queued", "running", "done", "failed"};
+  std::vector<AdfTransferManager::Transfer> transfers;
+  adf_transfer_manager_.GetTransfers(&transfers);
+  AdfTransferManager::Stats stats = adf_transfer_manager_.GetStats();
+
+  std::ostringstream stream;
+  stream.precision(2);
+  stream << std::fixed;
+  for (const AdfTransferManager::Transfer& transfer : transfers) {
+    stream << (transfer.direction == AdfTransferManager::kImport ? "Import "
+                                                                 : "Export ")
+           << transfer.uuid << ": " << kStateNames[transfer.state];
+    if (transfer.state == AdfTransferManager::kSucceeded &&
+        transfer.seconds > 0.0) {
+      stream << ", " << transfer.bytes / kBytesPerMegabyte << " MB, "
+             << transfer.bytes / kBytesPerMegabyte / transfer.seconds
+             << " MB/s";
+    } else if (transfer.state == AdfTransferManager::kRunning) {
+      stream << ", " << transfer.seconds << " s";
+    }
+    stream << "\n";
+  }
+  stream << stats.succeeded << " done, " << stats.failed << " failed, "
+         << stats.running << " running, " << stats.queued << " queued, "
+         << stats.bytes_per_second / kBytesPerMegabyte << " MB/s";
+  return stream.str();
+}
+
+void AreaLearningApp::SetDatasetDirectory(const std::string& directory) {
+  dataset_catalog_.SetDatasetDirectory(directory);
+  dataset_catalog_.Refresh();
+}
+
+std::string AreaLearningApp::GetDatasetString() {
+  std::vector<DatasetCatalog::Dataset> datasets;
+  if (!dataset_catalog_.GetDatasets(&datasets)) {
+    return "Datasets: loading";
+  }
+
+  std::ostringstream stream;
+  stream.precision(2);
+  stream << std::fixed;
+  for (const DatasetCatalog::Dataset& dataset : datasets) {
+    stream << "Dataset " << dataset.uuid << ": "
+           << dataset.bytes / kBytesPerMegabyte << " MB";
+    if (dataset.is_current) {
+      stream << ", recording";
+    }
+    if (dataset.is_deleting) {
+      stream << ", deleting";
+    }
+    stream << "\n";
+  }
+  stream << datasets.size() << " datasets, "
+         << dataset_catalog_.GetTotalBytes() / kBytesPerMegabyte << " MB, "
+         << dataset_catalog_.GetPendingDeleteCount() << " deletes pending";
+  return stream.str();
 }
 
-void AreaLearningApp::InitializeGLContent() { main_scene_.InitGLContent(); }
+void AreaLearningApp::InitializeGLContent() {
+  // Anything RenderState remembers belongs to the previous GL context.
+  tango_gl::RenderState::Invalidate();
+  main_scene_.InitGLContent();
+}
 
 void AreaLearningApp::SetViewPort(int width, int height) {
   main_scene_.SetupViewPort(width, height);
 }
 
 void AreaLearningApp::Render() {
+  tango_gl::RenderState::BeginFrame();
+  event_bus_.Dispatch();
+  touch_queue_.Drain([this](const tango_gl::TouchQueue::Touch& touch) {
+    main_scene_.OnTouchEvent(touch.touch_count, touch.event, touch.x0,
+                             touch.y0, touch.x1, touch.y1);
+  });
+
   // Query current pose data.
-  TangoPoseData cur_pose;
+  TangoPoseData cur_pose = pose_data_.GetCurrentPoseData();
+
+  // The ADF trace is in the frame of the ADF switched away from.
+  if (has_adf_switched_.exchange(false)) {
+    adf_T_start_service_ = TangoPoseData();
+    main_scene_.ClearAdfTrace();
+  }
+
+  // Move the ADF trace along when the localization corrects the start service
+  // frame, before this frame's poses are added to it.
+  if (pose_data_.IsRelocalized()) {
+    TangoPoseData adf_T_start_service = pose_data_.GetAdfTStartServicePose();
+    if (adf_T_start_service.timestamp != adf_T_start_service_.timestamp) {
+      if (adf_T_start_service_.status_code == TANGO_POSE_VALID &&
+          adf_T_start_service.status_code == TANGO_POSE_VALID &&
+          !IsSamePose(adf_T_start_service_, adf_T_start_service)) {
+        main_scene_.CorrectAdfTrace(adf_T_start_service_, adf_T_start_service);
+      }
+      adf_T_start_service_ = adf_T_start_service;
+    }
+  }
+  // Poses queued before a switch were dropped by ResetPoseData(), so the
+  // ones left are in the frame of the current ADF.
+  TangoPoseData trajectory_pose;
+  while (pose_data_.PopTrajectoryPose(&trajectory_pose)) {
+    main_scene_.AddTrajectoryPose(trajectory_pose);
+  }
+  AddCoverage();
+  main_scene_.Render(cur_pose);
+}
+
+void AreaLearningApp::AddCoverage() {
+  std::vector<Footprint> footprints;
+  glm::mat4 device_T_depth;
   {
-    std::lock_guard<std::mutex> lock(pose_mutex_);
-    cur_pose = pose_data_.GetCurrentPoseData();
+    std::lock_guard<std::mutex> lock(footprint_mutex_);
+    if (has_motion_tracking_reset_.exchange(false)) {
+      pending_footprints_.clear();
+      main_scene_.ClearCoverage();
+    }
+    if (!has_depth_calibration_) {
+      return;
+    }
+    if (is_depth_calibration_new_) {
+      main_scene_.SetDepthCameraIntrinsics(depth_intrinsics_);
+      is_depth_calibration_new_ = false;
+    }
+    footprints.swap(pending_footprints_);
+    device_T_depth = device_T_depth_;
+  }
+  for (const Footprint& footprint : footprints) {
+    main_scene_.AddCoverage(footprint.start_service_T_device * device_T_depth,
+                            footprint.range);
   }
-  main_scene_.Render(cur_pose, pose_data_.IsRelocalized());
 }
 
 void AreaLearningApp::FreeContent() {
-  pose_data_.ResetPoseData();
+  {
+    std::lock_guard<std::mutex> lock(pose_update_mutex_);
+    pose_data_.ResetPoseData();
+  }
+  {
+    std::lock_guard<std::mutex> lock(footprint_mutex_);
+    pending_footprints_.clear();
+    // The new scene needs the intrinsics again.
+    is_depth_calibration_new_ = has_depth_calibration_;
+  }
+  adf_T_start_service_ = TangoPoseData();
   main_scene_.FreeGLContent();
 }
 
 bool AreaLearningApp::IsRelocalized() {
-  std::lock_guard<std::mutex> lock(pose_mutex_);
   return pose_data_.IsRelocalized();
 }
 
 std::string AreaLearningApp::GetStartServiceTDeviceString() {
-  std::lock_guard<std::mutex> lock(pose_mutex_);
   return pose_data_.GetStartServiceTDeviceString();
 }
 
 std::string AreaLearningApp::GetAdfTDeviceString() {
-  std::lock_guard<std::mutex> lock(pose_mutex_);
   return pose_data_.GetAdfTDeviceString();
 }
 
 std::string AreaLearningApp::GetAdfTStartServiceString() {
-  std::lock_guard<std::mutex> lock(pose_mutex_);
   return pose_data_.GetAdfTStartServiceString();
 }
 
 std::string AreaLearningApp::GetEventString() {
-  std::lock_guard<std::mutex> lock(tango_event_mutex_);
   return tango_event_data_.GetTangoEventString().c_str();
 }
 
@@ -333,31 +629,7 @@ void AreaLearningApp::SetCameraType(
 void AreaLearningApp::OnTouchEvent(int touch_count,
                                       tango_gl::GestureCamera::TouchEvent event,
                                       float x0, float y0, float x1, float y1) {
-  main_scene_.OnTouchEvent(touch_count, event, x0, y0, x1, y1);
-}
-
-void AreaLearningApp::GetAdfUuids(std::vector<std::string>* adf_list) {
-  // Get all ADF's uuids.
-  char* uuid_list = nullptr;
-  int ret = TangoService_getAreaDescriptionUUIDList(&uuid_list);
-  // uuid_list will contain a comma separated list of UUIDs.
-  if (ret != TANGO_SUCCESS) {
-    LOGE("AreaLearningApp: get ADF UUID failed with error code: %d", ret);
-  }
-
-  // Parse the uuid_list to get the individual uuids.
-  if (uuid_list != nullptr) {
-    if (uuid_list[0] != '\0') {
-      char* parsing_char;
-      char* saved_ptr;
-      parsing_char = strtok_r(uuid_list, ",", &saved_ptr);
-      while (parsing_char != nullptr) {
-        std::string str = std::string(parsing_char);
-        adf_list->push_back(str);
-        parsing_char = strtok_r(nullptr, ",", &saved_ptr);
-      }
-    }
-  }
+  touch_queue_.Push(touch_count, event, x0, y0, x1, y1);
 }
 
 std::string AreaLearningApp::GetTangoServiceVersion() {
@@ -373,13 +645,19 @@ std::string AreaLearningApp::GetTangoServiceVersion() {
   return std::string(version_buffer);
 }
 
-void AreaLearningApp::OnAdfSavingProgressChanged(int progress) {
-  // Here, we notify the Java activity that we'd like it to update the saving
-  // Adf progress.
+void AreaLearningApp::OnAdfSaveFinished(const std::string& uuid) {
+  // Here, we notify the Java activity that the save is done. The save thread
+  // is not known to the Java VM, so it is attached for the call.
   JNIEnv* env;
-  java_vm_->GetEnv(reinterpret_cast<void**>(&env), JNI_VERSION_1_6);
-  env->CallVoidMethod(calling_activity_obj_, on_saving_adf_progress_updated_,
-                      progress);
+  if (java_vm_->AttachCurrentThread(&env, nullptr) != JNI_OK) {
+    LOGE("AreaLearningApp: Failed to attach the ADF save thread.");
+    return;
+  }
+  jstring uuid_string = env->NewStringUTF(uuid.c_str());
+  env->CallVoidMethod(calling_activity_obj_, on_adf_save_finished_,
+                      uuid_string);
+  env->DeleteLocalRef(uuid_string);
+  java_vm_->DetachCurrentThread();
 }
 
 }  // namespace tango_area_learning
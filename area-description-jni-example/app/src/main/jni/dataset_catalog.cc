@@ -0,0 +1,294 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <dirent.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+
+#include <tango_client_api.h>  // NOLINT
+#include <tango-gl/util.h>
+
+#include "tango-area-learning/dataset_catalog.h"
+
+namespace {
+// Return the bytes of the files below a path, and its last modification.
+uint64_t GetTreeSize(const std::string& path, int64_t* modified_time) {
+  struct stat file_stat;
+  if (lstat(path.c_str(), &file_stat) != 0) {
+    return 0;
+  }
+  *modified_time = std::max(*modified_time,
+                            static_cast<int64_t>(file_stat.st_mtime));
+  if (!S_ISDIR(file_stat.st_mode)) {
+    return static_cast<uint64_t>(file_stat.st_size);
+  }
+
+  DIR* directory = opendir(path.c_str());
+  if (directory == nullptr) {
+    return 0;
+  }
+  uint64_t bytes = 0;
+  while (const struct dirent* entry = readdir(directory)) {
+    if (strcmp(entry->d_name, ".") != 0 && strcmp(entry->d_name, "..") != 0) {
+      bytes += GetTreeSize(path + "/" + entry->d_name, modified_time);
+    }
+  }
+  closedir(directory);
+  return bytes;
+}
+}  // namespace
+
+namespace tango_area_learning {
+
+DatasetCatalog::DatasetCatalog()
+    : is_stopping_(false), is_refresh_requested_(false), is_loaded_(false) {}
+
+DatasetCatalog::~DatasetCatalog() { Stop(); }
+
+void DatasetCatalog::SetDatasetDirectory(const std::string& directory) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  directory_ = directory;
+}
+
+void DatasetCatalog::Refresh() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  StartWorker();
+  is_refresh_requested_ = true;
+  work_available_.notify_one();
+}
+
+bool DatasetCatalog::GetDatasets(std::vector<Dataset>* datasets) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  *datasets = datasets_;
+  return is_loaded_;
+}
+
+uint64_t DatasetCatalog::GetTotalBytes() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  uint64_t bytes = 0;
+  for (const Dataset& dataset : datasets_) {
+    if (!dataset.is_deleting) {
+      bytes += dataset.bytes;
+    }
+  }
+  return bytes;
+}
+
+void DatasetCatalog::Delete(const std::vector<std::string>& uuids) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (const std::string& uuid : uuids) {
+    auto it = std::find_if(
+        datasets_.begin(), datasets_.end(),
+        [&uuid](const Dataset& dataset) { return dataset.uuid == uuid; });
+    if (it != datasets_.end()) {
+      QueueDelete(&*it);
+    } else if (deleting_.insert(uuid).second) {
+      // Not in the inventory yet, the service still knows whether it exists.
+      StartWorker();
+      queued_deletes_.push_back(uuid);
+    }
+  }
+  work_available_.notify_one();
+}
+
+int DatasetCatalog::EnforceQuota(uint64_t max_bytes) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  uint64_t bytes = 0;
+  std::vector<Dataset*> candidates;
+  for (Dataset& dataset : datasets_) {
+    if (!dataset.is_deleting) {
+      bytes += dataset.bytes;
+      if (!dataset.is_current) {
+        candidates.push_back(&dataset);
+      }
+    }
+  }
+  std::sort(candidates.begin(), candidates.end(),
+            [](const Dataset* a, const Dataset* b) {
+              return a->modified_time < b->modified_time;
+            });
+
+  int count = 0;
+  for (Dataset* dataset : candidates) {
+    if (bytes <= max_bytes) {
+      break;
+    }
+    bytes -= dataset->bytes;
+    QueueDelete(dataset);
+    ++count;
+  }
+  if (count > 0) {
+    work_available_.notify_one();
+  }
+  return count;
+}
+
+int DatasetCatalog::GetPendingDeleteCount() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return static_cast<int>(deleting_.size());
+}
+
+void DatasetCatalog::Stop() {
+  std::thread thread;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    is_stopping_ = true;
+    is_refresh_requested_ = false;
+    for (const std::string& uuid : queued_deletes_) {
+      deleting_.erase(uuid);
+    }
+    queued_deletes_.clear();
+    for (Dataset& dataset : datasets_) {
+      dataset.is_deleting = deleting_.count(dataset.uuid) > 0;
+    }
+    work_available_.notify_all();
+    thread.swap(thread_);
+  }
+  if (thread.joinable()) {
+    thread.join();
+  }
+}
+
+void DatasetCatalog::StartWorker() {
+  // The thread is started by the first request, most sessions never manage
+  // datasets.
+  if (!thread_.joinable()) {
+    is_stopping_ = false;
+    thread_ = std::thread(&DatasetCatalog::WorkerLoop, this);
+  }
+}
+
+void DatasetCatalog::QueueDelete(Dataset* dataset) {
+  if (dataset->is_deleting) {
+    return;
+  }
+  StartWorker();
+  dataset->is_deleting = true;
+  deleting_.insert(dataset->uuid);
+  queued_deletes_.push_back(dataset->uuid);
+}
+
+void DatasetCatalog::WorkerLoop() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    work_available_.wait(lock, [this] {
+      return is_stopping_ || is_refresh_requested_ || !queued_deletes_.empty();
+    });
+    if (is_stopping_) {
+      return;
+    }
+
+    // Deletes go first, the refresh after them then sees the space they
+    // freed.
+    if (!queued_deletes_.empty()) {
+      std::vector<std::string> uuids;
+      uuids.swap(queued_deletes_);
+      lock.unlock();
+      std::vector<char> succeeded(uuids.size());
+      for (size_t i = 0; i < uuids.size(); ++i) {
+        int ret = TangoService_Experimental_deleteDataset(uuids[i].c_str());
+        if (ret != TANGO_SUCCESS) {
+          LOGE("DatasetCatalog: Failed to delete dataset %s with error code: %d",
+               uuids[i].c_str(), ret);
+        }
+        succeeded[i] = ret == TANGO_SUCCESS;
+      }
+      lock.lock();
+
+      for (size_t i = 0; i < uuids.size(); ++i) {
+        deleting_.erase(uuids[i]);
+        auto it = std::find_if(
+            datasets_.begin(), datasets_.end(),
+            [&uuids, i](const Dataset& dataset) {
+              return dataset.uuid == uuids[i];
+            });
+        if (it == datasets_.end()) {
+          continue;
+        }
+        if (succeeded[i]) {
+          datasets_.erase(it);
+        } else {
+          it->is_deleting = false;
+        }
+      }
+      continue;
+    }
+
+    is_refresh_requested_ = false;
+    const std::string directory = directory_;
+    std::map<std::string, Dataset> known;
+    for (const Dataset& dataset : datasets_) {
+      known[dataset.uuid] = dataset;
+    }
+    lock.unlock();
+    std::vector<Dataset> datasets;
+    bool succeeded = LoadDatasets(directory, known, &datasets);
+    lock.lock();
+
+    if (succeeded) {
+      for (Dataset& dataset : datasets) {
+        dataset.is_deleting = deleting_.count(dataset.uuid) > 0;
+      }
+      datasets_.swap(datasets);
+      is_loaded_ = true;
+    }
+  }
+}
+
+bool DatasetCatalog::LoadDatasets(const std::string& directory,
+                                  const std::map<std::string, Dataset>& known,
+                                  std::vector<Dataset>* datasets) {
+  TangoUUID* uuids = nullptr;
+  int uuid_count = 0;
+  int ret = TangoService_Experimental_getDatasetUUIDs(&uuids, &uuid_count);
+  if (ret != TANGO_SUCCESS) {
+    LOGE("DatasetCatalog: Failed to list datasets with error code: %d", ret);
+    return false;
+  }
+
+  TangoUUID current_uuid;
+  current_uuid[0] = '\0';
+  ret = TangoService_Experimental_getCurrentDatasetUUID(&current_uuid);
+  if (ret != TANGO_SUCCESS) {
+    current_uuid[0] = '\0';
+  }
+
+  datasets->resize(uuid_count);
+  for (int i = 0; i < uuid_count; ++i) {
+    Dataset& dataset = (*datasets)[i];
+    dataset.uuid = std::string(uuids[i]);
+    dataset.is_current = dataset.uuid == current_uuid;
+
+    auto it = known.find(dataset.uuid);
+    if (it != known.end() && !dataset.is_current && !it->second.is_current) {
+      dataset.bytes = it->second.bytes;
+      dataset.modified_time = it->second.modified_time;
+      continue;
+    }
+    dataset.modified_time = 0;
+    dataset.bytes = directory.empty()
+                        ? 0
+                        : GetTreeSize(directory + "/" + dataset.uuid,
+                                      &dataset.modified_time);
+  }
+  TangoService_Experimental_releaseDatasetUUIDs(&uuids);
+  return true;
+}
+
+}  // namespace tango_area_learning
@@ -17,179 +17,314 @@
 #define GLM_FORCE_RADIANS
 
 #include <jni.h>
+#include <tango-gl/jni_natives.h>
 #include <tango-area-learning/area_learning_app.h>
 #include <tango-area-learning/scene.h>
 
-static tango_area_learning::AreaLearningApp app;
+namespace {
+tango_area_learning::AreaLearningApp app;
 
-#ifdef __cplusplus
-extern "C" {
-#endif
-jint JNI_OnLoad(JavaVM* vm, void*) {
-  // We need to store a reference to the Java VM so that we can call into the
-  // Java layer to trigger rendering.
-  app.SetJavaVM(vm);
-  return JNI_VERSION_1_6;
-}
-
-JNIEXPORT jint JNICALL
-Java_com_projecttango_experiments_nativearealearning_TangoJNINative_initialize(
-    JNIEnv* env, jobject, jobject activity) {
+jint Initialize(JNIEnv* env, jobject, jobject activity) {
   return app.TangoInitialize(env, activity);
 }
 
-JNIEXPORT jint JNICALL
-Java_com_projecttango_experiments_nativearealearning_TangoJNINative_setupConfig(
-    JNIEnv*, jobject, bool is_area_learningEnabled, bool is_loading_adf) {
+jint SetupConfig(JNIEnv*, jobject, bool is_area_learningEnabled,
+                 bool is_loading_adf) {
   return app.TangoSetupConfig(is_area_learningEnabled, is_loading_adf);
 }
 
-JNIEXPORT jboolean JNICALL
-Java_com_projecttango_experiments_nativearealearning_TangoJNINative_connect(
-    JNIEnv*, jobject) {
+jboolean Connect(JNIEnv*, jobject) {
   return app.TangoConnect();
 }
 
-JNIEXPORT jint JNICALL
-Java_com_projecttango_experiments_nativearealearning_TangoJNINative_connectCallbacks(
-    JNIEnv*, jobject) {
+jint ConnectCallbacks(JNIEnv*, jobject) {
   int ret = app.TangoConnectCallbacks();
   return ret;
 }
 
-JNIEXPORT void JNICALL
-Java_com_projecttango_experiments_nativearealearning_TangoJNINative_disconnect(
-    JNIEnv*, jobject) {
+void Disconnect(JNIEnv*, jobject) {
   app.TangoDisconnect();
 }
 
-JNIEXPORT void JNICALL
-Java_com_projecttango_experiments_nativearealearning_TangoJNINative_resetMotionTracking(
-    JNIEnv*, jobject) {
+void ResetMotionTracking(JNIEnv*, jobject) {
   app.TangoResetMotionTracking();
 }
 
-JNIEXPORT void JNICALL
-Java_com_projecttango_experiments_nativearealearning_TangoJNINative_initGlContent(
-    JNIEnv*, jobject) {
+void InitGlContent(JNIEnv*, jobject) {
   app.InitializeGLContent();
 }
 
-JNIEXPORT void JNICALL
-Java_com_projecttango_experiments_nativearealearning_TangoJNINative_setupGraphics(
-    JNIEnv*, jobject, jint width, jint height) {
+void SetupGraphics(JNIEnv*, jobject, jint width, jint height) {
   app.SetViewPort(width, height);
 }
 
-JNIEXPORT void JNICALL
-Java_com_projecttango_experiments_nativearealearning_TangoJNINative_render(
-    JNIEnv*, jobject) {
+void Render(JNIEnv*, jobject) {
   app.Render();
 }
 
-JNIEXPORT void JNICALL
-Java_com_projecttango_experiments_nativearealearning_TangoJNINative_freeContent(
-    JNIEnv*, jobject) {
+void FreeContent(JNIEnv*, jobject) {
   app.FreeContent();
 }
 
-JNIEXPORT jboolean JNICALL
-Java_com_projecttango_experiments_nativearealearning_TangoJNINative_isRelocalized(
-    JNIEnv*, jobject) {
+jboolean IsRelocalized(JNIEnv*, jobject) {
   return app.IsRelocalized();
 }
 
-JNIEXPORT jstring JNICALL
-Java_com_projecttango_experiments_nativearealearning_TangoJNINative_getStartServiceTDeviceString(
-    JNIEnv* env, jobject) {
+jstring GetStartServiceTDeviceString(JNIEnv* env, jobject) {
   return (env)->NewStringUTF(app.GetStartServiceTDeviceString().c_str());
 }
 
-JNIEXPORT jstring JNICALL
-Java_com_projecttango_experiments_nativearealearning_TangoJNINative_getAdfTDeviceString(
-    JNIEnv* env, jobject) {
+jstring GetAdfTDeviceString(JNIEnv* env, jobject) {
   return (env)->NewStringUTF(app.GetAdfTDeviceString().c_str());
 }
 
-JNIEXPORT jstring JNICALL
-Java_com_projecttango_experiments_nativearealearning_TangoJNINative_getAdfTStartServiceString(
-    JNIEnv* env, jobject) {
+jstring GetAdfTStartServiceString(JNIEnv* env, jobject) {
   return (env)->NewStringUTF(app.GetAdfTStartServiceString().c_str());
 }
 
-JNIEXPORT jstring JNICALL
-Java_com_projecttango_experiments_nativearealearning_TangoJNINative_getEventString(
-    JNIEnv* env, jobject) {
+jstring GetEventString(JNIEnv* env, jobject) {
   return (env)->NewStringUTF(app.GetEventString().c_str());
 }
 
-JNIEXPORT jstring JNICALL
-Java_com_projecttango_experiments_nativearealearning_TangoJNINative_getVersionNumber(
-    JNIEnv* env, jobject) {
+jstring GetVersionNumber(JNIEnv* env, jobject) {
   return (env)->NewStringUTF(app.GetVersionString().c_str());
 }
 
-JNIEXPORT void JNICALL
-Java_com_projecttango_experiments_nativearealearning_TangoJNINative_setCamera(
-    JNIEnv*, jobject, int camera_index) {
+void SetCamera(JNIEnv*, jobject, int camera_index) {
   using namespace tango_gl;
   GestureCamera::CameraType cam_type =
       static_cast<GestureCamera::CameraType>(camera_index);
   app.SetCameraType(cam_type);
 }
 
-JNIEXPORT void JNICALL
-Java_com_projecttango_experiments_nativearealearning_TangoJNINative_onTouchEvent(
-    JNIEnv*, jobject, int touch_count, int event, float x0, float y0, float x1,
-    float y1) {
+void OnTouchEvent(JNIEnv*, jobject, int touch_count, int event, float x0,
+                  float y0, float x1, float y1) {
   using namespace tango_gl;
   GestureCamera::TouchEvent touch_event =
       static_cast<GestureCamera::TouchEvent>(event);
   app.OnTouchEvent(touch_count, touch_event, x0, y0, x1, y1);
 }
 
-JNIEXPORT jstring JNICALL
-Java_com_projecttango_experiments_nativearealearning_TangoJNINative_getLoadedADFUUIDString(
-    JNIEnv* env, jobject) {
+jstring GetLoadedADFUUIDString(JNIEnv* env, jobject) {
   return (env)->NewStringUTF(app.GetLoadedAdfString().c_str());
 }
 
-JNIEXPORT jstring JNICALL
-Java_com_projecttango_experiments_nativearealearning_TangoJNINative_saveAdf(
-    JNIEnv* env, jobject) {
-  return (env)->NewStringUTF(app.SaveAdf().c_str());
+jboolean StartSaveAdf(JNIEnv* env, jobject, jstring name) {
+  const char* name_chars = env->GetStringUTFChars(name, nullptr);
+  std::string name_str(name_chars);
+  env->ReleaseStringUTFChars(name, name_chars);
+  return app.StartSaveAdf(name_str);
+}
+
+jint GetSaveAdfProgress(JNIEnv*, jobject) {
+  return app.GetSaveAdfProgress();
 }
 
-JNIEXPORT jstring JNICALL
-Java_com_projecttango_experiments_nativearealearning_TangoJNINative_getAdfMetadataValue(
-    JNIEnv* env, jobject, jstring uuid, jstring key) {
+jstring GetAdfMetadataValue(JNIEnv* env, jobject, jstring uuid, jstring key) {
   std::string uuid_str(env->GetStringUTFChars(uuid, nullptr));
   std::string key_str(env->GetStringUTFChars(key, nullptr));
   return env->NewStringUTF(app.GetAdfMetadataValue(uuid_str, key_str).c_str());
 }
 
-JNIEXPORT void JNICALL
-Java_com_projecttango_experiments_nativearealearning_TangoJNINative_setAdfMetadataValue(
-    JNIEnv* env, jobject, jstring uuid, jstring key, jstring value) {
+void SetAdfMetadataValue(JNIEnv* env, jobject, jstring uuid, jstring key,
+                         jstring value) {
   std::string uuid_str(env->GetStringUTFChars(uuid, nullptr));
   std::string key_str(env->GetStringUTFChars(key, nullptr));
   std::string value_str(env->GetStringUTFChars(value, nullptr));
   app.SetAdfMetadataValue(uuid_str, key_str, value_str);
 }
 
-JNIEXPORT jstring JNICALL
-Java_com_projecttango_experiments_nativearealearning_TangoJNINative_getAllAdfUuids(
-    JNIEnv* env, jobject) {
+jstring GetAllAdfUuids(JNIEnv* env, jobject) {
   return env->NewStringUTF(app.GetAllAdfUuids().c_str());
 }
 
-JNIEXPORT void JNICALL
-Java_com_projecttango_experiments_nativearealearning_TangoJNINative_deleteAdf(
-    JNIEnv* env, jobject, jstring uuid) {
+void DeleteAdf(JNIEnv* env, jobject, jstring uuid) {
   std::string uuid_str(env->GetStringUTFChars(uuid, nullptr));
   return app.DeleteAdf(uuid_str);
 }
 
+void FlushAdfMetadata(JNIEnv*, jobject) {
+  app.FlushAdfMetadata();
+}
+
+void InvalidateAdfCatalog(JNIEnv* env, jobject, jstring uuid) {
+  std::string uuid_str(env->GetStringUTFChars(uuid, nullptr));
+  app.InvalidateAdfCatalog(uuid_str);
+}
+
+void ImportAdfs(JNIEnv* env, jobject, jobjectArray file_paths) {
+  jsize count = env->GetArrayLength(file_paths);
+  for (jsize i = 0; i < count; ++i) {
+    jstring path =
+        static_cast<jstring>(env->GetObjectArrayElement(file_paths, i));
+    const char* path_chars = env->GetStringUTFChars(path, nullptr);
+    app.ImportAdf(path_chars);
+    env->ReleaseStringUTFChars(path, path_chars);
+    env->DeleteLocalRef(path);
+  }
+}
+
+void ExportAdfs(JNIEnv* env, jobject, jobjectArray uuids, jstring directory) {
+  const char* directory_chars = env->GetStringUTFChars(directory, nullptr);
+  std::string directory_str(directory_chars);
+  env->ReleaseStringUTFChars(directory, directory_chars);
+  jsize count = env->GetArrayLength(uuids);
+  for (jsize i = 0; i < count; ++i) {
+    jstring uuid = static_cast<jstring>(env->GetObjectArrayElement(uuids, i));
+    const char* uuid_chars = env->GetStringUTFChars(uuid, nullptr);
+    app.ExportAdf(uuid_chars, directory_str);
+    env->ReleaseStringUTFChars(uuid, uuid_chars);
+    env->DeleteLocalRef(uuid);
+  }
+}
+
+void SetAdfCacheDirectory(JNIEnv* env, jobject, jstring directory) {
+  const char* directory_chars = env->GetStringUTFChars(directory, nullptr);
+  app.SetAdfCacheDirectory(std::string(directory_chars));
+  env->ReleaseStringUTFChars(directory, directory_chars);
+}
+
+jboolean SwitchAdf(JNIEnv* env, jobject, jstring uuid) {
+  const char* uuid_chars = env->GetStringUTFChars(uuid, nullptr);
+  bool is_started = app.SwitchAdf(std::string(uuid_chars));
+  env->ReleaseStringUTFChars(uuid, uuid_chars);
+  return is_started;
+}
+
+void PrefetchAdf(JNIEnv* env, jobject, jstring uuid) {
+  const char* uuid_chars = env->GetStringUTFChars(uuid, nullptr);
+  app.PrefetchAdf(std::string(uuid_chars));
+  env->ReleaseStringUTFChars(uuid, uuid_chars);
+}
+
+jboolean IsSwitchingAdf(JNIEnv*, jobject) {
+  return app.IsSwitchingAdf();
+}
+
+jint GetAdfTransferPendingCount(JNIEnv*, jobject) {
+  return app.GetAdfTransferPendingCount();
+}
+
+jstring GetAdfTransferString(JNIEnv* env, jobject) {
+  return env->NewStringUTF(app.GetAdfTransferString().c_str());
+}
+
+void SetDatasetDirectory(JNIEnv* env, jobject, jstring directory) {
+  const char* directory_chars = env->GetStringUTFChars(directory, nullptr);
+  app.SetDatasetDirectory(std::string(directory_chars));
+  env->ReleaseStringUTFChars(directory, directory_chars);
+}
+
+void RefreshDatasets(JNIEnv*, jobject) {
+  app.RefreshDatasets();
+}
+
+void DeleteDatasets(JNIEnv* env, jobject, jobjectArray uuids) {
+  std::vector<std::string> uuid_list;
+  jsize count = env->GetArrayLength(uuids);
+  for (jsize i = 0; i < count; ++i) {
+    jstring uuid = static_cast<jstring>(env->GetObjectArrayElement(uuids, i));
+    const char* uuid_chars = env->GetStringUTFChars(uuid, nullptr);
+    uuid_list.push_back(std::string(uuid_chars));
+    env->ReleaseStringUTFChars(uuid, uuid_chars);
+    env->DeleteLocalRef(uuid);
+  }
+  app.DeleteDatasets(uuid_list);
+}
+
+jint EnforceDatasetQuota(JNIEnv*, jobject, jlong max_bytes) {
+  return app.EnforceDatasetQuota(static_cast<uint64_t>(max_bytes));
+}
+
+jstring GetDatasetString(JNIEnv* env, jobject) {
+  return env->NewStringUTF(app.GetDatasetString().c_str());
+}
+
+// onTouchEvent() only queues the touch for the next frame, so it is a fast
+// native call. render() runs for milliseconds and stays a regular call, see
+// tango_gl::jni::RegisterNatives().
+const JNINativeMethod kNativeMethods[] = {
+    {"initialize",
+     "(Lcom/projecttango/experiments/nativearealearning/"
+     "AreaDescriptionActivity;)I",
+     reinterpret_cast<void*>(Initialize)},
+    {"setupConfig", "(ZZ)I", reinterpret_cast<void*>(SetupConfig)},
+    {"connect", "()Z", reinterpret_cast<void*>(Connect)},
+    {"connectCallbacks", "()I", reinterpret_cast<void*>(ConnectCallbacks)},
+    {"disconnect", "()V", reinterpret_cast<void*>(Disconnect)},
+    {"resetMotionTracking", "()V",
+     reinterpret_cast<void*>(ResetMotionTracking)},
+    {"initGlContent", "()V", reinterpret_cast<void*>(InitGlContent)},
+    {"setupGraphics", "(II)V", reinterpret_cast<void*>(SetupGraphics)},
+    {"render", "()V", reinterpret_cast<void*>(Render)},
+    {"freeContent", "()V", reinterpret_cast<void*>(FreeContent)},
+    {"isRelocalized", "()Z", reinterpret_cast<void*>(IsRelocalized)},
+    {"getStartServiceTDeviceString", "()Ljava/lang/String;",
+     reinterpret_cast<void*>(GetStartServiceTDeviceString)},
+    {"getAdfTDeviceString", "()Ljava/lang/String;",
+     reinterpret_cast<void*>(GetAdfTDeviceString)},
+    {"getAdfTStartServiceString", "()Ljava/lang/String;",
+     reinterpret_cast<void*>(GetAdfTStartServiceString)},
+    {"getEventString", "()Ljava/lang/String;",
+     reinterpret_cast<void*>(GetEventString)},
+    {"getVersionNumber", "()Ljava/lang/String;",
+     reinterpret_cast<void*>(GetVersionNumber)},
+    {"setCamera", "(I)V", reinterpret_cast<void*>(SetCamera)},
+    {"onTouchEvent", "!(IIFFFF)V", reinterpret_cast<void*>(OnTouchEvent)},
+    {"getLoadedADFUUIDString", "()Ljava/lang/String;",
+     reinterpret_cast<void*>(GetLoadedADFUUIDString)},
+    {"startSaveAdf", "(Ljava/lang/String;)Z",
+     reinterpret_cast<void*>(StartSaveAdf)},
+    {"getSaveAdfProgress", "()I", reinterpret_cast<void*>(GetSaveAdfProgress)},
+    {"getAdfMetadataValue",
+     "(Ljava/lang/String;Ljava/lang/String;)Ljava/lang/String;",
+     reinterpret_cast<void*>(GetAdfMetadataValue)},
+    {"setAdfMetadataValue",
+     "(Ljava/lang/String;Ljava/lang/String;Ljava/lang/String;)V",
+     reinterpret_cast<void*>(SetAdfMetadataValue)},
+    {"getAllAdfUuids", "()Ljava/lang/String;",
+     reinterpret_cast<void*>(GetAllAdfUuids)},
+    {"deleteAdf", "(Ljava/lang/String;)V", reinterpret_cast<void*>(DeleteAdf)},
+    {"flushAdfMetadata", "()V", reinterpret_cast<void*>(FlushAdfMetadata)},
+    {"invalidateAdfCatalog", "(Ljava/lang/String;)V",
+     reinterpret_cast<void*>(InvalidateAdfCatalog)},
+    {"importAdfs", "([Ljava/lang/String;)V",
+     reinterpret_cast<void*>(ImportAdfs)},
+    {"exportAdfs", "([Ljava/lang/String;Ljava/lang/String;)V",
+     reinterpret_cast<void*>(ExportAdfs)},
+    {"setAdfCacheDirectory", "(Ljava/lang/String;)V",
+     reinterpret_cast<void*>(SetAdfCacheDirectory)},
+    {"switchAdf", "(Ljava/lang/String;)Z", reinterpret_cast<void*>(SwitchAdf)},
+    {"prefetchAdf", "(Ljava/lang/String;)V",
+     reinterpret_cast<void*>(PrefetchAdf)},
+    {"isSwitchingAdf", "()Z", reinterpret_cast<void*>(IsSwitchingAdf)},
+    {"getAdfTransferPendingCount", "()I",
+     reinterpret_cast<void*>(GetAdfTransferPendingCount)},
+    {"getAdfTransferString", "()Ljava/lang/String;",
+     reinterpret_cast<void*>(GetAdfTransferString)},
+    {"setDatasetDirectory", "(Ljava/lang/String;)V",
+     reinterpret_cast<void*>(SetDatasetDirectory)},
+    {"refreshDatasets", "()V", reinterpret_cast<void*>(RefreshDatasets)},
+    {"deleteDatasets", "([Ljava/lang/String;)V",
+     reinterpret_cast<void*>(DeleteDatasets)},
+    {"enforceDatasetQuota", "(J)I",
+     reinterpret_cast<void*>(EnforceDatasetQuota)},
+    {"getDatasetString", "()Ljava/lang/String;",
+     reinterpret_cast<void*>(GetDatasetString)},
+};
+}  // namespace
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+jint JNI_OnLoad(JavaVM* vm, void*) {
+  // We need to store a reference to the Java VM so that we can call into the
+  // Java layer to trigger rendering.
+  app.SetJavaVM(vm);
+  return tango_gl::jni::RegisterNatives(
+      vm, "com/projecttango/experiments/nativearealearning/TangoJNINative",
+      kNativeMethods);
+}
 #ifdef __cplusplus
 }
 #endif
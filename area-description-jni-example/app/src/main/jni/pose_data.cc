@@ -20,75 +20,120 @@
 
 namespace {
 const float kMeterToMillimeter = 1000.0f;
+
+// Indices of the frame pairs in kFramePairs.
+enum FramePair { kStartServiceTDevice = 0, kAdfTDevice, kAdfTStartService };
+
+const TangoCoordinateFramePair kFramePairs[] = {
+    {TANGO_COORDINATE_FRAME_START_OF_SERVICE, TANGO_COORDINATE_FRAME_DEVICE},
+    {TANGO_COORDINATE_FRAME_AREA_DESCRIPTION, TANGO_COORDINATE_FRAME_DEVICE},
+    {TANGO_COORDINATE_FRAME_AREA_DESCRIPTION,
+     TANGO_COORDINATE_FRAME_START_OF_SERVICE}};
+const int kFramePairCount = 3;
+
+// Rate of the debug strings, the activity polls them a few times a second.
+const double kDisplayedPoseRate = 10.0;
+
+// Distance the device moves between two trajectory poses, in meters.
+const float kTrajectoryPoseDistance = 0.05f;
+
+// Trajectory poses waiting for the render thread, seconds of walking.
+const size_t kTrajectoryQueueCapacity = 64;
 }  // namespace
 
 namespace tango_area_learning {
 
-PoseData::PoseData() {}
+PoseData::PoseData()
+    : trajectory_poses_(kTrajectoryQueueCapacity),
+      pose_stream_(kFramePairs, kFramePairCount) {
+  pose_stream_.SetRelocalizationPair(kAdfTStartService);
+
+  tango_gl::PoseStream::SubscriberOptions display_options;
+  display_options.max_rate = kDisplayedPoseRate;
+  for (int pair = 0; pair < kFramePairCount; ++pair) {
+    subscriptions_.push_back(pose_stream_.Subscribe(
+        pair, display_options, [this, pair](const TangoPoseData&) {
+          displayed_poses_[pair].Store(pose_stream_.GetLatest(pair));
+        }));
+  }
 
-PoseData::~PoseData() {}
+  // The trajectory follows start of service until the device relocalizes,
+  // and the ADF frame after.
+  tango_gl::PoseStream::SubscriberOptions trajectory_options;
+  trajectory_options.min_translation = kTrajectoryPoseDistance;
+  subscriptions_.push_back(pose_stream_.Subscribe(
+      kStartServiceTDevice, trajectory_options,
+      [this](const TangoPoseData& pose) {
+        if (!pose_stream_.IsRelocalized()) {
+          QueueTrajectoryPose(pose);
+        }
+      }));
+  subscriptions_.push_back(pose_stream_.Subscribe(
+      kAdfTDevice, trajectory_options, [this](const TangoPoseData& pose) {
+        if (pose_stream_.IsRelocalized()) {
+          QueueTrajectoryPose(pose);
+        }
+      }));
+}
 
-void PoseData::UpdatePose(const TangoPoseData& pose_data) {
-  PoseDataInfo* pose_data_info;
-  // We check the frame pair received in the pose_data instance, and store it
-  // in the proper cooresponding local member.
-  //
-  // The frame pairs are the one we registred in the
-  // TangoService_connectOnPoseAvailable functions during the setup of the
-  // Tango configuration file.
-  if (pose_data.frame.base == TANGO_COORDINATE_FRAME_START_OF_SERVICE &&
-      pose_data.frame.target == TANGO_COORDINATE_FRAME_DEVICE) {
-    pose_data_info = &start_service_T_device_pose_;
-  } else if (pose_data.frame.base == TANGO_COORDINATE_FRAME_AREA_DESCRIPTION &&
-             pose_data.frame.target == TANGO_COORDINATE_FRAME_DEVICE) {
-    pose_data_info = &adf_T_device_pose_;
-  } else if (pose_data.frame.base == TANGO_COORDINATE_FRAME_AREA_DESCRIPTION &&
-             pose_data.frame.target ==
-                 TANGO_COORDINATE_FRAME_START_OF_SERVICE) {
-    pose_data_info = &adf_T_start_service_pose_;
-    is_relocalized = (pose_data.status_code == TANGO_POSE_VALID);
-  } else {
-    return;
+PoseData::~PoseData() {
+  for (int subscription : subscriptions_) {
+    pose_stream_.Unsubscribe(subscription);
   }
+}
 
-  pose_data_info->cur_pose = pose_data;
+void PoseData::UpdatePose(const TangoPoseData& pose_data) {
+  // The stream routes the pose to the slot of the frame pair it belongs to,
+  // the pairs are the ones registered in TangoService_connectOnPoseAvailable.
+  pose_stream_.OnPoseAvailable(pose_data);
+}
 
-  if (pose_data_info->prev_pose.status_code !=
-      pose_data_info->cur_pose.status_code) {
-    // Reset pose counter when the status changed.
-    pose_data_info->pose_counter = 0;
+void PoseData::ResetPoseData() {
+  pose_stream_.Reset();
+  for (int pair = 0; pair < kFramePairCount; ++pair) {
+    displayed_poses_[pair].Store(tango_gl::PoseStream::Snapshot());
   }
+  // Poses of the trajectory before the reset are not relative to the same
+  // frame as the ones after.
+  TangoPoseData pose;
+  while (trajectory_poses_.Pop(&pose)) {
+  }
+}
 
-  // Increase pose counter.
-  ++pose_data_info->pose_counter;
-  FormatPoseString(pose_data_info);
-  pose_data_info->prev_pose = pose_data_info->cur_pose;
+bool PoseData::PopTrajectoryPose(TangoPoseData* pose) {
+  return trajectory_poses_.Pop(pose);
 }
 
-void PoseData::ResetPoseData() {
-  is_relocalized = false;
-  start_service_T_device_pose_ = PoseDataInfo();
-  adf_T_device_pose_ = PoseDataInfo();
-  adf_T_start_service_pose_ = PoseDataInfo();
+void PoseData::QueueTrajectoryPose(const TangoPoseData& pose) {
+  if (pose.status_code != TANGO_POSE_VALID) {
+    return;
+  }
+  // The render thread catches up within a frame, a full queue means it is
+  // not rendering and the trace is redrawn from later poses anyway.
+  trajectory_poses_.Push(pose);
 }
 
 std::string PoseData::GetStartServiceTDeviceString() {
-  return start_service_T_device_pose_.pose_string;
+  return FormatPoseString(kStartServiceTDevice);
 }
 
 std::string PoseData::GetAdfTDeviceString() {
-  return adf_T_device_pose_.pose_string;
+  return FormatPoseString(kAdfTDevice);
 }
 
 std::string PoseData::GetAdfTStartServiceString() {
-  return adf_T_start_service_pose_.pose_string;
+  return FormatPoseString(kAdfTStartService);
+}
+
+TangoPoseData PoseData::GetAdfTStartServicePose() {
+  return pose_stream_.GetLatest(kAdfTStartService).pose;
 }
 
 TangoPoseData PoseData::GetCurrentPoseData() {
-  if (is_relocalized) {
-    return adf_T_device_pose_.cur_pose;
+  if (pose_stream_.IsRelocalized()) {
+    return pose_stream_.GetLatest(kAdfTDevice).pose;
   } else {
-    return start_service_T_device_pose_.cur_pose;
+    return pose_stream_.GetLatest(kStartServiceTDevice).pose;
   }
 }
 
@@ -114,26 +159,26 @@ std::string PoseData::GetStringFromStatusCode(TangoPoseStatusType status) {
   return ret_string;
 }
 
-void PoseData::FormatPoseString(PoseDataInfo* pose_data_info) {
+std::string PoseData::FormatPoseString(int pair) {
+  tango_gl::PoseStream::Snapshot snapshot = displayed_poses_[pair].Load();
+  if (snapshot.pose_counter == 0) {
+    // No pose received yet.
+    return "N/A";
+  }
+  const TangoPoseData& pose = snapshot.pose;
   std::stringstream string_stream;
   string_stream.setf(std::ios_base::fixed, std::ios_base::floatfield);
   string_stream.precision(3);
-  string_stream << "status: "
-                << GetStringFromStatusCode(pose_data_info->cur_pose.status_code)
-                << ", count: " << pose_data_info->pose_counter
+  string_stream << "status: " << GetStringFromStatusCode(pose.status_code)
+                << ", count: " << snapshot.pose_counter
                 << ", delta time (ms): "
-                << (pose_data_info->cur_pose.timestamp -
-                    pose_data_info->prev_pose.timestamp) *
-                       kMeterToMillimeter << ", position (m): ["
-                << pose_data_info->cur_pose.translation[0] << ", "
-                << pose_data_info->cur_pose.translation[1] << ", "
-                << pose_data_info->cur_pose.translation[2] << "]"
-                << ", orientation: [" << pose_data_info->cur_pose.orientation[0]
-                << ", " << pose_data_info->cur_pose.orientation[1] << ", "
-                << pose_data_info->cur_pose.orientation[2] << ", "
-                << pose_data_info->cur_pose.orientation[3] << "]";
-  pose_data_info->pose_string = string_stream.str();
-  string_stream.flush();
+                << snapshot.delta_time * kMeterToMillimeter
+                << ", position (m): [" << pose.translation[0] << ", "
+                << pose.translation[1] << ", " << pose.translation[2] << "]"
+                << ", orientation: [" << pose.orientation[0] << ", "
+                << pose.orientation[1] << ", " << pose.orientation[2] << ", "
+                << pose.orientation[3] << "]";
+  return string_stream.str();
 }
 
 } //namespace tango_area_learning
\ No newline at end of file
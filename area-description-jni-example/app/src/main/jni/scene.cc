@@ -15,6 +15,7 @@
  */
 
 #include <tango-gl/conversions.h>
+#include <tango-gl/render_state.h>
 
 #include "tango-area-learning/scene.h"
 
@@ -53,6 +54,7 @@ void Scene::InitGLContent() {
   motion_tracking_trace_ = new tango_gl::Trace();
   adf_trace_ = new tango_gl::Trace();
   grid_ = new tango_gl::Grid();
+  coverage_map_ = new tango_gl::CoverageMap();
 
   // Set the frustum scale to 4:3, this doesn't necessarily match the physical
   // camera's aspect ratio, this is just for visualization purposes.
@@ -64,15 +66,23 @@ void Scene::InitGLContent() {
   grid_->SetColor(kGridColor);
   gesture_camera_->SetCameraType(
       tango_gl::GestureCamera::CameraType::kThirdPerson);
+
+  scene_graph_.Add(frustum_, tango_gl::SceneGraph::kOpaque);
+  scene_graph_.Add(axis_, tango_gl::SceneGraph::kOpaque);
+  scene_graph_.Add(adf_trace_, tango_gl::SceneGraph::kOpaque);
+  scene_graph_.Add(motion_tracking_trace_, tango_gl::SceneGraph::kOpaque);
+  scene_graph_.Add(grid_, tango_gl::SceneGraph::kOpaque);
 }
 
 void Scene::FreeGLContent() {
+  scene_graph_.Clear();
   delete gesture_camera_;
   delete axis_;
   delete frustum_;
   delete motion_tracking_trace_;
   delete adf_trace_;
   delete grid_;
+  delete coverage_map_;
 }
 
 void Scene::SetupViewPort(int w, int h) {
@@ -84,9 +94,9 @@ void Scene::SetupViewPort(int w, int h) {
   glViewport(0, 0, w, h);
 }
 
-void Scene::Render(const TangoPoseData& cur_pose, bool is_relocalized) {
-  glEnable(GL_DEPTH_TEST);
-  glEnable(GL_CULL_FACE);
+void Scene::Render(const TangoPoseData& cur_pose) {
+  tango_gl::RenderState::Enable(GL_DEPTH_TEST);
+  tango_gl::RenderState::Enable(GL_CULL_FACE);
 
   glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
   glClear(GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT);
@@ -120,35 +130,80 @@ void Scene::Render(const TangoPoseData& cur_pose, bool is_relocalized) {
     // In first person mode, we directly control camera's motion.
     gesture_camera_->SetPosition(position);
     gesture_camera_->SetRotation(rotation);
+    scene_graph_.SetVisible(frustum_, false);
+    scene_graph_.SetVisible(axis_, false);
   } else {
     // In third person or top down more, we follow the camera movement.
     gesture_camera_->SetAnchorPosition(position);
 
     frustum_->SetPosition(position);
     frustum_->SetRotation(rotation);
-    frustum_->Render(gesture_camera_->GetProjectionMatrix(),
-                     gesture_camera_->GetViewMatrix());
-
     axis_->SetPosition(position);
     axis_->SetRotation(rotation);
-    axis_->Render(gesture_camera_->GetProjectionMatrix(),
-                  gesture_camera_->GetViewMatrix());
+    scene_graph_.SetVisible(frustum_, true);
+    scene_graph_.SetVisible(axis_, true);
   }
 
-  if (is_relocalized) {
-    adf_trace_->UpdateVertexArray(position);
+  coverage_map_->Render(gesture_camera_->GetProjectionMatrix(),
+                        gesture_camera_->GetViewMatrix());
+  scene_graph_.Render(gesture_camera_->GetProjectionMatrix(),
+                      gesture_camera_->GetViewMatrix(), nullptr);
+}
+
+void Scene::AddTrajectoryPose(const TangoPoseData& pose) {
+  glm::vec3 position =
+      tango_gl::conversions::Vec3TangoToGl(glm::vec3(
+          pose.translation[0], pose.translation[1], pose.translation[2])) +
+      kHeightOffset;
+  if (pose.frame.base == TANGO_COORDINATE_FRAME_AREA_DESCRIPTION) {
+    adf_trace_->UpdateVertexArray(pose.timestamp, position);
   } else {
     motion_tracking_trace_->UpdateVertexArray(position);
   }
+}
+
+void Scene::SetDepthCameraIntrinsics(const TangoCameraIntrinsics& intrinsics) {
+  coverage_map_->SetIntrinsics(intrinsics);
+}
+
+void Scene::AddCoverage(const glm::mat4& start_service_T_depth, float range) {
+  // Same frame as the traces, the ground is at the height of the grid.
+  tango_gl::conversions::OpenGlWorldTTangoWorld opengl_world_T_start_service;
+  coverage_map_->Splat(glm::translate(glm::mat4(1.0f), kHeightOffset) *
+                           (opengl_world_T_start_service *
+                            start_service_T_depth),
+                       range);
+}
+
+void Scene::ClearCoverage() { coverage_map_->Clear(); }
+
+void Scene::CorrectAdfTrace(const TangoPoseData& old_adf_T_start_service,
+                            const TangoPoseData& new_adf_T_start_service) {
+  const TangoPoseData* poses[2] = {&old_adf_T_start_service,
+                                   &new_adf_T_start_service};
+  glm::mat4 adf_T_start_service[2];
+  for (int i = 0; i < 2; ++i) {
+    adf_T_start_service[i] = tango_gl::conversions::TransformFromVecAndQuat(
+        glm::vec3(poses[i]->translation[0], poses[i]->translation[1],
+                  poses[i]->translation[2]),
+        glm::quat(poses[i]->orientation[3], poses[i]->orientation[0],
+                  poses[i]->orientation[1], poses[i]->orientation[2]));
+  }
 
-  adf_trace_->Render(gesture_camera_->GetProjectionMatrix(),
-                     gesture_camera_->GetViewMatrix());
-  motion_tracking_trace_->Render(gesture_camera_->GetProjectionMatrix(),
-                                 gesture_camera_->GetViewMatrix());
-  grid_->Render(gesture_camera_->GetProjectionMatrix(),
-                gesture_camera_->GetViewMatrix());
+  // The trace holds offset * opengl_world_T_adf * adf_p, re-express it with
+  // the new pose.
+  tango_gl::conversions::OpenGlWorldTTangoWorld opengl_world_T_adf;
+  glm::mat4 correction =
+      glm::translate(glm::mat4(1.0f), kHeightOffset) *
+      (opengl_world_T_adf * adf_T_start_service[1] *
+       glm::inverse(adf_T_start_service[0]) *
+       tango_gl::conversions::Inverse(opengl_world_T_adf)) *
+      glm::translate(glm::mat4(1.0f), -kHeightOffset);
+  adf_trace_->Correct(0.0, correction);
 }
 
+void Scene::ClearAdfTrace() { adf_trace_->ClearVertexArray(); }
+
 void Scene::SetCameraType(tango_gl::GestureCamera::CameraType camera_type) {
   gesture_camera_->SetCameraType(camera_type);
 }
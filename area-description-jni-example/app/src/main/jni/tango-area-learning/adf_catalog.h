@@ -0,0 +1,126 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_AREA_LEARNING_ADF_CATALOG_H_
+#define TANGO_AREA_LEARNING_ADF_CATALOG_H_
+
+#include <stdint.h>
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <tango-gl/worker_pool.h>
+
+namespace tango_area_learning {
+
+// AdfCatalog is an in-memory cache of the ADFs in Tango space and their
+// metadata.
+//
+// The first query loads the UUID list and then the metadata of every ADF,
+// fetching them in parallel on a small worker pool since each fetch is a
+// round trip to the Tango Service. Later queries are served from memory until
+// the catalog is invalidated. Writes update the cache at once and are queued,
+// Flush() then stores each ADF's pending writes with one metadata round trip.
+//
+// All methods can be called from any thread.
+class AdfCatalog {
+ public:
+  AdfCatalog();
+  AdfCatalog(const AdfCatalog& other) = delete;
+  const AdfCatalog& operator=(const AdfCatalog&) = delete;
+  ~AdfCatalog();
+
+  // Get the UUIDs of all ADFs, in the order the Tango Service lists them, the
+  // most recent one last.
+  //
+  // @param adf_list: ADF UUID list to be filled in.
+  void GetUuids(std::vector<std::string>* adf_list);
+
+  // Get a metadata value of an ADF.
+  //
+  // @param uuid: the UUID of the targeting ADF.
+  // @param key: the key of the metadata.
+  // @param value: filled with the value, binary values are kept as they are.
+  //
+  // @return: false if the ADF or the key is unknown.
+  bool GetValue(const std::string& uuid, const std::string& key,
+                std::string* value);
+
+  // Queue a metadata write for an ADF, readers see the value at once.
+  //
+  // @param uuid: the UUID of the targeting ADF.
+  // @param key: the key of the metadata.
+  // @param value: the value that is going to be assigned to the key.
+  void SetValue(const std::string& uuid, const std::string& key,
+                const std::string& value);
+
+  // Store all queued writes into the Tango Service.
+  //
+  // @return: false if any of the ADFs failed to save.
+  bool Flush();
+
+  // Delete an ADF from Tango space and from the catalog.
+  //
+  // @param uuid: target ADF's uuid.
+  void Delete(const std::string& uuid);
+
+  // Mark the UUID list as stale, e.g. after an ADF was saved or imported. The
+  // next query reloads the list and loads the metadata of new ADFs only.
+  void Invalidate();
+
+  // Drop the cached metadata of one ADF, it is reloaded by the next query.
+  //
+  // @param uuid: target ADF's uuid.
+  void InvalidateEntry(const std::string& uuid);
+
+ private:
+  struct Entry {
+    std::string uuid;
+    // Raw metadata values by key, empty if the metadata failed to load.
+    std::map<std::string, std::string> values;
+    bool is_loaded;
+  };
+
+  // Reload the UUID list and missing metadata if needed, called with mutex_
+  // held.
+  void Refresh();
+
+  // Fetch the metadata of an ADF from the Tango Service.
+  static void LoadEntry(Entry* entry);
+
+  // Store writes into the metadata of an ADF.
+  static bool StoreValues(const std::string& uuid,
+                          const std::map<std::string, std::string>& values);
+
+  // Guards everything below, also serializing use of the worker pool.
+  std::mutex mutex_;
+  std::unique_ptr<tango_gl::WorkerPool> worker_pool_;
+
+  bool is_list_valid_;
+  std::vector<Entry> entries_;
+  std::unordered_map<std::string, size_t> entry_index_;
+
+  // Queued writes per ADF UUID.
+  std::map<std::string, std::map<std::string, std::string>> pending_writes_;
+};
+}  // namespace tango_area_learning
+
+#endif  // TANGO_AREA_LEARNING_ADF_CATALOG_H_
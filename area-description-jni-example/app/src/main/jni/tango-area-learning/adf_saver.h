@@ -0,0 +1,81 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_AREA_LEARNING_ADF_SAVER_H_
+#define TANGO_AREA_LEARNING_ADF_SAVER_H_
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace tango_area_learning {
+
+// AdfSaver runs TangoService_saveAreaDescription() on its own thread, so
+// neither the UI nor the render thread waits on a save, which takes several
+// seconds for large areas.
+//
+// Save progress arrives as AreaDescriptionSaveProgress events, parsed by the
+// app's tango_gl::EventBus and handed to OnSaveProgress(), which publishes it
+// as an integer percentage any thread can poll without locking.
+class AdfSaver {
+ public:
+  // Called on the save thread once the save finished.
+  //
+  // @param uuid: UUID of the saved ADF, empty if the save failed.
+  typedef std::function<void(const std::string& uuid)> CompletionCallback;
+
+  AdfSaver();
+  AdfSaver(const AdfSaver& other) = delete;
+  const AdfSaver& operator=(const AdfSaver&) = delete;
+  ~AdfSaver();
+
+  // Start saving the current area description.
+  //
+  // @param name: name stored into the metadata of the saved ADF, not set if
+  //        empty.
+  // @param on_finished: called on the save thread when the save is done.
+  // @return false if a save is already running.
+  bool Start(const std::string& name, const CompletionCallback& on_finished);
+
+  // Wait for a running save to finish.
+  void Join();
+
+  // Return true while a save is running.
+  bool IsSaving() const { return is_saving_; }
+
+  // Return the progress of the running or last save in percent, 0 to 100.
+  int GetProgress() const { return progress_; }
+
+  // Handle the value of an AreaDescriptionSaveProgress event, a fraction
+  // between 0 and 1.
+  void OnSaveProgress(double fraction);
+
+ private:
+  void SaveThread(std::string name, CompletionCallback on_finished);
+
+  // Serializes Start() and Join() on the calling threads.
+  std::mutex thread_mutex_;
+  std::thread thread_;
+
+  std::atomic<bool> is_saving_;
+  std::atomic<int> progress_;
+};
+}  // namespace tango_area_learning
+
+#endif  // TANGO_AREA_LEARNING_ADF_SAVER_H_
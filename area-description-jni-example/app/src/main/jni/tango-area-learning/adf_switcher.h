@@ -0,0 +1,115 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_AREA_LEARNING_ADF_SWITCHER_H_
+#define TANGO_AREA_LEARNING_ADF_SWITCHER_H_
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace tango_area_learning {
+
+// AdfSwitcher changes the ADF the service relocalizes against while it stays
+// connected, with TangoService_Experimental_loadAreaDescriptionFromFile(),
+// so moving to another area does not tear down the connection and the
+// rendering with it.
+//
+// Loading an ADF from Tango space first exports it to a file, the slow part
+// of a switch. Prefetch() does that ahead of time on the switcher thread: the
+// ADF is exported into a cache directory and its pages read ahead, so a later
+// SwitchTo() only has the service load a warm local file.
+//
+// Switching only works once connected, with learning mode off and no ADF in
+// the connect configuration. A switch takes precedence over queued
+// prefetches, and a newer switch replaces a queued one.
+class AdfSwitcher {
+ public:
+  // Called on the switcher thread once a switch finished.
+  //
+  // @param uuid: UUID of the ADF switched to.
+  // @param succeeded: false if the ADF could not be exported or loaded.
+  typedef std::function<void(const std::string& uuid, bool succeeded)>
+      CompletionCallback;
+
+  AdfSwitcher();
+  AdfSwitcher(const AdfSwitcher& other) = delete;
+  const AdfSwitcher& operator=(const AdfSwitcher&) = delete;
+  ~AdfSwitcher();
+
+  // Set the directory prefetched ADFs are exported to, e.g. the app cache
+  // directory. Nothing is prefetched or switched before it is set.
+  void SetCacheDirectory(const std::string& directory);
+
+  // Set the function called after each switch. Not thread safe, set it
+  // before switching.
+  void SetCompletionCallback(const CompletionCallback& on_switched) {
+    on_switched_ = on_switched;
+  }
+
+  // Queue an export of an ADF into the cache directory, unless it is
+  // already there.
+  void Prefetch(const std::string& uuid);
+
+  // Queue a switch to an ADF, prefetched first if needed.
+  void SwitchTo(const std::string& uuid);
+
+  // Drop the cached file of an ADF that changed or was deleted.
+  void Invalidate(const std::string& uuid);
+
+  // Drop queued prefetches and switches and wait for the running one, e.g.
+  // before disconnecting.
+  void Cancel();
+
+  // Return the UUID of the ADF last switched to, empty if none.
+  std::string GetLoadedUuid();
+
+  // Return true while a switch is queued or running.
+  bool IsSwitching();
+
+ private:
+  void WorkerLoop();
+
+  // Export an ADF into the cache directory if it is not there yet and read
+  // it ahead, without the lock held.
+  //
+  // @return the path of the cached file, empty if the export failed.
+  std::string PrefetchFile(const std::string& directory,
+                           const std::string& uuid);
+
+  CompletionCallback on_switched_;
+
+  // Guards everything below.
+  std::mutex mutex_;
+  std::condition_variable work_available_;
+  std::condition_variable work_finished_;
+  std::string cache_directory_;
+  std::deque<std::string> prefetches_;
+  // Empty if no switch is queued.
+  std::string pending_switch_;
+  bool is_busy_;
+  bool is_switching_;
+  bool is_stopping_;
+  std::string loaded_uuid_;
+  std::thread thread_;
+};
+}  // namespace tango_area_learning
+
+#endif  // TANGO_AREA_LEARNING_ADF_SWITCHER_H_
@@ -0,0 +1,146 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_AREA_LEARNING_ADF_TRANSFER_MANAGER_H_
+#define TANGO_AREA_LEARNING_ADF_TRANSFER_MANAGER_H_
+
+#include <stdint.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace tango_area_learning {
+
+// AdfTransferManager queues ADF imports and exports and runs them on a small
+// fixed set of worker threads, so bulk syncing many ADFs neither blocks the
+// caller nor floods the Tango Service with concurrent transfers.
+//
+// The service transfers a file in one blocking call, so per file progress is
+// the transfer state, plus size and throughput once it finished.
+class AdfTransferManager {
+ public:
+  enum Direction { kImport = 0, kExport };
+
+  enum State { kQueued = 0, kRunning, kSucceeded, kFailed };
+
+  struct Transfer {
+    int id;
+    Direction direction;
+    // ADF UUID, for imports the file name until the service reports it.
+    std::string uuid;
+    // Source file for imports, destination directory for exports.
+    std::string path;
+    State state;
+    // Size of the transferred file.
+    uint64_t bytes;
+    // Time spent transferring, so far while running.
+    double seconds;
+  };
+
+  struct Stats {
+    int queued;
+    int running;
+    int succeeded;
+    int failed;
+    uint64_t bytes;
+    // Bytes over the time any transfer was running.
+    double bytes_per_second;
+  };
+
+  // Called on a worker thread after each transfer finished.
+  typedef std::function<void(const Transfer& transfer)> CompletionCallback;
+
+  // @param thread_count: maximum number of concurrent transfers.
+  explicit AdfTransferManager(int thread_count);
+  AdfTransferManager(const AdfTransferManager& other) = delete;
+  const AdfTransferManager& operator=(const AdfTransferManager&) = delete;
+  ~AdfTransferManager();
+
+  // Set the function called after each transfer. Not thread safe, set it
+  // before queueing transfers.
+  void SetCompletionCallback(const CompletionCallback& on_finished) {
+    on_finished_ = on_finished;
+  }
+
+  // Queue an import of an ADF file into Tango space.
+  //
+  // @param file_path: path of the ADF file, named by its UUID.
+  // @return: id of the transfer.
+  int EnqueueImport(const std::string& file_path);
+
+  // Queue an export of an ADF from Tango space into a directory.
+  //
+  // @param uuid: the UUID of the ADF.
+  // @param directory: destination directory, the file is named by the UUID.
+  // @return: id of the transfer.
+  int EnqueueExport(const std::string& uuid, const std::string& directory);
+
+  // Copy all transfers since the last ClearFinished(), in queueing order.
+  void GetTransfers(std::vector<Transfer>* transfers);
+
+  Stats GetStats();
+
+  // Forget finished transfers, their bytes stay in the statistics.
+  void ClearFinished();
+
+  // Stop the worker threads after the running transfers, queued ones are
+  // dropped.
+  void Stop();
+
+ private:
+  typedef std::chrono::steady_clock Clock;
+
+  int Enqueue(Direction direction, const std::string& uuid,
+              const std::string& path);
+
+  void WorkerLoop();
+
+  // Run a transfer through the Tango Service, filling in the uuid and bytes.
+  static bool RunTransfer(Transfer* transfer);
+
+  // Return the time transfers were running, called with mutex_ held.
+  double GetBusySeconds(Clock::time_point now) const;
+
+  const int thread_count_;
+  std::vector<std::thread> threads_;
+  CompletionCallback on_finished_;
+
+  // Guards everything below.
+  std::mutex mutex_;
+  std::condition_variable work_available_;
+  bool is_stopping_;
+
+  // All transfers, queued_ holds indices into it of the ones not started.
+  std::vector<Transfer> transfers_;
+  std::vector<Clock::time_point> start_times_;
+  std::deque<size_t> queued_;
+  int next_id_;
+  int running_count_;
+
+  uint64_t finished_bytes_;
+  double busy_seconds_;
+  Clock::time_point busy_start_;
+};
+}  // namespace tango_area_learning
+
+#endif  // TANGO_AREA_LEARNING_ADF_TRANSFER_MANAGER_H_
@@ -18,11 +18,21 @@
 #define TANGO_AREA_LEARNING_AREA_LEARNING_APP_H_
 
 #include <jni.h>
+#include <atomic>
 #include <memory>
+#include <mutex>
+#include <vector>
 
 #include <tango_client_api.h>  // NOLINT
+#include <tango-gl/event_bus.h>
+#include <tango-gl/touch_queue.h>
 #include <tango-gl/util.h>
 
+#include <tango-area-learning/adf_catalog.h>
+#include <tango-area-learning/adf_saver.h>
+#include <tango-area-learning/adf_switcher.h>
+#include <tango-area-learning/adf_transfer_manager.h>
+#include <tango-area-learning/dataset_catalog.h>
 #include <tango-area-learning/pose_data.h>
 #include <tango-area-learning/scene.h>
 #include <tango-area-learning/tango_event_data.h>
@@ -46,10 +56,13 @@ class AreaLearningApp {
   // we'd like auto-recover enabled.
   //
   // @param is_area_learning_enabled: enable/disable the area learning mode.
-  // @param is_loading_adf: load the most recent Adf.
+  // @param is_loading_adf: load the most recent Adf. Without learning mode it
+  //        is loaded through the ADF switcher once connected, so it can be
+  //        switched later, see SwitchAdf().
   int TangoSetupConfig(bool is_area_learning_enabled, bool is_loading_adf);
 
-  // Connect the onPoseAvailable callback.
+  // Connect the onPoseAvailable, onXYZijAvailable and onTangoEvent
+  // callbacks.
   int TangoConnectCallbacks();
 
   // Connect to Tango Service.
@@ -65,22 +78,31 @@ class AreaLearningApp {
   // loaded it will re-start the relocalization process.
   void TangoResetMotionTracking();
 
-  // Save current ADF in learning mode. Note that the save function only works
-  // when learning mode is on.
+  // Start saving the current ADF in learning mode on a background thread.
+  // Note that the save function only works when learning mode is on and Tango
+  // has relocalized. The activity's onAdfSaveFinished(String) is called with
+  // the UUID of the saved ADF, or an empty string, when the save is done.
   //
-  // @return: UUID of the saved ADF.
-  std::string SaveAdf();
+  // @param name: name stored into the metadata of the saved ADF.
+  //
+  // @return: true if the save was started.
+  bool StartSaveAdf(const std::string& name);
+
+  // Return the progress of the running ADF save in percent, 0 to 100.
+  int GetSaveAdfProgress() { return adf_saver_.GetProgress(); }
 
-  // Get specifc meta value of an exsiting ADF.
+  // Get specifc meta value of an exsiting ADF. Served from the ADF catalog,
+  // which loads the metadata of all ADFs on first use.
   //
   // @param uuid: the UUID of the targeting ADF.
   // @param key: key value.
   //
-  // @retun: the value queried from the Tango Service.
+  // @retun: the value cached from the Tango Service.
   std::string GetAdfMetadataValue(const std::string& uuid,
                                   const std::string& key);
 
-  // Set specific meta value to an exsiting ADF.
+  // Set specific meta value to an exsiting ADF. The write is queued until
+  // FlushAdfMetadata() is called.
   //
   // @param uuid: the UUID of the targeting ADF.
   // @param key: the key of the metadata.
@@ -88,6 +110,9 @@ class AreaLearningApp {
   void SetAdfMetadataValue(const std::string& uuid, const std::string& key,
                            const std::string& value);
 
+  // Store all queued metadata writes into the Tango Service.
+  void FlushAdfMetadata() { adf_catalog_.Flush(); }
+
   // Get all ADF's UUIDs list in one string, saperated by comma.
   //
   // @return: all ADF's UUIDs.
@@ -98,6 +123,81 @@ class AreaLearningApp {
   // @param uuid: target ADF's uuid.
   void DeleteAdf(std::string uuid);
 
+  // Drop cached ADF information after ADFs changed outside of this object,
+  // e.g. by an import.
+  //
+  // @param uuid: the UUID of the changed ADF.
+  void InvalidateAdfCatalog(const std::string& uuid);
+
+  // Queue an import of an ADF file into Tango space, run in the background.
+  //
+  // @param file_path: path of the ADF file, named by its UUID.
+  void ImportAdf(const std::string& file_path);
+
+  // Queue an export of an ADF into a directory, run in the background.
+  //
+  // @param uuid: the UUID of the ADF.
+  // @param directory: destination directory, the file is named by the UUID.
+  void ExportAdf(const std::string& uuid, const std::string& directory);
+
+  // Return the number of queued and running ADF transfers.
+  int GetAdfTransferPendingCount();
+
+  // Set the directory ADFs are prefetched into for switching, e.g. the app
+  // cache directory.
+  void SetAdfCacheDirectory(const std::string& directory) {
+    adf_switcher_.SetCacheDirectory(directory);
+  }
+
+  // Switch to another ADF in the background while staying connected. The ADF
+  // trace restarts once the device relocalizes against it.
+  //
+  // @param uuid: the UUID of the ADF.
+  // @return: false in learning mode, where ADFs cannot be switched.
+  bool SwitchAdf(const std::string& uuid);
+
+  // Export an ADF ahead of a switch to it, in the background.
+  //
+  // @param uuid: the UUID of the ADF.
+  void PrefetchAdf(const std::string& uuid) { adf_switcher_.Prefetch(uuid); }
+
+  // Return true while an ADF switch is queued or running.
+  bool IsSwitchingAdf() { return adf_switcher_.IsSwitching(); }
+
+  // Get one line per ADF transfer with its state, size and throughput, and a
+  // summary line.
+  //
+  // @return: transfer debug string for display on Java activity.
+  std::string GetAdfTransferString();
+
+  // Set the directory the Tango Service records datasets into, for the
+  // dataset size accounting, and refresh the dataset inventory.
+  void SetDatasetDirectory(const std::string& directory);
+
+  // Refresh the dataset inventory in the background.
+  void RefreshDatasets() { dataset_catalog_.Refresh(); }
+
+  // Queue deletes of datasets, run in the background.
+  //
+  // @param uuids: the UUIDs of the datasets.
+  void DeleteDatasets(const std::vector<std::string>& uuids) {
+    dataset_catalog_.Delete(uuids);
+  }
+
+  // Queue deletes of the least recently modified datasets until the others
+  // fit into a storage quota, run in the background.
+  //
+  // @param max_bytes: storage quota for all datasets.
+  // @return: the number of datasets queued for deletion.
+  int EnforceDatasetQuota(uint64_t max_bytes) {
+    return dataset_catalog_.EnforceQuota(max_bytes);
+  }
+
+  // Get one line per dataset with its size, and a summary line.
+  //
+  // @return: dataset debug string for display on Java activity.
+  std::string GetDatasetString();
+
   // Tango service pose callback function for pose data. Called when new
   // information about device pose is available from the Tango Service.
   //
@@ -110,6 +210,12 @@ class AreaLearningApp {
   // @param event: Tango event, caller allocated.
   void onTangoEventAvailable(const TangoEvent* event);
 
+  // Tango service point cloud callback function for depth data. Queues the
+  // footprint of the frame for the coverage heatmap.
+  //
+  // @param xyz_ij: The point cloud returned by the service, caller allocated.
+  void onXYZijAvailable(const TangoXYZij* xyz_ij);
+
   // Allocate OpenGL resources for rendering, mainly initializing the Scene.
   void InitializeGLContent();
 
@@ -146,7 +252,10 @@ class AreaLearningApp {
   // Retrun Tango Service version string.
   std::string GetVersionString();
 
-  std::string GetLoadedAdfString() { return loaded_adf_string_; }
+  std::string GetLoadedAdfString() {
+    std::lock_guard<std::mutex> lock(loaded_adf_mutex_);
+    return loaded_adf_string_;
+  }
 
   // Set render camera's viewing angle, first person, third person or top down.
   //
@@ -155,7 +264,8 @@ class AreaLearningApp {
   void SetCameraType(tango_gl::GestureCamera::CameraType camera_type);
 
   // Touch event passed from android activity. This function only supports two
-  // touches.
+  // touches. Called on the UI thread, the event is queued and applied by the
+  // next Render().
   //
   // @param: touch_count, total count for touches.
   // @param: event, touch event of current touch.
@@ -171,41 +281,59 @@ class AreaLearningApp {
   // @JavaVM java_vm: the Java VM is using from the Java layer.
   void SetJavaVM(JavaVM* java_vm) { java_vm_ = java_vm; }
 
-  // Callback function when the Adf saving progress.
+  // Callback function when the Adf saving finished, called on the save
+  // thread.
   //
-  // @JavaVM progress: current progress value, the value is between 1 to 100,
-  //                   inclusive.
-  void OnAdfSavingProgressChanged(int progress);
+  // @param uuid: UUID of the saved ADF, empty if the save failed.
+  void OnAdfSaveFinished(const std::string& uuid);
+
+  // Callback function when an ADF switch finished, called on the switcher
+  // thread.
+  //
+  // @param uuid: UUID of the ADF switched to.
+  // @param succeeded: false if the ADF could not be loaded.
+  void OnAdfSwitched(const std::string& uuid, bool succeeded);
 
  private:
+  // Footprint of a depth frame, waiting for the GL thread to add it to the
+  // coverage heatmap.
+  struct Footprint {
+    glm::mat4 start_service_T_device;
+    float range;
+  };
+
   // Get the Tango Service version.
   //
   // @return: Tango Service's version.
   std::string GetTangoServiceVersion();
 
-  // Get the vector list of all ADF stored in the Tango space.
-  //
-  // @adf_list: ADF UUID list to be filled in.
-  void GetAdfUuids(std::vector<std::string>* adf_list);
+  // Add the footprints queued by onXYZijAvailable() to the coverage heatmap.
+  // Called on the GL thread.
+  void AddCoverage();
 
   // pose_data_ handles all pose onPoseAvailable callbacks, onPoseAvailable()
   // in this object will be routed to pose_data_ to handle.
   PoseData pose_data_;
 
-  // Mutex for protecting the pose data. The pose data is shared between render
-  // thread and TangoService callback thread.
-  std::mutex pose_mutex_;
+  // Serializes UpdatePose() on the callback thread with ResetPoseData() on the
+  // GL thread. Readers of pose_data_ do not lock.
+  std::mutex pose_update_mutex_;
+
+  // Start service with respect to ADF pose the ADF trace was last drawn
+  // with, only used on the GL thread.
+  TangoPoseData adf_T_start_service_;
 
   // tango_event_data_ handles all Tango event callbacks,
   // onTangoEventAvailable() in this object will be routed to tango_event_data_
   // to handle.
   TangoEventData tango_event_data_;
 
-  // tango_event_data_ is share between the UI thread we start for updating
-  // debug
-  // texts and the TangoService event callback thread. We keep event_mutex_ to
-  // protect tango_event_data_.
-  std::mutex tango_event_mutex_;
+  // Typed Tango events from the callback thread, dispatched by Render() on
+  // the GL thread.
+  tango_gl::EventBus event_bus_;
+
+  // Touch events from the UI thread, drained by Render() on the GL thread.
+  tango_gl::TouchQueue touch_queue_;
 
   // main_scene_ includes all drawable object for visualizing Tango device's
   // movement.
@@ -219,14 +347,57 @@ class AreaLearningApp {
   // Tango service version string.
   std::string tango_core_version_string_;
 
-  // Current loaded ADF.
+  // Current loaded ADF, guarded by loaded_adf_mutex_ as switches update it.
+  std::mutex loaded_adf_mutex_;
   std::string loaded_adf_string_;
 
-  // Cached Java VM, caller activity object and the request render method. These
-  // variables are used for get the saving Adf progress bar update.
+  // Whether learning mode is on, ADFs can only be switched without it.
+  bool is_area_learning_enabled_;
+
+  // ADF to switch to once connected, empty for none.
+  std::string initial_adf_uuid_;
+
+  // ADF loaded before the last switch, the likely next one to come back to.
+  // Only used on the switcher thread.
+  std::string previous_adf_uuid_;
+
+  // Set by a finished switch, the GL thread then restarts the ADF trace.
+  std::atomic<bool> has_adf_switched_;
+
+  // Caches the ADF list and metadata.
+  AdfCatalog adf_catalog_;
+
+  // Runs ADF imports and exports, declared after adf_catalog_ which its
+  // completion callback updates.
+  AdfTransferManager adf_transfer_manager_;
+
+  // Runs ADF saves off the UI and render threads.
+  AdfSaver adf_saver_;
+
+  // Caches the dataset list and sizes, and deletes datasets.
+  DatasetCatalog dataset_catalog_;
+
+  // Loads and prefetches ADFs while connected. Declared after the members its
+  // completion callback updates.
+  AdfSwitcher adf_switcher_;
+
+  // Footprints from the depth callback thread, and the depth camera
+  // calibration they are added with, queried once connected.
+  std::mutex footprint_mutex_;
+  std::vector<Footprint> pending_footprints_;
+  bool has_depth_calibration_;
+  bool is_depth_calibration_new_;
+  TangoCameraIntrinsics depth_intrinsics_;
+  glm::mat4 device_T_depth_;
+  // Set by a motion tracking reset, the GL thread then clears the heatmap,
+  // which was in the old start service frame.
+  std::atomic<bool> has_motion_tracking_reset_;
+
+  // Cached Java VM, caller activity object and the save finished method. These
+  // variables are used for reporting the end of an Adf save.
   JavaVM* java_vm_;
   jobject calling_activity_obj_;
-  jmethodID on_saving_adf_progress_updated_;
+  jmethodID on_adf_save_finished_;
 };
 }  // namespace tango_area_learning
 
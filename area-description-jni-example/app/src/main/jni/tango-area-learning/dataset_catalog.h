@@ -0,0 +1,134 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_AREA_LEARNING_DATASET_CATALOG_H_
+#define TANGO_AREA_LEARNING_DATASET_CATALOG_H_
+
+#include <stdint.h>
+
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace tango_area_learning {
+
+// DatasetCatalog is an in-memory inventory of the datasets recorded by the
+// Tango Service, with their size on disk.
+//
+// Enumerating datasets and deleting them are round trips to the service, and
+// sizing a dataset walks its directory, so both run on a background thread.
+// Queries are served from the inventory of the last refresh and never wait.
+// A refresh only sizes datasets it has not seen yet, plus the current one
+// which is still growing.
+//
+// All methods can be called from any thread.
+class DatasetCatalog {
+ public:
+  struct Dataset {
+    std::string uuid;
+    // Bytes on disk, 0 without a dataset directory.
+    uint64_t bytes;
+    // Last modification of the dataset directory, in seconds since the epoch.
+    int64_t modified_time;
+    // The dataset is being recorded.
+    bool is_current;
+    // A delete of the dataset is queued or running.
+    bool is_deleting;
+  };
+
+  DatasetCatalog();
+  DatasetCatalog(const DatasetCatalog& other) = delete;
+  const DatasetCatalog& operator=(const DatasetCatalog&) = delete;
+  ~DatasetCatalog();
+
+  // Set the directory the Tango Service records datasets into, each dataset
+  // is a subdirectory named by its UUID. Sizes of datasets already in the
+  // inventory are kept, call Refresh() after changing it.
+  void SetDatasetDirectory(const std::string& directory);
+
+  // Queue a refresh of the inventory on the background thread.
+  void Refresh();
+
+  // Copy the inventory of the last refresh, in the order the Tango Service
+  // lists the datasets.
+  //
+  // @param datasets: filled with the datasets.
+  // @return: false if no refresh has finished yet.
+  bool GetDatasets(std::vector<Dataset>* datasets);
+
+  // Return the bytes of all datasets not being deleted.
+  uint64_t GetTotalBytes();
+
+  // Queue deletes of datasets, the background thread runs all queued deletes
+  // in one batch before the next refresh. Datasets leave the inventory once
+  // their delete succeeded.
+  //
+  // @param uuids: UUIDs of the datasets.
+  void Delete(const std::vector<std::string>& uuids);
+
+  // Queue deletes of the least recently modified datasets until the others
+  // fit into a storage quota. The current dataset is never deleted.
+  //
+  // @param max_bytes: storage quota for all datasets.
+  // @return: the number of datasets queued for deletion.
+  int EnforceQuota(uint64_t max_bytes);
+
+  // Return the number of queued and running deletes.
+  int GetPendingDeleteCount();
+
+  // Stop the background thread after the running batch, queued work is
+  // dropped.
+  void Stop();
+
+ private:
+  // Start the background thread if needed, called with mutex_ held.
+  void StartWorker();
+
+  // Queue the delete of a dataset, called with mutex_ held.
+  void QueueDelete(Dataset* dataset);
+
+  void WorkerLoop();
+
+  // Enumerate the datasets, sizing the ones not in known by UUID and the
+  // current one. Called without mutex_ held.
+  static bool LoadDatasets(const std::string& directory,
+                           const std::map<std::string, Dataset>& known,
+                           std::vector<Dataset>* datasets);
+
+  std::thread thread_;
+
+  // Guards everything below.
+  std::mutex mutex_;
+  std::condition_variable work_available_;
+  bool is_stopping_;
+  bool is_refresh_requested_;
+
+  std::string directory_;
+  bool is_loaded_;
+  std::vector<Dataset> datasets_;
+
+  // UUIDs of queued deletes, and of queued or running ones.
+  std::vector<std::string> queued_deletes_;
+  std::set<std::string> deleting_;
+};
+}  // namespace tango_area_learning
+
+#endif  // TANGO_AREA_LEARNING_DATASET_CATALOG_H_
@@ -18,37 +18,46 @@
 #define TANGO_AREA_LEARNING_POSE_DATA_H_
 
 #include <jni.h>
-#include <mutex>
+
+#include <string>
+#include <vector>
 
 #include <tango_client_api.h>  // NOLINT
+#include <tango-gl/bounded_queue.h>
+#include <tango-gl/pose_stream.h>
+#include <tango-gl/seqlock.h>
 #include <tango-gl/util.h>
 
 namespace tango_area_learning {
 
-// PoseDataInfo is a data container class for storing pose data to compute all
-// the debug data we want show on screen.
-class PoseDataInfo {
- public:
-  PoseDataInfo() {
-    pose_string = "N/A";
-    cur_pose = TangoPoseData();
-    prev_pose = TangoPoseData();
-    pose_counter = 0;
-  }
-
-  TangoPoseData cur_pose;
-  TangoPoseData prev_pose;
-  std::string pose_string;
-  size_t pose_counter;
-};
-
 // PoseData holds all pose related data. E.g. pose position, rotation and time-
 // stamp. It also produce the debug information strings.
+//
+// The poses of the three frame pairs are fanned out by a PoseStream, so the
+// getters can be called from any thread without locking. The debug strings
+// and the trajectory only need a fraction of the poses: they subscribe to
+// the stream with limits, so the poses they skip cost them nothing. The
+// debug strings are only formatted when they are asked for. UpdatePose() and
+// ResetPoseData() must not run concurrently with each other.
 class PoseData {
  public:
   PoseData();
   ~PoseData();
 
+  // Pop the oldest pose queued for the trajectory, the device with respect
+  // to the ADF once relocalized and to start of service before. Poses are
+  // queued once the device moved a few centimeters, and dropped by
+  // ResetPoseData().
+  //
+  // @return: false if no pose is queued.
+  bool PopTrajectoryPose(TangoPoseData* pose);
+
+  // Frame pairs to pass to TangoService_connectOnPoseAvailable().
+  const TangoCoordinateFramePair* GetFramePairs() const {
+    return pose_stream_.GetFramePairs();
+  }
+  int GetFramePairCount() const { return pose_stream_.GetPairCount(); }
+
   // Update current pose and previous pose.
   //
   // @param pose: pose data of current frame.
@@ -72,6 +81,12 @@ class PoseData {
   // @return: pose debug strings for dispaly on Java activity.
   std::string GetAdfTStartServiceString();
 
+  // Get the latest pose of the start service frame with respect to the ADF
+  // frame, it changes when the ADF localization corrects the trajectory.
+  //
+  // @return: latest adf_T_start_service pose.
+  TangoPoseData GetAdfTStartServicePose();
+
   // Get pose data in current frame.
   //
   // @return: curent pose data.
@@ -80,7 +95,15 @@ class PoseData {
   // Check if the device is relocalized.
   //
   // @return: relocalized flag.
-  bool IsRelocalized() { return is_relocalized; }
+  bool IsRelocalized() { return pose_stream_.IsRelocalized(); }
+
+  // Get the number of relocalizations since the last reset, it changes every
+  // time poses in the ADF frame were corrected.
+  //
+  // @return: relocalization count.
+  uint32_t GetRelocalizationCount() {
+    return pose_stream_.GetRelocalizationCount();
+  }
 
  private:
   // Convert TangoPoseStatusType to string.
@@ -90,23 +113,28 @@ class PoseData {
   // @return: corresponding string based on status passed in.
   std::string GetStringFromStatusCode(TangoPoseStatusType status);
 
-  // Format the pose debug string based on current pose and previous pose data.
-  void FormatPoseString(PoseDataInfo* pose_data_info);
+  // Format the pose debug string of a frame pair's latest displayed pose.
+  std::string FormatPoseString(int pair);
+
+  // Queue a pose for the trajectory, on the callback thread.
+  void QueueTrajectoryPose(const TangoPoseData& pose);
 
-  // Pose data and debug information of start_service_T_device pose data.
-  // start_service_T_device represents device with respect to start of service
-  // frame.
-  PoseDataInfo start_service_T_device_pose_;
+  // Poses waiting for PopTrajectoryPose(), the newest are dropped when full.
+  tango_gl::BoundedQueue<TangoPoseData> trajectory_poses_;
 
-  // Pose data and debug information of adf_T_device pose data.
-  PoseDataInfo adf_T_device_pose_;
+  // Latest pose of each frame pair at the rate the debug strings are
+  // refreshed at.
+  tango_gl::SeqLock<tango_gl::PoseStream::Snapshot>
+      displayed_poses_[tango_gl::PoseStream::kMaxFramePairs];
 
-  // Pose data and debug information of adf_T_start_service pose data.
-  PoseDataInfo adf_T_start_service_pose_;
+  // Fans out the poses of start_service_T_device, adf_T_device and
+  // adf_T_start_service. start_service_T_device represents device with
+  // respect to start of service frame. The relocalization is determined by
+  // the pose in start of service with respect to ADF turning valid.
+  tango_gl::PoseStream pose_stream_;
 
-  // Relocalized flag, the relocalization is determined by the pose in start of
-  // service with respect to ADF turns to valid.
-  bool is_relocalized = false;
+  // Subscriptions of the debug strings and the trajectory to pose_stream_.
+  std::vector<int> subscriptions_;
 };
 }  // namespace tango_area_learning
 
@@ -24,8 +24,10 @@
 #include <tango-gl/axis.h>
 #include <tango-gl/camera.h>
 #include <tango-gl/color.h>
+#include <tango-gl/coverage_map.h>
 #include <tango-gl/gesture_camera.h>
 #include <tango-gl/grid.h>
+#include <tango-gl/scene_graph.h>
 #include <tango-gl/frustum.h>
 #include <tango-gl/trace.h>
 #include <tango-gl/transform.h>
@@ -57,9 +59,43 @@ class Scene {
   // Render loop.
   //
   // @param: cur_pose, TangoPoseData of current frame.
-  // @param: is_relocalized, relocalization flag, the program use the flag to
-  //         determine the trajactory color.
-  void Render(const TangoPoseData& cur_pose, bool is_relocalized);
+  void Render(const TangoPoseData& cur_pose);
+
+  // Append a pose to the trajectory. Poses of the device with respect to the
+  // ADF go to the ADF trace, the others to the motion tracking trace.
+  //
+  // @param: pose, valid pose of the device.
+  void AddTrajectoryPose(const TangoPoseData& pose);
+
+  // Move the ADF trajectory drawn so far along with a correction of the
+  // start service frame with respect to the ADF frame, e.g. after a loop
+  // closure. The trace is corrected in the background.
+  //
+  // @param: old_adf_T_start_service, pose the trajectory was drawn with.
+  // @param: new_adf_T_start_service, corrected pose.
+  void CorrectAdfTrace(const TangoPoseData& old_adf_T_start_service,
+                       const TangoPoseData& new_adf_T_start_service);
+
+  // Drop the ADF trajectory drawn so far, e.g. after switching to another
+  // ADF whose frame it is not in.
+  void ClearAdfTrace();
+
+  // Set the intrinsics of the depth camera the coverage footprints are
+  // computed with. Coverage is not added before.
+  void SetDepthCameraIntrinsics(const TangoCameraIntrinsics& intrinsics);
+
+  // Add the footprint of a depth frame to the coverage heatmap drawn under
+  // the grid.
+  //
+  // @param: start_service_T_depth, pose of the depth camera with respect to
+  //         the start service frame at the frame timestamp.
+  // @param: range, distance in meters the frame reaches, e.g. its average
+  //         depth.
+  void AddCoverage(const glm::mat4& start_service_T_depth, float range);
+
+  // Drop the coverage so far, e.g. after a motion tracking reset moved the
+  // start service frame.
+  void ClearCoverage();
 
   // Set render camera's viewing angle, first person, third person or top down.
   //
@@ -99,6 +135,13 @@ class Scene {
   // Trace of ADF pose data, ADF pose is the device with respect to ADF pose
   // frame.
   tango_gl::Trace* adf_trace_;
+
+  // Ground heatmap of what the depth camera has seen, in the start service
+  // frame. Drawn before, and so under, the drawables of the scene graph.
+  tango_gl::CoverageMap* coverage_map_;
+
+  // Draw list of the drawables above.
+  tango_gl::SceneGraph scene_graph_;
 };
 }  // namespace tango_area_learning
 
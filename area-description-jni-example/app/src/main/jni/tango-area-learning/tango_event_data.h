@@ -21,6 +21,7 @@
 #include <mutex>
 
 #include <tango_client_api.h>  // NOLINT
+#include <tango-gl/seqlock.h>
 
 namespace tango_area_learning {
 
@@ -42,14 +43,26 @@ class TangoEventData {
   // @param: event, TangoEvent in current frame.
   void UpdateTangoEvent(const TangoEvent* event);
 
-  // Clear event string. Set event_string_ to empty.
+  // Clear the current event.
   void ClearEventString();
 
   // Get formated event string for debug dispaly purpose.
   std::string GetTangoEventString();
+
  private:
-  // Current event string.
-  std::string event_string_;
+  // Longest event key and value kept, longer ones are truncated.
+  static const size_t kMaxEventKeyLength = 63;
+  static const size_t kMaxEventValueLength = 127;
+
+  // Latest event, copied out of the callback's strings so no formatting or
+  // allocation happens until GetTangoEventString() is called, from any
+  // thread. Updates come from the event callback thread.
+  struct EventSnapshot {
+    char key[kMaxEventKeyLength + 1];
+    char value[kMaxEventValueLength + 1];
+  };
+
+  tango_gl::SeqLock<EventSnapshot> event_;
 };
 }  // namespace tango_area_learning
 
@@ -14,13 +14,13 @@
  * limitations under the License.
  */
 
-#include <sstream>
+#include <string.h>
 
 #include "tango-area-learning/tango_event_data.h"
 
 namespace tango_area_learning {
 
-TangoEventData::TangoEventData() { event_string_ = "N/A"; }
+TangoEventData::TangoEventData() {}
 
 TangoEventData::~TangoEventData() {}
 
@@ -30,20 +30,29 @@ TangoEventData::~TangoEventData() {}
 //
 // @param: event, TangoEvent in current frame.
 void TangoEventData::UpdateTangoEvent(const TangoEvent* event) {
-  std::stringstream string_stream;
-  string_stream << event->event_key << ": " << event->event_value;
-  event_string_ = string_stream.str();
-  string_stream.flush();
+  EventSnapshot snapshot;
+  strncpy(snapshot.key, event->event_key != nullptr ? event->event_key : "",
+          kMaxEventKeyLength);
+  snapshot.key[kMaxEventKeyLength] = '\0';
+  strncpy(snapshot.value,
+          event->event_value != nullptr ? event->event_value : "",
+          kMaxEventValueLength);
+  snapshot.value[kMaxEventValueLength] = '\0';
+  event_.Store(snapshot);
 }
 
-// Clear event string. Set event_string_ to empty.
+// Clear the current event.
 void TangoEventData::ClearEventString() {
-  event_string_.clear();
+  event_.Store(EventSnapshot());
 }
 
 // Get formated event string for debug dispaly purpose.
 std::string TangoEventData::GetTangoEventString() {
-  return event_string_;
+  EventSnapshot snapshot = event_.Load();
+  if (snapshot.key[0] == '\0') {
+    return "N/A";
+  }
+  return std::string(snapshot.key) + ": " + snapshot.value;
 }
 
 } //namespace tango_area_learning
\ No newline at end of file
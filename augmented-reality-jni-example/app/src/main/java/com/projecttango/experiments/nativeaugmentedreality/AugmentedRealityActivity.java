@@ -24,6 +24,7 @@ import android.content.pm.PackageManager.NameNotFoundException;
 import android.graphics.Point;
 import android.opengl.GLSurfaceView;
 import android.os.Bundle;
+import android.os.Environment;
 import android.util.Log;
 import android.view.Display;
 import android.view.MotionEvent;
@@ -33,6 +34,9 @@ import android.widget.Button;
 import android.widget.TextView;
 import android.widget.Toast;
 
+import java.io.File;
+import java.io.IOException;
+
 // The main activity of the application which shows debug information and a
 // glSurfaceView that renders graphic content.
 public class AugmentedRealityActivity extends Activity implements
@@ -73,6 +77,15 @@ public class AugmentedRealityActivity extends Activity implements
   // wait for re-initialization of the motion tracking system.
   private Button mMotionReset;
 
+  // Button starting and stopping the recording of the rendered view.
+  private Button mRecordButton;
+
+  // Encoder of the recording in progress, null when not recording.
+  private VideoRecorder mVideoRecorder;
+
+  // EGL config of the view, recordable when the device has one.
+  private RecordableConfigChooser mConfigChooser;
+
   // GLSurfaceView and its renderer, all of the graphic content is rendered
   // through OpenGL ES 2.0 in the native code.
   private AugmentedRealityRenderer mRenderer;
@@ -136,6 +149,24 @@ public class AugmentedRealityActivity extends Activity implements
     // Set up button click listeners
     mMotionReset.setOnClickListener(this);
 
+    mRecordButton = (Button) findViewById(R.id.record_button);
+    mRecordButton.setOnClickListener(this);
+
+    // Ask for an EGL config the video encoder can be rendered into, the record
+    // button is hidden on devices without one.
+    mConfigChooser = new RecordableConfigChooser(new Runnable() {
+      @Override
+      public void run() {
+        runOnUiThread(new Runnable() {
+          @Override
+          public void run() {
+            disableRecording();
+          }
+        });
+      }
+    });
+    mGLView.setEGLConfigChooser(mConfigChooser);
+
     // Configure OpenGL renderer. The RENDERMODE_WHEN_DIRTY is set explicitly
     // for reducing the CPU load. The request render function call is triggered
     // by the onTextureAvailable callback from the Tango Service in the native
@@ -187,6 +218,10 @@ public class AugmentedRealityActivity extends Activity implements
   @Override
   protected void onPause() {
     super.onPause();
+    // The recording surface is released on the GL thread before it stops.
+    if (mVideoRecorder != null) {
+      stopRecording();
+    }
     mGLView.onPause();
     TangoJNINative.freeGLContent();
 
@@ -214,6 +249,13 @@ public class AugmentedRealityActivity extends Activity implements
       case R.id.resetmotion:
         TangoJNINative.resetMotionTracking();
         break;
+      case R.id.record_button:
+        if (mVideoRecorder == null) {
+          startRecording();
+        } else {
+          stopRecording();
+        }
+        break;
       default:
         Log.w(TAG, "Unknown button click");
         return;
@@ -258,6 +300,73 @@ public class AugmentedRealityActivity extends Activity implements
     mGLView.requestRender();
   }
 
+  // Record the rendered view into an MP4 file on the external storage. The
+  // native layer renders every frame a second time into the encoder.
+  private void startRecording() {
+    if (!mConfigChooser.isRecordable()) {
+      disableRecording();
+      return;
+    }
+    File file = new File(Environment.getExternalStorageDirectory(),
+        "augmented_reality_" + System.currentTimeMillis() + ".mp4");
+    final VideoRecorder recorder;
+    try {
+      recorder = new VideoRecorder(mGLView.getWidth(), mGLView.getHeight(),
+                                   file.getPath());
+    } catch (IOException e) {
+      Log.e(TAG, "Could not start the video encoder", e);
+      Toast.makeText(this, "Recording Error", Toast.LENGTH_SHORT).show();
+      return;
+    }
+    mVideoRecorder = recorder;
+    mRecordButton.setText(R.string.stop_recording);
+    mGLView.queueEvent(new Runnable() {
+      @Override
+      public void run() {
+        if (!TangoJNINative.startRecording(recorder.getInputSurface())) {
+          Log.e(TAG, "Could not render into the video encoder");
+          runOnUiThread(new Runnable() {
+            @Override
+            public void run() {
+              Toast.makeText(AugmentedRealityActivity.this, "Recording Error",
+                             Toast.LENGTH_SHORT).show();
+              disableRecording();
+            }
+          });
+        }
+      }
+    });
+  }
+
+  // Stop rendering into the encoder on the GL thread, then finish the file
+  // without blocking either thread.
+  private void stopRecording() {
+    final VideoRecorder recorder = mVideoRecorder;
+    mVideoRecorder = null;
+    mRecordButton.setText(R.string.record);
+    mGLView.queueEvent(new Runnable() {
+      @Override
+      public void run() {
+        TangoJNINative.stopRecording();
+        new Thread(new Runnable() {
+          @Override
+          public void run() {
+            recorder.stop();
+          }
+        }).start();
+      }
+    });
+  }
+
+  // Hide the record button, e.g. when the view cannot be recorded, and stop
+  // the recording in progress if any.
+  private void disableRecording() {
+    if (mVideoRecorder != null) {
+      stopRecording();
+    }
+    mRecordButton.setVisibility(View.GONE);
+  }
+
   // UI thread for handling debug text changes.
   private void startUIThread() {
     new Thread(new Runnable() {
@@ -0,0 +1,86 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package com.projecttango.experiments.nativeaugmentedreality;
+
+import android.opengl.GLSurfaceView;
+import android.util.Log;
+
+import javax.microedition.khronos.egl.EGL10;
+import javax.microedition.khronos.egl.EGLConfig;
+import javax.microedition.khronos.egl.EGLDisplay;
+
+// RecordableConfigChooser picks an RGB888 config with a depth buffer that the
+// input surface of a video encoder can also be created with, so the rendered
+// view can be recorded, see TangoJNINative.startRecording(). Devices without
+// such a config get one that is not recordable, and onNotRecordable is run on
+// the GL thread.
+public class RecordableConfigChooser implements GLSurfaceView.EGLConfigChooser {
+  private static final String TAG = RecordableConfigChooser.class.getSimpleName();
+
+  // From EGLExt, which EGL10 does not have.
+  private static final int EGL_RECORDABLE_ANDROID = 0x3142;
+
+  private final Runnable mOnNotRecordable;
+  private volatile boolean mIsRecordable = false;
+
+  public RecordableConfigChooser(Runnable onNotRecordable) {
+    mOnNotRecordable = onNotRecordable;
+  }
+
+  @Override
+  public EGLConfig chooseConfig(EGL10 egl, EGLDisplay display) {
+    EGLConfig config = chooseConfig(egl, display, new int[] {
+        EGL10.EGL_RED_SIZE, 8,
+        EGL10.EGL_GREEN_SIZE, 8,
+        EGL10.EGL_BLUE_SIZE, 8,
+        EGL10.EGL_DEPTH_SIZE, 16,
+        EGL_RECORDABLE_ANDROID, 1,
+        EGL10.EGL_NONE});
+    mIsRecordable = config != null;
+    if (config == null) {
+      Log.w(TAG, "No recordable EGL config, recording is disabled.");
+      config = chooseConfig(egl, display, new int[] {
+          EGL10.EGL_RED_SIZE, 8,
+          EGL10.EGL_GREEN_SIZE, 8,
+          EGL10.EGL_BLUE_SIZE, 8,
+          EGL10.EGL_DEPTH_SIZE, 16,
+          EGL10.EGL_NONE});
+      if (config == null) {
+        throw new IllegalArgumentException("No EGL config matches.");
+      }
+      mOnNotRecordable.run();
+    }
+    return config;
+  }
+
+  // Whether the chosen config is recordable, false before one is chosen.
+  public boolean isRecordable() {
+    return mIsRecordable;
+  }
+
+  // First config matching the attributes, null if none does.
+  private static EGLConfig chooseConfig(EGL10 egl, EGLDisplay display,
+                                        int[] attributes) {
+    EGLConfig[] configs = new EGLConfig[1];
+    int[] configCount = new int[1];
+    if (!egl.eglChooseConfig(display, attributes, configs, 1, configCount) ||
+        configCount[0] == 0) {
+      return null;
+    }
+    return configs[0];
+  }
+}
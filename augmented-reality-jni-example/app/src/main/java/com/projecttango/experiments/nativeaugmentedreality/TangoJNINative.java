@@ -16,6 +16,8 @@
 
 package com.projecttango.experiments.nativeaugmentedreality;
 
+import android.view.Surface;
+
 // Interfaces between native C++ code and Java code.
 public class TangoJNINative {
   static {
@@ -72,6 +74,32 @@ public class TangoJNINative {
   // Get the TangoCore version from our application for display in our debug UI.
   public static native String getVersionNumber();
 
+  // Render virtual content with the pose predicted for display time.
+  public static native void setPosePrediction(boolean on);
+
+  // Hide virtual content behind real surfaces seen by the depth camera.
+  public static native void setDepthOcclusion(boolean on);
+
+  // Upsample the occlusion depth from a quarter resolution image, keeping
+  // depth edges sharp.
+  public static native void setEdgeAwareOcclusion(boolean on);
+
+  // When a frame would miss its vsync, warp the previous virtual content to
+  // the current pose over the live camera image instead of rendering it.
+  public static native void setLateReprojection(boolean on);
+
+  // Render at a steady rate of framesPerSecond, 0 for the display rate.
+  public static native void setTargetFrameRate(int framesPerSecond);
+
+  // Render every frame a second time into a video encoder input surface.
+  // Must be called on the GL thread, returns false if the surface can not be
+  // rendered to.
+  public static native boolean startRecording(Surface surface);
+
+  // Stop rendering into the encoder input surface. Must be called on the GL
+  // thread.
+  public static native void stopRecording();
+
   // Pass touch events to the native layer.
   public static native void onTouchEvent(int touchCount, int event0,
                                          float x0, float y0, float x1, float y1);
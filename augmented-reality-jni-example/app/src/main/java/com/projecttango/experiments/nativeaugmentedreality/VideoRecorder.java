@@ -0,0 +1,135 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package com.projecttango.experiments.nativeaugmentedreality;
+
+import android.media.MediaCodec;
+import android.media.MediaCodecInfo;
+import android.media.MediaFormat;
+import android.media.MediaMuxer;
+import android.util.Log;
+import android.view.Surface;
+
+import java.io.IOException;
+import java.nio.ByteBuffer;
+
+// VideoRecorder encodes the frames rendered into its input surface to an
+// H.264 MP4 file. The native layer renders each frame into the surface on the
+// GPU, see TangoJNINative.startRecording(); the encoder output is drained
+// into the file on a thread of its own.
+public class VideoRecorder {
+  private static final String TAG = VideoRecorder.class.getSimpleName();
+
+  private static final String MIME_TYPE = "video/avc";
+  private static final int FRAME_RATE = 30;
+  private static final int I_FRAME_INTERVAL_S = 1;
+  // Bits per pixel and frame, about 8 Mbps at 1080p.
+  private static final float BITS_PER_PIXEL = 0.13f;
+  private static final long DRAIN_TIMEOUT_US = 10000;
+
+  private final MediaCodec mEncoder;
+  private final MediaMuxer mMuxer;
+  private final Surface mInputSurface;
+  private final Thread mDrainThread;
+  private int mTrackIndex = -1;
+
+  // Start an encoder of the given size, writing to outputPath. Encoders want
+  // even sizes, the size is rounded down to a multiple of 16.
+  public VideoRecorder(int width, int height, String outputPath)
+      throws IOException {
+    width &= ~15;
+    height &= ~15;
+    MediaFormat format = MediaFormat.createVideoFormat(MIME_TYPE, width, height);
+    format.setInteger(MediaFormat.KEY_COLOR_FORMAT,
+        MediaCodecInfo.CodecCapabilities.COLOR_FormatSurface);
+    format.setInteger(MediaFormat.KEY_BIT_RATE,
+        (int) (BITS_PER_PIXEL * width * height * FRAME_RATE));
+    format.setInteger(MediaFormat.KEY_FRAME_RATE, FRAME_RATE);
+    format.setInteger(MediaFormat.KEY_I_FRAME_INTERVAL, I_FRAME_INTERVAL_S);
+
+    mEncoder = MediaCodec.createEncoderByType(MIME_TYPE);
+    mEncoder.configure(format, null, null, MediaCodec.CONFIGURE_FLAG_ENCODE);
+    mInputSurface = mEncoder.createInputSurface();
+    mEncoder.start();
+    mMuxer = new MediaMuxer(outputPath,
+        MediaMuxer.OutputFormat.MUXER_OUTPUT_MPEG_4);
+
+    mDrainThread = new Thread(new Runnable() {
+      @Override
+      public void run() {
+        drain();
+      }
+    }, "VideoRecorder");
+    mDrainThread.start();
+  }
+
+  // The surface the native layer renders into.
+  public Surface getInputSurface() {
+    return mInputSurface;
+  }
+
+  // Finish the file. Call after TangoJNINative.stopRecording(), no frames may
+  // be rendered into the input surface afterwards. Blocks until the encoder
+  // drained.
+  public void stop() {
+    mEncoder.signalEndOfInputStream();
+    try {
+      mDrainThread.join();
+    } catch (InterruptedException e) {
+      Thread.currentThread().interrupt();
+    }
+    mEncoder.stop();
+    mEncoder.release();
+    mInputSurface.release();
+    if (mTrackIndex >= 0) {
+      mMuxer.stop();
+    }
+    mMuxer.release();
+  }
+
+  // Write the encoded frames to the muxer until the end of the stream.
+  private void drain() {
+    MediaCodec.BufferInfo info = new MediaCodec.BufferInfo();
+    ByteBuffer[] outputBuffers = mEncoder.getOutputBuffers();
+    while (true) {
+      int index = mEncoder.dequeueOutputBuffer(info, DRAIN_TIMEOUT_US);
+      if (index == MediaCodec.INFO_TRY_AGAIN_LATER) {
+        continue;
+      } else if (index == MediaCodec.INFO_OUTPUT_BUFFERS_CHANGED) {
+        outputBuffers = mEncoder.getOutputBuffers();
+      } else if (index == MediaCodec.INFO_OUTPUT_FORMAT_CHANGED) {
+        mTrackIndex = mMuxer.addTrack(mEncoder.getOutputFormat());
+        mMuxer.start();
+      } else if (index >= 0) {
+        // The codec config is part of the output format.
+        boolean isConfig =
+            (info.flags & MediaCodec.BUFFER_FLAG_CODEC_CONFIG) != 0;
+        if (!isConfig && info.size > 0 && mTrackIndex >= 0) {
+          ByteBuffer data = outputBuffers[index];
+          data.position(info.offset);
+          data.limit(info.offset + info.size);
+          mMuxer.writeSampleData(mTrackIndex, data, info);
+        }
+        mEncoder.releaseOutputBuffer(index, false);
+        if ((info.flags & MediaCodec.BUFFER_FLAG_END_OF_STREAM) != 0) {
+          return;
+        }
+      } else {
+        Log.w(TAG, "Unexpected encoder status " + index);
+      }
+    }
+  }
+}
@@ -14,7 +14,14 @@
  * limitations under the License.
  */
 
+#include <android/native_window_jni.h>
+
+#include <algorithm>
+#include <chrono>
+
 #include <tango-gl/conversions.h>
+#include <tango-gl/program_cache.h>
+#include <tango-gl/render_state.h>
 
 #include "tango-augmented-reality/augmented_reality_app.h"
 
@@ -25,6 +32,59 @@ const int kVersionStringLength = 128;
 const float kArCameraNearClippingPlane = 0.1f;
 const float kArCameraFarClippingPlane = 100.0f;
 
+// Time from the color image timestamp to the display of the rendered frame
+// that pose prediction extrapolates over, about two vsync periods.
+const double kPosePredictionLatency = 0.033;
+
+// Rate of the color camera, rendering is paced to it.
+const int kColorCameraFrameRate = 30;
+
+// Resolution scales of the virtual content, from the cheapest to the best.
+const float kRenderScaleLadder[] = {0.5f, 0.625f, 0.75f, 0.875f, 1.0f};
+const int kRenderScaleLevelCount =
+    sizeof(kRenderScaleLadder) / sizeof(kRenderScaleLadder[0]);
+
+// GPU time the scene may take per frame. Well under the 33 ms between two
+// color images, the compositor needs the GPU as well.
+const float kSceneGpuBudgetMs = 12.0f;
+
+// Late reprojection: percentile of the scene timings taken as its cost, and
+// the most frames in a row that reuse the previous content.
+const float kSceneCostPercentile = 0.9f;
+const int kMaxReprojectedFrames = 2;
+
+tango_gl::QualityGovernor::Options GetResolutionGovernorOptions() {
+  tango_gl::QualityGovernor::Options options;
+  options.target_frame_ms = kSceneGpuBudgetMs;
+  options.zone = "scene";
+  options.is_gpu_time = true;
+  return options;
+}
+
+// This function routes onPoseAvailable callbacks to the application object for
+// handling.
+//
+// @param context, context will be a pointer to a AugmentedRealityApp
+//        instance on which to call callbacks.
+// @param pose, pose data to route to onPoseAvailable function.
+void onPoseAvailableRouter(void* context, const TangoPoseData* pose) {
+  using namespace tango_augmented_reality;
+  AugmentedRealityApp* app = static_cast<AugmentedRealityApp*>(context);
+  app->onPoseAvailable(pose);
+}
+
+// This function routes onXYZijAvailable callbacks to the application object
+// for handling.
+//
+// @param context, context will be a pointer to a AugmentedRealityApp
+//        instance on which to call callbacks.
+// @param xyz_ij, point cloud to route to onXYZijAvailable function.
+void onXYZijAvailableRouter(void* context, const TangoXYZij* xyz_ij) {
+  using namespace tango_augmented_reality;
+  AugmentedRealityApp* app = static_cast<AugmentedRealityApp*>(context);
+  app->onXYZijAvailable(xyz_ij);
+}
+
 // This function routes onTangoEvent callbacks to the application object for
 // handling.
 //
@@ -51,18 +111,46 @@ void onTextureAvailableRouter(void* context, TangoCameraId id) {
 }  // namespace
 
 namespace tango_augmented_reality {
+void AugmentedRealityApp::onPoseAvailable(const TangoPoseData* pose) {
+  if (pose->status_code == TANGO_POSE_VALID) {
+    pose_history_.Add(pose->timestamp, pose->translation, pose->orientation);
+  } else {
+    // Poses after a tracking loss do not continue the earlier ones.
+    pose_history_.Clear();
+  }
+}
+
+void AugmentedRealityApp::onXYZijAvailable(const TangoXYZij* xyz_ij) {
+  // The write slot is owned by this thread until it is published.
+  DepthFrame* frame = depth_frames_.GetWriteBuffer();
+  frame->points.assign(xyz_ij->xyz[0], xyz_ij->xyz[0] + xyz_ij->xyz_count * 3);
+  frame->timestamp = xyz_ij->timestamp;
+  depth_frames_.Publish();
+}
+
 void AugmentedRealityApp::onTangoEventAvailable(const TangoEvent* event) {
-  std::lock_guard<std::mutex> lock(tango_event_mutex_);
   tango_event_data_.UpdateTangoEvent(event);
 }
 
 void AugmentedRealityApp::onTextureAvailable(TangoCameraId id) {
   if (id == TANGO_CAMERA_COLOR) {
-    RequestRender();
+    render_scheduler_.Signal(tango_gl::RenderScheduler::kTextureAvailable);
   }
 }
 
-AugmentedRealityApp::AugmentedRealityApp() {}
+AugmentedRealityApp::AugmentedRealityApp()
+    : pose_predictor_(&pose_history_),
+      is_pose_prediction_on_(false),
+      is_depth_occlusion_on_(true),
+      is_edge_aware_occlusion_on_(false),
+      resolution_governor_(kRenderScaleLevelCount,
+                           GetResolutionGovernorOptions()),
+      is_late_reprojection_on_(false),
+      reprojected_frame_count_(0) {
+  pose_predictor_.SetLatency(kPosePredictionLatency);
+  // One frame per color camera image, shown at a steady cadence.
+  render_scheduler_.SetTargetFrameRate(kColorCameraFrameRate);
+}
 
 AugmentedRealityApp::~AugmentedRealityApp() {
   TangoConfig_free(tango_config_);
@@ -72,6 +160,9 @@ AugmentedRealityApp::~AugmentedRealityApp() {
 }
 
 int AugmentedRealityApp::TangoInitialize(JNIEnv* env, jobject caller_activity) {
+  // Linked shader programs are persisted in the app cache directory.
+  tango_gl::program_cache::SetBinaryCacheDirectory(env, caller_activity);
+
   // The first thing we need to do for any Tango enabled application is to
   // initialize the service. We'll do that here, passing on the JNI environment
   // and jobject corresponding to the Android activity that is calling us.
@@ -118,6 +209,14 @@ int AugmentedRealityApp::TangoSetupConfig() {
     return ret;
   }
 
+  // Enable depth, the point clouds occlude the virtual content.
+  ret = TangoConfig_setBool(tango_config_, "config_enable_depth", true);
+  if (ret != TANGO_SUCCESS) {
+    LOGE("AugmentedRealityApp: config_enable_depth() failed with error"
+         "code: %d", ret);
+    return ret;
+  }
+
   // Low latency IMU integration enables aggressive integration of the latest
   // inertial measurements to provide lower latency pose estimates. This will
   // improve the AR experience.
@@ -158,12 +257,36 @@ int AugmentedRealityApp::TangoConnectCallbacks() {
     return ret;
   }
 
+  // Attach onXYZijAvailable callback for depth occlusion.
+  ret = TangoService_connectOnXYZijAvailable(onXYZijAvailableRouter);
+  if (ret != TANGO_SUCCESS) {
+    LOGE("AugmentedRealityApp: Failed to connect to point cloud callback with "
+         "error code: %d", ret);
+    return ret;
+  }
+
+  // Attach onPoseAvailable callback, the device poses are kept for pose
+  // prediction and to register the depth frames to the color image.
+  TangoCoordinateFramePair pairs;
+  pairs.base = TANGO_COORDINATE_FRAME_START_OF_SERVICE;
+  pairs.target = TANGO_COORDINATE_FRAME_DEVICE;
+  pose_history_.Clear();
+  pose_predictor_.Reset();
+  ret = TangoService_connectOnPoseAvailable(1, &pairs, onPoseAvailableRouter);
+  if (ret != TANGO_SUCCESS) {
+    LOGE("AugmentedRealityApp: Failed to connect to pose callback with error"
+         "code: %d", ret);
+    return ret;
+  }
+
   return ret;
 }
 
 // Connect to Tango Service, service will start running, and
 // pose can be queried.
 int AugmentedRealityApp::TangoConnect() {
+  // Intrinsics may change between connections, query them again.
+  camera_intrinsics_.Clear();
   TangoErrorType ret = TangoService_connect(this, tango_config_);
   if (ret != TANGO_SUCCESS) {
     LOGE("AugmentedRealityApp: Failed to connect to the Tango service with"
@@ -179,6 +302,14 @@ int AugmentedRealityApp::TangoConnect() {
         ret);
     return ret;
   }
+
+  // Render requests are sent at most once per vsync from the scheduler
+  // thread, which stays attached to the Java VM.
+  jobject activity = calling_activity_obj_;
+  jmethodID on_demand_render = on_demand_render_;
+  render_scheduler_.Start(java_vm_, [activity, on_demand_render](JNIEnv* env) {
+    env->CallVoidMethod(activity, on_demand_render);
+  });
   return ret;
 }
 
@@ -191,6 +322,28 @@ void AugmentedRealityApp::TangoDisconnect() {
   TangoConfig_free(tango_config_);
   tango_config_ = nullptr;
   TangoService_disconnect();
+
+  // Stop after the service is gone so no callback signals a stopped
+  // scheduler.
+  render_scheduler_.Stop();
+  tango_gl::RenderScheduler::Stats stats = render_scheduler_.GetStats();
+  LOGI(
+      "AugmentedRealityApp: %llu render requests for %llu color frames, %llu "
+      "vsyncs skipped with a frame in flight, %llu janky frames.",
+      static_cast<unsigned long long>(stats.requests),
+      static_cast<unsigned long long>(
+          stats.signals[tango_gl::RenderScheduler::kTextureAvailable]),
+      static_cast<unsigned long long>(stats.dropped_frames),
+      static_cast<unsigned long long>(stats.janky_frames));
+
+  if (pose_predictor_.GetMeasurementCount() > 0) {
+    LOGI(
+        "AugmentedRealityApp: Mean pose prediction error %f m, %f rad over %zu "
+        "frames.",
+        pose_predictor_.GetMeanTranslationError(),
+        pose_predictor_.GetMeanRotationError(),
+        pose_predictor_.GetMeasurementCount());
+  }
 }
 
 void AugmentedRealityApp::TangoResetMotionTracking() {
@@ -199,7 +352,14 @@ void AugmentedRealityApp::TangoResetMotionTracking() {
 }
 
 void AugmentedRealityApp::InitializeGLContent() {
+  // Anything RenderState remembers belongs to the previous GL context.
+  tango_gl::RenderState::Invalidate();
+  profiler_.Invalidate();
+
   main_scene_.InitGLContent();
+  recording_surface_.Invalidate();
+  main_scene_.SetRenderScale(
+      kRenderScaleLadder[resolution_governor_.GetLevel()]);
 
   // Connect color camera texture. TangoService_connectTextureId expects a valid
   // texture id from the caller, so we will need to wait until the GL content is
@@ -216,11 +376,12 @@ void AugmentedRealityApp::InitializeGLContent() {
 }
 
 void AugmentedRealityApp::SetViewPort(int width, int height) {
-  // Query intrinsics for the color camera from the Tango Service, because we
-  // want to match the virtual render camera's intrinsics to the physical
-  // camera, we will compute the actually projection matrix and the view port
-  // ratio for the render.
-  TangoErrorType ret = TangoService_getCameraIntrinsics(
+  // Get the intrinsics of the color camera, because we want to match the
+  // virtual render camera's intrinsics to the physical camera, we will compute
+  // the actually projection matrix and the view port ratio for the render. The
+  // registry queries the Tango Service once per connection, so resizing the
+  // view does not go through the service.
+  TangoErrorType ret = camera_intrinsics_.GetIntrinsics(
       TANGO_CAMERA_COLOR, &color_camera_intrinsics_);
   if (ret != TANGO_SUCCESS) {
     LOGE(
@@ -232,23 +393,25 @@ void AugmentedRealityApp::SetViewPort(int width, int height) {
   float image_width = static_cast<float>(color_camera_intrinsics_.width);
   float image_height = static_cast<float>(color_camera_intrinsics_.height);
   float fx = static_cast<float>(color_camera_intrinsics_.fx);
-  float fy = static_cast<float>(color_camera_intrinsics_.fy);
-  float cx = static_cast<float>(color_camera_intrinsics_.cx);
-  float cy = static_cast<float>(color_camera_intrinsics_.cy);
 
   float image_plane_ratio = image_height / image_width;
   float image_plane_distance = 2.0f * fx / image_width;
 
-  glm::mat4 projection_mat_ar =
-      tango_gl::Camera::ProjectionMatrixForCameraIntrinsics(
-          image_width, image_height, fx, fy, cx, cy, kArCameraNearClippingPlane,
-          kArCameraFarClippingPlane);
+  glm::mat4 projection_mat_ar;
+  camera_intrinsics_.GetProjectionMatrix(
+      TANGO_CAMERA_COLOR, 0, 0, kArCameraNearClippingPlane,
+      kArCameraFarClippingPlane, &projection_mat_ar);
 
   main_scene_.SetFrustumScale(
       glm::vec3(1.0f, image_plane_ratio, image_plane_distance));
   main_scene_.SetCameraImagePlaneRatio(image_plane_ratio);
   main_scene_.SetImagePlaneDistance(image_plane_distance);
   main_scene_.SetARCameraProjectionMatrix(projection_mat_ar);
+  main_scene_.SetColorImageSize(color_camera_intrinsics_.width,
+                                color_camera_intrinsics_.height);
+  main_scene_.SetVideoOverlayDistortionMap(camera_intrinsics_.GetDistortionMap(
+      TANGO_CAMERA_COLOR, tango_gl::UndistortionMesh::kDefaultGridWidth,
+      tango_gl::UndistortionMesh::kDefaultGridHeight));
 
   float screen_ratio = static_cast<float>(height) / static_cast<float>(width);
   // In the following code, we place the view port at (0, 0) from the bottom
@@ -270,20 +433,38 @@ void AugmentedRealityApp::SetViewPort(int width, int height) {
   // }
 
   if (image_plane_ratio < screen_ratio) {
-    glViewport(0, 0, height / image_plane_ratio, height);
+    main_scene_.SetupViewPort(0, 0, height / image_plane_ratio, height);
   } else {
-    glViewport(0, 0, width, width * image_plane_ratio);
+    main_scene_.SetupViewPort(0, 0, width, width * image_plane_ratio);
   }
   main_scene_.SetCameraType(tango_gl::GestureCamera::CameraType::kFirstPerson);
 }
 
 void AugmentedRealityApp::Render() {
+  tango_gl::RenderState::BeginFrame();
+  touch_queue_.Drain([this](const tango_gl::TouchQueue::Touch& touch) {
+    main_scene_.OnTouchEvent(touch.touch_count, touch.event, touch.x0,
+                             touch.y0, touch.x1, touch.y1);
+  });
+  profiler_.BeginFrame();
+  if (resolution_governor_.Update(&profiler_)) {
+    main_scene_.SetRenderScale(
+        kRenderScaleLadder[resolution_governor_.GetLevel()]);
+  }
+
   double video_overlay_timestamp;
   TangoErrorType status =
       TangoService_updateTexture(TANGO_CAMERA_COLOR, &video_overlay_timestamp);
+  // TangoService_updateTexture() binds the camera texture directly.
+  tango_gl::RenderState::Invalidate();
 
   glm::mat4 color_camera_pose =
       GetPoseMatrixAtTimestamp(video_overlay_timestamp);
+  tango_gl::RigidTransform predicted_pose;
+  if (is_pose_prediction_on_ &&
+      pose_predictor_.Predict(video_overlay_timestamp, &predicted_pose)) {
+    color_camera_pose = predicted_pose.ToMatrix();
+  }
   color_camera_pose =
       pose_data_.GetExtrinsicsAppliedOpenGLWorldFrame(color_camera_pose);
   if (status != TANGO_SUCCESS) {
@@ -292,18 +473,76 @@ void AugmentedRealityApp::Render() {
         "error code: %d",
         status);
   }
-  main_scene_.Render(color_camera_pose);
+  main_scene_.SetDepthOcclusion(is_depth_occlusion_on_);
+  if (is_depth_occlusion_on_) {
+    UpdateOcclusionDepth(video_overlay_timestamp);
+  }
+  main_scene_.SetLateReprojection(is_late_reprojection_on_);
+  bool is_reprojected = false;
+  if (is_late_reprojection_on_ &&
+      reprojected_frame_count_ < kMaxReprojectedFrames && IsSceneLate()) {
+    tango_gl::ScopedGpuZone gpu_zone(&profiler_, "reprojection");
+    is_reprojected = main_scene_.RenderReprojected(color_camera_pose);
+  }
+  if (is_reprojected) {
+    ++reprojected_frame_count_;
+  } else {
+    reprojected_frame_count_ = 0;
+    tango_gl::ScopedCpuZone cpu_zone(&profiler_, "scene");
+    tango_gl::ScopedGpuZone gpu_zone(&profiler_, "scene");
+    main_scene_.Render(color_camera_pose);
+  }
+  if (recording_surface_.IsRecording()) {
+    tango_gl::ScopedGpuZone gpu_zone(&profiler_, "recording");
+    recording_surface_.RecordFrame(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch())
+            .count());
+  }
+  render_scheduler_.OnFrameRendered();
 }
 
-void AugmentedRealityApp::FreeGLContent() { main_scene_.FreeGLContent(); }
+bool AugmentedRealityApp::IsSceneLate() const {
+  const int64_t deadline_ns = render_scheduler_.GetFrameDeadlineNs();
+  if (deadline_ns == 0) {
+    return false;
+  }
+  const float cost_ms =
+      std::max(profiler_.GetCpuPercentile("scene", kSceneCostPercentile,
+                                          nullptr),
+               profiler_.GetGpuPercentile("scene", kSceneCostPercentile,
+                                          nullptr));
+  const int64_t now_ns =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now().time_since_epoch())
+          .count();
+  return now_ns + static_cast<int64_t>(cost_ms * 1e6f) > deadline_ns;
+}
+
+bool AugmentedRealityApp::StartRecording(JNIEnv* env, jobject surface) {
+  ANativeWindow* window = ANativeWindow_fromSurface(env, surface);
+  if (window == nullptr) {
+    LOGE("AugmentedRealityApp: no native window for the recording surface.");
+    return false;
+  }
+  // The recording surface holds its own reference.
+  bool ret = recording_surface_.Start(window);
+  ANativeWindow_release(window);
+  return ret;
+}
+
+void AugmentedRealityApp::StopRecording() { recording_surface_.Stop(); }
+
+void AugmentedRealityApp::FreeGLContent() {
+  main_scene_.FreeGLContent();
+  profiler_.Release();
+}
 
 std::string AugmentedRealityApp::GetPoseString() {
-  std::lock_guard<std::mutex> lock(pose_mutex_);
   return pose_data_.GetPoseDebugString();
 }
 
 std::string AugmentedRealityApp::GetEventString() {
-  std::lock_guard<std::mutex> lock(tango_event_mutex_);
   return tango_event_data_.GetTangoEventString().c_str();
 }
 
@@ -319,7 +558,7 @@ void AugmentedRealityApp::SetCameraType(
 void AugmentedRealityApp::OnTouchEvent(int touch_count,
                                       tango_gl::GestureCamera::TouchEvent event,
                                       float x0, float y0, float x1, float y1) {
-  main_scene_.OnTouchEvent(touch_count, event, x0, y0, x1, y1);
+  touch_queue_.Push(touch_count, event, x0, y0, x1, y1);
 }
 
 glm::mat4 AugmentedRealityApp::GetPoseMatrixAtTimestamp(double timstamp) {
@@ -336,10 +575,7 @@ glm::mat4 AugmentedRealityApp::GetPoseMatrixAtTimestamp(double timstamp) {
         timstamp);
   }
 
-  {
-    std::lock_guard<std::mutex> lock(pose_mutex_);
-    pose_data_.UpdatePose(&pose_start_service_T_device);
-  }
+  pose_data_.UpdatePose(&pose_start_service_T_device);
 
   if (pose_start_service_T_device.status_code != TANGO_POSE_VALID) {
     return glm::mat4(1.0f);
@@ -347,46 +583,68 @@ glm::mat4 AugmentedRealityApp::GetPoseMatrixAtTimestamp(double timstamp) {
   return pose_data_.GetMatrixFromPose(pose_start_service_T_device);
 }
 
-TangoErrorType AugmentedRealityApp::UpdateExtrinsics() {
-  TangoErrorType ret;
-  TangoPoseData pose_data;
-  TangoCoordinateFramePair frame_pair;
+void AugmentedRealityApp::UpdateOcclusionDepth(double color_timestamp) {
+  depth_frames_.Acquire();
+  const DepthFrame* depth_frame = depth_frames_.GetReadBuffer();
+  main_scene_.SetDepthOcclusionMode(
+      is_edge_aware_occlusion_on_ ? tango_gl::DepthOcclusion::kEdgeAware
+                                  : tango_gl::DepthOcclusion::kNearest);
+
+  // The depth frame at t0 is moved to the color camera at t1 with the device
+  // motion in between; without both poses nothing occludes.
+  tango_gl::RigidTransform start_service_T_device_t0;
+  tango_gl::RigidTransform start_service_T_device_t1;
+  if (depth_frame->points.empty() ||
+      !GetStartServiceTDevice(depth_frame->timestamp,
+                              &start_service_T_device_t0) ||
+      !GetStartServiceTDevice(color_timestamp, &start_service_T_device_t1)) {
+    main_scene_.UpdateOcclusionDepth(nullptr, 0, glm::mat4(1.0f));
+    return;
+  }
+  const tango_gl::RigidTransform device_t1_T_device_t0 =
+      start_service_T_device_t1.Inverse() * start_service_T_device_t0;
+  const glm::mat4 color_t1_T_depth_t0 = extrinsics_.GetColorTDevice() *
+                                        device_t1_T_device_t0.ToMatrix() *
+                                        extrinsics_.GetDeviceTDepth();
+  main_scene_.UpdateOcclusionDepth(depth_frame->points.data(),
+                                   depth_frame->points.size() / 3,
+                                   color_t1_T_depth_t0);
+}
 
-  // TangoService_getPoseAtTime function is used for query device extrinsics
-  // as well. We use timestamp 0.0 and the target frame pair to get the
-  // extrinsics from the sensors.
-  //
-  // Get device with respect to imu transformation matrix.
-  frame_pair.base = TANGO_COORDINATE_FRAME_IMU;
+bool AugmentedRealityApp::GetStartServiceTDevice(
+    double timestamp, tango_gl::RigidTransform* start_service_T_device) {
+  if (pose_history_.GetPose(timestamp, start_service_T_device)) {
+    return true;
+  }
+
+  TangoCoordinateFramePair frame_pair;
+  frame_pair.base = TANGO_COORDINATE_FRAME_START_OF_SERVICE;
   frame_pair.target = TANGO_COORDINATE_FRAME_DEVICE;
-  ret = TangoService_getPoseAtTime(0.0, frame_pair, &pose_data);
-  if (ret != TANGO_SUCCESS) {
-    LOGE(
-        "PointCloudApp: Failed to get transform between the IMU frame and "
-        "device frames");
-    return ret;
+  TangoPoseData pose_start_service_T_device;
+  if (TangoService_getPoseAtTime(timestamp, frame_pair,
+                                 &pose_start_service_T_device) !=
+          TANGO_SUCCESS ||
+      pose_start_service_T_device.status_code != TANGO_POSE_VALID) {
+    return false;
   }
-  pose_data_.SetImuTDevice(pose_data_.GetMatrixFromPose(pose_data));
+  *start_service_T_device = tango_gl::conversions::TransformFromArrays(
+      pose_start_service_T_device.translation,
+      pose_start_service_T_device.orientation);
+  return true;
+}
 
-  // Get color camera with respect to imu transformation matrix.
-  frame_pair.base = TANGO_COORDINATE_FRAME_IMU;
-  frame_pair.target = TANGO_COORDINATE_FRAME_CAMERA_COLOR;
-  ret = TangoService_getPoseAtTime(0.0, frame_pair, &pose_data);
+TangoErrorType AugmentedRealityApp::UpdateExtrinsics() {
+  // TangoService_getPoseAtTime function is used for query device extrinsics
+  // as well. DeviceExtrinsics uses timestamp 0.0 and the IMU frame pairs to
+  // get the extrinsics from the sensors.
+  TangoErrorType ret = extrinsics_.Query();
   if (ret != TANGO_SUCCESS) {
-    LOGE(
-        "PointCloudApp: Failed to get transform between the color camera frame "
-        "and device frames");
+    LOGE("AugmentedRealityApp: Failed to get the device extrinsics");
     return ret;
   }
-  pose_data_.SetImuTColorCamera(pose_data_.GetMatrixFromPose(pose_data));
+  pose_data_.SetDeviceTOpenGLCamera(
+      extrinsics_.GetDeviceTOpenGLColorCamera());
   return ret;
 }
 
-void AugmentedRealityApp::RequestRender() {
-  // Here, we notify the Java activity that we'd like it to trigger a render.
-  JNIEnv* env;
-  java_vm_->GetEnv(reinterpret_cast<void**>(&env), JNI_VERSION_1_6);
-  env->CallVoidMethod(calling_activity_obj_, on_demand_render_);
-}
-
 }  // namespace tango_augmented_reality
@@ -17,117 +17,158 @@
 #define GLM_FORCE_RADIANS
 
 #include <jni.h>
+#include <tango-gl/jni_natives.h>
 #include <tango-augmented-reality/augmented_reality_app.h>
 
-static tango_augmented_reality::AugmentedRealityApp app;
+namespace {
+tango_augmented_reality::AugmentedRealityApp app;
 
-#ifdef __cplusplus
-extern "C" {
-#endif
-jint JNI_OnLoad(JavaVM* vm, void*) {
-  // We need to store a reference to the Java VM so that we can call into the
-  // Java layer to trigger rendering.
-  app.SetJavaVM(vm);
-  return JNI_VERSION_1_6;
-}
-
-JNIEXPORT jint JNICALL
-Java_com_projecttango_experiments_nativeaugmentedreality_TangoJNINative_initialize(
-    JNIEnv* env, jobject, jobject activity) {
+jint Initialize(JNIEnv* env, jobject, jobject activity) {
   return app.TangoInitialize(env, activity);
 }
 
-JNIEXPORT jint JNICALL
-Java_com_projecttango_experiments_nativeaugmentedreality_TangoJNINative_setupConfig(
-    JNIEnv*, jobject) {
+jint SetupConfig(JNIEnv*, jobject) {
   return app.TangoSetupConfig();
 }
 
-JNIEXPORT jint JNICALL
-Java_com_projecttango_experiments_nativeaugmentedreality_TangoJNINative_connect(
-    JNIEnv*, jobject) {
+jint Connect(JNIEnv*, jobject) {
   return app.TangoConnect();
 }
 
-JNIEXPORT jint JNICALL
-Java_com_projecttango_experiments_nativeaugmentedreality_TangoJNINative_connectCallbacks(
-    JNIEnv*, jobject) {
+jint ConnectCallbacks(JNIEnv*, jobject) {
   int ret = app.TangoConnectCallbacks();
   return ret;
 }
 
-JNIEXPORT void JNICALL
-Java_com_projecttango_experiments_nativeaugmentedreality_TangoJNINative_disconnect(
-    JNIEnv*, jobject) {
+void Disconnect(JNIEnv*, jobject) {
   app.TangoDisconnect();
 }
 
-JNIEXPORT void JNICALL
-Java_com_projecttango_experiments_nativeaugmentedreality_TangoJNINative_resetMotionTracking(
-    JNIEnv*, jobject) {
+void ResetMotionTracking(JNIEnv*, jobject) {
   app.TangoResetMotionTracking();
 }
 
-JNIEXPORT void JNICALL
-Java_com_projecttango_experiments_nativeaugmentedreality_TangoJNINative_initGlContent(
-    JNIEnv*, jobject) {
+void InitGlContent(JNIEnv*, jobject) {
   app.InitializeGLContent();
 }
 
-JNIEXPORT void JNICALL
-Java_com_projecttango_experiments_nativeaugmentedreality_TangoJNINative_setupGraphic(
-    JNIEnv*, jobject, jint width, jint height) {
+void SetupGraphic(JNIEnv*, jobject, jint width, jint height) {
   app.SetViewPort(width, height);
 }
 
-JNIEXPORT void JNICALL
-Java_com_projecttango_experiments_nativeaugmentedreality_TangoJNINative_render(
-    JNIEnv*, jobject) {
+void Render(JNIEnv*, jobject) {
   app.Render();
 }
 
-JNIEXPORT void JNICALL
-Java_com_projecttango_experiments_nativeaugmentedreality_TangoJNINative_freeGLContent(
-    JNIEnv*, jobject) {
+void FreeGLContent(JNIEnv*, jobject) {
   app.FreeGLContent();
 }
 
-JNIEXPORT jstring JNICALL
-Java_com_projecttango_experiments_nativeaugmentedreality_TangoJNINative_getPoseString(
-    JNIEnv* env, jobject) {
+jstring GetPoseString(JNIEnv* env, jobject) {
   return (env)->NewStringUTF(app.GetPoseString().c_str());
 }
 
-JNIEXPORT jstring JNICALL
-Java_com_projecttango_experiments_nativeaugmentedreality_TangoJNINative_getEventString(
-    JNIEnv* env, jobject) {
+jstring GetEventString(JNIEnv* env, jobject) {
   return (env)->NewStringUTF(app.GetEventString().c_str());
 }
 
-JNIEXPORT jstring JNICALL
-Java_com_projecttango_experiments_nativeaugmentedreality_TangoJNINative_getVersionNumber(
-    JNIEnv* env, jobject) {
+jstring GetVersionNumber(JNIEnv* env, jobject) {
   return (env)->NewStringUTF(app.GetVersionString().c_str());
 }
 
-JNIEXPORT void JNICALL
-Java_com_projecttango_experiments_nativeaugmentedreality_TangoJNINative_setCamera(
-    JNIEnv*, jobject, int camera_index) {
+void SetCamera(JNIEnv*, jobject, int camera_index) {
   using namespace tango_gl;
   GestureCamera::CameraType cam_type =
       static_cast<GestureCamera::CameraType>(camera_index);
   app.SetCameraType(cam_type);
 }
 
-JNIEXPORT void JNICALL
-Java_com_projecttango_experiments_nativeaugmentedreality_TangoJNINative_onTouchEvent(
-    JNIEnv*, jobject, int touch_count, int event, float x0, float y0, float x1,
-    float y1) {
+void SetPosePrediction(JNIEnv*, jobject, jboolean on) {
+  app.SetPosePrediction(on);
+}
+
+void SetDepthOcclusion(JNIEnv*, jobject, jboolean on) {
+  app.SetDepthOcclusion(on);
+}
+
+void SetEdgeAwareOcclusion(JNIEnv*, jobject, jboolean on) {
+  app.SetEdgeAwareOcclusion(on);
+}
+
+void SetLateReprojection(JNIEnv*, jobject, jboolean on) {
+  app.SetLateReprojection(on);
+}
+
+void SetTargetFrameRate(JNIEnv*, jobject, jint frames_per_second) {
+  app.SetTargetFrameRate(frames_per_second);
+}
+
+jboolean StartRecording(JNIEnv* env, jobject, jobject surface) {
+  return app.StartRecording(env, surface);
+}
+
+void StopRecording(JNIEnv*, jobject) {
+  app.StopRecording();
+}
+
+void OnTouchEvent(JNIEnv*, jobject, int touch_count, int event, float x0,
+                  float y0, float x1, float y1) {
   using namespace tango_gl;
   GestureCamera::TouchEvent touch_event =
       static_cast<GestureCamera::TouchEvent>(event);
   app.OnTouchEvent(touch_count, touch_event, x0, y0, x1, y1);
 }
+
+// onTouchEvent() only queues the touch for the next frame, so it is a fast
+// native call. render() runs for milliseconds and stays a regular call, see
+// tango_gl::jni::RegisterNatives().
+const JNINativeMethod kNativeMethods[] = {
+    {"initialize",
+     "(Lcom/projecttango/experiments/nativeaugmentedreality/"
+     "AugmentedRealityActivity;)I",
+     reinterpret_cast<void*>(Initialize)},
+    {"setupConfig", "()I", reinterpret_cast<void*>(SetupConfig)},
+    {"connect", "()I", reinterpret_cast<void*>(Connect)},
+    {"connectCallbacks", "()I", reinterpret_cast<void*>(ConnectCallbacks)},
+    {"disconnect", "()V", reinterpret_cast<void*>(Disconnect)},
+    {"resetMotionTracking", "()V",
+     reinterpret_cast<void*>(ResetMotionTracking)},
+    {"initGlContent", "()V", reinterpret_cast<void*>(InitGlContent)},
+    {"setupGraphic", "(II)V", reinterpret_cast<void*>(SetupGraphic)},
+    {"render", "()V", reinterpret_cast<void*>(Render)},
+    {"freeGLContent", "()V", reinterpret_cast<void*>(FreeGLContent)},
+    {"getPoseString", "()Ljava/lang/String;",
+     reinterpret_cast<void*>(GetPoseString)},
+    {"getEventString", "()Ljava/lang/String;",
+     reinterpret_cast<void*>(GetEventString)},
+    {"getVersionNumber", "()Ljava/lang/String;",
+     reinterpret_cast<void*>(GetVersionNumber)},
+    {"setCamera", "(I)V", reinterpret_cast<void*>(SetCamera)},
+    {"setPosePrediction", "(Z)V", reinterpret_cast<void*>(SetPosePrediction)},
+    {"setDepthOcclusion", "(Z)V", reinterpret_cast<void*>(SetDepthOcclusion)},
+    {"setEdgeAwareOcclusion", "(Z)V",
+     reinterpret_cast<void*>(SetEdgeAwareOcclusion)},
+    {"setLateReprojection", "(Z)V",
+     reinterpret_cast<void*>(SetLateReprojection)},
+    {"setTargetFrameRate", "(I)V", reinterpret_cast<void*>(SetTargetFrameRate)},
+    {"startRecording", "(Landroid/view/Surface;)Z",
+     reinterpret_cast<void*>(StartRecording)},
+    {"stopRecording", "()V", reinterpret_cast<void*>(StopRecording)},
+    {"onTouchEvent", "!(IIFFFF)V", reinterpret_cast<void*>(OnTouchEvent)},
+};
+}  // namespace
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+jint JNI_OnLoad(JavaVM* vm, void*) {
+  // We need to store a reference to the Java VM so that we can call into the
+  // Java layer to trigger rendering.
+  app.SetJavaVM(vm);
+  return tango_gl::jni::RegisterNatives(
+      vm, "com/projecttango/experiments/nativeaugmentedreality/TangoJNINative",
+      kNativeMethods);
+}
 #ifdef __cplusplus
 }
 #endif
@@ -24,28 +24,38 @@ const float kMeterToMillimeter = 1000.0f;
 
 namespace tango_augmented_reality {
 
-PoseData::PoseData() {}
+PoseData::PoseData() : prev_pose_(), pose_counter_(0) {}
 
 PoseData::~PoseData() {}
 
 void PoseData::UpdatePose(const TangoPoseData* pose_data) {
-  cur_pose_ = *pose_data;
-
-  if (prev_pose_.status_code != cur_pose_.status_code) {
+  if (prev_pose_.status_code != pose_data->status_code) {
     // Reset pose counter when the status changed.
     pose_counter_ = 0;
   }
 
   // Increase pose counter.
   ++pose_counter_;
-  FormatPoseString();
-  prev_pose_ = cur_pose_;
+
+  PoseSnapshot snapshot;
+  snapshot.cur_pose = *pose_data;
+  snapshot.delta_time = pose_data->timestamp - prev_pose_.timestamp;
+  snapshot.pose_counter = pose_counter_;
+  snapshot_.Store(snapshot);
+  prev_pose_ = *pose_data;
 }
 
-std::string PoseData::GetPoseDebugString() { return pose_string_; }
+std::string PoseData::GetPoseDebugString() {
+  PoseSnapshot snapshot = snapshot_.Load();
+  if (snapshot.pose_counter == 0) {
+    // No pose received yet.
+    return std::string();
+  }
+  return FormatPoseString(snapshot);
+}
 
 glm::mat4 PoseData::GetLatestPoseMatrix() {
-  return GetMatrixFromPose(cur_pose_);
+  return GetMatrixFromPose(snapshot_.Load().cur_pose);
 }
 
 glm::mat4 PoseData::GetExtrinsicsAppliedOpenGLWorldFrame(
@@ -57,6 +67,7 @@ glm::mat4 PoseData::GetExtrinsicsAppliedOpenGLWorldFrame(
   //      device_T_imu *
   //      imu_T_color_camera *
   //      color_camera_T_opengl_camera;
+  // where the last three factors are the precomputed device_T_opengl_camera_.
   // Note that color camera and depth camera are the same hardware, they share
   // the same frame.
   //
@@ -65,9 +76,9 @@ glm::mat4 PoseData::GetExtrinsicsAppliedOpenGLWorldFrame(
   //   https://developers.google.com/project-tango/overview/frames-of-reference
   // Coordinate System Conventions:
   //   https://developers.google.com/project-tango/overview/coordinate-systems
-  return tango_gl::conversions::opengl_world_T_tango_world() * pose_matrix *
-         glm::inverse(GetImuTDevice()) * GetImuTColorCamera() *
-         tango_gl::conversions::color_camera_T_opengl_camera();
+  // The frame convention change applies as a swizzle of pose_matrix's rows.
+  return (tango_gl::conversions::OpenGlWorldTTangoWorld() * pose_matrix) *
+         device_T_opengl_camera_;
 }
 
 glm::mat4 PoseData::GetMatrixFromPose(const TangoPoseData& pose) {
@@ -109,21 +120,21 @@ std::string PoseData::GetStringFromStatusCode(TangoPoseStatusType status) {
   return ret_string;
 }
 
-void PoseData::FormatPoseString() {
+std::string PoseData::FormatPoseString(const PoseSnapshot& snapshot) {
+  const TangoPoseData& pose = snapshot.cur_pose;
   std::stringstream string_stream;
   string_stream.setf(std::ios_base::fixed, std::ios_base::floatfield);
   string_stream.precision(3);
-  string_stream << "status: " << GetStringFromStatusCode(cur_pose_.status_code)
-                << ", count: " << pose_counter_ << ", delta time (ms): "
-                << (cur_pose_.timestamp - prev_pose_.timestamp) *
-                       kMeterToMillimeter << ", position (m): ["
-                << cur_pose_.translation[0] << ", " << cur_pose_.translation[1]
-                << ", " << cur_pose_.translation[2] << "]"
-                << ", orientation: [" << cur_pose_.orientation[0] << ", "
-                << cur_pose_.orientation[1] << ", " << cur_pose_.orientation[2]
-                << ", " << cur_pose_.orientation[3] << "]";
-  pose_string_ = string_stream.str();
-  string_stream.flush();
+  string_stream << "status: " << GetStringFromStatusCode(pose.status_code)
+                << ", count: " << snapshot.pose_counter
+                << ", delta time (ms): "
+                << snapshot.delta_time * kMeterToMillimeter
+                << ", position (m): [" << pose.translation[0] << ", "
+                << pose.translation[1] << ", " << pose.translation[2] << "]"
+                << ", orientation: [" << pose.orientation[0] << ", "
+                << pose.orientation[1] << ", " << pose.orientation[2] << ", "
+                << pose.orientation[3] << "]";
+  return string_stream.str();
 }
 
 } //namespace tango_augmented_reality
\ No newline at end of file
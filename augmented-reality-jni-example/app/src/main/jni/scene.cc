@@ -15,6 +15,7 @@
  */
 
 #include <tango-gl/conversions.h>
+#include <tango-gl/render_state.h>
 
 #include "tango-augmented-reality/scene.h"
 
@@ -41,15 +42,27 @@ const glm::quat kMarkerRotation = glm::quat(0.0f, 0.0f, 1.0f, 0.0f);
 const glm::vec3 kMarkerPosition = glm::vec3(0.0f, 0.85f, -3.0f);
 const glm::vec3 kMarkerScale = glm::vec3(0.05f, 0.05f, 0.05f);
 const tango_gl::Color kMarkerColor(1.0f, 0.f, 0.f);
+// Bounds of the flat marker model, before kMarkerScale.
+const tango_gl::BoundingBox kMarkerBoundingBox(glm::vec3(-10.0f, -16.5f, -0.1f),
+                                               glm::vec3(10.0f, 10.0f, 0.1f));
 }  // namespace
 
 namespace tango_augmented_reality {
 
-Scene::Scene() {}
+Scene::Scene()
+    : has_reprojection_layer_(false),
+      is_depth_occlusion_on_(false),
+      color_image_width_(0),
+      color_image_height_(0) {}
 
 Scene::~Scene() {}
 
 void Scene::InitGLContent() {
+  // The target of a previous context died with it.
+  render_target_.Invalidate();
+  depth_occlusion_.Invalidate();
+  has_reprojection_layer_ = false;
+
   // Allocating render camera and drawable object.
   // All of these objects are for visualization purposes.
   video_overlay_ = new tango_gl::VideoOverlay();
@@ -71,9 +84,21 @@ void Scene::InitGLContent() {
 
   gesture_camera_->SetCameraType(
       tango_gl::GestureCamera::CameraType::kThirdPerson);
+
+  scene_graph_.Add(video_overlay_, tango_gl::SceneGraph::kOpaque);
+  scene_graph_.Add(frustum_, tango_gl::SceneGraph::kOpaque);
+  scene_graph_.Add(axis_, tango_gl::SceneGraph::kOpaque);
+  scene_graph_.Add(trace_, tango_gl::SceneGraph::kOpaque);
+  scene_graph_.Add(grid_, tango_gl::SceneGraph::kOpaque);
+  scene_graph_.Add(marker_, tango_gl::SceneGraph::kOpaque);
+  scene_graph_.SetBounds(marker_, kMarkerBoundingBox);
+  occlusion_culler_.Clear();
 }
 
 void Scene::FreeGLContent() {
+  scene_graph_.Clear();
+  render_target_.Release();
+  depth_occlusion_.Release();
   delete video_overlay_;
   delete gesture_camera_;
   delete axis_;
@@ -90,10 +115,11 @@ void Scene::SetupViewPort(int x, int y, int w, int h) {
   gesture_camera_->SetAspectRatio(static_cast<float>(w) /
                                   static_cast<float>(h));
   glViewport(x, y, w, h);
+  render_target_.SetViewport(x, y, w, h);
 }
 
 void Scene::Render(const glm::mat4& cur_pose_transformation) {
-  glEnable(GL_DEPTH_TEST);
+  tango_gl::RenderState::Enable(GL_DEPTH_TEST);
 
   glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
   glClear(GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT);
@@ -104,15 +130,20 @@ void Scene::Render(const glm::mat4& cur_pose_transformation) {
 
   trace_->UpdateVertexArray(position);
 
-  if (gesture_camera_->GetCameraType() ==
-      tango_gl::GestureCamera::CameraType::kFirstPerson) {
+  const bool is_first_person =
+      gesture_camera_->GetCameraType() ==
+      tango_gl::GestureCamera::CameraType::kFirstPerson;
+  if (is_first_person) {
     // In first person mode, we directly control camera's motion.
     gesture_camera_->SetTransformationMatrix(cur_pose_transformation);
 
     // If it's first person view, we will render the video overlay in full
-    // screen, so we passed identity matrix as view and projection matrix.
-    glDisable(GL_DEPTH_TEST);
-    video_overlay_->Render(glm::mat4(1.0f), glm::mat4(1.0f));
+    // screen behind everything else, at the screen resolution; the virtual
+    // content goes through render_target_.
+    scene_graph_.SetVisible(video_overlay_, false);
+    const glm::mat4 identity(1.0f);
+    tango_gl::RenderState::Disable(GL_DEPTH_TEST);
+    video_overlay_->Render(identity, identity);
   } else {
     // In third person or top down more, we follow the camera movement.
     gesture_camera_->SetAnchorPosition(position);
@@ -122,26 +153,78 @@ void Scene::Render(const glm::mat4& cur_pose_transformation) {
     // camera's aspect ratio, this is just for visualization purposes.
     frustum_->SetScale(
         glm::vec3(1.0f, camera_image_plane_ratio_, image_plane_distance_));
-    frustum_->Render(ar_camera_projection_matrix_,
-                     gesture_camera_->GetViewMatrix());
-
     axis_->SetTransformationMatrix(cur_pose_transformation);
-    axis_->Render(ar_camera_projection_matrix_,
-                  gesture_camera_->GetViewMatrix());
+    scene_graph_.SetVisible(video_overlay_, true);
+  }
+  scene_graph_.SetVisible(frustum_, !is_first_person);
+  scene_graph_.SetVisible(axis_, !is_first_person);
+  scene_graph_.SetVisible(trace_, !is_first_person);
+
+  bool is_offscreen = false;
+  if (is_first_person) {
+    is_offscreen = render_target_.Begin();
+    if (is_depth_occlusion_on_) {
+      depth_occlusion_.Render(ar_camera_projection_matrix_);
+    }
+  }
+  const glm::mat4 view_matrix = gesture_camera_->GetViewMatrix();
+  if (is_first_person) {
+    view_frustum_.SetOcclusionCuller(
+        is_depth_occlusion_on_ ? &occlusion_culler_ : nullptr);
+    view_frustum_.Update(ar_camera_projection_matrix_, view_matrix);
+  }
+  scene_graph_.Render(ar_camera_projection_matrix_, view_matrix,
+                      is_first_person ? &view_frustum_ : nullptr);
+  if (is_first_person) {
+    render_target_.End();
+  }
+  has_reprojection_layer_ = is_offscreen;
+  layer_view_matrix_ = view_matrix;
+}
 
-    trace_->Render(ar_camera_projection_matrix_,
-                   gesture_camera_->GetViewMatrix());
-    video_overlay_->Render(ar_camera_projection_matrix_,
-                           gesture_camera_->GetViewMatrix());
+bool Scene::RenderReprojected(const glm::mat4& cur_pose_transformation) {
+  if (!has_reprojection_layer_ || !render_target_.HasRetainedContent() ||
+      gesture_camera_->GetCameraType() !=
+          tango_gl::GestureCamera::CameraType::kFirstPerson) {
+    return false;
+  }
+  gesture_camera_->SetTransformationMatrix(cur_pose_transformation);
+  trace_->UpdateVertexArray(glm::vec3(cur_pose_transformation[3]));
+
+  glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
+  glClear(GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT);
+  const glm::mat4 identity(1.0f);
+  tango_gl::RenderState::Disable(GL_DEPTH_TEST);
+  video_overlay_->Render(identity, identity);
+  return render_target_.CompositeReprojected(
+      tango_gl::DynamicResolutionTarget::GetReprojection(
+          ar_camera_projection_matrix_, layer_view_matrix_,
+          gesture_camera_->GetViewMatrix()));
+}
+
+void Scene::UpdateOcclusionDepth(const float* points, size_t count,
+                                 const glm::mat4& color_T_depth) {
+  if (!is_depth_occlusion_on_ ||
+      gesture_camera_->GetCameraType() !=
+          tango_gl::GestureCamera::CameraType::kFirstPerson) {
+    return;
+  }
+  depth_occlusion_.UpdateDepth(points, count, color_T_depth,
+                               ar_camera_projection_matrix_,
+                               color_image_width_, color_image_height_);
+  if (points == nullptr) {
+    occlusion_culler_.Clear();
+    return;
   }
-  glEnable(GL_DEPTH_TEST);
-  grid_->Render(ar_camera_projection_matrix_, gesture_camera_->GetViewMatrix());
-  marker_->Render(ar_camera_projection_matrix_,
-                  gesture_camera_->GetViewMatrix());
+  const glm::mat4 opengl_camera_T_color =
+      glm::inverse(tango_gl::conversions::color_camera_T_opengl_camera());
+  occlusion_culler_.Build(points, count, opengl_camera_T_color * color_T_depth,
+                          ar_camera_projection_matrix_);
 }
 
 void Scene::SetCameraType(tango_gl::GestureCamera::CameraType camera_type) {
   gesture_camera_->SetCameraType(camera_type);
+  has_reprojection_layer_ = false;
   if (camera_type == tango_gl::GestureCamera::CameraType::kFirstPerson) {
     video_overlay_->SetParent(nullptr);
     video_overlay_->SetScale(glm::vec3(1.0f, 1.0f, 1.0f));
@@ -19,8 +19,19 @@
 
 #include <jni.h>
 #include <memory>
+#include <vector>
 
 #include <tango_client_api.h>  // NOLINT
+#include <tango-gl/camera_intrinsics_registry.h>
+#include <tango-gl/device_extrinsics.h>
+#include <tango-gl/frame_profiler.h>
+#include <tango-gl/pose_history.h>
+#include <tango-gl/pose_predictor.h>
+#include <tango-gl/quality_governor.h>
+#include <tango-gl/recording_surface.h>
+#include <tango-gl/render_scheduler.h>
+#include <tango-gl/touch_queue.h>
+#include <tango-gl/triple_buffer.h>
 #include <tango-gl/util.h>
 
 #include <tango-augmented-reality/pose_data.h>
@@ -46,7 +57,7 @@ class AugmentedRealityApp {
   // we'd like auto-recover enabled.
   int TangoSetupConfig();
 
-  // Connect the onPoseAvailable callback.
+  // Connect the onPoseAvailable and onXYZijAvailable callbacks.
   int TangoConnectCallbacks();
 
   // Connect to Tango Service.
@@ -62,6 +73,19 @@ class AugmentedRealityApp {
   // Note that this will cause motion tracking to re-initialize.
   void TangoResetMotionTracking();
 
+  // Tango service pose callback function. Called when a new device pose is
+  // available from the Tango Service.
+  //
+  // @param pose: start of service to device pose, caller allocated.
+  void onPoseAvailable(const TangoPoseData* pose);
+
+  // Tango service point cloud callback function. Called when a new depth
+  // frame is available, the points are handed to the render loop for depth
+  // occlusion.
+  //
+  // @param xyz_ij: point cloud in the depth camera frame, caller allocated.
+  void onXYZijAvailable(const TangoXYZij* xyz_ij);
+
   // Tango service event callback function for pose data. Called when new events
   // are available from the Tango Service.
   //
@@ -101,7 +125,8 @@ class AugmentedRealityApp {
   void SetCameraType(tango_gl::GestureCamera::CameraType camera_type);
 
   // Touch event passed from android activity. This function only supports two
-  // touches.
+  // touches. Called on the UI thread, the event is queued and applied by the
+  // next Render().
   //
   // @param: touch_count, total count for touches.
   // @param: event, touch event of current touch.
@@ -112,6 +137,54 @@ class AugmentedRealityApp {
   void OnTouchEvent(int touch_count, tango_gl::GestureCamera::TouchEvent event,
                     float x0, float y0, float x1, float y1);
 
+  // Render the virtual content with the device pose predicted for the time the
+  // frame is displayed, instead of the pose at the color image timestamp.
+  //
+  // @param: on, enable or disable pose prediction.
+  void SetPosePrediction(bool on) { is_pose_prediction_on_ = on; }
+
+  // Hide the virtual content behind real surfaces seen by the depth camera.
+  //
+  // @param: on, enable or disable depth occlusion.
+  void SetDepthOcclusion(bool on) { is_depth_occlusion_on_ = on; }
+
+  // Upsample the depth for occlusion from a quarter resolution image with
+  // edge aware interpolation, instead of splatting it at full resolution.
+  //
+  // @param: on, enable or disable edge aware upsampling.
+  void SetEdgeAwareOcclusion(bool on) { is_edge_aware_occlusion_on_ = on; }
+
+  // When the virtual content can not be rendered before the frame is due,
+  // e.g. after a long texture update or depth upload, warp the content of
+  // the previous frame to the current pose over the live camera image
+  // instead, see tango_gl::DynamicResolutionTarget::CompositeReprojected().
+  //
+  // @param: on, enable or disable late reprojection.
+  void SetLateReprojection(bool on) { is_late_reprojection_on_ = on; }
+
+  // Pace rendering to a steady rate, see
+  // tango_gl::RenderScheduler::SetTargetFrameRate(). Defaults to the 30Hz
+  // of the color camera.
+  //
+  // @param: frames_per_second, the target rate, 0 for the display rate.
+  void SetTargetFrameRate(int frames_per_second) {
+    render_scheduler_.SetTargetFrameRate(frames_per_second);
+  }
+
+  // Start recording every rendered frame into the input surface of a video
+  // encoder, see tango_gl::RecordingSurface. Must be called on the GL thread.
+  //
+  // @param: env, the JNI environment of the GL thread.
+  // @param: surface, the android.view.Surface from
+  //         MediaCodec.createInputSurface().
+  //
+  // @return: false if the surface can not be rendered to.
+  bool StartRecording(JNIEnv* env, jobject surface);
+
+  // Stop recording. Must be called on the GL thread, before the encoder is
+  // signaled the end of its input stream.
+  void StopRecording();
+
   // Cache the Java VM
   //
   // @JavaVM java_vm: the Java VM is using from the Java layer.
@@ -125,33 +198,65 @@ class AugmentedRealityApp {
   // @return: pose in matrix format.
   glm::mat4 GetPoseMatrixAtTimestamp(double timstamp);
 
+  // Get the device pose with respect to start of service at a timestamp, from
+  // the pose history or from the service if the history does not cover it.
+  //
+  // @return false if there is no valid pose at the timestamp.
+  bool GetStartServiceTDevice(double timestamp,
+                              tango_gl::RigidTransform* start_service_T_device);
+
+  // Whether rendering the scene now would likely finish after the frame is
+  // due, judging by its recent CPU and GPU times.
+  bool IsSceneLate() const;
+
+  // Register the latest depth frame to the color image at color_timestamp
+  // and hand it to the scene for depth occlusion.
+  //
+  // @param: color_timestamp, timestamp of the color image being rendered.
+  void UpdateOcclusionDepth(double color_timestamp);
+
   // Query sensor/camera extrinsic from the Tango Service, the extrinsic is only
   // available after the service is connected.
   //
   // @return: error code.
   TangoErrorType UpdateExtrinsics();
 
-  // Request the render function from Java layer.
-  void RequestRender();
-
   // pose_data_ handles all pose onPoseAvailable callbacks, onPoseAvailable()
   // in this object will be routed to pose_data_ to handle.
   PoseData pose_data_;
 
-  // Mutex for protecting the pose data. The pose data is shared between render
-  // thread and TangoService callback thread.
-  std::mutex pose_mutex_;
+  // Fixed transformations between the device and camera frames.
+  tango_gl::DeviceExtrinsics extrinsics_;
+
+  // Device poses from the pose callback, extrapolated by pose_predictor_ when
+  // is_pose_prediction_on_ is set.
+  tango_gl::PoseHistory pose_history_;
+  tango_gl::PosePredictor pose_predictor_;
+  bool is_pose_prediction_on_;
+
+  // A depth frame from the point cloud callback.
+  struct DepthFrame {
+    DepthFrame() : timestamp(0.0) {}
+
+    // Time of capture of the depth data (in seconds).
+    double timestamp;
+    // Packed x,y,z coordinates in the depth camera frame, in meters.
+    std::vector<float> points;
+  };
+
+  // Depth frames handed from the point cloud callback to the render loop,
+  // which splats them into the occlusion depth image.
+  tango_gl::TripleBuffer<DepthFrame> depth_frames_;
+  bool is_depth_occlusion_on_;
+  bool is_edge_aware_occlusion_on_;
 
   // tango_event_data_ handles all Tango event callbacks,
   // onTangoEventAvailable() in this object will be routed to tango_event_data_
   // to handle.
   TangoEventData tango_event_data_;
 
-  // tango_event_data_ is share between the UI thread we start for updating
-  // debug
-  // texts and the TangoService event callback thread. We keep event_mutex_ to
-  // protect tango_event_data_.
-  std::mutex tango_event_mutex_;
+  // Touch events from the UI thread, drained by Render() on the GL thread.
+  tango_gl::TouchQueue touch_queue_;
 
   // main_scene_ includes all drawable object for visualizing Tango device's
   // movement.
@@ -168,6 +273,10 @@ class AugmentedRealityApp {
   // as close as possible.
   TangoCameraIntrinsics color_camera_intrinsics_;
 
+  // Cache of the camera intrinsics and the projection matrices derived from
+  // them, cleared on connect.
+  tango_gl::CameraIntrinsicsRegistry camera_intrinsics_;
+
   // Tango service version string.
   std::string tango_core_version_string_;
 
@@ -177,6 +286,23 @@ class AugmentedRealityApp {
   JavaVM* java_vm_;
   jobject calling_activity_obj_;
   jmethodID on_demand_render_;
+
+  // Coalesces onTextureAvailable callbacks into at most one render request
+  // per vsync.
+  tango_gl::RenderScheduler render_scheduler_;
+
+  // GPU time of the scene, and the resolution scale of the virtual content
+  // chosen from it.
+  tango_gl::FrameProfiler profiler_;
+  tango_gl::QualityGovernor resolution_governor_;
+
+  // Frames in a row that reprojected the previous content, capped so a
+  // scene that is always too slow still updates.
+  bool is_late_reprojection_on_;
+  int reprojected_frame_count_;
+
+  // Second render target of each frame while recording.
+  tango_gl::RecordingSurface recording_surface_;
 };
 }  // namespace tango_augmented_reality
 
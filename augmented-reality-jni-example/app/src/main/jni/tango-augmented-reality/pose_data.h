@@ -22,12 +22,17 @@
 
 #include <tango_client_api.h>  // NOLINT
 #include <tango-gl/conversions.h>
+#include <tango-gl/seqlock.h>
 #include <tango-gl/util.h>
 
 namespace tango_augmented_reality {
 
 // PoseData holds all pose related data. E.g. pose position, rotation and time-
 // stamp. It also produce the debug information strings.
+//
+// UpdatePose() only stores a snapshot of the pose, the getters can be called
+// from any thread without locking and the debug string is only formatted
+// when it is asked for. UpdatePose() itself must be called from one thread.
 class PoseData {
  public:
   PoseData();
@@ -48,22 +53,11 @@ class PoseData {
   // @return: latest pose in matrix format.
   glm::mat4 GetLatestPoseMatrix();
 
-  // @return: device frame with respect to IMU frame matrix.
-  glm::mat4 GetImuTDevice() { return imu_T_device_; }
-
-  // Set device frame with respect to IMU frame matrix.
-  // @param: imu_T_device, imu_T_device_ matrix.
-  void SetImuTDevice(const glm::mat4& imu_T_device) {
-    imu_T_device_ = imu_T_device;
-  }
-
-  // @return: color camera frame with respect to IMU frame.
-  glm::mat4 GetImuTColorCamera() { return imu_T_color_camera_; }
-
-  // Set color camera frame with respect to IMU frame matrix.
-  // @param: imu_T_color_camera, imu_T_color_camera_ matrix.
-  void SetImuTColorCamera(const glm::mat4& imu_T_color_camera) {
-    imu_T_color_camera_ = imu_T_color_camera;
+  // Set the OpenGL camera frame attached to the color camera with respect to
+  // the device frame. This is a fixed extrinsics transformation.
+  // @param: device_T_opengl_camera, device_T_opengl_camera_ matrix.
+  void SetDeviceTOpenGLCamera(const glm::mat4& device_T_opengl_camera) {
+    device_T_opengl_camera_ = device_T_opengl_camera;
   }
 
   // Get pose transformation in OpenGL coordinate system. This function also
@@ -86,25 +80,29 @@ class PoseData {
   // @return: corresponding string based on status passed in.
   std::string GetStringFromStatusCode(TangoPoseStatusType status);
 
-  // Format the pose debug string based on current pose and previous pose data.
-  void FormatPoseString();
+  // Latest pose, published by UpdatePose() for the getters.
+  struct PoseSnapshot {
+    // Pose data of current frame.
+    TangoPoseData cur_pose;
+    // Time since the previous pose, in seconds.
+    double delta_time;
+    // Poses since the last status change, for debug purpose.
+    size_t pose_counter;
+  };
 
-  // Device frame with respect to IMU frame.
-  glm::mat4 imu_T_device_;
+  // Format the pose debug string of a pose snapshot.
+  std::string FormatPoseString(const PoseSnapshot& snapshot);
 
-  // Color camera frame with respect to IMU frame.
-  glm::mat4 imu_T_color_camera_;
+  // OpenGL camera frame attached to the color camera with respect to device
+  // frame.
+  glm::mat4 device_T_opengl_camera_;
 
-  // Pose data of current frame.
-  TangoPoseData cur_pose_;
+  tango_gl::SeqLock<PoseSnapshot> snapshot_;
 
-  // prev_pose_, pose_counter_ and pose_debug_string_ are used for composing the
-  // debug string to display the useful information on screen.
+  // prev_pose_ and pose_counter_ are only used by UpdatePose() to fill in the
+  // snapshot.
   TangoPoseData prev_pose_;
 
-  // Debug pose string.
-  std::string pose_string_;
-
   // Pose counter for debug purpose.
   size_t pose_counter_;
 };
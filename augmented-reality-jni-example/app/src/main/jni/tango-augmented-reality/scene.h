@@ -24,14 +24,19 @@
 #include <tango-gl/axis.h>
 #include <tango-gl/camera.h>
 #include <tango-gl/color.h>
+#include <tango-gl/depth_occlusion.h>
+#include <tango-gl/dynamic_resolution_target.h>
 #include <tango-gl/gesture_camera.h>
 #include <tango-gl/grid.h>
 #include <tango-gl/frustum.h>
 #include <tango-gl/goal_marker.h>
+#include <tango-gl/occlusion_culler.h>
+#include <tango-gl/scene_graph.h>
 #include <tango-gl/trace.h>
 #include <tango-gl/transform.h>
 #include <tango-gl/util.h>
 #include <tango-gl/video_overlay.h>
+#include <tango-gl/view_frustum.h>
 
 #include <tango-augmented-reality/pose_data.h>
 
@@ -63,6 +68,20 @@ class Scene {
   // Render loop.
   void Render(const glm::mat4& cur_pose_transformation);
 
+  // Draw the video overlay, and over it the virtual content of the last
+  // first person Render() warped to the current pose instead of rendering it
+  // again. Needs SetLateReprojection().
+  //
+  // @param: cur_pose_transformation, the current camera pose.
+  // @return: false if there is no first person content to reproject, nothing
+  //          is drawn then.
+  bool RenderReprojected(const glm::mat4& cur_pose_transformation);
+
+  // Keep the virtual content of the first person view in an offscreen layer,
+  // with the pose it was rendered at, for RenderReprojected().
+  // @param: on, enable or disable keeping the layer.
+  void SetLateReprojection(bool on) { render_target_.SetRetainContent(on); }
+
   // Set render camera's viewing angle, first person, third person or top down.
   //
   // @param: camera_type, camera type includes first person, third person and
@@ -98,12 +117,55 @@ class Scene {
     ar_camera_projection_matrix_ = projection_matrix;
   }
 
+  // Set the size of the color camera image, the resolution of the depth image
+  // for occlusion.
+  // @param: width, height, image size in pixels.
+  void SetColorImageSize(int width, int height) {
+    color_image_width_ = width;
+    color_image_height_ = height;
+  }
+
+  // Hide the virtual content of the first person view behind the depth of the
+  // last UpdateOcclusionDepth(). Needs GL_EXT_frag_depth, without it nothing
+  // is occluded.
+  // @param: on, enable or disable depth occlusion.
+  void SetDepthOcclusion(bool on) { is_depth_occlusion_on_ = on; }
+
+  // @param: mode, resolution and upsampling of the occlusion depth.
+  void SetDepthOcclusionMode(tango_gl::DepthOcclusion::Mode mode) {
+    depth_occlusion_.SetMode(mode);
+  }
+
+  // Splat a depth frame into the occlusion depth image, and build the depth
+  // pyramid that culls the drawables it hides. Must be called before
+  // Render(), outside of any other render target.
+  // @param: points, xyz points in the depth camera frame, nullptr to clear.
+  // @param: count, number of points.
+  // @param: color_T_depth, depth camera to color camera at the color image
+  //         timestamp.
+  void UpdateOcclusionDepth(const float* points, size_t count,
+                            const glm::mat4& color_T_depth);
+
+  // Set the distortion map used to undistort the video overlay, so it matches
+  // the pinhole projection of the AR view.
+  // @param: map, the distortion map, nullptr to draw the image as is.
+  void SetVideoOverlayDistortionMap(
+      const tango_gl::CameraIntrinsicsRegistry::DistortionMap* map) {
+    video_overlay_->SetDistortionMap(map);
+  }
+
   // Set the frustum render drawable object's scale. For the best visialization
   // result, we set the camera frustum object's scale to the physical camera's
   // aspect ratio.
   // @param: scale, frustum's scale.
   void SetFrustumScale(const glm::vec3& scale) { frustum_->SetScale(scale); }
 
+  // Set the fraction of the screen resolution the virtual content of the
+  // first person view is rendered at. The camera image is always drawn at
+  // the screen resolution.
+  // @param: scale, resolution scale in [0.25, 1].
+  void SetRenderScale(float scale) { render_target_.SetScale(scale); }
+
   // Clear the Motion Tracking trajactory.
   void ResetTrajectory() { trace_->ClearVertexArray(); }
 
@@ -141,6 +203,29 @@ class Scene {
   // A marker placed at (0.0f, 0.0f, -3.0f) location.
   tango_gl::GoalMarker* marker_;
 
+  // Draw list of the drawables above.
+  tango_gl::SceneGraph scene_graph_;
+
+  // Culls the drawables with bounds in first person view, behind the real
+  // surfaces of the last depth frame when depth occlusion is on.
+  tango_gl::ViewFrustum view_frustum_;
+  tango_gl::OcclusionCuller occlusion_culler_;
+
+  // Reduced resolution target of the virtual content in first person view,
+  // composited over the video overlay.
+  tango_gl::DynamicResolutionTarget render_target_;
+  // View matrix the content in render_target_ was rendered with, valid if
+  // has_reprojection_layer_ is set.
+  glm::mat4 layer_view_matrix_;
+  bool has_reprojection_layer_;
+
+  // Writes the depth of real surfaces before the virtual content in first
+  // person view.
+  tango_gl::DepthOcclusion depth_occlusion_;
+  bool is_depth_occlusion_on_;
+  int color_image_width_;
+  int color_image_height_;
+
   // We use both camera_image_plane_ratio_ and image_plane_distance_ to compute
   // the first person AR camera's frustum, these value is derived from actual
   // physical camera instrinsics.
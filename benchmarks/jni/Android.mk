@@ -0,0 +1,152 @@
+#
+# Copyright 2014 Google Inc. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+
+# Microbenchmarks of tango-gl and the example hot paths, an executable run
+# from adb shell:
+#
+#   cd benchmarks && ndk-build
+#   adb push libs/armeabi-v7a/tango_benchmarks /data/local/tmp
+#   adb shell /data/local/tmp/tango_benchmarks --csv
+#
+# The same sources build on a desktop with host/CMakeLists.txt.
+
+LOCAL_PATH := $(call my-dir)
+PROJECT_ROOT_FROM_JNI:= ../..
+PROJECT_ROOT:= $(call my-dir)/../..
+RGB_DEPTH_SYNC_JNI := $(PROJECT_ROOT_FROM_JNI)/rgb-depth-sync-example/app/src/main/jni
+PLANE_FITTING_JNI := $(PROJECT_ROOT_FROM_JNI)/plane-fitting-jni-example/app/src/main/jni
+VIDEO_OVERLAY_JNI := $(PROJECT_ROOT_FROM_JNI)/video-overlay-jni-example/app/src/main/jni
+
+include $(CLEAR_VARS)
+LOCAL_MODULE    := tango_benchmarks
+
+LOCAL_STATIC_LIBRARIES := cpufeatures
+LOCAL_CFLAGS    := -std=c++11
+# Per frame matrix math on NEON, part of the arm64-v8a baseline. armeabi-v7a
+# keeps the scalar glm path, see tango-gl/simd_math.h.
+ifeq ($(TARGET_ARCH_ABI),arm64-v8a)
+LOCAL_CFLAGS    += -DTANGO_GL_SIMD_MATH
+endif
+
+# Only the API headers are needed, nothing calls into the service.
+LOCAL_C_INCLUDES := $(LOCAL_PATH) \
+                    $(PROJECT_ROOT)/tango_client_api/include \
+                    $(PROJECT_ROOT)/tango_support_api/include \
+                    $(PROJECT_ROOT)/tango-gl/include \
+                    $(PROJECT_ROOT)/third-party/glm/ \
+                    $(LOCAL_PATH)/$(RGB_DEPTH_SYNC_JNI) \
+                    $(LOCAL_PATH)/$(PLANE_FITTING_JNI) \
+                    $(LOCAL_PATH)/$(VIDEO_OVERLAY_JNI)
+
+LOCAL_SRC_FILES := benchmark.cc \
+                   benchmark_main.cc \
+                   depth_image_benchmark.cc \
+                   inputs.cc \
+                   intersection_benchmark.cc \
+                   obj_loader_benchmark.cc \
+                   object_store_benchmark.cc \
+                   plane_fitting_benchmark.cc \
+                   point_block_benchmark.cc \
+                   point_cloud_codec_benchmark.cc \
+                   range_image_benchmark.cc \
+                   transform_benchmark.cc \
+                   yuv_benchmark.cc \
+                   $(RGB_DEPTH_SYNC_JNI)/bilateral_depth_upsampler.cc \
+                   $(RGB_DEPTH_SYNC_JNI)/depth_image.cc \
+                   $(RGB_DEPTH_SYNC_JNI)/tiled_depth_splatter.cc \
+                   $(PLANE_FITTING_JNI)/plane_fitting.cc \
+                   $(VIDEO_OVERLAY_JNI)/yuv_drawable.cc \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/block_store.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/bounding_box.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/bvh.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/camera.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/camera_intrinsics_registry.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/conversions.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/corner_detector.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/counters.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/depth_hit_tester.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/depth_outlier_filter.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/drawable_object.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/frame_arena.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/frame_constants.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/geometry_registry.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/luminance_pyramid.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/lz4.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/memory_tracker.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/mesh.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/normal_estimator.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/obj_loader.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/object_store.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/occlusion_culler.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/offscreen_context.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/point_block.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/point_cloud_codec.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/point_colorizer.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/pixel_readback.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/point_map.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/point_projection.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/pose_interpolation.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/program_cache.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/projective_icp.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/range_image.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/range_image_mesh.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/ray_table.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/render_pass.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/render_state.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/session_replayer.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/service_probe.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/shader_variants.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/shaders.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/streaming_texture.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/temporal_depth_filter.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/thread_policy.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/transform.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/undistortion_mesh.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/util.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/vertex_array.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/vertex_buffer.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/view_frustum.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/worker_pool.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/yuv_converter.cpp
+
+# The NEON kernels are built with NEON enabled and selected at runtime, so the
+# executable still runs on armeabi-v7a devices without NEON. arm64-v8a always
+# has NEON and needs no .neon suffix.
+TANGO_GL_NEON_SOURCES := $(PROJECT_ROOT_FROM_JNI)/tango-gl/corner_detector_neon.cpp \
+                         $(PROJECT_ROOT_FROM_JNI)/tango-gl/luminance_pyramid_neon.cpp \
+                         $(PROJECT_ROOT_FROM_JNI)/tango-gl/object_store_neon.cpp \
+                         $(PROJECT_ROOT_FROM_JNI)/tango-gl/point_block_neon.cpp \
+                         $(PROJECT_ROOT_FROM_JNI)/tango-gl/point_cloud_codec_neon.cpp \
+                         $(PROJECT_ROOT_FROM_JNI)/tango-gl/point_projection_neon.cpp \
+                         $(PROJECT_ROOT_FROM_JNI)/tango-gl/pose_interpolation_neon.cpp \
+                         $(PROJECT_ROOT_FROM_JNI)/tango-gl/projective_icp_neon.cpp \
+                         $(PROJECT_ROOT_FROM_JNI)/tango-gl/range_image_neon.cpp \
+                         $(PROJECT_ROOT_FROM_JNI)/tango-gl/temporal_depth_filter_neon.cpp \
+                         $(PROJECT_ROOT_FROM_JNI)/tango-gl/yuv_converter_neon.cpp
+ifeq ($(TARGET_ARCH_ABI),armeabi-v7a)
+LOCAL_CFLAGS    += -DTANGO_GL_HAS_NEON
+LOCAL_SRC_FILES += $(addsuffix .neon,$(TANGO_GL_NEON_SOURCES))
+endif
+ifeq ($(TARGET_ARCH_ABI),arm64-v8a)
+LOCAL_CFLAGS    += -DTANGO_GL_HAS_NEON
+LOCAL_SRC_FILES += $(TANGO_GL_NEON_SOURCES)
+endif
+
+LOCAL_LDLIBS    := -llog -lGLESv2 -lEGL -L$(SYSROOT)/usr/lib
+include $(BUILD_EXECUTABLE)
+
+$(call import-add-path, $(PROJECT_ROOT))
+$(call import-module,android/cpufeatures)
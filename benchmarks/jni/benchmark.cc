@@ -0,0 +1,172 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "tango-benchmarks/benchmark.h"
+
+namespace {
+// Upper bound of the iteration count, keeps very cheap benchmarks from
+// overflowing and bounds the time of a run that calibrated badly.
+const int64_t kMaxIterations = 1000000000;
+
+struct Benchmark {
+  std::string name;
+  tango_benchmark::Function function;
+  bool needs_gl;
+};
+
+// Function local, so registrations from static initializers of any
+// translation unit find it constructed.
+std::vector<Benchmark>& GetRegistry() {
+  static std::vector<Benchmark> registry;
+  return registry;
+}
+
+// Run a benchmark until it takes the minimum time.
+//
+// @return: false if the benchmark reported an error.
+bool RunBenchmark(const Benchmark& benchmark, double min_time,
+                  tango_benchmark::State* result) {
+  int64_t iterations = 1;
+  while (true) {
+    tango_benchmark::State state(iterations);
+    benchmark.function(&state);
+    *result = state;
+    if (state.GetErrorMessage() != nullptr) {
+      return false;
+    }
+
+    double elapsed = state.GetElapsedSeconds();
+    if (elapsed >= min_time || iterations >= kMaxIterations) {
+      return true;
+    }
+    // Aim slightly past the minimum time, but grow at most tenfold at once
+    // as the first runs are dominated by cold caches.
+    double scale = elapsed > 0.0 ? 1.4 * min_time / elapsed : 10.0;
+    scale = std::max(2.0, std::min(10.0, scale));
+    iterations = std::min(
+        kMaxIterations, static_cast<int64_t>(iterations * scale + 0.5));
+  }
+}
+}  // namespace
+
+namespace tango_benchmark {
+
+State::State(int64_t max_iterations)
+    : max_iterations_(max_iterations),
+      iterations_(0),
+      bytes_processed_(0),
+      error_message_(nullptr),
+      is_timing_(false),
+      elapsed_(0.0) {}
+
+bool State::KeepRunning() {
+  if (iterations_ == 0 && !is_timing_) {
+    ResumeTiming();
+  }
+  if (iterations_ < max_iterations_ && error_message_ == nullptr) {
+    ++iterations_;
+    return true;
+  }
+  PauseTiming();
+  return false;
+}
+
+void State::PauseTiming() {
+  if (is_timing_) {
+    elapsed_ += Clock::now() - start_;
+    is_timing_ = false;
+  }
+}
+
+void State::ResumeTiming() {
+  if (!is_timing_) {
+    start_ = Clock::now();
+    is_timing_ = true;
+  }
+}
+
+bool RegisterBenchmark(const char* name, Function function, bool needs_gl) {
+  Benchmark benchmark;
+  benchmark.name = name;
+  benchmark.function = function;
+  benchmark.needs_gl = needs_gl;
+  GetRegistry().push_back(benchmark);
+  return true;
+}
+
+int RunBenchmarks(const Options& options) {
+  std::vector<Benchmark> benchmarks = GetRegistry();
+  std::sort(benchmarks.begin(), benchmarks.end(),
+            [](const Benchmark& a, const Benchmark& b) {
+              return a.name < b.name;
+            });
+
+  if (options.csv) {
+    printf("name,iterations,ns_per_op,bytes_per_op,mb_per_s\n");
+  } else {
+    printf("%-40s %12s %14s %14s %10s\n", "Benchmark", "Iterations",
+           "ns/op", "bytes/op", "MB/s");
+  }
+
+  int failed_count = 0;
+  for (const Benchmark& benchmark : benchmarks) {
+    if (options.filter != nullptr &&
+        benchmark.name.find(options.filter) == std::string::npos) {
+      continue;
+    }
+    if (benchmark.needs_gl && !options.has_gl) {
+      fprintf(stderr, "%s: skipped, no GL context\n", benchmark.name.c_str());
+      continue;
+    }
+
+    State state(0);
+    if (!RunBenchmark(benchmark, options.min_time, &state)) {
+      fprintf(stderr, "%s: %s\n", benchmark.name.c_str(),
+              state.GetErrorMessage());
+      ++failed_count;
+      continue;
+    }
+
+    double iterations = static_cast<double>(state.iterations());
+    double ns_per_op = state.GetElapsedSeconds() * 1e9 / iterations;
+    double bytes_per_op = state.GetBytesProcessed() / iterations;
+    double mb_per_s = state.GetElapsedSeconds() > 0.0
+                          ? state.GetBytesProcessed() /
+                                state.GetElapsedSeconds() / (1024 * 1024)
+                          : 0.0;
+    if (options.csv) {
+      printf("%s,%" PRId64 ",%.2f,%.0f,%.2f\n", benchmark.name.c_str(),
+             state.iterations(), ns_per_op, bytes_per_op, mb_per_s);
+    } else {
+      printf("%-40s %12" PRId64 " %14.2f %14.0f %10.2f\n",
+             benchmark.name.c_str(), state.iterations(), ns_per_op,
+             bytes_per_op, mb_per_s);
+    }
+    fflush(stdout);
+  }
+  return failed_count;
+}
+
+}  // namespace tango_benchmark
@@ -0,0 +1,84 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// Runs the tango-gl and example microbenchmarks, on a device from adb shell
+// or on a desktop with the host build:
+//
+//   tango_benchmarks [--filter=<substring>] [--min_time=<seconds>] [--csv]
+//       [--session=<session file>] [--tmp_dir=<directory>] [--no_gl]
+//
+// Results are reported as ns and bytes per iteration, --csv prints them in a
+// form suited for regression tracking.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <tango-gl/offscreen_context.h>
+
+#include "tango-benchmarks/benchmark.h"
+#include "tango-benchmarks/inputs.h"
+
+namespace {
+const int kSurfaceWidth = 1280;
+const int kSurfaceHeight = 720;
+
+// Returns the value of a --name=value argument, nullptr if arg is another
+// one.
+const char* GetFlagValue(const char* arg, const char* name) {
+  size_t length = strlen(name);
+  if (strncmp(arg, name, length) != 0 || arg[length] != '=') {
+    return nullptr;
+  }
+  return arg + length + 1;
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  tango_benchmark::Options options;
+  bool use_gl = true;
+  for (int i = 1; i < argc; ++i) {
+    const char* value = nullptr;
+    if ((value = GetFlagValue(argv[i], "--filter")) != nullptr) {
+      options.filter = value;
+    } else if ((value = GetFlagValue(argv[i], "--min_time")) != nullptr) {
+      options.min_time = atof(value);
+    } else if ((value = GetFlagValue(argv[i], "--session")) != nullptr) {
+      if (!tango_benchmark::inputs::LoadSession(value)) {
+        fprintf(stderr, "Could not open session %s\n", value);
+        return EXIT_FAILURE;
+      }
+    } else if ((value = GetFlagValue(argv[i], "--tmp_dir")) != nullptr) {
+      tango_benchmark::inputs::SetTemporaryDirectory(value);
+    } else if (strcmp(argv[i], "--csv") == 0) {
+      options.csv = true;
+    } else if (strcmp(argv[i], "--no_gl") == 0) {
+      use_gl = false;
+    } else {
+      fprintf(stderr, "Unknown argument %s\n", argv[i]);
+      return EXIT_FAILURE;
+    }
+  }
+
+  tango_gl::OffscreenContext context;
+  options.has_gl = use_gl && context.Create(kSurfaceWidth, kSurfaceHeight);
+  if (use_gl && !options.has_gl) {
+    fprintf(stderr, "No GL context, skipping the GL benchmarks\n");
+  }
+  return tango_benchmark::RunBenchmarks(options) == 0 ? EXIT_SUCCESS
+                                                      : EXIT_FAILURE;
+}
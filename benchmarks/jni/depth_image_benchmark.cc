@@ -0,0 +1,62 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// CPU depth upsampling of the RGB depth sync example at the color camera
+// resolution, including the texture upload.
+
+#include "rgb-depth-sync/depth_image.h"
+#include "tango-benchmarks/benchmark.h"
+#include "tango-benchmarks/inputs.h"
+
+namespace {
+void RunUpsampleDepth(tango_benchmark::State* state, bool is_parallel,
+                      bool is_hole_filling_on) {
+  const std::vector<float>& points = tango_benchmark::inputs::GetPointCloud();
+  glm::mat4 color_T_depth = tango_benchmark::inputs::GetColorTDepth();
+  rgb_depth_sync::DepthImage depth_image;
+  depth_image.InitializeGL();
+  // The CPU paths do not render with the projection matrix.
+  depth_image.SetCameraIntrinsics(
+      tango_benchmark::inputs::GetColorIntrinsics(), glm::mat4(1.0f));
+  depth_image.SetHoleFilling(is_hole_filling_on);
+  while (state->KeepRunning()) {
+    if (is_parallel) {
+      depth_image.UpdateAndUpsampleDepthParallel(color_T_depth, points);
+    } else {
+      depth_image.UpdateAndUpsampleDepth(color_T_depth, points);
+    }
+  }
+  glFinish();
+  state->SetBytesProcessed(state->iterations() * points.size() *
+                           sizeof(float));
+}
+
+void BM_UpdateAndUpsampleDepth(tango_benchmark::State* state) {
+  RunUpsampleDepth(state, false, false);
+}
+TANGO_BENCHMARK_GL(BM_UpdateAndUpsampleDepth);
+
+void BM_UpdateAndUpsampleDepthHoleFilling(tango_benchmark::State* state) {
+  RunUpsampleDepth(state, false, true);
+}
+TANGO_BENCHMARK_GL(BM_UpdateAndUpsampleDepthHoleFilling);
+
+void BM_UpdateAndUpsampleDepthParallel(tango_benchmark::State* state) {
+  RunUpsampleDepth(state, true, false);
+}
+TANGO_BENCHMARK_GL(BM_UpdateAndUpsampleDepthParallel);
+}  // namespace
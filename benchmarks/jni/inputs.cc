@@ -0,0 +1,242 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <tango-gl/session_replayer.h>
+
+#include "tango-benchmarks/inputs.h"
+
+namespace {
+// Development kit color camera.
+const int kColorWidth = 1280;
+const int kColorHeight = 720;
+const double kColorFocalLength = 1042.0;
+const double kColorCx = 637.0;
+const double kColorCy = 357.0;
+
+// Development kit depth camera, used to synthesize a full depth frame.
+const int kDepthWidth = 320;
+const int kDepthHeight = 180;
+const float kDepthFocalLength = 260.0f;
+
+const int kObjGridSize = 250;
+
+#if defined(__ANDROID__)
+const char kDefaultTemporaryDirectory[] = "/data/local/tmp";
+#else
+const char kDefaultTemporaryDirectory[] = "/tmp";
+#endif
+
+struct Inputs {
+  Inputs()
+      : temporary_directory(kDefaultTemporaryDirectory),
+        color_width(0),
+        color_height(0),
+        is_obj_file_written(false) {}
+
+  std::string temporary_directory;
+  std::vector<float> point_cloud;
+  std::vector<uint8_t> color_image;
+  int color_width;
+  int color_height;
+  std::string obj_file_path;
+  bool is_obj_file_written;
+};
+
+Inputs& GetInputs() {
+  static Inputs inputs;
+  return inputs;
+}
+
+void SynthesizePointCloud(std::vector<float>* points) {
+  points->clear();
+  points->reserve(kDepthWidth * kDepthHeight * 3);
+  for (int y = 0; y < kDepthHeight; ++y) {
+    for (int x = 0; x < kDepthWidth; ++x) {
+      float z = 2.0f + 0.2f * sinf(x * 0.05f) * cosf(y * 0.07f);
+      points->push_back((x - kDepthWidth * 0.5f) * z / kDepthFocalLength);
+      points->push_back((y - kDepthHeight * 0.5f) * z / kDepthFocalLength);
+      points->push_back(z);
+    }
+  }
+}
+
+void SynthesizeColorImage(std::vector<uint8_t>* nv21) {
+  const int y_size = kColorWidth * kColorHeight;
+  nv21->resize(y_size * 3 / 2);
+  for (int y = 0; y < kColorHeight; ++y) {
+    for (int x = 0; x < kColorWidth; ++x) {
+      (*nv21)[y * kColorWidth + x] = static_cast<uint8_t>(x + y);
+    }
+  }
+  for (int i = y_size; i < y_size * 3 / 2; ++i) {
+    (*nv21)[i] = static_cast<uint8_t>(i * 7);
+  }
+}
+
+void OnXYZijAvailable(void* context, const TangoXYZij* xyz_ij) {
+  Inputs* inputs = static_cast<Inputs*>(context);
+  if (inputs->point_cloud.empty() && xyz_ij->xyz_count > 0) {
+    inputs->point_cloud.assign(xyz_ij->xyz[0],
+                               xyz_ij->xyz[0] + xyz_ij->xyz_count * 3);
+  }
+}
+
+void OnFrameAvailable(void* context, TangoCameraId camera_id,
+                      const TangoImageBuffer* image) {
+  Inputs* inputs = static_cast<Inputs*>(context);
+  if (camera_id != TANGO_CAMERA_COLOR || !inputs->color_image.empty() ||
+      image->format != TANGO_HAL_PIXEL_FORMAT_YCrCb_420_SP ||
+      image->stride != image->width) {
+    return;
+  }
+  inputs->color_image.assign(
+      image->data, image->data + image->width * image->height * 3 / 2);
+  inputs->color_width = image->width;
+  inputs->color_height = image->height;
+}
+}  // namespace
+
+namespace tango_benchmark {
+namespace inputs {
+
+bool LoadSession(const char* path) {
+  tango_gl::SessionReplayer replayer;
+  if (!replayer.Open(path)) {
+    return false;
+  }
+  tango_gl::SessionReplayer::Callbacks callbacks;
+  callbacks.context = &GetInputs();
+  callbacks.on_xyz_ij_available = OnXYZijAvailable;
+  callbacks.on_frame_available = OnFrameAvailable;
+  replayer.Run(callbacks, 0.0);
+  return true;
+}
+
+void SetTemporaryDirectory(const std::string& path) {
+  GetInputs().temporary_directory = path;
+}
+
+const TangoCameraIntrinsics& GetColorIntrinsics() {
+  static TangoCameraIntrinsics intrinsics = [] {
+    TangoCameraIntrinsics color;
+    memset(&color, 0, sizeof(color));
+    color.camera_id = TANGO_CAMERA_COLOR;
+    color.calibration_type = TANGO_CALIBRATION_POLYNOMIAL_3_PARAMETERS;
+    color.width = kColorWidth;
+    color.height = kColorHeight;
+    color.fx = kColorFocalLength;
+    color.fy = kColorFocalLength;
+    color.cx = kColorCx;
+    color.cy = kColorCy;
+    return color;
+  }();
+  return intrinsics;
+}
+
+const TangoCameraIntrinsics& GetDepthIntrinsics() {
+  static TangoCameraIntrinsics intrinsics = [] {
+    TangoCameraIntrinsics depth;
+    memset(&depth, 0, sizeof(depth));
+    depth.camera_id = TANGO_CAMERA_DEPTH;
+    depth.width = kDepthWidth;
+    depth.height = kDepthHeight;
+    depth.fx = kDepthFocalLength;
+    depth.fy = kDepthFocalLength;
+    depth.cx = kDepthWidth * 0.5;
+    depth.cy = kDepthHeight * 0.5;
+    return depth;
+  }();
+  return intrinsics;
+}
+
+glm::mat4 GetColorTDepth() {
+  // The cameras are a few centimeters apart on the device.
+  return glm::translate(glm::mat4(1.0f), glm::vec3(0.06f, 0.0f, 0.0f));
+}
+
+const std::vector<float>& GetPointCloud() {
+  Inputs& inputs = GetInputs();
+  if (inputs.point_cloud.empty()) {
+    SynthesizePointCloud(&inputs.point_cloud);
+  }
+  return inputs.point_cloud;
+}
+
+const std::vector<uint8_t>& GetColorImage() {
+  Inputs& inputs = GetInputs();
+  if (inputs.color_image.empty()) {
+    SynthesizeColorImage(&inputs.color_image);
+    inputs.color_width = kColorWidth;
+    inputs.color_height = kColorHeight;
+  }
+  return inputs.color_image;
+}
+
+int GetColorImageWidth() {
+  GetColorImage();
+  return GetInputs().color_width;
+}
+
+int GetColorImageHeight() {
+  GetColorImage();
+  return GetInputs().color_height;
+}
+
+const std::string& GetObjFilePath() {
+  Inputs& inputs = GetInputs();
+  if (inputs.is_obj_file_written) {
+    return inputs.obj_file_path;
+  }
+  inputs.is_obj_file_written = true;
+
+  std::string path = inputs.temporary_directory + "/tango_benchmark_grid.obj";
+  FILE* file = fopen(path.c_str(), "w");
+  if (file == nullptr) {
+    LOGE("Could not write %s", path.c_str());
+    return inputs.obj_file_path;
+  }
+  for (int y = 0; y < kObjGridSize; ++y) {
+    for (int x = 0; x < kObjGridSize; ++x) {
+      fprintf(file, "v %f %f %f\n", x * 0.01f, 0.05f * sinf(x * 0.1f + y),
+              y * 0.01f);
+      fprintf(file, "vn 0.000000 1.000000 0.000000\n");
+    }
+  }
+  for (int y = 0; y + 1 < kObjGridSize; ++y) {
+    for (int x = 0; x + 1 < kObjGridSize; ++x) {
+      int v = y * kObjGridSize + x + 1;
+      fprintf(file, "f %d//%d %d//%d %d//%d %d//%d\n", v, v, v + 1, v + 1,
+              v + kObjGridSize + 1, v + kObjGridSize + 1, v + kObjGridSize,
+              v + kObjGridSize);
+    }
+  }
+  bool is_written = ferror(file) == 0;
+  is_written = fclose(file) == 0 && is_written;
+  if (is_written) {
+    inputs.obj_file_path = path;
+  } else {
+    LOGE("Could not write %s", path.c_str());
+  }
+  return inputs.obj_file_path;
+}
+
+}  // namespace inputs
+}  // namespace tango_benchmark
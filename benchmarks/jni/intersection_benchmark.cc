@@ -0,0 +1,129 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// Ray picking tests, a touch segment against object bounds.
+
+#include <math.h>
+
+#include <vector>
+
+#include <tango-gl/bounding_box.h>
+#include <tango-gl/bvh.h>
+#include <tango-gl/segment.h>
+#include <tango-gl/util.h>
+
+#include "tango-benchmarks/benchmark.h"
+
+namespace {
+// Segments are cycled, about half of them hit the box.
+const int kSegmentCount = 256;
+
+// Placed boxes of the picking benchmarks, a scene with many selectable
+// meshes.
+const int kSceneBoxCount = 1024;
+
+std::vector<tango_gl::Segment> MakeSegments() {
+  std::vector<tango_gl::Segment> segments;
+  for (int i = 0; i < kSegmentCount; ++i) {
+    glm::vec3 direction(sinf(i * 0.37f), cosf(i * 0.61f), -1.0f);
+    segments.push_back(tango_gl::Segment(glm::vec3(0.0f, 0.0f, 2.0f),
+                                         glm::vec3(0.0f, 0.0f, 2.0f) +
+                                             4.0f * direction));
+  }
+  return segments;
+}
+
+// Model matrices of small boxes scattered in front of the segments' start.
+glm::mat4 MakeSceneTransformation(int i) {
+  glm::quat rotation = glm::angleAxis(
+      i * 0.7f, glm::normalize(glm::vec3(1.0f, sinf(i * 1.3f), 0.5f)));
+  return glm::translate(glm::mat4(1.0f),
+                        glm::vec3(2.0f * sinf(i * 2.1f), 2.0f * cosf(i * 1.7f),
+                                  -2.0f * sinf(i * 0.9f))) *
+         glm::mat4_cast(rotation);
+}
+
+const tango_gl::BoundingBox kSceneBox(glm::vec3(-0.05f), glm::vec3(0.05f));
+
+void BM_BoundingBoxIsIntersecting(tango_benchmark::State* state) {
+  std::vector<tango_gl::Segment> segments = MakeSegments();
+  tango_gl::BoundingBox box(glm::vec3(-0.5f), glm::vec3(0.5f));
+  glm::quat rotation =
+      glm::angleAxis(0.3f, glm::normalize(glm::vec3(1.0f, 1.0f, 0.0f)));
+  glm::mat4 transformation =
+      glm::translate(glm::mat4(1.0f), glm::vec3(0.1f, -0.2f, 0.0f)) *
+      glm::mat4_cast(rotation);
+
+  int index = 0;
+  while (state->KeepRunning()) {
+    tango_benchmark::DoNotOptimize(
+        box.IsIntersecting(segments[index], rotation, transformation));
+    index = (index + 1) % kSegmentCount;
+  }
+  state->SetBytesProcessed(state->iterations() * sizeof(tango_gl::Segment));
+}
+TANGO_BENCHMARK(BM_BoundingBoxIsIntersecting);
+
+void BM_BoundingBoxBatchFindNearest(tango_benchmark::State* state) {
+  std::vector<tango_gl::Segment> segments = MakeSegments();
+  tango_gl::BoundingBoxBatch batch;
+  for (int i = 0; i < kSceneBoxCount; ++i) {
+    batch.Add(kSceneBox, MakeSceneTransformation(i));
+  }
+
+  int index = 0;
+  while (state->KeepRunning()) {
+    tango_benchmark::DoNotOptimize(
+        batch.FindNearest(segments[index], nullptr));
+    index = (index + 1) % kSegmentCount;
+  }
+  state->SetBytesProcessed(state->iterations() * sizeof(tango_gl::Segment));
+}
+TANGO_BENCHMARK(BM_BoundingBoxBatchFindNearest);
+
+void BM_ObjectBvhPick(tango_benchmark::State* state) {
+  std::vector<tango_gl::Segment> segments = MakeSegments();
+  tango_gl::ObjectBvh bvh;
+  for (int i = 0; i < kSceneBoxCount; ++i) {
+    bvh.Add(kSceneBox, MakeSceneTransformation(i));
+  }
+  bvh.Update();
+
+  int index = 0;
+  while (state->KeepRunning()) {
+    tango_benchmark::DoNotOptimize(bvh.Pick(segments[index], nullptr));
+    index = (index + 1) % kSegmentCount;
+  }
+  state->SetBytesProcessed(state->iterations() * sizeof(tango_gl::Segment));
+}
+TANGO_BENCHMARK(BM_ObjectBvhPick);
+
+void BM_SegmentAABBIntersect(tango_benchmark::State* state) {
+  std::vector<tango_gl::Segment> segments = MakeSegments();
+  const glm::vec3 aabb_min(-0.5f);
+  const glm::vec3 aabb_max(0.5f);
+
+  int index = 0;
+  while (state->KeepRunning()) {
+    tango_benchmark::DoNotOptimize(tango_gl::util::SegmentAABBIntersect(
+        aabb_min, aabb_max, segments[index].start, segments[index].end));
+    index = (index + 1) % kSegmentCount;
+  }
+  state->SetBytesProcessed(state->iterations() * sizeof(tango_gl::Segment));
+}
+TANGO_BENCHMARK(BM_SegmentAABBIntersect);
+}  // namespace
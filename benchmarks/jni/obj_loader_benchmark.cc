@@ -0,0 +1,71 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// OBJ parsing into the layouts the examples load, from a generated grid
+// model.
+
+#include <sys/stat.h>
+
+#include <tango-gl/obj_loader.h>
+
+#include "tango-benchmarks/benchmark.h"
+#include "tango-benchmarks/inputs.h"
+
+namespace {
+// Size of the OBJ file, or 0 if it could not be written.
+int64_t GetObjFileSize(tango_benchmark::State* state) {
+  const std::string& path = tango_benchmark::inputs::GetObjFilePath();
+  struct stat file_stat;
+  if (path.empty() || stat(path.c_str(), &file_stat) != 0) {
+    state->SkipWithError("no OBJ file");
+    return 0;
+  }
+  return file_stat.st_size;
+}
+
+void BM_LoadOBJDataIndexed(tango_benchmark::State* state) {
+  int64_t file_size = GetObjFileSize(state);
+  const char* path = tango_benchmark::inputs::GetObjFilePath().c_str();
+  std::vector<GLfloat> vertices;
+  std::vector<GLushort> indices;
+  while (state->KeepRunning()) {
+    vertices.clear();
+    indices.clear();
+    if (!tango_gl::obj_loader::LoadOBJData(path, vertices, indices)) {
+      state->SkipWithError("LoadOBJData() failed");
+    }
+  }
+  state->SetBytesProcessed(state->iterations() * file_size);
+}
+TANGO_BENCHMARK(BM_LoadOBJDataIndexed);
+
+void BM_LoadOBJDataNormals(tango_benchmark::State* state) {
+  int64_t file_size = GetObjFileSize(state);
+  const char* path = tango_benchmark::inputs::GetObjFilePath().c_str();
+  std::vector<GLfloat> vertices;
+  std::vector<GLfloat> normals;
+  while (state->KeepRunning()) {
+    vertices.clear();
+    normals.clear();
+    if (!tango_gl::obj_loader::LoadOBJData(path, vertices, normals)) {
+      state->SkipWithError("LoadOBJData() failed");
+    }
+  }
+  state->SetBytesProcessed(state->iterations() * file_size);
+}
+TANGO_BENCHMARK(BM_LoadOBJDataNormals);
+}  // namespace
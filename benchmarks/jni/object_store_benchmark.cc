@@ -0,0 +1,116 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// Placed objects updated and culled each frame, a Transform and a frustum
+// test per object against an ObjectStore.
+
+#include <math.h>
+
+#include <vector>
+
+#include <tango-gl/bounding_box.h>
+#include <tango-gl/mesh.h>
+#include <tango-gl/object_store.h>
+#include <tango-gl/transform.h>
+#include <tango-gl/util.h>
+#include <tango-gl/view_frustum.h>
+
+#include "tango-benchmarks/benchmark.h"
+
+namespace {
+// Objects of the scene, one in kMovedStride moves every frame.
+const int kObjectCount = 4096;
+const int kMovedStride = 8;
+
+const float kCubeVertices[] = {-0.05f, -0.05f, -0.05f, 0.05f, 0.05f, 0.05f};
+
+glm::vec3 MakePosition(int i, int frame) {
+  return glm::vec3(8.0f * sinf(i * 2.1f + frame * 0.01f),
+                   2.0f * cosf(i * 1.7f), -8.0f * sinf(i * 0.9f));
+}
+
+glm::quat MakeRotation(int i) {
+  return glm::angleAxis(
+      i * 0.7f, glm::normalize(glm::vec3(1.0f, sinf(i * 1.3f), 0.5f)));
+}
+
+// Camera turning around the origin, about a quarter of the objects in view.
+void UpdateFrustum(int frame, tango_gl::ViewFrustum* frustum) {
+  const glm::vec3 target(sinf(frame * 0.05f), 0.0f, cosf(frame * 0.05f));
+  frustum->Update(glm::perspective(1.0f, 1.5f, 0.1f, 20.0f),
+                  glm::lookAt(glm::vec3(0.0f), target,
+                              glm::vec3(0.0f, 1.0f, 0.0f)));
+}
+
+void BM_TransformCullPerObject(tango_benchmark::State* state) {
+  const tango_gl::BoundingBox box(
+      std::vector<float>(kCubeVertices, kCubeVertices + 6));
+  std::vector<tango_gl::Transform> transforms(kObjectCount);
+  for (int i = 0; i < kObjectCount; ++i) {
+    transforms[i].SetPosition(MakePosition(i, 0));
+    transforms[i].SetRotation(MakeRotation(i));
+  }
+  tango_gl::ViewFrustum frustum;
+  std::vector<GLfloat> instances;
+  int frame = 0;
+  while (state->KeepRunning()) {
+    ++frame;
+    UpdateFrustum(frame, &frustum);
+    for (int i = frame % kMovedStride; i < kObjectCount; i += kMovedStride) {
+      transforms[i].SetPosition(MakePosition(i, frame));
+    }
+    instances.clear();
+    for (const tango_gl::Transform& transform : transforms) {
+      const glm::mat4& world_T_model = transform.GetTransformationMatrix();
+      if (frustum.IsBoxVisible(box, world_T_model)) {
+        const GLfloat* matrix = glm::value_ptr(world_T_model);
+        instances.insert(instances.end(), matrix, matrix + 16);
+      }
+    }
+    tango_benchmark::DoNotOptimize(instances.data());
+  }
+  state->SetBytesProcessed(state->iterations() * kObjectCount *
+                           sizeof(glm::mat4));
+}
+TANGO_BENCHMARK(BM_TransformCullPerObject);
+
+void BM_ObjectStoreUpdate(tango_benchmark::State* state) {
+  tango_gl::Mesh cube;
+  cube.SetVertices(std::vector<GLfloat>(kCubeVertices, kCubeVertices + 6));
+  tango_gl::ObjectStore store;
+  const uint32_t mesh = store.AddMesh(&cube);
+  std::vector<tango_gl::ObjectStore::ObjectId> ids(kObjectCount);
+  for (int i = 0; i < kObjectCount; ++i) {
+    ids[i] = store.Add(mesh, MakePosition(i, 0), MakeRotation(i),
+                       glm::vec3(1.0f), glm::vec4(1.0f));
+  }
+  tango_gl::ViewFrustum frustum;
+  int frame = 0;
+  while (state->KeepRunning()) {
+    ++frame;
+    UpdateFrustum(frame, &frustum);
+    for (int i = frame % kMovedStride; i < kObjectCount; i += kMovedStride) {
+      store.SetPose(ids[i], MakePosition(i, frame), MakeRotation(i));
+    }
+    store.Update(frustum);
+    tango_benchmark::DoNotOptimize(store.GetInstances(mesh).data());
+  }
+  state->SetBytesProcessed(state->iterations() * kObjectCount *
+                           sizeof(glm::mat4));
+}
+TANGO_BENCHMARK(BM_ObjectStoreUpdate);
+}  // namespace
@@ -0,0 +1,52 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// Plane equation transforms of the plane fitting example, one per detected
+// plane and frame.
+
+#include <math.h>
+
+#include <tango-gl/util.h>
+
+#include "tango-benchmarks/benchmark.h"
+#include "tango-plane-fitting/plane_fitting.h"
+
+namespace {
+// Inputs are cycled so the results do not depend on one plane.
+const int kPlaneCount = 64;
+
+void BM_PlaneTransform(tango_benchmark::State* state) {
+  std::vector<glm::vec4> planes(kPlaneCount);
+  for (int i = 0; i < kPlaneCount; ++i) {
+    glm::vec3 normal = glm::normalize(glm::vec3(sinf(i), cosf(i), 0.5f));
+    planes[i] = glm::vec4(normal, -0.1f * i);
+  }
+  glm::mat4 out_T_in = glm::rotate(
+      glm::translate(glm::mat4(1.0f), glm::vec3(0.3f, -1.2f, 2.0f)), 0.7f,
+      glm::normalize(glm::vec3(1.0f, 2.0f, 3.0f)));
+
+  glm::vec4 out_plane;
+  int index = 0;
+  while (state->KeepRunning()) {
+    tango_plane_fitting::PlaneTransform(planes[index], out_T_in, &out_plane);
+    tango_benchmark::DoNotOptimize(out_plane);
+    index = (index + 1) % kPlaneCount;
+  }
+  state->SetBytesProcessed(state->iterations() * 2 * sizeof(glm::vec4));
+}
+TANGO_BENCHMARK(BM_PlaneTransform);
+}  // namespace
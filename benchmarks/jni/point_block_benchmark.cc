@@ -0,0 +1,97 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// Depth frames transformed to the world frame, walking the interleaved
+// points of TangoXYZij against a PointBlock, and the conversions between
+// the two layouts.
+
+#include <vector>
+
+#include <tango-gl/point_block.h>
+#include <tango-gl/util.h>
+
+#include "tango-benchmarks/benchmark.h"
+#include "tango-benchmarks/inputs.h"
+
+namespace {
+glm::mat4 GetWorldTDepth() {
+  return glm::translate(glm::mat4(1.0f), glm::vec3(0.5f, 1.2f, -0.3f)) *
+         glm::mat4_cast(
+             glm::angleAxis(0.3f, glm::normalize(glm::vec3(1.0f, 2.0f, 0.5f))));
+}
+
+void BM_TransformInterleavedPoints(tango_benchmark::State* state) {
+  const std::vector<float>& cloud = tango_benchmark::inputs::GetPointCloud();
+  const size_t point_count = cloud.size() / 3;
+  const glm::mat4 world_T_depth = GetWorldTDepth();
+  std::vector<float> points(cloud.size());
+  while (state->KeepRunning()) {
+    for (size_t i = 0; i < point_count; ++i) {
+      const float* point = cloud.data() + i * 3;
+      const glm::vec4 world =
+          world_T_depth * glm::vec4(point[0], point[1], point[2], 1.0f);
+      points[i * 3] = world.x;
+      points[i * 3 + 1] = world.y;
+      points[i * 3 + 2] = world.z;
+    }
+    tango_benchmark::DoNotOptimize(points.data());
+  }
+  state->SetBytesProcessed(state->iterations() * cloud.size() *
+                           sizeof(float));
+}
+TANGO_BENCHMARK(BM_TransformInterleavedPoints);
+
+void BM_PointBlockTransform(tango_benchmark::State* state) {
+  const std::vector<float>& cloud = tango_benchmark::inputs::GetPointCloud();
+  const glm::mat4 world_T_depth = GetWorldTDepth();
+  tango_gl::PointBlock block;
+  block.CopyFromXyz(cloud.data(), cloud.size() / 3);
+  while (state->KeepRunning()) {
+    block.Transform(world_T_depth);
+    tango_benchmark::DoNotOptimize(block.GetX());
+  }
+  state->SetBytesProcessed(state->iterations() * cloud.size() *
+                           sizeof(float));
+}
+TANGO_BENCHMARK(BM_PointBlockTransform);
+
+void BM_PointBlockCopyFromXyz(tango_benchmark::State* state) {
+  const std::vector<float>& cloud = tango_benchmark::inputs::GetPointCloud();
+  tango_gl::PointBlock block;
+  while (state->KeepRunning()) {
+    block.CopyFromXyz(cloud.data(), cloud.size() / 3);
+    tango_benchmark::DoNotOptimize(block.GetX());
+  }
+  state->SetBytesProcessed(state->iterations() * cloud.size() *
+                           sizeof(float));
+}
+TANGO_BENCHMARK(BM_PointBlockCopyFromXyz);
+
+void BM_PointBlockCopyToXyz(tango_benchmark::State* state) {
+  const std::vector<float>& cloud = tango_benchmark::inputs::GetPointCloud();
+  tango_gl::PointBlock block;
+  block.CopyFromXyz(cloud.data(), cloud.size() / 3);
+  std::vector<float> points(cloud.size());
+  while (state->KeepRunning()) {
+    block.CopyToXyz(points.data());
+    tango_benchmark::DoNotOptimize(points.data());
+  }
+  state->SetBytesProcessed(state->iterations() * cloud.size() *
+                           sizeof(float));
+}
+TANGO_BENCHMARK(BM_PointBlockCopyToXyz);
+}  // namespace
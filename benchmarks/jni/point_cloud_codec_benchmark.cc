@@ -0,0 +1,80 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Encoding and decoding of depth frames with tango_gl::point_cloud_codec, at
+// the default millimeter step and at a lossy centimeter step.
+
+#include <vector>
+
+#include <tango-gl/point_cloud_codec.h>
+
+#include "tango-benchmarks/benchmark.h"
+#include "tango-benchmarks/inputs.h"
+
+namespace {
+namespace codec = tango_gl::point_cloud_codec;
+
+const float kLossyStep = 0.01f;
+
+void RunEncode(tango_benchmark::State* state, float step) {
+  const std::vector<float>& points = tango_benchmark::inputs::GetPointCloud();
+  const size_t point_count = points.size() / 3;
+  std::vector<uint8_t> encoded(codec::GetMaxEncodedSize(point_count));
+  codec::Encoder encoder;
+  while (state->KeepRunning()) {
+    tango_benchmark::DoNotOptimize(encoder.Encode(
+        points.data(), point_count, step, encoded.data(), encoded.size()));
+  }
+  state->SetBytesProcessed(state->iterations() * points.size() *
+                           sizeof(float));
+}
+
+void RunDecode(tango_benchmark::State* state, float step) {
+  const std::vector<float>& points = tango_benchmark::inputs::GetPointCloud();
+  const size_t point_count = points.size() / 3;
+  std::vector<uint8_t> encoded(codec::GetMaxEncodedSize(point_count));
+  codec::Encoder encoder;
+  const size_t encoded_size = encoder.Encode(
+      points.data(), point_count, step, encoded.data(), encoded.size());
+  std::vector<float> decoded(points.size());
+  while (state->KeepRunning()) {
+    tango_benchmark::DoNotOptimize(codec::Decode(
+        encoded.data(), encoded_size, decoded.data(), point_count));
+  }
+  state->SetBytesProcessed(state->iterations() * points.size() *
+                           sizeof(float));
+}
+
+void BM_PointCloudEncode(tango_benchmark::State* state) {
+  RunEncode(state, codec::kDefaultStep);
+}
+TANGO_BENCHMARK(BM_PointCloudEncode);
+
+void BM_PointCloudEncodeLossy(tango_benchmark::State* state) {
+  RunEncode(state, kLossyStep);
+}
+TANGO_BENCHMARK(BM_PointCloudEncodeLossy);
+
+void BM_PointCloudDecode(tango_benchmark::State* state) {
+  RunDecode(state, codec::kDefaultStep);
+}
+TANGO_BENCHMARK(BM_PointCloudDecode);
+
+void BM_PointCloudDecodeLossy(tango_benchmark::State* state) {
+  RunDecode(state, kLossyStep);
+}
+TANGO_BENCHMARK(BM_PointCloudDecodeLossy);
+}  // namespace
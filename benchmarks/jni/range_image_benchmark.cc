@@ -0,0 +1,283 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Conversion of a depth frame into an organized range image, the first stage
+// of the algorithms that need the neighbors of each point, its back
+// projection, and the outlier removal, temporal filtering, normal estimation,
+// hit testing and triangulation on it, and the projective ICP that aligns the
+// frame with a map through it.
+
+#include <memory>
+
+#include <tango-gl/depth_hit_tester.h>
+#include <tango-gl/depth_outlier_filter.h>
+#include <tango-gl/normal_estimator.h>
+#include <tango-gl/point_map.h>
+#include <tango-gl/projective_icp.h>
+#include <tango-gl/range_image.h>
+#include <tango-gl/range_image_mesh.h>
+#include <tango-gl/temporal_depth_filter.h>
+
+#include "tango-benchmarks/benchmark.h"
+#include "tango-benchmarks/inputs.h"
+
+namespace {
+void BM_RangeImageUpdate(tango_benchmark::State* state) {
+  const std::vector<float>& points = tango_benchmark::inputs::GetPointCloud();
+  tango_gl::RangeImage range_image;
+  range_image.SetIntrinsics(tango_benchmark::inputs::GetDepthIntrinsics());
+  while (state->KeepRunning()) {
+    tango_benchmark::DoNotOptimize(
+        range_image.Update(points.data(), points.size() / 3));
+  }
+  state->SetBytesProcessed(state->iterations() * points.size() *
+                           sizeof(float));
+}
+TANGO_BENCHMARK(BM_RangeImageUpdate);
+
+// The same frame with its ij index grid filled in, gathered instead of
+// projected.
+void BM_RangeImageUpdateIndexGrid(tango_benchmark::State* state) {
+  std::vector<float> points = tango_benchmark::inputs::GetPointCloud();
+  tango_gl::RangeImage range_image;
+  range_image.SetIntrinsics(tango_benchmark::inputs::GetDepthIntrinsics());
+  range_image.Update(points.data(), points.size() / 3);
+  const int32_t* point_indices = range_image.GetPointIndices();
+  std::vector<uint32_t> ij(point_indices,
+                           point_indices + range_image.GetWidth() *
+                                               range_image.GetHeight());
+
+  TangoXYZij cloud = TangoXYZij();
+  cloud.xyz_count = static_cast<uint32_t>(points.size() / 3);
+  cloud.xyz = reinterpret_cast<float(*)[3]>(points.data());
+  cloud.ij_rows = static_cast<uint32_t>(range_image.GetHeight());
+  cloud.ij_cols = static_cast<uint32_t>(range_image.GetWidth());
+  cloud.ij = ij.data();
+  while (state->KeepRunning()) {
+    tango_benchmark::DoNotOptimize(range_image.Update(cloud));
+  }
+  state->SetBytesProcessed(state->iterations() * ij.size() *
+                           sizeof(uint32_t));
+}
+TANGO_BENCHMARK(BM_RangeImageUpdateIndexGrid);
+
+// Back projection of every filled pixel through the ray table.
+void BM_RangeImageBackProject(tango_benchmark::State* state) {
+  const std::vector<float>& points = tango_benchmark::inputs::GetPointCloud();
+  tango_gl::RangeImage range_image;
+  range_image.SetIntrinsics(tango_benchmark::inputs::GetDepthIntrinsics());
+  range_image.Update(points.data(), points.size() / 3);
+  const int width = range_image.GetWidth();
+  const int height = range_image.GetHeight();
+  while (state->KeepRunning()) {
+    glm::vec3 sum(0.0f);
+    for (int y = 0; y < height; ++y) {
+      for (int x = 0; x < width; ++x) {
+        sum += range_image.GetPosition(x, y);
+      }
+    }
+    tango_benchmark::DoNotOptimize(sum);
+  }
+  state->SetBytesProcessed(state->iterations() * width * height *
+                           sizeof(float));
+}
+TANGO_BENCHMARK(BM_RangeImageBackProject);
+
+// The grid depths of a frame, the CPU side of drawing it as a surface.
+void BM_RangeImageMeshUpdate(tango_benchmark::State* state) {
+  const std::vector<float>& points = tango_benchmark::inputs::GetPointCloud();
+  tango_gl::RangeImage range_image;
+  range_image.SetIntrinsics(tango_benchmark::inputs::GetDepthIntrinsics());
+  range_image.Update(points.data(), points.size() / 3);
+  tango_gl::RangeImageMesh mesh;
+  while (state->KeepRunning()) {
+    tango_benchmark::DoNotOptimize(mesh.Update(range_image));
+  }
+  state->SetBytesProcessed(state->iterations() * range_image.GetWidth() *
+                           range_image.GetHeight() * sizeof(float));
+}
+TANGO_BENCHMARK(BM_RangeImageMeshUpdate);
+
+void RunDepthOutlierFilter(tango_benchmark::State* state,
+                           tango_gl::WorkerPool* worker_pool) {
+  const std::vector<float>& points = tango_benchmark::inputs::GetPointCloud();
+  tango_gl::RangeImage range_image;
+  range_image.SetIntrinsics(tango_benchmark::inputs::GetDepthIntrinsics());
+  range_image.Update(points.data(), points.size() / 3);
+  tango_gl::DepthOutlierFilter filter(tango_gl::DepthOutlierFilter::Options(),
+                                      worker_pool);
+  while (state->KeepRunning()) {
+    tango_benchmark::DoNotOptimize(filter.Filter(range_image));
+  }
+  state->SetBytesProcessed(state->iterations() * range_image.GetWidth() *
+                           range_image.GetHeight() * sizeof(float));
+}
+
+void BM_DepthOutlierFilter(tango_benchmark::State* state) {
+  RunDepthOutlierFilter(state, nullptr);
+}
+TANGO_BENCHMARK(BM_DepthOutlierFilter);
+
+void BM_DepthOutlierFilterParallel(tango_benchmark::State* state) {
+  RunDepthOutlierFilter(state, &tango_gl::WorkerPool::GetShared());
+}
+TANGO_BENCHMARK(BM_DepthOutlierFilterParallel);
+
+// The filter fusing the same frame over and over, from a still camera or
+// from a camera moving a centimeter every frame, which adds the warp of the
+// previous state.
+void RunTemporalDepthFilter(tango_benchmark::State* state, bool is_moving) {
+  const std::vector<float>& points = tango_benchmark::inputs::GetPointCloud();
+  tango_gl::RangeImage range_image;
+  range_image.SetIntrinsics(tango_benchmark::inputs::GetDepthIntrinsics());
+  range_image.Update(points.data(), points.size() / 3);
+  tango_gl::TemporalDepthFilter filter(
+      (tango_gl::TemporalDepthFilter::Options()));
+  glm::mat4 world_T_depth(1.0f);
+  while (state->KeepRunning()) {
+    if (is_moving) {
+      world_T_depth[3].x += 0.01f;
+    }
+    tango_benchmark::DoNotOptimize(filter.Update(range_image, world_T_depth));
+  }
+  state->SetBytesProcessed(state->iterations() * range_image.GetWidth() *
+                           range_image.GetHeight() * sizeof(float));
+}
+
+void BM_TemporalDepthFilter(tango_benchmark::State* state) {
+  RunTemporalDepthFilter(state, false);
+}
+TANGO_BENCHMARK(BM_TemporalDepthFilter);
+
+void BM_TemporalDepthFilterMoving(tango_benchmark::State* state) {
+  RunTemporalDepthFilter(state, true);
+}
+TANGO_BENCHMARK(BM_TemporalDepthFilterMoving);
+
+void RunNormalEstimation(tango_benchmark::State* state, int window_radius,
+                         tango_gl::WorkerPool* worker_pool) {
+  const std::vector<float>& points = tango_benchmark::inputs::GetPointCloud();
+  tango_gl::RangeImage range_image;
+  range_image.SetIntrinsics(tango_benchmark::inputs::GetDepthIntrinsics());
+  range_image.Update(points.data(), points.size() / 3);
+  tango_gl::NormalEstimator estimator(worker_pool);
+  estimator.SetWindowRadius(window_radius);
+  while (state->KeepRunning()) {
+    tango_benchmark::DoNotOptimize(estimator.Compute(range_image));
+  }
+  state->SetBytesProcessed(state->iterations() * range_image.GetWidth() *
+                           range_image.GetHeight() * sizeof(float));
+}
+
+// The cost does not depend on the window size.
+void BM_NormalEstimation3x3(tango_benchmark::State* state) {
+  RunNormalEstimation(state, 1, nullptr);
+}
+TANGO_BENCHMARK(BM_NormalEstimation3x3);
+
+void BM_NormalEstimation15x15(tango_benchmark::State* state) {
+  RunNormalEstimation(state, 7, nullptr);
+}
+TANGO_BENCHMARK(BM_NormalEstimation15x15);
+
+void BM_NormalEstimationParallel(tango_benchmark::State* state) {
+  RunNormalEstimation(state, tango_gl::NormalEstimator::kDefaultWindowRadius,
+                      &tango_gl::WorkerPool::GetShared());
+}
+TANGO_BENCHMARK(BM_NormalEstimationParallel);
+
+// The frame aligned with a map holding only itself, from a pose off by a
+// centimeter and half a degree, which takes a few steps per level.
+void RunProjectiveIcp(tango_benchmark::State* state,
+                      tango_gl::WorkerPool* worker_pool) {
+  const std::vector<float>& points = tango_benchmark::inputs::GetPointCloud();
+  tango_gl::PointMap map(0.02f, 4096);
+  map.Insert(points.data(), points.size() / 3, glm::mat4(1.0f));
+  tango_gl::ProjectiveIcp icp(worker_pool);
+  icp.SetIntrinsics(tango_benchmark::inputs::GetDepthIntrinsics());
+  const glm::mat4 guess = glm::rotate(
+      glm::translate(glm::mat4(1.0f), glm::vec3(0.01f, 0.0f, 0.01f)),
+      0.01f, glm::vec3(0.0f, 1.0f, 0.0f));
+  while (state->KeepRunning()) {
+    glm::mat4 map_T_depth = guess;
+    tango_benchmark::DoNotOptimize(
+        icp.Refine(map, points.data(), points.size() / 3, &map_T_depth,
+                   nullptr));
+  }
+  state->SetBytesProcessed(state->iterations() * points.size() *
+                           sizeof(float));
+}
+
+void BM_ProjectiveIcp(tango_benchmark::State* state) {
+  RunProjectiveIcp(state, nullptr);
+}
+TANGO_BENCHMARK(BM_ProjectiveIcp);
+
+void BM_ProjectiveIcpParallel(tango_benchmark::State* state) {
+  RunProjectiveIcp(state, &tango_gl::WorkerPool::GetShared());
+}
+TANGO_BENCHMARK(BM_ProjectiveIcpParallel);
+
+// Probes on a 16 by 16 grid over the image, cycled through one at a time or
+// all at once like a placement preview.
+const int kProbeGridSize = 16;
+
+void RunDepthHitTest(tango_benchmark::State* state, bool is_batched) {
+  const std::vector<float>& points = tango_benchmark::inputs::GetPointCloud();
+  tango_gl::RangeImage range_image;
+  range_image.SetIntrinsics(tango_benchmark::inputs::GetDepthIntrinsics());
+  range_image.Update(points.data(), points.size() / 3);
+  tango_gl::DepthHitTester hit_tester;
+  hit_tester.SetDepthImage(range_image.GetDepths(),
+                           range_image.GetIntrinsics(), glm::mat4(1.0f));
+
+  const size_t probe_count = kProbeGridSize * kProbeGridSize;
+  std::vector<glm::vec2> uvs;
+  for (int y = 0; y < kProbeGridSize; ++y) {
+    for (int x = 0; x < kProbeGridSize; ++x) {
+      uvs.push_back(glm::vec2((x + 0.5f) / kProbeGridSize,
+                              (y + 0.5f) / kProbeGridSize));
+    }
+  }
+  std::vector<tango_gl::DepthHit> hits(probe_count);
+  std::unique_ptr<bool[]> is_hit(new bool[probe_count]);
+  size_t index = 0;
+  while (state->KeepRunning()) {
+    if (is_batched) {
+      tango_benchmark::DoNotOptimize(hit_tester.HitTest(
+          uvs.data(), probe_count, hits.data(), is_hit.get()));
+    } else {
+      tango_benchmark::DoNotOptimize(
+          hit_tester.HitTest(uvs[index], &hits[index]));
+      index = (index + 1) % probe_count;
+    }
+  }
+  const size_t window_size =
+      2 * tango_gl::DepthHitTester::kDefaultWindowRadius + 1;
+  state->SetBytesProcessed(state->iterations() * (is_batched ? probe_count : 1) *
+                           window_size * window_size * sizeof(float));
+}
+
+void BM_DepthHitTest(tango_benchmark::State* state) {
+  RunDepthHitTest(state, false);
+}
+TANGO_BENCHMARK(BM_DepthHitTest);
+
+void BM_DepthHitTestBatch256(tango_benchmark::State* state) {
+  RunDepthHitTest(state, true);
+}
+TANGO_BENCHMARK(BM_DepthHitTestBatch256);
+}  // namespace
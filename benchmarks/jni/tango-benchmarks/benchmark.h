@@ -0,0 +1,127 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_BENCHMARKS_BENCHMARK_H_
+#define TANGO_BENCHMARKS_BENCHMARK_H_
+
+#include <stdint.h>
+
+#include <chrono>
+
+namespace tango_benchmark {
+
+// A small harness in the style of Google Benchmark, which the NDK does not
+// ship. A benchmark is a function looping on State::KeepRunning():
+//
+//   void BM_Something(tango_benchmark::State* state) {
+//     Setup();
+//     while (state->KeepRunning()) {
+//       tango_benchmark::DoNotOptimize(Something());
+//     }
+//     state->SetBytesProcessed(state->iterations() * kBytesPerCall);
+//   }
+//   TANGO_BENCHMARK(BM_Something);
+//
+// The runner repeats it with a growing iteration count until a run takes
+// the minimum time, then reports the time and the bytes per iteration.
+class State {
+ public:
+  explicit State(int64_t max_iterations);
+
+  // True while iterations are left. The first call starts the timer, the
+  // call returning false stops it.
+  bool KeepRunning();
+
+  // Exclude setup done inside the loop from the measured time.
+  void PauseTiming();
+  void ResumeTiming();
+
+  // Total bytes read and written by all iterations, reported per iteration.
+  void SetBytesProcessed(int64_t bytes) { bytes_processed_ = bytes; }
+
+  // Mark the benchmark as not runnable, e.g. without input data.
+  void SkipWithError(const char* message) { error_message_ = message; }
+
+  int64_t iterations() const { return iterations_; }
+  int64_t GetBytesProcessed() const { return bytes_processed_; }
+  const char* GetErrorMessage() const { return error_message_; }
+  double GetElapsedSeconds() const { return elapsed_.count(); }
+
+ private:
+  typedef std::chrono::steady_clock Clock;
+
+  int64_t max_iterations_;
+  int64_t iterations_;
+  int64_t bytes_processed_;
+  const char* error_message_;
+  bool is_timing_;
+  Clock::time_point start_;
+  std::chrono::duration<double> elapsed_;
+};
+
+typedef void (*Function)(State* state);
+
+// Add a benchmark to the suite, see TANGO_BENCHMARK().
+//
+// @param name: name used in the report and by the filter.
+// @param function: the benchmark.
+// @param needs_gl: the benchmark makes GL calls and is skipped when no
+//        context could be created.
+// @return: true, to initialize a static in the registration macros.
+bool RegisterBenchmark(const char* name, Function function, bool needs_gl);
+
+// Run options, RunBenchmarks() uses the defaults unless changed.
+struct Options {
+  Options() : filter(nullptr), min_time(0.5), csv(false), has_gl(true) {}
+
+  // Only run benchmarks whose name contains this string, nullptr for all.
+  const char* filter;
+  // Minimum time of the reported run, in seconds.
+  double min_time;
+  // Print comma separated values instead of a table.
+  bool csv;
+  // Whether a GL context is current.
+  bool has_gl;
+};
+
+// Run the registered benchmarks in name order and print the results.
+//
+// @return: the number of benchmarks that failed.
+int RunBenchmarks(const Options& options);
+
+// Keep the compiler from optimizing away the computation of a value.
+template <typename T>
+inline void DoNotOptimize(const T& value) {
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// Keep the compiler from optimizing away writes to memory.
+inline void ClobberMemory() { asm volatile("" : : : "memory"); }
+
+}  // namespace tango_benchmark
+
+#define TANGO_BENCHMARK_REGISTER(function, needs_gl)   \
+  static const bool function##_is_registered =         \
+      tango_benchmark::RegisterBenchmark(#function, function, needs_gl)
+
+// Register a CPU only benchmark.
+#define TANGO_BENCHMARK(function) TANGO_BENCHMARK_REGISTER(function, false)
+
+// Register a benchmark needing a current GL context.
+#define TANGO_BENCHMARK_GL(function) TANGO_BENCHMARK_REGISTER(function, true)
+
+#endif  // TANGO_BENCHMARKS_BENCHMARK_H_
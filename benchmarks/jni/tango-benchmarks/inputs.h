@@ -0,0 +1,72 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_BENCHMARKS_INPUTS_H_
+#define TANGO_BENCHMARKS_INPUTS_H_
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include <tango_client_api.h>
+#include <tango-gl/util.h>
+
+namespace tango_benchmark {
+namespace inputs {
+
+// Inputs shared by the benchmarks. They are synthetic unless a session
+// recorded with tango_gl::SessionRecorder is loaded, in which case its
+// first point cloud and color image are used, so results can be tracked on
+// both fixed data and captures of real scenes.
+
+// Use the first point cloud and color image of a session.
+//
+// @return: false if the file is not a session. The synthetic inputs are
+//          kept for what the session does not contain.
+bool LoadSession(const char* path);
+
+// Directory for the files the benchmarks write, e.g. OBJ models.
+void SetTemporaryDirectory(const std::string& path);
+
+// Color camera intrinsics of the development kit.
+const TangoCameraIntrinsics& GetColorIntrinsics();
+
+// Depth camera intrinsics the synthetic point cloud was sampled with.
+const TangoCameraIntrinsics& GetDepthIntrinsics();
+
+// Transformation of the depth camera frame with respect to the color camera
+// frame, close to the development kit extrinsics.
+glm::mat4 GetColorTDepth();
+
+// Packed x, y, z points in the depth camera frame. The synthetic cloud is a
+// full resolution depth frame of a wavy wall two meters away.
+const std::vector<float>& GetPointCloud();
+
+// NV21 color image of GetColorIntrinsics() size.
+const std::vector<uint8_t>& GetColorImage();
+int GetColorImageWidth();
+int GetColorImageHeight();
+
+// Path of an OBJ file with a grid mesh of about 250 by 250 vertices, written
+// on the first call. Empty if the file cannot be written.
+const std::string& GetObjFilePath();
+
+}  // namespace inputs
+}  // namespace tango_benchmark
+
+#endif  // TANGO_BENCHMARKS_INPUTS_H_
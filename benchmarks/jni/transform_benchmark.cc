@@ -0,0 +1,281 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// World matrices of scene graph chains, the cached case and the cases where
+// an ancestor or the leaf moved since the last frame.
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include <tango-gl/conversions.h>
+#include <tango-gl/pose_interpolation.h>
+#include <tango-gl/simd_math.h>
+#include <tango-gl/transform.h>
+#include <tango-gl/util.h>
+
+#include "tango-benchmarks/benchmark.h"
+
+namespace {
+// Depth of the chains, e.g. world, device, camera and a few attached
+// objects.
+const int kChainLength = 8;
+
+// Poses interpolated per iteration, the depth frames of about a minute.
+const size_t kPoseCount = 256;
+
+class TransformChain {
+ public:
+  TransformChain() {
+    for (int i = 0; i < kChainLength; ++i) {
+      transforms_.emplace_back(new tango_gl::Transform());
+      transforms_[i]->SetPosition(glm::vec3(0.1f * i, 0.2f, -0.3f));
+      transforms_[i]->SetRotation(
+          glm::angleAxis(0.1f * i, glm::vec3(0.0f, 1.0f, 0.0f)));
+      if (i > 0) {
+        transforms_[i]->SetParent(transforms_[i - 1].get());
+      }
+    }
+  }
+
+  tango_gl::Transform* GetRoot() { return transforms_.front().get(); }
+  tango_gl::Transform* GetLeaf() { return transforms_.back().get(); }
+
+ private:
+  std::vector<std::unique_ptr<tango_gl::Transform>> transforms_;
+};
+
+void BM_TransformChainCached(tango_benchmark::State* state) {
+  TransformChain chain;
+  while (state->KeepRunning()) {
+    tango_benchmark::DoNotOptimize(chain.GetLeaf()->GetTransformationMatrix());
+  }
+  state->SetBytesProcessed(state->iterations() * sizeof(glm::mat4));
+}
+TANGO_BENCHMARK(BM_TransformChainCached);
+
+void BM_TransformChainRootMoved(tango_benchmark::State* state) {
+  TransformChain chain;
+  float x = 0.0f;
+  while (state->KeepRunning()) {
+    x += 0.001f;
+    chain.GetRoot()->SetPosition(glm::vec3(x, 0.0f, 0.0f));
+    tango_benchmark::DoNotOptimize(chain.GetLeaf()->GetTransformationMatrix());
+  }
+  state->SetBytesProcessed(state->iterations() * kChainLength *
+                           sizeof(glm::mat4));
+}
+TANGO_BENCHMARK(BM_TransformChainRootMoved);
+
+void BM_TransformChainLeafMoved(tango_benchmark::State* state) {
+  TransformChain chain;
+  float x = 0.0f;
+  while (state->KeepRunning()) {
+    x += 0.001f;
+    chain.GetLeaf()->SetPosition(glm::vec3(x, 0.0f, 0.0f));
+    tango_benchmark::DoNotOptimize(chain.GetLeaf()->GetTransformationMatrix());
+  }
+  state->SetBytesProcessed(state->iterations() * sizeof(glm::mat4));
+}
+TANGO_BENCHMARK(BM_TransformChainLeafMoved);
+
+// A matrix set directly, as the examples do with tracked poses.
+void BM_TransformChainRootMatrixSet(tango_benchmark::State* state) {
+  TransformChain chain;
+  float x = 0.0f;
+  while (state->KeepRunning()) {
+    x += 0.001f;
+    chain.GetRoot()->SetTransformationMatrix(
+        glm::translate(glm::mat4(1.0f), glm::vec3(x, 0.0f, 0.0f)));
+    tango_benchmark::DoNotOptimize(chain.GetLeaf()->GetTransformationMatrix());
+  }
+  state->SetBytesProcessed(state->iterations() * kChainLength *
+                           sizeof(glm::mat4));
+}
+TANGO_BENCHMARK(BM_TransformChainRootMatrixSet);
+
+// Largest difference between simd_math::Multiply() and the scalar glm
+// product over random matrices, in float epsilons relative to the magnitude
+// of the terms summed into each element. The outputs alias the left and
+// right operands in turn, as Transform does.
+float GetMaxMultiplyError() {
+  std::minstd_rand random(53);
+  std::uniform_real_distribution<float> element(-10.0f, 10.0f);
+  float max_error = 0.0f;
+  for (int k = 0; k < 1000; ++k) {
+    glm::mat4 a;
+    glm::mat4 b;
+    for (int column = 0; column < 4; ++column) {
+      for (int row = 0; row < 4; ++row) {
+        a[column][row] = element(random);
+        b[column][row] = element(random);
+      }
+    }
+    const glm::mat4 expected = a * b;
+    glm::mat4 products[3];
+    products[0] = tango_gl::simd_math::Multiply(a, b);
+    products[1] = a;
+    tango_gl::simd_math::Multiply(products[1], b, &products[1]);
+    products[2] = b;
+    tango_gl::simd_math::Multiply(a, products[2], &products[2]);
+    for (int column = 0; column < 4; ++column) {
+      for (int row = 0; row < 4; ++row) {
+        float magnitude = std::numeric_limits<float>::min();
+        for (int i = 0; i < 4; ++i) {
+          magnitude += std::fabs(a[i][row] * b[column][i]);
+        }
+        for (const glm::mat4& product : products) {
+          const float error =
+              std::fabs(product[column][row] - expected[column][row]) /
+              (magnitude * std::numeric_limits<float>::epsilon());
+          if (std::isnan(error)) {
+            return error;
+          }
+          max_error = std::max(max_error, error);
+        }
+      }
+    }
+  }
+  return max_error;
+}
+
+// Float epsilons the SIMD products may differ by, they sum the terms in
+// another order than glm.
+const float kMaxMultiplyError = 4.0f;
+
+// A model-view-projection product, scalar glm against simd_math, which is the
+// scalar path too unless built with TANGO_GL_SIMD_MATH. The SIMD benchmark
+// checks the products match the scalar ones first, so a wrong fast path
+// does not pass for a speedup.
+void BM_MatrixMultiplyScalar(tango_benchmark::State* state) {
+  glm::mat4 view = glm::lookAt(glm::vec3(1.0f, 2.0f, 3.0f), glm::vec3(0.0f),
+                               glm::vec3(0.0f, 1.0f, 0.0f));
+  glm::mat4 projection = glm::perspective(45.0f, 1.5f, 0.1f, 100.0f);
+  glm::mat4 model(1.0f);
+  while (state->KeepRunning()) {
+    model[3][0] += 0.001f;
+    tango_benchmark::DoNotOptimize(projection * view * model);
+  }
+  state->SetBytesProcessed(state->iterations() * 3 * sizeof(glm::mat4));
+}
+TANGO_BENCHMARK(BM_MatrixMultiplyScalar);
+
+void BM_MatrixMultiplySimd(tango_benchmark::State* state) {
+  glm::mat4 view = glm::lookAt(glm::vec3(1.0f, 2.0f, 3.0f), glm::vec3(0.0f),
+                               glm::vec3(0.0f, 1.0f, 0.0f));
+  glm::mat4 projection = glm::perspective(45.0f, 1.5f, 0.1f, 100.0f);
+  glm::mat4 model(1.0f);
+  if (!(GetMaxMultiplyError() <= kMaxMultiplyError)) {
+    state->SkipWithError("SIMD products differ from the scalar ones");
+    return;
+  }
+  while (state->KeepRunning()) {
+    model[3][0] += 0.001f;
+    tango_benchmark::DoNotOptimize(tango_gl::simd_math::Multiply(
+        tango_gl::simd_math::Multiply(projection, view), model));
+  }
+  state->SetBytesProcessed(state->iterations() * 3 * sizeof(glm::mat4));
+}
+TANGO_BENCHMARK(BM_MatrixMultiplySimd);
+
+// opengl_world_T_tango_world * pose * device_T_opengl_camera, the per frame
+// pose conversion of the examples, with the frame conventions as matrices
+// and as compile time axis permutations.
+void BM_PoseConversionMatrices(tango_benchmark::State* state) {
+  glm::mat4 pose = glm::translate(glm::mat4(1.0f), glm::vec3(1.0f, 2.0f, 3.0f));
+  const glm::mat4 device_T_color = glm::mat4(1.0f);
+  while (state->KeepRunning()) {
+    pose[3][0] += 0.001f;
+    tango_benchmark::DoNotOptimize(
+        tango_gl::conversions::opengl_world_T_tango_world() * pose *
+        (device_T_color *
+         tango_gl::conversions::color_camera_T_opengl_camera()));
+  }
+  state->SetBytesProcessed(state->iterations() * sizeof(glm::mat4));
+}
+TANGO_BENCHMARK(BM_PoseConversionMatrices);
+
+void BM_PoseConversionPermutations(tango_benchmark::State* state) {
+  glm::mat4 pose = glm::translate(glm::mat4(1.0f), glm::vec3(1.0f, 2.0f, 3.0f));
+  const glm::mat4 device_T_color = glm::mat4(1.0f);
+  while (state->KeepRunning()) {
+    pose[3][0] += 0.001f;
+    tango_benchmark::DoNotOptimize(
+        (tango_gl::conversions::OpenGlWorldTTangoWorld() * pose) *
+        (device_T_color * tango_gl::conversions::CameraTOpenGlCamera()));
+  }
+  state->SetBytesProcessed(state->iterations() * sizeof(glm::mat4));
+}
+TANGO_BENCHMARK(BM_PoseConversionPermutations);
+
+// Poses between consecutive 100Hz poses of a device turning at about 90
+// degrees per second, one glm::slerp each against the batched lerp.
+void MakePosePairs(std::vector<tango_gl::RigidTransform>* before,
+                   std::vector<tango_gl::RigidTransform>* after,
+                   std::vector<float>* weights) {
+  const glm::vec3 axis = glm::normalize(glm::vec3(0.2f, 1.0f, 0.1f));
+  for (size_t i = 0; i < kPoseCount; ++i) {
+    const float angle = 0.015f * i;
+    before->emplace_back(glm::angleAxis(angle, axis),
+                         glm::vec3(0.01f * i, 0.0f, 1.0f));
+    after->emplace_back(glm::angleAxis(angle + 0.015f, axis),
+                        glm::vec3(0.01f * i + 0.01f, 0.0f, 1.0f));
+    weights->push_back((i % 10) / 10.0f);
+  }
+}
+
+void BM_PoseSlerp(tango_benchmark::State* state) {
+  std::vector<tango_gl::RigidTransform> before;
+  std::vector<tango_gl::RigidTransform> after;
+  std::vector<float> weights;
+  MakePosePairs(&before, &after, &weights);
+  std::vector<tango_gl::RigidTransform> poses(kPoseCount);
+  while (state->KeepRunning()) {
+    for (size_t i = 0; i < kPoseCount; ++i) {
+      poses[i] = tango_gl::RigidTransform(
+          glm::slerp(before[i].GetRotation(), after[i].GetRotation(),
+                     weights[i]),
+          glm::mix(before[i].GetTranslation(), after[i].GetTranslation(),
+                   weights[i]));
+    }
+    tango_benchmark::DoNotOptimize(poses.data());
+  }
+  state->SetBytesProcessed(state->iterations() * kPoseCount *
+                           sizeof(tango_gl::RigidTransform));
+}
+TANGO_BENCHMARK(BM_PoseSlerp);
+
+void BM_PoseInterpolateBatch(tango_benchmark::State* state) {
+  std::vector<tango_gl::RigidTransform> before;
+  std::vector<tango_gl::RigidTransform> after;
+  std::vector<float> weights;
+  MakePosePairs(&before, &after, &weights);
+  std::vector<tango_gl::RigidTransform> poses(kPoseCount);
+  while (state->KeepRunning()) {
+    tango_gl::pose_interpolation::Interpolate(before.data(), after.data(),
+                                              weights.data(), kPoseCount,
+                                              poses.data());
+    tango_benchmark::DoNotOptimize(poses.data());
+  }
+  state->SetBytesProcessed(state->iterations() * kPoseCount *
+                           sizeof(tango_gl::RigidTransform));
+}
+TANGO_BENCHMARK(BM_PoseInterpolateBatch);
+}  // namespace
@@ -0,0 +1,179 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// Color camera image conversion, as done by VideoOverlayApp::RenderYUV(), the
+// per point color lookup of the point cloud example and the vision stages
+// running on the Y plane.
+
+#include <tango-gl/corner_detector.h>
+#include <tango-gl/luminance_pyramid.h>
+#include <tango-gl/point_colorizer.h>
+#include <tango-gl/yuv_converter.h>
+
+#include "tango-benchmarks/benchmark.h"
+#include "tango-benchmarks/inputs.h"
+#include "tango-video-overlay/yuv_drawable.h"
+
+namespace {
+void BM_ConvertNV21ToRGB(tango_benchmark::State* state) {
+  const std::vector<uint8_t>& nv21 = tango_benchmark::inputs::GetColorImage();
+  const int width = tango_benchmark::inputs::GetColorImageWidth();
+  const int height = tango_benchmark::inputs::GetColorImageHeight();
+  std::vector<uint8_t> rgb(width * height * 3);
+  while (state->KeepRunning()) {
+    tango_gl::yuv::ConvertNV21ToRGB(nv21.data(), width, height, rgb.data());
+    tango_benchmark::ClobberMemory();
+  }
+  state->SetBytesProcessed(state->iterations() * (nv21.size() + rgb.size()));
+}
+TANGO_BENCHMARK(BM_ConvertNV21ToRGB);
+
+// The preview mode of VideoOverlayApp::RenderYUV().
+void BM_ConvertNV21ToHalfRGB(tango_benchmark::State* state) {
+  const std::vector<uint8_t>& nv21 = tango_benchmark::inputs::GetColorImage();
+  const int width = tango_benchmark::inputs::GetColorImageWidth();
+  const int height = tango_benchmark::inputs::GetColorImageHeight();
+  std::vector<uint8_t> rgb((width / 2) * (height / 2) * 3);
+  while (state->KeepRunning()) {
+    tango_gl::yuv::ConvertNV21ToHalfRGB(nv21.data(), width, height,
+                                        rgb.data());
+    tango_benchmark::ClobberMemory();
+  }
+  state->SetBytesProcessed(state->iterations() * rgb.size());
+}
+TANGO_BENCHMARK(BM_ConvertNV21ToHalfRGB);
+
+// A 256x256 region around the image center, e.g. around a tracked anchor.
+void BM_ConvertNV21RegionToRGB(tango_benchmark::State* state) {
+  const std::vector<uint8_t>& nv21 = tango_benchmark::inputs::GetColorImage();
+  const int width = tango_benchmark::inputs::GetColorImageWidth();
+  const int height = tango_benchmark::inputs::GetColorImageHeight();
+  const int region_size = 256;
+  std::vector<uint8_t> rgb(region_size * region_size * 3);
+  while (state->KeepRunning()) {
+    tango_gl::yuv::ConvertNV21RegionToRGB(
+        nv21.data(), width, height, (width - region_size) / 2,
+        (height - region_size) / 2, region_size, region_size, rgb.data());
+    tango_benchmark::ClobberMemory();
+  }
+  state->SetBytesProcessed(state->iterations() * rgb.size());
+}
+TANGO_BENCHMARK(BM_ConvertNV21RegionToRGB);
+
+// The pyramid a CameraStream builds for vision consumers of the color camera.
+void BM_BuildLuminancePyramid(tango_benchmark::State* state) {
+  const std::vector<uint8_t>& nv21 = tango_benchmark::inputs::GetColorImage();
+  const int width = tango_benchmark::inputs::GetColorImageWidth();
+  const int height = tango_benchmark::inputs::GetColorImageHeight();
+  tango_gl::LuminancePyramid pyramid;
+  while (state->KeepRunning()) {
+    pyramid.Build(nv21.data(), width, height, width,
+                  tango_gl::LuminancePyramid::kMaxLevelCount);
+    tango_benchmark::ClobberMemory();
+  }
+  state->SetBytesProcessed(state->iterations() * width * height);
+}
+TANGO_BENCHMARK(BM_BuildLuminancePyramid);
+
+// FAST-9 corners on every pyramid level, with the default bucketing.
+void BM_DetectCorners(tango_benchmark::State* state) {
+  const std::vector<uint8_t>& nv21 = tango_benchmark::inputs::GetColorImage();
+  const int width = tango_benchmark::inputs::GetColorImageWidth();
+  const int height = tango_benchmark::inputs::GetColorImageHeight();
+  tango_gl::LuminancePyramid pyramid;
+  pyramid.Build(nv21.data(), width, height, width,
+                tango_gl::LuminancePyramid::kMaxLevelCount);
+  tango_gl::CornerDetector detector{tango_gl::CornerDetector::Options()};
+  const std::vector<tango_gl::CornerDetector::Roi> whole_image;
+  std::vector<tango_gl::CornerDetector::Corner> corners;
+  while (state->KeepRunning()) {
+    corners.clear();
+    for (int level = 0; level < pyramid.GetLevelCount(); ++level) {
+      detector.Detect(pyramid, level, whole_image, &corners);
+    }
+    tango_benchmark::ClobberMemory();
+  }
+  state->SetBytesProcessed(state->iterations() * width * height);
+}
+TANGO_BENCHMARK(BM_DetectCorners);
+
+// Coloring a depth frame, as done by PointCloudData::UpdateColors().
+void BM_ColorizePoints(tango_benchmark::State* state) {
+  const std::vector<uint8_t>& nv21 = tango_benchmark::inputs::GetColorImage();
+  const std::vector<float>& points = tango_benchmark::inputs::GetPointCloud();
+  const TangoCameraIntrinsics& color_intrinsics =
+      tango_benchmark::inputs::GetColorIntrinsics();
+  tango_gl::projection::CameraIntrinsics intrinsics;
+  intrinsics.width = color_intrinsics.width;
+  intrinsics.height = color_intrinsics.height;
+  intrinsics.fx = color_intrinsics.fx;
+  intrinsics.fy = color_intrinsics.fy;
+  intrinsics.cx = color_intrinsics.cx;
+  intrinsics.cy = color_intrinsics.cy;
+  glm::mat4 color_T_depth = tango_benchmark::inputs::GetColorTDepth();
+  const size_t point_count = points.size() / 3;
+  std::vector<tango_gl::ColoredPoint> colored_points(point_count);
+  tango_gl::PointColorizer colorizer;
+  while (state->KeepRunning()) {
+    colorizer.Colorize(points.data(), point_count, color_T_depth, intrinsics,
+                       nv21.data(), colored_points.data());
+    tango_benchmark::ClobberMemory();
+  }
+  state->SetBytesProcessed(state->iterations() * points.size() *
+                           sizeof(float));
+}
+TANGO_BENCHMARK(BM_ColorizePoints);
+
+// Conversion into the texture upload buffer, upload and draw, finished so
+// the GPU time is included.
+void BM_RenderYUV(tango_benchmark::State* state) {
+  const std::vector<uint8_t>& nv21 = tango_benchmark::inputs::GetColorImage();
+  const int width = tango_benchmark::inputs::GetColorImageWidth();
+  const int height = tango_benchmark::inputs::GetColorImageHeight();
+  tango_video_overlay::YUVDrawable drawable;
+  drawable.SetTextureFormat(tango_video_overlay::YUVDrawable::kRGB);
+  while (state->KeepRunning()) {
+    uint8_t* rgb = drawable.BeginRGBUpdate(width, height);
+    if (rgb == nullptr) {
+      state->SkipWithError("BeginRGBUpdate() failed");
+      break;
+    }
+    tango_gl::yuv::ConvertNV21ToRGB(nv21.data(), width, height, rgb);
+    drawable.EndRGBUpdate();
+    drawable.Render(glm::mat4(1.0f), glm::mat4(1.0f));
+    glFinish();
+  }
+  state->SetBytesProcessed(state->iterations() * nv21.size() * 3);
+}
+TANGO_BENCHMARK_GL(BM_RenderYUV);
+
+// The alternative path, uploading the planes for conversion in the shader.
+void BM_RenderNV21Shader(tango_benchmark::State* state) {
+  const std::vector<uint8_t>& nv21 = tango_benchmark::inputs::GetColorImage();
+  const int width = tango_benchmark::inputs::GetColorImageWidth();
+  const int height = tango_benchmark::inputs::GetColorImageHeight();
+  tango_video_overlay::YUVDrawable drawable;
+  drawable.SetTextureFormat(tango_video_overlay::YUVDrawable::kNV21);
+  while (state->KeepRunning()) {
+    drawable.UpdateNV21(nv21.data(), width, height);
+    drawable.Render(glm::mat4(1.0f), glm::mat4(1.0f));
+    glFinish();
+  }
+  state->SetBytesProcessed(state->iterations() * nv21.size());
+}
+TANGO_BENCHMARK_GL(BM_RenderNV21Shader);
+}  // namespace
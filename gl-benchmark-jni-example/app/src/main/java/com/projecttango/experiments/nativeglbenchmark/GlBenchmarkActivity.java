@@ -0,0 +1,79 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package com.projecttango.experiments.nativeglbenchmark;
+
+import android.app.Activity;
+import android.opengl.GLSurfaceView;
+import android.os.Bundle;
+import android.util.Log;
+import android.view.WindowManager;
+import android.widget.Toast;
+
+import java.io.File;
+
+/**
+ * Sweeps the synthetic rendering workloads of the native GlBenchmarkApp and
+ * writes their CPU submit and GPU times to gl_benchmark.csv in the external
+ * files directory of the application. Pausing the activity restarts the
+ * sweep.
+ */
+public class GlBenchmarkActivity extends Activity {
+    private static final String TAG = GlBenchmarkActivity.class.getSimpleName();
+
+    private GLSurfaceView mGLView;
+
+    @Override
+    protected void onCreate(Bundle savedInstanceState) {
+        super.onCreate(savedInstanceState);
+        // The display must stay on, the sweep takes a few minutes.
+        getWindow().addFlags(WindowManager.LayoutParams.FLAG_KEEP_SCREEN_ON);
+
+        setContentView(R.layout.activity_gl_benchmark);
+        File output = new File(getExternalFilesDir(null), "gl_benchmark.csv");
+        TangoJNINative.setOutputPath(output.getAbsolutePath());
+
+        mGLView = (GLSurfaceView) findViewById(R.id.gl_surface_view);
+        mGLView.setEGLContextClientVersion(2);
+        mGLView.setRenderer(new GlBenchmarkRenderer(this));
+    }
+
+    @Override
+    protected void onResume() {
+        super.onResume();
+        mGLView.onResume();
+    }
+
+    @Override
+    protected void onPause() {
+        super.onPause();
+        mGLView.onPause();
+    }
+
+    /** Called on the GL thread once the results are written. */
+    void onSweepFinished() {
+        final String path =
+                new File(getExternalFilesDir(null), "gl_benchmark.csv").getAbsolutePath();
+        Log.i(TAG, "Sweep finished, results in " + path);
+        runOnUiThread(new Runnable() {
+            @Override
+            public void run() {
+                Toast.makeText(GlBenchmarkActivity.this,
+                        getString(R.string.results_written, path), Toast.LENGTH_LONG).show();
+            }
+        });
+    }
+}
@@ -0,0 +1,34 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package com.projecttango.experiments.nativeglbenchmark;
+
+public class TangoJNINative {
+    static {
+        System.loadLibrary("gl_benchmark_jni_example");
+    }
+
+    public static native void setOutputPath(String path);
+
+    public static native void initGlContent();
+
+    public static native void setupGraphic(int width, int height);
+
+    // Returns false once the sweep has ended and the results are written.
+    public static native boolean render();
+
+    public static native void freeGLContent();
+}
@@ -0,0 +1,96 @@
+#
+# Copyright 2015 Google Inc. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+
+# GL throughput benchmark, an application sweeping synthetic tango-gl
+# workloads and writing a CSV of their CPU submit and GPU times:
+#
+#   adb pull /sdcard/Android/data/com.projecttango.experiments.nativeglbenchmark/files/gl_benchmark.csv
+#
+# The same sweep runs on a desktop with host/CMakeLists.txt's gl_benchmark.
+
+LOCAL_PATH := $(call my-dir)
+PROJECT_ROOT_FROM_JNI:= ../../../../..
+PROJECT_ROOT:= $(call my-dir)/../../../../..
+POINT_CLOUD_JNI := $(PROJECT_ROOT_FROM_JNI)/point-cloud-jni-example/app/src/main/jni
+VIDEO_OVERLAY_JNI := $(PROJECT_ROOT_FROM_JNI)/video-overlay-jni-example/app/src/main/jni
+
+include $(CLEAR_VARS)
+LOCAL_MODULE    := libgl_benchmark_jni_example
+LOCAL_STATIC_LIBRARIES := cpufeatures
+LOCAL_CFLAGS    := -Werror -std=c++11
+# Per frame matrix math on NEON, part of the arm64-v8a baseline. armeabi-v7a
+# keeps the scalar glm path, see tango-gl/simd_math.h.
+ifeq ($(TARGET_ARCH_ABI),arm64-v8a)
+LOCAL_CFLAGS    += -DTANGO_GL_SIMD_MATH
+endif
+
+# Only the API headers are needed, nothing calls into the service.
+LOCAL_C_INCLUDES := $(LOCAL_PATH) \
+                    $(PROJECT_ROOT)/tango_client_api/include \
+                    $(PROJECT_ROOT)/tango-gl/include \
+                    $(PROJECT_ROOT)/third-party/glm/ \
+                    $(LOCAL_PATH)/$(POINT_CLOUD_JNI) \
+                    $(LOCAL_PATH)/$(VIDEO_OVERLAY_JNI)
+
+LOCAL_SRC_FILES := gl_benchmark_app.cc \
+                   jni_interface.cc \
+                   workloads.cc \
+                   $(POINT_CLOUD_JNI)/point_cloud_drawable.cc \
+                   $(VIDEO_OVERLAY_JNI)/yuv_drawable.cc \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/axis.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/bounding_box.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/bvh.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/counters.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/cube.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/drawable_object.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/frame_arena.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/frame_constants.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/frame_profiler.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/geometry_registry.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/line.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/memory_tracker.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/mesh.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/obj_loader.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/occlusion_culler.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/point_projection.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/program_cache.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/render_state.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/shader_variants.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/shaders.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/streaming_texture.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/transform.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/util.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/vertex_array.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/vertex_buffer.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/view_frustum.cpp
+
+# The NEON kernel is built with NEON enabled and selected at runtime, so the
+# library still runs on armeabi-v7a devices without NEON. arm64-v8a always
+# has NEON and needs no .neon suffix.
+TANGO_GL_NEON_SOURCES := $(PROJECT_ROOT_FROM_JNI)/tango-gl/point_projection_neon.cpp
+ifeq ($(TARGET_ARCH_ABI),armeabi-v7a)
+LOCAL_CFLAGS    += -DTANGO_GL_HAS_NEON
+LOCAL_SRC_FILES += $(addsuffix .neon,$(TANGO_GL_NEON_SOURCES))
+endif
+ifeq ($(TARGET_ARCH_ABI),arm64-v8a)
+LOCAL_CFLAGS    += -DTANGO_GL_HAS_NEON
+LOCAL_SRC_FILES += $(TANGO_GL_NEON_SOURCES)
+endif
+
+LOCAL_LDLIBS    := -llog -lGLESv2 -lEGL -L$(SYSROOT)/usr/lib
+include $(BUILD_SHARED_LIBRARY)
+
+$(call import-module,android/cpufeatures)
@@ -0,0 +1,223 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "tango-gl-benchmark/gl_benchmark_app.h"
+
+#include <algorithm>
+#include <cstdio>
+
+#include <tango-gl/render_state.h>
+
+namespace {
+// Zones of the timed frames.
+const char* const kSubmitZone = "submit";
+const char* const kGpuZone = "gpu";
+
+// Frames rendered after the timed ones at most, for their GPU timings to come
+// back before the case is released.
+const int kMaxDrainFrameCount = 30;
+
+// Field of view of the camera, vertical, in radians.
+const float kFieldOfView = 1.0f;
+}  // namespace
+
+namespace tango_gl_benchmark {
+
+GlBenchmarkApp::GlBenchmarkApp(const Options& options)
+    : options_(options),
+      gl_context_(EGL_NO_CONTEXT),
+      current_workload_(0),
+      current_size_(0),
+      is_case_set_up_(false),
+      is_finished_(false),
+      case_frame_(0),
+      drain_frame_(0),
+      viewport_width_(1),
+      viewport_height_(1),
+      projection_mat_(1.0f) {}
+
+GlBenchmarkApp::~GlBenchmarkApp() {}
+
+void GlBenchmarkApp::InitializeGLContent() {
+  const EGLContext context = eglGetCurrentContext();
+  if (!workloads_.empty() && context == gl_context_) {
+    return;
+  }
+  // The objects of a lost context are gone. Nothing has been allocated in the
+  // new context yet, so deleting their stale ids is a no-op.
+  FreeGLContent();
+  profiler_.Invalidate();
+  gl_context_ = context;
+
+  // Anything RenderState remembers belongs to the previous GL context.
+  tango_gl::RenderState::Invalidate();
+
+  const GLubyte* renderer = glGetString(GL_RENDERER);
+  renderer_ = renderer != nullptr ? reinterpret_cast<const char*>(renderer)
+                                  : "unknown";
+  workloads_ = CreateWorkloads();
+  results_.clear();
+  current_workload_ = 0;
+  current_size_ = 0;
+  is_finished_ = false;
+  LOGI("GlBenchmarkApp: sweep started on %s.", renderer_.c_str());
+}
+
+void GlBenchmarkApp::SetViewPort(int width, int height) {
+  viewport_width_ = width;
+  viewport_height_ = height;
+  projection_mat_ = glm::perspective(
+      kFieldOfView, static_cast<float>(width) / std::max(height, 1), 0.1f,
+      100.0f);
+}
+
+bool GlBenchmarkApp::Render() {
+  if (is_finished_ || workloads_.empty()) {
+    return false;
+  }
+  tango_gl::RenderState::BeginFrame();
+  profiler_.BeginFrame();
+  if (!is_case_set_up_) {
+    StartCase();
+  }
+
+  glViewport(0, 0, viewport_width_, viewport_height_);
+  tango_gl::RenderState::Enable(GL_DEPTH_TEST);
+  glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+  glClear(GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT);
+
+  Workload* workload = workloads_[current_workload_].get();
+  const glm::mat4 view_mat(1.0f);
+  const int timed_end =
+      options_.warmup_frame_count + options_.measured_frame_count;
+  if (case_frame_ >= options_.warmup_frame_count && case_frame_ < timed_end) {
+    profiler_.BeginCpuZone(kSubmitZone);
+    profiler_.BeginGpuZone(kGpuZone);
+    workload->Render(projection_mat_, view_mat, case_frame_);
+    profiler_.EndGpuZone();
+    profiler_.EndCpuZone();
+  } else {
+    workload->Render(projection_mat_, view_mat, case_frame_);
+  }
+  ++case_frame_;
+
+  if (case_frame_ > timed_end) {
+    // The GPU timings of the last frames are read back a few frames late.
+    size_t gpu_sample_count = 0;
+    profiler_.GetGpuPercentile(kGpuZone, 0.5f, &gpu_sample_count);
+    if (!profiler_.HasGpuTimers() ||
+        gpu_sample_count >=
+            static_cast<size_t>(options_.measured_frame_count) ||
+        ++drain_frame_ > kMaxDrainFrameCount) {
+      FinishCase();
+    }
+  }
+  return true;
+}
+
+void GlBenchmarkApp::FreeGLContent() {
+  if (is_case_set_up_) {
+    workloads_[current_workload_]->Release();
+    is_case_set_up_ = false;
+  }
+  profiler_.Release();
+  gl_context_ = EGL_NO_CONTEXT;
+}
+
+std::string GlBenchmarkApp::GetCsv() const {
+  std::string csv =
+      "renderer,workload,size_name,size,frames,cpu_p50_ms,cpu_p99_ms,"
+      "gpu_p50_ms,gpu_p99_ms\n";
+  for (const Result& result : results_) {
+    char line[256];
+    if (result.has_gpu_times) {
+      snprintf(line, sizeof(line), ",%s,%s,%d,%zu,%.4f,%.4f,%.4f,%.4f\n",
+               result.workload.c_str(), result.size_name.c_str(), result.size,
+               result.frame_count, result.cpu_p50, result.cpu_p99,
+               result.gpu_p50, result.gpu_p99);
+    } else {
+      snprintf(line, sizeof(line), ",%s,%s,%d,%zu,%.4f,%.4f,,\n",
+               result.workload.c_str(), result.size_name.c_str(), result.size,
+               result.frame_count, result.cpu_p50, result.cpu_p99);
+    }
+    // Renderer strings may hold commas.
+    csv += "\"" + renderer_ + "\"" + line;
+  }
+  return csv;
+}
+
+void GlBenchmarkApp::StartCase() {
+  Workload* workload = workloads_[current_workload_].get();
+  workload->Setup(workload->GetSizes()[current_size_]);
+  profiler_.ClearZone(kSubmitZone);
+  profiler_.ClearZone(kGpuZone);
+  is_case_set_up_ = true;
+  case_frame_ = 0;
+  drain_frame_ = 0;
+}
+
+void GlBenchmarkApp::FinishCase() {
+  Workload* workload = workloads_[current_workload_].get();
+  Result result;
+  result.workload = workload->GetName();
+  result.size_name = workload->GetSizeName();
+  result.size = workload->GetSizes()[current_size_];
+  result.cpu_p50 =
+      profiler_.GetCpuPercentile(kSubmitZone, 0.5f, &result.frame_count);
+  result.cpu_p99 = profiler_.GetCpuPercentile(kSubmitZone, 0.99f, nullptr);
+  size_t gpu_sample_count = 0;
+  result.gpu_p50 =
+      profiler_.GetGpuPercentile(kGpuZone, 0.5f, &gpu_sample_count);
+  result.gpu_p99 = profiler_.GetGpuPercentile(kGpuZone, 0.99f, nullptr);
+  result.has_gpu_times = gpu_sample_count > 0;
+  results_.push_back(result);
+  LOGI("GlBenchmarkApp: %s %d %s, cpu p50 %.3f p99 %.3f ms, gpu p50 %.3f "
+       "p99 %.3f ms.",
+       result.workload.c_str(), result.size, result.size_name.c_str(),
+       result.cpu_p50, result.cpu_p99, result.gpu_p50, result.gpu_p99);
+
+  workload->Release();
+  is_case_set_up_ = false;
+  if (++current_size_ == workload->GetSizes().size()) {
+    current_size_ = 0;
+    ++current_workload_;
+  }
+  if (current_workload_ == workloads_.size()) {
+    is_finished_ = true;
+    WriteCsv();
+  }
+}
+
+void GlBenchmarkApp::WriteCsv() const {
+  const std::string csv = GetCsv();
+  if (output_path_.empty()) {
+    LOGI("GlBenchmarkApp: results\n%s", csv.c_str());
+    return;
+  }
+  FILE* file = fopen(output_path_.c_str(), "w");
+  if (file == nullptr) {
+    LOGE("GlBenchmarkApp: could not create %s.", output_path_.c_str());
+    return;
+  }
+  if (fwrite(csv.data(), 1, csv.size(), file) != csv.size()) {
+    LOGE("GlBenchmarkApp: could not write %s.", output_path_.c_str());
+  }
+  fclose(file);
+  LOGI("GlBenchmarkApp: results written to %s.", output_path_.c_str());
+}
+
+}  // namespace tango_gl_benchmark
@@ -0,0 +1,69 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#define GLM_FORCE_RADIANS
+
+#include <jni.h>
+#include <tango-gl/jni_natives.h>
+#include <tango-gl-benchmark/gl_benchmark_app.h>
+
+namespace {
+tango_gl_benchmark::GlBenchmarkApp app;
+
+void SetOutputPath(JNIEnv* env, jobject, jstring path) {
+  const char* path_chars = env->GetStringUTFChars(path, nullptr);
+  app.SetOutputPath(path_chars);
+  env->ReleaseStringUTFChars(path, path_chars);
+}
+
+void InitGlContent(JNIEnv*, jobject) {
+  app.InitializeGLContent();
+}
+
+void SetupGraphic(JNIEnv*, jobject, jint width, jint height) {
+  app.SetViewPort(width, height);
+}
+
+jboolean Render(JNIEnv*, jobject) {
+  return app.Render();
+}
+
+void FreeGLContent(JNIEnv*, jobject) {
+  app.FreeGLContent();
+}
+
+const JNINativeMethod kNativeMethods[] = {
+    {"setOutputPath", "(Ljava/lang/String;)V",
+     reinterpret_cast<void*>(SetOutputPath)},
+    {"initGlContent", "()V", reinterpret_cast<void*>(InitGlContent)},
+    {"setupGraphic", "(II)V", reinterpret_cast<void*>(SetupGraphic)},
+    {"render", "()Z", reinterpret_cast<void*>(Render)},
+    {"freeGLContent", "()V", reinterpret_cast<void*>(FreeGLContent)},
+};
+}  // namespace
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+jint JNI_OnLoad(JavaVM* vm, void*) {
+  return tango_gl::jni::RegisterNatives(
+      vm, "com/projecttango/experiments/nativeglbenchmark/TangoJNINative",
+      kNativeMethods);
+}
+#ifdef __cplusplus
+}
+#endif
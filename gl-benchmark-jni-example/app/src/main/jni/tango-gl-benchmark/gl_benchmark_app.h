@@ -0,0 +1,141 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_GL_BENCHMARK_GL_BENCHMARK_APP_H_
+#define TANGO_GL_BENCHMARK_GL_BENCHMARK_APP_H_
+
+#include <EGL/egl.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <tango-gl/frame_profiler.h>
+#include <tango-gl/util.h>
+
+#include "tango-gl-benchmark/workloads.h"
+
+namespace tango_gl_benchmark {
+
+// GlBenchmarkApp measures the driver and GPU side of tango-gl rendering,
+// which the CPU microbenchmarks of benchmarks/jni do not see. It sweeps the
+// sizes of the synthetic workloads of CreateWorkloads(), one case per size:
+// the case is set up, rendered for warmup_frame_count frames, then for
+// measured_frame_count frames timed by a FrameProfiler, the CPU time to
+// submit the GL commands of the workload and the GPU time to execute them
+// when GL_EXT_disjoint_timer_query is available.
+//
+// Once the sweep ends, a CSV line per case is written, with the median and
+// 99th percentile of both times, to compare tango-gl changes and devices:
+//
+//   renderer,workload,size_name,size,frames,cpu_p50_ms,cpu_p99_ms,
+//   gpu_p50_ms,gpu_p99_ms
+//
+// The GPU columns are empty without timer queries. A new GL context, e.g.
+// after the activity was paused, restarts the sweep, as an interrupted case
+// is not comparable.
+//
+// All functions must be called on the GL thread.
+class GlBenchmarkApp {
+ public:
+  struct Options {
+    Options() : warmup_frame_count(30), measured_frame_count(120) {}
+
+    // Frames rendered before the timed ones of a case, for the driver to
+    // settle, e.g. compile shaders and allocate buffers.
+    int warmup_frame_count;
+    // Frames timed per case, at most the 128 samples of a FrameProfiler
+    // window.
+    int measured_frame_count;
+  };
+
+  explicit GlBenchmarkApp(const Options& options = Options());
+  GlBenchmarkApp(const GlBenchmarkApp& other) = delete;
+  const GlBenchmarkApp& operator=(const GlBenchmarkApp&) = delete;
+  ~GlBenchmarkApp();
+
+  // Set the file the CSV is written to when the sweep ends.
+  void SetOutputPath(const std::string& path) { output_path_ = path; }
+
+  // Create the workloads and start the sweep. No-op if the GL context is
+  // the one of the sweep so far.
+  void InitializeGLContent();
+
+  // Set the viewport of the render surface.
+  void SetViewPort(int width, int height);
+
+  // Render a frame of the current case.
+  //
+  // @return false once the sweep has ended and the CSV was written.
+  bool Render();
+
+  // Release the GL resources of the current case.
+  void FreeGLContent();
+
+  // The CSV of the cases measured so far, with its header line.
+  std::string GetCsv() const;
+
+ private:
+  // Result of a case, a line of the CSV.
+  struct Result {
+    std::string workload;
+    std::string size_name;
+    int size;
+    size_t frame_count;
+    float cpu_p50;
+    float cpu_p99;
+    bool has_gpu_times;
+    float gpu_p50;
+    float gpu_p99;
+  };
+
+  // Set up the case of current_workload_ and current_size_.
+  void StartCase();
+
+  // Record the result of the current case, release it and move on to the
+  // next one.
+  void FinishCase();
+
+  // Write the CSV to output_path_ and log it.
+  void WriteCsv() const;
+
+  Options options_;
+  std::string output_path_;
+  EGLContext gl_context_;
+  std::string renderer_;
+
+  std::vector<std::unique_ptr<Workload>> workloads_;
+  size_t current_workload_;
+  size_t current_size_;
+  bool is_case_set_up_;
+  bool is_finished_;
+  // Frames rendered in the current case, and frames waited for its GPU
+  // timings once they were all rendered.
+  int case_frame_;
+  int drain_frame_;
+
+  int viewport_width_;
+  int viewport_height_;
+  glm::mat4 projection_mat_;
+
+  tango_gl::FrameProfiler profiler_;
+  std::vector<Result> results_;
+};
+
+}  // namespace tango_gl_benchmark
+
+#endif  // TANGO_GL_BENCHMARK_GL_BENCHMARK_APP_H_
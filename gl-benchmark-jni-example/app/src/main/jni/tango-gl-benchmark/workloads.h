@@ -0,0 +1,71 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_GL_BENCHMARK_WORKLOADS_H_
+#define TANGO_GL_BENCHMARK_WORKLOADS_H_
+
+#include <memory>
+#include <vector>
+
+#include <tango-gl/util.h>
+
+namespace tango_gl_benchmark {
+
+// A synthetic rendering load whose cost grows with a size, e.g. a number of
+// draws or of points uploaded per frame. The sizes are swept by
+// GlBenchmarkApp, each set up, rendered for a number of frames and released
+// before the next one.
+//
+// All functions except the getters must be called on the GL thread.
+class Workload {
+ public:
+  virtual ~Workload() {}
+
+  // Name of the workload and of its size, the first columns of the CSV.
+  virtual const char* GetName() const = 0;
+  virtual const char* GetSizeName() const = 0;
+
+  // Sizes swept, smallest first.
+  virtual std::vector<int> GetSizes() const = 0;
+
+  // Create the GL resources of a size.
+  virtual void Setup(int size) = 0;
+
+  // Issue the GL commands of a frame. Uploads, e.g. of a point cloud, happen
+  // on every frame.
+  //
+  // @param frame: index of the frame since Setup().
+  virtual void Render(const glm::mat4& projection_mat,
+                      const glm::mat4& view_mat, int frame) = 0;
+
+  // Release the GL resources of the size set up.
+  virtual void Release() = 0;
+};
+
+// The workloads of the sweep, in order:
+//  - "axis", separate Axis draws,
+//  - "cube", separate lit Cube draws,
+//  - "point_cloud", a PointCloudDrawable frame of points uploaded and drawn
+//    with the frames still in its ring,
+//  - "yuv_upload", a NV21 camera image of pixels uploaded and drawn by the
+//    YUVDrawable of the video overlay example,
+//  - "mesh", a single lit Mesh of triangles.
+std::vector<std::unique_ptr<Workload>> CreateWorkloads();
+
+}  // namespace tango_gl_benchmark
+
+#endif  // TANGO_GL_BENCHMARK_WORKLOADS_H_
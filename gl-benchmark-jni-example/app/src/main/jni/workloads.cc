@@ -0,0 +1,259 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "tango-gl-benchmark/workloads.h"
+
+#include <math.h>
+#include <string.h>
+
+#include <tango-gl/axis.h>
+#include <tango-gl/cube.h>
+#include <tango-gl/mesh.h>
+#include <tango-gl/view_frustum.h>
+#include <tango-point-cloud/point_cloud_drawable.h>
+#include <tango-video-overlay/yuv_drawable.h>
+
+namespace {
+// Distance from the camera of the objects, the point cloud and the mesh.
+const float kSceneDistance = 4.0f;
+
+// Width of the area the objects are spread over at kSceneDistance, about the
+// width of the view.
+const float kSceneWidth = 4.0f;
+
+// Separate draws of the same drawable, on a square grid facing the camera.
+class DrawCallWorkload : public tango_gl_benchmark::Workload {
+ public:
+  enum Type { kAxis, kCube };
+
+  explicit DrawCallWorkload(Type type) : type_(type) {}
+
+  const char* GetName() const override {
+    return type_ == kAxis ? "axis" : "cube";
+  }
+  const char* GetSizeName() const override { return "draws"; }
+  std::vector<int> GetSizes() const override {
+    return {16, 64, 256, 1024, 4096};
+  }
+
+  void Setup(int size) override {
+    const int side = static_cast<int>(ceil(sqrt(static_cast<float>(size))));
+    const float spacing = kSceneWidth / side;
+    for (int i = 0; i < size; ++i) {
+      std::unique_ptr<tango_gl::DrawableObject> object;
+      if (type_ == kAxis) {
+        object.reset(new tango_gl::Axis());
+      } else {
+        object.reset(new tango_gl::Cube());
+        object->SetColor(0.2f + 0.6f * (i % side) / side, 0.5f, 0.8f);
+      }
+      object->SetPosition(
+          glm::vec3(((i % side) + 0.5f) * spacing - 0.5f * kSceneWidth,
+                    ((i / side) + 0.5f) * spacing - 0.5f * kSceneWidth,
+                    -kSceneDistance));
+      object->SetScale(glm::vec3(0.4f * spacing));
+      objects_.push_back(std::move(object));
+    }
+  }
+
+  void Render(const glm::mat4& projection_mat, const glm::mat4& view_mat,
+              int frame) override {
+    // Turn the objects so the transforms are rebuilt every frame, like in
+    // an application placing them.
+    const glm::quat rotation =
+        glm::angleAxis(frame * 0.02f, glm::vec3(0.0f, 1.0f, 0.0f));
+    for (std::unique_ptr<tango_gl::DrawableObject>& object : objects_) {
+      object->SetRotation(rotation);
+      object->Render(projection_mat, view_mat);
+    }
+  }
+
+  void Release() override { objects_.clear(); }
+
+ private:
+  Type type_;
+  std::vector<std::unique_ptr<tango_gl::DrawableObject>> objects_;
+};
+
+// A new depth frame every frame, a disc of points in front of the camera.
+class PointCloudWorkload : public tango_gl_benchmark::Workload {
+ public:
+  const char* GetName() const override { return "point_cloud"; }
+  const char* GetSizeName() const override { return "points"; }
+  std::vector<int> GetSizes() const override {
+    return {10000, 30000, 60000, 120000};
+  }
+
+  void Setup(int size) override {
+    drawable_.reset(new tango_point_cloud::PointCloudDrawable());
+    points_.resize(size);
+    for (int i = 0; i < size; ++i) {
+      // Golden angle spiral, evenly spread over the disc.
+      const float radius = 0.5f * kSceneWidth * sqrtf((i + 0.5f) / size);
+      const float angle = i * 2.39996f;
+      tango_gl::QuantizedColoredPoint& point = points_[i];
+      point.x = static_cast<int16_t>(radius * cosf(angle) /
+                                     tango_gl::kQuantizedPointScale);
+      point.y = static_cast<int16_t>(radius * sinf(angle) /
+                                     tango_gl::kQuantizedPointScale);
+      point.z = static_cast<int16_t>(-kSceneDistance /
+                                     tango_gl::kQuantizedPointScale);
+      point.padding = 0;
+      point.r = static_cast<uint8_t>(i * 7);
+      point.g = static_cast<uint8_t>(i * 13);
+      point.b = 200;
+      point.a = 255;
+    }
+  }
+
+  void Render(const glm::mat4& projection_mat, const glm::mat4& view_mat,
+              int frame) override {
+    view_frustum_.Update(projection_mat, view_mat);
+    // A frame is uploaded when its timestamp changes.
+    drawable_->Render(&view_frustum_, projection_mat, view_mat,
+                      glm::mat4(1.0f), frame, points_);
+  }
+
+  void Release() override {
+    drawable_.reset();
+    points_.clear();
+  }
+
+ private:
+  std::unique_ptr<tango_point_cloud::PointCloudDrawable> drawable_;
+  std::vector<tango_gl::QuantizedColoredPoint> points_;
+  tango_gl::ViewFrustum view_frustum_;
+};
+
+// A NV21 image uploaded every frame and converted in the fragment shader, as
+// the video overlay example does with the color camera.
+class YuvUploadWorkload : public tango_gl_benchmark::Workload {
+ public:
+  const char* GetName() const override { return "yuv_upload"; }
+  const char* GetSizeName() const override { return "pixels"; }
+  // Pixels of the color camera resolutions.
+  std::vector<int> GetSizes() const override {
+    return {640 * 480, 1280 * 720, 1920 * 1080};
+  }
+
+  void Setup(int size) override {
+    // 4:3 below 720p, 16:9 from it.
+    height_ = size > 640 * 480 ? static_cast<int>(sqrtf(size * 9.0f / 16.0f))
+                               : static_cast<int>(sqrtf(size * 3.0f / 4.0f));
+    width_ = size / height_;
+    image_.resize(width_ * height_ * 3 / 2);
+    for (size_t i = 0; i < image_.size(); ++i) {
+      image_[i] = static_cast<uint8_t>(i * 31);
+    }
+    drawable_.reset(new tango_video_overlay::YUVDrawable());
+    drawable_->SetTextureFormat(tango_video_overlay::YUVDrawable::kNV21);
+  }
+
+  void Render(const glm::mat4&, const glm::mat4&, int frame) override {
+    // Change a row, so no driver can skip an identical upload.
+    memset(image_.data() + (frame % height_) * width_, frame & 0xff, width_);
+    drawable_->UpdateNV21(image_.data(), width_, height_);
+    drawable_->Render(glm::mat4(1.0f), glm::mat4(1.0f));
+  }
+
+  void Release() override {
+    drawable_.reset();
+    image_.clear();
+  }
+
+ private:
+  std::unique_ptr<tango_video_overlay::YUVDrawable> drawable_;
+  std::vector<uint8_t> image_;
+  int width_;
+  int height_;
+};
+
+// A lit grid of triangles facing the camera, a single draw.
+class MeshWorkload : public tango_gl_benchmark::Workload {
+ public:
+  const char* GetName() const override { return "mesh"; }
+  const char* GetSizeName() const override { return "triangles"; }
+  // The largest keeps its vertices under the 16 bit index limit.
+  std::vector<int> GetSizes() const override {
+    return {2048, 8192, 32768, 115200};
+  }
+
+  void Setup(int size) override {
+    const int quads = static_cast<int>(sqrtf(size / 2.0f) + 0.5f);
+    const int side = quads + 1;
+    std::vector<GLfloat> vertices;
+    std::vector<GLfloat> normals;
+    std::vector<GLushort> indices;
+    for (int y = 0; y < side; ++y) {
+      for (int x = 0; x < side; ++x) {
+        const float u = static_cast<float>(x) / quads;
+        const float v = static_cast<float>(y) / quads;
+        // A gentle wave, so the lighting varies over the grid.
+        const float z = 0.1f * sinf(u * 12.0f) * cosf(v * 12.0f);
+        vertices.insert(vertices.end(), {(u - 0.5f) * kSceneWidth,
+                                         (v - 0.5f) * kSceneWidth, z});
+        const glm::vec3 normal = glm::normalize(
+            glm::vec3(-1.2f * cosf(u * 12.0f) * cosf(v * 12.0f) / kSceneWidth,
+                      1.2f * sinf(u * 12.0f) * sinf(v * 12.0f) / kSceneWidth,
+                      1.0f));
+        normals.insert(normals.end(), {normal.x, normal.y, normal.z});
+      }
+    }
+    for (int y = 0; y < quads; ++y) {
+      for (int x = 0; x < quads; ++x) {
+        const GLushort corner = static_cast<GLushort>(y * side + x);
+        indices.insert(indices.end(),
+                       {corner, static_cast<GLushort>(corner + 1),
+                        static_cast<GLushort>(corner + side),
+                        static_cast<GLushort>(corner + 1),
+                        static_cast<GLushort>(corner + side + 1),
+                        static_cast<GLushort>(corner + side)});
+      }
+    }
+    mesh_.reset(new tango_gl::Mesh());
+    mesh_->SetShader(true);
+    mesh_->SetVertices(vertices, normals, indices);
+    mesh_->SetColor(0.8f, 0.6f, 0.3f);
+    mesh_->SetLightDirection(glm::vec3(-0.5f, -1.0f, -1.0f));
+    mesh_->SetPosition(glm::vec3(0.0f, 0.0f, -kSceneDistance));
+  }
+
+  void Render(const glm::mat4& projection_mat, const glm::mat4& view_mat,
+              int) override {
+    mesh_->Render(projection_mat, view_mat);
+  }
+
+  void Release() override { mesh_.reset(); }
+
+ private:
+  std::unique_ptr<tango_gl::Mesh> mesh_;
+};
+}  // namespace
+
+namespace tango_gl_benchmark {
+
+std::vector<std::unique_ptr<Workload>> CreateWorkloads() {
+  std::vector<std::unique_ptr<Workload>> workloads;
+  workloads.emplace_back(new DrawCallWorkload(DrawCallWorkload::kAxis));
+  workloads.emplace_back(new DrawCallWorkload(DrawCallWorkload::kCube));
+  workloads.emplace_back(new PointCloudWorkload());
+  workloads.emplace_back(new YuvUploadWorkload());
+  workloads.emplace_back(new MeshWorkload());
+  return workloads;
+}
+
+}  // namespace tango_gl_benchmark
@@ -14,6 +14,7 @@
 # limitations under the License.
 #
 LOCAL_PATH := $(call my-dir)
+PROJECT_ROOT_FROM_JNI:= ../../../../..
 PROJECT_ROOT:= $(call my-dir)/../../../../..
 
 include $(CLEAR_VARS)
@@ -21,7 +22,8 @@ LOCAL_MODULE    := libhello_tango_jni_example
 LOCAL_SHARED_LIBRARIES := tango_client_api
 LOCAL_CFLAGS    := -Werror -std=c++11
 LOCAL_SRC_FILES := tango_native.cc \
-                   tango_handler.cc
+                   tango_handler.cc \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/pose_logger.cpp
 LOCAL_C_INCLUDES := $(PROJECT_ROOT)/tango-gl/include \
                     $(PROJECT_ROOT)/third-party/glm/
 LOCAL_LDLIBS    := -llog -lGLESv2 -L$(SYSROOT)/usr/lib
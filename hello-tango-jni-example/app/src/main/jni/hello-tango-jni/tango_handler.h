@@ -19,6 +19,8 @@
 
 #include <android/log.h>
 
+#include <string>
+
 #include "tango_client_api.h"  // NOLINT
 
 #define LOG_TAG "hello-tango-jni"
@@ -40,7 +42,8 @@ class TangoHandler {
   // Setup the configuration file of Tango Service.
   TangoErrorType SetupConfig();
 
-  // Connect the onPoseAvailable callback.
+  // Connect the onPoseAvailable callback, and start logging the poses to
+  // the cache directory of the activity.
   TangoErrorType ConnectPoseCallback();
 
   // Connect to Tango Service.
@@ -49,11 +52,12 @@ class TangoHandler {
   TangoErrorType ConnectService();
 
   // Disconnect from Tango Service, release all the resources that the app is
-  // holding from Tango Service.
+  // holding from Tango Service, and close the pose log.
   void DisconnectService();
 
  private:
   TangoConfig tango_config_;
+  std::string pose_log_path_;
 };
 }  // namespace hello_tango_jni
 
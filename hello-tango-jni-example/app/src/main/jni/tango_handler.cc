@@ -14,14 +14,54 @@
  * limitations under the License.
  */
 
+#include <tango-gl/pose_logger.h>
+
 #include "hello-tango-jni/tango_handler.h"
 
+namespace {
+// Poses kept in the log, about ten minutes at the full pose rate.
+const uint32_t kPoseLogCapacity = 65536;
+
+// Poses are logged in binary, formatting each one for logcat would throttle
+// the callback thread. Pull the file and print it with
+// host/pose_log_decode.
+tango_gl::PoseLogger pose_logger;
+
+// Path of the pose log in the cache directory of the activity, empty if it
+// could not be found.
+std::string GetPoseLogPath(JNIEnv* env, jobject activity) {
+  jclass activity_class = env->GetObjectClass(activity);
+  jmethodID get_cache_dir =
+      env->GetMethodID(activity_class, "getCacheDir", "()Ljava/io/File;");
+  jobject cache_dir = env->CallObjectMethod(activity, get_cache_dir);
+  if (env->ExceptionCheck() || cache_dir == nullptr) {
+    env->ExceptionClear();
+    return std::string();
+  }
+  jclass file_class = env->GetObjectClass(cache_dir);
+  jmethodID get_absolute_path =
+      env->GetMethodID(file_class, "getAbsolutePath", "()Ljava/lang/String;");
+  jstring path = static_cast<jstring>(
+      env->CallObjectMethod(cache_dir, get_absolute_path));
+  if (env->ExceptionCheck() || path == nullptr) {
+    env->ExceptionClear();
+    return std::string();
+  }
+  const char* path_chars = env->GetStringUTFChars(path, nullptr);
+  std::string log_path = std::string(path_chars) + "/poses.bin";
+  env->ReleaseStringUTFChars(path, path_chars);
+
+  env->DeleteLocalRef(path);
+  env->DeleteLocalRef(file_class);
+  env->DeleteLocalRef(cache_dir);
+  env->DeleteLocalRef(activity_class);
+  return log_path;
+}
+}  // namespace
+
 namespace hello_tango_jni {
 static void onPoseAvailable(void*, const TangoPoseData* pose) {
-  LOGI("Position: %f, %f, %f. Orientation: %f, %f, %f, %f",
-       pose->translation[0], pose->translation[1], pose->translation[2],
-       pose->orientation[0], pose->orientation[2], pose->orientation[3],
-       pose->orientation[3]);
+  pose_logger.Log(*pose);
 }
 
 TangoHandler::TangoHandler() : tango_config_(nullptr) {}
@@ -31,6 +71,7 @@ TangoHandler::~TangoHandler() {
 };
 
 TangoErrorType TangoHandler::Initialize(JNIEnv* env, jobject activity) {
+  pose_log_path_ = GetPoseLogPath(env, activity);
   return TangoService_initialize(env, activity);
 }
 
@@ -50,6 +91,12 @@ TangoErrorType TangoHandler::ConnectPoseCallback() {
   TangoCoordinateFramePair pair;
   pair.base = TANGO_COORDINATE_FRAME_START_OF_SERVICE;
   pair.target = TANGO_COORDINATE_FRAME_DEVICE;
+  if (!pose_log_path_.empty() &&
+      pose_logger.Start(pose_log_path_.c_str(), kPoseLogCapacity)) {
+    LOGI("Logging poses to %s", pose_log_path_.c_str());
+  } else {
+    LOGE("Could not start the pose log.");
+  }
   return TangoService_connectOnPoseAvailable(1, &pair, onPoseAvailable);
 }
 
@@ -61,5 +108,10 @@ void TangoHandler::DisconnectService() {
   TangoConfig_free(tango_config_);
   tango_config_ = nullptr;
   TangoService_disconnect();
+  pose_logger.Stop();
+  if (pose_logger.GetDroppedCount() > 0) {
+    LOGE("%llu poses were dropped from the log.",
+         static_cast<unsigned long long>(pose_logger.GetDroppedCount()));
+  }
 }
 }  // namespace hello_tango_jni
@@ -15,43 +15,52 @@
  */
 
 #include <jni.h>
+#include <tango-gl/jni_natives.h>
 
 #include "hello-tango-jni/tango_handler.h"
 
-static hello_tango_jni::TangoHandler tango_handler;
+namespace {
+hello_tango_jni::TangoHandler tango_handler;
 
-#ifdef __cplusplus
-extern "C" {
-#endif
-JNIEXPORT jint JNICALL
-Java_com_projecttango_experiments_nativehellotango_TangoJNINative_initialize(
-    JNIEnv* env, jobject, jobject activity) {
+jint Initialize(JNIEnv* env, jobject, jobject activity) {
   return static_cast<int>(tango_handler.Initialize(env, activity));
 }
 
-JNIEXPORT jint JNICALL
-Java_com_projecttango_experiments_nativehellotango_TangoJNINative_setupConfig(
-    JNIEnv*, jobject) {
+jint SetupConfig(JNIEnv*, jobject) {
   return static_cast<int>(tango_handler.SetupConfig());
 }
 
-JNIEXPORT jint JNICALL
-Java_com_projecttango_experiments_nativehellotango_TangoJNINative_connectCallbacks(
-    JNIEnv*, jobject) {
+jint ConnectCallbacks(JNIEnv*, jobject) {
   return static_cast<int>(tango_handler.ConnectPoseCallback());
 }
 
-JNIEXPORT jint JNICALL
-Java_com_projecttango_experiments_nativehellotango_TangoJNINative_connect(
-    JNIEnv*, jobject) {
+jint Connect(JNIEnv*, jobject) {
   return static_cast<int>(tango_handler.ConnectService());
 }
 
-JNIEXPORT void JNICALL
-Java_com_projecttango_experiments_nativehellotango_TangoJNINative_disconnect(
-    JNIEnv*, jobject) {
+void Disconnect(JNIEnv*, jobject) {
   tango_handler.DisconnectService();
 }
+
+const JNINativeMethod kNativeMethods[] = {
+    {"initialize",
+     "(Lcom/projecttango/experiments/nativehellotango/HelloTangoActivity;)I",
+     reinterpret_cast<void*>(Initialize)},
+    {"setupConfig", "()I", reinterpret_cast<void*>(SetupConfig)},
+    {"connectCallbacks", "()I", reinterpret_cast<void*>(ConnectCallbacks)},
+    {"connect", "()I", reinterpret_cast<void*>(Connect)},
+    {"disconnect", "()V", reinterpret_cast<void*>(Disconnect)},
+};
+}  // namespace
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+jint JNI_OnLoad(JavaVM* vm, void*) {
+  return tango_gl::jni::RegisterNatives(
+      vm, "com/projecttango/experiments/nativehellotango/TangoJNINative",
+      kNativeMethods);
+}
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,302 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "tango_host/example_driver.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+
+#include <tango-gl/conversions.h>
+#include <tango_host/replay.h>
+
+#include "rgb-depth-sync/rgb_depth_sync_application.h"
+#include "tango-motion-tracking/motion_tracking_app.h"
+#include "tango-plane-fitting/plane_fitting_application.h"
+#include "tango-video-overlay/video_overlay_app.h"
+
+// The starter example is a single file of JNI entry points over globals, see
+// starter-jni-example/app/src/main/jni/tango_motion_tracking.cpp.
+#define STARTER_JNI(name) \
+  Java_com_projecttango_experiments_nativemotiontracking_TangoJNINative_##name
+extern "C" {
+jint STARTER_JNI(tangoInitialize)(JNIEnv*, jobject, jobject);
+void STARTER_JNI(tangoSetupConfig)(JNIEnv*, jobject);
+jint STARTER_JNI(tangoConnectCallbacks)(JNIEnv*, jobject);
+jint STARTER_JNI(tangoConnect)(JNIEnv*, jobject);
+void STARTER_JNI(tangoDisconnect)(JNIEnv*, jobject);
+void STARTER_JNI(freeGLContent)(JNIEnv*, jobject);
+void STARTER_JNI(setupGraphic)(JNIEnv*, jobject, jint, jint);
+void STARTER_JNI(render)(JNIEnv*, jobject);
+}
+// Pose of the starter render camera, before its height offset.
+extern glm::vec3 position;
+extern glm::quat rotation;
+
+namespace {
+// Collects the callback durations of the replay thread.
+struct CallbackTimes {
+  std::mutex mutex;
+  tango_host::StageTimes* times;
+};
+
+void OnCallbackTimed(void* context, TangoHostCallbackType type,
+                     double milliseconds) {
+  CallbackTimes* callback_times = static_cast<CallbackTimes*>(context);
+  std::lock_guard<std::mutex> lock(callback_times->mutex);
+  tango_host::StageTimes* times = callback_times->times;
+  switch (type) {
+    case TANGO_HOST_POSE_CALLBACK:
+      times->on_pose.push_back(milliseconds);
+      break;
+    case TANGO_HOST_XYZ_IJ_CALLBACK:
+      times->on_xyz_ij.push_back(milliseconds);
+      break;
+    case TANGO_HOST_FRAME_CALLBACK:
+      times->on_frame.push_back(milliseconds);
+      break;
+  }
+}
+
+// Drives an application through the calls its Java activity makes.
+template <typename Application>
+bool Run(Application* app, tango_gl::OffscreenContext* context, int width,
+         int height, bool (*connect)(Application*),
+         void (*free_gl)(Application*), tango_host::StageTimes* times) {
+  CallbackTimes callback_times;
+  callback_times.times = times;
+  TangoHost_setCallbackTimer(OnCallbackTimed, &callback_times);
+
+  // The JNI replacement answers every call with an exception, so the
+  // applications skip what needs the activity, like the shader cache.
+  JNIEnv env;
+  if (app->TangoInitialize(&env, nullptr) != TANGO_SUCCESS ||
+      !connect(app)) {
+    TangoHost_setCallbackTimer(nullptr, nullptr);
+    fprintf(stderr, "tango_replay: could not connect to the session.\n");
+    return false;
+  }
+  app->InitializeGLContent();
+  app->SetViewPort(width, height);
+  if (!TangoHost_startReplay()) {
+    app->TangoDisconnect();
+    TangoHost_setCallbackTimer(nullptr, nullptr);
+    fprintf(stderr, "tango_replay: could not start the replay.\n");
+    return false;
+  }
+
+  // Frames are rendered back to back. A pbuffer swap neither waits for a
+  // display nor flushes, so the GPU is waited for after each swap; queued
+  // frames would otherwise be rendered in one go, long after being timed.
+  std::vector<double> frame_times;
+  std::vector<double> render_times;
+  std::vector<double> swap_times;
+  while (!TangoHost_isReplayDone()) {
+    auto begin = std::chrono::steady_clock::now();
+    app->Render();
+    auto rendered = std::chrono::steady_clock::now();
+    context->SwapBuffers();
+    glFinish();
+    auto end = std::chrono::steady_clock::now();
+    frame_times.push_back(
+        std::chrono::duration<double, std::milli>(end - begin).count());
+    render_times.push_back(
+        std::chrono::duration<double, std::milli>(rendered - begin).count());
+    swap_times.push_back(
+        std::chrono::duration<double, std::milli>(end - rendered).count());
+  }
+  app->TangoDisconnect();
+  free_gl(app);
+  TangoHost_setCallbackTimer(nullptr, nullptr);
+
+  std::lock_guard<std::mutex> lock(callback_times.mutex);
+  times->frame.insert(times->frame.end(), frame_times.begin(),
+                      frame_times.end());
+  times->render.insert(times->render.end(), render_times.begin(),
+                       render_times.end());
+  times->swap.insert(times->swap.end(), swap_times.begin(), swap_times.end());
+  return true;
+}
+
+bool ConnectSynchronization(rgb_depth_sync::SynchronizationApplication* app) {
+  return app->TangoSetupConfig() == TANGO_SUCCESS &&
+         app->TangoConnectTexture() == TANGO_SUCCESS &&
+         app->TangoConnectCallbacks() == TANGO_SUCCESS &&
+         app->TangoConnect() == TANGO_SUCCESS &&
+         app->TangoSetIntrinsicsAndExtrinsics() == TANGO_SUCCESS;
+}
+
+void FreeSynchronization(rgb_depth_sync::SynchronizationApplication*) {}
+
+bool ConnectPlaneFitting(tango_plane_fitting::PlaneFittingApplication* app) {
+  return app->TangoSetupAndConnect() == TANGO_SUCCESS;
+}
+
+void FreePlaneFitting(tango_plane_fitting::PlaneFittingApplication* app) {
+  app->FreeGLContent();
+}
+
+bool ConnectVideoOverlay(tango_video_overlay::VideoOverlayApp* app) {
+  return app->TangoSetupConfig() == TANGO_SUCCESS &&
+         app->TangoConnect() == TANGO_SUCCESS;
+}
+
+void FreeVideoOverlay(tango_video_overlay::VideoOverlayApp* app) {
+  app->FreeGLContent();
+}
+
+bool ConnectMotionTracking(tango_motion_tracking::MotiongTrackingApp* app) {
+  return app->TangoSetupConfig(false) == TANGO_SUCCESS &&
+         app->TangoConnectCallbacks() == TANGO_SUCCESS &&
+         app->TangoConnect() == TANGO_SUCCESS;
+}
+
+void FreeMotionTracking(tango_motion_tracking::MotiongTrackingApp* app) {
+  app->FreeGLContent();
+}
+
+// Drives the starter example through its JNI entry points. Its Tango calls
+// are left for the reader to write, so the adapter connects to the session
+// itself and moves the starter camera along the replayed device poses.
+class StarterApp {
+ public:
+  StarterApp() : env_(nullptr), config_(nullptr), has_pose_(false) {}
+
+  ~StarterApp() {
+    if (config_ != nullptr) {
+      TangoConfig_free(config_);
+    }
+  }
+
+  int TangoInitialize(JNIEnv* env, jobject caller_activity) {
+    env_ = env;
+    STARTER_JNI(tangoInitialize)(env_, nullptr, caller_activity);
+    return TangoService_initialize(env, caller_activity);
+  }
+
+  bool Connect() {
+    STARTER_JNI(tangoSetupConfig)(env_, nullptr);
+    STARTER_JNI(tangoConnectCallbacks)(env_, nullptr);
+    STARTER_JNI(tangoConnect)(env_, nullptr);
+
+    config_ = TangoService_getConfig(TANGO_CONFIG_DEFAULT);
+    TangoCoordinateFramePair pair;
+    pair.base = TANGO_COORDINATE_FRAME_START_OF_SERVICE;
+    pair.target = TANGO_COORDINATE_FRAME_DEVICE;
+    return TangoService_connectOnPoseAvailable(1, &pair, OnPoseAvailable) ==
+               TANGO_SUCCESS &&
+           TangoService_connect(this, config_) == TANGO_SUCCESS;
+  }
+
+  void InitializeGLContent() {}
+
+  void SetViewPort(int width, int height) {
+    STARTER_JNI(setupGraphic)(env_, nullptr, width, height);
+  }
+
+  void Render() {
+    {
+      std::lock_guard<std::mutex> lock(pose_mutex_);
+      if (has_pose_) {
+        position = tango_gl::conversions::Vec3TangoToGl(
+            tango_gl::conversions::Vec3FromArray(pose_.translation));
+        rotation = tango_gl::conversions::QuatTangoToGl(
+            tango_gl::conversions::QuatFromArray(pose_.orientation));
+      }
+    }
+    STARTER_JNI(render)(env_, nullptr);
+  }
+
+  void TangoDisconnect() {
+    STARTER_JNI(tangoDisconnect)(env_, nullptr);
+    TangoService_disconnect();
+  }
+
+  void FreeGLContent() { STARTER_JNI(freeGLContent)(env_, nullptr); }
+
+ private:
+  static void OnPoseAvailable(void* context, const TangoPoseData* pose) {
+    if (pose->status_code != TANGO_POSE_VALID) {
+      return;
+    }
+    StarterApp* app = static_cast<StarterApp*>(context);
+    std::lock_guard<std::mutex> lock(app->pose_mutex_);
+    app->pose_ = *pose;
+    app->has_pose_ = true;
+  }
+
+  JNIEnv* env_;
+  TangoConfig config_;
+  std::mutex pose_mutex_;
+  TangoPoseData pose_;
+  bool has_pose_;
+};
+
+bool ConnectStarter(StarterApp* app) { return app->Connect(); }
+
+void FreeStarter(StarterApp* app) { app->FreeGLContent(); }
+}  // namespace
+
+namespace tango_host {
+
+const char* const kExampleNames[] = {"rgb-depth-sync", "plane-fitting",
+                                     "video-overlay", "motion-tracking",
+                                     "starter", nullptr};
+
+bool RunExample(const char* example, tango_gl::OffscreenContext* context,
+                int width, int height, StageTimes* times) {
+  TangoHost_setDeferredReplay(true);
+  if (strcmp(example, "rgb-depth-sync") == 0) {
+    rgb_depth_sync::SynchronizationApplication app;
+    return Run(&app, context, width, height, ConnectSynchronization,
+               FreeSynchronization, times);
+  } else if (strcmp(example, "plane-fitting") == 0) {
+    tango_plane_fitting::PlaneFittingApplication app;
+    return Run(&app, context, width, height, ConnectPlaneFitting,
+               FreePlaneFitting, times);
+  } else if (strcmp(example, "video-overlay") == 0) {
+    tango_video_overlay::VideoOverlayApp app;
+    return Run(&app, context, width, height, ConnectVideoOverlay,
+               FreeVideoOverlay, times);
+  } else if (strcmp(example, "motion-tracking") == 0) {
+    tango_motion_tracking::MotiongTrackingApp app;
+    return Run(&app, context, width, height, ConnectMotionTracking,
+               FreeMotionTracking, times);
+  } else if (strcmp(example, "starter") == 0) {
+    StarterApp app;
+    return Run(&app, context, width, height, ConnectStarter, FreeStarter,
+               times);
+  }
+  fprintf(stderr, "tango_replay: unknown example %s.\n", example);
+  return false;
+}
+
+double GetPercentile(std::vector<double>* samples, double percentile) {
+  if (samples->empty()) {
+    return 0.0;
+  }
+  size_t index = std::min(samples->size() - 1,
+                          static_cast<size_t>(samples->size() * percentile));
+  std::nth_element(samples->begin(), samples->begin() + index,
+                   samples->end());
+  return (*samples)[index];
+}
+
+}  // namespace tango_host
@@ -0,0 +1,70 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// Runs the sweep of the GL benchmark example in an offscreen context, for
+// desktop GPUs and drivers or to check the workloads without a device:
+//
+//   gl_benchmark [results.csv] [measured frames per case]
+//
+// The CSV is printed when no file is given.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+
+#include <tango-gl/offscreen_context.h>
+#include <tango-gl-benchmark/gl_benchmark_app.h>
+
+namespace {
+const int kSurfaceWidth = 1280;
+const int kSurfaceHeight = 720;
+}  // namespace
+
+int main(int argc, char** argv) {
+  tango_gl_benchmark::GlBenchmarkApp::Options options;
+  if (argc > 2) {
+    options.measured_frame_count = atoi(argv[2]);
+    if (options.measured_frame_count <= 0 ||
+        options.measured_frame_count > 128) {
+      fprintf(stderr, "gl_benchmark: measured frames must be in [1, 128].\n");
+      return EXIT_FAILURE;
+    }
+    options.warmup_frame_count =
+        std::min(options.warmup_frame_count, options.measured_frame_count);
+  }
+
+  tango_gl::OffscreenContext context;
+  if (!context.Create(kSurfaceWidth, kSurfaceHeight)) {
+    fprintf(stderr, "gl_benchmark: could not create a GLES2 context.\n");
+    return EXIT_FAILURE;
+  }
+
+  tango_gl_benchmark::GlBenchmarkApp app(options);
+  if (argc > 1) {
+    app.SetOutputPath(argv[1]);
+  }
+  app.InitializeGLContent();
+  app.SetViewPort(kSurfaceWidth, kSurfaceHeight);
+  while (app.Render()) {
+    context.SwapBuffers();
+  }
+  if (argc == 1) {
+    printf("%s", app.GetCsv().c_str());
+  }
+  app.FreeGLContent();
+  return EXIT_SUCCESS;
+}
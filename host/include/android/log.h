@@ -0,0 +1,54 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// Host replacement for the NDK logging header, prints to stderr.
+
+#ifndef TANGO_HOST_ANDROID_LOG_H_
+#define TANGO_HOST_ANDROID_LOG_H_
+
+#include <stdarg.h>
+#include <stdio.h>
+
+enum {
+  ANDROID_LOG_UNKNOWN = 0,
+  ANDROID_LOG_DEFAULT,
+  ANDROID_LOG_VERBOSE,
+  ANDROID_LOG_DEBUG,
+  ANDROID_LOG_INFO,
+  ANDROID_LOG_WARN,
+  ANDROID_LOG_ERROR,
+  ANDROID_LOG_FATAL,
+  ANDROID_LOG_SILENT,
+};
+
+static inline int __android_log_print(int priority, const char* tag,
+                                      const char* format, ...) {
+  static const char kPriorities[] = "??VDIWEFS";
+  va_list args;
+  va_start(args, format);
+  fprintf(stderr, "%c/%s: ",
+          kPriorities[priority >= 0 && priority <= ANDROID_LOG_SILENT
+                          ? priority
+                          : 0],
+          tag);
+  int count = vfprintf(stderr, format, args);
+  fputc('\n', stderr);
+  va_end(args);
+  return count;
+}
+
+#endif  // TANGO_HOST_ANDROID_LOG_H_
@@ -0,0 +1,85 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// Minimal stand-in for jni.h, used by the host build when no JDK is found.
+// It only declares what tango-gl and the example cores reference; the host
+// build never has a Java VM, so every call fails.
+
+#ifndef TANGO_HOST_JNI_H_
+#define TANGO_HOST_JNI_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef uint8_t jboolean;
+typedef int32_t jint;
+typedef int64_t jlong;
+typedef float jfloat;
+typedef double jdouble;
+typedef void* jobject;
+typedef jobject jclass;
+typedef jobject jstring;
+typedef jobject jbyteArray;
+typedef jobject jfloatArray;
+typedef struct _jmethodID* jmethodID;
+typedef struct _jfieldID* jfieldID;
+
+#define JNIEXPORT __attribute__((visibility("default")))
+#define JNICALL
+#define JNI_OK 0
+#define JNI_ERR (-1)
+#define JNI_FALSE 0
+#define JNI_TRUE 1
+#define JNI_VERSION_1_6 0x00010006
+
+typedef struct {
+  const char* name;
+  const char* signature;
+  void* fnPtr;
+} JNINativeMethod;
+
+struct _JNIEnv {
+  jclass FindClass(const char*) { return nullptr; }
+  jint RegisterNatives(jclass, const JNINativeMethod*, jint) {
+    return JNI_ERR;
+  }
+  jclass GetObjectClass(jobject) { return nullptr; }
+  jmethodID GetMethodID(jclass, const char*, const char*) { return nullptr; }
+  jobject CallObjectMethod(jobject, jmethodID, ...) { return nullptr; }
+  void CallVoidMethod(jobject, jmethodID, ...) {}
+  jboolean ExceptionCheck() { return JNI_TRUE; }
+  void ExceptionClear() {}
+  const char* GetStringUTFChars(jstring, jboolean*) { return nullptr; }
+  void ReleaseStringUTFChars(jstring, const char*) {}
+  jstring NewStringUTF(const char*) { return nullptr; }
+  void DeleteLocalRef(jobject) {}
+  jobject NewDirectByteBuffer(void*, jlong) { return nullptr; }
+  void* GetDirectBufferAddress(jobject) { return nullptr; }
+  jlong GetDirectBufferCapacity(jobject) { return -1; }
+  jobject NewGlobalRef(jobject) { return nullptr; }
+  void DeleteGlobalRef(jobject) {}
+};
+typedef _JNIEnv JNIEnv;
+
+struct _JavaVM {
+  jint AttachCurrentThread(JNIEnv**, void*) { return JNI_ERR; }
+  jint DetachCurrentThread() { return JNI_ERR; }
+  jint GetEnv(void**, jint) { return JNI_ERR; }
+};
+typedef _JavaVM JavaVM;
+
+#endif  // TANGO_HOST_JNI_H_
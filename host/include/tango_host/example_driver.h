@@ -0,0 +1,64 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_HOST_EXAMPLE_DRIVER_H_
+#define TANGO_HOST_EXAMPLE_DRIVER_H_
+
+#include <vector>
+
+#include <tango-gl/offscreen_context.h>
+
+namespace tango_host {
+
+// Durations in milliseconds of the stages of an example run against a
+// recorded session, one sample per call.
+struct StageTimes {
+  // Each frame, then its App::Render() call and its buffer swap, which
+  // includes waiting for the GPU to finish the frame.
+  std::vector<double> frame;
+  std::vector<double> render;
+  std::vector<double> swap;
+  // The application callbacks, on the replay thread.
+  std::vector<double> on_pose;
+  std::vector<double> on_xyz_ij;
+  std::vector<double> on_frame;
+};
+
+// Example names accepted by RunExample(), nullptr terminated.
+extern const char* const kExampleNames[];
+
+// Run an example headless against the session set with
+// TangoHost_setSessionPath(), driving it through the calls its Java
+// activity makes and rendering into context until the session has been
+// replayed.
+//
+// @param example: one of kExampleNames.
+// @param context: current offscreen context.
+// @param width: width of the context surface.
+// @param height: height of the context surface.
+// @param times: stage durations, appended to.
+// @return: false for an unknown example or if it could not connect to the
+//          session.
+bool RunExample(const char* example, tango_gl::OffscreenContext* context,
+                int width, int height, StageTimes* times);
+
+// Percentile of samples, e.g. 0.95, sorting them. 0 without samples.
+double GetPercentile(std::vector<double>* samples, double percentile);
+
+}  // namespace tango_host
+
+#endif  // TANGO_HOST_EXAMPLE_DRIVER_H_
@@ -0,0 +1,78 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_HOST_REPLAY_H_
+#define TANGO_HOST_REPLAY_H_
+
+#include <tango_client_api.h>
+
+// Controls of the host replacement for the Tango client API. The replacement
+// implements the service functions the examples call on top of a session
+// recorded with tango_gl::SessionRecorder: TangoService_connect() starts
+// replaying the session into the connected callbacks, and
+// TangoService_getPoseAtTime() answers from the recorded poses.
+//
+// Without TangoHost_setSessionPath(), the TANGO_HOST_SESSION and
+// TANGO_HOST_REPLAY_SPEED environment variables are used.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Session file replayed by the next TangoService_connect().
+void TangoHost_setSessionPath(const char* path);
+
+// Replay speed, 1 for the recorded timing, 0 to deliver samples back to back.
+void TangoHost_setReplaySpeed(double speed);
+
+// Intrinsics returned by TangoService_getCameraIntrinsics(), sessions do not
+// record them. Defaults to values typical of the development kit.
+void TangoHost_setCameraIntrinsics(const TangoCameraIntrinsics* intrinsics);
+
+// When deferred, TangoService_connect() only opens the session and the replay
+// starts with TangoHost_startReplay(). On a device the first samples arrive
+// well after the GL surface is created; deferring lets a driver reproduce that
+// order.
+void TangoHost_setDeferredReplay(bool defer);
+
+// Starts the replay of a deferred connection, false if there is none.
+bool TangoHost_startReplay();
+
+// True once the session of the current connection has been fully replayed.
+bool TangoHost_isReplayDone();
+
+// Application callbacks the replay delivers, see TangoHost_setCallbackTimer().
+typedef enum {
+  TANGO_HOST_POSE_CALLBACK = 0,
+  TANGO_HOST_XYZ_IJ_CALLBACK,
+  TANGO_HOST_FRAME_CALLBACK,
+} TangoHostCallbackType;
+
+// Time every application callback the replay delivers, e.g. to collect the
+// distribution of each processing stage. on_callback_timed is called on the
+// replay thread after each callback returns, with its duration. Set it before
+// TangoService_connect(), nullptr stops timing.
+void TangoHost_setCallbackTimer(
+    void (*on_callback_timed)(void* context, TangoHostCallbackType type,
+                              double milliseconds),
+    void* context);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // TANGO_HOST_REPLAY_H_
@@ -0,0 +1,307 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Performance regression gate: replays a fixed set of recorded sessions
+// through every example and compares the 95th percentile of each stage with
+// a stored baseline.
+//
+//   tango_perf_gate --write_baseline=<baseline.csv> <session>...
+//   tango_perf_gate --baseline=<baseline.csv> [--max_regression=<ratio>]
+//       [--min_regression_ms=<ms>] [--speed=<speed>]
+//
+// The baseline is a CSV file of example,session,stage,p95_ms lines, session
+// paths being relative to the directory of the baseline, so the sessions and
+// their baseline can be kept together. The stages are the frame, Render()
+// and the buffer swap, and the pose, point cloud and camera frame callbacks.
+// A stage fails when its p95 exceeds the baseline by more than
+// max_regression (0.15 by default) and by more than min_regression_ms (0.25
+// by default), which keeps stages of a few microseconds from failing on
+// noise. The exit status is non zero if any stage fails or any run could not
+// be made. Stages with too few samples in a session, e.g. the point cloud
+// callback of a short session, are not gated.
+//
+// Baselines only compare on the machine they were written on, and samples
+// are delivered with their recorded timing unless --speed says otherwise.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <tango-gl/offscreen_context.h>
+#include <tango_host/example_driver.h>
+#include <tango_host/replay.h>
+
+namespace {
+const int kSurfaceWidth = 1280;
+const int kSurfaceHeight = 720;
+
+// Only stages with at least this many samples have a meaningful p95, with
+// fewer it is close to the maximum.
+const size_t kMinSampleCount = 60;
+
+// Stage of an example run on a session.
+struct StageKey {
+  std::string example;
+  std::string session;
+  std::string stage;
+
+  bool operator<(const StageKey& other) const {
+    if (example != other.example) {
+      return example < other.example;
+    }
+    if (session != other.session) {
+      return session < other.session;
+    }
+    return stage < other.stage;
+  }
+};
+
+// Returns the value of a --name=value argument, nullptr if arg is another
+// one.
+const char* GetFlagValue(const char* arg, const char* name) {
+  size_t length = strlen(name);
+  if (strncmp(arg, name, length) != 0 || arg[length] != '=') {
+    return nullptr;
+  }
+  return arg + length + 1;
+}
+
+std::string GetDirectory(const std::string& path) {
+  size_t slash = path.rfind('/');
+  return slash == std::string::npos ? std::string() : path.substr(0, slash + 1);
+}
+
+// Read a baseline written by WriteBaseline().
+//
+// @return: false if the file cannot be read or has a malformed line.
+bool ReadBaseline(const std::string& path,
+                  std::map<StageKey, double>* baseline) {
+  std::ifstream file(path.c_str());
+  if (!file) {
+    fprintf(stderr, "tango_perf_gate: could not read %s\n", path.c_str());
+    return false;
+  }
+  std::string line;
+  // Skip the header.
+  std::getline(file, line);
+  while (std::getline(file, line)) {
+    if (line.empty()) {
+      continue;
+    }
+    std::istringstream fields(line);
+    StageKey key;
+    std::string p95;
+    if (!std::getline(fields, key.example, ',') ||
+        !std::getline(fields, key.session, ',') ||
+        !std::getline(fields, key.stage, ',') ||
+        !std::getline(fields, p95)) {
+      fprintf(stderr, "tango_perf_gate: malformed baseline line \"%s\"\n",
+              line.c_str());
+      return false;
+    }
+    (*baseline)[key] = atof(p95.c_str());
+  }
+  return true;
+}
+
+bool WriteBaseline(const std::string& path,
+                   const std::map<StageKey, double>& results) {
+  FILE* file = fopen(path.c_str(), "w");
+  if (file == nullptr) {
+    fprintf(stderr, "tango_perf_gate: could not write %s\n", path.c_str());
+    return false;
+  }
+  fprintf(file, "example,session,stage,p95_ms\n");
+  for (const auto& result : results) {
+    fprintf(file, "%s,%s,%s,%.4f\n", result.first.example.c_str(),
+            result.first.session.c_str(), result.first.stage.c_str(),
+            result.second);
+  }
+  return fclose(file) == 0;
+}
+
+// Run an example on a session and add the p95 of each stage to results,
+// printing the distributions.
+//
+// @return: false if the run could not be made.
+bool Measure(const std::string& example, const std::string& session,
+             const std::string& session_path,
+             tango_gl::OffscreenContext* context,
+             std::map<StageKey, double>* results) {
+  TangoHost_setSessionPath(session_path.c_str());
+  tango_host::StageTimes times;
+  if (!tango_host::RunExample(example.c_str(), context, kSurfaceWidth,
+                              kSurfaceHeight, &times)) {
+    fprintf(stderr, "tango_perf_gate: %s on %s failed\n", example.c_str(),
+            session.c_str());
+    return false;
+  }
+
+  const std::pair<const char*, std::vector<double>*> stages[] = {
+      {"frame", &times.frame},
+      {"render", &times.render},
+      {"swap", &times.swap},
+      {"on_pose", &times.on_pose},
+      {"on_xyz_ij", &times.on_xyz_ij},
+      {"on_frame", &times.on_frame}};
+  for (const auto& stage : stages) {
+    std::vector<double>* samples = stage.second;
+    if (samples->size() < kMinSampleCount) {
+      continue;
+    }
+    StageKey key = {example, session, stage.first};
+    const double p50 = tango_host::GetPercentile(samples, 0.5);
+    const double p95 = tango_host::GetPercentile(samples, 0.95);
+    const double p99 = tango_host::GetPercentile(samples, 0.99);
+    printf("%-16s %-24s %-10s n %6zu p50 %8.3f p95 %8.3f p99 %8.3f ms\n",
+           example.c_str(), session.c_str(), stage.first, samples->size(),
+           p50, p95, p99);
+    (*results)[key] = p95;
+  }
+  fflush(stdout);
+  return true;
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  std::string baseline_path;
+  std::string write_baseline_path;
+  double max_regression = 0.15;
+  double min_regression_ms = 0.25;
+  std::vector<std::string> sessions;
+  for (int i = 1; i < argc; ++i) {
+    const char* value = nullptr;
+    if ((value = GetFlagValue(argv[i], "--baseline")) != nullptr) {
+      baseline_path = value;
+    } else if ((value = GetFlagValue(argv[i], "--write_baseline")) !=
+               nullptr) {
+      write_baseline_path = value;
+    } else if ((value = GetFlagValue(argv[i], "--max_regression")) !=
+               nullptr) {
+      max_regression = atof(value);
+    } else if ((value = GetFlagValue(argv[i], "--min_regression_ms")) !=
+               nullptr) {
+      min_regression_ms = atof(value);
+    } else if ((value = GetFlagValue(argv[i], "--speed")) != nullptr) {
+      TangoHost_setReplaySpeed(atof(value));
+    } else if (argv[i][0] == '-') {
+      fprintf(stderr, "Unknown argument %s\n", argv[i]);
+      return EXIT_FAILURE;
+    } else {
+      sessions.push_back(argv[i]);
+    }
+  }
+  if (baseline_path.empty() == write_baseline_path.empty()) {
+    fprintf(stderr,
+            "usage: %s --write_baseline=<baseline.csv> <session>...\n"
+            "       %s --baseline=<baseline.csv> [--max_regression=<ratio>] "
+            "[--min_regression_ms=<ms>] [--speed=<speed>]\n",
+            argv[0], argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  const bool is_writing = !write_baseline_path.empty();
+  const std::string directory =
+      GetDirectory(is_writing ? write_baseline_path : baseline_path);
+  std::map<StageKey, double> baseline;
+  if (!is_writing && !ReadBaseline(baseline_path, &baseline)) {
+    return EXIT_FAILURE;
+  }
+
+  // The runs to make, every example on every session when writing a
+  // baseline, the runs of the baseline otherwise.
+  std::vector<std::pair<std::string, std::string>> runs;
+  if (is_writing) {
+    for (const std::string& session : sessions) {
+      for (const char* const* example = tango_host::kExampleNames;
+           *example != nullptr; ++example) {
+        runs.push_back(std::make_pair(*example, session));
+      }
+    }
+  } else {
+    for (const auto& entry : baseline) {
+      std::pair<std::string, std::string> run(entry.first.example,
+                                              entry.first.session);
+      if (runs.empty() || runs.back() != run) {
+        runs.push_back(run);
+      }
+    }
+  }
+  if (runs.empty()) {
+    fprintf(stderr, "tango_perf_gate: no sessions to replay\n");
+    return EXIT_FAILURE;
+  }
+
+  tango_gl::OffscreenContext context;
+  if (!context.Create(kSurfaceWidth, kSurfaceHeight)) {
+    fprintf(stderr, "tango_perf_gate: could not create a GLES2 context.\n");
+    return EXIT_FAILURE;
+  }
+
+  int failed_count = 0;
+  std::map<StageKey, double> results;
+  for (const auto& run : runs) {
+    // Sessions given on the command line are relative to the working
+    // directory, the written baseline makes them relative to itself.
+    std::string session = run.second;
+    std::string session_path = session;
+    if (is_writing) {
+      if (!directory.empty() && session.compare(0, directory.size(),
+                                                directory) == 0) {
+        session = session.substr(directory.size());
+      }
+    } else if (session.empty() || session[0] != '/') {
+      session_path = directory + session;
+    }
+    if (!Measure(run.first, session, session_path, &context, &results)) {
+      ++failed_count;
+    }
+  }
+
+  if (is_writing) {
+    return failed_count == 0 && WriteBaseline(write_baseline_path, results)
+               ? EXIT_SUCCESS
+               : EXIT_FAILURE;
+  }
+
+  for (const auto& entry : baseline) {
+    const StageKey& key = entry.first;
+    auto result = results.find(key);
+    if (result == results.end()) {
+      printf("FAIL %s %s %s: no samples\n", key.example.c_str(),
+             key.session.c_str(), key.stage.c_str());
+      ++failed_count;
+      continue;
+    }
+    const double regression = result->second - entry.second;
+    if (regression > min_regression_ms &&
+        regression > entry.second * max_regression) {
+      printf("FAIL %s %s %s: p95 %.3f ms, baseline %.3f ms (+%.0f%%)\n",
+             key.example.c_str(), key.session.c_str(), key.stage.c_str(),
+             result->second, entry.second,
+             entry.second > 0.0 ? 100.0 * regression / entry.second : 0.0);
+      ++failed_count;
+    }
+  }
+  printf("%s\n", failed_count == 0 ? "PASS" : "FAIL");
+  return failed_count == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,148 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// Writes the depth frames of a session recorded with tango_gl::SessionRecorder,
+// or of a stream of concatenated tango_gl::point_cloud_codec frames, as binary
+// PLY files, one per frame:
+//
+//   point_cloud_decode depth.bin frames/depth
+//
+// writes frames/depth_00000.ply, frames/depth_00001.ply, and so on.
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include <tango-gl/point_cloud_codec.h>
+#include <tango-gl/session_format.h>
+#include <tango-gl/session_replayer.h>
+
+namespace codec = tango_gl::point_cloud_codec;
+
+namespace {
+struct Output {
+  std::string prefix;
+  int frame_count;
+  bool has_error;
+};
+
+void WriteFrame(Output* output, double timestamp, const float* points,
+                size_t point_count) {
+  char suffix[32];
+  snprintf(suffix, sizeof(suffix), "_%05d.ply", output->frame_count++);
+  const std::string path = output->prefix + suffix;
+  FILE* file = fopen(path.c_str(), "wb");
+  if (file == nullptr) {
+    fprintf(stderr, "point_cloud_decode: could not create %s.\n",
+            path.c_str());
+    output->has_error = true;
+    return;
+  }
+  fprintf(file,
+          "ply\nformat binary_little_endian 1.0\ncomment timestamp %.6f\n"
+          "element vertex %zu\nproperty float x\nproperty float y\n"
+          "property float z\nend_header\n",
+          timestamp, point_count);
+  if (fwrite(points, 3 * sizeof(float), point_count, file) != point_count) {
+    fprintf(stderr, "point_cloud_decode: could not write %s.\n",
+            path.c_str());
+    output->has_error = true;
+  }
+  fclose(file);
+}
+
+void OnXyzIjAvailable(void* context, const TangoXYZij* xyz_ij) {
+  WriteFrame(static_cast<Output*>(context), xyz_ij->timestamp, xyz_ij->xyz[0],
+             xyz_ij->xyz_count);
+}
+
+// Frames of a codec stream carry no timestamp, they are numbered instead.
+bool DecodeStream(const char* path, Output* output) {
+  FILE* file = fopen(path, "rb");
+  if (file == nullptr) {
+    return false;
+  }
+  std::vector<uint8_t> data;
+  uint8_t buffer[1 << 16];
+  size_t read_size;
+  while ((read_size = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+    data.insert(data.end(), buffer, buffer + read_size);
+  }
+  fclose(file);
+
+  std::vector<float> points;
+  size_t offset = 0;
+  while (offset < data.size()) {
+    codec::Header header;
+    if (!codec::ReadHeader(data.data() + offset, data.size() - offset,
+                           &header)) {
+      fprintf(stderr, "point_cloud_decode: malformed frame at byte %zu.\n",
+              offset);
+      return false;
+    }
+    points.resize(static_cast<size_t>(header.point_count) * 3);
+    if (!codec::Decode(data.data() + offset, data.size() - offset,
+                       points.data(), header.point_count)) {
+      fprintf(stderr, "point_cloud_decode: malformed frame at byte %zu.\n",
+              offset);
+      return false;
+    }
+    WriteFrame(output, output->frame_count, points.data(), header.point_count);
+    offset += sizeof(header) + header.payload_size;
+  }
+  return true;
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc != 3) {
+    fprintf(stderr,
+            "usage: point_cloud_decode <session or codec stream> <prefix>\n");
+    return EXIT_FAILURE;
+  }
+  Output output;
+  output.prefix = argv[2];
+  output.frame_count = 0;
+  output.has_error = false;
+
+  FILE* file = fopen(argv[1], "rb");
+  if (file == nullptr) {
+    fprintf(stderr, "point_cloud_decode: could not open %s.\n", argv[1]);
+    return EXIT_FAILURE;
+  }
+  uint32_t magic = 0;
+  const bool has_magic = fread(&magic, sizeof(magic), 1, file) == 1;
+  fclose(file);
+
+  if (has_magic && magic == tango_gl::session::kMagic) {
+    tango_gl::SessionReplayer replayer;
+    if (!replayer.Open(argv[1])) {
+      fprintf(stderr, "point_cloud_decode: %s is not a valid session.\n",
+              argv[1]);
+      return EXIT_FAILURE;
+    }
+    tango_gl::SessionReplayer::Callbacks callbacks;
+    callbacks.context = &output;
+    callbacks.on_xyz_ij_available = OnXyzIjAvailable;
+    replayer.Run(callbacks, 0.0);
+  } else if (!DecodeStream(argv[1], &output)) {
+    return EXIT_FAILURE;
+  }
+  printf("point_cloud_decode: wrote %d frames.\n", output.frame_count);
+  return output.has_error ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,80 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Prints a pose log written by tango_gl::PoseLogger as comma separated
+// values, oldest pose first:
+//
+//   pose_log_decode poses.bin > poses.csv
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include <tango-gl/pose_log_format.h>
+
+namespace pose_log = tango_gl::pose_log;
+
+int main(int argc, char** argv) {
+  if (argc != 2) {
+    fprintf(stderr, "usage: pose_log_decode <pose log>\n");
+    return EXIT_FAILURE;
+  }
+  FILE* file = fopen(argv[1], "rb");
+  if (file == nullptr) {
+    fprintf(stderr, "pose_log_decode: could not open %s.\n", argv[1]);
+    return EXIT_FAILURE;
+  }
+
+  pose_log::FileHeader header;
+  if (fread(&header, sizeof(header), 1, file) != 1 ||
+      header.magic != pose_log::kMagic ||
+      header.version != pose_log::kVersion ||
+      header.record_size != sizeof(pose_log::Record) ||
+      header.record_capacity == 0) {
+    fprintf(stderr, "pose_log_decode: %s is not a pose log.\n", argv[1]);
+    fclose(file);
+    return EXIT_FAILURE;
+  }
+  std::vector<pose_log::Record> records(header.record_capacity);
+  const size_t read_count =
+      fread(records.data(), sizeof(pose_log::Record), records.size(), file);
+  fclose(file);
+  if (read_count != records.size()) {
+    fprintf(stderr, "pose_log_decode: %s is truncated.\n", argv[1]);
+    return EXIT_FAILURE;
+  }
+
+  // Once the ring wrapped, the oldest record is the one after the newest.
+  const uint64_t capacity = header.record_capacity;
+  const uint64_t first =
+      header.record_count > capacity ? header.record_count - capacity : 0;
+  printf("timestamp,base_frame,target_frame,status_code,"
+         "tx,ty,tz,qx,qy,qz,qw\n");
+  for (uint64_t i = first; i < header.record_count; ++i) {
+    const pose_log::Record& record = records[i % capacity];
+    printf("%.6f,%d,%d,%d,%.6f,%.6f,%.6f,%.6f,%.6f,%.6f,%.6f\n",
+           record.timestamp, record.pose.base_frame, record.pose.target_frame,
+           record.pose.status_code, record.pose.translation[0],
+           record.pose.translation[1], record.pose.translation[2],
+           record.pose.orientation[0], record.pose.orientation[1],
+           record.pose.orientation[2], record.pose.orientation[3]);
+  }
+  fprintf(stderr, "pose_log_decode: %llu poses, %llu written, %llu dropped.\n",
+          static_cast<unsigned long long>(header.record_count - first),
+          static_cast<unsigned long long>(header.record_count),
+          static_cast<unsigned long long>(header.dropped_count));
+  return EXIT_SUCCESS;
+}
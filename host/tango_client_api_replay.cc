@@ -0,0 +1,493 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// Host replacement for the Tango client API, replaying a recorded session.
+// Only the functions used by the example cores are provided.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <tango-gl/session_replayer.h>
+#include <tango-gl/util.h>
+
+#include "tango_host/replay.h"
+
+namespace {
+// Callbacks and replay of the current connection.
+struct Connection {
+  Connection()
+      : context(nullptr),
+        on_pose_available(nullptr),
+        on_xyz_ij_available(nullptr),
+        replay_speed(1.0),
+        defer_replay(false),
+        replay_pending(false),
+        on_callback_timed(nullptr),
+        timer_context(nullptr),
+        latest_color_timestamp(0.0) {
+    memset(on_frame_available, 0, sizeof(on_frame_available));
+    memset(frame_contexts, 0, sizeof(frame_contexts));
+    memset(on_texture_available, 0, sizeof(on_texture_available));
+    memset(texture_contexts, 0, sizeof(texture_contexts));
+    memset(intrinsics, 0, sizeof(intrinsics));
+  }
+
+  void* context;
+  std::vector<TangoCoordinateFramePair> pose_frames;
+  void (*on_pose_available)(void*, const TangoPoseData*);
+  void (*on_xyz_ij_available)(void*, const TangoXYZij*);
+  void (*on_frame_available[TANGO_CAMERA_DEPTH + 1])(void*, TangoCameraId,
+                                                     const TangoImageBuffer*);
+  void* frame_contexts[TANGO_CAMERA_DEPTH + 1];
+  void (*on_texture_available[TANGO_CAMERA_DEPTH + 1])(void*, TangoCameraId);
+  void* texture_contexts[TANGO_CAMERA_DEPTH + 1];
+  TangoCameraIntrinsics intrinsics[TANGO_CAMERA_DEPTH + 1];
+
+  std::string session_path;
+  double replay_speed;
+  bool defer_replay;
+  // Connected, waiting for TangoHost_startReplay().
+  bool replay_pending;
+  tango_gl::SessionReplayer replayer;
+  tango_gl::SessionReplayer::Callbacks replayer_callbacks;
+  void (*on_callback_timed)(void*, TangoHostCallbackType, double);
+  void* timer_context;
+  std::atomic<double> latest_color_timestamp;
+};
+
+// Times an application callback for TangoHost_setCallbackTimer().
+class ScopedCallbackTimer {
+ public:
+  ScopedCallbackTimer(const Connection* connection, TangoHostCallbackType type)
+      : connection_(connection),
+        type_(type),
+        start_(std::chrono::steady_clock::now()) {}
+  ScopedCallbackTimer(const ScopedCallbackTimer& other) = delete;
+  const ScopedCallbackTimer& operator=(const ScopedCallbackTimer&) = delete;
+  ~ScopedCallbackTimer() {
+    if (connection_->on_callback_timed != nullptr) {
+      std::chrono::duration<double, std::milli> elapsed =
+          std::chrono::steady_clock::now() - start_;
+      connection_->on_callback_timed(connection_->timer_context, type_,
+                                     elapsed.count());
+    }
+  }
+
+ private:
+  const Connection* connection_;
+  TangoHostCallbackType type_;
+  std::chrono::steady_clock::time_point start_;
+};
+
+// Configuration values, all stored as strings.
+struct HostConfig {
+  std::map<std::string, std::string> values;
+};
+
+std::mutex connection_mutex;
+
+Connection* GetConnection() {
+  static Connection* connection = [] {
+    Connection* new_connection = new Connection();
+    TangoCameraIntrinsics* color =
+        &new_connection->intrinsics[TANGO_CAMERA_COLOR];
+    color->camera_id = TANGO_CAMERA_COLOR;
+    color->calibration_type = TANGO_CALIBRATION_POLYNOMIAL_3_PARAMETERS;
+    color->width = 1280;
+    color->height = 720;
+    color->fx = 1042.0;
+    color->fy = 1042.0;
+    color->cx = 637.0;
+    color->cy = 357.0;
+    TangoCameraIntrinsics* depth =
+        &new_connection->intrinsics[TANGO_CAMERA_DEPTH];
+    depth->camera_id = TANGO_CAMERA_DEPTH;
+    depth->calibration_type = TANGO_CALIBRATION_POLYNOMIAL_3_PARAMETERS;
+    depth->width = 320;
+    depth->height = 180;
+    depth->fx = 260.0;
+    depth->fy = 260.0;
+    depth->cx = 160.0;
+    depth->cy = 90.0;
+    const char* session_path = getenv("TANGO_HOST_SESSION");
+    if (session_path != nullptr) {
+      new_connection->session_path = session_path;
+    }
+    const char* replay_speed = getenv("TANGO_HOST_REPLAY_SPEED");
+    if (replay_speed != nullptr) {
+      new_connection->replay_speed = atof(replay_speed);
+    }
+    return new_connection;
+  }();
+  return connection;
+}
+
+bool IsValidCamera(TangoCameraId camera_id) {
+  return camera_id >= TANGO_CAMERA_COLOR && camera_id <= TANGO_CAMERA_DEPTH;
+}
+
+void OnPoseAvailable(void* context, const TangoPoseData* pose) {
+  Connection* connection = static_cast<Connection*>(context);
+  if (connection->on_pose_available == nullptr) {
+    return;
+  }
+  for (const TangoCoordinateFramePair& frame : connection->pose_frames) {
+    if (frame.base == pose->frame.base && frame.target == pose->frame.target) {
+      ScopedCallbackTimer timer(connection, TANGO_HOST_POSE_CALLBACK);
+      connection->on_pose_available(connection->context, pose);
+      return;
+    }
+  }
+}
+
+void OnXYZijAvailable(void* context, const TangoXYZij* xyz_ij) {
+  Connection* connection = static_cast<Connection*>(context);
+  if (connection->on_xyz_ij_available != nullptr) {
+    ScopedCallbackTimer timer(connection, TANGO_HOST_XYZ_IJ_CALLBACK);
+    connection->on_xyz_ij_available(connection->context, xyz_ij);
+  }
+}
+
+void OnFrameAvailable(void* context, TangoCameraId camera_id,
+                      const TangoImageBuffer* image) {
+  Connection* connection = static_cast<Connection*>(context);
+  if (!IsValidCamera(camera_id)) {
+    return;
+  }
+  if (camera_id == TANGO_CAMERA_COLOR) {
+    connection->latest_color_timestamp = image->timestamp;
+  }
+  ScopedCallbackTimer timer(connection, TANGO_HOST_FRAME_CALLBACK);
+  if (connection->on_frame_available[camera_id] != nullptr) {
+    connection->on_frame_available[camera_id](
+        connection->frame_contexts[camera_id], camera_id, image);
+  }
+  if (connection->on_texture_available[camera_id] != nullptr) {
+    connection->on_texture_available[camera_id](
+        connection->texture_contexts[camera_id], camera_id);
+  }
+}
+}  // namespace
+
+extern "C" {
+
+void TangoHost_setSessionPath(const char* path) {
+  std::lock_guard<std::mutex> lock(connection_mutex);
+  GetConnection()->session_path = path;
+}
+
+void TangoHost_setReplaySpeed(double speed) {
+  std::lock_guard<std::mutex> lock(connection_mutex);
+  GetConnection()->replay_speed = speed;
+}
+
+void TangoHost_setCameraIntrinsics(const TangoCameraIntrinsics* intrinsics) {
+  std::lock_guard<std::mutex> lock(connection_mutex);
+  if (IsValidCamera(intrinsics->camera_id)) {
+    GetConnection()->intrinsics[intrinsics->camera_id] = *intrinsics;
+  }
+}
+
+void TangoHost_setDeferredReplay(bool defer) {
+  std::lock_guard<std::mutex> lock(connection_mutex);
+  GetConnection()->defer_replay = defer;
+}
+
+bool TangoHost_startReplay() {
+  std::lock_guard<std::mutex> lock(connection_mutex);
+  Connection* connection = GetConnection();
+  if (!connection->replay_pending) {
+    return false;
+  }
+  connection->replay_pending = false;
+  return connection->replayer.Start(connection->replayer_callbacks,
+                                    connection->replay_speed);
+}
+
+bool TangoHost_isReplayDone() {
+  return GetConnection()->replayer.IsDone();
+}
+
+void TangoHost_setCallbackTimer(
+    void (*on_callback_timed)(void* context, TangoHostCallbackType type,
+                              double milliseconds),
+    void* context) {
+  std::lock_guard<std::mutex> lock(connection_mutex);
+  Connection* connection = GetConnection();
+  connection->on_callback_timed = on_callback_timed;
+  connection->timer_context = context;
+}
+
+TangoErrorType TangoService_initialize(JNIEnv*, jobject) {
+  return TANGO_SUCCESS;
+}
+
+TangoConfig TangoService_getConfig(TangoConfigType) {
+  return new HostConfig();
+}
+
+void TangoConfig_free(TangoConfig config) {
+  delete static_cast<HostConfig*>(config);
+}
+
+TangoErrorType TangoConfig_setBool(TangoConfig config, const char* key,
+                                   bool value) {
+  if (config == nullptr || key == nullptr) {
+    return TANGO_INVALID;
+  }
+  static_cast<HostConfig*>(config)->values[key] = value ? "true" : "false";
+  return TANGO_SUCCESS;
+}
+
+TangoErrorType TangoConfig_setInt32(TangoConfig config, const char* key,
+                                    int32_t value) {
+  if (config == nullptr || key == nullptr) {
+    return TANGO_INVALID;
+  }
+  static_cast<HostConfig*>(config)->values[key] = std::to_string(value);
+  return TANGO_SUCCESS;
+}
+
+TangoErrorType TangoConfig_getBool(TangoConfig config, const char* key,
+                                   bool* value) {
+  if (config == nullptr || key == nullptr || value == nullptr) {
+    return TANGO_INVALID;
+  }
+  const HostConfig* host_config = static_cast<HostConfig*>(config);
+  auto entry = host_config->values.find(key);
+  *value = entry != host_config->values.end() && entry->second == "true";
+  return TANGO_SUCCESS;
+}
+
+TangoErrorType TangoConfig_getInt32(TangoConfig config, const char* key,
+                                    int32_t* value) {
+  if (config == nullptr || key == nullptr || value == nullptr) {
+    return TANGO_INVALID;
+  }
+  const HostConfig* host_config = static_cast<HostConfig*>(config);
+  auto entry = host_config->values.find(key);
+  if (entry != host_config->values.end()) {
+    *value = atoi(entry->second.c_str());
+  } else if (strcmp(key, "max_point_cloud_elements") == 0) {
+    // Largest cloud of the development kit depth sensor.
+    *value = 60000;
+  } else {
+    return TANGO_ERROR;
+  }
+  return TANGO_SUCCESS;
+}
+
+TangoErrorType TangoConfig_getString(TangoConfig config, const char* key,
+                                     char* value, size_t size) {
+  if (config == nullptr || key == nullptr || value == nullptr || size == 0) {
+    return TANGO_INVALID;
+  }
+  const HostConfig* host_config = static_cast<HostConfig*>(config);
+  auto entry = host_config->values.find(key);
+  std::string string_value;
+  if (entry != host_config->values.end()) {
+    string_value = entry->second;
+  } else if (strcmp(key, "tango_service_library_version") == 0) {
+    string_value = "host-replay";
+  } else {
+    return TANGO_INVALID;
+  }
+  snprintf(value, size, "%s", string_value.c_str());
+  return TANGO_SUCCESS;
+}
+
+TangoErrorType TangoService_connect(void* context, TangoConfig) {
+  std::lock_guard<std::mutex> lock(connection_mutex);
+  Connection* connection = GetConnection();
+  connection->context = context;
+  if (connection->session_path.empty()) {
+    LOGE("TangoService_connect: no session, set TANGO_HOST_SESSION.");
+    return TANGO_ERROR;
+  }
+  if (!connection->replayer.Open(connection->session_path.c_str())) {
+    return TANGO_ERROR;
+  }
+  tango_gl::SessionReplayer::Callbacks* callbacks =
+      &connection->replayer_callbacks;
+  callbacks->context = connection;
+  callbacks->on_pose_available = OnPoseAvailable;
+  callbacks->on_xyz_ij_available = OnXYZijAvailable;
+  callbacks->on_frame_available = OnFrameAvailable;
+  if (connection->defer_replay) {
+    connection->replay_pending = true;
+    return TANGO_SUCCESS;
+  }
+  return connection->replayer.Start(*callbacks, connection->replay_speed)
+             ? TANGO_SUCCESS
+             : TANGO_ERROR;
+}
+
+void TangoService_disconnect() {
+  std::lock_guard<std::mutex> lock(connection_mutex);
+  Connection* connection = GetConnection();
+  connection->replayer.Close();
+  connection->replay_pending = false;
+  connection->on_pose_available = nullptr;
+  connection->on_xyz_ij_available = nullptr;
+  memset(connection->on_frame_available, 0,
+         sizeof(connection->on_frame_available));
+  memset(connection->on_texture_available, 0,
+         sizeof(connection->on_texture_available));
+  connection->pose_frames.clear();
+}
+
+// A recorded session cannot be tracked again, the replay goes on.
+void TangoService_resetMotionTracking() {}
+
+TangoErrorType TangoService_connectOnPoseAvailable(
+    uint32_t count, const TangoCoordinateFramePair* frames,
+    void (*on_pose_available)(void* context, const TangoPoseData* pose),
+    ...) {
+  std::lock_guard<std::mutex> lock(connection_mutex);
+  Connection* connection = GetConnection();
+  connection->pose_frames.assign(frames, frames + count);
+  connection->on_pose_available = on_pose_available;
+  return TANGO_SUCCESS;
+}
+
+TangoErrorType TangoService_connectOnXYZijAvailable(
+    void (*on_xyz_ij_available)(void* context, const TangoXYZij* xyz_ij),
+    ...) {
+  std::lock_guard<std::mutex> lock(connection_mutex);
+  GetConnection()->on_xyz_ij_available = on_xyz_ij_available;
+  return TANGO_SUCCESS;
+}
+
+// Sessions hold no events, the callback is never called.
+TangoErrorType TangoService_connectOnTangoEvent(
+    void (*)(void* context, const TangoEvent* event), ...) {
+  return TANGO_SUCCESS;
+}
+
+TangoErrorType TangoService_connectOnFrameAvailable(
+    TangoCameraId id, void* context,
+    void (*on_frame_available)(void* context, TangoCameraId id,
+                               const TangoImageBuffer* buffer)) {
+  if (!IsValidCamera(id)) {
+    return TANGO_INVALID;
+  }
+  std::lock_guard<std::mutex> lock(connection_mutex);
+  Connection* connection = GetConnection();
+  connection->on_frame_available[id] = on_frame_available;
+  connection->frame_contexts[id] = context;
+  return TANGO_SUCCESS;
+}
+
+TangoErrorType TangoService_connectTextureId(
+    TangoCameraId id, unsigned int, void* context,
+    void (*callback)(void*, TangoCameraId)) {
+  if (!IsValidCamera(id)) {
+    return TANGO_INVALID;
+  }
+  std::lock_guard<std::mutex> lock(connection_mutex);
+  Connection* connection = GetConnection();
+  connection->on_texture_available[id] = callback;
+  connection->texture_contexts[id] = context;
+  return TANGO_SUCCESS;
+}
+
+TangoErrorType TangoService_updateTexture(TangoCameraId id,
+                                          double* timestamp) {
+  // The texture is left as is, only its timestamp follows the replay.
+  if (id != TANGO_CAMERA_COLOR || timestamp == nullptr) {
+    return TANGO_INVALID;
+  }
+  *timestamp = GetConnection()->latest_color_timestamp;
+  return TANGO_SUCCESS;
+}
+
+TangoErrorType TangoService_getCameraIntrinsics(
+    TangoCameraId camera_id, TangoCameraIntrinsics* intrinsics) {
+  if (!IsValidCamera(camera_id) || intrinsics == nullptr) {
+    return TANGO_INVALID;
+  }
+  std::lock_guard<std::mutex> lock(connection_mutex);
+  *intrinsics = GetConnection()->intrinsics[camera_id];
+  return TANGO_SUCCESS;
+}
+
+TangoErrorType TangoService_getPoseAtTime(double timestamp,
+                                          TangoCoordinateFramePair frame,
+                                          TangoPoseData* pose) {
+  if (pose == nullptr) {
+    return TANGO_INVALID;
+  }
+  // The index of the open session is immutable, no lock needed.
+  GetConnection()->replayer.GetPoseAtTime(timestamp, frame, pose);
+  return TANGO_SUCCESS;
+}
+
+// A recorded session has no area description to plan in.
+TangoErrorType TangoService_Experimental_getTrajectoryToGoal(
+    const TangoPositionData_Experimental, const TangoCoordinateFrameType,
+    size_t* trajectory_size, TangoPositionData_Experimental** trajectory) {
+  if (trajectory_size == nullptr || trajectory == nullptr) {
+    return TANGO_INVALID;
+  }
+  *trajectory_size = 0;
+  *trajectory = nullptr;
+  return TANGO_INVALID;
+}
+
+TangoErrorType TangoService_Experimental_freeTrajectory(
+    TangoPositionData_Experimental** trajectory) {
+  if (trajectory == nullptr) {
+    return TANGO_INVALID;
+  }
+  free(*trajectory);
+  *trajectory = nullptr;
+  return TANGO_SUCCESS;
+}
+
+// A replay has no scene reconstruction server, as a service connected
+// without config_experimental_enable_scene_reconstruction.
+TangoErrorType TangoService_Experimental_startSceneReconstruction() {
+  return TANGO_INVALID;
+}
+
+TangoErrorType TangoService_Experimental_stopSceneReconstruction() {
+  return TANGO_INVALID;
+}
+
+TangoErrorType TangoService_Experimental_resetSceneReconstruction() {
+  return TANGO_INVALID;
+}
+
+TangoErrorType TangoService_Experimental_extractMesh(
+    TangoMesh_Experimental*) {
+  return TANGO_INVALID;
+}
+
+TangoErrorType TangoService_Experimental_getReconstructionMetadata(
+    TangoReconstructionMetadata_Experimental*) {
+  return TANGO_INVALID;
+}
+
+}  // extern "C"
@@ -0,0 +1,110 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Runs one of the example applications headless against a recorded session:
+//
+//   tango_replay <example> session.bin [speed]
+//
+// where example is one of tango_host::kExampleNames. The application renders
+// into an offscreen pbuffer as fast as it can, unthrottled by a display,
+// until the session has been replayed, then the frames per second and the
+// times of each stage are printed. The starter and motion-tracking examples,
+// which only render the device pose, make a quick smoke benchmark of
+// tango-gl.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <utility>
+#include <vector>
+
+#include <tango-gl/offscreen_context.h>
+#include <tango_host/example_driver.h>
+#include <tango_host/replay.h>
+
+namespace {
+const int kSurfaceWidth = 1280;
+const int kSurfaceHeight = 720;
+
+void PrintUsage(const char* program) {
+  fprintf(stderr, "usage: %s <", program);
+  for (const char* const* example = tango_host::kExampleNames;
+       *example != nullptr; ++example) {
+    fprintf(stderr, "%s%s", example == tango_host::kExampleNames ? "" : "|",
+            *example);
+  }
+  fprintf(stderr, "> <session> [speed]\n");
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc < 3) {
+    PrintUsage(argv[0]);
+    return EXIT_FAILURE;
+  }
+  TangoHost_setSessionPath(argv[2]);
+  if (argc > 3) {
+    TangoHost_setReplaySpeed(atof(argv[3]));
+  }
+
+  tango_gl::OffscreenContext context;
+  if (!context.Create(kSurfaceWidth, kSurfaceHeight)) {
+    fprintf(stderr, "tango_replay: could not create a GLES2 context.\n");
+    return EXIT_FAILURE;
+  }
+
+  tango_host::StageTimes times;
+  if (!tango_host::RunExample(argv[1], &context, kSurfaceWidth,
+                              kSurfaceHeight, &times)) {
+    return EXIT_FAILURE;
+  }
+
+  if (times.frame.empty()) {
+    printf("no frames rendered\n");
+    return EXIT_SUCCESS;
+  }
+  double total = 0.0;
+  for (double frame_time : times.frame) {
+    total += frame_time;
+  }
+  printf("frames %zu, %.1f fps\n", times.frame.size(),
+         times.frame.size() * 1000.0 / total);
+
+  const std::pair<const char*, std::vector<double>*> stages[] = {
+      {"frame", &times.frame},
+      {"render", &times.render},
+      {"swap", &times.swap},
+      {"on_pose", &times.on_pose},
+      {"on_xyz_ij", &times.on_xyz_ij},
+      {"on_frame", &times.on_frame}};
+  for (const auto& stage : stages) {
+    std::vector<double>* samples = stage.second;
+    if (samples->empty()) {
+      continue;
+    }
+    double sum = 0.0;
+    for (double sample : *samples) {
+      sum += sample;
+    }
+    const double mean = sum / samples->size();
+    const double median = tango_host::GetPercentile(samples, 0.5);
+    const double p99 = tango_host::GetPercentile(samples, 0.99);
+    printf("%-10s n %6zu mean %8.3f median %8.3f p99 %8.3f max %8.3f ms\n",
+           stage.first, samples->size(), mean, median, p99,
+           *std::max_element(samples->begin(), samples->end()));
+  }
+  return EXIT_SUCCESS;
+}
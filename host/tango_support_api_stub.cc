@@ -0,0 +1,189 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// Host replacement for the Tango support library. The mesh functions are
+// implemented, the ones backed by device algorithms report TANGO_ERROR.
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <tango-gl/util.h>
+#include <tango_support_api.h>
+
+namespace {
+template <typename T>
+T* CopyArray(const T* source, size_t count) {
+  if (source == nullptr || count == 0) {
+    return nullptr;
+  }
+  T* copy = static_cast<T*>(malloc(count * sizeof(T)));
+  memcpy(copy, source, count * sizeof(T));
+  return copy;
+}
+
+// Pose of a frame at a timestamp with respect to the start of service frame,
+// through the recorded device pose and extrinsics.
+bool GetStartOfServicePose(double timestamp, TangoCoordinateFrameType frame,
+                           glm::dmat4* start_service_T_frame) {
+  TangoCoordinateFramePair pair;
+  pair.base = TANGO_COORDINATE_FRAME_START_OF_SERVICE;
+  pair.target = TANGO_COORDINATE_FRAME_DEVICE;
+  TangoPoseData device_pose;
+  TangoService_getPoseAtTime(timestamp, pair, &device_pose);
+  pair.base = TANGO_COORDINATE_FRAME_DEVICE;
+  pair.target = frame;
+  TangoPoseData extrinsics;
+  if (frame == TANGO_COORDINATE_FRAME_DEVICE) {
+    memset(&extrinsics, 0, sizeof(extrinsics));
+    extrinsics.orientation[3] = 1.0;
+    extrinsics.status_code = TANGO_POSE_VALID;
+  } else {
+    TangoService_getPoseAtTime(0.0, pair, &extrinsics);
+  }
+  if (device_pose.status_code != TANGO_POSE_VALID ||
+      extrinsics.status_code != TANGO_POSE_VALID) {
+    return false;
+  }
+
+  auto to_matrix = [](const TangoPoseData& pose) {
+    const glm::dquat rotation(pose.orientation[3], pose.orientation[0],
+                              pose.orientation[1], pose.orientation[2]);
+    glm::dmat4 matrix = glm::mat4_cast(rotation);
+    matrix[3] = glm::dvec4(pose.translation[0], pose.translation[1],
+                           pose.translation[2], 1.0);
+    return matrix;
+  };
+  *start_service_T_frame = to_matrix(device_pose) * to_matrix(extrinsics);
+  return true;
+}
+}  // namespace
+
+extern "C" {
+
+TangoErrorType TangoSupport_fitPlaneModelNearClick(
+    const TangoXYZij*, const TangoCameraIntrinsics*, const TangoPoseData*,
+    const float[2], double[3], double[4]) {
+  LOGE("TangoSupport_fitPlaneModelNearClick is not available on host.");
+  return TANGO_ERROR;
+}
+
+TangoErrorType TangoSupport_calculateRelativePose(
+    double base_timestamp, TangoCoordinateFrameType base_frame,
+    double target_timestamp, TangoCoordinateFrameType target_frame,
+    TangoPoseData* base_frame_T_target_frame) {
+  if (base_frame_T_target_frame == nullptr) {
+    return TANGO_INVALID;
+  }
+  memset(base_frame_T_target_frame, 0, sizeof(*base_frame_T_target_frame));
+  glm::dmat4 start_service_T_base;
+  glm::dmat4 start_service_T_target;
+  if (!GetStartOfServicePose(base_timestamp, base_frame,
+                             &start_service_T_base) ||
+      !GetStartOfServicePose(target_timestamp, target_frame,
+                             &start_service_T_target)) {
+    base_frame_T_target_frame->status_code = TANGO_POSE_INVALID;
+    return TANGO_ERROR;
+  }
+  const glm::dmat4 base_T_target =
+      glm::inverse(start_service_T_base) * start_service_T_target;
+  const glm::dquat rotation = glm::quat_cast(base_T_target);
+  base_frame_T_target_frame->timestamp = target_timestamp;
+  base_frame_T_target_frame->orientation[0] = rotation.x;
+  base_frame_T_target_frame->orientation[1] = rotation.y;
+  base_frame_T_target_frame->orientation[2] = rotation.z;
+  base_frame_T_target_frame->orientation[3] = rotation.w;
+  for (int i = 0; i < 3; ++i) {
+    base_frame_T_target_frame->translation[i] = base_T_target[3][i];
+  }
+  base_frame_T_target_frame->status_code = TANGO_POSE_VALID;
+  base_frame_T_target_frame->frame.base = base_frame;
+  base_frame_T_target_frame->frame.target = target_frame;
+  return TANGO_SUCCESS;
+}
+
+TangoErrorType TangoSupport_initializeEmptyMesh(TangoMesh_Experimental* mesh) {
+  if (mesh == nullptr) {
+    return TANGO_INVALID;
+  }
+  memset(mesh, 0, sizeof(*mesh));
+  return TANGO_SUCCESS;
+}
+
+TangoErrorType TangoSupport_freeMesh(TangoMesh_Experimental* mesh) {
+  if (mesh == nullptr) {
+    return TANGO_INVALID;
+  }
+  free(mesh->vertices);
+  free(mesh->faces);
+  free(mesh->normals);
+  free(mesh->colors);
+  return TangoSupport_initializeEmptyMesh(mesh);
+}
+
+TangoErrorType TangoSupport_createMesh(uint32_t num_vertices,
+                                       uint32_t num_faces, bool has_normals,
+                                       bool has_colors,
+                                       TangoMesh_Experimental* mesh) {
+  if (mesh == nullptr) {
+    return TANGO_INVALID;
+  }
+  TangoSupport_initializeEmptyMesh(mesh);
+  mesh->num_vertices = num_vertices;
+  mesh->num_faces = num_faces;
+  mesh->has_normals = has_normals;
+  mesh->has_colors = has_colors;
+  mesh->vertices =
+      static_cast<float(*)[3]>(malloc(num_vertices * sizeof(*mesh->vertices)));
+  mesh->faces =
+      static_cast<uint32_t(*)[3]>(malloc(num_faces * sizeof(*mesh->faces)));
+  if (has_normals) {
+    mesh->normals = static_cast<float(*)[3]>(
+        malloc(num_vertices * sizeof(*mesh->normals)));
+  }
+  if (has_colors) {
+    mesh->colors = static_cast<uint8_t(*)[4]>(
+        malloc(num_vertices * sizeof(*mesh->colors)));
+  }
+  return TANGO_SUCCESS;
+}
+
+TangoErrorType TangoSupport_copyMesh(const TangoMesh_Experimental* input_mesh,
+                                     TangoMesh_Experimental* output_mesh) {
+  if (input_mesh == nullptr || output_mesh == nullptr) {
+    return TANGO_INVALID;
+  }
+  *output_mesh = *input_mesh;
+  output_mesh->vertices =
+      CopyArray(input_mesh->vertices, input_mesh->num_vertices);
+  output_mesh->faces = CopyArray(input_mesh->faces, input_mesh->num_faces);
+  output_mesh->normals = input_mesh->has_normals
+                             ? CopyArray(input_mesh->normals,
+                                         input_mesh->num_vertices)
+                             : nullptr;
+  output_mesh->colors = input_mesh->has_colors
+                            ? CopyArray(input_mesh->colors,
+                                        input_mesh->num_vertices)
+                            : nullptr;
+  return TANGO_SUCCESS;
+}
+
+TangoErrorType TangoSupport_createSimplifiedMesh(
+    const TangoMesh_Experimental*, const uint32_t, TangoMesh_Experimental*) {
+  return TANGO_ERROR;
+}
+
+}  // extern "C"
@@ -0,0 +1,271 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+
+// Receives the datagrams of tango_gl::TelemetrySender on a UDP port, prints
+// the poses as CSV to stdout and optionally appends the complete depth frames
+// to a codec stream that point_cloud_decode turns into PLY files:
+//
+//   telemetry_receive 9000 depth.bin > poses.csv
+//
+// Lost datagrams and incomplete depth frames are counted on stderr, followed
+// by the last service probe histograms received, if the sender had the probe
+// enabled.
+
+#include <netinet/in.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include <tango-gl/service_probe.h>
+#include <tango-gl/telemetry_format.h>
+
+namespace telemetry = tango_gl::telemetry;
+typedef tango_gl::ServiceProbe ServiceProbe;
+
+namespace {
+volatile sig_atomic_t is_interrupted = 0;
+
+void OnInterrupt(int) { is_interrupted = 1; }
+
+// The depth frame being reassembled; fragments of older frames are dropped.
+struct Frame {
+  bool is_valid;
+  uint32_t id;
+  uint32_t received_size;
+  std::vector<uint8_t> data;
+  std::vector<bool> has_fragment;
+};
+
+struct Stats {
+  uint32_t packet_count;
+  uint32_t lost_packet_count;
+  uint32_t pose_count;
+  uint32_t frame_count;
+  uint32_t incomplete_frame_count;
+  // Newest histogram of each probe source, empty until one arrives.
+  ServiceProbe::Histogram probes[ServiceProbe::kSourceCount];
+};
+
+void ReceivePoses(const uint8_t* payload, size_t size, Stats* stats) {
+  telemetry::PoseBatchHeader header;
+  if (size < sizeof(header)) {
+    return;
+  }
+  memcpy(&header, payload, sizeof(header));
+  if (header.pose_count >
+      (size - sizeof(header)) / sizeof(telemetry::PoseRecord)) {
+    return;
+  }
+  for (uint32_t i = 0; i < header.pose_count; ++i) {
+    telemetry::PoseRecord pose;
+    memcpy(&pose,
+           payload + sizeof(header) + i * sizeof(telemetry::PoseRecord),
+           sizeof(pose));
+    printf("%.6f,%d,%d,%d,%f,%f,%f,%f,%f,%f,%f\n", pose.timestamp,
+           pose.base_frame, pose.target_frame, pose.status_code,
+           pose.translation[0], pose.translation[1], pose.translation[2],
+           pose.orientation[0], pose.orientation[1], pose.orientation[2],
+           pose.orientation[3]);
+  }
+  stats->pose_count += header.pose_count;
+}
+
+void ReceiveDepthFragment(const uint8_t* payload, size_t size, Frame* frame,
+                          FILE* output, Stats* stats) {
+  telemetry::DepthFragmentHeader header;
+  if (size < sizeof(header)) {
+    return;
+  }
+  memcpy(&header, payload, sizeof(header));
+  const size_t fragment_size = size - sizeof(header);
+  if (header.fragment_index >= header.fragment_count ||
+      header.offset > header.frame_size ||
+      fragment_size > header.frame_size - header.offset) {
+    return;
+  }
+  if (frame->is_valid && header.frame_id != frame->id) {
+    if (static_cast<int32_t>(header.frame_id - frame->id) < 0) {
+      return;
+    }
+    ++stats->incomplete_frame_count;
+    frame->is_valid = false;
+  }
+  if (!frame->is_valid) {
+    frame->is_valid = true;
+    frame->id = header.frame_id;
+    frame->received_size = 0;
+    frame->data.resize(header.frame_size);
+    frame->has_fragment.assign(header.fragment_count, false);
+  }
+  if (header.frame_size != frame->data.size() ||
+      header.fragment_count != frame->has_fragment.size() ||
+      frame->has_fragment[header.fragment_index]) {
+    return;
+  }
+  frame->has_fragment[header.fragment_index] = true;
+  memcpy(frame->data.data() + header.offset, payload + sizeof(header),
+         fragment_size);
+  frame->received_size += static_cast<uint32_t>(fragment_size);
+  if (frame->received_size < frame->data.size()) {
+    return;
+  }
+  frame->is_valid = false;
+  ++stats->frame_count;
+  if (output != nullptr) {
+    fwrite(frame->data.data(), 1, frame->data.size(), output);
+    fflush(output);
+  }
+}
+
+void ReceiveProbe(const uint8_t* payload, size_t size, Stats* stats) {
+  telemetry::ProbeRecord record;
+  if (size < sizeof(record)) {
+    return;
+  }
+  memcpy(&record, payload, sizeof(record));
+  if (record.source >= ServiceProbe::kSourceCount ||
+      record.bucket_count != ServiceProbe::kBucketCount ||
+      size - sizeof(record) < record.bucket_count * sizeof(uint32_t)) {
+    return;
+  }
+  ServiceProbe::Histogram& histogram = stats->probes[record.source];
+  // Histograms only grow, an older datagram arriving late is skipped.
+  if (record.count < histogram.count) {
+    return;
+  }
+  histogram.count = record.count;
+  histogram.sum_us = record.sum_us;
+  histogram.max_us = record.max_us;
+  histogram.early_count = record.early_count;
+  memcpy(histogram.buckets, payload + sizeof(record),
+         sizeof(histogram.buckets));
+}
+
+void PrintProbes(const Stats& stats) {
+  for (int i = 0; i < ServiceProbe::kSourceCount; ++i) {
+    const ServiceProbe::Histogram& histogram = stats.probes[i];
+    if (histogram.count == 0) {
+      continue;
+    }
+    fprintf(stderr,
+            "telemetry_receive: %s n %llu mean %.2f ms p50 %.2f ms p90 %.2f "
+            "ms p99 %.2f ms max %.2f ms jitter %.2f ms early %llu.\n",
+            ServiceProbe::GetName(static_cast<ServiceProbe::Source>(i)),
+            static_cast<unsigned long long>(histogram.count),
+            histogram.sum_us * 1e-3 / histogram.count,
+            histogram.GetPercentile(0.5f) * 1e-3f,
+            histogram.GetPercentile(0.9f) * 1e-3f,
+            histogram.GetPercentile(0.99f) * 1e-3f, histogram.max_us * 1e-3f,
+            histogram.GetJitter() * 1e-3f,
+            static_cast<unsigned long long>(histogram.early_count));
+  }
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc != 2 && argc != 3) {
+    fprintf(stderr, "usage: telemetry_receive <port> [depth stream]\n");
+    return EXIT_FAILURE;
+  }
+  const int udp_socket = socket(AF_INET6, SOCK_DGRAM, 0);
+  if (udp_socket < 0) {
+    fprintf(stderr, "telemetry_receive: could not create a socket.\n");
+    return EXIT_FAILURE;
+  }
+  // Accept IPv4 senders too.
+  int is_v6_only = 0;
+  setsockopt(udp_socket, IPPROTO_IPV6, IPV6_V6ONLY, &is_v6_only,
+             sizeof(is_v6_only));
+  sockaddr_in6 address;
+  memset(&address, 0, sizeof(address));
+  address.sin6_family = AF_INET6;
+  address.sin6_addr = in6addr_any;
+  address.sin6_port = htons(static_cast<uint16_t>(atoi(argv[1])));
+  if (bind(udp_socket, reinterpret_cast<sockaddr*>(&address),
+           sizeof(address)) != 0) {
+    fprintf(stderr, "telemetry_receive: could not bind port %s.\n", argv[1]);
+    return EXIT_FAILURE;
+  }
+  FILE* output = nullptr;
+  if (argc == 3) {
+    output = fopen(argv[2], "wb");
+    if (output == nullptr) {
+      fprintf(stderr, "telemetry_receive: could not create %s.\n", argv[2]);
+      return EXIT_FAILURE;
+    }
+  }
+  // Without SA_RESTART, so the interrupt also ends recv().
+  struct sigaction action;
+  memset(&action, 0, sizeof(action));
+  action.sa_handler = OnInterrupt;
+  sigaction(SIGINT, &action, nullptr);
+  sigaction(SIGTERM, &action, nullptr);
+
+  Frame frame;
+  frame.is_valid = false;
+  Stats stats = Stats();
+  bool has_sequence = false;
+  uint32_t next_sequence = 0;
+  std::vector<uint8_t> datagram(1 << 16);
+  while (!is_interrupted) {
+    const ssize_t size = recv(udp_socket, datagram.data(), datagram.size(), 0);
+    if (size < static_cast<ssize_t>(sizeof(telemetry::PacketHeader))) {
+      continue;
+    }
+    telemetry::PacketHeader header;
+    memcpy(&header, datagram.data(), sizeof(header));
+    if (header.magic != telemetry::kMagic ||
+        header.version != telemetry::kVersion) {
+      continue;
+    }
+    // A sequence going backwards is a restarted sender.
+    if (has_sequence &&
+        static_cast<int32_t>(header.sequence - next_sequence) > 0) {
+      stats.lost_packet_count += header.sequence - next_sequence;
+    }
+    has_sequence = true;
+    next_sequence = header.sequence + 1;
+    ++stats.packet_count;
+
+    const uint8_t* payload = datagram.data() + sizeof(header);
+    const size_t payload_size = size - sizeof(header);
+    if (header.type == telemetry::kPosePacket) {
+      ReceivePoses(payload, payload_size, &stats);
+    } else if (header.type == telemetry::kDepthPacket) {
+      ReceiveDepthFragment(payload, payload_size, &frame, output, &stats);
+    } else if (header.type == telemetry::kProbePacket) {
+      ReceiveProbe(payload, payload_size, &stats);
+    }
+  }
+  close(udp_socket);
+  if (output != nullptr) {
+    fclose(output);
+  }
+  fprintf(stderr,
+          "telemetry_receive: %u packets, %u lost, %u poses, %u depth frames, "
+          "%u incomplete.\n",
+          stats.packet_count, stats.lost_packet_count, stats.pose_count,
+          stats.frame_count, stats.incomplete_frame_count);
+  PrintProbes(stats);
+  return EXIT_SUCCESS;
+}
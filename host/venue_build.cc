@@ -0,0 +1,65 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// Converts an OBJ model into a venue file for tango_gl::VenueStreamer:
+//
+//   venue_build venue.obj venue.bin --chunk_size=8 --level_count=5
+//
+// --cluster_size sets the cluster edge of level 1 in meters.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <tango-gl/venue_builder.h>
+
+namespace {
+// Parse "--name=value" into value, false if arg is another option.
+bool ParseFloat(const char* arg, const char* name, float* value) {
+  const size_t length = strlen(name);
+  if (strncmp(arg, name, length) != 0 || arg[length] != '=') {
+    return false;
+  }
+  *value = static_cast<float>(atof(arg + length + 1));
+  return true;
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc < 3) {
+    fprintf(stderr,
+            "usage: venue_build <model.obj> <venue file> [--chunk_size=m] "
+            "[--level_count=n] [--cluster_size=m]\n");
+    return EXIT_FAILURE;
+  }
+  tango_gl::venue::BuildOptions options;
+  for (int i = 3; i < argc; ++i) {
+    float level_count = 0.0f;
+    if (ParseFloat(argv[i], "--level_count", &level_count)) {
+      options.level_count = static_cast<int>(level_count);
+    } else if (!ParseFloat(argv[i], "--chunk_size", &options.chunk_size) &&
+               !ParseFloat(argv[i], "--cluster_size", &options.cluster_size)) {
+      fprintf(stderr, "venue_build: unknown option %s.\n", argv[i]);
+      return EXIT_FAILURE;
+    }
+  }
+  if (!tango_gl::venue::Build(argv[1], argv[2], options)) {
+    fprintf(stderr, "venue_build: could not build %s.\n", argv[2]);
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
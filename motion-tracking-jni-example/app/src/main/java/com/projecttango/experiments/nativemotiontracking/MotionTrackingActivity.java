@@ -53,8 +53,8 @@ public class MotionTrackingActivity extends Activity implements
   private static final String TAG = MotionTrackingActivity.class.getSimpleName();
 
   // The interval at which we'll update our UI debug text in milliseconds.
-  // This is the rate at which we query our native wrapper around the tango
-  // service for pose and event information.
+  // This is the rate at which we read the pose and event information the
+  // native code publishes in mTelemetry.
   private static final int kUpdateIntervalMs = 100;
 
   // Debug information text.
@@ -66,12 +66,24 @@ public class MotionTrackingActivity extends Activity implements
   private TextView mAppVersion;
   // Latest Tango Event received.
   private TextView mEvent;
+  // Hot path counts of the last rendered frame.
+  private TextView mCounters;
+
+  // Pose, event and counter statistics shared with the native code, and the
+  // text they are formatted into.
+  private Telemetry mTelemetry;
+  private final StringBuilder mPoseText = new StringBuilder();
+  private final StringBuilder mEventText = new StringBuilder();
+  private final StringBuilder mCountersText = new StringBuilder();
 
   // Button for manually resetting motion tracking. Resetting motion tracking
   // will restart the tracking pipeline, which also means the user will have to
   // wait for re-initialization of the motion tracking system.
   private Button mMotionReset;
 
+  // Whether the top down inset is shown over the main view.
+  private boolean mIsInsetShown = false;
+
   // Auto recovery flag received from StartActivity.
   private boolean mIsAutoRecovery;
   // GLSurfaceView and its renderer, all of the graphic content is rendered
@@ -110,6 +122,9 @@ public class MotionTrackingActivity extends Activity implements
     // Text views for displaying most recent Tango Event
     mEvent = (TextView) findViewById(R.id.tango_event_textview);
 
+    // Text view for the hot path counters
+    mCounters = (TextView) findViewById(R.id.counters_textview);
+
     // Text views for Tango library versions
     mVersion = (TextView) findViewById(R.id.version_textview);
 
@@ -127,6 +142,7 @@ public class MotionTrackingActivity extends Activity implements
     findViewById(R.id.first_person_button).setOnClickListener(this);
     findViewById(R.id.third_person_button).setOnClickListener(this);
     findViewById(R.id.top_down_button).setOnClickListener(this);
+    findViewById(R.id.inset_button).setOnClickListener(this);
 
     // Button to reset motion tracking
     mMotionReset = (Button) findViewById(R.id.resetmotion);
@@ -153,6 +169,7 @@ public class MotionTrackingActivity extends Activity implements
     // between the application and Tango Service.
     // The activity object is used for checking if the API version is outdated.
     TangoJNINative.initialize(this);
+    mTelemetry = new Telemetry(TangoJNINative.getTelemetryBuffer());
 
     // UI thread handles the task of updating all debug text.
     startUIThread();
@@ -210,6 +227,10 @@ public class MotionTrackingActivity extends Activity implements
       case R.id.third_person_button:
         TangoJNINative.setCamera(1);
         break;
+      case R.id.inset_button:
+        mIsInsetShown = !mIsInsetShown;
+        TangoJNINative.setTopDownInset(mIsInsetShown);
+        break;
       case R.id.resetmotion:
         TangoJNINative.resetMotionTracking();
         break;
@@ -252,24 +273,33 @@ public class MotionTrackingActivity extends Activity implements
   
   // UI thread for handling debug text changes.
   private void startUIThread() {
+    // Only the blocks changed since the last refresh are formatted, and no
+    // JNI call is made.
+    final Runnable updateDebugText = new Runnable() {
+      @Override
+      public void run() {
+        try {
+          if (mTelemetry.readEvent(mEventText)) {
+            mEvent.setText(mEventText);
+          }
+          if (mTelemetry.readPose(mPoseText)) {
+            mPoseData.setText(mPoseText);
+          }
+          if (mTelemetry.readCounters(mCountersText)) {
+            mCounters.setText(mCountersText);
+          }
+        } catch (Exception e) {
+          e.printStackTrace();
+        }
+      }
+    };
     new Thread(new Runnable() {
       @Override
       public void run() {
         while (true) {
           try {
             Thread.sleep(kUpdateIntervalMs);
-            runOnUiThread(new Runnable() {
-              @Override
-              public void run() {
-                try {
-                  mEvent.setText(TangoJNINative.getEventString());
-                  mPoseData.setText(TangoJNINative.getPoseString());
-                } catch (Exception e) {
-                  e.printStackTrace();
-                }
-              }
-            });
-
+            runOnUiThread(updateDebugText);
           } catch (Exception e) {
             e.printStackTrace();
           }
@@ -58,16 +58,17 @@ public class TangoJNINative {
   // Set the render camera's viewing angle:
   //   first person, third person, or top down.
   public static native void setCamera(int cameraIndex);
+
+  // Show or hide a top down view of the device over the main view.
+  public static native void setTopDownInset(boolean isInsetShown);
   
   // Explicitly reset motion tracking and restart the pipeline.
   // Note that this will cause motion tracking to re-initialize.
   public static native void resetMotionTracking();
   
-  // Get the latest pose string from our application for display in our debug UI.
-  public static native String getPoseString();
-  
-  // Get the latest event string from our application for display in our debug UI.
-  public static native String getEventString();
+  // Get the native debug statistics block, read through Telemetry. The buffer
+  // stays valid for the lifetime of the process, map it once.
+  public static native java.nio.ByteBuffer getTelemetryBuffer();
   
   // Get the TangoCore version from our application for display in our debug UI.
   public static native String getVersionNumber();
@@ -0,0 +1,206 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+package com.projecttango.experiments.nativemotiontracking;
+
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
+
+// Reads the debug statistics the native code publishes in a direct ByteBuffer,
+// so refreshing the debug UI needs no JNI call.
+//
+// Each block starts with a sequence number which is odd while the native side
+// writes the block. A read is retried until the sequence is even and the same
+// before and after copying the fields. Java has no portable load fence, so a
+// torn read is caught in practice rather than guaranteed, at worst one refresh
+// of the debug text is garbled. The offsets mirror
+// tango-motion-tracking/telemetry.h.
+public class Telemetry {
+  private static final int POSE_SEQUENCE = 0;
+  private static final int POSE_STATUS = 4;
+  private static final int POSE_COUNT = 8;
+  private static final int POSE_TRANSLATION = 12;
+  private static final int POSE_ORIENTATION = 36;
+  private static final int POSE_DELTA_TIME = 68;
+  private static final int EVENT_SEQUENCE = 76;
+  private static final int EVENT_KEY = 80;
+  private static final int EVENT_KEY_LENGTH = 64;
+  private static final int EVENT_VALUE = 144;
+  private static final int EVENT_VALUE_LENGTH = 128;
+  private static final int COUNTERS_SEQUENCE = 272;
+  private static final int COUNTERS_VALUES = 276;
+
+  // Names of tango_gl::Counters, in the order of its enum.
+  private static final String[] COUNTER_NAMES = {
+      "buffer bytes", "texture bytes", "draw calls", "program binds",
+      "points projected", "poses", "depth outliers"};
+
+  private static final String[] POSE_STATUS_NAMES = {
+      "initializing", "valid", "invalid", "unknown"};
+
+  private final ByteBuffer mBuffer;
+
+  // Sequence of the last block read, a block is only read again once it
+  // changed.
+  private int mPoseSequence = -1;
+  private int mEventSequence = -1;
+  private int mCountersSequence = -1;
+
+  // Scratch storage reused by every read.
+  private final double[] mTranslation = new double[3];
+  private final double[] mOrientation = new double[4];
+  private final byte[] mKey = new byte[EVENT_KEY_LENGTH];
+  private final byte[] mValue = new byte[EVENT_VALUE_LENGTH];
+  private final long[] mCounters = new long[COUNTER_NAMES.length];
+
+  public Telemetry(ByteBuffer buffer) {
+    mBuffer = buffer.order(ByteOrder.nativeOrder());
+  }
+
+  // Format the latest pose into builder, in the form "status: valid, count: 1,
+  // ...". Returns false and leaves builder untouched if the pose did not
+  // change since the last call.
+  public boolean readPose(StringBuilder builder) {
+    int begin;
+    int status;
+    int count;
+    float deltaTimeMs;
+    do {
+      begin = mBuffer.getInt(POSE_SEQUENCE);
+      if (begin == mPoseSequence) {
+        return false;
+      }
+      status = mBuffer.getInt(POSE_STATUS);
+      count = mBuffer.getInt(POSE_COUNT);
+      for (int i = 0; i < mTranslation.length; ++i) {
+        mTranslation[i] = mBuffer.getDouble(POSE_TRANSLATION + 8 * i);
+      }
+      for (int i = 0; i < mOrientation.length; ++i) {
+        mOrientation[i] = mBuffer.getDouble(POSE_ORIENTATION + 8 * i);
+      }
+      deltaTimeMs = mBuffer.getFloat(POSE_DELTA_TIME);
+    } while ((begin & 1) != 0 || begin != mBuffer.getInt(POSE_SEQUENCE));
+    mPoseSequence = begin;
+
+    builder.setLength(0);
+    if (count == 0) {
+      // No pose received yet.
+      return true;
+    }
+    builder.append("status: ")
+        .append(status >= 0 && status < POSE_STATUS_NAMES.length
+                ? POSE_STATUS_NAMES[status] : "status_code_invalid")
+        .append(", count: ").append(count & 0xffffffffL)
+        .append(", delta time (ms): ");
+    appendFixed(builder, deltaTimeMs);
+    builder.append(", position (m): ");
+    appendVector(builder, mTranslation);
+    builder.append(", orientation: ");
+    appendVector(builder, mOrientation);
+    return true;
+  }
+
+  // Format the latest Tango event into builder as "key: value". Returns false
+  // and leaves builder untouched if the event did not change since the last
+  // call.
+  public boolean readEvent(StringBuilder builder) {
+    int begin;
+    do {
+      begin = mBuffer.getInt(EVENT_SEQUENCE);
+      if (begin == mEventSequence) {
+        return false;
+      }
+      for (int i = 0; i < EVENT_KEY_LENGTH; ++i) {
+        mKey[i] = mBuffer.get(EVENT_KEY + i);
+      }
+      for (int i = 0; i < EVENT_VALUE_LENGTH; ++i) {
+        mValue[i] = mBuffer.get(EVENT_VALUE + i);
+      }
+    } while ((begin & 1) != 0 || begin != mBuffer.getInt(EVENT_SEQUENCE));
+    mEventSequence = begin;
+
+    builder.setLength(0);
+    if (mKey[0] == 0) {
+      return true;
+    }
+    appendCString(builder, mKey);
+    builder.append(": ");
+    appendCString(builder, mValue);
+    return true;
+  }
+
+  // Format the hot path counts of the last rendered frame into builder, in
+  // the form "draw calls: 12, ...". Returns false and leaves builder untouched
+  // if no frame was rendered since the last call.
+  public boolean readCounters(StringBuilder builder) {
+    int begin;
+    do {
+      begin = mBuffer.getInt(COUNTERS_SEQUENCE);
+      if (begin == mCountersSequence) {
+        return false;
+      }
+      for (int i = 0; i < mCounters.length; ++i) {
+        mCounters[i] = mBuffer.getInt(COUNTERS_VALUES + 4 * i) & 0xffffffffL;
+      }
+    } while ((begin & 1) != 0 || begin != mBuffer.getInt(COUNTERS_SEQUENCE));
+    mCountersSequence = begin;
+
+    builder.setLength(0);
+    for (int i = 0; i < mCounters.length; ++i) {
+      if (i > 0) {
+        builder.append(", ");
+      }
+      builder.append(COUNTER_NAMES[i]).append(": ").append(mCounters[i]);
+    }
+    return true;
+  }
+
+  // Append value with three decimals, like the native "%.3f".
+  private static void appendFixed(StringBuilder builder, double value) {
+    long thousandths = Math.round(Math.abs(value) * 1000.0);
+    if (value < 0.0 && thousandths != 0) {
+      builder.append('-');
+    }
+    builder.append(thousandths / 1000).append('.');
+    long fraction = thousandths % 1000;
+    if (fraction < 100) {
+      builder.append('0');
+    }
+    if (fraction < 10) {
+      builder.append('0');
+    }
+    builder.append(fraction);
+  }
+
+  private static void appendVector(StringBuilder builder, double[] vector) {
+    builder.append('[');
+    for (int i = 0; i < vector.length; ++i) {
+      if (i > 0) {
+        builder.append(", ");
+      }
+      appendFixed(builder, vector[i]);
+    }
+    builder.append(']');
+  }
+
+  // Append a null terminated ASCII string.
+  private static void appendCString(StringBuilder builder, byte[] chars) {
+    for (int i = 0; i < chars.length && chars[i] != 0; ++i) {
+      builder.append((char) chars[i]);
+    }
+  }
+}
@@ -21,6 +21,11 @@ include $(CLEAR_VARS)
 LOCAL_MODULE    := libmotion_tracking_jni_example
 LOCAL_SHARED_LIBRARIES := tango_client_api
 LOCAL_CFLAGS    := -std=c++11
+# Per frame matrix math on NEON, part of the arm64-v8a baseline. armeabi-v7a
+# keeps the scalar glm path, see tango-gl/simd_math.h.
+ifeq ($(TARGET_ARCH_ABI),arm64-v8a)
+LOCAL_CFLAGS    += -DTANGO_GL_SIMD_MATH
+endif
 
 LOCAL_C_INCLUDES := $(PROJECT_ROOT)/tango-service-sdk/include/ \
                     $(PROJECT_ROOT)/tango-gl/include \
@@ -34,17 +39,40 @@ LOCAL_SRC_FILES := jni_interface.cc \
                    $(PROJECT_ROOT_FROM_JNI)/tango-gl/axis.cpp \
                    $(PROJECT_ROOT_FROM_JNI)/tango-gl/camera.cpp \
                    $(PROJECT_ROOT_FROM_JNI)/tango-gl/conversions.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/counters.cpp \
                    $(PROJECT_ROOT_FROM_JNI)/tango-gl/drawable_object.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/dynamic_resolution_target.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/frame_arena.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/frame_cache.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/frame_constants.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/geometry_registry.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/memory_tracker.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/minimap.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/occlusion_culler.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/point_cloud_pool.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/point_projection.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/program_cache.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/render_pass.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/render_state.cpp \
                    $(PROJECT_ROOT_FROM_JNI)/tango-gl/frustum.cpp \
                    $(PROJECT_ROOT_FROM_JNI)/tango-gl/gesture_camera.cpp \
                    $(PROJECT_ROOT_FROM_JNI)/tango-gl/grid.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/image_pool.cpp \
                    $(PROJECT_ROOT_FROM_JNI)/tango-gl/line.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/scene_graph.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/shader_variants.cpp \
                    $(PROJECT_ROOT_FROM_JNI)/tango-gl/shaders.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/tango_session.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/touch_queue.cpp \
                    $(PROJECT_ROOT_FROM_JNI)/tango-gl/trace.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/trajectory_store.cpp \
                    $(PROJECT_ROOT_FROM_JNI)/tango-gl/transform.cpp \
-                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/util.cpp
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/util.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/vertex_array.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/vertex_buffer.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/view_frustum.cpp
 
-LOCAL_LDLIBS    := -llog -lGLESv2 -L$(SYSROOT)/usr/lib
+LOCAL_LDLIBS    := -llog -lGLESv2 -lEGL -L$(SYSROOT)/usr/lib
 include $(BUILD_SHARED_LIBRARY)
 
 $(call import-add-path, $(PROJECT_ROOT))
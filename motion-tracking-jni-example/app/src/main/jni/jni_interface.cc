@@ -17,111 +17,118 @@
 #define GLM_FORCE_RADIANS
 
 #include <jni.h>
+#include <tango-gl/jni_natives.h>
 #include <tango-motion-tracking/motion_tracking_app.h>
 #include <tango-motion-tracking/scene.h>
 
-static tango_motion_tracking::MotiongTrackingApp app;
+namespace {
+tango_motion_tracking::MotiongTrackingApp app;
 
-#ifdef __cplusplus
-extern "C" {
-#endif
-JNIEXPORT jint JNICALL
-Java_com_projecttango_experiments_nativemotiontracking_TangoJNINative_initialize(
-    JNIEnv* env, jobject, jobject activity) {
+jint Initialize(JNIEnv* env, jobject, jobject activity) {
   return app.TangoInitialize(env, activity);
 }
 
-JNIEXPORT jint JNICALL
-Java_com_projecttango_experiments_nativemotiontracking_TangoJNINative_setupConfig(
-    JNIEnv*, jobject, bool is_auto_reset) {
+jint SetupConfig(JNIEnv*, jobject, bool is_auto_reset) {
   return app.TangoSetupConfig(is_auto_reset);
 }
 
-JNIEXPORT jint JNICALL
-Java_com_projecttango_experiments_nativemotiontracking_TangoJNINative_connect(
-    JNIEnv*, jobject) {
+jint Connect(JNIEnv*, jobject) {
   return app.TangoConnect();
 }
 
-JNIEXPORT jint JNICALL
-Java_com_projecttango_experiments_nativemotiontracking_TangoJNINative_connectCallbacks(
-    JNIEnv*, jobject) {
+jint ConnectCallbacks(JNIEnv*, jobject) {
   int ret = app.TangoConnectCallbacks();
   return ret;
 }
 
-JNIEXPORT void JNICALL
-Java_com_projecttango_experiments_nativemotiontracking_TangoJNINative_disconnect(
-    JNIEnv*, jobject) {
+void Disconnect(JNIEnv*, jobject) {
   app.TangoDisconnect();
 }
 
-JNIEXPORT void JNICALL
-Java_com_projecttango_experiments_nativemotiontracking_TangoJNINative_resetMotionTracking(
-    JNIEnv*, jobject) {
+void ResetMotionTracking(JNIEnv*, jobject) {
   app.TangoResetMotionTracking();
 }
 
-JNIEXPORT void JNICALL
-Java_com_projecttango_experiments_nativemotiontracking_TangoJNINative_initGlContent(
-    JNIEnv*, jobject) {
+void InitGlContent(JNIEnv*, jobject) {
   app.InitializeGLContent();
 }
 
-JNIEXPORT void JNICALL
-Java_com_projecttango_experiments_nativemotiontracking_TangoJNINative_setupGraphic(
-    JNIEnv*, jobject, jint width, jint height) {
+void SetupGraphic(JNIEnv*, jobject, jint width, jint height) {
   app.SetViewPort(width, height);
 }
 
-JNIEXPORT void JNICALL
-Java_com_projecttango_experiments_nativemotiontracking_TangoJNINative_render(
-    JNIEnv*, jobject) {
+void Render(JNIEnv*, jobject) {
   app.Render();
 }
 
-JNIEXPORT void JNICALL
-Java_com_projecttango_experiments_nativemotiontracking_TangoJNINative_freeGLContent(
-    JNIEnv*, jobject) {
+void FreeGLContent(JNIEnv*, jobject) {
   app.FreeGLContent();
 }
 
-JNIEXPORT jstring JNICALL
-Java_com_projecttango_experiments_nativemotiontracking_TangoJNINative_getPoseString(
-    JNIEnv* env, jobject) {
-  return (env)->NewStringUTF(app.GetPoseString().c_str());
+jobject GetTelemetryBuffer(JNIEnv* env, jobject) {
+  return (env)->NewDirectByteBuffer(app.GetTelemetry(),
+                                    sizeof(tango_motion_tracking::Telemetry));
 }
 
-JNIEXPORT jstring JNICALL
-Java_com_projecttango_experiments_nativemotiontracking_TangoJNINative_getEventString(
-    JNIEnv* env, jobject) {
-  return (env)->NewStringUTF(app.GetEventString().c_str());
-}
-
-JNIEXPORT jstring JNICALL
-Java_com_projecttango_experiments_nativemotiontracking_TangoJNINative_getVersionNumber(
-    JNIEnv* env, jobject) {
+jstring GetVersionNumber(JNIEnv* env, jobject) {
   return (env)->NewStringUTF(app.GetVersionString().c_str());
 }
 
-JNIEXPORT void JNICALL
-Java_com_projecttango_experiments_nativemotiontracking_TangoJNINative_setCamera(
-    JNIEnv*, jobject, int camera_index) {
+void SetCamera(JNIEnv*, jobject, int camera_index) {
   using namespace tango_gl;
   GestureCamera::CameraType cam_type =
       static_cast<GestureCamera::CameraType>(camera_index);
   app.SetCameraType(cam_type);
 }
 
-JNIEXPORT void JNICALL
-Java_com_projecttango_experiments_nativemotiontracking_TangoJNINative_onTouchEvent(
-    JNIEnv*, jobject, int touch_count, int event, float x0, float y0, float x1,
-    float y1) {
+void SetTopDownInset(JNIEnv*, jobject, jboolean is_inset_shown) {
+  app.SetTopDownInset(is_inset_shown);
+}
+
+void OnTouchEvent(JNIEnv*, jobject, int touch_count, int event, float x0,
+                  float y0, float x1, float y1) {
   using namespace tango_gl;
   GestureCamera::TouchEvent touch_event =
       static_cast<GestureCamera::TouchEvent>(event);
   app.OnTouchEvent(touch_count, touch_event, x0, y0, x1, y1);
 }
+
+// onTouchEvent() only queues the touch for the next frame, so it is a fast
+// native call. render() runs for milliseconds and stays a regular call, see
+// tango_gl::jni::RegisterNatives().
+const JNINativeMethod kNativeMethods[] = {
+    {"initialize",
+     "(Lcom/projecttango/experiments/nativemotiontracking/"
+     "MotionTrackingActivity;)I",
+     reinterpret_cast<void*>(Initialize)},
+    {"setupConfig", "(Z)I", reinterpret_cast<void*>(SetupConfig)},
+    {"connect", "()I", reinterpret_cast<void*>(Connect)},
+    {"connectCallbacks", "()I", reinterpret_cast<void*>(ConnectCallbacks)},
+    {"disconnect", "()V", reinterpret_cast<void*>(Disconnect)},
+    {"resetMotionTracking", "()V",
+     reinterpret_cast<void*>(ResetMotionTracking)},
+    {"initGlContent", "()V", reinterpret_cast<void*>(InitGlContent)},
+    {"setupGraphic", "(II)V", reinterpret_cast<void*>(SetupGraphic)},
+    {"render", "()V", reinterpret_cast<void*>(Render)},
+    {"freeGLContent", "()V", reinterpret_cast<void*>(FreeGLContent)},
+    {"getTelemetryBuffer", "()Ljava/nio/ByteBuffer;",
+     reinterpret_cast<void*>(GetTelemetryBuffer)},
+    {"getVersionNumber", "()Ljava/lang/String;",
+     reinterpret_cast<void*>(GetVersionNumber)},
+    {"setCamera", "(I)V", reinterpret_cast<void*>(SetCamera)},
+    {"setTopDownInset", "(Z)V", reinterpret_cast<void*>(SetTopDownInset)},
+    {"onTouchEvent", "!(IIFFFF)V", reinterpret_cast<void*>(OnTouchEvent)},
+};
+}  // namespace
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+jint JNI_OnLoad(JavaVM* vm, void*) {
+  return tango_gl::jni::RegisterNatives(
+      vm, "com/projecttango/experiments/nativemotiontracking/TangoJNINative",
+      kNativeMethods);
+}
 #ifdef __cplusplus
 }
 #endif
@@ -15,57 +15,36 @@
  */
 
 #include <tango-gl/conversions.h>
+#include <tango-gl/counters.h>
+#include <tango-gl/program_cache.h>
+#include <tango-gl/render_state.h>
 
 #include "tango-motion-tracking/motion_tracking_app.h"
 
 namespace {
 const int kVersionStringLength = 128;
-
-// This function routes onPoseAvailable callbacks to the application object for
-// handling.
-//
-// @param context, context will be a pointer to a MotionTrackingApplication
-//        instance on which to call callbacks.
-// @param pose, pose data to route to onPoseAvailable function.
-void onPoseAvailableRouter(void* context, const TangoPoseData* pose) {
-  using namespace tango_motion_tracking;
-  MotiongTrackingApp* app = static_cast<MotiongTrackingApp*>(context);
-  app->onPoseAvailable(pose);
-}
-
-// This function routes onTangoEvent callbacks to the application object for
-// handling.
-//
-// @param context, context will be a pointer to a MotionTrackingApplication
-//        instance on which to call callbacks.
-// @param event, TangoEvent to route to onTangoEventAvailable function.
-void onTangoEventAvailableRouter(void* context, const TangoEvent* event) {
-  using namespace tango_motion_tracking;
-  MotiongTrackingApp* app = static_cast<MotiongTrackingApp*>(context);
-  app->onTangoEventAvailable(event);
-}
 }  // namespace
 
 namespace tango_motion_tracking {
 void MotiongTrackingApp::onPoseAvailable(const TangoPoseData* pose) {
-  std::lock_guard<std::mutex> lock(pose_mutex_);
+  tango_gl::Counters::Increment(tango_gl::Counters::kPosesReceived);
   pose_data_.UpdatePose(pose);
+  telemetry_.pose.Store(pose_data_.GetPoseTelemetry());
 }
 
 void MotiongTrackingApp::onTangoEventAvailable(const TangoEvent* event) {
-  std::lock_guard<std::mutex> lock(tango_event_mutex_);
   tango_event_data_.UpdateTangoEvent(event);
+  telemetry_.event.Store(tango_event_data_.GetEventTelemetry());
 }
 
 MotiongTrackingApp::MotiongTrackingApp() {}
 
-MotiongTrackingApp::~MotiongTrackingApp() {
-  if (tango_config_ != nullptr) {
-    TangoConfig_free(tango_config_);
-  }
-}
+MotiongTrackingApp::~MotiongTrackingApp() {}
 
 int MotiongTrackingApp::TangoInitialize(JNIEnv* env, jobject caller_activity) {
+  // Linked shader programs are persisted in the app cache directory.
+  tango_gl::program_cache::SetBinaryCacheDirectory(env, caller_activity);
+
   // The first thing we need to do for any Tango enabled application is to
   // initialize the service. We'll do that here, passing on the JNI environment
   // and jobject corresponding to the Android activity that is calling us.
@@ -74,27 +53,29 @@ int MotiongTrackingApp::TangoInitialize(JNIEnv* env, jobject caller_activity) {
 
 int MotiongTrackingApp::TangoSetupConfig(bool is_atuo_recovery) {
   // Here, we'll configure the service to run in the way we'd want. For this
-  // application, we'll start from the default configuration
-  // (TANGO_CONFIG_DEFAULT). This enables basic motion tracking capabilities.
-  tango_config_ = TangoService_getConfig(TANGO_CONFIG_DEFAULT);
-  if (tango_config_ == nullptr) {
-    LOGE("MotiongTrackingApp: Failed to get default config form");
-    return TANGO_ERROR;
-  }
-
-  // Set auto-recovery for motion tracking as requested by the user.
-  int ret = TangoConfig_setBool(tango_config_, "config_enable_auto_recovery",
-                                is_atuo_recovery);
+  // application, the session starts from the default configuration
+  // (TANGO_CONFIG_DEFAULT), which enables basic motion tracking capabilities,
+  // and only needs the device pose with respect to start of service.
+  tango_gl::TangoSession::Options options;
+  options.enable_depth = false;
+  options.enable_auto_recovery = is_atuo_recovery;
+  options.frame_pairs.push_back(
+      {TANGO_COORDINATE_FRAME_START_OF_SERVICE, TANGO_COORDINATE_FRAME_DEVICE});
+
+  // The options of a session are fixed, so auto-recovery as requested by the
+  // user takes a new one. The previous one is disconnected already.
+  session_.reset(new tango_gl::TangoSession(options));
+  int ret = session_->SetupConfig();
   if (ret != TANGO_SUCCESS) {
-    LOGE("MotiongTrackingApp: config_enable_auto_recovery() failed with error"
-         "code: %d", ret);
+    LOGE("MotiongTrackingApp: Failed to set up the config with error code: %d",
+         ret);
     return ret;
   }
 
   // Get TangoCore version string from service.
   char tango_core_version[kVersionStringLength];
   ret = TangoConfig_getString(
-      tango_config_, "tango_service_library_version",
+      session_->GetConfig(), "tango_service_library_version",
       tango_core_version, kVersionStringLength);
   if (ret != TANGO_SUCCESS) {
     LOGE(
@@ -109,86 +90,75 @@ int MotiongTrackingApp::TangoSetupConfig(bool is_atuo_recovery) {
 }
 
 int MotiongTrackingApp::TangoConnectCallbacks() {
-  // Setting up the frame pair for the onPoseAvailable callback.
-  TangoCoordinateFramePair pairs;
-  pairs.base = TANGO_COORDINATE_FRAME_START_OF_SERVICE;
-  pairs.target = TANGO_COORDINATE_FRAME_DEVICE;
-
-  // Attach onPoseAvailable callback.
-  // The callback will be called after the service is connected.
-  int ret =
-      TangoService_connectOnPoseAvailable(1, &pairs, onPoseAvailableRouter);
-  if (ret != TANGO_SUCCESS) {
-    LOGE("MotiongTrackingApp: Failed to connect to pose callback with error"
-         "code: %d", ret);
-    return ret;
-  }
-
-  // Attach onEventAvailable callback.
-  // The callback will be called after the service is connected.
-  ret = TangoService_connectOnTangoEvent(onTangoEventAvailableRouter);
-  if (ret != TANGO_SUCCESS) {
-    LOGE("MotiongTrackingApp: Failed to connect to event callback with error"
-         "code: %d", ret);
-    return ret;
+  if (!session_) {
+    LOGE("MotiongTrackingApp: Callbacks connected before the config");
+    return TANGO_ERROR;
   }
-  return ret;
+  // The session connects the pose and event callbacks to the service, and
+  // hands each pose and event to these on the callback thread once connected.
+  session_->AddPoseHandler(
+      [this](const TangoPoseData& pose) { onPoseAvailable(&pose); });
+  session_->AddEventHandler(
+      [this](const TangoEvent& event) { onTangoEventAvailable(&event); });
+  return TANGO_SUCCESS;
 }
 
 // Connect to Tango Service, service will start running, and
 // pose can be queried.
 int MotiongTrackingApp::TangoConnect() {
-  TangoErrorType ret = TangoService_connect(this, tango_config_);
-  if (ret != TANGO_SUCCESS) {
-    LOGE("MotiongTrackingApp: Failed to connect to the Tango service with"
-         "error code: %d", ret);
-    return ret;
+  if (!session_) {
+    LOGE("MotiongTrackingApp: Connected before the config");
+    return TANGO_ERROR;
   }
-  return ret;
+  return session_->Connect();
 }
 
 void MotiongTrackingApp::TangoDisconnect() {
-  // When disconnecting from the Tango Service, it is important to make sure to
-  // free your configuration object. Note that disconnecting from the service,
-  // resets all configuration, and disconnects all callbacks. If an application
-  // resumes after disconnecting, it must re-register configuration and
-  // callbacks with the service.
-  TangoConfig_free(tango_config_);
-  tango_config_ = nullptr;
-  TangoService_disconnect();
+  // Disconnecting from the Tango Service resets all configuration and
+  // disconnects all callbacks. If an application resumes after disconnecting,
+  // it must set up a config and callbacks again, with a new session. The
+  // config of this one is freed with it.
+  if (session_) {
+    session_->Disconnect();
+  }
 }
 
 void MotiongTrackingApp::TangoResetMotionTracking() {
   TangoService_resetMotionTracking();
 }
 
-void MotiongTrackingApp::InitializeGLContent() { main_scene_.InitGLContent(); }
+void MotiongTrackingApp::InitializeGLContent() {
+  // Anything RenderState remembers belongs to the previous GL context.
+  tango_gl::RenderState::Invalidate();
+  main_scene_.InitGLContent();
+}
 
 void MotiongTrackingApp::SetViewPort(int width, int height) {
   main_scene_.SetupViewPort(width, height);
 }
 
 void MotiongTrackingApp::Render() {
-  // Query current pose data.
-  TangoPoseData cur_pose;
-  {
-    std::lock_guard<std::mutex> lock(pose_mutex_);
-    cur_pose = pose_data_.GetCurrentPoseData();
+  tango_gl::RenderState::BeginFrame();
+  touch_queue_.Drain([this](const tango_gl::TouchQueue::Touch& touch) {
+    main_scene_.OnTouchEvent(touch.touch_count, touch.event, touch.x0,
+                             touch.y0, touch.x1, touch.y1);
+  });
+  Telemetry::Counters counters;
+  for (int i = 0; i < tango_gl::Counters::kCounterCount; ++i) {
+    counters.values[i] =
+        static_cast<uint32_t>(tango_gl::Counters::GetFrameValue(
+            static_cast<tango_gl::Counters::Counter>(i)));
   }
+  telemetry_.counters.Store(counters);
+
+  // Query current pose data.
+  TangoPoseData cur_pose = pose_data_.GetCurrentPoseData();
   main_scene_.Render(cur_pose);
 }
 
 void MotiongTrackingApp::FreeGLContent() { main_scene_.FreeGLContent(); }
 
-std::string MotiongTrackingApp::GetPoseString() {
-  std::lock_guard<std::mutex> lock(pose_mutex_);
-  return pose_data_.GetPoseDebugString();
-}
-
-std::string MotiongTrackingApp::GetEventString() {
-  std::lock_guard<std::mutex> lock(tango_event_mutex_);
-  return tango_event_data_.GetTangoEventString().c_str();
-}
+Telemetry* MotiongTrackingApp::GetTelemetry() { return &telemetry_; }
 
 std::string MotiongTrackingApp::GetVersionString() {
   return tango_core_version_string_.c_str();
@@ -199,10 +169,14 @@ void MotiongTrackingApp::SetCameraType(
   main_scene_.SetCameraType(camera_type);
 }
 
+void MotiongTrackingApp::SetTopDownInset(bool is_inset_shown) {
+  main_scene_.SetTopDownInset(is_inset_shown);
+}
+
 void MotiongTrackingApp::OnTouchEvent(int touch_count,
                                       tango_gl::GestureCamera::TouchEvent event,
                                       float x0, float y0, float x1, float y1) {
-  main_scene_.OnTouchEvent(touch_count, event, x0, y0, x1, y1);
+  touch_queue_.Push(touch_count, event, x0, y0, x1, y1);
 }
 
 }  // namespace tango_motion_tracking
@@ -14,77 +14,55 @@
  * limitations under the License.
  */
 
-#include <sstream>
-
 #include "tango-motion-tracking/pose_data.h"
 
 namespace {
-const float kMeterToMillimeter = 1000.0f;
+const float kSecondToMillisecond = 1000.0f;
 }  // namespace
 
 namespace tango_motion_tracking {
 
-PoseData::PoseData() {}
+PoseData::PoseData() : prev_pose_(), pose_counter_(0) {}
 
 PoseData::~PoseData() {}
 
 void PoseData::UpdatePose(const TangoPoseData* pose_data) {
-  cur_pose_ = *pose_data;
-
-  if (prev_pose_.status_code != cur_pose_.status_code) {
+  if (prev_pose_.status_code != pose_data->status_code) {
     // Reset pose counter when the status changed.
     pose_counter_ = 0;
   }
 
   // Increase pose counter.
   ++pose_counter_;
-  FormatPoseString();
-  prev_pose_ = cur_pose_;
-}
-
-std::string PoseData::GetPoseDebugString() { return pose_string_; }
 
-TangoPoseData PoseData::GetCurrentPoseData() {
-  return cur_pose_;
+  PoseSnapshot snapshot;
+  snapshot.cur_pose = *pose_data;
+  snapshot.delta_time = pose_data->timestamp - prev_pose_.timestamp;
+  snapshot.pose_counter = pose_counter_;
+  snapshot_.Store(snapshot);
+  prev_pose_ = *pose_data;
 }
 
-std::string PoseData::GetStringFromStatusCode(TangoPoseStatusType status) {
-  std::string ret_string;
-  switch (status) {
-    case TANGO_POSE_INITIALIZING:
-      ret_string = "initializing";
-      break;
-    case TANGO_POSE_VALID:
-      ret_string = "valid";
-      break;
-    case TANGO_POSE_INVALID:
-      ret_string = "invalid";
-      break;
-    case TANGO_POSE_UNKNOWN:
-      ret_string = "unknown";
-      break;
-    default:
-      ret_string = "status_code_invalid";
-      break;
+Telemetry::Pose PoseData::GetPoseTelemetry() {
+  PoseSnapshot snapshot = snapshot_.Load();
+  const TangoPoseData& pose = snapshot.cur_pose;
+  Telemetry::Pose telemetry;
+  telemetry.status = pose.status_code;
+  telemetry.count = static_cast<uint32_t>(snapshot.pose_counter);
+  for (int i = 0; i < 3; ++i) {
+    telemetry.translation[i] = pose.translation[i];
+  }
+  for (int i = 0; i < 4; ++i) {
+    telemetry.orientation[i] = pose.orientation[i];
   }
-  return ret_string;
+  telemetry.delta_time_ms =
+      static_cast<float>(snapshot.delta_time * kSecondToMillisecond);
+  telemetry.reserved = 0;
+  return telemetry;
 }
 
-void PoseData::FormatPoseString() {
-  std::stringstream string_stream;
-  string_stream.setf(std::ios_base::fixed, std::ios_base::floatfield);
-  string_stream.precision(3);
-  string_stream << "status: " << GetStringFromStatusCode(cur_pose_.status_code)
-                << ", count: " << pose_counter_ << ", delta time (ms): "
-                << (cur_pose_.timestamp - prev_pose_.timestamp) *
-                       kMeterToMillimeter << ", position (m): ["
-                << cur_pose_.translation[0] << ", " << cur_pose_.translation[1]
-                << ", " << cur_pose_.translation[2] << "]"
-                << ", orientation: [" << cur_pose_.orientation[0] << ", "
-                << cur_pose_.orientation[1] << ", " << cur_pose_.orientation[2]
-                << ", " << cur_pose_.orientation[3] << "]";
-  pose_string_ = string_stream.str();
-  string_stream.flush();
+TangoPoseData PoseData::GetCurrentPoseData() {
+  return snapshot_.Load().cur_pose;
 }
 
 } //namespace tango_motion_tracking
\ No newline at end of file
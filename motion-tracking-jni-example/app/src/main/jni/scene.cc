@@ -15,6 +15,7 @@
  */
 
 #include <tango-gl/conversions.h>
+#include <tango-gl/render_state.h>
 
 #include "tango-motion-tracking/scene.h"
 
@@ -33,15 +34,30 @@ const tango_gl::Color kGridColor(0.85f, 0.85f, 0.85f);
 
 // Frustum scale.
 const glm::vec3 kFrustumScale = glm::vec3(0.4f, 0.3f, 0.5f);
+
+// Size of the top down inset as a fraction of the screen, and its margin to
+// the top right corner in pixels.
+const float kInsetScale = 0.35f;
+const int kInsetMargin = 16;
+
+// Colors of the top down inset: its background, slightly darker than the
+// main view so the two can be told apart, the ground grid, the trajectory and
+// the device.
+const glm::vec4 kInsetClearColor(0.92f, 0.92f, 0.92f, 1.0f);
+const glm::vec4 kInsetGridColor(0.8f, 0.8f, 0.8f, 1.0f);
+const glm::vec4 kInsetDeviceColor(0.9f, 0.3f, 0.1f, 1.0f);
 }  // namespace
 
 namespace tango_motion_tracking {
 
-Scene::Scene() {}
+Scene::Scene()
+    : is_inset_shown_(false), viewport_width_(0), viewport_height_(0) {}
 
 Scene::~Scene() {}
 
 void Scene::InitGLContent() {
+  frame_cache_.Invalidate();
+  minimap_.Invalidate();
   // Allocating render camera and drawable object.
   // All of these objects are for visualization purposes.
   gesture_camera_ = new tango_gl::GestureCamera();
@@ -56,11 +72,27 @@ void Scene::InitGLContent() {
 
   trace_->SetColor(kTraceColor);
   grid_->SetColor(kGridColor);
+  // The procedural grid follows the camera, so it does not end when the
+  // user walks away from the start of the session.
+  const bool is_grid_procedural = grid_->SetProcedural(true);
   gesture_camera_->SetCameraType(
       tango_gl::GestureCamera::CameraType::kThirdPerson);
+  minimap_.SetColors(kInsetClearColor, kInsetGridColor,
+                     glm::vec4(kTraceColor.r, kTraceColor.g, kTraceColor.b,
+                               1.0f),
+                     kInsetDeviceColor);
+
+  scene_graph_.Add(frustum_, tango_gl::SceneGraph::kOpaque);
+  scene_graph_.Add(axis_, tango_gl::SceneGraph::kOpaque);
+  scene_graph_.Add(trace_, tango_gl::SceneGraph::kOpaque);
+  scene_graph_.Add(grid_, is_grid_procedural
+                              ? tango_gl::SceneGraph::kTransparent
+                              : tango_gl::SceneGraph::kOpaque);
 }
 
 void Scene::FreeGLContent() {
+  scene_graph_.Clear();
+  minimap_.Release();
   delete gesture_camera_;
   delete axis_;
   delete frustum_;
@@ -74,16 +106,13 @@ void Scene::SetupViewPort(int w, int h) {
   }
   gesture_camera_->SetAspectRatio(static_cast<float>(w) /
                                   static_cast<float>(h));
+  viewport_width_ = w;
+  viewport_height_ = h;
+  frame_cache_.SetViewport(0, 0, w, h);
   glViewport(0, 0, w, h);
 }
 
 void Scene::Render(const TangoPoseData& cur_pose) {
-  glEnable(GL_DEPTH_TEST);
-  glEnable(GL_CULL_FACE);
-
-  glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
-  glClear(GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT);
-
   // Convert pose data to vec3 for position and quaternion for orientation.
   // Note that the pose data we received here is in the Tango device frame with
   // respect to the Tango start service frame.
@@ -108,38 +137,73 @@ void Scene::Render(const TangoPoseData& cur_pose) {
 
   position += kHeightOffset;
 
-  if (gesture_camera_->GetCameraType() ==
-      tango_gl::GestureCamera::CameraType::kFirstPerson) {
+  const bool is_first_person =
+      gesture_camera_->GetCameraType() ==
+      tango_gl::GestureCamera::CameraType::kFirstPerson;
+  if (is_first_person) {
     // In first person mode, we directly control camera's motion.
     gesture_camera_->SetPosition(position);
     gesture_camera_->SetRotation(rotation);
   } else {
     // In third person or top down more, we follow the camera movement.
     gesture_camera_->SetAnchorPosition(position);
+  }
 
-    frustum_->SetPosition(position);
-    frustum_->SetRotation(rotation);
-    frustum_->Render(gesture_camera_->GetProjectionMatrix(),
-                     gesture_camera_->GetViewMatrix());
+  // The device is hidden in the first person view, which it would block. The
+  // inset still shows it with a marker.
+  frustum_->SetPosition(position);
+  frustum_->SetRotation(rotation);
+  axis_->SetPosition(position);
+  axis_->SetRotation(rotation);
+  scene_graph_.SetVisible(frustum_, !is_first_person);
+  scene_graph_.SetVisible(axis_, !is_first_person);
 
-    axis_->SetPosition(position);
-    axis_->SetRotation(rotation);
-    axis_->Render(gesture_camera_->GetProjectionMatrix(),
-                  gesture_camera_->GetViewMatrix());
+  trace_->UpdateVertexArray(position);
+  // The trajectory is recorded while the inset is hidden, and drawn into
+  // the minimap once it shows.
+  minimap_.AddPosition(position);
+  if (is_inset_shown_) {
+    minimap_.Update(position);
   }
 
-  trace_->UpdateVertexArray(position);
-  trace_->Render(gesture_camera_->GetProjectionMatrix(),
-                 gesture_camera_->GetViewMatrix());
+  // A still device seen from a still camera is presented from the cache.
+  frame_cache_.AddInput(gesture_camera_->GetProjectionMatrix());
+  frame_cache_.AddInput(gesture_camera_->GetViewMatrix());
+  frame_cache_.AddInput(frustum_->GetTransformationMatrix());
+  frame_cache_.AddInput(is_first_person ? 1.0 : 0.0);
+  frame_cache_.AddInput(is_inset_shown_ ? 1.0 : 0.0);
+  if (!frame_cache_.Begin()) {
+    return;
+  }
+
+  tango_gl::RenderState::Enable(GL_DEPTH_TEST);
+  tango_gl::RenderState::Enable(GL_CULL_FACE);
+
+  glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
+  glClear(GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT);
 
-  grid_->Render(gesture_camera_->GetProjectionMatrix(),
-                gesture_camera_->GetViewMatrix());
+  scene_graph_.Render(gesture_camera_->GetProjectionMatrix(),
+                      gesture_camera_->GetViewMatrix(), nullptr);
+  if (is_inset_shown_) {
+    const GLsizei inset_width =
+        static_cast<GLsizei>(viewport_width_ * kInsetScale);
+    const GLsizei inset_height =
+        static_cast<GLsizei>(viewport_height_ * kInsetScale);
+    minimap_.Composite(viewport_width_ - inset_width - kInsetMargin,
+                       viewport_height_ - inset_height - kInsetMargin,
+                       inset_width, inset_height, position, rotation);
+  }
+  frame_cache_.End();
 }
 
 void Scene::SetCameraType(tango_gl::GestureCamera::CameraType camera_type) {
   gesture_camera_->SetCameraType(camera_type);
 }
 
+void Scene::SetTopDownInset(bool is_inset_shown) {
+  is_inset_shown_ = is_inset_shown;
+}
+
 void Scene::OnTouchEvent(int touch_count,
                          tango_gl::GestureCamera::TouchEvent event, float x0,
                          float y0, float x1, float y1) {
@@ -21,11 +21,14 @@
 #include <memory>
 
 #include <tango_client_api.h>  // NOLINT
+#include <tango-gl/tango_session.h>
+#include <tango-gl/touch_queue.h>
 #include <tango-gl/util.h>
 
 #include <tango-motion-tracking/pose_data.h>
 #include <tango-motion-tracking/scene.h>
 #include <tango-motion-tracking/tango_event_data.h>
+#include <tango-motion-tracking/telemetry.h>
 
 
 namespace tango_motion_tracking {
@@ -48,7 +51,8 @@ class MotiongTrackingApp {
   // @param is_auto_reset: set auto reset flag.
   int TangoSetupConfig(bool is_atuo_recovery);
 
-  // Connect the onPoseAvailable callback.
+  // Register the pose and event callbacks with the session set up by
+  // TangoSetupConfig().
   int TangoConnectCallbacks();
 
   // Connect to Tango Service.
@@ -88,11 +92,9 @@ class MotiongTrackingApp {
   // Release all OpenGL resources that allocate from the program.
   void FreeGLContent();
 
-  // Retrun pose debug string.
-  std::string GetPoseString();
-
-  // Retrun Tango event debug string.
-  std::string GetEventString();
+  // Return the debug statistics block, which the Java activity maps as a
+  // direct ByteBuffer once at startup. It lives as long as the app object.
+  Telemetry* GetTelemetry();
 
   // Retrun Tango Service version string.
   std::string GetVersionString();
@@ -103,8 +105,12 @@ class MotiongTrackingApp {
   //         top down
   void SetCameraType(tango_gl::GestureCamera::CameraType camera_type);
 
+  // Show or hide the top down inset over the main view.
+  void SetTopDownInset(bool is_inset_shown);
+
   // Touch event passed from android activity. This function only supports two
-  // touches.
+  // touches. Called on the UI thread, the event is queued and applied by the
+  // next Render().
   //
   // @param: touch_count, total count for touches.
   // @param: event, touch event of current touch.
@@ -120,29 +126,26 @@ class MotiongTrackingApp {
   // in this object will be routed to pose_data_ to handle.
   PoseData pose_data_;
 
-  // Mutex for protecting the pose data. The pose data is shared between render
-  // thread and TangoService callback thread.
-  std::mutex pose_mutex_;
-
   // tango_event_data_ handles all Tango event callbacks,
   // onTangoEventAvailable() in this object will be routed to tango_event_data_
   // to handle.
   TangoEventData tango_event_data_;
 
-  // tango_event_data_ is share between the UI thread we start for updating
-  // debug
-  // texts and the TangoService event callback thread. We keep event_mutex_ to
-  // protect tango_event_data_.
-  std::mutex tango_event_mutex_;
+  // Debug statistics published for the Java activity by the pose and event
+  // callbacks.
+  Telemetry telemetry_;
+
+  // Touch events from the UI thread, drained by Render() on the GL thread.
+  tango_gl::TouchQueue touch_queue_;
 
   // main_scene_ includes all drawable object for visualizing Tango device's
   // movement.
   Scene main_scene_;
 
-  // Tango configration file, this object is for configuring Tango Service setup
-  // before connect to service. For example, we set the flag
-  // config_enable_auto_recovery based user's input and then start Tango.
-  TangoConfig tango_config_;
+  // Connection to the Tango Service, with the config and the callbacks of a
+  // run of the activity. It is created by TangoSetupConfig(), from the flag
+  // config_enable_auto_recovery based on the user's input.
+  std::unique_ptr<tango_gl::TangoSession> session_;
 
   // Tango service version string.
   std::string tango_core_version_string_;
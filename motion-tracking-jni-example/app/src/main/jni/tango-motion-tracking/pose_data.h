@@ -21,12 +21,19 @@
 #include <mutex>
 
 #include <tango_client_api.h>  // NOLINT
+#include <tango-gl/seqlock.h>
 #include <tango-gl/util.h>
 
+#include <tango-motion-tracking/telemetry.h>
+
 namespace tango_motion_tracking {
 
 // PoseData holds all pose related data. E.g. pose position, rotation and time-
-// stamp. It also produce the debug information strings.
+// stamp. It also produce the debug statistics.
+//
+// UpdatePose() only stores a snapshot of the pose, the getters can be called
+// from any thread without locking. UpdatePose() itself must be called from
+// one thread.
 class PoseData {
  public:
   PoseData();
@@ -37,10 +44,10 @@ class PoseData {
   // @param pose: pose data of current frame.
   void UpdatePose(const TangoPoseData* pose_data);
 
-  // Compose the pose debug string.
+  // Get the debug statistics of the current pose.
   //
-  // @return: pose debug strings for dispaly on Java activity.
-  std::string GetPoseDebugString();
+  // @return: pose statistics for display on Java activity.
+  Telemetry::Pose GetPoseTelemetry();
 
   // Get pose data in current frame.
   //
@@ -48,26 +55,22 @@ class PoseData {
   TangoPoseData GetCurrentPoseData();
 
  private:
-  // Convert TangoPoseStatusType to string.
-  //
-  // @param: status, status code needs to be converted.
-  //
-  // @return: corresponding string based on status passed in.
-  std::string GetStringFromStatusCode(TangoPoseStatusType status);
+  // Latest pose, published by UpdatePose() for the getters.
+  struct PoseSnapshot {
+    // Pose data of current frame.
+    TangoPoseData cur_pose;
+    // Time since the previous pose, in seconds.
+    double delta_time;
+    // Poses since the last status change, for debug purpose.
+    size_t pose_counter;
+  };
 
-  // Format the pose debug string based on current pose and previous pose data.
-  void FormatPoseString();
+  tango_gl::SeqLock<PoseSnapshot> snapshot_;
 
-  // Pose data of current frame.
-  TangoPoseData cur_pose_;
-
-  // prev_pose_, pose_counter_ and pose_debug_string_ are used for composing the
-  // debug string to display the useful information on screen.
+  // prev_pose_ and pose_counter_ are only used by UpdatePose() to fill in the
+  // snapshot.
   TangoPoseData prev_pose_;
 
-  // Debug pose string.
-  std::string pose_string_;
-
   // Pose counter for debug purpose.
   size_t pose_counter_;
 };
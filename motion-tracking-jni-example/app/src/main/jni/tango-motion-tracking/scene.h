@@ -26,6 +26,9 @@
 #include <tango-gl/color.h>
 #include <tango-gl/gesture_camera.h>
 #include <tango-gl/grid.h>
+#include <tango-gl/minimap.h>
+#include <tango-gl/scene_graph.h>
+#include <tango-gl/frame_cache.h>
 #include <tango-gl/frustum.h>
 #include <tango-gl/trace.h>
 #include <tango-gl/transform.h>
@@ -63,6 +66,11 @@ class Scene {
   //         top down
   void SetCameraType(tango_gl::GestureCamera::CameraType camera_type);
 
+  // Show a top down minimap of the trajectory in an inset over the main
+  // view. The minimap is drawn incrementally into a texture and composited
+  // as one quad.
+  void SetTopDownInset(bool is_inset_shown);
+
   // Touch event passed from android activity. This function only support two
   // touches.
   //
@@ -79,6 +87,12 @@ class Scene {
   // Camera object that allows user to use touch input to interact with.
   tango_gl::GestureCamera* gesture_camera_;
 
+  bool is_inset_shown_;
+
+  // Size of the GL surface.
+  int viewport_width_;
+  int viewport_height_;
+
   // Device axis (in device frame of reference).
   tango_gl::Axis* axis_;
 
@@ -90,6 +104,15 @@ class Scene {
 
   // Trace of pose data.
   tango_gl::Trace* trace_;
+
+  // Top down view of the trace and the ground of the inset.
+  tango_gl::Minimap minimap_;
+
+  // Draw list of the drawables above.
+  tango_gl::SceneGraph scene_graph_;
+
+  // Last rendered frame, presented again while nothing in it changed.
+  tango_gl::FrameCache frame_cache_;
 };
 }  // namespace tango_motion_tracking
 
@@ -21,6 +21,9 @@
 #include <mutex>
 
 #include <tango_client_api.h>  // NOLINT
+#include <tango-gl/seqlock.h>
+
+#include <tango-motion-tracking/telemetry.h>
 
 namespace tango_motion_tracking {
 
@@ -42,14 +45,21 @@ class TangoEventData {
   // @param: event, TangoEvent in current frame.
   void UpdateTangoEvent(const TangoEvent* event);
 
-  // Clear event string. Set event_string_ to empty.
+  // Clear the current event.
   void ClearEventString();
 
-  // Get formated event string for debug dispaly purpose.
-  std::string GetTangoEventString();
+  // Get the current event for debug display purpose.
+  Telemetry::Event GetEventTelemetry();
+
  private:
-  // Current event string.
-  std::string event_string_;
+  // Longest event key and value kept, longer ones are truncated.
+  static const size_t kMaxEventKeyLength = sizeof(Telemetry::Event::key) - 1;
+  static const size_t kMaxEventValueLength =
+      sizeof(Telemetry::Event::value) - 1;
+
+  // Latest event, copied out of the callback's strings so it can be read from
+  // any thread. Updates come from the event callback thread.
+  tango_gl::SeqLock<Telemetry::Event> event_;
 };
 }  // namespace tango_motion_tracking
 
@@ -0,0 +1,83 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_MOTION_TRACKING_TELEMETRY_H_
+#define TANGO_MOTION_TRACKING_TELEMETRY_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <type_traits>
+
+#include <tango-gl/counters.h>
+#include <tango-gl/seqlock.h>
+
+namespace tango_motion_tracking {
+
+// Debug statistics shared with the Java activity through a direct ByteBuffer,
+// so a UI refresh reads them without any JNI call.
+//
+// Each block is a tango_gl::SeqLock, i.e. a uint32 sequence followed by the
+// payload words in native byte order. The pose block is written by the pose
+// callback thread, the event block by the event callback thread and the
+// counters block by the GL thread, each block has a single writer. The byte offsets are mirrored in Telemetry.java
+// and checked below, change both together.
+struct Telemetry {
+  struct Pose {
+    // TangoPoseStatusType of the latest pose.
+    int32_t status;
+    // Poses since the last status change, 0 before the first pose.
+    uint32_t count;
+    double translation[3];
+    double orientation[4];
+    // Time since the previous pose, in milliseconds.
+    float delta_time_ms;
+    uint32_t reserved;
+  };
+
+  // Latest Tango event, truncated and null terminated.
+  struct Event {
+    char key[64];
+    char value[128];
+  };
+
+  // tango_gl::Counters of the last frame, indexed by Counters::Counter.
+  struct Counters {
+    uint32_t values[tango_gl::Counters::kCounterCount];
+  };
+
+  tango_gl::SeqLock<Pose> pose;
+  tango_gl::SeqLock<Event> event;
+  tango_gl::SeqLock<Counters> counters;
+};
+
+static_assert(std::is_standard_layout<Telemetry>::value,
+              "Telemetry is read by byte offset from Java");
+static_assert(offsetof(Telemetry::Pose, translation) == 8 &&
+                  offsetof(Telemetry::Pose, orientation) == 32 &&
+                  offsetof(Telemetry::Pose, delta_time_ms) == 64 &&
+                  sizeof(Telemetry::Pose) == 72,
+              "Pose layout is mirrored in Telemetry.java");
+static_assert(sizeof(Telemetry::Counters) == 28,
+              "Counters layout is mirrored in Telemetry.java");
+static_assert(offsetof(Telemetry, event) == 76 &&
+                  offsetof(Telemetry, counters) == 272 &&
+                  sizeof(Telemetry) == 304,
+              "Block offsets are mirrored in Telemetry.java");
+}  // namespace tango_motion_tracking
+
+#endif  // TANGO_MOTION_TRACKING_TELEMETRY_H_
@@ -14,7 +14,7 @@
  * limitations under the License.
  */
 
-#include <sstream>
+#include <string.h>
 
 #include "tango-motion-tracking/tango_event_data.h"
 
@@ -30,20 +30,23 @@ TangoEventData::~TangoEventData() {}
 //
 // @param: event, TangoEvent in current frame.
 void TangoEventData::UpdateTangoEvent(const TangoEvent* event) {
-  std::stringstream string_stream;
-  string_stream << event->event_key << ": " << event->event_value;
-  event_string_ = string_stream.str();
-  string_stream.flush();
+  Telemetry::Event snapshot;
+  strncpy(snapshot.key, event->event_key != nullptr ? event->event_key : "",
+          kMaxEventKeyLength);
+  snapshot.key[kMaxEventKeyLength] = '\0';
+  strncpy(snapshot.value,
+          event->event_value != nullptr ? event->event_value : "",
+          kMaxEventValueLength);
+  snapshot.value[kMaxEventValueLength] = '\0';
+  event_.Store(snapshot);
 }
 
-// Clear event string. Set event_string_ to empty.
+// Clear the current event.
 void TangoEventData::ClearEventString() {
-  event_string_.clear();
+  event_.Store(Telemetry::Event());
 }
 
-// Get formated event string for debug dispaly purpose.
-std::string TangoEventData::GetTangoEventString() {
-  return event_string_;
-}
+// Get the current event for debug display purpose.
+Telemetry::Event TangoEventData::GetEventTelemetry() { return event_.Load(); }
 
 } //namespace tango_motion_tracking
\ No newline at end of file
@@ -48,6 +48,9 @@ public class JNIInterface {
     // Display debug colors on point cloud.
     public static native void setRenderDebugPointCloud(boolean debugRender);
 
+    // Share of the latest depth frame supporting the placed plane.
+    public static native float getPlaneInlierRatio();
+
     // Setup the view port width and height.
     public static native void setViewPort(int width, int height);
 
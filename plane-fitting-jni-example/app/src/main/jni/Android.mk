@@ -20,23 +20,66 @@ include $(CLEAR_VARS)
 LOCAL_MODULE := plane_fitting_jni_example
 LOCAL_SHARED_LIBRARIES := tango_client_api tango_support_api
 LOCAL_CFLAGS := -std=c++11
+# Per frame matrix math on NEON, part of the arm64-v8a baseline. armeabi-v7a
+# keeps the scalar glm path, see tango-gl/simd_math.h.
+ifeq ($(TARGET_ARCH_ABI),arm64-v8a)
+LOCAL_CFLAGS    += -DTANGO_GL_SIMD_MATH
+endif
 LOCAL_C_INCLUDES := $(PROJECT_ROOT)/tango-gl/include \
                     $(PROJECT_ROOT)/third-party/glm
 LOCAL_SRC_FILES := jni_interface.cc \
+                   plane_detector.cc \
+                   plane_fit_queue.cc \
                    plane_fitting.cc \
                    plane_fitting_application.cc \
+                   plane_inlier_counter.cc \
+                   plane_renderer.cc \
+                   plane_tracker.cc \
                    point_cloud.cc \
                    $(PROJECT_ROOT_FROM_JNI)/tango-gl/bounding_box.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/bvh.cpp \
                    $(PROJECT_ROOT_FROM_JNI)/tango-gl/camera.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/camera_intrinsics_registry.cpp \
                    $(PROJECT_ROOT_FROM_JNI)/tango-gl/conversions.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/counters.cpp \
                    $(PROJECT_ROOT_FROM_JNI)/tango-gl/cube.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/debug_draw.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/depth_outlier_filter.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/device_extrinsics.cpp \
                    $(PROJECT_ROOT_FROM_JNI)/tango-gl/drawable_object.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/frame_arena.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/frame_constants.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/geometry_registry.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/light_estimator.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/memory_tracker.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/occlusion_culler.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/point_projection.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/program_cache.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/render_state.cpp \
                    $(PROJECT_ROOT_FROM_JNI)/tango-gl/mesh.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/motion_gate.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/pixel_readback.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/point_cloud_buffer.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/point_cloud_decimator.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/point_cloud_pool.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/pose_history.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/range_image.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/range_image_mesh.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/ray_table.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/rigid_transform.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/service_probe.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/shader_variants.cpp \
                    $(PROJECT_ROOT_FROM_JNI)/tango-gl/shaders.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/thread_policy.cpp \
                    $(PROJECT_ROOT_FROM_JNI)/tango-gl/transform.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/undistortion_mesh.cpp \
                    $(PROJECT_ROOT_FROM_JNI)/tango-gl/util.cpp \
-                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/video_overlay.cpp
-LOCAL_LDLIBS := -lGLESv2 -llog -L$(SYSROOT)/usr/lib
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/vertex_array.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/vertex_buffer.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/video_overlay.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/view_frustum.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/worker_pool.cpp
+LOCAL_LDLIBS := -lGLESv2 -lEGL -llog -L$(SYSROOT)/usr/lib
 include $(BUILD_SHARED_LIBRARY)
 
 $(call import-add-path,$(PROJECT_ROOT))
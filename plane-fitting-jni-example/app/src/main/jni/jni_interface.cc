@@ -15,69 +15,80 @@
  */
 
 #include <jni.h>
+#include <tango-gl/jni_natives.h>
 
 #include "tango-plane-fitting/plane_fitting_application.h"
 
-static tango_plane_fitting::PlaneFittingApplication app;
+namespace {
+tango_plane_fitting::PlaneFittingApplication app;
 
-#ifdef __cplusplus
-extern "C" {
-#endif
-
-JNIEXPORT jint JNICALL
-Java_com_projecttango_experiments_nativeplanefitting_JNIInterface_tangoInitialize(
-    JNIEnv* env, jobject /*obj*/, jobject activity) {
+jint TangoInitialize(JNIEnv* env, jobject /*obj*/, jobject activity) {
   return app.TangoInitialize(env, activity);
 }
 
-JNIEXPORT jint JNICALL
-Java_com_projecttango_experiments_nativeplanefitting_JNIInterface_tangoSetupAndConnect(
-    JNIEnv* /*env*/, jobject /*obj*/) {
+jint TangoSetupAndConnect(JNIEnv* /*env*/, jobject /*obj*/) {
   return app.TangoSetupAndConnect();
 }
 
-JNIEXPORT void JNICALL
-Java_com_projecttango_experiments_nativeplanefitting_JNIInterface_tangoDisconnect(
-    JNIEnv* /*env*/, jobject /*obj*/) {
+void TangoDisconnect(JNIEnv* /*env*/, jobject /*obj*/) {
   app.TangoDisconnect();
 }
 
-JNIEXPORT jint JNICALL
-Java_com_projecttango_experiments_nativeplanefitting_JNIInterface_initializeGLContent(
-    JNIEnv* /*env*/, jobject /*obj*/) {
+jint InitializeGLContent(JNIEnv* /*env*/, jobject /*obj*/) {
   return app.InitializeGLContent();
 }
 
-JNIEXPORT void JNICALL
-Java_com_projecttango_experiments_nativeplanefitting_JNIInterface_setRenderDebugPointCloud(
-    JNIEnv* /*env*/, jobject /*obj*/, jboolean on) {
+void SetRenderDebugPointCloud(JNIEnv* /*env*/, jobject /*obj*/, jboolean on) {
   app.SetRenderDebugPointCloud(on);
 }
 
-JNIEXPORT void JNICALL
-Java_com_projecttango_experiments_nativeplanefitting_JNIInterface_setViewPort(
-    JNIEnv* /*env*/, jobject /*obj*/, jint width, jint height) {
+jfloat GetPlaneInlierRatio(JNIEnv* /*env*/, jobject /*obj*/) {
+  return app.GetPlaneInlierRatio();
+}
+
+void SetViewPort(JNIEnv* /*env*/, jobject /*obj*/, jint width, jint height) {
   app.SetViewPort(width, height);
 }
 
-JNIEXPORT void JNICALL
-Java_com_projecttango_experiments_nativeplanefitting_JNIInterface_render(
-    JNIEnv* /*env*/, jobject /*obj*/) {
+void Render(JNIEnv* /*env*/, jobject /*obj*/) {
   app.Render();
 }
 
-JNIEXPORT void JNICALL
-Java_com_projecttango_experiments_nativeplanefitting_JNIInterface_freeGLContent(
-    JNIEnv* /*env*/, jobject /*obj*/) {
+void FreeGLContent(JNIEnv* /*env*/, jobject /*obj*/) {
   app.FreeGLContent();
 }
 
-JNIEXPORT void JNICALL
-Java_com_projecttango_experiments_nativeplanefitting_JNIInterface_onTouchEvent(
-    JNIEnv* /*env*/, jobject /*obj*/, jfloat x, jfloat y) {
+void OnTouchEvent(JNIEnv* /*env*/, jobject /*obj*/, jfloat x, jfloat y) {
   app.OnTouchEvent(x, y);
 }
 
+const JNINativeMethod kNativeMethods[] = {
+    {"tangoInitialize", "(Landroid/app/Activity;)I",
+     reinterpret_cast<void*>(TangoInitialize)},
+    {"tangoSetupAndConnect", "()I",
+     reinterpret_cast<void*>(TangoSetupAndConnect)},
+    {"tangoDisconnect", "()V", reinterpret_cast<void*>(TangoDisconnect)},
+    {"initializeGLContent", "()I",
+     reinterpret_cast<void*>(InitializeGLContent)},
+    {"setRenderDebugPointCloud", "(Z)V",
+     reinterpret_cast<void*>(SetRenderDebugPointCloud)},
+    {"getPlaneInlierRatio", "()F",
+     reinterpret_cast<void*>(GetPlaneInlierRatio)},
+    {"setViewPort", "(II)V", reinterpret_cast<void*>(SetViewPort)},
+    {"render", "()V", reinterpret_cast<void*>(Render)},
+    {"freeGLContent", "()V", reinterpret_cast<void*>(FreeGLContent)},
+    {"onTouchEvent", "(FF)V", reinterpret_cast<void*>(OnTouchEvent)},
+};
+}  // namespace
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+jint JNI_OnLoad(JavaVM* vm, void*) {
+  return tango_gl::jni::RegisterNatives(
+      vm, "com/projecttango/experiments/nativeplanefitting/JNIInterface",
+      kNativeMethods);
+}
 #ifdef __cplusplus
 }
 #endif
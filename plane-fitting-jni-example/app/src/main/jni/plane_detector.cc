@@ -0,0 +1,284 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "tango-plane-fitting/plane_detector.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <utility>
+
+namespace {
+// Distance in meters within which a point supports a plane.
+const float kInlierDistance = 0.03f;
+
+// Smallest number of points accepted as a new plane, and as an observation
+// of a tracked one.
+const int kMinPlaneInliers = 200;
+const int kMinTrackedInliers = 50;
+
+// Hypotheses scored per round, split across the pool, and the overall cap.
+const int kHypothesesPerRound = 32;
+const int kMaxHypotheses = 256;
+
+// Probability that at least one hypothesis is drawn from the inliers of the
+// best plane left in the frame.
+const double kConfidence = 0.99;
+
+// Number of hypotheses needed to draw an all inlier sample with kConfidence,
+// given the inlier ratio of the best plane found so far.
+int RequiredHypotheses(int inlier_count, size_t point_count) {
+  const double inlier_ratio =
+      static_cast<double>(inlier_count) / static_cast<double>(point_count);
+  const double all_inlier_probability =
+      inlier_ratio * inlier_ratio * inlier_ratio;
+  if (all_inlier_probability <= 0.0) {
+    return kMaxHypotheses;
+  }
+  if (all_inlier_probability >= 1.0) {
+    return 1;
+  }
+  const double required =
+      std::log(1.0 - kConfidence) / std::log(1.0 - all_inlier_probability);
+  return static_cast<int>(
+      std::min(std::ceil(required), static_cast<double>(kMaxHypotheses)));
+}
+}  // namespace
+
+namespace tango_plane_fitting {
+
+PlaneDetector::PlaneDetector()
+    : worker_pool_(&tango_gl::WorkerPool::GetShared()),
+      is_stopping_(false),
+      device_T_depth_(1.0f),
+      hypotheses_per_task_(1),
+      round_seed_(0) {
+  const int concurrency = worker_pool_->GetConcurrency();
+  hypotheses_.resize(concurrency);
+  hypotheses_per_task_ =
+      std::max(1, (kHypothesesPerRound + concurrency - 1) / concurrency);
+}
+
+PlaneDetector::~PlaneDetector() { Stop(); }
+
+void PlaneDetector::Start(const glm::mat4& device_T_depth) {
+  if (thread_.joinable()) {
+    return;
+  }
+  // The detection thread is not running, nothing else touches these.
+  device_T_depth_ = device_T_depth;
+  tracker_.Reset();
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    is_stopping_ = false;
+  }
+  thread_ = std::thread(&PlaneDetector::DetectionLoop, this);
+}
+
+void PlaneDetector::Stop() {
+  if (!thread_.joinable()) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    is_stopping_ = true;
+    pending_frame_.Reset();
+  }
+  frame_available_.notify_one();
+  thread_.join();
+}
+
+void PlaneDetector::Submit(const tango_gl::PointCloudPool::Handle& frame) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    pending_frame_ = frame;
+  }
+  frame_available_.notify_one();
+}
+
+const PlaneSet& PlaneDetector::GetLatestPlanes() {
+  planes_.Acquire();
+  return *planes_.GetReadBuffer();
+}
+
+void PlaneDetector::DetectionLoop() {
+  while (true) {
+    tango_gl::PointCloudPool::Handle frame;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      frame_available_.wait(
+          lock, [this] { return pending_frame_ || is_stopping_; });
+      if (is_stopping_) {
+        return;
+      }
+      frame = std::move(pending_frame_);
+    }
+
+    PlaneSet* plane_set = planes_.GetWriteBuffer();
+    plane_set->timestamp = frame->cloud.timestamp;
+    plane_set->start_service_T_device = frame->pose;
+    DetectPlanes(std::move(frame), plane_set);
+    planes_.Publish();
+  }
+}
+
+void PlaneDetector::DetectPlanes(tango_gl::PointCloudPool::Handle frame,
+                                 PlaneSet* plane_set) {
+  const TangoXYZij& cloud = frame->cloud;
+  remaining_.resize(cloud.xyz_count);
+  for (uint32_t i = 0; i < cloud.xyz_count; ++i) {
+    remaining_[i] =
+        glm::vec3(cloud.xyz[i][0], cloud.xyz[i][1], cloud.xyz[i][2]);
+  }
+  tracker_.BeginFrame(frame->pose * device_T_depth_);
+  // Points are removed from remaining_ as planes claim them, hand the frame
+  // back to the pool.
+  frame.Reset();
+
+  // Refine the tracked planes with their new inliers, those points need no
+  // detection.
+  for (int i = 0; i < tracker_.GetPlaneCount(); ++i) {
+    const glm::vec4 equation = tracker_.GetPlaneInDepthFrame(i);
+    PlaneMoments inliers;
+    AccumulateInliers(equation, &inliers, &inlier_points_);
+    if (inliers.weight >= kMinTrackedInliers) {
+      tracker_.AddInliers(i, inliers, inlier_points_);
+      RemoveInliers(equation);
+    }
+  }
+
+  // Search what is left for planes not tracked yet.
+  for (int i = 0; i < PlaneSet::kMaxPlaneCount &&
+                  remaining_.size() >= static_cast<size_t>(kMinPlaneInliers);
+       ++i) {
+    glm::vec4 equation;
+    PlaneMoments inliers;
+    if (!FindPlane(&equation, &inliers, &inlier_points_)) {
+      break;
+    }
+    tracker_.AddDetection(inliers, inlier_points_);
+    RemoveInliers(equation);
+  }
+
+  tracker_.EndFrame(plane_set);
+}
+
+bool PlaneDetector::FindPlane(glm::vec4* equation, PlaneMoments* inliers,
+                              std::vector<glm::vec3>* inlier_points) {
+  const int task_count = static_cast<int>(hypotheses_.size());
+  Hypothesis best;
+  best.inlier_count = 0;
+  int hypothesis_count = 0;
+  int required = kMaxHypotheses;
+  while (hypothesis_count < required) {
+    worker_pool_->ParallelFor(task_count,
+                              [this](int task) { RunHypotheses(task); });
+    ++round_seed_;
+    hypothesis_count += task_count * hypotheses_per_task_;
+
+    for (const Hypothesis& hypothesis : hypotheses_) {
+      if (hypothesis.inlier_count > best.inlier_count) {
+        best = hypothesis;
+      }
+    }
+    if (best.inlier_count > 0) {
+      required = RequiredHypotheses(best.inlier_count, remaining_.size());
+    }
+  }
+
+  if (best.inlier_count < kMinPlaneInliers) {
+    return false;
+  }
+
+  // Refit to the hypothesis inliers, then collect the inliers of the refit
+  // plane, which are more than the noisy three point plane catches.
+  PlaneMoments hypothesis_inliers;
+  AccumulateInliers(best.equation, &hypothesis_inliers, nullptr);
+  if (!FitPlane(hypothesis_inliers, equation)) {
+    return false;
+  }
+  *inliers = PlaneMoments();
+  AccumulateInliers(*equation, inliers, inlier_points);
+  return inliers->weight >= kMinPlaneInliers;
+}
+
+void PlaneDetector::RunHypotheses(int task) {
+  Hypothesis* best = &hypotheses_[task];
+  best->inlier_count = 0;
+
+  std::minstd_rand random(round_seed_ * hypotheses_.size() + task + 1);
+  std::uniform_int_distribution<size_t> pick(0, remaining_.size() - 1);
+  for (int i = 0; i < hypotheses_per_task_; ++i) {
+    const glm::vec3& p0 = remaining_[pick(random)];
+    const glm::vec3& p1 = remaining_[pick(random)];
+    const glm::vec3& p2 = remaining_[pick(random)];
+    const glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+    const float length = glm::length(normal);
+    // Repeated or collinear samples.
+    if (length < 1e-6f) {
+      continue;
+    }
+    const glm::vec3 unit_normal = normal / length;
+    const glm::vec4 equation(unit_normal, -glm::dot(unit_normal, p0));
+    const int inlier_count = CountInliers(equation);
+    if (inlier_count > best->inlier_count) {
+      best->equation = equation;
+      best->inlier_count = inlier_count;
+    }
+  }
+}
+
+int PlaneDetector::CountInliers(const glm::vec4& equation) const {
+  const glm::vec3 normal(equation);
+  int inlier_count = 0;
+  for (const glm::vec3& point : remaining_) {
+    if (std::abs(glm::dot(normal, point) + equation.w) < kInlierDistance) {
+      ++inlier_count;
+    }
+  }
+  return inlier_count;
+}
+
+void PlaneDetector::AccumulateInliers(
+    const glm::vec4& equation, PlaneMoments* inliers,
+    std::vector<glm::vec3>* inlier_points) const {
+  if (inlier_points != nullptr) {
+    inlier_points->clear();
+  }
+  const glm::vec3 normal(equation);
+  for (const glm::vec3& point : remaining_) {
+    if (std::abs(glm::dot(normal, point) + equation.w) < kInlierDistance) {
+      inliers->Add(point);
+      if (inlier_points != nullptr) {
+        inlier_points->push_back(point);
+      }
+    }
+  }
+}
+
+void PlaneDetector::RemoveInliers(const glm::vec4& equation) {
+  remaining_.erase(
+      std::remove_if(remaining_.begin(), remaining_.end(),
+                     [&equation](const glm::vec3& point) {
+                       return std::abs(glm::dot(
+                                  equation, glm::vec4(point, 1.0f))) <
+                              kInlierDistance;
+                     }),
+      remaining_.end());
+}
+
+}  // namespace tango_plane_fitting
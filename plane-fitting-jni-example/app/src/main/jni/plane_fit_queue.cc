@@ -0,0 +1,243 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tango-plane-fitting/plane_fit_queue.h"
+
+#include <utility>
+
+#include <glm/gtc/type_ptr.hpp>
+#include <tango-gl/conversions.h>
+#include <tango-gl/rigid_transform.h>
+
+#include "tango-plane-fitting/plane_fitting.h"
+
+namespace {
+// Pixels around the touch ray whose points are fit, in each direction.
+const int kNeighborhoodRadius = 4;
+
+// Fewest points a neighborhood is fit with.
+const int kMinNeighborCount = 10;
+
+// Largest root mean square distance in meters of the points to the plane
+// fit to them, beyond which the neighborhood is not flat, e.g. an edge.
+const double kMaxPlaneRmsDistance = 0.01;
+
+// Depth in meters the ray is first followed to, before it is refined with
+// the depth found there.
+const float kInitialRayDepth = 2.0f;
+}  // namespace
+
+namespace tango_plane_fitting {
+
+PlaneFitQueue::PlaneFitQueue()
+    : is_stopping_(false),
+      color_intrinsics_(),
+      has_depth_intrinsics_(false) {}
+
+PlaneFitQueue::~PlaneFitQueue() { Stop(); }
+
+void PlaneFitQueue::Start(const TangoCameraIntrinsics& color_intrinsics,
+                          const TangoCameraIntrinsics& depth_intrinsics) {
+  if (thread_.joinable()) {
+    return;
+  }
+  // The fitting thread is not running, nothing else touches these.
+  color_intrinsics_ = color_intrinsics;
+  has_depth_intrinsics_ =
+      depth_intrinsics.width > 0 && depth_intrinsics.height > 0;
+  if (has_depth_intrinsics_) {
+    depth_image_.SetIntrinsics(depth_intrinsics);
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    is_stopping_ = false;
+  }
+  thread_ = std::thread(&PlaneFitQueue::FitLoop, this);
+}
+
+void PlaneFitQueue::Stop() {
+  if (!thread_.joinable()) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    is_stopping_ = true;
+    pending_requests_.clear();
+  }
+  request_available_.notify_one();
+  thread_.join();
+}
+
+bool PlaneFitQueue::Submit(const tango_gl::PointCloudPool::Handle& frame,
+                           const TangoPoseData& color_camera_T_depth_camera,
+                           const glm::vec2& uv, ResultCallback on_result) {
+  if (!thread_.joinable() || !frame) {
+    return false;
+  }
+  Request request;
+  request.frame = frame;
+  request.color_camera_T_depth_camera = color_camera_T_depth_camera;
+  request.uv = uv;
+  request.on_result = std::move(on_result);
+  request.is_fit = false;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    pending_requests_.push_back(std::move(request));
+  }
+  request_available_.notify_one();
+  return true;
+}
+
+void PlaneFitQueue::FitLoop() {
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      request_available_.wait(lock, [this] {
+        return !pending_requests_.empty() || is_stopping_;
+      });
+      if (is_stopping_) {
+        return;
+      }
+      // Both vectors keep their capacity, touches never allocate once both
+      // have grown to the largest batch.
+      batch_.swap(pending_requests_);
+    }
+
+    // Touches of the same frame share its organized image, which is built
+    // once for the first of them.
+    for (size_t i = 0; i < batch_.size(); ++i) {
+      if (batch_[i].is_fit) {
+        continue;
+      }
+      const TangoXYZij& cloud = batch_[i].frame->cloud;
+      const bool is_image_valid = has_depth_intrinsics_ &&
+                                  cloud.xyz_count > 0 &&
+                                  depth_image_.Update(cloud) > 0;
+      const int slot = batch_[i].frame.GetSlot();
+      for (size_t j = i; j < batch_.size(); ++j) {
+        if (batch_[j].frame.GetSlot() == slot) {
+          Fit(is_image_valid, &batch_[j]);
+        }
+      }
+    }
+    for (Request& request : batch_) {
+      request.on_result(request.result);
+    }
+    batch_.clear();
+  }
+}
+
+void PlaneFitQueue::Fit(bool is_image_valid, Request* request) const {
+  Result* result = &request->result;
+  request->is_fit = true;
+  result->is_found = false;
+  result->start_service_T_device = request->frame->pose;
+
+  const glm::mat4 depth_camera_T_color_camera = tango_gl::InverseRigidMatrix(
+      tango_gl::conversions::TransformFromArrays(
+          request->color_camera_T_depth_camera.translation,
+          request->color_camera_T_depth_camera.orientation).ToMatrix());
+  // Ray through the touched pixel of the color camera.
+  const glm::vec3 color_direction(
+      (request->uv.x * color_intrinsics_.width - color_intrinsics_.cx) /
+          color_intrinsics_.fx,
+      (request->uv.y * color_intrinsics_.height - color_intrinsics_.cy) /
+          color_intrinsics_.fy,
+      1.0f);
+  const glm::vec3 origin(depth_camera_T_color_camera[3]);
+  const glm::vec3 direction =
+      glm::mat3(depth_camera_T_color_camera) * color_direction;
+  if (is_image_valid &&
+      FitNearRay(request->frame->cloud, origin, direction, result)) {
+    result->is_found = true;
+    return;
+  }
+
+  glm::dvec3 depth_position;
+  glm::dvec4 depth_plane_equation;
+  if (TangoSupport_fitPlaneModelNearClick(
+          &request->frame->cloud, &color_intrinsics_,
+          &request->color_camera_T_depth_camera, glm::value_ptr(request->uv),
+          glm::value_ptr(depth_position),
+          glm::value_ptr(depth_plane_equation)) != TANGO_SUCCESS) {
+    return;  // Assume error has already been reported.
+  }
+  result->depth_position = static_cast<glm::vec3>(depth_position);
+  result->depth_plane_equation = static_cast<glm::vec4>(depth_plane_equation);
+  result->is_found = true;
+}
+
+bool PlaneFitQueue::FitNearRay(const TangoXYZij& cloud,
+                               const glm::vec3& origin,
+                               const glm::vec3& direction,
+                               Result* result) const {
+  // The color and depth cameras are a few centimeters apart, the ray lands
+  // on the right pixel once followed to about the depth found there.
+  int x;
+  int y;
+  if (!depth_image_.GetPixel(origin + direction * kInitialRayDepth, &x, &y)) {
+    return false;
+  }
+  const float depth = depth_image_.GetDepth(x, y);
+  if (depth > 0.0f && direction.z > 0.0f &&
+      !depth_image_.GetPixel(origin + direction * (depth / direction.z), &x,
+                             &y)) {
+    return false;
+  }
+
+  // The exact points of the frame, not the pixel centers, are fit.
+  PlaneMoments moments;
+  for (int j = y - kNeighborhoodRadius; j <= y + kNeighborhoodRadius; ++j) {
+    for (int i = x - kNeighborhoodRadius; i <= x + kNeighborhoodRadius; ++i) {
+      if (!depth_image_.Contains(i, j)) {
+        continue;
+      }
+      const int32_t index = depth_image_.GetPointIndex(i, j);
+      if (index != tango_gl::RangeImage::kNoPoint) {
+        moments.Add(glm::vec3(cloud.xyz[index][0], cloud.xyz[index][1],
+                              cloud.xyz[index][2]));
+      }
+    }
+  }
+  glm::vec4 equation;
+  if (moments.weight < kMinNeighborCount || !FitPlane(moments, &equation)) {
+    return false;
+  }
+  // The variance of the points along the normal is their mean squared
+  // distance to the plane.
+  const glm::dvec3 normal(equation);
+  if (glm::dot(normal, moments.Covariance() * normal) >
+      kMaxPlaneRmsDistance * kMaxPlaneRmsDistance) {
+    return false;
+  }
+
+  // Face the camera, like the detected planes.
+  float origin_distance = glm::dot(glm::vec3(equation), origin) + equation.w;
+  if (origin_distance < 0.0f) {
+    equation = -equation;
+    origin_distance = -origin_distance;
+  }
+  const float direction_dot = glm::dot(glm::vec3(equation), direction);
+  if (!(direction_dot < 0.0f)) {
+    return false;
+  }
+  result->depth_position =
+      origin - direction * (origin_distance / direction_dot);
+  result->depth_plane_equation = equation;
+  return true;
+}
+
+}  // namespace tango_plane_fitting
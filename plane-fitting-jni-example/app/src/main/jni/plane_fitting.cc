@@ -16,8 +16,73 @@
 
 #include "tango-plane-fitting/plane_fitting.h"
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
 #include <tango-gl/util.h>
 
+namespace {
+// Slack in meters around the inlier extent when hit testing a plane.
+const float kExtentMargin = 0.05f;
+
+// z of the cross product of two 2D vectors, positive if b is
+// counterclockwise of a.
+float Cross(const glm::vec2& a, const glm::vec2& b) {
+  return a.x * b.y - a.y * b.x;
+}
+
+// Unit eigenvector of the smallest eigenvalue of a symmetric 3x3 matrix.
+//
+// @return: false if the eigenvector is not well defined, e.g. for collinear
+//          points.
+bool SmallestEigenvector(const glm::dmat3& m, glm::dvec3* eigenvector) {
+  // Closed form eigenvalues of a symmetric matrix, see Smith, "Eigenvalues of
+  // a symmetric 3x3 matrix", CACM 1961.
+  const double off_diagonal =
+      m[0][1] * m[0][1] + m[0][2] * m[0][2] + m[1][2] * m[1][2];
+  const double mean = (m[0][0] + m[1][1] + m[2][2]) / 3.0;
+  const double spread =
+      (m[0][0] - mean) * (m[0][0] - mean) +
+      (m[1][1] - mean) * (m[1][1] - mean) +
+      (m[2][2] - mean) * (m[2][2] - mean) + 2.0 * off_diagonal;
+  const double scale = std::sqrt(spread / 6.0);
+  if (scale <= 0.0) {
+    return false;
+  }
+  const glm::dmat3 b = (m - glm::dmat3(mean)) * (1.0 / scale);
+  const double half_det =
+      std::max(-1.0, std::min(1.0, glm::determinant(b) / 2.0));
+  const double angle = std::acos(half_det) / 3.0;
+  const double smallest =
+      mean + 2.0 * scale * std::cos(angle + 2.0 * M_PI / 3.0);
+
+  // The eigenvector is orthogonal to the rows of m - smallest * I, take the
+  // best conditioned cross product of two of them.
+  const glm::dmat3 shifted = m - glm::dmat3(smallest);
+  const glm::dvec3 row0(shifted[0][0], shifted[1][0], shifted[2][0]);
+  const glm::dvec3 row1(shifted[0][1], shifted[1][1], shifted[2][1]);
+  const glm::dvec3 row2(shifted[0][2], shifted[1][2], shifted[2][2]);
+  const glm::dvec3 candidates[3] = {glm::cross(row0, row1),
+                                    glm::cross(row0, row2),
+                                    glm::cross(row1, row2)};
+  int best = 0;
+  double best_length = 0.0;
+  for (int i = 0; i < 3; ++i) {
+    const double length = glm::dot(candidates[i], candidates[i]);
+    if (length > best_length) {
+      best = i;
+      best_length = length;
+    }
+  }
+  if (best_length <= 0.0) {
+    return false;
+  }
+  *eigenvector = candidates[best] / std::sqrt(best_length);
+  return true;
+}
+}  // namespace
+
 namespace tango_plane_fitting {
 
 void PlaneTransform(const glm::vec4& in_plane, const glm::mat4& out_T_in,
@@ -40,4 +105,146 @@ void PlaneTransform(const glm::vec4& in_plane, const glm::mat4& out_T_in,
                 -glm::dot(glm::vec3(out_origin), glm::vec3(out_normal)));
 }
 
+void MomentsTransform(const PlaneMoments& in_moments, const glm::mat4& out_T_in,
+                      PlaneMoments* out_moments) {
+  if (!out_moments) {
+    LOGE("PlaneFitting: Invalid input to moments transform");
+    return;
+  }
+
+  // Every point p maps to R p + t, expand the sums of the mapped points.
+  const glm::dmat3 rotation = glm::dmat3(glm::mat3(out_T_in));
+  const glm::dvec3 translation = glm::dvec3(glm::vec3(out_T_in[3]));
+  const glm::dvec3 rotated_sum = rotation * in_moments.sum;
+
+  out_moments->weight = in_moments.weight;
+  out_moments->sum = rotated_sum + in_moments.weight * translation;
+  out_moments->outer_sum =
+      rotation * in_moments.outer_sum * glm::transpose(rotation) +
+      glm::outerProduct(rotated_sum, translation) +
+      glm::outerProduct(translation, rotated_sum) +
+      in_moments.weight * glm::outerProduct(translation, translation);
+}
+
+bool FitPlane(const PlaneMoments& moments, glm::vec4* plane) {
+  if (!plane) {
+    LOGE("PlaneFitting: Invalid input to plane fit");
+    return false;
+  }
+  if (moments.weight < 3.0) {
+    return false;
+  }
+
+  glm::dvec3 normal;
+  if (!SmallestEigenvector(moments.Covariance(), &normal)) {
+    return false;
+  }
+  *plane = glm::vec4(glm::vec3(normal),
+                     static_cast<float>(-glm::dot(normal, moments.Mean())));
+  return true;
+}
+
+bool GrowConvexPolygon(const std::vector<glm::vec2>& points, float tolerance,
+                       int max_vertex_count, std::vector<glm::vec2>* polygon) {
+  // Keep the points outside of every edge's tolerance band.
+  const size_t vertex_count = polygon->size();
+  std::vector<glm::vec2> candidates;
+  for (const glm::vec2& point : points) {
+    bool is_inside = vertex_count >= 3;
+    for (size_t i = 0; is_inside && i < vertex_count; ++i) {
+      const glm::vec2& a = (*polygon)[i];
+      const glm::vec2& b = (*polygon)[(i + 1) % vertex_count];
+      const glm::vec2 edge = b - a;
+      // Edges of a convex polygon have positive length.
+      is_inside = Cross(edge, point - a) >= -tolerance * glm::length(edge);
+    }
+    if (!is_inside) {
+      candidates.push_back(point);
+    }
+  }
+  if (candidates.empty()) {
+    return false;
+  }
+
+  // Monotone chain over the outside points and the old vertices, see
+  // Andrew, "Another efficient algorithm for convex hulls in two
+  // dimensions", 1979.
+  candidates.insert(candidates.end(), polygon->begin(), polygon->end());
+  std::sort(candidates.begin(), candidates.end(),
+            [](const glm::vec2& a, const glm::vec2& b) {
+              return a.x < b.x || (a.x == b.x && a.y < b.y);
+            });
+  std::vector<glm::vec2> hull(2 * candidates.size());
+  size_t hull_size = 0;
+  for (size_t i = 0; i < candidates.size(); ++i) {
+    while (hull_size >= 2 && Cross(hull[hull_size - 1] - hull[hull_size - 2],
+                                   candidates[i] - hull[hull_size - 2]) <=
+                                 0.0f) {
+      --hull_size;
+    }
+    hull[hull_size++] = candidates[i];
+  }
+  const size_t lower_size = hull_size + 1;
+  for (size_t i = candidates.size() - 1; i-- > 0;) {
+    while (hull_size >= lower_size &&
+           Cross(hull[hull_size - 1] - hull[hull_size - 2],
+                 candidates[i] - hull[hull_size - 2]) <= 0.0f) {
+      --hull_size;
+    }
+    hull[hull_size++] = candidates[i];
+  }
+  // The last point is the first one again.
+  hull.resize(hull_size > 1 ? hull_size - 1 : hull_size);
+
+  // Drop the vertices cutting off the least area until under the cap.
+  max_vertex_count = std::max(max_vertex_count, 3);
+  while (hull.size() > static_cast<size_t>(max_vertex_count)) {
+    size_t smallest = 0;
+    float smallest_area = std::numeric_limits<float>::max();
+    for (size_t i = 0; i < hull.size(); ++i) {
+      const glm::vec2& previous = hull[(i + hull.size() - 1) % hull.size()];
+      const glm::vec2& next = hull[(i + 1) % hull.size()];
+      const float area = Cross(hull[i] - previous, next - previous);
+      if (area < smallest_area) {
+        smallest = i;
+        smallest_area = area;
+      }
+    }
+    hull.erase(hull.begin() + smallest);
+  }
+  polygon->swap(hull);
+  return true;
+}
+
+bool RaycastPlanes(const PlaneSet& plane_set, const glm::vec3& origin,
+                   const glm::vec3& direction, glm::vec3* position,
+                   glm::vec4* equation) {
+  float nearest = -1.0f;
+  for (int i = 0; i < plane_set.plane_count; ++i) {
+    const DetectedPlane& plane = plane_set.planes[i];
+    const glm::vec3 normal(plane.equation);
+    const float denominator = glm::dot(normal, direction);
+    if (std::abs(denominator) < 1e-6f) {
+      continue;
+    }
+    const float distance =
+        -(glm::dot(normal, origin) + plane.equation.w) / denominator;
+    if (distance <= 0.0f || (nearest >= 0.0f && distance >= nearest)) {
+      continue;
+    }
+    const glm::vec3 hit = origin + distance * direction;
+    const glm::vec3 offset = hit - plane.center;
+    const glm::vec2 uv(glm::dot(offset, plane.axis_u),
+                       glm::dot(offset, plane.axis_v));
+    if (glm::any(glm::lessThan(uv, plane.min_extent - kExtentMargin)) ||
+        glm::any(glm::greaterThan(uv, plane.max_extent + kExtentMargin))) {
+      continue;
+    }
+    nearest = distance;
+    *position = hit;
+    *equation = plane.equation;
+  }
+  return nearest >= 0.0f;
+}
+
 }  // namespace tango_plane_fitting
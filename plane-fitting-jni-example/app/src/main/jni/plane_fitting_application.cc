@@ -16,10 +16,14 @@
 
 #include "tango-plane-fitting/plane_fitting_application.h"
 
+#include <algorithm>
+
 #include <glm/gtc/matrix_access.hpp>
 #include <glm/gtx/quaternion.hpp>
-#include <tango-gl/camera.h>
 #include <tango-gl/conversions.h>
+#include <tango-gl/program_cache.h>
+#include <tango-gl/render_state.h>
+#include <tango-gl/rigid_transform.h>
 #include <tango-gl/util.h>
 
 #include "tango-plane-fitting/plane_fitting.h"
@@ -30,6 +34,17 @@ namespace {
 
 constexpr float kCubeScale = 0.05f;
 
+// Camera image luminance lit like the default ambient light, and the bounds
+// of the exposure applied to the cube as the scene gets darker or brighter.
+constexpr float kMiddleGray = 0.4f;
+constexpr float kMinExposure = 0.25f;
+constexpr float kMaxExposure = 1.5f;
+constexpr float kAmbientIntensity = 0.3f;
+
+// Memory for decimated depth frames. The callback, the renderer and the plane
+// detector hold up to five frames at once, this leaves room for a few more.
+constexpr size_t kPointCloudPoolBudget = 1024 * 1024;
+
 /**
  * This function will route callbacks to our application object via the context
  * parameter.
@@ -43,17 +58,43 @@ void OnXYZijAvailableRouter(void* context, const TangoXYZij* xyz_ij) {
   app->OnXYZijAvailable(xyz_ij);
 }
 
+/**
+ * This function will route callbacks to our application object via the context
+ * parameter.
+ *
+ * @param context Will be a pointer to a PlaneFittingApplication instance on
+ * which to call callbacks.
+ * @param pose The pose to pass on.
+ */
+void OnPoseAvailableRouter(void* context, const TangoPoseData* pose) {
+  PlaneFittingApplication* app = static_cast<PlaneFittingApplication*>(context);
+  app->OnPoseAvailable(pose);
+}
+
 }  // end namespace
 
 void PlaneFittingApplication::OnXYZijAvailable(const TangoXYZij* xyz_ij) {
-  point_cloud_->UpdateVertices(xyz_ij);
+  point_cloud_->UpdateVertices(xyz_ij, pose_history_, &camera_intrinsics_);
+}
+
+void PlaneFittingApplication::OnPoseAvailable(const TangoPoseData* pose) {
+  if (pose->status_code == TANGO_POSE_VALID) {
+    pose_history_.Add(pose->timestamp, pose->translation, pose->orientation);
+  } else {
+    // Poses after a tracking loss do not continue the earlier ones.
+    pose_history_.Clear();
+  }
 }
 
 PlaneFittingApplication::PlaneFittingApplication()
-    : point_cloud_debug_render_(false),
+    : point_cloud_pool_(PointCloud::kMaxPointCount, kPointCloudPoolBudget),
+      has_plane_fit_(false),
+      point_cloud_debug_render_(false),
       last_gpu_timestamp_(0.0),
       opengl_world_T_start_service_(
           tango_gl::conversions::opengl_world_T_tango_world()),
+      start_service_T_opengl_world_(
+          glm::inverse(opengl_world_T_start_service_)),
       color_camera_T_opengl_camera_(
           tango_gl::conversions::color_camera_T_opengl_camera()) {}
 
@@ -63,6 +104,9 @@ PlaneFittingApplication::~PlaneFittingApplication() {
 
 int PlaneFittingApplication::TangoInitialize(JNIEnv* env,
                                              jobject caller_activity) {
+  // Linked shader programs are persisted in the app cache directory.
+  tango_gl::program_cache::SetBinaryCacheDirectory(env, caller_activity);
+
   // The first thing we need to do for any Tango enabled application is to
   // initialize the service. We will do that here, passing on the JNI
   // environment and jobject corresponding to the Android activity that is
@@ -122,9 +166,23 @@ int PlaneFittingApplication::TangoSetupAndConnect() {
     return ret;
   }
 
+  // Register for device poses, kept to look up the poses of depth and color
+  // frames without asking the service.
+  TangoCoordinateFramePair pairs;
+  pairs.base = TANGO_COORDINATE_FRAME_START_OF_SERVICE;
+  pairs.target = TANGO_COORDINATE_FRAME_DEVICE;
+  pose_history_.Clear();
+  ret = TangoService_connectOnPoseAvailable(1, &pairs, OnPoseAvailableRouter);
+  if (ret != TANGO_SUCCESS) {
+    LOGE("Failed to connected to pose callback.");
+    return ret;
+  }
+
   // Here, we will connect to the TangoService and set up to run. Note that
   // we are passing in a pointer to ourselves as the context which will be
-  // passed back in our callbacks.
+  // passed back in our callbacks. Intrinsics may change between connections,
+  // so the cached ones are dropped.
+  camera_intrinsics_.Clear();
   ret = TangoService_connect(this, tango_config_);
   if (ret != TANGO_SUCCESS) {
     LOGE("PlaneFittingApplication: Failed to connect to the Tango service.");
@@ -134,7 +192,7 @@ int PlaneFittingApplication::TangoSetupAndConnect() {
   // Get the intrinsics for the color camera and pass them on to the depth
   // image. We need these to know how to project the point cloud into the color
   // camera frame.
-  ret = TangoService_getCameraIntrinsics(TANGO_CAMERA_COLOR,
+  ret = camera_intrinsics_.GetIntrinsics(TANGO_CAMERA_COLOR,
                                          &color_camera_intrinsics_);
   if (ret != TANGO_SUCCESS) {
     LOGE(
@@ -145,80 +203,42 @@ int PlaneFittingApplication::TangoSetupAndConnect() {
   constexpr float kNearPlane = 0.1;
   constexpr float kFarPlane = 100.0;
 
-  projection_matrix_ar_ = tango_gl::Camera::ProjectionMatrixForCameraIntrinsics(
-      color_camera_intrinsics_.width, color_camera_intrinsics_.height,
-      color_camera_intrinsics_.fx, color_camera_intrinsics_.fy,
-      color_camera_intrinsics_.cx, color_camera_intrinsics_.cy, kNearPlane,
-      kFarPlane);
-
-  // Setup fixed pose information
-  TangoPoseData pose_imu_T_color_t0;
-  TangoPoseData pose_imu_T_depth_t0;
-  TangoPoseData pose_imu_T_device_t0;
-
-  TangoCoordinateFramePair frame_pair;
-  glm::vec3 translation;
-  glm::quat rotation;
-
-  // We need to get the extrinsic transform between the color camera and the
-  // IMU coordinate frames. This matrix is then used to compute the extrinsic
-  // transform between color camera and device: C_T_D = C_T_IMU * IMU_T_D.
-  // Note that the matrix C_T_D is a constant transformation since the hardware
-  // will not change, we use the getPoseAtTime() function to query it once right
-  // after the Tango Service connected and store it for efficiency.
-  frame_pair.base = TANGO_COORDINATE_FRAME_IMU;
-  frame_pair.target = TANGO_COORDINATE_FRAME_DEVICE;
-  ret = TangoService_getPoseAtTime(0.0, frame_pair, &pose_imu_T_device_t0);
-  if (ret != TANGO_SUCCESS) {
-    LOGE(
-        "PlaneFittingApplication: Failed to get transform between the IMU and"
-        "device frames. Something is wrong with device extrinsics.");
-    return ret;
-  }
-  const glm::mat4 IMU_T_device = tango_gl::conversions::TransformFromArrays(
-      pose_imu_T_device_t0.translation, pose_imu_T_device_t0.orientation);
-
-  // Get color camera with respect to IMU transformation matrix. This matrix is
-  // used to compute the extrinsics between color camera and device:
-  // C_T_D = C_T_IMU * IMU_T_D.
-  frame_pair.base = TANGO_COORDINATE_FRAME_IMU;
-  frame_pair.target = TANGO_COORDINATE_FRAME_CAMERA_COLOR;
-  ret = TangoService_getPoseAtTime(0.0, frame_pair, &pose_imu_T_color_t0);
-  if (ret != TANGO_SUCCESS) {
-    LOGE(
-        "PlaneFittingApplication: Failed to get transform between the IMU and"
-        "camera frames. Something is wrong with device extrinsics.");
-    return ret;
-  }
-  const glm::mat4 IMU_T_color = tango_gl::conversions::TransformFromArrays(
-      pose_imu_T_color_t0.translation, pose_imu_T_color_t0.orientation);
-
-  // Get depth camera with respect to imu transformation matrix. This matrix is
-  // used to compute the extrinsics between depth camera and device:
-  // C_T_D = C_T_IMU * IMU_T_D.
-  frame_pair.base = TANGO_COORDINATE_FRAME_IMU;
-  frame_pair.target = TANGO_COORDINATE_FRAME_CAMERA_DEPTH;
-  ret = TangoService_getPoseAtTime(0.0, frame_pair, &pose_imu_T_depth_t0);
+  camera_intrinsics_.GetProjectionMatrix(TANGO_CAMERA_COLOR, 0, 0, kNearPlane,
+                                         kFarPlane, &projection_matrix_ar_);
+
+  // The transformations between the device and the cameras are constant since
+  // the hardware will not change, we query them once right after the Tango
+  // Service connected and store them for efficiency.
+  ret = extrinsics_.Query();
   if (ret != TANGO_SUCCESS) {
-    LOGE(
-        "PlaneFittingApplication: Failed to get transform between the IMU and"
-        "camera frames. Something is wrong with device extrinsics.");
-    return ret;
+    LOGE("PlaneFittingApplication: Failed to get the device extrinsics.");
   }
-  const glm::mat4 IMU_T_depth = tango_gl::conversions::TransformFromArrays(
-      pose_imu_T_depth_t0.translation, pose_imu_T_depth_t0.orientation);
 
-  device_T_depth_ = glm::inverse(IMU_T_device) * IMU_T_depth;
-  device_T_color_ = glm::inverse(IMU_T_device) * IMU_T_color;
+  // Frames submitted before this are held until the detector starts.
+  plane_detector_.Start(extrinsics_.GetDeviceTDepth());
+
+  // Without the depth intrinsics every touch is fit by the support library.
+  TangoCameraIntrinsics depth_camera_intrinsics = TangoCameraIntrinsics();
+  if (camera_intrinsics_.GetIntrinsics(TANGO_CAMERA_DEPTH,
+                                       &depth_camera_intrinsics) !=
+      TANGO_SUCCESS) {
+    LOGE("PlaneFittingApplication: Failed to get the depth intrinsics.");
+  }
+  plane_fit_queue_.Start(color_camera_intrinsics_, depth_camera_intrinsics);
 
   return ret;
 }
 
 void PlaneFittingApplication::TangoDisconnect() {
   TangoService_disconnect();
+  plane_detector_.Stop();
+  plane_fit_queue_.Stop();
 }
 
 int PlaneFittingApplication::InitializeGLContent() {
+  // Anything RenderState remembers belongs to the previous GL context.
+  tango_gl::RenderState::Invalidate();
+
   int32_t max_point_cloud_elements;
   const int ret = TangoConfig_getInt32(tango_config_, "max_point_cloud_elements",
                                        &max_point_cloud_elements);
@@ -228,10 +248,15 @@ int PlaneFittingApplication::InitializeGLContent() {
   }
 
   video_overlay_ = new tango_gl::VideoOverlay();
-  point_cloud_ = new PointCloud(max_point_cloud_elements);
+  point_cloud_ = new PointCloud(max_point_cloud_elements, &point_cloud_pool_,
+                                &plane_detector_);
+  plane_renderer_ = new PlaneRenderer();
+  debug_draw_ = new tango_gl::DebugDraw();
+  debug_draw_->SetEnabled(point_cloud_debug_render_);
   cube_ = new tango_gl::Cube();
   cube_->SetScale(glm::vec3(kCubeScale, kCubeScale, kCubeScale));
   cube_->SetColor(0.7f, 0.7f, 0.7f);
+  light_estimator_ = new tango_gl::LightEstimator();
 
   // The Tango service allows you to connect an OpenGL texture directly to its
   // RGB and fisheye cameras. This is the most efficient way of receiving
@@ -243,7 +268,18 @@ int PlaneFittingApplication::InitializeGLContent() {
 }
 
 void PlaneFittingApplication::SetRenderDebugPointCloud(bool on) {
+  point_cloud_debug_render_ = on;
   point_cloud_->SetRenderDebugColors(on);
+  debug_draw_->SetEnabled(on);
+}
+
+float PlaneFittingApplication::GetPlaneInlierRatio() const {
+  PlaneInlierCounts counts;
+  if (!point_cloud_ || !point_cloud_->GetPlaneInlierCounts(&counts) ||
+      counts.point_count == 0) {
+    return 0.0f;
+  }
+  return static_cast<float>(counts.inlier_count) / counts.point_count;
 }
 
 void PlaneFittingApplication::SetViewPort(int width, int height) {
@@ -251,39 +287,60 @@ void PlaneFittingApplication::SetViewPort(int width, int height) {
   screen_height_ = static_cast<float>(height);
 
   glViewport(0, 0, screen_width_, screen_height_);
+
+  // Planes are rendered with the pinhole projection, undistort the camera
+  // image to match it.
+  if (video_overlay_ != nullptr) {
+    video_overlay_->SetDistortionMap(camera_intrinsics_.GetDistortionMap(
+        TANGO_CAMERA_COLOR, tango_gl::UndistortionMesh::kDefaultGridWidth,
+        tango_gl::UndistortionMesh::kDefaultGridHeight));
+  }
 }
 
 void PlaneFittingApplication::Render() {
+  tango_gl::RenderState::BeginFrame();
+
   // We need to make sure that we update the texture associated with the color
   // image.
-  if (TangoService_updateTexture(TANGO_CAMERA_COLOR, &last_gpu_timestamp_) !=
-      TANGO_SUCCESS) {
+  const TangoErrorType update_texture_status =
+      TangoService_updateTexture(TANGO_CAMERA_COLOR, &last_gpu_timestamp_);
+  // TangoService_updateTexture() binds the camera texture directly.
+  tango_gl::RenderState::Invalidate();
+  if (update_texture_status != TANGO_SUCCESS) {
     LOGE("PlaneFittingApplication: Failed to get a color image.");
     return;
   }
 
-  // Querying the GPU color image's frame transformation based its timestamp.
-  TangoPoseData pose_start_service_T_color_gpu;
-  TangoCoordinateFramePair color_gpu_frame_pair;
-  color_gpu_frame_pair.base = TANGO_COORDINATE_FRAME_START_OF_SERVICE;
-  color_gpu_frame_pair.target = TANGO_COORDINATE_FRAME_DEVICE;
-  if (TangoService_getPoseAtTime(last_gpu_timestamp_, color_gpu_frame_pair,
-                                 &pose_start_service_T_color_gpu) !=
-      TANGO_SUCCESS) {
-    LOGE(
-        "PlaneFittingApplication: Could not find a valid pose at time %lf"
-        " for the color camera.",
-        last_gpu_timestamp_);
+  // Querying the GPU color image's frame transformation based its timestamp,
+  // from the service only if the pose history does not cover it.
+  glm::mat4 start_service_T_device;
+  bool is_pose_valid =
+      pose_history_.GetPose(last_gpu_timestamp_, &start_service_T_device);
+  if (!is_pose_valid) {
+    TangoPoseData pose_start_service_T_color_gpu;
+    TangoCoordinateFramePair color_gpu_frame_pair;
+    color_gpu_frame_pair.base = TANGO_COORDINATE_FRAME_START_OF_SERVICE;
+    color_gpu_frame_pair.target = TANGO_COORDINATE_FRAME_DEVICE;
+    if (TangoService_getPoseAtTime(last_gpu_timestamp_, color_gpu_frame_pair,
+                                   &pose_start_service_T_color_gpu) !=
+        TANGO_SUCCESS) {
+      LOGE(
+          "PlaneFittingApplication: Could not find a valid pose at time %lf"
+          " for the color camera.",
+          last_gpu_timestamp_);
+    }
+    is_pose_valid =
+        pose_start_service_T_color_gpu.status_code == TANGO_POSE_VALID;
+    start_service_T_device = tango_gl::conversions::TransformFromArrays(
+        pose_start_service_T_color_gpu.translation,
+        pose_start_service_T_color_gpu.orientation).ToMatrix();
   }
 
-  if (pose_start_service_T_color_gpu.status_code == TANGO_POSE_VALID) {
-    const glm::mat4 start_service_T_device =
-        tango_gl::conversions::TransformFromArrays(
-            pose_start_service_T_color_gpu.translation,
-            pose_start_service_T_color_gpu.orientation);
+  ApplyPlaneFit();
 
+  if (is_pose_valid) {
     const glm::mat4 start_service_T_color_camera =
-        start_service_T_device * device_T_color_;
+        start_service_T_device * extrinsics_.GetDeviceTColor();
 
     GLRender(start_service_T_color_camera);
   } else {
@@ -293,7 +350,13 @@ void PlaneFittingApplication::Render() {
 
 void PlaneFittingApplication::GLRender(
     const glm::mat4& start_service_T_color_camera) {
-  glEnable(GL_CULL_FACE);
+  // The counting pass has its own render target, run it before setting up
+  // the state of this frame.
+  point_cloud_->CountPlaneInliers(extrinsics_.GetDeviceTDepth());
+  light_estimator_->Update(video_overlay_->GetTextureId(),
+                           last_gpu_timestamp_);
+
+  tango_gl::RenderState::Enable(GL_CULL_FACE);
 
   glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
   glClear(GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT);
@@ -304,72 +367,191 @@ void PlaneFittingApplication::GLRender(
   glm::mat4 opengl_camera_T_ss = glm::inverse(start_service_T_color_camera *
                                               color_camera_T_opengl_camera_);
 
-  glDisable(GL_DEPTH_TEST);
-  glEnable(GL_BLEND);
+  tango_gl::RenderState::Disable(GL_DEPTH_TEST);
+  tango_gl::RenderState::Enable(GL_BLEND);
   video_overlay_->Render(glm::mat4(1.0), glm::mat4(1.0));
-  glEnable(GL_DEPTH_TEST);
+  tango_gl::RenderState::Enable(GL_DEPTH_TEST);
   point_cloud_->Render(projection_matrix_ar_, opengl_camera_T_ss,
-                       device_T_depth_);
-  glDisable(GL_BLEND);
+                       extrinsics_.GetDeviceTDepth(), &camera_intrinsics_);
+  tango_gl::RenderState::Enable(GL_BLEND);
+  tango_gl::RenderState::Enable(GL_CULL_FACE);
+  const PlaneSet& plane_set = plane_detector_.GetLatestPlanes();
+  plane_renderer_->Render(plane_set, extrinsics_.GetDeviceTDepth(),
+                          projection_matrix_ar_, opengl_camera_T_ss);
+  tango_gl::RenderState::Disable(GL_BLEND);
 
   glm::mat4 opengl_camera_T_opengl_world =
-      opengl_camera_T_ss *
-      glm::inverse(tango_gl::conversions::opengl_world_T_tango_world());
+      opengl_camera_T_ss * start_service_T_opengl_world_;
+  tango_gl::LightEstimator::Estimate light;
+  if (light_estimator_->GetEstimate(&light)) {
+    const float exposure = std::min(
+        std::max(light.intensity / kMiddleGray, kMinExposure), kMaxExposure);
+    tango_gl::Mesh::SetAmbientLight(light.color * exposure, kAmbientIntensity);
+  }
   cube_->Render(projection_matrix_ar_, opengl_camera_T_opengl_world);
+
+  if (debug_draw_->IsEnabled()) {
+    AddPlaneDebugShapes(plane_set);
+  }
+  debug_draw_->Flush(projection_matrix_ar_, opengl_camera_T_ss,
+                     static_cast<int>(screen_width_),
+                     static_cast<int>(screen_height_));
+}
+
+void PlaneFittingApplication::AddPlaneDebugShapes(const PlaneSet& plane_set) {
+  const tango_gl::Color outline_color(1.0f, 1.0f, 1.0f);
+  const tango_gl::Color normal_color(1.0f, 1.0f, 0.0f);
+  const glm::mat4 start_service_T_depth =
+      plane_set.start_service_T_device * extrinsics_.GetDeviceTDepth();
+  for (int i = 0; i < plane_set.plane_count; ++i) {
+    const DetectedPlane& plane = plane_set.planes[i];
+    const glm::vec3 normal(plane.equation);
+    const glm::mat4 depth_T_plane(glm::vec4(plane.axis_u, 0.0f),
+                                  glm::vec4(plane.axis_v, 0.0f),
+                                  glm::vec4(normal, 0.0f),
+                                  glm::vec4(plane.polygon_origin, 1.0f));
+    const glm::mat4 start_service_T_plane =
+        start_service_T_depth * depth_T_plane;
+    for (int j = 0; j < plane.polygon_vertex_count; ++j) {
+      const glm::vec2& a = plane.polygon[j];
+      const glm::vec2& b =
+          plane.polygon[(j + 1) % plane.polygon_vertex_count];
+      debug_draw_->AddLine(
+          glm::vec3(start_service_T_plane * glm::vec4(a, 0.0f, 1.0f)),
+          glm::vec3(start_service_T_plane * glm::vec4(b, 0.0f, 1.0f)),
+          outline_color);
+    }
+    const glm::vec3 center(start_service_T_depth *
+                           glm::vec4(plane.center, 1.0f));
+    const glm::vec3 start_service_normal =
+        glm::mat3(start_service_T_depth) * normal;
+    debug_draw_->AddLine(center, center + start_service_normal * 0.2f,
+                         normal_color);
+    debug_draw_->AddAxes(start_service_T_plane, 0.1f);
+  }
 }
 
 void PlaneFittingApplication::FreeGLContent() {
   delete video_overlay_;
   delete point_cloud_;
+  delete plane_renderer_;
+  delete debug_draw_;
   delete cube_;
+  delete light_estimator_;
   video_overlay_ = nullptr;
   point_cloud_ = nullptr;
+  plane_renderer_ = nullptr;
+  debug_draw_ = nullptr;
   cube_ = nullptr;
+  light_estimator_ = nullptr;
 }
 
-// We assume the Java layer ensures this function is called on the GL thread.
-void PlaneFittingApplication::OnTouchEvent(float x, float y) {
-  // Get the current point cloud data and transform.  This assumes the data has
-  // been recently updated on the render thread and does not attempt to update
-  // again here.
-  const TangoXYZij* current_cloud = point_cloud_->GetCurrentPointData();
-  // This transform relates the point cloud at acquisition time (t0) to the
-  // start of service.
-  const glm::mat4 start_service_T_device_t0 =
-      point_cloud_->GetCurrentTransform();
+bool PlaneFittingApplication::RaycastDetectedPlanes(
+    const glm::vec2& uv, glm::vec3* depth_position,
+    glm::vec4* depth_plane_equation, glm::mat4* start_service_T_device_t0) {
+  const PlaneSet& plane_set = plane_detector_.GetLatestPlanes();
+  if (plane_set.plane_count == 0) {
+    return false;
+  }
+
+  TangoPoseData pose_color_camera_t0_T_depth_camera_t1;
+  if (TangoSupport_calculateRelativePose(
+          last_gpu_timestamp_, TANGO_COORDINATE_FRAME_CAMERA_COLOR,
+          plane_set.timestamp, TANGO_COORDINATE_FRAME_CAMERA_DEPTH,
+          &pose_color_camera_t0_T_depth_camera_t1) != TANGO_SUCCESS) {
+    return false;
+  }
+  const glm::mat4 depth_camera_T_color_camera = tango_gl::InverseRigidMatrix(
+      tango_gl::conversions::TransformFromArrays(
+          pose_color_camera_t0_T_depth_camera_t1.translation,
+          pose_color_camera_t0_T_depth_camera_t1.orientation).ToMatrix());
+
+  // Ray through the touched pixel of the color camera.
+  const glm::vec3 color_direction(
+      (uv.x * color_camera_intrinsics_.width - color_camera_intrinsics_.cx) /
+          color_camera_intrinsics_.fx,
+      (uv.y * color_camera_intrinsics_.height - color_camera_intrinsics_.cy) /
+          color_camera_intrinsics_.fy,
+      1.0f);
+  const glm::vec3 origin(depth_camera_T_color_camera[3]);
+  const glm::vec3 direction =
+      glm::mat3(depth_camera_T_color_camera) * color_direction;
+
+  if (!RaycastPlanes(plane_set, origin, direction, depth_position,
+                     depth_plane_equation)) {
+    return false;
+  }
+  *start_service_T_device_t0 = plane_set.start_service_T_device;
+  return true;
+}
+
+void PlaneFittingApplication::QueuePlaneFit(const glm::vec2& uv) {
+  const tango_gl::PointCloudPool::Handle& frame =
+      point_cloud_->GetCurrentFrame();
+  if (!frame) {
+    return;
+  }
 
   /// Calculate the conversion from the latest depth camera position to the
   /// position of the most recent color camera image. This corrects for screen
-  /// lag between the two systems. 
+  /// lag between the two systems.
   TangoPoseData pose_color_camera_t0_T_depth_camera_t1;
   int ret = TangoSupport_calculateRelativePose(
       last_gpu_timestamp_, TANGO_COORDINATE_FRAME_CAMERA_COLOR,
-      current_cloud->timestamp, TANGO_COORDINATE_FRAME_CAMERA_DEPTH,
+      frame->cloud.timestamp, TANGO_COORDINATE_FRAME_CAMERA_DEPTH,
       &pose_color_camera_t0_T_depth_camera_t1);
   if (ret != TANGO_SUCCESS) {
     LOGE("%s: could not calculate relative pose", __func__);
     return;
   }
-  glm::vec2 uv(x / screen_width_, y / screen_height_);
-
-  glm::dvec3 double_depth_position;
-  glm::dvec4 double_depth_plane_equation;
-  if (TangoSupport_fitPlaneModelNearClick(
-          current_cloud, &color_camera_intrinsics_,
-          &pose_color_camera_t0_T_depth_camera_t1, glm::value_ptr(uv),
-          glm::value_ptr(double_depth_position),
-          glm::value_ptr(double_depth_plane_equation)) != TANGO_SUCCESS) {
-    return;  // Assume error has already been reported.
+
+  // Results come in on the fitting thread, the last plane found wins.
+  plane_fit_queue_.Submit(
+      frame, pose_color_camera_t0_T_depth_camera_t1, uv,
+      [this](const PlaneFitQueue::Result& result) {
+        if (result.is_found) {
+          std::lock_guard<std::mutex> lock(plane_fit_mutex_);
+          plane_fit_ = result;
+          has_plane_fit_ = true;
+        }
+      });
+}
+
+void PlaneFittingApplication::ApplyPlaneFit() {
+  PlaneFitQueue::Result result;
+  {
+    std::lock_guard<std::mutex> lock(plane_fit_mutex_);
+    if (!has_plane_fit_) {
+      return;
+    }
+    result = plane_fit_;
+    has_plane_fit_ = false;
   }
+  PlaceCube(result.depth_position, result.depth_plane_equation,
+            result.start_service_T_device);
+}
 
-  const glm::vec3 depth_position =
-      static_cast<glm::vec3>(double_depth_position);
-  const glm::vec4 depth_plane_equation =
-      static_cast<glm::vec4>(double_depth_plane_equation);
+// We assume the Java layer ensures this function is called on the GL thread.
+void PlaneFittingApplication::OnTouchEvent(float x, float y) {
+  const glm::vec2 uv(x / screen_width_, y / screen_height_);
+
+  glm::vec3 depth_position;
+  glm::vec4 depth_plane_equation;
+  glm::mat4 start_service_T_device_t0;
+  if (RaycastDetectedPlanes(uv, &depth_position, &depth_plane_equation,
+                            &start_service_T_device_t0)) {
+    PlaceCube(depth_position, depth_plane_equation, start_service_T_device_t0);
+  } else {
+    QueuePlaneFit(uv);
+  }
+}
 
+void PlaneFittingApplication::PlaceCube(
+    const glm::vec3& depth_position, const glm::vec4& depth_plane_equation,
+    const glm::mat4& start_service_T_device_t0) {
   const glm::mat4 opengl_world_T_depth = opengl_world_T_start_service_ *
-                                                start_service_T_device_t0 *
-                                                device_T_depth_;
+                                         start_service_T_device_t0 *
+                                         extrinsics_.GetDeviceTDepth();
 
   // Transform to world coordinates
   const glm::vec4 world_position =
@@ -380,6 +562,7 @@ void PlaneFittingApplication::OnTouchEvent(float x, float y) {
                  &world_plane_equation);
 
   point_cloud_->SetPlaneEquation(world_plane_equation);
+  point_cloud_->SetPlaneInlierCounting(true);
 
   const glm::vec3 plane_normal(world_plane_equation);
 
@@ -0,0 +1,216 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "tango-plane-fitting/plane_inlier_counter.h"
+
+#include <algorithm>
+
+#include <tango-gl/counters.h>
+#include <tango-gl/memory_tracker.h>
+#include <tango-gl/program_cache.h>
+#include <tango-gl/render_state.h>
+
+namespace {
+
+// Each point lands on the pixel picked by its index and adds one 8 bit step
+// to the channel of its class: red for inliers, green in front of the plane,
+// blue behind it. Alpha counts every point.
+const std::string kCountVertexShader =
+    "attribute vec4 vertex;\n"
+    "attribute float point_index;\n"
+    "uniform vec4 plane;\n"
+    "uniform float inlier_distance;\n"
+    "uniform float target_size;\n"
+    "varying vec4 v_count;\n"
+    ""
+    "void main() {\n"
+    "  float pixel = mod(point_index, target_size * target_size);\n"
+    "  vec2 position = vec2(mod(pixel, target_size),\n"
+    "                       floor(pixel / target_size)) + 0.5;\n"
+    "  gl_Position = vec4(position * (2.0 / target_size) - 1.0, 0.0, 1.0);\n"
+    "  gl_PointSize = 1.0;\n"
+    "  float d = dot(plane, vertex);\n"
+    "  if (abs(d) < inlier_distance) {\n"
+    "    v_count = vec4(1.0, 0.0, 0.0, 1.0);\n"
+    "  } else if (d > 0.0) {\n"
+    "    v_count = vec4(0.0, 1.0, 0.0, 1.0);\n"
+    "  } else {\n"
+    "    v_count = vec4(0.0, 0.0, 1.0, 1.0);\n"
+    "  }\n"
+    "  v_count /= 255.0;\n"
+    "}\n";
+const std::string kCountFragmentShader =
+    "precision mediump float;\n"
+    "varying vec4 v_count;\n"
+    "void main() {\n"
+    "  gl_FragColor = v_count;\n"
+    "}\n";
+
+// Points a pixel can count before a channel saturates.
+const size_t kMaxPointsPerPixel = 255;
+
+}  // namespace
+
+namespace tango_plane_fitting {
+
+const int PlaneInlierCounter::kTargetSize;
+
+PlaneInlierCounter::PlaneInlierCounter(size_t max_point_count)
+    : index_buffer_(0),
+      max_point_count_(max_point_count),
+      next_target_(0),
+      pixels_(kTargetSize * kTargetSize * 4),
+      has_counts_(false) {
+  if (max_point_count_ > kMaxPointsPerPixel * kTargetSize * kTargetSize) {
+    LOGE("PlaneInlierCounter: Too many points to count per frame");
+    max_point_count_ = kMaxPointsPerPixel * kTargetSize * kTargetSize;
+  }
+
+  shader_program_ = tango_gl::program_cache::AcquireProgram(
+      kCountVertexShader.c_str(), kCountFragmentShader.c_str());
+  vertices_handle_ = glGetAttribLocation(shader_program_, "vertex");
+  index_handle_ = glGetAttribLocation(shader_program_, "point_index");
+  plane_handle_ = glGetUniformLocation(shader_program_, "plane");
+  inlier_distance_handle_ =
+      glGetUniformLocation(shader_program_, "inlier_distance");
+  target_size_handle_ = glGetUniformLocation(shader_program_, "target_size");
+
+  std::vector<GLfloat> indices(max_point_count_);
+  for (size_t i = 0; i < indices.size(); ++i) {
+    indices[i] = static_cast<GLfloat>(i);
+  }
+  glGenBuffers(1, &index_buffer_);
+  tango_gl::RenderState::BindBuffer(GL_ARRAY_BUFFER, index_buffer_);
+  glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * indices.size(),
+               indices.data(), GL_STATIC_DRAW);
+  tango_gl::RenderState::BindBuffer(GL_ARRAY_BUFFER, 0);
+  tango_gl::MemoryTracker::Track(tango_gl::MemoryTracker::kBuffer,
+                                 index_buffer_, "PlaneInlierCounter",
+                                 sizeof(GLfloat) * indices.size());
+
+  GLint framebuffer = 0;
+  glGetIntegerv(GL_FRAMEBUFFER_BINDING, &framebuffer);
+  glGenTextures(2, textures_);
+  glGenFramebuffers(2, framebuffers_);
+  tango_gl::RenderState::ActiveTexture(GL_TEXTURE0);
+  for (int i = 0; i < 2; ++i) {
+    tango_gl::RenderState::BindTexture(GL_TEXTURE_2D, textures_[i]);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, kTargetSize, kTargetSize, 0,
+                 GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    tango_gl::MemoryTracker::Track(
+        tango_gl::MemoryTracker::kTexture, textures_[i], "PlaneInlierCounter",
+        tango_gl::MemoryTracker::GetTextureSize(kTargetSize, kTargetSize,
+                                                GL_RGBA, GL_UNSIGNED_BYTE));
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffers_[i]);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                           GL_TEXTURE_2D, textures_[i], 0);
+    pending_timestamps_[i] = 0.0;
+  }
+  tango_gl::RenderState::BindTexture(GL_TEXTURE_2D, 0);
+  glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+
+  tango_gl::util::CheckGlError("PlaneInlierCounter::Construction");
+}
+
+PlaneInlierCounter::~PlaneInlierCounter() {
+  glDeleteFramebuffers(2, framebuffers_);
+  tango_gl::RenderState::DeleteTextures(2, textures_);
+  tango_gl::RenderState::DeleteBuffers(1, &index_buffer_);
+  tango_gl::program_cache::ReleaseProgram(shader_program_);
+}
+
+void PlaneInlierCounter::Count(const tango_gl::PointCloudBuffer& points,
+                               double timestamp, const glm::vec4& depth_plane,
+                               float inlier_distance) {
+  GLint viewport[4];
+  glGetIntegerv(GL_VIEWPORT, viewport);
+  GLint framebuffer = 0;
+  glGetIntegerv(GL_FRAMEBUFFER_BINDING, &framebuffer);
+
+  const int target = next_target_;
+  const int previous = 1 - target;
+  if (pending_timestamps_[previous] > 0.0) {
+    ReadBack(previous);
+  }
+
+  const size_t point_count = std::min(points.GetPointCount(), max_point_count_);
+  if (point_count > 0) {
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffers_[target]);
+    glViewport(0, 0, kTargetSize, kTargetSize);
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    tango_gl::RenderState::UseProgram(shader_program_);
+    tango_gl::RenderState::Enable(GL_BLEND);
+    glBlendFunc(GL_ONE, GL_ONE);
+    glUniform4fv(plane_handle_, 1, glm::value_ptr(depth_plane));
+    glUniform1f(inlier_distance_handle_, inlier_distance);
+    glUniform1f(target_size_handle_, static_cast<GLfloat>(kTargetSize));
+
+    points.Bind();
+    glEnableVertexAttribArray(vertices_handle_);
+    glVertexAttribPointer(vertices_handle_, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
+    tango_gl::RenderState::BindBuffer(GL_ARRAY_BUFFER, index_buffer_);
+    glEnableVertexAttribArray(index_handle_);
+    glVertexAttribPointer(index_handle_, 1, GL_FLOAT, GL_FALSE, 0, nullptr);
+
+    tango_gl::Counters::Increment(tango_gl::Counters::kDrawCalls);
+    glDrawArrays(GL_POINTS, 0, point_count);
+
+    glDisableVertexAttribArray(index_handle_);
+    glDisableVertexAttribArray(vertices_handle_);
+    pending_timestamps_[target] = timestamp;
+    next_target_ = previous;
+  }
+
+  glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+  glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+  tango_gl::util::CheckGlError("PlaneInlierCounter::Count");
+}
+
+bool PlaneInlierCounter::GetCounts(PlaneInlierCounts* counts) const {
+  if (!has_counts_) {
+    return false;
+  }
+  *counts = counts_;
+  return true;
+}
+
+void PlaneInlierCounter::ReadBack(int target) {
+  // The pass was issued a frame ago, by now the GPU is done with it and the
+  // read does not stall the pipeline.
+  glBindFramebuffer(GL_FRAMEBUFFER, framebuffers_[target]);
+  glReadPixels(0, 0, kTargetSize, kTargetSize, GL_RGBA, GL_UNSIGNED_BYTE,
+               pixels_.data());
+
+  PlaneInlierCounts counts;
+  counts.timestamp = pending_timestamps_[target];
+  for (size_t i = 0; i < pixels_.size(); i += 4) {
+    counts.inlier_count += pixels_[i];
+    counts.front_count += pixels_[i + 1];
+    counts.behind_count += pixels_[i + 2];
+    counts.point_count += pixels_[i + 3];
+  }
+  counts_ = counts;
+  has_counts_ = true;
+  pending_timestamps_[target] = 0.0;
+}
+
+}  // namespace tango_plane_fitting
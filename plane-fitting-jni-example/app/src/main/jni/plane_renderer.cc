@@ -0,0 +1,119 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "tango-plane-fitting/plane_renderer.h"
+
+#include <algorithm>
+
+#include <tango-gl/render_state.h>
+
+namespace {
+// Colors of the planes, picked by id so a plane keeps its color.
+const glm::vec3 kPlaneColors[] = {
+    glm::vec3(0.26f, 0.52f, 0.96f), glm::vec3(0.20f, 0.66f, 0.33f),
+    glm::vec3(0.98f, 0.74f, 0.02f), glm::vec3(0.92f, 0.26f, 0.21f),
+    glm::vec3(0.61f, 0.15f, 0.69f), glm::vec3(0.00f, 0.67f, 0.76f)};
+const int kPlaneColorCount = sizeof(kPlaneColors) / sizeof(kPlaneColors[0]);
+
+const float kPlaneAlpha = 0.35f;
+}  // namespace
+
+namespace tango_plane_fitting {
+
+PlaneRenderer::PlaneRenderer() {}
+
+void PlaneRenderer::Render(const PlaneSet& plane_set,
+                           const glm::mat4& device_T_depth,
+                           const glm::mat4& projection_mat,
+                           const glm::mat4& view_mat) {
+  // Drop the meshes of planes no longer tracked.
+  meshes_.erase(
+      std::remove_if(meshes_.begin(), meshes_.end(),
+                     [&plane_set](const PlaneMesh& plane_mesh) {
+                       for (int i = 0; i < plane_set.plane_count; ++i) {
+                         if (plane_set.planes[i].id == plane_mesh.id) {
+                           return false;
+                         }
+                       }
+                       return true;
+                     }),
+      meshes_.end());
+
+  const glm::mat4 start_service_T_depth =
+      plane_set.start_service_T_device * device_T_depth;
+  // The polygons are seen from both sides.
+  tango_gl::RenderState::Disable(GL_CULL_FACE);
+  for (int i = 0; i < plane_set.plane_count; ++i) {
+    const DetectedPlane& plane = plane_set.planes[i];
+    if (plane.polygon_vertex_count < 3) {
+      continue;
+    }
+    tango_gl::Mesh* mesh = UpdateMesh(plane);
+    const glm::vec3 normal = glm::cross(plane.axis_u, plane.axis_v);
+    const glm::mat4 depth_T_plane(glm::vec4(plane.axis_u, 0.0f),
+                                  glm::vec4(plane.axis_v, 0.0f),
+                                  glm::vec4(normal, 0.0f),
+                                  glm::vec4(plane.polygon_origin, 1.0f));
+    mesh->SetTransformationMatrix(start_service_T_depth * depth_T_plane);
+    mesh->Render(projection_mat, view_mat);
+  }
+  tango_gl::RenderState::Enable(GL_CULL_FACE);
+}
+
+tango_gl::Mesh* PlaneRenderer::UpdateMesh(const DetectedPlane& plane) {
+  std::vector<PlaneMesh>::iterator plane_mesh =
+      std::find_if(meshes_.begin(), meshes_.end(),
+                   [&plane](const PlaneMesh& candidate) {
+                     return candidate.id == plane.id;
+                   });
+  if (plane_mesh == meshes_.end()) {
+    PlaneMesh created;
+    created.id = plane.id;
+    // Revisions start at 1 once a polygon exists, 0 forces the upload.
+    created.polygon_revision = 0;
+    created.mesh.reset(new tango_gl::Mesh(GL_TRIANGLES));
+    created.mesh->SetShader();
+    const glm::vec3& color = kPlaneColors[plane.id % kPlaneColorCount];
+    created.mesh->SetColor(color.r, color.g, color.b);
+    created.mesh->SetAlpha(kPlaneAlpha);
+    meshes_.push_back(std::move(created));
+    plane_mesh = meshes_.end() - 1;
+  }
+  if (plane_mesh->polygon_revision == plane.polygon_revision) {
+    return plane_mesh->mesh.get();
+  }
+
+  // A fan around the first vertex triangulates a convex polygon.
+  const int vertex_count = plane.polygon_vertex_count;
+  vertices_.resize(vertex_count * 3);
+  for (int i = 0; i < vertex_count; ++i) {
+    vertices_[i * 3] = plane.polygon[i].x;
+    vertices_[i * 3 + 1] = plane.polygon[i].y;
+    vertices_[i * 3 + 2] = 0.0f;
+  }
+  indices_.clear();
+  for (int i = 1; i + 1 < vertex_count; ++i) {
+    indices_.push_back(0);
+    indices_.push_back(static_cast<GLushort>(i));
+    indices_.push_back(static_cast<GLushort>(i + 1));
+  }
+  plane_mesh->mesh->SetVertices(vertices_, indices_);
+  plane_mesh->polygon_revision = plane.polygon_revision;
+  return plane_mesh->mesh.get();
+}
+
+}  // namespace tango_plane_fitting
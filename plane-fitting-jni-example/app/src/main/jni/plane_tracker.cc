@@ -0,0 +1,263 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "tango-plane-fitting/plane_tracker.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <tango-gl/rigid_transform.h>
+
+namespace {
+// Largest inlier weight a tracked plane accumulates. Past it older inliers
+// are scaled down, so the newest frames keep a say in the fit.
+const double kMaxPlaneWeight = 20000.0;
+
+// A detection agrees with a tracked plane if their normals are within about
+// 10 degrees and its mean lies within this distance in meters of the plane.
+const float kMergeCosine = 0.985f;
+const float kMergeDistance = 0.05f;
+
+// Tracked planes not seen for this many frames are dropped.
+const int kMaxUnseenFrames = 300;
+
+// Points grow a polygon once they lie this far outside of it in meters,
+// about the depth noise at a few meters.
+const float kPolygonTolerance = 0.02f;
+
+// Unit vector orthogonal to a unit normal.
+glm::vec3 OrthogonalAxis(const glm::vec3& normal) {
+  const glm::vec3 reference = std::abs(normal.x) < 0.9f
+                                  ? glm::vec3(1.0f, 0.0f, 0.0f)
+                                  : glm::vec3(0.0f, 1.0f, 0.0f);
+  return glm::normalize(glm::cross(normal, reference));
+}
+
+// Signed distance of a point to a plane.
+float PlaneDistance(const glm::vec4& equation, const glm::vec3& point) {
+  return glm::dot(glm::vec3(equation), point) + equation.w;
+}
+}  // namespace
+
+namespace tango_plane_fitting {
+
+PlaneTracker::PlaneTracker()
+    : start_service_T_depth_(1.0f),
+      depth_T_start_service_(1.0f),
+      next_plane_id_(0),
+      frame_index_(0) {
+  planes_.reserve(PlaneSet::kMaxPlaneCount);
+}
+
+void PlaneTracker::Reset() {
+  planes_.clear();
+  frame_index_ = 0;
+}
+
+void PlaneTracker::BeginFrame(const glm::mat4& start_service_T_depth) {
+  ++frame_index_;
+  start_service_T_depth_ = start_service_T_depth;
+  depth_T_start_service_ = tango_gl::InverseRigidMatrix(start_service_T_depth);
+}
+
+glm::vec4 PlaneTracker::GetPlaneInDepthFrame(int index) const {
+  glm::vec4 depth_equation;
+  PlaneTransform(planes_[index].equation, depth_T_start_service_,
+                 &depth_equation);
+  return depth_equation;
+}
+
+void PlaneTracker::AddInliers(int index, const PlaneMoments& depth_inliers,
+                              const std::vector<glm::vec3>& depth_points) {
+  PlaneMoments inliers;
+  MomentsTransform(depth_inliers, start_service_T_depth_, &inliers);
+
+  TrackedPlane* plane = &planes_[index];
+  PlaneMoments merged = plane->moments;
+  merged.Merge(inliers);
+  if (merged.weight > kMaxPlaneWeight) {
+    merged.Scale(kMaxPlaneWeight / merged.weight);
+  }
+  const PlaneMoments previous_moments = plane->moments;
+  const glm::vec4 previous_equation = plane->equation;
+  plane->moments = merged;
+  if (!Refit(plane)) {
+    plane->moments = previous_moments;
+    plane->equation = previous_equation;
+    return;
+  }
+  plane->last_seen_frame = frame_index_;
+  GrowPolygon(depth_points, plane);
+}
+
+void PlaneTracker::AddDetection(const PlaneMoments& depth_inliers,
+                                const std::vector<glm::vec3>& depth_points) {
+  TrackedPlane detected;
+  MomentsTransform(depth_inliers, start_service_T_depth_, &detected.moments);
+  detected.last_seen_frame = frame_index_;
+  if (!FitPlane(detected.moments, &detected.equation)) {
+    return;
+  }
+
+  // Merge into the closest tracked plane it agrees with.
+  const glm::vec3 mean(detected.moments.Mean());
+  int match = -1;
+  float match_distance = kMergeDistance;
+  for (size_t i = 0; i < planes_.size(); ++i) {
+    const glm::vec4& equation = planes_[i].equation;
+    const float distance = std::abs(PlaneDistance(equation, mean));
+    if (std::abs(glm::dot(glm::vec3(equation),
+                          glm::vec3(detected.equation))) > kMergeCosine &&
+        distance < match_distance) {
+      match = static_cast<int>(i);
+      match_distance = distance;
+    }
+  }
+  if (match >= 0) {
+    AddInliers(match, depth_inliers, depth_points);
+    return;
+  }
+
+  // A new plane faces the camera it was first seen from.
+  const glm::vec3 camera_position(start_service_T_depth_[3]);
+  if (PlaneDistance(detected.equation, camera_position) < 0.0f) {
+    detected.equation = -detected.equation;
+  }
+  const glm::vec3 normal(detected.equation);
+  detected.id = next_plane_id_++;
+  detected.origin = mean - PlaneDistance(detected.equation, mean) * normal;
+  detected.axis_u = OrthogonalAxis(normal);
+  detected.axis_v = glm::cross(normal, detected.axis_u);
+  detected.polygon_revision = 0;
+
+  TrackedPlane* plane;
+  if (planes_.size() < static_cast<size_t>(PlaneSet::kMaxPlaneCount)) {
+    planes_.push_back(detected);
+    plane = &planes_.back();
+  } else {
+    // Full, give up the plane seen least recently.
+    plane = &*std::min_element(
+        planes_.begin(), planes_.end(),
+        [](const TrackedPlane& a, const TrackedPlane& b) {
+          return a.last_seen_frame < b.last_seen_frame;
+        });
+    *plane = detected;
+  }
+  GrowPolygon(depth_points, plane);
+}
+
+void PlaneTracker::EndFrame(PlaneSet* plane_set) {
+  const int frame_index = frame_index_;
+  planes_.erase(std::remove_if(planes_.begin(), planes_.end(),
+                               [frame_index](const TrackedPlane& plane) {
+                                 return frame_index - plane.last_seen_frame >
+                                        kMaxUnseenFrames;
+                               }),
+                planes_.end());
+  std::sort(planes_.begin(), planes_.end(),
+            [](const TrackedPlane& a, const TrackedPlane& b) {
+              return a.moments.weight > b.moments.weight;
+            });
+
+  const glm::mat3 depth_R_start_service(depth_T_start_service_);
+  plane_set->plane_count = static_cast<int>(planes_.size());
+  for (size_t i = 0; i < planes_.size(); ++i) {
+    const TrackedPlane& tracked = planes_[i];
+    DetectedPlane* plane = &plane_set->planes[i];
+
+    // The polygon axes, kept in the plane as its normal is refit.
+    const glm::vec3 normal(tracked.equation);
+    const glm::vec3 in_plane_u =
+        tracked.axis_u - glm::dot(tracked.axis_u, normal) * normal;
+    const glm::vec3 axis_u = glm::length(in_plane_u) > 1e-3f
+                                 ? glm::normalize(in_plane_u)
+                                 : OrthogonalAxis(normal);
+    const glm::vec3 axis_v = glm::cross(normal, axis_u);
+
+    // Only the moments of the inliers are kept, take the extent of a uniform
+    // distribution with the same variance along each axis.
+    const glm::dmat3 covariance = tracked.moments.Covariance();
+    const glm::dvec3 u(axis_u);
+    const glm::dvec3 v(axis_v);
+    const double variance_u = std::max(0.0, glm::dot(u, covariance * u));
+    const double variance_v = std::max(0.0, glm::dot(v, covariance * v));
+    const glm::vec2 half_extent(
+        static_cast<float>(std::sqrt(3.0 * variance_u)),
+        static_cast<float>(std::sqrt(3.0 * variance_v)));
+
+    PlaneTransform(tracked.equation, depth_T_start_service_, &plane->equation);
+    // The depth camera sits at the origin, face it.
+    if (plane->equation.w < 0.0f) {
+      plane->equation = -plane->equation;
+    }
+    const glm::vec3 center(tracked.moments.Mean());
+    plane->center =
+        glm::vec3(depth_T_start_service_ * glm::vec4(center, 1.0f));
+    plane->axis_u = depth_R_start_service * axis_u;
+    plane->axis_v = depth_R_start_service * axis_v;
+    plane->min_extent = -half_extent;
+    plane->max_extent = half_extent;
+    plane->inlier_count = static_cast<int>(tracked.moments.weight);
+
+    plane->id = tracked.id;
+    const glm::vec3 origin =
+        tracked.origin - PlaneDistance(tracked.equation, tracked.origin) *
+                             normal;
+    plane->polygon_origin =
+        glm::vec3(depth_T_start_service_ * glm::vec4(origin, 1.0f));
+    plane->polygon_vertex_count = static_cast<int>(tracked.polygon.size());
+    std::copy(tracked.polygon.begin(), tracked.polygon.end(), plane->polygon);
+    plane->polygon_revision = tracked.polygon_revision;
+  }
+}
+
+void PlaneTracker::GrowPolygon(const std::vector<glm::vec3>& depth_points,
+                               TrackedPlane* plane) {
+  // Polygon coordinates straight from the depth frame.
+  const glm::mat3 start_service_R_depth(start_service_T_depth_);
+  const glm::vec3 offset =
+      glm::vec3(start_service_T_depth_[3]) - plane->origin;
+  const glm::vec3 depth_u = glm::transpose(start_service_R_depth) *
+                            plane->axis_u;
+  const glm::vec3 depth_v = glm::transpose(start_service_R_depth) *
+                            plane->axis_v;
+  const glm::vec2 origin(glm::dot(offset, plane->axis_u),
+                         glm::dot(offset, plane->axis_v));
+  projected_.resize(depth_points.size());
+  for (size_t i = 0; i < depth_points.size(); ++i) {
+    projected_[i] = origin + glm::vec2(glm::dot(depth_points[i], depth_u),
+                                       glm::dot(depth_points[i], depth_v));
+  }
+  if (GrowConvexPolygon(projected_, kPolygonTolerance,
+                        DetectedPlane::kMaxPolygonVertexCount,
+                        &plane->polygon)) {
+    ++plane->polygon_revision;
+  }
+}
+
+bool PlaneTracker::Refit(TrackedPlane* plane) const {
+  const glm::vec4 previous = plane->equation;
+  if (!FitPlane(plane->moments, &plane->equation)) {
+    return false;
+  }
+  if (glm::dot(glm::vec3(plane->equation), glm::vec3(previous)) < 0.0f) {
+    plane->equation = -plane->equation;
+  }
+  return true;
+}
+
+}  // namespace tango_plane_fitting
@@ -16,6 +16,8 @@
 
 #include "tango-plane-fitting/point_cloud.h"
 
+#include <utility>
+
 #include <tango-gl/conversions.h>
 #include <tango_support_api.h>
 
@@ -25,169 +27,207 @@ namespace tango_plane_fitting {
 
 namespace {
 
-const std::string kPointCloudVertexShader =
-    "precision mediump float;\n"
-    "attribute vec4 vertex;\n"
-    "uniform mat4 mvp;\n"
-    "uniform vec4 plane;\n"
-    "uniform float plane_distance;\n"
-    "varying vec3 v_color;\n"
-    ""
-    "void main() {\n"
-    "  gl_PointSize = 7.0;\n"
-    "  gl_Position =  mvp*vertex;\n"
-    "  "
-    "  float d = dot(plane, vertex);\n"
-    "  if (abs(d) < (plane_distance * plane_distance)) {\n"
-    "    v_color = vec3(0.0, 1.0, 0.0);\n"
-    "  } else if (d < 0.0) {\n"
-    "    v_color = vec3(1.0, 0.0, 0.0);\n"
-    "  } else {\n"
-    "    v_color = vec3(0.0, 0.0, 1.0);\n"
-    "  }\n"
-    "}\n";
-const std::string kPointCloudFragmentShader =
-    "precision mediump float;\n"
-    "varying vec3 v_color;\n"
-    "void main() {\n"
-    "  gl_FragColor = vec4(v_color, 1.0);\n"
-    "}\n";
+// The decimated frames are sparse in the depth image, coarser cells keep the
+// surface closed between their points.
+tango_gl::RangeImageMesh::Options GetMeshOptions() {
+  tango_gl::RangeImageMesh::Options options;
+  options.cell_size = 4;
+  return options;
+}
+
+// Give a range image the depth camera intrinsics, which may change between
+// connections.
+//
+// @return false if the intrinsics are unknown.
+bool UpdateRangeImageIntrinsics(
+    tango_gl::CameraIntrinsicsRegistry* camera_intrinsics,
+    tango_gl::RangeImage* range_image) {
+  TangoCameraIntrinsics intrinsics;
+  if (camera_intrinsics->GetIntrinsics(TANGO_CAMERA_DEPTH, &intrinsics) !=
+      TANGO_SUCCESS) {
+    return false;
+  }
+  const tango_gl::projection::CameraIntrinsics& current =
+      range_image->GetIntrinsics();
+  if (current.width != static_cast<int>(intrinsics.width) ||
+      current.height != static_cast<int>(intrinsics.height) ||
+      current.fx != static_cast<float>(intrinsics.fx) ||
+      current.fy != static_cast<float>(intrinsics.fy) ||
+      current.cx != static_cast<float>(intrinsics.cx) ||
+      current.cy != static_cast<float>(intrinsics.cy)) {
+    range_image->SetIntrinsics(intrinsics);
+  }
+  return true;
+}
 
 }  // namespace
 
-PointCloud::PointCloud(int32_t max_point_cloud_size)
-    : plane_distance_(0.05f),
+const size_t PointCloud::kMaxPointCount;
+
+PointCloud::PointCloud(int32_t max_point_cloud_size,
+                       tango_gl::PointCloudPool* pool,
+                       PlaneDetector* plane_detector)
+    : inlier_counter_(kMaxPointCount),
+      count_inliers_(false),
+      mesh_(GetMeshOptions()),
+      mesh_timestamp_(-1.0),
+      plane_distance_(0.05f),
       debug_colors_(false),
       plane_model_(glm::vec4(0.0, 0.0, 1.0, 0.0)),
-      points_back_(max_point_cloud_size),
-      points_swap_(max_point_cloud_size),
-      points_front_(max_point_cloud_size) {
+      outlier_filter_(tango_gl::DepthOutlierFilter::Options(),
+                      &tango_gl::WorkerPool::GetShared()),
+      pool_(pool),
+      plane_detector_(plane_detector) {
   opengl_world_T_start_service_ =
       tango_gl::conversions::opengl_world_T_tango_world();
 
-  shader_program_ = tango_gl::util::CreateProgram(
-      kPointCloudVertexShader.c_str(), kPointCloudFragmentShader.c_str());
-
-  glGenBuffers(1, &vertex_buffer_);
-
-  mvp_handle_ = glGetUniformLocation(shader_program_, "mvp");
-  vertices_handle_ = glGetAttribLocation(shader_program_, "vertex");
-  plane_handle_ = glGetUniformLocation(shader_program_, "plane");
-  plane_distance_handle_ =
-      glGetUniformLocation(shader_program_, "plane_distance");
-
-  tango_gl::util::CheckGlError("Pointcloud::Construction");
+  decimator_.SetMode(tango_gl::PointCloudDecimator::kVoxelGrid);
+  decimator_.SetTargetPointCount(kMaxPointCount);
+  decimator_.Reserve(max_point_cloud_size);
+  inliers_.resize(static_cast<size_t>(max_point_cloud_size) * 3);
+  if (pool_->GetCapacity() < kMaxPointCount) {
+    LOGE("PointCloud: Pooled frames are too small for decimated frames");
+  }
 }
 
-PointCloud::~PointCloud() {
-  glDeleteProgram(shader_program_);
-  glDeleteBuffers(0, &vertex_buffer_);
-}
+PointCloud::~PointCloud() {}
+
+void PointCloud::UpdateVertices(
+    const TangoXYZij* cloud, const tango_gl::PoseHistory& pose_history,
+    tango_gl::CameraIntrinsicsRegistry* camera_intrinsics) {
+  // Get the transform, from the service only if the pose history does not
+  // cover the point cloud timestamp.
+  glm::mat4 start_service_T_device;
+  if (!pose_history.GetPose(cloud->timestamp, &start_service_T_device)) {
+    TangoCoordinateFramePair frame_pair;
+    frame_pair.base = TANGO_COORDINATE_FRAME_START_OF_SERVICE;
+    frame_pair.target = TANGO_COORDINATE_FRAME_DEVICE;
+    TangoPoseData pose_start_service_T_device_t1;
+
+    if (TangoService_getPoseAtTime(cloud->timestamp, frame_pair,
+                                   &pose_start_service_T_device_t1) !=
+        TANGO_SUCCESS) {
+      LOGE("PointCloud: Could not localize point cloud data");
+      return;
+    }
+
+    start_service_T_device = tango_gl::conversions::TransformFromArrays(
+        pose_start_service_T_device_t1.translation,
+        pose_start_service_T_device_t1.orientation).ToMatrix();
+  }
 
-void PointCloud::UpdateVertices(const TangoXYZij* cloud) {
-  // Get the transform.
-  TangoCoordinateFramePair frame_pair;
-  frame_pair.base = TANGO_COORDINATE_FRAME_START_OF_SERVICE;
-  frame_pair.target = TANGO_COORDINATE_FRAME_DEVICE;
-  TangoPoseData pose_start_service_T_device_t1;
+  if (!motion_gate_.ShouldProcess(start_service_T_device)) {
+    return;
+  }
 
-  if (TangoService_getPoseAtTime(cloud->timestamp, frame_pair,
-                                 &pose_start_service_T_device_t1) !=
-      TANGO_SUCCESS) {
-    LOGE("PointCloud: Could not localize point cloud data");
+  // Decimate straight into pooled storage, the renderer and the plane
+  // detector then share the frame without copies.
+  tango_gl::PointCloudPool::Handle frame = pool_->Allocate();
+  if (!frame) {
+    LOGE("PointCloud: Every pooled frame is in use, dropping point cloud");
     return;
   }
+  size_t point_count = 0;
+  const float* points = RemoveOutliers(cloud, camera_intrinsics, &point_count);
+  frame->cloud.xyz_count = static_cast<uint32_t>(
+      decimator_.Decimate(points, point_count, frame->cloud.xyz[0]));
+  frame->cloud.timestamp = cloud->timestamp;
+  frame->pose = start_service_T_device;
+
+  pool_->Publish(frame);
+  if (plane_detector_) {
+    plane_detector_->Submit(frame);
+  }
+}
 
-  const glm::mat4 start_service_T_device =
-      tango_gl::conversions::TransformFromArrays(
-          pose_start_service_T_device_t1.translation,
-          pose_start_service_T_device_t1.orientation);
+const float* PointCloud::RemoveOutliers(
+    const TangoXYZij* cloud,
+    tango_gl::CameraIntrinsicsRegistry* camera_intrinsics,
+    size_t* point_count) {
+  *point_count = cloud->xyz_count;
+  if (!UpdateRangeImageIntrinsics(camera_intrinsics, &range_image_)) {
+    return cloud->xyz[0];
+  }
 
-  // Copy into back buffer.
-  TangoSupport_copyXYZij(cloud, &points_back_.cloud);
-  points_back_.start_service_T_device_t1 = start_service_T_device;
+  range_image_.Update(*cloud);
+  if (outlier_filter_.Filter(range_image_) == 0) {
+    return cloud->xyz[0];
+  }
+  if (inliers_.size() < *point_count * 3) {
+    inliers_.resize(*point_count * 3);
+  }
+  *point_count =
+      outlier_filter_.CopyInliers(cloud->xyz[0], *point_count, inliers_.data());
+  return inliers_.data();
+}
 
-  {
-    std::lock_guard<std::mutex> lock(buffer_lock_);
-    SwapPointCloudData(points_back_, points_swap_);
+bool PointCloud::UpdateRenderPoints() {
+  tango_gl::PointCloudPool::Handle latest = pool_->AcquireLatest();
+  if (!latest ||
+      (front_ && latest->cloud.timestamp <= front_->cloud.timestamp)) {
+    return false;
   }
+  front_ = std::move(latest);
+  return true;
 }
 
-PointCloud::PointData::PointData(int32_t max_point_cloud_size)
-    : start_service_T_device_t1(1.0) {
-  TangoSupport_createXYZij(max_point_cloud_size, &cloud);
+glm::vec4 PointCloud::GetDepthPlane(const glm::mat4& device_T_depth) const {
+  // Every factor is rigid, so the inverse is a transpose of the rotation.
+  const glm::mat4 depth_T_opengl = tango_gl::InverseRigidMatrix(
+      opengl_world_T_start_service_ * front_->pose * device_T_depth);
+
+  // Transform plane into depth camera coordinates.
+  glm::vec4 depth_plane;
+  PlaneTransform(plane_model_, depth_T_opengl, &depth_plane);
+  return depth_plane;
 }
 
-PointCloud::PointData::~PointData() { TangoSupport_freeXYZij(&cloud); }
+void PointCloud::CountPlaneInliers(const glm::mat4& device_T_depth) {
+  this->UpdateRenderPoints();
+  if (!count_inliers_ || !front_) {
+    return;
+  }
 
-void PointCloud::SwapPointCloudData(PointCloud::PointData& a,
-                                    PointCloud::PointData& b) const {
-  std::swap(a.cloud.xyz, b.cloud.xyz);
-  std::swap(a.cloud.xyz_count, b.cloud.xyz_count);
-  std::swap(a.cloud.timestamp, b.cloud.timestamp);
-  std::swap(a.start_service_T_device_t1, b.start_service_T_device_t1);
+  // Only uploads when a new frame was swapped in since the last upload.
+  vertex_buffer_.Update(front_->cloud.timestamp, front_->cloud.xyz[0],
+                        front_->cloud.xyz_count);
+  inlier_counter_.Count(vertex_buffer_, front_->cloud.timestamp,
+                        GetDepthPlane(device_T_depth), plane_distance_);
 }
 
-bool PointCloud::UpdateRenderPoints() {
-  bool updated = false;
-  std::lock_guard<std::mutex> lock(buffer_lock_);
-  if (points_swap_.cloud.timestamp > points_front_.cloud.timestamp) {
-    updated = true;
-    SwapPointCloudData(points_swap_, points_front_);
+bool PointCloud::UpdateMesh(
+    tango_gl::CameraIntrinsicsRegistry* camera_intrinsics) {
+  if (front_->cloud.timestamp == mesh_timestamp_) {
+    return mesh_.GetKeptNodeCount() > 0;
+  }
+  if (!UpdateRangeImageIntrinsics(camera_intrinsics, &mesh_range_image_)) {
+    return false;
   }
-  return updated;
+  mesh_range_image_.Update(front_->cloud.xyz[0], front_->cloud.xyz_count);
+  mesh_timestamp_ = front_->cloud.timestamp;
+  return mesh_.Update(mesh_range_image_) > 0;
 }
 
 void PointCloud::Render(const glm::mat4& projection,
                         const glm::mat4& opengl_camera_T_start_service,
-                        const glm::mat4& device_T_depth) {
+                        const glm::mat4& device_T_depth,
+                        tango_gl::CameraIntrinsicsRegistry* camera_intrinsics) {
   // Update point data.
-  const bool points_need_buffering = this->UpdateRenderPoints();
-  if (!debug_colors_) {
+  this->UpdateRenderPoints();
+  if (!debug_colors_ || !front_ || !UpdateMesh(camera_intrinsics)) {
     return;
   }
 
-  glUseProgram(shader_program_);
-
-  const size_t number_of_vertices = points_front_.cloud.xyz_count;
-
-  glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer_);
-  if (points_need_buffering) {
-    glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * 3 * number_of_vertices,
-                 points_front_.cloud.xyz[0], GL_STATIC_DRAW);
-  }
-  const glm::mat4 start_service_T_device_t1 =
-      points_front_.start_service_T_device_t1;
-  const glm::mat4 mvp_mat = projection * opengl_camera_T_start_service *
-                            start_service_T_device_t1 * device_T_depth;
-
-  const glm::mat4 depth_T_opengl =
-      glm::inverse(opengl_world_T_start_service_ * start_service_T_device_t1 *
-                   device_T_depth);
-
-  // Transform plane into depth camera coordinates.
-  glm::vec4 camera_plane;
-  PlaneTransform(plane_model_, depth_T_opengl, &camera_plane);
-
-  glUniformMatrix4fv(mvp_handle_, 1, GL_FALSE, glm::value_ptr(mvp_mat));
-
-  glUniform4fv(plane_handle_, 1, glm::value_ptr(camera_plane));
-
   // It looks better to have more points colored by the plane than the number
   // needed to be a good inlier support for fitting. Scale the distance here.
+  // The band is as wide as the one the point shader drew, which compared
+  // against the square of the scaled distance.
   constexpr float kDistanceScale = 5.0f;
-  glUniform1f(plane_distance_handle_, kDistanceScale * plane_distance_);
-
-  glEnableVertexAttribArray(vertices_handle_);
-  glVertexAttribPointer(vertices_handle_, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
-
-  glDrawArrays(GL_POINTS, 0, number_of_vertices);
-
-  glDisableVertexAttribArray(vertices_handle_);
-  glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-  glUseProgram(0);
-  tango_gl::util::CheckGlError("Pointcloud::Render");
+  const float band_distance = kDistanceScale * plane_distance_;
+  mesh_.SetPlaneColors(GetDepthPlane(device_T_depth),
+                       band_distance * band_distance);
+  mesh_.Render(projection, opengl_camera_T_start_service,
+               front_->pose * device_T_depth);
 }
 
 }  // namespace tango_plane_fitting
@@ -0,0 +1,149 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_PLANE_FITTING_PLANE_DETECTOR_H_
+#define TANGO_PLANE_FITTING_PLANE_DETECTOR_H_
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <tango-gl/point_cloud_pool.h>
+#include <tango-gl/triple_buffer.h>
+#include <tango-gl/util.h>
+#include <tango-gl/worker_pool.h>
+
+#include "tango-plane-fitting/plane_fitting.h"
+#include "tango-plane-fitting/plane_tracker.h"
+
+namespace tango_plane_fitting {
+
+// PlaneDetector extracts the dominant planes of each depth frame on a
+// background thread. Points supporting a plane already tracked by the
+// PlaneTracker refine that plane and are removed first, so only the points
+// left over are searched for new planes. Every new plane is found by RANSAC
+// over the points not yet claimed by a larger plane:
+//
+// 1. Batches of three point hypotheses are scored in parallel on a
+//    WorkerPool, each task drawing from its own random sequence.
+// 2. After each round the number of hypotheses needed for the configured
+//    confidence is recomputed from the best inlier ratio, so frames dominated
+//    by a few large planes terminate after a single round.
+// 3. The best hypothesis is refit to its inliers by least squares, handed
+//    to the tracker, and the inliers of the refit plane are removed before
+//    searching for the next one.
+//
+// Only the latest submitted frame is processed, frames arriving while the
+// detector is busy replace each other. Results are published through a
+// triple buffer, so the consumer never waits for a detection in progress.
+class PlaneDetector {
+ public:
+  PlaneDetector();
+  PlaneDetector(const PlaneDetector& other) = delete;
+  const PlaneDetector& operator=(const PlaneDetector&) = delete;
+  ~PlaneDetector();
+
+  // Start the detection thread with no tracked planes.
+  //
+  // @param device_T_depth: fixed pose of the depth camera with respect to the
+  //        device.
+  void Start(const glm::mat4& device_T_depth);
+
+  // Stop the detection thread, dropping any pending frame.
+  void Stop();
+
+  // Hand a depth frame to the detection thread. Intended to be called from
+  // the point cloud callback, the frame is shared, not copied.
+  //
+  // @param frame: points in the depth camera frame, with the device pose at
+  //        the frame timestamp with respect to start of service.
+  void Submit(const tango_gl::PointCloudPool::Handle& frame);
+
+  // Get the planes of the most recently processed frame. Intended to be
+  // called from a single consumer thread, the returned set stays valid until
+  // the next call.
+  const PlaneSet& GetLatestPlanes();
+
+ private:
+  // Best hypothesis of a RANSAC task.
+  struct Hypothesis {
+    glm::vec4 equation;
+    int inlier_count;
+  };
+
+  void DetectionLoop();
+
+  // Track and find the planes of a frame, largest first.
+  //
+  // @param frame: depth frame, released as soon as its points are read.
+  // @param plane_set: output planes, in the depth frame.
+  void DetectPlanes(tango_gl::PointCloudPool::Handle frame,
+                    PlaneSet* plane_set);
+
+  // Run RANSAC over the remaining points and refit the winner.
+  //
+  // @param equation: output refit plane equation.
+  // @param inliers: output moments of the refit plane inliers.
+  // @param inlier_points: output refit plane inliers.
+  // @return: true if a plane with enough support was found.
+  bool FindPlane(glm::vec4* equation, PlaneMoments* inliers,
+                 std::vector<glm::vec3>* inlier_points);
+
+  // Score hypotheses_per_task_ random hypotheses into hypotheses_[task].
+  void RunHypotheses(int task);
+
+  // Count the remaining points within the inlier distance of a plane.
+  int CountInliers(const glm::vec4& equation) const;
+
+  // Sum up the remaining points within the inlier distance of a plane.
+  //
+  // @param inlier_points: if not null, output the points summed up.
+  void AccumulateInliers(const glm::vec4& equation, PlaneMoments* inliers,
+                         std::vector<glm::vec3>* inlier_points) const;
+
+  // Drop the inliers of a plane from the remaining points.
+  void RemoveInliers(const glm::vec4& equation);
+
+  // The shared pool.
+  tango_gl::WorkerPool* worker_pool_;
+  std::thread thread_;
+
+  // Latest submitted frame, guarded by mutex_.
+  std::mutex mutex_;
+  std::condition_variable frame_available_;
+  tango_gl::PointCloudPool::Handle pending_frame_;
+  bool is_stopping_;
+
+  // Frame being processed, only touched by the detection thread.
+  glm::mat4 device_T_depth_;
+  PlaneTracker tracker_;
+  std::vector<glm::vec3> remaining_;
+  // Inliers of the plane being added to the tracker.
+  std::vector<glm::vec3> inlier_points_;
+  std::vector<Hypothesis> hypotheses_;
+  int hypotheses_per_task_;
+  // Bumped for every round of hypotheses so each round draws fresh samples.
+  unsigned int round_seed_;
+
+  tango_gl::TripleBuffer<PlaneSet> planes_;
+};
+
+}  // namespace tango_plane_fitting
+
+#endif  // TANGO_PLANE_FITTING_PLANE_DETECTOR_H_
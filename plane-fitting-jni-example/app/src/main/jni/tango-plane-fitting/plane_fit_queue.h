@@ -0,0 +1,129 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TANGO_PLANE_FITTING_PLANE_FIT_QUEUE_H_
+#define TANGO_PLANE_FITTING_PLANE_FIT_QUEUE_H_
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <tango_client_api.h>
+#include <tango-gl/point_cloud_pool.h>
+#include <tango-gl/range_image.h>
+#include <tango-gl/util.h>
+
+namespace tango_plane_fitting {
+
+// PlaneFitQueue fits planes near touches on a background thread, so a touch
+// never blocks the thread handling it on TangoSupport_fitPlaneModelNearClick().
+//
+// A touch is queued with the depth frame it is resolved against and the pose
+// of that frame relative to the color camera at the touch. The fitting thread
+// takes every queued touch at once and groups them by frame. The points of a
+// frame are projected into an organized depth image once per group, through
+// the ij index grid of the frame when it has one, and each touch is fit by
+// least squares to the points around the pixel its ray falls on. Only touches
+// whose neighborhood is too sparse or not flat fall back to the support
+// library, which projects the whole frame again for each call.
+class PlaneFitQueue {
+ public:
+  struct Result {
+    // False if no plane was found near the touch.
+    bool is_found;
+    // Touched point and plane, in the depth camera frame.
+    glm::vec3 depth_position;
+    glm::vec4 depth_plane_equation;
+    // Pose recorded with the frame, the device with respect to start of
+    // service at its timestamp.
+    glm::mat4 start_service_T_device;
+  };
+
+  // Called on the fitting thread, in the order the touches were queued.
+  typedef std::function<void(const Result& result)> ResultCallback;
+
+  PlaneFitQueue();
+  PlaneFitQueue(const PlaneFitQueue& other) = delete;
+  const PlaneFitQueue& operator=(const PlaneFitQueue&) = delete;
+  ~PlaneFitQueue();
+
+  // Start the fitting thread.
+  //
+  // @param color_intrinsics: intrinsics of the color camera the touches are
+  //        in.
+  // @param depth_intrinsics: intrinsics of the depth camera, for the
+  //        organized image. With a zero size every touch goes to the support
+  //        library.
+  void Start(const TangoCameraIntrinsics& color_intrinsics,
+             const TangoCameraIntrinsics& depth_intrinsics);
+
+  // Stop the fitting thread, dropping the touches not fit yet.
+  void Stop();
+
+  // Queue a touch. The frame is shared, not copied.
+  //
+  // @param frame: points in the depth camera frame.
+  // @param color_camera_T_depth_camera: pose of the frame relative to the
+  //        color camera at the time of the touch, see
+  //        TangoSupport_calculateRelativePose().
+  // @param uv: touch location in normalized color image coordinates.
+  // @param on_result: receives the result.
+  // @return false if the queue is not started.
+  bool Submit(const tango_gl::PointCloudPool::Handle& frame,
+              const TangoPoseData& color_camera_T_depth_camera,
+              const glm::vec2& uv, ResultCallback on_result);
+
+ private:
+  struct Request {
+    tango_gl::PointCloudPool::Handle frame;
+    TangoPoseData color_camera_T_depth_camera;
+    glm::vec2 uv;
+    ResultCallback on_result;
+    Result result;
+    bool is_fit;
+  };
+
+  void FitLoop();
+
+  // Fit a touch, first to the organized image if it holds its frame.
+  void Fit(bool is_image_valid, Request* request) const;
+
+  // Fit a plane to the organized image around the touch ray.
+  //
+  // @return false if the neighborhood is too sparse or not flat.
+  bool FitNearRay(const TangoXYZij& cloud, const glm::vec3& origin,
+                  const glm::vec3& direction, Result* result) const;
+
+  std::thread thread_;
+
+  // Touches not taken by the fitting thread yet, guarded by mutex_.
+  std::mutex mutex_;
+  std::condition_variable request_available_;
+  std::vector<Request> pending_requests_;
+  bool is_stopping_;
+
+  // Only touched by the fitting thread.
+  TangoCameraIntrinsics color_intrinsics_;
+  bool has_depth_intrinsics_;
+  tango_gl::RangeImage depth_image_;
+  std::vector<Request> batch_;
+};
+
+}  // namespace tango_plane_fitting
+
+#endif  // TANGO_PLANE_FITTING_PLANE_FIT_QUEUE_H_
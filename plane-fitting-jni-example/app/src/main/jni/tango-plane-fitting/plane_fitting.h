@@ -24,10 +24,132 @@
 
 namespace tango_plane_fitting {
 
+// Running sums over a set of points, enough to fit a plane to them by least
+// squares. Sets are merged by adding their moments.
+struct PlaneMoments {
+  PlaneMoments() : weight(0.0), sum(0.0), outer_sum(0.0) {}
+
+  void Add(const glm::vec3& point) {
+    const glm::dvec3 p(point);
+    weight += 1.0;
+    sum += p;
+    outer_sum += glm::outerProduct(p, p);
+  }
+
+  void Merge(const PlaneMoments& other) {
+    weight += other.weight;
+    sum += other.sum;
+    outer_sum += other.outer_sum;
+  }
+
+  // Scale the weight of every point, keeping mean and covariance.
+  void Scale(double factor) {
+    weight *= factor;
+    sum *= factor;
+    outer_sum *= factor;
+  }
+
+  glm::dvec3 Mean() const { return sum / weight; }
+
+  glm::dmat3 Covariance() const {
+    const glm::dvec3 mean = Mean();
+    return outer_sum / weight - glm::outerProduct(mean, mean);
+  }
+
+  double weight;
+  glm::dvec3 sum;
+  glm::dmat3 outer_sum;
+};
+
+// A plane expressed in the coordinates of a depth frame.
+struct DetectedPlane {
+  static const int kMaxPolygonVertexCount = 48;
+
+  // Plane equation (a, b, c, d) with a unit normal facing the camera, so
+  // dot(equation, (p, 1)) is the signed distance of p to the plane.
+  glm::vec4 equation;
+  // Mean of the inliers and an orthonormal basis of the plane. The basis
+  // stays the same while the plane is tracked.
+  glm::vec3 center;
+  glm::vec3 axis_u;
+  glm::vec3 axis_v;
+  // Extent of the inliers along axis_u and axis_v, relative to center.
+  glm::vec2 min_extent;
+  glm::vec2 max_extent;
+  // Number of points supporting the plane.
+  int inlier_count;
+  // Identifies the tracked plane across plane sets.
+  int id;
+  // Convex outline of all the inliers seen so far, counterclockwise around
+  // axis_u x axis_v, vertex p at polygon_origin + p.x * axis_u + p.y *
+  // axis_v. The vertices only change when polygon_revision does.
+  glm::vec3 polygon_origin;
+  glm::vec2 polygon[kMaxPolygonVertexCount];
+  int polygon_vertex_count;
+  unsigned int polygon_revision;
+};
+
+// The planes known at the time of a depth frame, in its coordinates, largest
+// first.
+struct PlaneSet {
+  static const int kMaxPlaneCount = 8;
+
+  PlaneSet() : timestamp(0.0), start_service_T_device(1.0f), plane_count(0) {}
+
+  double timestamp;
+  glm::mat4 start_service_T_device;
+  int plane_count;
+  DetectedPlane planes[kMaxPlaneCount];
+};
 
 void PlaneTransform(const glm::vec4& in_plane, const glm::mat4& out_T_in,
                     glm::vec4* out_plane);
 
+// Express the moments of a point set in another frame.
+//
+// @param in_moments: moments in the input frame.
+// @param out_T_in: rigid transform of the input frame with respect to the
+//        output frame.
+// @param out_moments: moments in the output frame.
+void MomentsTransform(const PlaneMoments& in_moments, const glm::mat4& out_T_in,
+                      PlaneMoments* out_moments);
+
+// Least squares plane through a point set: its normal is the direction of
+// least variance around the mean. The sign of the normal is arbitrary.
+//
+// @param moments: moments of at least three points.
+// @param plane: output plane equation with a unit normal.
+// @return: false if the points do not define a plane, e.g. when collinear.
+bool FitPlane(const PlaneMoments& moments, glm::vec4* plane);
+
+// Grow a convex polygon to enclose a set of points too. Points within
+// tolerance of the polygon are treated as inside, so the polygon settles
+// once the plane is covered instead of creeping with the sensor noise, and
+// only points outside are sorted.
+//
+// @param points: points to add.
+// @param tolerance: distance outside the polygon a point needs to grow it.
+// @param max_vertex_count: the vertices cutting off the least area are
+//        dropped past this count, at least 3.
+// @param polygon: input and output, counterclockwise convex polygon, empty
+//        to start one.
+// @return: true if the polygon changed.
+bool GrowConvexPolygon(const std::vector<glm::vec2>& points, float tolerance,
+                       int max_vertex_count, std::vector<glm::vec2>* polygon);
+
+// Find the nearest plane of a set hit by a ray, within the extent of its
+// inliers.
+//
+// @param plane_set: planes in depth camera coordinates.
+// @param origin: ray origin in depth camera coordinates.
+// @param direction: ray direction in depth camera coordinates.
+// @param position: output intersection point.
+// @param equation: output equation of the plane hit.
+// @return: false if the ray misses every plane.
+bool RaycastPlanes(const PlaneSet& plane_set, const glm::vec3& origin,
+                   const glm::vec3& direction, glm::vec3* position,
+                   glm::vec4* equation);
+
 }  // namespace tango_plane_fitting
 
 #endif  // TANGO_PLANE_FITTING_PLANE_FITTING_H_
@@ -19,11 +19,21 @@
 
 #include <jni.h>
 
+#include <mutex>
+
 #include <tango_client_api.h>
+#include <tango-gl/camera_intrinsics_registry.h>
 #include <tango-gl/cube.h>
+#include <tango-gl/debug_draw.h>
+#include <tango-gl/device_extrinsics.h>
+#include <tango-gl/light_estimator.h>
+#include <tango-gl/pose_history.h>
 #include <tango-gl/util.h>
 #include <tango-gl/video_overlay.h>
 
+#include "tango-plane-fitting/plane_detector.h"
+#include "tango-plane-fitting/plane_fit_queue.h"
+#include "tango-plane-fitting/plane_renderer.h"
 #include "tango-plane-fitting/point_cloud.h"
 
 namespace tango_plane_fitting {
@@ -55,6 +65,10 @@ class PlaneFittingApplication {
   // Configure whether to display depth data for debugging.
   void SetRenderDebugPointCloud(bool on);
 
+  // Get the share of the latest depth frame supporting the placed plane,
+  // counted on the GPU. 0 until a plane is placed.
+  float GetPlaneInlierRatio() const;
+
   // Configure the viewport of the GL view.
   void SetViewPort(int width, int height);
 
@@ -71,9 +85,18 @@ class PlaneFittingApplication {
   //
   void OnXYZijAvailable(const TangoXYZij* xyz_ij);
 
+  //
+  // Callback for the device poses that come in from the Tango service.
+  //
+  // @param pose The start of service to device pose.
+  //
+  void OnPoseAvailable(const TangoPoseData* pose);
+
   //
   // Callback for touch events to fit a plane and place an object.  The Java
-  // layer should ensure this is only called from the GL thread.
+  // layer should ensure this is only called from the GL thread. A touch
+  // missing the detected planes is fit in the background, the object moves
+  // once the fit is done.
   //
   // @param x The requested x coordinate in screen space of the window.
   // @param y The requested y coordinate in screen space of the window.
@@ -83,13 +106,63 @@ class PlaneFittingApplication {
   // Details of rendering to OpenGL after determining transforms.
   void GLRender(const glm::mat4& w_T_cc);
 
+  // Outline the planes of a set, with their normals and polygon frames, in
+  // debug_draw_.
+  void AddPlaneDebugShapes(const PlaneSet& plane_set);
+
+  // Queue a touch to be fit to the current point cloud in the background,
+  // see PlaneFitQueue.
+  void QueuePlaneFit(const glm::vec2& uv);
+
+  // Place the cube on the plane of the last fit done in the background, if
+  // any. Called on the GL thread.
+  void ApplyPlaneFit();
+
+  // Place the cube on a plane under a touch.
+  //
+  // @param depth_position The touched point in depth camera coordinates.
+  // @param depth_plane_equation The plane in depth camera coordinates.
+  // @param start_service_T_device_t0 The device pose at the timestamp of the
+  // depth frame the plane was found in.
+  void PlaceCube(const glm::vec3& depth_position,
+                 const glm::vec4& depth_plane_equation,
+                 const glm::mat4& start_service_T_device_t0);
+
+  // Intersect the touch ray with the planes of the latest detection.
+  bool RaycastDetectedPlanes(const glm::vec2& uv, glm::vec3* depth_position,
+                             glm::vec4* depth_plane_equation,
+                             glm::mat4* start_service_T_device_t0);
+
   TangoConfig tango_config_;
   TangoCameraIntrinsics color_camera_intrinsics_;
+  // Color camera intrinsics and projection, queried once per connection.
+  tango_gl::CameraIntrinsicsRegistry camera_intrinsics_;
 
   // Render objects
   tango_gl::VideoOverlay* video_overlay_;
   PointCloud* point_cloud_;
+
+  // Decimated depth frames, shared by the point cloud renderer and the plane
+  // detector. Declared before the detector so it outlives the frames the
+  // detector holds on to.
+  tango_gl::PointCloudPool point_cloud_pool_;
+
+  // Extracts the planes of each depth frame, so touches resolve without
+  // fitting on the GL thread.
+  PlaneDetector plane_detector_;
+  // Fits touches that miss the detected planes. The last plane found is
+  // handed to the GL thread through plane_fit_.
+  PlaneFitQueue plane_fit_queue_;
+  std::mutex plane_fit_mutex_;
+  PlaneFitQueue::Result plane_fit_;
+  bool has_plane_fit_;
+  // Outlines of the detected planes.
+  PlaneRenderer* plane_renderer_;
+  // Plane outlines and normals while the debug point cloud is on.
+  tango_gl::DebugDraw* debug_draw_;
   tango_gl::Cube* cube_;
+  // Average brightness and color of the camera image, lighting the cube.
+  tango_gl::LightEstimator* light_estimator_;
 
   // The dimensions of the render window.
   float screen_width_;
@@ -99,13 +172,16 @@ class PlaneFittingApplication {
 
   double last_gpu_timestamp_;
 
+  // Device poses with respect to start of service from the pose callback.
+  tango_gl::PoseHistory pose_history_;
+
   // Cached transforms
-  // Pose of color camera with respect to device.
-  glm::mat4 device_T_color_;
-  // Pose of depth camera with respect to device.
-  glm::mat4 device_T_depth_;
+  // Poses of the cameras with respect to device.
+  tango_gl::DeviceExtrinsics extrinsics_;
   // Start of service with respect to OpenGL world.
   glm::mat4 opengl_world_T_start_service_;
+  // OpenGL world with respect to start of service.
+  glm::mat4 start_service_T_opengl_world_;
   // OpenGL camera with respect to color camera.
   glm::mat4 color_camera_T_opengl_camera_;
   // OpenGL projection matrix.
@@ -0,0 +1,111 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_PLANE_FITTING_PLANE_INLIER_COUNTER_H_
+#define TANGO_PLANE_FITTING_PLANE_INLIER_COUNTER_H_
+
+#include <vector>
+
+#include <tango-gl/point_cloud_buffer.h>
+#include <tango-gl/util.h>
+
+namespace tango_plane_fitting {
+
+// Classification of a depth frame against a plane.
+struct PlaneInlierCounts {
+  PlaneInlierCounts()
+      : timestamp(0.0), inlier_count(0), front_count(0), behind_count(0),
+        point_count(0) {}
+
+  // Timestamp of the depth frame counted.
+  double timestamp;
+  // Points within the inlier distance of the plane, on its normal side and
+  // on the other side.
+  int inlier_count;
+  int front_count;
+  int behind_count;
+  int point_count;
+};
+
+// PlaneInlierCounter classifies the points of a depth frame against a plane
+// on the GPU. Every point is drawn as a single pixel into a small render
+// target with additive blending, adding one 8 bit step to the channel of its
+// class and to alpha. Points are spread over the target by their index, so
+// no pixel collects more than 255 of them.
+//
+// The counts are read back one frame late, from the target drawn during the
+// previous frame, so the CPU does not wait for the pass it just issued. All
+// functions must be called on the GL thread.
+class PlaneInlierCounter {
+ public:
+  // @param max_point_count: largest depth frame counted.
+  explicit PlaneInlierCounter(size_t max_point_count);
+  PlaneInlierCounter(const PlaneInlierCounter& other) = delete;
+  const PlaneInlierCounter& operator=(const PlaneInlierCounter&) = delete;
+  ~PlaneInlierCounter();
+
+  // Read back the counts of the previous pass, then count a depth frame.
+  // Leaves GL_BLEND enabled with an additive blend function and a black clear
+  // color, the framebuffer binding and the viewport are restored.
+  //
+  // @param points: depth frame in the depth camera frame.
+  // @param timestamp: timestamp of the depth frame.
+  // @param depth_plane: plane in the depth camera frame.
+  // @param inlier_distance: distance in meters within which a point is an
+  // inlier.
+  void Count(const tango_gl::PointCloudBuffer& points, double timestamp,
+             const glm::vec4& depth_plane, float inlier_distance);
+
+  // Get the counts read back most recently.
+  //
+  // @return false if no pass was read back yet.
+  bool GetCounts(PlaneInlierCounts* counts) const;
+
+ private:
+  // Edge of the square render targets in pixels.
+  static const int kTargetSize = 32;
+
+  // Sum the target drawn by the previous pass into counts_.
+  void ReadBack(int target);
+
+  GLuint shader_program_;
+  GLuint vertices_handle_;
+  GLuint index_handle_;
+  GLuint plane_handle_;
+  GLuint inlier_distance_handle_;
+  GLuint target_size_handle_;
+
+  // Index of every point, as floats since OpenGL ES 2.0 vertex shaders have
+  // no vertex id.
+  GLuint index_buffer_;
+  size_t max_point_count_;
+
+  // Two render targets, drawn in turns.
+  GLuint textures_[2];
+  GLuint framebuffers_[2];
+  int next_target_;
+  // Timestamp of the frame counted into each target, 0 if none is pending.
+  double pending_timestamps_[2];
+
+  std::vector<uint8_t> pixels_;
+  PlaneInlierCounts counts_;
+  bool has_counts_;
+};
+
+}  // namespace tango_plane_fitting
+
+#endif  // TANGO_PLANE_FITTING_PLANE_INLIER_COUNTER_H_
@@ -0,0 +1,70 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_PLANE_FITTING_PLANE_RENDERER_H_
+#define TANGO_PLANE_FITTING_PLANE_RENDERER_H_
+
+#include <memory>
+#include <vector>
+
+#include <tango-gl/mesh.h>
+#include <tango-gl/util.h>
+
+#include "tango-plane-fitting/plane_fitting.h"
+
+namespace tango_plane_fitting {
+
+// PlaneRenderer draws the polygons of the tracked planes as translucent
+// triangle fans. Each plane has its own tango_gl::Mesh with the polygon in
+// the plane frame, so only the model matrix changes from frame to frame and
+// the vertex buffer is uploaded again only when the polygon grows. Must be
+// used on the GL thread.
+class PlaneRenderer {
+ public:
+  PlaneRenderer();
+  PlaneRenderer(const PlaneRenderer& other) = delete;
+  const PlaneRenderer& operator=(const PlaneRenderer&) = delete;
+
+  // Draw the planes of a set, with blending enabled by the caller.
+  //
+  // @param plane_set: planes in the depth frame of their detection.
+  // @param device_T_depth: fixed pose of the depth camera with respect to the
+  //        device.
+  // @param projection_mat: projection of the camera.
+  // @param view_mat: camera with respect to start of service.
+  void Render(const PlaneSet& plane_set, const glm::mat4& device_T_depth,
+              const glm::mat4& projection_mat, const glm::mat4& view_mat);
+
+ private:
+  struct PlaneMesh {
+    int id;
+    unsigned int polygon_revision;
+    std::unique_ptr<tango_gl::Mesh> mesh;
+  };
+
+  // Get the mesh of a plane with its polygon up to date.
+  tango_gl::Mesh* UpdateMesh(const DetectedPlane& plane);
+
+  // Meshes of the planes of the last set.
+  std::vector<PlaneMesh> meshes_;
+  std::vector<GLfloat> vertices_;
+  std::vector<GLushort> indices_;
+};
+
+}  // namespace tango_plane_fitting
+
+#endif  // TANGO_PLANE_FITTING_PLANE_RENDERER_H_
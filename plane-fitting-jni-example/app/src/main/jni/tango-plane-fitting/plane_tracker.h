@@ -0,0 +1,120 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_PLANE_FITTING_PLANE_TRACKER_H_
+#define TANGO_PLANE_FITTING_PLANE_TRACKER_H_
+
+#include <vector>
+
+#include <tango-gl/util.h>
+
+#include "tango-plane-fitting/plane_fitting.h"
+
+namespace tango_plane_fitting {
+
+// PlaneTracker keeps the planes seen so far in start of service coordinates,
+// so they stay put while the device moves and improve as more of them is
+// seen. Each tracked plane holds the running moments of its inliers:
+//
+// 1. At the start of a frame every tracked plane is expressed in the depth
+//    frame, its inliers among the new points are merged into its moments and
+//    the plane is refit. The detector then removes those points.
+// 2. Planes the detector finds in the remaining points are merged into a
+//    tracked plane they agree with, or start a new one.
+//
+// Moments are capped to a fixed weight, so old observations fade out and
+// planes keep following drift corrections of the pose.
+//
+// Each tracked plane also grows a convex polygon around its inliers, in a
+// frame on the plane fixed when the plane is first seen. Only the inliers of
+// each new frame are added, the polygon is a summary of the earlier ones.
+class PlaneTracker {
+ public:
+  PlaneTracker();
+  PlaneTracker(const PlaneTracker& other) = delete;
+  const PlaneTracker& operator=(const PlaneTracker&) = delete;
+
+  // Forget all tracked planes, e.g. when start of service is reset.
+  void Reset();
+
+  // Start a depth frame.
+  //
+  // @param start_service_T_depth: depth camera pose at the frame timestamp.
+  void BeginFrame(const glm::mat4& start_service_T_depth);
+
+  int GetPlaneCount() const { return static_cast<int>(planes_.size()); }
+
+  // Equation of a tracked plane in the current depth frame.
+  glm::vec4 GetPlaneInDepthFrame(int index) const;
+
+  // Merge the inliers of a tracked plane found in the current depth frame.
+  //
+  // @param index: tracked plane.
+  // @param depth_inliers: moments of the inliers in the depth frame.
+  // @param depth_points: the inliers in the depth frame, to grow the polygon.
+  void AddInliers(int index, const PlaneMoments& depth_inliers,
+                  const std::vector<glm::vec3>& depth_points);
+
+  // Merge a plane detected in the current depth frame into the tracked plane
+  // it agrees with, or start tracking it.
+  //
+  // @param depth_inliers: moments of the plane inliers in the depth frame.
+  // @param depth_points: the inliers in the depth frame.
+  void AddDetection(const PlaneMoments& depth_inliers,
+                    const std::vector<glm::vec3>& depth_points);
+
+  // Write the tracked planes in the current depth frame, largest support
+  // first.
+  void EndFrame(PlaneSet* plane_set);
+
+ private:
+  struct TrackedPlane {
+    // Inlier moments and plane equation in start of service coordinates.
+    PlaneMoments moments;
+    glm::vec4 equation;
+    int last_seen_frame;
+    int id;
+    // Frame of the polygon in start of service coordinates, and the
+    // polygon in it.
+    glm::vec3 origin;
+    glm::vec3 axis_u;
+    glm::vec3 axis_v;
+    std::vector<glm::vec2> polygon;
+    unsigned int polygon_revision;
+  };
+
+  // Refit a tracked plane to its moments, keeping the normal direction.
+  //
+  // @return: false if the moments are degenerate.
+  bool Refit(TrackedPlane* plane) const;
+
+  // Grow the polygon of a tracked plane by inliers of the current frame.
+  void GrowPolygon(const std::vector<glm::vec3>& depth_points,
+                   TrackedPlane* plane);
+
+  std::vector<TrackedPlane> planes_;
+  // Inliers projected into a polygon frame.
+  std::vector<glm::vec2> projected_;
+  glm::mat4 start_service_T_depth_;
+  glm::mat4 depth_T_start_service_;
+  int next_plane_id_;
+  int frame_index_;
+};
+
+}  // namespace tango_plane_fitting
+
+#endif  // TANGO_PLANE_FITTING_PLANE_TRACKER_H_
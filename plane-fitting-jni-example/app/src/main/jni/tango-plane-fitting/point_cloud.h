@@ -17,37 +17,73 @@
 #ifndef TANGO_PLANE_FITTING_POINT_CLOUD_H_
 #define TANGO_PLANE_FITTING_POINT_CLOUD_H_
 
-#include <mutex>
-#include <utility>
 #include <vector>
 
 #include <tango_client_api.h>
+#include <tango-gl/camera_intrinsics_registry.h>
+#include <tango-gl/depth_outlier_filter.h>
+#include <tango-gl/motion_gate.h>
+#include <tango-gl/point_cloud_buffer.h>
+#include <tango-gl/point_cloud_decimator.h>
+#include <tango-gl/point_cloud_pool.h>
+#include <tango-gl/pose_history.h>
+#include <tango-gl/range_image.h>
+#include <tango-gl/range_image_mesh.h>
 #include <tango-gl/util.h>
 
+#include "tango-plane-fitting/plane_detector.h"
+#include "tango-plane-fitting/plane_inlier_counter.h"
+
 namespace tango_plane_fitting {
 
 // PointCloud contains the logic to maintain an updated, renderable depth
 // buffer.
 class PointCloud {
  public:
-  PointCloud(int32_t max_point_cloud_size);
+  // Points kept from each depth frame, the capacity needed in the pool. The
+  // voxel grid evens out the density, so near surfaces do not dominate the
+  // plane fit.
+  static const size_t kMaxPointCount = 10000;
+
+  // @param max_point_cloud_size: largest depth frame the service delivers.
+  // @param pool: storage of the decimated frames, must outlive the point
+  // cloud and have room for kMaxPointCount points per frame.
+  // @param plane_detector: receives every decimated frame, may be null.
+  PointCloud(int32_t max_point_cloud_size, tango_gl::PointCloudPool* pool,
+             PlaneDetector* plane_detector);
   ~PointCloud();
 
   // Update the point cloud data with the latest results from the
-  // callback. This is intended to be called from the callback thread.
-  void UpdateVertices(const TangoXYZij* cloud);
-
-  // Render the point cloud colored by its location relative to the
-  // world plane model.
+  // callback. This is intended to be called from the callback thread. While
+  // the device is still most frames are dropped, the renderer keeps drawing
+  // the last one and the detector keeps its planes, see tango_gl::MotionGate.
+  // Flying pixels along depth edges are removed before the frame reaches the
+  // renderer and the detector, see tango_gl::DepthOutlierFilter.
+  //
+  // @param cloud The point cloud returned by the service.
+  // @param pose_history Device poses with respect to start of service, the
+  // service is only queried if they do not cover the cloud timestamp.
+  // @param camera_intrinsics Registry to get the depth camera intrinsics
+  // from, the frame is not filtered while they are unknown.
+  void UpdateVertices(const TangoXYZij* cloud,
+                      const tango_gl::PoseHistory& pose_history,
+                      tango_gl::CameraIntrinsicsRegistry* camera_intrinsics);
+
+  // Render the point cloud as a surface colored by its location relative to
+  // the world plane model, see tango_gl::RangeImageMesh. Leaves blending
+  // and face culling disabled.
   //
   // @param projection The OpenGL projection matrix.
   // @param opengl_camera_T_start_service The pose of the OpenGL camera with
   // respect to start of service.
   // @param device_T_depth Fixed extrinsics of pose of depth camera
   // with respect to device (not time-varying).
+  // @param camera_intrinsics Registry to get the depth camera intrinsics
+  // from, nothing is drawn while they are unknown.
   void Render(const glm::mat4& projection,
               const glm::mat4& opengl_camera_T_start_service,
-              const glm::mat4& device_T_depth);
+              const glm::mat4& device_T_depth,
+              tango_gl::CameraIntrinsicsRegistry* camera_intrinsics);
 
   // Render depth points with debugging colors.
   void SetRenderDebugColors(bool on) { debug_colors_ = on; }
@@ -55,12 +91,35 @@ class PointCloud {
   // A plane equation in world coordinates for debug rendering.
   void SetPlaneEquation(const glm::vec4& plane) { plane_model_ = plane; }
 
-  // Get a reference to the current point data.
-  const TangoXYZij* GetCurrentPointData() { return &points_front_.cloud; }
+  // Classify the rendered depth frames against the plane model on the GPU.
+  void SetPlaneInlierCounting(bool on) { count_inliers_ = on; }
+
+  // Count the current depth frame against the plane model, if enabled. Call
+  // on the GL thread before the frame sets up its clear color and blend
+  // state, see PlaneInlierCounter::Count().
+  //
+  // @param device_T_depth Fixed extrinsics of pose of depth camera
+  // with respect to device (not time-varying).
+  void CountPlaneInliers(const glm::mat4& device_T_depth);
+
+  // Get the counts read back most recently, they lag one frame behind.
+  bool GetPlaneInlierCounts(PlaneInlierCounts* counts) const {
+    return inlier_counter_.GetCounts(counts);
+  }
+
+  // Get a reference to the current point data, null before the first frame.
+  const TangoXYZij* GetCurrentPointData() {
+    return front_ ? &front_->cloud : nullptr;
+  }
+  // Share the current frame, e.g. to fit a plane to it in the background.
+  // Empty before the first frame.
+  const tango_gl::PointCloudPool::Handle& GetCurrentFrame() const {
+    return front_;
+  }
   // Get a copy of the current point cloud transform of device with respect to
   // start of service.
   glm::mat4 GetCurrentTransform() {
-    return points_front_.start_service_T_device_t1;
+    return front_ ? front_->pose : glm::mat4(1.0f);
   }
 
  private:
@@ -68,12 +127,33 @@ class PointCloud {
   // Intended to be called from the render thread.
   bool UpdateRenderPoints();
 
-  GLuint shader_program_;
-  GLuint vertex_buffer_;
-  GLuint mvp_handle_;
-  GLuint vertices_handle_;
-  GLuint plane_handle_;
-  GLuint plane_distance_handle_;
+  // The plane model in the depth camera frame of the current points.
+  glm::vec4 GetDepthPlane(const glm::mat4& device_T_depth) const;
+
+  // Triangulate the current frame into mesh_ if it changed.
+  //
+  // @return false if there is no surface to draw.
+  bool UpdateMesh(tango_gl::CameraIntrinsicsRegistry* camera_intrinsics);
+
+  // Remove the outliers of a depth frame into inliers_.
+  //
+  // @return the points to decimate, the frame itself if it could not be
+  // filtered. Sets point_count to their number.
+  const float* RemoveOutliers(
+      const TangoXYZij* cloud,
+      tango_gl::CameraIntrinsicsRegistry* camera_intrinsics,
+      size_t* point_count);
+
+  // Current frame uploaded for the inlier counting pass.
+  tango_gl::PointCloudBuffer vertex_buffer_;
+  PlaneInlierCounter inlier_counter_;
+  bool count_inliers_;
+
+  // Surface of the current frame for the debug view, only used by the
+  // render thread. mesh_timestamp_ is the frame it was built from.
+  tango_gl::RangeImage mesh_range_image_;
+  tango_gl::RangeImageMesh mesh_;
+  double mesh_timestamp_;
 
   // A parameter controlling inlier distance.
   GLfloat plane_distance_;
@@ -88,24 +168,23 @@ class PointCloud {
   // This is initialized and never updated.
   glm::mat4 opengl_world_T_start_service_;
 
-  class PointData {
-   public:
-    PointData(int32_t max_size);
-    ~PointData();
+  // Reduces each depth frame to the points rendered and fitted.
+  tango_gl::PointCloudDecimator decimator_;
 
-    PointData(const PointData&) = delete;
+  // Drops the depth frames that would not change the result.
+  tango_gl::MotionGate motion_gate_;
 
-    TangoXYZij cloud;
-    glm::mat4 start_service_T_device_t1;
-  };
+  // Flying pixel removal, only used by the callback thread.
+  tango_gl::RangeImage range_image_;
+  tango_gl::DepthOutlierFilter outlier_filter_;
+  std::vector<float> inliers_;
 
-  // Constant time swap of two PointData structures.
-  void SwapPointCloudData(PointData& a, PointData& b) const;
+  // Not owned.
+  tango_gl::PointCloudPool* pool_;
+  PlaneDetector* plane_detector_;
 
-  std::mutex buffer_lock_;
-  PointData points_back_;
-  PointData points_swap_;
-  PointData points_front_;
+  // Frame rendered, its pose is the device with respect to start of service.
+  tango_gl::PointCloudPool::Handle front_;
 };
 
 }  // namespace tango_plane_fitting
@@ -0,0 +1,117 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+package com.projecttango.experiments.nativepointcloud;
+
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
+import java.nio.FloatBuffer;
+
+/**
+ * Reads the depth frames of the native point cloud in place.
+ *
+ * The native side decimates every depth frame into one of a fixed number of
+ * slots. The slots are mapped here once as direct buffers, so reading a frame
+ * copies no point data through JNI and allocates nothing:
+ *
+ * <pre>
+ *   if (export.acquireLatest()) {
+ *     FloatBuffer points = export.getPoints();  // x, y, z per point
+ *     ...
+ *     export.release();
+ *   }
+ * </pre>
+ *
+ * A frame stays pinned until released, so release it promptly: the native side
+ * drops depth frames while every slot is pinned. An instance is meant to be
+ * used from a single thread.
+ */
+public class PointCloudExport {
+  // Layout of PointCloudData::ExportInfo.
+  private static final int INFO_SEQUENCE = 0;
+  private static final int INFO_TIMESTAMP = 8;
+  private static final int INFO_POINT_COUNT = 16;
+  private static final int INFO_SIZE = 24;
+
+  private final FloatBuffer[] mSlots;
+  private final ByteBuffer mInfo =
+      ByteBuffer.allocateDirect(INFO_SIZE).order(ByteOrder.nativeOrder());
+
+  // Pinned slot, or -1.
+  private int mSlot = -1;
+  private long mSequence;
+  private double mTimestamp;
+  private int mPointCount;
+
+  public PointCloudExport() {
+    mSlots = new FloatBuffer[TangoJNINative.getPointCloudSlotCount()];
+    for (int i = 0; i < mSlots.length; ++i) {
+      mSlots[i] = TangoJNINative.getPointCloudSlotBuffer(i)
+          .order(ByteOrder.nativeOrder()).asFloatBuffer();
+    }
+  }
+
+  /**
+   * Pin the latest depth frame, releasing the previously pinned one.
+   *
+   * @return false if no depth frame was received yet.
+   */
+  public boolean acquireLatest() {
+    release();
+    int slot = TangoJNINative.acquireLatestPointCloud(mInfo);
+    if (slot < 0) {
+      return false;
+    }
+    mSlot = slot;
+    mSequence = mInfo.getLong(INFO_SEQUENCE);
+    mTimestamp = mInfo.getDouble(INFO_TIMESTAMP);
+    mPointCount = mInfo.getInt(INFO_POINT_COUNT);
+    return true;
+  }
+
+  /** Unpin the current frame, if any. */
+  public void release() {
+    if (mSlot >= 0) {
+      TangoJNINative.releasePointCloud(mSlot);
+      mSlot = -1;
+    }
+  }
+
+  /**
+   * Packed x, y, z coordinates of the pinned frame, in the depth camera frame.
+   * Only valid until the frame is released.
+   */
+  public FloatBuffer getPoints() {
+    FloatBuffer points = mSlots[mSlot];
+    points.limit(mPointCount * 3).position(0);
+    return points;
+  }
+
+  /** Publish order of the pinned frame, a newer frame has a larger value. */
+  public long getSequence() {
+    return mSequence;
+  }
+
+  /** Timestamp of the pinned frame in seconds. */
+  public double getTimestamp() {
+    return mTimestamp;
+  }
+
+  public int getPointCount() {
+    return mPointCount;
+  }
+}
@@ -33,8 +33,9 @@ import android.widget.Button;
 import android.widget.TextView;
 import android.widget.Toast;
 
-// The main activity of the application. This activity shows debug information
-// and a glSurfaceView that renders graphic content.
+// The main activity of the application. This activity shows version
+// information and a glSurfaceView that renders graphic content. The pose,
+// event and depth statistics are drawn by the native renderer.
 public class PointcloudActivity extends Activity implements OnClickListener {
   // The input argument is invalid.
   private static final int  TANGO_INVALID = -2;
@@ -51,26 +52,10 @@ public class PointcloudActivity extends Activity implements OnClickListener {
 
   // The package name of Tang Core, used for checking minimum Tango Core version.
   private static final String TANGO_PACKAGE_NAME = "com.projecttango.tango";
-  // The interval at which we'll update our UI debug text in milliseconds.
-  // This is the rate at which we query our native wrapper around the tango
-  // service for pose and event information.
-  private static final int UPDATE_INTERVAL = 100;
-
-  // Current frame's pose information.
-  private TextView mPoseData;
   // Tango Core version.
   private TextView mVersion;
   // Application version.
   private TextView mAppVersion;
-  // Latest Tango Event received.
-  private TextView mEvent;
-  // Total points count in the current depth frame.
-  private TextView mPointCount;
-  // Average depth value (in meteres) of all the points in the current frame.
-  private TextView mAverageZ;
-  // Depth frame delta time (in milliseconds) between the last depth frame and
-  // the current depth frame.
-  private TextView mFrameDeltaTime;
 
   // GLSurfaceView and renderer, all of the graphic content is rendered
   // through OpenGL ES 2.0 in native code.
@@ -99,24 +84,9 @@ public class PointcloudActivity extends Activity implements OnClickListener {
     // Setting content view of this activity.
     setContentView(R.layout.activity_pointcloud);
 
-    // Text views for displaying translation and rotation data
-    mPoseData = (TextView) findViewById(R.id.pose_data);
-
-    // Text views for displaying most recent Tango Event
-    mEvent = (TextView) findViewById(R.id.tango_event);
-
     // Text views for Tango library versions
     mVersion = (TextView) findViewById(R.id.tango_service_version);
 
-    // Text views for the available points count.
-    mPointCount = (TextView) findViewById(R.id.point_count);
-
-    // Text view for average depth distance (in meters). 
-    mAverageZ = (TextView) findViewById(R.id.average_depth);
-
-    // Text view for fram delta time between two depth frame.
-    mFrameDeltaTime = (TextView) findViewById(R.id.frame_delta);
-
     // Text views for application versions.
     mAppVersion = (TextView) findViewById(R.id.app_version);
     PackageInfo pInfo;
@@ -139,8 +109,6 @@ public class PointcloudActivity extends Activity implements OnClickListener {
     mRenderer = new Renderer();
     mGLView.setRenderer(mRenderer);
 
-    startUIThread();
-
     // Check if the Tango Core is out dated.
     if (!CheckTangoCoreVersion(MIN_TANGO_CORE_VERSION)) {
       Toast.makeText(this, "Tango Core out dated, please update in Play Store", 
@@ -238,37 +206,6 @@ public class PointcloudActivity extends Activity implements OnClickListener {
     return true;
   }
 
-  // UI thread for handling debug text changes.
-  private void startUIThread() {
-    new Thread(new Runnable() {
-      @Override
-        public void run() {
-          while (true) {
-            try {
-              Thread.sleep(UPDATE_INTERVAL);
-              runOnUiThread(new Runnable() {
-                @Override
-                public void run() {
-                  try {
-                    mEvent.setText(TangoJNINative.getEventString());
-                    mPoseData.setText(TangoJNINative.getPoseString());
-                    mPointCount.setText(String.valueOf(TangoJNINative.getVerticesCount()));
-                    mAverageZ.setText(String.format("%.3f", TangoJNINative.getAverageZ()));
-                    mFrameDeltaTime.setText(
-                        String.format("%.3f", TangoJNINative.getFrameDeltaTime()));
-                  } catch (Exception e) {
-                      e.printStackTrace();
-                  }
-                }
-              });
-            } catch (Exception e) {
-              e.printStackTrace();
-            }
-          }
-        }
-    }).start();
-  }
-
   private boolean CheckTangoCoreVersion(int minVersion) {
     int versionNumber = 0;
     String packageName = TANGO_PACKAGE_NAME;
@@ -54,30 +54,37 @@ public class TangoJNINative {
   // Setup the view port width and height.
   public static native void setupGraphic(int width, int height);
 
-  // Main render loop.
+  // Main render loop, also draws the debug HUD with the pose, event and depth
+  // frame statistics.
   public static native void render();
 
   // Set the render camera's viewing angle:
   //   first person, third person, or top down.
   public static native void setCamera(int cameraIndex);
   
-  // Get the latest pose string from our application for display in our debug UI.
-  public static native String getPoseString();
-  
-  // Get the latest event string from our application for display in our debug UI.
-  public static native String getEventString();
-  
+  // Depth frame export, use it through PointCloudExport.
+  //
+  // Number of slots frames are exported from.
+  public static native int getPointCloudSlotCount();
+
+  // Direct ByteBuffer over the packed x, y, z floats of a slot, in native byte
+  // order. The storage never moves, map each slot once.
+  public static native java.nio.ByteBuffer getPointCloudSlotBuffer(int slot);
+
+  // Pin the latest depth frame and describe it in info, a direct ByteBuffer
+  // of at least 24 bytes. Returns the slot of the frame, or -1 if there is
+  // none yet. The slot must be passed to releasePointCloud() once read.
+  public static native int acquireLatestPointCloud(java.nio.ByteBuffer info);
+
+  // Unpin a slot returned by acquireLatestPointCloud().
+  public static native void releasePointCloud(int slot);
+
+  // Measure the latency of the Tango service calls and callbacks, logged on
+  // disconnect.
+  public static native void setServiceProbe(boolean on);
+
   // Get the TangoCore version from our application for display in our debug UI.
   public static native String getVersionNumber();
-
-  // Get total point count in current depth frame.
-  public static native int getVerticesCount();
-  
-  // Get average depth (in meters) in current depth frame.
-  public static native float getAverageZ();
-  
-  // Get depth frame delta time between current frame and previous frame.
-  public static native float getFrameDeltaTime();
   
   // Pass touch events to the native layer.
   public static native void onTouchEvent(int touchCount, int event0,
@@ -20,7 +20,15 @@ PROJECT_ROOT:= $(call my-dir)/../../../../..
 include $(CLEAR_VARS)
 LOCAL_MODULE    := libpoint_cloud_jni_example
 LOCAL_SHARED_LIBRARIES := tango_client_api
+LOCAL_STATIC_LIBRARIES := cpufeatures libfreetype
 LOCAL_CFLAGS    := -std=c++11
+# Uncomment to record a Chrome trace, written to the sdcard on disconnect.
+# LOCAL_CFLAGS    += -DTANGO_GL_TRACING
+# Per frame matrix math on NEON, part of the arm64-v8a baseline. armeabi-v7a
+# keeps the scalar glm path, see tango-gl/simd_math.h.
+ifeq ($(TARGET_ARCH_ABI),arm64-v8a)
+LOCAL_CFLAGS    += -DTANGO_GL_SIMD_MATH
+endif
 
 LOCAL_C_INCLUDES := $(PROJECT_ROOT)/tango-service-sdk/include/ \
                     $(PROJECT_ROOT)/tango-gl/include \
@@ -34,20 +42,74 @@ LOCAL_SRC_FILES := jni_interface.cc \
                    scene.cc \
                    tango_event_data.cc \
                    $(PROJECT_ROOT_FROM_JNI)/tango-gl/axis.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/bounding_box.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/bvh.cpp \
                    $(PROJECT_ROOT_FROM_JNI)/tango-gl/camera.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/camera_intrinsics_registry.cpp \
                    $(PROJECT_ROOT_FROM_JNI)/tango-gl/conversions.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/counters.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/depth_statistics.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/device_extrinsics.cpp \
                    $(PROJECT_ROOT_FROM_JNI)/tango-gl/drawable_object.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/dynamic_resolution_target.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/frame_arena.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/frame_cache.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/frame_constants.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/geometry_registry.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/memory_tracker.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/occlusion_culler.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/program_cache.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/render_state.cpp \
                    $(PROJECT_ROOT_FROM_JNI)/tango-gl/frustum.cpp \
                    $(PROJECT_ROOT_FROM_JNI)/tango-gl/gesture_camera.cpp \
                    $(PROJECT_ROOT_FROM_JNI)/tango-gl/grid.cpp \
                    $(PROJECT_ROOT_FROM_JNI)/tango-gl/line.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/motion_gate.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/pipeline_stage.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/point_cloud_decimator.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/point_cloud_pool.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/point_colorizer.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/point_projection.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/pose_history.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/ray_table.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/rigid_transform.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/scene_graph.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/service_probe.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/shader_variants.cpp \
                    $(PROJECT_ROOT_FROM_JNI)/tango-gl/shaders.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/text_overlay.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/thread_policy.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/touch_queue.cpp \
                    $(PROJECT_ROOT_FROM_JNI)/tango-gl/trace.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/trajectory_store.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/tracing.cpp \
                    $(PROJECT_ROOT_FROM_JNI)/tango-gl/transform.cpp \
-                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/util.cpp
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/util.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/vertex_array.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/vertex_buffer.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/view_frustum.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/worker_pool.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/yuv_converter.cpp
 
-LOCAL_LDLIBS    := -llog -lGLESv2 -L$(SYSROOT)/usr/lib
+# The NEON kernel is built with NEON enabled and selected at runtime, so the
+# library still runs on armeabi-v7a devices without NEON. arm64-v8a always
+# has NEON and needs no .neon suffix.
+TANGO_GL_NEON_SOURCES := $(PROJECT_ROOT_FROM_JNI)/tango-gl/depth_statistics_neon.cpp \
+                         $(PROJECT_ROOT_FROM_JNI)/tango-gl/point_projection_neon.cpp \
+                         $(PROJECT_ROOT_FROM_JNI)/tango-gl/yuv_converter_neon.cpp
+ifeq ($(TARGET_ARCH_ABI),armeabi-v7a)
+LOCAL_CFLAGS    += -DTANGO_GL_HAS_NEON
+LOCAL_SRC_FILES += $(addsuffix .neon,$(TANGO_GL_NEON_SOURCES))
+endif
+ifeq ($(TARGET_ARCH_ABI),arm64-v8a)
+LOCAL_CFLAGS    += -DTANGO_GL_HAS_NEON
+LOCAL_SRC_FILES += $(TANGO_GL_NEON_SOURCES)
+endif
+
+LOCAL_LDLIBS    := -llog -lGLESv2 -lEGL -L$(SYSROOT)/usr/lib
 include $(BUILD_SHARED_LIBRARY)
 
 $(call import-add-path, $(PROJECT_ROOT))
 $(call import-module,tango_client_api)
+$(call import-module,android/cpufeatures)
+$(call import-module,third-party/libfreetype)
@@ -17,122 +17,139 @@
 #define GLM_FORCE_RADIANS
 
 #include <jni.h>
+#include <tango-gl/jni_natives.h>
 #include <tango-point-cloud/point_cloud_app.h>
 #include <tango-point-cloud/scene.h>
 
-static tango_point_cloud::PointCloudApp app;
+namespace {
+tango_point_cloud::PointCloudApp app;
 
-#ifdef __cplusplus
-extern "C" {
-#endif
-JNIEXPORT jint JNICALL
-Java_com_projecttango_experiments_nativepointcloud_TangoJNINative_initialize(
-    JNIEnv* env, jobject, jobject activity) {
+jint Initialize(JNIEnv* env, jobject, jobject activity) {
   return app.TangoInitialize(env, activity);
 }
 
-JNIEXPORT jint JNICALL
-Java_com_projecttango_experiments_nativepointcloud_TangoJNINative_setupConfig(
-    JNIEnv*, jobject, bool is_auto_reset) {
+jint SetupConfig(JNIEnv*, jobject, bool is_auto_reset) {
   return app.TangoSetupConfig(is_auto_reset);
 }
 
-JNIEXPORT jint JNICALL
-Java_com_projecttango_experiments_nativepointcloud_TangoJNINative_connect(
-    JNIEnv*, jobject) {
+jint Connect(JNIEnv*, jobject) {
   return app.TangoConnect();
 }
 
-JNIEXPORT jint JNICALL
-Java_com_projecttango_experiments_nativepointcloud_TangoJNINative_connectCallbacks(
-    JNIEnv*, jobject) {
+jint ConnectCallbacks(JNIEnv*, jobject) {
   return app.TangoConnectCallbacks();
 }
 
-JNIEXPORT void JNICALL
-Java_com_projecttango_experiments_nativepointcloud_TangoJNINative_disconnect(
-    JNIEnv*, jobject) {
+void Disconnect(JNIEnv*, jobject) {
   app.TangoDisconnect();
 }
 
-JNIEXPORT void JNICALL
-Java_com_projecttango_experiments_nativepointcloud_TangoJNINative_initGlContent(
-    JNIEnv*, jobject) {
+void InitGlContent(JNIEnv*, jobject) {
   app.InitializeGLContent();
 }
 
-JNIEXPORT void JNICALL
-Java_com_projecttango_experiments_nativepointcloud_TangoJNINative_setupGraphic(
-    JNIEnv*, jobject, jint width, jint height) {
+void SetupGraphic(JNIEnv*, jobject, jint width, jint height) {
   app.SetViewPort(width, height);
 }
 
-JNIEXPORT void JNICALL
-Java_com_projecttango_experiments_nativepointcloud_TangoJNINative_render(
-    JNIEnv*, jobject) {
+void Render(JNIEnv*, jobject) {
   app.Render();
 }
 
-JNIEXPORT void JNICALL
-Java_com_projecttango_experiments_nativepointcloud_TangoJNINative_freeGLContent(
-    JNIEnv*, jobject) {
+void FreeGLContent(JNIEnv*, jobject) {
   app.FreeGLContent();
 }
 
-JNIEXPORT jstring JNICALL
-Java_com_projecttango_experiments_nativepointcloud_TangoJNINative_getPoseString(
-    JNIEnv* env, jobject) {
-  return (env)->NewStringUTF(app.GetPoseString().c_str());
-}
-
-JNIEXPORT jstring JNICALL
-Java_com_projecttango_experiments_nativepointcloud_TangoJNINative_getEventString(
-    JNIEnv* env, jobject) {
-  return (env)->NewStringUTF(app.GetEventString().c_str());
+jstring GetVersionNumber(JNIEnv* env, jobject) {
+  return (env)->NewStringUTF(app.GetVersionString().c_str());
 }
 
-JNIEXPORT jstring JNICALL
-Java_com_projecttango_experiments_nativepointcloud_TangoJNINative_getVersionNumber(
-    JNIEnv* env, jobject) {
-  return (env)->NewStringUTF(app.GetVersionString().c_str());
+jint GetPointCloudSlotCount(JNIEnv*, jobject) {
+  return app.GetPointCloudSlotCount();
 }
 
-JNIEXPORT jint JNICALL
-Java_com_projecttango_experiments_nativepointcloud_TangoJNINative_getVerticesCount(
-    JNIEnv*, jobject) {
-  return app.GetPointCloudVerticesCount();
+jobject GetPointCloudSlotBuffer(JNIEnv* env, jobject, jint slot) {
+  if (slot < 0 || slot >= app.GetPointCloudSlotCount()) {
+    return nullptr;
+  }
+  return (env)->NewDirectByteBuffer(
+      app.GetPointCloudSlotData(slot),
+      app.GetPointCloudSlotCapacity() * 3 * sizeof(float));
 }
 
-JNIEXPORT jfloat JNICALL
-Java_com_projecttango_experiments_nativepointcloud_TangoJNINative_getAverageZ(
-    JNIEnv*, jobject) {
-  return app.GetAverageZ();
+jint AcquireLatestPointCloud(JNIEnv* env, jobject, jobject info_buffer) {
+  using tango_point_cloud::PointCloudData;
+  void* info = (env)->GetDirectBufferAddress(info_buffer);
+  if (info == nullptr ||
+      (env)->GetDirectBufferCapacity(info_buffer) <
+          static_cast<jlong>(sizeof(PointCloudData::ExportInfo))) {
+    return -1;
+  }
+  return app.AcquireLatestPointCloud(
+      static_cast<PointCloudData::ExportInfo*>(info));
 }
 
-JNIEXPORT jfloat JNICALL
-Java_com_projecttango_experiments_nativepointcloud_TangoJNINative_getFrameDeltaTime(
-    JNIEnv*, jobject) {
-  return app.GetDepthFrameDeltaTime();
+void ReleasePointCloud(JNIEnv*, jobject, jint slot) {
+  app.ReleasePointCloud(slot);
 }
 
-JNIEXPORT void JNICALL
-Java_com_projecttango_experiments_nativepointcloud_TangoJNINative_setCamera(
-    JNIEnv*, jobject, int camera_index) {
+void SetCamera(JNIEnv*, jobject, int camera_index) {
   using namespace tango_gl;
   GestureCamera::CameraType cam_type =
       static_cast<GestureCamera::CameraType>(camera_index);
   app.SetCameraType(cam_type);
 }
 
-JNIEXPORT void JNICALL
-Java_com_projecttango_experiments_nativepointcloud_TangoJNINative_onTouchEvent(
-    JNIEnv*, jobject, int touch_count, int event, float x0, float y0, float x1,
-    float y1) {
+void SetServiceProbe(JNIEnv*, jobject, jboolean on) {
+  app.SetServiceProbe(on);
+}
+
+void OnTouchEvent(JNIEnv*, jobject, int touch_count, int event, float x0,
+                  float y0, float x1, float y1) {
   using namespace tango_gl;
   GestureCamera::TouchEvent touch_event =
       static_cast<GestureCamera::TouchEvent>(event);
   app.OnTouchEvent(touch_count, touch_event, x0, y0, x1, y1);
 }
+
+// onTouchEvent() only queues the touch for the next frame, so it is a fast
+// native call. render() runs for milliseconds and stays a regular call, see
+// tango_gl::jni::RegisterNatives().
+const JNINativeMethod kNativeMethods[] = {
+    {"initialize",
+     "(Lcom/projecttango/experiments/nativepointcloud/PointcloudActivity;)I",
+     reinterpret_cast<void*>(Initialize)},
+    {"setupConfig", "(Z)I", reinterpret_cast<void*>(SetupConfig)},
+    {"connect", "()I", reinterpret_cast<void*>(Connect)},
+    {"connectCallbacks", "()I", reinterpret_cast<void*>(ConnectCallbacks)},
+    {"disconnect", "()V", reinterpret_cast<void*>(Disconnect)},
+    {"initGlContent", "()V", reinterpret_cast<void*>(InitGlContent)},
+    {"setupGraphic", "(II)V", reinterpret_cast<void*>(SetupGraphic)},
+    {"render", "()V", reinterpret_cast<void*>(Render)},
+    {"freeGLContent", "()V", reinterpret_cast<void*>(FreeGLContent)},
+    {"getVersionNumber", "()Ljava/lang/String;",
+     reinterpret_cast<void*>(GetVersionNumber)},
+    {"getPointCloudSlotCount", "()I",
+     reinterpret_cast<void*>(GetPointCloudSlotCount)},
+    {"getPointCloudSlotBuffer", "(I)Ljava/nio/ByteBuffer;",
+     reinterpret_cast<void*>(GetPointCloudSlotBuffer)},
+    {"acquireLatestPointCloud", "(Ljava/nio/ByteBuffer;)I",
+     reinterpret_cast<void*>(AcquireLatestPointCloud)},
+    {"releasePointCloud", "(I)V", reinterpret_cast<void*>(ReleasePointCloud)},
+    {"setCamera", "(I)V", reinterpret_cast<void*>(SetCamera)},
+    {"setServiceProbe", "(Z)V", reinterpret_cast<void*>(SetServiceProbe)},
+    {"onTouchEvent", "!(IIFFFF)V", reinterpret_cast<void*>(OnTouchEvent)},
+};
+}  // namespace
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+jint JNI_OnLoad(JavaVM* vm, void*) {
+  return tango_gl::jni::RegisterNatives(
+      vm, "com/projecttango/experiments/nativepointcloud/TangoJNINative",
+      kNativeMethods);
+}
 #ifdef __cplusplus
 }
 #endif
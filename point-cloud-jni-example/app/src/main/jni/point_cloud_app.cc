@@ -14,13 +14,56 @@
  * limitations under the License.
  */
 
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+
 #include <tango-gl/conversions.h>
+#include <tango-gl/program_cache.h>
+#include <tango-gl/render_state.h>
+#include <tango-gl/service_probe.h>
+#include <tango-gl/thread_policy.h>
+#include <tango-gl/tracing.h>
 
 #include "tango-point-cloud/point_cloud_app.h"
 
 namespace {
 const int kVersionStringLength = 128;
 
+// Where TangoDisconnect() writes the trace when built with TANGO_GL_TRACING.
+const char kTracePath[] = "/sdcard/point_cloud_trace.json";
+
+// Debug HUD layout, in pixels.
+const int kHudTextSize = 24;
+const float kHudTextMargin = 8.0f;
+const int kHudLineCount = 8;
+
+// How often the HUD text is formatted, the rate the Java views used to poll
+// the statistics at.
+const std::chrono::milliseconds kHudUpdateInterval(100);
+
+// Largest depth frame copied out of the XYZij callback, the point count of a
+// full depth camera frame. Larger frames are truncated.
+const size_t kMaxDepthPointCount = 320 * 180;
+
+// Depth frames queued for the depth stage, the stage keeps only the latest
+// ones when it falls behind.
+const size_t kDepthStageCapacity = 1;
+
+// Raw depth frames in flight: every frame the depth stage keeps queued, the
+// one it processes and the one the callback copies into, so the callback
+// always gets a frame and a slow stage drops the oldest ones instead.
+const size_t kDepthFrameBudget =
+    (tango_gl::PipelineStage<tango_gl::PointCloudPool::Handle>::GetQueuedCount(
+         kDepthStageCapacity) +
+     2) *
+    kMaxDepthPointCount * 3 * sizeof(float);
+
+// Core the depth stage runs on, -1 leaves the choice to the scheduler. Pin it
+// away from the GL and callback threads on devices with a known topology.
+const int kDepthStageCpu = -1;
+
 // This function routes onXYZijAvailable callbacks to the application object for
 // handling.
 //
@@ -33,6 +76,19 @@ void onPointCloudAvailableRouter(void* context, const TangoXYZij* xyz_ij) {
   app->onPointCloudAvailable(xyz_ij);
 }
 
+// This function routes OnFrameAvailable callbacks to the application object
+// for handling.
+//
+// @param context, context will be a pointer to a PointCloudApp
+//        instance on which to call callbacks.
+// @param buffer, color camera frame to route to OnFrameAvailable function.
+void OnFrameAvailableRouter(void* context, TangoCameraId,
+                            const TangoImageBuffer* buffer) {
+  using namespace tango_point_cloud;
+  PointCloudApp* app = static_cast<PointCloudApp*>(context);
+  app->OnFrameAvailable(buffer);
+}
+
 // This function routes onPoseAvailable callbacks to the application object for
 // handling.
 //
@@ -60,21 +116,98 @@ void onTangoEventAvailableRouter(void* context, const TangoEvent* event) {
 
 namespace tango_point_cloud {
 void PointCloudApp::onPointCloudAvailable(const TangoXYZij* xyz_ij) {
-  std::lock_guard<std::mutex> lock(point_cloud_mutex_);
-  point_cloud_data_.UpdatePointCloud(xyz_ij);
+  TANGO_GL_TRACE_THREAD_NAME("onPointCloudAvailable");
+  tango_gl::thread_policy::EnterRole(tango_gl::thread_policy::kDepth);
+  TANGO_GL_TRACE_SCOPE("onPointCloudAvailable");
+  tango_gl::ServiceProbe::RecordCallback(tango_gl::ServiceProbe::kXyzIjCallback,
+                                         xyz_ij->timestamp);
+  // Only copy the points here, decimating and coloring them runs on
+  // depth_stage_ so the callback returns quickly.
+  tango_gl::PointCloudPool::Handle frame = depth_frames_.Allocate();
+  if (!frame) {
+    LOGE("PointCloudApp: Every depth frame is in use, dropping a frame");
+    return;
+  }
+  const uint32_t point_count = std::min<uint32_t>(
+      xyz_ij->xyz_count, static_cast<uint32_t>(depth_frames_.GetCapacity()));
+  memcpy(frame->cloud.xyz[0], xyz_ij->xyz[0],
+         point_count * 3 * sizeof(float));
+  frame->cloud.xyz_count = point_count;
+  frame->cloud.timestamp = xyz_ij->timestamp;
+  depth_stage_.Submit(frame);
+}
+
+void PointCloudApp::ProcessDepthFrame(tango_gl::PointCloudPool::Handle* frame) {
+  if (!motion_gate_.ShouldProcess(pose_history_, (*frame)->cloud.timestamp)) {
+    return;
+  }
+  point_cloud_data_.UpdatePointCloud(&(*frame)->cloud);
+  UpdatePointCloudColors();
+
+  // The points are copied into the write slot, whose storage is reused
+  // between frames, so the render thread never copies them.
+  RenderCloud* cloud = render_clouds_.GetWriteBuffer();
+  cloud->timestamp = point_cloud_data_.GetCurrentTimstamp();
+  cloud->points = point_cloud_data_.GetColoredPoints();
+  render_clouds_.Publish();
+}
+
+void PointCloudApp::OnFrameAvailable(const TangoImageBuffer* buffer) {
+  TANGO_GL_TRACE_THREAD_NAME("OnFrameAvailable");
+  tango_gl::thread_policy::EnterRole(tango_gl::thread_policy::kCamera);
+  TANGO_GL_TRACE_SCOPE("OnFrameAvailable");
+  tango_gl::ServiceProbe::RecordCallback(tango_gl::ServiceProbe::kFrameCallback,
+                                         buffer->timestamp);
+  if (buffer->format != TANGO_HAL_PIXEL_FORMAT_YCrCb_420_SP) {
+    LOGE("PointCloudApp: color frame format is not supported by this app");
+    return;
+  }
+
+  // The write slot is owned by this thread until it is published, so it can be
+  // filled without holding a lock. Rows are copied without their stride
+  // padding, the way the colorizer expects the NV21 planes.
+  ColorFrame* frame = color_frames_.GetWriteBuffer();
+  const size_t width = buffer->width;
+  const size_t height = buffer->height;
+  const size_t stride = buffer->stride;
+  const size_t row_count = height + height / 2;
+  frame->nv21.resize(width * row_count);
+  for (size_t row = 0; row < row_count; ++row) {
+    memcpy(frame->nv21.data() + row * width, buffer->data + row * stride,
+           width);
+  }
+  frame->timestamp = buffer->timestamp;
+  color_frames_.Publish();
 }
 
 void PointCloudApp::onPoseAvailable(const TangoPoseData* pose) {
-  std::lock_guard<std::mutex> lock(pose_mutex_);
+  TANGO_GL_TRACE_THREAD_NAME("onPoseAvailable");
+  tango_gl::thread_policy::EnterRole(tango_gl::thread_policy::kPose);
+  TANGO_GL_TRACE_SCOPE("onPoseAvailable");
+  tango_gl::ServiceProbe::RecordCallback(tango_gl::ServiceProbe::kPoseCallback,
+                                         pose->timestamp);
   pose_data_.UpdatePose(pose);
+  if (pose->status_code == TANGO_POSE_VALID) {
+    pose_history_.Add(pose->timestamp, pose->translation, pose->orientation);
+  } else {
+    // Poses after a tracking loss do not continue the earlier ones.
+    pose_history_.Clear();
+  }
 }
 
 void PointCloudApp::onTangoEventAvailable(const TangoEvent* event) {
-  std::lock_guard<std::mutex> lock(tango_event_mutex_);
   tango_event_data_.UpdateTangoEvent(event);
 }
 
-PointCloudApp::PointCloudApp() {}
+PointCloudApp::PointCloudApp()
+    : color_camera_intrinsics_(),
+      depth_frames_(kMaxDepthPointCount, kDepthFrameBudget),
+      depth_stage_("DepthStage", kDepthStageCapacity, kDepthStageCpu,
+                   [this](tango_gl::PointCloudPool::Handle* frame) {
+                     ProcessDepthFrame(frame);
+                   }),
+      screen_width_(0),
+      screen_height_(0) {}
 
 PointCloudApp::~PointCloudApp() {
   if (tango_config_ != nullptr) {
@@ -83,6 +216,9 @@ PointCloudApp::~PointCloudApp() {
 }
 
 int PointCloudApp::TangoInitialize(JNIEnv* env, jobject caller_activity) {
+  // Linked shader programs are persisted in the app cache directory.
+  tango_gl::program_cache::SetBinaryCacheDirectory(env, caller_activity);
+
   // The first thing we need to do for any Tango enabled application is to
   // initialize the service. We'll do that here, passing on the JNI environment
   // and jobject corresponding to the Android activity that is calling us.
@@ -118,6 +254,16 @@ int PointCloudApp::TangoSetupConfig(bool is_atuo_recovery) {
     return ret;
   }
 
+  // Enable the color camera, its frames color the depth points.
+  ret = TangoConfig_setBool(tango_config_, "config_enable_color_camera", true);
+  if (ret != TANGO_SUCCESS) {
+    LOGE(
+        "PointCloudApp: config_enable_color_camera() failed with error"
+        "code: %d",
+        ret);
+    return ret;
+  }
+
   // Get TangoCore version string from service.
   char tango_core_version[kVersionStringLength];
   ret = TangoConfig_getString(
@@ -147,6 +293,15 @@ int PointCloudApp::TangoConnectCallbacks() {
     return ret;
   }
 
+  // Attach the OnFrameAvailable callback for the color camera.
+  ret = TangoService_connectOnFrameAvailable(TANGO_CAMERA_COLOR, this,
+                                             OnFrameAvailableRouter);
+  if (ret != TANGO_SUCCESS) {
+    LOGE("PointCloudApp: Failed to connect to color frame callback with error"
+         "code: %d", ret);
+    return ret;
+  }
+
   // Setting up the frame pair for the onPoseAvailable callback.
   TangoCoordinateFramePair pairs;
   pairs.base = TANGO_COORDINATE_FRAME_START_OF_SERVICE;
@@ -187,6 +342,28 @@ int PointCloudApp::TangoConnect() {
          ret);
     return ret;
   }
+
+  // Intrinsics may change between connections, so the cached ones are
+  // dropped.
+  camera_intrinsics_.Clear();
+  TangoCameraIntrinsics color_camera_intrinsics;
+  ret = camera_intrinsics_.GetIntrinsics(TANGO_CAMERA_COLOR,
+                                         &color_camera_intrinsics);
+  if (ret != TANGO_SUCCESS) {
+    LOGE("PointCloudApp: Failed to get the color camera intrinsics with error"
+         "code: %d", ret);
+    return ret;
+  }
+  color_camera_intrinsics_.width = color_camera_intrinsics.width;
+  color_camera_intrinsics_.height = color_camera_intrinsics.height;
+  color_camera_intrinsics_.fx = color_camera_intrinsics.fx;
+  color_camera_intrinsics_.fy = color_camera_intrinsics.fy;
+  color_camera_intrinsics_.cx = color_camera_intrinsics.cx;
+  color_camera_intrinsics_.cy = color_camera_intrinsics.cy;
+
+  // Started last, so the worker sees the extrinsics and intrinsics written
+  // above without a lock. Frames arriving meanwhile wait in its queue.
+  depth_stage_.Start();
   return ret;
 }
 
@@ -199,6 +376,19 @@ void PointCloudApp::TangoDisconnect() {
   TangoConfig_free(tango_config_);
   tango_config_ = nullptr;
   TangoService_disconnect();
+  depth_stage_.Stop();
+  TANGO_GL_TRACE_DUMP(kTracePath);
+  if (tango_gl::ServiceProbe::IsEnabled()) {
+    LOGI("PointCloudApp: service probe\n%s",
+         tango_gl::ServiceProbe::GetReport().c_str());
+  }
+}
+
+void PointCloudApp::SetServiceProbe(bool on) {
+  if (on && !tango_gl::ServiceProbe::IsEnabled()) {
+    tango_gl::ServiceProbe::Reset();
+  }
+  tango_gl::ServiceProbe::SetEnabled(on);
 }
 
 void PointCloudApp::TangoResetMotionTracking() {
@@ -206,34 +396,44 @@ void PointCloudApp::TangoResetMotionTracking() {
 }
 
 void PointCloudApp::InitializeGLContent() {
+  // Anything RenderState remembers belongs to the previous GL context.
+  tango_gl::RenderState::Invalidate();
+  hud_.Invalidate();
+  if (!hud_.Initialize(tango_gl::TextOverlay::kDefaultFontPath,
+                       kHudTextSize)) {
+    LOGE("PointCloudApp: Debug HUD is not available.");
+  }
+
   main_scene_.InitGLContent();
 }
 
 void PointCloudApp::SetViewPort(int width, int height) {
+  screen_width_ = width;
+  screen_height_ = height;
   main_scene_.SetupViewPort(width, height);
 }
 
 void PointCloudApp::Render() {
+  TANGO_GL_TRACE_THREAD_NAME("GLThread");
+  tango_gl::thread_policy::EnterRole(tango_gl::thread_policy::kRender);
+  TANGO_GL_TRACE_SCOPE("Render");
+  tango_gl::RenderState::BeginFrame();
+  touch_queue_.Drain([this](const tango_gl::TouchQueue::Touch& touch) {
+    main_scene_.OnTouchEvent(touch.touch_count, touch.event, touch.x0,
+                             touch.y0, touch.x1, touch.y1);
+  });
+
   // Query the latest pose transformation and point cloud frame transformation.
   // Point cloud data comes in with a specific timestamp, in order to get the
   // closest pose for the point cloud, we will need to use the
   // TangoService_getPoseAtTime() to query pose at timestamp.
-  glm::mat4 cur_pose_transformation;
+  glm::mat4 cur_pose_transformation = pose_data_.GetLatestPoseMatrix();
   glm::mat4 point_cloud_transformation;
-  {
-    std::lock_guard<std::mutex> lock(pose_mutex_);
-    cur_pose_transformation = pose_data_.GetLatestPoseMatrix();
-  }
 
-  double point_cloud_timestamp;
-  // We make another copy for rendering and depth computation.
-  std::vector<float> vertices_cpy;
-  {
-    std::lock_guard<std::mutex> lock(point_cloud_mutex_);
-    point_cloud_timestamp = point_cloud_data_.GetCurrentTimstamp();
-    std::vector<float> vertices = point_cloud_data_.GetVerticeVector();
-    vertices_cpy = std::vector<float>(vertices);
-  }
+  // The read slot keeps the previous frame when no new one arrived.
+  render_clouds_.Acquire();
+  const RenderCloud* cloud = render_clouds_.GetReadBuffer();
+  const double point_cloud_timestamp = cloud->timestamp;
 
   // Get the latest pose transformation in opengl frame and apply extrinsics to
   // it.
@@ -247,37 +447,65 @@ void PointCloudApp::Render() {
   point_cloud_transformation = pose_data_.GetExtrinsicsAppliedOpenGLWorldFrame(
       point_cloud_transformation);
 
+  main_scene_.Render(cur_pose_transformation, point_cloud_transformation,
+                     point_cloud_timestamp, cloud->points);
+  RenderHud();
+}
 
-  // Compute the average depth value.
-  float average_depth_ = 0.0f;
-  size_t iteration_size = vertices_cpy.size();
-  size_t vertices_count = 0;
-  for (size_t i = 2; i < iteration_size; i += 3) {
-    average_depth_ += vertices_cpy[i];
-    vertices_count++;
-  }
-  if (vertices_count) {
-    average_depth_ /= vertices_count;
-  }
-
-  {
-    std::lock_guard<std::mutex> lock(point_cloud_mutex_);
-    point_cloud_data_.SetAverageDepth(average_depth_);
+void PointCloudApp::RenderHud() {
+  TANGO_GL_TRACE_SCOPE("RenderHud");
+  std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+  if (hud_text_.empty() || now - hud_update_time_ >= kHudUpdateInterval) {
+    const tango_gl::PipelineStageStatistics stage_statistics =
+        depth_stage_.GetStatistics();
+    char depth_statistics[192];
+    snprintf(depth_statistics, sizeof(depth_statistics),
+             "Average depth (m): %.3f\nPoint count: %d\n"
+             "Frame delta time (ms): %.3f\n"
+             "Depth stage latency (ms): %.3f, dropped: %llu",
+             GetAverageZ(), GetPointCloudVerticesCount(),
+             GetDepthFrameDeltaTime(), stage_statistics.latency_ms,
+             static_cast<unsigned long long>(stage_statistics.dropped_count));
+    // CPU time of each role since its threads entered it, to see where the
+    // thread policies put the load.
+    std::string cpu_statistics = "CPU (s):";
+    for (int role = 0; role < tango_gl::thread_policy::kRoleCount; ++role) {
+      const tango_gl::thread_policy::Statistics role_statistics =
+          tango_gl::thread_policy::GetStatistics(
+              static_cast<tango_gl::thread_policy::Role>(role));
+      if (role_statistics.thread_count == 0) {
+        continue;
+      }
+      char role_cpu[48];
+      snprintf(role_cpu, sizeof(role_cpu), " %s %.1f",
+               tango_gl::thread_policy::GetRoleName(
+                   static_cast<tango_gl::thread_policy::Role>(role)),
+               role_statistics.cpu_time_ms / 1000.0);
+      cpu_statistics += role_cpu;
+    }
+    hud_text_ = "Tango event: " + GetEventString() +
+                "\nDevice w.r.t. start of service:\n  " + GetPoseString() +
+                "\n" + depth_statistics + "\n" + cpu_statistics;
+    hud_update_time_ = now;
   }
-
-  main_scene_.Render(cur_pose_transformation, point_cloud_transformation,
-                     vertices_cpy);
+  // Anchored to the bottom left, clear of the version views and the camera
+  // buttons.
+  const float hud_height = kHudLineCount * hud_.GetLineHeight();
+  hud_.AddText(hud_text_, kHudTextMargin,
+               screen_height_ - kHudTextMargin - hud_height);
+  hud_.Draw(screen_width_, screen_height_);
 }
 
-void PointCloudApp::FreeGLContent() { main_scene_.FreeGLContent(); }
+void PointCloudApp::FreeGLContent() {
+  hud_.Release();
+  main_scene_.FreeGLContent();
+}
 
 std::string PointCloudApp::GetPoseString() {
-  std::lock_guard<std::mutex> lock(pose_mutex_);
   return pose_data_.GetPoseDebugString();
 }
 
 std::string PointCloudApp::GetEventString() {
-  std::lock_guard<std::mutex> lock(tango_event_mutex_);
   return tango_event_data_.GetTangoEventString().c_str();
 }
 
@@ -285,21 +513,42 @@ std::string PointCloudApp::GetVersionString() {
   return tango_core_version_string_.c_str();
 }
 
+// The statistics are published lock-free by the depth callback, so the JNI
+// getters never wait on the depth stage.
 int PointCloudApp::GetPointCloudVerticesCount() {
-  std::lock_guard<std::mutex> lock(point_cloud_mutex_);
   return point_cloud_data_.GetPointCloudVerticesCount();
 }
 
 float PointCloudApp::GetAverageZ() {
-  std::lock_guard<std::mutex> lock(point_cloud_mutex_);
   return point_cloud_data_.GetAverageDepth();
 }
 
 float PointCloudApp::GetDepthFrameDeltaTime() {
-  std::lock_guard<std::mutex> lock(point_cloud_mutex_);
   return point_cloud_data_.GetDepthFrameDeltaTime();
 }
 
+// The export calls go straight to the lock-free pool of point_cloud_data_.
+int PointCloudApp::GetPointCloudSlotCount() {
+  return point_cloud_data_.GetExportSlotCount();
+}
+
+size_t PointCloudApp::GetPointCloudSlotCapacity() {
+  return point_cloud_data_.GetExportSlotCapacity();
+}
+
+float* PointCloudApp::GetPointCloudSlotData(int slot) {
+  return point_cloud_data_.GetExportSlotData(slot);
+}
+
+int PointCloudApp::AcquireLatestPointCloud(
+    PointCloudData::ExportInfo* info) {
+  return point_cloud_data_.AcquireLatestExport(info);
+}
+
+void PointCloudApp::ReleasePointCloud(int slot) {
+  point_cloud_data_.ReleaseExport(slot);
+}
+
 void PointCloudApp::SetCameraType(
     tango_gl::GestureCamera::CameraType camera_type) {
   main_scene_.SetCameraType(camera_type);
@@ -308,7 +557,7 @@ void PointCloudApp::SetCameraType(
 void PointCloudApp::OnTouchEvent(int touch_count,
                                       tango_gl::GestureCamera::TouchEvent event,
                                       float x0, float y0, float x1, float y1) {
-  main_scene_.OnTouchEvent(touch_count, event, x0, y0, x1, y1);
+  touch_queue_.Push(touch_count, event, x0, y0, x1, y1);
 }
 
 glm::mat4 PointCloudApp::GetPoseMatrixAtTimestamp(double timstamp) {
@@ -316,8 +565,13 @@ glm::mat4 PointCloudApp::GetPoseMatrixAtTimestamp(double timstamp) {
   TangoCoordinateFramePair frame_pair;
   frame_pair.base = TANGO_COORDINATE_FRAME_START_OF_SERVICE;
   frame_pair.target = TANGO_COORDINATE_FRAME_DEVICE;
-  TangoErrorType status = TangoService_getPoseAtTime(
-      timstamp, frame_pair, &pose_start_service_T_device);
+  TangoErrorType status;
+  {
+    tango_gl::ServiceProbe::ScopedCall probe(
+        tango_gl::ServiceProbe::kGetPoseAtTime);
+    status = TangoService_getPoseAtTime(timstamp, frame_pair,
+                                        &pose_start_service_T_device);
+  }
   if (status != TANGO_SUCCESS) {
     LOGE(
         "PoseData: Failed to get transform between the Start of service and "
@@ -330,38 +584,61 @@ glm::mat4 PointCloudApp::GetPoseMatrixAtTimestamp(double timstamp) {
   return pose_data_.GetMatrixFromPose(pose_start_service_T_device);
 }
 
-TangoErrorType PointCloudApp::UpdateExtrinsics() {
-  TangoErrorType ret;
-  TangoPoseData pose_data;
-  TangoCoordinateFramePair frame_pair;
+void PointCloudApp::UpdatePointCloudColors() {
+  TANGO_GL_TRACE_SCOPE("UpdatePointCloudColors");
+  // The read slot keeps the previous frame when no new one arrived.
+  color_frames_.Acquire();
+  const ColorFrame* frame = color_frames_.GetReadBuffer();
+  const tango_gl::projection::CameraIntrinsics& intrinsics =
+      color_camera_intrinsics_;
+  const size_t frame_size = static_cast<size_t>(intrinsics.width) *
+                            static_cast<size_t>(intrinsics.height) * 3 / 2;
+  if (frame_size == 0 || frame->nv21.size() != frame_size) {
+    point_cloud_data_.UpdateColors(glm::mat4(1.0f), intrinsics, nullptr);
+    return;
+  }
+  glm::mat4 color_T_depth = GetColorTDepth(
+      frame->timestamp, point_cloud_data_.GetCurrentTimstamp());
+  point_cloud_data_.UpdateColors(color_T_depth, intrinsics, frame->nv21.data());
+}
 
-  // TangoService_getPoseAtTime function is used for query device extrinsics
-  // as well. We use timestamp 0.0 and the target frame pair to get the
-  // extrinsics from the sensors.
-  //
-  // Get device with respect to imu transformation matrix.
-  frame_pair.base = TANGO_COORDINATE_FRAME_IMU;
+glm::mat4 PointCloudApp::GetColorTDepth(double color_timestamp,
+                                        double depth_timestamp) {
+  TangoCoordinateFramePair frame_pair;
+  frame_pair.base = TANGO_COORDINATE_FRAME_START_OF_SERVICE;
   frame_pair.target = TANGO_COORDINATE_FRAME_DEVICE;
-  ret = TangoService_getPoseAtTime(0.0, frame_pair, &pose_data);
-  if (ret != TANGO_SUCCESS) {
-    LOGE(
-        "PointCloudApp: Failed to get transform between the IMU frame and "
-        "device frames");
-    return ret;
+  TangoPoseData start_service_T_device_color;
+  TangoPoseData start_service_T_device_depth;
+  if (TangoService_getPoseAtTime(color_timestamp, frame_pair,
+                                 &start_service_T_device_color) !=
+          TANGO_SUCCESS ||
+      TangoService_getPoseAtTime(depth_timestamp, frame_pair,
+                                 &start_service_T_device_depth) !=
+          TANGO_SUCCESS ||
+      start_service_T_device_color.status_code != TANGO_POSE_VALID ||
+      start_service_T_device_depth.status_code != TANGO_POSE_VALID) {
+    return extrinsics_.GetColorTDepth();
   }
-  pose_data_.SetImuTDevice(pose_data_.GetMatrixFromPose(pose_data));
+  // color_T_depth = color_T_device * device_color_T_start_service *
+  //                 start_service_T_device_depth * device_T_depth
+  return extrinsics_.GetColorTDevice() *
+         glm::inverse(
+             pose_data_.GetMatrixFromPose(start_service_T_device_color)) *
+         pose_data_.GetMatrixFromPose(start_service_T_device_depth) *
+         extrinsics_.GetDeviceTDepth();
+}
 
-  // Get color camera with respect to imu transformation matrix.
-  frame_pair.base = TANGO_COORDINATE_FRAME_IMU;
-  frame_pair.target = TANGO_COORDINATE_FRAME_CAMERA_DEPTH;
-  ret = TangoService_getPoseAtTime(0.0, frame_pair, &pose_data);
+TangoErrorType PointCloudApp::UpdateExtrinsics() {
+  // TangoService_getPoseAtTime function is used for query device extrinsics
+  // as well. DeviceExtrinsics uses timestamp 0.0 and the IMU frame pairs to
+  // get the extrinsics from the sensors.
+  TangoErrorType ret = extrinsics_.Query();
   if (ret != TANGO_SUCCESS) {
-    LOGE(
-        "PointCloudApp: Failed to get transform between the color camera frame "
-        "and device frames");
+    LOGE("PointCloudApp: Failed to get the device extrinsics");
     return ret;
   }
-  pose_data_.SetImuTDepthCamera(pose_data_.GetMatrixFromPose(pose_data));
+  pose_data_.SetDeviceTOpenGLCamera(
+      extrinsics_.GetDeviceTOpenGLDepthCamera());
   return ret;
 }
 
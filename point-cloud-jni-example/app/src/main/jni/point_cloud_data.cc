@@ -16,41 +16,105 @@
 
 #include "tango-point-cloud/point_cloud_data.h"
 
+#include <utility>
+
 namespace {
 const float kSecondToMillisecond = 1000.0f;
+
+// Points kept from each depth frame for rendering.
+const size_t kMaxRenderPointCount = 10000;
+
+// Point storage of the frame pool, room for eight frames of
+// kMaxRenderPointCount points. The renderer holds up to two frames, the rest
+// is slack for Java consumers of exported frames.
+const size_t kPointCloudPoolBudget =
+    8 * kMaxRenderPointCount * 3 * sizeof(float);
 }  // namespace
 
 namespace tango_point_cloud {
 
-int PointCloudData::GetPointCloudVerticesCount() { return vertices_count_; }
+PointCloudData::PointCloudData()
+    : pool_(kMaxRenderPointCount, kPointCloudPoolBudget) {
+  decimator_.SetMode(tango_gl::PointCloudDecimator::kVoxelGrid);
+  decimator_.SetTargetPointCount(kMaxRenderPointCount);
+}
 
-float PointCloudData::GetAverageDepth() { return average_depth_; }
+int PointCloudData::GetPointCloudVerticesCount() {
+  return GetFrameStatistics().point_count;
+}
 
-void PointCloudData::SetAverageDepth(float average_depth) {
-  average_depth_ = average_depth;
+float PointCloudData::GetAverageDepth() {
+  return GetFrameStatistics().depth.mean_depth;
 }
 
 float PointCloudData::GetDepthFrameDeltaTime() {
-  return static_cast<float>(delta_timestamp_) * kSecondToMillisecond;
+  return GetFrameStatistics().delta_time;
+}
+
+const PointCloudData::FrameStatistics& PointCloudData::GetFrameStatistics() {
+  frame_statistics_.Acquire();
+  return *frame_statistics_.GetReadBuffer();
 }
 
 double PointCloudData::GetCurrentTimstamp() { return cur_frame_timstamp_; }
 
 void PointCloudData::UpdatePointCloud(const TangoXYZij* point_cloud) {
-  size_t point_cloud_size = point_cloud->xyz_count * 3;
-  vertices_.resize(point_cloud_size);
-  std::copy(point_cloud->xyz[0], point_cloud->xyz[0] + point_cloud_size,
-            vertices_.begin());
+  FrameStatistics* statistics = frame_statistics_.GetWriteBuffer();
+  tango_gl::ComputeDepthStatistics(point_cloud->xyz[0], point_cloud->xyz_count,
+                                   &statistics->depth);
+
+  // Decimate into pool storage, so exported frames need no copy. The current
+  // frame is kept if every slot is held by consumers.
+  tango_gl::PointCloudPool::Handle frame = pool_.Allocate();
+  if (frame) {
+    frame->cloud.timestamp = point_cloud->timestamp;
+    frame->cloud.xyz_count = static_cast<uint32_t>(decimator_.Decimate(
+        point_cloud->xyz[0], point_cloud->xyz_count, frame->cloud.xyz[0]));
+    pool_.Publish(frame);
+    current_ = std::move(frame);
+  } else {
+    LOGE("PointCloudData: Every frame slot is in use, dropping a depth frame");
+  }
 
   // Get current frame's point count.
-  vertices_count_ = point_cloud->xyz_count;
+  statistics->point_count = point_cloud->xyz_count;
 
   // Compute the frame delta time.
   cur_frame_timstamp_ = point_cloud->timestamp;
-  delta_timestamp_ = cur_frame_timstamp_ - prev_frame_timestamp_;
+  statistics->delta_time = static_cast<float>(
+      (cur_frame_timstamp_ - prev_frame_timestamp_) * kSecondToMillisecond);
+  frame_statistics_.Publish();
 
   // Set current timestamp to previous timestamp.
   prev_frame_timestamp_ = point_cloud->timestamp;
 }
 
+void PointCloudData::UpdateColors(
+    const glm::mat4& color_T_depth,
+    const tango_gl::projection::CameraIntrinsics& intrinsics,
+    const uint8_t* nv21) {
+  if (!current_) {
+    colored_points_.clear();
+    return;
+  }
+  const size_t point_count = current_->cloud.xyz_count;
+  colored_points_.resize(point_count);
+  colorizer_.Colorize(current_->cloud.xyz[0], point_count, color_T_depth,
+                      intrinsics, nv21, colored_points_.data());
+}
+
+int PointCloudData::AcquireLatestExport(ExportInfo* info) {
+  tango_gl::PointCloudPool::Handle frame = pool_.AcquireLatest();
+  if (!frame) {
+    return -1;
+  }
+  info->sequence = frame->sequence;
+  info->timestamp = frame->cloud.timestamp;
+  info->point_count = frame->cloud.xyz_count;
+  info->reserved = 0;
+  return frame.Detach();
+}
+
+void PointCloudData::ReleaseExport(int slot) { pool_.Attach(slot); }
+
 }  // namespace tango_point_cloud
@@ -15,21 +15,38 @@
  * limitations under the License.
  */
 
+#include <stddef.h>
+#include <string.h>
+
 #include <sstream>
 
+#include <tango-gl/counters.h>
+#include <tango-gl/program_cache.h>
+#include <tango-gl/render_state.h>
+
 #include "tango-point-cloud/point_cloud_drawable.h"
 
 namespace {
+// Preceded by the definition of FRAME_COUNT.
 const std::string kPointCloudVertexShader =
-    "attribute vec4 vertex;\n"
-    "uniform mat4 mvp;\n"
+    "attribute vec3 vertex;\n"
+    "attribute vec4 color;\n"
+    "attribute vec2 slot;\n"
+    "uniform mat4 slot_mvp[FRAME_COUNT];\n"
+    "uniform vec2 slot_state[FRAME_COUNT];\n"
+    "uniform float vertex_scale;\n"
     "varying vec4 v_color;\n"
     "void main() {\n"
+    "  int index = int(slot.x);\n"
+    "  vec2 state = slot_state[index];\n"
+    "  vec4 position = vec4(vertex * vertex_scale, 1.0);\n"
     "  gl_PointSize = 5.0;\n"
-    "  gl_Position = mvp*vertex;\n"
-    "  v_color = vertex;\n"
+    "  gl_Position = slot.y < state.x ? slot_mvp[index] * position\n"
+    "                                 : vec4(2.0, 2.0, 2.0, 1.0);\n"
+    "  v_color = vec4(mix(position.rgb, color.rgb, color.a), state.y);\n"
     "}\n";
 const std::string kPointCloudFragmentShader =
+    "precision mediump float;\n"
     "varying vec4 v_color;\n"
     "void main() {\n"
     "  gl_FragColor = vec4(v_color);\n"
@@ -38,44 +55,157 @@ const std::string kPointCloudFragmentShader =
 const glm::mat4 kOpengGL_T_Depth =
     glm::mat4(1.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f,
               -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f);
+
+// Slot capacities are rounded up to a multiple of this, so frames a little
+// larger than the previous largest do not reallocate the ring each time.
+const size_t kSlotCapacityGranularity = 4096;
 }  // namespace
 
 namespace tango_point_cloud {
 
-PointCloudDrawable::PointCloudDrawable() {
+const int PointCloudDrawable::kFrameCount;
+
+PointCloudDrawable::PointCloudDrawable()
+    : vertex_buffer_(GL_ARRAY_BUFFER, GL_DYNAMIC_DRAW),
+      slot_buffer_(GL_ARRAY_BUFFER, GL_STATIC_DRAW),
+      slot_capacity_(0),
+      latest_slot_(-1),
+      latest_timestamp_(-1.0) {
   LOGI("PointCloudDrawable constructor");
-  shader_program_ = tango_gl::util::CreateProgram(
-      kPointCloudVertexShader.c_str(), kPointCloudFragmentShader.c_str());
+  for (Slot& slot : slots_) {
+    slot.point_count = 0;
+  }
+  std::ostringstream vertex_shader;
+  vertex_shader << "#define FRAME_COUNT " << kFrameCount << "\n"
+                << kPointCloudVertexShader;
+  shader_program_ = tango_gl::program_cache::AcquireProgram(
+      vertex_shader.str().c_str(), kPointCloudFragmentShader.c_str());
 
-  mvp_handle_ = glGetUniformLocation(shader_program_, "mvp");
+  slot_mvp_handle_ = glGetUniformLocation(shader_program_, "slot_mvp");
+  slot_state_handle_ = glGetUniformLocation(shader_program_, "slot_state");
+  vertex_scale_handle_ = glGetUniformLocation(shader_program_, "vertex_scale");
   vertices_handle_ = glGetAttribLocation(shader_program_, "vertex");
-  glGenBuffers(1, &vertex_buffers_);
+  color_handle_ = glGetAttribLocation(shader_program_, "color");
+  slot_handle_ = glGetAttribLocation(shader_program_, "slot");
+}
+
+PointCloudDrawable::~PointCloudDrawable() {
+  tango_gl::program_cache::ReleaseProgram(shader_program_);
 }
 
-PointCloudDrawable::~PointCloudDrawable() { glDeleteProgram(shader_program_); }
+void PointCloudDrawable::Render(tango_gl::ViewFrustum* view_frustum,
+                                glm::mat4 projection_mat, glm::mat4 view_mat,
+                                glm::mat4 model_mat, double timestamp,
+                                const std::vector<
+                                    tango_gl::QuantizedColoredPoint>& points) {
+  if (timestamp != latest_timestamp_ && !points.empty()) {
+    AddFrame(model_mat, points);
+    latest_timestamp_ = timestamp;
+  }
+  if (latest_slot_ < 0) {
+    return;
+  }
 
-void PointCloudDrawable::Render(glm::mat4 projection_mat, glm::mat4 view_mat,
-                                glm::mat4 model_mat,
-                                const std::vector<float>& vertices) {
-  glUseProgram(shader_program_);
-  glEnable(GL_VERTEX_PROGRAM_POINT_SIZE);
-  mvp_handle_ = glGetUniformLocation(shader_program_, "mvp");
+  // Frames outside of the view frustum keep their slot but no points.
+  const glm::mat4 vp_mat = projection_mat * view_mat;
+  GLfloat slot_mvps[kFrameCount * 16];
+  GLfloat slot_states[kFrameCount * 2];
+  bool is_visible = false;
+  for (int i = 0; i < kFrameCount; ++i) {
+    const Slot& slot = slots_[i];
+    const glm::mat4 world_T_depth = slot.model_mat * kOpengGL_T_Depth;
+    const bool is_slot_visible =
+        slot.point_count > 0 &&
+        view_frustum->IsBoxVisible(slot.bounding_box, world_T_depth);
+    const glm::mat4 mvp_mat = vp_mat * world_T_depth;
+    memcpy(slot_mvps + i * 16, glm::value_ptr(mvp_mat), sizeof(mvp_mat));
+    const int age = (latest_slot_ - i + kFrameCount) % kFrameCount;
+    slot_states[i * 2] =
+        is_slot_visible ? static_cast<GLfloat>(slot.point_count) : 0.0f;
+    slot_states[i * 2 + 1] = 1.0f - static_cast<float>(age) / kFrameCount;
+    is_visible = is_visible || is_slot_visible;
+  }
+  if (!is_visible) {
+    return;
+  }
 
-  // Calculate model view projection matrix.
-  glm::mat4 mvp_mat = projection_mat * view_mat * model_mat * kOpengGL_T_Depth;
-  glUniformMatrix4fv(mvp_handle_, 1, GL_FALSE, glm::value_ptr(mvp_mat));
+  tango_gl::RenderState::UseProgram(shader_program_);
+  tango_gl::RenderState::Enable(GL_VERTEX_PROGRAM_POINT_SIZE);
+  tango_gl::RenderState::Enable(GL_BLEND);
+  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-  glBindBuffer(GL_ARRAY_BUFFER, vertex_buffers_);
-  glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * vertices.size(),
-               vertices.data(), GL_STATIC_DRAW);
+  glUniformMatrix4fv(slot_mvp_handle_, kFrameCount, GL_FALSE, slot_mvps);
+  glUniform2fv(slot_state_handle_, kFrameCount, slot_states);
+  glUniform1f(vertex_scale_handle_, tango_gl::kQuantizedPointScale);
+
+  vertex_buffer_.Bind();
   glEnableVertexAttribArray(vertices_handle_);
-  glVertexAttribPointer(vertices_handle_, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
-  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  glVertexAttribPointer(vertices_handle_, 3, GL_SHORT, GL_FALSE,
+                        sizeof(tango_gl::QuantizedColoredPoint),
+                        reinterpret_cast<const GLvoid*>(
+                            offsetof(tango_gl::QuantizedColoredPoint, x)));
+  glEnableVertexAttribArray(color_handle_);
+  glVertexAttribPointer(color_handle_, 4, GL_UNSIGNED_BYTE, GL_TRUE,
+                        sizeof(tango_gl::QuantizedColoredPoint),
+                        reinterpret_cast<const GLvoid*>(
+                            offsetof(tango_gl::QuantizedColoredPoint, r)));
+  slot_buffer_.Bind();
+  glEnableVertexAttribArray(slot_handle_);
+  glVertexAttribPointer(slot_handle_, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
 
-  glDrawArrays(GL_POINTS, 0, vertices.size() / 3);
+  tango_gl::Counters::Increment(tango_gl::Counters::kDrawCalls);
+  glDrawArrays(GL_POINTS, 0,
+               static_cast<GLsizei>(kFrameCount * slot_capacity_));
+  glDisableVertexAttribArray(vertices_handle_);
+  glDisableVertexAttribArray(color_handle_);
+  glDisableVertexAttribArray(slot_handle_);
+  tango_gl::RenderState::BindBuffer(GL_ARRAY_BUFFER, 0);
 
-  glUseProgram(0);
   tango_gl::util::CheckGlError("Pointcloud::Render");
 }
 
+void PointCloudDrawable::AddFrame(
+    const glm::mat4& model_mat,
+    const std::vector<tango_gl::QuantizedColoredPoint>& points) {
+  const size_t point_size = sizeof(tango_gl::QuantizedColoredPoint);
+  if (points.size() > slot_capacity_) {
+    slot_capacity_ = (points.size() + kSlotCapacityGranularity - 1) /
+                     kSlotCapacityGranularity * kSlotCapacityGranularity;
+    vertex_buffer_.Reserve(kFrameCount * slot_capacity_ * point_size);
+    std::vector<GLfloat> slot_vertices(kFrameCount * slot_capacity_ * 2);
+    for (int i = 0; i < kFrameCount; ++i) {
+      for (size_t j = 0; j < slot_capacity_; ++j) {
+        GLfloat* vertex = slot_vertices.data() + (i * slot_capacity_ + j) * 2;
+        vertex[0] = static_cast<GLfloat>(i);
+        vertex[1] = static_cast<GLfloat>(j);
+      }
+    }
+    slot_buffer_.Update(slot_vertices.data(),
+                        slot_vertices.size() * sizeof(GLfloat), 0);
+    // Growing the ring lost the frames in it.
+    for (Slot& slot : slots_) {
+      slot.point_count = 0;
+    }
+    latest_slot_ = -1;
+  }
+
+  latest_slot_ = (latest_slot_ + 1) % kFrameCount;
+  Slot& slot = slots_[latest_slot_];
+  vertex_buffer_.Write(latest_slot_ * slot_capacity_ * point_size,
+                       points.data(), points.size() * point_size);
+  slot.point_count = points.size();
+  slot.model_mat = model_mat;
+
+  glm::vec3 bounding_min(points[0].x, points[0].y, points[0].z);
+  glm::vec3 bounding_max = bounding_min;
+  for (const tango_gl::QuantizedColoredPoint& point : points) {
+    glm::vec3 position(point.x, point.y, point.z);
+    bounding_min = glm::min(bounding_min, position);
+    bounding_max = glm::max(bounding_max, position);
+  }
+  slot.bounding_box =
+      tango_gl::BoundingBox(bounding_min * tango_gl::kQuantizedPointScale,
+                            bounding_max * tango_gl::kQuantizedPointScale);
+}
+
 }  // namespace tango_point_cloud
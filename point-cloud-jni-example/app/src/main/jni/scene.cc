@@ -15,6 +15,7 @@
  */
 
 #include <tango-gl/conversions.h>
+#include <tango-gl/render_state.h>
 
 #include "tango-point-cloud/scene.h"
 
@@ -33,6 +34,11 @@ const tango_gl::Color kGridColor(0.85f, 0.85f, 0.85f);
 
 // Frustum scale.
 const glm::vec3 kFrustumScale = glm::vec3(0.4f, 0.3f, 0.5f);
+
+// Bounds of the device axis and frustum drawables in the device frame, used
+// to cull them together.
+const tango_gl::BoundingBox kDeviceBoundingBox(glm::vec3(-1.0f, -1.0f, -1.0f),
+                                               glm::vec3(1.0f, 1.0f, 1.0f));
 }  // namespace
 
 namespace tango_point_cloud {
@@ -42,6 +48,7 @@ Scene::Scene() {}
 Scene::~Scene() {}
 
 void Scene::InitGLContent() {
+  frame_cache_.Invalidate();
   gesture_camera_ = new tango_gl::GestureCamera();
   axis_ = new tango_gl::Axis();
   frustum_ = new tango_gl::Frustum();
@@ -54,15 +61,24 @@ void Scene::InitGLContent() {
   grid_->SetPosition(-kHeightOffset);
   gesture_camera_->SetCameraType(
       tango_gl::GestureCamera::CameraType::kThirdPerson);
+
+  scene_graph_.Add(frustum_, tango_gl::SceneGraph::kOpaque);
+  scene_graph_.Add(axis_, tango_gl::SceneGraph::kOpaque);
+  scene_graph_.Add(trace_, tango_gl::SceneGraph::kOpaque);
+  scene_graph_.Add(grid_, tango_gl::SceneGraph::kOpaque);
+  scene_graph_.SetBounds(frustum_, kDeviceBoundingBox);
+  scene_graph_.SetBounds(axis_, kDeviceBoundingBox);
 }
 
 void Scene::FreeGLContent() {
+  scene_graph_.Clear();
   delete gesture_camera_;
   delete axis_;
   delete frustum_;
   delete trace_;
   delete grid_;
   delete point_cloud_;
+  frame_cache_.Release();
 }
 
 void Scene::SetupViewPort(int w, int h) {
@@ -71,18 +87,15 @@ void Scene::SetupViewPort(int w, int h) {
   }
   gesture_camera_->SetAspectRatio(static_cast<float>(w) /
                                   static_cast<float>(h));
+  frame_cache_.SetViewport(0, 0, w, h);
   glViewport(0, 0, w, h);
 }
 
 void Scene::Render(const glm::mat4& cur_pose_transformation,
                    const glm::mat4& point_cloud_transformation,
-                   const std::vector<float>& point_cloud_vertices) {
-  glEnable(GL_DEPTH_TEST);
-  glEnable(GL_CULL_FACE);
-
-  glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
-  glClear(GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT);
-
+                   double point_cloud_timestamp,
+                   const std::vector<tango_gl::QuantizedColoredPoint>&
+                       point_cloud_points) {
   glm::vec3 position =
       glm::vec3(cur_pose_transformation[3][0], cur_pose_transformation[3][1],
                 cur_pose_transformation[3][2]);
@@ -94,29 +107,52 @@ void Scene::Render(const glm::mat4& cur_pose_transformation,
   } else {
     // In third person or top down more, we follow the camera movement.
     gesture_camera_->SetAnchorPosition(position);
-
+  }
+  view_frustum_.Update(gesture_camera_->GetProjectionMatrix(),
+                       gesture_camera_->GetViewMatrix());
+
+  // The device is only shown when the camera is not looking through it.
+  const bool is_device_visible =
+      gesture_camera_->GetCameraType() !=
+      tango_gl::GestureCamera::CameraType::kFirstPerson;
+  scene_graph_.SetVisible(frustum_, is_device_visible);
+  scene_graph_.SetVisible(axis_, is_device_visible);
+  if (is_device_visible) {
     frustum_->SetTransformationMatrix(cur_pose_transformation);
     // Set the frustum scale to 4:3, this doesn't necessarily match the physical
     // camera's aspect ratio, this is just for visualization purposes.
     frustum_->SetScale(kFrustumScale);
-    frustum_->Render(gesture_camera_->GetProjectionMatrix(),
-                     gesture_camera_->GetViewMatrix());
-
     axis_->SetTransformationMatrix(cur_pose_transformation);
-    axis_->Render(gesture_camera_->GetProjectionMatrix(),
-                  gesture_camera_->GetViewMatrix());
   }
 
   trace_->UpdateVertexArray(position);
-  trace_->Render(gesture_camera_->GetProjectionMatrix(),
-                 gesture_camera_->GetViewMatrix());
 
-  grid_->Render(gesture_camera_->GetProjectionMatrix(),
-                gesture_camera_->GetViewMatrix());
+  // Everything drawn below follows from these, a still device seen from a
+  // still camera is presented from the cache until the next depth frame.
+  frame_cache_.AddInput(gesture_camera_->GetProjectionMatrix());
+  frame_cache_.AddInput(gesture_camera_->GetViewMatrix());
+  frame_cache_.AddInput(cur_pose_transformation);
+  frame_cache_.AddInput(point_cloud_transformation);
+  frame_cache_.AddInput(point_cloud_timestamp);
+  frame_cache_.AddInput(is_device_visible ? 1.0 : 0.0);
+  if (!frame_cache_.Begin()) {
+    return;
+  }
+
+  tango_gl::RenderState::Enable(GL_DEPTH_TEST);
+  tango_gl::RenderState::Enable(GL_CULL_FACE);
+
+  glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
+  glClear(GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT);
+
+  scene_graph_.Render(gesture_camera_->GetProjectionMatrix(),
+                      gesture_camera_->GetViewMatrix(), &view_frustum_);
 
-  point_cloud_->Render(gesture_camera_->GetProjectionMatrix(),
+  point_cloud_->Render(&view_frustum_, gesture_camera_->GetProjectionMatrix(),
                        gesture_camera_->GetViewMatrix(),
-                       point_cloud_transformation, point_cloud_vertices);
+                       point_cloud_transformation, point_cloud_timestamp,
+                       point_cloud_points);
+  frame_cache_.End();
 }
 
 void Scene::SetCameraType(tango_gl::GestureCamera::CameraType camera_type) {
@@ -18,9 +18,22 @@
 #define TANGO_POINT_CLOUD_POINT_CLOUD_APP_H_
 
 #include <jni.h>
+#include <chrono>
 #include <memory>
+#include <string>
+#include <vector>
 
 #include <tango_client_api.h>  // NOLINT
+#include <tango-gl/camera_intrinsics_registry.h>
+#include <tango-gl/device_extrinsics.h>
+#include <tango-gl/motion_gate.h>
+#include <tango-gl/pipeline_stage.h>
+#include <tango-gl/point_cloud_pool.h>
+#include <tango-gl/point_projection.h>
+#include <tango-gl/pose_history.h>
+#include <tango-gl/text_overlay.h>
+#include <tango-gl/touch_queue.h>
+#include <tango-gl/triple_buffer.h>
 #include <tango-gl/util.h>
 
 #include <tango-point-cloud/point_cloud_data.h>
@@ -72,6 +85,12 @@ class PointCloudApp {
   //              caller allocated.
   void onPointCloudAvailable(const TangoXYZij* xyz_ij);
 
+  // Tango service color camera callback function. The latest NV21 frame is
+  // kept for coloring the next depth frame.
+  //
+  // @param buffer: The color camera frame, caller allocated.
+  void OnFrameAvailable(const TangoImageBuffer* buffer);
+
   // Tango service pose callback function for pose data. Called when new
   // information about device pose is available from the Tango Service.
   //
@@ -90,7 +109,7 @@ class PointCloudApp {
   // Setup the view port width and height.
   void SetViewPort(int width, int height);
 
-  // Main render loop.
+  // Main render loop, draws the scene and the debug HUD.
   void Render();
 
   // Release all OpenGL resources that allocate from the program.
@@ -114,14 +133,29 @@ class PointCloudApp {
   // Return the delta time between current and previous depth frames.
   float GetDepthFrameDeltaTime();
 
+  // Depth frames exported to Java, see PointCloudData. Java maps each slot's
+  // storage once, then reads the latest frame in place between
+  // AcquireLatestPointCloud() and ReleasePointCloud(), from any thread.
+  int GetPointCloudSlotCount();
+  size_t GetPointCloudSlotCapacity();
+  float* GetPointCloudSlotData(int slot);
+  int AcquireLatestPointCloud(PointCloudData::ExportInfo* info);
+  void ReleasePointCloud(int slot);
+
   // Set render camera's viewing angle, first person, third person or top down.
   //
   // @param: camera_type, camera type includes first person, third person and
   //         top down
   void SetCameraType(tango_gl::GestureCamera::CameraType camera_type);
 
+  // Set whether the latency of the Tango service calls and callbacks is
+  // measured, see tango_gl::ServiceProbe. Turning it on starts over, the
+  // histograms are logged by TangoDisconnect().
+  void SetServiceProbe(bool on);
+
   // Touch event passed from android activity. This function only supports two
-  // touches.
+  // touches. Called on the UI thread, the event is queued and applied by the
+  // next Render().
   //
   // @param: touch_count, total count for touches.
   // @param: event, touch event of current touch.
@@ -133,6 +167,23 @@ class PointCloudApp {
                     float x0, float y0, float x1, float y1);
 
  private:
+  // A color camera frame handed from the camera callback thread to the depth
+  // callback thread.
+  struct ColorFrame {
+    ColorFrame() : timestamp(0.0) {}
+
+    double timestamp;
+    std::vector<uint8_t> nv21;
+  };
+
+  // A colored depth frame handed from the depth stage to the render thread.
+  struct RenderCloud {
+    RenderCloud() : timestamp(0.0) {}
+
+    double timestamp;
+    std::vector<tango_gl::QuantizedColoredPoint> points;
+  };
+
   // Get a pose in matrix format with extrinsics in OpenGl space.
   //
   // @param: timstamp, timestamp of the target pose.
@@ -146,6 +197,24 @@ class PointCloudApp {
   // @return: error code.
   TangoErrorType UpdateExtrinsics();
 
+  // Decimate and color a depth frame copied by onPointCloudAvailable(), run
+  // on depth_stage_.
+  void ProcessDepthFrame(tango_gl::PointCloudPool::Handle* frame);
+
+  // Color the current depth frame with the latest color frame, on
+  // depth_stage_.
+  void UpdatePointCloudColors();
+
+  // Compute the transformation of the depth camera at depth_timestamp with
+  // respect to the color camera at color_timestamp. The device motion
+  // between the timestamps is ignored if either pose is not available.
+  glm::mat4 GetColorTDepth(double color_timestamp, double depth_timestamp);
+
+  // Draw the pose, event and depth statistics on top of the scene. The text
+  // is formatted at most every kHudUpdateInterval, in between the unchanged
+  // batch is drawn again without an upload.
+  void RenderHud();
+
   // point_cloud_ contains the data of current depth frame, it also
   // has the render function to render the points. This instance will be passed
   // to main_scene_ for rendering.
@@ -154,28 +223,51 @@ class PointCloudApp {
   // internally inside the PointCloud class.
   PointCloudData point_cloud_data_;
 
-  // Mutex for protecting the point cloud data. The point cloud data is shared
-  // between render thread and TangoService callback thread.
-  std::mutex point_cloud_mutex_;
+  // Colored depth frames handed from depth_stage_ to the render thread.
+  tango_gl::TripleBuffer<RenderCloud> render_clouds_;
 
   // pose_data_ handles all pose onPoseAvailable callbacks, onPoseAvailable()
   // in this object will be routed to pose_data_ to handle.
   PoseData pose_data_;
 
-  // Mutex for protecting the pose data. The pose data is shared between render
-  // thread and TangoService callback thread.
-  std::mutex pose_mutex_;
+  // Device poses with respect to start of service from the pose callback.
+  tango_gl::PoseHistory pose_history_;
+
+  // Drops the depth frames that would not change the rendered cloud while
+  // the device is still, on depth_stage_. The renderer then keeps drawing
+  // the last cloud without uploading it again.
+  tango_gl::MotionGate motion_gate_;
+
+  // Fixed transformations between the device and camera frames.
+  tango_gl::DeviceExtrinsics extrinsics_;
+
+  // Intrinsics of the connected cameras.
+  tango_gl::CameraIntrinsicsRegistry camera_intrinsics_;
+
+  // Color camera intrinsics the depth points are projected with, written
+  // before depth_stage_ is started. Zero sized until the service is
+  // connected.
+  tango_gl::projection::CameraIntrinsics color_camera_intrinsics_;
+
+  // NV21 frames from the color camera, read by the depth callback. The slots
+  // are allocated on the first frames and reused afterwards.
+  tango_gl::TripleBuffer<ColorFrame> color_frames_;
+
+  // Depth frames copied out of the XYZij callback, declared before
+  // depth_stage_ so it outlives the frames queued there.
+  tango_gl::PointCloudPool depth_frames_;
+
+  // Worker processing the depth frames off the callback thread. Only the
+  // latest frame is kept when it falls behind.
+  tango_gl::PipelineStage<tango_gl::PointCloudPool::Handle> depth_stage_;
 
   // tango_event_data_ handles all Tango event callbacks,
   // onTangoEventAvailable() in this object will be routed to tango_event_data_
   // to handle.
   TangoEventData tango_event_data_;
 
-  // tango_event_data_ is share between the UI thread we start for updating
-  // debug
-  // texts and the TangoService event callback thread. We keep event_mutex_ to
-  // protect tango_event_data_.
-  std::mutex tango_event_mutex_;
+  // Touch events from the UI thread, drained by Render() on the GL thread.
+  tango_gl::TouchQueue touch_queue_;
 
   // main_scene_ includes all drawable object for visualizing Tango device's
   // movement and point cloud.
@@ -188,6 +280,16 @@ class PointCloudApp {
 
   // Tango service version string.
   std::string tango_core_version_string_;
+
+  // Debug HUD, drawn in the GL pass instead of Android views so the
+  // statistics never cross JNI.
+  tango_gl::TextOverlay hud_;
+  std::string hud_text_;
+  std::chrono::steady_clock::time_point hud_update_time_;
+
+  // Viewport size in pixels.
+  int screen_width_;
+  int screen_height_;
 };
 }  // namespace tango_point_cloud
 
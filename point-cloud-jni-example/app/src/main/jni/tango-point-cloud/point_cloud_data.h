@@ -20,15 +20,51 @@
 #include <jni.h>
 
 #include <tango_client_api.h>  // NOLINT
+#include <tango-gl/depth_statistics.h>
+#include <tango-gl/point_cloud_decimator.h>
+#include <tango-gl/point_cloud_pool.h>
+#include <tango-gl/point_colorizer.h>
+#include <tango-gl/triple_buffer.h>
 #include <tango-gl/util.h>
 
 namespace tango_point_cloud {
 
 // PointCloudData is a holder for all point cloud related data. That includes
 // the current frame of the point cloud, and some other debug data.
+//
+// The debug statistics are computed by UpdatePointCloud() and published
+// lock-free, so the statistics getters need no lock. They are meant to be
+// called from a single thread, e.g. the render thread drawing the HUD.
+//
+// Each frame is decimated straight into a slot of a PointCloudPool. Java maps
+// the slots once as direct ByteBuffers and reads the latest frame in place,
+// between AcquireLatestExport() and ReleaseExport(), which are lock-free and
+// may be called from any thread.
 class PointCloudData {
  public:
-  PointCloudData() {}
+  // Description of an exported frame, written to a Java direct ByteBuffer.
+  // The layout is mirrored in PointCloudExport.java.
+  struct ExportInfo {
+    // Publish order of the frame, starting at 1.
+    uint64_t sequence;
+    double timestamp;
+    int32_t point_count;
+    int32_t reserved;
+  };
+
+  // Debug statistics of a depth frame.
+  struct FrameStatistics {
+    FrameStatistics() : depth(), point_count(0), delta_time(0.0f) {}
+
+    // Depth statistics over every point of the frame, before decimation.
+    tango_gl::DepthStatistics depth;
+    // Point count of the frame, before decimation.
+    int point_count;
+    // Time since the previous frame in milliseconds.
+    float delta_time;
+  };
+
+  PointCloudData();
   ~PointCloudData() {}
 
   // @return total point count in the current depth frame.
@@ -37,14 +73,13 @@ class PointCloudData {
   // @return the average depth (in meters) of current depth frame.
   float GetAverageDepth();
 
-  // Set average depth value.
-  // @param average_depth: average depth of the current depth frame.
-  void SetAverageDepth(float average_depth);
-
   // @return the delta time (in milliseconds) between the current depth frame
   // and the previous depth frame.
   float GetDepthFrameDeltaTime();
 
+  // @return the statistics of the most recently published depth frame.
+  const FrameStatistics& GetFrameStatistics();
+
   // Return the current depth frame's timstamp. The timestamp is used for
   // querying the depth frame's pose using the TangoService_getPoseAtTime
   // function, so we return the data in double type.
@@ -52,37 +87,82 @@ class PointCloudData {
   // @return current depth frame's timstamp.
   double GetCurrentTimstamp();
 
-  // @return the vector of the vertices.
-  const std::vector<float>& GetVerticeVector() { return vertices_; }
+  // @return the number of pool slots a frame can be exported from.
+  int GetExportSlotCount() const { return pool_.GetCloudCount(); }
+
+  // @return the capacity in points of each export slot.
+  size_t GetExportSlotCapacity() const { return pool_.GetCapacity(); }
+
+  // @return the packed x, y, z storage of an export slot, which never moves.
+  float* GetExportSlotData(int slot) const {
+    return pool_.GetCloud(slot).cloud.xyz[0];
+  }
 
-  // Update current point cloud data.
+  // Take a reference on the latest frame for a consumer that cannot hold a
+  // pool handle. The slot is not reused until ReleaseExport() is called.
+  //
+  // @param info: filled with the frame's description.
+  // @return the slot of the frame, -1 if no frame was received yet.
+  int AcquireLatestExport(ExportInfo* info);
+
+  // Drop a reference taken by AcquireLatestExport().
+  void ReleaseExport(int slot);
+
+  // @return the vertices with their colors, as of the last UpdateColors().
+  // Coordinates are quantized to millimeters, see
+  // tango_gl::QuantizedColoredPoint.
+  const std::vector<tango_gl::QuantizedColoredPoint>& GetColoredPoints() {
+    return colored_points_;
+  }
+
+  // Update current point cloud data. Call UpdateColors() afterwards to update
+  // the colored points.
   //
   // @param point_cloud: point cloud data of the current frame.
   void UpdatePointCloud(const TangoXYZij* point_cloud);
 
+  // Color the current vertices from a color camera frame.
+  //
+  // @param color_T_depth: transformation of the depth camera frame at the
+  //        depth frame's timestamp with respect to the color camera frame at
+  //        the color frame's timestamp.
+  // @param intrinsics: color camera intrinsics.
+  // @param nv21: NV21 color frame, nullptr leaves the points uncolored.
+  void UpdateColors(const glm::mat4& color_T_depth,
+                    const tango_gl::projection::CameraIntrinsics& intrinsics,
+                    const uint8_t* nv21);
+
  private:
-  // A vector list of packed coordinate triplets, x,y,z as floating point
-  // values With the unit in landscape orientation, screen facing the user:
+  // Depth frames decimated to at most the render point count. Each holds
+  // packed coordinate triplets, x,y,z as floating point values With the unit
+  // in landscape orientation, screen facing the user:
   // +Z points in the direction of the camera's optical axis, and is measured
   // perpendicular to the plane of the camera.
   // +X points toward the user's right, and +Y points toward the bottom of
   // the screen.
-  std::vector<float> vertices_;
+  tango_gl::PointCloudPool pool_;
+
+  // The current frame, also the latest one published in pool_.
+  tango_gl::PointCloudPool::Handle current_;
+
+  // Points of current_ interleaved with their color, quantized so the copy
+  // to the render thread and the upload are 25% smaller.
+  std::vector<tango_gl::QuantizedColoredPoint> colored_points_;
+
+  // Looks up the colors of current_ in the color camera frame.
+  tango_gl::PointColorizer colorizer_;
+
+  // Reduces each depth frame to the points worth rendering.
+  tango_gl::PointCloudDecimator decimator_;
 
   // Timestamp of current depth frame.
   double cur_frame_timstamp_;
 
-  // Previous depth frame's timestamp for computing the delta_timestamp_.
+  // Previous depth frame's timestamp for computing the frame delta time.
   double prev_frame_timestamp_;
 
-  // delta_timestamp_ is for debug purposes.
-  double delta_timestamp_;
-
-  // vertices_count_ is for debug purposes.
-  int vertices_count_;
-
-  // average_depth_ is for debug purposes.
-  float average_depth_;
+  // Written by UpdatePointCloud(), read by the statistics getters.
+  tango_gl::TripleBuffer<FrameStatistics> frame_statistics_;
 };
 }  // namespace tango_point_cloud
 
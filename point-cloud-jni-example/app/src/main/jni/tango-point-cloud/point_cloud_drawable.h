@@ -19,28 +19,74 @@
 
 #include <jni.h>
 
+#include <tango-gl/bounding_box.h>
+#include <tango-gl/point_colorizer.h>
 #include <tango-gl/util.h>
+#include <tango-gl/vertex_buffer.h>
+#include <tango-gl/view_frustum.h>
 
 namespace tango_point_cloud {
 
-// PointCloudDrawable is responsible for the point cloud rendering.
+// PointCloudDrawable is responsible for the point cloud rendering. Points are
+// drawn in their color camera color, points without one are colored by their
+// position.
+//
+// The last kFrameCount frames stay on screen, fading out with their age. They
+// live in the slots of a ring in one vertex buffer, each frame uploaded once
+// into the slot of the oldest with its model matrix, so the upload cost is
+// one frame whatever kFrameCount. All frames are drawn by a single draw call:
+// a static attribute gives each vertex its slot and its index in the slot,
+// which select the matrix and age of its frame from uniform arrays and drop
+// the vertices past the points of the frame.
 class PointCloudDrawable {
  public:
+  // Frames drawn, the latest included.
+  static const int kFrameCount = 8;
+
   PointCloudDrawable();
   ~PointCloudDrawable();
 
-  // Update current point cloud data.
+  // Update current point cloud data. A frame outside of the view frustum is
+  // still uploaded, as a later view may see it, but not drawn.
   //
+  // @param view_frustum: view frustum of the current render camera.
   // @param projection_mat: projection matrix from current render camera.
   // @param view_mat: view matrix from current render camera.
-  // @param model_mat: model matrix for this point cloud frame.
-  // @param vertices: all vertices in this point cloud frame.
-  void Render(glm::mat4 projection_mat, glm::mat4 view_mat, glm::mat4 model_mat,
-              const std::vector<float>& vertices);
+  // @param model_mat: model matrix for this point cloud frame, kept with
+  //                   the frame in its slot.
+  // @param timestamp: timestamp of this point cloud frame, a new frame is
+  //                   only uploaded when it changes.
+  // @param points: all colored vertices in this point cloud frame, scaled
+  //                back to meters by the vertex shader.
+  void Render(tango_gl::ViewFrustum* view_frustum, glm::mat4 projection_mat,
+              glm::mat4 view_mat, glm::mat4 model_mat, double timestamp,
+              const std::vector<tango_gl::QuantizedColoredPoint>& points);
 
  private:
-  // Vertex buffer of the point cloud geometry.
-  GLuint vertex_buffers_;
+  // A frame of the ring.
+  struct Slot {
+    size_t point_count;
+    glm::mat4 model_mat;
+    // Bounds of the points in the depth frame.
+    tango_gl::BoundingBox bounding_box;
+  };
+
+  // Upload a frame into the slot of the oldest one.
+  void AddFrame(const glm::mat4& model_mat,
+                const std::vector<tango_gl::QuantizedColoredPoint>& points);
+
+  // Points of all slots, slot_capacity_ each.
+  tango_gl::VertexBuffer vertex_buffer_;
+
+  // Slot and index in the slot of each vertex of vertex_buffer_, written once
+  // per capacity.
+  tango_gl::VertexBuffer slot_buffer_;
+
+  Slot slots_[kFrameCount];
+  size_t slot_capacity_;
+  // Slot of the latest frame, -1 before the first one.
+  int latest_slot_;
+  double latest_timestamp_;
 
   // Shader to display point cloud.
   GLuint shader_program_;
@@ -48,8 +94,19 @@ class PointCloudDrawable {
   // Handle to vertex attribute value in the shader.
   GLuint vertices_handle_;
 
-  // Handle to the model view projection matrix uniform in the shader.
-  GLuint mvp_handle_;
+  // Handle to the packed color attribute in the shader.
+  GLuint color_handle_;
+
+  // Handle to the slot attribute in the shader.
+  GLuint slot_handle_;
+
+  // Handles to the per slot model view projection matrices and count of
+  // points and opacity.
+  GLint slot_mvp_handle_;
+  GLint slot_state_handle_;
+
+  // Handle to the uniform scaling quantized coordinates to meters.
+  GLuint vertex_scale_handle_;
 };
 }  // namespace tango_point_cloud
 
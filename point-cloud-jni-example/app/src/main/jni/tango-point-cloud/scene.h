@@ -26,10 +26,13 @@
 #include <tango-gl/color.h>
 #include <tango-gl/gesture_camera.h>
 #include <tango-gl/grid.h>
+#include <tango-gl/frame_cache.h>
 #include <tango-gl/frustum.h>
+#include <tango-gl/scene_graph.h>
 #include <tango-gl/trace.h>
 #include <tango-gl/transform.h>
 #include <tango-gl/util.h>
+#include <tango-gl/view_frustum.h>
 
 #include <tango-point-cloud/point_cloud_drawable.h>
 #include <tango-point-cloud/pose_data.h>
@@ -56,11 +59,14 @@ class Scene {
   // @param: cur_pose_transformation, latest pose's transformation.
   // @param: point_cloud_transformation, pose transformation at point cloud
   //         frame's timestamp.
-  // @param: point_cloud_vertices, point cloud's vertices of the current point
-  //         frame.
+  // @param: point_cloud_timestamp, timestamp of the current point frame.
+  // @param: point_cloud_points, point cloud's colored vertices of the current
+  //         point frame.
   void Render(const glm::mat4& cur_pose_transformation,
               const glm::mat4& point_cloud_transformation,
-              const std::vector<float>& point_cloud_vertices);
+              double point_cloud_timestamp,
+              const std::vector<tango_gl::QuantizedColoredPoint>&
+                  point_cloud_points);
 
   // Set render camera's viewing angle, first person, third person or top down.
   //
@@ -68,6 +74,10 @@ class Scene {
   //         top down
   void SetCameraType(tango_gl::GestureCamera::CameraType camera_type);
 
+  // Drawables tested and culled by the last Render().
+  size_t GetTestedCount() const { return view_frustum_.GetTestedCount(); }
+  size_t GetCulledCount() const { return view_frustum_.GetCulledCount(); }
+
   // Touch event passed from android activity. This function only support two
   // touches.
   //
@@ -98,6 +108,16 @@ class Scene {
 
   // Point cloud drawale object.
   PointCloudDrawable* point_cloud_;
+
+  // Draw list of the tango-gl drawables above, point_cloud_ is drawn after
+  // it.
+  tango_gl::SceneGraph scene_graph_;
+
+  // View frustum of gesture_camera_, updated every frame to cull drawables.
+  tango_gl::ViewFrustum view_frustum_;
+
+  // Last rendered frame, presented again while nothing in it changed.
+  tango_gl::FrameCache frame_cache_;
 };
 }  // namespace tango_point_cloud
 
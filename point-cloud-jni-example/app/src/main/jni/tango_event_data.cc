@@ -14,7 +14,7 @@
  * limitations under the License.
  */
 
-#include <sstream>
+#include <string.h>
 
 #include "tango-point-cloud/tango_event_data.h"
 
@@ -25,18 +25,27 @@ TangoEventData::TangoEventData() {}
 TangoEventData::~TangoEventData() {}
 
 void TangoEventData::UpdateTangoEvent(const TangoEvent* event) {
-  std::stringstream string_stream;
-  string_stream << event->event_key << ": " << event->event_value;
-  event_string_ = string_stream.str();
-  string_stream.flush();
+  EventSnapshot snapshot;
+  strncpy(snapshot.key, event->event_key != nullptr ? event->event_key : "",
+          kMaxEventKeyLength);
+  snapshot.key[kMaxEventKeyLength] = '\0';
+  strncpy(snapshot.value,
+          event->event_value != nullptr ? event->event_value : "",
+          kMaxEventValueLength);
+  snapshot.value[kMaxEventValueLength] = '\0';
+  event_.Store(snapshot);
 }
 
 void TangoEventData::ClearEventString() {
-  event_string_.clear();
+  event_.Store(EventSnapshot());
 }
 
 std::string TangoEventData::GetTangoEventString() {
-  return event_string_;
+  EventSnapshot snapshot = event_.Load();
+  if (snapshot.key[0] == '\0') {
+    return std::string();
+  }
+  return std::string(snapshot.key) + ": " + snapshot.value;
 }
 
 }  // namespace tango_point_cloud
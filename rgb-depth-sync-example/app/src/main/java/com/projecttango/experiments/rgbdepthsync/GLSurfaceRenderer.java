@@ -26,12 +26,6 @@ import javax.microedition.khronos.opengles.GL10;
  */
 public class GLSurfaceRenderer implements GLSurfaceView.Renderer {
 
-    private MainActivity mMainActivity;
-
-    public GLSurfaceRenderer(MainActivity mainActivity) {
-        mMainActivity = mainActivity;
-    }
-
     public void onDrawFrame(GL10 gl) {
         JNIInterface.render();
     }
@@ -41,6 +35,6 @@ public class GLSurfaceRenderer implements GLSurfaceView.Renderer {
     }
 
     public void onSurfaceCreated(GL10 gl, EGLConfig config) {
-        mMainActivity.surfaceCreated();
+        // The GL content is created by the startup tasks run from render().
     }
 }
@@ -28,20 +28,12 @@ public class JNIInterface {
 
     public static native int tangoInitialize(Activity activity);
 
-    public static native int tangoSetupConfig();
-
-    public static native int tangoConnectTexture();
-
-    public static native int tangoConnect();
-
-    public static native int tangoConnectCallbacks();
-
-    public static native int tangoSetIntrinsicsAndExtrinsics();
+    // Configure and connect the service on worker threads, and create the GL
+    // content on the GL thread. Nothing is rendered until both are done.
+    public static native void tangoStart();
 
     public static native void tangoDisconnect();
 
-    public static native void initializeGLContent();
-
     public static native void setViewPort(int width, int height);
 
     public static native void render();
@@ -49,4 +41,23 @@ public class JNIInterface {
     public static native void setDepthAlphaValue(float alpha);
 
     public static native void setGPUUpsample(boolean on);
+
+    public static native void setBilateralUpsample(boolean on);
+
+    public static native void setColorFrameMatching(boolean on);
+
+    public static native void setParallelUpsample(boolean on);
+
+    public static native void setHoleFilling(boolean on);
+
+    public static native void setProfilerOverlay(boolean on);
+
+    public static native String getProfilerReport();
+
+    // Budget in bytes for the memory tracked by tango-gl, 0 for none.
+    public static native void setMemoryBudget(long bytes);
+
+    // Measure the latency of the Tango service calls and callbacks, reported
+    // by getProfilerReport().
+    public static native void setServiceProbe(boolean on);
 }
@@ -62,6 +62,11 @@ public class MainActivity extends Activity {
     private SeekBar mDepthOverlaySeekbar;
     private CheckBox mdebugOverlayCheckbox;
     private CheckBox mGPUUpsampleCheckbox;
+    private CheckBox mBilateralUpsampleCheckbox;
+    private CheckBox mColorFrameMatchingCheckbox;
+    private CheckBox mParallelUpsampleCheckbox;
+    private CheckBox mHoleFillingCheckbox;
+    private CheckBox mProfilerOverlayCheckbox;
 
     // A flag to check if the Tango Service is connected. This flag avoids the
     // program attempting to disconnect from the service while it is not
@@ -107,6 +112,41 @@ public class MainActivity extends Activity {
         }
     }
 
+    private class BilateralUpsampleListener implements CheckBox.OnCheckedChangeListener {
+        @Override
+        public void onCheckedChanged(CompoundButton buttonView, boolean isChecked) {
+            JNIInterface.setBilateralUpsample(isChecked);
+        }
+    }
+
+    private class ParallelUpsampleListener implements CheckBox.OnCheckedChangeListener {
+        @Override
+        public void onCheckedChanged(CompoundButton buttonView, boolean isChecked) {
+            JNIInterface.setParallelUpsample(isChecked);
+        }
+    }
+
+    private class ColorFrameMatchingListener implements CheckBox.OnCheckedChangeListener {
+        @Override
+        public void onCheckedChanged(CompoundButton buttonView, boolean isChecked) {
+            JNIInterface.setColorFrameMatching(isChecked);
+        }
+    }
+
+    private class HoleFillingListener implements CheckBox.OnCheckedChangeListener {
+        @Override
+        public void onCheckedChanged(CompoundButton buttonView, boolean isChecked) {
+            JNIInterface.setHoleFilling(isChecked);
+        }
+    }
+
+    private class ProfilerOverlayListener implements CheckBox.OnCheckedChangeListener {
+        @Override
+        public void onCheckedChanged(CompoundButton buttonView, boolean isChecked) {
+            JNIInterface.setProfilerOverlay(isChecked);
+        }
+    }
+
     @Override
     protected void onCreate(Bundle savedInstanceState) {
         super.onCreate(savedInstanceState);
@@ -130,18 +170,6 @@ public class MainActivity extends Activity {
           }
         }
 
-        status = JNIInterface.tangoSetupConfig();
-        if (status != TANGO_SUCCESS) {
-            Log.e(TAG, "Failed to set config with code: "  + status);
-            finish();
-        }
-
-        status = JNIInterface.tangoSetIntrinsicsAndExtrinsics();
-        if (status != TANGO_SUCCESS) {
-            Log.e(TAG, "Failed to set extrinsics and intrinsics code: "  + status);
-            finish();
-        }
-
         setContentView(R.layout.activity_main);
 
         mDepthOverlaySeekbar = (SeekBar) findViewById(R.id.depth_overlay_alpha_seekbar);
@@ -154,12 +182,35 @@ public class MainActivity extends Activity {
         mGPUUpsampleCheckbox = (CheckBox) findViewById(R.id.gpu_upsample_checkbox);
         mGPUUpsampleCheckbox.setOnCheckedChangeListener(new GPUUpsampleListener());
 
+        mBilateralUpsampleCheckbox =
+                (CheckBox) findViewById(R.id.bilateral_upsample_checkbox);
+        mBilateralUpsampleCheckbox.setOnCheckedChangeListener(
+                new BilateralUpsampleListener());
+
+        mParallelUpsampleCheckbox =
+                (CheckBox) findViewById(R.id.parallel_upsample_checkbox);
+        mParallelUpsampleCheckbox.setOnCheckedChangeListener(
+                new ParallelUpsampleListener());
+
+        mColorFrameMatchingCheckbox =
+                (CheckBox) findViewById(R.id.color_frame_matching_checkbox);
+        mColorFrameMatchingCheckbox.setOnCheckedChangeListener(
+                new ColorFrameMatchingListener());
+
+        mHoleFillingCheckbox = (CheckBox) findViewById(R.id.hole_filling_checkbox);
+        mHoleFillingCheckbox.setOnCheckedChangeListener(new HoleFillingListener());
+
+        mProfilerOverlayCheckbox =
+                (CheckBox) findViewById(R.id.profiler_overlay_checkbox);
+        mProfilerOverlayCheckbox.setOnCheckedChangeListener(
+                new ProfilerOverlayListener());
+
         // OpenGL view where all of the graphics are drawn
         mGLView = (GLSurfaceView) findViewById(R.id.gl_surface_view);
 
         // Configure OpenGL renderer
         mGLView.setEGLContextClientVersion(2);
-        mRenderer = new GLSurfaceRenderer(this);
+        mRenderer = new GLSurfaceRenderer();
         mGLView.setRenderer(mRenderer);
 
         // Check if the Tango Core is out dated.
@@ -173,45 +224,27 @@ public class MainActivity extends Activity {
 
     @Override
     protected void onResume() {
-        // We moved most of the onResume lifecycle calls to the surfaceCreated,
-        // surfaceCreated will be called after the GLSurface is created.
         super.onResume();
 
         mGLView.onResume();
 
-        int ret = JNIInterface.tangoConnect();
-        if (ret != TANGO_SUCCESS) {
-            mIsConnectedService = true;
-            Log.e(TAG, "Failed to set connect service with code: "  + ret);
-            finish();
-        }
+        // Connecting to the service and creating the GL content overlap, the
+        // steps are logged with the frame timings on pause.
+        JNIInterface.tangoStart();
+        mIsConnectedService = true;
     }
 
     @Override
     protected void onPause() {
         super.onPause();
         mGLView.onPause();
+        Log.i(TAG, "Frame timings:\n" + JNIInterface.getProfilerReport());
         if (mIsConnectedService) {
             JNIInterface.tangoDisconnect();
             mIsConnectedService = false;
         }
     }
 
-    public void surfaceCreated() {
-        JNIInterface.initializeGLContent();
-        int ret = JNIInterface.tangoConnectTexture();
-        if (ret != TANGO_SUCCESS) {
-            Log.e(TAG, "Failed to connect texture with code: "  + ret);
-            finish();
-        }
-
-        ret = JNIInterface.tangoConnectCallbacks();
-        if (ret != TANGO_SUCCESS) {
-            Log.e(TAG, "Failed to set connect cbs with code: "  + ret);
-            finish();
-        }
-    }
-
     private boolean CheckTangoCoreVersion(int minVersion) {
         int versionNumber = 0;
         String packageName = TANGO_PACKAGE_NAME;
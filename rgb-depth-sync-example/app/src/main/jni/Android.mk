@@ -22,34 +22,95 @@ include $(CLEAR_VARS)
 LOCAL_MODULE    := librgb_depth_sync_example
 
 LOCAL_SHARED_LIBRARIES := tango_client_api
+LOCAL_STATIC_LIBRARIES := cpufeatures libfreetype
 LOCAL_CFLAGS    := -std=c++11
+# Uncomment to record a Chrome trace, written to the sdcard on disconnect.
+# LOCAL_CFLAGS    += -DTANGO_GL_TRACING
+# Per frame matrix math on NEON, part of the arm64-v8a baseline. armeabi-v7a
+# keeps the scalar glm path, see tango-gl/simd_math.h.
+ifeq ($(TARGET_ARCH_ABI),arm64-v8a)
+LOCAL_CFLAGS    += -DTANGO_GL_SIMD_MATH
+endif
 
 LOCAL_C_INCLUDES := $(PROJECT_ROOT)/tango-service-sdk/include/ \
                     $(PROJECT_ROOT)/tango-gl/include \
                     $(PROJECT_ROOT)/third-party/glm/
 
-LOCAL_SRC_FILES := camera_texture_drawable.cc \
+LOCAL_SRC_FILES := bilateral_depth_upsampler.cc \
+                   camera_texture_drawable.cc \
+                   color_frame_ring.cc \
                    color_image.cc \
                    depth_image.cc \
                    jni_interface.cc \
                    rgb_depth_sync_application.cc \
                    scene.cc \
+                   tiled_depth_splatter.cc \
                    util.cc \
                    $(PROJECT_ROOT_FROM_JNI)/tango-gl/bounding_box.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/bvh.cpp \
                    $(PROJECT_ROOT_FROM_JNI)/tango-gl/camera.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/camera_intrinsics_registry.cpp \
                    $(PROJECT_ROOT_FROM_JNI)/tango-gl/conversions.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/counters.cpp \
                    $(PROJECT_ROOT_FROM_JNI)/tango-gl/cube.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/device_extrinsics.cpp \
                    $(PROJECT_ROOT_FROM_JNI)/tango-gl/drawable_object.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/energy_monitor.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/frame_arena.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/frame_constants.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/frame_profiler.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/geometry_registry.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/memory_tracker.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/occlusion_culler.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/program_cache.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/render_pass.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/render_state.cpp \
                    $(PROJECT_ROOT_FROM_JNI)/tango-gl/frustum.cpp \
                    $(PROJECT_ROOT_FROM_JNI)/tango-gl/grid.cpp \
                    $(PROJECT_ROOT_FROM_JNI)/tango-gl/line.cpp \
                    $(PROJECT_ROOT_FROM_JNI)/tango-gl/mesh.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/motion_gate.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/pixel_readback.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/point_cloud_decimator.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/point_projection.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/pose_history.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/quality_governor.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/ray_table.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/rigid_transform.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/service_probe.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/shader_variants.cpp \
                    $(PROJECT_ROOT_FROM_JNI)/tango-gl/shaders.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/startup_orchestrator.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/streaming_texture.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/text_overlay.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/thread_policy.cpp \
                    $(PROJECT_ROOT_FROM_JNI)/tango-gl/trace.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/trajectory_store.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/tracing.cpp \
                    $(PROJECT_ROOT_FROM_JNI)/tango-gl/transform.cpp \
-                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/util.cpp
-                   
-LOCAL_LDLIBS    := -llog -lGLESv2 -L$(SYSROOT)/usr/lib
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/undistortion_mesh.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/util.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/vertex_array.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/vertex_buffer.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/view_frustum.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/worker_pool.cpp
+
+# The NEON kernel is built with NEON enabled and selected at runtime, so the
+# library still runs on armeabi-v7a devices without NEON. arm64-v8a always
+# has NEON and needs no .neon suffix.
+TANGO_GL_NEON_SOURCES := $(PROJECT_ROOT_FROM_JNI)/tango-gl/point_projection_neon.cpp
+ifeq ($(TARGET_ARCH_ABI),armeabi-v7a)
+LOCAL_CFLAGS    += -DTANGO_GL_HAS_NEON
+LOCAL_SRC_FILES += $(addsuffix .neon,$(TANGO_GL_NEON_SOURCES))
+endif
+ifeq ($(TARGET_ARCH_ABI),arm64-v8a)
+LOCAL_CFLAGS    += -DTANGO_GL_HAS_NEON
+LOCAL_SRC_FILES += $(TANGO_GL_NEON_SOURCES)
+endif
+
+LOCAL_LDLIBS    := -llog -ldl -lGLESv2 -lEGL -L$(SYSROOT)/usr/lib
 include $(BUILD_SHARED_LIBRARY)
 $(call import-add-path, $(PROJECT_ROOT))
 $(call import-module,tango_client_api)
+$(call import-module,android/cpufeatures)
+$(call import-module,third-party/libfreetype)
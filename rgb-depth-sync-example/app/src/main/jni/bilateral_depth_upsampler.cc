@@ -0,0 +1,488 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+#include <tango-gl/counters.h>
+#include <tango-gl/memory_tracker.h>
+#include <tango-gl/program_cache.h>
+#include <tango-gl/render_pass.h>
+#include <tango-gl/render_state.h>
+
+#include "rgb-depth-sync/bilateral_depth_upsampler.h"
+
+namespace {
+// Full screen quad as a triangle strip, in normalized device coordinates.
+const GLfloat kQuadVertices[] = {-1.0f, -1.0f, 1.0f, -1.0f,
+                                 -1.0f, 1.0f,  1.0f, 1.0f};
+
+// Luminance of the undistorted color image. The mesh has texture coordinate
+// (0, 0) at its top left, y is flipped so that row 0 of the target is the
+// top of the image.
+const std::string kGuideVertexShader =
+    "precision highp float;\n"
+    "attribute vec4 vertex;\n"
+    "attribute vec2 textureCoords;\n"
+    "varying vec2 f_textureCoords;\n"
+    "void main() {\n"
+    "  f_textureCoords = textureCoords;\n"
+    "  gl_Position = vec4(vertex.x, -vertex.y, 0.0, 1.0);\n"
+    "}\n";
+// Preceded by the extension and sampler type of the color texture, see
+// GetGuideFragmentShader().
+const char kGuideFragmentShader[] =
+    "precision mediump float;\n"
+    "uniform COLOR_SAMPLER colorTexture;\n"
+    "varying vec2 f_textureCoords;\n"
+    "void main() {\n"
+    "  vec3 color = texture2D(colorTexture, f_textureCoords).rgb;\n"
+    "  gl_FragColor = vec4(dot(color, vec3(0.299, 0.587, 0.114)));\n"
+    "}\n";
+
+// Single pixel splats of the points, in the depth encoding of DepthImage.
+const std::string kSplatVertexShader =
+    "precision highp float;\n"
+    "attribute vec4 vertex;\n"
+    "uniform mat4 mvp;\n"
+    "uniform mat4 color_T_depth;\n"
+    "varying mediump vec2 v_depth;\n"
+    "void main() {\n"
+    "  gl_PointSize = 1.0;\n"
+    "  gl_Position = mvp * vertex;\n"
+    "  float z = (color_T_depth * vertex).z;\n"
+    "  float millimeters = floor(clamp(z * 1000.0, 0.0, 65535.0) + 0.5);\n"
+    "  float high = floor(millimeters / 256.0);\n"
+    "  v_depth = vec2(millimeters - high * 256.0, high) / 255.0;\n"
+    "}\n";
+const std::string kSplatFragmentShader =
+    "precision mediump float;\n"
+    "varying vec2 v_depth;\n"
+    "void main() {\n"
+    "  gl_FragColor = vec4(0.0, 0.0, v_depth);\n"
+    "}\n";
+
+const std::string kFilterVertexShader =
+    "precision highp float;\n"
+    "attribute vec2 vertex;\n"
+    "varying vec2 f_coords;\n"
+    "void main() {\n"
+    "  gl_Position = vec4(vertex, 0.0, 1.0);\n"
+    "  f_coords = vertex * 0.5 + 0.5;\n"
+    "}\n";
+
+// Declarations shared by the two filter passes, after the RADIUS define.
+const char kFilterFragmentHeader[] =
+    "#ifdef GL_FRAGMENT_PRECISION_HIGH\n"
+    "precision highp float;\n"
+    "#else\n"
+    "precision mediump float;\n"
+    "#endif\n"
+    "uniform sampler2D depth_image;\n"
+    "uniform sampler2D guide;\n"
+    "uniform vec2 sparse_size;\n"
+    "uniform float spatial_scale;\n"
+    "uniform float range_scale;\n"
+    "varying vec2 f_coords;\n"
+    "float DecodeDepth(vec4 texel) {\n"
+    "  return dot(floor(texel.ba * 255.0 + 0.5), vec2(1.0, 256.0)) * 0.001;\n"
+    "}\n"
+    "vec2 EncodeDepth(float depth) {\n"
+    "  float millimeters = floor(clamp(depth * 1000.0, 0.0, 65535.0) + 0.5);\n"
+    "  float high = floor(millimeters / 256.0);\n"
+    "  return vec2(millimeters - high * 256.0, high) / 255.0;\n"
+    "}\n"
+    "float Weight(float offset, float luminance, float center_luminance) {\n"
+    "  float difference = luminance - center_luminance;\n"
+    "  return exp(spatial_scale * offset * offset +\n"
+    "             range_scale * difference * difference);\n"
+    "}\n";
+
+// Filters the sparse texels of a row. Red holds the sum of the weights, the
+// confidence of the vertical pass.
+const char kHorizontalFragmentShader[] =
+    "void main() {\n"
+    "  float x = f_coords.x * sparse_size.x - 0.5;\n"
+    "  float center = floor(x + 0.5);\n"
+    "  float center_luminance = texture2D(guide, f_coords).r;\n"
+    "  float sum = 0.0;\n"
+    "  float weight_sum = 0.0;\n"
+    "  for (int i = -RADIUS; i <= RADIUS; ++i) {\n"
+    "    float column = center + float(i);\n"
+    "    vec2 coords = vec2((column + 0.5) / sparse_size.x, f_coords.y);\n"
+    "    float depth = DecodeDepth(texture2D(depth_image, coords));\n"
+    "    float luminance = texture2D(guide, coords).r;\n"
+    "    float weight = step(0.0005, depth) *\n"
+    "                   Weight(column - x, luminance, center_luminance);\n"
+    "    sum += weight * depth;\n"
+    "    weight_sum += weight;\n"
+    "  }\n"
+    "  float depth = weight_sum > 0.001 ? sum / weight_sum : 0.0;\n"
+    "  gl_FragColor = vec4(min(weight_sum, 1.0), 0.0, EncodeDepth(depth));\n"
+    "}\n";
+
+// Filters the rows of the horizontal pass into the output.
+const char kVerticalFragmentShader[] =
+    "void main() {\n"
+    "  float y = f_coords.y * sparse_size.y - 0.5;\n"
+    "  float center = floor(y + 0.5);\n"
+    "  float center_luminance = texture2D(guide, f_coords).r;\n"
+    "  float sum = 0.0;\n"
+    "  float weight_sum = 0.0;\n"
+    "  for (int i = -RADIUS; i <= RADIUS; ++i) {\n"
+    "    float row = center + float(i);\n"
+    "    vec2 coords = vec2(f_coords.x, (row + 0.5) / sparse_size.y);\n"
+    "    vec4 texel = texture2D(depth_image, coords);\n"
+    "    float depth = DecodeDepth(texel);\n"
+    "    float luminance = texture2D(guide, coords).r;\n"
+    "    float weight = step(0.0005, depth) * texel.r *\n"
+    "                   Weight(row - y, luminance, center_luminance);\n"
+    "    sum += weight * depth;\n"
+    "    weight_sum += weight;\n"
+    "  }\n"
+    "  float depth = weight_sum > 0.001 ? sum / weight_sum : 0.0;\n"
+    "  gl_FragColor = vec4(0.0, 0.0, EncodeDepth(depth));\n"
+    "}\n";
+
+std::string GetGuideFragmentShader(GLenum color_texture_target) {
+  if (color_texture_target == GL_TEXTURE_2D) {
+    return std::string("#define COLOR_SAMPLER sampler2D\n") +
+           kGuideFragmentShader;
+  }
+  return std::string(
+             "#extension GL_OES_EGL_image_external : require\n"
+             "#define COLOR_SAMPLER samplerExternalOES\n") +
+         kGuideFragmentShader;
+}
+
+std::string GetFilterFragmentShader(const char* main, int radius) {
+  std::ostringstream source;
+  source << "#define RADIUS " << radius << "\n"
+         << kFilterFragmentHeader << main;
+  return source.str();
+}
+}  // namespace
+
+namespace rgb_depth_sync {
+
+const int BilateralDepthUpsampler::kMaxRadius;
+const float BilateralDepthUpsampler::kDefaultColorSigma = 0.1f;
+
+BilateralDepthUpsampler::BilateralDepthUpsampler()
+    : intrinsics_(),
+      output_scale_(1.0f),
+      radius_(kDefaultRadius),
+      color_sigma_(kDefaultColorSigma),
+      targets_(),
+      programs_(),
+      program_radius_(0),
+      program_color_target_(GL_TEXTURE_EXTERNAL_OES),
+      point_buffer_(GL_ARRAY_BUFFER, GL_STREAM_DRAW),
+      quad_buffer_(GL_ARRAY_BUFFER, GL_STATIC_DRAW) {}
+
+BilateralDepthUpsampler::~BilateralDepthUpsampler() { Release(); }
+
+void BilateralDepthUpsampler::InitializeGL() {
+  for (Target& target : targets_) {
+    target = Target();
+  }
+  for (Program& program : programs_) {
+    program = Program();
+  }
+  program_radius_ = 0;
+  mesh_.Invalidate();
+  point_buffer_.Invalidate();
+  quad_buffer_.Invalidate();
+}
+
+void BilateralDepthUpsampler::Release() {
+  for (Target& target : targets_) {
+    if (target.framebuffer != 0) {
+      glDeleteFramebuffers(1, &target.framebuffer);
+      tango_gl::RenderState::DeleteTextures(1, &target.texture);
+    }
+    if (target.depth_renderbuffer != 0) {
+      glDeleteRenderbuffers(1, &target.depth_renderbuffer);
+      tango_gl::MemoryTracker::Untrack(tango_gl::MemoryTracker::kRenderbuffer,
+                                       target.depth_renderbuffer);
+    }
+  }
+  ReleasePrograms();
+  point_buffer_.Release();
+  quad_buffer_.Release();
+  InitializeGL();
+}
+
+void BilateralDepthUpsampler::SetCameraIntrinsics(
+    const TangoCameraIntrinsics& intrinsics,
+    const glm::mat4& projection_matrix_ar) {
+  intrinsics_ = intrinsics;
+  projection_matrix_ar_ = projection_matrix_ar;
+}
+
+void BilateralDepthUpsampler::SetOutputScale(float scale) {
+  output_scale_ = std::min(1.0f, std::max(0.25f, scale));
+}
+
+void BilateralDepthUpsampler::SetRadius(int radius) {
+  radius_ = std::min(kMaxRadius, std::max(1, radius));
+}
+
+void BilateralDepthUpsampler::SetColorSigma(float sigma) {
+  color_sigma_ = std::max(0.001f, sigma);
+}
+
+bool BilateralDepthUpsampler::Upsample(const glm::mat4& color_t1_T_depth_t0,
+                                       const std::vector<float>& points,
+                                       bool new_points, GLuint color_texture,
+                                       GLenum color_texture_target) {
+  const GLsizei image_width = static_cast<GLsizei>(intrinsics_.width);
+  const GLsizei image_height = static_cast<GLsizei>(intrinsics_.height);
+  if (image_width <= 0 || image_height <= 0) {
+    return false;
+  }
+  const GLsizei output_width = std::max<GLsizei>(
+      1, static_cast<GLsizei>(std::lround(image_width * output_scale_)));
+  const GLsizei output_height = std::max<GLsizei>(
+      1, static_cast<GLsizei>(std::lround(image_height * output_scale_)));
+  const GLsizei sparse_width =
+      std::max<GLsizei>(1, image_width / kDefaultSparseDivisor);
+  const GLsizei sparse_height =
+      std::max<GLsizei>(1, image_height / kDefaultSparseDivisor);
+  if (!Allocate(kGuide, output_width, output_height) ||
+      !Allocate(kSparse, sparse_width, sparse_height) ||
+      !Allocate(kHorizontal, output_width, sparse_height) ||
+      !Allocate(kVertical, output_width, output_height) ||
+      !AcquirePrograms(color_texture_target)) {
+    return false;
+  }
+
+  tango_gl::RenderState::Disable(GL_BLEND);
+  tango_gl::RenderState::Disable(GL_DEPTH_TEST);
+
+  // The Tango C-API binds the color texture to the active unit, it is kept
+  // on unit 0 and the filter inputs go to units 1 and 2.
+  BeginPass(kGuide);
+  tango_gl::RenderState::ActiveTexture(GL_TEXTURE0);
+  tango_gl::RenderState::BindTexture(color_texture_target, color_texture);
+  glUniform1i(programs_[kGuide].uniform_color_texture, 0);
+  mesh_.Draw(programs_[kGuide].attrib_vertices,
+             programs_[kGuide].attrib_texture_coords);
+
+  BeginPass(kSparse);
+  const size_t point_count = points.size() / 3;
+  if (point_count > 0) {
+    // Without the usual negation of the Y-axis, so that texture row 0 is the
+    // top row of the color image.
+    const glm::mat4 opengl_T_color(1.0f, 0.0f, 0.0f, 0.0f,
+                                   0.0f, 1.0f, 0.0f, 0.0f,
+                                   0.0f, 0.0f, -1.0f, 0.0f,
+                                   0.0f, 0.0f, 0.0f, 1.0f);
+    const glm::mat4 mvp =
+        projection_matrix_ar_ * opengl_T_color * color_t1_T_depth_t0;
+    const size_t size = points.size() * sizeof(float);
+    if (new_points || point_buffer_.GetSize() != size) {
+      point_buffer_.Update(points.data(), size, 0);
+    }
+    const Program& splat = programs_[kSparse];
+    glUniformMatrix4fv(splat.uniform_mvp, 1, GL_FALSE, glm::value_ptr(mvp));
+    glUniformMatrix4fv(splat.uniform_color_T_depth, 1, GL_FALSE,
+                       glm::value_ptr(color_t1_T_depth_t0));
+    tango_gl::RenderState::Enable(GL_DEPTH_TEST);
+    point_buffer_.Bind();
+    glEnableVertexAttribArray(splat.attrib_vertices);
+    glVertexAttribPointer(splat.attrib_vertices, 3, GL_FLOAT, GL_FALSE, 0,
+                          nullptr);
+    tango_gl::Counters::Increment(tango_gl::Counters::kDrawCalls);
+    glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(point_count));
+    glDisableVertexAttribArray(splat.attrib_vertices);
+    tango_gl::RenderState::Disable(GL_DEPTH_TEST);
+  }
+
+  // The spatial weight falls to exp(-2) at the radius, the range weight
+  // with the luminance difference over color_sigma_.
+  const float sigma = 0.5f * radius_;
+  const float spatial_scale = -0.5f / (sigma * sigma);
+  const float range_scale = -0.5f / (color_sigma_ * color_sigma_);
+  const Pass filter_passes[] = {kHorizontal, kVertical};
+  const Pass input_passes[] = {kSparse, kHorizontal};
+  for (int i = 0; i < 2; ++i) {
+    const Program& filter = programs_[filter_passes[i]];
+    BeginPass(filter_passes[i]);
+    tango_gl::RenderState::ActiveTexture(GL_TEXTURE1);
+    tango_gl::RenderState::BindTexture(GL_TEXTURE_2D,
+                                       targets_[input_passes[i]].texture);
+    tango_gl::RenderState::ActiveTexture(GL_TEXTURE2);
+    tango_gl::RenderState::BindTexture(GL_TEXTURE_2D,
+                                       targets_[kGuide].texture);
+    glUniform1i(filter.uniform_depth_image, 1);
+    glUniform1i(filter.uniform_guide, 2);
+    glUniform2f(filter.uniform_sparse_size, static_cast<float>(sparse_width),
+                static_cast<float>(sparse_height));
+    glUniform1f(filter.uniform_spatial_scale, spatial_scale);
+    glUniform1f(filter.uniform_range_scale, range_scale);
+    DrawQuad(filter.attrib_vertices);
+  }
+  tango_gl::RenderState::ActiveTexture(GL_TEXTURE0);
+
+  tango_gl::RenderPass::End();
+  tango_gl::util::CheckGlError("BilateralDepthUpsampler::Upsample");
+  return true;
+}
+
+bool BilateralDepthUpsampler::Allocate(Pass pass, GLsizei width,
+                                       GLsizei height) {
+  Target& target = targets_[pass];
+  if (target.framebuffer != 0 && target.width == width &&
+      target.height == height) {
+    return true;
+  }
+  if (target.framebuffer == 0) {
+    glGenFramebuffers(1, &target.framebuffer);
+    glGenTextures(1, &target.texture);
+    if (pass == kSparse) {
+      glGenRenderbuffers(1, &target.depth_renderbuffer);
+    }
+  }
+
+  tango_gl::RenderState::BindTexture(GL_TEXTURE_2D, target.texture);
+  // Encoded depths must not be filtered, the guide is sampled between its
+  // pixels at the sparse texel centers.
+  const GLint filter = pass == kGuide ? GL_LINEAR : GL_NEAREST;
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA,
+               GL_UNSIGNED_BYTE, nullptr);
+  tango_gl::MemoryTracker::Track(
+      tango_gl::MemoryTracker::kTexture, target.texture,
+      "BilateralDepthUpsampler",
+      tango_gl::MemoryTracker::GetTextureSize(width, height, GL_RGBA,
+                                              GL_UNSIGNED_BYTE));
+
+  glBindFramebuffer(GL_FRAMEBUFFER, target.framebuffer);
+  glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
+                         target.texture, 0);
+  if (target.depth_renderbuffer != 0) {
+    glBindRenderbuffer(GL_RENDERBUFFER, target.depth_renderbuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT16, width,
+                          height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    tango_gl::MemoryTracker::Track(
+        tango_gl::MemoryTracker::kRenderbuffer, target.depth_renderbuffer,
+        "BilateralDepthUpsampler",
+        static_cast<size_t>(width) * height * sizeof(GLushort));
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
+                              GL_RENDERBUFFER, target.depth_renderbuffer);
+  }
+  const GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  if (status != GL_FRAMEBUFFER_COMPLETE) {
+    LOGE("BilateralDepthUpsampler: framebuffer %dx%d incomplete (0x%x).",
+         width, height, status);
+    return false;
+  }
+  target.width = width;
+  target.height = height;
+  return true;
+}
+
+bool BilateralDepthUpsampler::AcquirePrograms(GLenum color_texture_target) {
+  if (program_radius_ == radius_ &&
+      program_color_target_ == color_texture_target) {
+    return true;
+  }
+  ReleasePrograms();
+  if (!AcquireProgram(kGuide, kGuideVertexShader,
+                      GetGuideFragmentShader(color_texture_target)) ||
+      !AcquireProgram(kSparse, kSplatVertexShader, kSplatFragmentShader) ||
+      !AcquireProgram(kHorizontal, kFilterVertexShader,
+                      GetFilterFragmentShader(kHorizontalFragmentShader,
+                                              radius_)) ||
+      !AcquireProgram(kVertical, kFilterVertexShader,
+                      GetFilterFragmentShader(kVerticalFragmentShader,
+                                              radius_))) {
+    ReleasePrograms();
+    return false;
+  }
+  program_radius_ = radius_;
+  program_color_target_ = color_texture_target;
+  return true;
+}
+
+bool BilateralDepthUpsampler::AcquireProgram(
+    Pass pass, const std::string& vertex_shader,
+    const std::string& fragment_shader) {
+  Program& program = programs_[pass];
+  program.program = tango_gl::program_cache::AcquireProgram(
+      vertex_shader.c_str(), fragment_shader.c_str());
+  if (!program.program) {
+    LOGE("BilateralDepthUpsampler: could not create program of pass %d.",
+         pass);
+    return false;
+  }
+  const GLuint id = program.program;
+  program.attrib_vertices = glGetAttribLocation(id, "vertex");
+  program.attrib_texture_coords = glGetAttribLocation(id, "textureCoords");
+  program.uniform_mvp = glGetUniformLocation(id, "mvp");
+  program.uniform_color_T_depth = glGetUniformLocation(id, "color_T_depth");
+  program.uniform_color_texture = glGetUniformLocation(id, "colorTexture");
+  program.uniform_depth_image = glGetUniformLocation(id, "depth_image");
+  program.uniform_guide = glGetUniformLocation(id, "guide");
+  program.uniform_sparse_size = glGetUniformLocation(id, "sparse_size");
+  program.uniform_spatial_scale = glGetUniformLocation(id, "spatial_scale");
+  program.uniform_range_scale = glGetUniformLocation(id, "range_scale");
+  return true;
+}
+
+void BilateralDepthUpsampler::ReleasePrograms() {
+  for (Program& program : programs_) {
+    tango_gl::program_cache::ReleaseProgram(program.program);
+    program = Program();
+  }
+  program_radius_ = 0;
+}
+
+void BilateralDepthUpsampler::BeginPass(Pass pass) {
+  const Target& target = targets_[pass];
+  // The splats leave gaps, the sparse target starts cleared to no depth.
+  // The filter passes cover their whole target.
+  tango_gl::RenderPass::Options options;
+  if (pass != kSparse) {
+    options.color_load = tango_gl::RenderPass::kDontCare;
+    options.depth_load = tango_gl::RenderPass::kDontCare;
+  }
+  tango_gl::RenderPass::Begin(target.framebuffer, target.width, target.height,
+                              options);
+  tango_gl::RenderState::UseProgram(programs_[pass].program);
+}
+
+void BilateralDepthUpsampler::DrawQuad(GLint attrib_vertices) {
+  if (quad_buffer_.GetSize() == 0) {
+    quad_buffer_.Update(kQuadVertices, sizeof(kQuadVertices), 0);
+  }
+  quad_buffer_.Bind();
+  glEnableVertexAttribArray(attrib_vertices);
+  glVertexAttribPointer(attrib_vertices, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
+  tango_gl::Counters::Increment(tango_gl::Counters::kDrawCalls);
+  glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+  glDisableVertexAttribArray(attrib_vertices);
+}
+
+}  // namespace rgb_depth_sync
@@ -14,65 +14,42 @@
  * limitations under the License.
  */
 
-#include <rgb-depth-sync/camera_texture_drawable.h>
-
-namespace {
-const GLfloat kVertices[] = {-1.0, 1.0, 0.0, -1.0, -1.0, 0.0,
-                             1.0,  1.0, 0.0, 1.0,  -1.0, 0.0};
+#include <tango-gl/program_cache.h>
+#include <tango-gl/render_state.h>
 
-const GLushort kIndices[] = {0, 1, 2, 2, 1, 3};
-
-const GLfloat kTextureCoords[] = {0.0, 0.0, 0.0, 1.0, 1.0, 0.0, 1.0, 1.0};
-}  // namespace
+#include <rgb-depth-sync/camera_texture_drawable.h>
 
 namespace rgb_depth_sync {
 
-CameraTextureDrawable::CameraTextureDrawable() : shader_program_(0) {}
+CameraTextureDrawable::CameraTextureDrawable()
+    : color_texture_target_(GL_TEXTURE_EXTERNAL_OES),
+      shader_program_(0),
+      program_target_(GL_TEXTURE_EXTERNAL_OES) {}
 
 CameraTextureDrawable::~CameraTextureDrawable() {}
 
 void CameraTextureDrawable::InitializeGL() {
-  shader_program_ =
-      tango_gl::util::CreateProgram(rgb_depth_sync::shader::kColorCameraVert,
-                                    rgb_depth_sync::shader::kColorCameraFrag);
+  // The buffers of a previous context died with it.
+  mesh_.Invalidate();
+  AcquireProgram();
+}
+
+void CameraTextureDrawable::AcquireProgram() {
+  // A program from a previous context died with it, the cache ignores it.
+  tango_gl::program_cache::ReleaseProgram(shader_program_);
+  shader_program_ = tango_gl::program_cache::AcquireProgram(
+      rgb_depth_sync::shader::kColorCameraVert,
+      color_texture_target_ == GL_TEXTURE_2D
+          ? rgb_depth_sync::shader::kColorFrameFrag
+          : rgb_depth_sync::shader::kColorCameraFrag);
+  program_target_ = color_texture_target_;
   if (!shader_program_) {
     LOGE("Could not create shader program for CameraImageDrawable.");
   }
 
-  glGenBuffers(3, render_buffers_);
-  // Allocate vertices buffer.
-  glBindBuffer(GL_ARRAY_BUFFER, render_buffers_[0]);
-  glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * 3 * 4, kVertices,
-               GL_STATIC_DRAW);
-  glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-  // Allocate triangle indices buffer.
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, render_buffers_[1]);
-  glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(GLushort) * 6, kIndices,
-               GL_STATIC_DRAW);
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-
-  // Allocate texture coordinates buufer.
-  glBindBuffer(GL_ARRAY_BUFFER, render_buffers_[2]);
-  glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * 2 * 4, kTextureCoords,
-               GL_STATIC_DRAW);
-  glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-  // Assign the vertices attribute data.
   attrib_vertices_ = glGetAttribLocation(shader_program_, "vertex");
-  glBindBuffer(GL_ARRAY_BUFFER, render_buffers_[0]);
-  glEnableVertexAttribArray(attrib_vertices_);
-  glVertexAttribPointer(attrib_vertices_, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
-  glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-  // Assign the texture coordinates attribute data.
   attrib_texture_coords_ =
       glGetAttribLocation(shader_program_, "textureCoords");
-  glBindBuffer(GL_ARRAY_BUFFER, render_buffers_[2]);
-  glEnableVertexAttribArray(attrib_texture_coords_);
-  glVertexAttribPointer(attrib_texture_coords_, 2, GL_FLOAT, GL_FALSE, 0,
-                        nullptr);
-  glBindBuffer(GL_ARRAY_BUFFER, 0);
 
   color_texture_handle_ = glGetUniformLocation(shader_program_, "colorTexture");
   depth_texture_handle_ = glGetUniformLocation(shader_program_, "depthTexture");
@@ -82,11 +59,13 @@ void CameraTextureDrawable::InitializeGL() {
 void CameraTextureDrawable::RenderImage() {
   if (shader_program_ == 0) {
     InitializeGL();
+  } else if (program_target_ != color_texture_target_) {
+    AcquireProgram();
   }
 
-  glDisable(GL_DEPTH_TEST);
+  tango_gl::RenderState::Disable(GL_DEPTH_TEST);
 
-  glUseProgram(shader_program_);
+  tango_gl::RenderState::UseProgram(shader_program_);
 
   glUniform1f(blend_alpha_handle_, blend_alpha_);
 
@@ -95,36 +74,20 @@ void CameraTextureDrawable::RenderImage() {
   // not getting any handle from shader neither binding any texture here.
   // Once this is fix, we will need to bind the texture to the correct sampler2D
   // handle.
-  glActiveTexture(GL_TEXTURE0);
-  glBindTexture(GL_TEXTURE_EXTERNAL_OES, color_texture_id_);
+  tango_gl::RenderState::ActiveTexture(GL_TEXTURE0);
+  tango_gl::RenderState::BindTexture(color_texture_target_,
+                                     color_texture_id_);
   glUniform1i(color_texture_handle_, 0);
 
   // Bind depth texture to texture unit 1.
-  glActiveTexture(GL_TEXTURE1);
-  glBindTexture(GL_TEXTURE_2D, depth_texture_id_);
+  tango_gl::RenderState::ActiveTexture(GL_TEXTURE1);
+  tango_gl::RenderState::BindTexture(GL_TEXTURE_2D, depth_texture_id_);
   glUniform1i(depth_texture_handle_, 1);
 
-  // Bind vertices buffer.
-  glBindBuffer(GL_ARRAY_BUFFER, render_buffers_[0]);
-  glEnableVertexAttribArray(attrib_vertices_);
-  glVertexAttribPointer(attrib_vertices_, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
-  glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-  // Bind texture coordinates buffer.
-  glBindBuffer(GL_ARRAY_BUFFER, render_buffers_[2]);
-  glEnableVertexAttribArray(attrib_texture_coords_);
-  glVertexAttribPointer(attrib_texture_coords_, 2, GL_FLOAT, GL_FALSE, 0,
-                        nullptr);
-  glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-  // Bind element array buffer.
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, render_buffers_[1]);
-  glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, 0);
-  tango_gl::util::CheckGlError("ColorCameraDrawable glDrawElements");
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-
-  glUseProgram(0);
-  glActiveTexture(GL_TEXTURE0);
+  mesh_.Draw(attrib_vertices_, attrib_texture_coords_);
+
+  // The Tango C-API binds the color texture to the active unit.
+  tango_gl::RenderState::ActiveTexture(GL_TEXTURE0);
   tango_gl::util::CheckGlError("CameraTextureDrawable::render");
 }
 
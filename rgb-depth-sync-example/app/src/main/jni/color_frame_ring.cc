@@ -0,0 +1,237 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <cmath>
+
+#include <tango-gl/counters.h>
+#include <tango-gl/memory_tracker.h>
+#include <tango-gl/program_cache.h>
+#include <tango-gl/render_pass.h>
+#include <tango-gl/render_state.h>
+
+#include "rgb-depth-sync/color_frame_ring.h"
+
+namespace {
+// Full screen quad as a triangle strip, in normalized device coordinates.
+const GLfloat kQuadVertices[] = {-1.0f, -1.0f, 1.0f, -1.0f,
+                                 -1.0f, 1.0f,  1.0f, 1.0f};
+
+// Texel (u, v) of the copy is texel (u, v) of the camera texture.
+const char kCopyVertexShader[] =
+    "precision highp float;\n"
+    "attribute vec2 vertex;\n"
+    "varying vec2 f_textureCoords;\n"
+    "void main() {\n"
+    "  f_textureCoords = vertex * 0.5 + 0.5;\n"
+    "  gl_Position = vec4(vertex, 0.0, 1.0);\n"
+    "}\n";
+const char kCopyFragmentShader[] =
+    "#extension GL_OES_EGL_image_external : require\n"
+    "precision mediump float;\n"
+    "uniform samplerExternalOES cameraTexture;\n"
+    "varying vec2 f_textureCoords;\n"
+    "void main() {\n"
+    "  gl_FragColor = texture2D(cameraTexture, f_textureCoords);\n"
+    "}\n";
+}  // namespace
+
+namespace rgb_depth_sync {
+
+ColorFrameRing::ColorFrameRing(size_t capacity)
+    : frames_(capacity > 0 ? capacity : 1),
+      first_(0),
+      count_(0),
+      width_(0),
+      height_(0),
+      quad_buffer_(GL_ARRAY_BUFFER, GL_STATIC_DRAW) {
+  InitializeGL();
+}
+
+ColorFrameRing::~ColorFrameRing() { Release(); }
+
+void ColorFrameRing::InitializeGL() {
+  for (Frame& frame : frames_) {
+    frame = Frame();
+  }
+  Clear();
+  framebuffer_ = 0;
+  program_ = 0;
+  attrib_vertices_ = -1;
+  uniform_camera_texture_ = -1;
+  quad_buffer_.Invalidate();
+}
+
+void ColorFrameRing::Release() {
+  for (Frame& frame : frames_) {
+    if (frame.texture != 0) {
+      tango_gl::RenderState::DeleteTextures(1, &frame.texture);
+    }
+  }
+  if (framebuffer_ != 0) {
+    glDeleteFramebuffers(1, &framebuffer_);
+  }
+  tango_gl::program_cache::ReleaseProgram(program_);
+  quad_buffer_.Release();
+  InitializeGL();
+}
+
+void ColorFrameRing::Clear() {
+  first_ = 0;
+  count_ = 0;
+}
+
+void ColorFrameRing::SetImageSize(GLsizei width, GLsizei height) {
+  if (width == width_ && height == height_) {
+    return;
+  }
+  width_ = width;
+  height_ = height;
+  Clear();
+}
+
+bool ColorFrameRing::Push(GLuint camera_texture, double timestamp) {
+  if (width_ <= 0 || height_ <= 0 || camera_texture == 0) {
+    return false;
+  }
+  if (count_ > 0) {
+    const double latest = frames_[Index(count_ - 1)].timestamp;
+    if (timestamp == latest) {
+      return false;
+    }
+    if (timestamp < latest) {
+      Clear();
+    }
+  }
+  if (!AcquireProgram()) {
+    return false;
+  }
+
+  Frame* frame;
+  if (count_ < frames_.size()) {
+    frame = &frames_[Index(count_)];
+    ++count_;
+  } else {
+    frame = &frames_[first_];
+    first_ = Index(1);
+  }
+  Allocate(frame);
+  frame->timestamp = timestamp;
+
+  if (framebuffer_ == 0) {
+    glGenFramebuffers(1, &framebuffer_);
+  }
+  glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_);
+  glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
+                         frame->texture, 0);
+  // The quad covers the frame, its previous content is never loaded.
+  tango_gl::RenderPass::Options pass;
+  pass.color_load = tango_gl::RenderPass::kDontCare;
+  pass.depth_load = tango_gl::RenderPass::kDontCare;
+  tango_gl::RenderPass::Begin(framebuffer_, width_, height_, pass);
+  tango_gl::RenderState::Disable(GL_BLEND);
+  tango_gl::RenderState::Disable(GL_DEPTH_TEST);
+  tango_gl::RenderState::UseProgram(program_);
+  // The Tango C-API binds the color texture to the active unit, unit 0.
+  tango_gl::RenderState::ActiveTexture(GL_TEXTURE0);
+  tango_gl::RenderState::BindTexture(GL_TEXTURE_EXTERNAL_OES, camera_texture);
+  glUniform1i(uniform_camera_texture_, 0);
+
+  if (quad_buffer_.GetSize() == 0) {
+    quad_buffer_.Update(kQuadVertices, sizeof(kQuadVertices), 0);
+  }
+  quad_buffer_.Bind();
+  glEnableVertexAttribArray(attrib_vertices_);
+  glVertexAttribPointer(attrib_vertices_, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
+  tango_gl::Counters::Increment(tango_gl::Counters::kDrawCalls);
+  glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+  glDisableVertexAttribArray(attrib_vertices_);
+
+  tango_gl::RenderPass::End();
+  tango_gl::util::CheckGlError("ColorFrameRing::Push");
+  return true;
+}
+
+bool ColorFrameRing::GetNearestFrame(double timestamp, GLuint* texture,
+                                     double* frame_timestamp) const {
+  if (count_ == 0) {
+    return false;
+  }
+
+  // Binary search for the first frame not older than the timestamp, then
+  // pick it or the one before it, whichever is closer.
+  size_t low = 0;
+  size_t high = count_ - 1;
+  while (low < high) {
+    size_t middle = (low + high) / 2;
+    if (frames_[Index(middle)].timestamp < timestamp) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+  const Frame* nearest = &frames_[Index(low)];
+  if (low > 0) {
+    const Frame& before = frames_[Index(low - 1)];
+    if (std::fabs(before.timestamp - timestamp) <
+        std::fabs(nearest->timestamp - timestamp)) {
+      nearest = &before;
+    }
+  }
+  *texture = nearest->texture;
+  *frame_timestamp = nearest->timestamp;
+  return true;
+}
+
+void ColorFrameRing::Allocate(Frame* frame) {
+  if (frame->texture != 0 && frame->width == width_ &&
+      frame->height == height_) {
+    return;
+  }
+  if (frame->texture == 0) {
+    glGenTextures(1, &frame->texture);
+  }
+  tango_gl::RenderState::BindTexture(GL_TEXTURE_2D, frame->texture);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width_, height_, 0, GL_RGBA,
+               GL_UNSIGNED_BYTE, nullptr);
+  tango_gl::MemoryTracker::Track(
+      tango_gl::MemoryTracker::kTexture, frame->texture, "ColorFrameRing",
+      tango_gl::MemoryTracker::GetTextureSize(width_, height_, GL_RGBA,
+                                              GL_UNSIGNED_BYTE));
+  frame->width = width_;
+  frame->height = height_;
+}
+
+bool ColorFrameRing::AcquireProgram() {
+  if (program_ != 0) {
+    return true;
+  }
+  program_ = tango_gl::program_cache::AcquireProgram(kCopyVertexShader,
+                                                     kCopyFragmentShader);
+  if (!program_) {
+    LOGE("ColorFrameRing: could not create the copy program.");
+    return false;
+  }
+  attrib_vertices_ = glGetAttribLocation(program_, "vertex");
+  uniform_camera_texture_ = glGetUniformLocation(program_, "cameraTexture");
+  return true;
+}
+
+}  // namespace rgb_depth_sync
@@ -14,6 +14,8 @@
  * limitations under the License.
  */
 
+#include <tango-gl/render_state.h>
+
 #include "rgb-depth-sync/color_image.h"
 
 namespace rgb_depth_sync {
@@ -22,10 +24,10 @@ ColorImage::ColorImage() : texture_id_(0) {}
 
 void ColorImage::InitializeGL() {
   glGenTextures(1, &texture_id_);
-  glBindTexture(GL_TEXTURE_EXTERNAL_OES, texture_id_);
+  tango_gl::RenderState::BindTexture(GL_TEXTURE_EXTERNAL_OES, texture_id_);
   glTexParameteri(GL_TEXTURE_EXTERNAL_OES, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
   glTexParameteri(GL_TEXTURE_EXTERNAL_OES, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-  glBindTexture(GL_TEXTURE_EXTERNAL_OES, 0);
+  tango_gl::RenderState::BindTexture(GL_TEXTURE_EXTERNAL_OES, 0);
 }
 
 ColorImage::~ColorImage() {}
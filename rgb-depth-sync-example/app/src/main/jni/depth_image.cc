@@ -14,28 +14,42 @@
  * limitations under the License.
  */
 
+#include <algorithm>
+#include <cmath>
+
 #include "tango-gl/conversions.h"
-#include "tango-gl/camera.h"
+#include "tango-gl/counters.h"
+#include "tango-gl/depth_pipeline.h"
+#include "tango-gl/memory_tracker.h"
+#include "tango-gl/program_cache.h"
+#include "tango-gl/render_pass.h"
+#include "tango-gl/render_state.h"
 
 #include "rgb-depth-sync/depth_image.h"
 
 namespace {
+// Blue and alpha carry the depth in millimeters as a 16 bit integer, low
+// byte first, the layout of the CPU depth texture. The encoding is done in
+// the vertex shader where highp is guaranteed.
 const std::string kPointCloudVertexShader =
-    "precision mediump float;\n"
+    "precision highp float;\n"
     "\n"
     "attribute vec4 vertex;\n"
     "\n"
     "uniform mat4 mvp;\n"
-    "uniform float maxdepth;\n"
+    "uniform mat4 color_T_depth;\n"
     "uniform float pointsize;\n"
     "\n"
-    "varying vec4 v_color;\n"
+    "varying mediump vec4 v_color;\n"
     "\n"
     "void main() {\n"
     "  gl_PointSize = pointsize;\n"
     "  gl_Position = mvp*vertex;\n"
-    "  float depth = clamp(vertex.z / maxdepth, 0.0, 1.0);\n"
-    "  v_color = vec4(depth, depth, depth, 1.0);\n"
+    "  float z = (color_T_depth * vertex).z;\n"
+    "  float millimeters = floor(clamp(z * 1000.0, 0.0, 65535.0) + 0.5);\n"
+    "  float high = floor(millimeters / 256.0);\n"
+    "  float low = millimeters - high * 256.0;\n"
+    "  v_color = vec4(0.0, 0.0, low / 255.0, high / 255.0);\n"
     "}\n";
 const std::string kPointCloudFragmentShader =
     "precision mediump float;\n"
@@ -44,69 +58,90 @@ const std::string kPointCloudFragmentShader =
     "void main() {\n"
     "  gl_FragColor = v_color;\n"
     "}\n";
+
+// Depth points are at least this far from the camera, in meters.
+const float kMinPointDepth = 0.5f;
+
+// Points located by the ij index grid are splatted as they are while the
+// depth to color transform moves them by less than this, in pixels.
+const float kMaxImagePointShift = 1.0f;
+
+// Bound the pixel shift a transform causes to points at kMinPointDepth or
+// farther, for a camera with the given focal length in pixels. Uses the small
+// angle approximation, the transforms of interest are close to identity.
+float GetMaxPixelShift(const glm::mat4& transform, float focal_length) {
+  const float trace = transform[0][0] + transform[1][1] + transform[2][2];
+  const float angle =
+      std::acos(std::max(-1.0f, std::min(1.0f, (trace - 1.0f) * 0.5f)));
+  const float translation = glm::length(glm::vec3(transform[3]));
+  return focal_length * (angle + translation / kMinPointDepth);
+}
 }  // namespace
 
 namespace rgb_depth_sync {
 
 DepthImage::DepthImage()
     : texture_id_(0),
-      cpu_texture_id_(0),
       gpu_texture_id_(0),
       depth_map_buffer_(0),
-      grayscale_display_buffer_(0),
+      current_stamp_(0),
+      fill_holes_(false),
+      window_size_(kDefaultWindowSize),
       texture_render_program_(0),
       fbo_handle_(0),
+      depth_renderbuffer_handle_(0),
       vertex_buffer_handle_(0),
       vertices_handle_(0),
-      mvp_handle_(0) {}
+      mvp_handle_(0),
+      color_T_depth_handle_(0),
+      point_size_handle_(0),
+      is_depth_readback_on_(false) {}
 
 DepthImage::~DepthImage() {}
 
 void DepthImage::InitializeGL() {
   texture_id_ = 0;
-  cpu_texture_id_ = 0;
+  cpu_texture_.Invalidate();
   gpu_texture_id_ = 0;
 
   texture_render_program_ = 0;
   fbo_handle_ = 0;
+  depth_renderbuffer_handle_ = 0;
   vertex_buffer_handle_ = 0;
   vertices_handle_ = 0;
   mvp_handle_ = 0;
+  color_T_depth_handle_ = 0;
+  point_size_handle_ = 0;
+  depth_readback_.Invalidate();
+  bilateral_upsampler_.InitializeGL();
 }
 
-bool DepthImage::CreateOrBindGPUTexture() {
+bool DepthImage::CreateGPUTexture() {
   if (gpu_texture_id_) {
-    glBindFramebuffer(GL_FRAMEBUFFER, fbo_handle_);
     return false;
   } else {
     glGenTextures(1, &gpu_texture_id_);
-    texture_render_program_ = tango_gl::util::CreateProgram(
+    texture_render_program_ = tango_gl::program_cache::AcquireProgram(
         kPointCloudVertexShader.c_str(), kPointCloudFragmentShader.c_str());
 
     mvp_handle_ = glGetUniformLocation(texture_render_program_, "mvp");
-
-    glUseProgram(texture_render_program_);
-    // Assume these are constant for the life the program
-    GLuint max_depth_handle =
-        glGetUniformLocation(texture_render_program_, "maxdepth");
-    GLuint point_size_handle =
+    color_T_depth_handle_ =
+        glGetUniformLocation(texture_render_program_, "color_T_depth");
+    point_size_handle_ =
         glGetUniformLocation(texture_render_program_, "pointsize");
-    glUniform1f(max_depth_handle,
-                static_cast<float>(kMaxDepthDistance) / kMeterToMillimeter);
-    glUniform1f(point_size_handle, 2 * kWindowSize + 1);
 
     vertices_handle_ = glGetAttribLocation(texture_render_program_, "vertex");
 
     glGenBuffers(1, &vertex_buffer_handle_);
 
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, gpu_texture_id_);
+    tango_gl::RenderState::ActiveTexture(GL_TEXTURE0);
+    tango_gl::RenderState::BindTexture(GL_TEXTURE_2D, gpu_texture_id_);
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, rgb_camera_intrinsics_.width,
                  rgb_camera_intrinsics_.height, 0, GL_RGBA, GL_UNSIGNED_BYTE,
                  nullptr);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glBindTexture(GL_TEXTURE_2D, 0);
+    tango_gl::RenderState::BindTexture(GL_TEXTURE_2D, 0);
 
     glGenFramebuffers(1, &fbo_handle_);
     glBindFramebuffer(GL_FRAMEBUFFER, fbo_handle_);
@@ -114,48 +149,61 @@ bool DepthImage::CreateOrBindGPUTexture() {
                            GL_TEXTURE_2D,
                            gpu_texture_id_, 0);
 
-    return true;
-  }
-}
+    // The depth attachment makes overlapping splats keep the nearest point.
+    glGenRenderbuffers(1, &depth_renderbuffer_handle_);
+    glBindRenderbuffer(GL_RENDERBUFFER, depth_renderbuffer_handle_);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT16,
+                          rgb_camera_intrinsics_.width,
+                          rgb_camera_intrinsics_.height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
+                              GL_RENDERBUFFER, depth_renderbuffer_handle_);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+      LOGE("DepthImage: Incomplete depth framebuffer.");
+    }
+    tango_gl::MemoryTracker::Track(
+        tango_gl::MemoryTracker::kTexture, gpu_texture_id_, "DepthImage",
+        tango_gl::MemoryTracker::GetTextureSize(
+            rgb_camera_intrinsics_.width, rgb_camera_intrinsics_.height,
+            GL_RGBA, GL_UNSIGNED_BYTE));
+    tango_gl::MemoryTracker::Track(
+        tango_gl::MemoryTracker::kRenderbuffer, depth_renderbuffer_handle_,
+        "DepthImage", static_cast<size_t>(rgb_camera_intrinsics_.width) *
+                          rgb_camera_intrinsics_.height * sizeof(GLushort));
 
-bool DepthImage::CreateOrBindCPUTexture() {
-  if (cpu_texture_id_) {
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, cpu_texture_id_);
-    return false;
-  } else {
-    glGenTextures(1, &cpu_texture_id_);
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, cpu_texture_id_);
-    glTexImage2D(GL_TEXTURE_2D, 0,  // mip-map level
-                 GL_LUMINANCE, rgb_camera_intrinsics_.width,
-                 rgb_camera_intrinsics_.height, 0,  // border
-                 GL_LUMINANCE, GL_UNSIGNED_BYTE, nullptr);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
     return true;
   }
 }
 
 void DepthImage::RenderDepthToTexture(
     glm::mat4& color_t1_T_depth_t0,
-    const std::vector<float>& render_point_cloud_buffer, bool new_points) {
-  new_points = this->CreateOrBindGPUTexture() || new_points;
+    const std::vector<float>& render_point_cloud_buffer, bool new_points,
+    double color_timestamp) {
+  new_points = this->CreateGPUTexture() || new_points;
 
-  glViewport(0, 0, rgb_camera_intrinsics_.width, rgb_camera_intrinsics_.height);
-  glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
-  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+  // The depth attachment only resolves the splats of this pass, it is never
+  // written back.
+  tango_gl::RenderPass::Options pass;
+  pass.depth_store = tango_gl::RenderPass::kDiscard;
+  tango_gl::RenderPass::Begin(fbo_handle_, rgb_camera_intrinsics_.width,
+                              rgb_camera_intrinsics_.height, pass);
 
   // Special program needed to color by z-distance
-  glUseProgram(texture_render_program_);
+  tango_gl::RenderState::UseProgram(texture_render_program_);
 
-  glDisable(GL_BLEND);
-  glEnable(GL_DEPTH_TEST);
+  tango_gl::RenderState::Disable(GL_BLEND);
+  tango_gl::RenderState::Enable(GL_DEPTH_TEST);
 
-  glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer_handle_);
+  tango_gl::RenderState::BindBuffer(GL_ARRAY_BUFFER, vertex_buffer_handle_);
   if(new_points) {
     glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * render_point_cloud_buffer.size(),
                  render_point_cloud_buffer.data(), GL_STATIC_DRAW);
+    tango_gl::Counters::Add(
+        tango_gl::Counters::kBufferBytes,
+        sizeof(GLfloat) * render_point_cloud_buffer.size());
+    tango_gl::MemoryTracker::Track(
+        tango_gl::MemoryTracker::kBuffer, vertex_buffer_handle_, "DepthImage",
+        sizeof(GLfloat) * render_point_cloud_buffer.size());
   }
   tango_gl::util::CheckGlError("DepthImage Buffer");
 
@@ -170,24 +218,55 @@ void DepthImage::RenderDepthToTexture(
   glm::mat4 mvp_mat = projection_matrix_ar_ * opengl_T_color * color_t1_T_depth_t0;
 
   glUniformMatrix4fv(mvp_handle_, 1, GL_FALSE, glm::value_ptr(mvp_mat));
+  glUniformMatrix4fv(color_T_depth_handle_, 1, GL_FALSE,
+                     glm::value_ptr(color_t1_T_depth_t0));
+  glUniform1f(point_size_handle_, 2 * window_size_ + 1);
 
   glEnableVertexAttribArray(vertices_handle_);
   glVertexAttribPointer(vertices_handle_, 3, GL_FLOAT, GL_FALSE, 0,  nullptr);
 
+  tango_gl::Counters::Increment(tango_gl::Counters::kDrawCalls);
   glDrawArrays(GL_POINTS, 0, render_point_cloud_buffer.size() / 3);
   glDisableVertexAttribArray(vertices_handle_);
 
   tango_gl::util::CheckGlError("DepthImage Draw");
 
-  glBindBuffer(GL_ARRAY_BUFFER, 0);
-  glBindFramebuffer(GL_FRAMEBUFFER, 0);
-  glUseProgram(0);
+  if (is_depth_readback_on_) {
+    depth_readback_.Allocate(rgb_camera_intrinsics_.width,
+                             rgb_camera_intrinsics_.height);
+    depth_readback_.Read(color_timestamp);
+  }
+
+  tango_gl::RenderPass::End();
 
   tango_gl::util::CheckGlError("DepthImage RenderTexture");
 
   texture_id_ = gpu_texture_id_;
 }
 
+void DepthImage::SetDepthReadback(bool enabled) {
+  is_depth_readback_on_ = enabled;
+}
+
+bool DepthImage::GetRegisteredDepth(double* color_timestamp,
+                                    std::vector<float>* depth_map) {
+  // Decode straight from the mapped read, the pixels are not copied.
+  // Rows come bottom row first, which is the top row of the color image
+  // since the render pass keeps the Y-axis of the camera.
+  const size_t pixel_count =
+      static_cast<size_t>(depth_readback_.GetWidth()) *
+      depth_readback_.GetHeight();
+  return depth_readback_.GetPixels([color_timestamp, depth_map, pixel_count](
+             double timestamp, const uint8_t* pixel) {
+    *color_timestamp = timestamp;
+    depth_map->resize(pixel_count);
+    for (size_t i = 0; i < pixel_count; ++i, pixel += 4) {
+      (*depth_map)[i] =
+          static_cast<float>(pixel[2] | (pixel[3] << 8)) / kMeterToMillimeter;
+    }
+  }) > 0;
+}
+
 // Update function will be called in application's main render loop. This funct-
 // ion takes care of projecting raw depth points on the image plane, and render
 // the depth image into a texture.
@@ -201,95 +280,172 @@ void DepthImage::RenderDepthToTexture(
 void DepthImage::UpdateAndUpsampleDepth(
     glm::mat4& color_t1_T_depth_t0,
     const std::vector<float>& render_point_cloud_buffer) {
+  UpdateAndUpsampleDepth(color_t1_T_depth_t0, render_point_cloud_buffer,
+                         std::vector<float>());
+}
+
+void DepthImage::UpdateAndUpsampleDepth(
+    glm::mat4& color_t1_T_depth_t0,
+    const std::vector<float>& render_point_cloud_buffer,
+    const std::vector<float>& image_points) {
   int depth_image_width = rgb_camera_intrinsics_.width;
   int depth_image_height = rgb_camera_intrinsics_.height;
-  int depth_image_size = depth_image_width * depth_image_height;
-
-  depth_map_buffer_.resize(depth_image_size);
-  grayscale_display_buffer_.resize(depth_image_size);
-  std::fill(depth_map_buffer_.begin(), depth_map_buffer_.end(), 0);
-  std::fill(grayscale_display_buffer_.begin(), grayscale_display_buffer_.end(),
-            0);
-
-  int point_cloud_size = render_point_cloud_buffer.size();
-  for (int i = 0; i < point_cloud_size; i += 3) {
-    float x = render_point_cloud_buffer[i];
-    float y = render_point_cloud_buffer[i + 1];
-    float z = render_point_cloud_buffer[i + 2];
-
-    // depth_t0_point is the point in depth camera frame on timestamp t0.
-    // (depth image timestamp).
-    glm::vec4 depth_t0_point = glm::vec4(x, y, z, 1.0);
-
-    // color_t1_point is the point in camera frame on timestamp t1.
-    // (color image timestamp).
-    glm::vec4 color_t1_point = color_t1_T_depth_t0 * depth_t0_point;
-
-    int pixel_x, pixel_y;
-    // get the coordinate on image plane.
-    pixel_x = static_cast<int>((rgb_camera_intrinsics_.fx) *
-                                   (color_t1_point.x / color_t1_point.z) +
-                               rgb_camera_intrinsics_.cx);
-
-    pixel_y = static_cast<int>((rgb_camera_intrinsics_.fy) *
-                                   (color_t1_point.y / color_t1_point.z) +
-                               rgb_camera_intrinsics_.cy);
-
-    // Color value is the GL_LUMINANCE value used for displaying the depth
-    // image.
-    // We can query for depth value in mm from grayscale image buffer by
-    // getting a `pixel_value` at (pixel_x,pixel_y) and calculating
-    // pixel_value * (kMaxDepthDistance / USHRT_MAX)
-    float depth_value = color_t1_point.z;
-    uint8_t grayscale_value =
-        (color_t1_point.z * kMeterToMillimeter) * UCHAR_MAX / kMaxDepthDistance;
-
-    UpSampleDepthAroundPoint(grayscale_value, depth_value, pixel_x, pixel_y,
-                             &grayscale_display_buffer_, &depth_map_buffer_);
+  size_t depth_image_size = depth_image_width * depth_image_height;
+
+  // The buffers are only cleared when the image size changes, pixels not
+  // written this frame are told apart by their stamp instead.
+  if (depth_stamp_buffer_.size() != depth_image_size) {
+    depth_map_buffer_.resize(depth_image_size);
+    depth_stamp_buffer_.assign(depth_image_size, 0);
+    current_stamp_ = 0;
   }
+  // Two stamps per frame, one for splatted and one for hole filled pixels.
+  current_stamp_ += 2;
+  if (current_stamp_ < 2) {
+    // The counter wrapped around, old stamps could match again.
+    std::fill(depth_stamp_buffer_.begin(), depth_stamp_buffer_.end(), 0);
+    current_stamp_ = 2;
+  }
+
+  // Splats into the buffers in place, the nearest point of the frame
+  // winning in each pixel.
+  tango_gl::depth_pipeline::SplatDepth splat(
+      depth_map_buffer_.data(), depth_stamp_buffer_.data(), depth_image_width,
+      depth_image_height, window_size_, current_stamp_);
+  const float focal_length = static_cast<float>(
+      std::max(rgb_camera_intrinsics_.fx, rgb_camera_intrinsics_.fy));
+  if (!image_points.empty() &&
+      GetMaxPixelShift(color_t1_T_depth_t0, focal_length) <
+          kMaxImagePointShift) {
+    // The grid already located the points, splat them where they are.
+    for (size_t i = 0; i + 2 < image_points.size(); i += 3) {
+      const float depth = image_points[i + 2];
+      if (depth > 0.0f) {
+        splat.Splat(depth,
+                    static_cast<int>(image_points[i] * depth_image_width),
+                    static_cast<int>(image_points[i + 1] * depth_image_height));
+      }
+    }
+  } else {
+    // Move the points into the color camera frame on timestamp t1 (color
+    // image timestamp), project and splat them in a single pass.
+    tango_gl::depth_pipeline::Pipeline<tango_gl::depth_pipeline::Transform,
+                                       tango_gl::depth_pipeline::Project,
+                                       tango_gl::depth_pipeline::SplatDepth>
+        pipeline(tango_gl::depth_pipeline::Transform(color_t1_T_depth_t0),
+                 tango_gl::depth_pipeline::Project(projection_intrinsics_),
+                 splat);
+    pipeline.Run(render_point_cloud_buffer.data(),
+                 render_point_cloud_buffer.size() / 3);
+  }
+
+  ResolveDepthImage();
+  UploadDepthMap();
+
+  texture_id_ = cpu_texture_.GetTextureId();
+}
+
+void DepthImage::UpdateAndUpsampleDepthParallel(
+    const glm::mat4& color_t1_T_depth_t0,
+    const std::vector<float>& render_point_cloud_buffer) {
+  if (!tiled_depth_splatter_) {
+    tiled_depth_splatter_.reset(new TiledDepthSplatter());
+  }
+  tiled_depth_splatter_->Splat(
+      color_t1_T_depth_t0, render_point_cloud_buffer, projection_intrinsics_,
+      window_size_, &depth_map_buffer_);
+  UploadDepthMap();
+}
 
-  this->CreateOrBindCPUTexture();
-  glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, depth_image_width, depth_image_height,
-                  GL_LUMINANCE, GL_UNSIGNED_BYTE,
-                  grayscale_display_buffer_.data());
-  tango_gl::util::CheckGlError("DepthImage glTexSubImage2D");
-  glBindTexture(GL_TEXTURE_2D, 0);
+void DepthImage::UploadDepthMap() {
+  // Each little endian millimeter value is one luminance alpha texel, the
+  // low byte in luminance, which samples as blue, and the high byte in
+  // alpha.
+  cpu_texture_.Allocate(rgb_camera_intrinsics_.width,
+                        rgb_camera_intrinsics_.height, GL_LUMINANCE_ALPHA);
+  cpu_texture_.Update(depth_map_buffer_.data());
 
-  texture_id_ = cpu_texture_id_;
+  texture_id_ = cpu_texture_.GetTextureId();
 }
 
-void DepthImage::SetCameraIntrinsics(TangoCameraIntrinsics intrinsics) {
+void DepthImage::SetCameraIntrinsics(TangoCameraIntrinsics intrinsics,
+                                     const glm::mat4& projection_matrix_ar) {
   rgb_camera_intrinsics_ = intrinsics;
-  const float kNearClip = 0.1;
-  const float kFarClip = 10.0;
-  projection_matrix_ar_ = tango_gl::Camera::ProjectionMatrixForCameraIntrinsics(
-      intrinsics.width, intrinsics.height, intrinsics.fx, intrinsics.fy,
-      intrinsics.cx, intrinsics.cy, kNearClip, kFarClip);
+  projection_intrinsics_.width = intrinsics.width;
+  projection_intrinsics_.height = intrinsics.height;
+  projection_intrinsics_.fx = intrinsics.fx;
+  projection_intrinsics_.fy = intrinsics.fy;
+  projection_intrinsics_.cx = intrinsics.cx;
+  projection_intrinsics_.cy = intrinsics.cy;
+  projection_matrix_ar_ = projection_matrix_ar;
+  bilateral_upsampler_.SetCameraIntrinsics(intrinsics, projection_matrix_ar);
 }
 
-void DepthImage::UpSampleDepthAroundPoint(
-    uint8_t grayscale_value, float depth_value, int pixel_x, int pixel_y,
-    std::vector<uint8_t>* grayscale_buffer,
-    std::vector<float>* depth_map_buffer) {
-
-  int image_width = rgb_camera_intrinsics_.width;
-  int image_height = rgb_camera_intrinsics_.height;
-  int image_size = image_height * image_width;
-  // Set the neighbour pixels to same color.
-  for (int a = -kWindowSize; a <= kWindowSize; ++a) {
-    for (int b = -kWindowSize; b <= kWindowSize; ++b) {
-      if (pixel_x > image_width || pixel_y > image_height || pixel_x < 0 ||
-          pixel_y < 0) {
-        continue;
+void DepthImage::UpsampleDepthBilateral(
+    const glm::mat4& color_t1_T_depth_t0,
+    const std::vector<float>& render_point_cloud_buffer, bool new_points,
+    GLuint color_texture, GLenum color_texture_target) {
+  if (bilateral_upsampler_.Upsample(color_t1_T_depth_t0,
+                                    render_point_cloud_buffer, new_points,
+                                    color_texture, color_texture_target)) {
+    texture_id_ = bilateral_upsampler_.GetTextureId();
+  }
+}
+
+void DepthImage::SetBilateralQuality(float output_scale, int radius) {
+  bilateral_upsampler_.SetOutputScale(output_scale);
+  bilateral_upsampler_.SetRadius(radius);
+}
+
+bool DepthImage::FillHole(int pixel_x, int pixel_y) {
+  const int image_width = rgb_camera_intrinsics_.width;
+  const int image_height = rgb_camera_intrinsics_.height;
+  const int x0 = std::max(0, pixel_x - 1);
+  const int x1 = std::min(image_width - 1, pixel_x + 1);
+  const int y0 = std::max(0, pixel_y - 1);
+  const int y1 = std::min(image_height - 1, pixel_y + 1);
+
+  bool is_filled = false;
+  uint16_t depth_value = 0;
+  for (int y = y0; y <= y1; ++y) {
+    for (int x = x0; x <= x1; ++x) {
+      int neighbour = y * image_width + x;
+      // Only splatted pixels are used, so holes are not grown from pixels
+      // filled earlier in the same pass.
+      if (depth_stamp_buffer_[neighbour] == current_stamp_ &&
+          (!is_filled || depth_map_buffer_[neighbour] < depth_value)) {
+        depth_value = depth_map_buffer_[neighbour];
+        is_filled = true;
       }
-      int pixel_num = (pixel_x + a) + (pixel_y + b) * image_width;
+    }
+  }
 
-      if (pixel_num > 0 && pixel_num < image_size) {
-        (*grayscale_buffer)[pixel_num] = grayscale_value;
-        (*depth_map_buffer)[pixel_num] = depth_value;
+  if (is_filled) {
+    int pixel = pixel_y * image_width + pixel_x;
+    depth_map_buffer_[pixel] = depth_value;
+    depth_stamp_buffer_[pixel] = current_stamp_ + 1;
+  }
+  return is_filled;
+}
+
+void DepthImage::ResolveDepthImage() {
+  const int image_width = rgb_camera_intrinsics_.width;
+  const int image_height = rgb_camera_intrinsics_.height;
+  for (int y = 0; y < image_height; ++y) {
+    for (int x = 0; x < image_width; ++x) {
+      int pixel = y * image_width + x;
+      if (depth_stamp_buffer_[pixel] != current_stamp_ &&
+          !(fill_holes_ && FillHole(x, y))) {
+        depth_map_buffer_[pixel] = 0;
       }
     }
   }
 }
 
+void DepthImage::SetHoleFilling(bool enabled) { fill_holes_ = enabled; }
+
+void DepthImage::SetWindowSize(int window_size) {
+  window_size_ = std::max(0, window_size);
+}
+
 }  // namespace rgb_depth_sync
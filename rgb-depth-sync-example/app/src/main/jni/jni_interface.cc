@@ -17,86 +17,105 @@
 #define GLM_FORCE_RADIANS
 
 #include <jni.h>
+#include <tango-gl/jni_natives.h>
 
 #include "rgb-depth-sync/rgb_depth_sync_application.h"
 
-static rgb_depth_sync::SynchronizationApplication app;
+namespace {
+rgb_depth_sync::SynchronizationApplication app;
 
-#ifdef __cplusplus
-extern "C" {
-#endif
-JNIEXPORT jint JNICALL
-Java_com_projecttango_experiments_rgbdepthsync_JNIInterface_tangoInitialize(
-    JNIEnv* env, jobject, jobject activity) {
+jint TangoInitialize(JNIEnv* env, jobject, jobject activity) {
   return app.TangoInitialize(env, activity);
 }
 
-JNIEXPORT jint JNICALL
-Java_com_projecttango_experiments_rgbdepthsync_JNIInterface_tangoSetupConfig(
-    JNIEnv*, jobject) {
-  return app.TangoSetupConfig();
+void TangoStart(JNIEnv*, jobject) {
+  app.TangoStart();
 }
 
-JNIEXPORT jint JNICALL
-Java_com_projecttango_experiments_rgbdepthsync_JNIInterface_tangoConnectTexture(
-    JNIEnv*, jobject) {
-  return app.TangoConnectTexture();
+void TangoDisconnect(JNIEnv*, jobject) {
+  app.TangoDisconnect();
 }
 
-JNIEXPORT jint JNICALL
-Java_com_projecttango_experiments_rgbdepthsync_JNIInterface_tangoConnectCallbacks(
-    JNIEnv*, jobject) {
-  return app.TangoConnectCallbacks();
+void SetViewPort(JNIEnv*, jobject, jint width, jint height) {
+  app.SetViewPort(width, height);
 }
 
-JNIEXPORT jint JNICALL
-Java_com_projecttango_experiments_rgbdepthsync_JNIInterface_tangoConnect(
-    JNIEnv*, jobject) {
-  return app.TangoConnect();
+void Render(JNIEnv*, jobject) {
+  app.Render();
 }
 
-JNIEXPORT jint JNICALL
-Java_com_projecttango_experiments_rgbdepthsync_JNIInterface_tangoSetIntrinsicsAndExtrinsics(
-    JNIEnv*, jobject) {
-  return app.TangoSetIntrinsicsAndExtrinsics();
+void SetDepthAlphaValue(JNIEnv*, jobject, jfloat alpha) {
+  return app.SetDepthAlphaValue(alpha);
 }
 
-JNIEXPORT void JNICALL
-Java_com_projecttango_experiments_rgbdepthsync_JNIInterface_tangoDisconnect(
-    JNIEnv*, jobject) {
-  app.TangoDisconnect();
+void SetGPUUpsample(JNIEnv*, jobject, jboolean on) {
+  return app.SetGPUUpsample(on);
 }
 
-JNIEXPORT void JNICALL
-Java_com_projecttango_experiments_rgbdepthsync_JNIInterface_initializeGLContent(
-    JNIEnv*, jobject) {
-  app.InitializeGLContent();
+void SetBilateralUpsample(JNIEnv*, jobject, jboolean on) {
+  return app.SetBilateralUpsample(on);
 }
 
-JNIEXPORT void JNICALL
-Java_com_projecttango_experiments_rgbdepthsync_JNIInterface_setViewPort(
-    JNIEnv*, jobject, jint width, jint height) {
-  app.SetViewPort(width, height);
+void SetColorFrameMatching(JNIEnv*, jobject, jboolean on) {
+  return app.SetColorFrameMatching(on);
 }
 
-JNIEXPORT void JNICALL
-Java_com_projecttango_experiments_rgbdepthsync_JNIInterface_render(JNIEnv*,
-                                                                   jobject) {
-  app.Render();
+void SetParallelUpsample(JNIEnv*, jobject, jboolean on) {
+  return app.SetParallelUpsample(on);
 }
 
-JNIEXPORT void JNICALL
-Java_com_projecttango_experiments_rgbdepthsync_JNIInterface_setDepthAlphaValue(
-    JNIEnv*, jobject, jfloat alpha) {
-  return app.SetDepthAlphaValue(alpha);
+void SetHoleFilling(JNIEnv*, jobject, jboolean on) {
+  return app.SetHoleFilling(on);
 }
 
-JNIEXPORT void JNICALL
-Java_com_projecttango_experiments_rgbdepthsync_JNIInterface_setGPUUpsample(
-    JNIEnv*, jobject, jboolean on) {
-  return app.SetGPUUpsample(on);
+void SetProfilerOverlay(JNIEnv*, jobject, jboolean on) {
+  return app.SetProfilerOverlay(on);
+}
+
+jstring GetProfilerReport(JNIEnv* env, jobject) {
+  return env->NewStringUTF(app.GetProfilerReport().c_str());
+}
+
+void SetMemoryBudget(JNIEnv*, jobject, jlong bytes) {
+  app.SetMemoryBudget(bytes > 0 ? static_cast<size_t>(bytes) : 0);
+}
+
+void SetServiceProbe(JNIEnv*, jobject, jboolean on) {
+  return app.SetServiceProbe(on);
 }
 
+const JNINativeMethod kNativeMethods[] = {
+    {"tangoInitialize", "(Landroid/app/Activity;)I",
+     reinterpret_cast<void*>(TangoInitialize)},
+    {"tangoStart", "()V", reinterpret_cast<void*>(TangoStart)},
+    {"tangoDisconnect", "()V", reinterpret_cast<void*>(TangoDisconnect)},
+    {"setViewPort", "(II)V", reinterpret_cast<void*>(SetViewPort)},
+    {"render", "()V", reinterpret_cast<void*>(Render)},
+    {"setDepthAlphaValue", "(F)V", reinterpret_cast<void*>(SetDepthAlphaValue)},
+    {"setGPUUpsample", "(Z)V", reinterpret_cast<void*>(SetGPUUpsample)},
+    {"setBilateralUpsample", "(Z)V",
+     reinterpret_cast<void*>(SetBilateralUpsample)},
+    {"setColorFrameMatching", "(Z)V",
+     reinterpret_cast<void*>(SetColorFrameMatching)},
+    {"setParallelUpsample", "(Z)V",
+     reinterpret_cast<void*>(SetParallelUpsample)},
+    {"setHoleFilling", "(Z)V", reinterpret_cast<void*>(SetHoleFilling)},
+    {"setProfilerOverlay", "(Z)V", reinterpret_cast<void*>(SetProfilerOverlay)},
+    {"getProfilerReport", "()Ljava/lang/String;",
+     reinterpret_cast<void*>(GetProfilerReport)},
+    {"setMemoryBudget", "(J)V", reinterpret_cast<void*>(SetMemoryBudget)},
+    {"setServiceProbe", "(Z)V", reinterpret_cast<void*>(SetServiceProbe)},
+};
+}  // namespace
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+jint JNI_OnLoad(JavaVM* vm, void*) {
+  return tango_gl::jni::RegisterNatives(
+      vm, "com/projecttango/experiments/rgbdepthsync/JNIInterface",
+      kNativeMethods);
+}
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,199 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef RGB_DEPTH_SYNC_BILATERAL_DEPTH_UPSAMPLER_H_
+#define RGB_DEPTH_SYNC_BILATERAL_DEPTH_UPSAMPLER_H_
+
+#include <string>
+#include <vector>
+
+#include <tango_client_api.h>
+#include <tango-gl/camera_intrinsics_registry.h>
+#include <tango-gl/undistortion_mesh.h>
+#include <tango-gl/util.h>
+#include <tango-gl/vertex_buffer.h>
+
+namespace rgb_depth_sync {
+
+// BilateralDepthUpsampler turns a point cloud into a dense depth image on the
+// GPU with a joint bilateral filter guided by the color image. It runs four
+// passes, each into its own texture:
+//
+// 1. Guide: the luminance of the color camera texture, undistorted to the
+//    pinhole model of the depth, at the output resolution.
+// 2. Sparse: the points splatted as single pixels into an image a divisor
+//    smaller than the color image, nearest point wins.
+// 3. Horizontal: for each output column and sparse row, the depth of the
+//    sparse texels within the filter radius, weighted by their distance and
+//    by how close their guide luminance is to the one of the output pixel.
+// 4. Vertical: the same along the sparse rows of the horizontal pass, at the
+//    output resolution, weighted by the confidence of the horizontal pass.
+//
+// Each pass is a tango_gl::RenderPass. Only the sparse pass has a depth
+// attachment, cleared and discarded within it; the other passes draw every
+// pixel of their target, which is therefore never loaded.
+//
+// Splitting the filter into two 1D passes makes its cost linear in the
+// radius. Depth does not bleed across edges the color image shows, and no
+// pass reads back to the CPU. The output resolution and radius set the GPU
+// cost, see SetOutputScale() and SetRadius().
+//
+// The textures use the depth encoding of DepthImage: blue and alpha hold the
+// depth in millimeters as a 16 bit integer, low byte first, 0 meaning no
+// depth. The horizontal pass keeps its weight sum in red.
+// Texture row 0 is the top row of the color image.
+//
+// All functions must be called on the GL thread.
+class BilateralDepthUpsampler {
+ public:
+  // Default size of the color image relative to a sparse depth texel, about
+  // the density of a Tango point cloud.
+  static const int kDefaultSparseDivisor = 8;
+  // Default filter radius, in sparse texels.
+  static const int kDefaultRadius = 2;
+  // Largest filter radius.
+  static const int kMaxRadius = 4;
+  // Default standard deviation of the luminance weight.
+  static const float kDefaultColorSigma;
+
+  BilateralDepthUpsampler();
+  BilateralDepthUpsampler(const BilateralDepthUpsampler& other) = delete;
+  const BilateralDepthUpsampler& operator=(const BilateralDepthUpsampler&) =
+      delete;
+  ~BilateralDepthUpsampler();
+
+  // Forget the GL objects of a destroyed context, they are created again by
+  // the next Upsample().
+  void InitializeGL();
+
+  // Delete the GL objects.
+  void Release();
+
+  // Set the color camera the depth is registered to.
+  //
+  // @param intrinsics: color camera intrinsics, defines the image size.
+  // @param projection_matrix_ar: projection of the color camera.
+  void SetCameraIntrinsics(const TangoCameraIntrinsics& intrinsics,
+                           const glm::mat4& projection_matrix_ar);
+
+  // Undistort the color image with a distortion map of the color camera, so
+  // the guide lines up with the depth. nullptr uses the image as is.
+  void SetDistortionMap(
+      const tango_gl::CameraIntrinsicsRegistry::DistortionMap* map) {
+    mesh_.SetDistortionMap(map);
+  }
+
+  // Set the output resolution as a fraction of the color image, clamped to
+  // [0.25, 1]. The textures are reallocated when it changes.
+  void SetOutputScale(float scale);
+  float GetOutputScale() const { return output_scale_; }
+
+  // Set the filter radius in sparse texels, clamped to [1, kMaxRadius].
+  void SetRadius(int radius);
+  int GetRadius() const { return radius_; }
+
+  // Set the standard deviation of the luminance weight, in [0, 1] units.
+  // Smaller values keep edges sharper and fill less.
+  void SetColorSigma(float sigma);
+
+  // Run the passes for a point cloud. Binds its own framebuffers and
+  // restores framebuffer 0 and the viewport.
+  //
+  // @param color_t1_T_depth_t0: transformation of the depth camera frame at
+  //        the depth timestamp with respect to the color camera frame at the
+  //        color timestamp.
+  // @param points: packed x, y, z coordinates in the depth camera frame.
+  // @param new_points: whether the points changed since the last call and
+  //        need to be uploaded.
+  // @param color_texture: the color camera texture.
+  // @param color_texture_target: GL_TEXTURE_EXTERNAL_OES for the camera
+  //        texture, GL_TEXTURE_2D for a copy of it, see ColorFrameRing.
+  // @return false if a pass could not be set up.
+  bool Upsample(const glm::mat4& color_t1_T_depth_t0,
+                const std::vector<float>& points, bool new_points,
+                GLuint color_texture, GLenum color_texture_target);
+
+  // The dense depth texture, 0 before the first Upsample().
+  GLuint GetTextureId() const { return targets_[kVertical].texture; }
+  GLsizei GetOutputWidth() const { return targets_[kVertical].width; }
+  GLsizei GetOutputHeight() const { return targets_[kVertical].height; }
+
+ private:
+  enum Pass { kGuide, kSparse, kHorizontal, kVertical, kPassCount };
+
+  // A texture and the framebuffer rendering into it.
+  struct Target {
+    GLuint framebuffer;
+    GLuint texture;
+    // Only for kSparse, the z-test keeping the nearest point.
+    GLuint depth_renderbuffer;
+    GLsizei width;
+    GLsizei height;
+  };
+
+  // A program of a pass and its locations, -1 for the ones it lacks.
+  struct Program {
+    GLuint program;
+    GLint attrib_vertices;
+    GLint attrib_texture_coords;
+    GLint uniform_mvp;
+    GLint uniform_color_T_depth;
+    GLint uniform_color_texture;
+    GLint uniform_depth_image;
+    GLint uniform_guide;
+    GLint uniform_sparse_size;
+    GLint uniform_spatial_scale;
+    GLint uniform_range_scale;
+  };
+
+  // Create or resize the target of a pass.
+  bool Allocate(Pass pass, GLsizei width, GLsizei height);
+
+  // Compile the programs, again when the radius or the color texture target
+  // changed.
+  bool AcquirePrograms(GLenum color_texture_target);
+  bool AcquireProgram(Pass pass, const std::string& vertex_shader,
+                      const std::string& fragment_shader);
+  void ReleasePrograms();
+
+  // Begin the tango_gl::RenderPass of a pass on its target and use its
+  // program.
+  void BeginPass(Pass pass);
+
+  // Draw the full screen quad of the filter passes.
+  void DrawQuad(GLint attrib_vertices);
+
+  TangoCameraIntrinsics intrinsics_;
+  glm::mat4 projection_matrix_ar_;
+  float output_scale_;
+  int radius_;
+  float color_sigma_;
+
+  Target targets_[kPassCount];
+  Program programs_[kPassCount];
+  // Radius the filter programs were built for, 0 before they are.
+  int program_radius_;
+  // Color texture target the guide program samples.
+  GLenum program_color_target_;
+
+  tango_gl::UndistortionMesh mesh_;
+  tango_gl::VertexBuffer point_buffer_;
+  tango_gl::VertexBuffer quad_buffer_;
+};
+}  // namespace rgb_depth_sync
+
+#endif  // RGB_DEPTH_SYNC_BILATERAL_DEPTH_UPSAMPLER_H_
@@ -17,13 +17,14 @@
 #ifndef RGB_DEPTH_SYNC_CAMERA_TEXTURE_DRAWABLE_H_
 #define RGB_DEPTH_SYNC_CAMERA_TEXTURE_DRAWABLE_H_
 
+#include <tango-gl/undistortion_mesh.h>
 #include <tango-gl/util.h>
 #include "rgb-depth-sync/shader.h"
 
 namespace rgb_depth_sync {
 // The drawable class to render color camera texture in the render loop.
 // Please note that the color camera texture is in GL_TEXTURE_EXTERNAL_OES
-// format.
+// format, unless it is a copy, see SetColorTextureTarget().
 class CameraTextureDrawable {
  public:
   CameraTextureDrawable();
@@ -42,6 +43,10 @@ class CameraTextureDrawable {
   // @param texture_id: texture id which we set the color_texture_id_
   void SetColorTextureId(GLuint texture_id) { color_texture_id_ = texture_id; }
 
+  // Set the target of the color texture, GL_TEXTURE_EXTERNAL_OES for the
+  // camera texture or GL_TEXTURE_2D for a copy of it.
+  void SetColorTextureTarget(GLenum target) { color_texture_target_ = target; }
+
   // Set the depth texture id that is used for rendering.
   // @param texture_id: texture id which we set the depth_texture_id_
   void SetDepthTextureId(GLuint texture_id) { depth_texture_id_ = texture_id; }
@@ -51,10 +56,19 @@ class CameraTextureDrawable {
   // @param blend_alpha: Blending value between rgb and depth texture.
   void SetBlendAlpha(float blend_alpha) { blend_alpha_ = blend_alpha; }
 
+  // Undistort the color image with a distortion map of the color camera, so
+  // it lines up with the depth image which is projected with the pinhole
+  // model. nullptr draws the color image as it comes from the camera.
+  void SetDistortionMap(
+      const tango_gl::CameraIntrinsicsRegistry::DistortionMap* map) {
+    mesh_.SetDistortionMap(map);
+  }
+
  private:
   float blend_alpha_;
 
   GLuint color_texture_id_;
+  GLenum color_texture_target_;
   GLuint depth_texture_id_;
 
   GLuint color_texture_handle_;
@@ -64,9 +78,14 @@ class CameraTextureDrawable {
   GLuint attrib_texture_coords_;
   GLuint attrib_vertices_;
 
+  // Use the program sampling the current color texture target.
+  void AcquireProgram();
+
   GLuint shader_program_;
-  // Vertex, indices and texture buffers.
-  GLuint render_buffers_[3];
+  // Color texture target shader_program_ samples.
+  GLenum program_target_;
+  // Screen quad, a grid warping the color image when undistorting.
+  tango_gl::UndistortionMesh mesh_;
 };
 }  // namespace rgb_depth_sync
 
@@ -0,0 +1,118 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef RGB_DEPTH_SYNC_COLOR_FRAME_RING_H_
+#define RGB_DEPTH_SYNC_COLOR_FRAME_RING_H_
+
+#include <vector>
+
+#include <tango-gl/util.h>
+#include <tango-gl/vertex_buffer.h>
+
+namespace rgb_depth_sync {
+
+// ColorFrameRing keeps GPU copies of the most recent color camera frames,
+// indexed by timestamp, so a depth frame can be paired with the color frame
+// captured closest to it instead of with the latest one.
+//
+// The Tango service updates a single GL_TEXTURE_EXTERNAL_OES texture in
+// place, each new frame is copied into a GL_TEXTURE_2D of the ring with a
+// full screen draw. The copies keep the texture coordinates of the camera
+// texture, they can be drawn with the same coordinates. Depth arrives at a
+// few Hz and a few frames behind the color camera, the default capacity
+// covers about a quarter second of frames at 30Hz.
+//
+// All functions must be called on the GL thread.
+class ColorFrameRing {
+ public:
+  static const size_t kDefaultCapacity = 8;
+
+  // @param capacity: number of frames kept, the oldest frame is dropped
+  //        first.
+  explicit ColorFrameRing(size_t capacity = kDefaultCapacity);
+  ColorFrameRing(const ColorFrameRing& other) = delete;
+  const ColorFrameRing& operator=(const ColorFrameRing&) = delete;
+  ~ColorFrameRing();
+
+  // Forget the GL objects and frames of a destroyed context.
+  void InitializeGL();
+
+  // Delete the GL objects and drop the frames.
+  void Release();
+
+  // Drop the frames, keeping their textures.
+  void Clear();
+
+  // Set the size of the copies, usually the color camera image size. Frames
+  // of another size are dropped.
+  void SetImageSize(GLsizei width, GLsizei height);
+
+  // Copy the current content of the camera texture into the ring. A
+  // timestamp equal to the latest frame's is the same frame and is not
+  // copied again; an older one means the service restarted and drops the
+  // kept frames. The copy is a tango_gl::RenderPass of its own, run it
+  // before the pass on the window.
+  //
+  // @param camera_texture: the GL_TEXTURE_EXTERNAL_OES color camera texture.
+  // @param timestamp: capture time of the frame in seconds.
+  // @return true if the frame was copied.
+  bool Push(GLuint camera_texture, double timestamp);
+
+  // Get the frame captured closest to a timestamp, in O(log n).
+  //
+  // @param timestamp: time in seconds.
+  // @param texture: output GL_TEXTURE_2D of the frame, only written on
+  //        success.
+  // @param frame_timestamp: output capture time of the frame, only written
+  //        on success.
+  // @return false if the ring is empty.
+  bool GetNearestFrame(double timestamp, GLuint* texture,
+                       double* frame_timestamp) const;
+
+  size_t GetFrameCount() const { return count_; }
+
+ private:
+  struct Frame {
+    GLuint texture;
+    GLsizei width;
+    GLsizei height;
+    double timestamp;
+  };
+
+  // Index into frames_ of the i-th oldest kept frame.
+  size_t Index(size_t i) const { return (first_ + i) % frames_.size(); }
+
+  // Create or resize the texture of a frame.
+  void Allocate(Frame* frame);
+
+  bool AcquireProgram();
+
+  std::vector<Frame> frames_;
+  size_t first_;
+  size_t count_;
+  GLsizei width_;
+  GLsizei height_;
+
+  GLuint framebuffer_;
+  GLuint program_;
+  GLint attrib_vertices_;
+  GLint uniform_camera_texture_;
+  tango_gl::VertexBuffer quad_buffer_;
+};
+}  // namespace rgb_depth_sync
+
+#endif  // RGB_DEPTH_SYNC_COLOR_FRAME_RING_H_
@@ -18,9 +18,17 @@
 #define RGB_DEPTH_SYNC_DEPTH_IMAGE_H_
 
 #include <tango_client_api.h>
+#include <tango-gl/pixel_readback.h>
+#include <tango-gl/point_projection.h>
+#include <tango-gl/streaming_texture.h>
 #include <tango-gl/util.h>
+#include <memory>
 #include <thread>
 #include <mutex>
+
+#include "rgb-depth-sync/bilateral_depth_upsampler.h"
+#include "rgb-depth-sync/tiled_depth_splatter.h"
+
 namespace rgb_depth_sync {
 
 // DepthImage is a class which projects point cloud on to a color camera's
@@ -47,6 +55,26 @@ class DepthImage {
   void UpdateAndUpsampleDepth(
       glm::mat4& color_t1_T_depth_t0, const std::vector<float>& render_point_cloud_buffer);
 
+  // Same as UpdateAndUpsampleDepth(), but takes the points located by the ij
+  // index grid of TangoXYZij as well. The depth and color cameras are the
+  // same hardware, so while color_t1_T_depth_t0 moves the points by less
+  // than a pixel they are splatted at their grid location as they are, and
+  // nothing is projected. Otherwise render_point_cloud_buffer is projected.
+  //
+  // @param image_points: packed x and y of the depth camera image, both
+  //        normalized to [0, 1), and depth in meters. Can be empty.
+  void UpdateAndUpsampleDepth(
+      glm::mat4& color_t1_T_depth_t0,
+      const std::vector<float>& render_point_cloud_buffer,
+      const std::vector<float>& image_points);
+
+  // Same as UpdateAndUpsampleDepth(), but projects and splats the points on a
+  // worker pool with a tile based z-test, nearest depth wins. The worker
+  // threads are started on the first call.
+  void UpdateAndUpsampleDepthParallel(
+      const glm::mat4& color_t1_T_depth_t0,
+      const std::vector<float>& render_point_cloud_buffer);
+
   // Update the depth texture by direct rendering.
   // @param  color_t1_T_depth_t0: The transformation between the color camera frame on timestamp i
   //    (color camera timestamp) and the depth camera frame on timestamp j (depth
@@ -61,78 +89,144 @@ class DepthImage {
   //
   // @param new_points Indicates if the point data has been updated and needs to
   // be uploaded to the GPU.
+  //
+  // @param color_timestamp Timestamp of the color image, returned with the
+  // depth by GetRegisteredDepth().
   void RenderDepthToTexture(glm::mat4& color_t1_T_depth_t0,
                             const std::vector<float>& render_point_cloud_buffer,
-                            bool new_points);
+                            bool new_points, double color_timestamp);
+
+  // Update the depth texture with the joint bilateral upsampling of
+  // BilateralDepthUpsampler, guided by the color image. Same parameters as
+  // RenderDepthToTexture().
+  //
+  // @param color_texture: the color camera texture of ColorImage, or a copy
+  //        of it from ColorFrameRing.
+  // @param color_texture_target: GL_TEXTURE_EXTERNAL_OES or GL_TEXTURE_2D.
+  void UpsampleDepthBilateral(
+      const glm::mat4& color_t1_T_depth_t0,
+      const std::vector<float>& render_point_cloud_buffer, bool new_points,
+      GLuint color_texture, GLenum color_texture_target);
+
+  // Set the output resolution, as a fraction of the color image, and the
+  // filter radius of UpsampleDepthBilateral(), see BilateralDepthUpsampler.
+  void SetBilateralQuality(float output_scale, int radius);
+
+  // Undistort the color image guiding UpsampleDepthBilateral() with a
+  // distortion map of the color camera.
+  void SetCameraDistortionMap(
+      const tango_gl::CameraIntrinsicsRegistry::DistortionMap* map) {
+    bilateral_upsampler_.SetDistortionMap(map);
+  }
+
+  // Enable reading the metric depth of RenderDepthToTexture() back to the
+  // CPU. The reads are asynchronous and arrive a few frames late, see
+  // tango_gl::PixelReadback.
+  void SetDepthReadback(bool enabled);
+
+  // Get the depth maps read back since the last call, only the newest is
+  // kept.
+  //
+  // @param color_timestamp: set to the timestamp of the color image the depth
+  //        is registered to.
+  // @param depth_map: depth in meters for each color image pixel, row major
+  //        from the top left, 0 where no point landed. Depth is stored with
+  //        millimeter precision, up to 65.535 meters.
+  //
+  // @return false if no depth map is ready.
+  bool GetRegisteredDepth(double* color_timestamp,
+                          std::vector<float>* depth_map);
+
+  // Get the depth map of the last UpdateAndUpsampleDepth() or
+  // UpdateAndUpsampleDepthParallel() call, e.g. to hit test taps with a
+  // tango_gl::DepthHitTester.
+  //
+  // @return depth in millimeters for each color image pixel, row major from
+  //         the top left, 0 where no point landed. Empty before the first
+  //         call.
+  const std::vector<uint16_t>& GetDepthMap() const {
+    return depth_map_buffer_;
+  }
+
+  // Enable filling empty pixels next to splatted ones (a 3x3 dilation) in
+  // UpdateAndUpsampleDepth().
+  void SetHoleFilling(bool enabled);
+
+  // Set the half width in pixels of the window each point is splatted into,
+  // the window is 2 * window_size + 1 pixels wide. Smaller windows are
+  // cheaper and leave more holes. Defaults to kDefaultWindowSize.
+  void SetWindowSize(int window_size);
+
+  // Default half width of the splatting window.
+  static const int kDefaultWindowSize = 7;
 
   // Returns the depth texture id.
   GLuint GetTextureId() const { return texture_id_; }
 
   // Set camera's intrinsics.
   // The intrinsics are used to project the pointcloud to depth image and
-  // and undistort the image to the right size.
-  void SetCameraIntrinsics(TangoCameraIntrinsics intrinsics);
+  // and undistort the image to the right size. The projection matrix of the
+  // camera is used to render the pointcloud with the GPU.
+  void SetCameraIntrinsics(TangoCameraIntrinsics intrinsics,
+                           const glm::mat4& projection_matrix_ar);
 
  private:
   // Initialize the OpenGL structures needed to render depth image to texture.
-  // Returns true if the texture was created and false if an existing texture
-  // was bound.
-  bool CreateOrBindGPUTexture();
-
-  // Initialize the OpenGL structures needed for the CPU texture generation.
-  // Returns true if the texture was created and false if an existing texture
-  // was bound.
-  bool CreateOrBindCPUTexture();
-
-  // This function takes care of upsampling depth around a given point by
-  // setting the same value in a bounding box. Note:This is a very rudimentary
-  // approach to upsampling depth.
-  //
-  // @param color_value: The value that needs to set for all points in a
-  // bounding box.
-  //
-  // @param pixel_x: The pixel along x axis in the grayscale_buffer around which
-  // depth needs to be upsampled.
-  //
-  // @param pixel_y: The pixel along y axis in the grayscale_buffer around which
-  // depth needs to be upsampled.
-  //
-  // @param grayscale_buffer: The image buffer in which upsampling needs to be
-  // done.
-  void UpSampleDepthAroundPoint(uint8_t color_value, float depth_value,
-                                int pixel_x, int pixel_y,
-                                std::vector<uint8_t>* grayscale_buffer,
-                                std::vector<float>* depth_map_buffer);
+  // Returns true if the texture was created and false if it already existed.
+  bool CreateGPUTexture();
+
+  // Fill an empty pixel with the nearest depth among its splatted 3x3
+  // neighbours. Returns false if none of them has depth.
+  bool FillHole(int pixel_x, int pixel_y);
 
-  // The defined max distance for a depth value.
-  static const int kMaxDepthDistance = 4000;
+  // Fill holes in the depth splatted this frame if enabled, and clear the
+  // depth of the pixels left empty.
+  void ResolveDepthImage();
+
+  // Upload depth_map_buffer_ to cpu_texture_ and make it the depth texture.
+  void UploadDepthMap();
 
   // The meter to millimeter conversion.
   static const int kMeterToMillimeter = 1000;
 
-  // Window size for splatter upsample
-  static const int kWindowSize = 7;
-
   // The depth texture id. This is used for other rendering class to
   // render, in this class, we only write value to this texture via
   // CPU or offscreen framebuffer rendering.  This should point either
-  // to the cpu_texture_id_ or gpu_texture_id_ value and should not be
-  // deleted separately.
+  // to the cpu_texture_, gpu_texture_id_ or bilateral_upsampler_ texture
+  // and should not be deleted separately.
   GLuint texture_id_;
-  // The backing texture for CPU texture generation.
-  GLuint cpu_texture_id_;
+
+  // Parallel CPU upsampling, created on demand.
+  std::unique_ptr<TiledDepthSplatter> tiled_depth_splatter_;
+
+  // The backing texture for CPU texture generation, storage is allocated once
+  // and updated with glTexSubImage2D (through PBOs on GLES3 devices). Holds
+  // depth_map_buffer_ as is, in the depth encoding of the GPU texture; the
+  // display colormap is applied when compositing, see shader.h.
+  tango_gl::StreamingTexture cpu_texture_;
   // The backing texture for GPU texture generation.
   GLuint gpu_texture_id_;
 
-  std::vector<float> depth_map_buffer_;
+  // GPU upsampling guided by the color image, owns its textures.
+  BilateralDepthUpsampler bilateral_upsampler_;
 
-  // Color map buffer is for the texture render purpose, this value is written
-  // to the texture id buffer, and display as GL_LUMINANCE value.
-  std::vector<uint8_t> grayscale_display_buffer_;
+  // Depth in millimeters. While UpdateAndUpsampleDepth() splats, a pixel only
+  // holds depth for the current frame if its depth_stamp_buffer_ entry is
+  // current_stamp_ (splatted) or current_stamp_ + 1 (hole filled);
+  // ResolveDepthImage() then clears the other pixels.
+  std::vector<uint16_t> depth_map_buffer_;
+  std::vector<uint32_t> depth_stamp_buffer_;
+  uint32_t current_stamp_;
+
+  bool fill_holes_;
+
+  // Half width of the splatting window, see SetWindowSize().
+  int window_size_;
 
   // The camera intrinsics of current device. Note that the color camera and
   // depth camera are the same hardware on the device.
   TangoCameraIntrinsics rgb_camera_intrinsics_;
+  tango_gl::projection::CameraIntrinsics projection_intrinsics_;
 
   // Transform between Color camera and Depth Camera.
   glm::mat4 depth_camera_T_color_camera_;
@@ -141,9 +235,16 @@ class DepthImage {
   // OpenGL handles for render to texture
   GLuint texture_render_program_;
   GLuint fbo_handle_;
+  GLuint depth_renderbuffer_handle_;
   GLuint vertex_buffer_handle_;
   GLuint vertices_handle_;
   GLuint mvp_handle_;
+  GLuint color_T_depth_handle_;
+  GLuint point_size_handle_;
+
+  // Readback of the GPU depth, see GetRegisteredDepth().
+  bool is_depth_readback_on_;
+  tango_gl::PixelReadback depth_readback_;
 };
 }  // namespace rgb_depth_sync
 
@@ -19,11 +19,26 @@
 
 #include <jni.h>
 
+#include <string>
+
 #include <tango_client_api.h>
+#include <rgb-depth-sync/color_frame_ring.h>
 #include <rgb-depth-sync/color_image.h>
 #include <rgb-depth-sync/depth_image.h>
 #include <rgb-depth-sync/scene.h>
 #include <rgb-depth-sync/util.h>
+#include <tango-gl/camera_intrinsics_registry.h>
+#include <tango-gl/device_extrinsics.h>
+#include <tango-gl/energy_monitor.h>
+#include <tango-gl/frame_profiler.h>
+#include <tango-gl/motion_gate.h>
+#include <tango-gl/point_cloud_decimator.h>
+#include <tango-gl/pose_history.h>
+#include <tango-gl/quality_governor.h>
+#include <tango-gl/rigid_transform.h>
+#include <tango-gl/startup_orchestrator.h>
+#include <tango-gl/text_overlay.h>
+#include <tango-gl/triple_buffer.h>
 #include <tango-gl/util.h>
 
 namespace rgb_depth_sync {
@@ -35,17 +50,10 @@ namespace rgb_depth_sync {
 // callbacks and passing on the necessary information to stored objects. It also
 // takes care of passing a vector container which has a pointer to the
 // latest point cloud buffer that is to used for rendering.
-//  To reduce the number of point cloud data copies between callback and render
-// threads we use three buffers which are synchronously exchanged between each
-// other so that the render loop always contains the latest point cloud data.
-// 1. Callback buffer : The buffer to which pointcloud data received from Tango
-// Service callback is copied out.
-// 2. Shared buffer: This buffer is used to share the data between Service
-// callback and Render loop
-// 3. Render Buffer: This buffer is used in the renderloop to project point
-// cloud data to a 2D image plane which is of the same size as RGB image. We
-// also make sure that this buffer contains the latest point cloud data that is
-//  received from the call back.
+//  To avoid point cloud data copies between callback and render threads the
+// callback decimates each frame straight into the write slot of a
+// tango_gl::TripleBuffer, and the render loop acquires the latest published
+// slot. Neither thread ever waits for the other.
 class SynchronizationApplication {
  public:
   SynchronizationApplication();
@@ -76,6 +84,13 @@ class SynchronizationApplication {
   // Image plane.
   int TangoSetIntrinsicsAndExtrinsics();
 
+  // Run the steps from TangoSetupConfig() to
+  // TangoSetIntrinsicsAndExtrinsics() on worker threads, and
+  // InitializeGLContent() on the GL thread from Render(), overlapping the
+  // ones which do not depend on each other. Render() draws nothing until
+  // all of them succeeded.
+  void TangoStart();
+
   // Disconnect from Tango Service.
   void TangoDisconnect();
 
@@ -83,7 +98,8 @@ class SynchronizationApplication {
   // Top of an RGB image.
   void InitializeGLContent();
 
-  // Setup the view port width and height.
+  // Setup the view port width and height. The viewport is laid out on the
+  // next frame with the color camera intrinsics.
   void SetViewPort(int width, int height);
 
   // Main Render loop.
@@ -95,16 +111,83 @@ class SynchronizationApplication {
   // Set whether to use GPU or CPU upsampling
   void SetGPUUpsample(bool on);
 
+  // Set whether to upsample on the GPU with a joint bilateral filter guided
+  // by the color image, see BilateralDepthUpsampler. Takes precedence over
+  // the other upsampling settings.
+  void SetBilateralUpsample(bool on);
+
+  // Set whether each depth frame is paired with the recent color frame
+  // captured closest to it, see ColorFrameRing, rather than with the latest
+  // color frame. Trades color latency for registration under fast motion.
+  void SetColorFrameMatching(bool on);
+
+  // Set whether CPU upsampling runs on a worker pool. Ignored while GPU
+  // upsampling is on.
+  void SetParallelUpsample(bool on);
+
+  // Set whether the serial CPU upsampling fills small holes in the depth
+  // image.
+  void SetHoleFilling(bool on);
+
+  // Set whether the frame profiler statistics are drawn on top of the scene.
+  void SetProfilerOverlay(bool on);
+
+  // Frame profiler statistics, one line per zone, followed by the memory
+  // held per owner, the startup timings and the service probe histograms.
+  // Can be called from any thread.
+  std::string GetProfilerReport() const;
+
+  // Keep the tracked GPU and CPU memory under a budget by evicting
+  // reloadable assets, 0 for no budget. See tango_gl::MemoryTracker.
+  void SetMemoryBudget(size_t bytes);
+
+  // Set whether the latency of the Tango service calls and callbacks is
+  // measured, see tango_gl::ServiceProbe. Turning it on starts over.
+  void SetServiceProbe(bool on);
+
   // Callback for point clouds that come in from the Tango service.
   //
   // @param xyz_ij The point cloud returned by the service.
   //
   void OnXYZijAvailable(const TangoXYZij* xyz_ij);
 
+  // Callback for the device poses that come in from the Tango service.
+  //
+  // @param pose The start of service to device pose.
+  void OnPoseAvailable(const TangoPoseData* pose);
+
  private:
+  // Get the device pose with respect to start of service at a timestamp, from
+  // the pose history or from the service if the history does not cover it.
+  //
+  // @return false if there is no valid pose at the timestamp.
+  bool GetStartServiceTDevice(double timestamp,
+                              tango_gl::RigidTransform* start_service_T_device);
+
+  // Get the transformation of the depth camera frame at a depth timestamp
+  // with respect to the color camera frame at a color timestamp. The poses
+  // are only looked up when either timestamp changed since the last call.
+  //
+  // @return false if there is no valid pose at either timestamp.
+  bool GetColorTDepth(double color_timestamp, double depth_timestamp,
+                      glm::mat4* color_t1_T_depth_t0);
+
+  // Apply the quality governor's level to the upsampling.
+  void ApplyQualityLevel();
+
+  // Attribute the energy from now on to the upsampling mode and quality
+  // level.
+  void UpdateEnergyState();
+
+  // Fit the scene viewport to the screen and the color camera.
+  void UpdateViewport();
+
   // RGB image
   ColorImage color_image_;
 
+  // Recent color frames, when color_frame_matching_ is set.
+  ColorFrameRing color_frames_;
+
   // Depth image created by projecting Point Cloud onto RGB image plane.
   DepthImage depth_image_;
 
@@ -116,51 +199,101 @@ class SynchronizationApplication {
   // this example.
   TangoConfig tango_config_;
 
-  // Extrinsic transformation of color frame wrt device frame.
-  glm::mat4 device_T_color_;
+  // Extrinsic transformations between the device, color and depth frames.
+  tango_gl::DeviceExtrinsics extrinsics_;
 
-  // Extrinsic transformation of depth frame wrt device frame.
-  glm::mat4 device_T_depth_;
+  // Color camera intrinsics and projection, queried once per connection.
+  tango_gl::CameraIntrinsicsRegistry camera_intrinsics_;
 
   // OpenGL to Start of Service
   glm::mat4 OW_T_SS_;
   float screen_width_;
   float screen_height_;
-
-  // This is the buffer to which point cloud data from TangoService callback
-  // gets copied out to.
-  // The data is an array of packed coordinate triplets, x,y,z as floating point
-  // values. With the unit in landscape orientation, screen facing the user:
-  // +Z points in the direction of the camera's optical axis, and is measured
-  // perpendicular to the plane of the camera.
-  // +X points toward the user's right, and +Y points toward the bottom of
-  // the screen.
-  // The origin is the focal centre of the color camera.
-  // The output is in units of metres.
-  std::vector<float> callback_point_cloud_buffer_;
-
-  // The buffer of point cloud data which is shared between TangoService
-  // callback and render loop.
-  std::vector<float> shared_point_cloud_buffer_;
-
-  // This buffer is used in the render loop to project point cloud data to
-  // a 2D image plane which is of the same size as RGB image.
-  std::vector<float> render_point_cloud_buffer_;
-
-  // Time of capture of the current depth data (in seconds).
-  double depth_timestamp_;
-
-  // Mutex for protecting the point cloud data. The point cloud data is shared
-  // between update call which is called from render loop and
-  // TangoService callback thread.
-  std::mutex point_cloud_mutex_;
-
-  // This signal is used to notify update call if there is a new
-  // point cloud buffer available and swap the shared and render buffers
-  // accordingly.
-  bool swap_signal;
+  // Set when the viewport has to be laid out again, e.g. after the screen
+  // size or the intrinsics changed.
+  std::atomic<bool> is_viewport_dirty_;
+
+  // Brings up the service connection and the GL content, see TangoStart().
+  tango_gl::StartupOrchestrator startup_;
+
+  // A decimated depth frame.
+  struct DepthFrame {
+    DepthFrame() : timestamp(0.0) {}
+
+    // Time of capture of the depth data (in seconds).
+    double timestamp;
+    // The data is an array of packed coordinate triplets, x,y,z as floating
+    // point values. With the unit in landscape orientation, screen facing the
+    // user:
+    // +Z points in the direction of the camera's optical axis, and is
+    // measured perpendicular to the plane of the camera.
+    // +X points toward the user's right, and +Y points toward the bottom of
+    // the screen.
+    // The origin is the focal centre of the color camera.
+    // The output is in units of metres.
+    std::vector<float> points;
+    // The points of the ij index grid, when the service fills it in, packed
+    // x and y of the depth camera image normalized to [0, 1) and depth. See
+    // DepthImage::UpdateAndUpsampleDepth().
+    std::vector<float> image_points;
+  };
+
+  // Depth frames handed from the TangoService callback to the render loop,
+  // which projects the points to a 2D image plane which is of the same size
+  // as RGB image.
+  tango_gl::TripleBuffer<DepthFrame> depth_frames_;
+
+  // Reduces each depth frame before it is handed to the render thread.
+  tango_gl::PointCloudDecimator decimator_;
+  // Points kept per depth frame, set by the render thread from the quality
+  // level.
+  std::atomic<size_t> upsample_point_count_;
 
   bool gpu_upsample_;
+
+  bool parallel_upsample_;
+
+  bool bilateral_upsample_;
+
+  bool color_frame_matching_;
+
+  // The last result of GetColorTDepth().
+  struct Registration {
+    Registration() : is_valid(false) {}
+
+    bool is_valid;
+    double color_timestamp;
+    double depth_timestamp;
+    glm::mat4 color_T_depth;
+  };
+  Registration registration_;
+
+  // Timings of the render loop stages.
+  tango_gl::FrameProfiler profiler_;
+  // Steps the upsampling quality to hold the target frame rate.
+  tango_gl::QualityGovernor quality_governor_;
+  // Steps the bilateral upsampling resolution and radius to hold its GPU
+  // budget.
+  tango_gl::QualityGovernor bilateral_governor_;
+
+  // Battery power and CPU frequencies per upsampling mode and quality level,
+  // logged on disconnect.
+  tango_gl::EnergyMonitor energy_monitor_;
+
+  // Draws the profiler statistics when is_profiler_overlay_on_ is set.
+  tango_gl::TextOverlay text_overlay_;
+  bool is_profiler_overlay_on_;
+
+  // Device poses with respect to start of service from the pose callback.
+  tango_gl::PoseHistory pose_history_;
+
+  // Skips the upsampling while the device is still, the depth texture of the
+  // last upsampled frame is drawn instead. Reset by the render thread when
+  // is_motion_gate_dirty_ is set, since the upsampling settings change.
+  tango_gl::MotionGate motion_gate_;
+  std::atomic<bool> is_motion_gate_dirty_;
+  // A depth frame arrived since the last upsampling.
+  bool has_unprocessed_points_;
 };
 }  // namespace rgb_depth_sync
 
@@ -37,8 +37,17 @@ class Scene {
   // Setup GL view port.
   void SetupViewPort(int w, int h);
 
-  // Renders the scene onto the camera image using the provided depth texture.
-  void Render(GLuint, GLuint);
+  // Begin the tango_gl::RenderPass on the window, after the offscreen passes
+  // of the frame. Sets the viewport of the scene; nothing is drawn with
+  // depth, so the depth buffer is neither cleared nor stored.
+  void BeginRenderPass();
+
+  // Renders the scene onto the camera image using the provided depth texture,
+  // within the pass of BeginRenderPass().
+  // The color texture is the GL_TEXTURE_EXTERNAL_OES camera texture, or a
+  // GL_TEXTURE_2D copy of it as given by color_texture_target.
+  void Render(GLuint color_texture, GLenum color_texture_target,
+              GLuint depth_texture);
 
   // Recreate GL structures because of context creation.
   void InitializeGL();
@@ -49,6 +58,13 @@ class Scene {
   // Set the camera intrinsics to use for this scene.
   void SetCameraIntrinsics(const TangoCameraIntrinsics& cc_intrinsics);
 
+  // Set the distortion map used to undistort the color image, nullptr to draw
+  // it as is.
+  void SetCameraDistortionMap(
+      const tango_gl::CameraIntrinsicsRegistry::DistortionMap* map) {
+    camera_texture_drawable_.SetDistortionMap(map);
+  }
+
  private:
   GLint viewport_x_;
   GLint viewport_y_;
@@ -20,18 +20,31 @@
 namespace rgb_depth_sync {
 namespace shader {
 
-// Vertex shader for rendering a color camera texture on full screen.
+// Vertex shader for rendering a color camera texture on full screen. The
+// depth image is in pinhole camera coordinates, it is sampled at the vertex
+// position rather than at the possibly distorted color texture coordinates.
 static const char kColorCameraVert[] =
     "precision highp float;\n"
     "precision highp int;\n"
     "attribute vec4 vertex;\n"
     "attribute vec2 textureCoords;\n"
     "varying vec2 f_textureCoords;\n"
+    "varying vec2 f_depthCoords;\n"
     "void main() {\n"
     "  f_textureCoords = textureCoords;\n"
+    "  f_depthCoords = vec2(0.5 + 0.5 * vertex.x, 0.5 - 0.5 * vertex.y);\n"
     "  gl_Position =  vertex;\n"
     "}\n";
 
+// Display colormap of the depth texture, shared by the fragment shaders
+// below. Blue and alpha hold the depth in millimeters, low byte first, see
+// DepthImage; it is shown as a gray ramp saturating at 4 meters.
+#define RGB_DEPTH_SYNC_DEPTH_COLOR                                            \
+  "vec4 DepthColor(vec4 texel) {\n"                                           \
+  "  float depth = dot(floor(texel.ba * 255.0 + 0.5), vec2(1.0, 256.0));\n"   \
+  "  return vec4(vec3(clamp(depth / 4000.0, 0.0, 1.0)), 1.0);\n"              \
+  "}\n"
+
 // Fragment shader for rendering a color texture on full screen with half alpha
 // blending, please note that the color camera texture is samplerExternalOES.
 static const char kColorCameraFrag[] =
@@ -42,12 +55,33 @@ static const char kColorCameraFrag[] =
     "uniform samplerExternalOES colorTexture;\n"
     "uniform sampler2D depthTexture;\n"
     "varying vec2 f_textureCoords;\n"
+    "varying vec2 f_depthCoords;\n"
+    RGB_DEPTH_SYNC_DEPTH_COLOR
     "void main() {\n"
     "  vec4 cColor = texture2D(colorTexture, f_textureCoords);\n"
-    "  vec4 cDepth = texture2D(depthTexture, f_textureCoords);\n"
-    "  gl_FragColor = (1.0-blendAlpha) * cColor + blendAlpha * cDepth;;\n"
+    "  vec4 cDepth = DepthColor(texture2D(depthTexture, f_depthCoords));\n"
+    "  gl_FragColor = (1.0-blendAlpha) * cColor + blendAlpha * cDepth;\n"
     "}\n";
 
+// Same as kColorCameraFrag for a copy of the color camera texture in a
+// sampler2D, see ColorFrameRing.
+static const char kColorFrameFrag[] =
+    "precision highp float;\n"
+    "precision highp int;\n"
+    "uniform float blendAlpha;\n"
+    "uniform sampler2D colorTexture;\n"
+    "uniform sampler2D depthTexture;\n"
+    "varying vec2 f_textureCoords;\n"
+    "varying vec2 f_depthCoords;\n"
+    RGB_DEPTH_SYNC_DEPTH_COLOR
+    "void main() {\n"
+    "  vec4 cColor = texture2D(colorTexture, f_textureCoords);\n"
+    "  vec4 cDepth = DepthColor(texture2D(depthTexture, f_depthCoords));\n"
+    "  gl_FragColor = (1.0-blendAlpha) * cColor + blendAlpha * cDepth;\n"
+    "}\n";
+
+#undef RGB_DEPTH_SYNC_DEPTH_COLOR
+
 }  // namespace shader
 }  // namespace rgb_depth_sync
 
@@ -0,0 +1,102 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef RGB_DEPTH_SYNC_TILED_DEPTH_SPLATTER_H_
+#define RGB_DEPTH_SYNC_TILED_DEPTH_SPLATTER_H_
+
+#include <memory>
+#include <vector>
+
+#include <tango-gl/point_projection.h>
+#include <tango-gl/util.h>
+#include <tango-gl/worker_pool.h>
+
+namespace rgb_depth_sync {
+
+// TiledDepthSplatter is the multithreaded version of the CPU depth
+// upsampling. It runs in two parallel passes over a WorkerPool:
+//
+// 1. The point cloud is split into contiguous chunks. Each chunk is projected
+//    onto the color image plane and every resulting splat is binned into the
+//    screen tiles its window overlaps. Each chunk owns its bins.
+// 2. Each screen tile is cleared and splatted independently, visiting the
+//    chunks' bins in point order and keeping the nearest depth per pixel.
+//
+// No two tasks write the same memory, and the z-test with point order tie
+// breaking makes the output independent of the thread count and scheduling.
+class TiledDepthSplatter {
+ public:
+  TiledDepthSplatter();
+  TiledDepthSplatter(const TiledDepthSplatter& other) = delete;
+  const TiledDepthSplatter& operator=(const TiledDepthSplatter&) = delete;
+  ~TiledDepthSplatter();
+
+  // Project and splat a point cloud into a depth image.
+  //
+  // @param color_t1_T_depth_t0: transformation of the depth camera frame at
+  //        the depth timestamp with respect to the color camera frame at the
+  //        color timestamp.
+  // @param points: packed x, y, z coordinates in the depth camera frame.
+  // @param intrinsics: color camera intrinsics, defines the image size.
+  // @param window_size: half size of the square splat window in pixels.
+  // @param depth_map: output depth in millimeters, 0 where no point landed.
+  //        Resized to the image size.
+  void Splat(const glm::mat4& color_t1_T_depth_t0,
+             const std::vector<float>& points,
+             const tango_gl::projection::CameraIntrinsics& intrinsics,
+             int window_size, std::vector<uint16_t>* depth_map);
+
+ private:
+  // A projected point, the center of a splat window.
+  struct ProjectedPoint {
+    int pixel_x;
+    int pixel_y;
+    uint16_t millimeters;
+  };
+
+  // Tile edge in pixels, large enough for a splat window to overlap at most
+  // four tiles.
+  static const int kTileSize = 64;
+
+  void ProjectChunk(int chunk, const glm::mat4& color_t1_T_depth_t0,
+                    const std::vector<float>& points,
+                    const tango_gl::projection::CameraIntrinsics& intrinsics,
+                    int window_size);
+
+  void SplatTile(int tile, int window_size,
+                 std::vector<uint16_t>* depth_map);
+
+  // The shared pool.
+  tango_gl::WorkerPool* worker_pool_;
+
+  int image_width_;
+  int image_height_;
+  int tiles_x_;
+  int tiles_y_;
+  int chunk_count_;
+
+  // Per point output of the projection kernel, each chunk writes its own
+  // range.
+  std::vector<int32_t> pixels_;
+  std::vector<float> depths_;
+
+  // bins_[chunk * tile_count + tile] holds the splats of a chunk overlapping
+  // a tile. The vectors are reused between frames to avoid allocations.
+  std::vector<std::vector<ProjectedPoint>> bins_;
+};
+}  // namespace rgb_depth_sync
+
+#endif  // RGB_DEPTH_SYNC_TILED_DEPTH_SPLATTER_H_
@@ -13,10 +13,109 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
+#include <stdio.h>
+
 #include <tango-gl/conversions.h>
+#include <tango-gl/counters.h>
+#include <tango-gl/memory_tracker.h>
+#include <tango-gl/program_cache.h>
+#include <tango-gl/render_pass.h>
+#include <tango-gl/render_state.h>
+#include <tango-gl/service_probe.h>
+#include <tango-gl/tracing.h>
 
 #include <rgb-depth-sync/rgb_depth_sync_application.h>
 
+namespace {
+// Glyph height and distance to the top left corner of the profiler overlay,
+// in pixels.
+const int kProfilerTextSize = 24;
+const float kProfilerTextMargin = 8.0f;
+
+// Where TangoDisconnect() writes the trace when built with TANGO_GL_TRACING.
+const char kTracePath[] = "/sdcard/rgb_depth_sync_trace.json";
+
+// Frame rate held by the quality governor, the rate of the color camera.
+const float kTargetFrameRate = 30.0f;
+
+// A step of the quality ladder. Striding keeps measured points, voxel
+// centroids would put points between a foreground and background edge.
+struct UpsampleQuality {
+  // Half width of the splatting window in pixels.
+  int window_size;
+  // Depth points kept per frame.
+  size_t point_count;
+};
+
+// From the cheapest level to the best one.
+const UpsampleQuality kUpsampleQualityLadder[] = {
+    {3, 5000}, {4, 10000}, {5, 15000}, {7, 20000}};
+const int kUpsampleQualityLevelCount =
+    sizeof(kUpsampleQualityLadder) / sizeof(kUpsampleQualityLadder[0]);
+
+// A step of the bilateral upsampling ladder.
+struct BilateralQuality {
+  // Output resolution as a fraction of the color image.
+  float output_scale;
+  // Filter radius in sparse texels.
+  int radius;
+};
+
+// From the cheapest level to the best one.
+const BilateralQuality kBilateralQualityLadder[] = {
+    {0.25f, 1}, {0.5f, 1}, {0.5f, 2}, {0.75f, 2}, {1.0f, 2}, {1.0f, 3}};
+const int kBilateralQualityLevelCount =
+    sizeof(kBilateralQualityLadder) / sizeof(kBilateralQualityLadder[0]);
+
+// GPU time the bilateral upsampling may take per frame, leaving the rest of
+// the frame to the scene and the compositor.
+const float kBilateralGpuBudgetMs = 5.0f;
+
+// Collect the points of the ij index grid of a frame, as normalized image
+// x, y and depth. Every stride-th row and column is kept so that about
+// target_point_count points remain. Empty if the grid is not filled in.
+void GatherImagePoints(const TangoXYZij& xyz_ij, size_t target_point_count,
+                       std::vector<float>* image_points) {
+  image_points->clear();
+  if (xyz_ij.ij == nullptr || xyz_ij.ij_rows == 0 || xyz_ij.ij_cols == 0) {
+    return;
+  }
+  uint32_t stride = 1;
+  while (target_point_count > 0 &&
+         xyz_ij.xyz_count / (stride * stride) > target_point_count) {
+    ++stride;
+  }
+  const float inverse_cols = 1.0f / xyz_ij.ij_cols;
+  const float inverse_rows = 1.0f / xyz_ij.ij_rows;
+  for (uint32_t row = 0; row < xyz_ij.ij_rows; row += stride) {
+    const uint32_t* cells = xyz_ij.ij + row * xyz_ij.ij_cols;
+    for (uint32_t col = 0; col < xyz_ij.ij_cols; col += stride) {
+      // Cells without a point hold -1, which wraps past any valid index.
+      const uint32_t point = cells[col];
+      if (point < xyz_ij.xyz_count) {
+        image_points->push_back((col + 0.5f) * inverse_cols);
+        image_points->push_back((row + 0.5f) * inverse_rows);
+        image_points->push_back(xyz_ij.xyz[point][2]);
+      }
+    }
+  }
+}
+
+tango_gl::QualityGovernor::Options GetBilateralGovernorOptions() {
+  tango_gl::QualityGovernor::Options options;
+  options.target_frame_ms = kBilateralGpuBudgetMs;
+  options.zone = "upsample";
+  options.is_gpu_time = true;
+  return options;
+}
+
+tango_gl::QualityGovernor::Options GetQualityGovernorOptions() {
+  tango_gl::QualityGovernor::Options options;
+  options.target_frame_ms = 1000.0f / kTargetFrameRate;
+  return options;
+}
+}  // namespace
+
 namespace rgb_depth_sync {
 
 // This function will route callbacks to our application object via the context
@@ -31,16 +130,46 @@ void OnXYZijAvailableRouter(void* context, const TangoXYZij* xyz_ij) {
 }
 
 void SynchronizationApplication::OnXYZijAvailable(const TangoXYZij* xyz_ij) {
-  // We'll just update the point cloud associated with our depth image.
-  size_t point_cloud_size = xyz_ij->xyz_count * 3;
-  callback_point_cloud_buffer_.resize(point_cloud_size);
-  std::copy(xyz_ij->xyz[0], xyz_ij->xyz[0] + point_cloud_size,
-            callback_point_cloud_buffer_.begin());
-  {
-    std::lock_guard<std::mutex> lock(point_cloud_mutex_);
-    depth_timestamp_ = xyz_ij->timestamp;
-    callback_point_cloud_buffer_.swap(shared_point_cloud_buffer_);
-    swap_signal = true;
+  TANGO_GL_TRACE_THREAD_NAME("OnXYZijAvailable");
+  TANGO_GL_TRACE_SCOPE("OnXYZijAvailable");
+  tango_gl::ServiceProbe::RecordCallback(tango_gl::ServiceProbe::kXyzIjCallback,
+                                         xyz_ij->timestamp);
+  // We'll just update the point cloud associated with our depth image,
+  // decimated to the points the upsampling needs.
+  // The write slot is owned by this thread until it is published.
+  DepthFrame* frame = depth_frames_.GetWriteBuffer();
+  frame->points.resize(xyz_ij->xyz_count * 3);
+  decimator_.SetTargetPointCount(upsample_point_count_);
+  size_t point_count = decimator_.Decimate(
+      xyz_ij->xyz[0], xyz_ij->xyz_count, frame->points.data());
+  frame->points.resize(point_count * 3);
+  GatherImagePoints(*xyz_ij, upsample_point_count_, &frame->image_points);
+  frame->timestamp = xyz_ij->timestamp;
+  depth_frames_.Publish();
+  energy_monitor_.OnDepthFrame();
+}
+
+// This function will route callbacks to our application object via the context
+// parameter.
+// @param context Will be a pointer to a SynchronizationApplication instance  on
+// which to call callbacks.
+// @param pose The pose to pass on.
+void OnPoseAvailableRouter(void* context, const TangoPoseData* pose) {
+  SynchronizationApplication* app =
+      static_cast<SynchronizationApplication*>(context);
+  app->OnPoseAvailable(pose);
+}
+
+void SynchronizationApplication::OnPoseAvailable(const TangoPoseData* pose) {
+  TANGO_GL_TRACE_SCOPE("OnPoseAvailable");
+  tango_gl::ServiceProbe::RecordCallback(tango_gl::ServiceProbe::kPoseCallback,
+                                         pose->timestamp);
+  tango_gl::Counters::Increment(tango_gl::Counters::kPosesReceived);
+  if (pose->status_code == TANGO_POSE_VALID) {
+    pose_history_.Add(pose->timestamp, pose->translation, pose->orientation);
+  } else {
+    // Poses after a tracking loss do not continue the earlier ones.
+    pose_history_.Clear();
   }
 }
 
@@ -48,11 +177,53 @@ SynchronizationApplication::SynchronizationApplication()
     : color_image_(),
       depth_image_(),
       main_scene_(),
+      tango_config_(nullptr),
       // We'll store the fixed transform between the opengl frame convention.
       // (Y-up, X-right) and tango frame convention. (Z-up, X-right).
       OW_T_SS_(tango_gl::conversions::opengl_world_T_tango_world()),
-      swap_signal(false),
-      gpu_upsample_(false) {}
+      is_viewport_dirty_(false),
+      gpu_upsample_(false),
+      parallel_upsample_(false),
+      bilateral_upsample_(false),
+      color_frame_matching_(false),
+      quality_governor_(kUpsampleQualityLevelCount,
+                        GetQualityGovernorOptions()),
+      bilateral_governor_(kBilateralQualityLevelCount,
+                          GetBilateralGovernorOptions()),
+      is_profiler_overlay_on_(false),
+      is_motion_gate_dirty_(false),
+      has_unprocessed_points_(false) {
+  decimator_.SetMode(tango_gl::PointCloudDecimator::kStride);
+  ApplyQualityLevel();
+
+  // The service steps depend on each other, but not on the GL content, whose
+  // shaders compile on the GL thread meanwhile.
+  typedef tango_gl::StartupOrchestrator Startup;
+  int config = startup_.AddTask(
+      "setupConfig", Startup::kWorker,
+      [this]() { return static_cast<int>(TangoSetupConfig()); }, {});
+  int callbacks = startup_.AddTask(
+      "connectCallbacks", Startup::kWorker,
+      [this]() { return static_cast<int>(TangoConnectCallbacks()); },
+      {config});
+  int connect = startup_.AddTask(
+      "connect", Startup::kWorker,
+      [this]() { return static_cast<int>(TangoConnect()); }, {callbacks});
+  startup_.AddTask(
+      "intrinsicsAndExtrinsics", Startup::kWorker,
+      [this]() { return static_cast<int>(TangoSetIntrinsicsAndExtrinsics()); },
+      {connect});
+  int gl_content = startup_.AddTask("glContent", Startup::kGLThread,
+                                    [this]() {
+                                      InitializeGLContent();
+                                      return static_cast<int>(TANGO_SUCCESS);
+                                    },
+                                    {});
+  startup_.AddTask(
+      "connectTexture", Startup::kWorker,
+      [this]() { return static_cast<int>(TangoConnectTexture()); },
+      {gl_content});
+}
 
 SynchronizationApplication::~SynchronizationApplication() {
   if (tango_config_) {
@@ -65,6 +236,9 @@ int SynchronizationApplication::TangoInitialize(JNIEnv* env,
   SetDepthAlphaValue(0.0);
   SetGPUUpsample(false);
 
+  // Linked shader programs are persisted in the app cache directory.
+  tango_gl::program_cache::SetBinaryCacheDirectory(env, caller_activity);
+
   // The first thing we need to do for any Tango enabled application is to
   // initialize the service. We'll do that here, passing on the JNI environment
   // and jobject corresponding to the Android activity that is calling us.
@@ -118,20 +292,31 @@ int SynchronizationApplication::TangoConnectTexture() {
 }
 
 int SynchronizationApplication::TangoConnectCallbacks() {
-  // We're interested in only one callback for this application. We need to be
-  // notified when we receive depth information in order to support measuring
-  // 3D points. For both pose and color camera information, we'll be polling.
-  // The render loop will drive the rate at which we need color images and all
-  // our poses will be driven by timestamps. As such, we'll use GetPoseAtTime.
+  // We need to be notified when we receive depth information in order to
+  // support measuring 3D points. The color camera is polled, the render loop
+  // drives the rate at which we need color images. Poses are driven by the
+  // depth and color timestamps, we keep the device poses from the pose
+  // callback to look them up locally and only ask the service with
+  // GetPoseAtTime when a timestamp is not covered.
   TangoErrorType depth_ret =
       TangoService_connectOnXYZijAvailable(OnXYZijAvailableRouter);
-  return depth_ret;
+  if (depth_ret != TANGO_SUCCESS) {
+    return depth_ret;
+  }
+
+  TangoCoordinateFramePair pairs;
+  pairs.base = TANGO_COORDINATE_FRAME_START_OF_SERVICE;
+  pairs.target = TANGO_COORDINATE_FRAME_DEVICE;
+  pose_history_.Clear();
+  return TangoService_connectOnPoseAvailable(1, &pairs, OnPoseAvailableRouter);
 }
 
 int SynchronizationApplication::TangoConnect() {
   // Here, we'll connect to the TangoService and set up to run. Note that we're
   // passing in a pointer to ourselves as the context which will be passed back
-  // in our callbacks.
+  // in our callbacks. Intrinsics may change between connections, so the cached
+  // ones are dropped.
+  camera_intrinsics_.Clear();
   TangoErrorType ret = TangoService_connect(this, tango_config_);
   if (ret != TANGO_SUCCESS) {
     LOGE("SynchronizationApplication: Failed to connect to the Tango service.");
@@ -142,146 +327,333 @@ int SynchronizationApplication::TangoSetIntrinsicsAndExtrinsics() {
   // Get the intrinsics for the color camera and pass them on to the depth
   // image. We need these to know how to project the point cloud into the color
   // camera frame.
+  const float kNearClip = 0.1;
+  const float kFarClip = 10.0;
   TangoCameraIntrinsics color_camera_intrinsics;
-  TangoErrorType ret = TangoService_getCameraIntrinsics(
+  glm::mat4 projection_matrix_ar;
+  TangoErrorType ret = camera_intrinsics_.GetIntrinsics(
       TANGO_CAMERA_COLOR, &color_camera_intrinsics);
+  if (ret == TANGO_SUCCESS) {
+    ret = camera_intrinsics_.GetProjectionMatrix(
+        TANGO_CAMERA_COLOR, 0, 0, kNearClip, kFarClip, &projection_matrix_ar);
+  }
   if (ret != TANGO_SUCCESS) {
     LOGE(
         "SynchronizationApplication: Failed to get the intrinsics for the color"
         "camera.");
     return ret;
   }
-  depth_image_.SetCameraIntrinsics(color_camera_intrinsics);
+  depth_image_.SetCameraIntrinsics(color_camera_intrinsics,
+                                   projection_matrix_ar);
   main_scene_.SetCameraIntrinsics(color_camera_intrinsics);
 
-  // Pose of device frame wrt imu.
-  TangoPoseData pose_imu_T_device;
-  // Pose of color frame wrt imu.
-  TangoPoseData pose_imu_T_color;
-  // Pose of depth camera wrt imu.
-  TangoPoseData pose_imu_T_depth;
-  TangoCoordinateFramePair frame_pair;
-  glm::vec3 translation;
-  glm::quat rotation;
-
-  // We need to get the extrinsic transform between the color camera and the
-  // imu coordinate frames. This matrix is then used to compute the extrinsic
-  // transform between color camera and device:
-  // color_T_device = color_T_imu * imu_T_device;
-  // Note that the matrix color_T_device is a constant transformation since the
-  // hardware will not change, we use the getPoseAtTime() function to query it
-  // once right after the Tango Service connected and store it for efficiency.
-  frame_pair.base = TANGO_COORDINATE_FRAME_IMU;
-  frame_pair.target = TANGO_COORDINATE_FRAME_DEVICE;
-  ret = TangoService_getPoseAtTime(0.0, frame_pair, &pose_imu_T_device);
-  if (ret != TANGO_SUCCESS) {
-    LOGE(
-        "SynchronizationApplication: Failed to get transform between the IMU "
-        "and"
-        "device frames. Something is wrong with device extrinsics.");
-    return ret;
-  }
-  // Converting pose to transformation matrix.
-  glm::mat4 imu_T_device = util::GetMatrixFromPose(&pose_imu_T_device);
-
-  // Get color camera with respect to imu transformation matrix.
-  // This matrix is used to compute the extrinsics between color camera and
-  // device: color_T_device = color_T_imu * imu_T_device;
-  frame_pair.base = TANGO_COORDINATE_FRAME_IMU;
-  frame_pair.target = TANGO_COORDINATE_FRAME_CAMERA_COLOR;
-  ret = TangoService_getPoseAtTime(0.0, frame_pair, &pose_imu_T_color);
-  if (ret != TANGO_SUCCESS) {
-    LOGE(
-        "SynchronizationApplication: Failed to get transform between the IMU "
-        "and"
-        "color camera frames. Something is wrong with device extrinsics.");
-    return ret;
-  }
-  // Converting pose to transformation matrix.
-  glm::mat4 imu_T_color = util::GetMatrixFromPose(&pose_imu_T_color);
-
-  frame_pair.base = TANGO_COORDINATE_FRAME_IMU;
-  frame_pair.target = TANGO_COORDINATE_FRAME_CAMERA_DEPTH;
-  ret = TangoService_getPoseAtTime(0.0, frame_pair, &pose_imu_T_depth);
+  // The transformations between the device and the cameras are constant since
+  // the hardware will not change, we query them once right after the Tango
+  // Service connected and store them for efficiency.
+  ret = extrinsics_.Query();
   if (ret != TANGO_SUCCESS) {
     LOGE(
-        "SynchronizationApplication: Failed to get transform between the IMU "
-        "and depth camera frames. Something is wrong with device extrinsics.");
-    return ret;
+        "SynchronizationApplication: Failed to get the device extrinsics.");
   }
-  // Converting pose to transformation matrix.
-  glm::mat4 imu_T_depth = util::GetMatrixFromPose(&pose_imu_T_depth);
-
-  device_T_color_ = glm::inverse(imu_T_device) * imu_T_color;
-  device_T_depth_ = glm::inverse(imu_T_device) * imu_T_depth;
 
   return ret;
 }
 
+void SynchronizationApplication::TangoStart() {
+  // The intrinsics are queried again on connecting.
+  is_viewport_dirty_ = true;
+  startup_.Start();
+  energy_monitor_.Start();
+}
+
 void SynchronizationApplication::TangoDisconnect() {
+  // Connecting steps still running finish before the service disconnects.
+  startup_.Stop();
   TangoService_disconnect();
+  TANGO_GL_TRACE_DUMP(kTracePath);
+  if (tango_gl::ServiceProbe::IsEnabled()) {
+    LOGI("SynchronizationApplication: service probe\n%s",
+         tango_gl::ServiceProbe::GetReport().c_str());
+  }
+  energy_monitor_.Stop();
+  LOGI("SynchronizationApplication: energy\n%s",
+       energy_monitor_.GetReport().c_str());
 }
 
 void SynchronizationApplication::InitializeGLContent() {
+  // Anything RenderState remembers belongs to the previous GL context.
+  tango_gl::RenderState::Invalidate();
+  profiler_.Invalidate();
+  text_overlay_.Invalidate();
+  if (!text_overlay_.Initialize(tango_gl::TextOverlay::kDefaultFontPath,
+                                kProfilerTextSize)) {
+    LOGE("SynchronizationApplication: Profiler overlay is not available.");
+  }
+
   depth_image_.InitializeGL();
   color_image_.InitializeGL();
+  color_frames_.InitializeGL();
   main_scene_.InitializeGL();
 }
 
 void SynchronizationApplication::SetViewPort(int width, int height) {
   screen_width_ = static_cast<float>(width);
   screen_height_ = static_cast<float>(height);
-  main_scene_.SetupViewPort(width, height);
+  is_viewport_dirty_ = true;
+}
+
+void SynchronizationApplication::UpdateViewport() {
+  main_scene_.SetupViewPort(static_cast<int>(screen_width_),
+                            static_cast<int>(screen_height_));
+
+  // The depth image is projected with the pinhole model, undistort the color
+  // image to match it, for display and for guiding the bilateral
+  // upsampling. The map is baked once per connection.
+  const tango_gl::CameraIntrinsicsRegistry::DistortionMap* distortion_map =
+      camera_intrinsics_.GetDistortionMap(
+          TANGO_CAMERA_COLOR, tango_gl::UndistortionMesh::kDefaultGridWidth,
+          tango_gl::UndistortionMesh::kDefaultGridHeight);
+  main_scene_.SetCameraDistortionMap(distortion_map);
+  depth_image_.SetCameraDistortionMap(distortion_map);
+
+  // Kept color frames are copied at the color camera resolution.
+  TangoCameraIntrinsics color_camera_intrinsics;
+  if (camera_intrinsics_.GetIntrinsics(TANGO_CAMERA_COLOR,
+                                       &color_camera_intrinsics) ==
+      TANGO_SUCCESS) {
+    color_frames_.SetImageSize(
+        static_cast<GLsizei>(color_camera_intrinsics.width),
+        static_cast<GLsizei>(color_camera_intrinsics.height));
+  }
 }
 
 void SynchronizationApplication::Render() {
+  TANGO_GL_TRACE_THREAD_NAME("GLThread");
+  TANGO_GL_TRACE_SCOPE("Render");
+  tango_gl::RenderState::BeginFrame();
+
+  // Nothing can be drawn before the connection and the GL content are up.
+  startup_.RunGLTasks();
+  if (startup_.IsStarted() && !startup_.IsComplete()) {
+    tango_gl::RenderPass::Options pass;
+    pass.clear_color = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+    tango_gl::RenderPass::Begin(0, static_cast<GLsizei>(screen_width_),
+                                static_cast<GLsizei>(screen_height_), pass);
+    tango_gl::RenderPass::End();
+    return;
+  }
+  if (is_viewport_dirty_.exchange(false)) {
+    UpdateViewport();
+  }
+
+  profiler_.BeginFrame();
+  if (quality_governor_.Update(&profiler_)) {
+    ApplyQualityLevel();
+  }
+  profiler_.SetCounter("quality", quality_governor_.GetLevel());
+  profiler_.SetCounter(
+      "memoryMB",
+      tango_gl::MemoryTracker::GetTotal().bytes / (1024.0f * 1024.0f));
+  // Hot path counts of the previous frame, shown in the overlay with their
+  // p50 and p99.
+  for (int i = 0; i < tango_gl::Counters::kCounterCount; ++i) {
+    const tango_gl::Counters::Counter counter =
+        static_cast<tango_gl::Counters::Counter>(i);
+    profiler_.SetCounter(tango_gl::Counters::GetName(counter),
+                         tango_gl::Counters::GetFrameValue(counter));
+  }
+  // Only the bilateral upsampling is held to a GPU budget, the other paths
+  // would feed the governor GPU times it can not act on.
+  if (bilateral_upsample_ && bilateral_governor_.Update(&profiler_)) {
+    ApplyQualityLevel();
+  }
+  energy_monitor_.OnFrame();
+  energy_monitor_.Update(&profiler_);
+
   double color_timestamp = 0.0;
-  double depth_timestamp = 0.0;
-  bool new_points = false;
+  // The read slot keeps the previous frame when no new one arrived.
+  const bool new_points = depth_frames_.Acquire();
+  const DepthFrame* depth_frame = depth_frames_.GetReadBuffer();
+  const std::vector<float>& render_point_cloud_buffer = depth_frame->points;
+  const double depth_timestamp = depth_frame->timestamp;
+  // We need to make sure that we update the texture associated with the color
+  // image.
   {
-    std::lock_guard<std::mutex> lock(point_cloud_mutex_);
-    depth_timestamp = depth_timestamp_;
-    if (swap_signal) {
-      shared_point_cloud_buffer_.swap(render_point_cloud_buffer_);
-      swap_signal = false;
-      new_points = true;
+    tango_gl::ScopedCpuZone zone(&profiler_, "updateTexture");
+    tango_gl::ServiceProbe::ScopedCall probe(
+        tango_gl::ServiceProbe::kUpdateTexture);
+    if (TangoService_updateTexture(TANGO_CAMERA_COLOR, &color_timestamp) !=
+        TANGO_SUCCESS) {
+      LOGE("SynchronizationApplication: Failed to get a color image.");
     }
   }
-  // We need to make sure that we update the texture associated with the color
-  // image.
-  if (TangoService_updateTexture(TANGO_CAMERA_COLOR, &color_timestamp) !=
-      TANGO_SUCCESS) {
-    LOGE("SynchronizationApplication: Failed to get a color image.");
+  // TangoService_updateTexture() binds the camera texture directly.
+  tango_gl::RenderState::Invalidate();
+
+  // With color frame matching, the depth is drawn over the kept color frame
+  // captured closest to it rather than over the latest one. The color image
+  // is then as late as the depth, but the device barely moves between the
+  // two timestamps.
+  GLuint color_texture = color_image_.GetTextureId();
+  GLenum color_texture_target = GL_TEXTURE_EXTERNAL_OES;
+  if (color_frame_matching_) {
+    tango_gl::ScopedCpuZone zone(&profiler_, "colorFrames");
+    tango_gl::ScopedGpuZone gpu_zone(&profiler_, "colorFrames");
+    color_frames_.Push(color_texture, color_timestamp);
+    if (color_frames_.GetNearestFrame(depth_timestamp, &color_texture,
+                                      &color_timestamp)) {
+      color_texture_target = GL_TEXTURE_2D;
+    }
   }
 
-  // Querying the depth image's frame transformation based on the depth image's
-  // timestamp.
-  TangoPoseData pose_start_service_T_device_t0;
-  TangoCoordinateFramePair depth_frame_pair;
-  depth_frame_pair.base = TANGO_COORDINATE_FRAME_START_OF_SERVICE;
-  depth_frame_pair.target = TANGO_COORDINATE_FRAME_DEVICE;
-  if (TangoService_getPoseAtTime(depth_timestamp, depth_frame_pair,
-                                 &pose_start_service_T_device_t0) !=
-      TANGO_SUCCESS) {
-    LOGE(
-        "SynchronizationApplication: Could not find a valid pose at time %lf"
-        " for the depth camera.",
-        depth_timestamp);
-  }
-
-  // Querying the color image's frame transformation based on the depth image's
-  // timestamp.
-  TangoPoseData pose_start_service_T_device_t1;
-  TangoCoordinateFramePair color_frame_pair;
-  color_frame_pair.base = TANGO_COORDINATE_FRAME_START_OF_SERVICE;
-  color_frame_pair.target = TANGO_COORDINATE_FRAME_DEVICE;
-  if (TangoService_getPoseAtTime(color_timestamp, color_frame_pair,
-                                 &pose_start_service_T_device_t1) !=
-      TANGO_SUCCESS) {
-    LOGE(
-        "SynchronizationApplication: Could not find a valid pose at time %lf"
-        " for the color camera.",
-        color_timestamp);
+  glm::mat4 color_image_t1_T_depth_image_t0;
+  bool is_registered;
+  {
+    tango_gl::ScopedCpuZone zone(&profiler_, "getPoseAtTime");
+    is_registered = GetColorTDepth(color_timestamp, depth_timestamp,
+                                   &color_image_t1_T_depth_image_t0);
+  }
+  has_unprocessed_points_ = has_unprocessed_points_ || new_points;
+  if (is_registered) {
+    if (is_motion_gate_dirty_.exchange(false)) {
+      motion_gate_.Reset();
+    }
+    const bool should_upsample =
+        motion_gate_.ShouldProcess(pose_history_, color_timestamp);
+    profiler_.SetCounter("still", motion_gate_.IsStill() ? 1.0f : 0.0f);
+    if (should_upsample) {
+      const bool has_new_points = has_unprocessed_points_;
+      has_unprocessed_points_ = false;
+      tango_gl::ScopedCpuZone zone(&profiler_, "upsample");
+      tango_gl::ScopedGpuZone gpu_zone(&profiler_, "upsample");
+      if (bilateral_upsample_) {
+        depth_image_.UpsampleDepthBilateral(
+            color_image_t1_T_depth_image_t0, render_point_cloud_buffer,
+            has_new_points, color_texture, color_texture_target);
+      } else if (gpu_upsample_) {
+        depth_image_.RenderDepthToTexture(color_image_t1_T_depth_image_t0,
+                                          render_point_cloud_buffer,
+                                          has_new_points, color_timestamp);
+      } else if (parallel_upsample_) {
+        depth_image_.UpdateAndUpsampleDepthParallel(
+            color_image_t1_T_depth_image_t0, render_point_cloud_buffer);
+      } else {
+        depth_image_.UpdateAndUpsampleDepth(color_image_t1_T_depth_image_t0,
+                                            render_point_cloud_buffer,
+                                            depth_frame->image_points);
+      }
+    }
+  }
+
+  // The offscreen passes of the frame are done, everything else draws into
+  // the one pass on the window.
+  main_scene_.BeginRenderPass();
+  if (is_registered) {
+    {
+      tango_gl::ScopedCpuZone zone(&profiler_, "scene");
+      tango_gl::ScopedGpuZone gpu_zone(&profiler_, "scene");
+      main_scene_.Render(color_texture, color_texture_target,
+                         depth_image_.GetTextureId());
+    }
+    startup_.MarkFirstFrame();
+  }
+
+  if (is_profiler_overlay_on_) {
+    text_overlay_.Render(profiler_.GetReport(), kProfilerTextMargin,
+                         kProfilerTextMargin, screen_width_, screen_height_);
+  }
+  tango_gl::RenderPass::End();
+}
+
+void SynchronizationApplication::SetDepthAlphaValue(float alpha) {
+  main_scene_.SetDepthAlphaValue(alpha);
+}
+
+void SynchronizationApplication::SetGPUUpsample(bool on) {
+  gpu_upsample_ = on;
+  is_motion_gate_dirty_ = true;
+  UpdateEnergyState();
+}
+
+void SynchronizationApplication::SetBilateralUpsample(bool on) {
+  bilateral_upsample_ = on;
+  is_motion_gate_dirty_ = true;
+  UpdateEnergyState();
+}
+
+void SynchronizationApplication::SetColorFrameMatching(bool on) {
+  color_frame_matching_ = on;
+  is_motion_gate_dirty_ = true;
+}
+
+void SynchronizationApplication::SetParallelUpsample(bool on) {
+  parallel_upsample_ = on;
+  is_motion_gate_dirty_ = true;
+  UpdateEnergyState();
+}
+
+void SynchronizationApplication::SetHoleFilling(bool on) {
+  depth_image_.SetHoleFilling(on);
+  is_motion_gate_dirty_ = true;
+}
+
+void SynchronizationApplication::SetProfilerOverlay(bool on) {
+  is_profiler_overlay_on_ = on;
+}
+
+std::string SynchronizationApplication::GetProfilerReport() const {
+  return profiler_.GetReport() + tango_gl::MemoryTracker::GetReport() +
+         startup_.GetReport() + tango_gl::ServiceProbe::GetReport();
+}
+
+void SynchronizationApplication::SetMemoryBudget(size_t bytes) {
+  tango_gl::MemoryTracker::SetBudget(bytes);
+}
+
+void SynchronizationApplication::SetServiceProbe(bool on) {
+  if (on && !tango_gl::ServiceProbe::IsEnabled()) {
+    tango_gl::ServiceProbe::Reset();
+  }
+  tango_gl::ServiceProbe::SetEnabled(on);
+}
+
+void SynchronizationApplication::ApplyQualityLevel() {
+  const UpsampleQuality& quality =
+      kUpsampleQualityLadder[quality_governor_.GetLevel()];
+  depth_image_.SetWindowSize(quality.window_size);
+  upsample_point_count_ = quality.point_count;
+
+  const BilateralQuality& bilateral =
+      kBilateralQualityLadder[bilateral_governor_.GetLevel()];
+  depth_image_.SetBilateralQuality(bilateral.output_scale, bilateral.radius);
+  motion_gate_.Reset();
+  UpdateEnergyState();
+}
+
+void SynchronizationApplication::UpdateEnergyState() {
+  char state[64];
+  if (bilateral_upsample_) {
+    snprintf(state, sizeof(state), "bilateral %d",
+             bilateral_governor_.GetLevel());
+  } else {
+    snprintf(state, sizeof(state), "%s %d",
+             gpu_upsample_ ? "gpu"
+                           : (parallel_upsample_ ? "parallel" : "cpu"),
+             quality_governor_.GetLevel());
+  }
+  energy_monitor_.SetState(state);
+}
+
+bool SynchronizationApplication::GetColorTDepth(
+    double color_timestamp, double depth_timestamp,
+    glm::mat4* color_t1_T_depth_t0) {
+  // The pairing only changes when a depth or color frame arrives, most frames
+  // reuse the last registration without looking up any pose.
+  if (registration_.is_valid &&
+      registration_.color_timestamp == color_timestamp &&
+      registration_.depth_timestamp == depth_timestamp) {
+    *color_t1_T_depth_t0 = registration_.color_T_depth;
+    return true;
   }
 
   // In the following code, we define t0 as the depth timestamp and t1 as the
@@ -289,64 +661,82 @@ void SynchronizationApplication::Render() {
   //
   // Device frame at timestamp t0 (depth timestamp) with respect to start of
   // service.
-  glm::mat4 start_service_T_device_t0 =
-      util::GetMatrixFromPose(&pose_start_service_T_device_t0);
+  tango_gl::RigidTransform start_service_T_device_t0;
   // Device frame at timestamp t1 (color timestamp) with respect to start of
   // service.
-  glm::mat4 start_service_T_device_t1 =
-      util::GetMatrixFromPose(&pose_start_service_T_device_t1);
+  tango_gl::RigidTransform start_service_T_device_t1;
+  // Note that we are discarding all invalid poses at the moment, another
+  // option could be to use the latest pose when the queried pose is invalid.
+  if (!GetStartServiceTDevice(color_timestamp, &start_service_T_device_t1)) {
+    LOGE("Invalid pose for ss_t_color at time: %lf", color_timestamp);
+    return false;
+  }
+  if (!GetStartServiceTDevice(depth_timestamp, &start_service_T_device_t0)) {
+    LOGE("Invalid pose for ss_t_depth at time: %lf", depth_timestamp);
+    return false;
+  }
 
   // Transformation of depth frame wrt Device at time stamp t0.
   // Transformation of depth frame with respect to the device frame at
   // time stamp t0. This transformation remains constant over time. Here we
   // assign to a local variable to maintain naming consistency when calculating
   // the transform: color_image_t1_T_depth_image_t0.
-  glm::mat4 device_t0_T_depth_t0 = device_T_depth_;
+  const glm::mat4& device_t0_T_depth_t0 = extrinsics_.GetDeviceTDepth();
 
   // Transformation of Device Frame wrt Color Image frame at time stamp t1.
   // Transformation of device frame with respect to the color camera frame at
   // time stamp t1. This transformation remains constant over time. Here we
   // assign to a local variable to maintain naming consistency when calculating
   // the transform: color_image_t1_T_depth_image_t0.
-  glm::mat4 color_t1_T_device_t1 = glm::inverse(device_T_color_);
-
-  if (pose_start_service_T_device_t1.status_code == TANGO_POSE_VALID) {
-    if (pose_start_service_T_device_t0.status_code == TANGO_POSE_VALID) {
-      // Note that we are discarding all invalid poses at the moment, another
-      // option could be to use the latest pose when the queried pose is
-      // invalid.
-
-      // The Color Camera frame at timestamp t0 with respect to Depth
-      // Camera frame at timestamp t1.
-      glm::mat4 color_image_t1_T_depth_image_t0 =
-          color_t1_T_device_t1 * glm::inverse(start_service_T_device_t1) *
-          start_service_T_device_t0 * device_t0_T_depth_t0;
-
-      if(gpu_upsample_) {
-        depth_image_.RenderDepthToTexture(color_image_t1_T_depth_image_t0,
-                                          render_point_cloud_buffer_,
-                                          new_points);
-      } else {
-        depth_image_.UpdateAndUpsampleDepth(color_image_t1_T_depth_image_t0,
-                                            render_point_cloud_buffer_);
-
-      }
-      main_scene_.Render(color_image_.GetTextureId(),
-                         depth_image_.GetTextureId());
-    } else {
-      LOGE("Invalid pose for ss_t_depth at time: %lf", depth_timestamp);
-    }
-  } else {
-    LOGE("Invalid pose for ss_t_color at time: %lf", color_timestamp);
-  }
+  const glm::mat4& color_t1_T_device_t1 = extrinsics_.GetColorTDevice();
+
+  // The Color Camera frame at timestamp t0 with respect to Depth
+  // Camera frame at timestamp t1.
+  // Both device poses are rigid, so the motion of the device between t0
+  // and t1 is composed without a general matrix inverse.
+  const tango_gl::RigidTransform device_t1_T_device_t0 =
+      start_service_T_device_t1.Inverse() * start_service_T_device_t0;
+  *color_t1_T_depth_t0 = color_t1_T_device_t1 *
+                         device_t1_T_device_t0.ToMatrix() *
+                         device_t0_T_depth_t0;
+
+  registration_.is_valid = true;
+  registration_.color_timestamp = color_timestamp;
+  registration_.depth_timestamp = depth_timestamp;
+  registration_.color_T_depth = *color_t1_T_depth_t0;
+  return true;
 }
 
-void SynchronizationApplication::SetDepthAlphaValue(float alpha) {
-  main_scene_.SetDepthAlphaValue(alpha);
-}
+bool SynchronizationApplication::GetStartServiceTDevice(
+    double timestamp, tango_gl::RigidTransform* start_service_T_device) {
+  if (pose_history_.GetPose(timestamp, start_service_T_device)) {
+    return true;
+  }
 
-void SynchronizationApplication::SetGPUUpsample(bool on) {
-  gpu_upsample_ = on;
+  TangoCoordinateFramePair frame_pair;
+  frame_pair.base = TANGO_COORDINATE_FRAME_START_OF_SERVICE;
+  frame_pair.target = TANGO_COORDINATE_FRAME_DEVICE;
+  TangoPoseData pose_start_service_T_device;
+  TangoErrorType ret;
+  {
+    tango_gl::ServiceProbe::ScopedCall probe(
+        tango_gl::ServiceProbe::kGetPoseAtTime);
+    ret = TangoService_getPoseAtTime(timestamp, frame_pair,
+                                     &pose_start_service_T_device);
+  }
+  if (ret != TANGO_SUCCESS) {
+    LOGE(
+        "SynchronizationApplication: Could not find a valid pose at time %lf.",
+        timestamp);
+    return false;
+  }
+  if (pose_start_service_T_device.status_code != TANGO_POSE_VALID) {
+    return false;
+  }
+  *start_service_T_device = tango_gl::conversions::TransformFromArrays(
+      pose_start_service_T_device.translation,
+      pose_start_service_T_device.orientation);
+  return true;
 }
 
 }  // namespace rgb_depth_sync
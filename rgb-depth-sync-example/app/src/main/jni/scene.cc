@@ -15,6 +15,7 @@
  */
 
 #include "tango-gl/conversions.h"
+#include "tango-gl/render_pass.h"
 
 #include "rgb-depth-sync/scene.h"
 
@@ -36,7 +37,8 @@ void Scene::SetCameraIntrinsics(const TangoCameraIntrinsics& cc_intrinsics) {
   image_plane_ratio_ = image_height / image_width;
 }
 
-Scene::Scene() {
+Scene::Scene()
+    : viewport_x_(0), viewport_y_(0), viewport_width_(0), viewport_height_(0) {
   OW_T_W_ = tango_gl::conversions::opengl_world_T_tango_world();
   CC_T_OC_ = tango_gl::conversions::color_camera_T_opengl_camera();
 
@@ -70,17 +72,24 @@ void Scene::SetupViewPort(int screen_width, int screen_height) {
   }
 }
 
+void Scene::BeginRenderPass() {
+  // The clear also fills the bars around a letterboxed viewport.
+  tango_gl::RenderPass::Options pass;
+  pass.clear_color = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+  pass.depth_load = tango_gl::RenderPass::kDontCare;
+  tango_gl::RenderPass::Begin(0, viewport_x_, viewport_y_, viewport_width_,
+                              viewport_height_, pass);
+}
+
 // We'll render the scene from a pose.
-void Scene::Render(GLuint color_texture, GLuint depth_texture) {
+void Scene::Render(GLuint color_texture, GLenum color_texture_target,
+                   GLuint depth_texture) {
   if (color_texture == 0 || depth_texture == 0) {
     return;
   }
 
-  glViewport(viewport_x_, viewport_y_, viewport_width_, viewport_height_);
-
-  glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-  glClear(GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT);
   camera_texture_drawable_.SetColorTextureId(color_texture);
+  camera_texture_drawable_.SetColorTextureTarget(color_texture_target);
   camera_texture_drawable_.SetDepthTextureId(depth_texture);
   camera_texture_drawable_.RenderImage();
 }
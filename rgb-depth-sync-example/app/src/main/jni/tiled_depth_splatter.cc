@@ -0,0 +1,139 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+
+#include <tango-gl/depth_pipeline.h>
+
+#include "rgb-depth-sync/tiled_depth_splatter.h"
+
+namespace rgb_depth_sync {
+
+TiledDepthSplatter::TiledDepthSplatter()
+    : worker_pool_(&tango_gl::WorkerPool::GetShared()),
+      image_width_(0),
+      image_height_(0),
+      tiles_x_(0),
+      tiles_y_(0),
+      chunk_count_(0) {
+  chunk_count_ = worker_pool_->GetConcurrency();
+}
+
+TiledDepthSplatter::~TiledDepthSplatter() {}
+
+void TiledDepthSplatter::Splat(
+    const glm::mat4& color_t1_T_depth_t0, const std::vector<float>& points,
+    const tango_gl::projection::CameraIntrinsics& intrinsics, int window_size,
+    std::vector<uint16_t>* depth_map) {
+  image_width_ = intrinsics.width;
+  image_height_ = intrinsics.height;
+  tiles_x_ = (image_width_ + kTileSize - 1) / kTileSize;
+  tiles_y_ = (image_height_ + kTileSize - 1) / kTileSize;
+  bins_.resize(chunk_count_ * tiles_x_ * tiles_y_);
+  pixels_.resize(points.size() / 3);
+  depths_.resize(points.size() / 3);
+
+  size_t image_size = image_width_ * image_height_;
+  depth_map->resize(image_size);
+
+  worker_pool_->ParallelFor(chunk_count_, [&](int chunk) {
+    ProjectChunk(chunk, color_t1_T_depth_t0, points, intrinsics, window_size);
+  });
+
+  worker_pool_->ParallelFor(tiles_x_ * tiles_y_, [&](int tile) {
+    SplatTile(tile, window_size, depth_map);
+  });
+}
+
+void TiledDepthSplatter::ProjectChunk(
+    int chunk, const glm::mat4& color_t1_T_depth_t0,
+    const std::vector<float>& points,
+    const tango_gl::projection::CameraIntrinsics& intrinsics,
+    int window_size) {
+  const int tile_count = tiles_x_ * tiles_y_;
+  std::vector<ProjectedPoint>* chunk_bins = &bins_[chunk * tile_count];
+  for (int i = 0; i < tile_count; ++i) {
+    chunk_bins[i].clear();
+  }
+
+  const size_t point_count = points.size() / 3;
+  const size_t begin = point_count * chunk / chunk_count_;
+  const size_t end = point_count * (chunk + 1) / chunk_count_;
+  tango_gl::projection::ProjectPoints(
+      points.data() + begin * 3, end - begin, color_t1_T_depth_t0, intrinsics,
+      pixels_.data() + begin, depths_.data() + begin);
+
+  for (size_t i = begin; i < end; ++i) {
+    if (pixels_[i] == tango_gl::projection::kInvalidPixel) {
+      continue;
+    }
+    ProjectedPoint splat;
+    splat.pixel_x = tango_gl::projection::PixelX(pixels_[i]);
+    splat.pixel_y = tango_gl::projection::PixelY(pixels_[i]);
+    splat.millimeters =
+        tango_gl::depth_pipeline::SplatDepth::ToMillimeters(depths_[i]);
+
+    // Bin the splat into every tile its window overlaps.
+    int tile_x0 = std::max(0, splat.pixel_x - window_size) / kTileSize;
+    int tile_x1 =
+        std::min(image_width_ - 1, splat.pixel_x + window_size) / kTileSize;
+    int tile_y0 = std::max(0, splat.pixel_y - window_size) / kTileSize;
+    int tile_y1 =
+        std::min(image_height_ - 1, splat.pixel_y + window_size) / kTileSize;
+    for (int tile_y = tile_y0; tile_y <= tile_y1; ++tile_y) {
+      for (int tile_x = tile_x0; tile_x <= tile_x1; ++tile_x) {
+        chunk_bins[tile_y * tiles_x_ + tile_x].push_back(splat);
+      }
+    }
+  }
+}
+
+void TiledDepthSplatter::SplatTile(int tile, int window_size,
+                                   std::vector<uint16_t>* depth_map) {
+  const int tile_count = tiles_x_ * tiles_y_;
+  const int x0 = (tile % tiles_x_) * kTileSize;
+  const int y0 = (tile / tiles_x_) * kTileSize;
+  const int x1 = std::min(x0 + kTileSize, image_width_);
+  const int y1 = std::min(y0 + kTileSize, image_height_);
+
+  uint16_t* depth = depth_map->data();
+  for (int y = y0; y < y1; ++y) {
+    std::fill(depth + y * image_width_ + x0, depth + y * image_width_ + x1,
+              0);
+  }
+
+  for (int chunk = 0; chunk < chunk_count_; ++chunk) {
+    const std::vector<ProjectedPoint>& bin = bins_[chunk * tile_count + tile];
+    for (const ProjectedPoint& splat : bin) {
+      const int splat_x0 = std::max(x0, splat.pixel_x - window_size);
+      const int splat_x1 = std::min(x1, splat.pixel_x + window_size + 1);
+      const int splat_y0 = std::max(y0, splat.pixel_y - window_size);
+      const int splat_y1 = std::min(y1, splat.pixel_y + window_size + 1);
+
+      for (int y = splat_y0; y < splat_y1; ++y) {
+        uint16_t* depth_row = depth + y * image_width_;
+        for (int x = splat_x0; x < splat_x1; ++x) {
+          // Nearest point wins, 0 marks a pixel without depth.
+          if (depth_row[x] == 0 || splat.millimeters < depth_row[x]) {
+            depth_row[x] = splat.millimeters;
+          }
+        }
+      }
+    }
+  }
+}
+
+}  // namespace rgb_depth_sync
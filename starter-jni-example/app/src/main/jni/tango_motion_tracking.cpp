@@ -22,6 +22,7 @@
 
 #include "tango-gl/camera.h"
 #include "tango-gl/grid.h"
+#include "tango-gl/render_state.h"
 #include "tango-gl/util.h"
 
 GLuint screen_width;
@@ -43,6 +44,9 @@ glm::vec3 position;
 glm::quat rotation;
 
 bool SetupGraphics(int w, int h) {
+  // Anything RenderState remembers belongs to the previous GL context.
+  tango_gl::RenderState::Invalidate();
+
   screen_width = w;
   screen_height = h;
 
@@ -51,6 +55,7 @@ bool SetupGraphics(int w, int h) {
 
   cam = new tango_gl::Camera();
   grid = new tango_gl::Grid();
+  grid->SetProcedural(true);
 
   if (h == 0) {
     LOGE("Setup graphic height not valid");
@@ -62,8 +67,10 @@ bool SetupGraphics(int w, int h) {
 
 // Render current frame.
 bool RenderFrame() {
-  glEnable(GL_DEPTH_TEST);
-  glEnable(GL_CULL_FACE);
+  tango_gl::RenderState::BeginFrame();
+
+  tango_gl::RenderState::Enable(GL_DEPTH_TEST);
+  tango_gl::RenderState::Enable(GL_CULL_FACE);
 
   glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
   glClear(GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT);
@@ -0,0 +1,737 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "tango-gl/anchor_store.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+namespace {
+using tango_gl::anchor::AnchorRecord;
+using tango_gl::anchor::CellBucket;
+using tango_gl::anchor::FileHeader;
+using tango_gl::anchor::IdEntry;
+using tango_gl::anchor::JournalEntry;
+using tango_gl::anchor::JournalHeader;
+
+uint64_t CellKeyOf(const float position[3], float cell_size) {
+  return tango_gl::anchor::CellKey(
+      static_cast<int32_t>(std::floor(position[0] / cell_size)),
+      static_cast<int32_t>(std::floor(position[1] / cell_size)),
+      static_cast<int32_t>(std::floor(position[2] / cell_size)));
+}
+
+void ToAnchor(const AnchorRecord& record, const void* payload,
+              size_t payload_size, tango_gl::AnchorStore::Anchor* anchor) {
+  anchor->id = record.id;
+  anchor->position = glm::vec3(record.position[0], record.position[1],
+                               record.position[2]);
+  anchor->orientation =
+      glm::quat(record.orientation[3], record.orientation[0],
+                record.orientation[1], record.orientation[2]);
+  anchor->scale =
+      glm::vec3(record.scale[0], record.scale[1], record.scale[2]);
+  anchor->payload = payload;
+  anchor->payload_size = payload_size;
+}
+
+bool IsWithin(const AnchorRecord& record, const glm::vec3& center,
+              float squared_radius) {
+  const glm::vec3 offset =
+      glm::vec3(record.position[0], record.position[1], record.position[2]) -
+      center;
+  return glm::dot(offset, offset) <= squared_radius;
+}
+
+// Range of cells of cell_size meters within radius of center, and the
+// number of cells in it.
+double GetCellRange(const glm::vec3& center, float radius, float cell_size,
+                    int32_t min_cell[3], int32_t max_cell[3]) {
+  double cell_count = 1.0;
+  for (int axis = 0; axis < 3; ++axis) {
+    const double low = std::floor((center[axis] - radius) / cell_size);
+    const double high = std::floor((center[axis] + radius) / cell_size);
+    min_cell[axis] = static_cast<int32_t>(
+        std::max(low, -static_cast<double>(tango_gl::anchor::kCellKeyBias)));
+    max_cell[axis] = static_cast<int32_t>(std::min(
+        high, static_cast<double>(tango_gl::anchor::kCellKeyBias - 1)));
+    cell_count *= high - low + 1.0;
+  }
+  return cell_count;
+}
+
+// Write a file next to its final path and rename it into place, so an
+// interrupted write never leaves a truncated anchor file behind.
+bool WriteFile(const std::string& path, const std::vector<uint8_t>& image) {
+  const std::string temp_path = path + ".tmp";
+  FILE* file = fopen(temp_path.c_str(), "wb");
+  if (file == NULL) {
+    return false;
+  }
+  // The journal is emptied once the file is renamed, it has to be on disk
+  // by then.
+  bool is_written =
+      fwrite(image.data(), 1, image.size(), file) == image.size() &&
+      fflush(file) == 0 && fsync(fileno(file)) == 0;
+  is_written = fclose(file) == 0 && is_written;
+  if (!is_written || rename(temp_path.c_str(), path.c_str()) != 0) {
+    unlink(temp_path.c_str());
+    return false;
+  }
+  return true;
+}
+}  // namespace
+
+namespace tango_gl {
+
+AnchorStore::AnchorStore(const Options& options)
+    : options_(options),
+      journal_file_(-1),
+      journal_size_(0),
+      journal_entry_count_(0),
+      mapping_(nullptr),
+      mapping_size_(0),
+      header_(),
+      buckets_(nullptr),
+      records_(nullptr),
+      ids_(nullptr),
+      payloads_(nullptr),
+      anchor_count_(0) {}
+
+AnchorStore::~AnchorStore() { Close(); }
+
+bool AnchorStore::Open(const std::string& directory,
+                       const std::string& adf_uuid) {
+  if (IsOpen()) {
+    return false;
+  }
+  anchor_path_ = directory + "/" + adf_uuid + ".anchors";
+  journal_path_ = anchor_path_ + ".journal";
+  if (!MapAnchorFile()) {
+    return false;
+  }
+  if (!ReplayJournal()) {
+    UnmapAnchorFile();
+    edits_.clear();
+    edit_cells_.clear();
+    return false;
+  }
+  return true;
+}
+
+void AnchorStore::Close() {
+  if (!IsOpen()) {
+    return;
+  }
+  fdatasync(journal_file_);
+  close(journal_file_);
+  journal_file_ = -1;
+  journal_size_ = 0;
+  journal_entry_count_ = 0;
+  UnmapAnchorFile();
+  edits_.clear();
+  edit_cells_.clear();
+  anchor_count_ = 0;
+}
+
+bool AnchorStore::Put(const Anchor& anchor) {
+  if (!IsOpen() || anchor.payload_size > UINT32_MAX) {
+    return false;
+  }
+  JournalEntry entry = JournalEntry();
+  entry.op = anchor::kPut;
+  entry.payload_size = static_cast<uint32_t>(anchor.payload_size);
+  AnchorRecord& record = entry.record;
+  record.id = anchor.id;
+  for (int axis = 0; axis < 3; ++axis) {
+    record.position[axis] = anchor.position[axis];
+    record.scale[axis] = anchor.scale[axis];
+  }
+  record.orientation[0] = anchor.orientation.x;
+  record.orientation[1] = anchor.orientation.y;
+  record.orientation[2] = anchor.orientation.z;
+  record.orientation[3] = anchor.orientation.w;
+  record.payload_size = entry.payload_size;
+  if (!AppendJournal(entry, anchor.payload)) {
+    return false;
+  }
+  ApplyPut(record, anchor.payload);
+  if (journal_entry_count_ >= options_.max_journal_entries) {
+    // The edit is in the journal either way.
+    Compact();
+  }
+  return true;
+}
+
+bool AnchorStore::Remove(uint64_t id) {
+  if (!IsOpen()) {
+    return false;
+  }
+  if (!IsStored(id)) {
+    return true;
+  }
+  JournalEntry entry = JournalEntry();
+  entry.op = anchor::kRemove;
+  entry.record.id = id;
+  if (!AppendJournal(entry, nullptr)) {
+    return false;
+  }
+  ApplyRemove(id);
+  if (journal_entry_count_ >= options_.max_journal_entries) {
+    Compact();
+  }
+  return true;
+}
+
+bool AnchorStore::Find(uint64_t id, Anchor* anchor) const {
+  std::unordered_map<uint64_t, Edit>::const_iterator edit = edits_.find(id);
+  if (edit != edits_.end()) {
+    if (edit->second.is_removed) {
+      return false;
+    }
+    ToAnchor(edit->second.record, edit->second.payload.data(),
+             edit->second.payload.size(), anchor);
+    return true;
+  }
+  const AnchorRecord* record = FindRecord(id);
+  if (record == nullptr) {
+    return false;
+  }
+  GetMappedAnchor(*record, anchor);
+  return true;
+}
+
+size_t AnchorStore::Query(const glm::vec3& center, float radius,
+                          std::vector<Anchor>* anchors) const {
+  anchors->clear();
+  if (!(radius >= 0.0f)) {
+    return 0;
+  }
+  const float squared_radius = radius * radius;
+  Anchor anchor;
+  int32_t min_cell[3];
+  int32_t max_cell[3];
+
+  // Mapped anchors not edited since.
+  const uint32_t record_count = header_.anchor_count;
+  auto add_record = [&](const AnchorRecord& record) {
+    if ((edits_.empty() || edits_.count(record.id) == 0) &&
+        IsWithin(record, center, squared_radius)) {
+      GetMappedAnchor(record, &anchor);
+      anchors->push_back(anchor);
+    }
+  };
+  if (record_count > 0 &&
+      GetCellRange(center, radius, header_.cell_size, min_cell, max_cell) <=
+          record_count) {
+    const uint64_t mask = header_.bucket_count - 1;
+    for (int32_t z = min_cell[2]; z <= max_cell[2]; ++z) {
+      for (int32_t y = min_cell[1]; y <= max_cell[1]; ++y) {
+        for (int32_t x = min_cell[0]; x <= max_cell[0]; ++x) {
+          const uint64_t key = anchor::CellKey(x, y, z);
+          uint64_t slot = anchor::HashCellKey(key) & mask;
+          for (uint32_t probe = 0; probe < header_.bucket_count; ++probe) {
+            const CellBucket& bucket = buckets_[slot];
+            if (bucket.key == anchor::kEmptyCell) {
+              break;
+            }
+            if (bucket.key == key) {
+              const uint32_t end = std::min(
+                  record_count, bucket.first_record + bucket.record_count);
+              for (uint32_t i = bucket.first_record; i < end; ++i) {
+                add_record(records_[i]);
+              }
+              break;
+            }
+            slot = (slot + 1) & mask;
+          }
+        }
+      }
+    }
+  } else {
+    // More cells than anchors, reading them all is cheaper.
+    for (uint32_t i = 0; i < record_count; ++i) {
+      add_record(records_[i]);
+    }
+  }
+
+  // Anchors put since.
+  auto add_cell = [&](const std::vector<uint64_t>& ids) {
+    for (uint64_t id : ids) {
+      const Edit& edit = edits_.find(id)->second;
+      if (IsWithin(edit.record, center, squared_radius)) {
+        ToAnchor(edit.record, edit.payload.data(), edit.payload.size(),
+                 &anchor);
+        anchors->push_back(anchor);
+      }
+    }
+  };
+  if (edit_cells_.empty()) {
+    return anchors->size();
+  }
+  if (GetCellRange(center, radius, options_.cell_size, min_cell, max_cell) <=
+      edit_cells_.size()) {
+    for (int32_t z = min_cell[2]; z <= max_cell[2]; ++z) {
+      for (int32_t y = min_cell[1]; y <= max_cell[1]; ++y) {
+        for (int32_t x = min_cell[0]; x <= max_cell[0]; ++x) {
+          std::unordered_map<uint64_t, std::vector<uint64_t>>::const_iterator
+              cell = edit_cells_.find(anchor::CellKey(x, y, z));
+          if (cell != edit_cells_.end()) {
+            add_cell(cell->second);
+          }
+        }
+      }
+    }
+  } else {
+    for (const auto& cell : edit_cells_) {
+      add_cell(cell.second);
+    }
+  }
+  return anchors->size();
+}
+
+bool AnchorStore::Compact() {
+  if (!IsOpen()) {
+    return false;
+  }
+  struct Item {
+    uint64_t cell;
+    const AnchorRecord* record;
+    const void* payload;
+  };
+  std::vector<Item> items;
+  items.reserve(anchor_count_);
+  uint64_t payload_size = 0;
+  Anchor anchor;
+  for (uint32_t i = 0; i < header_.anchor_count; ++i) {
+    const AnchorRecord& record = records_[i];
+    if (!edits_.empty() && edits_.count(record.id) != 0) {
+      continue;
+    }
+    GetMappedAnchor(record, &anchor);
+    items.push_back(
+        {CellKeyOf(record.position, options_.cell_size), &record,
+         anchor.payload});
+    payload_size += anchor.payload_size;
+  }
+  for (const auto& edit : edits_) {
+    if (!edit.second.is_removed) {
+      items.push_back(
+          {CellKeyOf(edit.second.record.position, options_.cell_size),
+           &edit.second.record, edit.second.payload.data()});
+      payload_size += edit.second.payload.size();
+    }
+  }
+  if (payload_size > UINT32_MAX) {
+    LOGE("AnchorStore: Payloads of %s too large.", anchor_path_.c_str());
+    return false;
+  }
+  std::sort(items.begin(), items.end(), [](const Item& a, const Item& b) {
+    return a.cell != b.cell ? a.cell < b.cell : a.record->id < b.record->id;
+  });
+
+  size_t cell_count = 0;
+  for (size_t i = 0; i < items.size(); ++i) {
+    if (i == 0 || items[i].cell != items[i - 1].cell) {
+      ++cell_count;
+    }
+  }
+  // At most half full, so probes stay short.
+  uint32_t bucket_count = 1;
+  while (bucket_count < 2 * cell_count) {
+    bucket_count <<= 1;
+  }
+
+  FileHeader header = FileHeader();
+  header.magic = anchor::kMagic;
+  header.version = anchor::kVersion;
+  header.anchor_count = static_cast<uint32_t>(items.size());
+  header.bucket_count = bucket_count;
+  header.cell_size = options_.cell_size;
+  header.bucket_offset = sizeof(FileHeader);
+  header.record_offset =
+      header.bucket_offset + bucket_count * sizeof(CellBucket);
+  header.id_offset =
+      header.record_offset + items.size() * sizeof(AnchorRecord);
+  header.payload_offset = header.id_offset + items.size() * sizeof(IdEntry);
+  header.payload_size = payload_size;
+
+  std::vector<uint8_t> image(header.payload_offset + payload_size);
+  memcpy(image.data(), &header, sizeof(header));
+  CellBucket* buckets =
+      reinterpret_cast<CellBucket*>(image.data() + header.bucket_offset);
+  for (uint32_t i = 0; i < bucket_count; ++i) {
+    buckets[i].key = anchor::kEmptyCell;
+  }
+  AnchorRecord* records =
+      reinterpret_cast<AnchorRecord*>(image.data() + header.record_offset);
+  IdEntry* ids = reinterpret_cast<IdEntry*>(image.data() + header.id_offset);
+  uint8_t* payloads = image.data() + header.payload_offset;
+  uint32_t payload_offset = 0;
+  for (size_t i = 0; i < items.size(); ++i) {
+    records[i] = *items[i].record;
+    records[i].payload_offset = payload_offset;
+    if (records[i].payload_size > 0) {
+      memcpy(payloads + payload_offset, items[i].payload,
+             records[i].payload_size);
+    }
+    payload_offset += records[i].payload_size;
+    ids[i].id = records[i].id;
+    ids[i].record = static_cast<uint32_t>(i);
+
+    if (i == 0 || items[i].cell != items[i - 1].cell) {
+      uint64_t slot = anchor::HashCellKey(items[i].cell) & (bucket_count - 1);
+      while (buckets[slot].key != anchor::kEmptyCell) {
+        slot = (slot + 1) & (bucket_count - 1);
+      }
+      buckets[slot].key = items[i].cell;
+      buckets[slot].first_record = static_cast<uint32_t>(i);
+    }
+  }
+  // Each cell's bucket was filled at its first record, count them now.
+  for (uint32_t i = 0; i < bucket_count; ++i) {
+    if (buckets[i].key != anchor::kEmptyCell) {
+      uint32_t end = buckets[i].first_record;
+      while (end < items.size() && items[end].cell == buckets[i].key) {
+        ++end;
+      }
+      buckets[i].record_count = end - buckets[i].first_record;
+    }
+  }
+  std::sort(ids, ids + items.size(), [](const IdEntry& a, const IdEntry& b) {
+    return a.id < b.id;
+  });
+
+  if (!WriteFile(anchor_path_, image)) {
+    LOGE("AnchorStore: Could not write %s.", anchor_path_.c_str());
+    return false;
+  }
+  image.clear();
+  UnmapAnchorFile();
+  edits_.clear();
+  edit_cells_.clear();
+  if (!MapAnchorFile()) {
+    // The journal is still there, the anchors are back when reopened.
+    Close();
+    return false;
+  }
+  // Replaying the journal over the new file would be harmless, emptying it
+  // only saves the time.
+  if (ftruncate(journal_file_, sizeof(JournalHeader)) == 0) {
+    journal_size_ = sizeof(JournalHeader);
+    journal_entry_count_ = 0;
+  } else {
+    LOGE("AnchorStore: Could not empty %s.", journal_path_.c_str());
+  }
+  return true;
+}
+
+bool AnchorStore::MapAnchorFile() {
+  header_ = FileHeader();
+  anchor_count_ = 0;
+  int fd = open(anchor_path_.c_str(), O_RDONLY);
+  if (fd < 0) {
+    if (errno == ENOENT) {
+      // No anchors yet.
+      return true;
+    }
+    LOGE("AnchorStore: Could not open %s.", anchor_path_.c_str());
+    return false;
+  }
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) != 0 ||
+      file_stat.st_size < static_cast<off_t>(sizeof(FileHeader))) {
+    LOGE("AnchorStore: %s is not an anchor file.", anchor_path_.c_str());
+    close(fd);
+    return false;
+  }
+  const size_t size = file_stat.st_size;
+  void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  // The mapping keeps the file referenced on its own.
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    LOGE("AnchorStore: Could not map %s.", anchor_path_.c_str());
+    return false;
+  }
+
+  FileHeader header;
+  memcpy(&header, mapping, sizeof(header));
+  const uint64_t count = header.anchor_count;
+  const bool is_valid =
+      header.magic == anchor::kMagic && header.version == anchor::kVersion &&
+      header.bucket_count > 0 &&
+      (header.bucket_count & (header.bucket_count - 1)) == 0 &&
+      header.cell_size > 0.0f && header.bucket_offset % 8 == 0 &&
+      header.record_offset % 8 == 0 && header.id_offset % 8 == 0 &&
+      header.bucket_offset >= sizeof(FileHeader) &&
+      header.bucket_offset + header.bucket_count * sizeof(CellBucket) <=
+          header.record_offset &&
+      header.record_offset + count * sizeof(AnchorRecord) <=
+          header.id_offset &&
+      header.id_offset + count * sizeof(IdEntry) <= header.payload_offset &&
+      header.payload_offset + header.payload_size <= size;
+  if (!is_valid) {
+    LOGE("AnchorStore: %s is not an anchor file.", anchor_path_.c_str());
+    munmap(mapping, size);
+    return false;
+  }
+  const uint8_t* base = static_cast<const uint8_t*>(mapping);
+  mapping_ = mapping;
+  mapping_size_ = size;
+  header_ = header;
+  buckets_ = reinterpret_cast<const CellBucket*>(base + header.bucket_offset);
+  records_ =
+      reinterpret_cast<const AnchorRecord*>(base + header.record_offset);
+  ids_ = reinterpret_cast<const IdEntry*>(base + header.id_offset);
+  payloads_ = base + header.payload_offset;
+  anchor_count_ = header.anchor_count;
+  return true;
+}
+
+void AnchorStore::UnmapAnchorFile() {
+  if (mapping_ != nullptr) {
+    munmap(mapping_, mapping_size_);
+  }
+  mapping_ = nullptr;
+  mapping_size_ = 0;
+  header_ = FileHeader();
+  buckets_ = nullptr;
+  records_ = nullptr;
+  ids_ = nullptr;
+  payloads_ = nullptr;
+}
+
+bool AnchorStore::ReplayJournal() {
+  journal_file_ =
+      open(journal_path_.c_str(), O_RDWR | O_CREAT | O_APPEND, 0644);
+  if (journal_file_ < 0) {
+    LOGE("AnchorStore: Could not open %s.", journal_path_.c_str());
+    return false;
+  }
+  journal_size_ = 0;
+  journal_entry_count_ = 0;
+  struct stat file_stat;
+  std::vector<uint8_t> contents;
+  if (fstat(journal_file_, &file_stat) == 0) {
+    contents.resize(file_stat.st_size);
+  }
+  size_t offset = 0;
+  while (offset < contents.size()) {
+    ssize_t count = pread(journal_file_, contents.data() + offset,
+                          contents.size() - offset, offset);
+    if (count <= 0) {
+      contents.resize(offset);
+      break;
+    }
+    offset += count;
+  }
+
+  size_t end = 0;
+  if (contents.size() >= sizeof(JournalHeader)) {
+    JournalHeader header;
+    memcpy(&header, contents.data(), sizeof(header));
+    if (header.magic != anchor::kJournalMagic ||
+        header.version != anchor::kVersion) {
+      LOGE("AnchorStore: %s is not an anchor journal.",
+           journal_path_.c_str());
+      close(journal_file_);
+      journal_file_ = -1;
+      return false;
+    }
+    end = sizeof(JournalHeader);
+    while (contents.size() - end >= sizeof(JournalEntry)) {
+      JournalEntry entry;
+      memcpy(&entry, contents.data() + end, sizeof(entry));
+      const size_t payload_size =
+          entry.op == anchor::kPut ? entry.payload_size : 0;
+      if ((entry.op != anchor::kPut && entry.op != anchor::kRemove) ||
+          contents.size() - end - sizeof(JournalEntry) < payload_size) {
+        break;
+      }
+      const uint8_t* payload = contents.data() + end + sizeof(JournalEntry);
+      if (entry.op == anchor::kPut) {
+        entry.record.payload_size = entry.payload_size;
+        ApplyPut(entry.record, payload);
+      } else {
+        ApplyRemove(entry.record.id);
+      }
+      end += sizeof(JournalEntry) + payload_size;
+      ++journal_entry_count_;
+    }
+  }
+
+  if (end == 0) {
+    // A new journal, or one whose header was torn.
+    JournalHeader header;
+    header.magic = anchor::kJournalMagic;
+    header.version = anchor::kVersion;
+    if (ftruncate(journal_file_, 0) != 0 ||
+        write(journal_file_, &header, sizeof(header)) !=
+            static_cast<ssize_t>(sizeof(header))) {
+      LOGE("AnchorStore: Could not write %s.", journal_path_.c_str());
+      close(journal_file_);
+      journal_file_ = -1;
+      return false;
+    }
+    end = sizeof(header);
+  } else if (end != contents.size()) {
+    LOGE("AnchorStore: Dropping a torn entry of %s.", journal_path_.c_str());
+    if (ftruncate(journal_file_, end) != 0) {
+      LOGE("AnchorStore: Could not truncate %s.", journal_path_.c_str());
+      close(journal_file_);
+      journal_file_ = -1;
+      return false;
+    }
+  }
+  journal_size_ = end;
+  return true;
+}
+
+void AnchorStore::ApplyPut(const AnchorRecord& record, const void* payload) {
+  std::unordered_map<uint64_t, Edit>::iterator found = edits_.find(record.id);
+  if (found != edits_.end()) {
+    if (found->second.is_removed) {
+      ++anchor_count_;
+    } else {
+      EraseEditCell(found->second.record);
+    }
+  } else if (FindRecord(record.id) == nullptr) {
+    ++anchor_count_;
+  }
+  Edit& edit = edits_[record.id];
+  edit.record = record;
+  edit.record.payload_offset = 0;
+  if (record.payload_size > 0) {
+    edit.payload.assign(static_cast<const char*>(payload),
+                        record.payload_size);
+  } else {
+    edit.payload.clear();
+  }
+  edit.is_removed = false;
+  edit_cells_[CellKeyOf(record.position, options_.cell_size)].push_back(
+      record.id);
+}
+
+void AnchorStore::ApplyRemove(uint64_t id) {
+  const bool is_mapped = FindRecord(id) != nullptr;
+  std::unordered_map<uint64_t, Edit>::iterator found = edits_.find(id);
+  if (found != edits_.end()) {
+    if (found->second.is_removed) {
+      return;
+    }
+    EraseEditCell(found->second.record);
+    --anchor_count_;
+    if (!is_mapped) {
+      edits_.erase(found);
+      return;
+    }
+  } else if (is_mapped) {
+    --anchor_count_;
+  } else {
+    return;
+  }
+  // The mapped record stays until the next compaction, hide it.
+  Edit& edit = edits_[id];
+  edit.record = AnchorRecord();
+  edit.record.id = id;
+  edit.payload.clear();
+  edit.is_removed = true;
+}
+
+void AnchorStore::EraseEditCell(const AnchorRecord& record) {
+  std::unordered_map<uint64_t, std::vector<uint64_t>>::iterator cell =
+      edit_cells_.find(CellKeyOf(record.position, options_.cell_size));
+  if (cell == edit_cells_.end()) {
+    return;
+  }
+  std::vector<uint64_t>& ids = cell->second;
+  std::vector<uint64_t>::iterator id =
+      std::find(ids.begin(), ids.end(), record.id);
+  if (id != ids.end()) {
+    *id = ids.back();
+    ids.pop_back();
+  }
+  if (ids.empty()) {
+    edit_cells_.erase(cell);
+  }
+}
+
+bool AnchorStore::AppendJournal(const JournalEntry& entry,
+                                const void* payload) {
+  const size_t payload_size = entry.op == anchor::kPut ? entry.payload_size : 0;
+  std::vector<uint8_t> buffer(sizeof(entry) + payload_size);
+  memcpy(buffer.data(), &entry, sizeof(entry));
+  if (payload_size > 0) {
+    memcpy(buffer.data() + sizeof(entry), payload, payload_size);
+  }
+  if (write(journal_file_, buffer.data(), buffer.size()) !=
+      static_cast<ssize_t>(buffer.size())) {
+    LOGE("AnchorStore: Could not write %s.", journal_path_.c_str());
+    // Drop what made it, so the next entry does not follow a torn one.
+    if (ftruncate(journal_file_, journal_size_) != 0) {
+      LOGE("AnchorStore: Could not truncate %s.", journal_path_.c_str());
+    }
+    return false;
+  }
+  journal_size_ += buffer.size();
+  ++journal_entry_count_;
+  return true;
+}
+
+const AnchorRecord* AnchorStore::FindRecord(uint64_t id) const {
+  const IdEntry* end = ids_ + header_.anchor_count;
+  const IdEntry* entry = std::lower_bound(
+      ids_, end, id,
+      [](const IdEntry& entry, uint64_t id) { return entry.id < id; });
+  if (entry == end || entry->id != id ||
+      entry->record >= header_.anchor_count) {
+    return nullptr;
+  }
+  return &records_[entry->record];
+}
+
+bool AnchorStore::IsStored(uint64_t id) const {
+  std::unordered_map<uint64_t, Edit>::const_iterator edit = edits_.find(id);
+  if (edit != edits_.end()) {
+    return !edit->second.is_removed;
+  }
+  return FindRecord(id) != nullptr;
+}
+
+void AnchorStore::GetMappedAnchor(const AnchorRecord& record,
+                                  Anchor* anchor) const {
+  const bool has_payload =
+      record.payload_size > 0 &&
+      static_cast<uint64_t>(record.payload_offset) + record.payload_size <=
+          header_.payload_size;
+  if (has_payload) {
+    ToAnchor(record, payloads_ + record.payload_offset, record.payload_size,
+             anchor);
+  } else {
+    ToAnchor(record, nullptr, 0, anchor);
+  }
+}
+
+}  // namespace tango_gl
@@ -0,0 +1,320 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <algorithm>
+#include <chrono>
+
+#include "tango-gl/asset_loader.h"
+
+namespace {
+// Bytes of texture data uploaded per slice, a few milliseconds of upload on
+// the devices we target.
+const size_t kUploadSliceBytes = 256 * 1024;
+
+// Decoded images kept around for reuse by later decodes.
+const size_t kMaxStagingBuffers = 2;
+}  // namespace
+
+namespace tango_gl {
+
+AssetLoader::AssetLoader()
+    : decoding_job_(nullptr),
+      is_decoding_cancelled_(false),
+      is_stopping_(false),
+      upload_thread_(nullptr) {
+  thread_ = std::thread(&AssetLoader::WorkerLoop, this);
+}
+
+AssetLoader::~AssetLoader() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    is_stopping_ = true;
+  }
+  work_available_.notify_one();
+  thread_.join();
+  // Uploads still in flight delete their texture when they complete.
+  for (std::shared_ptr<Job>& job : background_jobs_) {
+    job->is_cancelled = true;
+  }
+}
+
+void AssetLoader::LoadTexture(const char* file_path, Texture* texture) {
+  std::unique_ptr<Job> job(new Job());
+  job->file_path = file_path;
+  job->texture = texture;
+  // Evicted textures reload from here, see MemoryTracker.
+  texture->file_path_ = file_path;
+  job->mesh = nullptr;
+  job->atlas = nullptr;
+  job->sprite = -1;
+  job->capabilities = Texture::GetCapabilities();
+  job->with_normals = false;
+  job->is_decoded = false;
+  job->is_allocated = false;
+  job->next_slice = 0;
+  job->uploaded_texture = 0;
+  job->is_uploaded = false;
+  job->is_cancelled = false;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    decode_queue_.push_back(std::move(job));
+  }
+  work_available_.notify_one();
+}
+
+void AssetLoader::LoadMesh(const char* file_path, bool with_normals,
+                           Mesh* mesh) {
+  std::unique_ptr<Job> job(new Job());
+  job->file_path = file_path;
+  job->texture = nullptr;
+  job->mesh = mesh;
+  job->atlas = nullptr;
+  job->sprite = -1;
+  job->with_normals = with_normals;
+  job->is_decoded = false;
+  job->is_allocated = false;
+  job->next_slice = 0;
+  job->uploaded_texture = 0;
+  job->is_uploaded = false;
+  job->is_cancelled = false;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    decode_queue_.push_back(std::move(job));
+  }
+  work_available_.notify_one();
+}
+
+void AssetLoader::LoadSprite(const char* file_path, TextureAtlas* atlas,
+                             int sprite) {
+  std::unique_ptr<Job> job(new Job());
+  job->file_path = file_path;
+  job->texture = nullptr;
+  job->mesh = nullptr;
+  job->atlas = atlas;
+  job->sprite = sprite;
+  job->with_normals = false;
+  job->is_decoded = false;
+  job->is_allocated = false;
+  job->next_slice = 0;
+  job->uploaded_texture = 0;
+  job->is_uploaded = false;
+  job->is_cancelled = false;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    decode_queue_.push_back(std::move(job));
+  }
+  work_available_.notify_one();
+}
+
+void AssetLoader::Cancel(const void* target) {
+  if (uploading_job_ && uploading_job_->GetTarget() == target) {
+    RecycleStagingBuffer(&uploading_job_->image.pixels);
+    uploading_job_.reset();
+  }
+  for (std::shared_ptr<Job>& job : background_jobs_) {
+    if (job->GetTarget() == target) {
+      job->is_cancelled = true;
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto matches = [target](const std::unique_ptr<Job>& job) {
+    return job->GetTarget() == target;
+  };
+  decode_queue_.erase(
+      std::remove_if(decode_queue_.begin(), decode_queue_.end(), matches),
+      decode_queue_.end());
+  for (std::unique_ptr<Job>& job : upload_queue_) {
+    if (matches(job) && job->image.pixels.capacity() > 0 &&
+        staging_buffers_.size() < kMaxStagingBuffers) {
+      staging_buffers_.push_back(std::move(job->image.pixels));
+    }
+  }
+  upload_queue_.erase(
+      std::remove_if(upload_queue_.begin(), upload_queue_.end(), matches),
+      upload_queue_.end());
+  if (decoding_job_ != nullptr && decoding_job_->GetTarget() == target) {
+    is_decoding_cancelled_ = true;
+  }
+}
+
+void AssetLoader::SetUploadThread(UploadThread* upload_thread) {
+  upload_thread_ = upload_thread;
+}
+
+void AssetLoader::Update(double budget_ms) {
+  for (size_t i = 0; i < background_jobs_.size();) {
+    if (background_jobs_[i]->is_uploaded) {
+      RecycleStagingBuffer(&background_jobs_[i]->image.pixels);
+      background_jobs_[i] = std::move(background_jobs_.back());
+      background_jobs_.pop_back();
+    } else {
+      ++i;
+    }
+  }
+
+  typedef std::chrono::steady_clock Clock;
+  const Clock::time_point deadline =
+      Clock::now() + std::chrono::microseconds(
+                         static_cast<int64_t>(budget_ms * 1000.0));
+  do {
+    if (!uploading_job_) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (upload_queue_.empty()) {
+        return;
+      }
+      uploading_job_ = std::move(upload_queue_.front());
+      upload_queue_.pop_front();
+    }
+    if (upload_thread_ != nullptr && uploading_job_->texture != nullptr &&
+        uploading_job_->is_decoded && !uploading_job_->is_allocated) {
+      PostUpload(std::move(uploading_job_));
+      continue;
+    }
+    if (UploadSlice(uploading_job_.get())) {
+      RecycleStagingBuffer(&uploading_job_->image.pixels);
+      uploading_job_.reset();
+    }
+  } while (Clock::now() < deadline);
+}
+
+size_t AssetLoader::GetPendingCount() const {
+  size_t background_count = 0;
+  for (const std::shared_ptr<Job>& job : background_jobs_) {
+    background_count += job->is_uploaded ? 0 : 1;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  return decode_queue_.size() + upload_queue_.size() +
+         (decoding_job_ != nullptr ? 1 : 0) + (uploading_job_ ? 1 : 0) +
+         background_count;
+}
+
+void AssetLoader::PostUpload(std::unique_ptr<Job> job) {
+  std::shared_ptr<Job> shared_job(std::move(job));
+  background_jobs_.push_back(shared_job);
+  // The upload only touches the job, the target may go away meanwhile.
+  upload_thread_->Post(
+      [shared_job] {
+        shared_job->uploaded_texture =
+            Texture::CreateTexture(shared_job->image);
+      },
+      [shared_job] {
+        if (shared_job->is_cancelled) {
+          glDeleteTextures(1, &shared_job->uploaded_texture);
+        } else {
+          shared_job->texture->AdoptTexture(shared_job->uploaded_texture,
+                                            shared_job->image);
+        }
+        shared_job->is_uploaded = true;
+      });
+}
+
+bool AssetLoader::UploadSlice(Job* job) {
+  if (!job->is_decoded) {
+    // The decode error has been logged already.
+    return true;
+  }
+  if (job->mesh != nullptr) {
+    job->mesh->SetVertices(job->mapped_mesh);
+    return true;
+  }
+  if (job->atlas != nullptr) {
+    job->atlas->SetImage(job->sprite, job->image);
+    return true;
+  }
+
+  const Texture::Image& image = job->image;
+  if (!job->is_allocated) {
+    job->texture->Allocate(image);
+    job->is_allocated = true;
+  }
+  if (image.is_compressed) {
+    job->texture->UploadLevel(image, job->next_slice);
+    ++job->next_slice;
+    return job->next_slice >= image.level_sizes.size();
+  }
+  const png_uint_32 slice_rows = std::max<png_uint_32>(
+      1, kUploadSliceBytes / std::max<size_t>(1, image.GetRowSize()));
+  const png_uint_32 row_count =
+      std::min(slice_rows, image.height - job->next_slice);
+  job->texture->UploadRows(image, job->next_slice, row_count);
+  job->next_slice += row_count;
+  return job->next_slice >= image.height;
+}
+
+void AssetLoader::RecycleStagingBuffer(std::vector<uint8_t>* buffer) {
+  if (buffer->capacity() == 0) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (staging_buffers_.size() < kMaxStagingBuffers) {
+    staging_buffers_.push_back(std::move(*buffer));
+  }
+  buffer->clear();
+  buffer->shrink_to_fit();
+}
+
+void AssetLoader::WorkerLoop() {
+  while (true) {
+    std::unique_ptr<Job> job;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      work_available_.wait(
+          lock, [this] { return is_stopping_ || !decode_queue_.empty(); });
+      if (is_stopping_) {
+        return;
+      }
+      job = std::move(decode_queue_.front());
+      decode_queue_.pop_front();
+      decoding_job_ = job.get();
+      is_decoding_cancelled_ = false;
+      if (job->HasImage() && !staging_buffers_.empty()) {
+        // Reuse the largest pooled buffer, DecodePNG() keeps its capacity.
+        auto largest = std::max_element(
+            staging_buffers_.begin(), staging_buffers_.end(),
+            [](const std::vector<uint8_t>& a, const std::vector<uint8_t>& b) {
+              return a.capacity() < b.capacity();
+            });
+        job->image.pixels = std::move(*largest);
+        staging_buffers_.erase(largest);
+      }
+    }
+
+    if (job->texture != nullptr) {
+      job->is_decoded = Texture::DecodeFile(
+          job->file_path.c_str(), job->capabilities, &job->image);
+    } else if (job->atlas != nullptr) {
+      // Atlas pages take any size, the image is not padded.
+      job->is_decoded =
+          Texture::DecodePNG(job->file_path.c_str(), false, &job->image);
+    } else {
+      job->is_decoded = obj_loader::LoadOBJData(
+          job->file_path.c_str(), job->with_normals, &job->mapped_mesh);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    decoding_job_ = nullptr;
+    if (!is_decoding_cancelled_) {
+      upload_queue_.push_back(std::move(job));
+    } else if (job->image.pixels.capacity() > 0 &&
+               staging_buffers_.size() < kMaxStagingBuffers) {
+      staging_buffers_.push_back(std::move(job->image.pixels));
+    }
+  }
+}
+
+}  // namespace tango_gl
@@ -15,7 +15,9 @@
  */
 
 #include "tango-gl/axis.h"
-#include "tango-gl/shaders.h"
+#include "tango-gl/counters.h"
+#include "tango-gl/render_state.h"
+#include "tango-gl/shader_variants.h"
 
 namespace tango_gl {
 
@@ -27,49 +29,50 @@ static const float float_colors[] = {
     1.0f, 0.0f, 0.0f, 1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 1.0f,
     0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f};
 
+static void BuildAxis(Geometry* geometry) {
+  geometry->vertices.assign(
+      float_vertices,
+      float_vertices + sizeof(float_vertices) / sizeof(float));
+  geometry->colors.assign(
+      float_colors, float_colors + sizeof(float_colors) / sizeof(float));
+}
+
 Axis::Axis() : Line(3.0f, GL_LINES) {
   // Implement SetShader here, not using the dedault one.
-  shader_program_ =
-      util::CreateProgram(shaders::GetColorVertexShader().c_str(),
-                          shaders::GetBasicFragmentShader().c_str());
-  if (!shader_program_) {
+  const shader_variants::Variant* variant =
+      shader_variants::Acquire(shader_variants::kVertexColor |
+                               shader_variants::kFrameConstants);
+  if (variant != nullptr) {
+    shader_program_ = variant->program;
+    uniform_mvp_mat_ = variant->uniforms[shader_variants::kMvp];
+    uses_frame_constants_ =
+        (variant->features & shader_variants::kFrameConstants) != 0;
+    uniform_model_mat_ = variant->uniforms[shader_variants::kModel];
+    attrib_colors_ = variant->attributes[shader_variants::kColorAttribute];
+    attrib_vertices_ = variant->attributes[shader_variants::kVertexAttribute];
+  } else {
     LOGE("Could not create program.");
   }
-  uniform_mvp_mat_ = glGetUniformLocation(shader_program_, "mvp");
-  attrib_colors_ = glGetAttribLocation(shader_program_, "color");
-  attrib_vertices_ = glGetAttribLocation(shader_program_, "vertex");
-
-  size_t size = sizeof(float_vertices) / (sizeof(float) * 3);
-  for (size_t i = 0; i < size; i++) {
-    vec_vertices_.push_back(glm::vec3(float_vertices[i * 3],
-                                      float_vertices[i * 3 + 1],
-                                      float_vertices[i * 3 + 2]));
-    vec_colors_.push_back(
-        glm::vec4(float_colors[i * 4], float_colors[i * 4 + 1],
-                  float_colors[i * 4 + 2], float_colors[i * 4 + 3]));
-  }
+  SetGeometry(geometry_registry::Acquire("axis", BuildAxis));
 }
 
 void Axis::Render(const glm::mat4& projection_mat,
                   const glm::mat4& view_mat) const {
-  glUseProgram(shader_program_);
-  glLineWidth(line_width_);
-  glm::mat4 model_mat = GetTransformationMatrix();
-  glm::mat4 mvp_mat = projection_mat * view_mat * model_mat;
-  glUniformMatrix4fv(uniform_mvp_mat_, 1, GL_FALSE, glm::value_ptr(mvp_mat));
+  RenderState::UseProgram(shader_program_);
+  RenderState::LineWidth(line_width_);
+  SetTransformUniforms(projection_mat, view_mat, GetTransformationMatrix());
 
-  glEnableVertexAttribArray(attrib_vertices_);
-  glVertexAttribPointer(attrib_vertices_, 3, GL_FLOAT, GL_FALSE,
-                        sizeof(glm::vec3), &vec_vertices_[0]);
-
-  glEnableVertexAttribArray(attrib_colors_);
-  glVertexAttribPointer(attrib_colors_, 4, GL_FLOAT, GL_FALSE,
-                        sizeof(glm::vec4), &vec_colors_[0]);
-
-  glDrawArrays(render_mode_, 0, vec_vertices_.size());
-
-  glDisableVertexAttribArray(attrib_vertices_);
-  glDisableVertexAttribArray(attrib_colors_);
-  glUseProgram(0);
+  if (!vertex_array_.Bind()) {
+    geometry_->Bind();
+    vertex_array_.EnableAttribute(attrib_vertices_);
+    glVertexAttribPointer(attrib_vertices_, 3, GL_FLOAT, GL_FALSE,
+                          geometry_->GetStride(), nullptr);
+    vertex_array_.EnableAttribute(attrib_colors_);
+    glVertexAttribPointer(attrib_colors_, 4, GL_FLOAT, GL_FALSE,
+                          geometry_->GetStride(), geometry_->GetColorOffset());
+  }
+  Counters::Increment(Counters::kDrawCalls);
+  glDrawArrays(render_mode_, 0, geometry_->GetVertexCount());
+  vertex_array_.Unbind();
 }
 }  // namespace tango_gl
@@ -14,35 +14,141 @@
  * limitations under the License.
  */
 
+#include <string.h>
+
+#include <algorithm>
+
 #include "tango-gl/band.h"
+#include "tango-gl/counters.h"
+#include "tango-gl/memory_tracker.h"
+#include "tango-gl/program_cache.h"
+#include "tango-gl/render_state.h"
+#include "tango-gl/shaders.h"
+#include "tango-gl/simd_math.h"
 #include "tango-gl/util.h"
 
+// GLES3 token, the examples are built against the GLES2 headers.
+#ifndef GL_RGBA32F
+#define GL_RGBA32F 0x8814
+#endif
+
 namespace tango_gl {
 
 // Set band resolution to 0.01m(1cm) when using UpdateVertexArray()
 static const float kMinDistanceSquared = 0.0001f;
 
+// Samples per row of the procedural ribbon texture.
+static const size_t kSampleTextureWidth = 256;
+
 Band::Band(const unsigned int max_length)
-    : band_width_(0.2), max_length_(max_length) {
+    : band_width_(0.2),
+      next_index_key_(0.0),
+      body_(max_length, 2),
+      has_arrow_(false),
+      arrow_buffer_(GL_ARRAY_BUFFER, GL_DYNAMIC_DRAW),
+      is_arrow_dirty_(false),
+      is_procedural_(false),
+      procedural_program_(0),
+      sample_texture_(0),
+      sample_begin_(0),
+      sample_end_(0),
+      first_dirty_sample_(0),
+      up_(0.0f, 1.0f, 0.0f) {
   SetShader();
-  vertices_v_.reserve(max_length);
   pivot_left = glm::vec3(0, 0, 0);
   pivot_right = glm::vec3(0, 0, 0);
+  // A pair of body vertices per sample, in whole texture rows.
+  const size_t sample_count = std::max<size_t>(2, max_length / 2);
+  sample_capacity_ = (sample_count + kSampleTextureWidth - 1) /
+                     kSampleTextureWidth * kSampleTextureWidth;
+}
+
+Band::~Band() {
+  if (sample_texture_ != 0) {
+    RenderState::DeleteTextures(1, &sample_texture_);
+  }
+  program_cache::ReleaseProgram(procedural_program_);
 }
 
 void Band::SetWidth(const float width) {
   band_width_ = width;
 }
 
-void Band::UpdateVertexArray(const glm::mat4 m, BandMode mode) {
+bool Band::SetProcedural(bool is_procedural) {
+  if (is_procedural == is_procedural_) {
+    return true;
+  }
+  if (!is_procedural) {
+    is_procedural_ = false;
+    ClearVertexArray();
+    return true;
+  }
+  if (procedural_program_ == 0) {
+    const char* version =
+        reinterpret_cast<const char*>(glGetString(GL_VERSION));
+    if (version == nullptr || strncmp(version, "OpenGL ES 3", 11) != 0) {
+      LOGE("Band::SetProcedural, OpenGL ES 3 is missing.");
+      return false;
+    }
+    procedural_program_ = program_cache::AcquireProgram(
+        shaders::GetRibbonVertexShader().c_str(),
+        shaders::GetRibbonFragmentShader().c_str());
+    if (!procedural_program_) {
+      LOGE("Could not create program.");
+      return false;
+    }
+    uniform_ribbon_mvp_mat_ = glGetUniformLocation(procedural_program_, "mvp");
+    uniform_ribbon_color_ = glGetUniformLocation(procedural_program_, "color");
+    uniform_samples_ = glGetUniformLocation(procedural_program_, "samples");
+    uniform_first_ = glGetUniformLocation(procedural_program_, "first");
+    uniform_count_ = glGetUniformLocation(procedural_program_, "count");
+    uniform_capacity_ = glGetUniformLocation(procedural_program_, "capacity");
+    uniform_half_width_ =
+        glGetUniformLocation(procedural_program_, "half_width");
+    uniform_up_ = glGetUniformLocation(procedural_program_, "up");
+
+    glGenTextures(1, &sample_texture_);
+    RenderState::BindTexture(GL_TEXTURE_2D, sample_texture_);
+    // Float textures are not filterable, the shader fetches texels.
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, kSampleTextureWidth,
+                 sample_capacity_ / kSampleTextureWidth, 0, GL_RGBA, GL_FLOAT,
+                 nullptr);
+    MemoryTracker::Track(MemoryTracker::kTexture, sample_texture_, "Band",
+                         sample_capacity_ * sizeof(glm::vec4));
+    samples_.resize(sample_capacity_);
+    sample_timestamps_.resize(sample_capacity_);
+  }
+  ClearVertexArray();
+  is_procedural_ = true;
+  return true;
+}
+
+void Band::UpdateVertexArray(double timestamp, const glm::mat4 m,
+                             BandMode mode) {
+  if (is_procedural_) {
+    const glm::vec3 position = util::GetTranslationFromMatrix(m);
+    if (sample_end_ == sample_begin_ ||
+        kMinDistanceSquared <
+            util::DistanceSquared(
+                glm::vec3(samples_[(sample_end_ - 1) % sample_capacity_]),
+                position)) {
+      AddSample(timestamp, position);
+      next_index_key_ = timestamp + 1.0;
+    }
+    return;
+  }
+
   // First 2 vertices of a band + 3 arrow head vertices.
-  bool need_to_initialize = (vertices_v_.size() < 5);
+  bool need_to_initialize = (body_.GetPointCount() < 2);
 
   bool sufficient_delta = false;
   if (!need_to_initialize) {
-    // Band head is the first two vertices after arrow head.
-    glm::vec3 band_front = 0.5f * (vertices_v_[vertices_v_.size() - 4] +
-                                   vertices_v_[vertices_v_.size() - 5]);
+    // Band head is the last pair of body vertices.
+    glm::vec3 band_front = 0.5f * (pivot_left + pivot_right);
     sufficient_delta = kMinDistanceSquared <
         util::DistanceSquared(band_front, util::GetTranslationFromMatrix(m));
   }
@@ -77,25 +183,26 @@ void Band::UpdateVertexArray(const glm::mat4 m, BandMode mode) {
       head_m[3][2] = position.z;
     }
 
-    if (need_to_initialize) {
-      vertices_v_.resize(5);
-    } else {
-      vertices_v_.resize(vertices_v_.size() + 2);
-    }
-
-    size_t insertion_start = vertices_v_.size() - 5;
-    vertices_v_[insertion_start + 0] = pivot_left;
-    vertices_v_[insertion_start + 1] = pivot_right;
-    vertices_v_[insertion_start + 2] = util::ApplyTransform(head_m, arrow_left);
-    vertices_v_[insertion_start + 3] = util::ApplyTransform(head_m, arrow_right);
-    vertices_v_[insertion_start + 4] = util::ApplyTransform(head_m, arrow_front);
+    // Only the new pair is appended to the body, the arrow head is
+    // rewritten.
+    body_.Add(timestamp, pivot_left);
+    body_.Add(timestamp, pivot_right);
+    next_index_key_ = timestamp + 1.0;
 
-    if (vertices_v_.size() > max_length_) {
-      vertices_v_.erase(vertices_v_.begin(), vertices_v_.begin() + 2);
-    }
+    has_arrow_ = true;
+    is_arrow_dirty_ = true;
+    arrow_vertices_[0] = pivot_left;
+    arrow_vertices_[1] = pivot_right;
+    arrow_vertices_[2] = util::ApplyTransform(head_m, arrow_left);
+    arrow_vertices_[3] = util::ApplyTransform(head_m, arrow_right);
+    arrow_vertices_[4] = util::ApplyTransform(head_m, arrow_front);
   }
 }
 
+void Band::UpdateVertexArray(const glm::mat4 m, BandMode mode) {
+  UpdateVertexArray(next_index_key_, m, mode);
+}
+
 void Band::UpdateVertexArray(const glm::mat4 m) {
   // Defualt to call update with normal mode.
   UpdateVertexArray(m, BandMode::kNormal);
@@ -103,8 +210,15 @@ void Band::UpdateVertexArray(const glm::mat4 m) {
 
 void Band::SetVertexArray(const std::vector<glm::vec3>& v,
                           const glm::vec3& up) {
-  vertices_v_.clear();
-  vertices_v_.reserve(2 * v.size());
+  ClearVertexArray();
+  if (is_procedural_) {
+    up_ = glm::normalize(up);
+    for (const glm::vec3& position : v) {
+      AddSample(next_index_key_, position);
+      next_index_key_ += 1.0;
+    }
+    return;
+  }
   if (v.size() < 2)
     return;
 
@@ -115,35 +229,134 @@ void Band::SetVertexArray(const std::vector<glm::vec3>& v,
     glm::vec3 left = glm::cross(up, dir);
     glm::normalize(left);
 
-    vertices_v_.push_back(gl_p_world_a + (band_width_ / 2.0f * left));
-    vertices_v_.push_back(gl_p_world_a - (band_width_ / 2.0f * left));
+    pivot_left = gl_p_world_a + (band_width_ / 2.0f * left);
+    pivot_right = gl_p_world_a - (band_width_ / 2.0f * left);
+    body_.Add(next_index_key_, pivot_left);
+    body_.Add(next_index_key_, pivot_right);
+    next_index_key_ += 1.0;
 
     // Cap the end of the path.
     if (i == v.size() - 2) {
-      vertices_v_.push_back(gl_p_world_b + (band_width_ / 2.0f * left));
-      vertices_v_.push_back(gl_p_world_b - (band_width_ / 2.0f * left));
+      pivot_left = gl_p_world_b + (band_width_ / 2.0f * left);
+      pivot_right = gl_p_world_b - (band_width_ / 2.0f * left);
+      body_.Add(next_index_key_, pivot_left);
+      body_.Add(next_index_key_, pivot_right);
+      next_index_key_ += 1.0;
     }
   }
+}
 
+void Band::ClearVertexArray() {
+  body_.Clear();
+  next_index_key_ = 0.0;
+  has_arrow_ = false;
+  sample_begin_ = 0;
+  sample_end_ = 0;
+  first_dirty_sample_ = 0;
 }
 
-void Band::ClearVertexArray() { vertices_v_.clear(); }
+void Band::Correct(double since_timestamp, const glm::mat4& correction) {
+  if (is_procedural_) {
+    // A texel per sample, cheap enough to correct at once.
+    for (uint64_t n = sample_begin_; n < sample_end_; ++n) {
+      const size_t ring = n % sample_capacity_;
+      if (sample_timestamps_[ring] >= since_timestamp) {
+        samples_[ring] = correction * samples_[ring];
+        first_dirty_sample_ = std::min(first_dirty_sample_, n);
+      }
+    }
+    return;
+  }
+  body_.Correct(since_timestamp, correction);
+  pivot_left = util::ApplyTransform(correction, pivot_left);
+  pivot_right = util::ApplyTransform(correction, pivot_right);
+  for (glm::vec3& vertex : arrow_vertices_) {
+    vertex = util::ApplyTransform(correction, vertex);
+  }
+  is_arrow_dirty_ = true;
+}
 
 void Band::Render(const glm::mat4& projection_mat,
                   const glm::mat4& view_mat) const {
-  glUseProgram(shader_program_);
-  glm::mat4 model_mat = GetTransformationMatrix();
-  glm::mat4 mvp_mat = projection_mat * view_mat * model_mat;
-  glUniformMatrix4fv(uniform_mvp_mat_, 1, GL_FALSE, glm::value_ptr(mvp_mat));
+  if (is_procedural_) {
+    RenderProcedural(projection_mat, view_mat);
+    return;
+  }
+  RenderState::UseProgram(shader_program_);
+  SetTransformUniforms(projection_mat, view_mat, GetTransformationMatrix());
 
   glUniform4f(uniform_color_, red_, green_, blue_, alpha_);
 
-  glEnableVertexAttribArray(attrib_vertices_);
-  glVertexAttribPointer(attrib_vertices_, 3, GL_FLOAT, GL_FALSE,
-                        sizeof(glm::vec3), &vertices_v_[0]);
-  glDrawArrays(GL_TRIANGLE_STRIP, 0, vertices_v_.size());
-  glDisableVertexAttribArray(attrib_vertices_);
-  glUseProgram(0);
+  body_buffers_.Draw(body_, attrib_vertices_,
+                     [](size_t first_point, size_t point_count) {
+                       Counters::Increment(Counters::kDrawCalls);
+                       glDrawArrays(GL_TRIANGLE_STRIP, first_point,
+                                    point_count);
+                     });
+
+  if (has_arrow_) {
+    if (is_arrow_dirty_) {
+      arrow_buffer_.Update(arrow_vertices_, sizeof(arrow_vertices_), 0);
+      is_arrow_dirty_ = false;
+    }
+    arrow_buffer_.Bind();
+    glEnableVertexAttribArray(attrib_vertices_);
+    glVertexAttribPointer(attrib_vertices_, 3, GL_FLOAT, GL_FALSE,
+                          sizeof(glm::vec3), nullptr);
+    Counters::Increment(Counters::kDrawCalls);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 5);
+    glDisableVertexAttribArray(attrib_vertices_);
+  }
+}
+
+void Band::AddSample(double timestamp, const glm::vec3& position) {
+  const size_t ring = sample_end_ % sample_capacity_;
+  samples_[ring] = glm::vec4(position, 1.0f);
+  sample_timestamps_[ring] = timestamp;
+  ++sample_end_;
+  if (sample_end_ - sample_begin_ > sample_capacity_) {
+    ++sample_begin_;
+  }
+}
+
+void Band::RenderProcedural(const glm::mat4& projection_mat,
+                            const glm::mat4& view_mat) const {
+  RenderState::ActiveTexture(GL_TEXTURE0);
+  RenderState::BindTexture(GL_TEXTURE_2D, sample_texture_);
+  // Upload the new samples a row run at a time, the rows hold whole runs as
+  // the capacity is a multiple of the row width.
+  uint64_t n = std::max(first_dirty_sample_, sample_begin_);
+  while (n < sample_end_) {
+    const size_t ring = n % sample_capacity_;
+    const size_t x = ring % kSampleTextureWidth;
+    const size_t run = std::min<uint64_t>(sample_end_ - n,
+                                          kSampleTextureWidth - x);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, x, ring / kSampleTextureWidth, run, 1,
+                    GL_RGBA, GL_FLOAT, &samples_[ring]);
+    n += run;
+  }
+  first_dirty_sample_ = sample_end_;
+
+  const uint64_t sample_count = sample_end_ - sample_begin_;
+  if (sample_count < 2) {
+    return;
+  }
+  RenderState::UseProgram(procedural_program_);
+  const glm::mat4 mvp_mat = simd_math::Multiply(
+      projection_mat, simd_math::Multiply(view_mat, GetTransformationMatrix()));
+  glUniformMatrix4fv(uniform_ribbon_mvp_mat_, 1, GL_FALSE,
+                     glm::value_ptr(mvp_mat));
+  glUniform4f(uniform_ribbon_color_, red_, green_, blue_, alpha_);
+  glUniform1i(uniform_samples_, 0);
+  glUniform1i(uniform_first_,
+              static_cast<GLint>(sample_begin_ % sample_capacity_));
+  glUniform1i(uniform_count_, static_cast<GLint>(sample_count));
+  glUniform1i(uniform_capacity_, static_cast<GLint>(sample_capacity_));
+  glUniform1f(uniform_half_width_, band_width_ * 0.5f);
+  glUniform3fv(uniform_up_, 1, glm::value_ptr(up_));
+  // Two vertices per sample and the arrow head, without vertex attributes.
+  Counters::Increment(Counters::kDrawCalls);
+  glDrawArrays(GL_TRIANGLE_STRIP, 0, 2 * sample_count + 3);
 }
 
 }  // namespace tango_gl
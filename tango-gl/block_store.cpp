@@ -0,0 +1,369 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+
+#include "tango-gl/block_store.h"
+#include "tango-gl/lz4.h"
+#include "tango-gl/util.h"
+
+namespace {
+// Allocation unit of the file.
+const size_t kPageSize = 4096;
+}  // namespace
+
+namespace tango_gl {
+
+const size_t BlockStore::kMaxPrefetchedBlocks;
+
+BlockStore::BlockStore()
+    : file_(-1),
+      mapping_(nullptr),
+      mapping_size_(0),
+      in_flight_key_(0),
+      has_in_flight_(false),
+      in_flight_is_taken_(false),
+      page_count_(0),
+      next_page_(0),
+      used_pages_(0),
+      has_logged_full_(false),
+      is_stopping_(false) {}
+
+BlockStore::~BlockStore() { Close(); }
+
+bool BlockStore::Open(const char* path, size_t capacity) {
+  if (IsOpen()) {
+    return false;
+  }
+  const size_t page_count = (capacity + kPageSize - 1) / kPageSize;
+  if (page_count == 0 || page_count > UINT32_MAX) {
+    LOGE("BlockStore: Invalid capacity %zu.", capacity);
+    return false;
+  }
+  file_ = open(path, O_RDWR | O_CREAT | O_TRUNC, 0600);
+  if (file_ < 0) {
+    LOGE("BlockStore: Could not create %s.", path);
+    return false;
+  }
+  mapping_size_ = page_count * kPageSize;
+  if (ftruncate(file_, mapping_size_) != 0) {
+    LOGE("BlockStore: Could not size %s.", path);
+    close(file_);
+    unlink(path);
+    file_ = -1;
+    return false;
+  }
+  void* mapping = mmap(nullptr, mapping_size_, PROT_READ | PROT_WRITE,
+                       MAP_SHARED, file_, 0);
+  // The mapping keeps the file alive, the path is not needed anymore.
+  unlink(path);
+  if (mapping == MAP_FAILED) {
+    LOGE("BlockStore: Could not map %s.", path);
+    close(file_);
+    file_ = -1;
+    return false;
+  }
+  mapping_ = static_cast<uint8_t*>(mapping);
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  page_count_ = static_cast<uint32_t>(page_count);
+  next_page_ = 0;
+  used_pages_ = 0;
+  free_runs_.clear();
+  has_logged_full_ = false;
+  is_stopping_ = false;
+  thread_ = std::thread(&BlockStore::ThreadLoop, this);
+  return true;
+}
+
+void BlockStore::Close() {
+  if (thread_.joinable()) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      is_stopping_ = true;
+    }
+    work_available_.notify_one();
+    thread_.join();
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    records_.clear();
+    pending_writes_.clear();
+    write_queue_.clear();
+    prefetched_.clear();
+    prefetch_queue_.clear();
+    has_in_flight_ = false;
+    in_flight_data_.clear();
+  }
+  if (mapping_ != nullptr) {
+    munmap(mapping_, mapping_size_);
+    close(file_);
+    mapping_ = nullptr;
+    mapping_size_ = 0;
+    file_ = -1;
+  }
+}
+
+void BlockStore::Clear() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  // The run of the block in flight is allocated outside the free lists.
+  work_done_.wait(lock, [this] { return !has_in_flight_; });
+  records_.clear();
+  pending_writes_.clear();
+  write_queue_.clear();
+  prefetched_.clear();
+  prefetch_queue_.clear();
+  free_runs_.clear();
+  next_page_ = 0;
+  used_pages_ = 0;
+  has_logged_full_ = false;
+}
+
+void BlockStore::Write(uint64_t key, const void* data, size_t size) {
+  const uint8_t* bytes = static_cast<const uint8_t*>(data);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    EraseRecord(key);
+    if (has_in_flight_ && in_flight_key_ == key) {
+      in_flight_is_taken_ = true;
+    }
+    auto pending = pending_writes_.find(key);
+    if (pending != pending_writes_.end()) {
+      pending->second.assign(bytes, bytes + size);
+      return;
+    }
+    pending_writes_[key].assign(bytes, bytes + size);
+    write_queue_.push_back(key);
+  }
+  work_available_.notify_one();
+}
+
+bool BlockStore::Contains(uint64_t key) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return records_.count(key) != 0 || pending_writes_.count(key) != 0 ||
+         (has_in_flight_ && in_flight_key_ == key && !in_flight_is_taken_);
+}
+
+void BlockStore::Prefetch(const std::vector<uint64_t>& keys) {
+  bool has_work = false;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (uint64_t key : keys) {
+      if (prefetched_.size() + prefetch_queue_.size() >=
+          kMaxPrefetchedBlocks) {
+        break;
+      }
+      if (records_.count(key) != 0 && prefetched_.count(key) == 0) {
+        prefetch_queue_.push_back(key);
+        has_work = true;
+      }
+    }
+  }
+  if (has_work) {
+    work_available_.notify_one();
+  }
+}
+
+bool BlockStore::Take(uint64_t key, void* data, size_t size) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto pending = pending_writes_.find(key);
+  if (pending != pending_writes_.end()) {
+    if (pending->second.size() != size) {
+      return false;
+    }
+    std::memcpy(data, pending->second.data(), size);
+    // The thread skips queued keys without a pending block.
+    pending_writes_.erase(pending);
+    return true;
+  }
+  if (has_in_flight_ && in_flight_key_ == key && !in_flight_is_taken_) {
+    if (in_flight_data_.size() != size) {
+      return false;
+    }
+    // The thread only reads the block while compressing it.
+    std::memcpy(data, in_flight_data_.data(), size);
+    in_flight_is_taken_ = true;
+    return true;
+  }
+
+  auto prefetched = prefetched_.find(key);
+  if (prefetched != prefetched_.end()) {
+    const bool is_match = prefetched->second.size() == size;
+    if (is_match) {
+      std::memcpy(data, prefetched->second.data(), size);
+      EraseRecord(key);
+    }
+    return is_match;
+  }
+  auto record = records_.find(key);
+  if (record == records_.end() || record->second.size != size) {
+    return false;
+  }
+  const bool is_read = lz4::Decompress(
+      mapping_ + static_cast<size_t>(record->second.first_page) * kPageSize,
+      record->second.compressed_size, static_cast<uint8_t*>(data), size);
+  if (!is_read) {
+    LOGE("BlockStore: Block %llx is corrupted.",
+         static_cast<unsigned long long>(key));
+  }
+  EraseRecord(key);
+  return is_read;
+}
+
+void BlockStore::Flush() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  work_done_.wait(lock, [this] {
+    return !thread_.joinable() ||
+           (write_queue_.empty() && prefetch_queue_.empty() &&
+            !has_in_flight_);
+  });
+}
+
+size_t BlockStore::GetBlockCount() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return records_.size() + pending_writes_.size() +
+         (has_in_flight_ && !in_flight_is_taken_ ? 1 : 0);
+}
+
+size_t BlockStore::GetUsedBytes() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return used_pages_ * kPageSize;
+}
+
+bool BlockStore::AllocatePages(uint32_t page_count, uint32_t* first_page) {
+  if (page_count < free_runs_.size() && !free_runs_[page_count].empty()) {
+    *first_page = free_runs_[page_count].back();
+    free_runs_[page_count].pop_back();
+  } else if (page_count <= page_count_ - next_page_) {
+    *first_page = next_page_;
+    next_page_ += page_count;
+  } else {
+    return false;
+  }
+  used_pages_ += page_count;
+  return true;
+}
+
+void BlockStore::FreePages(const Record& record) {
+  if (record.page_count >= free_runs_.size()) {
+    free_runs_.resize(record.page_count + 1);
+  }
+  free_runs_[record.page_count].push_back(record.first_page);
+  used_pages_ -= record.page_count;
+}
+
+void BlockStore::EraseRecord(uint64_t key) {
+  auto record = records_.find(key);
+  if (record != records_.end()) {
+    FreePages(record->second);
+    records_.erase(record);
+  }
+  prefetched_.erase(key);
+}
+
+void BlockStore::ThreadLoop() {
+  std::vector<uint8_t> compressed;
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    work_available_.wait(lock, [this] {
+      return is_stopping_ || !write_queue_.empty() ||
+             !prefetch_queue_.empty();
+    });
+    if (is_stopping_) {
+      break;
+    }
+
+    if (!write_queue_.empty()) {
+      const uint64_t key = write_queue_.front();
+      write_queue_.pop_front();
+      auto pending = pending_writes_.find(key);
+      if (pending == pending_writes_.end()) {
+        // Taken back before it was written.
+        work_done_.notify_all();
+        continue;
+      }
+      in_flight_key_ = key;
+      in_flight_data_.swap(pending->second);
+      pending_writes_.erase(pending);
+      has_in_flight_ = true;
+      in_flight_is_taken_ = false;
+
+      lock.unlock();
+      const size_t size = in_flight_data_.size();
+      compressed.resize(lz4::GetMaxCompressedSize(size));
+      const size_t compressed_size = lz4::Compress(
+          in_flight_data_.data(), size, compressed.data(), compressed.size());
+      lock.lock();
+
+      Record record;
+      record.page_count = static_cast<uint32_t>(
+          std::max<size_t>(1, (compressed_size + kPageSize - 1) / kPageSize));
+      record.compressed_size = static_cast<uint32_t>(compressed_size);
+      record.size = static_cast<uint32_t>(size);
+      if (in_flight_is_taken_) {
+        // Taken or replaced while compressing.
+      } else if (AllocatePages(record.page_count, &record.first_page)) {
+        // Nobody else touches a run before it is in records_.
+        lock.unlock();
+        std::memcpy(
+            mapping_ + static_cast<size_t>(record.first_page) * kPageSize,
+            compressed.data(), compressed_size);
+        lock.lock();
+        if (in_flight_is_taken_) {
+          FreePages(record);
+        } else {
+          records_[key] = record;
+        }
+      } else {
+        if (!has_logged_full_) {
+          LOGE("BlockStore: The file is full, keeping blocks in memory.");
+          has_logged_full_ = true;
+        }
+        pending_writes_[key].swap(in_flight_data_);
+      }
+      has_in_flight_ = false;
+      in_flight_data_.clear();
+      work_done_.notify_all();
+      continue;
+    }
+
+    const uint64_t key = prefetch_queue_.front();
+    prefetch_queue_.pop_front();
+    auto record = records_.find(key);
+    if (record != records_.end() && prefetched_.count(key) == 0) {
+      // Decompressed under the lock, so Take() cannot free the run
+      // meanwhile. Blocks are small, this is a few microseconds.
+      std::vector<uint8_t>& block = prefetched_[key];
+      block.resize(record->second.size);
+      if (!lz4::Decompress(mapping_ + static_cast<size_t>(
+                                          record->second.first_page) *
+                                          kPageSize,
+                           record->second.compressed_size, block.data(),
+                           block.size())) {
+        prefetched_.erase(key);
+      }
+    }
+    work_done_.notify_all();
+  }
+}
+
+}  // namespace tango_gl
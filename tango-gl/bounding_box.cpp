@@ -6,7 +6,7 @@ BoundingBox::BoundingBox(const std::vector<float>& vertices) {
   bounding_min_ = glm::vec3(vertices[0], vertices[1], vertices[2]);
   bounding_max_ = bounding_min_;
   size_t vertices_count = vertices.size() / 3;
-  for (size_t i = 1; i < vertices_count; i += 3) {
+  for (size_t i = 1; i < vertices_count; ++i) {
     bounding_min_.x = std::min(vertices[i * 3], bounding_min_.x);
     bounding_min_.y = std::min(vertices[i * 3 + 1], bounding_min_.y);
     bounding_min_.z = std::min(vertices[i * 3 + 2], bounding_min_.z);
@@ -18,45 +18,101 @@ BoundingBox::BoundingBox(const std::vector<float>& vertices) {
 }
 
 bool BoundingBox::IsIntersecting(const Segment& segment,
-                                 const glm::quat& rotation,
-                                 const glm::mat4& transformation) {
-  // The current bounding box.
-  glm::vec3 min, max;
-
-  // If the mesh has been rotated, we need to derive a new bounding box
-  // based on the original one, if it just been translated or scaled,
-  // we can still use the original one with current model matrix applied.
-  if (rotation == glm::quat(1.0f, 0.0f, 0.0f, 0.0f)) {
-    min = util::ApplyTransform(transformation, bounding_min_);
-    max = util::ApplyTransform(transformation, bounding_max_);
-  } else {
-    std::vector<glm::vec3> box;
-    // Derive 8 vertices of the new bounding box from original min and max.
-    box.push_back(bounding_min_);
-    box.push_back(bounding_max_);
-
-    box.push_back(glm::vec3(bounding_min_.x, bounding_max_.y, bounding_max_.z));
-    box.push_back(glm::vec3(bounding_max_.x, bounding_min_.y, bounding_min_.z));
-
-    box.push_back(glm::vec3(bounding_min_.x, bounding_min_.y, bounding_max_.z));
-    box.push_back(glm::vec3(bounding_max_.x, bounding_max_.y, bounding_min_.z));
-
-    box.push_back(glm::vec3(bounding_max_.x, bounding_min_.y, bounding_max_.z));
-    box.push_back(glm::vec3(bounding_min_.x, bounding_max_.y, bounding_min_.z));
-
-    min = util::ApplyTransform(transformation, bounding_min_);
-    max = min;
-    for (size_t i = 1; i < box.size(); i++) {
-      glm::vec3 temp = util::ApplyTransform(transformation, box[i]);
-      min.x = std::min(temp.x, min.x);
-      min.y = std::min(temp.y, min.y);
-      min.z = std::min(temp.z, min.z);
-
-      max.x = std::max(temp.x, max.x);
-      max.y = std::max(temp.y, max.y);
-      max.z = std::max(temp.z, max.z);
+                                 const glm::quat& /*rotation*/,
+                                 const glm::mat4& transformation) const {
+  // An affine transform maps the segment to a segment with the same
+  // parametrization, so the test in the box frame is exact.
+  glm::mat4 box_T_world = glm::inverse(transformation);
+  return util::SegmentAABBIntersect(
+      bounding_min_, bounding_max_,
+      util::ApplyTransform(box_T_world, segment.start),
+      util::ApplyTransform(box_T_world, segment.end));
+}
+
+size_t BoundingBoxBatch::Add(const BoundingBox& box,
+                             const glm::mat4& transformation) {
+  for (int axis = 0; axis < 3; ++axis) {
+    min_[axis].push_back(box.GetMin()[axis]);
+    max_[axis].push_back(box.GetMax()[axis]);
+    for (int col = 0; col < 4; ++col) {
+      box_T_world_[axis][col].push_back(0.0f);
+    }
+  }
+  SetTransformation(size_, transformation);
+  return size_++;
+}
+
+void BoundingBoxBatch::SetTransformation(size_t index,
+                                         const glm::mat4& transformation) {
+  glm::mat4 box_T_world = glm::inverse(transformation);
+  for (int row = 0; row < 3; ++row) {
+    for (int col = 0; col < 4; ++col) {
+      // glm matrices are indexed by column first.
+      box_T_world_[row][col][index] = box_T_world[col][row];
     }
   }
-  return util::SegmentAABBIntersect(min, max, segment.start, segment.end);
+}
+
+void BoundingBoxBatch::Clear() {
+  size_ = 0;
+  for (int axis = 0; axis < 3; ++axis) {
+    min_[axis].clear();
+    max_[axis].clear();
+    for (int col = 0; col < 4; ++col) {
+      box_T_world_[axis][col].clear();
+    }
+  }
+}
+
+void BoundingBoxBatch::ClipSegment(const Segment& segment, size_t i,
+                                   float* entry, float* exit) const {
+  const glm::vec3 direction = segment.end - segment.start;
+  float t_entry = 0.0f;
+  float t_exit = 1.0f;
+  for (int axis = 0; axis < 3; ++axis) {
+    const std::vector<float>* row = box_T_world_[axis];
+    // Segment start and direction along this axis of the box frame.
+    float start = row[0][i] * segment.start.x + row[1][i] * segment.start.y +
+                  row[2][i] * segment.start.z + row[3][i];
+    float delta = row[0][i] * direction.x + row[1][i] * direction.y +
+                  row[2][i] * direction.z;
+    // A zero delta yields infinite slab distances, which reject or accept
+    // the axis as a whole.
+    float inverse_delta = 1.0f / delta;
+    float t0 = (min_[axis][i] - start) * inverse_delta;
+    float t1 = (max_[axis][i] - start) * inverse_delta;
+    t_entry = std::max(t_entry, std::min(t0, t1));
+    t_exit = std::min(t_exit, std::max(t0, t1));
+  }
+  *entry = t_entry;
+  *exit = t_exit;
+}
+
+void BoundingBoxBatch::Intersect(const Segment& segment,
+                                 std::vector<uint8_t>* hits) const {
+  hits->resize(size_);
+  for (size_t i = 0; i < size_; ++i) {
+    float entry, exit;
+    ClipSegment(segment, i, &entry, &exit);
+    (*hits)[i] = (entry <= exit) ? 1 : 0;
+  }
+}
+
+int BoundingBoxBatch::FindNearest(const Segment& segment,
+                                  float* segment_t) const {
+  int nearest = -1;
+  float nearest_t = 2.0f;
+  for (size_t i = 0; i < size_; ++i) {
+    float entry, exit;
+    ClipSegment(segment, i, &entry, &exit);
+    if (entry <= exit && entry < nearest_t) {
+      nearest = static_cast<int>(i);
+      nearest_t = entry;
+    }
+  }
+  if (nearest >= 0 && segment_t != nullptr) {
+    *segment_t = nearest_t;
+  }
+  return nearest;
 }
 }  // namespace tango_gl
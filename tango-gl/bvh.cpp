@@ -0,0 +1,413 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <math.h>
+
+#include <algorithm>
+
+#include "tango-gl/bvh.h"
+
+namespace {
+// Primitives per leaf, a few exact tests are cheaper than another level.
+const uint32_t kLeafSize = 4;
+
+const uint32_t kNoParent = 0xffffffff;
+
+// Deep enough for any median split tree addressable by 32 bit indices.
+const int kTraversalStackSize = 64;
+
+// Determinants below this are segments parallel to a triangle.
+const float kDeterminantEpsilon = 1e-12f;
+
+// Clip a segment against a box.
+//
+// @param start: segment start.
+// @param inverse_direction: per axis inverse of the segment end minus start.
+// @param max_t: farthest position along the segment of interest.
+// @param entry: set to the position the segment enters the box at, 0 if it
+//        starts inside.
+//
+// @return: true if the segment overlaps the box before max_t.
+bool ClipBox(const glm::vec3& start, const glm::vec3& inverse_direction,
+             const glm::vec3& bounds_min, const glm::vec3& bounds_max,
+             float max_t, float* entry) {
+  glm::vec3 t0 = (bounds_min - start) * inverse_direction;
+  glm::vec3 t1 = (bounds_max - start) * inverse_direction;
+  glm::vec3 t_near = glm::min(t0, t1);
+  glm::vec3 t_far = glm::max(t0, t1);
+  float t_entry =
+      std::max(std::max(0.0f, t_near.x), std::max(t_near.y, t_near.z));
+  float t_exit =
+      std::min(std::min(max_t, t_far.x), std::min(t_far.y, t_far.z));
+  *entry = t_entry;
+  return t_entry <= t_exit;
+}
+
+glm::vec3 InverseDirection(const tango_gl::Segment& segment) {
+  glm::vec3 direction = segment.end - segment.start;
+  return glm::vec3(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+}
+}  // namespace
+
+namespace tango_gl {
+
+void Bvh::Build(const std::vector<glm::vec3>& bounds_min,
+                const std::vector<glm::vec3>& bounds_max) {
+  const uint32_t count = static_cast<uint32_t>(bounds_min.size());
+  primitive_min_ = bounds_min;
+  primitive_max_ = bounds_max;
+  leaf_of_primitive_.resize(count);
+  primitives_.resize(count);
+  nodes_.clear();
+  if (count == 0) {
+    return;
+  }
+
+  std::vector<glm::vec3> centers(count);
+  for (uint32_t i = 0; i < count; ++i) {
+    primitives_[i] = i;
+    centers[i] = 0.5f * (bounds_min[i] + bounds_max[i]);
+  }
+  nodes_.reserve(2 * (count / kLeafSize + 1));
+  BuildNode(kNoParent, 0, count, centers);
+}
+
+uint32_t Bvh::BuildNode(uint32_t parent, uint32_t begin, uint32_t end,
+                        const std::vector<glm::vec3>& centers) {
+  const uint32_t index = static_cast<uint32_t>(nodes_.size());
+  nodes_.push_back(Node());
+  nodes_[index].parent = parent;
+
+  if (end - begin <= kLeafSize) {
+    nodes_[index].right_or_first = begin;
+    nodes_[index].count = end - begin;
+    for (uint32_t i = begin; i < end; ++i) {
+      leaf_of_primitive_[primitives_[i]] = index;
+    }
+    UpdateLeafBounds(index);
+    return index;
+  }
+
+  // Split at the median center along the axis the centers spread most on.
+  glm::vec3 center_min = centers[primitives_[begin]];
+  glm::vec3 center_max = center_min;
+  for (uint32_t i = begin + 1; i < end; ++i) {
+    center_min = glm::min(center_min, centers[primitives_[i]]);
+    center_max = glm::max(center_max, centers[primitives_[i]]);
+  }
+  glm::vec3 extent = center_max - center_min;
+  int axis = 0;
+  if (extent.y > extent.x) axis = 1;
+  if (extent.z > extent[axis]) axis = 2;
+
+  const uint32_t middle = begin + (end - begin) / 2;
+  std::nth_element(primitives_.begin() + begin, primitives_.begin() + middle,
+                   primitives_.begin() + end,
+                   [&centers, axis](uint32_t a, uint32_t b) {
+                     return centers[a][axis] < centers[b][axis];
+                   });
+
+  BuildNode(index, begin, middle, centers);
+  uint32_t right = BuildNode(index, middle, end, centers);
+  Node& node = nodes_[index];
+  node.right_or_first = right;
+  node.count = 0;
+  node.bounds_min = glm::min(nodes_[index + 1].bounds_min,
+                             nodes_[right].bounds_min);
+  node.bounds_max = glm::max(nodes_[index + 1].bounds_max,
+                             nodes_[right].bounds_max);
+  return index;
+}
+
+void Bvh::UpdateLeafBounds(uint32_t node) {
+  Node& leaf = nodes_[node];
+  const uint32_t first = primitives_[leaf.right_or_first];
+  leaf.bounds_min = primitive_min_[first];
+  leaf.bounds_max = primitive_max_[first];
+  for (uint32_t i = 1; i < leaf.count; ++i) {
+    const uint32_t primitive = primitives_[leaf.right_or_first + i];
+    leaf.bounds_min = glm::min(leaf.bounds_min, primitive_min_[primitive]);
+    leaf.bounds_max = glm::max(leaf.bounds_max, primitive_max_[primitive]);
+  }
+}
+
+void Bvh::Refit(uint32_t primitive, const glm::vec3& bounds_min,
+                const glm::vec3& bounds_max) {
+  if (primitive >= leaf_of_primitive_.size()) {
+    LOGE("Bvh::Refit, primitive %u is not in the hierarchy.", primitive);
+    return;
+  }
+  primitive_min_[primitive] = bounds_min;
+  primitive_max_[primitive] = bounds_max;
+
+  uint32_t node = leaf_of_primitive_[primitive];
+  UpdateLeafBounds(node);
+  for (node = nodes_[node].parent; node != kNoParent;
+       node = nodes_[node].parent) {
+    Node& interior = nodes_[node];
+    const Node& left = nodes_[node + 1];
+    const Node& right = nodes_[interior.right_or_first];
+    interior.bounds_min = glm::min(left.bounds_min, right.bounds_min);
+    interior.bounds_max = glm::max(left.bounds_max, right.bounds_max);
+  }
+}
+
+int Bvh::Raycast(const Segment& segment, const IntersectFunction& intersect,
+                 float* t) const {
+  if (nodes_.empty()) {
+    return -1;
+  }
+  const glm::vec3 inverse_direction = InverseDirection(segment);
+  float nearest_t = 1.0f;
+  int nearest = -1;
+
+  // Nodes to visit with the position the segment enters them at.
+  uint32_t stack_nodes[kTraversalStackSize];
+  float stack_entries[kTraversalStackSize];
+  int stack_size = 0;
+
+  float entry;
+  if (!ClipBox(segment.start, inverse_direction, nodes_[0].bounds_min,
+               nodes_[0].bounds_max, nearest_t, &entry)) {
+    return -1;
+  }
+  stack_nodes[stack_size] = 0;
+  stack_entries[stack_size++] = entry;
+
+  while (stack_size > 0) {
+    --stack_size;
+    if (stack_entries[stack_size] > nearest_t) {
+      continue;
+    }
+    const uint32_t index = stack_nodes[stack_size];
+    const Node& node = nodes_[index];
+
+    if (node.count > 0) {
+      for (uint32_t i = 0; i < node.count; ++i) {
+        const uint32_t primitive = primitives_[node.right_or_first + i];
+        float hit_t;
+        if (intersect(primitive, nearest_t, &hit_t) && hit_t <= nearest_t) {
+          nearest_t = hit_t;
+          nearest = static_cast<int>(primitive);
+        }
+      }
+      continue;
+    }
+
+    // Visit the nearer child first, so the farther one is likely culled.
+    const uint32_t children[2] = {index + 1, node.right_or_first};
+    float entries[2];
+    bool overlaps[2];
+    for (int i = 0; i < 2; ++i) {
+      const Node& child = nodes_[children[i]];
+      overlaps[i] = ClipBox(segment.start, inverse_direction, child.bounds_min,
+                            child.bounds_max, nearest_t, &entries[i]);
+    }
+    const int near_child = (entries[1] < entries[0]) ? 1 : 0;
+    const int far_child = 1 - near_child;
+    if (overlaps[far_child]) {
+      stack_nodes[stack_size] = children[far_child];
+      stack_entries[stack_size++] = entries[far_child];
+    }
+    if (overlaps[near_child]) {
+      stack_nodes[stack_size] = children[near_child];
+      stack_entries[stack_size++] = entries[near_child];
+    }
+  }
+
+  if (nearest >= 0 && t != nullptr) {
+    *t = nearest_t;
+  }
+  return nearest;
+}
+
+void MeshBvh::Build(const std::vector<GLfloat>& vertices,
+                    const std::vector<GLushort>& indices) {
+  const size_t vertex_count = vertices.size() / 3;
+  const size_t triangle_count =
+      indices.empty() ? vertex_count / 3 : indices.size() / 3;
+  triangles_.resize(triangle_count);
+
+  std::vector<glm::vec3> bounds_min(triangle_count);
+  std::vector<glm::vec3> bounds_max(triangle_count);
+  for (size_t i = 0; i < triangle_count; ++i) {
+    glm::vec3 corners[3];
+    for (size_t j = 0; j < 3; ++j) {
+      size_t vertex = indices.empty() ? i * 3 + j : indices[i * 3 + j];
+      if (vertex >= vertex_count) {
+        LOGE("MeshBvh::Build, index %zu out of range.", vertex);
+        vertex = 0;
+      }
+      corners[j] = glm::vec3(vertices[vertex * 3], vertices[vertex * 3 + 1],
+                             vertices[vertex * 3 + 2]);
+    }
+    triangles_[i].a = corners[0];
+    triangles_[i].b = corners[1];
+    triangles_[i].c = corners[2];
+    bounds_min[i] = glm::min(glm::min(corners[0], corners[1]), corners[2]);
+    bounds_max[i] = glm::max(glm::max(corners[0], corners[1]), corners[2]);
+  }
+  bvh_.Build(bounds_min, bounds_max);
+}
+
+int MeshBvh::Raycast(const Segment& segment, float* t) const {
+  const glm::vec3 direction = segment.end - segment.start;
+  // Moller-Trumbore, hits from both sides count.
+  return bvh_.Raycast(
+      segment,
+      [this, &segment, &direction](uint32_t primitive, float max_t,
+                                   float* hit_t) {
+        const Triangle& triangle = triangles_[primitive];
+        const glm::vec3 edge1 = triangle.b - triangle.a;
+        const glm::vec3 edge2 = triangle.c - triangle.a;
+        const glm::vec3 p = glm::cross(direction, edge2);
+        const float determinant = glm::dot(edge1, p);
+        if (fabsf(determinant) < kDeterminantEpsilon) {
+          return false;
+        }
+        const float inverse_determinant = 1.0f / determinant;
+        const glm::vec3 to_start = segment.start - triangle.a;
+        const float u = glm::dot(to_start, p) * inverse_determinant;
+        if (u < 0.0f || u > 1.0f) {
+          return false;
+        }
+        const glm::vec3 q = glm::cross(to_start, edge1);
+        const float v = glm::dot(direction, q) * inverse_determinant;
+        if (v < 0.0f || u + v > 1.0f) {
+          return false;
+        }
+        const float segment_t = glm::dot(edge2, q) * inverse_determinant;
+        if (segment_t < 0.0f || segment_t > max_t) {
+          return false;
+        }
+        *hit_t = segment_t;
+        return true;
+      },
+      t);
+}
+
+uint32_t ObjectBvh::Add(const BoundingBox& box,
+                        const glm::mat4& transformation,
+                        const MeshBvh* mesh) {
+  Object object;
+  object.box = box;
+  object.transformation = transformation;
+  object.object_T_world = glm::inverse(transformation);
+  object.mesh = mesh;
+  object.is_dirty = false;
+  objects_.push_back(object);
+  is_built_ = false;
+  return static_cast<uint32_t>(objects_.size() - 1);
+}
+
+void ObjectBvh::SetTransformation(uint32_t object,
+                                  const glm::mat4& transformation) {
+  Object& target = objects_[object];
+  target.transformation = transformation;
+  target.object_T_world = glm::inverse(transformation);
+  if (!target.is_dirty) {
+    target.is_dirty = true;
+    dirty_objects_.push_back(object);
+  }
+}
+
+void ObjectBvh::Clear() {
+  objects_.clear();
+  dirty_objects_.clear();
+  is_built_ = false;
+}
+
+void ObjectBvh::Update() {
+  if (!is_built_) {
+    Rebuild();
+    return;
+  }
+  for (uint32_t object : dirty_objects_) {
+    glm::vec3 bounds_min, bounds_max;
+    GetWorldBounds(objects_[object], &bounds_min, &bounds_max);
+    bvh_.Refit(object, bounds_min, bounds_max);
+    objects_[object].is_dirty = false;
+  }
+  dirty_objects_.clear();
+}
+
+void ObjectBvh::Rebuild() {
+  std::vector<glm::vec3> bounds_min(objects_.size());
+  std::vector<glm::vec3> bounds_max(objects_.size());
+  for (size_t i = 0; i < objects_.size(); ++i) {
+    GetWorldBounds(objects_[i], &bounds_min[i], &bounds_max[i]);
+    objects_[i].is_dirty = false;
+  }
+  dirty_objects_.clear();
+  bvh_.Build(bounds_min, bounds_max);
+  is_built_ = true;
+}
+
+void ObjectBvh::GetWorldBounds(const Object& object, glm::vec3* bounds_min,
+                               glm::vec3* bounds_max) {
+  const glm::vec3& box_min = object.box.GetMin();
+  const glm::vec3& box_max = object.box.GetMax();
+  for (int i = 0; i < 8; ++i) {
+    glm::vec3 corner((i & 1) ? box_max.x : box_min.x,
+                     (i & 2) ? box_max.y : box_min.y,
+                     (i & 4) ? box_max.z : box_min.z);
+    corner = util::ApplyTransform(object.transformation, corner);
+    if (i == 0) {
+      *bounds_min = corner;
+      *bounds_max = corner;
+    } else {
+      *bounds_min = glm::min(*bounds_min, corner);
+      *bounds_max = glm::max(*bounds_max, corner);
+    }
+  }
+}
+
+bool ObjectBvh::IntersectObject(uint32_t object, const Segment& segment,
+                                float max_t, float* t) const {
+  // Affine transforms keep positions along the segment, so hits in the
+  // object frame compare with hits in other objects.
+  const Object& target = objects_[object];
+  Segment object_segment(
+      util::ApplyTransform(target.object_T_world, segment.start),
+      util::ApplyTransform(target.object_T_world, segment.end));
+  if (target.mesh != nullptr) {
+    float hit_t;
+    if (target.mesh->Raycast(object_segment, &hit_t) < 0 || hit_t > max_t) {
+      return false;
+    }
+    *t = hit_t;
+    return true;
+  }
+  return ClipBox(object_segment.start, InverseDirection(object_segment),
+                 target.box.GetMin(), target.box.GetMax(), max_t, t);
+}
+
+int ObjectBvh::Pick(const Segment& segment, glm::vec3* hit_point) {
+  Update();
+  float t;
+  int object = bvh_.Raycast(
+      segment,
+      [this, &segment](uint32_t primitive, float max_t, float* hit_t) {
+        return IntersectObject(primitive, segment, max_t, hit_t);
+      },
+      &t);
+  if (object >= 0 && hit_point != nullptr) {
+    *hit_point = segment.start + t * (segment.end - segment.start);
+  }
+  return object;
+}
+}  // namespace tango_gl
@@ -0,0 +1,185 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "tango-gl/camera_downscaler.h"
+
+#include <algorithm>
+
+#include "tango-gl/counters.h"
+#include "tango-gl/memory_tracker.h"
+#include "tango-gl/program_cache.h"
+#include "tango-gl/render_state.h"
+#include "tango-gl/shaders.h"
+
+namespace {
+// Full screen quad as a triangle strip, in normalized device coordinates.
+const GLfloat kQuadVertices[] = {-1.0f, -1.0f, 1.0f, -1.0f,
+                                 -1.0f, 1.0f,  1.0f, 1.0f};
+
+// Gray pixels packed in a texel of the target.
+const GLsizei kGrayPixelsPerTexel = 4;
+}  // namespace
+
+namespace tango_gl {
+
+CameraDownscaler::CameraDownscaler(Format format, GLsizei width,
+                                   GLsizei height)
+    : format_(format),
+      width_(std::max<GLsizei>(1, width)),
+      height_(std::max<GLsizei>(1, height)),
+      target_width_(width_),
+      framebuffer_(0),
+      texture_(0),
+      is_unsupported_(false),
+      program_(0),
+      attrib_vertices_(-1),
+      uniform_offset_(-1),
+      uniform_pixel_width_(-1),
+      vertex_buffer_(GL_ARRAY_BUFFER, GL_STATIC_DRAW) {
+  if (format_ == kGray) {
+    target_width_ =
+        (width_ + kGrayPixelsPerTexel - 1) / kGrayPixelsPerTexel;
+    width_ = target_width_ * kGrayPixelsPerTexel;
+  }
+}
+
+CameraDownscaler::~CameraDownscaler() { Release(); }
+
+void CameraDownscaler::Update(GLuint camera_texture, double timestamp) {
+  if (is_unsupported_ || !Allocate()) {
+    return;
+  }
+
+  GLint viewport[4];
+  glGetIntegerv(GL_VIEWPORT, viewport);
+  RenderState::Disable(GL_BLEND);
+  RenderState::Disable(GL_DEPTH_TEST);
+  RenderState::Disable(GL_CULL_FACE);
+
+  glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_);
+  glViewport(0, 0, target_width_, height_);
+  RenderState::UseProgram(program_);
+  RenderState::ActiveTexture(GL_TEXTURE0);
+  RenderState::BindTexture(GL_TEXTURE_EXTERNAL_OES, camera_texture);
+  // The taps are a quarter of an image pixel away from its center.
+  glUniform2f(uniform_offset_, 0.25f / width_, 0.25f / height_);
+  if (uniform_pixel_width_ != -1) {
+    glUniform1f(uniform_pixel_width_, 1.0f / width_);
+  }
+
+  vertex_buffer_.Bind();
+  glEnableVertexAttribArray(attrib_vertices_);
+  glVertexAttribPointer(attrib_vertices_, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
+  Counters::Increment(Counters::kDrawCalls);
+  glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+  glDisableVertexAttribArray(attrib_vertices_);
+
+  // Row 0 of the target samples the first row of the camera image, so the
+  // bottom row first order of the read is the top row first order of the
+  // camera.
+  readback_.Read(timestamp);
+
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+  util::CheckGlError("CameraDownscaler::Update");
+}
+
+int CameraDownscaler::GetImages(const ImageCallback& callback) {
+  return readback_.GetPixels(callback);
+}
+
+bool CameraDownscaler::GetImage(double* timestamp,
+                                std::vector<uint8_t>* pixels) {
+  return readback_.GetPixels(timestamp, pixels);
+}
+
+bool CameraDownscaler::Allocate() {
+  if (framebuffer_ != 0) {
+    return true;
+  }
+
+  program_ = program_cache::AcquireProgram(
+      shaders::GetCompositeVertexShader().c_str(),
+      format_ == kGray
+          ? shaders::GetExternalGrayDownsampleFragmentShader().c_str()
+          : shaders::GetExternalDownsampleFragmentShader().c_str());
+  if (!program_) {
+    LOGE("CameraDownscaler: could not create program.");
+    Release();
+    is_unsupported_ = true;
+    return false;
+  }
+  attrib_vertices_ = glGetAttribLocation(program_, "vertex");
+  uniform_offset_ = glGetUniformLocation(program_, "offset");
+  uniform_pixel_width_ = glGetUniformLocation(program_, "pixel_width");
+  RenderState::UseProgram(program_);
+  glUniform1i(glGetUniformLocation(program_, "image"), 0);
+  vertex_buffer_.Update(kQuadVertices, sizeof(kQuadVertices), 0);
+
+  glGenFramebuffers(1, &framebuffer_);
+  glGenTextures(1, &texture_);
+  RenderState::BindTexture(GL_TEXTURE_2D, texture_);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, target_width_, height_, 0, GL_RGBA,
+               GL_UNSIGNED_BYTE, nullptr);
+  MemoryTracker::Track(MemoryTracker::kTexture, texture_, "CameraDownscaler",
+                       MemoryTracker::GetTextureSize(target_width_, height_,
+                                                     GL_RGBA,
+                                                     GL_UNSIGNED_BYTE));
+
+  glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_);
+  glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
+                         texture_, 0);
+  const GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  util::CheckGlError("CameraDownscaler::Allocate");
+
+  if (status != GL_FRAMEBUFFER_COMPLETE) {
+    LOGE("CameraDownscaler: framebuffer incomplete (0x%x), downscaling "
+         "disabled.", status);
+    Release();
+    is_unsupported_ = true;
+    return false;
+  }
+  readback_.Allocate(target_width_, height_);
+  return true;
+}
+
+void CameraDownscaler::Release() {
+  if (framebuffer_ != 0) {
+    glDeleteFramebuffers(1, &framebuffer_);
+    RenderState::DeleteTextures(1, &texture_);
+  }
+  program_cache::ReleaseProgram(program_);
+  vertex_buffer_.Release();
+  readback_.Release();
+  Invalidate();
+}
+
+void CameraDownscaler::Invalidate() {
+  framebuffer_ = 0;
+  texture_ = 0;
+  is_unsupported_ = false;
+  program_ = 0;
+  vertex_buffer_.Invalidate();
+  readback_.Invalidate();
+}
+
+}  // namespace tango_gl
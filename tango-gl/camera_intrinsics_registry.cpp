@@ -0,0 +1,302 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <math.h>
+
+#include "tango-gl/camera.h"
+#include "tango-gl/camera_intrinsics_registry.h"
+#include "tango-gl/service_probe.h"
+
+namespace {
+// Fixed point iterations of Undistort(), converge to well under a
+// thousandth of a pixel for the distortion of the Tango cameras.
+const int kUndistortIterations = 20;
+}  // namespace
+
+namespace tango_gl {
+
+void CameraIntrinsicsRegistry::Clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (Entry& entry : entries_) {
+    entry = Entry();
+  }
+}
+
+void CameraIntrinsicsRegistry::SetIntrinsics(
+    const TangoCameraIntrinsics& intrinsics) {
+  if (intrinsics.camera_id < 0 || intrinsics.camera_id >= TANGO_MAX_CAMERA_ID) {
+    LOGE("CameraIntrinsicsRegistry: Invalid camera %d.", intrinsics.camera_id);
+    return;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  Entry& entry = entries_[intrinsics.camera_id];
+  entry = Entry();
+  entry.has_intrinsics = true;
+  entry.intrinsics = intrinsics;
+}
+
+CameraIntrinsicsRegistry::Entry* CameraIntrinsicsRegistry::GetEntry(
+    TangoCameraId camera, TangoErrorType* ret) {
+  if (camera < 0 || camera >= TANGO_MAX_CAMERA_ID) {
+    LOGE("CameraIntrinsicsRegistry: Invalid camera %d.", camera);
+    *ret = TANGO_INVALID;
+    return nullptr;
+  }
+  Entry* entry = &entries_[camera];
+  if (!entry->has_intrinsics) {
+    {
+      ServiceProbe::ScopedCall probe(ServiceProbe::kGetCameraIntrinsics);
+      *ret = TangoService_getCameraIntrinsics(camera, &entry->intrinsics);
+    }
+    if (*ret != TANGO_SUCCESS) {
+      LOGE(
+          "CameraIntrinsicsRegistry: Failed to get the intrinsics of camera "
+          "%d with error code: %d",
+          camera, *ret);
+      return nullptr;
+    }
+    entry->has_intrinsics = true;
+  }
+  *ret = TANGO_SUCCESS;
+  return entry;
+}
+
+TangoErrorType CameraIntrinsicsRegistry::GetIntrinsics(
+    TangoCameraId camera, TangoCameraIntrinsics* intrinsics) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  TangoErrorType ret;
+  Entry* entry = GetEntry(camera, &ret);
+  if (entry != nullptr) {
+    *intrinsics = entry->intrinsics;
+  }
+  return ret;
+}
+
+TangoErrorType CameraIntrinsicsRegistry::GetProjectionMatrix(
+    TangoCameraId camera, int viewport_width, int viewport_height, float near,
+    float far, glm::mat4* projection) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  TangoErrorType ret;
+  Entry* entry = GetEntry(camera, &ret);
+  if (entry == nullptr) {
+    return ret;
+  }
+  for (const Projection& cached : entry->projections) {
+    if (cached.viewport_width == viewport_width &&
+        cached.viewport_height == viewport_height && cached.near == near &&
+        cached.far == far) {
+      *projection = cached.matrix;
+      return TANGO_SUCCESS;
+    }
+  }
+
+  // Crop the image to the viewport's aspect ratio around its center, which
+  // keeps the focal lengths and moves the principal point.
+  const TangoCameraIntrinsics& intrinsics = entry->intrinsics;
+  float width = static_cast<float>(intrinsics.width);
+  float height = static_cast<float>(intrinsics.height);
+  if (viewport_width > 0 && viewport_height > 0) {
+    const float viewport_ratio = static_cast<float>(viewport_width) /
+                                 static_cast<float>(viewport_height);
+    if (viewport_ratio > width / height) {
+      height = width / viewport_ratio;
+    } else {
+      width = height * viewport_ratio;
+    }
+  }
+  const float cx = intrinsics.cx - 0.5f * (intrinsics.width - width);
+  const float cy = intrinsics.cy - 0.5f * (intrinsics.height - height);
+
+  Projection computed;
+  computed.viewport_width = viewport_width;
+  computed.viewport_height = viewport_height;
+  computed.near = near;
+  computed.far = far;
+  computed.matrix = Camera::ProjectionMatrixForCameraIntrinsics(
+      width, height, intrinsics.fx, intrinsics.fy, cx, cy, near, far);
+  entry->projections.push_back(computed);
+  *projection = computed.matrix;
+  return TANGO_SUCCESS;
+}
+
+const CameraIntrinsicsRegistry::DistortionMap*
+CameraIntrinsicsRegistry::GetDistortionMap(TangoCameraId camera,
+                                           uint32_t grid_width,
+                                           uint32_t grid_height) {
+  if (grid_width < 2 || grid_height < 2) {
+    LOGE("CameraIntrinsicsRegistry: Distortion grids need 2 by 2 samples.");
+    return nullptr;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  TangoErrorType ret;
+  Entry* entry = GetEntry(camera, &ret);
+  if (entry == nullptr) {
+    return nullptr;
+  }
+  for (const std::unique_ptr<DistortionMap>& cached : entry->distortion_maps) {
+    if (cached->grid_width == grid_width &&
+        cached->grid_height == grid_height) {
+      return cached.get();
+    }
+  }
+
+  const TangoCameraIntrinsics& intrinsics = entry->intrinsics;
+  std::unique_ptr<DistortionMap> map(new DistortionMap());
+  map->grid_width = grid_width;
+  map->grid_height = grid_height;
+  map->texture_coords.resize(grid_width * grid_height);
+  for (uint32_t j = 0; j < grid_height; ++j) {
+    const float pixel_y = intrinsics.height * j / (grid_height - 1.0f);
+    for (uint32_t i = 0; i < grid_width; ++i) {
+      const float pixel_x = intrinsics.width * i / (grid_width - 1.0f);
+      glm::vec2 distorted = Distort(
+          intrinsics,
+          glm::vec2((pixel_x - intrinsics.cx) / intrinsics.fx,
+                    (pixel_y - intrinsics.cy) / intrinsics.fy));
+      map->texture_coords[j * grid_width + i] = glm::vec2(
+          (distorted.x * intrinsics.fx + intrinsics.cx) / intrinsics.width,
+          (distorted.y * intrinsics.fy + intrinsics.cy) / intrinsics.height);
+    }
+  }
+  entry->distortion_maps.push_back(std::move(map));
+  return entry->distortion_maps.back().get();
+}
+
+const RayTable* CameraIntrinsicsRegistry::GetRayTable(TangoCameraId camera,
+                                                      float pixel_center) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  TangoErrorType ret;
+  Entry* entry = GetEntry(camera, &ret);
+  if (entry == nullptr) {
+    return nullptr;
+  }
+  for (const auto& cached : entry->ray_tables) {
+    if (cached.first == pixel_center) {
+      return cached.second.get();
+    }
+  }
+  const TangoCameraIntrinsics& intrinsics = entry->intrinsics;
+  projection::CameraIntrinsics pinhole;
+  pinhole.width = static_cast<int>(intrinsics.width);
+  pinhole.height = static_cast<int>(intrinsics.height);
+  pinhole.fx = static_cast<float>(intrinsics.fx);
+  pinhole.fy = static_cast<float>(intrinsics.fy);
+  pinhole.cx = static_cast<float>(intrinsics.cx);
+  pinhole.cy = static_cast<float>(intrinsics.cy);
+  std::unique_ptr<RayTable> table(new RayTable());
+  if (HasDistortion(intrinsics)) {
+    table->Build(pinhole, pixel_center,
+                 [&intrinsics](const glm::vec2& distorted_position) {
+                   return Undistort(intrinsics, distorted_position);
+                 });
+  } else {
+    table->Build(pinhole, pixel_center);
+  }
+  entry->ray_tables.emplace_back(pixel_center, std::move(table));
+  return entry->ray_tables.back().second.get();
+}
+
+glm::vec2 CameraIntrinsicsRegistry::Distort(
+    const TangoCameraIntrinsics& intrinsics,
+    const glm::vec2& normalized_position) {
+  const double* k = intrinsics.distortion;
+  const double x = normalized_position.x;
+  const double y = normalized_position.y;
+  const double ru2 = x * x + y * y;
+  switch (intrinsics.calibration_type) {
+    case TANGO_CALIBRATION_POLYNOMIAL_2_PARAMETERS: {
+      const double scale = 1.0 + ru2 * (k[0] + ru2 * k[1]);
+      return glm::vec2(x * scale, y * scale);
+    }
+    case TANGO_CALIBRATION_POLYNOMIAL_3_PARAMETERS: {
+      // rd = ru + k1 * ru^3 + k2 * ru^5 + k3 * ru^7.
+      const double scale = 1.0 + ru2 * (k[0] + ru2 * (k[1] + ru2 * k[2]));
+      return glm::vec2(x * scale, y * scale);
+    }
+    case TANGO_CALIBRATION_POLYNOMIAL_5_PARAMETERS: {
+      // Radial k1, k2, k3 and tangential p1, p2 terms, ordered
+      // k1, k2, p1, p2, k3.
+      const double scale = 1.0 + ru2 * (k[0] + ru2 * (k[1] + ru2 * k[4]));
+      return glm::vec2(
+          x * scale + 2.0 * k[2] * x * y + k[3] * (ru2 + 2.0 * x * x),
+          y * scale + k[2] * (ru2 + 2.0 * y * y) + 2.0 * k[3] * x * y);
+    }
+    case TANGO_CALIBRATION_EQUIDISTANT: {
+      // rd = 1 / w * arctan(2 * ru * tan(w / 2)).
+      const double w = k[0];
+      const double ru = sqrt(ru2);
+      if (w == 0.0 || ru < 1e-9) {
+        return normalized_position;
+      }
+      const double scale = atan(2.0 * ru * tan(0.5 * w)) / (w * ru);
+      return glm::vec2(x * scale, y * scale);
+    }
+    default:
+      return normalized_position;
+  }
+}
+
+glm::vec2 CameraIntrinsicsRegistry::Undistort(
+    const TangoCameraIntrinsics& intrinsics,
+    const glm::vec2& distorted_position) {
+  if (intrinsics.calibration_type == TANGO_CALIBRATION_EQUIDISTANT) {
+    // ru = tan(rd * w) / (2 * tan(w / 2)).
+    const double w = intrinsics.distortion[0];
+    const double rd = glm::length(glm::dvec2(distorted_position));
+    if (w == 0.0 || rd < 1e-9) {
+      return distorted_position;
+    }
+    const double scale = tan(rd * w) / (2.0 * tan(0.5 * w) * rd);
+    return glm::vec2(glm::dvec2(distorted_position) * scale);
+  }
+  // The distortion is a small correction, so the position moves by the
+  // remaining error each step.
+  glm::vec2 position = distorted_position;
+  for (int i = 0; i < kUndistortIterations; ++i) {
+    position += distorted_position - Distort(intrinsics, position);
+  }
+  return position;
+}
+
+bool CameraIntrinsicsRegistry::HasDistortion(
+    const TangoCameraIntrinsics& intrinsics) {
+  int coefficient_count = 0;
+  switch (intrinsics.calibration_type) {
+    case TANGO_CALIBRATION_POLYNOMIAL_2_PARAMETERS:
+      coefficient_count = 2;
+      break;
+    case TANGO_CALIBRATION_POLYNOMIAL_3_PARAMETERS:
+      coefficient_count = 3;
+      break;
+    case TANGO_CALIBRATION_POLYNOMIAL_5_PARAMETERS:
+      coefficient_count = 5;
+      break;
+    case TANGO_CALIBRATION_EQUIDISTANT:
+      coefficient_count = 1;
+      break;
+    default:
+      break;
+  }
+  for (int i = 0; i < coefficient_count; ++i) {
+    if (intrinsics.distortion[i] != 0.0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace tango_gl
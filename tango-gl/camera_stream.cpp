@@ -0,0 +1,102 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "tango-gl/camera_stream.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+namespace {
+// Frames closer than this fraction of the budget interval are dropped, so
+// the jitter of a camera running at a multiple of the budget does not drop
+// every other kept frame.
+const double kIntervalTolerance = 0.9;
+
+// Copy rows of width bytes, in one piece when they are tightly packed.
+void CopyRows(const uint8_t* source, size_t stride, size_t width,
+              size_t height, uint8_t* destination) {
+  if (stride == width) {
+    memcpy(destination, source, width * height);
+    return;
+  }
+  for (size_t y = 0; y < height; ++y) {
+    memcpy(destination + y * width, source + y * stride, width);
+  }
+}
+}  // namespace
+
+namespace tango_gl {
+
+CameraStream::CameraStream(TangoCameraId camera, const Options& options)
+    : camera_(camera),
+      options_(options),
+      last_timestamp_(-1.0),
+      published_count_(0),
+      dropped_count_(0) {}
+
+bool CameraStream::OnFrameAvailable(const TangoImageBuffer* buffer) {
+  const bool is_nv21 = buffer->format == TANGO_HAL_PIXEL_FORMAT_YCrCb_420_SP;
+  const bool is_yuv = is_nv21 || buffer->format == TANGO_HAL_PIXEL_FORMAT_YV12;
+  if (options_.format == kNV21 ? !is_nv21 : !is_yuv) {
+    return false;
+  }
+
+  // The budget is checked before anything is copied.
+  if (options_.max_frame_rate > 0.0 && last_timestamp_ >= 0.0 &&
+      buffer->timestamp >= last_timestamp_ &&
+      buffer->timestamp - last_timestamp_ <
+          kIntervalTolerance / options_.max_frame_rate) {
+    ++dropped_count_;
+    return false;
+  }
+  last_timestamp_ = buffer->timestamp;
+
+  const size_t width = buffer->width;
+  const size_t height = buffer->height;
+  const size_t stride = std::max<size_t>(buffer->stride, width);
+  const size_t y_size = width * height;
+
+  // The write slot is owned by this thread until it is published, it is only
+  // reallocated for the first frames or if the image size changed.
+  Frame* frame = frames_.GetWriteBuffer();
+  frame->data.resize(options_.format == kNV21 ? y_size + y_size / 2 : y_size);
+  CopyRows(buffer->data, stride, width, height, frame->data.data());
+  if (options_.format == kNV21) {
+    CopyRows(buffer->data + stride * height, stride, width, height / 2,
+             frame->data.data() + y_size);
+  }
+  frame->width = static_cast<int>(width);
+  frame->height = static_cast<int>(height);
+  if (options_.pyramid_level_count > 0) {
+    // Built in the write slot, so its levels are reused like data.
+    frame->pyramid.Build(frame->data.data(), frame->width, frame->height,
+                         frame->width, options_.pyramid_level_count);
+  }
+  frame->timestamp = buffer->timestamp;
+  frames_.Publish();
+  ++published_count_;
+  return true;
+}
+
+const CameraStream::Frame* CameraStream::Acquire(bool* is_new_frame) {
+  *is_new_frame = frames_.Acquire();
+  const Frame* frame = frames_.GetReadBuffer();
+  return frame->data.empty() ? nullptr : frame;
+}
+
+}  // namespace tango_gl
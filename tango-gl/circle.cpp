@@ -14,23 +14,28 @@
  * limitations under the License.
  */
 
+#include <stdio.h>
+
 #include "tango-gl/circle.h"
 
 namespace tango_gl {
 Circle::Circle(float radius, int resolution) : Mesh(GL_TRIANGLE_FAN){
   SetShader();
-  std::vector<GLfloat> vertices;
-  vertices.reserve(3 * (resolution + 2));
-  vertices.push_back(0);
-  vertices.push_back(0);
-  vertices.push_back(0);
-  float delta_theta = M_PI * 2.0f / static_cast<float>(resolution);
-  for (int i = resolution; i >= 0; i--) {
-    float theta = delta_theta * static_cast<float>(i);
-    vertices.push_back(cos(theta) * radius);
+  char key[64];
+  snprintf(key, sizeof(key), "circle/%.9g/%d", radius, resolution);
+  SetGeometry(geometry_registry::Acquire(key, [=](Geometry* geometry) {
+    std::vector<GLfloat>& vertices = geometry->vertices;
+    vertices.reserve(3 * (resolution + 2));
+    vertices.push_back(0);
+    vertices.push_back(0);
     vertices.push_back(0);
-    vertices.push_back(sin(theta) * radius);
-  }
-  SetVertices(vertices);
+    float delta_theta = M_PI * 2.0f / static_cast<float>(resolution);
+    for (int i = resolution; i >= 0; i--) {
+      float theta = delta_theta * static_cast<float>(i);
+      vertices.push_back(cos(theta) * radius);
+      vertices.push_back(0);
+      vertices.push_back(sin(theta) * radius);
+    }
+  }));
 }
 }  // namespace tango_gl
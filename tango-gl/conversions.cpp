@@ -20,25 +20,15 @@ namespace tango_gl {
 namespace conversions {
 
 glm::mat4 opengl_world_T_tango_world() {
-  // Note glm is column-wise.
-  return glm::mat4(1.0f, 0.0f,  0.0f, 0.0f,
-                   0.0f, 0.0f, -1.0f, 0.0f,
-                   0.0f, 1.0f,  0.0f, 0.0f,
-                   0.0f, 0.0f,  0.0f, 1.0f);
+  return OpenGlWorldTTangoWorld().ToMatrix();
 }
 
 glm::mat4 color_camera_T_opengl_camera() {
-  // Note glm is column-wise.
-  return glm::mat4(1.0f,  0.0f,  0.0f, 0.0f,
-                   0.0f, -1.0f,  0.0f, 0.0f,
-                   0.0f,  0.0f, -1.0f, 0.0f,
-                   0.0f,  0.0f,  0.0f, 1.0f);
+  return CameraTOpenGlCamera().ToMatrix();
 }
 
 glm::mat4 depth_camera_T_opengl_camera() {
-  // Note glm is column-wise.
-  return glm::mat4(1.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f,
-                   -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f);
+  return CameraTOpenGlCamera().ToMatrix();
 }
 
 glm::quat QuatTangoToGl(const glm::quat& tango_q_frame) {
@@ -0,0 +1,257 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "tango-gl/corner_detector.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+#include "tango-gl/cpu_features.h"
+
+namespace {
+// Pixels within the circle radius of the border are not tested.
+const int kBorder = 3;
+
+// The Bresenham circle of radius 3, clockwise from the top.
+const int kCircleX[16] = {0, 1, 2, 3, 3, 3, 2, 1, 0, -1, -2, -3, -3, -3, -2,
+                          -1};
+const int kCircleY[16] = {-3, -3, -2, -1, 0, 1, 2, 3, 3, 3, 2, 1, 0, -1, -2,
+                          -3};
+
+inline uint16_t RotateRight(uint16_t mask, int count) {
+  return static_cast<uint16_t>((mask >> count) | (mask << (16 - count)));
+}
+
+// True if the circle mask has 9 contiguous bits, with the same doubling of
+// run lengths as the NEON kernel.
+inline bool HasArc(uint16_t mask) {
+  uint16_t run2 = mask & RotateRight(mask, 1);
+  uint16_t run4 = run2 & RotateRight(run2, 2);
+  uint16_t run8 = run4 & RotateRight(run4, 4);
+  return (run8 & RotateRight(mask, 8)) != 0;
+}
+
+bool IsCorner(const uint8_t* pixel, const int* offsets, int threshold) {
+  const int high = pixel[0] + threshold;
+  const int low = pixel[0] - threshold;
+  // Any arc of 9 covers two neighbouring compass points.
+  const int top = pixel[offsets[0]];
+  const int right = pixel[offsets[4]];
+  const int bottom = pixel[offsets[8]];
+  const int left = pixel[offsets[12]];
+  const bool may_be_brighter = (top > high && right > high) ||
+                               (right > high && bottom > high) ||
+                               (bottom > high && left > high) ||
+                               (left > high && top > high);
+  const bool may_be_darker = (top < low && right < low) ||
+                             (right < low && bottom < low) ||
+                             (bottom < low && left < low) ||
+                             (left < low && top < low);
+  if (!may_be_brighter && !may_be_darker) {
+    return false;
+  }
+  uint16_t brighter = 0;
+  uint16_t darker = 0;
+  for (int k = 0; k < 16; ++k) {
+    const int value = pixel[offsets[k]];
+    brighter |= static_cast<uint16_t>(value > high) << k;
+    darker |= static_cast<uint16_t>(value < low) << k;
+  }
+  return HasArc(brighter) || HasArc(darker);
+}
+
+// Sum of the differences over the threshold, on the side with the larger sum.
+int Score(const uint8_t* pixel, const int* offsets, int threshold) {
+  const int high = pixel[0] + threshold;
+  const int low = pixel[0] - threshold;
+  int brighter_sum = 0;
+  int darker_sum = 0;
+  for (int k = 0; k < 16; ++k) {
+    const int value = pixel[offsets[k]];
+    if (value > high) {
+      brighter_sum += value - high;
+    } else if (value < low) {
+      darker_sum += low - value;
+    }
+  }
+  return std::max(brighter_sum, darker_sum);
+}
+
+inline bool IsHigherScore(const tango_gl::CornerDetector::Corner& a,
+                          const tango_gl::CornerDetector::Corner& b) {
+  return a.score > b.score;
+}
+}  // namespace
+
+namespace tango_gl {
+
+CornerDetector::CornerDetector(const Options& options)
+    : options_(options), cell_columns_(0), cell_rows_(0) {}
+
+void CornerDetector::MarkCells(const std::vector<Roi>& rois, int level,
+                               int level_width, int level_height) {
+  const int cell_size = options_.cell_size;
+  cell_columns_ = (level_width + cell_size - 1) / cell_size;
+  cell_rows_ = (level_height + cell_size - 1) / cell_size;
+  active_cells_.assign(cell_columns_ * cell_rows_, rois.empty() ? 1 : 0);
+  for (const Roi& roi : rois) {
+    // Level pixels covered by the region, then the cells covering those.
+    const int x_begin = std::max(roi.x >> level, 0);
+    const int y_begin = std::max(roi.y >> level, 0);
+    const int x_end =
+        std::min((roi.x + roi.width + (1 << level) - 1) >> level, level_width);
+    const int y_end = std::min((roi.y + roi.height + (1 << level) - 1) >> level,
+                               level_height);
+    if (x_begin >= x_end || y_begin >= y_end) {
+      continue;
+    }
+    for (int row = y_begin / cell_size; row <= (y_end - 1) / cell_size;
+         ++row) {
+      for (int column = x_begin / cell_size;
+           column <= (x_end - 1) / cell_size; ++column) {
+        active_cells_[row * cell_columns_ + column] = 1;
+      }
+    }
+  }
+}
+
+size_t CornerDetector::Detect(const LuminancePyramid& pyramid, int level,
+                              const std::vector<Roi>& rois,
+                              std::vector<Corner>* corners) {
+  const LuminancePyramid::Level& image = pyramid.GetLevel(level);
+  const int width = image.width;
+  const int height = image.height;
+  if (width <= 2 * kBorder || height <= 2 * kBorder ||
+      options_.cell_size <= 0) {
+    return 0;
+  }
+  const int threshold = std::min(std::max(options_.threshold, 1), 255);
+  const int cell_size = options_.cell_size;
+  MarkCells(rois, level, width, height);
+
+  int offsets[16];
+  for (int k = 0; k < 16; ++k) {
+    offsets[k] = kCircleY[k] * image.stride + kCircleX[k];
+  }
+
+  // Pixels outside the active cells keep a score of 0 for the suppression.
+  const size_t pixel_count = static_cast<size_t>(width) * height;
+  if (scores_.size() < pixel_count) {
+    scores_.resize(pixel_count);
+  }
+  memset(scores_.data(), 0, pixel_count * sizeof(scores_[0]));
+  if (corner_flags_.size() < static_cast<size_t>(width)) {
+    corner_flags_.resize(width);
+  }
+#if defined(TANGO_GL_HAS_NEON)
+  const bool use_neon = cpu_features::IsNeonAvailable();
+#endif
+
+  // Score the corners of the active cells, a run of active cells in a cell
+  // row is tested in one span.
+  for (int cell_row = 0; cell_row < cell_rows_; ++cell_row) {
+    const int y_begin = std::max(cell_row * cell_size, kBorder);
+    const int y_end = std::min((cell_row + 1) * cell_size, height - kBorder);
+    int cell_column = 0;
+    while (cell_column < cell_columns_) {
+      if (!active_cells_[cell_row * cell_columns_ + cell_column]) {
+        ++cell_column;
+        continue;
+      }
+      const int span_begin = cell_column;
+      while (cell_column < cell_columns_ &&
+             active_cells_[cell_row * cell_columns_ + cell_column]) {
+        ++cell_column;
+      }
+      const int x_begin = std::max(span_begin * cell_size, kBorder);
+      const int x_end = std::min(cell_column * cell_size, width - kBorder);
+      for (int y = y_begin; y < y_end; ++y) {
+        const uint8_t* row = image.data + static_cast<size_t>(y) * image.stride;
+        uint8_t* flags = corner_flags_.data();
+        size_t x = x_begin;
+#if defined(TANGO_GL_HAS_NEON)
+        if (use_neon && x_begin < x_end) {
+          x = corner_detector::internal::DetectRowNeon(
+              row, image.stride, x_begin, x_end, threshold, flags);
+        }
+#endif
+        for (; x < static_cast<size_t>(x_end); ++x) {
+          flags[x] = IsCorner(row + x, offsets, threshold) ? 0xff : 0;
+        }
+        uint16_t* score_row = scores_.data() + static_cast<size_t>(y) * width;
+        for (int i = x_begin; i < x_end; ++i) {
+          if (flags[i]) {
+            score_row[i] =
+                static_cast<uint16_t>(Score(row + i, offsets, threshold));
+          }
+        }
+      }
+    }
+  }
+
+  // Keep the local maxima of each cell, ties go to the first in raster
+  // order, then the best of the cell.
+  const size_t max_per_cell = std::max(options_.max_corners_per_cell, 0);
+  const float scale = static_cast<float>(1 << level);
+  const float offset = 0.5f * scale - 0.5f;
+  size_t appended = 0;
+  for (int cell_row = 0; cell_row < cell_rows_; ++cell_row) {
+    const int y_begin = std::max(cell_row * cell_size, kBorder);
+    const int y_end = std::min((cell_row + 1) * cell_size, height - kBorder);
+    for (int cell_column = 0; cell_column < cell_columns_; ++cell_column) {
+      if (!active_cells_[cell_row * cell_columns_ + cell_column]) {
+        continue;
+      }
+      const int x_begin = std::max(cell_column * cell_size, kBorder);
+      const int x_end =
+          std::min((cell_column + 1) * cell_size, width - kBorder);
+      candidates_.clear();
+      for (int y = y_begin; y < y_end; ++y) {
+        const uint16_t* above = scores_.data() + (y - 1) * width;
+        const uint16_t* center = above + width;
+        const uint16_t* below = center + width;
+        for (int x = x_begin; x < x_end; ++x) {
+          const uint16_t score = center[x];
+          if (score == 0 || score <= above[x - 1] || score <= above[x] ||
+              score <= above[x + 1] || score <= center[x - 1] ||
+              score < center[x + 1] || score < below[x - 1] ||
+              score < below[x] || score < below[x + 1]) {
+            continue;
+          }
+          Corner corner;
+          corner.x = x * scale + offset;
+          corner.y = y * scale + offset;
+          corner.level = level;
+          corner.score = score;
+          candidates_.push_back(corner);
+        }
+      }
+      if (candidates_.size() > max_per_cell) {
+        std::partial_sort(candidates_.begin(),
+                          candidates_.begin() + max_per_cell,
+                          candidates_.end(), IsHigherScore);
+        candidates_.resize(max_per_cell);
+      }
+      corners->insert(corners->end(), candidates_.begin(), candidates_.end());
+      appended += candidates_.size();
+    }
+  }
+  return appended;
+}
+
+}  // namespace tango_gl
@@ -0,0 +1,134 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// This file is only compiled with NEON enabled (the ".neon" suffix in
+// Android.mk), the kernel is selected at runtime by corner_detector.cpp.
+
+#include <arm_neon.h>
+#include <stddef.h>
+
+#include "tango-gl/corner_detector.h"
+
+namespace {
+// The Bresenham circle of radius 3, clockwise from the top, as in
+// corner_detector.cpp.
+const int kCircleX[16] = {0, 1, 2, 3, 3, 3, 2, 1, 0, -1, -2, -3, -3, -3, -2,
+                          -1};
+const int kCircleY[16] = {-3, -3, -2, -1, 0, 1, 2, 3, 3, 3, 2, 1, 0, -1, -2,
+                          -3};
+
+inline bool IsAnySet(const uint8x16_t& mask) {
+  uint64x2_t lanes = vreinterpretq_u64_u8(mask);
+  return (vgetq_lane_u64(lanes, 0) | vgetq_lane_u64(lanes, 1)) != 0;
+}
+
+// 0xff in the lanes where two neighbouring compass points are set, a
+// vertical point together with a horizontal one.
+inline uint8x16_t HasNeighbouringPoints(const uint8x16_t& top,
+                                        const uint8x16_t& right,
+                                        const uint8x16_t& bottom,
+                                        const uint8x16_t& left) {
+  return vandq_u8(vorrq_u8(top, bottom), vorrq_u8(right, left));
+}
+
+// Sign extend 8 byte masks to 16 bit masks.
+inline uint16x8_t Widen(const uint8x8_t& mask) {
+  return vreinterpretq_u16_s16(vmovl_s8(vreinterpret_s8_u8(mask)));
+}
+
+template <int count>
+inline uint16x8_t RotateRight(const uint16x8_t& mask) {
+  return vorrq_u16(vshrq_n_u16(mask, count), vshlq_n_u16(mask, 16 - count));
+}
+
+// 0xffff in the lanes whose circle mask has 9 contiguous bits: runs of 2, 4
+// and 8 bits, then one more.
+inline uint16x8_t HasArc(const uint16x8_t& mask) {
+  uint16x8_t run2 = vandq_u16(mask, RotateRight<1>(mask));
+  uint16x8_t run4 = vandq_u16(run2, RotateRight<2>(run2));
+  uint16x8_t run8 = vandq_u16(run4, RotateRight<4>(run4));
+  uint16x8_t run9 = vandq_u16(run8, RotateRight<8>(mask));
+  return vtstq_u16(run9, run9);
+}
+}  // namespace
+
+namespace tango_gl {
+namespace corner_detector {
+namespace internal {
+
+size_t DetectRowNeon(const uint8_t* row, size_t stride, size_t begin,
+                     size_t end, uint8_t threshold, uint8_t* flags) {
+  ptrdiff_t offsets[16];
+  for (int k = 0; k < 16; ++k) {
+    offsets[k] = kCircleY[k] * static_cast<ptrdiff_t>(stride) + kCircleX[k];
+  }
+  const uint8x16_t threshold_vector = vdupq_n_u8(threshold);
+
+  size_t x = begin;
+  for (; x + 16 <= end; x += 16) {
+    const uint8_t* pixel = row + x;
+    const uint8x16_t center = vld1q_u8(pixel);
+    const uint8x16_t high = vqaddq_u8(center, threshold_vector);
+    const uint8x16_t low = vqsubq_u8(center, threshold_vector);
+
+    // Reject the block unless a pixel has two neighbouring compass points on
+    // the same side, any arc of 9 covers two of them.
+    const uint8x16_t top = vld1q_u8(pixel + offsets[0]);
+    const uint8x16_t right = vld1q_u8(pixel + offsets[4]);
+    const uint8x16_t bottom = vld1q_u8(pixel + offsets[8]);
+    const uint8x16_t left = vld1q_u8(pixel + offsets[12]);
+    const uint8x16_t candidates = vorrq_u8(
+        HasNeighbouringPoints(vcgtq_u8(top, high), vcgtq_u8(right, high),
+                              vcgtq_u8(bottom, high), vcgtq_u8(left, high)),
+        HasNeighbouringPoints(vcltq_u8(top, low), vcltq_u8(right, low),
+                              vcltq_u8(bottom, low), vcltq_u8(left, low)));
+    if (!IsAnySet(candidates)) {
+      vst1q_u8(flags + x, vdupq_n_u8(0));
+      continue;
+    }
+
+    // One 16 bit circle mask per pixel, 8 pixels per vector.
+    uint16x8_t brighter_low = vdupq_n_u16(0);
+    uint16x8_t brighter_high = vdupq_n_u16(0);
+    uint16x8_t darker_low = vdupq_n_u16(0);
+    uint16x8_t darker_high = vdupq_n_u16(0);
+    for (int k = 0; k < 16; ++k) {
+      const uint8x16_t value = vld1q_u8(pixel + offsets[k]);
+      const uint8x16_t brighter = vcgtq_u8(value, high);
+      const uint8x16_t darker = vcltq_u8(value, low);
+      const uint16x8_t bit = vdupq_n_u16(static_cast<uint16_t>(1 << k));
+      brighter_low = vorrq_u16(
+          brighter_low, vandq_u16(Widen(vget_low_u8(brighter)), bit));
+      brighter_high = vorrq_u16(
+          brighter_high, vandq_u16(Widen(vget_high_u8(brighter)), bit));
+      darker_low =
+          vorrq_u16(darker_low, vandq_u16(Widen(vget_low_u8(darker)), bit));
+      darker_high =
+          vorrq_u16(darker_high, vandq_u16(Widen(vget_high_u8(darker)), bit));
+    }
+    const uint16x8_t corner_low =
+        vorrq_u16(HasArc(brighter_low), HasArc(darker_low));
+    const uint16x8_t corner_high =
+        vorrq_u16(HasArc(brighter_high), HasArc(darker_high));
+    vst1q_u8(flags + x,
+             vcombine_u8(vmovn_u16(corner_low), vmovn_u16(corner_high)));
+  }
+  return x;
+}
+
+}  // namespace internal
+}  // namespace corner_detector
+}  // namespace tango_gl
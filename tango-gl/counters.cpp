@@ -0,0 +1,106 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "tango-gl/counters.h"
+
+#include <stdio.h>
+
+#include <atomic>
+
+namespace {
+typedef tango_gl::Counters Counters;
+
+// More shards than the threads counting at once in the examples, threads
+// beyond that share shards, which stays correct.
+const size_t kShardCount = 8;
+
+// A cache line per shard, so threads counting into different shards do not
+// share one.
+struct alignas(64) Shard {
+  std::atomic<uint64_t> values[Counters::kCounterCount];
+};
+
+Shard g_shards[kShardCount];
+std::atomic<size_t> g_next_shard(0);
+
+// Written by BeginFrame() on the GL thread, read from any thread.
+std::atomic<uint64_t> g_frame_values[Counters::kCounterCount];
+// Totals at the last BeginFrame(), only touched on the GL thread.
+uint64_t g_frame_start_totals[Counters::kCounterCount];
+
+const char* const kNames[Counters::kCounterCount] = {
+    "buffer_bytes",  "texture_bytes",    "draw_calls",
+    "program_binds", "points_projected", "poses",
+    "depth_outliers"};
+
+Shard& GetThreadShard() {
+  static thread_local Shard* shard =
+      &g_shards[g_next_shard.fetch_add(1, std::memory_order_relaxed) %
+                kShardCount];
+  return *shard;
+}
+}  // namespace
+
+namespace tango_gl {
+
+void Counters::AddToShard(Counter counter, uint64_t value) {
+  GetThreadShard().values[counter].fetch_add(value,
+                                             std::memory_order_relaxed);
+}
+
+uint64_t Counters::GetTotal(Counter counter) {
+  uint64_t total = 0;
+  for (const Shard& shard : g_shards) {
+    total += shard.values[counter].load(std::memory_order_relaxed);
+  }
+  return total;
+}
+
+uint64_t Counters::GetFrameValue(Counter counter) {
+  return g_frame_values[counter].load(std::memory_order_relaxed);
+}
+
+void Counters::BeginFrame() {
+  for (int i = 0; i < kCounterCount; ++i) {
+    const Counter counter = static_cast<Counter>(i);
+    const uint64_t total = GetTotal(counter);
+    g_frame_values[i].store(total - g_frame_start_totals[i],
+                            std::memory_order_relaxed);
+    g_frame_start_totals[i] = total;
+  }
+}
+
+const char* Counters::GetName(Counter counter) { return kNames[counter]; }
+
+std::string Counters::GetReport() {
+  std::string report = "counters";
+  for (int i = 0; i < kCounterCount; ++i) {
+    const Counter counter = static_cast<Counter>(i);
+    const uint64_t value = GetFrameValue(counter);
+    char text[64];
+    if (counter == kBufferBytes || counter == kTextureBytes) {
+      snprintf(text, sizeof(text), " %s %.1f KB", kNames[i], value / 1024.0);
+    } else {
+      snprintf(text, sizeof(text), " %s %llu", kNames[i],
+               static_cast<unsigned long long>(value));
+    }
+    report += text;
+  }
+  return report;
+}
+
+}  // namespace tango_gl
@@ -0,0 +1,363 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "tango-gl/coverage_map.h"
+
+#include <algorithm>
+
+#include "tango-gl/counters.h"
+#include "tango-gl/memory_tracker.h"
+#include "tango-gl/program_cache.h"
+#include "tango-gl/render_state.h"
+#include "tango-gl/shaders.h"
+
+namespace {
+// Apex and the 4 far corners of a frustum.
+const int kFootprintPointCount = 5;
+
+// Cross product of b - a and c - a, positive if a, b, c turn left.
+float Cross(const glm::vec2& a, const glm::vec2& b, const glm::vec2& c) {
+  return (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+}
+
+// Convex hull of a few points, counterclockwise, by the monotone chain.
+//
+// @param points: the points, sorted in place.
+// @param hull: output, room for count + 1 points.
+// @return number of points of the hull.
+int ConvexHull(glm::vec2* points, int count, glm::vec2* hull) {
+  std::sort(points, points + count,
+            [](const glm::vec2& a, const glm::vec2& b) {
+              return a.x < b.x || (a.x == b.x && a.y < b.y);
+            });
+  int size = 0;
+  for (int i = 0; i < count; ++i) {
+    while (size >= 2 && Cross(hull[size - 2], hull[size - 1], points[i]) <= 0) {
+      --size;
+    }
+    hull[size++] = points[i];
+  }
+  const int lower_size = size + 1;
+  for (int i = count - 2; i >= 0; --i) {
+    while (size >= lower_size &&
+           Cross(hull[size - 2], hull[size - 1], points[i]) <= 0) {
+      --size;
+    }
+    hull[size++] = points[i];
+  }
+  // The last point is the first one again.
+  return size - 1;
+}
+}  // namespace
+
+namespace tango_gl {
+
+CoverageMap::CoverageMap(const Options& options)
+    : options_(options),
+      has_intrinsics_(false),
+      is_unsupported_(false),
+      framebuffer_(0),
+      texture_(0),
+      is_cleared_(false),
+      splat_program_(0),
+      splat_attrib_vertices_(-1),
+      uniform_weight_(-1),
+      splat_buffer_(GL_ARRAY_BUFFER, GL_STREAM_DRAW),
+      program_(0),
+      attrib_vertices_(-1),
+      uniform_mvp_mat_(-1),
+      uniform_height_(-1),
+      uniform_inverse_extent_(-1),
+      uniform_low_color_(-1),
+      uniform_high_color_(-1),
+      tile_buffer_(GL_ARRAY_BUFFER, GL_DYNAMIC_DRAW),
+      uploaded_tile_float_count_(0),
+      covered_tile_count_(0),
+      splat_count_(0),
+      height_(0.0f),
+      low_color_(0.2f, 0.45f, 1.0f, 0.35f),
+      high_color_(1.0f, 0.25f, 0.1f, 0.75f) {
+  options_.tile_size = std::max(1, options_.tile_size);
+  options_.texture_size =
+      std::max(1, options_.texture_size / options_.tile_size) *
+      options_.tile_size;
+  extent_ = options_.texture_size * options_.meters_per_pixel;
+  tiles_per_side_ = options_.texture_size / options_.tile_size;
+  tiles_.assign(tiles_per_side_ * tiles_per_side_, 0);
+}
+
+CoverageMap::~CoverageMap() { Release(); }
+
+void CoverageMap::SetIntrinsics(const TangoCameraIntrinsics& intrinsics) {
+  if (intrinsics.width == 0 || intrinsics.height == 0 ||
+      intrinsics.fx == 0.0 || intrinsics.fy == 0.0) {
+    has_intrinsics_ = false;
+    return;
+  }
+  const float corners[4][2] = {{0.0f, 0.0f},
+                               {static_cast<float>(intrinsics.width), 0.0f},
+                               {0.0f, static_cast<float>(intrinsics.height)},
+                               {static_cast<float>(intrinsics.width),
+                                static_cast<float>(intrinsics.height)}};
+  for (int i = 0; i < 4; ++i) {
+    corner_rays_[i] =
+        glm::vec3((corners[i][0] - intrinsics.cx) / intrinsics.fx,
+                  (corners[i][1] - intrinsics.cy) / intrinsics.fy, 1.0f);
+  }
+  has_intrinsics_ = true;
+}
+
+void CoverageMap::Splat(const glm::mat4& world_T_depth, float range) {
+  range = std::min(range, options_.max_range);
+  if (!has_intrinsics_ || !(range > 0.0f) || !Allocate()) {
+    return;
+  }
+
+  // The footprint on the ground, in meters then in normalized device
+  // coordinates of the texture.
+  glm::vec2 points[kFootprintPointCount];
+  points[0] = glm::vec2(world_T_depth[3].x, world_T_depth[3].z);
+  for (int i = 0; i < 4; ++i) {
+    const glm::vec4 corner =
+        world_T_depth * glm::vec4(corner_rays_[i] * range, 1.0f);
+    points[i + 1] = glm::vec2(corner.x, corner.z);
+  }
+  glm::vec2 hull[kFootprintPointCount + 1];
+  const int hull_size = ConvexHull(points, kFootprintPointCount, hull);
+  if (hull_size < 3) {
+    return;
+  }
+  GLfloat vertices[kFootprintPointCount * 2];
+  glm::vec2 min_pixel(static_cast<float>(options_.texture_size));
+  glm::vec2 max_pixel(0.0f);
+  for (int i = 0; i < hull_size; ++i) {
+    const glm::vec2 texture_coords = hull[i] / extent_ + 0.5f;
+    vertices[i * 2] = texture_coords.x * 2.0f - 1.0f;
+    vertices[i * 2 + 1] = texture_coords.y * 2.0f - 1.0f;
+    const glm::vec2 pixel =
+        texture_coords * static_cast<float>(options_.texture_size);
+    min_pixel = glm::min(min_pixel, pixel);
+    max_pixel = glm::max(max_pixel, pixel);
+  }
+  CoverTiles(min_pixel, max_pixel);
+
+  GLint viewport[4];
+  glGetIntegerv(GL_VIEWPORT, viewport);
+  glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_);
+  glViewport(0, 0, options_.texture_size, options_.texture_size);
+  RenderState::Disable(GL_SCISSOR_TEST);
+  if (!is_cleared_) {
+    GLfloat clear_color[4];
+    glGetFloatv(GL_COLOR_CLEAR_VALUE, clear_color);
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glClearColor(clear_color[0], clear_color[1], clear_color[2],
+                 clear_color[3]);
+    is_cleared_ = true;
+  }
+  RenderState::Enable(GL_BLEND);
+  glBlendFunc(GL_ONE, GL_ONE);
+  RenderState::Disable(GL_DEPTH_TEST);
+  RenderState::Disable(GL_CULL_FACE);
+  RenderState::UseProgram(splat_program_);
+  const float weight = options_.splat_weight;
+  glUniform4f(uniform_weight_, weight, weight, weight, weight);
+
+  splat_buffer_.Update(vertices, hull_size * 2 * sizeof(GLfloat), 0);
+  splat_buffer_.Bind();
+  glEnableVertexAttribArray(splat_attrib_vertices_);
+  glVertexAttribPointer(splat_attrib_vertices_, 2, GL_FLOAT, GL_FALSE, 0,
+                        nullptr);
+  Counters::Increment(Counters::kDrawCalls);
+  glDrawArrays(GL_TRIANGLE_FAN, 0, hull_size);
+  glDisableVertexAttribArray(splat_attrib_vertices_);
+  RenderState::BindBuffer(GL_ARRAY_BUFFER, 0);
+
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+  ++splat_count_;
+  util::CheckGlError("CoverageMap::Splat");
+}
+
+void CoverageMap::Render(const glm::mat4& projection_mat,
+                         const glm::mat4& view_mat) {
+  if (covered_tile_count_ == 0 || framebuffer_ == 0 || !is_cleared_) {
+    return;
+  }
+  if (uploaded_tile_float_count_ != tile_vertices_.size()) {
+    tile_buffer_.Update(tile_vertices_.data(),
+                        tile_vertices_.size() * sizeof(GLfloat),
+                        uploaded_tile_float_count_ * sizeof(GLfloat));
+    uploaded_tile_float_count_ = tile_vertices_.size();
+  }
+
+  RenderState::UseProgram(program_);
+  const glm::mat4 mvp_mat = projection_mat * view_mat;
+  glUniformMatrix4fv(uniform_mvp_mat_, 1, GL_FALSE, glm::value_ptr(mvp_mat));
+  glUniform1f(uniform_height_, height_);
+  glUniform1f(uniform_inverse_extent_, 1.0f / extent_);
+  glUniform4fv(uniform_low_color_, 1, glm::value_ptr(low_color_));
+  glUniform4fv(uniform_high_color_, 1, glm::value_ptr(high_color_));
+  RenderState::ActiveTexture(GL_TEXTURE0);
+  RenderState::BindTexture(GL_TEXTURE_2D, texture_);
+  RenderState::Enable(GL_BLEND);
+  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+  RenderState::Enable(GL_DEPTH_TEST);
+  RenderState::Disable(GL_CULL_FACE);
+  glDepthMask(GL_FALSE);
+
+  tile_buffer_.Bind();
+  glEnableVertexAttribArray(attrib_vertices_);
+  glVertexAttribPointer(attrib_vertices_, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
+  Counters::Increment(Counters::kDrawCalls);
+  glDrawArrays(GL_TRIANGLES, 0,
+               static_cast<GLsizei>(tile_vertices_.size() / 2));
+  glDisableVertexAttribArray(attrib_vertices_);
+  RenderState::BindBuffer(GL_ARRAY_BUFFER, 0);
+  glDepthMask(GL_TRUE);
+  util::CheckGlError("CoverageMap::Render");
+}
+
+void CoverageMap::Clear() { Reset(); }
+
+void CoverageMap::CoverTiles(const glm::vec2& min_pixel,
+                             const glm::vec2& max_pixel) {
+  const float tile_size = static_cast<float>(options_.tile_size);
+  const int min_x = std::max(0, static_cast<int>(min_pixel.x / tile_size));
+  const int min_y = std::max(0, static_cast<int>(min_pixel.y / tile_size));
+  const int max_x = std::min(tiles_per_side_ - 1,
+                             static_cast<int>(max_pixel.x / tile_size));
+  const int max_y = std::min(tiles_per_side_ - 1,
+                             static_cast<int>(max_pixel.y / tile_size));
+  const float tile_meters = extent_ / tiles_per_side_;
+  for (int y = min_y; y <= max_y; ++y) {
+    for (int x = min_x; x <= max_x; ++x) {
+      uint8_t& tile = tiles_[y * tiles_per_side_ + x];
+      if (tile != 0) {
+        continue;
+      }
+      tile = 1;
+      ++covered_tile_count_;
+      const float x0 = x * tile_meters - 0.5f * extent_;
+      const float z0 = y * tile_meters - 0.5f * extent_;
+      const float x1 = x0 + tile_meters;
+      const float z1 = z0 + tile_meters;
+      const GLfloat quad[] = {x0, z0, x1, z0, x1, z1,
+                              x0, z0, x1, z1, x0, z1};
+      tile_vertices_.insert(tile_vertices_.end(), quad,
+                            quad + sizeof(quad) / sizeof(quad[0]));
+    }
+  }
+}
+
+bool CoverageMap::Allocate() {
+  if (framebuffer_ != 0) {
+    return true;
+  }
+  if (is_unsupported_) {
+    return false;
+  }
+
+  splat_program_ = program_cache::AcquireProgram(
+      shaders::GetCompositeVertexShader().c_str(),
+      shaders::GetCoverageSplatFragmentShader().c_str());
+  program_ = program_cache::AcquireProgram(
+      shaders::GetCoverageVertexShader().c_str(),
+      shaders::GetCoverageFragmentShader().c_str());
+  if (!splat_program_ || !program_) {
+    LOGE("CoverageMap: could not create programs.");
+    Release();
+    is_unsupported_ = true;
+    return false;
+  }
+  splat_attrib_vertices_ = glGetAttribLocation(splat_program_, "vertex");
+  uniform_weight_ = glGetUniformLocation(splat_program_, "weight");
+  attrib_vertices_ = glGetAttribLocation(program_, "vertex");
+  uniform_mvp_mat_ = glGetUniformLocation(program_, "mvp");
+  uniform_height_ = glGetUniformLocation(program_, "height");
+  uniform_inverse_extent_ = glGetUniformLocation(program_, "inverse_extent");
+  uniform_low_color_ = glGetUniformLocation(program_, "low_color");
+  uniform_high_color_ = glGetUniformLocation(program_, "high_color");
+  RenderState::UseProgram(program_);
+  glUniform1i(glGetUniformLocation(program_, "coverage"), 0);
+
+  glGenFramebuffers(1, &framebuffer_);
+  glGenTextures(1, &texture_);
+  RenderState::BindTexture(GL_TEXTURE_2D, texture_);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, options_.texture_size,
+               options_.texture_size, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+  MemoryTracker::Track(
+      MemoryTracker::kTexture, texture_, "CoverageMap",
+      MemoryTracker::GetTextureSize(options_.texture_size,
+                                    options_.texture_size, GL_RGBA,
+                                    GL_UNSIGNED_BYTE));
+  glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_);
+  glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
+                         texture_, 0);
+  const GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  util::CheckGlError("CoverageMap::Allocate");
+
+  if (status != GL_FRAMEBUFFER_COMPLETE) {
+    LOGE("CoverageMap: framebuffer incomplete (0x%x), coverage disabled.",
+         status);
+    Release();
+    is_unsupported_ = true;
+    return false;
+  }
+  // The coverage drawn so far was in the texture.
+  Reset();
+  return true;
+}
+
+void CoverageMap::Reset() {
+  std::fill(tiles_.begin(), tiles_.end(), 0);
+  tile_vertices_.clear();
+  uploaded_tile_float_count_ = 0;
+  covered_tile_count_ = 0;
+  splat_count_ = 0;
+  is_cleared_ = false;
+}
+
+void CoverageMap::Release() {
+  if (framebuffer_ != 0) {
+    glDeleteFramebuffers(1, &framebuffer_);
+    RenderState::DeleteTextures(1, &texture_);
+  }
+  program_cache::ReleaseProgram(splat_program_);
+  program_cache::ReleaseProgram(program_);
+  splat_buffer_.Release();
+  tile_buffer_.Release();
+  Invalidate();
+}
+
+void CoverageMap::Invalidate() {
+  framebuffer_ = 0;
+  texture_ = 0;
+  is_unsupported_ = false;
+  splat_program_ = 0;
+  program_ = 0;
+  splat_buffer_.Invalidate();
+  tile_buffer_.Invalidate();
+  Reset();
+}
+
+}  // namespace tango_gl
@@ -42,13 +42,16 @@ static const GLfloat const_normals[] = {
     1.0f,  0.0f,  0.0f,  -1.0f, 0.0f,  0.0f,  -1.0f, 0.0f,  0.0f,  -1.0f, 0.0f,
     0.0f,  -1.0f, 0.0f,  0.0f,  -1.0f, 0.0f,  0.0f,  -1.0f, 0.0f};
 
-Cube::Cube() {
-  SetShader(true);
-  std::vector<GLfloat> vertices(
+static void BuildCube(Geometry* geometry) {
+  geometry->vertices.assign(
       const_vertices,
       const_vertices + sizeof(const_vertices) / sizeof(GLfloat));
-  std::vector<GLfloat> normals(
+  geometry->normals.assign(
       const_normals, const_normals + sizeof(const_normals) / sizeof(GLfloat));
-  SetVertices(vertices, normals);
+}
+
+Cube::Cube() {
+  SetShader(true);
+  SetGeometry(geometry_registry::Acquire("cube", BuildCube));
 }
 }  // namespace tango_gl
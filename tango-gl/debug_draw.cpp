@@ -0,0 +1,205 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "tango-gl/debug_draw.h"
+
+#include <stddef.h>
+
+#include <algorithm>
+
+#include "tango-gl/counters.h"
+#include "tango-gl/program_cache.h"
+#include "tango-gl/render_state.h"
+#include "tango-gl/shader_variants.h"
+
+namespace {
+const float kDefaultLineWidth = 2.0f;
+
+// Corner i of a box has the max coordinate along the axes of the set bits.
+glm::vec3 BoxCorner(const glm::vec3& min, const glm::vec3& max, int i) {
+  return glm::vec3((i & 1) ? max.x : min.x, (i & 2) ? max.y : min.y,
+                   (i & 4) ? max.z : min.z);
+}
+
+// The 12 edges of a box, as pairs of corners.
+const int kBoxEdges[12][2] = {{0, 1}, {2, 3}, {4, 5}, {6, 7},
+                              {0, 2}, {1, 3}, {4, 6}, {5, 7},
+                              {0, 4}, {1, 5}, {2, 6}, {3, 7}};
+
+uint8_t ColorByte(float value) {
+  return static_cast<uint8_t>(
+      std::min(std::max(value, 0.0f), 1.0f) * 255.0f + 0.5f);
+}
+}  // namespace
+
+namespace tango_gl {
+
+DebugDraw::DebugDraw()
+    : is_enabled_(true),
+      line_width_(kDefaultLineWidth),
+      shader_program_(0),
+      uniform_mvp_(-1),
+      attrib_vertices_(-1),
+      attrib_colors_(-1),
+      vertex_buffer_(GL_ARRAY_BUFFER, GL_STREAM_DRAW) {}
+
+DebugDraw::~DebugDraw() { Release(); }
+
+void DebugDraw::AddLine(const glm::vec3& start, const glm::vec3& end,
+                        const Color& color) {
+  if (!is_enabled_ || vertices_.size() + 2 > kMaxVertexCount) {
+    return;
+  }
+  PushVertex(start, color);
+  PushVertex(end, color);
+}
+
+void DebugDraw::AddBox(const glm::vec3& min, const glm::vec3& max,
+                       const Color& color) {
+  AddBox(glm::mat4(1.0f), min, max, color);
+}
+
+void DebugDraw::AddBox(const glm::mat4& world_T_box, const glm::vec3& min,
+                       const glm::vec3& max, const Color& color) {
+  if (!is_enabled_) {
+    return;
+  }
+  glm::vec3 corners[8];
+  for (int i = 0; i < 8; ++i) {
+    corners[i] =
+        glm::vec3(world_T_box * glm::vec4(BoxCorner(min, max, i), 1.0f));
+  }
+  for (const int* edge : kBoxEdges) {
+    AddLine(corners[edge[0]], corners[edge[1]], color);
+  }
+}
+
+void DebugDraw::AddAxes(const glm::mat4& world_T_frame, float length) {
+  if (!is_enabled_) {
+    return;
+  }
+  const glm::vec3 origin(world_T_frame[3]);
+  AddLine(origin, origin + glm::vec3(world_T_frame[0]) * length,
+          Color(1.0f, 0.0f, 0.0f));
+  AddLine(origin, origin + glm::vec3(world_T_frame[1]) * length,
+          Color(0.0f, 1.0f, 0.0f));
+  AddLine(origin, origin + glm::vec3(world_T_frame[2]) * length,
+          Color(0.0f, 0.0f, 1.0f));
+}
+
+void DebugDraw::AddText(const std::string& text, const glm::vec3& position) {
+  if (!is_enabled_) {
+    return;
+  }
+  Label label;
+  label.text = text;
+  label.position = position;
+  labels_.push_back(label);
+}
+
+void DebugDraw::Flush(const glm::mat4& projection_mat,
+                      const glm::mat4& view_mat, int viewport_width,
+                      int viewport_height) {
+  const glm::mat4 mvp = projection_mat * view_mat;
+
+  // Labels behind the camera or outside the view are dropped.
+  flushed_labels_.clear();
+  for (Label& label : labels_) {
+    const glm::vec4 clip = mvp * glm::vec4(label.position, 1.0f);
+    if (clip.w <= 0.0f) {
+      continue;
+    }
+    const glm::vec2 ndc = glm::vec2(clip) / clip.w;
+    if (glm::any(glm::greaterThan(glm::abs(ndc), glm::vec2(1.0f)))) {
+      continue;
+    }
+    label.pixel = glm::vec2((ndc.x * 0.5f + 0.5f) * viewport_width,
+                            (0.5f - ndc.y * 0.5f) * viewport_height);
+    flushed_labels_.push_back(std::move(label));
+  }
+  labels_.clear();
+
+  if (vertices_.empty() || !InitializeProgram()) {
+    vertices_.clear();
+    return;
+  }
+  // Written whole every frame, the vertex array stays valid as the buffer
+  // object is kept when its storage grows.
+  vertex_buffer_.Update(vertices_.data(), vertices_.size() * sizeof(Vertex),
+                        0);
+
+  RenderState::UseProgram(shader_program_);
+  RenderState::LineWidth(line_width_);
+  glUniformMatrix4fv(uniform_mvp_, 1, GL_FALSE, glm::value_ptr(mvp));
+  if (!vertex_array_.Bind()) {
+    vertex_buffer_.Bind();
+    vertex_array_.EnableAttribute(attrib_vertices_);
+    glVertexAttribPointer(attrib_vertices_, 3, GL_FLOAT, GL_FALSE,
+                          sizeof(Vertex), nullptr);
+    vertex_array_.EnableAttribute(attrib_colors_);
+    glVertexAttribPointer(
+        attrib_colors_, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Vertex),
+        reinterpret_cast<const GLvoid*>(offsetof(Vertex, color)));
+  }
+  Counters::Increment(Counters::kDrawCalls);
+  glDrawArrays(GL_LINES, 0, static_cast<GLsizei>(vertices_.size()));
+  vertex_array_.Unbind();
+  vertices_.clear();
+}
+
+void DebugDraw::Release() {
+  vertex_buffer_.Release();
+  vertex_array_.Release();
+  program_cache::ReleaseProgram(shader_program_);
+  shader_program_ = 0;
+}
+
+void DebugDraw::Invalidate() {
+  vertex_buffer_.Invalidate();
+  vertex_array_.Invalidate();
+  shader_program_ = 0;
+}
+
+bool DebugDraw::InitializeProgram() {
+  if (shader_program_ != 0) {
+    return true;
+  }
+  const shader_variants::Variant* variant =
+      shader_variants::Acquire(shader_variants::kVertexColor);
+  if (variant == nullptr) {
+    LOGE("DebugDraw: Could not create program.");
+    return false;
+  }
+  shader_program_ = variant->program;
+  uniform_mvp_ = variant->uniforms[shader_variants::kMvp];
+  attrib_vertices_ = variant->attributes[shader_variants::kVertexAttribute];
+  attrib_colors_ = variant->attributes[shader_variants::kColorAttribute];
+  vertex_array_.Reset();
+  return true;
+}
+
+void DebugDraw::PushVertex(const glm::vec3& position, const Color& color) {
+  Vertex vertex;
+  vertex.position = position;
+  vertex.color[0] = ColorByte(color.r);
+  vertex.color[1] = ColorByte(color.g);
+  vertex.color[2] = ColorByte(color.b);
+  vertex.color[3] = 255;
+  vertices_.push_back(vertex);
+}
+
+}  // namespace tango_gl
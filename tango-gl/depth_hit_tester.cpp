@@ -0,0 +1,193 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tango-gl/depth_hit_tester.h"
+
+#include <math.h>
+
+#include <algorithm>
+
+#include "tango-gl/normal_estimator.h"
+
+namespace {
+// Smallest cosine between the tap ray and the plane normal, flatter hits are
+// too unstable to place content on.
+const double kMinRayCosine = 0.05;
+
+// Squared length below which a direction in the plane is degenerate.
+const double kMinDirectionLength2 = 1e-12;
+}  // namespace
+
+namespace tango_gl {
+
+const int DepthHitTester::kDefaultWindowRadius;
+const int DepthHitTester::kMinPointCount;
+
+DepthHitTester::DepthHitTester()
+    : depths_(nullptr),
+      confidences_(nullptr),
+      min_confidence_(0.0f),
+      world_T_camera_(1.0f),
+      window_radius_(kDefaultWindowRadius) {
+  intrinsics_.width = 0;
+  intrinsics_.height = 0;
+  intrinsics_.fx = 0.0f;
+  intrinsics_.fy = 0.0f;
+  intrinsics_.cx = 0.0f;
+  intrinsics_.cy = 0.0f;
+}
+
+void DepthHitTester::SetDepthImage(
+    const float* depths, const projection::CameraIntrinsics& intrinsics,
+    const glm::mat4& world_T_camera) {
+  depths_ = depths;
+  intrinsics_ = intrinsics;
+  world_T_camera_ = world_T_camera;
+  // Depth images are projected with projection::ProjectPoints(), pixel x
+  // covers [x, x + 1).
+  if (!ray_table_.IsBuiltFor(intrinsics, 0.5f)) {
+    ray_table_.Build(intrinsics, 0.5f);
+  }
+}
+
+void DepthHitTester::SetConfidences(const float* confidences,
+                                    float min_confidence) {
+  confidences_ = confidences;
+  min_confidence_ = min_confidence;
+}
+
+void DepthHitTester::SetWindowRadius(int radius) {
+  window_radius_ = std::max(radius, 1);
+}
+
+bool DepthHitTester::HitTest(const glm::vec2& uv, DepthHit* hit) const {
+  if (depths_ == nullptr) {
+    return false;
+  }
+  const double pixel_x = static_cast<double>(uv.x) * intrinsics_.width;
+  const double pixel_y = static_cast<double>(uv.y) * intrinsics_.height;
+  // Compared as doubles so far away taps never overflow the int cast.
+  if (!(pixel_x >= 0.0 && pixel_x < intrinsics_.width && pixel_y >= 0.0 &&
+        pixel_y < intrinsics_.height)) {
+    return false;
+  }
+  const int center_x = static_cast<int>(pixel_x);
+  const int center_y = static_cast<int>(pixel_y);
+  const int left = std::max(center_x - window_radius_, 0);
+  const int right = std::min(center_x + window_radius_ + 1, intrinsics_.width);
+  const int top = std::max(center_y - window_radius_, 0);
+  const int bottom =
+      std::min(center_y + window_radius_ + 1, intrinsics_.height);
+
+  // Weighted moments of the window points in the camera frame.
+  int point_count = 0;
+  double weight_sum = 0.0;
+  glm::dvec3 sum(0.0);
+  glm::dmat3 outer_sum(0.0);
+  for (int y = top; y < bottom; ++y) {
+    const size_t row_offset = static_cast<size_t>(y) * intrinsics_.width;
+    const float* row = depths_ + row_offset;
+    for (int x = left; x < right; ++x) {
+      const float depth = row[x];
+      if (!(depth > 0.0f)) {
+        continue;
+      }
+      double weight = 1.0;
+      if (confidences_ != nullptr) {
+        weight = confidences_[row_offset + x];
+        if (!(weight > 0.0) || weight < min_confidence_) {
+          continue;
+        }
+      }
+      const glm::dvec3 point = GetCameraPoint(x, y, depth);
+      ++point_count;
+      weight_sum += weight;
+      sum += point * weight;
+      outer_sum += glm::outerProduct(point, point) * weight;
+    }
+  }
+  if (point_count < kMinPointCount) {
+    return false;
+  }
+
+  const glm::dvec3 mean = sum / weight_sum;
+  const glm::dmat3 covariance =
+      outer_sum / weight_sum - glm::outerProduct(mean, mean);
+  glm::dvec3 normal;
+  if (!SmallestEigenvector(covariance, &normal)) {
+    return false;
+  }
+
+  // The camera is at the origin of its frame, the ray goes through the tap.
+  const glm::dvec3 ray((pixel_x - intrinsics_.cx) / intrinsics_.fx,
+                       (pixel_y - intrinsics_.cy) / intrinsics_.fy, 1.0);
+  if (glm::dot(normal, mean) > 0.0) {
+    normal = -normal;
+  }
+  const double ray_cosine = glm::dot(normal, ray) / glm::length(ray);
+  if (!(ray_cosine < -kMinRayCosine)) {
+    return false;
+  }
+  const glm::dvec3 position =
+      ray * (glm::dot(normal, mean) / glm::dot(normal, ray));
+
+  // Forward axis towards the camera, or along the image up direction when
+  // the camera looks straight at the plane.
+  glm::dvec3 forward = -position - normal * glm::dot(-position, normal);
+  if (glm::dot(forward, forward) < kMinDirectionLength2) {
+    const glm::dvec3 image_up(0.0, -1.0, 0.0);
+    forward = image_up - normal * glm::dot(image_up, normal);
+    if (glm::dot(forward, forward) < kMinDirectionLength2) {
+      forward = glm::dvec3(1.0, 0.0, 0.0) - normal * normal.x;
+    }
+  }
+  forward = glm::normalize(forward);
+  const glm::dvec3 side = glm::cross(normal, forward);
+  glm::mat4 camera_T_hit(1.0f);
+  camera_T_hit[0] = glm::vec4(glm::vec3(side), 0.0f);
+  camera_T_hit[1] = glm::vec4(glm::vec3(normal), 0.0f);
+  camera_T_hit[2] = glm::vec4(glm::vec3(forward), 0.0f);
+  camera_T_hit[3] = glm::vec4(glm::vec3(position), 1.0f);
+
+  hit->world_T_hit = world_T_camera_ * camera_T_hit;
+  hit->position = glm::vec3(hit->world_T_hit[3]);
+  hit->normal = glm::vec3(hit->world_T_hit[1]);
+  hit->point_count = point_count;
+  hit->point_weight = static_cast<float>(weight_sum);
+  // The smallest eigenvalue is the variance along the normal.
+  hit->fit_error = static_cast<float>(
+      sqrt(std::max(0.0, glm::dot(normal, covariance * normal))));
+  return true;
+}
+
+size_t DepthHitTester::HitTest(const glm::vec2* uvs, size_t probe_count,
+                               DepthHit* hits, bool* is_hit) const {
+  size_t hit_count = 0;
+  for (size_t i = 0; i < probe_count; ++i) {
+    is_hit[i] = HitTest(uvs[i], &hits[i]);
+    if (is_hit[i]) {
+      ++hit_count;
+    }
+  }
+  return hit_count;
+}
+
+glm::dvec3 DepthHitTester::GetCameraPoint(int x, int y, double depth) const {
+  const glm::vec2 ray = ray_table_.GetRay(x, y);
+  return glm::dvec3(ray.x * depth, ray.y * depth, depth);
+}
+
+}  // namespace tango_gl
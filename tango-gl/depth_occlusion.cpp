@@ -0,0 +1,319 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+
+#include <algorithm>
+
+#include "tango-gl/depth_occlusion.h"
+#include "tango-gl/counters.h"
+#include "tango-gl/memory_tracker.h"
+#include "tango-gl/program_cache.h"
+#include "tango-gl/render_state.h"
+#include "tango-gl/shaders.h"
+
+namespace {
+// Full screen quad as a triangle strip, in normalized device coordinates.
+const GLfloat kQuadVertices[] = {-1.0f, -1.0f, 1.0f, -1.0f,
+                                 -1.0f, 1.0f,  1.0f, 1.0f};
+
+// Resolution divisor of the depth image in kEdgeAware mode.
+const GLsizei kEdgeAwareDownsampling = 4;
+}  // namespace
+
+namespace tango_gl {
+
+const float DepthOcclusion::kDefaultPointSize = 12.0f;
+const float DepthOcclusion::kDefaultEdgeThreshold = 0.05f;
+
+DepthOcclusion::DepthOcclusion()
+    : mode_(kNearest),
+      point_size_(kDefaultPointSize),
+      edge_threshold_(kDefaultEdgeThreshold),
+      framebuffer_(0),
+      depth_texture_(0),
+      depth_renderbuffer_(0),
+      texture_width_(0),
+      texture_height_(0),
+      has_depth_(false),
+      is_unsupported_(false),
+      splat_program_(0),
+      splat_attrib_vertices_(-1),
+      splat_uniform_mvp_(-1),
+      splat_uniform_color_T_depth_(-1),
+      splat_uniform_point_size_(-1),
+      point_buffer_(GL_ARRAY_BUFFER, GL_STREAM_DRAW),
+      nearest_program_(),
+      edge_aware_program_(),
+      quad_buffer_(GL_ARRAY_BUFFER, GL_STATIC_DRAW) {}
+
+DepthOcclusion::~DepthOcclusion() { Release(); }
+
+bool DepthOcclusion::IsSupported() {
+  const char* extensions =
+      reinterpret_cast<const char*>(glGetString(GL_EXTENSIONS));
+  return extensions != nullptr &&
+         strstr(extensions, "GL_EXT_frag_depth") != nullptr;
+}
+
+void DepthOcclusion::SetMode(Mode mode) {
+  if (mode != mode_) {
+    // The depth image of the other mode has the wrong resolution.
+    has_depth_ = false;
+  }
+  mode_ = mode;
+}
+
+void DepthOcclusion::SetPointSize(float point_size) {
+  point_size_ = std::max(1.0f, point_size);
+}
+
+void DepthOcclusion::SetEdgeThreshold(float edge_threshold) {
+  edge_threshold_ = std::max(0.0f, edge_threshold);
+}
+
+bool DepthOcclusion::UpdateDepth(const float* points, size_t count,
+                                 const glm::mat4& color_T_depth,
+                                 const glm::mat4& projection, GLsizei width,
+                                 GLsizei height) {
+  const GLsizei downsampling =
+      mode_ == kEdgeAware ? kEdgeAwareDownsampling : 1;
+  if (is_unsupported_ || width <= 0 || height <= 0 ||
+      !Allocate(std::max<GLsizei>(1, width / downsampling),
+                std::max<GLsizei>(1, height / downsampling)) ||
+      !AcquireSplatProgram()) {
+    has_depth_ = false;
+    return false;
+  }
+
+  GLint viewport[4];
+  glGetIntegerv(GL_VIEWPORT, viewport);
+  glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_);
+  glViewport(0, 0, texture_width_, texture_height_);
+  glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+  if (count > 0) {
+    // Without the usual negation of the Y-axis, so that texture row 0 is the
+    // top row of the color image.
+    const glm::mat4 opengl_T_color(1.0f, 0.0f, 0.0f, 0.0f,
+                                   0.0f, 1.0f, 0.0f, 0.0f,
+                                   0.0f, 0.0f, -1.0f, 0.0f,
+                                   0.0f, 0.0f, 0.0f, 1.0f);
+    const glm::mat4 mvp = projection * opengl_T_color * color_T_depth;
+
+    point_buffer_.Update(points, count * 3 * sizeof(float), 0);
+    RenderState::UseProgram(splat_program_);
+    RenderState::Disable(GL_BLEND);
+    RenderState::Enable(GL_DEPTH_TEST);
+    glUniformMatrix4fv(splat_uniform_mvp_, 1, GL_FALSE, glm::value_ptr(mvp));
+    glUniformMatrix4fv(splat_uniform_color_T_depth_, 1, GL_FALSE,
+                       glm::value_ptr(color_T_depth));
+    glUniform1f(splat_uniform_point_size_,
+                std::max(1.0f, point_size_ / downsampling));
+
+    point_buffer_.Bind();
+    glEnableVertexAttribArray(splat_attrib_vertices_);
+    glVertexAttribPointer(splat_attrib_vertices_, 3, GL_FLOAT, GL_FALSE, 0,
+                          nullptr);
+    Counters::Increment(Counters::kDrawCalls);
+    glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(count));
+    glDisableVertexAttribArray(splat_attrib_vertices_);
+  }
+
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+  util::CheckGlError("DepthOcclusion::UpdateDepth");
+  has_depth_ = true;
+  return true;
+}
+
+void DepthOcclusion::Render(const glm::mat4& projection) {
+  if (has_depth_) {
+    Render(depth_texture_, texture_width_, texture_height_, projection);
+  }
+}
+
+void DepthOcclusion::Render(GLuint depth_texture, GLsizei width,
+                            GLsizei height, const glm::mat4& projection) {
+  OcclusionProgram* program =
+      mode_ == kEdgeAware ? &edge_aware_program_ : &nearest_program_;
+  if (depth_texture == 0 || width <= 0 || height <= 0 ||
+      !AcquireOcclusionProgram(mode_, program)) {
+    return;
+  }
+  if (quad_buffer_.GetSize() == 0) {
+    quad_buffer_.Update(kQuadVertices, sizeof(kQuadVertices), 0);
+  }
+
+  RenderState::UseProgram(program->program);
+  RenderState::ActiveTexture(GL_TEXTURE0);
+  RenderState::BindTexture(GL_TEXTURE_2D, depth_texture);
+  glUniform1i(program->uniform_depth_image, 0);
+  // Normalized device z of a point at distance d is -P[2][2] + P[3][2] / d.
+  glUniform2f(program->uniform_depth_transform, -projection[2][2],
+              projection[3][2]);
+  if (program->uniform_texel_size >= 0) {
+    glUniform2f(program->uniform_texel_size, 1.0f / width, 1.0f / height);
+    glUniform1f(program->uniform_edge_threshold, edge_threshold_);
+  }
+  RenderState::Disable(GL_BLEND);
+  RenderState::Enable(GL_DEPTH_TEST);
+  glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+
+  quad_buffer_.Bind();
+  glEnableVertexAttribArray(program->attrib_vertices);
+  glVertexAttribPointer(program->attrib_vertices, 2, GL_FLOAT, GL_FALSE, 0,
+                        nullptr);
+  Counters::Increment(Counters::kDrawCalls);
+  glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+  glDisableVertexAttribArray(program->attrib_vertices);
+
+  glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+  util::CheckGlError("DepthOcclusion::Render");
+}
+
+bool DepthOcclusion::Allocate(GLsizei width, GLsizei height) {
+  if (framebuffer_ != 0 && width == texture_width_ &&
+      height == texture_height_) {
+    return true;
+  }
+  if (framebuffer_ == 0) {
+    glGenFramebuffers(1, &framebuffer_);
+    glGenTextures(1, &depth_texture_);
+    glGenRenderbuffers(1, &depth_renderbuffer_);
+  }
+
+  RenderState::BindTexture(GL_TEXTURE_2D, depth_texture_);
+  // Encoded depths must not be filtered, kEdgeAware interpolates itself.
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA,
+               GL_UNSIGNED_BYTE, nullptr);
+
+  glBindRenderbuffer(GL_RENDERBUFFER, depth_renderbuffer_);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT16, width, height);
+  glBindRenderbuffer(GL_RENDERBUFFER, 0);
+  MemoryTracker::Track(
+      MemoryTracker::kTexture, depth_texture_, "DepthOcclusion",
+      MemoryTracker::GetTextureSize(width, height, GL_RGBA, GL_UNSIGNED_BYTE));
+  MemoryTracker::Track(MemoryTracker::kRenderbuffer, depth_renderbuffer_,
+                       "DepthOcclusion",
+                       static_cast<size_t>(width) * height * sizeof(GLushort));
+
+  glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_);
+  glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
+                         depth_texture_, 0);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
+                            GL_RENDERBUFFER, depth_renderbuffer_);
+  const GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  util::CheckGlError("DepthOcclusion::Allocate");
+
+  if (status != GL_FRAMEBUFFER_COMPLETE) {
+    LOGE("DepthOcclusion: framebuffer %dx%d incomplete (0x%x).", width, height,
+         status);
+    Release();
+    is_unsupported_ = true;
+    return false;
+  }
+  texture_width_ = width;
+  texture_height_ = height;
+  return true;
+}
+
+bool DepthOcclusion::AcquireSplatProgram() {
+  if (splat_program_ != 0) {
+    return true;
+  }
+  splat_program_ = program_cache::AcquireProgram(
+      shaders::GetDepthSplatVertexShader().c_str(),
+      shaders::GetDepthSplatFragmentShader().c_str());
+  if (!splat_program_) {
+    LOGE("DepthOcclusion: could not create splat program.");
+    return false;
+  }
+  splat_attrib_vertices_ = glGetAttribLocation(splat_program_, "vertex");
+  splat_uniform_mvp_ = glGetUniformLocation(splat_program_, "mvp");
+  splat_uniform_color_T_depth_ =
+      glGetUniformLocation(splat_program_, "color_T_depth");
+  splat_uniform_point_size_ =
+      glGetUniformLocation(splat_program_, "point_size");
+  return true;
+}
+
+bool DepthOcclusion::AcquireOcclusionProgram(Mode mode,
+                                             OcclusionProgram* program) {
+  if (program->program != 0) {
+    return true;
+  }
+  if (!IsSupported()) {
+    return false;
+  }
+  const std::string fragment_shader =
+      mode == kEdgeAware ? shaders::GetEdgeAwareOcclusionFragmentShader()
+                         : shaders::GetOcclusionFragmentShader();
+  program->program = program_cache::AcquireProgram(
+      shaders::GetOcclusionVertexShader().c_str(), fragment_shader.c_str());
+  if (!program->program) {
+    LOGE("DepthOcclusion: could not create occlusion program.");
+    return false;
+  }
+  program->attrib_vertices = glGetAttribLocation(program->program, "vertex");
+  program->uniform_depth_image =
+      glGetUniformLocation(program->program, "depth_image");
+  program->uniform_depth_transform =
+      glGetUniformLocation(program->program, "depth_transform");
+  program->uniform_texel_size =
+      glGetUniformLocation(program->program, "texel_size");
+  program->uniform_edge_threshold =
+      glGetUniformLocation(program->program, "edge_threshold");
+  return true;
+}
+
+void DepthOcclusion::Release() {
+  if (framebuffer_ != 0) {
+    glDeleteFramebuffers(1, &framebuffer_);
+    RenderState::DeleteTextures(1, &depth_texture_);
+    glDeleteRenderbuffers(1, &depth_renderbuffer_);
+    MemoryTracker::Untrack(MemoryTracker::kRenderbuffer, depth_renderbuffer_);
+  }
+  program_cache::ReleaseProgram(splat_program_);
+  program_cache::ReleaseProgram(nearest_program_.program);
+  program_cache::ReleaseProgram(edge_aware_program_.program);
+  point_buffer_.Release();
+  quad_buffer_.Release();
+  Invalidate();
+}
+
+void DepthOcclusion::Invalidate() {
+  point_buffer_.Invalidate();
+  quad_buffer_.Invalidate();
+  framebuffer_ = 0;
+  depth_texture_ = 0;
+  depth_renderbuffer_ = 0;
+  texture_width_ = 0;
+  texture_height_ = 0;
+  has_depth_ = false;
+  is_unsupported_ = false;
+  splat_program_ = 0;
+  nearest_program_ = OcclusionProgram();
+  edge_aware_program_ = OcclusionProgram();
+}
+
+}  // namespace tango_gl
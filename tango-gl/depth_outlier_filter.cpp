@@ -0,0 +1,234 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "tango-gl/depth_outlier_filter.h"
+
+#include <math.h>
+
+#include <algorithm>
+#include <limits>
+
+#include "tango-gl/counters.h"
+#include "tango-gl/frame_arena.h"
+
+namespace {
+// Tasks per pool thread, so threads that finish early can take over rows of
+// slower ones.
+const int kTasksPerThread = 4;
+
+// Score of pixels without a point.
+const float kNoScore = -1.0f;
+}  // namespace
+
+namespace tango_gl {
+
+DepthOutlierFilter::DepthOutlierFilter(const Options& options,
+                                       WorkerPool* worker_pool)
+    : options_(options),
+      worker_pool_(worker_pool),
+      outlier_count_(0),
+      threshold_(0.0f) {
+  options_.window_radius = std::max(options_.window_radius, 1);
+  const int window_size = 2 * options_.window_radius + 1;
+  options_.neighbor_count = std::max(
+      1, std::min(options_.neighbor_count, window_size * window_size - 1));
+}
+
+size_t DepthOutlierFilter::Filter(const RangeImage& image) {
+  const int width = image.GetWidth();
+  const int height = image.GetHeight();
+  const size_t pixel_count = static_cast<size_t>(width) * height;
+  scores_.resize(pixel_count);
+  std::fill(is_outlier_.begin(), is_outlier_.end(), 0);
+  outlier_count_ = 0;
+  threshold_ = 0.0f;
+  if (pixel_count == 0) {
+    return 0;
+  }
+
+  // Room for the index of every point in the image.
+  const int32_t* point_indices = image.GetPointIndices();
+  int32_t max_point_index = RangeImage::kNoPoint;
+  for (size_t i = 0; i < pixel_count; ++i) {
+    max_point_index = std::max(max_point_index, point_indices[i]);
+  }
+  if (is_outlier_.size() < static_cast<size_t>(max_point_index + 1)) {
+    is_outlier_.resize(max_point_index + 1, 0);
+  }
+
+  const int task_count = std::max(
+      1, std::min(worker_pool_ == nullptr
+                      ? 1
+                      : worker_pool_->GetConcurrency() * kTasksPerThread,
+                  height));
+  FrameArena& arena = FrameArena::ForThisThread();
+  FrameArena::Scope scope(&arena);
+  ArenaVector<ScoreSums> sums(task_count, ScoreSums(),
+                              ArenaAllocator<ScoreSums>(&arena));
+  RunTasks(task_count, [this, &image, &sums, height, task_count](int task) {
+    sums[task] = ScoreRows(image, height * task / task_count,
+                           height * (task + 1) / task_count);
+  });
+
+  // The bands are added in order, so the threshold does not depend on the
+  // threads that ran them.
+  ScoreSums total = ScoreSums();
+  for (const ScoreSums& band : sums) {
+    total.sum += band.sum;
+    total.sum2 += band.sum2;
+    total.count += band.count;
+  }
+  if (total.count > 0) {
+    const double mean = total.sum / total.count;
+    const double variance =
+        std::max(0.0, total.sum2 / total.count - mean * mean);
+    threshold_ =
+        static_cast<float>(mean + options_.std_ratio * sqrt(variance));
+  }
+
+  ArenaVector<size_t> counts(task_count, 0, ArenaAllocator<size_t>(&arena));
+  RunTasks(task_count, [this, &image, &counts, height, task_count](int task) {
+    counts[task] = MarkRows(image, height * task / task_count,
+                            height * (task + 1) / task_count);
+  });
+  for (size_t count : counts) {
+    outlier_count_ += count;
+  }
+  Counters::Add(Counters::kDepthOutliers, outlier_count_);
+  return outlier_count_;
+}
+
+size_t DepthOutlierFilter::CopyInliers(const float* points,
+                                       size_t point_count,
+                                       float* inliers) const {
+  size_t inlier_count = 0;
+  for (size_t i = 0; i < point_count; ++i) {
+    if (IsOutlier(i)) {
+      continue;
+    }
+    std::copy(points + i * 3, points + i * 3 + 3, inliers + inlier_count * 3);
+    ++inlier_count;
+  }
+  return inlier_count;
+}
+
+DepthOutlierFilter::ScoreSums DepthOutlierFilter::ScoreRows(
+    const RangeImage& image, int begin, int end) {
+  const int width = image.GetWidth();
+  const int height = image.GetHeight();
+  const int radius = options_.window_radius;
+  const int neighbor_count = options_.neighbor_count;
+  const float* depths = image.GetDepths();
+  const float* column_rays = image.GetRayTable().GetColumnRays();
+  const float* row_rays = image.GetRayTable().GetRowRays();
+  // Squared distances to the nearest neighbors of a point, ascending.
+  std::vector<float> nearest2(neighbor_count);
+
+  ScoreSums sums = ScoreSums();
+  for (int y = begin; y < end; ++y) {
+    const int top = std::max(y - radius, 0);
+    const int bottom = std::min(y + radius + 1, height);
+    for (int x = 0; x < width; ++x) {
+      const size_t index = static_cast<size_t>(y) * width + x;
+      const float depth = depths[index];
+      if (!(depth > 0.0f)) {
+        scores_[index] = kNoScore;
+        continue;
+      }
+      const float point_x = column_rays[x] * depth;
+      const float point_y = row_rays[y] * depth;
+
+      const int left = std::max(x - radius, 0);
+      const int right = std::min(x + radius + 1, width);
+      std::fill(nearest2.begin(), nearest2.end(),
+                std::numeric_limits<float>::infinity());
+      for (int neighbor_y = top; neighbor_y < bottom; ++neighbor_y) {
+        const float* row = depths + static_cast<size_t>(neighbor_y) * width;
+        for (int neighbor_x = left; neighbor_x < right; ++neighbor_x) {
+          const float neighbor_depth = row[neighbor_x];
+          if (!(neighbor_depth > 0.0f) ||
+              (neighbor_x == x && neighbor_y == y)) {
+            continue;
+          }
+          const float dx = column_rays[neighbor_x] * neighbor_depth - point_x;
+          const float dy = row_rays[neighbor_y] * neighbor_depth - point_y;
+          const float dz = neighbor_depth - depth;
+          const float distance2 = dx * dx + dy * dy + dz * dz;
+          // Insertion into the few nearest so far, most neighbors are
+          // rejected by the first comparison.
+          int i = neighbor_count - 1;
+          if (!(distance2 < nearest2[i])) {
+            continue;
+          }
+          for (; i > 0 && distance2 < nearest2[i - 1]; --i) {
+            nearest2[i] = nearest2[i - 1];
+          }
+          nearest2[i] = distance2;
+        }
+      }
+      // Too few neighbors leave the farthest slot empty.
+      if (nearest2[neighbor_count - 1] ==
+          std::numeric_limits<float>::infinity()) {
+        scores_[index] = std::numeric_limits<float>::infinity();
+        continue;
+      }
+
+      float distance_sum = 0.0f;
+      for (int i = 0; i < neighbor_count; ++i) {
+        distance_sum += sqrtf(nearest2[i]);
+      }
+      const float score = distance_sum / (neighbor_count * depth);
+      scores_[index] = score;
+      sums.sum += score;
+      sums.sum2 += static_cast<double>(score) * score;
+      ++sums.count;
+    }
+  }
+  return sums;
+}
+
+size_t DepthOutlierFilter::MarkRows(const RangeImage& image, int begin,
+                                    int end) {
+  const int width = image.GetWidth();
+  size_t outlier_count = 0;
+  for (int y = begin; y < end; ++y) {
+    for (int x = 0; x < width; ++x) {
+      const size_t index = static_cast<size_t>(y) * width + x;
+      // Isolated points score infinite, above any threshold.
+      if (scores_[index] == kNoScore || scores_[index] <= threshold_) {
+        continue;
+      }
+      // Every point is in at most one pixel, the tasks write disjoint flags.
+      is_outlier_[image.GetPointIndex(x, y)] = 1;
+      ++outlier_count;
+    }
+  }
+  return outlier_count;
+}
+
+void DepthOutlierFilter::RunTasks(int task_count,
+                                  const std::function<void(int)>& task) {
+  if (worker_pool_ == nullptr) {
+    for (int i = 0; i < task_count; ++i) {
+      task(i);
+    }
+  } else {
+    worker_pool_->ParallelFor(task_count, task);
+  }
+}
+
+}  // namespace tango_gl
@@ -0,0 +1,86 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "tango-gl/depth_statistics.h"
+
+#include <algorithm>
+#include <cfloat>
+
+#include "tango-gl/cpu_features.h"
+
+namespace {
+// Accumulate points [begin, end). Also the tail of the NEON kernel.
+void AccumulateDepthScalar(const float* points, size_t begin, size_t end,
+                           tango_gl::internal::DepthAccumulator* accumulator) {
+  using namespace tango_gl;
+  const float inverse_bin_size = 1.0f / kDepthHistogramBinSize;
+  for (size_t i = begin; i < end; ++i) {
+    const float depth = points[i * 3 + 2];
+    if (!(depth > 0.0f)) {
+      continue;
+    }
+    ++accumulator->valid_point_count;
+    accumulator->min_depth = std::min(accumulator->min_depth, depth);
+    accumulator->max_depth = std::max(accumulator->max_depth, depth);
+    accumulator->depth_sum += depth;
+    // Compared as floats so far away points never overflow the int cast.
+    const float bin = depth * inverse_bin_size;
+    ++accumulator->histogram[bin < kDepthHistogramBinCount - 1
+                                 ? static_cast<int>(bin)
+                                 : kDepthHistogramBinCount - 1];
+  }
+}
+}  // namespace
+
+namespace tango_gl {
+
+void ComputeDepthStatistics(const float* points, size_t point_count,
+                            DepthStatistics* statistics) {
+  internal::DepthAccumulator accumulator;
+  accumulator.valid_point_count = 0;
+  accumulator.min_depth = FLT_MAX;
+  accumulator.max_depth = 0.0f;
+  accumulator.depth_sum = 0.0;
+  std::fill(accumulator.histogram,
+            accumulator.histogram + kDepthHistogramBinCount, 0);
+
+  size_t begin = 0;
+#if defined(TANGO_GL_HAS_NEON)
+  if (cpu_features::IsNeonAvailable()) {
+    begin = point_count & ~static_cast<size_t>(3);
+    internal::AccumulateDepthNeon(points, point_count, &accumulator);
+  }
+#endif
+  AccumulateDepthScalar(points, begin, point_count, &accumulator);
+
+  statistics->valid_point_count = accumulator.valid_point_count;
+  if (accumulator.valid_point_count > 0) {
+    statistics->min_depth = accumulator.min_depth;
+    statistics->max_depth = accumulator.max_depth;
+    statistics->mean_depth = static_cast<float>(
+        accumulator.depth_sum / accumulator.valid_point_count);
+  } else {
+    statistics->min_depth = 0.0f;
+    statistics->max_depth = 0.0f;
+    statistics->mean_depth = 0.0f;
+  }
+  std::copy(accumulator.histogram,
+            accumulator.histogram + kDepthHistogramBinCount,
+            statistics->histogram);
+}
+
+}  // namespace tango_gl
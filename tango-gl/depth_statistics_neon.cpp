@@ -0,0 +1,106 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// This file is only compiled with NEON enabled (the ".neon" suffix in
+// Android.mk), the kernel is selected at runtime by depth_statistics.cpp.
+
+#include <arm_neon.h>
+
+#include <algorithm>
+#include <cfloat>
+
+#include "tango-gl/depth_statistics.h"
+
+namespace {
+// Iterations between flushes of the float lane sums into the double sum,
+// keeps the mean as precise as the scalar path.
+const size_t kSumFlushInterval = 256;
+
+inline float HorizontalSum(const float32x4_t& value) {
+  float32x2_t sum = vadd_f32(vget_low_f32(value), vget_high_f32(value));
+  return vget_lane_f32(vpadd_f32(sum, sum), 0);
+}
+}  // namespace
+
+namespace tango_gl {
+namespace internal {
+
+void AccumulateDepthNeon(const float* points, size_t point_count,
+                         DepthAccumulator* accumulator) {
+  const float32x4_t zero = vdupq_n_f32(0.0f);
+  const float32x4_t inverse_bin_size =
+      vdupq_n_f32(1.0f / kDepthHistogramBinSize);
+  const uint32x4_t last_bin = vdupq_n_u32(kDepthHistogramBinCount - 1);
+  // Invalid lanes are counted in a scratch bin past the histogram.
+  const uint32x4_t scratch_bin = vdupq_n_u32(kDepthHistogramBinCount);
+  uint32_t histogram[kDepthHistogramBinCount + 1] = {0};
+
+  float32x4_t min_depth = vdupq_n_f32(FLT_MAX);
+  float32x4_t max_depth = zero;
+  float32x4_t depth_sum = zero;
+  // Subtracting the all ones mask of a valid lane counts it up by one.
+  uint32x4_t valid = vdupq_n_u32(0);
+  uint32_t bins[4];
+
+  const size_t count = point_count & ~static_cast<size_t>(3);
+  for (size_t i = 0; i < count; i += 4) {
+    // Only z is needed, vld3 de-interleaves it from four xyz points.
+    const float32x4_t depth = vld3q_f32(points + i * 3).val[2];
+    const uint32x4_t is_valid = vcgtq_f32(depth, zero);
+
+    min_depth = vminq_f32(min_depth,
+                          vbslq_f32(is_valid, depth, vdupq_n_f32(FLT_MAX)));
+    max_depth = vmaxq_f32(max_depth, vbslq_f32(is_valid, depth, zero));
+    depth_sum = vaddq_f32(depth_sum, vbslq_f32(is_valid, depth, zero));
+    valid = vsubq_u32(valid, is_valid);
+
+    // The conversion saturates, far points end up in the last bin.
+    uint32x4_t bin = vcvtq_u32_f32(vmulq_f32(depth, inverse_bin_size));
+    bin = vbslq_u32(is_valid, vminq_u32(bin, last_bin), scratch_bin);
+    vst1q_u32(bins, bin);
+    ++histogram[bins[0]];
+    ++histogram[bins[1]];
+    ++histogram[bins[2]];
+    ++histogram[bins[3]];
+
+    if ((i / 4) % kSumFlushInterval == kSumFlushInterval - 1) {
+      accumulator->depth_sum += HorizontalSum(depth_sum);
+      depth_sum = zero;
+    }
+  }
+  accumulator->depth_sum += HorizontalSum(depth_sum);
+
+  float lanes[4];
+  vst1q_f32(lanes, min_depth);
+  for (int i = 0; i < 4; ++i) {
+    accumulator->min_depth = std::min(accumulator->min_depth, lanes[i]);
+  }
+  vst1q_f32(lanes, max_depth);
+  for (int i = 0; i < 4; ++i) {
+    accumulator->max_depth = std::max(accumulator->max_depth, lanes[i]);
+  }
+  uint32_t valid_lanes[4];
+  vst1q_u32(valid_lanes, valid);
+  accumulator->valid_point_count +=
+      valid_lanes[0] + valid_lanes[1] + valid_lanes[2] + valid_lanes[3];
+  for (int i = 0; i < kDepthHistogramBinCount; ++i) {
+    accumulator->histogram[i] += histogram[i];
+  }
+}
+
+}  // namespace internal
+}  // namespace tango_gl
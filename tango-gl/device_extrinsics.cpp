@@ -0,0 +1,95 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "tango-gl/device_extrinsics.h"
+#include "tango-gl/conversions.h"
+#include "tango-gl/service_probe.h"
+
+namespace {
+// Get the pose of a sensor frame with respect to the IMU frame.
+TangoErrorType QueryImuTransform(TangoCoordinateFrameType target,
+                                 glm::mat4* imu_T_target) {
+  TangoCoordinateFramePair frame_pair;
+  frame_pair.base = TANGO_COORDINATE_FRAME_IMU;
+  frame_pair.target = target;
+  TangoPoseData pose;
+  TangoErrorType ret;
+  {
+    tango_gl::ServiceProbe::ScopedCall probe(
+        tango_gl::ServiceProbe::kGetPoseAtTime);
+    ret = TangoService_getPoseAtTime(0.0, frame_pair, &pose);
+  }
+  if (ret != TANGO_SUCCESS) {
+    LOGE(
+        "DeviceExtrinsics: Failed to get the transform between the IMU and "
+        "frame %d. Something is wrong with device extrinsics.",
+        target);
+    return ret;
+  }
+  *imu_T_target = tango_gl::conversions::TransformFromArrays(
+                      pose.translation, pose.orientation).ToMatrix();
+  return TANGO_SUCCESS;
+}
+}  // namespace
+
+namespace tango_gl {
+
+DeviceExtrinsics::DeviceExtrinsics() {
+  SetImuTransforms(glm::mat4(1.0f), glm::mat4(1.0f), glm::mat4(1.0f));
+}
+
+TangoErrorType DeviceExtrinsics::Query() {
+  glm::mat4 imu_T_device;
+  glm::mat4 imu_T_color;
+  glm::mat4 imu_T_depth;
+  TangoErrorType ret =
+      QueryImuTransform(TANGO_COORDINATE_FRAME_DEVICE, &imu_T_device);
+  if (ret != TANGO_SUCCESS) {
+    return ret;
+  }
+  ret = QueryImuTransform(TANGO_COORDINATE_FRAME_CAMERA_COLOR, &imu_T_color);
+  if (ret != TANGO_SUCCESS) {
+    return ret;
+  }
+  ret = QueryImuTransform(TANGO_COORDINATE_FRAME_CAMERA_DEPTH, &imu_T_depth);
+  if (ret != TANGO_SUCCESS) {
+    return ret;
+  }
+  SetImuTransforms(imu_T_device, imu_T_color, imu_T_depth);
+  return TANGO_SUCCESS;
+}
+
+void DeviceExtrinsics::SetImuTransforms(const glm::mat4& imu_T_device,
+                                        const glm::mat4& imu_T_color,
+                                        const glm::mat4& imu_T_depth) {
+  const glm::mat4 device_T_imu = glm::inverse(imu_T_device);
+  device_T_color_ = device_T_imu * imu_T_color;
+  color_T_device_ = glm::inverse(device_T_color_);
+  device_T_depth_ = device_T_imu * imu_T_depth;
+  depth_T_device_ = glm::inverse(device_T_depth_);
+  color_T_depth_ = color_T_device_ * device_T_depth_;
+  depth_T_color_ = depth_T_device_ * device_T_color_;
+
+  device_T_opengl_color_camera_ =
+      device_T_color_ * conversions::CameraTOpenGlCamera();
+  opengl_color_camera_T_device_ = glm::inverse(device_T_opengl_color_camera_);
+  device_T_opengl_depth_camera_ =
+      device_T_depth_ * conversions::CameraTOpenGlCamera();
+  opengl_depth_camera_T_device_ = glm::inverse(device_T_opengl_depth_camera_);
+}
+
+}  // namespace tango_gl
@@ -0,0 +1,580 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <EGL/egl.h>
+#include <string.h>
+
+#include <algorithm>
+#include <string>
+
+#include "tango-gl/draw_batch.h"
+#include "tango-gl/counters.h"
+#include "tango-gl/frame_constants.h"
+#include "tango-gl/program_cache.h"
+#include "tango-gl/render_state.h"
+#include "tango-gl/shader_variants.h"
+
+namespace {
+typedef void (GL_APIENTRY* DrawArraysInstancedFunc)(GLenum mode, GLint first,
+                                                    GLsizei count,
+                                                    GLsizei instance_count);
+typedef void (GL_APIENTRY* DrawElementsInstancedFunc)(
+    GLenum mode, GLsizei count, GLenum type, const GLvoid* indices,
+    GLsizei instance_count);
+typedef void (GL_APIENTRY* VertexAttribDivisorFunc)(GLuint index,
+                                                    GLuint divisor);
+
+// Instancing entry points of the current context, null if not supported.
+DrawArraysInstancedFunc g_draw_arrays_instanced = nullptr;
+DrawElementsInstancedFunc g_draw_elements_instanced = nullptr;
+VertexAttribDivisorFunc g_vertex_attrib_divisor = nullptr;
+
+// Per instance data: a column major model matrix followed by a color.
+const int kInstanceFloats = 16 + 4;
+const GLsizei kInstanceStride = kInstanceFloats * sizeof(GLfloat);
+
+const uint64_t kFnvOffsetBasis = 14695981039346656037ULL;
+const uint64_t kFnvPrime = 1099511628211ULL;
+
+uint64_t HashBytes(const void* data, size_t size, uint64_t hash) {
+  const uint8_t* bytes = static_cast<const uint8_t*>(data);
+  for (size_t i = 0; i < size; ++i) {
+    hash ^= bytes[i];
+    hash *= kFnvPrime;
+  }
+  return hash;
+}
+
+void ResolveInstancing() {
+  const char* version = reinterpret_cast<const char*>(glGetString(GL_VERSION));
+  const char* extensions =
+      reinterpret_cast<const char*>(glGetString(GL_EXTENSIONS));
+  std::string suffix;
+  if (version != nullptr && strncmp(version, "OpenGL ES 3", 11) == 0) {
+    suffix = "";
+  } else if (extensions != nullptr &&
+             strstr(extensions, "GL_EXT_instanced_arrays") != nullptr) {
+    suffix = "EXT";
+  } else if (extensions != nullptr &&
+             strstr(extensions, "GL_ANGLE_instanced_arrays") != nullptr) {
+    suffix = "ANGLE";
+  } else {
+    g_draw_arrays_instanced = nullptr;
+    g_draw_elements_instanced = nullptr;
+    g_vertex_attrib_divisor = nullptr;
+    return;
+  }
+
+  g_draw_arrays_instanced = reinterpret_cast<DrawArraysInstancedFunc>(
+      eglGetProcAddress(("glDrawArraysInstanced" + suffix).c_str()));
+  g_draw_elements_instanced = reinterpret_cast<DrawElementsInstancedFunc>(
+      eglGetProcAddress(("glDrawElementsInstanced" + suffix).c_str()));
+  g_vertex_attrib_divisor = reinterpret_cast<VertexAttribDivisorFunc>(
+      eglGetProcAddress(("glVertexAttribDivisor" + suffix).c_str()));
+  if (g_draw_arrays_instanced == nullptr ||
+      g_draw_elements_instanced == nullptr ||
+      g_vertex_attrib_divisor == nullptr) {
+    g_draw_arrays_instanced = nullptr;
+    g_draw_elements_instanced = nullptr;
+    g_vertex_attrib_divisor = nullptr;
+  }
+}
+
+bool IsInstancingAvailable() { return g_vertex_attrib_divisor != nullptr; }
+}  // namespace
+
+namespace tango_gl {
+
+DrawBatch::Group::Group()
+    : type(kUnlitMesh),
+      render_mode(GL_TRIANGLES),
+      line_width(1.0f),
+      geometry_hash(0),
+      vertex_count(0),
+      is_geometry_dirty(true),
+      vertex_buffer(GL_ARRAY_BUFFER, GL_STATIC_DRAW),
+      index_buffer(GL_ELEMENT_ARRAY_BUFFER, GL_STATIC_DRAW),
+      instance_buffer(GL_ARRAY_BUFFER, GL_DYNAMIC_DRAW),
+      store(nullptr),
+      store_mesh(0) {}
+
+DrawBatch::DrawBatch() : is_gl_initialized_(false) {
+  memset(programs_, 0, sizeof(programs_));
+}
+
+DrawBatch::~DrawBatch() { Release(); }
+
+void DrawBatch::Add(const Mesh* mesh) {
+  Remove(mesh);
+  const GroupType type = mesh->is_lighting_on_ ? kLitMesh : kUnlitMesh;
+  if (AddToSharedGroup(mesh, mesh->geometry_, type, mesh->render_mode_, 1.0f)) {
+    return;
+  }
+  std::vector<GLfloat> vertices;
+  if (!GetMeshVertices(mesh, type, &vertices)) {
+    // Meshes set from a MappedMesh keep no CPU copy to batch.
+    LOGE("DrawBatch::Add, mesh has no CPU side vertices.");
+    return;
+  }
+  const std::vector<GLushort>& mesh_indices = mesh->GetIndices();
+  const size_t vertex_count = vertices.size() / (type == kLitMesh ? 6 : 3);
+
+  uint64_t hash = HashBytes(vertices.data(), vertices.size() * sizeof(GLfloat),
+                            kFnvOffsetBasis);
+  hash = HashBytes(mesh_indices.data(),
+                   mesh_indices.size() * sizeof(GLushort), hash);
+  Group* group = nullptr;
+  for (std::unique_ptr<Group>& candidate : groups_) {
+    if (candidate->store == nullptr && candidate->type == type &&
+        candidate->render_mode == mesh->render_mode_ &&
+        candidate->geometry_hash == hash &&
+        candidate->vertices == vertices &&
+        candidate->indices == mesh_indices) {
+      group = candidate.get();
+      break;
+    }
+  }
+  if (group == nullptr) {
+    group = new Group();
+    group->type = type;
+    group->render_mode = mesh->render_mode_;
+    group->geometry_hash = hash;
+    group->vertices.swap(vertices);
+    group->indices = mesh_indices;
+    group->vertex_count = vertex_count;
+    groups_.push_back(std::unique_ptr<Group>(group));
+  }
+  if (!group->shared_geometry) {
+    group->shared_geometry = mesh->geometry_;
+  }
+  group->objects.push_back(mesh);
+}
+
+bool DrawBatch::GetMeshVertices(const Mesh* mesh, GroupType type,
+                                std::vector<GLfloat>* vertices) {
+  const std::vector<GLfloat>& mesh_vertices = mesh->GetVertices();
+  const std::vector<GLfloat>& mesh_normals = mesh->GetNormals();
+  if (mesh_vertices.empty()) {
+    return false;
+  }
+
+  const bool is_lit = type == kLitMesh;
+  const bool has_normals =
+      !mesh_normals.empty() && mesh_normals.size() == mesh_vertices.size();
+  const size_t vertex_count = mesh_vertices.size() / 3;
+  const size_t floats_per_vertex = is_lit ? 6 : 3;
+
+  // Lit meshes without normals only get the ambient term, like in
+  // Mesh::Render().
+  vertices->assign(vertex_count * floats_per_vertex, 0.0f);
+  for (size_t i = 0; i < vertex_count; ++i) {
+    std::copy(mesh_vertices.begin() + i * 3,
+              mesh_vertices.begin() + i * 3 + 3,
+              vertices->begin() + i * floats_per_vertex);
+    if (is_lit && has_normals) {
+      std::copy(mesh_normals.begin() + i * 3,
+                mesh_normals.begin() + i * 3 + 3,
+                vertices->begin() + i * floats_per_vertex + 3);
+    }
+  }
+  return true;
+}
+
+void DrawBatch::Add(const ObjectStore* store) {
+  static_assert(ObjectStore::kInstanceFloats == kInstanceFloats,
+                "ObjectStore instance layout differs from DrawBatch.");
+  // Groups of meshes already added keep their uploaded instances.
+  std::vector<bool> has_group(store->GetMeshCount(), false);
+  for (const std::unique_ptr<Group>& group : groups_) {
+    if (group->store == store) {
+      has_group[group->store_mesh] = true;
+    }
+  }
+  for (uint32_t i = 0; i < store->GetMeshCount(); ++i) {
+    if (has_group[i]) {
+      continue;
+    }
+    const Mesh* mesh = store->GetMesh(i);
+    const GroupType type = mesh->is_lighting_on_ ? kLitMesh : kUnlitMesh;
+    std::unique_ptr<Group> group(new Group());
+    if (!GetMeshVertices(mesh, type, &group->vertices)) {
+      LOGE("DrawBatch::Add, mesh has no CPU side vertices.");
+      continue;
+    }
+    group->type = type;
+    group->render_mode = mesh->render_mode_;
+    group->indices = mesh->GetIndices();
+    group->vertex_count = group->vertices.size() / (type == kLitMesh ? 6 : 3);
+    group->store = store;
+    group->store_mesh = i;
+    groups_.push_back(std::move(group));
+  }
+}
+
+void DrawBatch::Add(const Axis* axis) {
+  Remove(axis);
+  const std::shared_ptr<const Geometry>& geometry = axis->geometry_;
+  if (AddToSharedGroup(axis, geometry, kAxis, axis->render_mode_,
+                       axis->line_width_)) {
+    return;
+  }
+
+  // Position and color of a vertex next to each other:
+  // [x, y, z, r, g, b, a, x, ...]
+  const size_t vertex_count = geometry->GetVertexCount();
+  std::vector<GLfloat> vertices(vertex_count * 7);
+  for (size_t i = 0; i < vertex_count; ++i) {
+    std::copy(geometry->vertices.begin() + i * 3,
+              geometry->vertices.begin() + i * 3 + 3,
+              vertices.begin() + i * 7);
+    std::copy(geometry->colors.begin() + i * 4,
+              geometry->colors.begin() + i * 4 + 4,
+              vertices.begin() + i * 7 + 3);
+  }
+
+  uint64_t hash = HashBytes(vertices.data(), vertices.size() * sizeof(GLfloat),
+                            kFnvOffsetBasis);
+  Group* group = nullptr;
+  for (std::unique_ptr<Group>& candidate : groups_) {
+    if (candidate->store == nullptr && candidate->type == kAxis &&
+        candidate->render_mode == axis->render_mode_ &&
+        candidate->line_width == axis->line_width_ &&
+        candidate->geometry_hash == hash && candidate->vertices == vertices) {
+      group = candidate.get();
+      break;
+    }
+  }
+  if (group == nullptr) {
+    group = new Group();
+    group->type = kAxis;
+    group->render_mode = axis->render_mode_;
+    group->line_width = axis->line_width_;
+    group->geometry_hash = hash;
+    group->vertices.swap(vertices);
+    group->vertex_count = vertex_count;
+    groups_.push_back(std::unique_ptr<Group>(group));
+  }
+  if (!group->shared_geometry) {
+    group->shared_geometry = geometry;
+  }
+  group->objects.push_back(axis);
+}
+
+bool DrawBatch::AddToSharedGroup(
+    const DrawableObject* object,
+    const std::shared_ptr<const Geometry>& geometry, GroupType type,
+    GLenum render_mode, float line_width) {
+  if (!geometry) {
+    return false;
+  }
+  for (std::unique_ptr<Group>& candidate : groups_) {
+    if (candidate->store == nullptr &&
+        candidate->shared_geometry == geometry && candidate->type == type &&
+        candidate->render_mode == render_mode &&
+        candidate->line_width == line_width) {
+      candidate->objects.push_back(object);
+      return true;
+    }
+  }
+  return false;
+}
+
+void DrawBatch::Remove(const DrawableObject* object) {
+  for (auto group = groups_.begin(); group != groups_.end(); ++group) {
+    std::vector<const DrawableObject*>& objects = (*group)->objects;
+    auto found = std::find(objects.begin(), objects.end(), object);
+    if (found != objects.end()) {
+      objects.erase(found);
+      if (objects.empty()) {
+        groups_.erase(group);
+      }
+      return;
+    }
+  }
+}
+
+void DrawBatch::Remove(const ObjectStore* store) {
+  groups_.erase(std::remove_if(groups_.begin(), groups_.end(),
+                               [store](const std::unique_ptr<Group>& group) {
+                                 return group->store == store;
+                               }),
+                groups_.end());
+}
+
+void DrawBatch::Clear() { groups_.clear(); }
+
+void DrawBatch::InitializeGL() {
+  ResolveInstancing();
+
+  const uint32_t features[] = {
+      shader_variants::kInstanced,
+      shader_variants::kInstanced | shader_variants::kLighting,
+      shader_variants::kInstanced | shader_variants::kVertexColor};
+  for (int i = 0; i < 3; ++i) {
+    Program& program = programs_[i];
+    const shader_variants::Variant* variant = shader_variants::Acquire(
+        features[i] | shader_variants::kFrameConstants);
+    if (variant == nullptr) {
+      LOGE("Could not create program.");
+      memset(&program, 0, sizeof(program));
+      continue;
+    }
+    program.program = variant->program;
+    program.uniform_vp_mat = variant->uniforms[shader_variants::kVp];
+    program.uniform_view_mat = variant->uniforms[shader_variants::kView];
+    program.uniform_light_vec = variant->uniforms[shader_variants::kLightVec];
+    program.uniform_ambient = variant->uniforms[shader_variants::kAmbient];
+    program.attrib_vertices =
+        variant->attributes[shader_variants::kVertexAttribute];
+    program.attrib_normals =
+        variant->attributes[shader_variants::kNormalAttribute];
+    program.attrib_colors =
+        variant->attributes[shader_variants::kColorAttribute];
+    program.attrib_model_mat =
+        variant->attributes[shader_variants::kModelAttribute];
+    program.attrib_instance_color =
+        variant->attributes[shader_variants::kInstanceColorAttribute];
+  }
+  is_gl_initialized_ = true;
+}
+
+void DrawBatch::Render(const glm::mat4& projection_mat,
+                       const glm::mat4& view_mat) {
+  if (groups_.empty()) {
+    return;
+  }
+  if (!is_gl_initialized_) {
+    InitializeGL();
+  }
+
+  FrameConstants::Set(projection_mat, view_mat);
+  const glm::mat4 vp_mat =
+      FrameConstants::GetViewProjection(projection_mat, view_mat);
+  for (std::unique_ptr<Group>& group : groups_) {
+    RenderGroup(group.get(), vp_mat, view_mat);
+  }
+  util::CheckGlError("DrawBatch::Render");
+}
+
+void DrawBatch::RenderGroup(Group* group, const glm::mat4& vp_mat,
+                            const glm::mat4& view_mat) {
+  if (group->is_geometry_dirty) {
+    group->vertex_buffer.Update(group->vertices.data(),
+                                group->vertices.size() * sizeof(GLfloat), 0);
+    if (!group->indices.empty()) {
+      group->index_buffer.Update(group->indices.data(),
+                                 group->indices.size() * sizeof(GLushort), 0);
+    }
+    group->is_geometry_dirty = false;
+    group->vertex_array.Reset();
+  }
+
+  const GLfloat* store_instances = nullptr;
+  size_t instance_count = group->objects.size();
+  if (group->store != nullptr) {
+    const std::vector<GLfloat>& source =
+        group->store->GetInstances(group->store_mesh);
+    store_instances = source.data();
+    instance_count = source.size() / kInstanceFloats;
+    if (instance_count == 0) {
+      return;
+    }
+  }
+  std::vector<GLfloat>& instances = group->instances;
+  // Only the instances that changed since the last frame are uploaded again,
+  // nothing for static content.
+  size_t dirty_offset = instances.size() == instance_count * kInstanceFloats
+                            ? instances.size() * sizeof(GLfloat)
+                            : 0;
+  instances.resize(instance_count * kInstanceFloats);
+  for (size_t i = 0; i < instance_count; ++i) {
+    GLfloat object_instance[kInstanceFloats];
+    const GLfloat* instance = object_instance;
+    if (store_instances != nullptr) {
+      instance = store_instances + i * kInstanceFloats;
+    } else {
+      const DrawableObject* object = group->objects[i];
+      const glm::mat4 model_mat = object->GetTransformationMatrix();
+      std::copy(glm::value_ptr(model_mat), glm::value_ptr(model_mat) + 16,
+                object_instance);
+      object_instance[16] = object->red_;
+      object_instance[17] = object->green_;
+      object_instance[18] = object->blue_;
+      object_instance[19] = object->alpha_;
+    }
+    GLfloat* stored = &instances[i * kInstanceFloats];
+    if (memcmp(stored, instance, kInstanceStride) != 0) {
+      std::copy(instance, instance + kInstanceFloats, stored);
+      dirty_offset = std::min<size_t>(dirty_offset, i * kInstanceStride);
+    }
+  }
+
+  const Program& program = programs_[group->type];
+  RenderState::UseProgram(program.program);
+  // The matrices are -1 in kFrameConstants programs.
+  if (program.uniform_vp_mat >= 0) {
+    glUniformMatrix4fv(program.uniform_vp_mat, 1, GL_FALSE,
+                       glm::value_ptr(vp_mat));
+  }
+  if (group->type == kLitMesh) {
+    const Mesh* mesh =
+        group->store != nullptr
+            ? group->store->GetMesh(group->store_mesh)
+            : static_cast<const Mesh*>(group->objects[0]);
+    glm::vec3 light_direction = glm::mat3(view_mat) * mesh->light_direction_;
+    if (program.uniform_view_mat >= 0) {
+      glUniformMatrix4fv(program.uniform_view_mat, 1, GL_FALSE,
+                         glm::value_ptr(view_mat));
+    }
+    glUniform3fv(program.uniform_light_vec, 1,
+                 glm::value_ptr(light_direction));
+    glUniform4fv(program.uniform_ambient, 1,
+                 glm::value_ptr(Mesh::GetAmbientLight()));
+  } else if (group->type == kAxis) {
+    RenderState::LineWidth(group->line_width);
+  }
+
+  const bool is_instanced = IsInstancingAvailable();
+  if (is_instanced) {
+    group->instance_buffer.Update(instances.data(),
+                                  instances.size() * sizeof(GLfloat),
+                                  dirty_offset);
+  }
+
+  // The color is not used by the axis program, its location is -1.
+  const bool has_instance_color = program.attrib_instance_color >= 0;
+  const bool has_indices = !group->indices.empty();
+  // The attribute setup, instance divisors included, is recorded once per
+  // group; drawing a group then costs a bind and a draw call.
+  if (!group->vertex_array.Bind()) {
+    // Per vertex attributes.
+    const GLsizei floats_per_vertex =
+        group->type == kAxis ? 7 : (group->type == kLitMesh ? 6 : 3);
+    const GLsizei stride = floats_per_vertex * sizeof(GLfloat);
+    const GLvoid* second_attrib_offset =
+        reinterpret_cast<const GLvoid*>(3 * sizeof(GLfloat));
+    group->vertex_buffer.Bind();
+    group->vertex_array.EnableAttribute(program.attrib_vertices);
+    glVertexAttribPointer(program.attrib_vertices, 3, GL_FLOAT, GL_FALSE,
+                          stride, nullptr);
+    if (group->type == kLitMesh) {
+      group->vertex_array.EnableAttribute(program.attrib_normals);
+      glVertexAttribPointer(program.attrib_normals, 3, GL_FLOAT, GL_FALSE,
+                            stride, second_attrib_offset);
+    } else if (group->type == kAxis) {
+      group->vertex_array.EnableAttribute(program.attrib_colors);
+      glVertexAttribPointer(program.attrib_colors, 4, GL_FLOAT, GL_FALSE,
+                            stride, second_attrib_offset);
+    }
+    if (has_indices) {
+      group->index_buffer.Bind();
+    }
+
+    if (is_instanced) {
+      group->instance_buffer.Bind();
+      for (int column = 0; column < 4; ++column) {
+        const GLuint location = program.attrib_model_mat + column;
+        group->vertex_array.EnableAttribute(location);
+        glVertexAttribPointer(
+            location, 4, GL_FLOAT, GL_FALSE, kInstanceStride,
+            reinterpret_cast<const GLvoid*>(column * 4 * sizeof(GLfloat)));
+        g_vertex_attrib_divisor(location, 1);
+      }
+      if (has_instance_color) {
+        group->vertex_array.EnableAttribute(program.attrib_instance_color);
+        glVertexAttribPointer(
+            program.attrib_instance_color, 4, GL_FLOAT, GL_FALSE,
+            kInstanceStride,
+            reinterpret_cast<const GLvoid*>(16 * sizeof(GLfloat)));
+        g_vertex_attrib_divisor(program.attrib_instance_color, 1);
+      }
+    }
+  }
+
+  if (is_instanced) {
+    Counters::Increment(Counters::kDrawCalls);
+    if (has_indices) {
+      g_draw_elements_instanced(group->render_mode, group->indices.size(),
+                                GL_UNSIGNED_SHORT, nullptr, instance_count);
+    } else {
+      g_draw_arrays_instanced(group->render_mode, 0, group->vertex_count,
+                              instance_count);
+    }
+
+    // Without vertex array objects the divisors are attribute state shared
+    // with every other drawable.
+    if (!RenderState::HasVertexArrays()) {
+      for (int column = 0; column < 4; ++column) {
+        g_vertex_attrib_divisor(program.attrib_model_mat + column, 0);
+      }
+      if (has_instance_color) {
+        g_vertex_attrib_divisor(program.attrib_instance_color, 0);
+      }
+    }
+  } else {
+    // Without instancing the per instance attributes are set as constant
+    // attribute values, one draw call per object.
+    for (size_t i = 0; i < instance_count; ++i) {
+      const GLfloat* instance = &instances[i * kInstanceFloats];
+      for (int column = 0; column < 4; ++column) {
+        glVertexAttrib4fv(program.attrib_model_mat + column,
+                          instance + column * 4);
+      }
+      if (has_instance_color) {
+        glVertexAttrib4fv(program.attrib_instance_color, instance + 16);
+      }
+      Counters::Increment(Counters::kDrawCalls);
+      if (has_indices) {
+        glDrawElements(group->render_mode, group->indices.size(),
+                       GL_UNSIGNED_SHORT, nullptr);
+      } else {
+        glDrawArrays(group->render_mode, 0, group->vertex_count);
+      }
+    }
+  }
+  group->vertex_array.Unbind();
+}
+
+void DrawBatch::Release() {
+  for (std::unique_ptr<Group>& group : groups_) {
+    group->vertex_buffer.Release();
+    group->index_buffer.Release();
+    group->instance_buffer.Release();
+    group->vertex_array.Release();
+    group->is_geometry_dirty = true;
+  }
+  if (is_gl_initialized_) {
+    for (Program& program : programs_) {
+      program_cache::ReleaseProgram(program.program);
+    }
+    memset(programs_, 0, sizeof(programs_));
+    is_gl_initialized_ = false;
+  }
+}
+
+void DrawBatch::Invalidate() {
+  for (std::unique_ptr<Group>& group : groups_) {
+    group->vertex_buffer.Invalidate();
+    group->index_buffer.Invalidate();
+    group->instance_buffer.Invalidate();
+    group->vertex_array.Invalidate();
+    group->is_geometry_dirty = true;
+  }
+  memset(programs_, 0, sizeof(programs_));
+  is_gl_initialized_ = false;
+}
+
+}  // namespace tango_gl
@@ -15,23 +15,48 @@
  */
 
 #include "tango-gl/drawable_object.h"
-#include "tango-gl/shaders.h"
+#include "tango-gl/frame_constants.h"
+#include "tango-gl/program_cache.h"
+#include "tango-gl/shader_variants.h"
+#include "tango-gl/simd_math.h"
 
 namespace tango_gl {
 
 void DrawableObject::SetShader() {
-  shader_program_ =
-      util::CreateProgram(shaders::GetBasicVertexShader().c_str(),
-                          shaders::GetBasicFragmentShader().c_str());
-  if (!shader_program_) {
+  program_cache::ReleaseProgram(shader_program_);
+  shader_program_ = 0;
+  const shader_variants::Variant* variant =
+      shader_variants::Acquire(shader_variants::kFrameConstants);
+  if (variant == nullptr) {
     LOGE("Could not create program.");
+    return;
   }
-  uniform_mvp_mat_ = glGetUniformLocation(shader_program_, "mvp");
-  attrib_vertices_ = glGetAttribLocation(shader_program_, "vertex");
-  uniform_color_ = glGetUniformLocation(shader_program_, "color");
+  shader_program_ = variant->program;
+  uniform_mvp_mat_ = variant->uniforms[shader_variants::kMvp];
+  uses_frame_constants_ =
+      (variant->features & shader_variants::kFrameConstants) != 0;
+  uniform_model_mat_ = variant->uniforms[shader_variants::kModel];
+  attrib_vertices_ = variant->attributes[shader_variants::kVertexAttribute];
+  uniform_color_ = variant->uniforms[shader_variants::kColor];
 }
 
-DrawableObject::~DrawableObject() { glDeleteShader(shader_program_); }
+void DrawableObject::SetTransformUniforms(const glm::mat4& projection_mat,
+                                          const glm::mat4& view_mat,
+                                          const glm::mat4& model_mat) const {
+  if (uses_frame_constants_) {
+    FrameConstants::Set(projection_mat, view_mat);
+    glUniformMatrix4fv(uniform_model_mat_, 1, GL_FALSE,
+                       glm::value_ptr(model_mat));
+    return;
+  }
+  const glm::mat4 mvp_mat = simd_math::Multiply(
+      FrameConstants::GetViewProjection(projection_mat, view_mat), model_mat);
+  glUniformMatrix4fv(uniform_mvp_mat_, 1, GL_FALSE, glm::value_ptr(mvp_mat));
+}
+
+DrawableObject::~DrawableObject() {
+  program_cache::ReleaseProgram(shader_program_);
+}
 
 void DrawableObject::SetColor(float red, float green, float blue) {
   red_ = red;
@@ -46,17 +71,33 @@ void DrawableObject::SetAlpha(const float alpha) { alpha_ = alpha; }
 
 void DrawableObject::SetVertices(const std::vector<GLfloat>& vertices) {
   vertices_ = vertices;
+  geometry_.reset();
+  is_vertex_data_dirty_ = true;
 }
 
 void DrawableObject::SetVertices(const std::vector<GLfloat>& vertices,
                                  const std::vector<GLushort>& indices) {
   vertices_ = vertices;
   indices_ = indices;
+  geometry_.reset();
+  is_vertex_data_dirty_ = true;
 }
 
 void DrawableObject::SetVertices(const std::vector<GLfloat>& vertices,
                                  const std::vector<GLfloat>& normals) {
   vertices_ = vertices;
   normals_ = normals;
+  geometry_.reset();
+  is_vertex_data_dirty_ = true;
+}
+
+void DrawableObject::SetVertices(const std::vector<GLfloat>& vertices,
+                                 const std::vector<GLfloat>& normals,
+                                 const std::vector<GLushort>& indices) {
+  vertices_ = vertices;
+  normals_ = normals;
+  indices_ = indices;
+  geometry_.reset();
+  is_vertex_data_dirty_ = true;
 }
 }  // namespace tango_gl
@@ -0,0 +1,273 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <cmath>
+
+#include "tango-gl/dynamic_resolution_target.h"
+#include "tango-gl/counters.h"
+#include "tango-gl/memory_tracker.h"
+#include "tango-gl/program_cache.h"
+#include "tango-gl/render_state.h"
+#include "tango-gl/shaders.h"
+
+namespace {
+// Full screen quad as a triangle strip, in normalized device coordinates.
+const GLfloat kQuadVertices[] = {-1.0f, -1.0f, 1.0f, -1.0f,
+                                 -1.0f, 1.0f,  1.0f, 1.0f};
+}  // namespace
+
+namespace tango_gl {
+
+const float DynamicResolutionTarget::kMinScale = 0.25f;
+
+DynamicResolutionTarget::DynamicResolutionTarget()
+    : viewport_x_(0),
+      viewport_y_(0),
+      viewport_width_(0),
+      viewport_height_(0),
+      scale_(1.0f),
+      framebuffer_(0),
+      color_texture_(0),
+      depth_renderbuffer_(0),
+      target_width_(0),
+      target_height_(0),
+      is_unsupported_(false),
+      is_offscreen_(false),
+      is_retaining_content_(false),
+      is_opaque_(false),
+      has_content_(false),
+      shader_program_(0),
+      attrib_vertices_(-1),
+      uniform_image_(-1),
+      reprojection_program_(0),
+      reprojection_attrib_vertices_(-1),
+      reprojection_uniform_image_(-1),
+      reprojection_uniform_matrix_(-1),
+      vertex_buffer_(GL_ARRAY_BUFFER, GL_STATIC_DRAW) {}
+
+DynamicResolutionTarget::~DynamicResolutionTarget() { Release(); }
+
+void DynamicResolutionTarget::SetViewport(GLint x, GLint y, GLsizei width,
+                                          GLsizei height) {
+  viewport_x_ = x;
+  viewport_y_ = y;
+  viewport_width_ = width;
+  viewport_height_ = height;
+}
+
+void DynamicResolutionTarget::SetScale(float scale) {
+  scale_ = std::min(1.0f, std::max(kMinScale, scale));
+}
+
+bool DynamicResolutionTarget::Begin() {
+  const GLsizei width = std::max<GLsizei>(
+      1, static_cast<GLsizei>(std::lround(viewport_width_ * scale_)));
+  const GLsizei height = std::max<GLsizei>(
+      1, static_cast<GLsizei>(std::lround(viewport_height_ * scale_)));
+  is_offscreen_ = (scale_ < 1.0f || is_retaining_content_) &&
+                  !is_unsupported_ && viewport_width_ > 0 &&
+                  viewport_height_ > 0 && Allocate(width, height);
+  has_content_ = false;
+  if (!is_offscreen_) {
+    glViewport(viewport_x_, viewport_y_, viewport_width_, viewport_height_);
+    glClear(GL_DEPTH_BUFFER_BIT);
+    return false;
+  }
+
+  glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_);
+  glViewport(0, 0, target_width_, target_height_);
+  glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+  return true;
+}
+
+void DynamicResolutionTarget::End() {
+  if (!is_offscreen_) {
+    return;
+  }
+  is_offscreen_ = false;
+  has_content_ = is_retaining_content_;
+  if (shader_program_ == 0) {
+    shader_program_ = program_cache::AcquireProgram(
+        shaders::GetCompositeVertexShader().c_str(),
+        shaders::GetCompositeFragmentShader().c_str());
+    if (!shader_program_) {
+      LOGE("DynamicResolutionTarget: could not create program.");
+      glBindFramebuffer(GL_FRAMEBUFFER, 0);
+      glViewport(viewport_x_, viewport_y_, viewport_width_, viewport_height_);
+      return;
+    }
+    attrib_vertices_ = glGetAttribLocation(shader_program_, "vertex");
+    uniform_image_ = glGetUniformLocation(shader_program_, "image");
+  }
+  RenderState::UseProgram(shader_program_);
+  glUniform1i(uniform_image_, 0);
+  DrawTarget(attrib_vertices_);
+  util::CheckGlError("DynamicResolutionTarget::End");
+}
+
+glm::mat3 DynamicResolutionTarget::GetReprojection(
+    const glm::mat4& projection_mat, const glm::mat4& render_view_mat,
+    const glm::mat4& view_mat) {
+  // Rows x, y and w of the projection of a direction: a point (x, y) in
+  // normalized device coordinates is the direction inverse(p) * (x, y, 1).
+  const glm::mat3 p(
+      glm::vec3(projection_mat[0][0], projection_mat[0][1],
+                projection_mat[0][3]),
+      glm::vec3(projection_mat[1][0], projection_mat[1][1],
+                projection_mat[1][3]),
+      glm::vec3(projection_mat[2][0], projection_mat[2][1],
+                projection_mat[2][3]));
+  const glm::mat3 rotation(render_view_mat * glm::inverse(view_mat));
+  return p * rotation * glm::inverse(p);
+}
+
+bool DynamicResolutionTarget::CompositeReprojected(
+    const glm::mat3& reprojection) {
+  if (!has_content_ || framebuffer_ == 0) {
+    return false;
+  }
+  if (reprojection_program_ == 0) {
+    reprojection_program_ = program_cache::AcquireProgram(
+        shaders::GetReprojectionVertexShader().c_str(),
+        shaders::GetReprojectionFragmentShader().c_str());
+    if (!reprojection_program_) {
+      LOGE("DynamicResolutionTarget: could not create reprojection program.");
+      return false;
+    }
+    reprojection_attrib_vertices_ =
+        glGetAttribLocation(reprojection_program_, "vertex");
+    reprojection_uniform_image_ =
+        glGetUniformLocation(reprojection_program_, "image");
+    reprojection_uniform_matrix_ =
+        glGetUniformLocation(reprojection_program_, "reprojection");
+  }
+  RenderState::UseProgram(reprojection_program_);
+  glUniform1i(reprojection_uniform_image_, 0);
+  glUniformMatrix3fv(reprojection_uniform_matrix_, 1, GL_FALSE,
+                     glm::value_ptr(reprojection));
+  DrawTarget(reprojection_attrib_vertices_);
+  util::CheckGlError("DynamicResolutionTarget::CompositeReprojected");
+  return true;
+}
+
+void DynamicResolutionTarget::DrawTarget(GLint attrib_vertices) {
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  glViewport(viewport_x_, viewport_y_, viewport_width_, viewport_height_);
+  if (vertex_buffer_.GetSize() == 0) {
+    vertex_buffer_.Update(kQuadVertices, sizeof(kQuadVertices), 0);
+  }
+
+  RenderState::ActiveTexture(GL_TEXTURE0);
+  RenderState::BindTexture(GL_TEXTURE_2D, color_texture_);
+  RenderState::Disable(GL_DEPTH_TEST);
+  if (is_opaque_) {
+    RenderState::Disable(GL_BLEND);
+  } else {
+    RenderState::Enable(GL_BLEND);
+    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+  }
+
+  vertex_buffer_.Bind();
+  glEnableVertexAttribArray(attrib_vertices);
+  glVertexAttribPointer(attrib_vertices, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
+  Counters::Increment(Counters::kDrawCalls);
+  glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+  glDisableVertexAttribArray(attrib_vertices);
+
+  RenderState::Disable(GL_BLEND);
+}
+
+bool DynamicResolutionTarget::Allocate(GLsizei width, GLsizei height) {
+  if (framebuffer_ != 0 && width == target_width_ &&
+      height == target_height_) {
+    return true;
+  }
+  if (framebuffer_ == 0) {
+    glGenFramebuffers(1, &framebuffer_);
+    glGenTextures(1, &color_texture_);
+    glGenRenderbuffers(1, &depth_renderbuffer_);
+  }
+
+  RenderState::BindTexture(GL_TEXTURE_2D, color_texture_);
+  // Linear filtering is the bilinear upscale of the composite.
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA,
+               GL_UNSIGNED_BYTE, nullptr);
+
+  glBindRenderbuffer(GL_RENDERBUFFER, depth_renderbuffer_);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT16, width, height);
+  glBindRenderbuffer(GL_RENDERBUFFER, 0);
+  MemoryTracker::Track(
+      MemoryTracker::kTexture, color_texture_, "DynamicResolutionTarget",
+      MemoryTracker::GetTextureSize(width, height, GL_RGBA, GL_UNSIGNED_BYTE));
+  MemoryTracker::Track(MemoryTracker::kRenderbuffer, depth_renderbuffer_,
+                       "DynamicResolutionTarget",
+                       static_cast<size_t>(width) * height * sizeof(GLushort));
+
+  glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_);
+  glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
+                         color_texture_, 0);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
+                            GL_RENDERBUFFER, depth_renderbuffer_);
+  const GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  util::CheckGlError("DynamicResolutionTarget::Allocate");
+
+  if (status != GL_FRAMEBUFFER_COMPLETE) {
+    LOGE("DynamicResolutionTarget: framebuffer %dx%d incomplete (0x%x), "
+         "rendering at full resolution.", width, height, status);
+    Release();
+    is_unsupported_ = true;
+    return false;
+  }
+  target_width_ = width;
+  target_height_ = height;
+  return true;
+}
+
+void DynamicResolutionTarget::Release() {
+  if (framebuffer_ != 0) {
+    glDeleteFramebuffers(1, &framebuffer_);
+    RenderState::DeleteTextures(1, &color_texture_);
+    glDeleteRenderbuffers(1, &depth_renderbuffer_);
+    MemoryTracker::Untrack(MemoryTracker::kRenderbuffer, depth_renderbuffer_);
+  }
+  program_cache::ReleaseProgram(shader_program_);
+  program_cache::ReleaseProgram(reprojection_program_);
+  vertex_buffer_.Release();
+  Invalidate();
+}
+
+void DynamicResolutionTarget::Invalidate() {
+  vertex_buffer_.Invalidate();
+  framebuffer_ = 0;
+  color_texture_ = 0;
+  depth_renderbuffer_ = 0;
+  target_width_ = 0;
+  target_height_ = 0;
+  is_unsupported_ = false;
+  is_offscreen_ = false;
+  has_content_ = false;
+  shader_program_ = 0;
+  reprojection_program_ = 0;
+}
+
+}  // namespace tango_gl
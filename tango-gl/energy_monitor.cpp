@@ -0,0 +1,447 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "tango-gl/energy_monitor.h"
+
+#include <dirent.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+// Units of the cpufreq time_in_state statistics, USER_HZ clock ticks.
+const uint64_t kCpuStatsTickMs = 10;
+
+// Read a small sysfs file, without its trailing newline.
+bool ReadFile(const std::string& path, std::string* content) {
+  FILE* file = fopen(path.c_str(), "r");
+  if (file == nullptr) {
+    return false;
+  }
+  char buffer[4096];
+  const size_t size = fread(buffer, 1, sizeof(buffer), file);
+  fclose(file);
+  content->assign(buffer, size);
+  while (!content->empty() &&
+         (content->back() == '\n' || content->back() == ' ')) {
+    content->pop_back();
+  }
+  return true;
+}
+
+bool ReadInteger(const std::string& path, int64_t* value) {
+  std::string content;
+  if (!ReadFile(path, &content) || content.empty()) {
+    return false;
+  }
+  char* end = nullptr;
+  *value = strtoll(content.c_str(), &end, 10);
+  return end != content.c_str();
+}
+
+// Names of the entries of a directory, without "." and "..".
+std::vector<std::string> ListDirectory(const std::string& path) {
+  std::vector<std::string> names;
+  DIR* dir = opendir(path.c_str());
+  if (dir == nullptr) {
+    return names;
+  }
+  while (dirent* entry = readdir(dir)) {
+    if (strcmp(entry->d_name, ".") != 0 && strcmp(entry->d_name, "..") != 0) {
+      names.push_back(entry->d_name);
+    }
+  }
+  closedir(dir);
+  std::sort(names.begin(), names.end());
+  return names;
+}
+
+// Parse "<prefix><number>", e.g. "policy4".
+bool ParseIndex(const std::string& name, const char* prefix, int* index) {
+  const size_t prefix_length = strlen(prefix);
+  if (name.compare(0, prefix_length, prefix) != 0 ||
+      name.size() == prefix_length) {
+    return false;
+  }
+  char* end = nullptr;
+  *index = static_cast<int>(strtol(name.c_str() + prefix_length, &end, 10));
+  return *end == '\0';
+}
+
+// Parse the "<kHz> <ticks>" lines of a time_in_state file.
+bool ReadCpuStats(const std::string& path,
+                  std::vector<uint32_t>* frequencies_khz,
+                  std::vector<uint64_t>* times_ms) {
+  std::string content;
+  if (!ReadFile(path, &content)) {
+    return false;
+  }
+  frequencies_khz->clear();
+  times_ms->clear();
+  const char* line = content.c_str();
+  while (*line != '\0') {
+    unsigned long frequency = 0;
+    unsigned long long ticks = 0;
+    if (sscanf(line, "%lu %llu", &frequency, &ticks) == 2) {
+      frequencies_khz->push_back(static_cast<uint32_t>(frequency));
+      times_ms->push_back(static_cast<uint64_t>(ticks) * kCpuStatsTickMs);
+    }
+    const char* next = strchr(line, '\n');
+    if (next == nullptr) {
+      break;
+    }
+    line = next + 1;
+  }
+  return !frequencies_khz->empty();
+}
+}  // namespace
+
+namespace tango_gl {
+
+float EnergyMonitor::CpuResidency::GetMeanFrequency() const {
+  double weighted_sum = 0.0;
+  uint64_t total_ms = 0;
+  for (size_t i = 0; i < times_ms.size(); ++i) {
+    weighted_sum += static_cast<double>(frequencies_khz[i]) * times_ms[i];
+    total_ms += times_ms[i];
+  }
+  return total_ms == 0 ? 0.0f : static_cast<float>(weighted_sum / total_ms);
+}
+
+float EnergyMonitor::CpuResidency::GetMaxFrequencyFraction() const {
+  uint64_t total_ms = 0;
+  uint64_t max_ms = 0;
+  uint32_t max_frequency = 0;
+  for (size_t i = 0; i < times_ms.size(); ++i) {
+    total_ms += times_ms[i];
+    if (frequencies_khz[i] > max_frequency) {
+      max_frequency = frequencies_khz[i];
+      max_ms = times_ms[i];
+    }
+  }
+  return total_ms == 0 ? 0.0f : static_cast<float>(max_ms) / total_ms;
+}
+
+EnergyMonitor::StateTotals::StateTotals()
+    : seconds(0.0),
+      charging_seconds(0.0),
+      energy_mj(0.0),
+      frame_count(0),
+      depth_frame_count(0) {}
+
+float EnergyMonitor::StateTotals::GetMeanPowerMw() const {
+  return seconds > 0.0 ? static_cast<float>(energy_mj / seconds) : 0.0f;
+}
+
+float EnergyMonitor::StateTotals::GetFrameEnergyMj() const {
+  return frame_count > 0 ? static_cast<float>(energy_mj / frame_count) : 0.0f;
+}
+
+float EnergyMonitor::StateTotals::GetDepthFrameEnergyMj() const {
+  return depth_frame_count > 0
+             ? static_cast<float>(energy_mj / depth_frame_count)
+             : 0.0f;
+}
+
+EnergyMonitor::EnergyMonitor(const Options& options)
+    : options_(options),
+      is_running_(false),
+      state_(0),
+      has_last_sample_(false),
+      last_power_mw_(-1.0f),
+      last_frame_count_(0),
+      last_depth_frame_count_(0),
+      frame_count_(0),
+      depth_frame_count_(0),
+      interval_power_mw_(0.0f),
+      interval_frame_mj_(0.0f) {
+  totals_.resize(1);
+  totals_[0].state = "default";
+}
+
+EnergyMonitor::~EnergyMonitor() { Stop(); }
+
+bool EnergyMonitor::Start() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (is_running_) {
+    return HasBattery();
+  }
+  FindNodes();
+  if (!HasBattery()) {
+    LOGE("EnergyMonitor: no readable battery under %s/class/power_supply.",
+         options_.sysfs_root.c_str());
+  }
+  has_last_sample_ = false;
+  Sample();
+  is_running_ = true;
+  thread_ = std::thread(&EnergyMonitor::Run, this);
+  return HasBattery();
+}
+
+void EnergyMonitor::Stop() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!is_running_) {
+      return;
+    }
+    is_running_ = false;
+    Sample();
+  }
+  stop_condition_.notify_all();
+  thread_.join();
+}
+
+void EnergyMonitor::SetState(const std::string& state) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (totals_[state_].state == state) {
+    return;
+  }
+  if (is_running_) {
+    Sample();
+  }
+  state_ = GetStateIndex(state);
+}
+
+void EnergyMonitor::Update(FrameProfiler* profiler) {
+  profiler->SetCounter("powerMW",
+                       interval_power_mw_.load(std::memory_order_relaxed));
+  profiler->SetCounter("frameMJ",
+                       interval_frame_mj_.load(std::memory_order_relaxed));
+}
+
+std::vector<EnergyMonitor::StateTotals> EnergyMonitor::GetTotals() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return totals_;
+}
+
+void EnergyMonitor::Reset() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const std::string state = totals_[state_].state;
+  totals_.resize(1);
+  totals_[0] = StateTotals();
+  totals_[0].state = state;
+  state_ = 0;
+}
+
+std::string EnergyMonitor::GetReport() const {
+  const std::vector<StateTotals> totals = GetTotals();
+  std::string report;
+  for (const StateTotals& state : totals) {
+    if (state.seconds == 0.0 && state.charging_seconds == 0.0) {
+      continue;
+    }
+    char line[256];
+    snprintf(line, sizeof(line),
+             "%s: %.1f s %.0f mW %.1f mJ/frame %.1f mJ/depth frame",
+             state.state.c_str(), state.seconds, state.GetMeanPowerMw(),
+             state.GetFrameEnergyMj(), state.GetDepthFrameEnergyMj());
+    report += line;
+    if (state.charging_seconds > 0.0) {
+      snprintf(line, sizeof(line), ", %.1f s charging",
+               state.charging_seconds);
+      report += line;
+    }
+    for (const CpuResidency& cpu : state.cpus) {
+      if (cpu.GetMeanFrequency() == 0.0f) {
+        continue;
+      }
+      snprintf(line, sizeof(line), ", cpu%d %.0f MHz %.0f%% max", cpu.cpu,
+               cpu.GetMeanFrequency() / 1000.0f,
+               100.0f * cpu.GetMaxFrequencyFraction());
+      report += line;
+    }
+    report += "\n";
+  }
+  return report;
+}
+
+void EnergyMonitor::FindNodes() {
+  battery_path_.clear();
+  const std::string power_supply = options_.sysfs_root + "/class/power_supply";
+  for (const std::string& name : ListDirectory(power_supply)) {
+    const std::string path = power_supply + "/" + name;
+    std::string type;
+    int64_t value;
+    if (!ReadFile(path + "/type", &type) || type != "Battery" ||
+        !ReadInteger(path + "/current_now", &value) ||
+        !ReadInteger(path + "/voltage_now", &value)) {
+      continue;
+    }
+    // Devices with several batteries, e.g. of a stylus, name the main one
+    // "battery".
+    if (battery_path_.empty() || name == "battery") {
+      battery_path_ = path;
+    }
+  }
+
+  cpu_stats_.clear();
+  // Kernels since 4.3 have a directory per policy, older ones a cpufreq
+  // directory per CPU, where the CPUs of a cluster repeat the statistics of
+  // the first.
+  const std::string cpu_root = options_.sysfs_root + "/devices/system/cpu";
+  for (const std::string& name : ListDirectory(cpu_root + "/cpufreq")) {
+    CpuStatsFile stats;
+    if (ParseIndex(name, "policy", &stats.cpu)) {
+      stats.path = cpu_root + "/cpufreq/" + name + "/stats/time_in_state";
+      cpu_stats_.push_back(stats);
+    }
+  }
+  if (cpu_stats_.empty()) {
+    for (const std::string& name : ListDirectory(cpu_root)) {
+      CpuStatsFile stats;
+      if (!ParseIndex(name, "cpu", &stats.cpu)) {
+        continue;
+      }
+      const std::string cpufreq = cpu_root + "/" + name + "/cpufreq";
+      int64_t first_related_cpu;
+      if (ReadInteger(cpufreq + "/related_cpus", &first_related_cpu) &&
+          first_related_cpu != stats.cpu) {
+        continue;
+      }
+      stats.path = cpufreq + "/stats/time_in_state";
+      cpu_stats_.push_back(stats);
+    }
+  }
+  std::vector<CpuStatsFile> readable;
+  for (CpuStatsFile& stats : cpu_stats_) {
+    if (ReadCpuStats(stats.path, &stats.frequencies_khz,
+                     &stats.last_times_ms)) {
+      readable.push_back(stats);
+    }
+  }
+  std::sort(readable.begin(), readable.end(),
+            [](const CpuStatsFile& a, const CpuStatsFile& b) {
+              return a.cpu < b.cpu;
+            });
+  cpu_stats_.swap(readable);
+}
+
+void EnergyMonitor::Sample() {
+  const std::chrono::steady_clock::time_point now =
+      std::chrono::steady_clock::now();
+  float power_mw = -1.0f;
+  bool is_charging = false;
+  if (HasBattery()) {
+    int64_t current_ua;
+    int64_t voltage_uv;
+    if (ReadInteger(battery_path_ + "/current_now", &current_ua) &&
+        ReadInteger(battery_path_ + "/voltage_now", &voltage_uv)) {
+      // The sign of the current differs between devices, discharging is
+      // negative on some and positive on others.
+      power_mw = static_cast<float>(std::abs(static_cast<double>(current_ua)) *
+                                    voltage_uv * 1e-9);
+    }
+    std::string status;
+    is_charging = ReadFile(battery_path_ + "/status", &status) &&
+                  (status == "Charging" || status == "Full");
+  }
+  const uint64_t frame_count = frame_count_.load(std::memory_order_relaxed);
+  const uint64_t depth_frame_count =
+      depth_frame_count_.load(std::memory_order_relaxed);
+
+  StateTotals& totals = totals_[state_];
+  if (has_last_sample_) {
+    const double seconds =
+        std::chrono::duration<double>(now - last_sample_time_).count();
+    const uint64_t frames = frame_count - last_frame_count_;
+    totals.frame_count += frames;
+    totals.depth_frame_count += depth_frame_count - last_depth_frame_count_;
+    if (is_charging) {
+      totals.charging_seconds += seconds;
+    } else {
+      totals.seconds += seconds;
+      if (power_mw >= 0.0f) {
+        const float mean_power_mw =
+            last_power_mw_ >= 0.0f ? 0.5f * (last_power_mw_ + power_mw)
+                                   : power_mw;
+        const double energy_mj = mean_power_mw * seconds;
+        totals.energy_mj += energy_mj;
+        interval_power_mw_.store(mean_power_mw, std::memory_order_relaxed);
+        interval_frame_mj_.store(
+            frames > 0 ? static_cast<float>(energy_mj / frames) : 0.0f,
+            std::memory_order_relaxed);
+      }
+    }
+  }
+
+  std::vector<uint32_t> frequencies_khz;
+  std::vector<uint64_t> times_ms;
+  for (CpuStatsFile& stats : cpu_stats_) {
+    if (!ReadCpuStats(stats.path, &frequencies_khz, &times_ms)) {
+      continue;
+    }
+    // Hotplugged or reconfigured, start over from this reading.
+    if (frequencies_khz != stats.frequencies_khz) {
+      stats.frequencies_khz = frequencies_khz;
+      stats.last_times_ms = times_ms;
+      continue;
+    }
+    if (has_last_sample_) {
+      CpuResidency* residency = nullptr;
+      for (CpuResidency& cpu : totals.cpus) {
+        if (cpu.cpu == stats.cpu &&
+            cpu.frequencies_khz == stats.frequencies_khz) {
+          residency = &cpu;
+        }
+      }
+      if (residency == nullptr) {
+        totals.cpus.push_back(CpuResidency());
+        residency = &totals.cpus.back();
+        residency->cpu = stats.cpu;
+        residency->frequencies_khz = stats.frequencies_khz;
+        residency->times_ms.assign(stats.frequencies_khz.size(), 0);
+      }
+      for (size_t i = 0; i < times_ms.size(); ++i) {
+        residency->times_ms[i] += times_ms[i] - stats.last_times_ms[i];
+      }
+    }
+    stats.last_times_ms = times_ms;
+  }
+
+  has_last_sample_ = true;
+  last_sample_time_ = now;
+  last_power_mw_ = power_mw;
+  last_frame_count_ = frame_count;
+  last_depth_frame_count_ = depth_frame_count;
+}
+
+size_t EnergyMonitor::GetStateIndex(const std::string& state) {
+  for (size_t i = 0; i < totals_.size(); ++i) {
+    if (totals_[i].state == state) {
+      return i;
+    }
+  }
+  totals_.push_back(StateTotals());
+  totals_.back().state = state;
+  return totals_.size() - 1;
+}
+
+void EnergyMonitor::Run() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (is_running_) {
+    stop_condition_.wait_for(
+        lock, std::chrono::milliseconds(options_.sample_period_ms));
+    if (is_running_) {
+      Sample();
+    }
+  }
+}
+
+}  // namespace tango_gl
@@ -0,0 +1,145 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "tango-gl/event_bus.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+
+namespace {
+typedef tango_gl::EventBus EventBus;
+
+// 32 bit FNV-1a.
+constexpr uint32_t HashKey(const char* key, uint32_t hash = 2166136261u) {
+  return *key == '\0'
+             ? hash
+             : HashKey(key + 1,
+                       (hash ^ static_cast<uint8_t>(*key)) * 16777619u);
+}
+
+struct KnownKey {
+  const char* key;
+  uint32_t hash;
+};
+
+constexpr KnownKey MakeKnownKey(const char* key) {
+  return KnownKey{key, HashKey(key)};
+}
+
+// Indexed by EventId.
+constexpr KnownKey kKnownKeys[EventBus::kEventIdCount] = {
+    MakeKnownKey("Unknown"),
+    MakeKnownKey("TangoServiceException"),
+    MakeKnownKey("FisheyeOverExposed"),
+    MakeKnownKey("FisheyeUnderExposed"),
+    MakeKnownKey("ColorOverExposed"),
+    MakeKnownKey("ColorUnderExposed"),
+    MakeKnownKey("TooFewFeaturesTracked"),
+    MakeKnownKey("AreaDescriptionSaveProgress"),
+};
+
+void CopyText(const char* text, char* destination) {
+  strncpy(destination, text, EventBus::kMaxTextLength);
+  destination[EventBus::kMaxTextLength] = '\0';
+}
+}  // namespace
+
+namespace tango_gl {
+
+EventBus::EventBus(size_t capacity)
+    : events_(capacity), dropped_count_(0), next_token_(0) {}
+
+int EventBus::Subscribe(EventId id, const Handler& handler) {
+  const Subscription subscription = {next_token_++, id, handler};
+  subscriptions_.push_back(subscription);
+  return subscription.token;
+}
+
+int EventBus::SubscribeAll(const Handler& handler) {
+  return Subscribe(kEventIdCount, handler);
+}
+
+void EventBus::Unsubscribe(int token) {
+  subscriptions_.erase(
+      std::remove_if(subscriptions_.begin(), subscriptions_.end(),
+                     [token](const Subscription& subscription) {
+                       return subscription.token == token;
+                     }),
+      subscriptions_.end());
+}
+
+bool EventBus::Publish(const TangoEvent* event) {
+  Event typed;
+  typed.id = Intern(event->event_key);
+  typed.type = event->type;
+  typed.timestamp = event->timestamp;
+  typed.has_number = false;
+  typed.number = 0.0;
+  typed.text[0] = '\0';
+  const char* value = event->event_value != nullptr ? event->event_value : "";
+  char* end = nullptr;
+  const double number = strtod(value, &end);
+  if (end != value && *end == '\0') {
+    typed.has_number = true;
+    typed.number = number;
+  } else if (typed.id != kUnknownEvent) {
+    CopyText(value, typed.text);
+  }
+  if (typed.id == kUnknownEvent && event->event_key != nullptr) {
+    CopyText(event->event_key, typed.text);
+  }
+  if (!events_.Push(typed)) {
+    dropped_count_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  return true;
+}
+
+size_t EventBus::Dispatch() {
+  size_t dispatched_count = 0;
+  Event event;
+  while (events_.Pop(&event)) {
+    for (const Subscription& subscription : subscriptions_) {
+      if (subscription.id == event.id || subscription.id == kEventIdCount) {
+        subscription.handler(event);
+      }
+    }
+    ++dispatched_count;
+  }
+  return dispatched_count;
+}
+
+EventBus::EventId EventBus::Intern(const char* key) {
+  if (key == nullptr) {
+    return kUnknownEvent;
+  }
+  // A matching hash is confirmed once, in case of a collision with a key
+  // added to the service later.
+  const uint32_t hash = HashKey(key);
+  for (int id = kUnknownEvent + 1; id < kEventIdCount; ++id) {
+    if (kKnownKeys[id].hash == hash && strcmp(kKnownKeys[id].key, key) == 0) {
+      return static_cast<EventId>(id);
+    }
+  }
+  return kUnknownEvent;
+}
+
+const char* EventBus::GetKey(EventId id) { return kKnownKeys[id].key; }
+
+}  // namespace tango_gl
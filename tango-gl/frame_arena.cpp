@@ -0,0 +1,139 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+
+#include "tango-gl/frame_arena.h"
+
+#include <pthread.h>
+
+#include <algorithm>
+
+namespace {
+pthread_key_t g_thread_arena_key;
+pthread_once_t g_thread_arena_once = PTHREAD_ONCE_INIT;
+
+void DeleteThreadArena(void* arena) {
+  delete static_cast<tango_gl::FrameArena*>(arena);
+}
+
+void CreateThreadArenaKey() {
+  pthread_key_create(&g_thread_arena_key, DeleteThreadArena);
+}
+}  // namespace
+
+namespace tango_gl {
+
+const size_t FrameArena::kDefaultBlockSize;
+
+FrameArena::FrameArena(size_t block_size)
+    : block_size_(std::max<size_t>(block_size, 1)),
+      block_(0),
+      offset_(0),
+      generation_(0),
+      bytes_used_(0),
+      high_water_mark_(0),
+      capacity_(0),
+      heap_allocation_count_(0) {}
+
+FrameArena::~FrameArena() { FreeBlocks(); }
+
+void* FrameArena::Allocate(size_t size, size_t alignment) {
+  while (true) {
+    if (block_ < blocks_.size()) {
+      const Block& block = blocks_[block_];
+      const uintptr_t base = reinterpret_cast<uintptr_t>(block.data);
+      const size_t aligned =
+          ((base + offset_ + alignment - 1) & ~(alignment - 1)) - base;
+      if (aligned <= block.size && size <= block.size - aligned) {
+        bytes_used_ += aligned + size - offset_;
+        high_water_mark_ = std::max(high_water_mark_, bytes_used_);
+        offset_ = aligned + size;
+        return block.data + aligned;
+      }
+      // Blocks chained in an earlier frame are reused after a Rewind().
+      if (block_ + 1 < blocks_.size()) {
+        ++block_;
+        offset_ = 0;
+        continue;
+      }
+    }
+    AddBlock(std::max(block_size_, size + alignment));
+  }
+}
+
+void FrameArena::Reset() {
+  // Coalesce, the next frame then fits into a single block.
+  if (blocks_.size() > 1) {
+    const size_t size = capacity_;
+    FreeBlocks();
+    AddBlock(size);
+  }
+  block_ = 0;
+  offset_ = 0;
+  bytes_used_ = 0;
+  ++generation_;
+}
+
+FrameArena::Mark FrameArena::GetMark() const {
+  Mark mark;
+  mark.generation = generation_;
+  mark.block = block_;
+  mark.offset = offset_;
+  mark.bytes_used = bytes_used_;
+  return mark;
+}
+
+void FrameArena::Rewind(const Mark& mark) {
+  if (mark.generation != generation_) {
+    return;
+  }
+  block_ = mark.block;
+  offset_ = mark.offset;
+  bytes_used_ = mark.bytes_used;
+}
+
+FrameArena& FrameArena::ForThisThread() {
+  pthread_once(&g_thread_arena_once, CreateThreadArenaKey);
+  FrameArena* arena =
+      static_cast<FrameArena*>(pthread_getspecific(g_thread_arena_key));
+  if (arena == nullptr) {
+    arena = new FrameArena();
+    pthread_setspecific(g_thread_arena_key, arena);
+  }
+  return *arena;
+}
+
+void FrameArena::AddBlock(size_t size) {
+  Block block;
+  block.data = new uint8_t[size];
+  block.size = size;
+  blocks_.push_back(block);
+  block_ = blocks_.size() - 1;
+  offset_ = 0;
+  capacity_ += size;
+  ++heap_allocation_count_;
+}
+
+void FrameArena::FreeBlocks() {
+  for (const Block& block : blocks_) {
+    delete[] block.data;
+  }
+  blocks_.clear();
+  capacity_ = 0;
+}
+
+}  // namespace tango_gl
@@ -0,0 +1,96 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "tango-gl/frame_cache.h"
+
+#include <cmath>
+
+namespace tango_gl {
+
+// About a millimeter, or a twentieth of a degree.
+const float FrameCache::kDefaultTolerance = 1e-3f;
+
+FrameCache::FrameCache()
+    : tolerance_(kDefaultTolerance),
+      is_marked_dirty_(true),
+      rendered_frame_count_(0),
+      reused_frame_count_(0) {
+  target_.SetRetainContent(true);
+  target_.SetOpaque(true);
+}
+
+void FrameCache::SetViewport(GLint x, GLint y, GLsizei width,
+                             GLsizei height) {
+  target_.SetViewport(x, y, width, height);
+  MarkDirty();
+}
+
+void FrameCache::AddInput(const glm::mat4& matrix) {
+  const float* elements = glm::value_ptr(matrix);
+  inputs_.insert(inputs_.end(), elements, elements + 16);
+}
+
+void FrameCache::AddInput(double value) { exact_inputs_.push_back(value); }
+
+bool FrameCache::IsDirty() const {
+  if (is_marked_dirty_ || inputs_.size() != rendered_inputs_.size() ||
+      exact_inputs_ != rendered_exact_inputs_) {
+    return true;
+  }
+  for (size_t i = 0; i < inputs_.size(); ++i) {
+    // Also true for NaN.
+    if (!(std::abs(inputs_[i] - rendered_inputs_[i]) <= tolerance_)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool FrameCache::Begin() {
+  const bool is_dirty = IsDirty() || !target_.HasRetainedContent();
+  // The last rendered inputs stay the reference while frames are reused, so
+  // slow drift adds up to a change.
+  if (is_dirty) {
+    rendered_inputs_.swap(inputs_);
+    rendered_exact_inputs_.swap(exact_inputs_);
+  }
+  inputs_.clear();
+  exact_inputs_.clear();
+  is_marked_dirty_ = false;
+
+  if (!is_dirty && target_.CompositeReprojected(glm::mat3(1.0f))) {
+    ++reused_frame_count_;
+    return false;
+  }
+  ++rendered_frame_count_;
+  target_.Begin();
+  return true;
+}
+
+void FrameCache::End() { target_.End(); }
+
+void FrameCache::Release() {
+  target_.Release();
+  MarkDirty();
+}
+
+void FrameCache::Invalidate() {
+  target_.Invalidate();
+  MarkDirty();
+}
+
+}  // namespace tango_gl
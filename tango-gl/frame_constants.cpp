@@ -0,0 +1,189 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <EGL/egl.h>
+#include <string.h>
+
+#include "tango-gl/frame_constants.h"
+
+#include "tango-gl/counters.h"
+#include "tango-gl/memory_tracker.h"
+#include "tango-gl/render_state.h"
+
+// GLES3 tokens, the examples are built against the GLES2 headers.
+#ifndef GL_UNIFORM_BUFFER
+#define GL_UNIFORM_BUFFER 0x8A11
+#endif
+#ifndef GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+#define GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT 0x8A34
+#endif
+#ifndef GL_INVALID_INDEX
+#define GL_INVALID_INDEX 0xFFFFFFFFu
+#endif
+
+namespace {
+typedef void (GL_APIENTRY* BindBufferRangeFunc)(GLenum target, GLuint index,
+                                                GLuint buffer, GLintptr offset,
+                                                GLsizeiptr size);
+typedef GLuint (GL_APIENTRY* GetUniformBlockIndexFunc)(
+    GLuint program, const GLchar* name);
+typedef void (GL_APIENTRY* UniformBlockBindingFunc)(GLuint program,
+                                                    GLuint block_index,
+                                                    GLuint binding);
+
+// Contents of a slot, std140 layout.
+struct Block {
+  glm::mat4 projection;
+  glm::mat4 view;
+  glm::mat4 vp;
+};
+
+// Slots of the ring, enough for the camera changes of a few frames.
+const int kSlotCount = 32;
+
+// State of g_context, only touched on the GL thread.
+EGLContext g_context = EGL_NO_CONTEXT;
+BindBufferRangeFunc g_bind_buffer_range = nullptr;
+GetUniformBlockIndexFunc g_get_uniform_block_index = nullptr;
+UniformBlockBindingFunc g_uniform_block_binding = nullptr;
+GLuint g_buffer = 0;
+GLsizeiptr g_slot_size = 0;
+int g_slot = 0;
+bool g_has_block = false;
+Block g_block;
+
+// Reset the state when the current context changed. The buffer of the old
+// context went with it.
+void UpdateContext() {
+  EGLContext context = eglGetCurrentContext();
+  if (context == g_context) {
+    return;
+  }
+  g_context = context;
+  g_buffer = 0;
+  g_slot = 0;
+  g_has_block = false;
+
+  g_bind_buffer_range = nullptr;
+  g_get_uniform_block_index = nullptr;
+  g_uniform_block_binding = nullptr;
+  const char* version = reinterpret_cast<const char*>(glGetString(GL_VERSION));
+  if (version == nullptr || strncmp(version, "OpenGL ES 3", 11) != 0) {
+    return;
+  }
+  // The GLES3 entry points are resolved at runtime so the examples keep
+  // linking against libGLESv2 only.
+  g_bind_buffer_range = reinterpret_cast<BindBufferRangeFunc>(
+      eglGetProcAddress("glBindBufferRange"));
+  g_get_uniform_block_index = reinterpret_cast<GetUniformBlockIndexFunc>(
+      eglGetProcAddress("glGetUniformBlockIndex"));
+  g_uniform_block_binding = reinterpret_cast<UniformBlockBindingFunc>(
+      eglGetProcAddress("glUniformBlockBinding"));
+  if (g_bind_buffer_range == nullptr || g_get_uniform_block_index == nullptr ||
+      g_uniform_block_binding == nullptr) {
+    LOGE("FrameConstants: GLES3 context without uniform buffer entry points.");
+    g_bind_buffer_range = nullptr;
+    g_get_uniform_block_index = nullptr;
+    g_uniform_block_binding = nullptr;
+  }
+}
+
+bool CreateBuffer() {
+  GLint alignment = 0;
+  glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+  alignment = alignment > 0 ? alignment : 256;
+  g_slot_size = (sizeof(Block) + alignment - 1) / alignment * alignment;
+
+  glGenBuffers(1, &g_buffer);
+  tango_gl::RenderState::BindBuffer(GL_UNIFORM_BUFFER, g_buffer);
+  glBufferData(GL_UNIFORM_BUFFER, g_slot_size * kSlotCount, nullptr,
+               GL_DYNAMIC_DRAW);
+  // The size rather than glGetError(), which may hold an earlier error of
+  // the application.
+  GLint size = 0;
+  glGetBufferParameteriv(GL_UNIFORM_BUFFER, GL_BUFFER_SIZE, &size);
+  if (size != static_cast<GLint>(g_slot_size * kSlotCount)) {
+    LOGE("FrameConstants: could not create the uniform buffer.");
+    tango_gl::RenderState::DeleteBuffers(1, &g_buffer);
+    g_buffer = 0;
+    g_bind_buffer_range = nullptr;
+    return false;
+  }
+  tango_gl::MemoryTracker::Track(tango_gl::MemoryTracker::kBuffer, g_buffer,
+                                 "FrameConstants", g_slot_size * kSlotCount);
+  return true;
+}
+}  // namespace
+
+namespace tango_gl {
+
+const GLuint FrameConstants::kBindingPoint;
+
+void FrameConstants::Set(const glm::mat4& projection_mat,
+                         const glm::mat4& view_mat) {
+  UpdateContext();
+  if (g_has_block &&
+      memcmp(&g_block.projection, &projection_mat, sizeof(glm::mat4)) == 0 &&
+      memcmp(&g_block.view, &view_mat, sizeof(glm::mat4)) == 0) {
+    return;
+  }
+  g_block.projection = projection_mat;
+  g_block.view = view_mat;
+  g_block.vp = projection_mat * view_mat;
+  g_has_block = true;
+
+  if (g_bind_buffer_range == nullptr ||
+      (g_buffer == 0 && !CreateBuffer())) {
+    return;
+  }
+  g_slot = (g_slot + 1) % kSlotCount;
+  const GLintptr offset = g_slot * g_slot_size;
+  RenderState::BindBuffer(GL_UNIFORM_BUFFER, g_buffer);
+  glBufferSubData(GL_UNIFORM_BUFFER, offset, sizeof(Block), &g_block);
+  Counters::Add(Counters::kBufferBytes, sizeof(Block));
+  g_bind_buffer_range(GL_UNIFORM_BUFFER, kBindingPoint, g_buffer, offset,
+                      sizeof(Block));
+}
+
+glm::mat4 FrameConstants::GetViewProjection(const glm::mat4& projection_mat,
+                                            const glm::mat4& view_mat) {
+  if (g_has_block && g_context == eglGetCurrentContext() &&
+      memcmp(&g_block.projection, &projection_mat, sizeof(glm::mat4)) == 0 &&
+      memcmp(&g_block.view, &view_mat, sizeof(glm::mat4)) == 0) {
+    return g_block.vp;
+  }
+  return projection_mat * view_mat;
+}
+
+bool FrameConstants::HasUniformBuffers() {
+  UpdateContext();
+  return g_bind_buffer_range != nullptr;
+}
+
+bool FrameConstants::BindBlock(GLuint program) {
+  if (!HasUniformBuffers()) {
+    return false;
+  }
+  const GLuint index = g_get_uniform_block_index(program, "FrameConstants");
+  if (index == GL_INVALID_INDEX) {
+    return false;
+  }
+  g_uniform_block_binding(program, index, kBindingPoint);
+  return true;
+}
+
+}  // namespace tango_gl
@@ -0,0 +1,321 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include "tango-gl/frame_arena.h"
+#include "tango-gl/frame_profiler.h"
+
+namespace {
+// GL_EXT_disjoint_timer_query enums, missing from older GLES2 headers.
+const GLenum kTimeElapsed = 0x88BF;
+const GLenum kQueryResult = 0x8866;
+const GLenum kQueryResultAvailable = 0x8867;
+const GLenum kGpuDisjoint = 0x8FBB;
+
+// Number of samples per zone, about two seconds at 60 frames per second.
+const size_t kSampleCount = 128;
+
+// Queries in flight are bounded in case results are never read back.
+const size_t kMaxPendingQueries = 64;
+
+const char kFrameZone[] = "frame";
+}  // namespace
+
+namespace tango_gl {
+
+void FrameProfiler::Samples::Add(float value) {
+  if (values.size() < kSampleCount) {
+    values.push_back(value);
+  } else {
+    values[next] = value;
+  }
+  next = (next + 1) % kSampleCount;
+}
+
+float FrameProfiler::Samples::GetPercentile(float percentile) const {
+  if (values.empty()) {
+    return 0.0f;
+  }
+  FrameArena& arena = FrameArena::ForThisThread();
+  FrameArena::Scope scope(&arena);
+  ArenaVector<float> sorted(values.begin(), values.end(),
+                            ArenaAllocator<float>(&arena));
+  size_t rank = std::min(
+      sorted.size() - 1, static_cast<size_t>(percentile * sorted.size()));
+  std::nth_element(sorted.begin(), sorted.begin() + rank, sorted.end());
+  return sorted[rank];
+}
+
+void FrameProfiler::Samples::Clear() {
+  values.clear();
+  next = 0;
+}
+
+FrameProfiler::FrameProfiler()
+    : has_frame_start_(false),
+      context_(EGL_NO_CONTEXT),
+      gen_queries_(nullptr),
+      delete_queries_(nullptr),
+      begin_query_(nullptr),
+      end_query_(nullptr),
+      get_query_objectuiv_(nullptr),
+      get_query_objectui64v_(nullptr),
+      is_gpu_zone_open_(false) {}
+
+FrameProfiler::~FrameProfiler() { Release(); }
+
+void FrameProfiler::BeginFrame() {
+  EGLContext context = eglGetCurrentContext();
+  if (context != context_) {
+    Invalidate();
+    context_ = context;
+    ResolveGpuTimers();
+  }
+  CollectGpuTimings();
+
+  Clock::time_point now = Clock::now();
+  if (has_frame_start_) {
+    std::chrono::duration<float, std::milli> frame_time = now - frame_start_;
+    std::lock_guard<std::mutex> lock(mutex_);
+    zones_[GetZone(kFrameZone)].cpu.Add(frame_time.count());
+  }
+  frame_start_ = now;
+  has_frame_start_ = true;
+}
+
+void FrameProfiler::BeginCpuZone(const char* name) {
+  OpenCpuZone open_zone;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    open_zone.zone = GetZone(name);
+  }
+  open_zone.start = Clock::now();
+  open_cpu_zones_.push_back(open_zone);
+}
+
+void FrameProfiler::EndCpuZone() {
+  if (open_cpu_zones_.empty()) {
+    LOGE("FrameProfiler::EndCpuZone, no zone is open.");
+    return;
+  }
+  std::chrono::duration<float, std::milli> duration =
+      Clock::now() - open_cpu_zones_.back().start;
+  std::lock_guard<std::mutex> lock(mutex_);
+  zones_[open_cpu_zones_.back().zone].cpu.Add(duration.count());
+  open_cpu_zones_.pop_back();
+}
+
+void FrameProfiler::BeginGpuZone(const char* name) {
+  if (begin_query_ == nullptr || is_gpu_zone_open_ ||
+      pending_queries_.size() >= kMaxPendingQueries) {
+    return;
+  }
+  if (free_queries_.empty()) {
+    GLuint query = 0;
+    gen_queries_(1, &query);
+    free_queries_.push_back(query);
+  }
+  open_query_.query = free_queries_.back();
+  free_queries_.pop_back();
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    open_query_.zone = GetZone(name);
+  }
+  begin_query_(kTimeElapsed, open_query_.query);
+  is_gpu_zone_open_ = true;
+}
+
+void FrameProfiler::EndGpuZone() {
+  if (!is_gpu_zone_open_) {
+    return;
+  }
+  end_query_(kTimeElapsed);
+  pending_queries_.push_back(open_query_);
+  is_gpu_zone_open_ = false;
+}
+
+void FrameProfiler::SetCounter(const char* name, float value) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  zones_[GetZone(name)].counter.Add(value);
+}
+
+void FrameProfiler::Release() {
+  if (delete_queries_ != nullptr && context_ == eglGetCurrentContext()) {
+    for (const PendingQuery& pending : pending_queries_) {
+      free_queries_.push_back(pending.query);
+    }
+    if (is_gpu_zone_open_) {
+      end_query_(kTimeElapsed);
+      free_queries_.push_back(open_query_.query);
+    }
+    if (!free_queries_.empty()) {
+      delete_queries_(free_queries_.size(), free_queries_.data());
+    }
+  }
+  Invalidate();
+}
+
+void FrameProfiler::Invalidate() {
+  pending_queries_.clear();
+  free_queries_.clear();
+  is_gpu_zone_open_ = false;
+  context_ = EGL_NO_CONTEXT;
+  gen_queries_ = nullptr;
+  delete_queries_ = nullptr;
+  begin_query_ = nullptr;
+  end_query_ = nullptr;
+  get_query_objectuiv_ = nullptr;
+  get_query_objectui64v_ = nullptr;
+}
+
+std::string FrameProfiler::GetReport() const {
+  std::string report;
+  char line[128];
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (const Zone& zone : zones_) {
+    if (!zone.cpu.values.empty()) {
+      snprintf(line, sizeof(line), "%s cpu p50 %.2f p99 %.2f ms\n",
+               zone.name.c_str(), zone.cpu.GetPercentile(0.5f),
+               zone.cpu.GetPercentile(0.99f));
+      report += line;
+    }
+    if (!zone.gpu.values.empty()) {
+      snprintf(line, sizeof(line), "%s gpu p50 %.2f p99 %.2f ms\n",
+               zone.name.c_str(), zone.gpu.GetPercentile(0.5f),
+               zone.gpu.GetPercentile(0.99f));
+      report += line;
+    }
+    if (!zone.counter.values.empty()) {
+      snprintf(line, sizeof(line), "%s p50 %.0f p99 %.0f\n",
+               zone.name.c_str(), zone.counter.GetPercentile(0.5f),
+               zone.counter.GetPercentile(0.99f));
+      report += line;
+    }
+  }
+  return report;
+}
+
+float FrameProfiler::GetCpuPercentile(const char* name, float percentile,
+                                      size_t* sample_count) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const Zone* zone = FindZone(name);
+  if (sample_count != nullptr) {
+    *sample_count = zone != nullptr ? zone->cpu.values.size() : 0;
+  }
+  return zone != nullptr ? zone->cpu.GetPercentile(percentile) : 0.0f;
+}
+
+float FrameProfiler::GetGpuPercentile(const char* name, float percentile,
+                                      size_t* sample_count) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const Zone* zone = FindZone(name);
+  if (sample_count != nullptr) {
+    *sample_count = zone != nullptr ? zone->gpu.values.size() : 0;
+  }
+  return zone != nullptr ? zone->gpu.GetPercentile(percentile) : 0.0f;
+}
+
+void FrameProfiler::ClearZone(const char* name) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (Zone& zone : zones_) {
+    if (zone.name == name) {
+      zone.cpu.Clear();
+      zone.gpu.Clear();
+      zone.counter.Clear();
+    }
+  }
+}
+
+size_t FrameProfiler::GetZone(const char* name) {
+  for (size_t i = 0; i < zones_.size(); ++i) {
+    if (zones_[i].name == name) {
+      return i;
+    }
+  }
+  zones_.push_back(Zone());
+  zones_.back().name = name;
+  return zones_.size() - 1;
+}
+
+const FrameProfiler::Zone* FrameProfiler::FindZone(const char* name) const {
+  for (const Zone& zone : zones_) {
+    if (zone.name == name) {
+      return &zone;
+    }
+  }
+  return nullptr;
+}
+
+void FrameProfiler::ResolveGpuTimers() {
+  const char* extensions =
+      reinterpret_cast<const char*>(glGetString(GL_EXTENSIONS));
+  if (extensions == nullptr ||
+      strstr(extensions, "GL_EXT_disjoint_timer_query") == nullptr) {
+    return;
+  }
+  gen_queries_ =
+      reinterpret_cast<GenQueriesFunc>(eglGetProcAddress("glGenQueriesEXT"));
+  delete_queries_ = reinterpret_cast<DeleteQueriesFunc>(
+      eglGetProcAddress("glDeleteQueriesEXT"));
+  begin_query_ =
+      reinterpret_cast<BeginQueryFunc>(eglGetProcAddress("glBeginQueryEXT"));
+  end_query_ =
+      reinterpret_cast<EndQueryFunc>(eglGetProcAddress("glEndQueryEXT"));
+  get_query_objectuiv_ = reinterpret_cast<GetQueryObjectuivFunc>(
+      eglGetProcAddress("glGetQueryObjectuivEXT"));
+  get_query_objectui64v_ = reinterpret_cast<GetQueryObjectui64vFunc>(
+      eglGetProcAddress("glGetQueryObjectui64vEXT"));
+  if (gen_queries_ == nullptr || delete_queries_ == nullptr ||
+      begin_query_ == nullptr || end_query_ == nullptr ||
+      get_query_objectuiv_ == nullptr || get_query_objectui64v_ == nullptr) {
+    LOGE("FrameProfiler: timer query entry points are missing.");
+    Invalidate();
+  }
+}
+
+void FrameProfiler::CollectGpuTimings() {
+  if (begin_query_ == nullptr) {
+    return;
+  }
+  // A disjoint operation (e.g. a frequency change) makes the results of the
+  // queries in flight meaningless.
+  GLint is_disjoint = 0;
+  glGetIntegerv(kGpuDisjoint, &is_disjoint);
+
+  while (!pending_queries_.empty()) {
+    const PendingQuery& pending = pending_queries_.front();
+    GLuint is_available = 0;
+    get_query_objectuiv_(pending.query, kQueryResultAvailable, &is_available);
+    if (!is_available) {
+      break;
+    }
+    uint64_t elapsed_ns = 0;
+    get_query_objectui64v_(pending.query, kQueryResult, &elapsed_ns);
+    if (!is_disjoint) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      zones_[pending.zone].gpu.Add(elapsed_ns / 1.0e6f);
+    }
+    free_queries_.push_back(pending.query);
+    pending_queries_.pop_front();
+  }
+}
+
+}  // namespace tango_gl
@@ -24,12 +24,14 @@ static const float float_vertices[] = {
     1.0f,  1.0f,  -1.0f, 1.0f,  -1.0f, -1.0f, 1.0f,  -1.0f, -1.0f, -1.0f,
     -1.0f, -1.0f, -1.0f, -1.0f, -1.0f, -1.0f, 1.0f,  -1.0f};
 
+static void BuildFrustum(Geometry* geometry) {
+  geometry->vertices.assign(
+      float_vertices,
+      float_vertices + sizeof(float_vertices) / sizeof(float));
+}
+
 Frustum::Frustum() : Line(3.0f, GL_LINES) {
   SetShader();
-  size_t size = sizeof(float_vertices) / sizeof(float);
-  for (size_t i = 0; i < size; i += 3) {
-    vec_vertices_.push_back(glm::vec3(float_vertices[i], float_vertices[i + 1],
-                                      float_vertices[i + 2]));
-  }
+  SetGeometry(geometry_registry::Acquire("frustum", BuildFrustum));
 }
 }  // namespace tango_gl
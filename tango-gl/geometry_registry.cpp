@@ -0,0 +1,128 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <unordered_map>
+
+#include "tango-gl/geometry_registry.h"
+
+namespace {
+// Registered geometries, only touched on the GL thread. Entries of released
+// geometries are dropped on the next Acquire().
+std::unordered_map<std::string, std::weak_ptr<const tango_gl::Geometry>>
+    g_geometries;
+}  // namespace
+
+namespace tango_gl {
+
+Geometry::Geometry()
+    : vertex_buffer_(GL_ARRAY_BUFFER, GL_STATIC_DRAW),
+      index_buffer_(GL_ELEMENT_ARRAY_BUFFER, GL_STATIC_DRAW),
+      context_(EGL_NO_CONTEXT) {}
+
+Geometry::~Geometry() {
+  // Buffers of another context may not be deleted from this one.
+  if (context_ != eglGetCurrentContext()) {
+    vertex_buffer_.Invalidate();
+    index_buffer_.Invalidate();
+  }
+}
+
+void Geometry::Bind() const {
+  EGLContext context = eglGetCurrentContext();
+  if (context != context_) {
+    vertex_buffer_.Invalidate();
+    index_buffer_.Invalidate();
+    context_ = context;
+
+    const size_t vertex_count = GetVertexCount();
+    const size_t floats_per_vertex = GetStride() / sizeof(GLfloat);
+    std::vector<GLfloat> interleaved;
+    interleaved.reserve(vertex_count * floats_per_vertex);
+    for (size_t i = 0; i < vertex_count; ++i) {
+      interleaved.insert(interleaved.end(), vertices.begin() + i * 3,
+                         vertices.begin() + i * 3 + 3);
+      if (!normals.empty()) {
+        interleaved.insert(interleaved.end(), normals.begin() + i * 3,
+                           normals.begin() + i * 3 + 3);
+      }
+      if (!colors.empty()) {
+        interleaved.insert(interleaved.end(), colors.begin() + i * 4,
+                           colors.begin() + i * 4 + 4);
+      }
+      if (!texture_coords.empty()) {
+        interleaved.insert(interleaved.end(), texture_coords.begin() + i * 2,
+                           texture_coords.begin() + i * 2 + 2);
+      }
+    }
+    vertex_buffer_.Update(interleaved.data(),
+                          interleaved.size() * sizeof(GLfloat), 0);
+    if (!indices.empty()) {
+      index_buffer_.Update(indices.data(), indices.size() * sizeof(GLushort),
+                           0);
+    }
+  }
+  vertex_buffer_.Bind();
+  if (!indices.empty()) {
+    index_buffer_.Bind();
+  }
+}
+
+GLsizei Geometry::GetStride() const {
+  size_t floats = 3;
+  floats += normals.empty() ? 0 : 3;
+  floats += colors.empty() ? 0 : 4;
+  floats += texture_coords.empty() ? 0 : 2;
+  return floats * sizeof(GLfloat);
+}
+
+const GLvoid* Geometry::GetNormalOffset() const {
+  return reinterpret_cast<const GLvoid*>(3 * sizeof(GLfloat));
+}
+
+const GLvoid* Geometry::GetColorOffset() const {
+  size_t floats = 3 + (normals.empty() ? 0 : 3);
+  return reinterpret_cast<const GLvoid*>(floats * sizeof(GLfloat));
+}
+
+const GLvoid* Geometry::GetTextureCoordOffset() const {
+  size_t floats = 3 + (normals.empty() ? 0 : 3) + (colors.empty() ? 0 : 4);
+  return reinterpret_cast<const GLvoid*>(floats * sizeof(GLfloat));
+}
+
+namespace geometry_registry {
+
+std::shared_ptr<const Geometry> Acquire(
+    const std::string& key, const std::function<void(Geometry*)>& build) {
+  for (auto it = g_geometries.begin(); it != g_geometries.end();) {
+    if (it->second.expired()) {
+      it = g_geometries.erase(it);
+    } else {
+      ++it;
+    }
+  }
+
+  std::shared_ptr<const Geometry> geometry = g_geometries[key].lock();
+  if (!geometry) {
+    Geometry* new_geometry = new Geometry();
+    build(new_geometry);
+    geometry.reset(new_geometry);
+    g_geometries[key] = geometry;
+  }
+  return geometry;
+}
+
+}  // namespace geometry_registry
+}  // namespace tango_gl
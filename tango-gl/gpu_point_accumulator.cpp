@@ -0,0 +1,335 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <EGL/egl.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include "tango-gl/gpu_point_accumulator.h"
+
+#include "tango-gl/counters.h"
+#include "tango-gl/frame_constants.h"
+#include "tango-gl/memory_tracker.h"
+#include "tango-gl/program_cache.h"
+#include "tango-gl/render_state.h"
+#include "tango-gl/shader_variants.h"
+#include "tango-gl/shaders.h"
+
+// GLES3 tokens, the examples are built against the GLES2 headers.
+#ifndef GL_TRANSFORM_FEEDBACK_BUFFER
+#define GL_TRANSFORM_FEEDBACK_BUFFER 0x8C8E
+#endif
+#ifndef GL_INTERLEAVED_ATTRIBS
+#define GL_INTERLEAVED_ATTRIBS 0x8C8C
+#endif
+#ifndef GL_RASTERIZER_DISCARD
+#define GL_RASTERIZER_DISCARD 0x8C89
+#endif
+#ifndef GL_DYNAMIC_COPY
+#define GL_DYNAMIC_COPY 0x88EA
+#endif
+
+namespace {
+typedef void (GL_APIENTRY* TransformFeedbackVaryingsFunc)(
+    GLuint program, GLsizei count, const GLchar* const* varyings,
+    GLenum buffer_mode);
+typedef void (GL_APIENTRY* BeginTransformFeedbackFunc)(GLenum primitive_mode);
+typedef void (GL_APIENTRY* EndTransformFeedbackFunc)();
+typedef void (GL_APIENTRY* BindBufferRangeFunc)(GLenum target, GLuint index,
+                                                GLuint buffer, GLintptr offset,
+                                                GLsizeiptr size);
+typedef void (GL_APIENTRY* BindBufferBaseFunc)(GLenum target, GLuint index,
+                                               GLuint buffer);
+
+// Bytes of a world space point, x, y, z.
+const size_t kPointSize = 3 * sizeof(GLfloat);
+
+// State of g_context, only touched on the GL thread.
+EGLContext g_context = EGL_NO_CONTEXT;
+TransformFeedbackVaryingsFunc g_transform_feedback_varyings = nullptr;
+BeginTransformFeedbackFunc g_begin_transform_feedback = nullptr;
+EndTransformFeedbackFunc g_end_transform_feedback = nullptr;
+BindBufferRangeFunc g_bind_buffer_range = nullptr;
+BindBufferBaseFunc g_bind_buffer_base = nullptr;
+
+// Resolve the entry points again when the current context changed. The
+// GLES3 entry points are resolved at runtime so the examples keep linking
+// against libGLESv2 only.
+void UpdateContext() {
+  EGLContext context = eglGetCurrentContext();
+  if (context == g_context) {
+    return;
+  }
+  g_context = context;
+  g_transform_feedback_varyings = nullptr;
+  g_begin_transform_feedback = nullptr;
+  g_end_transform_feedback = nullptr;
+  g_bind_buffer_range = nullptr;
+  g_bind_buffer_base = nullptr;
+  const char* version = reinterpret_cast<const char*>(glGetString(GL_VERSION));
+  if (version == nullptr || strncmp(version, "OpenGL ES 3", 11) != 0) {
+    return;
+  }
+  g_transform_feedback_varyings =
+      reinterpret_cast<TransformFeedbackVaryingsFunc>(
+          eglGetProcAddress("glTransformFeedbackVaryings"));
+  g_begin_transform_feedback = reinterpret_cast<BeginTransformFeedbackFunc>(
+      eglGetProcAddress("glBeginTransformFeedback"));
+  g_end_transform_feedback = reinterpret_cast<EndTransformFeedbackFunc>(
+      eglGetProcAddress("glEndTransformFeedback"));
+  g_bind_buffer_range = reinterpret_cast<BindBufferRangeFunc>(
+      eglGetProcAddress("glBindBufferRange"));
+  g_bind_buffer_base = reinterpret_cast<BindBufferBaseFunc>(
+      eglGetProcAddress("glBindBufferBase"));
+  if (g_transform_feedback_varyings == nullptr ||
+      g_begin_transform_feedback == nullptr ||
+      g_end_transform_feedback == nullptr || g_bind_buffer_range == nullptr ||
+      g_bind_buffer_base == nullptr) {
+    LOGE("GpuPointAccumulator: GLES3 context without transform feedback "
+         "entry points.");
+    g_transform_feedback_varyings = nullptr;
+  }
+}
+
+// Link the transform feedback program. The captured varyings are part of
+// the link, so the program is linked a second time once they are set. It
+// does not go through program_cache: a persisted binary would miss them.
+GLuint CreateTransformProgram() {
+  GLuint program = tango_gl::util::CreateProgram(
+      tango_gl::shaders::GetPointTransformVertexShader().c_str(),
+      tango_gl::shaders::GetPointTransformFragmentShader().c_str());
+  if (program == 0) {
+    return 0;
+  }
+  const GLchar* varyings[] = {"world_position"};
+  g_transform_feedback_varyings(program, 1, varyings, GL_INTERLEAVED_ATTRIBS);
+  glLinkProgram(program);
+  GLint link_status = GL_FALSE;
+  glGetProgramiv(program, GL_LINK_STATUS, &link_status);
+  if (link_status != GL_TRUE) {
+    glDeleteProgram(program);
+    return 0;
+  }
+  return program;
+}
+}  // namespace
+
+namespace tango_gl {
+
+GpuPointAccumulator::GpuPointAccumulator(const Options& options)
+    : options_(options),
+      color_(0.85f, 0.85f, 0.85f),
+      point_size_(2.0f),
+      block_(0),
+      frame_count_(0),
+      transform_program_(0),
+      transform_attrib_vertices_(-1),
+      uniform_world_T_depth_(-1),
+      render_program_(0),
+      attrib_vertices_(-1),
+      uniform_mvp_mat_(-1),
+      uniform_color_(-1),
+      uniform_point_size_(-1) {
+  options_.block_point_count = std::max<size_t>(1, options_.block_point_count);
+  options_.block_count = std::max(1, options_.block_count);
+}
+
+GpuPointAccumulator::~GpuPointAccumulator() { Release(); }
+
+bool GpuPointAccumulator::IsSupported() {
+  UpdateContext();
+  return g_transform_feedback_varyings != nullptr;
+}
+
+bool GpuPointAccumulator::Accumulate(const PointCloudBuffer& frame,
+                                     const glm::mat4& world_T_depth) {
+  if (!InitializeGL()) {
+    return false;
+  }
+  const size_t frame_point_count = frame.GetPointCount();
+  if (frame_point_count == 0) {
+    return true;
+  }
+
+  RenderState::UseProgram(transform_program_);
+  glUniformMatrix4fv(uniform_world_T_depth_, 1, GL_FALSE,
+                     glm::value_ptr(world_T_depth));
+  frame.Bind();
+  glEnableVertexAttribArray(transform_attrib_vertices_);
+  glVertexAttribPointer(transform_attrib_vertices_, 3, GL_FLOAT, GL_FALSE, 0,
+                        nullptr);
+  RenderState::Enable(GL_RASTERIZER_DISCARD);
+
+  // One pass per block the frame lands in, each capturing into the free
+  // range of its block.
+  size_t first = 0;
+  while (first < frame_point_count) {
+    Block* block = &blocks_[block_];
+    if (block->point_count == options_.block_point_count) {
+      block_ = (block_ + 1) % static_cast<int>(blocks_.size());
+      block = &blocks_[block_];
+      block->point_count = 0;
+    }
+    const size_t count =
+        std::min(frame_point_count - first,
+                 options_.block_point_count - block->point_count);
+    RenderState::BindBuffer(GL_TRANSFORM_FEEDBACK_BUFFER, block->buffer);
+    g_bind_buffer_range(GL_TRANSFORM_FEEDBACK_BUFFER, 0, block->buffer,
+                        block->point_count * kPointSize, count * kPointSize);
+    g_begin_transform_feedback(GL_POINTS);
+    Counters::Increment(Counters::kDrawCalls);
+    glDrawArrays(GL_POINTS, static_cast<GLint>(first),
+                 static_cast<GLsizei>(count));
+    g_end_transform_feedback();
+    block->point_count += count;
+    first += count;
+  }
+
+  RenderState::Disable(GL_RASTERIZER_DISCARD);
+  g_bind_buffer_base(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+  RenderState::BindBuffer(GL_TRANSFORM_FEEDBACK_BUFFER, 0);
+  glDisableVertexAttribArray(transform_attrib_vertices_);
+  RenderState::BindBuffer(GL_ARRAY_BUFFER, 0);
+  ++frame_count_;
+  util::CheckGlError("GpuPointAccumulator::Accumulate");
+  return true;
+}
+
+void GpuPointAccumulator::Render(const glm::mat4& projection_mat,
+                                 const glm::mat4& view_mat) {
+  if (render_program_ == 0 || GetPointCount() == 0) {
+    return;
+  }
+  RenderState::UseProgram(render_program_);
+  const glm::mat4 mvp_mat =
+      FrameConstants::GetViewProjection(projection_mat, view_mat);
+  glUniformMatrix4fv(uniform_mvp_mat_, 1, GL_FALSE, glm::value_ptr(mvp_mat));
+  glUniform4f(uniform_color_, color_.r, color_.g, color_.b, 1.0f);
+  glUniform1f(uniform_point_size_, point_size_);
+
+  glEnableVertexAttribArray(attrib_vertices_);
+  for (const Block& block : blocks_) {
+    if (block.point_count == 0) {
+      continue;
+    }
+    RenderState::BindBuffer(GL_ARRAY_BUFFER, block.buffer);
+    glVertexAttribPointer(attrib_vertices_, 3, GL_FLOAT, GL_FALSE, 0,
+                          nullptr);
+    Counters::Increment(Counters::kDrawCalls);
+    glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(block.point_count));
+  }
+  glDisableVertexAttribArray(attrib_vertices_);
+  RenderState::BindBuffer(GL_ARRAY_BUFFER, 0);
+  util::CheckGlError("GpuPointAccumulator::Render");
+}
+
+void GpuPointAccumulator::Clear() {
+  for (Block& block : blocks_) {
+    block.point_count = 0;
+  }
+  block_ = 0;
+  frame_count_ = 0;
+}
+
+size_t GpuPointAccumulator::GetPointCount() const {
+  size_t point_count = 0;
+  for (const Block& block : blocks_) {
+    point_count += block.point_count;
+  }
+  return point_count;
+}
+
+bool GpuPointAccumulator::InitializeGL() {
+  if (transform_program_ != 0) {
+    return true;
+  }
+  if (!IsSupported()) {
+    return false;
+  }
+  transform_program_ = CreateTransformProgram();
+  if (transform_program_ == 0) {
+    LOGE("GpuPointAccumulator: could not create the transform program.");
+    return false;
+  }
+  transform_attrib_vertices_ =
+      glGetAttribLocation(transform_program_, "vertex");
+  uniform_world_T_depth_ =
+      glGetUniformLocation(transform_program_, "world_T_depth");
+
+  const shader_variants::Variant* variant =
+      shader_variants::Acquire(shader_variants::kPointSize);
+  if (variant == nullptr) {
+    LOGE("GpuPointAccumulator: could not create the render program.");
+    Release();
+    return false;
+  }
+  render_program_ = variant->program;
+  attrib_vertices_ = variant->attributes[shader_variants::kVertexAttribute];
+  uniform_mvp_mat_ = variant->uniforms[shader_variants::kMvp];
+  uniform_color_ = variant->uniforms[shader_variants::kColor];
+  uniform_point_size_ =
+      variant->uniforms[shader_variants::kPointSizeUniform];
+
+  const size_t block_size = options_.block_point_count * kPointSize;
+  blocks_.resize(options_.block_count);
+  for (Block& block : blocks_) {
+    block.point_count = 0;
+    glGenBuffers(1, &block.buffer);
+    RenderState::BindBuffer(GL_ARRAY_BUFFER, block.buffer);
+    glBufferData(GL_ARRAY_BUFFER, block_size, nullptr, GL_DYNAMIC_COPY);
+    // The size rather than glGetError(), which may hold an earlier error of
+    // the application.
+    GLint size = 0;
+    glGetBufferParameteriv(GL_ARRAY_BUFFER, GL_BUFFER_SIZE, &size);
+    RenderState::BindBuffer(GL_ARRAY_BUFFER, 0);
+    if (size != static_cast<GLint>(block_size)) {
+      LOGE("GpuPointAccumulator: could not create the point blocks.");
+      RenderState::DeleteBuffers(1, &block.buffer);
+      block.buffer = 0;
+      Release();
+      return false;
+    }
+    MemoryTracker::Track(MemoryTracker::kBuffer, block.buffer,
+                         "GpuPointAccumulator", block_size);
+  }
+  block_ = 0;
+  return true;
+}
+
+void GpuPointAccumulator::Release() {
+  if (transform_program_ != 0) {
+    glDeleteProgram(transform_program_);
+  }
+  program_cache::ReleaseProgram(render_program_);
+  for (Block& block : blocks_) {
+    if (block.buffer != 0) {
+      RenderState::DeleteBuffers(1, &block.buffer);
+    }
+  }
+  Invalidate();
+}
+
+void GpuPointAccumulator::Invalidate() {
+  transform_program_ = 0;
+  render_program_ = 0;
+  blocks_.clear();
+  block_ = 0;
+  frame_count_ = 0;
+}
+
+}  // namespace tango_gl
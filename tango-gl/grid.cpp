@@ -14,14 +14,36 @@
  * limitations under the License.
  */
 
+#include <string.h>
+
 #include "tango-gl/grid.h"
+#include "tango-gl/counters.h"
+#include "tango-gl/program_cache.h"
+#include "tango-gl/render_state.h"
+#include "tango-gl/shaders.h"
+#include "tango-gl/simd_math.h"
 
 namespace tango_gl {
 
+// Unit square in the XZ plane, as a triangle strip.
+static const GLfloat plane_vertices[] = {-1.0f, 0.0f, -1.0f, -1.0f, 0.0f, 1.0f,
+                                         1.0f,  0.0f, -1.0f, 1.0f,  0.0f, 1.0f};
+
+static void BuildPlane(Geometry* geometry) {
+  geometry->vertices.assign(
+      plane_vertices,
+      plane_vertices + sizeof(plane_vertices) / sizeof(GLfloat));
+}
+
 // Initialize Grid with x and y grid count,
 // qx, quantity in x
 // qy, quantity in y.
-Grid::Grid(float density, int qx, int qy) : Line(1.0f, GL_LINES) {
+Grid::Grid(float density, int qx, int qy)
+    : Line(1.0f, GL_LINES),
+      density_(density),
+      fade_distance_(density * std::max(qx, qy) / 2),
+      is_procedural_(false),
+      procedural_program_(0) {
   SetShader();
 
   // 3 float in 1 vertex, 2 vertices form a line.
@@ -40,4 +62,83 @@ Grid::Grid(float density, int qx, int qy) : Line(1.0f, GL_LINES) {
     vec_vertices_.push_back(glm::vec3(-width + i * density, 0.0f, height));
   }
 }
+
+Grid::~Grid() { program_cache::ReleaseProgram(procedural_program_); }
+
+bool Grid::SetProcedural(bool is_procedural) {
+  if (!is_procedural) {
+    is_procedural_ = false;
+    return true;
+  }
+  if (procedural_program_ == 0) {
+    const char* extensions =
+        reinterpret_cast<const char*>(glGetString(GL_EXTENSIONS));
+    if (extensions == nullptr ||
+        strstr(extensions, "GL_OES_standard_derivatives") == nullptr) {
+      LOGE("Grid::SetProcedural, GL_OES_standard_derivatives is missing.");
+      return false;
+    }
+    procedural_program_ =
+        program_cache::AcquireProgram(shaders::GetGridVertexShader().c_str(),
+                                      shaders::GetGridFragmentShader().c_str());
+    if (!procedural_program_) {
+      LOGE("Could not create program.");
+      return false;
+    }
+    uniform_plane_mvp_mat_ = glGetUniformLocation(procedural_program_, "mvp");
+    uniform_plane_color_ = glGetUniformLocation(procedural_program_, "color");
+    uniform_camera_ = glGetUniformLocation(procedural_program_, "camera");
+    uniform_origin_ = glGetUniformLocation(procedural_program_, "origin");
+    uniform_density_ = glGetUniformLocation(procedural_program_, "density");
+    uniform_fade_distance_ =
+        glGetUniformLocation(procedural_program_, "fade_distance");
+    uniform_line_width_ =
+        glGetUniformLocation(procedural_program_, "line_width");
+    attrib_plane_vertices_ =
+        glGetAttribLocation(procedural_program_, "vertex");
+    plane_ = geometry_registry::Acquire("grid_plane", BuildPlane);
+    plane_vertex_array_.Reset();
+  }
+  is_procedural_ = true;
+  return true;
+}
+
+void Grid::Render(const glm::mat4& projection_mat,
+                  const glm::mat4& view_mat) const {
+  if (!is_procedural_) {
+    Line::Render(projection_mat, view_mat);
+    return;
+  }
+
+  RenderState::UseProgram(procedural_program_);
+  glm::mat4 mv_mat = simd_math::Multiply(view_mat, GetTransformationMatrix());
+  glm::mat4 mvp_mat = simd_math::Multiply(projection_mat, mv_mat);
+  glUniformMatrix4fv(uniform_plane_mvp_mat_, 1, GL_FALSE,
+                     glm::value_ptr(mvp_mat));
+  glUniform4f(uniform_plane_color_, red_, green_, blue_, alpha_);
+
+  // Camera position in the grid frame, and the grid line crossing closest
+  // below it.
+  glm::vec3 camera = glm::vec3(glm::inverse(mv_mat)[3]);
+  glm::vec2 origin = glm::floor(glm::vec2(camera.x, camera.z) / density_) *
+                     density_;
+  glUniform3fv(uniform_camera_, 1, glm::value_ptr(camera));
+  glUniform2fv(uniform_origin_, 1, glm::value_ptr(origin));
+  glUniform1f(uniform_density_, density_);
+  glUniform1f(uniform_fade_distance_, fade_distance_);
+  glUniform1f(uniform_line_width_, line_width_);
+
+  RenderState::Enable(GL_BLEND);
+  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+  if (!plane_vertex_array_.Bind()) {
+    plane_->Bind();
+    plane_vertex_array_.EnableAttribute(attrib_plane_vertices_);
+    glVertexAttribPointer(attrib_plane_vertices_, 3, GL_FLOAT, GL_FALSE,
+                          plane_->GetStride(), nullptr);
+  }
+  Counters::Increment(Counters::kDrawCalls);
+  glDrawArrays(GL_TRIANGLE_STRIP, 0, plane_->GetVertexCount());
+  plane_vertex_array_.Unbind();
+  RenderState::Disable(GL_BLEND);
+}
 }  // namespace tango_gl
@@ -0,0 +1,391 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "tango-gl/hardware_frame_queue.h"
+
+#include <dlfcn.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <mutex>
+
+#include "tango-gl/render_state.h"
+
+namespace {
+// The parts of <android/hardware_buffer.h> used here, with the same layout.
+struct HardwareBufferDesc {
+  uint32_t width;
+  uint32_t height;
+  uint32_t layers;
+  uint32_t format;
+  uint64_t usage;
+  uint32_t stride;
+  uint32_t rfu0;
+  uint64_t rfu1;
+};
+
+struct HardwareBufferPlane {
+  void* data;
+  uint32_t pixel_stride;
+  uint32_t row_stride;
+};
+
+struct HardwareBufferPlanes {
+  uint32_t plane_count;
+  HardwareBufferPlane planes[4];
+};
+
+// AHARDWAREBUFFER_FORMAT_Y8Cb8Cr8_420, the flexible YUV 4:2:0 format.
+const uint32_t kFormatYCbCr420 = 0x23;
+// AHARDWAREBUFFER_USAGE_CPU_WRITE_OFTEN | _GPU_SAMPLED_IMAGE.
+const uint64_t kUsage = (3ULL << 4) | (1ULL << 8);
+const uint64_t kCpuWriteUsage = 3ULL << 4;
+
+// EGL_ANDROID_image_native_buffer and EGL_ANDROID_native_fence_sync, not in
+// the eglext.h of every NDK.
+const EGLenum kNativeBufferAndroid = 0x3140;
+const EGLenum kSyncNativeFenceAndroid = 0x3144;
+const EGLint kSyncNativeFenceFdAndroid = 0x3145;
+const EGLint kNoNativeFenceFdAndroid = -1;
+const EGLint kImagePreservedKhr = 0x30D2;
+
+typedef int (*AllocateFunction)(const HardwareBufferDesc*, AHardwareBuffer**);
+typedef void (*ReleaseFunction)(AHardwareBuffer*);
+typedef int (*LockPlanesFunction)(AHardwareBuffer*, uint64_t, int32_t,
+                                  const void*, HardwareBufferPlanes*);
+typedef int (*UnlockFunction)(AHardwareBuffer*, int32_t*);
+typedef EGLClientBuffer (*GetNativeClientBufferFunction)(
+    const AHardwareBuffer*);
+typedef void* (*CreateImageFunction)(EGLDisplay, EGLContext, EGLenum,
+                                     EGLClientBuffer, const EGLint*);
+typedef EGLBoolean (*DestroyImageFunction)(EGLDisplay, void*);
+typedef void* (*CreateSyncFunction)(EGLDisplay, EGLenum, const EGLint*);
+typedef EGLBoolean (*DestroySyncFunction)(EGLDisplay, void*);
+typedef EGLint (*DupNativeFenceFdFunction)(EGLDisplay, void*);
+typedef void (*ImageTargetTextureFunction)(GLenum, void*);
+
+// Functions resolved once, the libandroid ones from any thread.
+struct Functions {
+  AllocateFunction allocate;
+  ReleaseFunction release;
+  LockPlanesFunction lock_planes;
+  UnlockFunction unlock;
+  GetNativeClientBufferFunction get_native_client_buffer;
+  CreateImageFunction create_image;
+  DestroyImageFunction destroy_image;
+  CreateSyncFunction create_sync;
+  DestroySyncFunction destroy_sync;
+  DupNativeFenceFdFunction dup_native_fence_fd;
+  ImageTargetTextureFunction image_target_texture;
+};
+
+const Functions& GetFunctions() {
+  static Functions functions;
+  static std::once_flag once;
+  std::call_once(once, []() {
+    memset(&functions, 0, sizeof(functions));
+    void* library = dlopen("libandroid.so", RTLD_NOW);
+    if (library != nullptr) {
+      functions.allocate = reinterpret_cast<AllocateFunction>(
+          dlsym(library, "AHardwareBuffer_allocate"));
+      functions.release = reinterpret_cast<ReleaseFunction>(
+          dlsym(library, "AHardwareBuffer_release"));
+      functions.lock_planes = reinterpret_cast<LockPlanesFunction>(
+          dlsym(library, "AHardwareBuffer_lockPlanes"));
+      functions.unlock = reinterpret_cast<UnlockFunction>(
+          dlsym(library, "AHardwareBuffer_unlock"));
+    }
+    functions.get_native_client_buffer =
+        reinterpret_cast<GetNativeClientBufferFunction>(
+            eglGetProcAddress("eglGetNativeClientBufferANDROID"));
+    functions.create_image = reinterpret_cast<CreateImageFunction>(
+        eglGetProcAddress("eglCreateImageKHR"));
+    functions.destroy_image = reinterpret_cast<DestroyImageFunction>(
+        eglGetProcAddress("eglDestroyImageKHR"));
+    functions.create_sync = reinterpret_cast<CreateSyncFunction>(
+        eglGetProcAddress("eglCreateSyncKHR"));
+    functions.destroy_sync = reinterpret_cast<DestroySyncFunction>(
+        eglGetProcAddress("eglDestroySyncKHR"));
+    functions.dup_native_fence_fd = reinterpret_cast<DupNativeFenceFdFunction>(
+        eglGetProcAddress("eglDupNativeFenceFDANDROID"));
+    functions.image_target_texture =
+        reinterpret_cast<ImageTargetTextureFunction>(
+            eglGetProcAddress("glEGLImageTargetTexture2DOES"));
+  });
+  return functions;
+}
+
+bool HasExtension(const char* extensions, const char* name) {
+  return extensions != nullptr && strstr(extensions, name) != nullptr;
+}
+
+// Copy the rows of a plane, a memcpy per row when the pixels are packed.
+void CopyPlane(const uint8_t* source, int source_stride, int width,
+               int height, const HardwareBufferPlane& plane) {
+  uint8_t* row = static_cast<uint8_t*>(plane.data);
+  for (int y = 0; y < height; ++y, source += source_stride,
+           row += plane.row_stride) {
+    if (plane.pixel_stride == 1) {
+      memcpy(row, source, width);
+    } else {
+      for (int x = 0; x < width; ++x) {
+        row[x * plane.pixel_stride] = source[x];
+      }
+    }
+  }
+}
+
+// Copy the interleaved VU rows of NV21 into the chroma planes of a buffer.
+void CopyChroma(const uint8_t* vu, int stride, int width, int height,
+                const HardwareBufferPlane& u_plane,
+                const HardwareBufferPlane& v_plane) {
+  const int chroma_width = width / 2;
+  const int chroma_height = height / 2;
+  // Most drivers lay the chroma out as NV21 already, V one byte before U.
+  if (u_plane.pixel_stride == 2 && v_plane.pixel_stride == 2 &&
+      u_plane.row_stride == v_plane.row_stride &&
+      static_cast<uint8_t*>(u_plane.data) ==
+          static_cast<uint8_t*>(v_plane.data) + 1) {
+    HardwareBufferPlane interleaved = v_plane;
+    interleaved.pixel_stride = 1;
+    CopyPlane(vu, stride, chroma_width * 2, chroma_height, interleaved);
+    return;
+  }
+  uint8_t* u_row = static_cast<uint8_t*>(u_plane.data);
+  uint8_t* v_row = static_cast<uint8_t*>(v_plane.data);
+  for (int y = 0; y < chroma_height; ++y, vu += stride,
+           u_row += u_plane.row_stride, v_row += v_plane.row_stride) {
+    for (int x = 0; x < chroma_width; ++x) {
+      v_row[x * v_plane.pixel_stride] = vu[2 * x];
+      u_row[x * u_plane.pixel_stride] = vu[2 * x + 1];
+    }
+  }
+}
+}  // namespace
+
+namespace tango_gl {
+
+HardwareFrameQueue::HardwareFrameQueue()
+    : next_id_(1), acquire_count_(0), has_frame_(false) {}
+
+HardwareFrameQueue::~HardwareFrameQueue() {
+  const Functions& functions = GetFunctions();
+  // The textures belong to the GL context, only the images and buffers are
+  // freed here.
+  for (Import& import : imports_) {
+    if (import.image != nullptr && functions.destroy_image != nullptr) {
+      functions.destroy_image(eglGetDisplay(EGL_DEFAULT_DISPLAY),
+                              import.image);
+    }
+  }
+  for (int i = 0; i < TripleBuffer<Slot>::kSlotCount; ++i) {
+    Slot* slot = slots_.GetSlot(i);
+    if (slot->buffer != nullptr) {
+      functions.release(slot->buffer);
+    }
+    if (slot->fence >= 0) {
+      close(slot->fence);
+    }
+  }
+}
+
+bool HardwareFrameQueue::IsSupported() {
+  const Functions& functions = GetFunctions();
+  if (functions.allocate == nullptr || functions.release == nullptr ||
+      functions.lock_planes == nullptr || functions.unlock == nullptr ||
+      functions.get_native_client_buffer == nullptr ||
+      functions.create_image == nullptr ||
+      functions.destroy_image == nullptr || functions.create_sync == nullptr ||
+      functions.destroy_sync == nullptr ||
+      functions.dup_native_fence_fd == nullptr ||
+      functions.image_target_texture == nullptr) {
+    return false;
+  }
+  const char* egl_extensions =
+      eglQueryString(eglGetCurrentDisplay(), EGL_EXTENSIONS);
+  const char* gl_extensions =
+      reinterpret_cast<const char*>(glGetString(GL_EXTENSIONS));
+  return HasExtension(egl_extensions, "EGL_ANDROID_image_native_buffer") &&
+         HasExtension(egl_extensions, "EGL_ANDROID_native_fence_sync") &&
+         HasExtension(gl_extensions, "GL_OES_EGL_image_external");
+}
+
+bool HardwareFrameQueue::PublishNV21(const uint8_t* nv21, int width,
+                                     int height, int stride) {
+  const Functions& functions = GetFunctions();
+  if (functions.allocate == nullptr || functions.release == nullptr ||
+      functions.lock_planes == nullptr || functions.unlock == nullptr) {
+    return false;
+  }
+
+  Slot* slot = slots_.GetWriteBuffer();
+  if (slot->buffer == nullptr || slot->width != width ||
+      slot->height != height) {
+    if (slot->buffer != nullptr) {
+      // The consumer's import keeps its own reference until it is evicted.
+      functions.release(slot->buffer);
+      slot->buffer = nullptr;
+    }
+    HardwareBufferDesc desc;
+    memset(&desc, 0, sizeof(desc));
+    desc.width = width;
+    desc.height = height;
+    desc.layers = 1;
+    desc.format = kFormatYCbCr420;
+    desc.usage = kUsage;
+    if (functions.allocate(&desc, &slot->buffer) != 0) {
+      LOGE("HardwareFrameQueue: Could not allocate a %dx%d buffer", width,
+           height);
+      slot->buffer = nullptr;
+      return false;
+    }
+    slot->id = next_id_++;
+    slot->width = width;
+    slot->height = height;
+  }
+
+  // The lock waits for the GPU reads of the last frame in this buffer and
+  // takes ownership of the fence.
+  HardwareBufferPlanes planes;
+  const int fence = slot->fence;
+  slot->fence = -1;
+  if (functions.lock_planes(slot->buffer, kCpuWriteUsage, fence, nullptr,
+                            &planes) != 0 ||
+      planes.plane_count != 3) {
+    LOGE("HardwareFrameQueue: Could not lock the buffer planes");
+    return false;
+  }
+  CopyPlane(nv21, stride, width, height, planes.planes[0]);
+  CopyChroma(nv21 + static_cast<size_t>(stride) * height, stride, width,
+             height, planes.planes[1], planes.planes[2]);
+  functions.unlock(slot->buffer, nullptr);
+
+  slots_.Publish();
+  return true;
+}
+
+GLuint HardwareFrameQueue::AcquireTexture(bool* is_new_frame) {
+  *is_new_frame = slots_.Acquire();
+  has_frame_ = has_frame_ || *is_new_frame;
+  const Slot& slot = *slots_.GetReadBuffer();
+  if (!has_frame_ || slot.buffer == nullptr) {
+    return 0;
+  }
+  Import* import = FindImport(slot);
+  import->last_use = ++acquire_count_;
+  return import->texture;
+}
+
+HardwareFrameQueue::Import* HardwareFrameQueue::FindImport(
+    const Slot& slot) {
+  Import* oldest = &imports_[0];
+  for (Import& import : imports_) {
+    if (import.id == slot.id && import.texture != 0) {
+      return &import;
+    }
+    if (import.last_use < oldest->last_use) {
+      oldest = &import;
+    }
+  }
+
+  // Reuse the least recently used import, its buffer may still be in a slot
+  // and is imported again when it comes back.
+  const Functions& functions = GetFunctions();
+  EGLDisplay display = eglGetCurrentDisplay();
+  if (oldest->image != nullptr) {
+    functions.destroy_image(display, oldest->image);
+    oldest->image = nullptr;
+  }
+  oldest->id = slot.id;
+  if (oldest->texture == 0) {
+    glGenTextures(1, &oldest->texture);
+  }
+  const EGLint attributes[] = {kImagePreservedKhr, EGL_TRUE, EGL_NONE};
+  oldest->image = functions.create_image(
+      display, EGL_NO_CONTEXT, kNativeBufferAndroid,
+      functions.get_native_client_buffer(slot.buffer), attributes);
+  if (oldest->image == nullptr) {
+    LOGE("HardwareFrameQueue: Could not create an EGLImage");
+  }
+
+  RenderState::BindTexture(GL_TEXTURE_EXTERNAL_OES, oldest->texture);
+  glTexParameteri(GL_TEXTURE_EXTERNAL_OES, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_EXTERNAL_OES, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_EXTERNAL_OES, GL_TEXTURE_WRAP_S,
+                  GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_EXTERNAL_OES, GL_TEXTURE_WRAP_T,
+                  GL_CLAMP_TO_EDGE);
+  if (oldest->image != nullptr) {
+    functions.image_target_texture(GL_TEXTURE_EXTERNAL_OES, oldest->image);
+  }
+  util::CheckGlError("HardwareFrameQueue::FindImport");
+  return oldest;
+}
+
+void HardwareFrameQueue::EndRead() {
+  Slot* slot = slots_.GetReadBuffer();
+  if (!has_frame_ || slot->buffer == nullptr) {
+    return;
+  }
+  const Functions& functions = GetFunctions();
+  EGLDisplay display = eglGetCurrentDisplay();
+  const EGLint attributes[] = {kSyncNativeFenceFdAndroid,
+                               kNoNativeFenceFdAndroid, EGL_NONE};
+  void* sync =
+      functions.create_sync(display, kSyncNativeFenceAndroid, attributes);
+  if (sync == nullptr) {
+    // Without a fence the producer could overwrite a buffer in use.
+    glFinish();
+    return;
+  }
+  // The fence only gets a file descriptor once the commands are flushed.
+  glFlush();
+  const int fence = functions.dup_native_fence_fd(display, sync);
+  functions.destroy_sync(display, sync);
+  if (slot->fence >= 0) {
+    close(slot->fence);
+  }
+  slot->fence = fence;
+}
+
+void HardwareFrameQueue::ReleaseGL() {
+  const Functions& functions = GetFunctions();
+  for (Import& import : imports_) {
+    if (import.image != nullptr) {
+      functions.destroy_image(eglGetCurrentDisplay(), import.image);
+    }
+    if (import.texture != 0) {
+      RenderState::DeleteTextures(1, &import.texture);
+    }
+    import = Import();
+  }
+}
+
+void HardwareFrameQueue::InvalidateGL() {
+  // The images belong to the display rather than the context, they are
+  // still destroyed.
+  const Functions& functions = GetFunctions();
+  for (Import& import : imports_) {
+    if (import.image != nullptr) {
+      functions.destroy_image(eglGetDisplay(EGL_DEFAULT_DISPLAY),
+                              import.image);
+    }
+    import = Import();
+  }
+}
+
+}  // namespace tango_gl
@@ -0,0 +1,176 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "tango-gl/image_pool.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <utility>
+
+#include "tango-gl/memory_tracker.h"
+
+namespace tango_gl {
+
+ImagePool::Handle::Handle(const Handle& other)
+    : pool_(other.pool_), slot_(other.slot_) {
+  if (slot_ >= 0) {
+    pool_->AddReference(slot_);
+  }
+}
+
+ImagePool::Handle::Handle(Handle&& other)
+    : pool_(other.pool_), slot_(other.slot_) {
+  other.pool_ = nullptr;
+  other.slot_ = -1;
+}
+
+ImagePool::Handle& ImagePool::Handle::operator=(Handle other) {
+  std::swap(pool_, other.pool_);
+  std::swap(slot_, other.slot_);
+  return *this;
+}
+
+void ImagePool::Handle::Reset() {
+  if (slot_ >= 0) {
+    pool_->Release(slot_);
+  }
+  pool_ = nullptr;
+  slot_ = -1;
+}
+
+ImagePool::ImagePool(size_t max_image_size, size_t memory_budget)
+    : max_image_size_(max_image_size),
+      slot_count_(1),
+      latest_(-1),
+      publish_count_(0) {
+  slot_count_ = static_cast<int>(std::max<size_t>(
+      1, memory_budget / std::max<size_t>(1, max_image_size)));
+  storage_.resize(max_image_size * slot_count_);
+  MemoryTracker::Track(MemoryTracker::kHost, reinterpret_cast<uintptr_t>(this),
+                       "ImagePool", storage_.size());
+  slots_.reset(new Slot[slot_count_]);
+  for (int i = 0; i < slot_count_; ++i) {
+    TangoImageBuffer& buffer = slots_[i].image.buffer;
+    memset(&buffer, 0, sizeof(buffer));
+    buffer.data = storage_.data() + max_image_size * i;
+    slots_[i].image.sequence = 0;
+    slots_[i].references.store(0, std::memory_order_relaxed);
+  }
+}
+
+ImagePool::~ImagePool() {
+  MemoryTracker::Untrack(MemoryTracker::kHost,
+                         reinterpret_cast<uintptr_t>(this));
+  const int latest = latest_.exchange(-1);
+  if (latest >= 0) {
+    Release(latest);
+  }
+  for (int i = 0; i < slot_count_; ++i) {
+    if (slots_[i].references.load() != 0) {
+      LOGE("ImagePool: Destroyed while image %d is still referenced", i);
+    }
+  }
+}
+
+size_t ImagePool::GetImageSize(const TangoImageBuffer& buffer) {
+  const size_t stride = std::max(buffer.stride, buffer.width);
+  switch (buffer.format) {
+    case TANGO_HAL_PIXEL_FORMAT_RGBA_8888:
+      return stride * buffer.height * 4;
+    case TANGO_HAL_PIXEL_FORMAT_YV12:
+    case TANGO_HAL_PIXEL_FORMAT_YCrCb_420_SP:
+      // A full resolution Y plane and two quarter resolution chroma planes.
+      return stride * buffer.height + stride * buffer.height / 2;
+    default:
+      return 0;
+  }
+}
+
+ImagePool::Handle ImagePool::Copy(const TangoImageBuffer& buffer) {
+  const size_t size = GetImageSize(buffer);
+  if (size == 0 || size > max_image_size_) {
+    return Handle();
+  }
+  for (int i = 0; i < slot_count_; ++i) {
+    int unused = 0;
+    if (slots_[i].references.compare_exchange_strong(
+            unused, 1, std::memory_order_acquire)) {
+      TangoImageBuffer& image = slots_[i].image.buffer;
+      uint8_t* data = image.data;
+      image = buffer;
+      image.stride = std::max(buffer.stride, buffer.width);
+      image.data = data;
+      memcpy(data, buffer.data, size);
+      return Handle(this, i);
+    }
+  }
+  return Handle();
+}
+
+void ImagePool::Publish(const Handle& handle) {
+  if (!handle || handle.pool_ != this) {
+    LOGE("ImagePool: Invalid handle to publish");
+    return;
+  }
+  handle->sequence =
+      publish_count_.fetch_add(1, std::memory_order_relaxed) + 1;
+  AddReference(handle.slot_);
+  const int previous =
+      latest_.exchange(handle.slot_, std::memory_order_acq_rel);
+  if (previous >= 0) {
+    Release(previous);
+  }
+}
+
+ImagePool::Handle ImagePool::AcquireLatest() {
+  while (true) {
+    const int slot = latest_.load(std::memory_order_acquire);
+    if (slot < 0) {
+      return Handle();
+    }
+    // The slot may be replaced and recycled between the load and taking the
+    // reference, only keep it if it is still the latest frame afterwards.
+    if (TryAddReference(slot)) {
+      if (latest_.load(std::memory_order_acquire) == slot) {
+        return Handle(this, slot);
+      }
+      Release(slot);
+    }
+  }
+}
+
+void ImagePool::AddReference(int slot) {
+  slots_[slot].references.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool ImagePool::TryAddReference(int slot) {
+  int references = slots_[slot].references.load(std::memory_order_relaxed);
+  while (references > 0) {
+    if (slots_[slot].references.compare_exchange_weak(
+            references, references + 1, std::memory_order_acquire)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void ImagePool::Release(int slot) {
+  slots_[slot].references.fetch_sub(1, std::memory_order_acq_rel);
+}
+
+}  // namespace tango_gl
@@ -0,0 +1,134 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_GL_ANCHOR_FORMAT_H_
+#define TANGO_GL_ANCHOR_FORMAT_H_
+
+#include <stdint.h>
+
+namespace tango_gl {
+namespace anchor {
+
+// Layout of the anchor files of an ADF, written and mapped by AnchorStore.
+//
+// The anchor file, <adf uuid>.anchors, is:
+//
+// - a FileHeader,
+// - bucket_count CellBucket, an open addressing hash table of the grid cells
+//   of cell_size meters holding anchors: the bucket of a cell is found from
+//   HashCellKey(CellKey(x, y, z)) & (bucket_count - 1), probing linearly,
+//   and bucket_count is a power of two,
+// - anchor_count AnchorRecord, ordered by cell so those of a cell are
+//   contiguous, then by id,
+// - anchor_count IdEntry, ordered by id,
+// - payload_size bytes of payloads, referenced by the records.
+//
+// Edits since the anchor file was written go to the journal,
+// <adf uuid>.anchors.journal: a JournalHeader followed by JournalEntry,
+// those of kPut followed by payload_size bytes of payload. Entries are only
+// appended, and replaying them twice leaves the same anchors. All values
+// are little endian.
+
+const uint32_t kMagic = 0x4E414754;         // "TGAN"
+const uint32_t kJournalMagic = 0x4A414754;  // "TGAJ"
+const uint32_t kVersion = 1;
+
+struct FileHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t anchor_count;
+  uint32_t bucket_count;
+  // Edge of a grid cell in meters.
+  float cell_size;
+  uint32_t reserved;
+  uint64_t bucket_offset;
+  uint64_t record_offset;
+  uint64_t id_offset;
+  uint64_t payload_offset;
+  uint64_t payload_size;
+};
+
+struct CellBucket {
+  // CellKey() of the cell, kEmptyCell for an empty bucket.
+  uint64_t key;
+  uint32_t first_record;
+  uint32_t record_count;
+};
+
+struct AnchorRecord {
+  uint64_t id;
+  float position[3];
+  // Quaternion x, y, z, w.
+  float orientation[4];
+  float scale[3];
+  // Offset of the payload from the start of the payloads, and its size.
+  uint32_t payload_offset;
+  uint32_t payload_size;
+  uint32_t reserved[2];
+};
+
+struct IdEntry {
+  uint64_t id;
+  uint32_t record;
+  uint32_t reserved;
+};
+
+struct JournalHeader {
+  uint32_t magic;
+  uint32_t version;
+};
+
+enum JournalOp { kPut = 1, kRemove = 2 };
+
+struct JournalEntry {
+  uint32_t op;
+  uint32_t payload_size;
+  // The anchor put, or only the id of the anchor removed. payload_offset is
+  // not used.
+  AnchorRecord record;
+};
+
+const uint64_t kEmptyCell = ~0ull;
+
+// Cells are keyed by 21 bits per coordinate, so a grid of 2 meter cells
+// spans 2000 km along each axis.
+const int kCellKeyBits = 21;
+const int32_t kCellKeyBias = 1 << (kCellKeyBits - 1);
+const uint64_t kCellKeyMask = (1ull << kCellKeyBits) - 1;
+
+inline uint64_t CellKey(int32_t x, int32_t y, int32_t z) {
+  return (static_cast<uint64_t>(x + kCellKeyBias) & kCellKeyMask) |
+         ((static_cast<uint64_t>(y + kCellKeyBias) & kCellKeyMask)
+          << kCellKeyBits) |
+         ((static_cast<uint64_t>(z + kCellKeyBias) & kCellKeyMask)
+          << (2 * kCellKeyBits));
+}
+
+inline uint64_t HashCellKey(uint64_t key) {
+  key *= 0x9E3779B97F4A7C15ull;
+  return key ^ (key >> 32);
+}
+
+static_assert(sizeof(FileHeader) == 64, "FileHeader layout changed.");
+static_assert(sizeof(CellBucket) == 16, "CellBucket layout changed.");
+static_assert(sizeof(AnchorRecord) == 64, "AnchorRecord layout changed.");
+static_assert(sizeof(IdEntry) == 16, "IdEntry layout changed.");
+static_assert(sizeof(JournalEntry) == 72, "JournalEntry layout changed.");
+
+}  // namespace anchor
+}  // namespace tango_gl
+#endif  // TANGO_GL_ANCHOR_FORMAT_H_
@@ -0,0 +1,190 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_GL_ANCHOR_STORE_H_
+#define TANGO_GL_ANCHOR_STORE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "tango-gl/anchor_format.h"
+#include "tango-gl/util.h"
+
+namespace tango_gl {
+
+// AnchorStore keeps the anchors placed in an ADF, e.g. the transforms of
+// objects the user put in the area, in a binary file per ADF uuid, see
+// anchor_format.h.
+//
+// Open() maps the anchor file and reads nothing else of it, so it takes the
+// same time for ten anchors or a hundred thousand. Anchors are read in
+// place: Find() binary searches the id index, and Query() looks up the grid
+// cells around a position in a hash table, so its cost depends on the radius
+// and on the anchors found, not on the size of the store.
+//
+// Put() and Remove() append an entry to the journal and keep the edit in
+// memory, where it overrides the mapped anchor. Once the journal holds
+// Options::max_journal_entries entries, or on Compact(), the anchors are
+// written to a new anchor file which replaces the old one and the journal is
+// emptied. A torn journal entry, e.g. after the process was killed while
+// writing it, is dropped when the store is opened again.
+//
+// Not thread safe.
+class AnchorStore {
+ public:
+  struct Options {
+    Options() : cell_size(2.0f), max_journal_entries(4096) {}
+
+    // Edge of the grid cells in meters, used when the anchor file is
+    // written. Queries are fastest with a radius around the cell size.
+    float cell_size;
+    // Edits after which the store is compacted.
+    size_t max_journal_entries;
+  };
+
+  struct Anchor {
+    uint64_t id;
+    glm::vec3 position;
+    glm::quat orientation;
+    glm::vec3 scale;
+    // Data of the application, e.g. the kind of object the anchor places.
+    // For anchors read from the store it points into the store, and is
+    // valid until the next edit, Compact() or Close().
+    const void* payload;
+    size_t payload_size;
+  };
+
+  explicit AnchorStore(const Options& options = Options());
+  AnchorStore(const AnchorStore& other) = delete;
+  const AnchorStore& operator=(const AnchorStore&) = delete;
+  ~AnchorStore();
+
+  // Open the anchors of an ADF, creating an empty store if it has none.
+  //
+  // @param directory: directory of the anchor files, e.g. in the app files
+  //        directory.
+  // @param adf_uuid: uuid of the ADF the anchors are in.
+  // @return false if the files could not be opened or are not anchor
+  //         files.
+  bool Open(const std::string& directory, const std::string& adf_uuid);
+
+  // Write the journal out and unmap the store.
+  void Close();
+
+  bool IsOpen() const { return journal_file_ >= 0; }
+
+  // Add an anchor, or replace the anchor with the same id. The payload is
+  // copied.
+  //
+  // @return false if the journal could not be written.
+  bool Put(const Anchor& anchor);
+
+  // Remove an anchor, if stored.
+  //
+  // @return false if the journal could not be written.
+  bool Remove(uint64_t id);
+
+  // Get an anchor by id.
+  //
+  // @return false if no anchor has this id.
+  bool Find(uint64_t id, Anchor* anchor) const;
+
+  // Get the anchors within a distance of a position, e.g. of the device, in
+  // no particular order.
+  //
+  // @param center: position in the ADF frame.
+  // @param radius: distance in meters.
+  // @param anchors: output, cleared first.
+  // @return number of anchors found.
+  size_t Query(const glm::vec3& center, float radius,
+               std::vector<Anchor>* anchors) const;
+
+  // Write every anchor to a new anchor file and empty the journal.
+  //
+  // @return false if the file could not be written, the store is then left
+  //         as it was.
+  bool Compact();
+
+  size_t GetAnchorCount() const { return anchor_count_; }
+
+  // Entries in the journal since the anchor file was written.
+  size_t GetJournalEntryCount() const { return journal_entry_count_; }
+
+ private:
+  // An anchor put or removed since the anchor file was written.
+  struct Edit {
+    anchor::AnchorRecord record;
+    std::string payload;
+    bool is_removed;
+  };
+
+  // Map the anchor file, if any. The store is empty without one.
+  bool MapAnchorFile();
+  void UnmapAnchorFile();
+
+  // Replay the journal into edits_, dropping a torn tail, or start a new
+  // journal.
+  bool ReplayJournal();
+
+  // Apply an edit in memory.
+  void ApplyPut(const anchor::AnchorRecord& record, const void* payload);
+  void ApplyRemove(uint64_t id);
+
+  // Forget the cell of an anchor put.
+  void EraseEditCell(const anchor::AnchorRecord& record);
+
+  // Append an entry to the journal with a single write().
+  bool AppendJournal(const anchor::JournalEntry& entry, const void* payload);
+
+  // Mapped record of an id, nullptr if none.
+  const anchor::AnchorRecord* FindRecord(uint64_t id) const;
+
+  // Whether an id is an anchor of the store, mapped or edited.
+  bool IsStored(uint64_t id) const;
+
+  // Anchor of a mapped record.
+  void GetMappedAnchor(const anchor::AnchorRecord& record,
+                       Anchor* anchor) const;
+
+  Options options_;
+  std::string anchor_path_;
+  std::string journal_path_;
+  int journal_file_;
+  size_t journal_size_;
+  size_t journal_entry_count_;
+
+  // Mapped anchor file, nullptr if the store had none.
+  void* mapping_;
+  size_t mapping_size_;
+  anchor::FileHeader header_;
+  const anchor::CellBucket* buckets_;
+  const anchor::AnchorRecord* records_;
+  const anchor::IdEntry* ids_;
+  const uint8_t* payloads_;
+
+  // Edits by id, and the ids of the anchors put by cell key, in cells of
+  // options_.cell_size.
+  std::unordered_map<uint64_t, Edit> edits_;
+  std::unordered_map<uint64_t, std::vector<uint64_t>> edit_cells_;
+  size_t anchor_count_;
+};
+}  // namespace tango_gl
+#endif  // TANGO_GL_ANCHOR_STORE_H_
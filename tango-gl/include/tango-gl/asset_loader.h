@@ -0,0 +1,165 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_GL_ASSET_LOADER_H_
+#define TANGO_GL_ASSET_LOADER_H_
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "tango-gl/mesh.h"
+#include "tango-gl/obj_loader.h"
+#include "tango-gl/texture.h"
+#include "tango-gl/texture_atlas.h"
+#include "tango-gl/upload_thread.h"
+
+namespace tango_gl {
+
+// AssetLoader keeps file decoding off the GL thread. PNG textures and OBJ
+// meshes are decoded on a background thread, then uploaded on the GL thread
+// from Update() in slices that fit a per frame time budget, so loading a
+// large asset never stalls a frame. Uncompressed textures are uploaded a few
+// rows per slice, compressed ones a mip level per slice. Textures show their
+// placeholder until the last slice is uploaded.
+//
+// Decoded images are staged in a small pool of reused buffers. Meshes go
+// through the obj_loader binary cache and are uploaded in a single slice, so
+// are the sprites of a TextureAtlas.
+//
+// With an UploadThread, textures are instead uploaded whole on that thread
+// and swapped in from its Poll() once the GPU finished them, outside of the
+// Update() budget.
+//
+// All functions must be called on the GL thread. Targets must outlive their
+// load or be passed to Cancel() first.
+class AssetLoader {
+ public:
+  AssetLoader();
+  AssetLoader(const AssetLoader& other) = delete;
+  const AssetLoader& operator=(const AssetLoader&) = delete;
+  ~AssetLoader();
+
+  // Queue loading a KTX, PKM or PNG file into a texture, see
+  // Texture::DecodeFile().
+  //
+  // @param file_path: path of the texture file.
+  // @param texture: target, typically created with Texture().
+  void LoadTexture(const char* file_path, Texture* texture);
+
+  // Queue loading an OBJ file into a mesh, see obj_loader::LoadOBJData().
+  //
+  // @param file_path: path of the OBJ file.
+  // @param with_normals: keep the normals of the file.
+  // @param mesh: target.
+  void LoadMesh(const char* file_path, bool with_normals, Mesh* mesh);
+
+  // Queue loading a PNG file into a sprite of an atlas, see
+  // TextureAtlas::SetImage().
+  //
+  // @param file_path: path of the PNG file.
+  // @param atlas: target, its pending loads are cancelled together.
+  // @param sprite: sprite of the atlas, from TextureAtlas::AddSprite().
+  void LoadSprite(const char* file_path, TextureAtlas* atlas, int sprite);
+
+  // Drop the pending loads of a target.
+  void Cancel(const void* target);
+
+  // Upload the textures on a background thread from now on.
+  //
+  // @param upload_thread: polled by the caller once per frame, it must
+  //        outlive the loader. nullptr to upload from Update() again.
+  void SetUploadThread(UploadThread* upload_thread);
+
+  // Upload decoded assets until the budget is spent. At least one slice is
+  // uploaded per call if one is ready, so loads always make progress.
+  //
+  // @param budget_ms: time budget in milliseconds.
+  void Update(double budget_ms);
+
+  // Number of loads queued, decoding or uploading.
+  size_t GetPendingCount() const;
+
+ private:
+  struct Job {
+    std::string file_path;
+    Texture* texture;
+    Mesh* mesh;
+    TextureAtlas* atlas;
+    int sprite;
+    bool with_normals;
+    bool is_decoded;
+    // Capabilities of the GL context, captured on the GL thread.
+    Texture::Capabilities capabilities;
+    Texture::Image image;
+    obj_loader::MappedMesh mapped_mesh;
+    bool is_allocated;
+    // Next row or mip level to upload.
+    png_uint_32 next_slice;
+    // Texture made by the upload thread, only read once is_uploaded.
+    GLuint uploaded_texture;
+    bool is_uploaded;
+    // Set on the GL thread when the target went away during the upload.
+    bool is_cancelled;
+
+    const void* GetTarget() const {
+      if (texture != nullptr) {
+        return texture;
+      }
+      return mesh != nullptr ? static_cast<const void*>(mesh) : atlas;
+    }
+
+    // Whether the job decodes an image into staging pixels.
+    bool HasImage() const { return texture != nullptr || atlas != nullptr; }
+  };
+
+  void WorkerLoop();
+
+  // Run one upload slice of a job on the GL thread.
+  //
+  // @return true once the job is complete.
+  bool UploadSlice(Job* job);
+
+  // Hand a decoded texture job to the upload thread.
+  void PostUpload(std::unique_ptr<Job> job);
+
+  void RecycleStagingBuffer(std::vector<uint8_t>* buffer);
+
+  std::thread thread_;
+  mutable std::mutex mutex_;
+  std::condition_variable work_available_;
+
+  // Guarded by mutex_.
+  std::deque<std::unique_ptr<Job>> decode_queue_;
+  std::deque<std::unique_ptr<Job>> upload_queue_;
+  const Job* decoding_job_;
+  bool is_decoding_cancelled_;
+  std::vector<std::vector<uint8_t>> staging_buffers_;
+  bool is_stopping_;
+
+  // Only touched on the GL thread.
+  std::unique_ptr<Job> uploading_job_;
+  UploadThread* upload_thread_;
+  // Jobs posted to upload_thread_, until Update() sees them uploaded.
+  std::vector<std::shared_ptr<Job>> background_jobs_;
+};
+}  // namespace tango_gl
+#endif  // TANGO_GL_ASSET_LOADER_H_
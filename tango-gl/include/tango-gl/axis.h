@@ -25,8 +25,9 @@ class Axis : public Line {
   Axis();
   void Render(const glm::mat4& projection_mat, const glm::mat4& view_mat) const;
  private:
+  friend class DrawBatch;
+
   GLuint attrib_colors_;
-  std::vector<glm::vec4> vec_colors_;
 };
 }  // namespace tango_gl
 #endif  // TANGO_GL_AXIS_H_
@@ -17,10 +17,13 @@
 #ifndef TANGO_GL_BAND_H_
 #define TANGO_GL_BAND_H_
 
+#include <stdint.h>
 #include <stdlib.h>
 #include <vector>
 
 #include "tango-gl/drawable_object.h"
+#include "tango-gl/trajectory_store.h"
+#include "tango-gl/vertex_buffer.h"
 
 namespace tango_gl {
 class Band : public DrawableObject {
@@ -32,24 +35,86 @@ class Band : public DrawableObject {
   };
 
   Band(const unsigned int max_legnth);
+  ~Band();
 
   void SetWidth(const float width);
+
+  // Draw the band as a ribbon expanded in the vertex shader: only the
+  // centerline positions are kept, one texel each in a ring texture, and
+  // an update appends one texel. The sides and the arrow head are placed
+  // across the path direction around the up vector, given to
+  // SetVertexArray() and +y by default, so the turn modes have no effect.
+  // Switching clears the band.
+  //
+  // Needs OpenGL ES 3, must be called on the GL thread.
+  //
+  // @return false if the context does not support it, the band then stays
+  //         built on the CPU.
+  bool SetProcedural(bool is_procedural);
+
   // Render a Band with arrow head, pass in the mode for rendering,
   // kKeepLeft is left turn, kKeepRight is right turn,
   // when making a turn, vertices only get updated in one side to avoid overlapping.
+  // Poses passed without a timestamp are keyed by their index.
+  void UpdateVertexArray(double timestamp, const glm::mat4 m, BandMode mode);
   void UpdateVertexArray(const glm::mat4 m, BandMode mode);
   void UpdateVertexArray(const glm::mat4 m);
   void SetVertexArray(const std::vector<glm::vec3>& v, const glm::vec3& up);
   void ClearVertexArray();
+
+  // Re-transform the band added at or after a timestamp, e.g. when the poses
+  // it came from got corrected by a relocalization. The body is corrected in
+  // the background, the arrow head at once.
+  //
+  // @param since_timestamp: oldest timestamp to correct.
+  // @param correction: transformation applied to the band.
+  void Correct(double since_timestamp, const glm::mat4& correction);
+
   void Render(const glm::mat4& projection_mat, const glm::mat4& view_mat) const;
 
  private:
   float band_width_;
-  unsigned int max_length_;
-  std::vector<glm::vec3> vertices_v_;
+  double next_index_key_;
+  // Left and right vertex pairs of the band body.
+  TrajectoryStore body_;
+  mutable TrajectoryBuffers body_buffers_;
+  // Triangle strip joining the band head's pivots to the arrow head.
+  bool has_arrow_;
+  glm::vec3 arrow_vertices_[5];
+  mutable VertexBuffer arrow_buffer_;
+  mutable bool is_arrow_dirty_;
   // Current band head's left and right position in world frame.
   glm::vec3 pivot_left;
   glm::vec3 pivot_right;
+
+  // Append a centerline sample of the procedural ribbon.
+  void AddSample(double timestamp, const glm::vec3& position);
+  void RenderProcedural(const glm::mat4& projection_mat,
+                        const glm::mat4& view_mat) const;
+
+  bool is_procedural_;
+  // Program and sample texture of the procedural ribbon, created by
+  // SetProcedural().
+  GLuint procedural_program_;
+  GLint uniform_ribbon_mvp_mat_;
+  GLint uniform_ribbon_color_;
+  GLint uniform_samples_;
+  GLint uniform_first_;
+  GLint uniform_count_;
+  GLint uniform_capacity_;
+  GLint uniform_half_width_;
+  GLint uniform_up_;
+  GLuint sample_texture_;
+  // Ring of the centerline samples, mirrored in the texture. Sample n is at
+  // n % sample_capacity_, the samples kept are [sample_begin_, sample_end_).
+  size_t sample_capacity_;
+  std::vector<glm::vec4> samples_;
+  std::vector<double> sample_timestamps_;
+  uint64_t sample_begin_;
+  uint64_t sample_end_;
+  // Samples not uploaded yet, from there to sample_end_.
+  mutable uint64_t first_dirty_sample_;
+  glm::vec3 up_;
 };
 }  // namespace tango_gl
 #endif  // TANGO_GL_BAND_H_
@@ -0,0 +1,155 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_GL_BLOCK_STORE_H_
+#define TANGO_GL_BLOCK_STORE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace tango_gl {
+
+// BlockStore keeps blocks of a sparse map, e.g. PointMap or TsdfVolume
+// blocks, on disk while the device is away from them, so a session can map
+// more than fits in memory.
+//
+// Blocks are LZ4 compressed and written into a memory mapped scratch file on
+// a background thread, Write() only copies them. Prefetch() decompresses
+// blocks ahead of Take() on the same thread, so a map can ask for the blocks
+// around the device before it walks into them. The file is allocated in
+// pages, freed runs are reused for blocks of the same page count.
+//
+// The scratch file is unlinked as soon as it is mapped, nothing outlives
+// Close(). When the file is full, blocks stay in memory in the write queue
+// instead.
+//
+// A store belongs to one map, keys are the map's block keys. The functions
+// are thread safe, a map calls them from the thread it is updated on.
+class BlockStore {
+ public:
+  BlockStore();
+  BlockStore(const BlockStore& other) = delete;
+  const BlockStore& operator=(const BlockStore&) = delete;
+  ~BlockStore();
+
+  // Create the scratch file and start the background thread.
+  //
+  // @param path: path of the scratch file, e.g. in the app cache directory.
+  //        An existing file is replaced.
+  // @param capacity: size of the file in bytes, rounded up to a page.
+  // @return false if the file could not be created or mapped.
+  bool Open(const char* path, size_t capacity);
+
+  // Stop the thread and drop every block.
+  void Close();
+
+  bool IsOpen() const { return mapping_ != nullptr; }
+
+  // Drop every block, keeping the file open.
+  void Clear();
+
+  // Store a block, replacing any block with the same key.
+  //
+  // @param key: block key.
+  // @param data: block bytes, copied before returning.
+  // @param size: number of bytes.
+  void Write(uint64_t key, const void* data, size_t size);
+
+  // Whether a block is stored, written or still queued.
+  bool Contains(uint64_t key) const;
+
+  // Queue the decompression of stored blocks, so the Take() that follows
+  // does not read the file. Keys not stored are ignored, and at most
+  // kMaxPrefetchedBlocks blocks are kept decompressed.
+  void Prefetch(const std::vector<uint64_t>& keys);
+
+  // Read a block back and remove it from the store.
+  //
+  // @param key: block key.
+  // @param data: output, size bytes.
+  // @param size: size of the block, as written.
+  // @return false if the block is not stored, or its size does not match.
+  bool Take(uint64_t key, void* data, size_t size);
+
+  // Wait until the queued writes and prefetches are done.
+  void Flush();
+
+  // Number of blocks stored.
+  size_t GetBlockCount() const;
+
+  // Bytes of the file in use, including the unused tail of each run.
+  size_t GetUsedBytes() const;
+
+  // Decompressed blocks kept for Take().
+  static const size_t kMaxPrefetchedBlocks = 256;
+
+ private:
+  struct Record {
+    uint32_t first_page;
+    uint32_t page_count;
+    uint32_t compressed_size;
+    uint32_t size;
+  };
+
+  // Take a run of page_count pages, false if the file is full.
+  bool AllocatePages(uint32_t page_count, uint32_t* first_page);
+  void FreePages(const Record& record);
+
+  // Forget a stored record and the prefetched copy of a key.
+  void EraseRecord(uint64_t key);
+
+  void ThreadLoop();
+
+  int file_;
+  uint8_t* mapping_;
+  size_t mapping_size_;
+
+  std::thread thread_;
+  mutable std::mutex mutex_;
+  std::condition_variable work_available_;
+  std::condition_variable work_done_;
+
+  // Guarded by mutex_.
+  std::unordered_map<uint64_t, Record> records_;
+  // Blocks waiting to be written, by key, and their order.
+  std::unordered_map<uint64_t, std::vector<uint8_t>> pending_writes_;
+  std::deque<uint64_t> write_queue_;
+  // Block being compressed by the thread, readable by Take() meanwhile.
+  // Take() sets in_flight_is_taken_ so the thread drops it.
+  uint64_t in_flight_key_;
+  std::vector<uint8_t> in_flight_data_;
+  bool has_in_flight_;
+  bool in_flight_is_taken_;
+  std::unordered_map<uint64_t, std::vector<uint8_t>> prefetched_;
+  std::deque<uint64_t> prefetch_queue_;
+  // Freed runs by page count, and the first page never used.
+  std::vector<std::vector<uint32_t>> free_runs_;
+  uint32_t page_count_;
+  uint32_t next_page_;
+  size_t used_pages_;
+  bool has_logged_full_;
+  bool is_stopping_;
+};
+}  // namespace tango_gl
+#endif  // TANGO_GL_BLOCK_STORE_H_
@@ -0,0 +1,128 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_GL_BOUNDED_QUEUE_H_
+#define TANGO_GL_BOUNDED_QUEUE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <memory>
+#include <utility>
+
+namespace tango_gl {
+
+// Lock-free bounded multi producer, multi consumer FIFO queue (Dmitry
+// Vyukov's design). Every cell carries a sequence number telling whether it
+// is ready to be written or read in the current lap, so Push() and Pop() are
+// a single compare and swap on the shared position in the common case and
+// never wait for another thread.
+//
+// Values are copied in and out, the queue is meant for small handles such as
+// slot indices.
+template <typename T>
+class BoundedQueue {
+ public:
+  // @param capacity: maximum number of queued values, rounded up to a power
+  //        of two.
+  explicit BoundedQueue(size_t capacity)
+      : enqueue_position_(0), dequeue_position_(0) {
+    const size_t cell_count = GetCellCount(capacity);
+    mask_ = cell_count - 1;
+    cells_.reset(new Cell[cell_count]);
+    for (size_t i = 0; i < cell_count; ++i) {
+      cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+  BoundedQueue(const BoundedQueue& other) = delete;
+  const BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+  // Number of values a queue constructed with capacity holds, at least 2.
+  static size_t GetCellCount(size_t capacity) {
+    size_t cell_count = 2;
+    while (cell_count < capacity) {
+      cell_count *= 2;
+    }
+    return cell_count;
+  }
+
+  // @return: false if the queue is full.
+  bool Push(const T& value) {
+    size_t position = enqueue_position_.load(std::memory_order_relaxed);
+    Cell* cell;
+    while (true) {
+      cell = &cells_[position & mask_];
+      const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+      const intptr_t difference =
+          static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+      if (difference == 0) {
+        if (enqueue_position_.compare_exchange_weak(
+                position, position + 1, std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (difference < 0) {
+        return false;
+      } else {
+        position = enqueue_position_.load(std::memory_order_relaxed);
+      }
+    }
+    cell->value = value;
+    cell->sequence.store(position + 1, std::memory_order_release);
+    return true;
+  }
+
+  // @return: false if the queue is empty.
+  bool Pop(T* value) {
+    size_t position = dequeue_position_.load(std::memory_order_relaxed);
+    Cell* cell;
+    while (true) {
+      cell = &cells_[position & mask_];
+      const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+      const intptr_t difference = static_cast<intptr_t>(sequence) -
+                                  static_cast<intptr_t>(position + 1);
+      if (difference == 0) {
+        if (dequeue_position_.compare_exchange_weak(
+                position, position + 1, std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (difference < 0) {
+        return false;
+      } else {
+        position = dequeue_position_.load(std::memory_order_relaxed);
+      }
+    }
+    // Moved out, so the cell does not keep e.g. a reference counted handle
+    // alive until it is overwritten.
+    *value = std::move(cell->value);
+    cell->sequence.store(position + mask_ + 1, std::memory_order_release);
+    return true;
+  }
+
+ private:
+  struct Cell {
+    std::atomic<size_t> sequence;
+    T value;
+  };
+
+  std::unique_ptr<Cell[]> cells_;
+  size_t mask_;
+  std::atomic<size_t> enqueue_position_;
+  std::atomic<size_t> dequeue_position_;
+};
+}  // namespace tango_gl
+#endif  // TANGO_GL_BOUNDED_QUEUE_H_
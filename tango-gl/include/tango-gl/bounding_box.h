@@ -17,6 +17,7 @@
 #ifndef TANGO_GL_BOUNDING_BOX_H_
 #define TANGO_GL_BOUNDING_BOX_H_
 
+#include <stdint.h>
 #include <vector>
 
 #include "tango-gl/segment.h"
@@ -30,13 +31,72 @@ class BoundingBox {
   BoundingBox(const std::vector<float>& vertices);
   BoundingBox(const glm::vec3& min, const glm::vec3& max)
       : bounding_min_(min), bounding_max_(max) {}
+
+  // Exact test of a segment against the box placed by a model matrix. The
+  // segment is moved into the box's frame instead of the box into the world,
+  // so rotated boxes are not approximated by a world aligned box.
+  //
+  // @param segment: segment in world frame.
+  // @param rotation: unused, the rotation is part of the transformation. Kept
+  //        for existing callers.
+  // @param transformation: model matrix of the box, must be invertible.
   bool IsIntersecting(const Segment& segment, const glm::quat& rotation,
-                      const glm::mat4& transformation);
+                      const glm::mat4& transformation) const;
+
+  const glm::vec3& GetMin() const { return bounding_min_; }
+  const glm::vec3& GetMax() const { return bounding_max_; }
 
  private:
   // Axis-aligned bounding box minimum and maximum point.
   glm::vec3 bounding_min_;
   glm::vec3 bounding_max_;
 };
+
+// BoundingBoxBatch tests one segment against many placed boxes, e.g. for tap
+// to select over all meshes of a scene. Bounds and world-to-box transforms are
+// kept in structure of arrays layout, so the per box loop streams through
+// contiguous arrays and allocates nothing.
+class BoundingBoxBatch {
+ public:
+  BoundingBoxBatch() : size_(0) {}
+
+  // Add a box with its model matrix, which must be invertible.
+  //
+  // @return: index of the box.
+  size_t Add(const BoundingBox& box, const glm::mat4& transformation);
+
+  // Update the model matrix of a box.
+  void SetTransformation(size_t index, const glm::mat4& transformation);
+
+  void Clear();
+  size_t GetSize() const { return size_; }
+
+  // Test the segment against every box.
+  //
+  // @param segment: segment in world frame.
+  // @param hits: set to 1 for the boxes hit, 0 otherwise, resized to the
+  //        batch size.
+  void Intersect(const Segment& segment, std::vector<uint8_t>* hits) const;
+
+  // Find the box the segment enters first.
+  //
+  // @param segment: segment in world frame.
+  // @param segment_t: if not null, set to the entry point along the segment,
+  //        0 at its start and 1 at its end.
+  //
+  // @return: index of the box, -1 if no box is hit.
+  int FindNearest(const Segment& segment, float* segment_t) const;
+
+ private:
+  // Entry and exit of the segment for box i, entry > exit on a miss.
+  void ClipSegment(const Segment& segment, size_t i, float* entry,
+                   float* exit) const;
+
+  size_t size_;
+  std::vector<float> min_[3];
+  std::vector<float> max_[3];
+  // Row r of the world-to-box affine transform, r = 0..2, column c = 0..3.
+  std::vector<float> box_T_world_[3][4];
+};
 }  // namespace tango_gl
 #endif  // TANGO_GL_BOUNDING_BOX_H_
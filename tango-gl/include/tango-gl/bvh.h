@@ -0,0 +1,203 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_GL_BVH_H_
+#define TANGO_GL_BVH_H_
+
+#include <stdint.h>
+
+#include <functional>
+#include <vector>
+
+#include "tango-gl/bounding_box.h"
+#include "tango-gl/segment.h"
+#include "tango-gl/util.h"
+
+namespace tango_gl {
+
+// Bvh is a bounding volume hierarchy over axis aligned primitive bounds, for
+// finding what a segment hits without testing every primitive. Nodes are
+// split at the median of the longest axis, so the depth stays logarithmic in
+// the primitive count. Bounds of moved primitives can be refit without a
+// rebuild, at the cost of looser nodes over time.
+//
+// Segment positions are parametrized from 0 at the start to 1 at the end.
+class Bvh {
+ public:
+  // Exact test of a primitive whose bounds the segment enters.
+  //
+  // @param primitive: index of the primitive in the bounds passed to Build().
+  // @param max_t: nearest hit found so far, hits beyond it can be ignored.
+  // @param t: set to the hit position along the segment on a hit.
+  //
+  // @return: true on a hit nearer than max_t.
+  typedef std::function<bool(uint32_t primitive, float max_t, float* t)>
+      IntersectFunction;
+
+  Bvh() {}
+
+  // Build the hierarchy over primitive bounds, replacing the previous one.
+  //
+  // @param bounds_min: minimum corner per primitive.
+  // @param bounds_max: maximum corner per primitive.
+  void Build(const std::vector<glm::vec3>& bounds_min,
+             const std::vector<glm::vec3>& bounds_max);
+
+  // Update the bounds of a primitive and of the nodes above it.
+  void Refit(uint32_t primitive, const glm::vec3& bounds_min,
+             const glm::vec3& bounds_max);
+
+  // Find the nearest primitive hit by a segment.
+  //
+  // @param segment: segment in the frame of the primitive bounds.
+  // @param intersect: exact test of a candidate primitive.
+  // @param t: if not null, set to the hit position along the segment.
+  //
+  // @return: index of the hit primitive, -1 if nothing is hit.
+  int Raycast(const Segment& segment, const IntersectFunction& intersect,
+              float* t) const;
+
+  uint32_t GetPrimitiveCount() const {
+    return static_cast<uint32_t>(leaf_of_primitive_.size());
+  }
+
+ private:
+  struct Node {
+    glm::vec3 bounds_min;
+    glm::vec3 bounds_max;
+    // Interior nodes: index of the right child, the left one follows the
+    // node. Leaves: first entry in primitives_.
+    uint32_t right_or_first;
+    // Primitives in a leaf, 0 for interior nodes.
+    uint32_t count;
+    uint32_t parent;
+  };
+
+  uint32_t BuildNode(uint32_t parent, uint32_t begin, uint32_t end,
+                     const std::vector<glm::vec3>& centers);
+
+  void UpdateLeafBounds(uint32_t node);
+
+  std::vector<Node> nodes_;
+  // Primitive indices ordered by leaf.
+  std::vector<uint32_t> primitives_;
+  std::vector<uint32_t> leaf_of_primitive_;
+  std::vector<glm::vec3> primitive_min_;
+  std::vector<glm::vec3> primitive_max_;
+};
+
+// MeshBvh finds the exact triangle a segment hits on a triangle mesh, in the
+// mesh's own frame.
+class MeshBvh {
+ public:
+  MeshBvh() {}
+  MeshBvh(const MeshBvh& other) = delete;
+  const MeshBvh& operator=(const MeshBvh&) = delete;
+
+  // Build over a triangle list.
+  //
+  // @param vertices: packed x, y, z positions.
+  // @param indices: three per triangle, empty if the vertices are a plain
+  //        triangle list.
+  void Build(const std::vector<GLfloat>& vertices,
+             const std::vector<GLushort>& indices);
+
+  // Find the nearest triangle hit by a segment.
+  //
+  // @param segment: segment in the mesh frame.
+  // @param t: if not null, set to the hit position along the segment.
+  //
+  // @return: index of the hit triangle, -1 if nothing is hit.
+  int Raycast(const Segment& segment, float* t) const;
+
+  size_t GetTriangleCount() const { return triangles_.size(); }
+
+ private:
+  struct Triangle {
+    glm::vec3 a;
+    glm::vec3 b;
+    glm::vec3 c;
+  };
+
+  std::vector<Triangle> triangles_;
+  Bvh bvh_;
+};
+
+// ObjectBvh picks among placed objects, e.g. the drawables of a scene on a
+// tap. Each object has bounds in its own frame and a model matrix. Objects
+// are tested exactly as oriented boxes, or against their triangles when a
+// MeshBvh is attached.
+class ObjectBvh {
+ public:
+  ObjectBvh() : is_built_(false) {}
+  ObjectBvh(const ObjectBvh& other) = delete;
+  const ObjectBvh& operator=(const ObjectBvh&) = delete;
+
+  // Add an object.
+  //
+  // @param box: bounds in the object frame.
+  // @param transformation: model matrix, must be invertible.
+  // @param mesh: optional triangles in the object frame for exact hits, not
+  //        owned, has to outlive this ObjectBvh.
+  //
+  // @return: index of the object.
+  uint32_t Add(const BoundingBox& box, const glm::mat4& transformation,
+               const MeshBvh* mesh = nullptr);
+
+  // Move an object, its node bounds are refit on the next Update().
+  void SetTransformation(uint32_t object, const glm::mat4& transformation);
+
+  void Clear();
+
+  // Build the hierarchy after objects were added, refit it after objects
+  // moved. Pick() calls it as needed.
+  void Update();
+
+  // Rebuild the hierarchy from scratch, e.g. after many objects moved far.
+  void Rebuild();
+
+  // Find the nearest object hit by a segment.
+  //
+  // @param segment: segment in world frame.
+  // @param hit_point: if not null, set to the hit point in world frame.
+  //
+  // @return: index of the hit object, -1 if nothing is hit.
+  int Pick(const Segment& segment, glm::vec3* hit_point);
+
+ private:
+  struct Object {
+    BoundingBox box;
+    glm::mat4 transformation;
+    glm::mat4 object_T_world;
+    const MeshBvh* mesh;
+    bool is_dirty;
+  };
+
+  // World aligned bounds of an object's box.
+  static void GetWorldBounds(const Object& object, glm::vec3* bounds_min,
+                             glm::vec3* bounds_max);
+
+  bool IntersectObject(uint32_t object, const Segment& segment, float max_t,
+                       float* t) const;
+
+  std::vector<Object> objects_;
+  std::vector<uint32_t> dirty_objects_;
+  bool is_built_;
+  Bvh bvh_;
+};
+}  // namespace tango_gl
+#endif  // TANGO_GL_BVH_H_
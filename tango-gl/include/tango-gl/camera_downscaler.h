@@ -0,0 +1,130 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_GL_CAMERA_DOWNSCALER_H_
+#define TANGO_GL_CAMERA_DOWNSCALER_H_
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "tango-gl/pixel_readback.h"
+#include "tango-gl/util.h"
+#include "tango-gl/vertex_buffer.h"
+
+namespace tango_gl {
+
+// CameraDownscaler hands small copies of the camera image to computer vision
+// code, taken from the external texture filled by
+// TangoService_connectTextureId() instead of the NV21 buffers of
+// TangoService_connectOnFrameAvailable(), which cost a full frame memcpy on
+// the callback thread.
+//
+// Each Update() samples the camera texture once into a low resolution
+// target, grayscale or RGBA, and queues a PixelReadback of it: the image
+// comes out a few frames later, by the time the GPU has finished it, and
+// the GL thread never waits. Grayscale pixels are packed 4 to an RGBA
+// texel, so the target and the read are a quarter of the RGBA ones.
+//
+// Each output pixel averages 4 taps of the camera texture, a quarter of a
+// pixel around its center, so downscales of up to 4 are box filtered when
+// the texture is linearly filtered; the camera texture keeps the filtering
+// of its owner.
+//
+// The images are only valid during the callback of GetImages(); copy them,
+// or use GetImage(), to hand them to a worker.
+//
+// All functions must be called on the GL thread.
+class CameraDownscaler {
+ public:
+  enum Format {
+    // One byte per pixel, the BT.601 luma like the Y plane of NV21.
+    kGray,
+    // Four bytes per pixel.
+    kRgba
+  };
+
+  // Receives an image: GetWidth() * GetHeight() pixels of
+  // GetBytesPerPixel() bytes, rows in the order of the camera image, top
+  // first.
+  typedef PixelReadback::PixelsCallback ImageCallback;
+
+  // @param format: format of the images.
+  // @param width, height: size of the images in pixels, the width of gray
+  //        images is rounded up to a multiple of 4.
+  CameraDownscaler(Format format, GLsizei width, GLsizei height);
+  CameraDownscaler(const CameraDownscaler& other) = delete;
+  const CameraDownscaler& operator=(const CameraDownscaler&) = delete;
+  ~CameraDownscaler();
+
+  // Queue the downscale of the current camera image. Restores the viewport
+  // and binds framebuffer 0 before returning.
+  //
+  // @param camera_texture: GL_TEXTURE_EXTERNAL_OES texture of the camera.
+  // @param timestamp: camera timestamp of the texture image.
+  void Update(GLuint camera_texture, double timestamp);
+
+  // Hand the completed images to a callback, oldest first, without copying
+  // them.
+  //
+  // @return the number of images handed out.
+  int GetImages(const ImageCallback& callback);
+
+  // Get the oldest completed image.
+  //
+  // @param timestamp: set to the camera timestamp of the image.
+  // @param pixels: resized to the image and filled with its pixels.
+  //
+  // @return false if no image has completed since the last call.
+  bool GetImage(double* timestamp, std::vector<uint8_t>* pixels);
+
+  Format GetFormat() const { return format_; }
+  GLsizei GetWidth() const { return width_; }
+  GLsizei GetHeight() const { return height_; }
+  int GetBytesPerPixel() const { return format_ == kGray ? 1 : 4; }
+
+  // Release the GL objects and drop pending images.
+  void Release();
+
+  // Forget the GL objects without deleting them. Use this when the GL
+  // context they belonged to has been destroyed.
+  void Invalidate();
+
+ private:
+  // Create the target and program if needed.
+  bool Allocate();
+
+  Format format_;
+  GLsizei width_;
+  GLsizei height_;
+  // Size of the target, a quarter of the width for gray images.
+  GLsizei target_width_;
+
+  GLuint framebuffer_;
+  GLuint texture_;
+  bool is_unsupported_;
+
+  GLuint program_;
+  GLint attrib_vertices_;
+  GLint uniform_offset_;
+  GLint uniform_pixel_width_;
+  VertexBuffer vertex_buffer_;
+
+  PixelReadback readback_;
+};
+}  // namespace tango_gl
+#endif  // TANGO_GL_CAMERA_DOWNSCALER_H_
@@ -0,0 +1,155 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_GL_CAMERA_INTRINSICS_REGISTRY_H_
+#define TANGO_GL_CAMERA_INTRINSICS_REGISTRY_H_
+
+#include <stdint.h>
+
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include <tango_client_api.h>  // NOLINT
+
+#include "tango-gl/ray_table.h"
+#include "tango-gl/util.h"
+
+namespace tango_gl {
+
+// CameraIntrinsicsRegistry caches the intrinsics of the device cameras and
+// what is derived from them. The intrinsics of a camera are queried from the
+// Tango service the first time they are asked for after Clear(), and every
+// projection matrix and distortion map is computed once per camera and
+// parameters. Call Clear() when connecting to the service.
+//
+// All functions are thread safe. Returned pointers stay valid until Clear()
+// or SetIntrinsics() for the same camera.
+class CameraIntrinsicsRegistry {
+ public:
+  // Distorted image positions sampled on a regular grid over the undistorted
+  // pinhole image of the same size and intrinsics.
+  struct DistortionMap {
+    uint32_t grid_width;
+    uint32_t grid_height;
+    // Row major, grid_width * grid_height texture coordinates into the
+    // distorted camera image, (0, 0) at the top left of the image. Sample
+    // (i, j) is for the undistorted texture coordinate
+    // (i / (grid_width - 1), j / (grid_height - 1)).
+    std::vector<glm::vec2> texture_coords;
+  };
+
+  CameraIntrinsicsRegistry() {}
+  CameraIntrinsicsRegistry(const CameraIntrinsicsRegistry& other) = delete;
+  const CameraIntrinsicsRegistry& operator=(const CameraIntrinsicsRegistry&) =
+      delete;
+
+  // Forget all cached intrinsics, the next Get functions query the service
+  // again.
+  void Clear();
+
+  // Provide the intrinsics instead of querying, e.g. from a recording.
+  void SetIntrinsics(const TangoCameraIntrinsics& intrinsics);
+
+  // Get the intrinsics of a camera, must be called after
+  // TangoService_connect() if they are not cached yet.
+  //
+  // @return TANGO_SUCCESS, or the error of the query, in which case it is
+  //         queried again on the next call.
+  TangoErrorType GetIntrinsics(TangoCameraId camera,
+                               TangoCameraIntrinsics* intrinsics);
+
+  // Get the OpenGL projection matrix of a camera, see
+  // Camera::ProjectionMatrixForCameraIntrinsics().
+  //
+  // @param viewport_width, viewport_height: size of the viewport the camera
+  //        image fills. If its aspect ratio differs from the image's, the
+  //        image is cropped around its center to the viewport's ratio. 0 for
+  //        a viewport matching the image.
+  // @param near, far: clip planes.
+  // @param projection: set to the projection matrix.
+  //
+  // @return error of the intrinsics query, see GetIntrinsics().
+  TangoErrorType GetProjectionMatrix(TangoCameraId camera, int viewport_width,
+                                     int viewport_height, float near,
+                                     float far, glm::mat4* projection);
+
+  // Get the map from undistorted to distorted image positions of a camera,
+  // for undistorting its images on the GPU.
+  //
+  // @param grid_width, grid_height: number of samples per row and column, at
+  //        least 2.
+  //
+  // @return the map, nullptr if the intrinsics query failed.
+  const DistortionMap* GetDistortionMap(TangoCameraId camera,
+                                        uint32_t grid_width,
+                                        uint32_t grid_height);
+
+  // Get the table of the rays through the pixels of a camera's raw images,
+  // lens distortion undone, see RayTable.
+  //
+  // @param pixel_center: see RayTable::Build().
+  //
+  // @return the table, nullptr if the intrinsics query failed.
+  const RayTable* GetRayTable(TangoCameraId camera, float pixel_center);
+
+  // Apply the distortion model of the intrinsics to an undistorted position
+  // on the normalized image plane, (X / Z, Y / Z).
+  static glm::vec2 Distort(const TangoCameraIntrinsics& intrinsics,
+                           const glm::vec2& normalized_position);
+
+  // Inverse of Distort(): the undistorted position on the normalized image
+  // plane of a distorted one. Closed form for the equidistant model,
+  // iterated for the polynomial ones.
+  static glm::vec2 Undistort(const TangoCameraIntrinsics& intrinsics,
+                             const glm::vec2& distorted_position);
+
+  // Whether the intrinsics have a distortion model with a non zero
+  // coefficient.
+  static bool HasDistortion(const TangoCameraIntrinsics& intrinsics);
+
+ private:
+  struct Projection {
+    int viewport_width;
+    int viewport_height;
+    float near;
+    float far;
+    glm::mat4 matrix;
+  };
+
+  struct Entry {
+    Entry() : has_intrinsics(false), intrinsics() {}
+
+    bool has_intrinsics;
+    TangoCameraIntrinsics intrinsics;
+    std::vector<Projection> projections;
+    std::vector<std::unique_ptr<DistortionMap>> distortion_maps;
+    std::vector<std::pair<float, std::unique_ptr<RayTable>>> ray_tables;
+  };
+
+  // Get the entry of a camera with its intrinsics queried, with mutex_ held.
+  //
+  // @return nullptr if the camera is invalid or the query failed, *ret is set
+  //         to the error.
+  Entry* GetEntry(TangoCameraId camera, TangoErrorType* ret);
+
+  std::mutex mutex_;
+  Entry entries_[TANGO_MAX_CAMERA_ID];
+};
+}  // namespace tango_gl
+#endif  // TANGO_GL_CAMERA_INTRINSICS_REGISTRY_H_
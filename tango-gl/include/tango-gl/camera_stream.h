@@ -0,0 +1,117 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_GL_CAMERA_STREAM_H_
+#define TANGO_GL_CAMERA_STREAM_H_
+
+#include <stdint.h>
+
+#include <atomic>
+#include <vector>
+
+#include <tango_client_api.h>  // NOLINT
+
+#include "tango-gl/luminance_pyramid.h"
+#include "tango-gl/triple_buffer.h"
+
+namespace tango_gl {
+
+// CameraStream hands the frames of one camera from its onFrameAvailable
+// callback to the GL thread, so an app can run several cameras side by side,
+// e.g. the color camera and the fisheye camera, each with its own stream.
+//
+// Every stream has a budget: the frame format it keeps and the most frames
+// per second it copies. Frames over the budget are dropped in the callback
+// before any byte is copied, and a luminance stream copies only the Y plane,
+// a third less than the full image and with no chroma to convert, for
+// grayscale consumers like a wide angle monitor.
+//
+// A stream can also build a luminance pyramid of every kept frame, so the
+// vision code tracking markers or features in it shares one set of
+// downsampled images instead of building its own.
+//
+// One producer thread and one consumer thread, see TripleBuffer.
+class CameraStream {
+ public:
+  enum Format {
+    // The full NV21 image, a Y plane followed by interleaved VU rows.
+    kNV21,
+    // The Y plane only, a GL_LUMINANCE image. Accepts NV21 and YV12 frames.
+    kLuminance
+  };
+
+  struct Options {
+    Options() : format(kNV21), max_frame_rate(0.0), pyramid_level_count(0) {}
+
+    Format format;
+    // Most frames per second copied, 0 copies every frame.
+    double max_frame_rate;
+    // Levels of Frame::pyramid built, including the Y plane, 0 builds none.
+    // See LuminancePyramid::kMaxLevelCount.
+    int pyramid_level_count;
+  };
+
+  // A tightly packed frame.
+  struct Frame {
+    Frame() : width(0), height(0), timestamp(0.0) {}
+
+    std::vector<uint8_t> data;
+    int width;
+    int height;
+    double timestamp;
+    // Built from the Y plane of data if Options::pyramid_level_count is set,
+    // level 0 is the Y plane in data.
+    LuminancePyramid pyramid;
+  };
+
+  CameraStream(TangoCameraId camera, const Options& options);
+  CameraStream(const CameraStream& other) = delete;
+  const CameraStream& operator=(const CameraStream&) = delete;
+
+  TangoCameraId GetCameraId() const { return camera_; }
+  const Options& GetOptions() const { return options_; }
+
+  // Producer side. Copy a frame of the camera and publish it, unless it is
+  // over the frame rate budget or of a format the stream cannot keep.
+  //
+  // @return true if the frame was published.
+  bool OnFrameAvailable(const TangoImageBuffer* buffer);
+
+  // Consumer side. Acquire the latest published frame.
+  //
+  // @param is_new_frame: set to true if the frame was not returned before.
+  // @return the current frame, nullptr if no frame has arrived yet.
+  const Frame* Acquire(bool* is_new_frame);
+
+  // Frames published and dropped over the budget so far, from any thread.
+  uint64_t GetPublishedFrameCount() const { return published_count_; }
+  uint64_t GetDroppedFrameCount() const { return dropped_count_; }
+
+ private:
+  const TangoCameraId camera_;
+  const Options options_;
+
+  TripleBuffer<Frame> frames_;
+
+  // Only touched by the producer.
+  double last_timestamp_;
+
+  std::atomic<uint64_t> published_count_;
+  std::atomic<uint64_t> dropped_count_;
+};
+}  // namespace tango_gl
+#endif  // TANGO_GL_CAMERA_STREAM_H_
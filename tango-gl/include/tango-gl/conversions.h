@@ -22,6 +22,7 @@
 #include "glm/glm.hpp"
 #include "glm/gtc/matrix_transform.hpp"
 #include "glm/gtc/quaternion.hpp"
+#include "tango-gl/rigid_transform.h"
 
 namespace tango_gl {
 namespace conversions {
@@ -44,17 +45,16 @@ inline glm::quat QuatFromArray(const double* array) {
 }
 
 /**
- * @brief Creates a glm::mat4 rigid-frame transformation matrix from two arrays.
- * This is designed for the TangoPoseData translation and orientation fields.
+ * @brief Creates a rigid-frame transformation from two arrays. This is
+ * designed for the TangoPoseData translation and orientation fields.
  * @param A_p_B Position [x, y, z] of B_origin from A_origin, expressed in A.
  * @param A_q_B The quaternion representation [x, y, z, w] of the rotation
  * matrix A_R_B.
- * @return The transformation matrix A_T_B.
+ * @return The transformation A_T_B, use ToMatrix() for the glm::mat4.
  */
-inline glm::mat4 TransformFromArrays(const double* A_p_B, const double* A_q_B) {
-  glm::vec3 glm_A_p_B = Vec3FromArray(A_p_B);
-  glm::quat glm_A_q_B = QuatFromArray(A_q_B);
-  return glm::translate(glm::mat4(1.0f), glm_A_p_B) * glm::mat4_cast(glm_A_q_B);
+inline RigidTransform TransformFromArrays(const double* A_p_B,
+                                          const double* A_q_B) {
+  return RigidTransform(QuatFromArray(A_q_B), Vec3FromArray(A_p_B));
 }
 
 /**
@@ -107,6 +107,130 @@ inline glm::vec3 Vec3GlToTango(const glm::vec3& gl_vec) {
 glm::quat QuatTangoToGl(const glm::quat& tango_q_any);
 
 /**
+ * @brief A rotation that only permutes and negates axes, like the fixed
+ * transformations between the Tango and OpenGL frame conventions below. It is
+ * resolved at compile time: applying it to a vector or multiplying it with a
+ * matrix is a swizzle instead of a full matrix multiply, and products and
+ * inverses of permutations are permutation types themselves.
+ *
+ * Each parameter names the input axis an output axis is taken from, 1 for X,
+ * 2 for Y and 3 for Z, negated to flip its sign. AxisPermutation<1, 3, -2>
+ * maps (x, y, z) to (x, z, -y).
+ */
+template <int X, int Y, int Z>
+struct AxisPermutation {
+  static_assert(X != 0 && Y != 0 && Z != 0 && X >= -3 && X <= 3 &&
+                    Y >= -3 && Y <= 3 && Z >= -3 && Z <= 3 &&
+                    X != Y && X != -Y && X != Z && X != -Z && Y != Z &&
+                    Y != -Z,
+                "AxisPermutation needs each of the three axes once.");
+
+  // Signed input axis of output axis i.
+  static constexpr int Axis(int i) { return i == 0 ? X : (i == 1 ? Y : Z); }
+
+  // Signed output axis input axis j goes to.
+  static constexpr int InverseAxis(int j) {
+    return (X == j + 1 || X == -j - 1)
+               ? (X > 0 ? 1 : -1)
+               : ((Y == j + 1 || Y == -j - 1) ? (Y > 0 ? 2 : -2)
+                                              : (Z > 0 ? 3 : -3));
+  }
+
+  typedef AxisPermutation<InverseAxis(0), InverseAxis(1), InverseAxis(2)>
+      Inverse;
+
+  glm::mat4 ToMatrix() const;
+};
+
+namespace internal {
+// Component |axis| of v, negated if axis is negative.
+template <int kAxis, typename Vector>
+inline typename Vector::value_type SignedComponent(const Vector& v) {
+  return kAxis > 0 ? v[kAxis - 1] : -v[-kAxis - 1];
+}
+
+// Column |axis| of m, negated if axis is negative.
+template <int kAxis>
+inline glm::vec4 SignedColumn(const glm::mat4& m) {
+  return kAxis > 0 ? m[kAxis - 1] : -m[-kAxis - 1];
+}
+
+// Signed axis of the product, the axis of b picked by a, signed by both.
+template <typename A, typename B>
+constexpr int ProductAxis(int i) {
+  return A::Axis(i) > 0 ? B::Axis(A::Axis(i) - 1) : -B::Axis(-A::Axis(i) - 1);
+}
+}  // namespace internal
+
+template <int X, int Y, int Z>
+inline glm::vec3 operator*(AxisPermutation<X, Y, Z>, const glm::vec3& v) {
+  return glm::vec3(internal::SignedComponent<X>(v),
+                   internal::SignedComponent<Y>(v),
+                   internal::SignedComponent<Z>(v));
+}
+
+template <int X, int Y, int Z>
+inline glm::vec4 operator*(AxisPermutation<X, Y, Z>, const glm::vec4& v) {
+  return glm::vec4(internal::SignedComponent<X>(v),
+                   internal::SignedComponent<Y>(v),
+                   internal::SignedComponent<Z>(v), v.w);
+}
+
+// R * m permutes the rows of m.
+template <int X, int Y, int Z>
+inline glm::mat4 operator*(AxisPermutation<X, Y, Z> r, const glm::mat4& m) {
+  return glm::mat4(r * m[0], r * m[1], r * m[2], r * m[3]);
+}
+
+// m * R permutes the columns of m.
+template <int X, int Y, int Z>
+inline glm::mat4 operator*(const glm::mat4& m, AxisPermutation<X, Y, Z>) {
+  typedef AxisPermutation<X, Y, Z> Permutation;
+  return glm::mat4(
+      internal::SignedColumn<Permutation::InverseAxis(0)>(m),
+      internal::SignedColumn<Permutation::InverseAxis(1)>(m),
+      internal::SignedColumn<Permutation::InverseAxis(2)>(m), m[3]);
+}
+
+template <int X1, int Y1, int Z1, int X2, int Y2, int Z2>
+inline AxisPermutation<
+    internal::ProductAxis<AxisPermutation<X1, Y1, Z1>,
+                          AxisPermutation<X2, Y2, Z2>>(0),
+    internal::ProductAxis<AxisPermutation<X1, Y1, Z1>,
+                          AxisPermutation<X2, Y2, Z2>>(1),
+    internal::ProductAxis<AxisPermutation<X1, Y1, Z1>,
+                          AxisPermutation<X2, Y2, Z2>>(2)>
+operator*(AxisPermutation<X1, Y1, Z1>, AxisPermutation<X2, Y2, Z2>) {
+  return {};
+}
+
+template <int X, int Y, int Z>
+inline typename AxisPermutation<X, Y, Z>::Inverse Inverse(
+    AxisPermutation<X, Y, Z>) {
+  return {};
+}
+
+template <int X, int Y, int Z>
+inline glm::mat4 AxisPermutation<X, Y, Z>::ToMatrix() const {
+  return *this * glm::mat4(1.0f);
+}
+
+/**
+ * The opengl world frame convention (with Y-up, X-right) with respect to the
+ * tango convention for the start-of-service and ADF frames (with Z-up,
+ * X-right). Applies as Vec3TangoToGl().
+ */
+typedef AxisPermutation<1, 3, -2> OpenGlWorldTTangoWorld;
+
+/**
+ * A camera frame convention of the device (with Z-forward, X-right) with
+ * respect to the opengl camera convention (with Z-backward, X-right).
+ */
+typedef AxisPermutation<1, -2, -3> CameraTOpenGlCamera;
+
+/**
+ * Matrix forms of the permutations above, for code that stores them.
+ *
  * Get the fixed transformation matrix relating the opengl frame convention
  * (with Y-up, X-right) and the tango frame convention for the start-of-service
  * and ADF frames (with Z-up, X-right), termed "world" here.
@@ -0,0 +1,118 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_GL_CORNER_DETECTOR_H_
+#define TANGO_GL_CORNER_DETECTOR_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include "tango-gl/luminance_pyramid.h"
+
+namespace tango_gl {
+
+// CornerDetector finds FAST-9 corners in the levels of a LuminancePyramid.
+//
+// A pixel is a corner if 9 contiguous pixels of the 16 on the radius 3 circle
+// around it are all brighter than the pixel plus the threshold, or all darker
+// than the pixel minus the threshold. Its score is the sum of the differences
+// over the threshold on the qualifying side. Corners are kept if no
+// neighbour scores higher, then the level is split in square cells and only
+// the best scoring corners of each cell are returned, so the feature count
+// stays bounded and spread out whatever the texture.
+//
+// Regions of interest restrict the search to the cells they overlap, e.g.
+// around the anchors being tracked. The corner test runs 16 pixels at a time
+// on NEON, selected at runtime, with the same result as the scalar path.
+class CornerDetector {
+ public:
+  struct Options {
+    Options() : threshold(20), cell_size(32), max_corners_per_cell(2) {}
+
+    // Intensity difference of the circle pixels, in [1, 255].
+    int threshold;
+    // Side of a bucketing cell in pixels of the searched level.
+    int cell_size;
+    // Best scoring corners kept per cell.
+    int max_corners_per_cell;
+  };
+
+  // A rectangle in level 0 pixels.
+  struct Roi {
+    int x;
+    int y;
+    int width;
+    int height;
+  };
+
+  struct Corner {
+    // Position in level 0 pixels, the center of the footprint of the corner
+    // pixel of its level.
+    float x;
+    float y;
+    int level;
+    int score;
+  };
+
+  explicit CornerDetector(const Options& options);
+  CornerDetector(const CornerDetector& other) = delete;
+  const CornerDetector& operator=(const CornerDetector&) = delete;
+
+  // Detect the corners of a pyramid level.
+  //
+  // @param pyramid: the pyramid to search.
+  // @param level: in [0, pyramid.GetLevelCount()).
+  // @param rois: the regions to search, all the level if empty.
+  // @param corners: the corners found are appended, cell by cell.
+  // @return number of corners appended.
+  size_t Detect(const LuminancePyramid& pyramid, int level,
+                const std::vector<Roi>& rois, std::vector<Corner>* corners);
+
+  const Options& GetOptions() const { return options_; }
+
+ private:
+  // Flag the cells overlapping the regions, all of them if there are none.
+  void MarkCells(const std::vector<Roi>& rois, int level, int level_width,
+                 int level_height);
+
+  const Options options_;
+
+  // Reused between calls, sized for the largest level searched.
+  std::vector<uint16_t> scores_;
+  std::vector<uint8_t> corner_flags_;
+  std::vector<uint8_t> active_cells_;
+  std::vector<Corner> candidates_;
+  int cell_columns_;
+  int cell_rows_;
+};
+
+namespace corner_detector {
+namespace internal {
+// Per-architecture row kernel, defined in corner_detector_neon.cpp. It runs
+// the FAST-9 test on columns [begin, end) of a row, 3 pixels away from the
+// image borders, and sets flags[x] to 0xff for corners and 0 otherwise. It
+// returns the first column not tested (begin plus a multiple of 16); the
+// caller tests the remaining ones.
+size_t DetectRowNeon(const uint8_t* row, size_t stride, size_t begin,
+                     size_t end, uint8_t threshold, uint8_t* flags);
+}  // namespace internal
+}  // namespace corner_detector
+
+}  // namespace tango_gl
+#endif  // TANGO_GL_CORNER_DETECTOR_H_
@@ -0,0 +1,84 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_GL_COUNTERS_H_
+#define TANGO_GL_COUNTERS_H_
+
+#include <stdint.h>
+
+#include <string>
+
+namespace tango_gl {
+
+// Counters tallies the work done by the hot paths, e.g. the bytes uploaded
+// to GL and the draw calls, so a throughput regression shows up as a number
+// rather than as a slower frame. Counting is cheap enough for production:
+// each thread adds to its own shard of relaxed atomics, so callbacks and the
+// GL thread never contend for a cache line.
+//
+// RenderState::BeginFrame() closes a frame; GetFrameValue() then returns what
+// was counted during the previous one, whichever thread counted it.
+//
+// Can be called from any thread, BeginFrame() on the GL thread.
+class Counters {
+ public:
+  enum Counter {
+    // Bytes passed to glBufferData() and glBufferSubData().
+    kBufferBytes,
+    // Bytes passed to glTexImage2D(), glTexSubImage2D() and
+    // glCompressedTexImage2D().
+    kTextureBytes,
+    kDrawCalls,
+    // glUseProgram() calls that reached GL, see RenderState::UseProgram().
+    kProgramBinds,
+    // Points passed to projection::ProjectPoints().
+    kPointsProjected,
+    // Poses delivered by the Tango service.
+    kPosesReceived,
+    // Points removed by DepthOutlierFilter.
+    kDepthOutliers,
+    kCounterCount
+  };
+
+  Counters() = delete;
+
+  static void Add(Counter counter, uint64_t value) {
+    AddToShard(counter, value);
+  }
+  static void Increment(Counter counter) { AddToShard(counter, 1); }
+
+  // Total since the process started.
+  static uint64_t GetTotal(Counter counter);
+
+  // Count of the last complete frame, 0 before the second BeginFrame().
+  static uint64_t GetFrameValue(Counter counter);
+
+  // Close the frame. Called by RenderState::BeginFrame(), on the GL thread.
+  static void BeginFrame();
+
+  // Name of a counter, e.g. "draw_calls".
+  static const char* GetName(Counter counter);
+
+  // The counts of the last frame on one line, e.g.
+  // "counters buffer_bytes 12.5 KB ... draw_calls 42 ...".
+  static std::string GetReport();
+
+ private:
+  static void AddToShard(Counter counter, uint64_t value);
+};
+}  // namespace tango_gl
+#endif  // TANGO_GL_COUNTERS_H_
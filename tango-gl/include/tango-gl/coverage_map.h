@@ -0,0 +1,178 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_GL_COVERAGE_MAP_H_
+#define TANGO_GL_COVERAGE_MAP_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include <tango_client_api.h>  // NOLINT
+
+#include "tango-gl/util.h"
+#include "tango-gl/vertex_buffer.h"
+
+namespace tango_gl {
+
+// CoverageMap shows which parts of the ground a session has seen, e.g. while
+// learning an area, as a heatmap under the ground grid.
+//
+// Coverage is accumulated on the GPU in a top-down texture of a square
+// around the world origin. Each depth frame adds its footprint, the depth
+// camera frustum cut at the range of the frame and projected on the ground,
+// with additive blending: a single draw of a polygon of at most 5 vertices,
+// whatever the number of points. A texel saturates after 1 / splat_weight
+// frames saw it.
+//
+// The texture is split into tiles, and only the tiles a footprint touched are
+// drawn, so the heatmap costs in proportion to the area covered.
+//
+// The world frame has y up, e.g. the OpenGL world frame, and the ground is
+// its XZ plane. All functions must be called on the GL thread.
+class CoverageMap {
+ public:
+  struct Options {
+    Options()
+        : texture_size(512),
+          meters_per_pixel(0.125f),
+          tile_size(32),
+          splat_weight(1.0f / 16.0f),
+          max_range(4.0f) {}
+
+    // Side of the texture in pixels, and of a pixel on the ground in meters:
+    // 64 m by default, centered on the world origin.
+    int texture_size;
+    float meters_per_pixel;
+    // Side of a tile in pixels, a divisor of texture_size.
+    int tile_size;
+    // Coverage added by a footprint, in [0, 1].
+    float splat_weight;
+    // Farthest a footprint reaches from the camera, in meters.
+    float max_range;
+  };
+
+  explicit CoverageMap(const Options& options = Options());
+  CoverageMap(const CoverageMap& other) = delete;
+  const CoverageMap& operator=(const CoverageMap&) = delete;
+  ~CoverageMap();
+
+  // Set the intrinsics of the depth camera, TANGO_CAMERA_DEPTH. Splat() does
+  // nothing before.
+  void SetIntrinsics(const TangoCameraIntrinsics& intrinsics);
+
+  // Add the footprint of a depth frame. Restores the viewport and binds
+  // framebuffer 0 before returning.
+  //
+  // @param world_T_depth: pose of the depth camera at the frame timestamp in
+  //        the world frame.
+  // @param range: distance in meters the frustum is cut at, e.g. the average
+  //        depth of the frame, clamped to max_range.
+  void Splat(const glm::mat4& world_T_depth, float range);
+
+  // Draw the heatmap on the covered tiles. It is blended and does not write
+  // depth, so it goes before the grid and the opaque drawables on the
+  // ground.
+  //
+  // @param projection_mat: projection matrix from current render camera.
+  // @param view_mat: view matrix from current render camera.
+  void Render(const glm::mat4& projection_mat, const glm::mat4& view_mat);
+
+  // Forget the coverage.
+  void Clear();
+
+  // Height of the ground the heatmap is drawn at, 0 by default.
+  void SetHeight(float height) { height_ = height; }
+
+  // Colors of the least and the most covered texels, alpha included.
+  void SetColors(const glm::vec4& low_color, const glm::vec4& high_color) {
+    low_color_ = low_color;
+    high_color_ = high_color;
+  }
+
+  // Tiles a footprint touched.
+  size_t GetCoveredTileCount() const { return covered_tile_count_; }
+
+  // Footprints added since creation or the last Clear().
+  uint64_t GetSplatCount() const { return splat_count_; }
+
+  const Options& GetOptions() const { return options_; }
+
+  // Release the GL objects, the coverage is lost.
+  void Release();
+
+  // Forget the GL objects without deleting them. Use this when the GL
+  // context they belonged to has been destroyed.
+  void Invalidate();
+
+ private:
+  // Create the texture, framebuffer and programs if needed.
+  bool Allocate();
+
+  // Forget the coverage on the CPU side, the texture is cleared before the
+  // next footprint.
+  void Reset();
+
+  // Mark the tiles overlapping a box of the ground, in pixels.
+  void CoverTiles(const glm::vec2& min_pixel, const glm::vec2& max_pixel);
+
+  Options options_;
+  // Side of the covered square in meters.
+  float extent_;
+  int tiles_per_side_;
+
+  bool has_intrinsics_;
+  // Directions of the depth image corners in the depth camera frame, at a
+  // depth of 1.
+  glm::vec3 corner_rays_[4];
+
+  bool is_unsupported_;
+  GLuint framebuffer_;
+  GLuint texture_;
+  bool is_cleared_;
+
+  GLuint splat_program_;
+  GLint splat_attrib_vertices_;
+  GLint uniform_weight_;
+  VertexBuffer splat_buffer_;
+
+  GLuint program_;
+  GLint attrib_vertices_;
+  GLint uniform_mvp_mat_;
+  GLint uniform_height_;
+  GLint uniform_inverse_extent_;
+  GLint uniform_low_color_;
+  GLint uniform_high_color_;
+  // Two triangles per covered tile, x and z of their vertices, appended as
+  // tiles get covered. The first uploaded_tile_float_count_ floats are on
+  // the GPU.
+  VertexBuffer tile_buffer_;
+  std::vector<GLfloat> tile_vertices_;
+  size_t uploaded_tile_float_count_;
+
+  // One byte per tile, non zero once covered.
+  std::vector<uint8_t> tiles_;
+  size_t covered_tile_count_;
+  uint64_t splat_count_;
+
+  float height_;
+  glm::vec4 low_color_;
+  glm::vec4 high_color_;
+};
+}  // namespace tango_gl
+#endif  // TANGO_GL_COVERAGE_MAP_H_
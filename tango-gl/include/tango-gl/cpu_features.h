@@ -0,0 +1,46 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TANGO_GL_CPU_FEATURES_H_
+#define TANGO_GL_CPU_FEATURES_H_
+
+#if defined(TANGO_GL_HAS_NEON)
+#include <cpu-features.h>
+#endif
+
+namespace tango_gl {
+namespace cpu_features {
+
+// Returns true if the NEON kernels are compiled in (TANGO_GL_HAS_NEON) and
+// supported by the CPU. The result is computed once and cached. Builds that
+// define TANGO_GL_HAS_NEON need to link the cpufeatures NDK module.
+inline bool IsNeonAvailable() {
+#if defined(TANGO_GL_HAS_NEON) && defined(__aarch64__)
+  // Advanced SIMD is part of the AArch64 baseline.
+  return true;
+#elif defined(TANGO_GL_HAS_NEON)
+  static const bool is_neon_available =
+      android_getCpuFamily() == ANDROID_CPU_FAMILY_ARM &&
+      (android_getCpuFeatures() & ANDROID_CPU_ARM_FEATURE_NEON) != 0;
+  return is_neon_available;
+#else
+  return false;
+#endif
+}
+
+}  // namespace cpu_features
+}  // namespace tango_gl
+#endif  // TANGO_GL_CPU_FEATURES_H_
@@ -0,0 +1,145 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_GL_DEBUG_DRAW_H_
+#define TANGO_GL_DEBUG_DRAW_H_
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "tango-gl/color.h"
+#include "tango-gl/text_overlay.h"
+#include "tango-gl/util.h"
+#include "tango-gl/vertex_array.h"
+#include "tango-gl/vertex_buffer.h"
+
+namespace tango_gl {
+
+// DebugDraw draws throwaway visualizations, e.g. rays, normals or plane
+// outlines, without a drawable per shape. Shapes are added in world
+// coordinates during a frame and Flush() draws all of their lines with a
+// single draw call from one streaming vertex buffer, with the per vertex
+// color variant of shader_variants, instead of a Line or SegmentDrawable
+// with its own draw call each. Text is anchored at world positions and
+// drawn by the caller's TextOverlay in its single draw call, see
+// AddLabels().
+//
+// Disabled, the Add functions return right away, so calls can stay in
+// production builds. Lines beyond kMaxVertexCount vertices per frame are
+// dropped.
+//
+// All functions must be called on the GL thread.
+class DebugDraw {
+ public:
+  static const size_t kMaxVertexCount = 1 << 16;
+
+  DebugDraw();
+  DebugDraw(const DebugDraw& other) = delete;
+  const DebugDraw& operator=(const DebugDraw&) = delete;
+  ~DebugDraw();
+
+  void SetEnabled(bool enabled) { is_enabled_ = enabled; }
+  bool IsEnabled() const { return is_enabled_; }
+
+  void SetLineWidth(float pixels) { line_width_ = pixels; }
+
+  // Add a line segment.
+  void AddLine(const glm::vec3& start, const glm::vec3& end,
+               const Color& color);
+
+  // Add the edges of an axis aligned box.
+  void AddBox(const glm::vec3& min, const glm::vec3& max, const Color& color);
+
+  // Add the edges of a box, e.g. an oriented bounding box.
+  //
+  // @param world_T_box: pose of the box frame.
+  // @param min, max: corners of the box in its frame.
+  void AddBox(const glm::mat4& world_T_box, const glm::vec3& min,
+              const glm::vec3& max, const Color& color);
+
+  // Add the x, y and z axes of a frame in red, green and blue.
+  //
+  // @param world_T_frame: pose of the frame.
+  // @param length: length of the axes.
+  void AddAxes(const glm::mat4& world_T_frame, float length);
+
+  // Add a text label, lines separated by '\n'.
+  //
+  // @param position: world position of the top left corner of the text.
+  void AddText(const std::string& text, const glm::vec3& position);
+
+  // Draw the lines added since the last Flush(), project the labels to the
+  // viewport for AddLabels() and start a new frame.
+  //
+  // @param projection_mat: projection of the camera.
+  // @param view_mat: camera with respect to world.
+  // @param viewport_width, viewport_height: viewport size in pixels.
+  void Flush(const glm::mat4& projection_mat, const glm::mat4& view_mat,
+             int viewport_width, int viewport_height);
+
+  // Add the labels in front of the camera at the last Flush() to the batch
+  // of a text overlay, drawn by its next Draw().
+  void AddLabels(TextOverlay* text_overlay) const {
+    for (const Label& label : flushed_labels_) {
+      text_overlay->AddText(label.text, label.pixel.x, label.pixel.y);
+    }
+  }
+
+  // Release the vertex buffer and the shader program.
+  void Release();
+
+  // Forget the GL objects without deleting them. Use this when the GL
+  // context they belonged to has been destroyed.
+  void Invalidate();
+
+ private:
+  // 16 bytes per vertex, the color normalized from bytes.
+  struct Vertex {
+    glm::vec3 position;
+    uint8_t color[4];
+  };
+
+  struct Label {
+    std::string text;
+    // World position before Flush(), pixels from the top left after it.
+    glm::vec3 position;
+    glm::vec2 pixel;
+  };
+
+  // Acquire the program on first use.
+  bool InitializeProgram();
+
+  void PushVertex(const glm::vec3& position, const Color& color);
+
+  bool is_enabled_;
+  float line_width_;
+
+  std::vector<Vertex> vertices_;
+  std::vector<Label> labels_;
+  std::vector<Label> flushed_labels_;
+
+  GLuint shader_program_;
+  GLint uniform_mvp_;
+  GLint attrib_vertices_;
+  GLint attrib_colors_;
+  VertexBuffer vertex_buffer_;
+  VertexArray vertex_array_;
+};
+}  // namespace tango_gl
+#endif  // TANGO_GL_DEBUG_DRAW_H_
@@ -0,0 +1,130 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TANGO_GL_DEPTH_HIT_TESTER_H_
+#define TANGO_GL_DEPTH_HIT_TESTER_H_
+
+#include <stddef.h>
+
+#include "tango-gl/point_projection.h"
+#include "tango-gl/ray_table.h"
+#include "tango-gl/util.h"
+
+namespace tango_gl {
+
+// Surface found under a probe by DepthHitTester.
+struct DepthHit {
+  // Where the probe ray meets the plane fitted around it, in the world
+  // frame.
+  glm::vec3 position;
+  // Unit normal of the plane in the world frame, facing the camera.
+  glm::vec3 normal;
+  // Pose to place content at: origin at position, +y along the normal and
+  // +z in the plane, towards the camera.
+  glm::mat4 world_T_hit;
+  // Depth pixels the plane was fitted to.
+  int point_count;
+  // Sum of their weights, their confidences if the tester has them, else
+  // point_count.
+  float point_weight;
+  // Root mean square distance of those pixels to the plane, in meters.
+  float fit_error;
+};
+
+// DepthHitTester places content on tap from a depth image registered to a
+// camera, e.g. the color camera depth map of the RGB depth sync example or a
+// RangeImage. A probe looks up the window of depth pixels around the tapped
+// pixel, fits a least squares plane to them and intersects the tap ray with
+// it, so a probe costs the same whatever the size of the depth frame, a few
+// microseconds with the default window.
+//
+// Probes only read the depth image and the tester, so they can run on any
+// number of threads at once.
+class DepthHitTester {
+ public:
+  // Default half size of the window, 11 by 11 pixels.
+  static const int kDefaultWindowRadius = 5;
+
+  // Fewest depth pixels a window needs for a plane.
+  static const int kMinPointCount = 6;
+
+  DepthHitTester();
+
+  // Set the depth image probes read. It is referenced rather than copied,
+  // and must neither change nor go away while probes run.
+  //
+  // @param depths: row major depth in meters for each pixel of the camera
+  //        image, 0 where there is no depth. Pixel (x, y) covers the image
+  //        positions [x, x + 1) by [y, y + 1), like in
+  //        projection::ProjectPoints().
+  // @param intrinsics: intrinsics of the camera, the image size is the size
+  //        of the depth image.
+  // @param world_T_camera: pose of the camera frame, +z along the optical
+  //        axis, in the frame hits are returned in.
+  void SetDepthImage(const float* depths,
+                     const projection::CameraIntrinsics& intrinsics,
+                     const glm::mat4& world_T_camera);
+
+  // Set a confidence per depth pixel, e.g. from TemporalDepthFilter, to fit
+  // the planes with: pixels are weighted by their confidence and pixels
+  // below min_confidence are skipped. Referenced like the depth image, pass
+  // nullptr to weight every pixel the same again.
+  //
+  // @param confidences: row major confidence in [0, 1] for each pixel of the
+  //        depth image.
+  // @param min_confidence: pixels with a lower confidence are ignored.
+  void SetConfidences(const float* confidences, float min_confidence);
+
+  // Windows span 2 * radius + 1 pixels per side, clipped by the image
+  // borders. Filtered depth with confidences needs a smaller window than a
+  // raw frame for the same fit error.
+  void SetWindowRadius(int radius);
+
+  // Probe the surface under a tap.
+  //
+  // @param uv: position in the camera image, (0, 0) at the top left and
+  //        (1, 1) at the bottom right corner, i.e. the tap position divided
+  //        by the view size for a full screen camera image.
+  // @param hit: set to the surface found.
+  // @return false if there is no depth image, too few depth pixels around
+  //         the tap, or the tap ray runs along the plane.
+  bool HitTest(const glm::vec2& uv, DepthHit* hit) const;
+
+  // Probe several taps at once, e.g. a placement preview following a
+  // reticle.
+  //
+  // @param uvs: probe_count positions, see HitTest().
+  // @param hits: output, probe_count surfaces, only set where is_hit is.
+  // @param is_hit: output, probe_count results of the probes.
+  // @return number of probes which hit a surface.
+  size_t HitTest(const glm::vec2* uvs, size_t probe_count, DepthHit* hits,
+                 bool* is_hit) const;
+
+ private:
+  // Depth pixel (x, y) back projected through its center into the camera
+  // frame.
+  glm::dvec3 GetCameraPoint(int x, int y, double depth) const;
+
+  const float* depths_;
+  const float* confidences_;
+  float min_confidence_;
+  projection::CameraIntrinsics intrinsics_;
+  RayTable ray_table_;
+  glm::mat4 world_T_camera_;
+  int window_radius_;
+};
+}  // namespace tango_gl
+#endif  // TANGO_GL_DEPTH_HIT_TESTER_H_
@@ -0,0 +1,157 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TANGO_GL_DEPTH_OCCLUSION_H_
+#define TANGO_GL_DEPTH_OCCLUSION_H_
+
+#include <stddef.h>
+
+#include "tango-gl/util.h"
+#include "tango-gl/vertex_buffer.h"
+
+namespace tango_gl {
+
+// DepthOcclusion hides virtual content behind real surfaces. A depth image
+// registered to the color camera is written into the depth buffer before the
+// virtual content is drawn, so fragments behind the real surface fail the
+// depth test; the video overlay under it is left untouched.
+//
+// The depth image is a texture in the encoding of the rgb-depth-sync
+// example: blue and alpha hold the depth in millimeters as a 16 bit integer,
+// high byte first, 0 meaning no depth, and texture row 0 is the top row of
+// the color image. UpdateDepth() splats a point cloud into such a texture
+// entirely on the GPU; a texture built elsewhere, e.g. DepthImage of
+// rgb-depth-sync, can be passed to Render() instead.
+//
+// Pixels without depth do not occlude. Writing the depth needs
+// GL_EXT_frag_depth, Render() is a no-op where it is missing.
+//
+// All functions must be called on the GL thread.
+class DepthOcclusion {
+ public:
+  enum Mode {
+    // The depth image has the color camera resolution and is sampled at the
+    // nearest pixel. Occlusion edges follow the splats, blocky where the
+    // points are sparse.
+    kNearest,
+    // The depth image has a quarter of the color camera resolution and is
+    // upsampled per pixel: the inverse depth is interpolated between the
+    // neighboring texels, but only those on the same side of a depth edge
+    // as the nearest one. Cheaper to splat and smoother on surfaces, while
+    // edges stay as sharp as the low resolution image.
+    kEdgeAware
+  };
+
+  // Default size of a splatted point in pixels of the color camera image.
+  static const float kDefaultPointSize;
+  // Default relative depth difference beyond which kEdgeAware treats two
+  // texels as different surfaces.
+  static const float kDefaultEdgeThreshold;
+
+  DepthOcclusion();
+  DepthOcclusion(const DepthOcclusion& other) = delete;
+  const DepthOcclusion& operator=(const DepthOcclusion&) = delete;
+  ~DepthOcclusion();
+
+  // Whether the current context can write fragment depth.
+  static bool IsSupported();
+
+  void SetMode(Mode mode);
+  Mode GetMode() const { return mode_; }
+
+  void SetPointSize(float point_size);
+  void SetEdgeThreshold(float edge_threshold);
+
+  // Splat a point cloud into the depth image. Binds its own framebuffer and
+  // restores framebuffer 0 and the viewport, so it must not be called while
+  // rendering into another target.
+  //
+  // @param points: xyz points in the depth camera frame.
+  // @param count: number of points.
+  // @param color_T_depth: depth camera frame to color camera frame, at the
+  //     timestamps of the depth and color frames.
+  // @param projection: projection of the color camera, e.g. the one the
+  //     virtual content is rendered with.
+  // @param width, height: color camera image size in pixels.
+  // @return false if the depth image could not be created.
+  bool UpdateDepth(const float* points, size_t count,
+                   const glm::mat4& color_T_depth, const glm::mat4& projection,
+                   GLsizei width, GLsizei height);
+
+  // Write the depth image of the last UpdateDepth() into the depth buffer of
+  // the current framebuffer, over the whole viewport. Leaves color writes
+  // enabled and the depth test enabled.
+  //
+  // @param projection: projection the virtual content is rendered with,
+  //     covering the same field of view as the color camera.
+  void Render(const glm::mat4& projection);
+
+  // Same with a depth image texture built elsewhere, of width x height
+  // texels. The texture must use GL_NEAREST filtering.
+  void Render(GLuint depth_texture, GLsizei width, GLsizei height,
+              const glm::mat4& projection);
+
+  // Release the framebuffer, its attachments, buffers and shader programs.
+  void Release();
+
+  // Forget the GL objects without deleting them. Use this when the GL
+  // context they belonged to has been destroyed.
+  void Invalidate();
+
+ private:
+  // A program and the locations the occlusion pass uses.
+  struct OcclusionProgram {
+    GLuint program;
+    GLint attrib_vertices;
+    GLint uniform_depth_image;
+    GLint uniform_texel_size;
+    GLint uniform_depth_transform;
+    GLint uniform_edge_threshold;
+  };
+
+  // Create or resize the depth image.
+  bool Allocate(GLsizei width, GLsizei height);
+  bool AcquireSplatProgram();
+  bool AcquireOcclusionProgram(Mode mode, OcclusionProgram* program);
+
+  Mode mode_;
+  float point_size_;
+  float edge_threshold_;
+
+  GLuint framebuffer_;
+  GLuint depth_texture_;
+  GLuint depth_renderbuffer_;
+  GLsizei texture_width_;
+  GLsizei texture_height_;
+  // Whether depth_texture_ holds a depth image.
+  bool has_depth_;
+  // Set when the framebuffer was incomplete, UpdateDepth() then fails until
+  // Release() or Invalidate().
+  bool is_unsupported_;
+
+  GLuint splat_program_;
+  GLint splat_attrib_vertices_;
+  GLint splat_uniform_mvp_;
+  GLint splat_uniform_color_T_depth_;
+  GLint splat_uniform_point_size_;
+  VertexBuffer point_buffer_;
+
+  OcclusionProgram nearest_program_;
+  OcclusionProgram edge_aware_program_;
+  VertexBuffer quad_buffer_;
+};
+}  // namespace tango_gl
+#endif  // TANGO_GL_DEPTH_OCCLUSION_H_
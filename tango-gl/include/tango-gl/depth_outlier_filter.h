@@ -0,0 +1,126 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_GL_DEPTH_OUTLIER_FILTER_H_
+#define TANGO_GL_DEPTH_OUTLIER_FILTER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <functional>
+#include <vector>
+
+#include "tango-gl/range_image.h"
+#include "tango-gl/worker_pool.h"
+
+namespace tango_gl {
+
+// DepthOutlierFilter finds the flying pixels a depth camera measures along
+// depth edges, points floating between the foreground and the background,
+// so they can be dropped before plane fitting, hit testing or fusion.
+//
+// It runs statistical outlier removal on a RangeImage: the score of a point
+// is the mean distance to its nearest neighbors, searched among the pixels
+// of a fixed window around its pixel rather than the whole frame, divided by
+// its depth since the spacing of the points grows with it. Points whose
+// score is more than std_ratio standard deviations above the mean score of
+// the frame, or with fewer than neighbor_count neighbors in the window, are
+// outliers. Points hidden in the range image behind a nearer point of the
+// same pixel are kept.
+//
+// The scores are computed in parallel bands of rows on the worker pool.
+// Not thread safe, callers serialize Filter() and reads.
+class DepthOutlierFilter {
+ public:
+  struct Options {
+    Options() : window_radius(2), neighbor_count(4), std_ratio(2.0f) {}
+
+    // Neighbors are searched in a window of 2 * window_radius + 1 pixels per
+    // side.
+    int window_radius;
+    // Number of nearest neighbors a score averages over, also the fewest
+    // neighbors a point needs to be kept.
+    int neighbor_count;
+    // Points scoring more than std_ratio standard deviations above the mean
+    // are outliers, lower values remove more points.
+    float std_ratio;
+  };
+
+  // @param options: filter parameters.
+  // @param worker_pool: pool to score rows in parallel on, can be nullptr to
+  //        score on the calling thread only.
+  DepthOutlierFilter(const Options& options, WorkerPool* worker_pool);
+  DepthOutlierFilter(const DepthOutlierFilter& other) = delete;
+  const DepthOutlierFilter& operator=(const DepthOutlierFilter&) = delete;
+
+  // Classify the points of the frame last passed to RangeImage::Update().
+  //
+  // @return number of outliers.
+  size_t Filter(const RangeImage& image);
+
+  const Options& GetOptions() const { return options_; }
+
+  // Whether a point of the filtered frame is an outlier.
+  bool IsOutlier(size_t point_index) const {
+    return point_index < is_outlier_.size() && is_outlier_[point_index] != 0;
+  }
+
+  // Number of outliers found by the last Filter().
+  size_t GetOutlierCount() const { return outlier_count_; }
+
+  // Score above which points were outliers in the last Filter().
+  float GetThreshold() const { return threshold_; }
+
+  // Copy the points of the filtered frame which are not outliers.
+  //
+  // @param points: packed x, y, z coordinates, the frame passed to
+  //        RangeImage::Update().
+  // @param point_count: number of points.
+  // @param inliers: output, room for point_count points.
+  // @return number of points copied.
+  size_t CopyInliers(const float* points, size_t point_count,
+                     float* inliers) const;
+
+ private:
+  // Sums over the scores of a band of rows.
+  struct ScoreSums {
+    double sum;
+    double sum2;
+    size_t count;
+  };
+
+  // Score the pixels of rows [begin, end).
+  ScoreSums ScoreRows(const RangeImage& image, int begin, int end);
+
+  // Mark the outliers of rows [begin, end).
+  size_t MarkRows(const RangeImage& image, int begin, int end);
+
+  void RunTasks(int task_count, const std::function<void(int)>& task);
+
+  Options options_;
+  WorkerPool* worker_pool_;
+
+  // Per pixel score, negative for pixels without a point, infinite for
+  // points with too few neighbors.
+  std::vector<float> scores_;
+
+  std::vector<uint8_t> is_outlier_;
+  size_t outlier_count_;
+  float threshold_;
+};
+}  // namespace tango_gl
+#endif  // TANGO_GL_DEPTH_OUTLIER_FILTER_H_
@@ -0,0 +1,318 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_GL_DEPTH_PIPELINE_H_
+#define TANGO_GL_DEPTH_PIPELINE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "tango-gl/point_projection.h"
+#include "tango-gl/util.h"
+
+namespace tango_gl {
+namespace depth_pipeline {
+
+// Depth pipelines composed at compile time: a Pipeline of stages, e.g.
+//
+//   Pipeline<DepthRange, Transform, Project, SplatDepth> pipeline(
+//       DepthRange(0.3f, 4.0f), Transform(color_T_depth),
+//       Project(intrinsics), SplatDepth(...));
+//   pipeline.Run(xyz, point_count);
+//
+// runs every point through all the stages in a single pass, the stage calls
+// being inlined into one loop instead of each stage sweeping the whole frame
+// and writing its output for the next. A stage is any class with
+//
+//   // Called before a pass over point_count points.
+//   void Begin(size_t point_count);
+//   // Update the point, or return false to drop it from the later stages.
+//   bool Process(Point* point);
+//   // Called after the pass.
+//   void End();
+//
+// Stages derive from Stage for empty Begin() and End(). Stages that depend on
+// the whole frame, e.g. a voxel grid decimation or a range image filter, are
+// run before or after a pipeline, not in it.
+
+// A point on its way through the stages.
+struct Point {
+  // Position, in the frame of the last Transform, in the depth camera frame
+  // before one.
+  glm::vec3 position;
+  // Pixel of the last Project.
+  int x;
+  int y;
+  // Index of the point in the frame.
+  size_t index;
+};
+
+class Stage {
+ public:
+  void Begin(size_t) {}
+  void End() {}
+};
+
+// Drop points with a depth out of [min_depth, max_depth], or not a number.
+class DepthRange : public Stage {
+ public:
+  DepthRange(float min_depth, float max_depth)
+      : min_depth_(min_depth), max_depth_(max_depth) {}
+
+  bool Process(Point* point) const {
+    return point->position.z >= min_depth_ && point->position.z <= max_depth_;
+  }
+
+ private:
+  float min_depth_;
+  float max_depth_;
+};
+
+// Keep one point every stride of the points reaching the stage.
+class Decimate : public Stage {
+ public:
+  explicit Decimate(int stride)
+      : stride_(std::max(1, stride)), countdown_(0) {}
+
+  void Begin(size_t) { countdown_ = 0; }
+
+  bool Process(Point*) {
+    if (countdown_ > 0) {
+      --countdown_;
+      return false;
+    }
+    countdown_ = stride_ - 1;
+    return true;
+  }
+
+ private:
+  int stride_;
+  int countdown_;
+};
+
+// Move the points into another frame by a rigid or affine transformation.
+class Transform : public Stage {
+ public:
+  explicit Transform(const glm::mat4& out_T_in)
+      : rotation_(out_T_in), translation_(out_T_in[3]) {}
+
+  bool Process(Point* point) const {
+    point->position = rotation_ * point->position + translation_;
+    return true;
+  }
+
+ private:
+  glm::mat3 rotation_;
+  glm::vec3 translation_;
+};
+
+// Project the points onto the image plane of a camera, in its frame, and
+// drop the ones behind it or outside of the image. Matches the scalar path
+// of projection::ProjectPoints().
+class Project : public Stage {
+ public:
+  explicit Project(const projection::CameraIntrinsics& intrinsics)
+      : intrinsics_(intrinsics),
+        width_(static_cast<float>(intrinsics.width)),
+        height_(static_cast<float>(intrinsics.height)) {}
+
+  bool Process(Point* point) const {
+    const glm::vec3& position = point->position;
+    if (!(position.z > 0.0f)) {
+      return false;
+    }
+    const float pixel_x =
+        intrinsics_.fx * (position.x / position.z) + intrinsics_.cx;
+    const float pixel_y =
+        intrinsics_.fy * (position.y / position.z) + intrinsics_.cy;
+    // Compared as floats so far away pixels never overflow the int cast.
+    if (!(pixel_x >= 0.0f && pixel_x < width_ && pixel_y >= 0.0f &&
+          pixel_y < height_)) {
+      return false;
+    }
+    point->x = static_cast<int>(pixel_x);
+    point->y = static_cast<int>(pixel_y);
+    return true;
+  }
+
+ private:
+  projection::CameraIntrinsics intrinsics_;
+  float width_;
+  float height_;
+};
+
+// Append the positions, packed x, y, z, to a buffer cleared by Begin().
+class AppendPoints : public Stage {
+ public:
+  explicit AppendPoints(std::vector<float>* points) : points_(points) {}
+
+  void Begin(size_t point_count) {
+    points_->clear();
+    points_->reserve(point_count * 3);
+  }
+
+  bool Process(Point* point) {
+    points_->push_back(point->position.x);
+    points_->push_back(point->position.y);
+    points_->push_back(point->position.z);
+    return true;
+  }
+
+ private:
+  std::vector<float>* points_;
+};
+
+// Splat the depth of projected points over a square window of a depth image,
+// the nearest depth winning. Depth is stored in millimeters as a 16 bit
+// integer, half the memory traffic of float meters, and the image can be
+// uploaded to a texture as is. Pixels whose stamp is not the current one
+// count as empty, so the image is not cleared between frames.
+class SplatDepth : public Stage {
+ public:
+  // Largest depth in millimeters, farther points are clamped to it.
+  static const uint16_t kMaxMillimeters = 65535;
+
+  // @param millimeters, stamps: width * height pixels, written in place.
+  // @param window_size: half width of the window, 0 splats single pixels.
+  // @param stamp: stamp of the pixels written this frame.
+  SplatDepth(uint16_t* millimeters, uint32_t* stamps, int width, int height,
+             int window_size, uint32_t stamp)
+      : millimeters_(millimeters),
+        stamps_(stamps),
+        width_(width),
+        height_(height),
+        window_size_(window_size),
+        stamp_(stamp) {}
+
+  // Depth in meters to millimeters, rounded and clamped.
+  static uint16_t ToMillimeters(float depth) {
+    return static_cast<uint16_t>(
+        std::min(std::max(depth * 1000.0f + 0.5f, 0.0f),
+                 static_cast<float>(kMaxMillimeters)));
+  }
+
+  bool Process(Point* point) {
+    Splat(point->position.z, point->x, point->y);
+    return true;
+  }
+
+  // Splat a depth in meters around a pixel.
+  void Splat(float depth, int pixel_x, int pixel_y) {
+    // Converted once per point, the window loop only compares integers.
+    const uint16_t millimeters = ToMillimeters(depth);
+    // Clip the window to the image so it never wraps into the next row.
+    const int x0 = std::max(0, pixel_x - window_size_);
+    const int x1 = std::min(width_ - 1, pixel_x + window_size_);
+    const int y0 = std::max(0, pixel_y - window_size_);
+    const int y1 = std::min(height_ - 1, pixel_y + window_size_);
+    for (int y = y0; y <= y1; ++y) {
+      uint16_t* depth_row = millimeters_ + y * width_;
+      uint32_t* stamp_row = stamps_ + y * width_;
+      for (int x = x0; x <= x1; ++x) {
+        if (stamp_row[x] != stamp_ || millimeters < depth_row[x]) {
+          depth_row[x] = millimeters;
+          stamp_row[x] = stamp_;
+        }
+      }
+    }
+  }
+
+ private:
+  uint16_t* millimeters_;
+  uint32_t* stamps_;
+  int width_;
+  int height_;
+  int window_size_;
+  uint32_t stamp_;
+};
+
+// A composition of stages, run front to back on each point in turn.
+template <typename... Stages>
+class Pipeline;
+
+template <>
+class Pipeline<> {
+ public:
+  void Begin(size_t) {}
+  bool Process(Point*) { return true; }
+  void End() {}
+};
+
+template <typename First, typename... Rest>
+class Pipeline<First, Rest...> {
+ public:
+  explicit Pipeline(const First& first, const Rest&... rest)
+      : first_(first), rest_(rest...) {}
+
+  // Run a frame through the stages.
+  //
+  // @param xyz: packed x, y, z coordinates in the depth camera frame.
+  // @param point_count: number of points.
+  // @return number of points that went through every stage.
+  size_t Run(const float* xyz, size_t point_count) {
+    Begin(point_count);
+    size_t kept_count = 0;
+    Point point;
+    point.x = 0;
+    point.y = 0;
+    for (size_t i = 0; i < point_count; ++i) {
+      point.position = glm::vec3(xyz[i * 3], xyz[i * 3 + 1], xyz[i * 3 + 2]);
+      point.index = i;
+      if (Process(&point)) {
+        ++kept_count;
+      }
+    }
+    End();
+    return kept_count;
+  }
+
+  void Begin(size_t point_count) {
+    first_.Begin(point_count);
+    rest_.Begin(point_count);
+  }
+
+  bool Process(Point* point) {
+    return first_.Process(point) && rest_.Process(point);
+  }
+
+  void End() {
+    first_.End();
+    rest_.End();
+  }
+
+  // The stages, e.g. to read what a consumer gathered.
+  First& GetFirst() { return first_; }
+  Pipeline<Rest...>& GetRest() { return rest_; }
+
+ private:
+  First first_;
+  Pipeline<Rest...> rest_;
+};
+
+// Deduce the stage types, e.g.
+//   auto pipeline = MakePipeline(Transform(m), Project(intrinsics), ...);
+template <typename... Stages>
+Pipeline<Stages...> MakePipeline(const Stages&... stages) {
+  return Pipeline<Stages...>(stages...);
+}
+
+}  // namespace depth_pipeline
+}  // namespace tango_gl
+#endif  // TANGO_GL_DEPTH_PIPELINE_H_
@@ -0,0 +1,68 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_GL_DEPTH_STATISTICS_H_
+#define TANGO_GL_DEPTH_STATISTICS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace tango_gl {
+
+// The depth histogram has bins of kDepthHistogramBinSize meters starting at
+// 0, the last bin also counts every point beyond it.
+const int kDepthHistogramBinCount = 16;
+const float kDepthHistogramBinSize = 0.5f;
+
+// Depth statistics of a point cloud frame. Points with a depth (z) of 0 or
+// less are not valid and not counted.
+struct DepthStatistics {
+  size_t valid_point_count;
+  // 0 if there is no valid point.
+  float min_depth;
+  float max_depth;
+  float mean_depth;
+  uint32_t histogram[kDepthHistogramBinCount];
+};
+
+// Compute the depth statistics of packed points in a single pass over them.
+// On NEON capable devices four points are accumulated at a time.
+//
+// @param points: packed x, y, z coordinates, point_count * 3 floats.
+// @param point_count: number of points.
+// @param statistics: output statistics.
+void ComputeDepthStatistics(const float* points, size_t point_count,
+                            DepthStatistics* statistics);
+
+namespace internal {
+// Running sums of ComputeDepthStatistics().
+struct DepthAccumulator {
+  size_t valid_point_count;
+  float min_depth;
+  float max_depth;
+  double depth_sum;
+  uint32_t histogram[kDepthHistogramBinCount];
+};
+
+// NEON kernel, defined in depth_statistics_neon.cpp. Accumulates the first
+// point_count & ~3 points; the caller accumulates the remaining points.
+void AccumulateDepthNeon(const float* points, size_t point_count,
+                         DepthAccumulator* accumulator);
+}  // namespace internal
+
+}  // namespace tango_gl
+#endif  // TANGO_GL_DEPTH_STATISTICS_H_
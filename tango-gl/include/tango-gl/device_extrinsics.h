@@ -0,0 +1,88 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_GL_DEVICE_EXTRINSICS_H_
+#define TANGO_GL_DEVICE_EXTRINSICS_H_
+
+#include <tango_client_api.h>  // NOLINT
+
+#include "tango-gl/util.h"
+
+namespace tango_gl {
+
+// DeviceExtrinsics holds the fixed transformations between the device, color
+// camera and depth camera frames, and the OpenGL camera frames attached to the
+// cameras. The sensors do not move on the device, so they are queried once
+// after connecting to the Tango service, and every chain and its inverse is
+// precomputed for the render loop.
+class DeviceExtrinsics {
+ public:
+  // All transformations start out as identity.
+  DeviceExtrinsics();
+
+  // Query the IMU to device, color and depth camera transformations from the
+  // Tango service. Must be called after TangoService_connect().
+  //
+  // @return TANGO_SUCCESS, or the error of the first failed query, in which
+  //         case the transformations are left unchanged.
+  TangoErrorType Query();
+
+  // Compute the transformations from the sensor poses with respect to the
+  // IMU frame, e.g. when they come from a recording instead of the service.
+  void SetImuTransforms(const glm::mat4& imu_T_device,
+                        const glm::mat4& imu_T_color,
+                        const glm::mat4& imu_T_depth);
+
+  // Camera frames with respect to the device frame, and back.
+  const glm::mat4& GetDeviceTColor() const { return device_T_color_; }
+  const glm::mat4& GetColorTDevice() const { return color_T_device_; }
+  const glm::mat4& GetDeviceTDepth() const { return device_T_depth_; }
+  const glm::mat4& GetDepthTDevice() const { return depth_T_device_; }
+
+  // Depth camera frame with respect to the color camera frame, and back.
+  const glm::mat4& GetColorTDepth() const { return color_T_depth_; }
+  const glm::mat4& GetDepthTColor() const { return depth_T_color_; }
+
+  // OpenGL camera frames (Z-backward) attached to the color and depth cameras
+  // (Z-forward) with respect to the device frame, and back.
+  const glm::mat4& GetDeviceTOpenGLColorCamera() const {
+    return device_T_opengl_color_camera_;
+  }
+  const glm::mat4& GetOpenGLColorCameraTDevice() const {
+    return opengl_color_camera_T_device_;
+  }
+  const glm::mat4& GetDeviceTOpenGLDepthCamera() const {
+    return device_T_opengl_depth_camera_;
+  }
+  const glm::mat4& GetOpenGLDepthCameraTDevice() const {
+    return opengl_depth_camera_T_device_;
+  }
+
+ private:
+  glm::mat4 device_T_color_;
+  glm::mat4 color_T_device_;
+  glm::mat4 device_T_depth_;
+  glm::mat4 depth_T_device_;
+  glm::mat4 color_T_depth_;
+  glm::mat4 depth_T_color_;
+  glm::mat4 device_T_opengl_color_camera_;
+  glm::mat4 opengl_color_camera_T_device_;
+  glm::mat4 device_T_opengl_depth_camera_;
+  glm::mat4 opengl_depth_camera_T_device_;
+};
+}  // namespace tango_gl
+#endif  // TANGO_GL_DEVICE_EXTRINSICS_H_
@@ -0,0 +1,181 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TANGO_GL_DRAW_BATCH_H_
+#define TANGO_GL_DRAW_BATCH_H_
+
+#include <stdint.h>
+
+#include <memory>
+#include <vector>
+
+#include "tango-gl/axis.h"
+#include "tango-gl/mesh.h"
+#include "tango-gl/object_store.h"
+#include "tango-gl/vertex_array.h"
+#include "tango-gl/vertex_buffer.h"
+
+namespace tango_gl {
+
+// DrawBatch renders many Mesh (e.g. Cube, GoalMarker) and Axis objects with
+// as few state changes as possible. Added objects are grouped by shader and
+// geometry, and each group is drawn with one instanced draw call, the model
+// matrix and color of every object being streamed as per instance
+// attributes. On contexts without instancing (neither OpenGL ES 3.0,
+// GL_EXT_instanced_arrays nor GL_ANGLE_instanced_arrays) a group still
+// shares one program and one set of vertex buffers, and issues one draw per
+// object.
+//
+// Like a pre-recorded command buffer, the attribute setup of each group is
+// recorded once in a vertex array object, and the instance data stays on
+// the GPU between frames: only objects whose transform or color changed
+// are uploaded again, so static content costs a bind and a draw call per
+// group. Vulkan is not an option: the examples build for android-19, and the
+// Vulkan loader ships from API 24 on.
+//
+// The geometry of an object is captured when it is added; add it again after
+// changing its vertices. Transforms and colors are read on every Render().
+// Lit meshes of a group share the light direction of the first one.
+//
+// An ObjectStore is drawn with a group per mesh of the store, its instance
+// data taken as the store packed it for the visible objects.
+//
+// The batch does not own the objects, they must be removed before they are
+// deleted. All functions must be called on the GL thread.
+class DrawBatch {
+ public:
+  DrawBatch();
+  DrawBatch(const DrawBatch& other) = delete;
+  const DrawBatch& operator=(const DrawBatch&) = delete;
+  ~DrawBatch();
+
+  // Add an object to the batch, or update its geometry if already added.
+  void Add(const Mesh* mesh);
+  void Add(const Axis* axis);
+
+  // Add the objects of a store, or update the meshes of a store already
+  // added, e.g. after ObjectStore::AddMesh(). The store is drawn as of its
+  // last ObjectStore::Update().
+  void Add(const ObjectStore* store);
+
+  // Remove an object from the batch. No-op if it was not added.
+  void Remove(const DrawableObject* object);
+
+  // Remove the objects of a store. No-op if it was not added.
+  void Remove(const ObjectStore* store);
+
+  // Remove all objects.
+  void Clear();
+
+  // Render all objects of the batch.
+  void Render(const glm::mat4& projection_mat, const glm::mat4& view_mat);
+
+  // Release the GL resources of the batch. The objects stay in the batch.
+  void Release();
+
+  // Forget the GL resources without deleting them. Use this when the GL
+  // context they belonged to has been destroyed.
+  void Invalidate();
+
+ private:
+  enum GroupType { kUnlitMesh, kLitMesh, kAxis };
+
+  // Objects sharing a shader and a geometry.
+  struct Group {
+    Group();
+
+    GroupType type;
+    GLenum render_mode;
+    float line_width;
+    uint64_t geometry_hash;
+
+    // Interleaved vertex data, position followed by a normal (kLitMesh) or a
+    // color (kAxis) per vertex.
+    std::vector<GLfloat> vertices;
+    std::vector<GLushort> indices;
+    GLsizei vertex_count;
+    bool is_geometry_dirty;
+
+    VertexBuffer vertex_buffer;
+    VertexBuffer index_buffer;
+
+    // Model matrix and color of each object as last uploaded to
+    // instance_buffer, compared on every Render() to upload only the
+    // objects that changed.
+    std::vector<GLfloat> instances;
+    VertexBuffer instance_buffer;
+    // Attribute setup of the group, recorded on its first draw.
+    VertexArray vertex_array;
+
+    // Shared geometry of the first object holding one. Other objects
+    // holding it join the group without their vertex data being compared.
+    std::shared_ptr<const Geometry> shared_geometry;
+
+    std::vector<const DrawableObject*> objects;
+
+    // Store and mesh the instances come from instead, for the groups of an
+    // ObjectStore.
+    const ObjectStore* store;
+    uint32_t store_mesh;
+  };
+
+  // Program and locations of one group type.
+  struct Program {
+    GLuint program;
+    GLint uniform_vp_mat;
+    GLint uniform_view_mat;
+    GLint uniform_light_vec;
+    GLint uniform_ambient;
+    GLint attrib_vertices;
+    GLint attrib_normals;
+    GLint attrib_colors;
+    GLint attrib_model_mat;
+    GLint attrib_instance_color;
+  };
+
+  // Move the object into the group matching the key, creating it if needed.
+  Group* AddToGroup(const DrawableObject* object, GroupType type,
+                    GLenum render_mode, float line_width,
+                    uint64_t geometry_hash);
+
+  // Interleave the vertices of a mesh as the group type draws them.
+  //
+  // @return false if the mesh keeps no CPU side vertices.
+  static bool GetMeshVertices(const Mesh* mesh, GroupType type,
+                              std::vector<GLfloat>* vertices);
+
+  // Add the object to the group already drawing its shared geometry.
+  //
+  // @return false if there is no such group, or the object has no shared
+  //         geometry.
+  bool AddToSharedGroup(const DrawableObject* object,
+                        const std::shared_ptr<const Geometry>& geometry,
+                        GroupType type, GLenum render_mode, float line_width);
+
+  // Compile the programs and resolve the instancing entry points, once per
+  // context.
+  void InitializeGL();
+
+  void RenderGroup(Group* group, const glm::mat4& vp_mat,
+                   const glm::mat4& view_mat);
+
+  std::vector<std::unique_ptr<Group>> groups_;
+
+  bool is_gl_initialized_;
+  Program programs_[3];
+};
+}  // namespace tango_gl
+#endif  // TANGO_GL_DRAW_BATCH_H_
@@ -17,19 +17,24 @@
 #ifndef TANGO_GL_DRAWABLE_OBJECT_H_
 #define TANGO_GL_DRAWABLE_OBJECT_H_
 
+#include <memory>
 #include <vector>
 
 #include "tango-gl/color.h"
+#include "tango-gl/geometry_registry.h"
 #include "tango-gl/transform.h"
 #include "tango-gl/util.h"
 
 namespace tango_gl {
 class DrawableObject : public Transform {
  public:
-  DrawableObject() : red_(0), green_(0), blue_(0), alpha_(1.0f) {};
+  DrawableObject()
+      : red_(0), green_(0), blue_(0), alpha_(1.0f),
+        is_vertex_data_dirty_(true), shader_program_(0),
+        uses_frame_constants_(false) {};
   DrawableObject(const DrawableObject& other) = delete;
   const DrawableObject& operator=(const DrawableObject&) = delete;
-  ~DrawableObject();
+  virtual ~DrawableObject();
 
   void SetShader();
   void SetColor(const Color& color);
@@ -40,10 +45,27 @@ class DrawableObject : public Transform {
                    const std::vector<GLushort>& indices);
   void SetVertices(const std::vector<GLfloat>& vertices,
                    const std::vector<GLfloat>& normals);
+  void SetVertices(const std::vector<GLfloat>& vertices,
+                   const std::vector<GLfloat>& normals,
+                   const std::vector<GLushort>& indices);
   virtual void Render(const glm::mat4& projection_mat,
                       const glm::mat4& view_mat) const = 0;
 
+  // Texture sampled by Render(), 0 if none. SceneGraph sorts drawables by
+  // it.
+  virtual GLuint GetTextureId() const { return 0; }
+
  protected:
+  friend class DrawBatch;
+  friend class SceneGraph;
+
+  // Upload the transform of a draw to the current program: the model matrix
+  // when the program reads the camera from FrameConstants, else
+  // projection_mat * view_mat * model_mat to uniform_mvp_mat_.
+  void SetTransformUniforms(const glm::mat4& projection_mat,
+                            const glm::mat4& view_mat,
+                            const glm::mat4& model_mat) const;
+
   float red_;
   float green_;
   float blue_;
@@ -51,11 +73,22 @@ class DrawableObject : public Transform {
   std::vector<GLushort> indices_;
   std::vector<GLfloat> vertices_;
   std::vector<GLfloat> normals_;
+  // Vertex data shared with other drawables of the same shape, used instead
+  // of the vectors above when set. SetVertices() drops it.
+  std::shared_ptr<const Geometry> geometry_;
+  // Set by SetVertices(), for subclasses keeping a GPU copy of the vertex
+  // data to know when it has to be uploaded again.
+  mutable bool is_vertex_data_dirty_;
 
   GLenum render_mode_;
+  // Owned through program_cache, released by the destructor.
   GLuint shader_program_;
   GLuint uniform_color_;
   GLuint uniform_mvp_mat_;
+  // Set for shader_variants::kFrameConstants programs, which take
+  // uniform_model_mat_ instead of uniform_mvp_mat_.
+  bool uses_frame_constants_;
+  GLuint uniform_model_mat_;
   GLuint attrib_vertices_;
   GLuint attrib_normals_;
 };
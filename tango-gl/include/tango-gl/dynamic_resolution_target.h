@@ -0,0 +1,160 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TANGO_GL_DYNAMIC_RESOLUTION_TARGET_H_
+#define TANGO_GL_DYNAMIC_RESOLUTION_TARGET_H_
+
+#include "tango-gl/util.h"
+#include "tango-gl/vertex_buffer.h"
+
+namespace tango_gl {
+
+// DynamicResolutionTarget renders virtual content at a fraction of the
+// screen resolution and composites it over what is already on screen, e.g.
+// the camera image, with a bilinear upscale. The camera image keeps its
+// native resolution while the fill rate of the virtual content shrinks with
+// the square of the scale; a QualityGovernor measuring GPU time is the usual
+// source of the scale.
+//
+// Content is drawn between Begin() and End() into a color texture and depth
+// buffer cleared to transparent, and composited as premultiplied alpha. That
+// is exact for opaque content; blended content should write its alpha with
+// glBlendFuncSeparate(..., GL_ONE, GL_ONE_MINUS_SRC_ALPHA). At scale 1, or if
+// the framebuffer can not be created, Begin() draws to the screen directly
+// and End() is a no-op.
+//
+// With SetRetainContent(), the content always goes to the target and stays
+// there after End(), so a frame that can not render the content in time can
+// composite the previous one again with CompositeReprojected(), warped to
+// the latest camera pose.
+//
+// All functions must be called on the GL thread.
+class DynamicResolutionTarget {
+ public:
+  // Smallest scale, below it virtual content turns to mush.
+  static const float kMinScale;
+
+  DynamicResolutionTarget();
+  DynamicResolutionTarget(const DynamicResolutionTarget& other) = delete;
+  const DynamicResolutionTarget& operator=(const DynamicResolutionTarget&) =
+      delete;
+  ~DynamicResolutionTarget();
+
+  // Set the rectangle of the screen the content covers, in pixels of the
+  // default framebuffer.
+  void SetViewport(GLint x, GLint y, GLsizei width, GLsizei height);
+
+  // Set the fraction of the viewport resolution to render at, clamped to
+  // [kMinScale, 1]. The target is reallocated by the next Begin() if its
+  // size changes, so the scale should come from a ladder rather than change
+  // every frame.
+  void SetScale(float scale);
+  float GetScale() const { return scale_; }
+
+  // Render the content to the target even at scale 1, so it can be
+  // composited again by CompositeReprojected().
+  void SetRetainContent(bool retain) { is_retaining_content_ = retain; }
+
+  // Composite the target without blending, replacing what is on screen. For
+  // content that covers the whole viewport, e.g. a scene cleared to a color,
+  // whose alpha may have been lowered by blended drawables.
+  void SetOpaque(bool opaque) { is_opaque_ = opaque; }
+
+  // Whether the target holds content for CompositeReprojected().
+  bool HasRetainedContent() const { return has_content_; }
+
+  // Reprojection of the content rendered with view matrix render_view_mat to
+  // a camera at view_mat, both with projection_mat. Only the rotation between
+  // the two views is undone, the usual late-stage warp: it is exact for
+  // distant content and for pure rotations, and lags by the translation
+  // otherwise.
+  //
+  // @return: homography from normalized device coordinates of the new view
+  //          to homogeneous normalized device coordinates of the target.
+  static glm::mat3 GetReprojection(const glm::mat4& projection_mat,
+                                   const glm::mat4& render_view_mat,
+                                   const glm::mat4& view_mat);
+
+  // Start rendering the content: bind the target, set the viewport to its
+  // size and clear it, or set the screen viewport and clear the depth buffer
+  // when drawing directly.
+  //
+  // @return: true if the content goes to the target.
+  bool Begin();
+
+  // Bind the default framebuffer and composite the target over it. Leaves
+  // the viewport set to the screen rectangle.
+  void End();
+
+  // Composite the content of the last End() again, warped by a reprojection
+  // from GetReprojection(). Needs SetRetainContent() before that frame.
+  // Leaves the viewport set to the screen rectangle.
+  //
+  // @return: false if there is no retained content.
+  bool CompositeReprojected(const glm::mat3& reprojection);
+
+  // Size of the target in pixels, 0 before the first Begin() at scale < 1.
+  GLsizei GetTargetWidth() const { return target_width_; }
+  GLsizei GetTargetHeight() const { return target_height_; }
+
+  // Release the framebuffer, its attachments and the shader program.
+  void Release();
+
+  // Forget the GL objects without deleting them. Use this when the GL
+  // context they belonged to has been destroyed.
+  void Invalidate();
+
+ private:
+  // Create or resize the target for the current viewport and scale.
+  bool Allocate(GLsizei width, GLsizei height);
+
+  // Bind the default framebuffer and draw the color texture over the screen
+  // rectangle with the program in use, blending premultiplied alpha unless
+  // opaque.
+  void DrawTarget(GLint attrib_vertices);
+
+  GLint viewport_x_;
+  GLint viewport_y_;
+  GLsizei viewport_width_;
+  GLsizei viewport_height_;
+  float scale_;
+
+  GLuint framebuffer_;
+  GLuint color_texture_;
+  GLuint depth_renderbuffer_;
+  GLsizei target_width_;
+  GLsizei target_height_;
+  // Set when the framebuffer was incomplete, the content is then drawn
+  // directly until Release() or Invalidate().
+  bool is_unsupported_;
+  // Whether the content of the current frame went to the target.
+  bool is_offscreen_;
+  bool is_retaining_content_;
+  bool is_opaque_;
+  // Whether the target holds the content of the last End().
+  bool has_content_;
+
+  GLuint shader_program_;
+  GLint attrib_vertices_;
+  GLint uniform_image_;
+  GLuint reprojection_program_;
+  GLint reprojection_attrib_vertices_;
+  GLint reprojection_uniform_image_;
+  GLint reprojection_uniform_matrix_;
+  VertexBuffer vertex_buffer_;
+};
+}  // namespace tango_gl
+#endif  // TANGO_GL_DYNAMIC_RESOLUTION_TARGET_H_
@@ -0,0 +1,187 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_GL_ENERGY_MONITOR_H_
+#define TANGO_GL_ENERGY_MONITOR_H_
+
+#include <stdint.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "tango-gl/frame_profiler.h"
+
+namespace tango_gl {
+
+// EnergyMonitor estimates what rendering and depth processing cost in
+// battery, so features can be compared by energy as well as by time, e.g.
+// the YUV and the texture id paths of the video overlay.
+//
+// A thread samples sysfs at a low rate, 4 Hz by default: the current and
+// voltage of the battery from /sys/class/power_supply, and the time spent
+// at each frequency by the CPUs from the cpufreq statistics. The energy of
+// each interval, the mean power of its two ends times its duration, is
+// attributed to the state set by the application, e.g. a QualityGovernor
+// level or an overlay mode, together with the frames and depth frames
+// counted over the interval and the CPU frequency residency. Intervals
+// while the battery charges count time only, the current then says nothing
+// about the load.
+//
+// The battery current is the whole device, screen and radios included, so
+// the energy per frame is only comparable between states measured on the
+// same device with the same screen brightness. Devices without the sysfs
+// nodes report no energy; cpufreq statistics are optional as well.
+//
+// OnFrame(), OnDepthFrame() and SetState() can be called from any thread,
+// Update() from the thread owning the profiler.
+class EnergyMonitor {
+ public:
+  struct Options {
+    Options() : sample_period_ms(250), sysfs_root("/sys") {}
+
+    // Time between two samples.
+    int sample_period_ms;
+    // Where sysfs is mounted, another directory for tests.
+    std::string sysfs_root;
+  };
+
+  // Time spent at each frequency by the CPUs of a cpufreq policy.
+  struct CpuResidency {
+    // First CPU of the policy.
+    int cpu;
+    std::vector<uint32_t> frequencies_khz;
+    std::vector<uint64_t> times_ms;
+
+    // Mean frequency in kHz weighted by the time, 0 without time.
+    float GetMeanFrequency() const;
+    // Fraction of the time at the highest frequency.
+    float GetMaxFrequencyFraction() const;
+  };
+
+  // What was measured in a state.
+  struct StateTotals {
+    StateTotals();
+
+    std::string state;
+    // Time sampled on battery, and while charging.
+    double seconds;
+    double charging_seconds;
+    double energy_mj;
+    uint64_t frame_count;
+    uint64_t depth_frame_count;
+    std::vector<CpuResidency> cpus;
+
+    float GetMeanPowerMw() const;
+    // Energy per frame and per depth frame in millijoules, 0 without frames.
+    float GetFrameEnergyMj() const;
+    float GetDepthFrameEnergyMj() const;
+  };
+
+  explicit EnergyMonitor(const Options& options = Options());
+  EnergyMonitor(const EnergyMonitor& other) = delete;
+  const EnergyMonitor& operator=(const EnergyMonitor&) = delete;
+  ~EnergyMonitor();
+
+  // Find the sysfs nodes and start sampling. No-op if already started.
+  //
+  // @return false if the battery can not be read, the CPU residency is
+  //         still sampled.
+  bool Start();
+
+  // Take a last sample and stop the thread.
+  void Stop();
+
+  // Attribute what is measured from now on to a state, e.g. "quality 2". The
+  // interval so far is closed with a sample first. The initial state is
+  // "default".
+  void SetState(const std::string& state);
+
+  // Count a rendered frame, and a processed depth frame.
+  void OnFrame() { frame_count_.fetch_add(1, std::memory_order_relaxed); }
+  void OnDepthFrame() {
+    depth_frame_count_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  // Set the profiler counters "powerMW", the power of the last interval,
+  // and "frameMJ", its energy per frame, so they show next to the zones.
+  void Update(FrameProfiler* profiler);
+
+  // Whether the battery current and voltage could be read.
+  bool HasBattery() const { return !battery_path_.empty(); }
+
+  std::vector<StateTotals> GetTotals() const;
+
+  // Forget the totals of all states, e.g. before comparing two modes.
+  void Reset();
+
+  // A line per state with time, e.g. "quality 2: 61.0 s 2310 mW 77.0
+  // mJ/frame 462.1 mJ/depth frame, cpu0 1190 MHz 12% max, cpu4 ...".
+  std::string GetReport() const;
+
+ private:
+  // cpufreq statistics of a policy, and their last reading.
+  struct CpuStatsFile {
+    int cpu;
+    std::string path;
+    std::vector<uint32_t> frequencies_khz;
+    std::vector<uint64_t> last_times_ms;
+  };
+
+  // Locate the battery and the cpufreq statistics.
+  void FindNodes();
+
+  // Read the battery and the CPU statistics, and add the interval since the
+  // last sample to the current state. Called with mutex_ held.
+  void Sample();
+
+  // Index of a state in totals_, added if new. Called with mutex_ held.
+  size_t GetStateIndex(const std::string& state);
+
+  void Run();
+
+  const Options options_;
+  std::string battery_path_;
+
+  mutable std::mutex mutex_;
+  std::condition_variable stop_condition_;
+  std::thread thread_;
+  bool is_running_;
+
+  std::vector<StateTotals> totals_;
+  size_t state_;
+  std::vector<CpuStatsFile> cpu_stats_;
+
+  bool has_last_sample_;
+  std::chrono::steady_clock::time_point last_sample_time_;
+  float last_power_mw_;
+  uint64_t last_frame_count_;
+  uint64_t last_depth_frame_count_;
+
+  std::atomic<uint64_t> frame_count_;
+  std::atomic<uint64_t> depth_frame_count_;
+
+  // Of the last interval, for Update().
+  std::atomic<float> interval_power_mw_;
+  std::atomic<float> interval_frame_mj_;
+};
+}  // namespace tango_gl
+#endif  // TANGO_GL_ENERGY_MONITOR_H_
@@ -0,0 +1,133 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_GL_EVENT_BUS_H_
+#define TANGO_GL_EVENT_BUS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <functional>
+#include <vector>
+
+#include <tango_client_api.h>  // NOLINT
+
+#include "tango-gl/bounded_queue.h"
+
+namespace tango_gl {
+
+// EventBus carries the events of TangoService_connectOnTangoEvent() from the
+// callback thread to subscribers on a consumer thread, e.g. the GL thread, as
+// typed events instead of key and value strings.
+//
+// Publish() interns the key into an EventId by its hash, compared against
+// the hashes of the known keys computed at compile time, parses the value
+// once into a number, and copies the event into a lock-free ring: a fixed
+// amount of work per event and no allocation on the callback thread.
+// Dispatch() then calls the subscribers of each queued event in order, so
+// handlers switch on an id rather than compare strings.
+//
+// Subscribe(), Unsubscribe() and Dispatch() are called from the consumer
+// thread, Publish() from any thread.
+class EventBus {
+ public:
+  // The keys documented with TangoEvent.
+  enum EventId {
+    kUnknownEvent,
+    kServiceException,
+    kFisheyeOverExposed,
+    kFisheyeUnderExposed,
+    kColorOverExposed,
+    kColorUnderExposed,
+    kTooFewFeaturesTracked,
+    kAreaDescriptionSaveProgress,
+    kEventIdCount
+  };
+
+  // Longest text kept in an event, longer ones are truncated.
+  static const size_t kMaxTextLength = 47;
+
+  struct Event {
+    EventId id;
+    TangoEventType type;
+    double timestamp;
+    // Whether the value is a number, e.g. the average pixel value of the
+    // exposure events or the fraction saved of kAreaDescriptionSaveProgress.
+    bool has_number;
+    double number;
+    // The key of kUnknownEvent, or the value when it is not a number, e.g.
+    // the description of kServiceException.
+    char text[kMaxTextLength + 1];
+  };
+
+  typedef std::function<void(const Event& event)> Handler;
+
+  // Events queued between two Dispatch() before new ones are dropped.
+  static const size_t kDefaultCapacity = 64;
+
+  explicit EventBus(size_t capacity = kDefaultCapacity);
+  EventBus(const EventBus& other) = delete;
+  const EventBus& operator=(const EventBus&) = delete;
+
+  // Call a handler for the events of an id, kUnknownEvent for the events of
+  // keys not known.
+  //
+  // @return a token for Unsubscribe().
+  int Subscribe(EventId id, const Handler& handler);
+
+  // Call a handler for every event.
+  int SubscribeAll(const Handler& handler);
+
+  void Unsubscribe(int token);
+
+  // Queue an event of the Tango event callback.
+  //
+  // @return false if the queue is full and the event was dropped.
+  bool Publish(const TangoEvent* event);
+
+  // Call the subscribers of the queued events, in order.
+  //
+  // @return number of events dispatched.
+  size_t Dispatch();
+
+  // Events dropped on a full queue so far, from any thread.
+  uint64_t GetDroppedCount() const {
+    return dropped_count_.load(std::memory_order_relaxed);
+  }
+
+  // The id of a key, kUnknownEvent for nullptr or an unknown key.
+  static EventId Intern(const char* key);
+
+  // The key of an id, "Unknown" for kUnknownEvent.
+  static const char* GetKey(EventId id);
+
+ private:
+  struct Subscription {
+    int token;
+    // kEventIdCount for every event.
+    EventId id;
+    Handler handler;
+  };
+
+  BoundedQueue<Event> events_;
+  std::atomic<uint64_t> dropped_count_;
+  std::vector<Subscription> subscriptions_;
+  int next_token_;
+};
+}  // namespace tango_gl
+#endif  // TANGO_GL_EVENT_BUS_H_
@@ -0,0 +1,170 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+
+#ifndef TANGO_GL_FRAME_ARENA_H_
+#define TANGO_GL_FRAME_ARENA_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+namespace tango_gl {
+
+// FrameArena is a bump allocator for scratch memory that lives no longer
+// than a frame. Allocate() moves a pointer forward and Reset() rewinds it, so
+// once the arena has grown to the largest frame seen, per frame scratch takes
+// no heap allocation at all.
+//
+// When a frame outgrows the current block another one is chained. Reset()
+// then replaces all blocks with a single one large enough for the whole
+// frame, so the next frames fit again.
+//
+// ForThisThread() gives every thread its own arena. RenderState::BeginFrame()
+// resets the one of the GL thread; code that also runs on other threads
+// allocates within a Scope, which rewinds on exit.
+//
+// Memory is never freed individually and destructors are not run, keep to
+// trivially destructible data or containers using ArenaAllocator. A
+// FrameArena is not thread safe.
+class FrameArena {
+ public:
+  static const size_t kDefaultBlockSize = 64 * 1024;
+
+  // Allocation point to rewind to, see Scope.
+  struct Mark {
+    uint32_t generation;
+    size_t block;
+    size_t offset;
+    size_t bytes_used;
+  };
+
+  // Rewind the arena to where it was on construction when going out of
+  // scope, so nested code may allocate freely without a frame loop.
+  class Scope {
+   public:
+    explicit Scope(FrameArena* arena)
+        : arena_(arena), mark_(arena->GetMark()) {}
+    Scope(const Scope& other) = delete;
+    const Scope& operator=(const Scope&) = delete;
+    ~Scope() { arena_->Rewind(mark_); }
+
+   private:
+    FrameArena* arena_;
+    Mark mark_;
+  };
+
+  // @param block_size: size of the first block, allocated lazily.
+  explicit FrameArena(size_t block_size = kDefaultBlockSize);
+  FrameArena(const FrameArena& other) = delete;
+  const FrameArena& operator=(const FrameArena&) = delete;
+  ~FrameArena();
+
+  // @param size: number of bytes.
+  // @param alignment: a power of two.
+  // @return uninitialized memory valid until the next Reset(), or Rewind()
+  //         to an earlier mark.
+  void* Allocate(size_t size, size_t alignment);
+
+  // Allocate an uninitialized array of count elements of T.
+  template <typename T>
+  T* AllocateArray(size_t count) {
+    return static_cast<T*>(Allocate(count * sizeof(T), alignof(T)));
+  }
+
+  // Release every allocation. Marks taken before are not rewound to anymore.
+  void Reset();
+
+  Mark GetMark() const;
+  // Release the allocations made since the mark was taken.
+  void Rewind(const Mark& mark);
+
+  // Bytes handed out since the last Reset(), alignment padding included.
+  size_t GetBytesUsed() const { return bytes_used_; }
+  // Largest GetBytesUsed() so far.
+  size_t GetHighWaterMark() const { return high_water_mark_; }
+  // Bytes held in blocks.
+  size_t GetCapacity() const { return capacity_; }
+  // Number of blocks allocated from the heap so far. Stays constant in
+  // steady state.
+  size_t GetHeapAllocationCount() const { return heap_allocation_count_; }
+
+  // Arena of the calling thread, created on first use and freed when the
+  // thread exits.
+  static FrameArena& ForThisThread();
+
+ private:
+  struct Block {
+    uint8_t* data;
+    size_t size;
+  };
+
+  // Chain a block of at least size bytes after the current one.
+  void AddBlock(size_t size);
+  void FreeBlocks();
+
+  size_t block_size_;
+  std::vector<Block> blocks_;
+  // Current block and offset in it.
+  size_t block_;
+  size_t offset_;
+  // Bumped by Reset() so stale marks are ignored.
+  uint32_t generation_;
+
+  size_t bytes_used_;
+  size_t high_water_mark_;
+  size_t capacity_;
+  size_t heap_allocation_count_;
+};
+
+// STL allocator drawing from a FrameArena, deallocate() is a no-op. The
+// container must not outlive the allocations, e.g. a local vector within a
+// Scope.
+template <typename T>
+class ArenaAllocator {
+ public:
+  typedef T value_type;
+
+  explicit ArenaAllocator(FrameArena* arena) : arena_(arena) {}
+  template <typename U>
+  ArenaAllocator(const ArenaAllocator<U>& other) : arena_(other.GetArena()) {}
+
+  T* allocate(size_t count) { return arena_->AllocateArray<T>(count); }
+  void deallocate(T*, size_t) {}
+
+  FrameArena* GetArena() const { return arena_; }
+
+ private:
+  FrameArena* arena_;
+};
+
+template <typename T, typename U>
+bool operator==(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) {
+  return a.GetArena() == b.GetArena();
+}
+
+template <typename T, typename U>
+bool operator!=(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) {
+  return a.GetArena() != b.GetArena();
+}
+
+template <typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+}  // namespace tango_gl
+#endif  // TANGO_GL_FRAME_ARENA_H_
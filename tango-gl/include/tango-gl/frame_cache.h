@@ -0,0 +1,115 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_GL_FRAME_CACHE_H_
+#define TANGO_GL_FRAME_CACHE_H_
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "tango-gl/dynamic_resolution_target.h"
+#include "tango-gl/util.h"
+
+namespace tango_gl {
+
+// FrameCache skips rendering a scene that did not change since the last
+// frame it rendered, and presents that frame again instead. Viewers of a
+// still device, e.g. a third person or top down camera waiting for the next
+// depth frame or touch, then cost one textured quad per frame.
+//
+// Each frame, the caller lists what goes into the scene with AddInput():
+// camera matrices, drawable transformations, timestamps of the data drawn.
+// Begin() compares the list with the one of the last rendered frame.
+// Matrices match within a tolerance, so the jitter of the pose of a device
+// lying on a table does not count as a change, and values match exactly.
+// Changes the inputs do not capture, e.g. a drawable edited in place, are
+// reported with MarkDirty().
+//
+// The scene is rendered into a retained DynamicResolutionTarget, since the
+// content of the default framebuffer is undefined after a swap, and
+// replaces the viewport when presented: the scene must clear it. Content
+// drawn after End(), e.g. a HUD, is drawn every frame. If the target can not
+// be created, every frame is rendered to the screen.
+//
+// All functions must be called on the GL thread.
+class FrameCache {
+ public:
+  // Default largest difference of a matrix element that is not a change.
+  static const float kDefaultTolerance;
+
+  FrameCache();
+  FrameCache(const FrameCache& other) = delete;
+  const FrameCache& operator=(const FrameCache&) = delete;
+
+  // Set the rectangle of the screen the scene covers, in pixels of the
+  // default framebuffer. A new rectangle is a change.
+  void SetViewport(GLint x, GLint y, GLsizei width, GLsizei height);
+
+  void SetTolerance(float tolerance) { tolerance_ = tolerance; }
+
+  // Add an input of the current frame, compared within the tolerance.
+  void AddInput(const glm::mat4& matrix);
+
+  // Add an input of the current frame compared exactly, e.g. the timestamp
+  // of a point cloud or a count.
+  void AddInput(double value);
+
+  // Render the next frame whatever its inputs.
+  void MarkDirty() { is_marked_dirty_ = true; }
+
+  // Whether the inputs added since the last Begin() differ from those of
+  // the last rendered frame.
+  bool IsDirty() const;
+
+  // Start a frame. If it is dirty, or no frame was rendered yet, bind the
+  // target for the scene; otherwise present the last rendered frame. Either
+  // way the inputs are cleared for the next frame.
+  //
+  // @return: true if the scene has to be rendered, followed by End().
+  bool Begin();
+
+  // Bind the default framebuffer and present the frame just rendered.
+  void End();
+
+  // Frames rendered and frames presented again since construction.
+  uint64_t GetRenderedFrameCount() const { return rendered_frame_count_; }
+  uint64_t GetReusedFrameCount() const { return reused_frame_count_; }
+
+  // Release the target.
+  void Release();
+
+  // Forget the GL objects without deleting them. Use this when the GL
+  // context they belonged to has been destroyed.
+  void Invalidate();
+
+ private:
+  float tolerance_;
+  // Inputs of the current frame, and of the last rendered frame.
+  std::vector<float> inputs_;
+  std::vector<float> rendered_inputs_;
+  std::vector<double> exact_inputs_;
+  std::vector<double> rendered_exact_inputs_;
+  bool is_marked_dirty_;
+
+  uint64_t rendered_frame_count_;
+  uint64_t reused_frame_count_;
+
+  DynamicResolutionTarget target_;
+};
+}  // namespace tango_gl
+#endif  // TANGO_GL_FRAME_CACHE_H_
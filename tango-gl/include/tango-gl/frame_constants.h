@@ -0,0 +1,70 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_GL_FRAME_CONSTANTS_H_
+#define TANGO_GL_FRAME_CONSTANTS_H_
+
+#include "tango-gl/util.h"
+
+namespace tango_gl {
+
+// FrameConstants holds the camera matrices shared by the draws of a frame,
+// so they are multiplied and uploaded once instead of once per drawable.
+//
+// On GLES3 contexts the matrices go into a uniform buffer, read by the
+// shader_variants::kFrameConstants variants through the block
+//
+//   layout(std140) uniform FrameConstants {
+//     mat4 projection;
+//     mat4 view;
+//     mat4 vp;
+//   };
+//
+// and a draw only uploads its model matrix. Each change of the matrices is
+// written to the next slot of a ring in the buffer, so a change does not
+// overwrite the slot earlier draws of the frame still read. On GLES2
+// contexts only the view projection matrix is cached.
+//
+// All functions must be called on the GL thread.
+class FrameConstants {
+ public:
+  FrameConstants() = delete;
+
+  // Uniform buffer binding point of the FrameConstants block.
+  static const GLuint kBindingPoint = 0;
+
+  // Set the camera of the following draws. Does nothing when the matrices
+  // did not change, so drawables can call it on every draw with the
+  // matrices they are given.
+  static void Set(const glm::mat4& projection_mat, const glm::mat4& view_mat);
+
+  // projection_mat * view_mat, without the multiplication when they are the
+  // matrices of the last Set().
+  static glm::mat4 GetViewProjection(const glm::mat4& projection_mat,
+                                     const glm::mat4& view_mat);
+
+  // Whether the current context has uniform buffers.
+  static bool HasUniformBuffers();
+
+  // Bind the FrameConstants block of a linked program to kBindingPoint.
+  //
+  // @return false if the context has no uniform buffers or the program no
+  //         FrameConstants block.
+  static bool BindBlock(GLuint program);
+};
+}  // namespace tango_gl
+#endif  // TANGO_GL_FRAME_CONSTANTS_H_
@@ -0,0 +1,205 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_GL_FRAME_PROFILER_H_
+#define TANGO_GL_FRAME_PROFILER_H_
+
+#include <EGL/egl.h>
+
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "tango-gl/util.h"
+
+namespace tango_gl {
+
+// FrameProfiler measures where frame time goes. CPU zones time a block of
+// code on the calling thread, GPU zones time the GL commands issued inside
+// them with GL_EXT_disjoint_timer_query, when available. Each zone keeps a
+// rolling window of samples and reports its median and 99th percentile.
+// The time between two BeginFrame() calls is recorded in the "frame" zone.
+//
+// GPU results are read back a few frames later, without stalling the
+// pipeline. GPU zones can not nest, CPU zones can.
+//
+// All functions except GetReport() must be called on the GL thread.
+class FrameProfiler {
+ public:
+  FrameProfiler();
+  FrameProfiler(const FrameProfiler& other) = delete;
+  const FrameProfiler& operator=(const FrameProfiler&) = delete;
+  ~FrameProfiler();
+
+  // Start a frame: collect the GPU timings that became available and record
+  // the frame time.
+  void BeginFrame();
+
+  // Start and end a CPU zone. Zones are identified by name, which should be
+  // a string literal.
+  void BeginCpuZone(const char* name);
+  void EndCpuZone();
+
+  // Start and end a GPU zone. No-op without timer query support.
+  void BeginGpuZone(const char* name);
+  void EndGpuZone();
+
+  // Record a per frame statistic which is not a duration, e.g. the number
+  // of culled drawables. Call it once per frame per counter, the report
+  // shows its median and 99th percentile like for zones.
+  void SetCounter(const char* name, float value);
+
+  // Percentile of the CPU samples of a zone in milliseconds, e.g. 0.9 for
+  // the 90th percentile of the "frame" zone. Sets sample_count to the number
+  // of samples in the window when not null. Returns 0 for an unknown zone.
+  // Can be called from any thread.
+  float GetCpuPercentile(const char* name, float percentile,
+                         size_t* sample_count) const;
+
+  // The same for the GPU samples of a zone. The window is empty without
+  // timer query support.
+  float GetGpuPercentile(const char* name, float percentile,
+                         size_t* sample_count) const;
+
+  // Forget the samples of a zone, e.g. after a change which makes the older
+  // timings meaningless.
+  void ClearZone(const char* name);
+
+  // Release the timer queries.
+  void Release();
+
+  // Forget the timer queries without deleting them. Use this when the GL
+  // context they belonged to has been destroyed.
+  void Invalidate();
+
+  // Whether GPU zones are measured in the current context.
+  bool HasGpuTimers() const { return begin_query_ != nullptr; }
+
+  // A line per zone, in order of first use, e.g.
+  // "frame cpu p50 16.6 p99 33.1 ms", or "culled p50 12 p99 40" for a
+  // counter. Can be called from any thread.
+  std::string GetReport() const;
+
+ private:
+  typedef std::chrono::steady_clock Clock;
+
+  typedef void (GL_APIENTRY* GenQueriesFunc)(GLsizei n, GLuint* ids);
+  typedef void (GL_APIENTRY* DeleteQueriesFunc)(GLsizei n, const GLuint* ids);
+  typedef void (GL_APIENTRY* BeginQueryFunc)(GLenum target, GLuint id);
+  typedef void (GL_APIENTRY* EndQueryFunc)(GLenum target);
+  typedef void (GL_APIENTRY* GetQueryObjectuivFunc)(GLuint id, GLenum pname,
+                                                     GLuint* params);
+  typedef void (GL_APIENTRY* GetQueryObjectui64vFunc)(GLuint id, GLenum pname,
+                                                       uint64_t* params);
+
+  // Rolling window of timings in milliseconds.
+  struct Samples {
+    Samples() : next(0) {}
+    void Add(float value);
+    float GetPercentile(float percentile) const;
+    void Clear();
+
+    std::vector<float> values;
+    size_t next;
+  };
+
+  struct Zone {
+    std::string name;
+    Samples cpu;
+    Samples gpu;
+    Samples counter;
+  };
+
+  struct OpenCpuZone {
+    size_t zone;
+    Clock::time_point start;
+  };
+
+  struct PendingQuery {
+    GLuint query;
+    size_t zone;
+  };
+
+  // Index of a zone, added on first use. Called with mutex_ held.
+  size_t GetZone(const char* name);
+
+  // Zone of a name, nullptr if it was never used. Called with mutex_ held.
+  const Zone* FindZone(const char* name) const;
+
+  // Resolve the timer query entry points of the current context.
+  void ResolveGpuTimers();
+
+  // Read back the finished GPU queries.
+  void CollectGpuTimings();
+
+  // Guards zones_, which also holds the counters, written on the GL thread
+  // and read by GetReport().
+  mutable std::mutex mutex_;
+  std::vector<Zone> zones_;
+
+  std::vector<OpenCpuZone> open_cpu_zones_;
+  bool has_frame_start_;
+  Clock::time_point frame_start_;
+
+  EGLContext context_;
+  GenQueriesFunc gen_queries_;
+  DeleteQueriesFunc delete_queries_;
+  BeginQueryFunc begin_query_;
+  EndQueryFunc end_query_;
+  GetQueryObjectuivFunc get_query_objectuiv_;
+  GetQueryObjectui64vFunc get_query_objectui64v_;
+
+  // Zone of the GPU query in flight between BeginGpuZone() and EndGpuZone().
+  bool is_gpu_zone_open_;
+  PendingQuery open_query_;
+  std::deque<PendingQuery> pending_queries_;
+  std::vector<GLuint> free_queries_;
+};
+
+// Times the enclosing scope as a CPU zone.
+class ScopedCpuZone {
+ public:
+  ScopedCpuZone(FrameProfiler* profiler, const char* name)
+      : profiler_(profiler) {
+    profiler_->BeginCpuZone(name);
+  }
+  ScopedCpuZone(const ScopedCpuZone& other) = delete;
+  const ScopedCpuZone& operator=(const ScopedCpuZone&) = delete;
+  ~ScopedCpuZone() { profiler_->EndCpuZone(); }
+
+ private:
+  FrameProfiler* profiler_;
+};
+
+// Times the GL commands of the enclosing scope as a GPU zone.
+class ScopedGpuZone {
+ public:
+  ScopedGpuZone(FrameProfiler* profiler, const char* name)
+      : profiler_(profiler) {
+    profiler_->BeginGpuZone(name);
+  }
+  ScopedGpuZone(const ScopedGpuZone& other) = delete;
+  const ScopedGpuZone& operator=(const ScopedGpuZone&) = delete;
+  ~ScopedGpuZone() { profiler_->EndGpuZone(); }
+
+ private:
+  FrameProfiler* profiler_;
+};
+}  // namespace tango_gl
+#endif  // TANGO_GL_FRAME_PROFILER_H_
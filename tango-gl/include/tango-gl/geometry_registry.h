@@ -0,0 +1,95 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TANGO_GL_GEOMETRY_REGISTRY_H_
+#define TANGO_GL_GEOMETRY_REGISTRY_H_
+
+#include <EGL/egl.h>
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tango-gl/util.h"
+#include "tango-gl/vertex_buffer.h"
+
+namespace tango_gl {
+
+// Vertex data of a primitive shape, e.g. the unit cube, shared by all the
+// drawables of that shape. The data is fixed once the geometry is built; it
+// is uploaded to one interleaved vertex buffer (and an index buffer if there
+// are indices) on the first Bind(), and again in a new GL context.
+//
+// All functions must be called on the GL thread.
+class Geometry {
+ public:
+  Geometry();
+  Geometry(const Geometry& other) = delete;
+  const Geometry& operator=(const Geometry&) = delete;
+  ~Geometry();
+
+  // Bind the vertex buffer, and the index buffer if there are indices,
+  // uploading them first if needed. The caller unbinds them after drawing.
+  void Bind() const;
+
+  // Layout of the vertex buffer: the position of a vertex followed by its
+  // normal, color and texture coordinates, those it has.
+  GLsizei GetStride() const;
+  const GLvoid* GetNormalOffset() const;
+  const GLvoid* GetColorOffset() const;
+  const GLvoid* GetTextureCoordOffset() const;
+
+  GLsizei GetVertexCount() const { return vertices.size() / 3; }
+  GLsizei GetIndexCount() const { return indices.size(); }
+
+  // x, y, z of every vertex.
+  std::vector<GLfloat> vertices;
+  // Either empty or one x, y, z normal per vertex.
+  std::vector<GLfloat> normals;
+  // Either empty or one r, g, b, a color per vertex.
+  std::vector<GLfloat> colors;
+  // Either empty or one u, v pair per vertex.
+  std::vector<GLfloat> texture_coords;
+  std::vector<GLushort> indices;
+
+ private:
+  mutable VertexBuffer vertex_buffer_;
+  mutable VertexBuffer index_buffer_;
+  // Context the buffers were uploaded in.
+  mutable EGLContext context_;
+};
+
+namespace geometry_registry {
+
+// Process wide registry of shared geometries.
+//
+// Drawables of the same shape, e.g. hundreds of Cube markers, hold the same
+// Geometry instead of a copy of its vertices each, and draw from one set of
+// buffers. A geometry is built the first time its key is acquired and lives
+// as long as a drawable holds it; acquiring the key again afterwards builds
+// it again.
+//
+// @param key: name of the shape, including any parameter of its vertices,
+//        e.g. "circle/0.5/32".
+// @param build: fills in the vertex data of a new geometry.
+// @return the geometry.
+std::shared_ptr<const Geometry> Acquire(
+    const std::string& key, const std::function<void(Geometry*)>& build);
+
+}  // namespace geometry_registry
+}  // namespace tango_gl
+#endif  // TANGO_GL_GEOMETRY_REGISTRY_H_
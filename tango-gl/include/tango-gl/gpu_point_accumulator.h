@@ -0,0 +1,135 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_GL_GPU_POINT_ACCUMULATOR_H_
+#define TANGO_GL_GPU_POINT_ACCUMULATOR_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include "tango-gl/color.h"
+#include "tango-gl/point_cloud_buffer.h"
+#include "tango-gl/util.h"
+
+namespace tango_gl {
+
+// GpuPointAccumulator accumulates depth frames into a map of world space
+// points that never leaves the GPU. A frame already uploaded for rendering
+// into a PointCloudBuffer is moved into the world frame by a transform
+// feedback pass, with rasterization discarded, and appended to a ring of
+// fixed size point blocks; once the ring is full the oldest block is
+// overwritten. The CPU does no per point work, neither to accumulate nor to
+// draw the map, which costs one draw call per block in use.
+//
+// Transform feedback needs OpenGL ES 3, see IsSupported(). On GLES2 contexts
+// Accumulate() returns false and the caller keeps accumulating on the CPU,
+// e.g. into a PointMap. The map is lost with the GL context.
+//
+// Must be created, used and destroyed on the GL thread.
+class GpuPointAccumulator {
+ public:
+  struct Options {
+    Options() : block_point_count(16384), block_count(64) {}
+
+    // Points per block. A frame fills the rest of the current block and
+    // continues in the next ones.
+    size_t block_point_count;
+    // Blocks of the ring, the map holds the last block_count *
+    // block_point_count points, 12 MB by default.
+    int block_count;
+  };
+
+  explicit GpuPointAccumulator(const Options& options = Options());
+  GpuPointAccumulator(const GpuPointAccumulator& other) = delete;
+  const GpuPointAccumulator& operator=(const GpuPointAccumulator&) = delete;
+  ~GpuPointAccumulator();
+
+  // Whether the current context has transform feedback.
+  static bool IsSupported();
+
+  // Append a depth frame to the map.
+  //
+  // @param frame: buffer holding the frame as packed x, y, z coordinates in
+  //        the depth camera frame, see PointCloudBuffer::Update().
+  // @param world_T_depth: pose of the depth camera at the frame timestamp,
+  //        e.g. start_service_T_device * device_T_depth.
+  // @return false if the context has no transform feedback or the pass
+  //         could not be set up; the map is then left as is.
+  bool Accumulate(const PointCloudBuffer& frame,
+                  const glm::mat4& world_T_depth);
+
+  // Draw the map as points.
+  //
+  // @param projection_mat: projection matrix from current render camera.
+  // @param view_mat: view matrix from current render camera.
+  void Render(const glm::mat4& projection_mat, const glm::mat4& view_mat);
+
+  // Empty the map, keeping the blocks allocated.
+  void Clear();
+
+  void SetColor(const Color& color) { color_ = color; }
+
+  // Point size in pixels, 2 by default.
+  void SetPointSize(float point_size) { point_size_ = point_size; }
+
+  // Points in the map.
+  size_t GetPointCount() const;
+
+  // Frames accumulated since creation or the last Clear().
+  uint64_t GetFrameCount() const { return frame_count_; }
+
+  const Options& GetOptions() const { return options_; }
+
+  // Release the programs and the blocks, emptying the map.
+  void Release();
+
+  // Forget the programs and the blocks without deleting them. Use this when
+  // the GL context they belonged to has been destroyed.
+  void Invalidate();
+
+ private:
+  struct Block {
+    GLuint buffer;
+    size_t point_count;
+  };
+
+  // Create the transform feedback program and the blocks.
+  bool InitializeGL();
+
+  Options options_;
+  Color color_;
+  float point_size_;
+
+  // Ring of blocks, block_ is the one being filled.
+  std::vector<Block> blocks_;
+  int block_;
+  uint64_t frame_count_;
+
+  GLuint transform_program_;
+  GLint transform_attrib_vertices_;
+  GLint uniform_world_T_depth_;
+
+  GLuint render_program_;
+  GLint attrib_vertices_;
+  GLint uniform_mvp_mat_;
+  GLint uniform_color_;
+  GLint uniform_point_size_;
+};
+}  // namespace tango_gl
+#endif  // TANGO_GL_GPU_POINT_ACCUMULATOR_H_
@@ -17,12 +17,53 @@
 #ifndef TANGO_GL_GRID_H_
 #define TANGO_GL_GRID_H_
 
+#include <memory>
+
 #include "tango-gl/line.h"
 
 namespace tango_gl {
 class Grid : public Line {
  public:
   Grid(float density = 1.0f, int qx = 50, int qy = 50);
+  Grid(const Grid& other) = delete;
+  Grid& operator=(const Grid&) = delete;
+  ~Grid();
+
+  // Draw the grid procedurally instead of from line vertices: one square
+  // around the camera in the XZ plane, the lines antialiased and faded out
+  // with the distance in the fragment shader. The grid then has no edge and
+  // a constant cost, but is blended, so it belongs to a transparent pass.
+  //
+  // Needs GL_OES_standard_derivatives, must be called on the GL thread.
+  //
+  // @return false if the context does not support it, the grid then stays
+  //         drawn from lines.
+  bool SetProcedural(bool is_procedural);
+
+  // Distance from the camera at which the procedural grid has faded out,
+  // half the extent of the line grid by default.
+  void SetFadeDistance(float distance) { fade_distance_ = distance; }
+
+  void Render(const glm::mat4& projection_mat, const glm::mat4& view_mat) const;
+
+ private:
+  float density_;
+  float fade_distance_;
+  bool is_procedural_;
+
+  // Program and unit square of the procedural grid, created by
+  // SetProcedural().
+  GLuint procedural_program_;
+  GLint uniform_plane_mvp_mat_;
+  GLint uniform_plane_color_;
+  GLint uniform_camera_;
+  GLint uniform_origin_;
+  GLint uniform_density_;
+  GLint uniform_fade_distance_;
+  GLint uniform_line_width_;
+  GLint attrib_plane_vertices_;
+  std::shared_ptr<const Geometry> plane_;
+  mutable VertexArray plane_vertex_array_;
 };
 }  // namespace tango_gl
 #endif  // TANGO_GL_GRID_H_
@@ -0,0 +1,132 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_GL_HARDWARE_FRAME_QUEUE_H_
+#define TANGO_GL_HARDWARE_FRAME_QUEUE_H_
+
+#include <EGL/egl.h>
+#include <stdint.h>
+
+#include "tango-gl/triple_buffer.h"
+#include "tango-gl/util.h"
+
+// Declared by <android/hardware_buffer.h> from android-26 on, the examples
+// build for older platforms and resolve the functions at runtime.
+struct AHardwareBuffer;
+
+namespace tango_gl {
+
+// HardwareFrameQueue hands NV21 camera frames from a callback thread to the
+// GL thread in AHardwareBuffers, which the GPU samples directly as
+// GL_TEXTURE_EXTERNAL_OES textures through EGLImages.
+//
+// The camera callback writes each frame once, straight into a buffer the GPU
+// reads, instead of copying it into a CPU buffer that the GL thread uploads
+// again with glTexImage2D. The driver converts YUV to RGB when sampling.
+//
+// Three buffers are exchanged like the slots of a TripleBuffer. The GPU may
+// still sample a buffer after the GL thread handed it back, so EndRead()
+// attaches a native fence to it that the producer waits on before writing.
+//
+// The AHardwareBuffer functions are resolved from libandroid.so at runtime
+// (android-29 for the YUV plane layout), so callers check IsSupported() and
+// keep a copy and upload path for older devices.
+class HardwareFrameQueue {
+ public:
+  HardwareFrameQueue();
+  HardwareFrameQueue(const HardwareFrameQueue& other) = delete;
+  const HardwareFrameQueue& operator=(const HardwareFrameQueue&) = delete;
+  ~HardwareFrameQueue();
+
+  // Whether the platform and the current GL context can import hardware
+  // buffers as external textures. Must be called on the GL thread.
+  static bool IsSupported();
+
+  // Producer side. Copy a NV21 frame into the write buffer and publish it.
+  // The buffer is (re)allocated on the first frame or if the size changed.
+  //
+  // @param nv21: Y rows followed by interleaved VU rows.
+  // @param width: image width in pixels, even.
+  // @param height: image height in pixels, even.
+  // @param stride: bytes per row of the Y plane and of the VU plane.
+  // @return false if the buffer could not be allocated or locked, nothing
+  //         is published then.
+  bool PublishNV21(const uint8_t* nv21, int width, int height, int stride);
+
+  // Consumer side. Bind the latest published frame to its external texture.
+  // Must be called on the GL thread.
+  //
+  // @param is_new_frame: set to true if the frame was not returned before.
+  // @return the GL_TEXTURE_EXTERNAL_OES texture, 0 if no frame has arrived
+  //         yet or it could not be imported.
+  GLuint AcquireTexture(bool* is_new_frame);
+
+  // Consumer side. Call after the draws sampling the texture of the last
+  // AcquireTexture() were issued, so the producer does not overwrite the
+  // buffer while the GPU still reads it.
+  void EndRead();
+
+  // Delete the textures and EGLImages. Must be called on the GL thread, the
+  // next AcquireTexture() imports the buffers again.
+  void ReleaseGL();
+
+  // Forget the textures without deleting them, when the GL context they
+  // belonged to has been destroyed.
+  void InvalidateGL();
+
+ private:
+  // One buffer, exchanged between the producer and the consumer.
+  struct Slot {
+    Slot() : buffer(nullptr), id(0), width(0), height(0), fence(-1) {}
+
+    AHardwareBuffer* buffer;
+    // Unique per allocation, so the consumer notices a reallocated buffer.
+    uint32_t id;
+    int width;
+    int height;
+    // Signaled when the GPU is done reading the buffer, -1 if none.
+    int fence;
+  };
+
+  // Consumer side import of a buffer, holding its own reference to it.
+  struct Import {
+    Import() : id(0), image(nullptr), texture(0), last_use(0) {}
+
+    uint32_t id;
+    void* image;
+    GLuint texture;
+    uint64_t last_use;
+  };
+
+  // One import per slot, an import of a freed buffer is evicted once it is
+  // the least recently used.
+  static const int kImportCount = 3;
+
+  Import* FindImport(const Slot& slot);
+
+  TripleBuffer<Slot> slots_;
+
+  // Only touched by the producer.
+  uint32_t next_id_;
+
+  // Only touched by the consumer.
+  Import imports_[kImportCount];
+  uint64_t acquire_count_;
+  bool has_frame_;
+};
+}  // namespace tango_gl
+#endif  // TANGO_GL_HARDWARE_FRAME_QUEUE_H_
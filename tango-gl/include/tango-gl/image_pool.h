@@ -0,0 +1,137 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_GL_IMAGE_POOL_H_
+#define TANGO_GL_IMAGE_POOL_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include <tango_client_api.h>  // NOLINT
+
+#include "tango-gl/util.h"
+
+namespace tango_gl {
+
+// An image owned by an ImagePool.
+struct PooledImage {
+  // Size, format and timestamp of the frame. data refers to pool storage
+  // with room for the pool capacity, and holds the rows with the stride of
+  // the camera, so the buffer reads like the one of the callback.
+  TangoImageBuffer buffer;
+  // Publish order of the frame, starting at 1, set by Publish().
+  uint64_t sequence;
+};
+
+// ImagePool shares camera frames between threads without copying them, the
+// image counterpart of PointCloudPool: frames are copied once out of the
+// camera callback into storage allocated up front from a memory budget, and
+// passed around as reference counted handles. See PointCloudPool for the
+// producer and consumer sides.
+//
+// All of this is lock-free. A published image must not be written anymore,
+// and the pool must outlive every handle.
+class ImagePool {
+ public:
+  // Reference to a pooled image, empty when default constructed.
+  class Handle {
+   public:
+    Handle() : pool_(nullptr), slot_(-1) {}
+    Handle(const Handle& other);
+    Handle(Handle&& other);
+    Handle& operator=(Handle other);
+    ~Handle() { Reset(); }
+
+    // Drop the reference, the handle becomes empty.
+    void Reset();
+
+    // @return: slot of the image, -1 if the handle is empty.
+    int GetSlot() const { return slot_; }
+
+    explicit operator bool() const { return slot_ >= 0; }
+    PooledImage* operator->() const { return &pool_->slots_[slot_].image; }
+    PooledImage& operator*() const { return pool_->slots_[slot_].image; }
+
+   private:
+    friend class ImagePool;
+    // Takes over a reference already counted on the slot.
+    Handle(ImagePool* pool, int slot) : pool_(pool), slot_(slot) {}
+
+    ImagePool* pool_;
+    int slot_;
+  };
+
+  // @param max_image_size: capacity of each image in bytes.
+  // @param memory_budget: bytes of image storage, the pool holds as many
+  //        images as fit, and at least one.
+  ImagePool(size_t max_image_size, size_t memory_budget);
+  ImagePool(const ImagePool& other) = delete;
+  const ImagePool& operator=(const ImagePool&) = delete;
+  ~ImagePool();
+
+  size_t GetCapacity() const { return max_image_size_; }
+  int GetImageCount() const { return slot_count_; }
+
+  // Bytes of a camera frame, rows of the stride included.
+  //
+  // @return: 0 for an unknown format.
+  static size_t GetImageSize(const TangoImageBuffer& buffer);
+
+  // Claim an unused image and copy a camera frame into it.
+  //
+  // @return: an empty handle if every image is in use, or if the frame is
+  //          larger than the capacity or of an unknown format.
+  Handle Copy(const TangoImageBuffer& buffer);
+
+  // Make an image the latest frame, replacing the previous one.
+  void Publish(const Handle& handle);
+
+  // Share the latest published frame.
+  //
+  // @return: an empty handle if nothing was published yet.
+  Handle AcquireLatest();
+
+ private:
+  struct Slot {
+    PooledImage image;
+    std::atomic<int> references;
+  };
+
+  void AddReference(int slot);
+  // Add a reference only if the slot is still referenced.
+  bool TryAddReference(int slot);
+  void Release(int slot);
+
+  size_t max_image_size_;
+  int slot_count_;
+  std::vector<uint8_t> storage_;
+  std::unique_ptr<Slot[]> slots_;
+
+  // Slot of the latest published frame, or -1. The pool holds a reference on
+  // it.
+  std::atomic<int> latest_;
+
+  // Number of Publish() calls.
+  std::atomic<uint64_t> publish_count_;
+};
+}  // namespace tango_gl
+
+#endif  // TANGO_GL_IMAGE_POOL_H_
@@ -0,0 +1,71 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_GL_JNI_NATIVES_H_
+#define TANGO_GL_JNI_NATIVES_H_
+
+#include <jni.h>
+#include <stddef.h>
+
+#include <android/log.h>
+
+namespace tango_gl {
+namespace jni {
+
+// Register the native methods of a Java class, called from JNI_OnLoad so the
+// VM binds every method once at load time instead of looking up an exported
+// Java_<package>_<class>_<method> symbol on the first call of each.
+//
+// A signature starting with '!' registers a fast native call, which skips
+// the thread state transition of a regular JNI call on Dalvik and on ART up
+// to Android 7, and is ignored by later releases. Only mark methods which
+// take and return primitives, run for a few microseconds and never block or
+// call back into Java: the garbage collector waits for a fast call to return.
+//
+// @param vm: the VM passed to JNI_OnLoad.
+// @param class_name: fully qualified class name, e.g.
+//        "com/projecttango/experiments/nativepointcloud/TangoJNINative".
+// @param methods: the name, signature and function of every native method.
+// @param method_count: number of methods.
+// @return JNI_VERSION_1_6 for JNI_OnLoad to return, JNI_ERR on failure, the
+//         library then fails to load instead of failing on the first call.
+template <size_t method_count>
+jint RegisterNatives(JavaVM* vm, const char* class_name,
+                     const JNINativeMethod (&methods)[method_count]) {
+  JNIEnv* env = nullptr;
+  if (vm->GetEnv(reinterpret_cast<void**>(&env), JNI_VERSION_1_6) != JNI_OK) {
+    return JNI_ERR;
+  }
+  jclass java_class = env->FindClass(class_name);
+  if (java_class == nullptr) {
+    __android_log_print(ANDROID_LOG_ERROR, "tango_jni_example",
+                        "Could not find class %s", class_name);
+    return JNI_ERR;
+  }
+  const jint result = env->RegisterNatives(java_class, methods, method_count);
+  env->DeleteLocalRef(java_class);
+  if (result != JNI_OK) {
+    __android_log_print(ANDROID_LOG_ERROR, "tango_jni_example",
+                        "Could not register the natives of %s", class_name);
+    return JNI_ERR;
+  }
+  return JNI_VERSION_1_6;
+}
+
+}  // namespace jni
+}  // namespace tango_gl
+#endif  // TANGO_GL_JNI_NATIVES_H_
@@ -0,0 +1,158 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_GL_KEYFRAME_SELECTOR_H_
+#define TANGO_GL_KEYFRAME_SELECTOR_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include "tango-gl/point_projection.h"
+#include "tango-gl/range_image.h"
+#include "tango-gl/util.h"
+
+namespace tango_gl {
+
+// KeyframeSelector picks the depth frames that add to what the last
+// keyframe already saw, so the expensive consumers of depth (PointMap,
+// TsdfFusion, SessionRecorder) do work in proportion to new coverage
+// instead of to the frame rate, while cheap ones like rendering still take
+// every frame.
+//
+// A frame becomes a keyframe when, compared with the last keyframe:
+//  - the depth camera moved or turned past a threshold,
+//  - its view overlaps too little: the fraction of its frustum, cut at
+//    max_depth, inside the frustum of the keyframe is estimated from a fixed
+//    set of sample positions spread evenly over the volume,
+//  - or its depth is too novel: the fraction of its points, one every
+//    sample_stride, which fall where the keyframe saw no depth or saw a
+//    different one, e.g. a person walking into the view.
+// The checks run cheapest first and stop at the first that selects the
+// frame. Unlike MotionGate, which looks at motion alone, a still camera
+// facing a changing scene still gets keyframes.
+//
+// Not thread safe, use it from the thread that hands out the frames.
+class KeyframeSelector {
+ public:
+  // Why Select() picked a frame, kNotKeyframe if it did not.
+  enum Reason {
+    kNotKeyframe,
+    kFirstFrame,
+    kMoved,
+    kLowOverlap,
+    kNovelDepth
+  };
+
+  struct Options {
+    Options()
+        : max_translation(0.3f),
+          max_rotation(0.35f),
+          min_overlap(0.6f),
+          max_novelty(0.15f),
+          depth_tolerance(0.1f),
+          max_depth(4.0f),
+          sample_stride(8) {}
+
+    // Distance in meters and angle in radians, 20 degrees by default, from
+    // the last keyframe past which a frame is a keyframe.
+    float max_translation;
+    float max_rotation;
+    // Fraction of the frustum shared with the last keyframe under which a
+    // frame is a keyframe.
+    float min_overlap;
+    // Fraction of novel points over which a frame is a keyframe.
+    float max_novelty;
+    // A point is not novel if the keyframe depth where it falls is within
+    // this fraction of its own depth.
+    float depth_tolerance;
+    // Depth in meters the frustums are cut at for the overlap.
+    float max_depth;
+    // Points tested for novelty, one every sample_stride.
+    int sample_stride;
+  };
+
+  explicit KeyframeSelector(const Options& options = Options());
+  KeyframeSelector(const KeyframeSelector& other) = delete;
+  const KeyframeSelector& operator=(const KeyframeSelector&) = delete;
+
+  // Set the intrinsics of the depth camera. Without them, only the motion
+  // of the camera selects keyframes. Resets the selector.
+  void SetIntrinsics(const projection::CameraIntrinsics& intrinsics);
+
+  // Decide whether a depth frame is a keyframe. A keyframe becomes the
+  // reference the next frames are compared against.
+  //
+  // @param xyz: packed x, y, z coordinates in the depth camera frame.
+  // @param point_count: number of points.
+  // @param world_T_depth: pose of the depth camera at the frame timestamp,
+  //        e.g. start_service_T_device * device_T_depth.
+  // @return why the frame is a keyframe, or kNotKeyframe.
+  Reason Select(const float* xyz, size_t point_count,
+                const glm::mat4& world_T_depth);
+
+  bool IsKeyframe(const float* xyz, size_t point_count,
+                  const glm::mat4& world_T_depth) {
+    return Select(xyz, point_count, world_T_depth) != kNotKeyframe;
+  }
+
+  // Make the next frame a keyframe, e.g. after a relocalization moved the
+  // world frame.
+  void Reset() { has_keyframe_ = false; }
+
+  const Options& GetOptions() const { return options_; }
+
+  // Overlap and novelty of the last frame Select() got that far with, 1 and
+  // 0 before.
+  float GetOverlap() const { return overlap_; }
+  float GetNovelty() const { return novelty_; }
+
+  uint64_t GetKeyframeCount() const { return keyframe_count_; }
+  uint64_t GetSkippedFrameCount() const { return skipped_frame_count_; }
+
+ private:
+  // Fraction of the frustum samples of a frame inside the keyframe frustum.
+  float ComputeOverlap(const glm::mat4& keyframe_T_depth) const;
+
+  // Fraction of the sampled points of a frame the keyframe depth does not
+  // explain.
+  float ComputeNovelty(const float* xyz, size_t point_count,
+                       const glm::mat4& keyframe_T_depth) const;
+
+  // Whether a position in the keyframe camera frame is inside its frustum.
+  bool IsInKeyframeFrustum(const glm::vec3& position) const;
+
+  Options options_;
+  projection::CameraIntrinsics intrinsics_;
+  // Positions spread evenly over the frustum cut at max_depth, in the depth
+  // camera frame. Empty without intrinsics.
+  std::vector<glm::vec3> frustum_samples_;
+
+  bool has_keyframe_;
+  glm::mat4 world_T_keyframe_;
+  // Depth of the last keyframe at a quarter of the camera resolution, so
+  // the sparse points of the depth camera leave few holes.
+  RangeImage keyframe_image_;
+
+  float overlap_;
+  float novelty_;
+  uint64_t keyframe_count_;
+  uint64_t skipped_frame_count_;
+};
+}  // namespace tango_gl
+#endif  // TANGO_GL_KEYFRAME_SELECTOR_H_
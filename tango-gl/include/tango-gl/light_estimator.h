@@ -0,0 +1,115 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_GL_LIGHT_ESTIMATOR_H_
+#define TANGO_GL_LIGHT_ESTIMATOR_H_
+
+#include <vector>
+
+#include "tango-gl/pixel_readback.h"
+#include "tango-gl/util.h"
+#include "tango-gl/vertex_buffer.h"
+
+namespace tango_gl {
+
+// LightEstimator measures the average brightness and color of the camera
+// image on the GPU, e.g. to light virtual objects like the scene around them
+// through Mesh::SetAmbientLight().
+//
+// Each Update() renders the external camera texture into a 64x64 target,
+// then reduces it to 16x16 and 4x4 with 4 bilinear taps per pixel, each of
+// those passes averaging 4x4 pixels. The 4x4 result goes through a
+// PixelReadback, so the estimate lags the camera by a few frames but the GL
+// thread never waits for the GPU.
+//
+// All functions must be called on the GL thread.
+class LightEstimator {
+ public:
+  struct Estimate {
+    // Average luminance of the image, in [0, 1].
+    float intensity;
+    // Average color divided by its luminance, white for a gray scene.
+    glm::vec3 color;
+    // Camera timestamp of the latest image included.
+    double timestamp;
+  };
+
+  LightEstimator();
+  LightEstimator(const LightEstimator& other) = delete;
+  const LightEstimator& operator=(const LightEstimator&) = delete;
+  ~LightEstimator();
+
+  // Queue the reduction of the current camera image. Restores the viewport
+  // and binds framebuffer 0 before returning.
+  //
+  // @param camera_texture: GL_TEXTURE_EXTERNAL_OES texture of the camera.
+  // @param timestamp: camera timestamp of the texture image.
+  void Update(GLuint camera_texture, double timestamp);
+
+  // Get the estimate, smoothed over the reads completed so far.
+  //
+  // @return false until the first read completed.
+  bool GetEstimate(Estimate* estimate) const;
+
+  // Release the GL objects, the estimate is kept.
+  void Release();
+
+  // Forget the GL objects without deleting them. Use this when the GL
+  // context they belonged to has been destroyed.
+  void Invalidate();
+
+ private:
+  // The 64x64, 16x16 and 4x4 targets.
+  static const int kLevelCount = 3;
+
+  struct Level {
+    GLuint framebuffer;
+    GLuint texture;
+    GLsizei size;
+  };
+
+  // Create the targets and programs if needed.
+  bool Allocate();
+
+  // Draw the full screen quad with a downsampling program into a level.
+  //
+  // @param texel_offset: offset of the taps in texture coordinates.
+  void Downsample(GLuint program, GLint attrib_vertices, GLint uniform_offset,
+                  GLenum target, GLuint texture, float texel_offset,
+                  const Level& level);
+
+  // Fold a completed read into the smoothed estimate.
+  void AddRead(double timestamp, const uint8_t* pixels);
+
+  Level levels_[kLevelCount];
+  bool is_unsupported_;
+
+  GLuint external_program_;
+  GLint external_attrib_vertices_;
+  GLint external_uniform_offset_;
+  GLuint program_;
+  GLint attrib_vertices_;
+  GLint uniform_offset_;
+  VertexBuffer vertex_buffer_;
+
+  PixelReadback readback_;
+
+  bool has_estimate_;
+  Estimate estimate_;
+};
+}  // namespace tango_gl
+#endif  // TANGO_GL_LIGHT_ESTIMATOR_H_
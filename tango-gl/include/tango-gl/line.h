@@ -17,7 +17,11 @@
 #ifndef TANGO_GL_LINE_H_
 #define TANGO_GL_LINE_H_
 
+#include <algorithm>
+
 #include "tango-gl/drawable_object.h"
+#include "tango-gl/vertex_array.h"
+#include "tango-gl/vertex_buffer.h"
 
 namespace tango_gl {
 class Line : public DrawableObject {
@@ -27,11 +31,38 @@ class Line : public DrawableObject {
   void Render(const glm::mat4& projection_mat, const glm::mat4& view_mat) const;
   void UpdateLineVertices(const std::vector<glm::vec3>& vec_vertices) {
     vec_vertices_ = vec_vertices;
+    if (geometry_) {
+      geometry_.reset();
+      vertex_array_.Reset();
+    }
+    MarkVerticesDirty(0);
   }
 
  protected:
+  friend class DrawBatch;
+
+  // Draw a shared geometry, e.g. from geometry_registry, instead of
+  // vec_vertices_, until UpdateLineVertices() is called.
+  void SetGeometry(std::shared_ptr<const Geometry> geometry);
+
+  // Derived classes changing vec_vertices_ must call this with the index of
+  // the first changed vertex, the vertex buffer is updated from there on the
+  // next Render() call. Vertices appended at the end only need their own
+  // index, so growing a line only uploads the new tail.
+  void MarkVerticesDirty(size_t first_vertex) {
+    first_dirty_vertex_ = std::min(first_dirty_vertex_, first_vertex);
+  }
+
+  // Upload the dirty vertices, if any.
+  void UpdateVertexBuffer() const;
+
   float line_width_;
   std::vector<glm::vec3> vec_vertices_;
+
+  // GPU copy of vec_vertices_, updated lazily from Render() on the GL thread.
+  mutable VertexBuffer vertex_buffer_;
+  mutable VertexArray vertex_array_;
+  mutable size_t first_dirty_vertex_;
 };
 }  // namespace tango_gl
 #endif  // TANGO_GL_LINE_H_
\ No newline at end of file
@@ -0,0 +1,97 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_GL_LUMINANCE_PYRAMID_H_
+#define TANGO_GL_LUMINANCE_PYRAMID_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+namespace tango_gl {
+
+// LuminancePyramid holds the downsampled copies of a Y plane that vision
+// code, e.g. marker or feature tracking, searches coarse to fine. Each level
+// halves the previous one with a rounded 2x2 box filter, an odd last row or
+// column is dropped.
+//
+// Level 0 is the source plane itself and is not copied, the other levels
+// live in one buffer owned by the pyramid. The buffer is only reallocated
+// when the image size or the level count grows, so a pyramid kept per frame
+// slot, see CameraStream, builds without allocating.
+class LuminancePyramid {
+ public:
+  // Most levels built, including the source.
+  static const int kMaxLevelCount = 4;
+
+  // A tightly packed level, except level 0 which has the source stride.
+  struct Level {
+    const uint8_t* data;
+    int width;
+    int height;
+    int stride;
+  };
+
+  LuminancePyramid();
+  LuminancePyramid(const LuminancePyramid& other) = delete;
+  const LuminancePyramid& operator=(const LuminancePyramid&) = delete;
+
+  // Build the pyramid of a Y plane.
+  //
+  // @param y: the Y plane, it has to outlive the use of level 0.
+  // @param width, height: size of the plane in pixels.
+  // @param stride: bytes between two rows, at least width.
+  // @param level_count: levels to build including the source, clamped to
+  //        [1, kMaxLevelCount] and to the levels at least one pixel large.
+  void Build(const uint8_t* y, int width, int height, int stride,
+             int level_count);
+
+  // Number of levels of the last Build(), 0 before the first one.
+  int GetLevelCount() const { return level_count_; }
+
+  // @param level: in [0, GetLevelCount()).
+  const Level& GetLevel(int level) const { return levels_[level]; }
+
+ private:
+  std::vector<uint8_t> buffer_;
+  Level levels_[kMaxLevelCount];
+  int level_count_;
+};
+
+namespace luminance_pyramid {
+// Halve a plane with a rounded 2x2 box filter, ((a + b + c + d + 2) >> 2).
+// Exposed for the benchmarks, LuminancePyramid::Build() calls it per level.
+//
+// @param source: the plane to halve.
+// @param width, height: size of the source in pixels.
+// @param stride: bytes between two source rows.
+// @param destination: width / 2 * height / 2 bytes, tightly packed.
+void Downsample(const uint8_t* source, int width, int height, int stride,
+                uint8_t* destination);
+
+namespace internal {
+// Per-architecture row kernel, defined in luminance_pyramid_neon.cpp. It
+// halves a pair of rows into one and returns the number of destination
+// columns written (a multiple of 16); the caller writes the remaining ones.
+size_t DownsampleRowPairNeon(const uint8_t* row0, const uint8_t* row1,
+                             size_t destination_width, uint8_t* destination);
+}  // namespace internal
+}  // namespace luminance_pyramid
+
+}  // namespace tango_gl
+#endif  // TANGO_GL_LUMINANCE_PYRAMID_H_
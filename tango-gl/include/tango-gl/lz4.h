@@ -0,0 +1,54 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_GL_LZ4_H_
+#define TANGO_GL_LZ4_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace tango_gl {
+namespace lz4 {
+
+// Compressor and decompressor for the LZ4 block format, so depth and image
+// data can be compressed at sensor rate without a third party library. The
+// output is readable by any LZ4 block decoder (e.g. LZ4_decompress_safe), and
+// Decompress() reads the output of any LZ4 block encoder.
+
+// Size of the destination buffer Compress() needs for size input bytes.
+size_t GetMaxCompressedSize(size_t size);
+
+// @param src: input bytes.
+// @param size: number of input bytes.
+// @param dst: output, at least GetMaxCompressedSize(size) bytes.
+// @param capacity: size of dst in bytes.
+// @return: number of bytes written to dst, 0 if capacity is too small.
+size_t Compress(const uint8_t* src, size_t size, uint8_t* dst,
+                size_t capacity);
+
+// @param src: compressed block.
+// @param size: size of the compressed block in bytes.
+// @param dst: output.
+// @param raw_size: exact size of the decompressed data in bytes.
+// @return: false if the block is malformed or does not decompress to exactly
+//          raw_size bytes. dst may be partially written then.
+bool Decompress(const uint8_t* src, size_t size, uint8_t* dst,
+                size_t raw_size);
+
+}  // namespace lz4
+}  // namespace tango_gl
+#endif  // TANGO_GL_LZ4_H_
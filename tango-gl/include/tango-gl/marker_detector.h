@@ -0,0 +1,167 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_GL_MARKER_DETECTOR_H_
+#define TANGO_GL_MARKER_DETECTOR_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+namespace tango_gl {
+
+// MarkerDetector finds square fiducial markers in a grayscale image, e.g. a
+// level of a LuminancePyramid. A marker is a grid of kGridSize x kGridSize
+// cells: a black border one cell wide around kDataSize x kDataSize data
+// cells, white for a set bit, printed with a white margin of at least one
+// cell. The 16 bit codes come from a fixed dictionary whose codes differ by
+// at least 5 bits from each other in every rotation, so a code is never
+// mistaken for another or for itself turned.
+//
+// The search, in the spirit of AprilTag:
+//  - each pixel is classified dark or light against the middle of the
+//    extremes of the tiles around it, pixels of low contrast tiles are left
+//    out,
+//  - the dark pixels are labeled in 8-connected components, the outer
+//    contour of each large enough component is traced and fitted with a
+//    quad, whose sides are refined by a line fit to the contour,
+//  - the cells are sampled through the homography of the quad and the code
+//    read against the border and the white margin, in the 4 rotations.
+//
+// Positions are continuous pixel coordinates, pixel (i, j) covering
+// [i, i + 1) x [j, j + 1). The buffers are reused between calls.
+class MarkerDetector {
+ public:
+  // Data cells on a side of a marker, and cells including the border.
+  static const int kDataSize = 4;
+  static const int kGridSize = kDataSize + 2;
+
+  struct Options {
+    Options()
+        : tile_size(8), min_contrast(30), min_side(12.0f), max_bit_errors(1) {}
+
+    // Side of the threshold tiles in pixels.
+    int tile_size;
+    // Difference between the darkest and the brightest pixels around a pixel,
+    // and between the border and the margin of a marker, in [1, 255].
+    int min_contrast;
+    // Shortest side of a marker in pixels of the searched image.
+    float min_side;
+    // Code bits that may be read wrong, at most 2.
+    int max_bit_errors;
+  };
+
+  // A rectangle of the image, in its pixels.
+  struct Roi {
+    int x;
+    int y;
+    int width;
+    int height;
+  };
+
+  struct Quad {
+    int id;
+    // Corners clockwise in the image, from the top left corner of the
+    // marker as printed, scaled by the scale passed to Detect().
+    float corners[4][2];
+    int bit_errors;
+  };
+
+  explicit MarkerDetector(const Options& options);
+  MarkerDetector(const MarkerDetector& other) = delete;
+  const MarkerDetector& operator=(const MarkerDetector&) = delete;
+
+  // Detect the markers of an image or of a region of it.
+  //
+  // @param image: the grayscale image.
+  // @param width, height: size of the image in pixels.
+  // @param stride: bytes between two rows, at least width.
+  // @param roi: the region to search, nullptr for the whole image. Markers
+  //        touching the border of the region are not found.
+  // @param scale: factor of the corners, e.g. 1 << level to report the
+  //        corners of a pyramid level in pixels of level 0.
+  // @param quads: the markers found are appended.
+  // @return number of markers appended.
+  size_t Detect(const uint8_t* image, int width, int height, int stride,
+                const Roi* roi, float scale, std::vector<Quad>* quads);
+
+  const Options& GetOptions() const { return options_; }
+
+  // Number of codes of the dictionary, the ids are [0, size).
+  static int GetDictionarySize();
+
+  // Code of an id, the data cells row by row from the top left in the high
+  // bits first, a set bit for a white cell.
+  static uint16_t GetCode(int id);
+
+  // Whether a cell of a marker is white, e.g. to print it.
+  //
+  // @param column, row: cell in [0, kGridSize), from the top left.
+  static bool IsCellWhite(int id, int column, int row);
+
+  // Homography mapping 4 points to 4 others, e.g. the corners of a marker
+  // to the image, h[8] = 1.
+  //
+  // @param homography: row major 3x3 matrix.
+  // @return false if 3 of the points are aligned.
+  static bool ComputeHomography(const float source[4][2],
+                                const float destination[4][2],
+                                double homography[9]);
+
+ private:
+  struct Component {
+    int count;
+    int min_x;
+    int min_y;
+    int max_x;
+    int max_y;
+    // First pixel in raster order, on the outer contour.
+    int first;
+  };
+
+  // Classify the pixels of the region into binary_.
+  void Threshold(const uint8_t* image, int stride, const Roi& roi);
+
+  // Label the dark pixels of binary_ into labels_ and components_.
+  void Label(int width, int height);
+
+  // Trace the outer contour of a component into contour_.
+  void TraceContour(int label, int first, int width, int height);
+
+  // Fit a quad to contour_, clockwise from any corner.
+  bool FitQuad(float corners[4][2]) const;
+
+  // Read the code of a quad in the region and match it with the
+  // dictionary. On success corners is rotated to start at the top left of
+  // the marker.
+  bool Decode(const uint8_t* image, int stride, const Roi& roi,
+              float corners[4][2], int* id, int* bit_errors) const;
+
+  const Options options_;
+
+  // Reused between calls, sized for the largest region searched.
+  std::vector<uint8_t> binary_;
+  std::vector<uint8_t> tile_min_;
+  std::vector<uint8_t> tile_max_;
+  std::vector<int32_t> labels_;
+  std::vector<int32_t> parents_;
+  std::vector<Component> components_;
+  std::vector<int32_t> contour_;
+};
+}  // namespace tango_gl
+#endif  // TANGO_GL_MARKER_DETECTOR_H_
@@ -0,0 +1,195 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_GL_MARKER_TRACKER_H_
+#define TANGO_GL_MARKER_TRACKER_H_
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <tango_client_api.h>  // NOLINT
+
+#include "tango-gl/camera_stream.h"
+#include "tango-gl/luminance_pyramid.h"
+#include "tango-gl/marker_detector.h"
+#include "tango-gl/pipeline_stage.h"
+#include "tango-gl/pose_history.h"
+#include "tango-gl/rigid_transform.h"
+
+namespace tango_gl {
+
+// MarkerTracker follows the fiducial markers of MarkerDetector in the Y plane
+// of a camera, without searching every full frame.
+//
+//  - A full frame search runs on a worker thread a few times per second, on
+//    a coarse level of the frame pyramid where the markers are still large
+//    enough, to find new markers.
+//  - Every frame, each known marker is searched only in a small region
+//    around where it is expected: its last corners, or with a pose and the
+//    device poses of a PoseHistory, its corners projected with the device
+//    motion since. The region is searched on the finest pyramid level where
+//    it stays under Options::max_roi_size pixels, so a marker costs about
+//    the same whatever its size in the image.
+//
+// The tracking thread is the consumer of the CameraStream, so the stream is
+// not acquired from elsewhere while the tracker runs. Streams of
+// CameraStream::kLuminance format with a pyramid of more than
+// Options::detection_level levels are used as is, others get a pyramid built
+// here.
+//
+// With the camera set, the pose of each marker is solved from its corners:
+// the marker frame has its origin at the center, x to the right and y down
+// the marker as printed and z into it, as the camera frame of Tango.
+class MarkerTracker {
+ public:
+  struct Options {
+    Options()
+        : detection_level(1),
+          detection_interval(0.5),
+          max_roi_size(192),
+          max_missed_frames(10),
+          marker_size(0.1f) {}
+
+    // Pyramid level searched for new markers, clamped to the levels.
+    int detection_level;
+    // Seconds between the starts of two full frame searches.
+    double detection_interval;
+    // Largest side of a tracking region, in pixels of the searched level.
+    int max_roi_size;
+    // Frames a marker may go unseen before it is dropped.
+    int max_missed_frames;
+    // Side of the markers, black border included, in meters.
+    float marker_size;
+    MarkerDetector::Options detector;
+  };
+
+  struct Marker {
+    int id;
+    // Timestamp of the last frame the marker was seen in.
+    double timestamp;
+    // Corners in pixels of the frame, see MarkerDetector::Quad.
+    float corners[4][2];
+    // Whether camera_T_marker is set, which needs SetCamera().
+    bool has_pose;
+    RigidTransform camera_T_marker;
+    // Whether world_T_marker is set, which also needs a device pose at the
+    // timestamp. World is the base frame of the PoseHistory poses.
+    bool has_world_pose;
+    RigidTransform world_T_marker;
+  };
+
+  // @param stream: the camera frames, it has to outlive the tracker.
+  // @param pose_history: device poses to predict the markers and place them
+  //        in the world, nullptr for none. It has to outlive the tracker.
+  MarkerTracker(CameraStream* stream, const PoseHistory* pose_history,
+                const Options& options = Options());
+  MarkerTracker(const MarkerTracker& other) = delete;
+  const MarkerTracker& operator=(const MarkerTracker&) = delete;
+  ~MarkerTracker();
+
+  // Set the intrinsics of the camera and its pose on the device, to solve
+  // the pose of the markers. Call before Start().
+  //
+  // @param intrinsics: of the camera, the frames may be of another
+  //        resolution with the same aspect.
+  // @param device_T_camera: the camera extrinsics, see DeviceExtrinsics.
+  void SetCamera(const TangoCameraIntrinsics& intrinsics,
+                 const RigidTransform& device_T_camera);
+
+  // Start the tracking and the detection threads.
+  void Start();
+
+  // Stop the threads and forget the markers.
+  void Stop();
+
+  // Get the markers tracked in the last frame, from any thread.
+  //
+  // @return the number of markers.
+  size_t GetMarkers(std::vector<Marker>* markers) const;
+
+ private:
+  struct Track {
+    Marker marker;
+    int missed_frames;
+    // Corners in the world, set with Marker::has_world_pose.
+    glm::vec3 world_corners[4];
+  };
+
+  void TrackLoop();
+  void ProcessFrame(const CameraStream::Frame& frame);
+
+  // Copy a level to detection_image_ and queue a full frame search.
+  void StartDetection(const LuminancePyramid::Level& level, int level_index,
+                      double timestamp);
+  // Run on the detection stage.
+  void Detect(double* timestamp);
+  // Take the results of the last full frame search into tracks_.
+  void MergeDetections();
+
+  // Search a marker around where it is expected.
+  bool TrackMarker(const LuminancePyramid& pyramid, double timestamp,
+                   Track* track);
+  // Expected corners of a marker at a timestamp, from the device poses.
+  bool PredictCorners(const Track& track, double timestamp,
+                      float corners[4][2]) const;
+  // Set the marker and world poses of a track from its corners.
+  void UpdatePose(Track* track) const;
+
+  // Pixel position of a camera frame point, false behind the camera.
+  bool Project(const glm::vec3& point, float pixel[2]) const;
+
+  CameraStream* const stream_;
+  const PoseHistory* const pose_history_;
+  const Options options_;
+
+  bool has_camera_;
+  TangoCameraIntrinsics intrinsics_;
+  RigidTransform device_T_camera_;
+
+  // Tracking thread.
+  std::thread thread_;
+  std::atomic<bool> is_stopping_;
+  MarkerDetector tracking_detector_;
+  LuminancePyramid pyramid_;
+  std::vector<Track> tracks_;
+  std::vector<MarkerDetector::Quad> tracking_quads_;
+  double last_detection_time_;
+  // Frame pixels per intrinsics pixel.
+  float frame_scale_;
+
+  // Detection stage, one search at a time on a copy of a level.
+  PipelineStage<double> detection_stage_;
+  std::atomic<bool> is_detecting_;
+  MarkerDetector detection_detector_;
+  std::vector<uint8_t> detection_image_;
+  int detection_width_;
+  int detection_height_;
+  int detection_level_;
+
+  // Results of the last search, guarded by detection_mutex_.
+  std::mutex detection_mutex_;
+  bool has_detections_;
+  double detection_timestamp_;
+  std::vector<MarkerDetector::Quad> detections_;
+
+  mutable std::mutex markers_mutex_;
+  std::vector<Marker> markers_;
+};
+}  // namespace tango_gl
+#endif  // TANGO_GL_MARKER_TRACKER_H_
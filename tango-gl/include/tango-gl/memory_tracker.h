@@ -0,0 +1,115 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+
+#ifndef TANGO_GL_MEMORY_TRACKER_H_
+#define TANGO_GL_MEMORY_TRACKER_H_
+
+#include <EGL/egl.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+
+#include "tango-gl/util.h"
+
+namespace tango_gl {
+
+// MemoryTracker accounts the memory of GL objects, and of large CPU buffers,
+// by owner, so a long session that grows can be traced to the code holding
+// the memory. Creators call Track() once the storage is allocated, with a
+// string literal naming them, e.g. "Texture"; the object is untracked when
+// deleted through RenderState::DeleteBuffers() or DeleteTextures(), or by an
+// explicit Untrack() for the other kinds.
+//
+// A budget can be set on the total. RenderState::BeginFrame() then evicts
+// evictable objects, least recently used first, until the total fits again.
+// Objects used in the last frame are never evicted. Textures loaded from
+// a file are evictable and reload on their next use.
+//
+// Can be called from any thread, evictions happen on the GL thread.
+class MemoryTracker {
+ public:
+  enum Kind { kTexture, kBuffer, kRenderbuffer, kProgram, kHost, kKindCount };
+
+  // An object that can free its storage and recreate it later.
+  class Evictable {
+   public:
+    virtual ~Evictable() {}
+    // Free the storage, on the GL thread. The object is untracked after.
+    virtual void Evict() = 0;
+  };
+
+  struct Usage {
+    Usage() : bytes(0), high_water_mark(0), object_count(0) {}
+
+    size_t bytes;
+    size_t high_water_mark;
+    size_t object_count;
+  };
+
+  MemoryTracker() = delete;
+
+  // Record the storage of an object, replacing its previous size.
+  //
+  // @param kind: kind of object.
+  // @param id: GL name of the object, or address of a kHost buffer.
+  // @param owner: string literal naming the creator.
+  // @param bytes: size of the storage.
+  static void Track(Kind kind, uintptr_t id, const char* owner, size_t bytes);
+
+  // Forget an object. No-op if it is not tracked.
+  static void Untrack(Kind kind, uintptr_t id);
+
+  // Mark an object as evictable, or not with nullptr. The object must be
+  // tracked; evictable must stay valid until it is untracked.
+  static void SetEvictable(Kind kind, uintptr_t id, Evictable* evictable);
+
+  // Note the use of an object in the current frame, for the eviction order.
+  static void Touch(Kind kind, uintptr_t id);
+
+  // Total to keep the tracked memory under, 0 for no budget.
+  static void SetBudget(size_t bytes);
+  static size_t GetBudget();
+
+  // Advance the frame and evict objects if over budget. Called by
+  // RenderState::BeginFrame(), on the GL thread.
+  static void BeginFrame();
+
+  // Forget the GL objects created in a context, when it was destroyed.
+  // RenderState::BeginFrame() does it when the current context changed.
+  static void ReleaseContext(EGLContext context);
+
+  static Usage GetTotal();
+  static Usage GetKindUsage(Kind kind);
+  // Usage of an owner, zero if it never tracked anything.
+  static Usage GetOwnerUsage(const char* owner);
+
+  // Number of objects evicted so far.
+  static size_t GetEvictionCount();
+
+  // A line for the total and one per owner, in order of first use, e.g.
+  // "memory Texture 3 objects 1.2 MB peak 1.5 MB".
+  static std::string GetReport();
+
+  // Size of a texture level of an uncompressed format, e.g. GL_RGBA and
+  // GL_UNSIGNED_BYTE.
+  static size_t GetTextureSize(GLsizei width, GLsizei height, GLenum format,
+                               GLenum type);
+};
+}  // namespace tango_gl
+#endif  // TANGO_GL_MEMORY_TRACKER_H_
@@ -17,9 +17,16 @@
 #ifndef TANGO_GL_MESH_H_
 #define TANGO_GL_MESH_H_
 
+#include <memory>
+
 #include "tango-gl/bounding_box.h"
+#include "tango-gl/bvh.h"
 #include "tango-gl/drawable_object.h"
+#include "tango-gl/obj_loader.h"
 #include "tango-gl/segment.h"
+#include "tango-gl/vertex_array.h"
+#include "tango-gl/vertex_buffer.h"
+#include "tango-gl/view_frustum.h"
 
 namespace tango_gl {
 class Mesh : public DrawableObject {
@@ -28,18 +35,82 @@ class Mesh : public DrawableObject {
   Mesh(GLenum render_mode);
   void SetShader();
   void SetShader(bool is_lighting_on);
+  using DrawableObject::SetVertices;
+
+  // Upload a mapped binary mesh straight to the GPU buffers, without copying
+  // it into vertices_. Must be called on the GL thread, the mesh can be
+  // unmapped afterwards. SetBoundingBox() is not available for such a mesh.
+  void SetVertices(const obj_loader::MappedMesh& mesh);
   void SetBoundingBox();
   void SetLightDirection(const glm::vec3& light_direction);
+
+  // Ambient light of all the lit meshes, e.g. from a LightEstimator: the
+  // diffuse term is tinted by color and raised by intensity. White and 0.3
+  // by default. Must be called on the GL thread.
+  static void SetAmbientLight(const glm::vec3& color, float intensity);
+  // Color in rgb, intensity in a.
+  static const glm::vec4& GetAmbientLight();
   void Render(const glm::mat4& projection_mat, const glm::mat4& view_mat) const;
-  bool IsIntersecting(const Segment& segment);
+
+  // Build a triangle hierarchy over vertices_ and indices_ for exact picking,
+  // needs to be called after SetVertices() on a GL_TRIANGLES mesh.
+  void SetTriangleBvh();
+  const MeshBvh* GetTriangleBvh() const { return triangle_bvh_.get(); }
+
+  // Test a world frame segment against the mesh, exactly against its
+  // triangles after SetTriangleBvh(), against its bounding box otherwise.
+  //
+  // @param hit_point: if not null, set to the world frame hit point on a
+  //        triangle hit, left untouched on a bounding box hit.
+  bool IsIntersecting(const Segment& segment, glm::vec3* hit_point = nullptr);
+
+  // Whether the mesh may be visible in a frustum. A mesh without bounding
+  // box is never culled.
+  bool IsVisible(ViewFrustum* frustum) const;
 
  protected:
+  friend class DrawBatch;
+  friend class ObjectStore;
+
+  // Draw a shared geometry, e.g. from geometry_registry, instead of own
+  // vertex data. Its normals are used by lit meshes.
+  void SetGeometry(std::shared_ptr<const Geometry> geometry);
+
+  // Vertex data of the mesh, from the shared geometry if there is one.
+  const std::vector<GLfloat>& GetVertices() const {
+    return geometry_ ? geometry_->vertices : vertices_;
+  }
+  const std::vector<GLfloat>& GetNormals() const {
+    return geometry_ ? geometry_->normals : normals_;
+  }
+  const std::vector<GLushort>& GetIndices() const {
+    return geometry_ ? geometry_->indices : indices_;
+  }
+
+  // Upload vertices_ (interleaved with normals_ if there is one normal per
+  // vertex) and indices_ to the GPU buffers.
+  void UploadVertexData() const;
+
   BoundingBox* bounding_box_;
+  std::unique_ptr<MeshBvh> triangle_bvh_;
   bool is_lighting_on_;
   bool is_bounding_box_on_;
   glm::vec3 light_direction_;
   GLuint uniform_mv_mat_;
   GLuint uniform_light_vec_;
+  GLint uniform_ambient_;
+
+  // GPU copies of the vertex data, uploaded on the first Render() after
+  // SetVertices(). Unused with a shared geometry.
+  mutable VertexBuffer vertex_buffer_;
+  mutable VertexBuffer index_buffer_;
+  // Attribute setup of the buffers, recorded again when the layout or the
+  // program changes.
+  mutable VertexArray vertex_array_;
+  mutable bool has_interleaved_normals_;
+  mutable GLsizei vertex_count_;
+  mutable GLsizei index_count_;
+  mutable GLenum index_type_;
 };
 }  // namespace tango_gl
 #endif  // TANGO_GL_MESH_H_
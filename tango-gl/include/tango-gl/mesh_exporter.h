@@ -0,0 +1,209 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_GL_MESH_EXPORTER_H_
+#define TANGO_GL_MESH_EXPORTER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include <tango_client_api.h>
+
+#include "tango-gl/bounded_queue.h"
+#include "tango-gl/util.h"
+
+namespace tango_gl {
+
+// MeshExporter streams a mesh given segment by segment, e.g. the segments of
+// TangoService_Experimental_extractMesh() or the blocks of TsdfMesher, to a
+// binary PLY or a glTF binary (.glb) file, without ever holding the whole
+// mesh in memory.
+//
+// AddSegment() copies a segment into fixed size staging blocks, the vertices
+// in file order and the faces, offset to the vertices added before, into a
+// separate stream. A dedicated I/O thread writes full blocks with one pwrite
+// each, the vertices into the file after a reserved header and the faces into
+// an unlinked spill file next to it. Finish() lets the thread append the
+// spill file to the vertices, through the same blocks, and write the header
+// now that the counts are known. The memory used is block_count * block_size
+// whatever the size of the mesh.
+//
+// The blocks are page aligned and the vertices start on a page boundary of
+// the file, so every block is a large aligned write.
+//
+// All functions but GetProgress() must be called from one thread.
+class MeshExporter {
+ public:
+  enum Format {
+    // Binary little endian PLY, float vertices and int vertex_indices.
+    kPly,
+    // glTF 2.0 binary, one primitive with 32 bit indices.
+    kGlb,
+  };
+
+  struct Options {
+    Options() : block_size(1 << 20), block_count(8), has_normals(true) {}
+
+    // Size of a staging block, rounded up to a page.
+    size_t block_size;
+    // Number of staging blocks, at least 2.
+    int block_count;
+    // Write a normal per vertex. AddSegment() then needs normals.
+    bool has_normals;
+  };
+
+  struct Progress {
+    uint64_t vertex_count;
+    uint64_t face_count;
+    // Bytes the I/O thread wrote out of those it has to write. The faces
+    // count twice, they are written to the spill file then appended.
+    // total_bytes grows with the segments until Finish().
+    uint64_t written_bytes;
+    uint64_t total_bytes;
+    bool is_done;
+    bool has_failed;
+  };
+
+  MeshExporter();
+  MeshExporter(const MeshExporter& other) = delete;
+  const MeshExporter& operator=(const MeshExporter&) = delete;
+  // Cancels an export that was not finished.
+  ~MeshExporter();
+
+  // Create the file, allocate the staging blocks and start the I/O thread.
+  //
+  // @param path: file to write, replaced if it exists.
+  // @return: false if the file could not be created or an export is already
+  //          running.
+  bool Start(const char* path, Format format,
+             const Options& options = Options());
+
+  // Queue a segment, copied before the function returns.
+  //
+  // @param vertices: packed x, y, z coordinates, vertex_count * 3 floats.
+  // @param normals: packed normals like vertices, or nullptr without
+  //        Options::has_normals.
+  // @param indices: triangle list, index_count / 3 triangles indexing the
+  //        vertices of the segment.
+  // @param wait: whether to wait for the I/O thread when the staging blocks
+  //        are full, e.g. on an export thread. Otherwise the segment is not
+  //        queued, for a call again later, e.g. next frame on the GL thread;
+  //        segments larger than all blocks then never fit.
+  // @return: false if the segment was not queued, because it did not fit,
+  //          is invalid, or the export is not running or failed.
+  bool AddSegment(const float* vertices, const float* normals,
+                  uint32_t vertex_count, const uint32_t* indices,
+                  uint32_t index_count, bool wait);
+  bool AddSegment(const float* vertices, const float* normals,
+                  uint32_t vertex_count, const GLushort* indices,
+                  uint32_t index_count, bool wait);
+  bool AddSegment(const TangoMesh_Experimental& mesh, bool wait);
+
+  // Stop accepting segments and let the I/O thread complete the file.
+  // Returns immediately, see GetProgress() and Wait().
+  void Finish();
+
+  // Wait for the I/O thread after Finish().
+  //
+  // @return: whether the file is complete.
+  bool Wait();
+
+  // Stop the export and delete the file.
+  void Cancel();
+
+  bool IsRunning() const { return thread_.joinable(); }
+
+  // Can be called from any thread.
+  Progress GetProgress() const;
+
+ private:
+  enum Stream { kVertexStream, kFaceStream, kStreamCount };
+
+  struct Block {
+    uint8_t* data;
+    size_t size;
+    Stream stream;
+  };
+
+  template <typename Index>
+  bool AddIndexedSegment(const float* vertices, const float* normals,
+                         uint32_t vertex_count, const Index* indices,
+                         uint32_t index_count, bool wait);
+
+  // Whether the bytes fit in the current and the free blocks.
+  bool HasSpace(size_t vertex_bytes, size_t face_bytes) const;
+
+  // Copy bytes to the current block of a stream, queueing it once full.
+  bool Append(Stream stream, const void* data, size_t size, bool wait);
+
+  // Queue the current block of a stream, if it has data.
+  void QueueBlock(Stream stream);
+
+  // Join the I/O thread, close the files and free the blocks.
+  void Join();
+
+  void WriteLoop();
+  void WriteBlock(int block_index);
+
+  // Append the spill file to the vertices and write the header.
+  void CompleteFile();
+  std::string GetPlyHeader() const;
+  std::string GetGlbHeader() const;
+
+  // Write to a file at an offset, or set has_failed_.
+  bool WriteBytes(int file, const void* data, size_t size, uint64_t offset);
+
+  Options options_;
+  Format format_;
+  std::string path_;
+  size_t vertex_size_;
+  size_t face_size_;
+
+  // Aligned storage of all blocks.
+  uint8_t* storage_;
+  std::unique_ptr<Block[]> blocks_;
+  std::unique_ptr<BoundedQueue<int>> free_blocks_;
+  std::unique_ptr<BoundedQueue<int>> ready_blocks_;
+  std::atomic<int> free_block_count_;
+
+  // Producer side.
+  int current_blocks_[kStreamCount];
+  float bounds_min_[3];
+  float bounds_max_[3];
+
+  // I/O thread side, the output file and the spill file.
+  int file_;
+  int spill_file_;
+  uint64_t offsets_[kStreamCount];
+
+  std::thread thread_;
+  std::atomic<bool> is_finishing_;
+  std::atomic<bool> is_cancelled_;
+  std::atomic<bool> is_done_;
+  std::atomic<bool> has_failed_;
+  std::atomic<uint64_t> vertex_count_;
+  std::atomic<uint64_t> face_count_;
+  std::atomic<uint64_t> written_bytes_;
+  std::atomic<uint64_t> total_bytes_;
+};
+}  // namespace tango_gl
+#endif  // TANGO_GL_MESH_EXPORTER_H_
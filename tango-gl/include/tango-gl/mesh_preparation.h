@@ -0,0 +1,83 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_GL_MESH_PREPARATION_H_
+#define TANGO_GL_MESH_PREPARATION_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include "tango-gl/util.h"
+#include "tango-gl/worker_pool.h"
+
+namespace tango_gl {
+namespace mesh_preparation {
+
+// Largest vertex count addressable with the GLushort indices of
+// tango_gl::Mesh.
+const size_t kMaxChunkVertexCount = 65536;
+
+// A piece of a larger mesh, in the layout DrawableObject::SetVertices()
+// takes.
+struct MeshChunk {
+  std::vector<GLfloat> vertices;
+  std::vector<GLfloat> normals;
+  std::vector<GLushort> indices;
+};
+
+// Compute smooth vertex normals, the area weighted average of the normals of
+// the faces around each vertex. Faces and then vertices are split into
+// ranges processed in parallel, the result does not depend on the pool size.
+//
+// @param vertices: packed x, y, z coordinates, vertex_count * 3 floats.
+// @param indices: triangle list, index_count / 3 faces.
+// @param pool: pool to run on, or nullptr to run on the calling thread.
+// @param normals: output, vertex_count * 3 floats. Vertices without face get
+//        a zero normal.
+void ComputeNormals(const float* vertices, size_t vertex_count,
+                    const uint32_t* indices, size_t index_count,
+                    WorkerPool* pool, float* normals);
+
+// Reorder the faces of a triangle list for the post-transform vertex cache,
+// with Tom Forsyth's linear-speed vertex cache optimization. Faces keep their
+// winding.
+//
+// @param vertex_count: number of vertices the indices refer to.
+// @param indices: triangle list, reordered in place.
+void OptimizeVertexCache(size_t vertex_count, std::vector<uint32_t>* indices);
+
+// Split a mesh into chunks of at most kMaxChunkVertexCount vertices, each
+// with its faces optimized for the vertex cache. Faces are assigned in order,
+// so a cache optimized input gives spatially coherent chunks. Vertices shared
+// by faces of several chunks are duplicated.
+//
+// @param vertices: packed x, y, z coordinates, vertex_count * 3 floats.
+// @param normals: vertex_count * 3 floats, or nullptr to compute them with
+//        ComputeNormals().
+// @param indices: triangle list, index_count / 3 faces.
+// @param pool: pool to run on, or nullptr to run on the calling thread.
+// @param chunks: output chunks, with normals.
+void PrepareMesh(const float* vertices, const float* normals,
+                 size_t vertex_count, const uint32_t* indices,
+                 size_t index_count, WorkerPool* pool,
+                 std::vector<MeshChunk>* chunks);
+
+}  // namespace mesh_preparation
+}  // namespace tango_gl
+#endif  // TANGO_GL_MESH_PREPARATION_H_
@@ -0,0 +1,153 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_GL_MESH_SIMPLIFIER_H_
+#define TANGO_GL_MESH_SIMPLIFIER_H_
+
+#include <stdint.h>
+
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <tango_client_api.h>
+
+#include "tango-gl/segmented_mesh.h"
+#include "tango-gl/util.h"
+
+namespace tango_gl {
+
+// MeshSimplifier sits between the scene reconstruction and a SegmentedMesh.
+// It keeps a full resolution copy of every segment for export, and feeds the
+// SegmentedMesh with versions simplified by TangoSupport_createSimplifiedMesh
+// on a background thread:
+//
+// - A segment gets a face budget proportional to the part of the screen its
+//   bounds cover, so distant segments are drawn with few faces.
+// - Changed segments are simplified as soon as the thread is free. The
+//   budgets of the others are re-evaluated a few times per second as the view
+//   moves, and a segment is only simplified again when its budget changed by
+//   more than Options::resimplify_ratio.
+// - A simplified segment replaces the previous one whole in the next
+//   SegmentedMesh::Update().
+//
+// The file calls into tango_support_api, which the consumer has to link.
+class MeshSimplifier {
+ public:
+  struct Options {
+    Options()
+        : full_screen_face_count(20000),
+          min_face_count(64),
+          resimplify_ratio(2.0f) {}
+
+    // Face budget of a segment covering the whole screen.
+    uint32_t full_screen_face_count;
+    // Smallest face budget of a visible segment.
+    uint32_t min_face_count;
+    // Budget change, up or down, after which a segment is simplified again.
+    float resimplify_ratio;
+  };
+
+  // @param output: mesh receiving the simplified segments, must outlive the
+  //        simplifier. It must not receive segments from anywhere else.
+  explicit MeshSimplifier(SegmentedMesh* output);
+  MeshSimplifier(const MeshSimplifier& other) = delete;
+  const MeshSimplifier& operator=(const MeshSimplifier&) = delete;
+  ~MeshSimplifier();
+
+  // Must be called while the simplification thread is stopped.
+  void SetOptions(const Options& options) { options_ = options; }
+
+  // Start the simplification thread.
+  void Start();
+
+  // Stop the simplification thread. The full resolution segments are kept.
+  void Stop();
+
+  // Drop every segment. The output mesh has to be cleared separately.
+  void Clear();
+
+  // Copy changed segments, e.g. from the mesh vector callback or the result
+  // of TangoService_Experimental_extractMesh, and schedule their
+  // simplification. A segment without faces removes the segment at its
+  // index.
+  void Submit(int segment_count, const TangoMesh_Experimental* segments);
+
+  // Set the camera the face budgets are computed for, e.g. once per frame
+  // from the GL thread.
+  //
+  // @param projection_view_mat: projection times view matrix of the render
+  //        camera, in the frame of the segments.
+  void SetView(const glm::mat4& projection_view_mat);
+
+  // Call visitor on the full resolution copy of every segment, e.g. to export
+  // the reconstruction. Submit() waits until this returns.
+  void ForEachFullResolutionSegment(
+      const std::function<void(const TangoMesh_Experimental&)>& visitor);
+
+ private:
+  // A full resolution copy, freed with TangoSupport_freeMesh.
+  typedef std::shared_ptr<TangoMesh_Experimental> SharedMesh;
+
+  struct Segment {
+    int32_t index[3];
+    SharedMesh full_mesh;
+    glm::vec3 min;
+    glm::vec3 max;
+    // Face count of the version last sent to the output, 0 if none.
+    uint32_t output_face_count;
+    bool is_dirty;
+  };
+
+  // A segment to simplify, copied out of segments_ by the thread. A job
+  // without mesh removes the segment from the output.
+  struct Job {
+    int32_t index[3];
+    SharedMesh full_mesh;
+    uint32_t face_count;
+  };
+
+  void SimplificationLoop();
+
+  // Face budget of a segment seen through projection_view_mat.
+  uint32_t GetFaceBudget(const Segment& segment,
+                         const glm::mat4& projection_view_mat) const;
+
+  // Simplify the jobs and hand the results to output_.
+  void RunJobs(const std::vector<Job>& jobs);
+
+  SegmentedMesh* output_;
+  Options options_;
+  std::thread thread_;
+
+  // Guarded by mutex_.
+  std::mutex mutex_;
+  std::condition_variable work_available_;
+  std::unordered_map<uint64_t, Segment> segments_;
+  // Segments removed since the thread last ran.
+  std::vector<Job> removals_;
+  bool has_dirty_segments_;
+  glm::mat4 projection_view_mat_;
+  bool is_view_set_;
+  bool is_stopping_;
+};
+}  // namespace tango_gl
+#endif  // TANGO_GL_MESH_SIMPLIFIER_H_
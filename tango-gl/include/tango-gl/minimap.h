@@ -0,0 +1,215 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_GL_MINIMAP_H_
+#define TANGO_GL_MINIMAP_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <unordered_map>
+#include <vector>
+
+#include "tango-gl/util.h"
+#include "tango-gl/vertex_buffer.h"
+
+namespace tango_gl {
+
+// Minimap shows a top down view of the trajectory and the ground grid around
+// the device, e.g. as an inset over the main view, for a cost which does not
+// grow with the session.
+//
+// The map is kept in a persistent texture of tile_count by tile_count tiles,
+// a window of the ground centered on the device. Tiles are addressed
+// toroidally: the ground tile (i, j) lives in the texture slot
+// (i mod tile_count, j mod tile_count), and the texture repeats, so when the
+// device walks into another tile the window scrolls by redrawing only the
+// slots whose ground tile changed. Trajectory segments are indexed by the
+// tiles they overlap; a redrawn slot draws the segments of its new tile,
+// and a new segment is drawn into the slots it overlaps only. Composite()
+// then draws the window around the device as one textured quad.
+//
+// The world frame has y up, e.g. the OpenGL world frame, and the map is its
+// XZ plane seen from above with -z up. All functions but AddPosition() must
+// be called on the GL thread.
+class Minimap {
+ public:
+  struct Options {
+    Options()
+        : tile_pixels(64),
+          tile_count(16),
+          meters_per_pixel(1.0f / 32.0f),
+          grid_pixels(32),
+          line_width(2.0f),
+          view_size(12.0f) {}
+
+    // Side of a tile in pixels, and of the texture in tiles. Their product
+    // should be a power of two, the texture repeats: 1024 by default.
+    int tile_pixels;
+    int tile_count;
+    // Side of a pixel on the ground in meters: tiles of 2 m and a window of
+    // 32 m by default.
+    float meters_per_pixel;
+    // Spacing of the grid lines in pixels, a divisor of tile_pixels: 1 m by
+    // default.
+    int grid_pixels;
+    // Width of the trajectory in pixels.
+    float line_width;
+    // Ground shown across the larger side of the composited rectangle, in
+    // meters, at most tile_count - 2 tiles so it stays in the window.
+    float view_size;
+  };
+
+  explicit Minimap(const Options& options = Options());
+  Minimap(const Minimap& other) = delete;
+  const Minimap& operator=(const Minimap&) = delete;
+  ~Minimap();
+
+  // Append a position of the trajectory if it moved at least a pixel from
+  // the last one. It is drawn by the next Update().
+  void AddPosition(const glm::vec3& position);
+
+  // Scroll the window to the device and draw what changed into the texture:
+  // the slots of the tiles which entered the window, and the segments added
+  // since the last call. An offscreen pass, so it goes before the passes on
+  // the window, e.g. before FrameCache::Begin().
+  void Update(const glm::vec3& device_position);
+
+  // Draw the map around the device into a rectangle of the current
+  // framebuffer, with a marker at the device pointing where it faces.
+  // Restores the viewport before returning.
+  //
+  // @param x, y, width, height: rectangle in pixels.
+  // @param device_position, device_rotation: pose of the device in the world
+  //        frame, as passed to Update().
+  void Composite(GLint x, GLint y, GLsizei width, GLsizei height,
+                 const glm::vec3& device_position,
+                 const glm::quat& device_rotation);
+
+  // Forget the trajectory.
+  void Clear();
+
+  void SetColors(const glm::vec4& background_color,
+                 const glm::vec4& grid_color, const glm::vec4& trace_color,
+                 const glm::vec4& marker_color) {
+    background_color_ = background_color;
+    grid_color_ = grid_color;
+    trace_color_ = trace_color;
+    marker_color_ = marker_color;
+    is_window_valid_ = false;
+  }
+
+  // Slots redrawn by the last Update(), all of them after the first one and
+  // a few when the device crosses into another tile.
+  size_t GetRedrawnSlotCount() const { return redrawn_slot_count_; }
+
+  size_t GetSegmentCount() const {
+    return positions_.empty() ? 0 : positions_.size() - 1;
+  }
+
+  const Options& GetOptions() const { return options_; }
+
+  // Release the GL objects, the texture is redrawn on the next Update().
+  void Release();
+
+  // Forget the GL objects without deleting them. Use this when the GL
+  // context they belonged to has been destroyed.
+  void Invalidate();
+
+ private:
+  // Create the texture, framebuffer, program and grid if needed.
+  bool Allocate();
+
+  // Key of a ground tile in tile_segments_.
+  static int64_t TileKey(int i, int j) {
+    return (static_cast<int64_t>(i) << 32) | static_cast<uint32_t>(j);
+  }
+
+  // Ground tile of a position in meters, x and z.
+  glm::ivec2 GetTile(const glm::vec2& position) const;
+
+  // Ground tiles a segment may draw into, from min_tile to max_tile.
+  void GetSegmentTiles(uint32_t segment, glm::ivec2* min_tile,
+                       glm::ivec2* max_tile) const;
+
+  // Index a segment into the tiles it may draw into.
+  void IndexSegment(uint32_t segment);
+
+  // Whether a ground tile is in the window.
+  bool IsTileInWindow(const glm::ivec2& tile) const;
+
+  // Slot of a ground tile in the texture.
+  glm::ivec2 GetSlot(const glm::ivec2& tile) const;
+
+  void SetSlotScissor(const glm::ivec2& slot);
+
+  // Draw the grid and segments of a ground tile into its slot.
+  //
+  // @param is_clear_needed: whether to clear the slot first, false when the
+  //        whole texture was just cleared.
+  void DrawTile(const glm::ivec2& tile, bool is_clear_needed);
+
+  // Draw the segments of a ground tile from the first index on, clipped to
+  // its slot, whose scissor must be set.
+  void DrawSegments(const glm::ivec2& tile, uint32_t first);
+
+  // Draw vertices of x, y pairs with program_, whose uniforms must be set.
+  void DrawStream(const GLfloat* vertices, size_t float_count, GLenum mode);
+
+  Options options_;
+  int texture_size_;
+  float tile_meters_;
+
+  bool is_unsupported_;
+  GLuint framebuffer_;
+  GLuint texture_;
+
+  GLuint program_;
+  GLint attrib_vertices_;
+  GLint uniform_transform_;
+  GLint uniform_color_;
+  GLuint composite_program_;
+  GLint composite_attrib_vertices_;
+  GLint uniform_composite_transform_;
+  // Lines of the grid over the whole texture, in texture pixels, drawn
+  // scissored to a slot: every tile has the same grid.
+  VertexBuffer grid_buffer_;
+  GLsizei grid_vertex_count_;
+  VertexBuffer quad_buffer_;
+  VertexBuffer stream_buffer_;
+  std::vector<GLfloat> stream_vertices_;
+
+  // Trajectory in meters, x and z; segment k goes from position k to k + 1.
+  std::vector<glm::vec2> positions_;
+  std::unordered_map<int64_t, std::vector<uint32_t>> tile_segments_;
+  // Segments drawn into the texture, the others are drawn by Update().
+  uint32_t drawn_segment_count_;
+
+  // First ground tile of the window, and the ground tile drawn in each slot,
+  // row major.
+  bool is_window_valid_;
+  glm::ivec2 window_origin_;
+  std::vector<glm::ivec2> slot_tiles_;
+  size_t redrawn_slot_count_;
+
+  glm::vec4 background_color_;
+  glm::vec4 grid_color_;
+  glm::vec4 trace_color_;
+  glm::vec4 marker_color_;
+};
+}  // namespace tango_gl
+#endif  // TANGO_GL_MINIMAP_H_
@@ -0,0 +1,96 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_GL_MOTION_GATE_H_
+#define TANGO_GL_MOTION_GATE_H_
+
+#include <stdint.h>
+
+#include "tango-gl/pose_history.h"
+#include "tango-gl/rigid_transform.h"
+
+namespace tango_gl {
+
+// MotionGate tells whether the device moved enough since the last processed
+// frame for a new frame to change the result, so depth pipelines can reuse
+// their registered depth, fitted planes and GPU buffers while the device is
+// still, e.g. mounted on a kiosk.
+//
+// A frame's pose is compared against the pose of the last processed frame,
+// not of the previous one, so slow drift adds up until it opens the gate.
+// While the device is still, every refresh_interval-th frame is processed
+// anyway, so changes of the scene itself show up with a bounded delay.
+//
+// Not thread safe, use it from the thread that processes the frames.
+class MotionGate {
+ public:
+  struct Options {
+    Options()
+        : max_translation(0.005f),
+          max_rotation(0.0087f),
+          refresh_interval(10) {}
+
+    // The device is still while it moved less than this, in meters.
+    float max_translation;
+    // and turned less than this, in radians. The default is half a degree.
+    float max_rotation;
+    // While still, process one frame out of this many. 0 or 1 processes
+    // every frame.
+    int refresh_interval;
+  };
+
+  explicit MotionGate(const Options& options = Options());
+
+  // Decide whether to process a frame. The pose of a frame processed because
+  // the device moved becomes the reference later frames are compared
+  // against; refreshes keep the reference.
+  //
+  // @param pose: pose of the device at the frame timestamp.
+  // @return true if the device moved past the thresholds since the last
+  //         processed frame, if there is none yet, or if a refresh is due.
+  bool ShouldProcess(const RigidTransform& pose);
+  bool ShouldProcess(const glm::mat4& pose) {
+    return ShouldProcess(RigidTransform::FromMatrix(pose));
+  }
+
+  // Same as above, with the pose looked up in a pose history. Frames the
+  // history has no pose for are always processed.
+  bool ShouldProcess(const PoseHistory& pose_history, double timestamp);
+
+  // Process the next frame whatever the motion, e.g. after the settings of
+  // the pipeline changed.
+  void Reset() { has_reference_ = false; }
+
+  const Options& GetOptions() const { return options_; }
+
+  // Whether the device was still at the last ShouldProcess() call.
+  bool IsStill() const { return is_still_; }
+
+  // Number of frames ShouldProcess() skipped.
+  uint64_t GetSkippedFrameCount() const { return skipped_frame_count_; }
+
+ private:
+  Options options_;
+  bool has_reference_;
+  RigidTransform reference_;
+  bool is_still_;
+  // Frames skipped since the last processed one.
+  int still_frame_count_;
+  uint64_t skipped_frame_count_;
+};
+}  // namespace tango_gl
+#endif  // TANGO_GL_MOTION_GATE_H_
@@ -0,0 +1,113 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TANGO_GL_NORMAL_ESTIMATOR_H_
+#define TANGO_GL_NORMAL_ESTIMATOR_H_
+
+#include <functional>
+#include <vector>
+
+#include "tango-gl/range_image.h"
+#include "tango-gl/util.h"
+#include "tango-gl/worker_pool.h"
+
+namespace tango_gl {
+
+// NormalEstimator computes a surface normal for every pixel of a RangeImage
+// from the covariance of the points in a square window around the pixel,
+// the normal being the direction of least variance. The window sums of the
+// coordinates and of their products are read from integral images, so a
+// normal costs the same whatever the window size.
+//
+// Points are the pixel centers back projected with their depth, see
+// RangeImage::GetPosition(). The integral images are built and read in
+// parallel bands of rows on the worker pool.
+class NormalEstimator {
+ public:
+  // Default half size of the window, 7 by 7 pixels.
+  static const int kDefaultWindowRadius = 3;
+
+  // Fewest points a window needs for a normal.
+  static const int kMinWindowPointCount = 3;
+
+  // @param worker_pool: pool to compute in parallel on, can be nullptr to
+  //        compute on the calling thread only.
+  explicit NormalEstimator(WorkerPool* worker_pool);
+  NormalEstimator(const NormalEstimator& other) = delete;
+  const NormalEstimator& operator=(const NormalEstimator&) = delete;
+
+  // Windows span 2 * radius + 1 pixels per side, clipped by the image
+  // borders.
+  void SetWindowRadius(int radius);
+  int GetWindowRadius() const { return window_radius_; }
+
+  // Compute the normals of a range image.
+  //
+  // @return number of pixels with a normal.
+  size_t Compute(const RangeImage& image);
+
+  int GetWidth() const { return width_; }
+  int GetHeight() const { return height_; }
+
+  // Row major, GetWidth() * GetHeight() unit normals in the depth camera
+  // frame, facing the camera. Zero for pixels without a point or with too
+  // few points around them.
+  const glm::vec3* GetNormals() const { return normals_.data(); }
+
+  glm::vec3 GetNormal(int x, int y) const { return normals_[y * width_ + x]; }
+
+ private:
+  // Sums over a rectangle of points: their count, coordinates and products
+  // of coordinates. Doubles, since window covariances are small differences
+  // of sums over the whole image.
+  struct Moments {
+    double count;
+    double x, y, z;
+    double xx, xy, xz, yy, yz, zz;
+  };
+
+  // Fill the rows [begin, end) of the integral image with the sums over
+  // their row prefixes.
+  void SumRows(const RangeImage& image, int begin, int end);
+
+  // Add the columns [begin, end) of the integral image up over the rows.
+  void SumColumns(int begin, int end);
+
+  // Compute the normals of rows [begin, end).
+  size_t ComputeRows(const RangeImage& image, int begin, int end);
+
+  void RunTasks(int task_count, const std::function<void(int)>& task);
+
+  WorkerPool* worker_pool_;
+  int window_radius_;
+  int width_;
+  int height_;
+
+  // (width_ + 1) * (height_ + 1) sums over the rectangle from the image
+  // origin up to, but not including, each entry's pixel.
+  std::vector<Moments> integral_;
+  std::vector<glm::vec3> normals_;
+};
+
+// Unit eigenvector of the smallest eigenvalue of a symmetric 3x3 matrix, e.g.
+// the normal of the least squares plane through points with that
+// covariance.
+//
+// @return false if the smallest eigenvalue is not unique, e.g. when all the
+//         points are the same or collinear.
+bool SmallestEigenvector(const glm::dmat3& matrix, glm::dvec3* eigenvector);
+}  // namespace tango_gl
+#endif  // TANGO_GL_NORMAL_ESTIMATOR_H_
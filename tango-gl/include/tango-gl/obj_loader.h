@@ -17,6 +17,8 @@
 #ifndef TANGO_GL_OBJ_LOADER_H
 #define TANGO_GL_OBJ_LOADER_H
 
+#include <stdint.h>
+
 #include <vector>
 
 #include "tango-gl/util.h"
@@ -40,6 +42,10 @@ namespace obj_loader {
 //   ...
 //   vn 1.00 2.00 3.00
 //   ..."
+//  Texture coordinates ("f 1/1/1 ...") and negative indices are accepted,
+//  polygons are split into triangle fans. The file is read in one go and
+//  parsed in memory.
+//
 //  this can be used with Mesh:
 //
 //  std::vector<GLfloat> vertices;
@@ -51,11 +57,106 @@ namespace obj_loader {
 //  tango_gl::obj_loader::LoadOBJData("/sdcard/model.obj", vertices, normals);
 //  mesh->SetVertices(vertices, normals);
 
+// Vertices shared by position with 16 bit indices. Fails if the mesh has more
+// than 65536 vertices.
 bool LoadOBJData(const char* path, std::vector<GLfloat>& vertices,
                  std::vector<GLushort>& indices);
 
+// Vertices shared by position with 32 bit indices, drawing them needs
+// OpenGL ES 3 or GL_OES_element_index_uint.
+bool LoadOBJData(const char* path, std::vector<GLfloat>& vertices,
+                 std::vector<GLuint>& indices);
+
+// One vertex and normal per triangle corner, without indices.
 bool LoadOBJData(const char* path, std::vector<GLfloat>& vertices,
                  std::vector<GLfloat>& normals);
+
+// Indexed mesh with one vertex per distinct (v, vn) pair of the faces.
+// Corners without a normal get a zero normal.
+bool LoadOBJData(const char* path, std::vector<GLfloat>& vertices,
+                 std::vector<GLfloat>& normals, std::vector<GLuint>& indices);
+
+// A mesh in the binary cache format, memory mapped read only. The format is
+// a header followed by an interleaved vertex block (position, then normal if
+// present, as floats) and an optional 16 or 32 bit index block, so the blocks
+// can be handed to glBufferData() as they are. 32 bit indices are only used
+// for meshes with more than 65536 vertices:
+//
+//  tango_gl::obj_loader::MappedMesh model;
+//  tango_gl::obj_loader::LoadOBJData("/sdcard/model.obj", true, &model);
+//  mesh->SetVertices(model);
+class MappedMesh {
+ public:
+  MappedMesh();
+  MappedMesh(const MappedMesh& other) = delete;
+  const MappedMesh& operator=(const MappedMesh&) = delete;
+  ~MappedMesh();
+
+  // Map a binary mesh file.
+  //
+  // @param path: path of the binary mesh file.
+  // @param with_normals: whether the mesh is expected to be built with
+  //        normals, see LoadOBJData().
+  // @param source_size: expected size of the OBJ file it was built from.
+  // @param source_mtime: expected modification time of that OBJ file.
+  // @return false if the file is missing, malformed or stale.
+  bool Map(const char* path, bool with_normals, int64_t source_size,
+           int64_t source_mtime);
+
+  // Unmap the file, the mesh is empty afterwards.
+  void Unmap();
+
+  bool IsMapped() const { return mapping_ != nullptr; }
+
+  // Interleaved vertex block, GetVertexStride() bytes per vertex.
+  const void* GetVertexData() const { return vertex_data_; }
+  uint32_t GetVertexCount() const { return vertex_count_; }
+  size_t GetVertexStride() const {
+    return (has_normals_ ? 6 : 3) * sizeof(GLfloat);
+  }
+  bool HasNormals() const { return has_normals_; }
+
+  // Index block, empty for a non indexed mesh. The index type is
+  // GL_UNSIGNED_SHORT or GL_UNSIGNED_INT.
+  const void* GetIndexData() const { return index_data_; }
+  uint32_t GetIndexCount() const { return index_count_; }
+  GLenum GetIndexType() const { return index_type_; }
+  size_t GetIndexSize() const {
+    return index_type_ == GL_UNSIGNED_INT ? sizeof(GLuint) : sizeof(GLushort);
+  }
+
+ private:
+  friend bool LoadOBJData(const char* path, bool with_normals,
+                          MappedMesh* mesh);
+
+  // Take ownership of a mapping holding a binary mesh and point the blocks
+  // into it. The mapping is released if it is malformed or stale.
+  bool Attach(void* mapping, size_t mapping_size, bool with_normals,
+              int64_t source_size, int64_t source_mtime);
+
+  void* mapping_;
+  size_t mapping_size_;
+  const void* vertex_data_;
+  uint32_t vertex_count_;
+  bool has_normals_;
+  const void* index_data_;
+  uint32_t index_count_;
+  GLenum index_type_;
+};
+
+// Load an OBJ file through the binary cache at <path>.mesh. The cache is
+// written on the first load and mapped on later ones, as long as the size and
+// modification time of the OBJ file, and with_normals, match the ones
+// recorded in it; a load with the other with_normals rebuilds it. If the
+// cache cannot be written (e.g. a read only directory), the mesh is parsed on
+// every load and held in anonymous memory instead.
+//
+// @param path: path of the OBJ file.
+// @param with_normals: keep the normals of the file, vertices are then shared
+//        per (v, vn) pair like the indexed normals overload.
+// @param mesh: the loaded mesh.
+// @return false if the OBJ file could not be loaded.
+bool LoadOBJData(const char* path, bool with_normals, MappedMesh* mesh);
 }  // namespace obj_loader
 }  // namespace tango_gl
 #endif  // TANGO_GL_OBJ_LOADER
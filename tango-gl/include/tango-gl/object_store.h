@@ -0,0 +1,170 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_GL_OBJECT_STORE_H_
+#define TANGO_GL_OBJECT_STORE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include "tango-gl/mesh.h"
+#include "tango-gl/util.h"
+#include "tango-gl/view_frustum.h"
+
+namespace tango_gl {
+
+// ObjectStore holds many placed objects, e.g. thousands of anchored markers,
+// as contiguous arrays instead of one Mesh with its own Transform per
+// object: the pose, scale, world matrix, world bounds, color and mesh of
+// every object are each an array indexed by the object's slot.
+//
+// The shapes are Mesh prototypes registered with AddMesh(), which keep
+// their geometry, render mode and lighting; an object only names its mesh.
+// Update() recomputes the world matrices and bounds of the objects moved
+// since the last call, and culls every object against a frustum with the
+// bounds as separate x, y and z arrays, four boxes at a time with NEON
+// where available. It then packs the model matrix and color of the visible
+// objects of each mesh in the per instance layout of DrawBatch, which draws
+// them with one instanced draw call per mesh, see DrawBatch::Add().
+//
+// Objects are removed by moving the last one into their slot, so the arrays
+// stay dense. Ids stay valid until the object is removed, and are reused
+// afterwards. The store does not own the prototypes, they must outlive it.
+// Not thread safe.
+class ObjectStore {
+ public:
+  typedef uint32_t ObjectId;
+  static const ObjectId kNoObject = UINT32_MAX;
+
+  // Floats per object in the instance data: a column major model matrix
+  // followed by a color.
+  static const int kInstanceFloats = 16 + 4;
+
+  ObjectStore();
+  ObjectStore(const ObjectStore& other) = delete;
+  const ObjectStore& operator=(const ObjectStore&) = delete;
+
+  // Register the shape of a kind of object. The bounding box of the mesh
+  // vertices is used for culling; meshes without CPU side vertices are
+  // never culled.
+  //
+  // @return id of the mesh for Add().
+  uint32_t AddMesh(const Mesh* prototype);
+
+  size_t GetMeshCount() const { return meshes_.size(); }
+  const Mesh* GetMesh(uint32_t mesh) const { return meshes_[mesh].prototype; }
+
+  // Place an object.
+  //
+  // @param mesh: id from AddMesh().
+  // @return id of the object.
+  ObjectId Add(uint32_t mesh, const glm::vec3& position,
+               const glm::quat& rotation, const glm::vec3& scale,
+               const glm::vec4& color);
+
+  // Remove an object. No-op for an id not in the store.
+  void Remove(ObjectId id);
+
+  // Remove all objects, keeping the meshes.
+  void Clear();
+
+  bool Contains(ObjectId id) const {
+    return id < slots_.size() && slots_[id] != kNoSlot;
+  }
+
+  size_t GetObjectCount() const { return object_ids_.size(); }
+
+  void SetPose(ObjectId id, const glm::vec3& position,
+               const glm::quat& rotation);
+  void SetScale(ObjectId id, const glm::vec3& scale);
+  void SetColor(ObjectId id, const glm::vec4& color);
+
+  // Model matrix of an object as of the last Update().
+  const glm::mat4& GetTransformationMatrix(ObjectId id) const {
+    return world_matrices_[slots_[id]];
+  }
+
+  // Update the moved objects, cull them all and pack the instance data of
+  // the visible ones. Call once per frame, before rendering.
+  //
+  // @param frustum: frustum of the render camera, updated for the frame.
+  //        Only its planes are tested.
+  void Update(const ViewFrustum& frustum);
+
+  // Objects visible in the frustum of the last Update().
+  size_t GetVisibleCount() const { return visible_count_; }
+
+  // Instance data of the visible objects of a mesh, kInstanceFloats per
+  // object, as of the last Update().
+  const std::vector<GLfloat>& GetInstances(uint32_t mesh) const {
+    return meshes_[mesh].instances;
+  }
+
+ private:
+  static const uint32_t kNoSlot = UINT32_MAX;
+
+  struct MeshEntry {
+    const Mesh* prototype;
+    // Bounds of the vertices in model coordinates.
+    glm::vec3 center;
+    glm::vec3 half_extents;
+    bool is_culled;
+    std::vector<GLfloat> instances;
+  };
+
+  void MarkMoved(uint32_t slot);
+
+  // Resize the bounds arrays to the object count rounded up to 4.
+  void ResizeBounds();
+
+  std::vector<MeshEntry> meshes_;
+
+  // Slot of each id, kNoSlot for free ids, and the free ids.
+  std::vector<uint32_t> slots_;
+  std::vector<ObjectId> free_ids_;
+
+  // Per slot.
+  std::vector<ObjectId> object_ids_;
+  std::vector<uint32_t> mesh_ids_;
+  std::vector<glm::vec3> positions_;
+  std::vector<glm::quat> rotations_;
+  std::vector<glm::vec3> scales_;
+  std::vector<glm::vec4> colors_;
+  std::vector<glm::mat4> world_matrices_;
+  // Moved since the last Update(), and the slots of those.
+  std::vector<uint8_t> is_moved_;
+  std::vector<uint32_t> moved_slots_;
+
+  // World bounds as x, y, z of the centers then of the half extents, padded
+  // to a multiple of 4 slots; the padding is tested and ignored. Boxes of
+  // meshes never culled get huge extents.
+  std::vector<float> bounds_[6];
+  std::vector<uint8_t> is_visible_;
+  size_t visible_count_;
+};
+
+namespace internal {
+// NEON kernel, defined in object_store_neon.cpp. Tests box_count boxes, a
+// multiple of 4, against the planes and sets is_visible to 1 or 0 each.
+void CullBoxesNeon(const glm::vec4 planes[6], const float* const bounds[6],
+                   size_t box_count, uint8_t* is_visible);
+}  // namespace internal
+
+}  // namespace tango_gl
+#endif  // TANGO_GL_OBJECT_STORE_H_
@@ -0,0 +1,113 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_GL_OCCLUSION_CULLER_H_
+#define TANGO_GL_OCCLUSION_CULLER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include "tango-gl/util.h"
+
+namespace tango_gl {
+
+// OcclusionCuller skips boxes hidden behind real surfaces, e.g. mesh
+// segments behind a wall, using a low resolution hierarchical depth buffer
+// of the render camera built on the CPU.
+//
+// Build() projects a registered depth frame into a grid of
+// Options::width x Options::height cells, each keeping the farthest depth of
+// its points, and reduces it to a pyramid of 2x2 maxima. Cells with fewer
+// than Options::min_cell_points points hold no occluder. IsBoxOccluded()
+// projects the corners of a box, picks the level where its screen rectangle
+// spans at most 2x2 cells, and reports it hidden if its nearest corner is
+// behind the farthest occluder of those cells. The points are projected by
+// projection::ProjectPoints() and the corners transformed by
+// simd_math::TransformBoxCorners(), both vectorized where available.
+//
+// The pyramid is conservative for surfaces the depth camera sampled densely
+// enough, but the depth frame is older than the render camera pose and has
+// holes, so surfaces it missed never occlude. Attach the culler to the
+// ViewFrustum of the same camera with ViewFrustum::SetOcclusionCuller() to
+// cull everything tested against that frustum.
+class OcclusionCuller {
+ public:
+  struct Options {
+    Options() : width(64), height(48), min_cell_points(3), depth_bias(0.1f) {}
+
+    // Cells of the finest level.
+    int width;
+    int height;
+    // Points a cell needs to occlude, fewer leave it empty.
+    int min_cell_points;
+    // Distance in meters a box must be behind the occluder to be culled,
+    // for the depth noise and the motion since the depth frame.
+    float depth_bias;
+  };
+
+  OcclusionCuller();
+  OcclusionCuller(const OcclusionCuller& other) = delete;
+  const OcclusionCuller& operator=(const OcclusionCuller&) = delete;
+
+  // Takes effect at the next Build().
+  void SetOptions(const Options& options) { options_ = options; }
+
+  // Build the pyramid from a depth frame seen from the render camera.
+  //
+  // @param points: packed x, y, z coordinates, point_count * 3 floats.
+  // @param point_count: number of points.
+  // @param view_T_points: transformation of the points frame with respect to
+  //        the OpenGL frame of the render camera, e.g. the depth camera
+  //        registered to the color image being rendered.
+  // @param projection_mat: projection matrix of the render camera.
+  void Build(const float* points, size_t point_count,
+             const glm::mat4& view_T_points, const glm::mat4& projection_mat);
+
+  // Forget the occluders, nothing is culled until the next Build().
+  void Clear();
+
+  // Whether an axis-aligned box is hidden.
+  //
+  // @param clip_T_world: projection times view matrix of the render camera
+  //        at the pose the pyramid was built for.
+  // @param center: center of the box in world coordinates.
+  // @param half_extents: half size of the box along each axis.
+  bool IsBoxOccluded(const glm::mat4& clip_T_world, const glm::vec3& center,
+                     const glm::vec3& half_extents) const;
+
+  bool IsEmpty() const { return levels_.empty(); }
+
+ private:
+  struct Level {
+    int width;
+    int height;
+    // Farthest occluder depth per cell, infinity for empty cells.
+    std::vector<float> depths;
+  };
+
+  Options options_;
+  std::vector<Level> levels_;
+
+  // Scratch buffers of Build(), kept to reuse their storage.
+  std::vector<int32_t> pixels_;
+  std::vector<float> point_depths_;
+  std::vector<uint16_t> cell_counts_;
+};
+}  // namespace tango_gl
+#endif  // TANGO_GL_OCCLUSION_CULLER_H_
@@ -0,0 +1,262 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_GL_OCCUPANCY_GRID_H_
+#define TANGO_GL_OCCUPANCY_GRID_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include "tango-gl/streaming_texture.h"
+#include "tango-gl/util.h"
+
+namespace tango_gl {
+
+// OccupancyGrid builds a 2D obstacle map for navigation from depth frames,
+// on the horizontal plane of a z up map frame: start of service, or an area
+// description once localized, so a saved grid can be reused in later
+// sessions.
+//
+// Cells hold the log-odds of being occupied, 0 for never observed. They are
+// grouped in tiles of kTileSize^2 which are only allocated where the depth
+// camera looked, so memory follows the visited area; tiles come from a pool
+// of fixed size found through an open addressing hash table, and once the
+// pool is exhausted new areas are not mapped anymore.
+//
+// Integrate() updates the grid from a frame in three steps:
+//
+// 1. The points are classified by height into floor and obstacles, and
+//    binned by bearing from the camera into a scan holding, per bearing,
+//    the nearest obstacle and the farthest point seen.
+// 2. Every cell of the tiles within reach is looked up in the scan: cells in
+//    front of the nearest obstacle are free, cells at it are hit, and cells
+//    behind it or without data are left alone. This projective update visits
+//    each cell once however many rays cross it, unlike tracing every ray.
+// 3. The log-odds are updated per tile, four cells at a time on NEON capable
+//    devices, then the coarser levels of the updated tiles are rebuilt.
+//
+// Each tile keeps kLevelCount levels, level n cells covering 2^n cells of
+// level 0 with their largest log-odds, so a coarse cell is as occupied as
+// the most occupied cell it covers, e.g. for planning over large areas.
+//
+// An OccupancyGrid is not thread safe, callers serialize Integrate() and
+// reads.
+class OccupancyGrid {
+ public:
+  // Edge of a tile in cells of level 0.
+  static const int kTileSize = 64;
+  static const int kCellsPerTile = kTileSize * kTileSize;
+  // Levels of detail, level n cells are 2^n cells of level 0.
+  static const int kLevelCount = 3;
+
+  struct Options {
+    Options()
+        : cell_size(0.05f),
+          floor_height(-1.2f),
+          min_obstacle_height(0.1f),
+          max_obstacle_height(1.8f),
+          max_range(4.0f),
+          bearing_resolution(0.5f),
+          log_odds_hit(0.85f),
+          log_odds_free(-0.4f),
+          min_log_odds(-2.0f),
+          max_log_odds(3.5f),
+          max_tile_count(1024) {}
+
+    // Edge of a level 0 cell in meters.
+    float cell_size;
+    // Height of the floor in the map frame, in meters. The start of service
+    // origin is where the device was at startup, usually held at chest
+    // height; see SetFloorHeight().
+    float floor_height;
+    // Points between these heights above the floor are obstacles, points
+    // below are floor and only mark space as free, points above are
+    // ignored.
+    float min_obstacle_height;
+    float max_obstacle_height;
+    // Points farther from the camera in meters are ignored.
+    float max_range;
+    // Width of a bearing bin of the scan, in degrees.
+    float bearing_resolution;
+    // Log-odds added to a cell per hit, and per frame it is seen free.
+    float log_odds_hit;
+    float log_odds_free;
+    // Log-odds are clamped to this range, so cells can change their mind.
+    float min_log_odds;
+    float max_log_odds;
+    // Number of tiles in the pool. Each tile takes about
+    // kCellsPerTile * 5.3 bytes.
+    size_t max_tile_count;
+  };
+
+  // Cells of a tile, x varying fastest.
+  struct Tile {
+    // Tile coordinates, the tile spans [x, x + 1) * kTileSize * cell_size
+    // along x, and so on.
+    int32_t x;
+    int32_t y;
+    // Value of GetRevision() when the tile was last updated.
+    uint32_t revision;
+    float log_odds[kCellsPerTile];
+    // Levels 1 to kLevelCount - 1, one after the other.
+    float coarse_log_odds[kCellsPerTile / 4 + kCellsPerTile / 16];
+  };
+
+  explicit OccupancyGrid(const Options& options);
+  OccupancyGrid(const OccupancyGrid& other) = delete;
+  const OccupancyGrid& operator=(const OccupancyGrid&) = delete;
+  ~OccupancyGrid();
+
+  // Drop every tile.
+  void Clear();
+
+  // Move the floor, e.g. to the height of a fitted floor plane. Cells
+  // already in the grid are kept.
+  void SetFloorHeight(float floor_height) {
+    options_.floor_height = floor_height;
+  }
+
+  // Update the grid from a depth frame.
+  //
+  // @param xyz: packed x, y, z coordinates in the depth camera frame.
+  // @param point_count: number of points.
+  // @param map_T_depth: pose of the depth camera with respect to the map
+  //        frame at the frame timestamp.
+  // @return the number of tiles updated.
+  size_t Integrate(const float* xyz, size_t point_count,
+                   const glm::mat4& map_T_depth);
+
+  const Options& GetOptions() const { return options_; }
+
+  // Number of Integrate() calls so far, stamped on the tiles they update.
+  uint32_t GetRevision() const { return revision_; }
+
+  // Allocated tiles, indices are stable until Clear().
+  size_t GetTileCount() const { return tile_count_; }
+  const Tile& GetTile(size_t index) const { return tiles_[index]; }
+
+  // Index of the tile at tile coordinates, -1 if it is not allocated.
+  int32_t FindTile(int32_t x, int32_t y) const;
+
+  // Log-odds of the cell of a level at a position, 0 if never observed.
+  //
+  // @param x, y: position in the map frame.
+  // @param level: level of detail, from 0 to kLevelCount - 1.
+  float GetLogOdds(float x, float y, int level) const;
+
+  // Write a window of a level into a streaming texture, centered on a
+  // position and snapped to cells so it does not shimmer as the center
+  // moves. The texture must be allocated as GL_LUMINANCE_ALPHA; one texel
+  // per cell, luminance from white (free) to black (occupied), alpha 0 for
+  // cells never observed. Must be called on the GL thread.
+  //
+  // @param x, y: center of the window in the map frame.
+  // @param level: level of detail, from 0 to kLevelCount - 1.
+  // @param texture: destination, its size sets the window size.
+  // @return the map frame rectangle covered by the texture, as min x,
+  //         min y, max x, max y; texture coordinate (0, 0) is at min x,
+  //         min y.
+  glm::vec4 UpdateTexture(float x, float y, int level,
+                          StreamingTexture* texture) const;
+
+  // Write the grid to a file, tagged with the base frame of the poses it
+  // was built with, e.g. TANGO_COORDINATE_FRAME_AREA_DESCRIPTION.
+  //
+  // @return false if the file cannot be written.
+  bool Save(const char* path, uint32_t base_frame) const;
+
+  // Replace the grid with one written by Save().
+  //
+  // @param base_frame: set to the base frame the grid was saved with.
+  // @return false if the file cannot be read, is malformed, or has another
+  //         cell size; the grid is then left empty.
+  bool Load(const char* path, uint32_t* base_frame);
+
+ private:
+  // Index of the tile at tile coordinates, allocated if needed. -1 if the
+  // pool is exhausted.
+  int32_t AcquireTile(int32_t x, int32_t y);
+
+  // Classify the points and fill the scan, and the bounds of the cells it
+  // reaches in the map frame.
+  void BuildScan(const float* xyz, size_t point_count,
+                 const glm::mat4& map_T_depth);
+
+  // Update the cells of a tile from the scan.
+  void IntegrateTile(int32_t index);
+
+  // Rebuild levels 1 and up of a tile from level 0.
+  static void BuildCoarseLevels(Tile* tile);
+
+  Options options_;
+
+  std::vector<Tile> tiles_;
+  size_t tile_count_;
+  uint32_t revision_;
+  bool has_logged_full_;
+
+  // Open addressing table of tile indices, -1 for an empty slot. Twice the
+  // pool size, a power of two.
+  std::vector<int32_t> table_;
+  size_t table_mask_;
+
+  // Per frame scratch, reused between frames. Per bearing bin, the range of
+  // the nearest obstacle, infinite if none, and the range up to which space
+  // is free, 0 if nothing was seen.
+  glm::vec2 camera_;
+  std::vector<float> hit_ranges_;
+  std::vector<float> free_ranges_;
+  glm::vec2 scan_min_;
+  glm::vec2 scan_max_;
+  std::vector<int32_t> frame_tiles_;
+  std::vector<float> cell_ranges_;
+  std::vector<float> cell_hit_ranges_;
+  std::vector<float> cell_free_ranges_;
+};
+
+namespace internal {
+// Update the log-odds of cells from their scan ranges, the inner loop of
+// OccupancyGrid::Integrate().
+//
+// @param ranges: distance of each cell center from the camera.
+// @param hit_ranges: range of the nearest obstacle in the bearing of each
+//        cell, infinite if none.
+// @param free_ranges: range up to which the bearing of each cell is free.
+// @param count: number of cells.
+// @param hit_half_width: cells within this distance of the obstacle range
+//        are hit.
+// @param log_odds_hit, log_odds_free, min_log_odds, max_log_odds: see
+//        OccupancyGrid::Options.
+// @param log_odds: cell log-odds, updated in place.
+void UpdateCells(const float* ranges, const float* hit_ranges,
+                 const float* free_ranges, size_t count, float hit_half_width,
+                 float log_odds_hit, float log_odds_free, float min_log_odds,
+                 float max_log_odds, float* log_odds);
+
+// NEON kernel, defined in occupancy_grid_neon.cpp. Updates the first
+// count & ~3 cells; the caller updates the remaining cells.
+void UpdateCellsNeon(const float* ranges, const float* hit_ranges,
+                     const float* free_ranges, size_t count,
+                     float hit_half_width, float log_odds_hit,
+                     float log_odds_free, float min_log_odds,
+                     float max_log_odds, float* log_odds);
+}  // namespace internal
+
+}  // namespace tango_gl
+#endif  // TANGO_GL_OCCUPANCY_GRID_H_
@@ -0,0 +1,51 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_GL_OFFSCREEN_CONTEXT_H_
+#define TANGO_GL_OFFSCREEN_CONTEXT_H_
+
+#include <EGL/egl.h>
+
+namespace tango_gl {
+// A GLES2 context rendering into a pbuffer, for tools and benchmarks that
+// run without a window, e.g. from adb shell or on a desktop without a
+// display. The context is current on the thread calling Create() until the
+// object is destroyed.
+class OffscreenContext {
+ public:
+  OffscreenContext();
+  OffscreenContext(const OffscreenContext& other) = delete;
+  const OffscreenContext& operator=(const OffscreenContext&) = delete;
+  ~OffscreenContext();
+
+  // Create the context and make it current.
+  //
+  // @param width: width of the pbuffer in pixels.
+  // @param height: height of the pbuffer in pixels.
+  // @return: false if EGL has no display or no pbuffer capable
+  //          configuration.
+  bool Create(int width, int height);
+
+  void SwapBuffers();
+
+ private:
+  EGLDisplay display_;
+  EGLSurface surface_;
+  EGLContext context_;
+};
+}  // namespace tango_gl
+#endif  // TANGO_GL_OFFSCREEN_CONTEXT_H_
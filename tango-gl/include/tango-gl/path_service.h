@@ -0,0 +1,158 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_GL_PATH_SERVICE_H_
+#define TANGO_GL_PATH_SERVICE_H_
+
+#include <stdint.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <tango_client_api.h>  // NOLINT
+
+#include "tango-gl/band.h"
+#include "tango-gl/util.h"
+
+namespace tango_gl {
+
+// PathService plans paths to goals with
+// TangoService_Experimental_getTrajectoryToGoal() without ever blocking the
+// caller: the planner is synchronous and can take a while, so queries run on
+// a worker thread and the render thread only picks up their results.
+//
+// Paths are cached per goal, switching back to a goal shows its last path
+// at once. A goal is planned again only once the device strays farther than
+// a threshold from its cached path, or after a failed query once the retry
+// interval passed.
+//
+// Goals and paths are in the base frame of the options, usually the area
+// description, so the service is only useful once localized.
+//
+// All functions are thread safe, and only take a lock long enough to copy a
+// goal or a path.
+class PathService {
+ public:
+  struct Options {
+    Options()
+        : base_frame(TANGO_COORDINATE_FRAME_AREA_DESCRIPTION),
+          deviation_threshold(0.5f),
+          retry_interval(std::chrono::milliseconds(1000)),
+          max_goal_count(16) {}
+
+    // Frame of the goals and paths, see getTrajectoryToGoal().
+    TangoCoordinateFrameType base_frame;
+    // Distance in meters from the cached path beyond which the goal is
+    // planned again.
+    float deviation_threshold;
+    // Wait after a failed query before trying the goal again.
+    std::chrono::milliseconds retry_interval;
+    // Goals cached, the least recently set is dropped first.
+    size_t max_goal_count;
+  };
+
+  explicit PathService(const Options& options);
+  PathService(const PathService& other) = delete;
+  const PathService& operator=(const PathService&) = delete;
+  // Waits for a running query.
+  ~PathService();
+
+  // Make a goal the active one. A goal set before, at the same position,
+  // keeps its cached path.
+  void SetGoal(const glm::vec3& goal);
+
+  // Drop the active goal, and every cached path, e.g. when the area
+  // description changes.
+  void Clear();
+
+  // Plan the active goal again if needed, call once per frame.
+  //
+  // @param device_position: device position in the base frame.
+  void Update(const glm::vec3& device_position);
+
+  // Copy the path to the active goal.
+  //
+  // @param path: set to the path, from the device position it was planned
+  //        at to the goal.
+  // @param revision: set to a number that changes with every new path.
+  // @return false if there is no path yet.
+  bool GetPath(std::vector<glm::vec3>* path, uint32_t* revision) const;
+
+  // Set a band to the path to the active goal if it changed since the last
+  // call, must be called on the GL thread.
+  //
+  // @param world_T_base: transformation from the base frame to the frame
+  //        the band is rendered in.
+  // @param up: up direction of the band in its frame.
+  // @return true if the band was changed.
+  bool UpdateBand(const glm::mat4& world_T_base, const glm::vec3& up,
+                  Band* band);
+
+  // Error of the last query for the active goal, TANGO_SUCCESS if it was
+  // planned or has not been queried yet.
+  TangoErrorType GetLastError() const;
+
+ private:
+  struct Goal {
+    glm::vec3 position;
+    std::vector<glm::vec3> path;
+    // 0 while there is no path.
+    uint32_t revision;
+    TangoErrorType last_error;
+    std::chrono::steady_clock::time_point last_query_time;
+    // Value of use_count_ when the goal was last set.
+    uint64_t last_use;
+  };
+
+  // Index of the goal at a position, -1 if it is not cached. Called with
+  // mutex_ held.
+  int FindGoal(const glm::vec3& position) const;
+
+  // Whether the active goal needs to be planned from a position. Called with
+  // mutex_ held.
+  bool NeedsQuery(const glm::vec3& device_position,
+                  std::chrono::steady_clock::time_point now) const;
+
+  void WorkerLoop();
+
+  // Run the planner, without any lock held.
+  TangoErrorType Plan(const glm::vec3& goal, std::vector<glm::vec3>* path);
+
+  const Options options_;
+
+  mutable std::mutex mutex_;
+  std::vector<Goal> goals_;
+  // Index into goals_, -1 for none.
+  int active_goal_;
+  uint64_t use_count_;
+  uint32_t next_revision_;
+  // Revision of the path last given to UpdateBand().
+  uint32_t band_revision_;
+
+  // Query handed to the worker, guarded by mutex_.
+  std::condition_variable query_changed_;
+  bool has_query_;
+  glm::vec3 query_goal_;
+  bool is_querying_;
+  bool is_stopping_;
+  std::thread worker_;
+};
+}  // namespace tango_gl
+#endif  // TANGO_GL_PATH_SERVICE_H_
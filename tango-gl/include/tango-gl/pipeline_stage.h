@@ -0,0 +1,218 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TANGO_GL_PIPELINE_STAGE_H_
+#define TANGO_GL_PIPELINE_STAGE_H_
+
+#include <stdint.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include "tango-gl/bounded_queue.h"
+#include "tango-gl/tracing.h"
+#include "tango-gl/util.h"
+
+namespace tango_gl {
+
+// Pin the calling thread to a CPU core.
+//
+// @return: false if pinning is not supported or the core does not exist.
+bool PinCurrentThreadToCpu(int cpu);
+
+// Counters of a PipelineStage since it was created.
+struct PipelineStageStatistics {
+  uint64_t submitted_count;
+  uint64_t processed_count;
+  // Values replaced by newer ones before the worker got to them.
+  uint64_t dropped_count;
+  // Time from Submit() to the end of processing, of the last processed value.
+  float latency_ms;
+};
+
+// PipelineStage moves one step of a sensor pipeline, e.g. filtering a depth
+// frame, off the latency critical Tango callback and GL threads. Stages are
+// chained by submitting to the next stage at the end of process, and the
+// last stage hands off to the renderer, e.g. through a TripleBuffer:
+//
+//   callback -> Submit() -> [queue] -> worker: process(value) -> handoff
+//
+// The queue is bounded and latest wins: when it is full, Submit() drops the
+// oldest value instead of waiting, so a slow stage sheds load rather than
+// stalling its producer or building up latency. Values are meant to be cheap
+// handles, e.g. PointCloudPool::Handle.
+//
+// Each processed value is recorded as a span named after the stage when
+// tracing is compiled in, and GetStatistics() reports the latency and drop
+// counters, e.g. for FrameProfiler::SetCounter() or a debug HUD.
+//
+// Submit() is meant for a single producer thread.
+template <typename T>
+class PipelineStage {
+ public:
+  typedef std::function<void(T* value)> Process;
+
+  // @param name: string literal naming the worker thread and its spans.
+  // @param capacity: number of values queued for the worker.
+  // @param cpu: core the worker is pinned to, -1 leaves it to the scheduler.
+  // @param process: run on the worker for each value, in submit order.
+  PipelineStage(const char* name, size_t capacity, int cpu, Process process)
+      : name_(name),
+        cpu_(cpu),
+        process_(process),
+        queue_(capacity),
+        has_work_(false),
+        is_stopping_(false),
+        submitted_count_(0),
+        processed_count_(0),
+        dropped_count_(0),
+        latency_us_(0) {}
+  PipelineStage(const PipelineStage& other) = delete;
+  const PipelineStage& operator=(const PipelineStage&) = delete;
+  ~PipelineStage() { Stop(); }
+
+  // Start the worker, no-op if it is running.
+  void Start() {
+    if (thread_.joinable()) {
+      return;
+    }
+    is_stopping_ = false;
+    thread_ = std::thread(&PipelineStage::WorkerLoop, this);
+  }
+
+  // Stop the worker after the value in process, dropping the queued ones.
+  void Stop() {
+    if (!thread_.joinable()) {
+      return;
+    }
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      is_stopping_ = true;
+    }
+    work_available_.notify_one();
+    thread_.join();
+    Item item;
+    while (queue_.Pop(&item)) {
+    }
+  }
+
+  // Queue a value for the worker, dropping the oldest queued one if the
+  // queue is full. Never waits for the worker.
+  void Submit(const T& value) {
+    Item item;
+    item.value = value;
+    item.submit_us = tracing::NowMicroseconds();
+    submitted_count_.fetch_add(1, std::memory_order_relaxed);
+    while (!queue_.Push(item)) {
+      Item dropped;
+      if (queue_.Pop(&dropped)) {
+        dropped_count_.fetch_add(1, std::memory_order_relaxed);
+      }
+    }
+    // Only held for the flag, the worker never processes with it held.
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      has_work_ = true;
+    }
+    work_available_.notify_one();
+  }
+
+  // Number of values a stage constructed with capacity keeps queued, which
+  // may be more than asked for. Add the one in process to size a pool of
+  // the values, e.g. a PointCloudPool.
+  static size_t GetQueuedCount(size_t capacity) {
+    return BoundedQueue<Item>::GetCellCount(capacity);
+  }
+
+  PipelineStageStatistics GetStatistics() const {
+    PipelineStageStatistics statistics;
+    statistics.submitted_count =
+        submitted_count_.load(std::memory_order_relaxed);
+    statistics.processed_count =
+        processed_count_.load(std::memory_order_relaxed);
+    statistics.dropped_count = dropped_count_.load(std::memory_order_relaxed);
+    statistics.latency_ms =
+        latency_us_.load(std::memory_order_relaxed) / 1000.0f;
+    return statistics;
+  }
+
+ private:
+  struct Item {
+    T value;
+    uint64_t submit_us;
+  };
+
+  void WorkerLoop() {
+    TANGO_GL_TRACE_THREAD_NAME(name_);
+    if (cpu_ >= 0 && !PinCurrentThreadToCpu(cpu_)) {
+      LOGE("PipelineStage: Failed to pin %s to cpu %d", name_, cpu_);
+    }
+    while (true) {
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        work_available_.wait(lock,
+                             [this] { return has_work_ || is_stopping_; });
+        if (is_stopping_) {
+          return;
+        }
+        // Cleared before draining, a value submitted meanwhile sets it again.
+        has_work_ = false;
+      }
+      Item item;
+      while (queue_.Pop(&item)) {
+        const uint64_t start_us = tracing::NowMicroseconds();
+        process_(&item.value);
+        // Drop the value, e.g. release a pooled frame, before the next wait.
+        item.value = T();
+        const uint64_t end_us = tracing::NowMicroseconds();
+#ifdef TANGO_GL_TRACING
+        tracing::RecordSpan(name_, "pipeline", start_us, end_us - start_us);
+#else
+        (void)start_us;
+#endif
+        latency_us_.store(end_us - item.submit_us, std::memory_order_relaxed);
+        processed_count_.fetch_add(1, std::memory_order_relaxed);
+        if (is_stopping_) {
+          break;
+        }
+      }
+    }
+  }
+
+  const char* name_;
+  int cpu_;
+  Process process_;
+  BoundedQueue<Item> queue_;
+  std::thread thread_;
+
+  // Wakes the worker, guarded by mutex_.
+  std::mutex mutex_;
+  std::condition_variable work_available_;
+  bool has_work_;
+  // Also read by the worker between values, without the lock.
+  std::atomic<bool> is_stopping_;
+
+  std::atomic<uint64_t> submitted_count_;
+  std::atomic<uint64_t> processed_count_;
+  std::atomic<uint64_t> dropped_count_;
+  std::atomic<uint64_t> latency_us_;
+};
+}  // namespace tango_gl
+
+#endif  // TANGO_GL_PIPELINE_STAGE_H_
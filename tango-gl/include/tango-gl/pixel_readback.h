@@ -0,0 +1,141 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_GL_PIXEL_READBACK_H_
+#define TANGO_GL_PIXEL_READBACK_H_
+
+#include <stdint.h>
+
+#include <functional>
+#include <vector>
+
+#include "tango-gl/util.h"
+
+namespace tango_gl {
+
+// Reads RGBA8 pixels of a framebuffer back to the CPU without stalling the GL
+// thread, e.g. screenshots or images rendered for computer vision code.
+//
+// Read() only queues work on the GPU and returns immediately. Reads are
+// handed out in order some frames later by GetPixels(), which never waits
+// for the GPU:
+//
+// - On GLES3 contexts each read goes into the next pixel buffer object of a
+//   ring, followed by a fence. A read is handed out once its fence has
+//   signaled, so mapping the buffer does not block.
+// - On GLES2 contexts each read is a copy of the framebuffer into the next
+//   texture of a ring. The texture is read with glReadPixels once
+//   kPixelBufferCount - 1 newer copies were queued after it, by which time
+//   the GPU has normally finished it. That read still waits for the GPU to
+//   drain the commands queued so far, so GetPixels() is best called early in
+//   the frame.
+//
+// All functions must be called on the GL thread.
+class PixelReadback {
+ public:
+  // Receives the pixels of a read: width * height RGBA8 pixels, bottom row
+  // first as returned by glReadPixels. The pixels are only valid during the
+  // call.
+  typedef std::function<void(double timestamp, const uint8_t* pixels)>
+      PixelsCallback;
+
+  PixelReadback();
+  PixelReadback(const PixelReadback& other) = delete;
+  const PixelReadback& operator=(const PixelReadback&) = delete;
+  ~PixelReadback();
+
+  // Allocate the buffers for reads of a given size. This is a no-op if the
+  // size did not change, otherwise pending reads are dropped.
+  void Allocate(GLsizei width, GLsizei height);
+
+  // Release the GL objects and drop pending reads.
+  void Release();
+
+  // Forget the GL objects without deleting them. Use this when the GL
+  // context they belonged to has been destroyed.
+  void Invalidate();
+
+  // Queue a read of the whole bound framebuffer. If the ring is full the
+  // oldest read that was not picked up is dropped.
+  //
+  // @param timestamp: caller defined tag returned with the pixels.
+  void Read(double timestamp);
+
+  // Hand the completed reads to a callback, oldest first, without copying
+  // them.
+  //
+  // @return the number of reads handed out.
+  int GetPixels(const PixelsCallback& callback);
+
+  // Get the oldest completed read.
+  //
+  // @param timestamp: set to the tag passed to Read().
+  // @param pixels: resized to width * height * 4 and filled with the RGBA8
+  //        pixels, bottom row first as returned by glReadPixels.
+  //
+  // @return false if no read has completed since the last call.
+  bool GetPixels(double* timestamp, std::vector<uint8_t>* pixels);
+
+  GLsizei GetWidth() const { return width_; }
+  GLsizei GetHeight() const { return height_; }
+
+  // Return true if reads go through pixel buffer objects.
+  bool IsUsingPixelBuffers() const { return slots_[0].pixel_buffer != 0; }
+
+ private:
+  static const int kPixelBufferCount = 3;
+
+  // GLsync of GLES3, which the GLES2 headers lack.
+  typedef struct __GLsync* Sync;
+
+  // A read in flight, in a pixel buffer object with its fence on GLES3 or
+  // in a texture and its framebuffer on GLES2.
+  struct Slot {
+    GLuint pixel_buffer;
+    Sync fence;
+    GLuint texture;
+    // Format of the texture, GL_RGB when copied from a framebuffer without
+    // alpha.
+    GLenum texture_format;
+    GLuint framebuffer;
+    double timestamp;
+  };
+
+  // Whether the oldest pending read can be handed out without waiting.
+  bool IsOldestReadComplete();
+
+  // Hand out the oldest pending read.
+  void DeliverOldestRead(const PixelsCallback& callback);
+
+  // Drop the oldest pending read.
+  void DropOldestRead();
+
+  GLsizei width_;
+  GLsizei height_;
+  size_t size_in_bytes_;
+
+  Slot slots_[kPixelBufferCount];
+  // Index of the next slot to read into, and number of queued reads ending
+  // just before it.
+  int next_index_;
+  int pending_count_;
+
+  // Pixels of the last GLES2 read.
+  std::vector<uint8_t> staging_buffer_;
+};
+}  // namespace tango_gl
+#endif  // TANGO_GL_PIXEL_READBACK_H_
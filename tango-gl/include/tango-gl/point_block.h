@@ -0,0 +1,151 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_GL_POINT_BLOCK_H_
+#define TANGO_GL_POINT_BLOCK_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <memory>
+
+#include <tango_client_api.h>  // NOLINT
+
+#include "tango-gl/util.h"
+
+namespace tango_gl {
+
+// PointBlock holds a point cloud as a structure of arrays: x, y and z each in
+// their own array, and optionally a confidence and a packed RGBA8 color per
+// point, instead of the interleaved x, y, z of TangoXYZij.
+//
+// Every array starts on a 16 byte boundary and is padded to a multiple of
+// kLaneCount points, so 4-wide kernels load a lane per point with plain
+// vector loads and run over GetPaddedPointCount() points without a scalar
+// tail. The padding points have zero coordinates, zero confidence and a
+// transparent color; a zero depth is what the depth camera reports for no
+// measurement, so depth consumers skip them as they skip holes.
+//
+// CopyFromXyz() and CopyToXyz() convert from and to the interleaved layout in
+// a single pass, four points at a time with NEON where available.
+class PointBlock {
+ public:
+  // Points per vector lane set.
+  static const size_t kLaneCount = 4;
+
+  // Optional arrays, combined with |.
+  enum Channel {
+    kConfidence = 1 << 0,
+    kColor = 1 << 1
+  };
+
+  // @param channels: optional arrays to hold besides x, y and z.
+  explicit PointBlock(int channels = 0);
+  PointBlock(const PointBlock& other) = delete;
+  const PointBlock& operator=(const PointBlock&) = delete;
+
+  int GetChannels() const { return channels_; }
+  bool HasConfidence() const { return (channels_ & kConfidence) != 0; }
+  bool HasColor() const { return (channels_ & kColor) != 0; }
+
+  // Make room for a number of points, keeping the points held.
+  void Reserve(size_t point_count);
+
+  // Set the number of points. Points added are zero, see the padding above.
+  void Resize(size_t point_count);
+
+  void Clear() { Resize(0); }
+
+  size_t GetPointCount() const { return point_count_; }
+
+  // Point count rounded up to kLaneCount, the points a 4-wide kernel runs
+  // over.
+  size_t GetPaddedPointCount() const {
+    return (point_count_ + kLaneCount - 1) & ~(kLaneCount - 1);
+  }
+
+  // Timestamp of the depth frame the points come from.
+  double GetTimestamp() const { return timestamp_; }
+  void SetTimestamp(double timestamp) { timestamp_ = timestamp; }
+
+  // The arrays, 16 byte aligned with GetPaddedPointCount() elements. The
+  // optional ones are nullptr when the block does not hold them. Valid until
+  // the next Reserve() or Resize() that grows the block.
+  float* GetX() { return x_; }
+  float* GetY() { return y_; }
+  float* GetZ() { return z_; }
+  const float* GetX() const { return x_; }
+  const float* GetY() const { return y_; }
+  const float* GetZ() const { return z_; }
+  float* GetConfidence() { return confidence_; }
+  const float* GetConfidence() const { return confidence_; }
+  uint32_t* GetColor() { return color_; }
+  const uint32_t* GetColor() const { return color_; }
+
+  // Replace the points with interleaved ones. Confidence and color are reset
+  // to zero.
+  //
+  // @param xyz: packed x, y, z coordinates, point_count * 3 floats.
+  // @param point_count: number of points.
+  void CopyFromXyz(const float* xyz, size_t point_count);
+
+  // Replace the points with those of a depth frame, and take its timestamp.
+  void CopyFromXyzij(const TangoXYZij& xyz_ij);
+
+  // Write the points interleaved, as TangoXYZij and most consumers of
+  // depth take them.
+  //
+  // @param xyz: output, GetPointCount() * 3 floats.
+  void CopyToXyz(float* xyz) const;
+
+  // Transform the points in place, e.g. from the depth camera frame to the
+  // world frame.
+  void Transform(const glm::mat4& matrix);
+
+ private:
+  // Zero the points between point_count_ and the padded count.
+  void ClearPadding();
+
+  int channels_;
+  size_t point_count_;
+  // Points each array has room for, a multiple of kLaneCount.
+  size_t capacity_;
+  double timestamp_;
+
+  // One allocation for every array, from which they are aligned.
+  std::unique_ptr<uint8_t[]> storage_;
+  float* x_;
+  float* y_;
+  float* z_;
+  float* confidence_;
+  uint32_t* color_;
+};
+
+namespace internal {
+// NEON kernels, defined in point_block_neon.cpp. They handle the first
+// point_count & ~3 points; the caller handles the remaining points.
+void DeinterleaveXyzNeon(const float* xyz, size_t point_count, float* x,
+                         float* y, float* z);
+void InterleaveXyzNeon(const float* x, const float* y, const float* z,
+                       size_t point_count, float* xyz);
+// Runs over point_count points, a multiple of 4, of 16 byte aligned arrays.
+void TransformPointsNeon(const glm::mat4& matrix, size_t point_count,
+                         float* x, float* y, float* z);
+}  // namespace internal
+
+}  // namespace tango_gl
+#endif  // TANGO_GL_POINT_BLOCK_H_
@@ -0,0 +1,103 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TANGO_GL_POINT_CLOUD_BUFFER_H_
+#define TANGO_GL_POINT_CLOUD_BUFFER_H_
+
+#include <stddef.h>
+
+#include "tango-gl/render_state.h"
+#include "tango-gl/util.h"
+
+namespace tango_gl {
+
+struct ColoredPoint;
+struct QuantizedColoredPoint;
+
+// GPU buffer holding the latest depth frame as packed xyz floats, or as
+// interleaved ColoredPoint or QuantizedColoredPoint vertices.
+//
+// A frame is only uploaded when its timestamp differs from the one already in
+// the buffer, so rendering the same frame repeatedly costs no transfer. Each
+// upload orphans the previous storage (glBufferData with a null pointer and a
+// streaming usage hint) before writing the new points, which lets the driver
+// hand out fresh memory instead of waiting for draws still reading the old
+// frame.
+//
+// The buffer is created on the first update. All functions must be called on
+// the GL thread.
+class PointCloudBuffer {
+ public:
+  PointCloudBuffer();
+  PointCloudBuffer(const PointCloudBuffer& other) = delete;
+  const PointCloudBuffer& operator=(const PointCloudBuffer&) = delete;
+  ~PointCloudBuffer();
+
+  // Upload a depth frame unless it is the frame already in the buffer.
+  //
+  // @param timestamp: timestamp of the depth frame.
+  // @param points: packed x, y, z coordinates, point_count * 3 floats.
+  // @param point_count: number of points in the frame.
+  // @return true if the frame was uploaded.
+  bool Update(double timestamp, const float* points, size_t point_count);
+
+  // Upload a colored depth frame unless it is the frame already in the
+  // buffer. The vertices keep the ColoredPoint layout, 16 bytes each.
+  //
+  // @param timestamp: timestamp of the depth frame.
+  // @param points: point_count colored points.
+  // @param point_count: number of points in the frame.
+  // @return true if the frame was uploaded.
+  bool Update(double timestamp, const ColoredPoint* points,
+              size_t point_count);
+
+  // Upload a quantized colored depth frame unless it is the frame already in
+  // the buffer. The vertices keep the QuantizedColoredPoint layout, 12 bytes
+  // each.
+  bool Update(double timestamp, const QuantizedColoredPoint* points,
+              size_t point_count);
+
+  // Bind the buffer to GL_ARRAY_BUFFER. The caller unbinds it after drawing.
+  void Bind() const { RenderState::BindBuffer(GL_ARRAY_BUFFER, buffer_id_); }
+
+  // Number of points of the frame in the buffer.
+  size_t GetPointCount() const { return point_count_; }
+
+  // Timestamp of the frame in the buffer.
+  double GetTimestamp() const { return timestamp_; }
+
+  // Release the buffer object.
+  void Release();
+
+  // Forget the buffer object without deleting it. Use this when the GL
+  // context it belonged to has been destroyed.
+  void Invalidate();
+
+ private:
+  // Upload size bytes of vertex data for point_count points.
+  bool Upload(double timestamp, const void* data, size_t size,
+              size_t point_count);
+
+  GLuint buffer_id_;
+  // Size of the storage requested on each upload. It only grows, so the
+  // driver can recycle orphaned storage of the same size.
+  size_t capacity_;
+  size_t point_count_;
+  double timestamp_;
+  bool has_frame_;
+};
+}  // namespace tango_gl
+#endif  // TANGO_GL_POINT_CLOUD_BUFFER_H_
@@ -0,0 +1,144 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_GL_POINT_CLOUD_CODEC_H_
+#define TANGO_GL_POINT_CLOUD_CODEC_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+namespace tango_gl {
+namespace point_cloud_codec {
+
+// Compact encoding of depth frames, for storage (see SessionRecorder) and for
+// streaming them off the device.
+//
+// The points are quantized onto a grid of step meters, sorted along the Morton
+// (Z-order) curve of their grid cells and stored as the differences between
+// consecutive Morton codes. Neighbors on the curve are neighbors in space, so
+// the differences are small; their bit lengths are range coded with an
+// adaptive model conditioned on the previous length, the bits below the
+// leading one are stored as is. A full resolution frame of a wall takes about
+// 15 bits per point at the default step, against 96 as floats.
+//
+// The codec always quantizes. At kDefaultStep the error is half a millimeter,
+// well below the noise of the depth sensor. Larger steps are the lossy mode,
+// each doubling saves about three bits per point. Decoded points come out in
+// Morton order rather than in the order of the frame.
+//
+// An encoded frame is a Header followed by header.payload_size bytes, so
+// frames can be concatenated into a stream. All values are little endian.
+
+const uint32_t kMagic = 0x43504754;  // "TGPC"
+
+// One millimeter.
+const float kDefaultStep = 0.001f;
+
+// Grid cells per axis are 21 bit, points farther than 2^20 steps from the
+// origin of the frame (1048 meters at kDefaultStep) are clamped.
+const int kCoordinateBits = 21;
+
+struct Header {
+  uint32_t magic;
+  uint32_t point_count;
+  // Size of a grid cell in meters.
+  float step;
+  // Bytes of range coded data following the header.
+  uint32_t payload_size;
+};
+
+static_assert(sizeof(Header) == 16, "point_cloud_codec::Header changed.");
+
+// Size of the buffer Encoder::Encode() needs for point_count points.
+size_t GetMaxEncodedSize(size_t point_count);
+
+// Read the header of an encoded frame.
+//
+// @return: false if data is not an encoded frame or is shorter than the
+//          frame.
+bool ReadHeader(const uint8_t* data, size_t size, Header* header);
+
+// Decode a frame written by Encoder::Encode().
+//
+// @param data: encoded frame, starting with its Header.
+// @param size: size of data in bytes, may extend past the frame.
+// @param points: output, header.point_count packed x, y, z floats in Morton
+//        order.
+// @param capacity: size of points in points.
+// @return: false if the frame is malformed or has more than capacity points.
+bool Decode(const uint8_t* data, size_t size, float* points, size_t capacity);
+
+// Encodes frames, keeping its scratch buffers between them. An encoder is
+// meant to be used from a single thread, e.g. a depth pipeline stage.
+//
+// Quantization and the Morton interleave run four points at a time with NEON
+// where available, the sort is a radix sort skipping the bytes all codes of
+// the frame share.
+class Encoder {
+ public:
+  Encoder() {}
+  Encoder(const Encoder& other) = delete;
+  const Encoder& operator=(const Encoder&) = delete;
+
+  // @param points: packed x, y, z coordinates in meters, point_count * 3
+  //        floats.
+  // @param point_count: number of points.
+  // @param step: size of a grid cell in meters, see kDefaultStep.
+  // @param dst: output, at least GetMaxEncodedSize(point_count) bytes.
+  // @param capacity: size of dst in bytes.
+  // @return: number of bytes written to dst, 0 if capacity is too small.
+  size_t Encode(const float* points, size_t point_count, float step,
+                uint8_t* dst, size_t capacity);
+
+ private:
+  std::vector<uint64_t> codes_;
+  std::vector<uint64_t> sort_buffer_;
+  // Model of the code difference lengths, reset for each frame.
+  std::vector<uint16_t> length_probabilities_;
+};
+
+namespace internal {
+// Grid cell of a coordinate: value / step rounded half away from zero,
+// clamped to +-2^20 and offset by 2^20 so it fits kCoordinateBits unsigned
+// bits. NaN goes to the origin. The NEON kernel does the same arithmetic and
+// gets the same cells.
+inline uint32_t Quantize(float value, float inverse_step) {
+  const int32_t kOffset = 1 << (kCoordinateBits - 1);
+  const float kLimit = static_cast<float>(kOffset);
+  float cell = value * inverse_step;
+  if (cell != cell) {
+    cell = 0.0f;
+  } else if (cell < -kLimit) {
+    cell = -kLimit;
+  } else if (cell > kLimit - 1.0f) {
+    cell = kLimit - 1.0f;
+  }
+  cell += cell < 0.0f ? -0.5f : 0.5f;
+  return static_cast<uint32_t>(static_cast<int32_t>(cell) + kOffset);
+}
+
+// NEON kernel, defined in point_cloud_codec_neon.cpp. Computes the Morton
+// codes of the first point_count & ~3 points, the caller does the rest.
+void ComputeMortonCodesNeon(const float* points, size_t point_count,
+                            float inverse_step, uint64_t* codes);
+}  // namespace internal
+
+}  // namespace point_cloud_codec
+}  // namespace tango_gl
+#endif  // TANGO_GL_POINT_CLOUD_CODEC_H_
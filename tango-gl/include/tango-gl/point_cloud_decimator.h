@@ -0,0 +1,139 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_GL_POINT_CLOUD_DECIMATOR_H_
+#define TANGO_GL_POINT_CLOUD_DECIMATOR_H_
+
+#include <stdint.h>
+
+#include <memory>
+#include <vector>
+
+#include "tango-gl/worker_pool.h"
+
+namespace tango_gl {
+
+// PointCloudDecimator reduces a depth frame to a target point count before it
+// is uploaded, rendered or fitted, so those costs follow what the consumer
+// needs instead of the sensor density.
+//
+// In voxel grid mode every occupied voxel is replaced by the centroid of its
+// points. The voxel size adapts from frame to frame so the voxel count tracks
+// the target, and any excess is removed by an even stride over the voxels.
+// Hashing points into voxels runs on a worker pool: keys are computed over
+// point chunks, then each worker fills its own partition of the hash table.
+//
+// Tables are kept between frames, only a frame larger than any before
+// allocates. A decimator is meant to be used from a single thread, e.g. the
+// XYZij callback.
+class PointCloudDecimator {
+ public:
+  enum Mode {
+    // Keep every n-th point, the cheapest option.
+    kStride,
+    // Average the points of each occupied voxel, evens out the density.
+    kVoxelGrid
+  };
+
+  PointCloudDecimator();
+  PointCloudDecimator(const PointCloudDecimator& other) = delete;
+  const PointCloudDecimator& operator=(const PointCloudDecimator&) = delete;
+  ~PointCloudDecimator();
+
+  void SetMode(Mode mode) { mode_ = mode; }
+  Mode GetMode() const { return mode_; }
+
+  // @param target_point_count: maximum number of output points, 0 keeps
+  //        every point.
+  void SetTargetPointCount(size_t target_point_count) {
+    target_point_count_ = target_point_count;
+  }
+  size_t GetTargetPointCount() const { return target_point_count_; }
+
+  // Current edge length of a voxel in meters, adapted by every voxel grid
+  // frame.
+  float GetVoxelSize() const { return voxel_size_; }
+
+  // Allocate the tables for frames of up to point_count points.
+  void Reserve(size_t point_count);
+
+  // Decimate a point cloud.
+  //
+  // @param xyz: packed x, y, z coordinates of the input points.
+  // @param point_count: number of input points.
+  // @param output: packed x, y, z coordinates of the output points, room for
+  //        min(point_count, target point count) points. May not alias xyz.
+  // @return the number of output points.
+  size_t Decimate(const float* xyz, size_t point_count, float* output);
+
+ private:
+  // A voxel of the hash table. stamp_ tells voxels of the current frame from
+  // stale ones, so the table never has to be cleared.
+  struct Voxel {
+    uint64_t key;
+    float sum[3];
+    uint32_t count;
+    uint32_t stamp;
+  };
+
+  size_t DecimateStride(const float* xyz, size_t point_count,
+                        size_t target_point_count, float* output);
+
+  size_t DecimateVoxelGrid(const float* xyz, size_t point_count,
+                           size_t target_point_count, float* output);
+
+  // The parallel passes of DecimateVoxelGrid(), they read the frame_ members.
+  //
+  // Compute the voxel keys and hashes of a chunk of points.
+  void HashChunk(int chunk);
+  // Accumulate the points hashed into a partition.
+  void FillPartition(int partition);
+  // Write the centroids of a partition's voxels whose global index falls on
+  // the stride from frame_voxel_count_ down to frame_target_point_count_.
+  void WritePartition(int partition);
+
+  Mode mode_;
+  size_t target_point_count_;
+  float voxel_size_;
+
+  // The frame being decimated. The passes only capture this, so handing them
+  // to the worker pool does not allocate.
+  const float* frame_xyz_;
+  size_t frame_point_count_;
+  size_t frame_target_point_count_;
+  size_t frame_voxel_count_;
+  float* frame_output_;
+
+  // The shared pool.
+  WorkerPool* worker_pool_;
+  int partition_count_;
+
+  // Per point voxel key and hash of the current frame.
+  std::vector<uint64_t> keys_;
+  std::vector<uint32_t> hashes_;
+
+  // partition_count_ open addressing tables of partition_size_ voxels each,
+  // with the voxel indices of every partition in insertion order.
+  std::vector<Voxel> voxels_;
+  std::vector<uint32_t> voxel_order_;
+  std::vector<size_t> partition_voxel_counts_;
+  std::vector<size_t> partition_offsets_;
+  size_t partition_size_;
+  uint32_t stamp_;
+};
+}  // namespace tango_gl
+#endif  // TANGO_GL_POINT_CLOUD_DECIMATOR_H_
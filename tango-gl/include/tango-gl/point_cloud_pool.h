@@ -0,0 +1,158 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_GL_POINT_CLOUD_POOL_H_
+#define TANGO_GL_POINT_CLOUD_POOL_H_
+
+#include <stdint.h>
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include <tango_client_api.h>
+
+#include "tango-gl/util.h"
+
+namespace tango_gl {
+
+// A point cloud owned by a PointCloudPool.
+struct PooledPointCloud {
+  // Points, timestamp and count of the frame. xyz refers to pool storage
+  // with room for the pool capacity, ij and color_image are unused.
+  TangoXYZij cloud;
+  // Pose recorded with the frame, e.g. the device pose at its timestamp.
+  glm::mat4 pose;
+  // Publish order of the frame, starting at 1, set by Publish().
+  uint64_t sequence;
+};
+
+// PointCloudPool shares depth frames between threads without copying them.
+// Storage for a fixed number of clouds is allocated up front from a memory
+// budget, and frames are passed around as reference counted handles:
+//
+// - The producer (e.g. the XYZij callback) allocates a cloud, fills it while
+//   it holds the only handle, and publishes it as the latest frame.
+// - Consumers (e.g. the renderer or a plane detector) acquire the latest
+//   frame, or receive a copy of the producer handle, and read it for as long
+//   as they hold on to it.
+// - A cloud goes back to the pool when its last handle is released.
+//
+// All of this is lock-free. A published cloud must not be written anymore,
+// and the pool must outlive every handle.
+//
+// Consumers that cannot hold a Handle, e.g. Java code through JNI, detach
+// the reference to a slot index and attach it again to release it. The
+// storage of a slot never moves, so it can be mapped once, e.g. as a direct
+// ByteBuffer, and read in place while referenced.
+class PointCloudPool {
+ public:
+  // Reference to a pooled cloud, empty when default constructed.
+  class Handle {
+   public:
+    Handle() : pool_(nullptr), slot_(-1) {}
+    Handle(const Handle& other);
+    Handle(Handle&& other);
+    Handle& operator=(Handle other);
+    ~Handle() { Reset(); }
+
+    // Drop the reference, the handle becomes empty.
+    void Reset();
+
+    // Give up the handle without dropping its reference, which must be
+    // returned with PointCloudPool::Attach() later.
+    //
+    // @return: slot of the cloud, -1 if the handle was empty.
+    int Detach();
+
+    // @return: slot of the cloud, -1 if the handle is empty.
+    int GetSlot() const { return slot_; }
+
+    explicit operator bool() const { return slot_ >= 0; }
+    PooledPointCloud* operator->() const { return &pool_->slots_[slot_].cloud; }
+    PooledPointCloud& operator*() const { return pool_->slots_[slot_].cloud; }
+
+   private:
+    friend class PointCloudPool;
+    // Takes over a reference already counted on the slot.
+    Handle(PointCloudPool* pool, int slot) : pool_(pool), slot_(slot) {}
+
+    PointCloudPool* pool_;
+    int slot_;
+  };
+
+  // @param max_point_count: capacity of each cloud in points.
+  // @param memory_budget: bytes of point storage, the pool holds as many
+  //        clouds as fit, and at least one.
+  PointCloudPool(size_t max_point_count, size_t memory_budget);
+  PointCloudPool(const PointCloudPool& other) = delete;
+  const PointCloudPool& operator=(const PointCloudPool&) = delete;
+  ~PointCloudPool();
+
+  size_t GetCapacity() const { return max_point_count_; }
+  int GetCloudCount() const { return slot_count_; }
+
+  // Claim an unused cloud for writing, with no points and a zero timestamp.
+  //
+  // @return: an empty handle if every cloud is in use.
+  Handle Allocate();
+
+  // Make a cloud the latest frame, replacing the previous one.
+  void Publish(const Handle& handle);
+
+  // Share the latest published frame.
+  //
+  // @return: an empty handle if nothing was published yet.
+  Handle AcquireLatest();
+
+  // Take over a reference given up by Handle::Detach().
+  //
+  // @return: an empty handle if slot is out of range.
+  Handle Attach(int slot);
+
+  // Cloud of a slot, for mapping its storage. Only read the points while
+  // holding a reference on the slot.
+  const PooledPointCloud& GetCloud(int slot) const {
+    return slots_[slot].cloud;
+  }
+
+ private:
+  struct Slot {
+    PooledPointCloud cloud;
+    std::atomic<int> references;
+  };
+
+  void AddReference(int slot);
+  // Add a reference only if the slot is still referenced.
+  bool TryAddReference(int slot);
+  void Release(int slot);
+
+  size_t max_point_count_;
+  int slot_count_;
+  std::vector<float> storage_;
+  std::unique_ptr<Slot[]> slots_;
+
+  // Slot of the latest published frame, or -1. The pool holds a reference on
+  // it.
+  std::atomic<int> latest_;
+
+  // Number of Publish() calls.
+  std::atomic<uint64_t> publish_count_;
+};
+}  // namespace tango_gl
+
+#endif  // TANGO_GL_POINT_CLOUD_POOL_H_
@@ -0,0 +1,116 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TANGO_GL_POINT_COLORIZER_H_
+#define TANGO_GL_POINT_COLORIZER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include "tango-gl/point_projection.h"
+
+namespace tango_gl {
+
+// Interleaved vertex of a colored point cloud, 16 bytes. The color is meant
+// to be read by a normalized GL_UNSIGNED_BYTE vertex attribute.
+struct ColoredPoint {
+  float x;
+  float y;
+  float z;
+  uint8_t r;
+  uint8_t g;
+  uint8_t b;
+  uint8_t a;
+};
+
+// Meters per unit of QuantizedColoredPoint coordinates, one millimeter. That
+// is below the noise of the depth sensor and spans +-32.767 meters.
+const float kQuantizedPointScale = 0.001f;
+
+// Interleaved vertex of a colored point cloud with 16 bit integer
+// coordinates, 12 bytes instead of the 16 of ColoredPoint. The coordinates
+// are meant to be read by a non normalized GL_SHORT vertex attribute of 3
+// components and scaled by kQuantizedPointScale in the vertex shader, the
+// padding keeps the color 4 byte aligned.
+struct QuantizedColoredPoint {
+  int16_t x;
+  int16_t y;
+  int16_t z;
+  int16_t padding;
+  uint8_t r;
+  uint8_t g;
+  uint8_t b;
+  uint8_t a;
+};
+
+// PointColorizer looks up the color of each depth point in a NV21 color
+// camera frame.
+//
+// The points are projected into the color image in one batch with
+// projection::ProjectPoints(), which uses the NEON kernel where available,
+// then the pixel each point lands on is converted to RGB. Only the sampled
+// pixels are converted, never the whole frame.
+//
+// The projection scratch buffer is kept between frames. A colorizer is meant
+// to be used from a single thread, e.g. the XYZij callback.
+class PointColorizer {
+ public:
+  PointColorizer() {}
+  PointColorizer(const PointColorizer& other) = delete;
+  const PointColorizer& operator=(const PointColorizer&) = delete;
+
+  // Color a point cloud.
+  //
+  // @param points: packed x, y, z coordinates, point_count * 3 floats.
+  // @param point_count: number of points.
+  // @param color_T_points: transformation of the points frame with respect
+  //        to the color camera frame, at the color frame's timestamp.
+  // @param intrinsics: color camera intrinsics, their size is the size of
+  //        the NV21 frame.
+  // @param nv21: NV21 color frame, width * height * 3 / 2 bytes. Can be
+  //        nullptr if there is no color frame yet.
+  // @param output: point_count colored points, in the order of the input.
+  //        Points without a color, outside of the image or behind the
+  //        camera, are gray with an alpha of 0 so a shader can tell them
+  //        apart.
+  // @return number of points that got a color from the frame.
+  size_t Colorize(const float* points, size_t point_count,
+                  const glm::mat4& color_T_points,
+                  const projection::CameraIntrinsics& intrinsics,
+                  const uint8_t* nv21, ColoredPoint* output);
+
+  // Color a point cloud into quantized vertices, see QuantizedColoredPoint.
+  // Coordinates are rounded to the nearest millimeter and clamped to the
+  // int16_t range, the projection still uses the float points.
+  size_t Colorize(const float* points, size_t point_count,
+                  const glm::mat4& color_T_points,
+                  const projection::CameraIntrinsics& intrinsics,
+                  const uint8_t* nv21, QuantizedColoredPoint* output);
+
+ private:
+  template <typename Point>
+  size_t ColorizePoints(const float* points, size_t point_count,
+                        const glm::mat4& color_T_points,
+                        const projection::CameraIntrinsics& intrinsics,
+                        const uint8_t* nv21, Point* output);
+
+
+  std::vector<int32_t> pixels_;
+};
+}  // namespace tango_gl
+#endif  // TANGO_GL_POINT_COLORIZER_H_
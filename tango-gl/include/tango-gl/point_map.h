@@ -0,0 +1,264 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_GL_POINT_MAP_H_
+#define TANGO_GL_POINT_MAP_H_
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "tango-gl/block_store.h"
+#include "tango-gl/util.h"
+#include "tango-gl/view_frustum.h"
+
+namespace tango_gl {
+
+// PointMap accumulates depth frames in a fixed frame, e.g. start of service,
+// into a sparse voxel grid, and answers radius and nearest neighbor queries
+// over it without going back to the raw frames.
+//
+// Every voxel keeps the running mean of the points that fell into it. Voxels
+// are grouped in blocks of kBlockSize^3, which are allocated from a pool of
+// fixed size and found through an open addressing hash table, so memory is
+// bounded and nothing is allocated after construction. Once the pool is
+// exhausted the block updated least recently, which is usually the one the
+// device moved away from, is evicted for the new one.
+//
+// With a BlockStore, evicted blocks are paged out to disk instead of being
+// dropped, and come back when a point falls into them again. PageOut(),
+// PageIn() and Prefetch() keep the pool around the device, so the map can
+// grow past the pool while the queries see the blocks near the device.
+//
+// For rendering, each block also keeps decimated levels of detail, the
+// means of 2^3, 4^3 and 8^3 voxels, rebuilt at the end of the Insert() that
+// changed the block. GetLodPoints() picks a level per block from its
+// projected size, so far geometry is drawn with fewer, larger points.
+//
+// A PointMap is not thread safe, callers serialize inserts and queries.
+class PointMap {
+ public:
+  // Edge of a block in voxels.
+  static const int kBlockSize = 8;
+
+  // @param voxel_size: edge of a voxel in meters.
+  // @param max_block_count: number of blocks in the pool. Each block takes
+  //        about (kBlockSize^3 + 73) * 16 bytes.
+  PointMap(float voxel_size, size_t max_block_count);
+  PointMap(const PointMap& other) = delete;
+  const PointMap& operator=(const PointMap&) = delete;
+  ~PointMap();
+
+  // Drop every point, including the paged out blocks.
+  void Clear();
+
+  // Page blocks out to a store instead of dropping them.
+  //
+  // @param store: store owned by the caller, used by this map only, nullptr
+  //        to drop evicted blocks again. The blocks it holds stay there.
+  void SetBlockStore(BlockStore* store) { block_store_ = store; }
+
+  // Page out the blocks farther than a distance from a position.
+  //
+  // @param center: position in the map frame, e.g. the device.
+  // @param radius: distance in meters from center to the nearest point of a
+  //        block.
+  // @return the number of blocks paged out.
+  size_t PageOut(const glm::vec3& center, float radius);
+
+  // Bring the paged out blocks within a distance of a position back, while
+  // the pool has free blocks.
+  //
+  // @return the number of blocks paged in.
+  size_t PageIn(const glm::vec3& center, float radius);
+
+  // Decompress the paged out blocks within a distance of a position ahead of
+  // the PageIn() or Insert() that needs them, on the store thread.
+  void Prefetch(const glm::vec3& center, float radius);
+
+  // Add a depth frame.
+  //
+  // @param xyz: packed x, y, z coordinates in the frame of the points.
+  // @param point_count: number of points.
+  // @param map_T_points: pose of the frame of the points with respect to the
+  //        map frame, e.g. start_service_T_depth at the frame timestamp.
+  void Insert(const float* xyz, size_t point_count,
+              const glm::mat4& map_T_points);
+
+  // Find the voxel points within a distance of a position.
+  //
+  // @param center: query position in the map frame.
+  // @param radius: search radius in meters.
+  // @param points: output points, in no particular order. Cleared first.
+  // @return the number of points found.
+  size_t RadiusSearch(const glm::vec3& center, float radius,
+                      std::vector<glm::vec3>* points) const;
+
+  // Find the voxel points nearest to a position.
+  //
+  // @param query: query position in the map frame.
+  // @param k: number of points wanted.
+  // @param max_distance: farthest distance in meters considered.
+  // @param points: output points, nearest first. Cleared first, fewer than k
+  //        if the map has fewer points within max_distance.
+  // @return the number of points found.
+  size_t NearestNeighbors(const glm::vec3& query, size_t k,
+                          float max_distance,
+                          std::vector<glm::vec3>* points) const;
+
+  // Collect the voxel points of the blocks which may be visible, e.g. for
+  // drawing the map. Each block is tested once, the culled blocks are
+  // counted by the frustum.
+  //
+  // @param frustum: view frustum in the map frame.
+  // @param xyz: output packed x, y, z coordinates. Cleared first.
+  // @return the number of points collected.
+  size_t GetVisiblePoints(ViewFrustum* frustum, std::vector<float>* xyz) const;
+
+  // Level of detail selection of GetLodPoints().
+  struct LodOptions {
+    LodOptions()
+        : pixels_per_meter(1000.0f),
+          point_spacing(4.0f),
+          max_point_count(100000) {}
+
+    // Size in pixels of one meter at a distance of one meter, i.e.
+    // projection_mat[1][1] * viewport_height / 2.
+    float pixels_per_meter;
+    // Smallest distance in pixels between points on screen. Blocks use the
+    // finest level whose points are at least this far apart.
+    float point_spacing;
+    // Vertex budget. If the levels picked need more points, every block is
+    // coarsened by one level until they fit, and the output is truncated if
+    // even the coarsest levels do not.
+    size_t max_point_count;
+  };
+
+  // Collect the points of the blocks which may be visible, each at its level
+  // of detail.
+  //
+  // @param frustum: view frustum in the map frame.
+  // @param options: level of detail selection.
+  // @param points: output packed x, y, z, size, where size is the edge in
+  //        meters of the voxel the point stands for, to scale the point
+  //        sprites with. Cleared first.
+  // @return the number of points collected.
+  size_t GetLodPoints(ViewFrustum* frustum, const LodOptions& options,
+                      std::vector<float>* points) const;
+
+  float GetVoxelSize() const { return voxel_size_; }
+  size_t GetBlockCount() const { return block_count_; }
+  size_t GetMaxBlockCount() const { return blocks_.size(); }
+  // Number of occupied voxels.
+  size_t GetPointCount() const { return point_count_; }
+
+ private:
+  static const int kVoxelsPerBlock = kBlockSize * kBlockSize * kBlockSize;
+  static const int kMaskWords = kVoxelsPerBlock / 64;
+  // Level 0 are the voxels, levels 1 to 3 are kept in lod_voxels.
+  static const int kLodLevelCount = 4;
+  static const int kLodVoxelCount = 4 * 4 * 4 + 2 * 2 * 2 + 1;
+
+  struct Voxel {
+    float mean[3];
+    uint32_t count;
+  };
+
+  struct Block {
+    uint64_t key;
+    // Neighbors in the recency list, -1 at the ends.
+    int32_t newer;
+    int32_t older;
+    // Occupied voxels.
+    uint64_t mask[kMaskWords];
+    Voxel voxels[kVoxelsPerBlock];
+    // Decimated levels, a count of 0 marks an empty entry.
+    Voxel lod_voxels[kLodVoxelCount];
+    // Occupied entries per level.
+    uint32_t lod_counts[kLodLevelCount];
+    // Whether the block is in dirty_blocks_.
+    bool is_lod_dirty;
+  };
+
+  // Key of the block at integer block coordinates.
+  static uint64_t BlockKey(int32_t x, int32_t y, int32_t z);
+
+  // Index of the block with a key, -1 if it is not in the map.
+  int32_t FindBlock(uint64_t key) const;
+
+  // Index of the block with a key, allocated, paged in or evicted for if
+  // needed.
+  int32_t AcquireBlock(uint64_t key);
+
+  // Write a block to block_store_.
+  void StoreBlock(int32_t block);
+
+  // Read a block from block_store_ into a pool entry, keeping its
+  // is_lod_dirty. Does not link or insert the block.
+  bool RestoreBlock(uint64_t key, int32_t block);
+
+  // Remove a block from the map, the last block takes its index.
+  void RemoveBlock(int32_t block);
+
+  // Collect the keys of the blocks within a distance of a position which
+  // are not in the pool, nearest first.
+  void CollectAbsentKeys(const glm::vec3& center, float radius,
+                         std::vector<uint64_t>* keys) const;
+
+  // Hash table maintenance, the block must hold the key.
+  void InsertSlot(int32_t block);
+  void EraseSlot(int32_t block);
+
+  // Recompute the decimated levels of a block from its voxels.
+  static void RebuildLods(Block* block);
+
+  // Recency list maintenance.
+  void Unlink(int32_t block);
+  void LinkNewest(int32_t block);
+
+  // Call visit(point, size) for every point of a block at a level.
+  template <typename Visitor>
+  void VisitLod(const Block& block, int level, Visitor visit) const;
+
+  // Call visit(point) for every voxel point of a block.
+  template <typename Visitor>
+  void VisitBlock(const Block& block, Visitor visit) const;
+
+  float voxel_size_;
+  float inverse_voxel_size_;
+
+  std::vector<Block> blocks_;
+  size_t block_count_;
+  size_t point_count_;
+  // Most and least recently updated blocks, -1 when empty.
+  int32_t newest_;
+  int32_t oldest_;
+
+  // Open addressing table of block indices, -1 for an empty slot. Twice the
+  // pool size, a power of two.
+  std::vector<int32_t> table_;
+  size_t table_mask_;
+
+  // Blocks changed by the current Insert(), reserved for the whole pool.
+  std::vector<int32_t> dirty_blocks_;
+
+  // Not owned, nullptr without paging.
+  BlockStore* block_store_;
+};
+}  // namespace tango_gl
+
+#endif  // TANGO_GL_POINT_MAP_H_
@@ -0,0 +1,77 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_GL_POINT_MAP_DRAWABLE_H_
+#define TANGO_GL_POINT_MAP_DRAWABLE_H_
+
+#include <vector>
+
+#include "tango-gl/color.h"
+#include "tango-gl/util.h"
+#include "tango-gl/vertex_array.h"
+#include "tango-gl/vertex_buffer.h"
+
+namespace tango_gl {
+
+// PointMapDrawable draws the output of PointMap::GetLodPoints() as point
+// sprites sized by the voxel each point stands for, so coarse levels of
+// detail cover the same screen area as the fine points they replace.
+//
+// Must be created, used and destroyed on the GL thread.
+class PointMapDrawable {
+ public:
+  PointMapDrawable();
+  PointMapDrawable(const PointMapDrawable& other) = delete;
+  const PointMapDrawable& operator=(const PointMapDrawable&) = delete;
+  ~PointMapDrawable();
+
+  void SetColor(const Color& color) { color_ = color; }
+
+  // Scale applied to the voxel size of the points, 1 by default. Smaller
+  // values leave gaps between the points, larger values overlap them.
+  void SetPointSizeScale(float scale) { point_size_scale_ = scale; }
+
+  // Largest point sprite in pixels, 64 by default.
+  void SetMaxPointSize(float max_point_size) {
+    max_point_size_ = max_point_size;
+  }
+
+  // Upload and draw a set of points.
+  //
+  // @param projection_mat: projection matrix from current render camera.
+  // @param view_mat: view matrix from current render camera.
+  // @param pixels_per_meter: LodOptions::pixels_per_meter of the points.
+  // @param points: packed x, y, z, size in the map frame.
+  void Render(const glm::mat4& projection_mat, const glm::mat4& view_mat,
+              float pixels_per_meter, const std::vector<float>& points);
+
+ private:
+  VertexBuffer vertex_buffer_;
+  VertexArray vertex_array_;
+  Color color_;
+  float point_size_scale_;
+  float max_point_size_;
+
+  GLuint shader_program_;
+  GLint attrib_vertices_;
+  GLint uniform_mvp_mat_;
+  GLint uniform_color_;
+  GLint uniform_point_scale_;
+  GLint uniform_max_point_size_;
+};
+}  // namespace tango_gl
+#endif  // TANGO_GL_POINT_MAP_DRAWABLE_H_
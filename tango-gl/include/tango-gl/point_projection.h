@@ -0,0 +1,89 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TANGO_GL_POINT_PROJECTION_H_
+#define TANGO_GL_POINT_PROJECTION_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "tango-gl/conversions.h"
+
+namespace tango_gl {
+namespace projection {
+
+// Pixel value of points behind the camera or outside of the image.
+const int32_t kInvalidPixel = -1;
+
+// Pinhole intrinsics of the camera the points are projected into. The fields
+// match TangoCameraIntrinsics so the Tango values can be copied over as is.
+struct CameraIntrinsics {
+  int width;
+  int height;
+  float fx;
+  float fy;
+  float cx;
+  float cy;
+};
+
+// Pack pixel coordinates the way ProjectPoints() outputs them.
+inline int32_t PackPixel(int32_t pixel_x, int32_t pixel_y) {
+  return (pixel_y << 16) | pixel_x;
+}
+
+inline int32_t PixelX(int32_t packed_pixel) { return packed_pixel & 0xffff; }
+
+inline int32_t PixelY(int32_t packed_pixel) { return packed_pixel >> 16; }
+
+// Transform packed points into a camera frame and project them onto its image
+// plane. This is the batched form of
+//
+//   glm::vec4 p = camera_T_points * glm::vec4(x, y, z, 1.0f);
+//   pixel_x = static_cast<int>(fx * (p.x / p.z) + cx);
+//   pixel_y = static_cast<int>(fy * (p.y / p.z) + cy);
+//
+// On NEON capable devices four points are processed at a time, with the
+// divide replaced by a refined reciprocal estimate; pixels exactly on a
+// boundary can therefore land one pixel off from the scalar result.
+//
+// @param points: packed x, y, z coordinates, point_count * 3 floats.
+// @param point_count: number of points.
+// @param camera_T_points: transformation of the points frame with respect to
+//        the camera frame.
+// @param intrinsics: camera intrinsics, the image size bounds the output.
+// @param pixels: output, one packed pixel (see PackPixel()) per point, or
+//        kInvalidPixel if the point does not project inside the image.
+// @param depths: output, depth of the point in the camera frame, in the unit
+//        of the input points. Can be nullptr.
+// @return number of points projected inside the image.
+size_t ProjectPoints(const float* points, size_t point_count,
+                     const glm::mat4& camera_T_points,
+                     const CameraIntrinsics& intrinsics, int32_t* pixels,
+                     float* depths);
+
+namespace internal {
+// NEON kernel, defined in point_projection_neon.cpp. Projects the first
+// point_count & ~3 points and returns how many of them landed inside the
+// image; the caller projects the remaining points.
+size_t ProjectPointsNeon(const float* points, size_t point_count,
+                         const glm::mat4& camera_T_points,
+                         const CameraIntrinsics& intrinsics, int32_t* pixels,
+                         float* depths);
+}  // namespace internal
+
+}  // namespace projection
+}  // namespace tango_gl
+#endif  // TANGO_GL_POINT_PROJECTION_H_
@@ -0,0 +1,89 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_GL_POSE_HISTORY_H_
+#define TANGO_GL_POSE_HISTORY_H_
+
+#include <mutex>
+#include <vector>
+
+#include "tango-gl/rigid_transform.h"
+#include "tango-gl/util.h"
+
+namespace tango_gl {
+
+// PoseHistory keeps the poses of one frame pair delivered by the pose
+// callback, so poses at the timestamps of depth and color frames can be looked
+// up and interpolated locally instead of asking the service with
+// TangoService_getPoseAtTime() on the render thread.
+//
+// Poses are added from the callback thread and read from any thread.
+class PoseHistory {
+ public:
+  // About 2.5 seconds of poses at the 100Hz rate of the pose callback.
+  static const size_t kDefaultCapacity = 256;
+
+  // @param capacity: number of poses kept, the oldest pose is dropped first.
+  explicit PoseHistory(size_t capacity = kDefaultCapacity);
+  PoseHistory(const PoseHistory& other) = delete;
+  const PoseHistory& operator=(const PoseHistory&) = delete;
+
+  // Add a valid pose. Poses older than the latest one are ignored.
+  //
+  // @param timestamp: pose timestamp in seconds.
+  // @param translation: position [x, y, z], as in TangoPoseData.
+  // @param orientation: quaternion [x, y, z, w], as in TangoPoseData.
+  void Add(double timestamp, const double* translation,
+           const double* orientation);
+
+  // Drop all poses, e.g. when tracking was lost and later poses are no longer
+  // continuous with the earlier ones.
+  void Clear();
+
+  // Get the pose at a timestamp, interpolating the translation linearly and
+  // the orientation spherically between the poses around it.
+  //
+  // @param timestamp: time in seconds.
+  // @param pose: output transformation, only written on success.
+  // @return false if the timestamp is outside of the kept poses, or falls in
+  //         a gap between poses larger than the callback rate explains.
+  bool GetPose(double timestamp, RigidTransform* pose) const;
+  bool GetPose(double timestamp, glm::mat4* pose) const;
+
+  // Get the most recent pose.
+  //
+  // @param timestamp: output timestamp of the pose, only written on success.
+  // @param pose: output transformation, only written on success.
+  // @return false if the history is empty.
+  bool GetLatestPose(double* timestamp, RigidTransform* pose) const;
+
+ private:
+  struct Sample {
+    double timestamp;
+    RigidTransform pose;
+  };
+
+  // Index into samples_ of the i-th oldest kept sample.
+  size_t Index(size_t i) const { return (first_ + i) % samples_.size(); }
+
+  mutable std::mutex mutex_;
+  std::vector<Sample> samples_;
+  size_t first_;
+  size_t count_;
+};
+}  // namespace tango_gl
+#endif  // TANGO_GL_POSE_HISTORY_H_
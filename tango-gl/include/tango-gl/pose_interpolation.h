@@ -0,0 +1,57 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_GL_POSE_INTERPOLATION_H_
+#define TANGO_GL_POSE_INTERPOLATION_H_
+
+#include <stddef.h>
+
+#include "tango-gl/rigid_transform.h"
+
+namespace tango_gl {
+namespace pose_interpolation {
+
+// Rotations whose quaternions have a dot product above this, about 3.6
+// degrees apart, are interpolated with a normalized lerp, which is within
+// float precision of the slerp at such angles and needs no trigonometry.
+// Consecutive poses of the 100Hz pose stream are far closer than that.
+const float kMinLerpDot = 0.9995f;
+
+// Interpolate pairs of transforms, the translations linearly and the
+// rotations spherically along the shorter arc, e.g. the recorded poses
+// around the timestamps of many depth frames.
+//
+// @param before, after: count transforms to interpolate between.
+// @param weights: count weights, 0 for before and 1 for after.
+// @param poses: count output transforms, may alias before or after.
+void Interpolate(const RigidTransform* before, const RigidTransform* after,
+                 const float* weights, size_t count, RigidTransform* poses);
+
+namespace internal {
+// The slerp of one pair, for the rotations too far apart for the lerp.
+RigidTransform Slerp(const RigidTransform& before, const RigidTransform& after,
+                     float weight);
+
+// Per-architecture kernel, defined in pose_interpolation_neon.cpp. The
+// quaternion of a pose fills one register.
+void InterpolateNeon(const RigidTransform* before, const RigidTransform* after,
+                     const float* weights, size_t count,
+                     RigidTransform* poses);
+}  // namespace internal
+}  // namespace pose_interpolation
+}  // namespace tango_gl
+#endif  // TANGO_GL_POSE_INTERPOLATION_H_
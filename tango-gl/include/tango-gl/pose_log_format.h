@@ -0,0 +1,60 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TANGO_GL_POSE_LOG_FORMAT_H_
+#define TANGO_GL_POSE_LOG_FORMAT_H_
+
+#include <stdint.h>
+
+#include "tango-gl/session_format.h"
+
+namespace tango_gl {
+namespace pose_log {
+
+// Layout of a pose log file, written by PoseLogger.
+//
+// The file has a fixed size: a FileHeader followed by record_capacity Record
+// slots used as a ring, record n of the log being in slot
+// n % record_capacity. Once the ring is full the oldest records are
+// overwritten, so the file holds the last min(record_count,
+// record_capacity) poses. All values are little endian.
+
+const uint32_t kMagic = 0x4C504754;  // "TGPL"
+const uint32_t kVersion = 1;
+
+struct FileHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t record_size;
+  uint32_t record_capacity;
+  // Records written since the log started, updated after the records.
+  uint64_t record_count;
+  // Poses dropped because the writer fell behind.
+  uint64_t dropped_count;
+};
+
+// A TangoPoseData and its timestamp, in seconds.
+struct Record {
+  double timestamp;
+  session::PoseRecord pose;
+};
+
+static_assert(sizeof(FileHeader) == 32, "FileHeader layout changed.");
+static_assert(sizeof(Record) == 80, "Record layout changed.");
+
+}  // namespace pose_log
+}  // namespace tango_gl
+#endif  // TANGO_GL_POSE_LOG_FORMAT_H_
@@ -0,0 +1,91 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TANGO_GL_POSE_LOGGER_H_
+#define TANGO_GL_POSE_LOGGER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <thread>
+
+#include <tango_client_api.h>
+
+#include "tango-gl/bounded_queue.h"
+#include "tango-gl/pose_log_format.h"
+
+namespace tango_gl {
+
+// PoseLogger records every pose of a session into a fixed size, memory
+// mapped ring file (see tango-gl/pose_log_format.h), for diagnostics at full
+// pose rate. host/pose_log_decode prints a log as text.
+//
+// Log() is meant to be called straight from the pose callback: it copies a
+// fixed size record into a lock-free queue, with no formatting and no system
+// call. A writer thread moves queued records into the mapping every few
+// milliseconds. When it falls behind, poses are dropped and counted instead
+// of stalling the callback.
+class PoseLogger {
+ public:
+  // @param queue_capacity: poses that can wait for the writer thread.
+  explicit PoseLogger(size_t queue_capacity = 1024);
+  PoseLogger(const PoseLogger& other) = delete;
+  const PoseLogger& operator=(const PoseLogger&) = delete;
+  ~PoseLogger();
+
+  // Create the file, map it and start the writer thread.
+  //
+  // @param path: file to write, replaced if it exists.
+  // @param record_capacity: poses kept, the oldest are overwritten.
+  // @return: false if the file could not be created or mapped, or a log is
+  //          already running.
+  bool Start(const char* path, uint32_t record_capacity);
+
+  // Write the queued poses, unmap and close the file.
+  void Stop();
+
+  // Queue a pose. Can be called from any thread.
+  //
+  // @return: false if the pose was dropped, because no log is running or the
+  //          queue is full.
+  bool Log(const TangoPoseData& pose);
+
+  // Poses dropped since Start().
+  uint64_t GetDroppedCount() const {
+    return dropped_count_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  void WriteLoop();
+
+  // Move the queued records into the mapping and publish their count.
+  void WriteQueued();
+
+  BoundedQueue<pose_log::Record> queue_;
+  std::atomic<bool> is_logging_;
+  std::atomic<bool> is_stopping_;
+  std::atomic<uint64_t> dropped_count_;
+
+  // Only touched by the writer thread while it runs.
+  int file_;
+  void* mapping_;
+  size_t mapping_size_;
+  uint64_t record_count_;
+  std::thread writer_;
+};
+}  // namespace tango_gl
+#endif  // TANGO_GL_POSE_LOGGER_H_
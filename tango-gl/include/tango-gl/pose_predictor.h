@@ -0,0 +1,109 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_GL_POSE_PREDICTOR_H_
+#define TANGO_GL_POSE_PREDICTOR_H_
+
+#include <functional>
+#include <vector>
+
+#include "tango-gl/pose_history.h"
+#include "tango-gl/rigid_transform.h"
+
+namespace tango_gl {
+
+// PosePredictor extrapolates the poses of a PoseHistory past its latest pose,
+// assuming constant linear and angular velocity, to the time a frame is
+// expected to reach the display.
+//
+// Predictions are remembered until the history covers their timestamp, then
+// compared with the actual pose to measure the prediction error. Only to be
+// used from one thread, typically the render thread.
+class PosePredictor {
+ public:
+  // Called for every measured prediction.
+  //
+  // @param timestamp: the predicted timestamp.
+  // @param translation_error: distance between the predicted and the actual
+  //        position, in meters.
+  // @param rotation_error: angle between the predicted and the actual
+  //        orientation, in radians.
+  typedef std::function<void(double timestamp, float translation_error,
+                             float rotation_error)> ErrorListener;
+
+  // @param history: poses to extrapolate, must outlive the predictor.
+  explicit PosePredictor(const PoseHistory* history);
+  PosePredictor(const PosePredictor& other) = delete;
+  const PosePredictor& operator=(const PosePredictor&) = delete;
+
+  // Set the time between a pose timestamp and the display of a frame rendered
+  // with it, e.g. one or two vsync periods. Defaults to 0, no prediction.
+  //
+  // @param latency: latency in seconds.
+  void SetLatency(double latency) { latency_ = latency; }
+
+  // Set the longest extrapolation past the latest pose, beyond which constant
+  // velocity is a poor guess. Defaults to 50 ms.
+  //
+  // @param max_extrapolation: time in seconds.
+  void SetMaxExtrapolation(double max_extrapolation) {
+    max_extrapolation_ = max_extrapolation;
+  }
+
+  void SetErrorListener(const ErrorListener& listener) {
+    error_listener_ = listener;
+  }
+
+  // Predict the pose at timestamp plus the latency. Also measures earlier
+  // predictions the history now covers.
+  //
+  // @param timestamp: time in seconds, e.g. of the camera image.
+  // @param pose: output transformation, only written on success.
+  // @return false if the history is empty.
+  bool Predict(double timestamp, RigidTransform* pose);
+
+  // Mean errors of the predictions measured so far, 0 before the first one.
+  float GetMeanTranslationError() const;
+  float GetMeanRotationError() const;
+  size_t GetMeasurementCount() const { return measurement_count_; }
+
+  // Drop pending predictions and the error statistics.
+  void Reset();
+
+ private:
+  struct Prediction {
+    double timestamp;
+    RigidTransform pose;
+  };
+
+  // Compare pending predictions with the actual poses in the history.
+  void MeasurePredictions(double latest_timestamp);
+
+  const PoseHistory* history_;
+  double latency_;
+  double max_extrapolation_;
+  ErrorListener error_listener_;
+
+  // Extrapolated predictions waiting for their actual pose, oldest first.
+  std::vector<Prediction> pending_;
+
+  size_t measurement_count_;
+  double translation_error_sum_;
+  double rotation_error_sum_;
+};
+}  // namespace tango_gl
+#endif  // TANGO_GL_POSE_PREDICTOR_H_
@@ -0,0 +1,224 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_GL_POSE_STREAM_H_
+#define TANGO_GL_POSE_STREAM_H_
+
+#include <stdint.h>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+#include <tango_client_api.h>  // NOLINT
+
+#include "tango-gl/seqlock.h"
+
+namespace tango_gl {
+
+// PoseStream fans the poses of one onPoseAvailable callback out to a slot per
+// subscribed frame pair. Each slot holds the latest pose in a SeqLock and the
+// recent poses in a ring of SeqLocks, so readers on the render and UI threads
+// never block the callback thread, and never wait for each other.
+//
+// One frame pair can be marked as the relocalization pair, e.g. ADF with
+// respect to start of service. Its pose turning valid is a relocalization
+// event, counted in an atomic so consumers can poll for corrections with a
+// single load.
+//
+// Consumers that need far fewer poses than the callback rate, e.g. a network
+// stream or a trajectory store, subscribe with a rate limit and motion
+// thresholds instead. The limits are checked on the callback thread with a
+// few comparisons, before the subscriber is called, so a skipped pose costs
+// the subscriber nothing.
+//
+// OnPoseAvailable() and Reset() are the writer side and must not run
+// concurrently with each other. Subscribe(), Unsubscribe() and all getters
+// can be called from any thread, e.g. by a consumer starting or stopping
+// while the callbacks run. A subscriber runs after the latest pose and the
+// relocalization state of its pose were updated, and may read them; it must
+// not call Subscribe(), Unsubscribe() or the subscription counters.
+class PoseStream {
+ public:
+  // Most frame pairs a stream fans out to.
+  static const int kMaxFramePairs = 8;
+
+  // About 2.5 seconds of poses at the 100Hz rate of the pose callback.
+  static const size_t kDefaultHistoryCapacity = 256;
+
+  // Latest pose of a frame pair.
+  struct Snapshot {
+    TangoPoseData pose;
+    // Time since the previous pose of the pair, in seconds.
+    double delta_time;
+    // Poses since the last status change, 0 before the first pose.
+    uint32_t pose_counter;
+  };
+
+  // Limits of a subscriber. A pose is delivered once the rate limit allows
+  // it and the device moved past a threshold since the last delivered pose.
+  // A pose whose status differs from the last delivered one is always
+  // delivered.
+  struct SubscriberOptions {
+    SubscriberOptions()
+        : max_rate(0.0), min_translation(0.0f), min_rotation(0.0f) {}
+
+    // Most poses per second, 0 for no limit.
+    double max_rate;
+    // Distance in meters and angle in radians to move past, either one is
+    // enough. Both 0 delivers poses whatever the motion.
+    float min_translation;
+    float min_rotation;
+  };
+
+  // Called on the pose callback thread, it should only copy the pose out.
+  typedef std::function<void(const TangoPoseData& pose)> Subscriber;
+
+  // Most subscribers of a stream.
+  static const int kMaxSubscribers = 8;
+
+  // @param pairs: frame pairs to keep apart, in the order they are passed to
+  //        TangoService_connectOnPoseAvailable().
+  // @param pair_count: number of pairs, at most kMaxFramePairs.
+  // @param history_capacity: poses kept per pair, the oldest is dropped first.
+  PoseStream(const TangoCoordinateFramePair* pairs, int pair_count,
+             size_t history_capacity = kDefaultHistoryCapacity);
+  PoseStream(const PoseStream& other) = delete;
+  const PoseStream& operator=(const PoseStream&) = delete;
+  ~PoseStream();
+
+  int GetPairCount() const { return pair_count_; }
+
+  // Frame pairs for TangoService_connectOnPoseAvailable().
+  const TangoCoordinateFramePair* GetFramePairs() const { return pairs_; }
+
+  // Return the index of a frame pair, -1 if it is not subscribed.
+  int FindPair(TangoCoordinateFrameType base,
+               TangoCoordinateFrameType target) const;
+
+  // Mark the pair whose valid poses mean the device is relocalized.
+  //
+  // @param pair: index of the pair, -1 for none.
+  void SetRelocalizationPair(int pair) { relocalization_pair_ = pair; }
+
+  // Route a pose to the slot of its frame pair, poses of other pairs are
+  // ignored. Called from the pose callback thread.
+  void OnPoseAvailable(const TangoPoseData& pose);
+
+  // Forget all poses and the relocalization state.
+  void Reset();
+
+  // Deliver the poses of a pair to a subscriber, decimated by its options.
+  //
+  // @param pair: index of the pair.
+  // @return: id of the subscription, -1 if the pair is not subscribed or
+  //          there are kMaxSubscribers subscriptions already.
+  int Subscribe(int pair, const SubscriberOptions& options,
+                const Subscriber& subscriber);
+
+  // Stop delivering poses to a subscription. Once it returns the subscriber
+  // is not running and will not be called again, so what it captured can be
+  // destroyed.
+  void Unsubscribe(int subscription);
+
+  // Poses delivered to and skipped for a subscription.
+  uint64_t GetDeliveredCount(int subscription) const;
+  uint64_t GetSkippedCount(int subscription) const;
+
+  // Get the latest pose of a pair, all zero before the first pose.
+  Snapshot GetLatest(int pair) const;
+
+  // Copy the most recent poses of a pair, newest first.
+  //
+  // @param pair: index of the pair.
+  // @param max_count: size of poses.
+  // @param poses: output poses.
+  // @return: number of poses copied.
+  size_t GetHistory(int pair, size_t max_count, TangoPoseData* poses) const;
+
+  // Return true while the relocalization pair's latest pose is valid.
+  bool IsRelocalized() const {
+    return is_relocalized_.load(std::memory_order_acquire);
+  }
+
+  // Return the number of relocalization events since the last Reset(). It
+  // grows every time the relocalization pair turns valid again, e.g. after a
+  // loop closure following lost tracking.
+  uint32_t GetRelocalizationCount() const {
+    return relocalization_count_.load(std::memory_order_acquire);
+  }
+
+ private:
+  // A history entry remembers its position in the stream, so a reader can
+  // tell an entry overwritten while it was reading the ring.
+  struct HistoryEntry {
+    uint64_t index;
+    TangoPoseData pose;
+  };
+
+  struct Slot {
+    explicit Slot(size_t history_capacity);
+
+    SeqLock<Snapshot> latest;
+    std::unique_ptr<SeqLock<HistoryEntry>[]> history;
+    size_t history_capacity;
+    // Poses written to the history, published after the entry.
+    std::atomic<uint64_t> history_count;
+
+    // Only used by the writer.
+    TangoPoseData prev_pose;
+    uint32_t pose_counter;
+  };
+
+  struct Subscription {
+    int pair;
+    Subscriber subscriber;
+    double min_interval;
+    // Squared min_translation, 0 without.
+    double min_translation_squared;
+    // Cosine of half min_rotation, the largest quaternion dot product of a
+    // rotation past it, -1 without.
+    double max_orientation_dot;
+    // Whether the poses pass without a motion threshold.
+    bool is_moving_always;
+
+    // Only used by the writer.
+    bool has_last_pose;
+    TangoPoseData last_pose;
+
+    std::atomic<uint64_t> delivered_count;
+    std::atomic<uint64_t> skipped_count;
+  };
+
+  // Whether a pose passes the limits of a subscription.
+  static bool ShouldDeliver(const Subscription& subscription,
+                            const TangoPoseData& pose);
+
+  TangoCoordinateFramePair pairs_[kMaxFramePairs];
+  int pair_count_;
+  std::unique_ptr<Slot> slots_[kMaxFramePairs];
+  int relocalization_pair_;
+  // Guards subscriptions_, held by OnPoseAvailable() while it delivers.
+  mutable std::mutex subscription_mutex_;
+  std::unique_ptr<Subscription> subscriptions_[kMaxSubscribers];
+
+  std::atomic<bool> is_relocalized_;
+  std::atomic<uint32_t> relocalization_count_;
+};
+}  // namespace tango_gl
+#endif  // TANGO_GL_POSE_STREAM_H_
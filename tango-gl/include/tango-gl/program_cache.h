@@ -0,0 +1,65 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TANGO_GL_PROGRAM_CACHE_H_
+#define TANGO_GL_PROGRAM_CACHE_H_
+
+#include <string>
+
+#include "tango-gl/util.h"
+
+namespace tango_gl {
+namespace program_cache {
+
+// Process wide cache of linked shader programs.
+//
+// Drawables built from the same shader sources share one program object, so
+// a scene with many axes or frustums compiles its shaders once. Programs are
+// reference counted and deleted when the last user releases them. If a binary
+// cache directory is set and the context supports GL_OES_get_program_binary,
+// linked programs are also written to disk and loaded from there on the next
+// start, skipping compilation altogether.
+//
+// Cached programs belong to the EGL context current when they were created;
+// the cache drops them (without deleting) as soon as it is used from another
+// context, so stale ids are never handed out after a context loss.
+//
+// All functions must be called on the GL thread.
+
+// Get the program for a pair of shader sources, compiling and linking it if
+// no live program exists yet. Each successful call must be paired with a
+// ReleaseProgram() call.
+//
+// @param vertex_source: source of the vertex shader.
+// @param fragment_source: source of the fragment shader.
+// @return the program, or 0 if compiling or linking failed.
+GLuint AcquireProgram(const char* vertex_source, const char* fragment_source);
+
+// Release a program returned by AcquireProgram(). Passing 0 or a program the
+// cache does not know (e.g. from a lost context) is a no-op.
+void ReleaseProgram(GLuint program);
+
+// Set the directory program binaries are persisted to, e.g. the application
+// cache directory. An empty path disables persistence, which is the default.
+void SetBinaryCacheDirectory(const std::string& path);
+
+// Convenience for SetBinaryCacheDirectory() with the cache directory of an
+// Android activity (Context.getCacheDir()).
+void SetBinaryCacheDirectory(JNIEnv* env, jobject activity);
+
+}  // namespace program_cache
+}  // namespace tango_gl
+#endif  // TANGO_GL_PROGRAM_CACHE_H_
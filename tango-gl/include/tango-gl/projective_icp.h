@@ -0,0 +1,168 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_GL_PROJECTIVE_ICP_H_
+#define TANGO_GL_PROJECTIVE_ICP_H_
+
+#include <stddef.h>
+
+#include <vector>
+
+#include <tango_client_api.h>  // NOLINT
+
+#include "tango-gl/normal_estimator.h"
+#include "tango-gl/point_map.h"
+#include "tango-gl/range_image.h"
+#include "tango-gl/util.h"
+#include "tango-gl/view_frustum.h"
+#include "tango-gl/worker_pool.h"
+
+namespace tango_gl {
+
+// ProjectiveIcp refines the pose of a depth frame against a PointMap before
+// the frame is inserted, so drift of the device pose does not leave seams
+// between the frames of the map.
+//
+// The map is rendered into a range image from the pose to refine, the model,
+// and the normals of the model are computed by a NormalEstimator. Each point
+// of the frame, moved by the current estimate, is then associated with the
+// model point in the pixel it projects into, instead of searching for the
+// nearest one, and the point to plane distances of these pairs are minimized
+// by Gauss-Newton steps on the 6x6 normal equations. The frame is sampled
+// coarse to fine, every 2^level pixels of its range image from the coarsest
+// level down to every pixel, with the distance threshold of the pairs
+// halving at each level.
+//
+// The normal equations are reduced from the pairs four at a time on NEON
+// capable devices. Not thread safe; it is meant to run on a worker, e.g. a
+// PipelineStage in front of PointMap::Insert(), with the map serialized
+// against its inserts.
+class ProjectiveIcp {
+ public:
+  struct Options {
+    Options()
+        : level_count(3),
+          iteration_count(5),
+          max_distance(0.1f),
+          max_depth(4.0f),
+          min_pair_count(100),
+          min_translation(1e-4f),
+          min_rotation(1e-4f) {}
+
+    // Sampling levels, the coarsest samples every 2^(level_count - 1)
+    // pixels of the frame.
+    int level_count;
+    // Most Gauss-Newton steps per level.
+    int iteration_count;
+    // Farthest apart in meters the points of a pair are at the coarsest
+    // level, half as far at each finer level.
+    float max_distance;
+    // Map points farther from the camera are not rendered into the model.
+    float max_depth;
+    // Fewest pairs a step is solved with. With fewer, e.g. when the map does
+    // not overlap the frame yet, refinement stops and keeps the pose so far.
+    size_t min_pair_count;
+    // A level ends once a step moves the frame less than this, in meters and
+    // radians.
+    float min_translation;
+    float min_rotation;
+  };
+
+  struct Result {
+    // Gauss-Newton steps taken over all levels.
+    int iteration_count;
+    // Pairs of the last step.
+    size_t pair_count;
+    // Root mean square point to plane distance of the pairs of the last
+    // step, in meters.
+    float rms_distance;
+    // Model pixels with a point and a normal.
+    size_t model_pixel_count;
+  };
+
+  // @param worker_pool: pool to compute the model normals on, can be nullptr
+  //        to compute on the calling thread only.
+  ProjectiveIcp(WorkerPool* worker_pool, const Options& options = Options());
+  ProjectiveIcp(const ProjectiveIcp& other) = delete;
+  const ProjectiveIcp& operator=(const ProjectiveIcp&) = delete;
+
+  // Set the intrinsics of the depth camera, TANGO_CAMERA_DEPTH, see
+  // CameraIntrinsicsRegistry::GetIntrinsics().
+  void SetIntrinsics(const TangoCameraIntrinsics& intrinsics);
+
+  // Refine the pose of a depth frame against a map.
+  //
+  // @param map: map the frame is aligned with, e.g. before inserting it.
+  // @param xyz: packed x, y, z coordinates in the depth camera frame.
+  // @param point_count: number of points.
+  // @param map_T_depth: in, the pose of the depth camera with respect to the
+  //        map frame at the frame timestamp, e.g. from the pose history;
+  //        out, the refined pose.
+  // @param result: output statistics, can be nullptr.
+  // @return false if the pose was left as is, because the map or the frame
+  //         gave too few pairs for a step.
+  bool Refine(const PointMap& map, const float* xyz, size_t point_count,
+              glm::mat4* map_T_depth, Result* result);
+
+ private:
+  // Render the map points into the model image from a pose, and compute
+  // their normals.
+  //
+  // @return number of model pixels with a normal.
+  size_t RenderModel(const PointMap& map, const glm::mat4& map_T_depth);
+
+  // Pair the frame points of a level with the model and fill terms_.
+  //
+  // @param model_T_frame: current estimate of the frame pose in the model
+  //        camera frame.
+  // @return number of pairs.
+  size_t Associate(const float* xyz, int stride, float max_distance,
+                   const glm::mat4& model_T_frame);
+
+  Options options_;
+
+  RangeImage frame_image_;
+  RangeImage model_image_;
+  NormalEstimator model_normals_;
+  ViewFrustum frustum_;
+  glm::mat4 projection_mat_;
+
+  // Map points, in the map frame then in the model camera frame.
+  std::vector<float> model_xyz_;
+  // internal::kTermCount planes of one float per pair.
+  std::vector<float> terms_;
+  size_t term_capacity_;
+};
+
+namespace internal {
+// Terms of a pair: the jacobian of its point to plane distance with respect
+// to a small rotation then a translation of the frame, and the distance.
+const int kTermCount = 7;
+
+// Upper triangle of the 7x7 sum of the outer products of the terms, row
+// major: the normal matrix in rows of 6, 5, ... 1 entries each followed by
+// the right hand side, and last the sum of squared distances.
+const int kTermSumCount = kTermCount * (kTermCount + 1) / 2;
+
+// NEON kernel, defined in projective_icp_neon.cpp. Accumulates the first
+// count & ~3 pairs; the caller accumulates the remaining pairs.
+void AccumulateTermsNeon(const float* const terms[kTermCount], size_t count,
+                         double sums[kTermSumCount]);
+}  // namespace internal
+
+}  // namespace tango_gl
+#endif  // TANGO_GL_PROJECTIVE_ICP_H_
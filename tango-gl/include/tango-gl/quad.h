@@ -18,6 +18,7 @@
 #define TANGO_GL_QUAD_H_
 
 #include "tango-gl/drawable_object.h"
+#include "tango-gl/vertex_array.h"
 
 namespace tango_gl {
 class Quad : public DrawableObject {
@@ -31,7 +32,7 @@ class Quad : public DrawableObject {
   void SetTextureId(GLuint texture_id);
 
  private:
-  GLuint vertex_buffer_;
+  mutable VertexArray vertex_array_;
   GLuint shader_program_;
   GLuint attrib_vertices_;
   GLuint texture_coords_;
@@ -0,0 +1,151 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_GL_QUALITY_GOVERNOR_H_
+#define TANGO_GL_QUALITY_GOVERNOR_H_
+
+#include <atomic>
+
+#include "tango-gl/frame_profiler.h"
+
+namespace tango_gl {
+
+// QualityGovernor holds a target frame rate on a device that throttles. The
+// application declares a ladder of quality levels, from 0 (cheapest) to
+// level_count - 1 (best), e.g. upsampling window sizes and point budgets,
+// and applies GetLevel() whenever Update() returns true.
+//
+// Update() reads a percentile of the frame time from a FrameProfiler zone,
+// its CPU samples by default or its GPU samples when the ladder trades GPU
+// work, e.g. a render resolution:
+//  - above step_down_ratio times the target frame time, it steps down a
+//    level as soon as min_sample_count frames were measured at the current
+//    level;
+//  - below step_up_ratio times the target, it steps up a level once the
+//    level held for its step up delay. The delay doubles each time a level
+//    had to be left again shortly after stepping up to it, so the governor
+//    does not oscillate around a level the device can not hold.
+// The profiler zone is cleared on each step, so decisions are only made on
+// frames rendered at the current level.
+//
+// The Android thermal status caps the level: moderate throttling takes one
+// level off the top, severe two, and so on. The status is polled from the
+// NDK thermal API where the device has it (API level 30), and can also be
+// given by SetThermalStatus(), e.g. from a PowerManager listener.
+//
+// Update() must be called on the thread that renders the frames measured.
+class QualityGovernor {
+ public:
+  // Values of the Android thermal status, see AThermalStatus.
+  enum ThermalStatus {
+    kThermalNone = 0,
+    kThermalLight = 1,
+    kThermalModerate = 2,
+    kThermalSevere = 3,
+    kThermalCritical = 4,
+    kThermalEmergency = 5,
+    kThermalShutdown = 6,
+  };
+
+  struct Options {
+    Options()
+        : target_frame_ms(1000.0f / 30.0f),
+          zone("frame"),
+          is_gpu_time(false),
+          percentile(0.9f),
+          step_down_ratio(1.1f),
+          step_up_ratio(0.75f),
+          min_sample_count(30),
+          step_up_frame_count(120) {}
+
+    // Frame time to hold, in milliseconds.
+    float target_frame_ms;
+    // Profiler zone measured against the target, a string literal.
+    const char* zone;
+    // Whether the GPU samples of the zone are measured rather than the CPU
+    // ones. Falls back to the CPU samples without timer query support.
+    bool is_gpu_time;
+    // Percentile of the zone compared to the target.
+    float percentile;
+    // Thresholds relative to target_frame_ms.
+    float step_down_ratio;
+    float step_up_ratio;
+    // Frames measured at a level before it can be left.
+    size_t min_sample_count;
+    // Frames a level is held before stepping up, before backoff.
+    size_t step_up_frame_count;
+  };
+
+  // Starts at the best level.
+  QualityGovernor(int level_count, const Options& options);
+  QualityGovernor(const QualityGovernor& other) = delete;
+  const QualityGovernor& operator=(const QualityGovernor&) = delete;
+  ~QualityGovernor();
+
+  // Evaluate the frame times once per frame.
+  //
+  // @return: true if the level changed.
+  bool Update(FrameProfiler* profiler);
+
+  // Current quality level, 0 is the cheapest.
+  int GetLevel() const { return level_; }
+
+  // Number of levels of the ladder.
+  int GetLevelCount() const { return level_count_; }
+
+  // Set the thermal status reported by a source other than the NDK thermal
+  // API. The higher of the two statuses is used. Can be called from any
+  // thread.
+  void SetThermalStatus(ThermalStatus status);
+
+  // The thermal status the level is capped by. Can be called from any thread.
+  ThermalStatus GetThermalStatus() const;
+
+ private:
+  typedef int (*GetThermalStatusFunc)(void* manager);
+
+  // Poll the NDK thermal status, if the device has the API.
+  void PollThermalStatus();
+
+  // Highest level allowed by the thermal status.
+  int GetThermalCap() const;
+
+  // Move to a level and start measuring it from scratch.
+  void SetLevel(int level, FrameProfiler* profiler);
+
+  const int level_count_;
+  const Options options_;
+
+  int level_;
+  // Frames since the level was entered.
+  size_t frame_count_;
+  // Frames the current level is held before stepping up.
+  size_t step_up_delay_;
+  // Whether the current level was reached by stepping up.
+  bool is_stepped_up_;
+
+  // AThermalManager and its status query, resolved at runtime since the
+  // examples build against an older platform. Null without the API.
+  void* thermal_manager_;
+  GetThermalStatusFunc get_thermal_status_;
+  size_t frames_since_thermal_poll_;
+
+  std::atomic<int> polled_thermal_status_;
+  std::atomic<int> external_thermal_status_;
+};
+}  // namespace tango_gl
+#endif  // TANGO_GL_QUALITY_GOVERNOR_H_
@@ -0,0 +1,174 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TANGO_GL_RANGE_IMAGE_H_
+#define TANGO_GL_RANGE_IMAGE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include <tango_client_api.h>  // NOLINT
+
+#include "tango-gl/point_projection.h"
+#include "tango-gl/ray_table.h"
+#include "tango-gl/util.h"
+
+namespace tango_gl {
+
+// RangeImage reprojects an unordered depth frame, e.g. TangoXYZij, into the
+// image of the depth camera that measured it. Algorithms that need the
+// neighbors of a point (normals, plane fitting around a pixel, hole filling)
+// can then look them up by pixel instead of searching the whole cloud.
+//
+// Each pixel keeps the nearest point projecting into it, its depth and its
+// index in the frame. The image is allocated by SetIntrinsics() and reused
+// for every frame. Update() only clears the pixels the previous frame
+// filled, so a frame costs a single pass over its points whatever the image
+// size. On NEON capable devices four points are projected at a time, with
+// the divide replaced by a refined reciprocal estimate; points exactly
+// between two pixels can therefore land one pixel off from the scalar result.
+// Frames whose ij index grid is filled in already carry the pixel of every
+// point and skip the projection.
+//
+// Not thread safe, give each thread that converts frames its own image.
+class RangeImage {
+ public:
+  // Point index of pixels without a point.
+  static const int32_t kNoPoint = -1;
+
+  RangeImage();
+  RangeImage(const RangeImage& other) = delete;
+  const RangeImage& operator=(const RangeImage&) = delete;
+
+  // Set the intrinsics of the depth camera, TANGO_CAMERA_DEPTH, see
+  // CameraIntrinsicsRegistry::GetIntrinsics(). The image takes the size of
+  // the camera image and is cleared. Points are assumed undistorted, the
+  // distortion coefficients are ignored.
+  void SetIntrinsics(const TangoCameraIntrinsics& intrinsics);
+
+  // Replace the image with a depth frame.
+  //
+  // @param points: packed x, y, z coordinates in the depth camera frame,
+  //        point_count * 3 floats.
+  // @param point_count: number of points.
+  // @return number of pixels with a point.
+  size_t Update(const float* points, size_t point_count);
+
+  // Replace the image with a TangoXYZij frame. If the service filled in the
+  // ij index grid at the image size, the points are gathered from it instead
+  // of being projected, see HasIndexGrid().
+  size_t Update(const TangoXYZij& cloud);
+
+  // Whether the ij index grid of a frame is filled in and maps onto this
+  // image pixel for pixel.
+  bool HasIndexGrid(const TangoXYZij& cloud) const;
+
+  // Remove every point from the image.
+  void Clear();
+
+  int GetWidth() const { return intrinsics_.width; }
+  int GetHeight() const { return intrinsics_.height; }
+  const projection::CameraIntrinsics& GetIntrinsics() const {
+    return intrinsics_;
+  }
+
+  // Rays through the pixel centers, built by SetIntrinsics(), to back
+  // project whole rows of the image.
+  const RayTable& GetRayTable() const { return ray_table_; }
+
+  // Number of pixels with a point.
+  size_t GetFilledPixelCount() const { return filled_pixel_count_; }
+
+  bool Contains(int x, int y) const {
+    return x >= 0 && x < intrinsics_.width && y >= 0 &&
+           y < intrinsics_.height;
+  }
+
+  // Row major, GetWidth() * GetHeight() depths, 0 where there is no point.
+  const float* GetDepths() const { return depths_.data(); }
+
+  // Row major, GetWidth() * GetHeight() indices of the points in the frame
+  // last passed to Update(), kNoPoint where there is no point.
+  const int32_t* GetPointIndices() const { return point_indices_.data(); }
+
+  // Depth at a pixel inside the image, 0 if it has no point.
+  float GetDepth(int x, int y) const {
+    return depths_[y * intrinsics_.width + x];
+  }
+
+  // Index of the point at a pixel inside the image, or kNoPoint.
+  int32_t GetPointIndex(int x, int y) const {
+    return point_indices_[y * intrinsics_.width + x];
+  }
+
+  // Pixel a position in the depth camera frame falls into, rounded to the
+  // nearest pixel center like Update() does.
+  //
+  // @return false if the position is behind the camera or outside the image.
+  bool GetPixel(const glm::vec3& position, int* x, int* y) const;
+
+  // Position of the point at a pixel, back projected through the pixel
+  // center with its depth. Only meaningful if the pixel has a point; use
+  // GetPointIndex() for the exact position in the frame.
+  glm::vec3 GetPosition(int x, int y) const {
+    return ray_table_.BackProject(x, y, GetDepth(x, y));
+  }
+
+ private:
+  projection::CameraIntrinsics intrinsics_;
+  RayTable ray_table_;
+  std::vector<float> depths_;
+  std::vector<int32_t> point_indices_;
+
+  // Offsets of the pixels with a point, the first filled_pixel_count_ are
+  // used.
+  std::vector<int32_t> filled_pixels_;
+  size_t filled_pixel_count_;
+};
+
+namespace internal {
+// Destination of the points written by Update() and its kernels.
+struct RangeImageTarget {
+  float* depths;
+  int32_t* point_indices;
+  int32_t* filled_pixels;
+  size_t filled_pixel_count;
+};
+
+// Keep a point at a pixel offset if it is the nearest one there so far.
+inline void StoreRangePoint(RangeImageTarget* target, int32_t pixel,
+                            int32_t point, float depth) {
+  float& pixel_depth = target->depths[pixel];
+  if (pixel_depth == 0.0f) {
+    target->filled_pixels[target->filled_pixel_count++] = pixel;
+  } else if (pixel_depth <= depth) {
+    return;
+  }
+  pixel_depth = depth;
+  target->point_indices[pixel] = point;
+}
+
+// NEON kernel, defined in range_image_neon.cpp. Projects and stores the
+// first point_count & ~3 points; the caller stores the remaining points.
+void StoreRangePointsNeon(const float* points, size_t point_count,
+                          const projection::CameraIntrinsics& intrinsics,
+                          RangeImageTarget* target);
+}  // namespace internal
+
+}  // namespace tango_gl
+#endif  // TANGO_GL_RANGE_IMAGE_H_
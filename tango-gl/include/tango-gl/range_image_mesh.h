@@ -0,0 +1,146 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_GL_RANGE_IMAGE_MESH_H_
+#define TANGO_GL_RANGE_IMAGE_MESH_H_
+
+#include <stddef.h>
+
+#include <vector>
+
+#include "tango-gl/range_image.h"
+#include "tango-gl/util.h"
+#include "tango-gl/vertex_buffer.h"
+
+namespace tango_gl {
+
+// RangeImageMesh draws a depth frame as a surface instead of GL_POINTS: the
+// organized RangeImage is triangulated as a regular grid, two triangles per
+// cell, so each screen pixel is covered about once, opaque, where large
+// points overlap and blend many times over.
+//
+// The grid never changes, so its index buffer and the ray of each grid node
+// are uploaded once per layout. A frame only uploads one depth per node, the
+// vertex shader back projects the node along its ray. A node holds the
+// nearest depth of its cell_size x cell_size block of pixels, which also
+// fills the holes between sparse depth points.
+//
+// Triangles across a depth discontinuity, e.g. between a chair and the wall
+// behind, are rejected: a node whose depth is farther than max_depth_jump
+// (relative to the depth) from a neighbor is dropped, and the fragments of
+// the triangles with a dropped node or a node without depth are discarded.
+// The nearer side of an edge keeps its nodes, so objects do not shrink.
+//
+// Update() is plain CPU work and can run on any thread; Render(), Release()
+// and Invalidate() must be called on the GL thread.
+class RangeImageMesh {
+ public:
+  struct Options {
+    Options() : cell_size(2), max_depth_jump(0.05f) {}
+
+    // Pixels of the range image per grid cell side. Raised as needed so the
+    // grid fits 16 bit indices.
+    int cell_size;
+    // Largest depth difference between neighbor nodes, as a fraction of the
+    // nearer depth, for them to share triangles.
+    float max_depth_jump;
+  };
+
+  explicit RangeImageMesh(const Options& options = Options());
+  RangeImageMesh(const RangeImageMesh& other) = delete;
+  const RangeImageMesh& operator=(const RangeImageMesh&) = delete;
+  ~RangeImageMesh();
+
+  // Build the node depths of a range image. The grid is laid out again
+  // when the intrinsics of the image change.
+  //
+  // @return number of nodes kept.
+  size_t Update(const RangeImage& image);
+
+  // Draw the last update, opaque and depth tested.
+  //
+  // @param model_mat: world_T_depth of the frame.
+  void Render(const glm::mat4& projection_mat, const glm::mat4& view_mat,
+              const glm::mat4& model_mat);
+
+  // Surface color, darkened with depth for a sense of shape.
+  void SetColor(const glm::vec4& color) { color_ = color; }
+
+  // Color the surface by its side of a plane instead, e.g. to debug a plane
+  // fit: green within distance of the plane, red below and blue above it.
+  // A distance of 0 goes back to the color of SetColor().
+  //
+  // @param plane: plane equation in the frame of the range image.
+  void SetPlaneColors(const glm::vec4& plane, float distance) {
+    plane_ = plane;
+    plane_distance_ = distance;
+  }
+
+  int GetGridWidth() const { return grid_width_; }
+  int GetGridHeight() const { return grid_height_; }
+  size_t GetKeptNodeCount() const { return kept_node_count_; }
+
+  // Release the GL resources.
+  void Release();
+
+  // Forget the GL resources without deleting them. Use this when the GL
+  // context they belonged to has been destroyed.
+  void Invalidate();
+
+ private:
+  // Lay out the grid and its rays for the intrinsics of an image.
+  void LayOut(const RangeImage& image);
+
+  bool InitializeGL();
+
+  Options options_;
+  glm::vec4 color_;
+  glm::vec4 plane_;
+  float plane_distance_;
+
+  projection::CameraIntrinsics intrinsics_;
+  int cell_size_;
+  int grid_width_;
+  int grid_height_;
+  // Per node, the x and y of its ray at a depth of 1, and the indices of
+  // the grid triangles.
+  std::vector<GLfloat> rays_;
+  std::vector<GLushort> indices_;
+  // Per node depth as uploaded, negative or 0 for the nodes not kept.
+  std::vector<GLfloat> depths_;
+  // Per node scratch, the nearest depth of each block, then the depths
+  // filled in for the nodes not kept.
+  std::vector<GLfloat> raw_depths_;
+  size_t kept_node_count_;
+  // Set by Update() and LayOut(), cleared once uploaded.
+  bool are_depths_dirty_;
+  bool is_layout_dirty_;
+
+  VertexBuffer ray_buffer_;
+  VertexBuffer index_buffer_;
+  VertexBuffer depth_buffer_;
+
+  GLuint shader_program_;
+  GLint attrib_rays_;
+  GLint attrib_depths_;
+  GLint uniform_mvp_mat_;
+  GLint uniform_color_;
+  GLint uniform_plane_;
+  GLint uniform_plane_distance_;
+};
+}  // namespace tango_gl
+#endif  // TANGO_GL_RANGE_IMAGE_MESH_H_
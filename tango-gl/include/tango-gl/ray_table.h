@@ -0,0 +1,126 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_GL_RAY_TABLE_H_
+#define TANGO_GL_RAY_TABLE_H_
+
+#include <stdint.h>
+
+#include <functional>
+#include <vector>
+
+#include "tango-gl/point_projection.h"
+#include "tango-gl/util.h"
+
+namespace tango_gl {
+
+// RayTable holds the ray through every pixel of a camera image, so back
+// projecting a pixel with its depth is a multiply instead of a subtract and
+// divide per coordinate, plus undoing the lens distortion.
+//
+// Rays are given on the plane z = 1, (X / Z, Y / Z), since Tango depth is
+// the z coordinate and not the distance along the ray; the position of a
+// pixel is then (ray.x * depth, ray.y * depth, depth).
+//
+// A pinhole table is separable, a ray x per column and a ray y per row, so
+// it takes (width + height) floats. A table with lens distortion keeps a
+// ray per pixel. Build a table once per intrinsics, e.g. through
+// CameraIntrinsicsRegistry::GetRayTable(), reads are then thread safe.
+class RayTable {
+ public:
+  RayTable();
+
+  // Build the table of a pinhole camera.
+  //
+  // @param intrinsics: camera intrinsics, the table takes the image size.
+  // @param pixel_center: offset of the pixel centers from the integer pixel
+  //        positions, 0 where pixel x covers [x - 0.5, x + 0.5) like in
+  //        RangeImage, 0.5 where it covers [x, x + 1) like in
+  //        projection::ProjectPoints().
+  void Build(const projection::CameraIntrinsics& intrinsics,
+             float pixel_center);
+
+  // Build the table of a camera with lens distortion, a ray per pixel of its
+  // raw images, e.g. with CameraIntrinsicsRegistry::Undistort().
+  //
+  // @param undistort: maps the pinhole ray of a pixel, its distorted
+  //        position on the plane z = 1, to the undistorted ray.
+  void Build(const projection::CameraIntrinsics& intrinsics,
+             float pixel_center,
+             const std::function<glm::vec2(const glm::vec2&)>& undistort);
+
+  // Whether the last Build() was the pinhole table of these intrinsics, so
+  // per frame callers rebuild only when the camera changes.
+  bool IsBuiltFor(const projection::CameraIntrinsics& intrinsics,
+                  float pixel_center) const;
+
+  int GetWidth() const { return width_; }
+  int GetHeight() const { return height_; }
+
+  // Whether the table is a ray x per column and a ray y per row.
+  bool IsSeparable() const { return rays_.empty(); }
+
+  // Ray through a pixel inside the image.
+  glm::vec2 GetRay(int x, int y) const {
+    return IsSeparable() ? glm::vec2(column_rays_[x], row_rays_[y])
+                         : rays_[static_cast<size_t>(y) * width_ + x];
+  }
+
+  // Position of a pixel at a depth, in the camera frame.
+  glm::vec3 BackProject(int x, int y, float depth) const {
+    const glm::vec2 ray = GetRay(x, y);
+    return glm::vec3(ray.x * depth, ray.y * depth, depth);
+  }
+
+  // GetWidth() rays x of the columns and GetHeight() rays y of the rows of a
+  // separable table, for loops walking the image row by row.
+  const float* GetColumnRays() const { return column_rays_.data(); }
+  const float* GetRowRays() const { return row_rays_.data(); }
+
+  // Encode the table into GetWidth() * GetHeight() RGBA texels, row 0 at the
+  // top: red and green hold ray x, blue and alpha ray y, each as a 16 bit
+  // code, high byte first. A shader decodes with
+  //
+  //   vec2 code = vec2(dot(texel.rg, vec2(65280.0, 255.0)),
+  //                    dot(texel.ba, vec2(65280.0, 255.0)));
+  //   vec2 ray = decode.xy + decode.zw * code;
+  //
+  // @param texels: output, 4 bytes per pixel.
+  // @param decode: output, the ray of code 0 in xy and the ray step per
+  //        code in zw.
+  void Encode(std::vector<uint8_t>* texels, glm::vec4* decode) const;
+
+  // Upload the encoded table as a GL_RGBA texture with nearest filtering.
+  // Must be called on the GL thread, release the texture with
+  // RenderState::DeleteTextures().
+  //
+  // @param decode: output, see Encode().
+  // @return the texture, 0 for an empty table.
+  GLuint CreateTexture(glm::vec4* decode) const;
+
+ private:
+  int width_;
+  int height_;
+  projection::CameraIntrinsics intrinsics_;
+  float pixel_center_;
+  std::vector<float> column_rays_;
+  std::vector<float> row_rays_;
+  // Row major rays of a table with distortion, empty if separable.
+  std::vector<glm::vec2> rays_;
+};
+}  // namespace tango_gl
+#endif  // TANGO_GL_RAY_TABLE_H_
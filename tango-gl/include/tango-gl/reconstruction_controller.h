@@ -0,0 +1,201 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_GL_RECONSTRUCTION_CONTROLLER_H_
+#define TANGO_GL_RECONSTRUCTION_CONTROLLER_H_
+
+#include <tango_client_api.h>
+
+#include "tango-gl/frame_profiler.h"
+#include "tango-gl/motion_gate.h"
+#include "tango-gl/rigid_transform.h"
+
+namespace tango_gl {
+
+// ReconstructionController runs the experimental scene reconstruction of the
+// Tango service only while it is worth the CPU the renderer needs. Update()
+// polls TangoService_Experimental_getReconstructionMetadata() every
+// metadata_interval and reads the frame times from a FrameProfiler zone, like
+// QualityGovernor, then stops the reconstruction when:
+//  - the device has been still for still_duration: nothing new is seen. It
+//    restarts once the device reaches new territory, i.e. moved or turned
+//    past the resume thresholds from where it paused, or left the bounding
+//    box of the reconstruction.
+//  - the frame time percentile exceeds pause_ratio times the target. It
+//    restarts once the percentile is back under resume_ratio times the
+//    target for resume_delay. The delay doubles each time the
+//    reconstruction had to be paused again within the delay after
+//    restarting, so it does not oscillate.
+//  - the volumes take more than max_volume_memory. Only Reset() restarts it.
+// Stopping keeps the reconstruction, the service just ignores new depth.
+//
+// The controller also paces what the renderer takes in: ShouldExtractMesh()
+// spaces TangoService_Experimental_extractMesh() calls by mesh_interval and
+// only allows them when volumes changed and the frames are within budget,
+// and GetSegmentBudget() is the number of mesh segments to refresh per
+// frame, e.g. for SegmentedMesh::Update(), halved on every frame over budget
+// and grown by one on every frame within it.
+//
+// All functions must be called on the thread that calls Update(), e.g. the
+// GL thread; the service calls only take a round trip to the service.
+class ReconstructionController {
+ public:
+  enum State {
+    // Not started, or stopped by Stop().
+    kStopped,
+    kRunning,
+    kPausedStill,
+    kPausedFrameTime,
+    kPausedMemory,
+  };
+
+  struct Options {
+    Options()
+        : target_frame_ms(1000.0f / 30.0f),
+          zone("frame"),
+          percentile(0.9f),
+          pause_ratio(1.1f),
+          resume_ratio(0.8f),
+          min_sample_count(30),
+          resume_delay(1.0),
+          max_volume_memory(128 << 20),
+          metadata_interval(0.5),
+          still_duration(2.0),
+          still_translation(0.02f),
+          still_rotation(0.035f),
+          resume_translation(0.25f),
+          resume_rotation(0.26f),
+          mesh_interval(2.0),
+          max_segment_budget(16) {}
+
+    // Frame time to hold, in milliseconds.
+    float target_frame_ms;
+    // Profiler zone measured against the target, a string literal.
+    const char* zone;
+    // Percentile of the zone CPU samples compared to the target.
+    float percentile;
+    // Thresholds relative to target_frame_ms.
+    float pause_ratio;
+    float resume_ratio;
+    // Samples the zone needs before it is compared.
+    size_t min_sample_count;
+    // Seconds within budget before resuming, before backoff.
+    double resume_delay;
+    // Bytes of reconstruction volumes allowed.
+    int64_t max_volume_memory;
+    // Seconds between two metadata queries.
+    double metadata_interval;
+    // Seconds the device stays still before pausing.
+    double still_duration;
+    // The device is still while it moved less than this in meters, and
+    // turned less than this in radians.
+    float still_translation;
+    float still_rotation;
+    // New territory is this far from where the reconstruction paused, in
+    // meters, or turned this much, in radians.
+    float resume_translation;
+    float resume_rotation;
+    // Seconds between two mesh extractions.
+    double mesh_interval;
+    // Largest segment budget, the budget it starts at.
+    int max_segment_budget;
+  };
+
+  explicit ReconstructionController(const Options& options = Options());
+  ReconstructionController(const ReconstructionController& other) = delete;
+  const ReconstructionController& operator=(const ReconstructionController&) =
+      delete;
+
+  // Start the reconstruction. The service must be connected with
+  // config_experimental_enable_scene_reconstruction.
+  TangoErrorType Start();
+
+  // Stop the reconstruction until the next Start(), keeping it.
+  TangoErrorType Stop();
+
+  // Clear the reconstruction, which also ends a memory pause.
+  TangoErrorType Reset();
+
+  // Evaluate the metadata, motion and frame times, once per frame.
+  //
+  // @param device_pose: start of service to device pose at the timestamp.
+  // @param timestamp: pose timestamp, in seconds.
+  // @param profiler: profiler of the rendered frames, nullptr to ignore the
+  //        frame times.
+  // @return true if the state changed.
+  bool Update(const RigidTransform& device_pose, double timestamp,
+              FrameProfiler* profiler);
+
+  // Whether a mesh extraction is due at a timestamp.
+  bool ShouldExtractMesh(double timestamp) const;
+
+  // Extract the whole mesh, restarting the mesh interval.
+  TangoErrorType ExtractMesh(double timestamp, TangoMesh_Experimental* mesh);
+
+  // Mesh segments the renderer should refresh this frame.
+  int GetSegmentBudget() const { return segment_budget_; }
+
+  State GetState() const { return state_; }
+
+  // Whether the service is reconstructing.
+  bool IsRunning() const { return state_ == kRunning; }
+
+  // Last metadata polled, zero before the first poll.
+  const TangoReconstructionMetadata_Experimental& GetMetadata() const {
+    return metadata_;
+  }
+
+  // Name of a state, e.g. "paused_still".
+  static const char* GetStateName(State state);
+
+ private:
+  // Stop the service reconstructing and enter a paused state.
+  void Pause(State state, const RigidTransform& device_pose, double timestamp);
+
+  // Restart the service after a pause.
+  void Resume(double timestamp);
+
+  // Whether the device reached what was not reconstructed at the pause.
+  bool IsNewTerritory(const RigidTransform& device_pose) const;
+
+  void PollMetadata(double timestamp);
+
+  const Options options_;
+  State state_;
+  int segment_budget_;
+
+  TangoReconstructionMetadata_Experimental metadata_;
+  double last_metadata_time_;
+  // Volumes changed since the last mesh extraction.
+  bool has_new_volumes_;
+  double last_mesh_time_;
+  bool is_over_frame_budget_;
+
+  MotionGate motion_gate_;
+  // Timestamp the device last moved at.
+  double still_since_;
+
+  RigidTransform pause_pose_;
+  // Timestamp of the last resume from a frame time pause.
+  double resume_time_;
+  // Timestamp since the frames have been within budget while paused.
+  double within_budget_since_;
+  // Seconds within budget before resuming from a frame time pause.
+  double resume_delay_;
+};
+}  // namespace tango_gl
+#endif  // TANGO_GL_RECONSTRUCTION_CONTROLLER_H_
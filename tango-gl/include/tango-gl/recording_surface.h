@@ -0,0 +1,106 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_GL_RECORDING_SURFACE_H_
+#define TANGO_GL_RECORDING_SURFACE_H_
+
+#include <stdint.h>
+
+#include <EGL/egl.h>
+
+#include "tango-gl/util.h"
+#include "tango-gl/vertex_buffer.h"
+
+struct ANativeWindow;
+
+namespace tango_gl {
+
+// RecordingSurface renders each finished frame a second time into an
+// ANativeWindow, usually the input surface of a MediaCodec video encoder, to
+// record what is on screen without a screen capture. The frame is copied on
+// the GPU from the surface it was drawn to, with glBlitFramebuffer on GLES3
+// and a texture copy and a textured quad on GLES2, letterboxed to the size
+// of the window. Nothing is read back to the CPU.
+//
+// The window gets an EGL surface of the config of the rendering context, and
+// the context is made current on it with the screen surface as the read
+// surface for the copy, so no second context and no cross context
+// synchronization is needed. The config has to have EGL_RECORDABLE_ANDROID,
+// e.g. chosen with it by the EGLConfigChooser of the GLSurfaceView.
+//
+// All functions must be called on the GL thread with the rendering context
+// current.
+class RecordingSurface {
+ public:
+  RecordingSurface();
+  RecordingSurface(const RecordingSurface& other) = delete;
+  const RecordingSurface& operator=(const RecordingSurface&) = delete;
+  ~RecordingSurface();
+
+  // Start recording into a window. Stops a recording in progress first.
+  //
+  // @param window: the window to record into, e.g. from
+  //        ANativeWindow_fromSurface() on the encoder input surface. A
+  //        reference is held until Stop().
+  // @return false if the config of the context is not recordable or no EGL
+  //         surface could be created for the window.
+  bool Start(ANativeWindow* window);
+
+  // Stop recording: destroy the EGL surface and release the window. The
+  // encoder may be signaled the end of its input stream afterwards.
+  void Stop();
+
+  bool IsRecording() const { return surface_ != EGL_NO_SURFACE; }
+
+  // Copy the frame drawn to the current draw surface into the window and
+  // queue it to the encoder. Call after the frame is complete and before
+  // the screen surface is swapped. Restores the current surfaces, the
+  // viewport and framebuffer 0.
+  //
+  // @param presentation_time_ns: time of the frame in nanoseconds, on a
+  //        monotonic clock.
+  // @return false if not recording or the frame could not be queued.
+  bool RecordFrame(int64_t presentation_time_ns);
+
+  // Release the GL objects of the GLES2 copy.
+  void Release();
+
+  // Forget the GL objects without deleting them. Use this when the GL
+  // context they belonged to has been destroyed.
+  void Invalidate();
+
+ private:
+  // Copy the read surface into the draw surface within a rectangle.
+  void CopyWithBlit(GLsizei source_width, GLsizei source_height, GLint x,
+                    GLint y, GLsizei width, GLsizei height);
+  void CopyWithTexture(GLsizei source_width, GLsizei source_height, GLint x,
+                       GLint y, GLsizei width, GLsizei height);
+
+  ANativeWindow* window_;
+  EGLDisplay display_;
+  EGLSurface surface_;
+
+  GLuint texture_;
+  GLsizei texture_width_;
+  GLsizei texture_height_;
+  GLuint shader_program_;
+  GLint attrib_vertices_;
+  GLint uniform_image_;
+  VertexBuffer vertex_buffer_;
+};
+}  // namespace tango_gl
+#endif  // TANGO_GL_RECORDING_SURFACE_H_
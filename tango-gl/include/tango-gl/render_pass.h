@@ -0,0 +1,111 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_GL_RENDER_PASS_H_
+#define TANGO_GL_RENDER_PASS_H_
+
+#include "tango-gl/util.h"
+
+namespace tango_gl {
+
+// RenderPass makes the passes of a frame explicit, so tile based GPUs, which
+// keep the framebuffer in on-chip tile memory while a pass draws, only move
+// the attachments between tile memory and DRAM when their contents matter.
+//
+// Begin() binds the framebuffer of a pass and says what to do with each of
+// its attachments before drawing: load the previous contents, clear them,
+// or neither when every pixel is drawn anyway. End() says what to keep:
+// attachments which are not read after the pass, typically depth, are
+// discarded with glInvalidateFramebuffer() on OpenGL ES 3 or
+// glDiscardFramebufferEXT() with GL_EXT_discard_framebuffer, so they are
+// never written back. Without either, don't care loads fall back to a
+// clear, which tilers do not load either, and discards are dropped.
+//
+// A frame should run all its offscreen passes before the pass on the window,
+// each once, so no framebuffer is bound again while its tiles were already
+// flushed. End() leaves the framebuffer bound; the next Begin() binds its
+// own, so there is no rebind of framebuffer 0 between two offscreen passes.
+//
+// All functions must be called on the GL thread.
+class RenderPass {
+ public:
+  // What happens to an attachment at the start of a pass.
+  enum LoadOp {
+    // Keep the contents, read back into tile memory on tilers.
+    kLoad,
+    // Clear to Options::clear_color, clear_depth or clear_stencil.
+    kClear,
+    // The pass draws every pixel, or the attachment is unused.
+    kDontCare
+  };
+
+  // What happens to an attachment at the end of a pass.
+  enum StoreOp {
+    // Write the contents back, e.g. a texture sampled by a later pass.
+    kStore,
+    // The contents are not needed after the pass.
+    kDiscard
+  };
+
+  struct Options {
+    Options()
+        : color_load(kClear),
+          depth_load(kClear),
+          stencil_load(kDontCare),
+          color_store(kStore),
+          depth_store(kDiscard),
+          stencil_store(kDiscard),
+          clear_color(0.0f, 0.0f, 0.0f, 0.0f),
+          clear_depth(1.0f),
+          clear_stencil(0) {}
+
+    LoadOp color_load;
+    LoadOp depth_load;
+    LoadOp stencil_load;
+    StoreOp color_store;
+    StoreOp depth_store;
+    StoreOp stencil_store;
+    glm::vec4 clear_color;
+    float clear_depth;
+    GLint clear_stencil;
+  };
+
+  RenderPass() = delete;
+
+  // Begin a pass, ending the current one first.
+  //
+  // @param framebuffer: framebuffer to draw into, 0 for the window.
+  // @param x, y, width, height: viewport of the pass. Clears cover the whole
+  //        framebuffer, which is what lets a tiler skip the load.
+  static void Begin(GLuint framebuffer, GLint x, GLint y, GLsizei width,
+                    GLsizei height, const Options& options);
+  static void Begin(GLuint framebuffer, GLsizei width, GLsizei height,
+                    const Options& options) {
+    Begin(framebuffer, 0, 0, width, height, options);
+  }
+
+  // End the current pass, discarding the attachments of kDiscard.
+  static void End();
+
+  // Whether a pass is between Begin() and End().
+  static bool IsInPass();
+
+  // Whether attachments can be invalidated, see the class comment.
+  static bool HasInvalidate();
+};
+}  // namespace tango_gl
+#endif  // TANGO_GL_RENDER_PASS_H_
@@ -0,0 +1,175 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_GL_RENDER_SCHEDULER_H_
+#define TANGO_GL_RENDER_SCHEDULER_H_
+
+#include <EGL/egl.h>
+#include <jni.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+struct ALooper;
+
+namespace tango_gl {
+
+// RenderScheduler turns the data availability callbacks of the Tango service
+// into on demand render requests, at most one per display vsync.
+//
+// Signal() can be called from any callback thread as often as data arrives.
+// A scheduler thread waits for the next vsync, using AChoreographer where the
+// platform has it and a 60Hz timer otherwise, and then asks the Java layer to
+// render once for all the signals since the previous request. The scheduler
+// thread stays attached to the Java VM, so requests cost no JNI attach.
+//
+// With a target frame rate below the display rate, e.g. 30Hz to match the
+// color camera, requests are also paced to one per frame period. Each frame
+// is then given a presentation time at the vsync closing its period with
+// eglPresentationTimeANDROID, and the swap interval is set to the number of
+// vsyncs per frame, so frames are shown at a steady cadence even when they
+// finish early. A frame finishing after that vsync is counted as janky.
+class RenderScheduler {
+ public:
+  // Kinds of newly available data, counted separately in the statistics.
+  enum SignalSource {
+    kTextureAvailable = 0,
+    kPoseAvailable,
+    kDepthAvailable,
+    kSignalSourceCount
+  };
+
+  struct Stats {
+    // Signals received per SignalSource.
+    uint64_t signals[kSignalSourceCount];
+    // Render requests sent to the Java layer.
+    uint64_t requests;
+    // Frames reported by OnFrameRendered().
+    uint64_t frames;
+    // Vsyncs with new data that passed while the previous frame was still
+    // being rendered.
+    uint64_t dropped_frames;
+    // Frames reported rendered after the vsync they were due at, each shown
+    // one frame period late.
+    uint64_t janky_frames;
+    // Measured display vsync period.
+    int64_t vsync_period_ns;
+    // Whether vsyncs come from AChoreographer rather than the fallback timer.
+    bool uses_choreographer;
+  };
+
+  // Called on the scheduler thread to request one render, e.g. by calling
+  // GLSurfaceView.requestRender() through the environment.
+  typedef std::function<void(JNIEnv* env)> RequestRenderFunction;
+
+  RenderScheduler();
+  RenderScheduler(const RenderScheduler& other) = delete;
+  const RenderScheduler& operator=(const RenderScheduler&) = delete;
+  ~RenderScheduler();
+
+  // Start the scheduler thread.
+  //
+  // @param java_vm: Java VM the scheduler thread is attached to.
+  // @param request_render: function requesting a render.
+  // @return false if the thread is already running or failed to start.
+  bool Start(JavaVM* java_vm, const RequestRenderFunction& request_render);
+
+  // Stop the scheduler thread, waiting for a running request to return.
+  void Stop();
+
+  // Report newly available data, a render is requested at the next vsync.
+  // Can be called from any thread.
+  void Signal(SignalSource source);
+
+  // Render at most frames_per_second frames per second, rounded to a whole
+  // number of vsyncs per frame. 0, the default, renders at the display rate.
+  // Can be called from any thread.
+  void SetTargetFrameRate(int frames_per_second);
+
+  // Report that the requested frame was rendered, called from the GL thread
+  // at the end of rendering, before the frame is swapped. Until then no
+  // further request is sent. Also sets the presentation time and swap
+  // interval of the current EGL surface when pacing to a target rate.
+  void OnFrameRendered();
+
+  // Time the requested frame is due to be shown at, on the steady clock: the
+  // vsync closing its frame period. A frame still rendering past it is shown
+  // a frame period late. Called from the GL thread before OnFrameRendered().
+  //
+  // @return: the due time in nanoseconds, 0 if the frame was not requested
+  //          by the scheduler.
+  int64_t GetFrameDeadlineNs() const;
+
+  Stats GetStats() const;
+
+ private:
+  void ThreadLoop();
+
+  // Request a render if there is new data, no frame in flight and the
+  // target frame period since the previous request passed.
+  //
+  // @param vsync_time_ns: time of the vsync on the steady clock.
+  void OnVsync(int64_t vsync_time_ns);
+
+  // Vsyncs per frame at the target frame rate, at least 1.
+  int GetVsyncsPerFrame() const;
+
+  // AChoreographer frame callback, data is the scheduler.
+  static void FrameCallback(long frame_time_nanos, void* data);
+
+  JavaVM* java_vm_;
+  JNIEnv* env_;
+  RequestRenderFunction request_render_;
+  std::thread thread_;
+
+  // Guards looper_ and is_running_, and the fallback timer's wait.
+  std::mutex mutex_;
+  std::condition_variable state_changed_;
+  bool is_running_;
+  ALooper* looper_;
+
+  std::atomic<bool> is_stopping_;
+  std::atomic<bool> has_new_data_;
+  std::atomic<bool> is_frame_in_flight_;
+  std::atomic<bool> uses_choreographer_;
+
+  std::atomic<int> target_frame_rate_;
+  std::atomic<int64_t> vsync_period_ns_;
+  // Vsync time the frame in flight was requested at.
+  std::atomic<int64_t> request_vsync_time_ns_;
+
+  // Only used on the scheduler thread.
+  bool is_frame_callback_posted_;
+  int64_t last_request_time_ns_;
+  int64_t last_vsync_time_ns_;
+
+  // Only used on the GL thread.
+  EGLSurface paced_surface_;
+  int swap_interval_;
+
+  std::atomic<uint64_t> signals_[kSignalSourceCount];
+  std::atomic<uint64_t> requests_;
+  std::atomic<uint64_t> frames_;
+  std::atomic<uint64_t> dropped_frames_;
+  std::atomic<uint64_t> janky_frames_;
+};
+}  // namespace tango_gl
+#endif  // TANGO_GL_RENDER_SCHEDULER_H_
@@ -0,0 +1,86 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TANGO_GL_RENDER_STATE_H_
+#define TANGO_GL_RENDER_STATE_H_
+
+#include "tango-gl/util.h"
+
+namespace tango_gl {
+
+// RenderState shadows the GL state drawables change most often, the current
+// program, buffer and texture bindings, enabled capabilities and line width,
+// and drops calls that would not change it. Drawables can then set the state
+// they need without resetting it afterwards.
+//
+// The shadow is only right if every change to the tracked state goes through
+// RenderState, including the deletion of bound buffers and textures. Call
+// Invalidate() after creating a GL context and after any code that changes
+// the tracked state directly; BeginFrame() also does it when the current
+// context changed.
+//
+// All functions must be called on the GL thread.
+class RenderState {
+ public:
+  RenderState() = delete;
+
+  // Start a new frame: reset the redundant call counter, the frame arena of
+  // the GL thread, and the shadow if the current EGL context changed since
+  // the last frame. Also where GL errors are sampled and, in debug builds,
+  // GL_KHR_debug output enabled, see util::SampleGlErrors(), where the
+  // MemoryTracker budget is enforced and where the Counters frame closes.
+  static void BeginFrame();
+
+  // Forget the shadow, the next call for each piece of state goes to GL.
+  static void Invalidate();
+
+  // Number of calls dropped since BeginFrame().
+  static int GetRedundantCallCount();
+
+  static void UseProgram(GLuint program);
+
+  // GL_ARRAY_BUFFER, GL_ELEMENT_ARRAY_BUFFER and GL_PIXEL_UNPACK_BUFFER are
+  // shadowed, other targets always reach GL.
+  static void BindBuffer(GLenum target, GLuint buffer);
+
+  // Texture bindings are shadowed per texture unit for GL_TEXTURE_2D and
+  // GL_TEXTURE_EXTERNAL_OES.
+  static void ActiveTexture(GLenum texture_unit);
+  static void BindTexture(GLenum target, GLuint texture);
+
+  // GL_BLEND, GL_CULL_FACE, GL_DEPTH_TEST, GL_SCISSOR_TEST and
+  // GL_STENCIL_TEST are shadowed, other capabilities always reach GL.
+  static void Enable(GLenum capability);
+  static void Disable(GLenum capability);
+
+  static void LineWidth(GLfloat width);
+
+  // Delete buffers and textures, unbinding them in the shadow like GL does
+  // and untracking them from MemoryTracker.
+  static void DeleteBuffers(GLsizei count, const GLuint* buffers);
+  static void DeleteTextures(GLsizei count, const GLuint* textures);
+
+  // Vertex array objects, from OpenGL ES 3 or GL_OES_vertex_array_object.
+  // The vertex array binding is shadowed; changing it also changes the
+  // GL_ELEMENT_ARRAY_BUFFER binding, which the shadow then forgets. Use
+  // VertexArray rather than these directly.
+  static bool HasVertexArrays();
+  static void GenVertexArrays(GLsizei count, GLuint* arrays);
+  static void BindVertexArray(GLuint array);
+  static void DeleteVertexArrays(GLsizei count, const GLuint* arrays);
+};
+}  // namespace tango_gl
+#endif  // TANGO_GL_RENDER_STATE_H_
@@ -0,0 +1,89 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_GL_RIGID_TRANSFORM_H_
+#define TANGO_GL_RIGID_TRANSFORM_H_
+
+#define GLM_FORCE_RADIANS
+
+#include <stddef.h>
+
+#include "glm/glm.hpp"
+#include "glm/gtc/quaternion.hpp"
+
+namespace tango_gl {
+
+// RigidTransform is a rotation followed by a translation, the form of every
+// Tango pose and extrinsics transformation. Unlike a general glm::mat4, it
+// inverts by conjugating the rotation, and composes without a 4x4 product.
+//
+// Following the naming used across the examples, A_T_B maps points expressed
+// in frame B to frame A.
+class RigidTransform {
+ public:
+  // Identity transformation.
+  RigidTransform() : rotation_(1.0f, 0.0f, 0.0f, 0.0f), translation_(0.0f) {}
+
+  // @param rotation: unit quaternion of the rotation A_R_B.
+  // @param translation: position of B_origin from A_origin, expressed in A.
+  RigidTransform(const glm::quat& rotation, const glm::vec3& translation)
+      : rotation_(rotation), translation_(translation) {}
+
+  // Convert a matrix known to be rigid, e.g. one built from poses.
+  static RigidTransform FromMatrix(const glm::mat4& A_T_B);
+
+  const glm::quat& GetRotation() const { return rotation_; }
+  const glm::vec3& GetTranslation() const { return translation_; }
+
+  // @return B_T_A for this A_T_B.
+  RigidTransform Inverse() const {
+    const glm::quat inverse_rotation = glm::conjugate(rotation_);
+    return RigidTransform(inverse_rotation, inverse_rotation * -translation_);
+  }
+
+  // @return A_T_C = A_T_B * B_T_C.
+  RigidTransform operator*(const RigidTransform& B_T_C) const {
+    return RigidTransform(rotation_ * B_T_C.rotation_,
+                          rotation_ * B_T_C.translation_ + translation_);
+  }
+
+  // @return the point expressed in B, expressed in A.
+  glm::vec3 Apply(const glm::vec3& B_point) const {
+    return rotation_ * B_point + translation_;
+  }
+
+  // Transform packed x, y, z points. The rotation is converted to a matrix
+  // once for the whole batch.
+  //
+  // @param B_points: input points expressed in B.
+  // @param count: number of points.
+  // @param A_points: output points expressed in A, may alias B_points.
+  void Apply(const float* B_points, size_t count, float* A_points) const;
+
+  glm::mat4 ToMatrix() const;
+
+ private:
+  glm::quat rotation_;
+  glm::vec3 translation_;
+};
+
+// Invert a matrix known to be rigid by transposing its rotation, instead of
+// the general glm::inverse().
+glm::mat4 InverseRigidMatrix(const glm::mat4& A_T_B);
+
+}  // namespace tango_gl
+#endif  // TANGO_GL_RIGID_TRANSFORM_H_
@@ -0,0 +1,177 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TANGO_GL_SCENE_GRAPH_H_
+#define TANGO_GL_SCENE_GRAPH_H_
+
+#include <stdint.h>
+
+#include <utility>
+#include <vector>
+
+#include "tango-gl/bounding_box.h"
+#include "tango-gl/drawable_object.h"
+#include "tango-gl/view_frustum.h"
+
+namespace tango_gl {
+
+// SceneGraph replaces a hand ordered sequence of Render() calls with a draw
+// list. Drawables are added once with the pass they belong to; the list is
+// sorted by pass, shader program and texture when it changes, so a Render()
+// is one linear pass over it and consecutive drawables share as much GL
+// state as possible. Transparent drawables are drawn after the opaque ones,
+// back to front from the eye.
+//
+// Drawables keep their own Transform, whose world matrix is cached until it
+// or a parent changes, so a drawable that did not move costs no matrix
+// rebuild. Drawables given bounds are culled against the view frustum.
+//
+// RenderViews() draws the same list into several viewports, e.g. a first
+// person view with a top down inset. The list is sorted once and the
+// drawables' buffers are shared, only the viewport and the matrices change
+// between views.
+//
+// The graph does not own the drawables, they must be removed before they are
+// deleted. All functions must be called on the GL thread.
+class SceneGraph {
+ public:
+  enum Pass {
+    // Drawn first with identity matrices and the depth test disabled, e.g. a
+    // full screen camera image.
+    kBackground,
+    // Drawn with the depth test enabled.
+    kOpaque,
+    // Drawn last with the depth test enabled, farthest first.
+    kTransparent
+  };
+
+  // One viewport of RenderViews().
+  struct View {
+    // Viewport rectangle in window pixels, origin at the bottom left.
+    GLint x;
+    GLint y;
+    GLsizei width;
+    GLsizei height;
+    glm::mat4 projection_mat;
+    glm::mat4 view_mat;
+    // Frustum of the view, already updated. Can be nullptr.
+    ViewFrustum* view_frustum;
+    // Whether the color buffer of the viewport is cleared to clear_color
+    // before drawing, e.g. for an inset over another view. The depth buffer
+    // of the viewport is always cleared.
+    bool is_color_cleared;
+    glm::vec4 clear_color;
+  };
+
+  // Largest number of views in one RenderViews().
+  static const size_t kMaxViewCount = 32;
+
+  SceneGraph();
+  SceneGraph(const SceneGraph& other) = delete;
+  const SceneGraph& operator=(const SceneGraph&) = delete;
+
+  // Add a drawable, or move it to another pass if already added. Adding a
+  // drawable again to the same pass is a no-op, so this can be called every
+  // frame.
+  void Add(const DrawableObject* drawable, Pass pass);
+
+  // Remove a drawable. No-op if it was not added.
+  void Remove(const DrawableObject* drawable);
+
+  // Remove all drawables.
+  void Clear();
+
+  // Skip a drawable in Render() without changing the draw list, e.g. an
+  // object only shown in some camera modes. Drawables are visible when
+  // added.
+  void SetVisible(const DrawableObject* drawable, bool is_visible);
+
+  // Cull a drawable against the view frustum passed to Render().
+  //
+  // @param bounds: bounding box in the drawable's model coordinates.
+  void SetBounds(const DrawableObject* drawable, const BoundingBox& bounds);
+
+  // Restrict a drawable to some of the views of RenderViews(), e.g. the
+  // device frustum shown in a top down inset but not in the first person
+  // view it would block. Render() draws as view 0.
+  //
+  // @param view_mask: bit i set to draw the drawable in view i. Drawables
+  //        are drawn in all views when added.
+  void SetViewMask(const DrawableObject* drawable, uint32_t view_mask);
+
+  // Sort the draw list again on the next Render(). Call this after a
+  // drawable changed its shader program or texture.
+  void Invalidate() { is_sorted_ = false; }
+
+  // Draw the visible drawables.
+  //
+  // @param projection_mat: projection matrix of the render camera.
+  // @param view_mat: view matrix of the render camera.
+  // @param view_frustum: frustum of the same camera, already updated, for
+  //        culling the drawables with bounds. Can be nullptr.
+  void Render(const glm::mat4& projection_mat, const glm::mat4& view_mat,
+              ViewFrustum* view_frustum);
+
+  // Draw the visible drawables into each view in turn. The scissor test is
+  // disabled and the viewport left at the last view on return.
+  //
+  // @param views: views to draw, at most kMaxViewCount.
+  // @param view_count: number of views.
+  void RenderViews(const View* views, size_t view_count);
+
+  // Number of drawables in the graph.
+  size_t GetSize() const { return nodes_.size(); }
+
+  // Number of drawables drawn by the last Render() or RenderViews(), summed
+  // over the views.
+  size_t GetDrawnCount() const { return drawn_count_; }
+
+ private:
+  struct Node {
+    const DrawableObject* drawable;
+    Pass pass;
+    bool is_visible;
+    bool has_bounds;
+    BoundingBox bounds;
+    uint32_t view_mask;
+    // Pass, program and texture, in order of significance.
+    uint64_t sort_key;
+  };
+
+  // Index of the node of a drawable, nodes_.size() if it was not added.
+  size_t Find(const DrawableObject* drawable) const;
+
+  // Whether a node is to be drawn in the current frame.
+  bool IsDrawn(const Node& node, ViewFrustum* view_frustum,
+               uint32_t view_bit) const;
+
+  // Draw the list once with the given matrices, adding to drawn_count_.
+  void RenderView(const glm::mat4& projection_mat, const glm::mat4& view_mat,
+                  ViewFrustum* view_frustum, uint32_t view_bit);
+
+  void Sort();
+
+  std::vector<Node> nodes_;
+  bool is_sorted_;
+
+  // Indices of the transparent nodes of the current frame, with their
+  // squared distance to the eye. Kept to avoid allocating every frame.
+  std::vector<std::pair<float, size_t>> transparent_nodes_;
+
+  size_t drawn_count_;
+};
+}  // namespace tango_gl
+#endif  // TANGO_GL_SCENE_GRAPH_H_
@@ -0,0 +1,150 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_GL_SEGMENTED_MESH_H_
+#define TANGO_GL_SEGMENTED_MESH_H_
+
+#include <stdint.h>
+
+#include <atomic>
+#include <limits>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <tango_client_api.h>
+
+#include "tango-gl/color.h"
+#include "tango-gl/mesh.h"
+#include "tango-gl/util.h"
+#include "tango-gl/view_frustum.h"
+
+namespace tango_gl {
+
+// SegmentedMesh draws the reconstruction reported through
+// TangoService_Experimental_connectOnMeshVectorAvailable. The service splits
+// the mesh into segments on a fixed grid and only reports the segments that
+// changed, so the mesh keeps one lit tango_gl::Mesh per grid index and only
+// re-uploads the buffers of the reported segments.
+//
+// The callback thread converts the segments to GL friendly arrays and hands
+// them to the GL thread through a lock-free list of batches: no batch is
+// dropped, and a segment reported several times between two frames is only
+// uploaded once. Batches are recycled, so steady state callbacks do not
+// allocate once the arrays reached their largest size.
+//
+// Vertex colors are ignored, the mesh is drawn in one color. Segments without
+// normals get area weighted vertex normals computed on the callback thread.
+class SegmentedMesh {
+ public:
+  SegmentedMesh();
+  SegmentedMesh(const SegmentedMesh& other) = delete;
+  const SegmentedMesh& operator=(const SegmentedMesh&) = delete;
+  ~SegmentedMesh();
+
+  // Producer side, call from the mesh vector callback. The segments are
+  // copied, they may be released when the function returns.
+  //
+  // @param segment_count: number of segments in the array.
+  // @param segments: segments reported by the service. A segment without
+  //        faces removes the segment at its index.
+  void OnMeshVectorAvailable(int segment_count,
+                             const TangoMesh_Experimental* segments);
+
+  // GL thread. Upload the segments reported since the last call.
+  //
+  // @return: number of segments that were uploaded or removed.
+  int Update() { return Update(std::numeric_limits<int>::max()); }
+
+  // GL thread. Upload at most max_update_count of the segments reported and
+  // not uploaded yet, e.g. the budget of a ReconstructionController. The
+  // others wait for the next calls, replaced by any newer report of their
+  // index meanwhile.
+  //
+  // @return: number of segments that were uploaded or removed.
+  int Update(int max_update_count);
+
+  // GL thread. Drop every segment, including the ones not uploaded yet.
+  void Clear();
+
+  void SetColor(const Color& color);
+
+  // GL thread. Draw every segment inside the view frustum.
+  //
+  // @param view_frustum: view frustum of the render camera, in the frame of
+  //        the segments. May be nullptr to draw every segment.
+  void Render(const glm::mat4& projection_mat, const glm::mat4& view_mat,
+              ViewFrustum* view_frustum) const;
+
+  size_t GetSegmentCount() const { return segments_.size(); }
+
+  // Hash key of a segment grid index.
+  static uint64_t SegmentKey(const int32_t index[3]);
+
+ private:
+  // A segment converted on the callback thread.
+  struct SegmentData {
+    int32_t index[3];
+    std::vector<GLfloat> vertices;
+    std::vector<GLfloat> normals;
+    std::vector<GLushort> indices;
+    glm::vec3 min;
+    glm::vec3 max;
+    // Uploaded, or replaced by a newer report.
+    bool is_done;
+  };
+
+  // The segments of one callback, linked into the pending or free list.
+  struct Batch {
+    std::vector<SegmentData> segments;
+    size_t segment_count;
+    Batch* next;
+  };
+
+  struct Segment {
+    std::unique_ptr<Mesh> mesh;
+    glm::vec3 min;
+    glm::vec3 max;
+  };
+
+  // Fill data from a service segment.
+  //
+  // @return: false if the segment has no faces or cannot be drawn with 16 bit
+  //          indices.
+  static bool ConvertSegment(const TangoMesh_Experimental& segment,
+                             SegmentData* data);
+
+  static void DeleteList(Batch* head);
+
+  // Batches published by the producer, newest first.
+  std::atomic<Batch*> pending_;
+  // Batches handed back by the consumer for reuse.
+  std::atomic<Batch*> free_;
+  // Only touched by the producer, batches taken from free_.
+  Batch* producer_free_;
+  // Only touched by the consumer, batches taken from pending_ with segments
+  // left for the next Update(), newest first.
+  Batch* held_;
+
+  Color color_;
+  std::unordered_map<uint64_t, Segment> segments_;
+  // Keys already updated by the current Update(), kept to reuse its storage.
+  std::unordered_set<uint64_t> updated_keys_;
+};
+}  // namespace tango_gl
+#endif  // TANGO_GL_SEGMENTED_MESH_H_
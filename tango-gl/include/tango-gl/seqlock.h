@@ -0,0 +1,87 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_GL_SEQLOCK_H_
+#define TANGO_GL_SEQLOCK_H_
+
+#include <stdint.h>
+#include <string.h>
+
+#include <atomic>
+
+namespace tango_gl {
+
+// Lock-free single writer, multiple reader snapshot of a small plain old data
+// value, e.g. the latest pose of a Tango Service callback.
+//
+// The writer never waits. A reader copies the value and retries if a store
+// ran at the same time, so it always sees a complete snapshot. The value is
+// kept as relaxed atomic words, so a torn read is detectable instead of
+// undefined behavior. T must be trivially copyable.
+template <typename T>
+class SeqLock {
+ public:
+  SeqLock() : sequence_(0) {
+    T value;
+    memset(&value, 0, sizeof(value));
+    Store(value);
+  }
+  SeqLock(const SeqLock& other) = delete;
+  const SeqLock& operator=(const SeqLock&) = delete;
+
+  // Writer side, only one thread may store.
+  void Store(const T& value) {
+    uint32_t words[kWordCount];
+    memcpy(words, &value, sizeof(T));
+
+    // An odd sequence tells readers a store is in progress.
+    uint32_t sequence = sequence_.load(std::memory_order_relaxed);
+    sequence_.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t i = 0; i < kWordCount; ++i) {
+      words_[i].store(words[i], std::memory_order_relaxed);
+    }
+    sequence_.store(sequence + 2, std::memory_order_release);
+  }
+
+  // Reader side, any thread.
+  T Load() const {
+    uint32_t words[kWordCount];
+    uint32_t begin_sequence;
+    uint32_t end_sequence;
+    do {
+      begin_sequence = sequence_.load(std::memory_order_acquire);
+      for (size_t i = 0; i < kWordCount; ++i) {
+        words[i] = words_[i].load(std::memory_order_relaxed);
+      }
+      std::atomic_thread_fence(std::memory_order_acquire);
+      end_sequence = sequence_.load(std::memory_order_relaxed);
+    } while ((begin_sequence & 1) != 0 || begin_sequence != end_sequence);
+
+    T value;
+    memcpy(&value, words, sizeof(T));
+    return value;
+  }
+
+ private:
+  static const size_t kWordCount = (sizeof(T) + 3) / 4;
+
+  std::atomic<uint32_t> sequence_;
+  std::atomic<uint32_t> words_[kWordCount];
+};
+}  // namespace tango_gl
+#endif  // TANGO_GL_SEQLOCK_H_
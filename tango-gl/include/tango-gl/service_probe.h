@@ -0,0 +1,137 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_GL_SERVICE_PROBE_H_
+#define TANGO_GL_SERVICE_PROBE_H_
+
+#include <stdint.h>
+
+#include <string>
+
+namespace tango_gl {
+
+// ServiceProbe measures how the Tango service behaves on a device: how long
+// the synchronous calls into it take, and how late its callbacks arrive
+// after the sensor timestamp they carry. Both are kept as histograms, so a
+// slow tail shows up even when the mean looks fine.
+//
+// The probe is off by default and costs one relaxed load per call site
+// then. Once enabled with SetEnabled(), every sample adds to log-linear
+// buckets of microseconds, 4 per octave, with relaxed atomics, from any
+// thread. TelemetrySender sends the histograms to its server, and with
+// TANGO_GL_TRACING every sample is also a span of category "service" in the
+// trace.
+//
+// The callback latency assumes the sensor timestamps are seconds on the
+// boot clock, as on the Tango devices. An offset between the clocks shifts
+// the whole histogram, arrivals before their timestamp are counted apart;
+// the spread of the histogram, e.g. GetJitter(), is meaningful either way.
+class ServiceProbe {
+ public:
+  enum Source {
+    // Duration of TangoService_getPoseAtTime().
+    kGetPoseAtTime,
+    // Duration of TangoService_updateTexture().
+    kUpdateTexture,
+    // Duration of TangoService_getCameraIntrinsics().
+    kGetCameraIntrinsics,
+    // Arrival of onPoseAvailable() after the pose timestamp.
+    kPoseCallback,
+    // Arrival of onXYZijAvailable() after the depth timestamp.
+    kXyzIjCallback,
+    // Arrival of onFrameAvailable() after the image timestamp.
+    kFrameCallback,
+    kSourceCount
+  };
+
+  // Buckets 0 to 7 hold 0 to 7 microseconds, every octave above has 4, up
+  // to about 2 seconds. Longer samples land in the last bucket.
+  static const int kBucketCount = 80;
+
+  struct Histogram {
+    Histogram();
+
+    // Value in microseconds below which a fraction of the samples lies,
+    // e.g. 0.99, interpolated within its bucket. 0 without samples.
+    float GetPercentile(float percentile) const;
+
+    // Spread of the samples in microseconds, the 90th minus the 10th
+    // percentile.
+    float GetJitter() const;
+
+    uint64_t count;
+    uint64_t sum_us;
+    uint64_t max_us;
+    // Callbacks that arrived before their timestamp, counted in bucket 0.
+    uint64_t early_count;
+    uint32_t buckets[kBucketCount];
+  };
+
+  ServiceProbe() = delete;
+
+  static void SetEnabled(bool is_enabled);
+  static bool IsEnabled();
+
+  // Record a call that started at start_us, microseconds on the monotonic
+  // clock as from tracing::NowMicroseconds().
+  static void RecordCall(Source source, uint64_t start_us,
+                         uint64_t duration_us);
+
+  // Record the arrival of a callback, now.
+  //
+  // @param source: one of the callback sources.
+  // @param timestamp: sensor timestamp of the data, in seconds.
+  static void RecordCallback(Source source, double timestamp);
+
+  static Histogram GetHistogram(Source source);
+
+  // Forget all samples.
+  static void Reset();
+
+  // Bucket of a sample, and the smallest sample of a bucket.
+  static int GetBucket(uint64_t value_us);
+  static uint64_t GetBucketStart(int bucket);
+
+  // Name of a source, e.g. "get_pose_at_time".
+  static const char* GetName(Source source);
+
+  // The sources with samples, one per line, e.g.
+  // "update_texture n 1800 p50 0.21 ms p99 1.40 ms max 3.02 ms jitter 0.35
+  // ms".
+  static std::string GetReport();
+
+  // Record the enclosing scope as a call, when the probe is enabled:
+  //
+  //  {
+  //    ServiceProbe::ScopedCall probe(ServiceProbe::kUpdateTexture);
+  //    ret = TangoService_updateTexture(TANGO_CAMERA_COLOR, &timestamp);
+  //  }
+  class ScopedCall {
+   public:
+    explicit ScopedCall(Source source);
+    ScopedCall(const ScopedCall& other) = delete;
+    const ScopedCall& operator=(const ScopedCall&) = delete;
+    ~ScopedCall();
+
+   private:
+    Source source_;
+    // 0 when the probe was disabled.
+    uint64_t start_us_;
+  };
+};
+}  // namespace tango_gl
+#endif  // TANGO_GL_SERVICE_PROBE_H_
@@ -0,0 +1,154 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_GL_SESSION_FORMAT_H_
+#define TANGO_GL_SESSION_FORMAT_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <tango_client_api.h>
+
+namespace tango_gl {
+namespace session {
+
+// Layout of a recorded session file, written by SessionRecorder.
+//
+// The file starts with a FileHeader and is followed by chunks until the end of
+// the file. Chunks are only ever appended, so a file cut short by a crash is
+// valid up to its last complete chunk. Each chunk is
+//
+//   ChunkHeader | record (record_size bytes) | data (data_size bytes) |
+//   padding to the next multiple of kChunkAlignment
+//
+// The record is the fixed size description of a sample (e.g. PoseRecord)
+// and is never compressed, so a reader can index a session by type and
+// timestamp without touching the data. The data holds the points or pixels
+// of the sample, LZ4 block compressed (see tango-gl/lz4.h) if the chunk has
+// kCompressedFlag, or encoded with tango-gl/point_cloud_codec.h if it has
+// kPointCodecFlag. Video chunks hold one access unit of a compressed color
+// stream each, see VideoRecord. All values are little endian.
+
+const uint32_t kMagic = 0x53534754;  // "TGSS"
+// Version 2 added kPointCodecFlag, version 3 kVideoChunk. Readers accept
+// every version up to theirs.
+const uint32_t kVersion = 3;
+
+// Chunks start at multiples of this offset, so a reader mapping the file can
+// use the points of an uncompressed chunk in place.
+const size_t kChunkAlignment = 8;
+
+struct FileHeader {
+  uint32_t magic;
+  uint32_t version;
+};
+
+enum ChunkType : uint32_t {
+  kPoseChunk = 1,
+  kPointCloudChunk = 2,
+  kImageChunk = 3,
+  kVideoChunk = 4,
+};
+
+// The data is LZ4 compressed, raw_data_size is its decompressed size.
+const uint32_t kCompressedFlag = 1;
+// The data of a point cloud chunk is a point_cloud_codec frame,
+// raw_data_size is the size of the decoded floats. The decoded points are
+// quantized and in Morton order rather than in the recorded order.
+const uint32_t kPointCodecFlag = 2;
+// The data of a video chunk is codec configuration, e.g. the H.264 SPS and
+// PPS, which precedes the first frame of the stream.
+const uint32_t kVideoConfigFlag = 4;
+// The data of a video chunk is a key frame, decoding can start there.
+const uint32_t kVideoKeyFrameFlag = 8;
+
+struct ChunkHeader {
+  uint32_t type;
+  uint32_t flags;
+  uint32_t record_size;
+  uint32_t data_size;
+  uint32_t raw_data_size;
+  uint32_t reserved;
+  // Timestamp of the sample, in seconds.
+  double timestamp;
+};
+
+// A TangoPoseData, no data.
+struct PoseRecord {
+  double orientation[4];
+  double translation[3];
+  int32_t status_code;
+  int32_t base_frame;
+  int32_t target_frame;
+  int32_t reserved;
+};
+
+// A TangoXYZij, the data is xyz_count packed x, y, z floats.
+struct PointCloudRecord {
+  uint32_t xyz_count;
+  uint32_t reserved;
+};
+
+// A TangoImageBuffer, the data is GetImageDataSize() bytes of pixels.
+struct ImageRecord {
+  int32_t camera_id;
+  int32_t format;
+  uint32_t width;
+  uint32_t height;
+  uint32_t stride;
+  uint32_t reserved;
+  int64_t frame_number;
+};
+
+enum VideoCodec : uint32_t {
+  kH264Codec = 1,
+  kHevcCodec = 2,
+};
+
+// An encoded image, the data is one access unit of the codec in Annex B
+// byte stream format. The chunk timestamp is the one of the recorded image,
+// presentation_time_us is the timestamp the encoder was given, in
+// microseconds, and orders the frames for display.
+struct VideoRecord {
+  int32_t camera_id;
+  uint32_t codec;
+  uint32_t width;
+  uint32_t height;
+  int64_t frame_number;
+  int64_t presentation_time_us;
+};
+
+static_assert(sizeof(ChunkHeader) == 32, "ChunkHeader layout changed.");
+static_assert(sizeof(PoseRecord) == 72, "PoseRecord layout changed.");
+static_assert(sizeof(PointCloudRecord) == 8,
+              "PointCloudRecord layout changed.");
+static_assert(sizeof(ImageRecord) == 32, "ImageRecord layout changed.");
+static_assert(sizeof(VideoRecord) == 32, "VideoRecord layout changed.");
+
+// Size in bytes of the pixels of an image. YUV formats have a full
+// resolution luma plane followed by quarter resolution chroma.
+inline size_t GetImageDataSize(TangoImageFormatType format, uint32_t stride,
+                               uint32_t height) {
+  if (format == TANGO_HAL_PIXEL_FORMAT_RGBA_8888) {
+    return static_cast<size_t>(stride) * height * 4;
+  }
+  return static_cast<size_t>(stride) * height * 3 / 2;
+}
+
+}  // namespace session
+}  // namespace tango_gl
+#endif  // TANGO_GL_SESSION_FORMAT_H_
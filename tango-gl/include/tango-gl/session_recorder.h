@@ -0,0 +1,206 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_GL_SESSION_RECORDER_H_
+#define TANGO_GL_SESSION_RECORDER_H_
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <tango_client_api.h>
+
+#include "tango-gl/bounded_queue.h"
+#include "tango-gl/point_cloud_codec.h"
+#include "tango-gl/session_format.h"
+#include "tango-gl/video_encoder.h"
+
+namespace tango_gl {
+
+// SessionRecorder writes the pose, depth and color streams of a Tango session
+// to a file in the format described in tango-gl/session_format.h, so they
+// can be replayed without a device.
+//
+// The Record functions are meant to be called straight from the Tango
+// callbacks and never block: each stream owns a fixed set of slots allocated
+// by Start(), a sample is copied into a free slot and queued for a dedicated
+// I/O thread, which compresses and appends it. Slots and queues are lock-free,
+// when the I/O thread falls behind samples are dropped and counted instead of
+// stalling the callback.
+//
+// With a color_encoder, the NV21 color frames are encoded on the I/O thread
+// into video chunks instead, e.g. by the hardware H.264 encoder, so long
+// sessions fit the storage bandwidth. The chunks keep the timestamp and
+// frame number of their image, the replay stays aligned with depth and pose.
+class SessionRecorder {
+ public:
+  struct Options {
+    Options()
+        : compress_depth(true),
+          encode_depth(false),
+          depth_step(point_cloud_codec::kDefaultStep),
+          compress_images(false),
+          max_point_count(60000),
+          max_image_data_size(1280 * 720 * 3 / 2),
+          pose_slot_count(256),
+          point_cloud_slot_count(4),
+          image_slot_count(4),
+          write_buffer_size(1 << 20),
+          color_encoder(nullptr) {}
+
+    // LZ4 compress the data of depth and image chunks.
+    bool compress_depth;
+    // Encode depth chunks with tango-gl/point_cloud_codec.h instead, several
+    // times smaller than LZ4 but quantized to depth_step meters.
+    bool encode_depth;
+    float depth_step;
+    bool compress_images;
+    // Largest samples accepted, larger ones are dropped.
+    uint32_t max_point_count;
+    size_t max_image_data_size;
+    // Number of samples of each stream that can wait for the I/O thread.
+    int pose_slot_count;
+    int point_cloud_slot_count;
+    int image_slot_count;
+    // Size of the stdio buffer of the file.
+    size_t write_buffer_size;
+    // Encoder of the NV21 images of TANGO_CAMERA_COLOR, not owned, nullptr
+    // to store them as image chunks. It is started at the size of the first
+    // frame and finished by Stop(). If it fails to start, the frames are
+    // stored as image chunks.
+    VideoEncoder* color_encoder;
+  };
+
+  SessionRecorder();
+  SessionRecorder(const SessionRecorder& other) = delete;
+  const SessionRecorder& operator=(const SessionRecorder&) = delete;
+  ~SessionRecorder();
+
+  // Create the file, allocate the slots and start the I/O thread.
+  //
+  // @param path: file to write, replaced if it exists.
+  // @return: false if the file could not be created or a session is already
+  //          being recorded.
+  bool Start(const char* path, const Options& options);
+
+  // Stop accepting samples, write the queued ones and close the file.
+  void Stop();
+
+  bool IsRecording() const {
+    return is_recording_.load(std::memory_order_relaxed);
+  }
+
+  // Queue a sample. Can be called from any thread.
+  //
+  // @return: false if the sample was dropped, because no session is being
+  //          recorded, the sample is too large or the stream has no free
+  //          slot.
+  bool RecordPose(const TangoPoseData& pose);
+  bool RecordPointCloud(const TangoXYZij& cloud);
+  bool RecordImage(TangoCameraId camera_id, const TangoImageBuffer& image);
+
+  // Samples dropped since Start().
+  uint32_t GetDroppedCount() const {
+    return dropped_count_.load(std::memory_order_relaxed);
+  }
+
+  // Bytes appended to the file since Start().
+  uint64_t GetWrittenByteCount() const {
+    return written_byte_count_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  enum Stream { kPoseStream, kPointCloudStream, kImageStream, kStreamCount };
+
+  struct Slot {
+    session::ChunkHeader header;
+    // Record followed by the raw data, allocated for the largest sample.
+    std::vector<uint8_t> payload;
+    Stream stream;
+  };
+
+  // Claim a free slot of a stream, or count a drop and return -1. Must be
+  // called between BeginRecord() and EndRecord().
+  int AcquireSlot(Stream stream);
+
+  // Track the callbacks using the slots, so Stop() can wait for them.
+  bool BeginRecord();
+  void EndRecord() {
+    active_record_count_.fetch_sub(1, std::memory_order_release);
+  }
+
+  void WriteLoop();
+
+  // Compress and append a slot to the file.
+  void WriteSlot(Slot* slot);
+
+  // Hand an image to the color encoder.
+  //
+  // @return false if the image is not for the encoder, it is then written
+  //         as an image chunk.
+  bool EncodeImage(const session::ChunkHeader& header,
+                   const session::ImageRecord& record, const uint8_t* data);
+
+  // Append a packet of the color encoder as a video chunk.
+  void WritePacket(const VideoEncoder::Packet& packet);
+
+  // Write the last packets of the color encoder and stop it.
+  void FinishEncoding();
+
+  // Append a chunk and pad it to the chunk alignment.
+  void WriteChunk(const session::ChunkHeader& header, const void* record,
+                  const void* data);
+
+  bool WriteBytes(const void* data, size_t size);
+
+  Options options_;
+  std::vector<Slot> slots_;
+  std::unique_ptr<BoundedQueue<int>> free_slots_[kStreamCount];
+  std::unique_ptr<BoundedQueue<int>> ready_slots_;
+
+  // Only touched by the I/O thread.
+  FILE* file_;
+  std::vector<uint8_t> compressed_data_;
+  point_cloud_codec::Encoder point_encoder_;
+  bool has_write_error_;
+
+  // An image given to the color encoder whose packet has not come out yet.
+  struct PendingFrame {
+    int64_t presentation_time_us;
+    double timestamp;
+    int64_t frame_number;
+  };
+  bool is_encoding_;
+  bool has_encoder_failed_;
+  session::ImageRecord encoded_record_;
+  std::deque<PendingFrame> pending_frames_;
+  VideoEncoder::PacketCallback packet_callback_;
+
+  std::thread thread_;
+  std::atomic<bool> is_recording_;
+  std::atomic<bool> is_stopping_;
+  std::atomic<int> active_record_count_;
+  std::atomic<uint32_t> dropped_count_;
+  std::atomic<uint64_t> written_byte_count_;
+};
+}  // namespace tango_gl
+#endif  // TANGO_GL_SESSION_RECORDER_H_
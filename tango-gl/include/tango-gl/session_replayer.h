@@ -0,0 +1,200 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_GL_SESSION_REPLAYER_H_
+#define TANGO_GL_SESSION_REPLAYER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <tango_client_api.h>
+
+#include "tango-gl/rigid_transform.h"
+#include "tango-gl/session_format.h"
+
+namespace tango_gl {
+
+// SessionReplayer plays a file written by SessionRecorder back through the
+// same callbacks the Tango service would call, e.g. the routers an
+// application passes to TangoService_connectOnPoseAvailable(), so the
+// application can be run and benchmarked without a device.
+//
+// The file is memory mapped and indexed by Open(). Samples are delivered in
+// timestamp order on the thread calling Run() or on the thread started by
+// Start(). Uncompressed point clouds and images point straight into the
+// mapping, compressed ones are decompressed into buffers reused between
+// samples. As with the service, the sample passed to a callback is only
+// valid until it returns.
+//
+// Color frames recorded through a VideoEncoder come out as VideoPackets, in
+// their chunk order, for the application to decode.
+class SessionReplayer {
+ public:
+  // A video chunk, see session::VideoRecord.
+  struct VideoPacket {
+    TangoCameraId camera_id;
+    session::VideoCodec codec;
+    uint32_t width;
+    uint32_t height;
+    // Of the recorded image, -1 for codec configuration.
+    double timestamp;
+    int64_t frame_number;
+    int64_t presentation_time_us;
+    bool is_config;
+    bool is_key_frame;
+    const uint8_t* data;
+    size_t size;
+  };
+
+  // The callbacks to drive, any of them can be nullptr.
+  struct Callbacks {
+    Callbacks()
+        : context(nullptr),
+          on_pose_available(nullptr),
+          on_xyz_ij_available(nullptr),
+          on_frame_available(nullptr),
+          on_video_packet_available(nullptr) {}
+
+    void* context;
+    void (*on_pose_available)(void* context, const TangoPoseData* pose);
+    void (*on_xyz_ij_available)(void* context, const TangoXYZij* xyz_ij);
+    void (*on_frame_available)(void* context, TangoCameraId camera_id,
+                               const TangoImageBuffer* image);
+    void (*on_video_packet_available)(void* context,
+                                      const VideoPacket* packet);
+  };
+
+  SessionReplayer();
+  SessionReplayer(const SessionReplayer& other) = delete;
+  const SessionReplayer& operator=(const SessionReplayer&) = delete;
+  ~SessionReplayer();
+
+  // Map and index a session file. A file cut short is read up to its last
+  // complete chunk.
+  //
+  // @return: false if the file cannot be mapped or is not a session file.
+  bool Open(const char* path);
+
+  // Stop the replay and unmap the file.
+  void Close();
+
+  // Replay the whole session on the calling thread.
+  //
+  // @param speed: 1 for the recorded timing, 2 for twice as fast, 0 to
+  //        deliver samples back to back, which makes benchmarks
+  //        independent of the recorded timing.
+  void Run(const Callbacks& callbacks, double speed);
+
+  // Replay the session on a new thread, see Run().
+  //
+  // @return: false if no session is open or a replay is running.
+  bool Start(const Callbacks& callbacks, double speed);
+
+  // Stop the replay thread after the sample being delivered.
+  void Stop();
+
+  // True once every sample has been delivered, or the replay was stopped.
+  bool IsDone() const { return is_done_.load(std::memory_order_acquire); }
+
+  // Recorded pose of a frame pair, interpolated between the two recorded
+  // poses around the timestamp, like TangoService_getPoseAtTime().
+  //
+  // @param timestamp: time of the pose, or 0 for the latest pose delivered
+  //        by the replay.
+  // @param frame: pair of frames recorded with RecordPose().
+  // @param pose: output pose.
+  // @return: false if the pair was not recorded or the timestamp is outside
+  //          of its recorded poses. pose then has an invalid status.
+  bool GetPoseAtTime(double timestamp, const TangoCoordinateFramePair& frame,
+                     TangoPoseData* pose) const;
+
+  // Recorded poses of a frame pair at many timestamps, e.g. to align every
+  // recorded point cloud offline. The timestamps are merged with the
+  // recorded poses in one pass instead of a search each, and the poses are
+  // interpolated in batches, see pose_interpolation::Interpolate().
+  //
+  // @param timestamps: count timestamps, ascending for the single pass.
+  // @param frame: pair of frames recorded with RecordPose().
+  // @param poses: count output base_T_target transforms. Poses that cannot
+  //        be resolved are left untouched.
+  // @param is_valid: count output flags, set to 1 for the resolved poses
+  //        and 0 for timestamps outside of the recorded poses.
+  // @return: number of poses resolved.
+  size_t GetPosesAtTimes(const double* timestamps, size_t count,
+                         const TangoCoordinateFramePair& frame,
+                         RigidTransform* poses, uint8_t* is_valid) const;
+
+  size_t GetSampleCount() const { return samples_.size(); }
+  double GetStartTimestamp() const;
+  double GetEndTimestamp() const;
+
+ private:
+  // A chunk of the mapping, in replay order.
+  struct Sample {
+    double timestamp;
+    const session::ChunkHeader* header;
+  };
+
+  // Pointer to the record of a chunk.
+  template <typename T>
+  static const T* GetRecord(const session::ChunkHeader* header) {
+    return reinterpret_cast<const T*>(header + 1);
+  }
+
+  // Index the chunks of the mapping.
+  bool Index();
+
+  // Data of a chunk, decompressed into buffer if needed.
+  //
+  // @return: nullptr if the data is malformed.
+  const uint8_t* GetData(const session::ChunkHeader* header,
+                         std::vector<uint8_t>* buffer) const;
+
+  void Deliver(const Sample& sample, const Callbacks& callbacks);
+
+  static TangoPoseData ToPose(const session::ChunkHeader* header);
+  static RigidTransform ToTransform(const session::ChunkHeader* header);
+
+  static uint32_t GetFramePairKey(const TangoCoordinateFramePair& frame) {
+    return (static_cast<uint32_t>(frame.base) << 16) |
+           static_cast<uint32_t>(frame.target);
+  }
+
+  void* mapping_;
+  size_t mapping_size_;
+  std::vector<Sample> samples_;
+  // Valid recorded poses of each frame pair, in timestamp order.
+  std::unordered_map<uint32_t, std::vector<const session::ChunkHeader*>>
+      poses_;
+
+  // Only touched by the replaying thread.
+  std::vector<uint8_t> point_buffer_;
+  std::vector<uint8_t> image_buffer_;
+
+  std::thread thread_;
+  std::atomic<bool> is_stopping_;
+  std::atomic<bool> is_done_;
+  // Timestamp of the last delivered sample.
+  std::atomic<double> replay_timestamp_;
+};
+}  // namespace tango_gl
+#endif  // TANGO_GL_SESSION_REPLAYER_H_
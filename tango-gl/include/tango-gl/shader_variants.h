@@ -0,0 +1,117 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+
+#ifndef TANGO_GL_SHADER_VARIANTS_H_
+#define TANGO_GL_SHADER_VARIANTS_H_
+
+#include <stdint.h>
+
+#include <string>
+
+#include "tango-gl/util.h"
+
+namespace tango_gl {
+namespace shader_variants {
+
+// Shader variants compose the vertex shader of the drawables from one
+// template and a set of feature flags, each flag a #define in front of the
+// template, instead of a hand written shader per combination. A variant is
+// compiled on first use through program_cache, so it is shared and persisted
+// like any other program, and its uniform and attribute locations are
+// queried once and kept in a per variant table.
+//
+// All variants share the fragment shader, which outputs the varying color.
+//
+// Inputs of every variant: attribute vertex, and uniform mvp unless
+// kInstanced or kFrameConstants.
+enum Feature {
+  // Diffuse plus ambient lighting: attribute normal, uniforms lightVec, ambient
+  // (light color in rgb, ambient intensity in a) and mv (view with
+  // kInstanced, from the block with kFrameConstants).
+  kLighting = 1 << 0,
+  // Per vertex color attribute instead of the color uniform.
+  kVertexColor = 1 << 1,
+  // Constant point size in pixels: uniform point_size.
+  kPointSize = 1 << 2,
+  // Point sprites sized by distance, vertex.w is the world size of the point:
+  // uniforms point_scale and max_point_size.
+  kPointSprite = 1 << 3,
+  // Integer positions scaled by the vertex_scale uniform, e.g. for
+  // QuantizedColoredPoint.
+  kQuantizedPositions = 1 << 4,
+  // Model matrix and color from the per instance attributes model and
+  // instanceColor, with uniform vp instead of mvp; see DrawBatch.
+  kInstanced = 1 << 5,
+  // Camera matrices from the FrameConstants uniform block, and the model
+  // matrix from uniform model instead of mvp unless kInstanced; the
+  // variant is GLSL ES 3.00. Acquire() drops the feature on contexts
+  // without uniform buffers, check Variant::features for the path taken.
+  kFrameConstants = 1 << 6,
+  kFeatureMask = (1 << 7) - 1
+};
+
+enum Uniform {
+  kMvp,
+  kModel,
+  kVp,
+  kMv,
+  kView,
+  kColor,
+  kLightVec,
+  kPointSizeUniform,
+  kPointScale,
+  kMaxPointSize,
+  kVertexScale,
+  kAmbient,
+  kUniformCount
+};
+
+enum Attribute {
+  kVertexAttribute,
+  kColorAttribute,
+  kNormalAttribute,
+  kModelAttribute,
+  kInstanceColorAttribute,
+  kAttributeCount
+};
+
+// A compiled variant. Locations are -1 for inputs the variant does not use.
+struct Variant {
+  uint32_t features;
+  GLuint program;
+  GLint uniforms[kUniformCount];
+  GLint attributes[kAttributeCount];
+};
+
+// Sources of a variant, e.g. to pass to program_cache directly.
+std::string GetVertexShader(uint32_t features);
+std::string GetFragmentShader(uint32_t features);
+
+// Get the variant for a set of features, compiling it if no live program
+// exists yet. kFrameConstants variants get their block bound to
+// FrameConstants::kBindingPoint. Each successful call must be paired with a
+// program_cache::ReleaseProgram() of the variant program. The variant stays
+// valid until then. Must be called on the GL thread.
+//
+// @param features: bitwise or of Feature values.
+// @return the variant, or nullptr if compiling or linking failed.
+const Variant* Acquire(uint32_t features);
+
+}  // namespace shader_variants
+}  // namespace tango_gl
+#endif  // TANGO_GL_SHADER_VARIANTS_H_
@@ -21,12 +21,106 @@
 
 namespace tango_gl {
 namespace shaders {
-std::string GetBasicVertexShader();
-std::string GetBasicFragmentShader();
-std::string GetColorVertexShader();
+// Shaders of the special purpose drawables; the drawables sharing the
+// varying color fragment shader use shader_variants.
 std::string GetVideoOverlayVertexShader();
 std::string GetVideoOverlayFragmentShader();
-std::string GetShadedVertexShader();
+
+// Screen space text of TextOverlay, sampling the alpha of a glyph atlas.
+std::string GetTextVertexShader();
+std::string GetTextFragmentShader();
+
+// World space quads of SpriteBatch, sampling a TextureAtlas page tinted by
+// a per vertex color.
+std::string GetSpriteVertexShader();
+std::string GetSpriteFragmentShader();
+
+// Grid triangles of RangeImageMesh, back projected from a ray and a depth per
+// node. Triangles with a node not kept, of negative depth, are discarded.
+std::string GetRangeImageMeshVertexShader();
+std::string GetRangeImageMeshFragmentShader();
+
+// Full screen copy of DynamicResolutionTarget, the vertices are in normalized
+// device coordinates.
+std::string GetCompositeVertexShader();
+std::string GetCompositeFragmentShader();
+
+// Composite of DynamicResolutionTarget::CompositeReprojected(). The vertex
+// shader maps each screen corner through the 3x3 reprojection to homogeneous
+// coordinates of the target; outside the target the content is transparent.
+std::string GetReprojectionVertexShader();
+std::string GetReprojectionFragmentShader();
+
+// Downsampling passes of LightEstimator and CameraDownscaler, drawn with
+// the composite vertex shader. The average of 4 bilinear taps at +/- offset
+// around the pixel center, from the camera texture for the external variant.
+std::string GetDownsampleFragmentShader();
+std::string GetExternalDownsampleFragmentShader();
+
+// Grayscale downsampling of CameraDownscaler from the camera texture, drawn
+// with the composite vertex shader. Each output pixel packs 4 horizontally
+// adjacent gray pixels, pixel_width apart in texture coordinates, into its
+// RGBA channels; each gray pixel is the BT.601 luma of 4 taps as above.
+std::string GetExternalGrayDownsampleFragmentShader();
+
+// Footprint splats of CoverageMap, drawn with the composite vertex shader
+// and additive blending: each adds weight to the coverage texture.
+std::string GetCoverageSplatFragmentShader();
+
+// Heatmap of CoverageMap, drawn on its covered tiles. The vertices are x, z
+// on the ground at height; the coverage, in the red channel of the texture,
+// picks a color between low_color and high_color. Uncovered texels are
+// discarded.
+std::string GetCoverageVertexShader();
+std::string GetCoverageFragmentShader();
+
+// Grid and trajectory lines of Minimap, and its device marker. The vertices
+// are moved to normalized device coordinates by vertex * transform.xy +
+// transform.zw and drawn in a flat color.
+std::string GetMinimapVertexShader();
+std::string GetMinimapFragmentShader();
+
+// Composite of Minimap, drawn with the composite fragment shader: a full
+// viewport quad whose texture coordinates are vertex * transform.xy +
+// transform.zw, in the repeating map texture.
+std::string GetMinimapCompositeVertexShader();
+
+// Procedural grid of Grid, drawn on a square of half size fade_distance
+// around the camera. Cell coordinates are relative to origin, a grid line
+// near the camera, to stay precise far from the grid origin. Lines are
+// antialiased over one pixel and faded out with the distance and where
+// cells get too small to resolve. Needs GL_OES_standard_derivatives.
+std::string GetGridVertexShader();
+std::string GetGridFragmentShader();
+
+// Procedural ribbon of Band, GLSL ES 3.00. The vertices are generated from
+// gl_VertexID without attributes: two per centerline sample, offset to the
+// left and right across the path direction taken from the neighboring
+// samples, then the three corners of the arrow head past the last sample.
+// The samples are in the xyz of an RGBA32F texture, a ring of capacity
+// texels starting at first, read row by row.
+std::string GetRibbonVertexShader();
+std::string GetRibbonFragmentShader();
+
+// Transform feedback pass of GpuPointAccumulator, GLSL ES 3.00. Moves each
+// depth point into the world frame and captures it as world_position;
+// nothing is rasterized, the fragment shader only completes the program.
+std::string GetPointTransformVertexShader();
+std::string GetPointTransformFragmentShader();
+
+// Point splats of DepthOcclusion, writing the depth of each point in the
+// color camera frame in millimeters, high byte to blue and low byte to
+// alpha.
+std::string GetDepthSplatVertexShader();
+std::string GetDepthSplatFragmentShader();
+
+// Full screen depth writes of DepthOcclusion. The depth image is sampled at
+// the nearest texel, or upsampled across texels on the same side of a depth
+// edge by the edge aware variant. depth_transform maps the inverse depth to
+// normalized device z. Needs GL_EXT_frag_depth.
+std::string GetOcclusionVertexShader();
+std::string GetOcclusionFragmentShader();
+std::string GetEdgeAwareOcclusionFragmentShader();
 }  // namespace shaders
 }  // namespace tango_gl
 #endif  // TANGO_GL_SHADERS_H_
@@ -0,0 +1,173 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_GL_SIMD_MATH_H_
+#define TANGO_GL_SIMD_MATH_H_
+
+#include "glm/glm.hpp"
+
+// Building with TANGO_GL_SIMD_MATH routes tango-gl's per frame matrix math
+// through NEON intrinsics on ARM and glm's SSE2 simd types on x86. Without
+// it, or on targets without either, the scalar glm operators are used.
+//
+// The SIMD paths sum the four column products pairwise instead of in order,
+// so results can differ from the scalar path in the last bits of the
+// mantissa.
+#if defined(TANGO_GL_SIMD_MATH) && \
+    (defined(__ARM_NEON) || defined(__ARM_NEON__))
+#define TANGO_GL_SIMD_MATH_NEON
+#include <arm_neon.h>
+#elif defined(TANGO_GL_SIMD_MATH) && defined(__SSE2__)
+#define TANGO_GL_SIMD_MATH_SSE2
+#include "glm/gtx/simd_mat4.hpp"
+#include "glm/gtx/simd_vec4.hpp"
+#endif
+
+namespace tango_gl {
+namespace simd_math {
+
+#if defined(TANGO_GL_SIMD_MATH_NEON)
+namespace internal {
+// m * (x, y, z, w) for the columns of a matrix.
+inline float32x4_t MultiplyColumns(const float32x4_t columns[4],
+                                   float32x4_t v) {
+#if defined(__aarch64__)
+  float32x4_t x = vmulq_laneq_f32(columns[0], v, 0);
+  float32x4_t y = vmulq_laneq_f32(columns[1], v, 1);
+  float32x4_t z = vmulq_laneq_f32(columns[2], v, 2);
+  float32x4_t w = vmulq_laneq_f32(columns[3], v, 3);
+#else
+  float32x2_t low = vget_low_f32(v);
+  float32x2_t high = vget_high_f32(v);
+  float32x4_t x = vmulq_lane_f32(columns[0], low, 0);
+  float32x4_t y = vmulq_lane_f32(columns[1], low, 1);
+  float32x4_t z = vmulq_lane_f32(columns[2], high, 0);
+  float32x4_t w = vmulq_lane_f32(columns[3], high, 1);
+#endif
+  // Pairwise, as glm's SSE2 path does.
+  return vaddq_f32(vaddq_f32(x, y), vaddq_f32(z, w));
+}
+
+inline void LoadColumns(const glm::mat4& m, float32x4_t columns[4]) {
+  for (int i = 0; i < 4; ++i) {
+    columns[i] = vld1q_f32(&m[i][0]);
+  }
+}
+}  // namespace internal
+#endif
+
+// a * b. out may alias a or b.
+inline void Multiply(const glm::mat4& a, const glm::mat4& b, glm::mat4* out) {
+#if defined(TANGO_GL_SIMD_MATH_NEON)
+  float32x4_t a_columns[4];
+  float32x4_t b_columns[4];
+  internal::LoadColumns(a, a_columns);
+  internal::LoadColumns(b, b_columns);
+  for (int i = 0; i < 4; ++i) {
+    vst1q_f32(&(*out)[i][0],
+              internal::MultiplyColumns(a_columns, b_columns[i]));
+  }
+#elif defined(TANGO_GL_SIMD_MATH_SSE2)
+  *out = glm::mat4_cast(glm::simdMat4(a) * glm::simdMat4(b));
+#else
+  *out = a * b;
+#endif
+}
+
+inline glm::mat4 Multiply(const glm::mat4& a, const glm::mat4& b) {
+  glm::mat4 product;
+  Multiply(a, b, &product);
+  return product;
+}
+
+// m * (point, 1), without the perspective divide.
+inline glm::vec3 TransformPoint(const glm::mat4& m, const glm::vec3& point) {
+#if defined(TANGO_GL_SIMD_MATH_NEON)
+  float32x4_t columns[4];
+  internal::LoadColumns(m, columns);
+  const float homogeneous[4] = {point.x, point.y, point.z, 1.0f};
+  float result[4];
+  vst1q_f32(result,
+            internal::MultiplyColumns(columns, vld1q_f32(homogeneous)));
+  return glm::vec3(result[0], result[1], result[2]);
+#elif defined(TANGO_GL_SIMD_MATH_SSE2)
+  return glm::vec3(glm::vec4_cast(glm::simdMat4(m) *
+                                  glm::simdVec4(glm::vec4(point, 1.0f))));
+#else
+  return glm::vec3(m * glm::vec4(point, 1.0f));
+#endif
+}
+
+// m * (center +/- half_extents, 1) for the 8 corners of a box, without the
+// perspective divide. Corner i takes +half_extents along axis k when bit k of
+// i is set.
+inline void TransformBoxCorners(const glm::mat4& m, const glm::vec3& center,
+                                const glm::vec3& half_extents,
+                                glm::vec4 corners[8]) {
+#if defined(TANGO_GL_SIMD_MATH_NEON)
+  float32x4_t columns[4];
+  internal::LoadColumns(m, columns);
+  const float homogeneous[4] = {center.x, center.y, center.z, 1.0f};
+  const float32x4_t origin =
+      internal::MultiplyColumns(columns, vld1q_f32(homogeneous));
+  const float32x4_t axes[3] = {vmulq_n_f32(columns[0], half_extents.x),
+                               vmulq_n_f32(columns[1], half_extents.y),
+                               vmulq_n_f32(columns[2], half_extents.z)};
+  for (int i = 0; i < 8; ++i) {
+    float32x4_t corner = origin;
+    for (int k = 0; k < 3; ++k) {
+      corner = (i >> k) & 1 ? vaddq_f32(corner, axes[k])
+                            : vsubq_f32(corner, axes[k]);
+    }
+    vst1q_f32(&corners[i][0], corner);
+  }
+#elif defined(TANGO_GL_SIMD_MATH_SSE2)
+  const glm::simdVec4 origin =
+      glm::simdMat4(m) * glm::simdVec4(glm::vec4(center, 1.0f));
+  glm::simdVec4 axes[3] = {glm::simdVec4(m[0]), glm::simdVec4(m[1]),
+                           glm::simdVec4(m[2])};
+  for (int k = 0; k < 3; ++k) {
+    axes[k] *= half_extents[k];
+  }
+  for (int i = 0; i < 8; ++i) {
+    glm::simdVec4 corner = origin;
+    for (int k = 0; k < 3; ++k) {
+      if ((i >> k) & 1) {
+        corner += axes[k];
+      } else {
+        corner -= axes[k];
+      }
+    }
+    corners[i] = glm::vec4_cast(corner);
+  }
+#else
+  const glm::vec4 origin = m * glm::vec4(center, 1.0f);
+  const glm::vec4 axes[3] = {m[0] * half_extents.x, m[1] * half_extents.y,
+                             m[2] * half_extents.z};
+  for (int i = 0; i < 8; ++i) {
+    glm::vec4 corner = origin;
+    for (int k = 0; k < 3; ++k) {
+      corner += (i >> k) & 1 ? axes[k] : -axes[k];
+    }
+    corners[i] = corner;
+  }
+#endif
+}
+
+}  // namespace simd_math
+}  // namespace tango_gl
+#endif  // TANGO_GL_SIMD_MATH_H_
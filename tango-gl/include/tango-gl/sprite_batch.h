@@ -0,0 +1,111 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_GL_SPRITE_BATCH_H_
+#define TANGO_GL_SPRITE_BATCH_H_
+
+#include <vector>
+
+#include "tango-gl/texture_atlas.h"
+#include "tango-gl/util.h"
+#include "tango-gl/vertex_buffer.h"
+
+namespace tango_gl {
+
+// SpriteBatch draws the sprites of a TextureAtlas as textured quads in the
+// world, e.g. goal markers, labels and status icons of AR annotations. The
+// quads added since the last Render() are drawn together, one draw call and
+// one texture bind per atlas page, however many there are. Like TextOverlay,
+// vertices are only uploaded from the first one that changed, so a batch of
+// static annotations seen from a still camera uploads nothing.
+//
+// Quads are blended with the alpha of their image, with depth test but
+// without depth writes, in the order they were added within each page; add
+// them back to front if they overlap. Sprites not loaded yet are skipped.
+//
+// All functions must be called on the GL thread.
+class SpriteBatch {
+ public:
+  // @param atlas: atlas of the sprites, it must outlive the batch.
+  explicit SpriteBatch(const TextureAtlas* atlas);
+  SpriteBatch(const SpriteBatch& other) = delete;
+  const SpriteBatch& operator=(const SpriteBatch&) = delete;
+  ~SpriteBatch();
+
+  // Add a quad facing the camera.
+  //
+  // @param sprite: sprite of the atlas.
+  // @param position: center of the quad in world coordinates.
+  // @param size: width and height of the quad in meters.
+  // @param color: multiplied with the image.
+  void AddBillboard(int sprite, const glm::vec3& position,
+                    const glm::vec2& size,
+                    const glm::vec4& color = glm::vec4(1.0f));
+
+  // Add a quad with its own orientation, the square from (-0.5, -0.5) to
+  // (0.5, 0.5) of the xy plane, image top towards +y, moved by model_mat.
+  void AddQuad(int sprite, const glm::mat4& model_mat,
+               const glm::vec4& color = glm::vec4(1.0f));
+
+  // Draw the quads added since the last Render() and start a new batch.
+  void Render(const glm::mat4& projection_mat, const glm::mat4& view_mat);
+
+  // Number of quads added since the last Render().
+  size_t GetQuadCount() const { return quads_.size(); }
+
+  // Release the vertex buffer and the shader program.
+  void Release();
+
+  // Forget the GL objects without deleting them. Use this when the GL
+  // context they belonged to has been destroyed.
+  void Invalidate();
+
+ private:
+  struct Quad {
+    int sprite;
+    glm::vec3 center;
+    // Half extents of the quad, along its right and up directions. Zero for
+    // billboards until the camera is known.
+    glm::vec3 half_right;
+    glm::vec3 half_up;
+    glm::vec2 size;
+    glm::vec4 color;
+  };
+
+  // Create the program if needed.
+  bool InitializeGL();
+
+  const TextureAtlas* atlas_;
+  std::vector<Quad> quads_;
+
+  // Interleaved position, texture coordinates and color, six vertices per
+  // quad, grouped by page. vertices_ is the batch being built and
+  // uploaded_vertices_ mirrors the content of vertex_buffer_.
+  std::vector<GLfloat> vertices_;
+  std::vector<GLfloat> uploaded_vertices_;
+  // First vertex of each page in the batch, and one past the last.
+  std::vector<GLsizei> page_starts_;
+  VertexBuffer vertex_buffer_;
+
+  GLuint shader_program_;
+  GLint attrib_vertices_;
+  GLint attrib_texture_coords_;
+  GLint attrib_colors_;
+  GLint uniform_vp_mat_;
+};
+}  // namespace tango_gl
+#endif  // TANGO_GL_SPRITE_BATCH_H_
@@ -0,0 +1,148 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_GL_STARTUP_ORCHESTRATOR_H_
+#define TANGO_GL_STARTUP_ORCHESTRATOR_H_
+
+#include <stdint.h>
+
+#include <functional>
+#include <initializer_list>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace tango_gl {
+
+// StartupOrchestrator overlaps the independent steps of bringing up an
+// application, e.g. configuring and connecting the Tango service while the
+// GL thread compiles shaders, instead of running them in sequence on
+// whichever thread Java calls from.
+//
+// Steps are added once as tasks with the tasks they depend on. Start() runs
+// them: a worker task starts on a thread of its own as soon as its
+// dependencies succeeded, a GL task runs on the next RunGLTasks() call from
+// the GL thread after that. A failing task stops the tasks depending on it.
+//
+//   StartupOrchestrator startup;
+//   int config = startup.AddTask("config", StartupOrchestrator::kWorker,
+//                                [this]() { return SetupConfig(); }, {});
+//   int gl = startup.AddTask("glContent", StartupOrchestrator::kGLThread,
+//                            [this]() { return InitGL(); }, {});
+//   startup.AddTask("connect", StartupOrchestrator::kWorker,
+//                   [this]() { return Connect(); }, {config, gl});
+//
+// The time from Start() to MarkFirstFrame() is the time to first frame.
+// GetReport() lists it with the start and duration of each task, and each
+// task is recorded as a span when tracing is compiled in.
+class StartupOrchestrator {
+ public:
+  // Thread a task runs on.
+  enum Thread {
+    kWorker,
+    kGLThread,
+  };
+
+  // Returns 0 on success, an error code otherwise, e.g. a TangoErrorType.
+  typedef std::function<int()> Task;
+
+  StartupOrchestrator();
+  StartupOrchestrator(const StartupOrchestrator& other) = delete;
+  const StartupOrchestrator& operator=(const StartupOrchestrator&) = delete;
+  ~StartupOrchestrator();
+
+  // Add a task. Must not be called while started.
+  //
+  // @param name: string literal naming the task in reports and traces.
+  // @param dependencies: ids of tasks added before.
+  // @return: the id of the task.
+  int AddTask(const char* name, Thread thread, Task task,
+              std::initializer_list<int> dependencies);
+
+  // Run the tasks from the start, after waiting for the previous run to
+  // stop. Can be called from any thread.
+  void Start();
+
+  // Let running tasks finish and start no others. Can be called from any
+  // thread except a worker task.
+  void Stop();
+
+  // Run the GL tasks whose dependencies succeeded. Call it once per frame
+  // on the GL thread, it returns immediately when there is nothing to run.
+  void RunGLTasks();
+
+  // Whether Start() was called since the last Stop(). Can be called from
+  // any thread.
+  bool IsStarted() const;
+
+  // Whether all tasks succeeded. Can be called from any thread.
+  bool IsComplete() const;
+
+  // Error code of the first failed task, 0 if none failed.
+  int GetError() const;
+
+  // Record the time to first frame, once per Start(). Call it when the first
+  // frame with content was rendered.
+  void MarkFirstFrame();
+
+  // Milliseconds from Start() to MarkFirstFrame(), 0 if not marked yet.
+  float GetTimeToFirstFrameMs() const;
+
+  // The time to first frame and a line per task, e.g.
+  // "connect worker +12.1 ms 250.3 ms", in order of addition. Can be called
+  // from any thread.
+  std::string GetReport() const;
+
+ private:
+  enum State {
+    kPending,
+    kRunning,
+    kSucceeded,
+    kFailed,
+  };
+
+  struct TaskInfo {
+    const char* name;
+    Thread thread;
+    Task task;
+    std::vector<int> dependencies;
+    State state;
+    // Microseconds, relative to start_us_.
+    uint64_t start_us;
+    uint64_t duration_us;
+  };
+
+  // Whether a pending task can run. Called with mutex_ held.
+  bool IsReady(const TaskInfo& task) const;
+
+  // Start the worker tasks which became ready. Called with mutex_ held.
+  void DispatchWorkers();
+
+  // Run a task on the calling thread and dispatch the tasks depending on it.
+  void RunTask(int id);
+
+  mutable std::mutex mutex_;
+  std::vector<TaskInfo> tasks_;
+  std::vector<std::thread> threads_;
+  bool is_started_;
+  int error_;
+  uint64_t start_us_;
+  uint64_t first_frame_us_;
+};
+}  // namespace tango_gl
+#endif  // TANGO_GL_STARTUP_ORCHESTRATOR_H_
@@ -0,0 +1,105 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TANGO_GL_STREAMING_TEXTURE_H_
+#define TANGO_GL_STREAMING_TEXTURE_H_
+
+#include <vector>
+
+#include "tango-gl/util.h"
+
+namespace tango_gl {
+
+// A 2D texture whose content is replaced every frame, e.g. camera images or
+// CPU generated depth maps.
+//
+// The texture storage is allocated once with glTexImage2D and later updates
+// go through glTexSubImage2D. On GLES3 capable contexts the updates are staged
+// in a ring of pixel buffer objects, so the driver can transfer the data to
+// the texture asynchronously while the GL thread moves on; a PBO is only
+// rewritten once the ring wraps around, by which time its previous transfer
+// has completed. On GLES2 contexts the data is uploaded directly.
+//
+// All functions must be called on the GL thread.
+class StreamingTexture {
+ public:
+  StreamingTexture();
+  StreamingTexture(const StreamingTexture& other) = delete;
+  const StreamingTexture& operator=(const StreamingTexture&) = delete;
+  ~StreamingTexture();
+
+  // Allocate the texture storage. This is a no-op if the texture already has
+  // the requested size and format, otherwise the previous storage is released.
+  //
+  // @param width: width of the texture in pixels.
+  // @param height: height of the texture in pixels.
+  // @param format: GL_LUMINANCE, GL_LUMINANCE_ALPHA, GL_RGB or GL_RGBA, with
+  //                GL_UNSIGNED_BYTE components.
+  void Allocate(GLsizei width, GLsizei height, GLenum format);
+
+  // Release the texture and the pixel buffer objects.
+  void Release();
+
+  // Forget the texture and the pixel buffer objects without deleting them.
+  // Use this when the GL context they belonged to has been destroyed.
+  void Invalidate();
+
+  // Replace the full texture content.
+  //
+  // @param data: tightly packed rows, width * height * bytes per pixel bytes.
+  void Update(const void* data);
+
+  // Start an update that is written in place by the caller, avoiding an extra
+  // copy: the returned pointer is either a mapped PBO or a staging buffer, and
+  // stays valid until EndUpdate() is called.
+  //
+  // @return: tightly packed destination of GetSizeInBytes() bytes, or nullptr
+  //          if the texture is not allocated.
+  uint8_t* BeginUpdate();
+
+  // Upload the data written since BeginUpdate().
+  void EndUpdate();
+
+  GLuint GetTextureId() const { return texture_id_; }
+  GLsizei GetWidth() const { return width_; }
+  GLsizei GetHeight() const { return height_; }
+  size_t GetSizeInBytes() const { return size_in_bytes_; }
+  bool IsAllocated() const { return texture_id_ != 0; }
+
+  // Return true if updates are staged through pixel buffer objects.
+  bool IsUsingPixelBuffers() const { return pixel_buffers_[0] != 0; }
+
+ private:
+  static const int kPixelBufferCount = 3;
+
+  void UploadFromBoundBuffer(const void* data);
+
+  GLuint texture_id_;
+  GLsizei width_;
+  GLsizei height_;
+  GLenum format_;
+  size_t size_in_bytes_;
+
+  // PBO ring, all zero if not supported by the context.
+  GLuint pixel_buffers_[kPixelBufferCount];
+  int pixel_buffer_index_;
+
+  // Destination of BeginUpdate() when PBOs are not available.
+  std::vector<uint8_t> staging_buffer_;
+  bool is_updating_;
+};
+}  // namespace tango_gl
+#endif  // TANGO_GL_STREAMING_TEXTURE_H_
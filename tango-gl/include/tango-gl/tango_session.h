@@ -0,0 +1,160 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_GL_TANGO_SESSION_H_
+#define TANGO_GL_TANGO_SESSION_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include <tango_client_api.h>  // NOLINT
+
+#include "tango-gl/image_pool.h"
+#include "tango-gl/point_cloud_pool.h"
+
+namespace tango_gl {
+
+// TangoSession owns the connection to the Tango service for an app that
+// combines several modules, e.g. an overlay, depth to color sync, plane
+// fitting and a recorder, which each used to connect their own callbacks and
+// copy the same frames.
+//
+// The session holds the config and registers one callback per stream. Each
+// depth frame and camera frame is copied once, into a PointCloudPool or an
+// ImagePool, and every module registered for the stream is handed the same
+// reference counted handle on the callback thread. A module that works on
+// the frame later, e.g. on a worker or the GL thread, keeps a copy of the
+// handle instead of the data; modules that only want the newest frame poll
+// AcquireLatestPointCloud() or AcquireLatestImage(). Poses and events are
+// small and handed out as is.
+//
+// When every pooled frame is still held by a module, new frames are dropped
+// and counted, so a slow module bounds the memory instead of growing it.
+//
+// Handlers are added before Connect() and removed only with the session; the
+// callback threads read them without locks. There is one connection per
+// process, so there is at most one connected session.
+class TangoSession {
+ public:
+  struct Options {
+    Options()
+        : enable_depth(true),
+          enable_auto_recovery(true),
+          max_point_count(320 * 180),
+          depth_frame_count(4),
+          max_image_size(1280 * 720 * 3 / 2),
+          image_frame_count(3) {}
+
+    bool enable_depth;
+    // Cameras whose frames are fanned out, each with a pool of its own. The
+    // color camera is enabled in the config if it is listed.
+    std::vector<TangoCameraId> cameras;
+    // Frame pairs of the pose callback, none connects no pose callback.
+    std::vector<TangoCoordinateFramePair> frame_pairs;
+    bool enable_auto_recovery;
+
+    // Capacity of each depth frame in points, larger frames are truncated.
+    size_t max_point_count;
+    // Depth frames pooled, shared by the modules and the one being copied.
+    int depth_frame_count;
+    // Capacity of each camera frame in bytes, larger frames are dropped.
+    size_t max_image_size;
+    // Frames pooled per camera.
+    int image_frame_count;
+  };
+
+  typedef std::function<void(const PointCloudPool::Handle& frame)>
+      DepthHandler;
+  typedef std::function<void(TangoCameraId camera,
+                             const ImagePool::Handle& frame)> FrameHandler;
+  typedef std::function<void(const TangoPoseData& pose)> PoseHandler;
+  typedef std::function<void(const TangoEvent& event)> EventHandler;
+
+  explicit TangoSession(const Options& options);
+  TangoSession(const TangoSession& other) = delete;
+  const TangoSession& operator=(const TangoSession&) = delete;
+  // Disconnects and frees the config.
+  ~TangoSession();
+
+  // Get the default config and apply the options. Modules can set keys of
+  // their own on GetConfig() before Connect().
+  TangoErrorType SetupConfig();
+
+  // nullptr before SetupConfig().
+  TangoConfig GetConfig() const { return config_; }
+
+  // Register a module for a stream, before Connect(). Handlers run on the
+  // callback thread of the stream, in the order they were added, and should
+  // return quickly.
+  void AddDepthHandler(const DepthHandler& handler);
+  // @param camera: one of Options::cameras.
+  void AddFrameHandler(TangoCameraId camera, const FrameHandler& handler);
+  void AddPoseHandler(const PoseHandler& handler);
+  void AddEventHandler(const EventHandler& handler);
+
+  // Connect the callbacks of the streams and the service.
+  TangoErrorType Connect();
+
+  void Disconnect();
+
+  bool IsConnected() const { return is_connected_; }
+
+  // Latest frames, from any thread.
+  //
+  // @return: an empty handle if no frame arrived yet.
+  PointCloudPool::Handle AcquireLatestPointCloud();
+  ImagePool::Handle AcquireLatestImage(TangoCameraId camera);
+
+  // Frames dropped because every pooled frame was held, from any thread.
+  uint64_t GetDroppedDepthCount() const { return dropped_depth_count_; }
+  uint64_t GetDroppedImageCount() const { return dropped_image_count_; }
+
+ private:
+  static void OnXYZijAvailableRouter(void* context, const TangoXYZij* xyz_ij);
+  static void OnFrameAvailableRouter(void* context, TangoCameraId camera,
+                                     const TangoImageBuffer* buffer);
+  static void OnPoseAvailableRouter(void* context, const TangoPoseData* pose);
+  static void OnTangoEventRouter(void* context, const TangoEvent* event);
+
+  void OnXYZijAvailable(const TangoXYZij* xyz_ij);
+  void OnFrameAvailable(TangoCameraId camera, const TangoImageBuffer* buffer);
+
+  TangoErrorType ConnectCallbacks();
+
+  const Options options_;
+  TangoConfig config_;
+  bool is_connected_;
+
+  std::unique_ptr<PointCloudPool> depth_pool_;
+  // Indexed by camera, nullptr for the cameras not in Options::cameras.
+  std::unique_ptr<ImagePool> image_pools_[TANGO_MAX_CAMERA_ID];
+
+  std::vector<DepthHandler> depth_handlers_;
+  std::vector<FrameHandler> frame_handlers_[TANGO_MAX_CAMERA_ID];
+  std::vector<PoseHandler> pose_handlers_;
+  std::vector<EventHandler> event_handlers_;
+
+  std::atomic<uint64_t> dropped_depth_count_;
+  std::atomic<uint64_t> dropped_image_count_;
+};
+}  // namespace tango_gl
+#endif  // TANGO_GL_TANGO_SESSION_H_
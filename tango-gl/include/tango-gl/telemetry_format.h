@@ -0,0 +1,113 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_GL_TELEMETRY_FORMAT_H_
+#define TANGO_GL_TELEMETRY_FORMAT_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace tango_gl {
+namespace telemetry {
+
+// Datagrams sent by TelemetrySender. Each datagram is a PacketHeader followed
+// by the packet of its type:
+//
+//   kPosePacket:  PoseBatchHeader | pose_count PoseRecord
+//   kDepthPacket: DepthFragmentHeader | fragment of a point_cloud_codec frame
+//   kProbePacket: ProbeRecord | bucket_count uint32_t bucket counts
+//
+// Nothing is retransmitted. Every record carries its sensor timestamp, so a
+// receiver can order what arrives and treat the rest as lost: a lost pose
+// batch is a gap in the trajectory, a depth frame missing a fragment is
+// dropped whole. A probe packet carries the whole ServiceProbe histogram of
+// one source, the newest one replaces the earlier ones. The packet sequence
+// numbers let the receiver count losses. All values are little endian.
+
+const uint32_t kMagic = 0x4D544754;  // "TGTM"
+const uint16_t kVersion = 1;
+
+// Largest datagram sent, small enough to cross common links without IP
+// fragmentation, as in QUIC.
+const size_t kDefaultMaxDatagramSize = 1200;
+
+enum PacketType : uint16_t {
+  kPosePacket = 1,
+  kDepthPacket = 2,
+  kProbePacket = 3,
+};
+
+struct PacketHeader {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t type;
+  // Counts every datagram of the sender, starting at 0.
+  uint32_t sequence;
+  uint32_t reserved;
+};
+
+struct PoseBatchHeader {
+  uint32_t pose_count;
+  uint32_t reserved;
+};
+
+// A TangoPoseData in single precision, meters and a unit quaternion.
+struct PoseRecord {
+  double timestamp;
+  float translation[3];
+  float orientation[4];
+  uint8_t status_code;
+  uint8_t base_frame;
+  uint8_t target_frame;
+  uint8_t reserved;
+};
+
+struct DepthFragmentHeader {
+  // Timestamp of the depth frame, in seconds.
+  double timestamp;
+  // Counts the depth frames of the sender.
+  uint32_t frame_id;
+  // Size of the whole encoded frame, and offset of this fragment in it.
+  uint32_t frame_size;
+  uint32_t offset;
+  uint16_t fragment_index;
+  uint16_t fragment_count;
+};
+
+// A tango_gl::ServiceProbe::Histogram, see tango-gl/service_probe.h.
+struct ProbeRecord {
+  // A ServiceProbe::Source.
+  uint8_t source;
+  uint8_t reserved[3];
+  uint32_t bucket_count;
+  uint64_t count;
+  uint64_t sum_us;
+  uint64_t max_us;
+  uint64_t early_count;
+};
+
+static_assert(sizeof(PacketHeader) == 16, "PacketHeader layout changed.");
+static_assert(sizeof(PoseBatchHeader) == 8,
+              "PoseBatchHeader layout changed.");
+static_assert(sizeof(PoseRecord) == 40, "PoseRecord layout changed.");
+static_assert(sizeof(DepthFragmentHeader) == 24,
+              "DepthFragmentHeader layout changed.");
+static_assert(sizeof(ProbeRecord) == 40, "ProbeRecord layout changed.");
+
+}  // namespace telemetry
+}  // namespace tango_gl
+#endif  // TANGO_GL_TELEMETRY_FORMAT_H_
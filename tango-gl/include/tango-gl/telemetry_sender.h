@@ -0,0 +1,197 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_GL_TELEMETRY_SENDER_H_
+#define TANGO_GL_TELEMETRY_SENDER_H_
+
+#include <stdint.h>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <tango_client_api.h>
+
+#include "tango-gl/bounded_queue.h"
+#include "tango-gl/point_cloud_codec.h"
+#include "tango-gl/pose_stream.h"
+#include "tango-gl/telemetry_format.h"
+
+namespace tango_gl {
+
+// TelemetrySender streams poses and depth to a remote server over UDP, in the
+// datagrams described in tango-gl/telemetry_format.h, e.g. for monitoring a
+// fleet of devices.
+//
+// All the work happens on a dedicated I/O thread:
+//
+// - Poses are delivered by a PoseStream subscription per frame pair,
+//   decimated by pose_options on the callback thread, which then only copies
+//   a record into a lock-free queue. Every pose_batch_interval the thread
+//   sends the queued records in as few datagrams as fit.
+// - Depth frames are copied by SendPointCloud() into one of a few slots and
+//   queued, lock-free. The thread encodes the newest queued frame with
+//   tango-gl/point_cloud_codec.h and sends it in fragments; older queued
+//   frames are dropped, as are frames arriving while every slot is taken.
+//
+// - When the ServiceProbe is enabled, its histograms are sent every
+//   probe_interval, one datagram per source with samples.
+//
+// The socket only ever blocks the I/O thread. Losses are not repaired, the
+// timestamps of the records let the receiver skip over them.
+class TelemetrySender {
+ public:
+  struct Options {
+    Options()
+        : max_datagram_size(telemetry::kDefaultMaxDatagramSize),
+          pose_batch_interval(std::chrono::milliseconds(20)),
+          pose_queue_capacity(256),
+          max_point_count(60000),
+          point_cloud_slot_count(3),
+          depth_step(point_cloud_codec::kDefaultStep),
+          probe_interval(std::chrono::milliseconds(1000)) {
+      pose_options.max_rate = 30.0;
+    }
+
+    size_t max_datagram_size;
+    // How often poses are sent, the latency a batch adds at most.
+    std::chrono::milliseconds pose_batch_interval;
+    // Limits of the poses sent for each frame pair: 30 poses per second by
+    // default, a third of the pose callback rate.
+    PoseStream::SubscriberOptions pose_options;
+    // Poses that can wait for the I/O thread, newer ones are dropped.
+    size_t pose_queue_capacity;
+    // Largest depth frame accepted, larger ones are dropped.
+    uint32_t max_point_count;
+    // Depth frames that can wait for the I/O thread.
+    int point_cloud_slot_count;
+    // Quantization of the depth frames, see point_cloud_codec::Encoder.
+    float depth_step;
+    // How often the ServiceProbe histograms are sent.
+    std::chrono::milliseconds probe_interval;
+  };
+
+  TelemetrySender();
+  TelemetrySender(const TelemetrySender& other) = delete;
+  const TelemetrySender& operator=(const TelemetrySender&) = delete;
+  ~TelemetrySender();
+
+  // Resolve the server, allocate the slots and start the I/O thread.
+  //
+  // @param host: server name or address.
+  // @param port: server UDP port.
+  // @param poses: stream whose frame pairs are sent, subscribed to until
+  //        Stop(), nullptr for none. It must outlive the sender.
+  // @return: false if the server cannot be resolved or reached, or the sender
+  //          is already running.
+  bool Start(const char* host, const char* port, PoseStream* poses,
+             const Options& options);
+
+  // Unsubscribe from the poses, stop the I/O thread and close the socket.
+  // Queued poses and depth frames are dropped.
+  void Stop();
+
+  bool IsRunning() const { return is_running_.load(std::memory_order_relaxed); }
+
+  // Queue a depth frame. Can be called from any thread, e.g. the XYZij
+  // callback, and never blocks.
+  //
+  // @return: false if the frame was dropped, because the sender is not
+  //          running, the frame is too large or every slot is taken.
+  bool SendPointCloud(const TangoXYZij& cloud);
+
+  // Datagrams and bytes sent since Start().
+  uint32_t GetSentPacketCount() const {
+    return sent_packet_count_.load(std::memory_order_relaxed);
+  }
+  uint64_t GetSentByteCount() const {
+    return sent_byte_count_.load(std::memory_order_relaxed);
+  }
+
+  // Depth frames and poses dropped before they were sent, and datagrams the
+  // socket refused, since Start().
+  uint32_t GetDroppedFrameCount() const {
+    return dropped_frame_count_.load(std::memory_order_relaxed);
+  }
+  uint32_t GetDroppedPoseCount() const {
+    return dropped_pose_count_.load(std::memory_order_relaxed);
+  }
+  uint32_t GetFailedPacketCount() const {
+    return failed_packet_count_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  struct PointCloudSlot {
+    double timestamp;
+    uint32_t point_count;
+    std::vector<float> points;
+  };
+
+  // Track the callbacks using the slots, so Stop() can wait for them.
+  bool BeginSend();
+  void EndSend() { active_send_count_.fetch_sub(1, std::memory_order_release); }
+
+  void SendLoop();
+
+  // Queue a pose for the I/O thread, called on the pose callback thread.
+  void QueuePose(const TangoPoseData& pose);
+
+  // Send the queued poses.
+  void SendPoses();
+
+  // Send the pose_count records written after the headers of datagram_.
+  void SendPoseBatch(size_t pose_count);
+
+  // Send the newest queued depth frame, if any.
+  void SendNewestPointCloud();
+
+  // Send the ServiceProbe histograms with samples.
+  void SendProbes();
+
+  // Prepend a PacketHeader to the payload in datagram_ and send it.
+  void SendDatagram(telemetry::PacketType type, size_t payload_size);
+
+  Options options_;
+  PoseStream* poses_;
+  int subscriptions_[PoseStream::kMaxFramePairs];
+  std::unique_ptr<BoundedQueue<telemetry::PoseRecord>> pose_records_;
+  std::vector<PointCloudSlot> slots_;
+  std::unique_ptr<BoundedQueue<int>> free_slots_;
+  std::unique_ptr<BoundedQueue<int>> ready_slots_;
+
+  // Only touched by the I/O thread.
+  int socket_;
+  uint32_t sequence_;
+  uint32_t frame_id_;
+  std::vector<uint8_t> datagram_;
+  std::vector<uint8_t> encoded_frame_;
+  point_cloud_codec::Encoder encoder_;
+
+  std::thread thread_;
+  std::atomic<bool> is_running_;
+  std::atomic<bool> is_stopping_;
+  std::atomic<int> active_send_count_;
+  std::atomic<uint32_t> sent_packet_count_;
+  std::atomic<uint64_t> sent_byte_count_;
+  std::atomic<uint32_t> dropped_frame_count_;
+  std::atomic<uint32_t> dropped_pose_count_;
+  std::atomic<uint32_t> failed_packet_count_;
+};
+}  // namespace tango_gl
+#endif  // TANGO_GL_TELEMETRY_SENDER_H_
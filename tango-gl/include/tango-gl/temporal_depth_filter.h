@@ -0,0 +1,185 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_GL_TEMPORAL_DEPTH_FILTER_H_
+#define TANGO_GL_TEMPORAL_DEPTH_FILTER_H_
+
+#include <stddef.h>
+
+#include <vector>
+
+#include "tango-gl/point_projection.h"
+#include "tango-gl/range_image.h"
+#include "tango-gl/ray_table.h"
+#include "tango-gl/util.h"
+
+namespace tango_gl {
+
+// TemporalDepthFilter smooths the frame to frame noise of an organized depth
+// image, e.g. a RangeImage or the color camera depth map of the RGB depth
+// sync example, by keeping a running mean and variance of the depth of every
+// pixel over the last frames.
+//
+// Each Update() first warps the state of the previous frame into the
+// current camera with the pose delta: every pixel with a mean is back
+// projected, moved and splatted into the current image, the nearest one
+// winning. Frames taken from the same pose skip the warp. Then each pixel
+// fuses its new depth: a depth within outlier_threshold standard deviations
+// of the mean updates the mean and variance, any other depth restarts the
+// pixel from it. Pixels without a new depth keep their mean for a few frames
+// while their weight decays. On NEON capable devices four pixels are fused
+// at a time, with the divides replaced by refined reciprocal estimates.
+//
+// Along with the filtered depth the filter emits a confidence per pixel, in
+// [0, 1], growing with the number of frames fused and shrinking with the
+// variance measured relative to the expected sensor noise. Later stages can
+// weight or skip pixels by it, see DepthHitTester::SetConfidences(), and get
+// away with smaller windows and fewer iterations.
+//
+// Not thread safe, callers serialize Update() and reads.
+class TemporalDepthFilter {
+ public:
+  struct Options {
+    Options()
+        : max_weight(8.0f), noise_coefficient(0.003f),
+          outlier_threshold(3.0f) {}
+
+    // Number of frames a pixel averages over at most, also the number of
+    // frames a pixel survives without new depth at full weight. Lower
+    // values follow moving geometry faster.
+    float max_weight;
+    // Expected standard deviation of a single depth measurement per squared
+    // meter of depth, i.e. sigma(z) = noise_coefficient * z^2.
+    float noise_coefficient;
+    // Depths farther from the mean than this many standard deviations,
+    // including the sensor noise, restart the pixel.
+    float outlier_threshold;
+  };
+
+  explicit TemporalDepthFilter(const Options& options);
+  TemporalDepthFilter(const TemporalDepthFilter& other) = delete;
+  const TemporalDepthFilter& operator=(const TemporalDepthFilter&) = delete;
+
+  // Forget the history of every pixel, e.g. after a tracking loss. The next
+  // Update() starts over from its depth image.
+  void Reset();
+
+  // Fuse a depth image.
+  //
+  // @param depths: row major depths in meters, intrinsics.width *
+  //        intrinsics.height, 0 where there is no depth. Pixel (x, y) covers
+  //        the image positions [x, x + 1) by [y, y + 1).
+  // @param intrinsics: intrinsics of the camera of the image. A change of
+  //        the image size resets the filter.
+  // @param world_T_camera: pose of the camera at the image timestamp in a
+  //        fixed frame, e.g. start of service.
+  // @return number of pixels with a filtered depth.
+  size_t Update(const float* depths,
+                const projection::CameraIntrinsics& intrinsics,
+                const glm::mat4& world_T_camera);
+
+  // Fuse the depth of a range image.
+  size_t Update(const RangeImage& image, const glm::mat4& world_T_camera);
+
+  const Options& GetOptions() const { return options_; }
+
+  int GetWidth() const { return intrinsics_.width; }
+  int GetHeight() const { return intrinsics_.height; }
+  const projection::CameraIntrinsics& GetIntrinsics() const {
+    return intrinsics_;
+  }
+
+  // Row major, GetWidth() * GetHeight() filtered depths, 0 where there is
+  // none. The layout of the input image, so it can stand in for it, e.g. in
+  // DepthHitTester::SetDepthImage().
+  const float* GetDepths() const { return depths_.data(); }
+
+  // Row major, GetWidth() * GetHeight() confidences in [0, 1], 0 where there
+  // is no filtered depth.
+  const float* GetConfidences() const { return confidences_.data(); }
+
+  // Row major, GetWidth() * GetHeight() variances of the depth over the
+  // frames fused, in squared meters.
+  const float* GetVariances() const { return variances_.data(); }
+
+  float GetDepth(int x, int y) const {
+    return depths_[y * intrinsics_.width + x];
+  }
+  float GetConfidence(int x, int y) const {
+    return confidences_[y * intrinsics_.width + x];
+  }
+
+ private:
+  // Move the means, variances and weights of the previous frame into the
+  // current camera.
+  void WarpState(const glm::mat4& current_T_previous);
+
+  Options options_;
+  projection::CameraIntrinsics intrinsics_;
+  // Rays through the pixel centers, for warping the state.
+  RayTable ray_table_;
+  glm::mat4 world_T_previous_;
+  bool has_previous_;
+
+  std::vector<float> means_;
+  std::vector<float> variances_;
+  std::vector<float> weights_;
+  std::vector<float> depths_;
+  std::vector<float> confidences_;
+
+  // Scratch of WarpState(), swapped with the state.
+  std::vector<float> warped_means_;
+  std::vector<float> warped_variances_;
+  std::vector<float> warped_weights_;
+};
+
+namespace internal {
+// Floor of the running variance in squared meters, a micrometer squared.
+// Depths that stop changing would otherwise decay it into denormals, which
+// are slow on most CPUs.
+const float kTemporalDepthMinVariance = 1e-12f;
+
+// Per pixel state of TemporalDepthFilter, updated in place by the kernels.
+struct TemporalDepthState {
+  float* means;
+  float* variances;
+  float* weights;
+  // Outputs, the filtered depth and the confidence of each pixel.
+  float* depths;
+  float* confidences;
+};
+
+// Fuse a depth image into the state, the inner loop of
+// TemporalDepthFilter::Update().
+//
+// @param measured_depths: depth of each pixel, 0 where there is none.
+// @param count: number of pixels.
+// @param options: see TemporalDepthFilter::Options.
+// @param state: per pixel state.
+void FuseTemporalDepths(const float* measured_depths, size_t count,
+                        const TemporalDepthFilter::Options& options,
+                        TemporalDepthState* state);
+
+// NEON kernel, defined in temporal_depth_filter_neon.cpp. Fuses the first
+// count & ~3 pixels; the caller fuses the remaining pixels.
+void FuseTemporalDepthsNeon(const float* measured_depths, size_t count,
+                            const TemporalDepthFilter::Options& options,
+                            TemporalDepthState* state);
+}  // namespace internal
+
+}  // namespace tango_gl
+#endif  // TANGO_GL_TEMPORAL_DEPTH_FILTER_H_
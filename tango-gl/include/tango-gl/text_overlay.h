@@ -0,0 +1,125 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_GL_TEXT_OVERLAY_H_
+#define TANGO_GL_TEXT_OVERLAY_H_
+
+#include <string>
+#include <vector>
+
+#include "tango-gl/util.h"
+#include "tango-gl/vertex_buffer.h"
+
+namespace tango_gl {
+
+// TextOverlay draws ASCII text in screen space on top of the scene, e.g.
+// debug statistics. The printable ASCII glyphs are rasterized once with
+// FreeType into an alpha atlas. Text added with AddText() is batched into a
+// textured quad per character and Draw() submits the whole batch in a single
+// draw call. Quads are kept in pixels, so a HUD whose text did not change
+// since the last Draw() uploads nothing, and one where only a few numbers
+// changed uploads the vertices from the first changed character on.
+// Rendering leaves the depth test disabled, like the other screen space
+// drawables.
+//
+// All functions must be called on the GL thread.
+class TextOverlay {
+ public:
+  TextOverlay();
+  TextOverlay(const TextOverlay& other) = delete;
+  const TextOverlay& operator=(const TextOverlay&) = delete;
+  ~TextOverlay();
+
+  // Rasterize a font into the glyph atlas.
+  //
+  // @param font_path: TrueType font file, e.g. kDefaultFontPath.
+  // @param pixel_size: glyph height in pixels.
+  // @return false if the font could not be loaded.
+  bool Initialize(const char* font_path, int pixel_size);
+
+  // Release the atlas, the vertex buffer and the shader program.
+  void Release();
+
+  // Forget the GL objects without deleting them. Use this when the GL
+  // context they belonged to has been destroyed. Initialize() must be called
+  // again before rendering.
+  void Invalidate();
+
+  void SetColor(float red, float green, float blue, float alpha);
+
+  // Distance between the baselines of two lines in pixels, 0 before
+  // Initialize().
+  float GetLineHeight() const { return line_height_; }
+
+  // Add text to the batch of the next Draw(), lines separated by '\n'.
+  // Characters outside printable ASCII are skipped.
+  //
+  // @param text: the text.
+  // @param x: left edge of the text in pixels from the left of the viewport.
+  // @param y: top edge of the text in pixels from the top of the viewport.
+  void AddText(const std::string& text, float x, float y);
+
+  // Draw the text added since the last Draw() and start a new batch.
+  //
+  // @param viewport_width: width of the viewport in pixels.
+  // @param viewport_height: height of the viewport in pixels.
+  void Draw(int viewport_width, int viewport_height);
+
+  // Draw a single text, the same as AddText() followed by Draw().
+  void Render(const std::string& text, float x, float y, int viewport_width,
+              int viewport_height);
+
+  // A font present on Android devices.
+  static const char kDefaultFontPath[];
+
+ private:
+  struct Glyph {
+    // Offset of the bitmap from the pen position, y pointing down.
+    float left;
+    float top;
+    float width;
+    float height;
+    float advance;
+    // Atlas coordinates of the bitmap.
+    float u0, v0, u1, v1;
+  };
+
+  static const char kFirstGlyph = ' ';
+  static const char kLastGlyph = '~';
+
+  Glyph glyphs_[kLastGlyph - kFirstGlyph + 1];
+  float line_height_;
+  float ascender_;
+
+  GLuint atlas_texture_;
+  GLuint shader_program_;
+  GLint attrib_vertices_;
+  GLint attrib_texture_coords_;
+  GLint uniform_glyphs_;
+  GLint uniform_color_;
+  GLint uniform_pixel_to_ndc_;
+  float red_, green_, blue_, alpha_;
+
+  // Interleaved x, y, u, v per vertex, six vertices per character, with x
+  // and y in pixels. vertices_ is the batch being added to, and
+  // uploaded_vertices_ mirrors the content of vertex_buffer_.
+  std::vector<GLfloat> vertices_;
+  std::vector<GLfloat> uploaded_vertices_;
+  VertexBuffer vertex_buffer_;
+};
+}  // namespace tango_gl
+#endif  // TANGO_GL_TEXT_OVERLAY_H_
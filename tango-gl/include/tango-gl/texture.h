@@ -20,24 +20,135 @@
 #include <errno.h>
 #include <png.h>
 
+#include <string>
+#include <vector>
+
+#include "tango-gl/memory_tracker.h"
 #include "tango-gl/util.h"
 
 namespace tango_gl {
-class Texture {
+// A 2D texture loaded from a file. Textures loaded from a file are evictable
+// under a MemoryTracker budget and reload synchronously on the next
+// GetTextureID() after an eviction.
+//
+// Textures are sampled trilinearly. PNG images get their mip levels
+// generated once uploaded, compressed images use the levels of their file,
+// see tools such as etcpack or toktx for generating them offline.
+class Texture : public MemoryTracker::Evictable {
  public:
+  // A decoded image. Uncompressed images keep their size where the context
+  // supports non power of two textures, and are padded to power of two
+  // dimensions otherwise. Compressed images hold their mip levels back to back in
+  // pixels, level 0 first, each level half the size of the previous one.
+  struct Image {
+    png_uint_32 width;
+    png_uint_32 height;
+    // GL_RGB or GL_RGBA, or the compressed internal format, e.g.
+    // GL_ETC1_RGB8_OES.
+    GLenum format;
+    bool is_compressed;
+    std::vector<uint8_t> pixels;
+    std::vector<size_t> level_sizes;
+
+    size_t GetRowSize() const {
+      return width * (format == GL_RGBA ? 4 : 3);
+    }
+  };
+
+  // What the GL context supports, captured on the GL thread for decoding on
+  // other threads.
+  struct Capabilities {
+    // Compressed texture formats.
+    std::vector<GLenum> compressed_formats;
+    // Non power of two textures with mipmaps and GL_REPEAT, from OpenGL ES 3
+    // or GL_OES_texture_npot.
+    bool has_npot;
+  };
+
+  // An empty texture, filled later by an AssetLoader. GetTextureID() returns
+  // a placeholder until then.
+  Texture();
   Texture(const char* file_path);
   Texture(const Texture& other) = delete;
   Texture& operator=(const Texture&) = delete;
-  ~Texture();
+  ~Texture() override;
 
+  // Decode and upload a PNG file synchronously, on the GL thread.
   bool LoadFromPNG(const char* file_path);
-  GLuint GetTextureID() const;
+
+  // The texture, or a shared 1x1 white placeholder while it is not loaded.
+  // Reloads the texture if it was evicted, and marks it used for the
+  // eviction order.
+  GLuint GetTextureID();
+
+  bool IsLoaded() const { return is_loaded_; }
+
+  // Decode and upload a KTX, PKM or PNG file synchronously, on the GL thread.
+  // A compressed file whose format the GPU does not support is replaced by
+  // the PNG file with the same base name, e.g. overlay.ktx by overlay.png.
+  bool LoadFromFile(const char* file_path);
+
+  // Decode a PNG file into image, reusing its pixel storage. Does not touch
+  // GL, so it can run on any thread.
+  //
+  // @param file_path: path of the file.
+  // @param pad_to_power_of_two: pad the image to power of two dimensions,
+  //        for contexts without Capabilities::has_npot.
+  // @param image: decoded image.
+  // @return false if the file could not be opened or is not a valid PNG.
+  static bool DecodePNG(const char* file_path, bool pad_to_power_of_two,
+                        Image* image);
+
+  // Decode a KTX (ETC1, ETC2, ASTC or any other compressed format, with mip
+  // levels) or PKM (ETC1, ETC2) file, or a PNG file, based on its content.
+  // Does not touch GL, so it can run on any thread.
+  //
+  // @param file_path: path of the file.
+  // @param capabilities: capabilities of the GL context, see
+  //        GetCapabilities().
+  // @param image: decoded image.
+  // @return false if neither the file nor its PNG fallback could be decoded.
+  static bool DecodeFile(const char* file_path,
+                         const Capabilities& capabilities, Image* image);
+
+  // Capabilities of the current GL context, on the GL thread.
+  static Capabilities GetCapabilities();
+
+  // Free the texture until its next use, see MemoryTracker.
+  void Evict() override;
 
  private:
+  friend class AssetLoader;
+
+  // Allocate the texture storage for an image, on the GL thread.
+  void Allocate(const Image& image);
+
+  // Upload rows [first_row, first_row + row_count) of an image to the storage
+  // created by Allocate(). The texture counts as loaded once the last row is
+  // uploaded, and its mip levels are generated then.
+  void UploadRows(const Image& image, png_uint_32 first_row,
+                  png_uint_32 row_count);
+
+  // Upload one mip level of a compressed image. The texture counts as loaded
+  // once the last level is uploaded.
+  void UploadLevel(const Image& image, size_t level);
+
+  // Create a texture holding a whole image with plain GL calls, bypassing
+  // RenderState, e.g. on an UploadThread. The texture is not tracked.
+  static GLuint CreateTexture(const Image& image);
+
+  // Replace the storage by a texture CreateTexture() made from the image,
+  // once its upload finished. The texture counts as loaded.
+  void AdoptTexture(GLuint texture_id, const Image& image);
+
   png_uint_32 width_, height_;
-  int bit_depth_, color_type_;
-  char* byte_data_;
   GLuint texture_id_;
+  bool is_loaded_;
+  // File the texture was loaded from, empty if it can not be reloaded.
+  std::string file_path_;
+  bool is_evicted_;
+  // Whether UploadRows() generates the mip levels.
+  bool generates_mipmaps_;
 };
 }  // namespace tango_gl
 #endif  // TANGO_GL_TEXTURE_H_
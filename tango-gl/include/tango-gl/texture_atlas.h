@@ -0,0 +1,130 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_GL_TEXTURE_ATLAS_H_
+#define TANGO_GL_TEXTURE_ATLAS_H_
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "tango-gl/texture.h"
+#include "tango-gl/util.h"
+
+namespace tango_gl {
+
+class AssetLoader;
+
+// TextureAtlas packs many small images, e.g. the icons, labels and markers
+// of AR annotations, into a few shared RGBA pages, so a SpriteBatch draws
+// all of them with one texture bind and one draw call per page.
+//
+// Sprites are reserved with AddSprite() and get their image later, from an
+// AssetLoader decoding PNG files off the GL thread or from SetImage(). Each
+// image is placed on the first shelf of a page it fits, shelves being rows
+// as high as their tallest image, and a new page is started when none has
+// room. Images are surrounded by a copy of their edge pixels, so bilinear
+// filtering at their border does not pick up their neighbors. Pages have no
+// mip levels, sprites are meant to be drawn near their image size.
+//
+// All functions must be called on the GL thread.
+class TextureAtlas {
+ public:
+  static const GLsizei kDefaultPageSize = 1024;
+
+  struct Sprite {
+    // Page of the image, -1 while it is not loaded.
+    int page;
+    // Texture coordinates of the image on its page.
+    glm::vec2 uv_min;
+    glm::vec2 uv_max;
+    // Size of the image in pixels.
+    GLsizei width;
+    GLsizei height;
+  };
+
+  // @param page_size: width and height of the pages in pixels, the largest
+  //        image that fits is 2 pixels smaller.
+  explicit TextureAtlas(GLsizei page_size = kDefaultPageSize);
+  TextureAtlas(const TextureAtlas& other) = delete;
+  const TextureAtlas& operator=(const TextureAtlas&) = delete;
+  ~TextureAtlas();
+
+  // Reserve a sprite without an image.
+  //
+  // @return the index of the sprite.
+  int AddSprite();
+
+  // Reserve a sprite and queue loading its image from a PNG file, the same
+  // as AddSprite() followed by AssetLoader::LoadSprite().
+  //
+  // @return the index of the sprite.
+  int LoadSprite(AssetLoader* loader, const char* file_path);
+
+  // Pack an uncompressed image and upload it, replacing the image of the
+  // sprite. The space of the previous image is not reused.
+  //
+  // @return false if the image is compressed or larger than a page.
+  bool SetImage(int sprite, const Texture::Image& image);
+
+  const Sprite& GetSprite(int sprite) const { return sprites_[sprite]; }
+  bool IsLoaded(int sprite) const { return sprites_[sprite].page >= 0; }
+  size_t GetSpriteCount() const { return sprites_.size(); }
+
+  size_t GetPageCount() const { return pages_.size(); }
+  GLuint GetPageTexture(int page) const { return pages_[page].texture; }
+
+  // Release the pages. The sprites are kept but are not loaded anymore.
+  void Release();
+
+  // Forget the pages without deleting them. Use this when the GL context
+  // they belonged to has been destroyed. The sprites are kept but are not
+  // loaded anymore.
+  void Invalidate();
+
+ private:
+  // A row of a page, as high as its tallest image.
+  struct Shelf {
+    GLsizei y;
+    GLsizei height;
+    // Left edge of the free space.
+    GLsizei x;
+  };
+
+  struct Page {
+    GLuint texture;
+    std::vector<Shelf> shelves;
+    // Top of the space left below the shelves.
+    GLsizei free_y;
+  };
+
+  // Find room for a rectangle, starting a shelf or a page if needed.
+  //
+  // @return false if the rectangle is larger than a page.
+  bool Pack(GLsizei width, GLsizei height, int* page, GLsizei* x, GLsizei* y);
+
+  // Start a page and create its texture.
+  void AddPage();
+
+  GLsizei page_size_;
+  std::vector<Page> pages_;
+  std::vector<Sprite> sprites_;
+  // RGBA image with its border, as uploaded.
+  std::vector<uint8_t> staging_buffer_;
+};
+}  // namespace tango_gl
+#endif  // TANGO_GL_TEXTURE_ATLAS_H_
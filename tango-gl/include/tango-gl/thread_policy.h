@@ -0,0 +1,107 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_GL_THREAD_POLICY_H_
+#define TANGO_GL_THREAD_POLICY_H_
+
+#include <vector>
+
+#include "tango-gl/worker_pool.h"
+
+// Scheduling of the threads an app does not start itself, the Tango
+// callback threads and the GL thread, by the role they play:
+//
+//  void App::OnXYZijAvailable(const TangoXYZij* xyz_ij) {
+//    tango_gl::thread_policy::EnterRole(tango_gl::thread_policy::kDepth);
+//    ...
+//  }
+//
+// The first EnterRole() on a thread applies the policy of its role, the
+// cores it may run on and its nice value; later calls only test a thread
+// local flag, so the call can sit at the top of a callback. On big.LITTLE
+// devices the default policies keep the GL, depth and camera threads on the
+// big cores and background work on the little ones.
+//
+// Tagged threads, and the workers of every WorkerPool, are accounted by
+// role: GetStatistics() reports the CPU time they used, read from
+// /proc/self/task. Policies and statistics are Linux only, elsewhere the
+// calls do nothing.
+namespace tango_gl {
+namespace thread_policy {
+
+enum Role {
+  // The GL thread, GLSurfaceView.Renderer.onDrawFrame().
+  kRender,
+  // onPoseAvailable.
+  kPose,
+  // OnXYZijAvailable, and the stages processing depth.
+  kDepth,
+  // OnFrameAvailable.
+  kCamera,
+  // Workers of the WorkerPools.
+  kWorker,
+  // Work nobody waits for, e.g. uploads, exports and logging.
+  kBackground,
+  kRoleCount
+};
+
+struct Policy {
+  Policy() : cores(WorkerPool::kAnyCores), nice(0) {}
+  Policy(WorkerPool::CoreSet cores, int nice) : cores(cores), nice(nice) {}
+
+  // Cores the threads are pinned to. Ignored where pinning is not
+  // supported, or if the set is empty.
+  WorkerPool::CoreSet cores;
+  // Nice value of the threads, from -20 (most favored) to 19. Going below
+  // the current value needs a permission the process may lack, a failure
+  // is logged and the thread keeps its priority.
+  int nice;
+};
+
+struct Statistics {
+  // Threads tagged with the role so far, including the ones that ended.
+  int thread_count;
+  // CPU time of those threads since they started, in milliseconds.
+  double cpu_time_ms;
+};
+
+// Set the policy of a role, for the threads entering it from now on.
+void SetPolicy(Role role, const Policy& policy);
+Policy GetPolicy(Role role);
+
+// Tag the calling thread with a role and apply its policy, the first time
+// only.
+void EnterRole(Role role);
+
+// Tag the calling thread with a role for the statistics only, keeping its
+// scheduling, e.g. for threads with scheduling options of their own.
+void TagCurrentThread(Role role);
+
+// CPU time used by the threads of a role.
+Statistics GetStatistics(Role role);
+
+// Short name of a role, e.g. for a HUD.
+const char* GetRoleName(Role role);
+
+// Cores of a core set. Cores are told apart by their maximum frequency, the
+// big cores being the fastest ones. Empty for WorkerPool::kAnyCores, or when
+// the frequencies are not readable.
+std::vector<int> GetCores(WorkerPool::CoreSet core_set);
+
+}  // namespace thread_policy
+}  // namespace tango_gl
+#endif  // TANGO_GL_THREAD_POLICY_H_
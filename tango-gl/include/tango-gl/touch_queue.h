@@ -0,0 +1,75 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_GL_TOUCH_QUEUE_H_
+#define TANGO_GL_TOUCH_QUEUE_H_
+
+#include <stddef.h>
+
+#include <functional>
+
+#include "tango-gl/bounded_queue.h"
+#include "tango-gl/gesture_camera.h"
+
+namespace tango_gl {
+
+// TouchQueue carries touch events from the UI thread to the GL thread.
+//
+// Push() only copies the event into a lock-free ring, so the JNI call
+// delivering a touch returns right away and can be a fast native call, see
+// jni::RegisterNatives(). The GL thread drains the ring once per frame and
+// applies the events before rendering, so the gesture camera is only touched
+// by the thread drawing with it. A run of moves is applied as its last move:
+// GestureCamera moves are relative to the touch down, the skipped moves would
+// be overwritten within the same frame anyway.
+class TouchQueue {
+ public:
+  struct Touch {
+    int touch_count;
+    GestureCamera::TouchEvent event;
+    float x0;
+    float y0;
+    float x1;
+    float y1;
+  };
+
+  // Touches queued between two frames before new ones are dropped.
+  static const size_t kCapacity = 256;
+
+  TouchQueue();
+  TouchQueue(const TouchQueue& other) = delete;
+  const TouchQueue& operator=(const TouchQueue&) = delete;
+
+  // UI thread. Queue a touch event, same parameters as
+  // GestureCamera::OnTouchEvent().
+  //
+  // @return false if the queue is full and the event was dropped.
+  bool Push(int touch_count, GestureCamera::TouchEvent event, float x0,
+            float y0, float x1, float y1);
+
+  // GL thread. Apply the queued events in order, consecutive moves with the
+  // same touch count coalesced into the last one.
+  //
+  // @param apply: called for each event to apply.
+  // @return number of events applied.
+  size_t Drain(const std::function<void(const Touch&)>& apply);
+
+ private:
+  BoundedQueue<Touch> touches_;
+};
+}  // namespace tango_gl
+#endif  // TANGO_GL_TOUCH_QUEUE_H_
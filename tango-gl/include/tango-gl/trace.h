@@ -17,14 +17,40 @@
 #ifndef TANGO_GL_TRACE_H_
 #define TANGO_GL_TRACE_H_
 
-#include "tango-gl/line.h"
+#include "tango-gl/drawable_object.h"
+#include "tango-gl/trajectory_store.h"
 
 namespace tango_gl {
-class Trace : public Line {
+// Trace draws the path of a moving object as a line strip, keeping its most
+// recent positions in a TrajectoryStore. Older positions are simplified, and
+// the strip is drawn from a ring buffer with at most two draw calls, so a
+// long session costs a bounded amount of memory and time.
+class Trace : public DrawableObject {
  public:
   Trace();
+  void SetLineWidth(const float pixels) { line_width_ = pixels; }
+
+  // Append a position if it moved far enough from the last one. Positions
+  // passed without a timestamp are keyed by their index.
   void UpdateVertexArray(const glm::vec3& v);
+  void UpdateVertexArray(double timestamp, const glm::vec3& v);
   void ClearVertexArray();
+
+  // Re-transform the positions added at or after a timestamp, e.g. when the
+  // poses they came from got corrected by a relocalization. The correction
+  // runs in the background and shows up in a later frame.
+  //
+  // @param since_timestamp: oldest timestamp to correct.
+  // @param correction: transformation applied to the positions.
+  void Correct(double since_timestamp, const glm::mat4& correction);
+
+  void Render(const glm::mat4& projection_mat, const glm::mat4& view_mat) const;
+
+ private:
+  float line_width_;
+  double next_index_key_;
+  TrajectoryStore store_;
+  mutable TrajectoryBuffers buffers_;
 };
 }  // namespace tango_gl
 #endif  // TANGO_GL_TRACE_H_
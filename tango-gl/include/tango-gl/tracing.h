@@ -0,0 +1,120 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_GL_TRACING_H_
+#define TANGO_GL_TRACING_H_
+
+#include <stdint.h>
+
+#include <mutex>
+
+// Span tracer for the Tango callback threads and the GL thread, written in
+// the Chrome trace event format (load the file in chrome://tracing).
+//
+// Tracing is compiled in with -DTANGO_GL_TRACING. Without it the macros
+// below expand to nothing, or to a plain std::lock_guard, and cost nothing:
+//
+//  void App::OnXYZijAvailable(const TangoXYZij* xyz_ij) {
+//    TANGO_GL_TRACE_SCOPE("OnXYZijAvailable");
+//    TANGO_GL_TRACE_LOCK_GUARD(lock, point_cloud_mutex_);
+//    ...
+//  }
+//
+// Each thread records into its own ring buffer of the most recent events,
+// so recording never contends with other threads. Names must be string
+// literals, only their address is stored.
+
+#ifdef TANGO_GL_TRACING
+#define TANGO_GL_TRACE_CONCAT_INNER(a, b) a##b
+#define TANGO_GL_TRACE_CONCAT(a, b) TANGO_GL_TRACE_CONCAT_INNER(a, b)
+// Record the enclosing scope as a span.
+#define TANGO_GL_TRACE_SCOPE(name)                 \
+  tango_gl::tracing::ScopedSpan TANGO_GL_TRACE_CONCAT( \
+      tango_gl_trace_span_, __LINE__)(name)
+// Lock a mutex like std::lock_guard, recording the time spent waiting for it.
+#define TANGO_GL_TRACE_LOCK_GUARD(lock, mutex) \
+  tango_gl::tracing::TracedLockGuard<decltype(mutex)> lock(mutex, #mutex)
+// Name the calling thread in the trace.
+#define TANGO_GL_TRACE_THREAD_NAME(name) \
+  tango_gl::tracing::SetThreadName(name)
+// Write the recorded events to a file.
+#define TANGO_GL_TRACE_DUMP(path) tango_gl::tracing::DumpChromeTrace(path)
+#else
+#define TANGO_GL_TRACE_SCOPE(name)
+#define TANGO_GL_TRACE_LOCK_GUARD(lock, mutex) \
+  std::lock_guard<decltype(mutex)> lock(mutex)
+#define TANGO_GL_TRACE_THREAD_NAME(name)
+#define TANGO_GL_TRACE_DUMP(path)
+#endif  // TANGO_GL_TRACING
+
+namespace tango_gl {
+namespace tracing {
+
+// Microseconds on the monotonic clock.
+uint64_t NowMicroseconds();
+
+// Record a span of the calling thread.
+//
+// @param name: string literal naming the span.
+// @param category: string literal grouping spans, e.g. "lock".
+// @param start_us: start time, from NowMicroseconds().
+// @param duration_us: duration in microseconds.
+void RecordSpan(const char* name, const char* category, uint64_t start_us,
+                uint64_t duration_us);
+
+// Name the calling thread in the trace.
+void SetThreadName(const char* name);
+
+// Write the events of all threads to a Chrome trace JSON file, e.g. on the
+// sdcard. Recording carries on while the file is written.
+//
+// @return false if the file could not be written.
+bool DumpChromeTrace(const char* path);
+
+class ScopedSpan {
+ public:
+  explicit ScopedSpan(const char* name)
+      : name_(name), start_us_(NowMicroseconds()) {}
+  ScopedSpan(const ScopedSpan& other) = delete;
+  const ScopedSpan& operator=(const ScopedSpan&) = delete;
+  ~ScopedSpan() {
+    RecordSpan(name_, "span", start_us_, NowMicroseconds() - start_us_);
+  }
+
+ private:
+  const char* name_;
+  uint64_t start_us_;
+};
+
+template <typename Mutex>
+class TracedLockGuard {
+ public:
+  TracedLockGuard(Mutex& mutex, const char* name) : mutex_(mutex) {
+    uint64_t start_us = NowMicroseconds();
+    mutex_.lock();
+    RecordSpan(name, "lock", start_us, NowMicroseconds() - start_us);
+  }
+  TracedLockGuard(const TracedLockGuard& other) = delete;
+  const TracedLockGuard& operator=(const TracedLockGuard&) = delete;
+  ~TracedLockGuard() { mutex_.unlock(); }
+
+ private:
+  Mutex& mutex_;
+};
+}  // namespace tracing
+}  // namespace tango_gl
+#endif  // TANGO_GL_TRACING_H_
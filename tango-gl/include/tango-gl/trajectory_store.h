@@ -0,0 +1,197 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_GL_TRAJECTORY_STORE_H_
+#define TANGO_GL_TRAJECTORY_STORE_H_
+
+#include <stdint.h>
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "tango-gl/util.h"
+#include "tango-gl/vertex_buffer.h"
+
+namespace tango_gl {
+
+// TrajectoryStore keeps the points of a trajectory keyed by timestamp in a
+// ring of fixed size chunks, for drawables such as Trace and Band which mirror
+// it in a ring vertex buffer, see TrajectoryBuffers. Dropping the oldest points drops a whole chunk
+// instead of shifting every kept point, and only chunks whose points changed
+// need to be uploaded again.
+//
+// Line strips can also be simplified as they age: with a tolerance set, a
+// full newest chunk has its older points thinned out with Douglas-Peucker
+// instead of being closed, so a fixed number of points covers a much longer
+// trajectory.
+//
+// When poses get corrected, e.g. on relocalization to an ADF, Correct()
+// re-transforms the points recorded since a timestamp. The affected chunks
+// are copied and transformed in bulk on a worker thread, and written back
+// marked dirty, so the render thread does not pay for the correction.
+//
+// Points are added and read on the render thread, with Lock() held while
+// reading chunks, the worker only takes the lock to copy and write back.
+class TrajectoryStore {
+ public:
+  // Points per chunk.
+  static const size_t kChunkSize = 256;
+  // Most recent points left as they are by simplification.
+  static const size_t kRecentPointCount = 32;
+
+  struct Chunk {
+    // Unique per chunk for the lifetime of the store, for renderers to map
+    // their buffers.
+    uint64_t id;
+    std::vector<double> timestamps;
+    std::vector<glm::vec3> points;
+    // Index of the first point not uploaded yet, the renderer moves it to
+    // points.size() through MarkUploaded() once it uploaded the chunk.
+    mutable size_t first_dirty_point;
+    // Points at the front already simplified, see SetSimplifyTolerance().
+    size_t simplified_point_count;
+  };
+
+  // @param max_point_count: points kept, the oldest are dropped a chunk at a
+  //        time.
+  // @param overlap: points repeated at the start of each chunk from the end
+  //        of the previous one, so strips drawn per chunk connect. 1 for line
+  //        strips, 2 for triangle strips.
+  TrajectoryStore(size_t max_point_count, size_t overlap);
+  TrajectoryStore(const TrajectoryStore& other) = delete;
+  const TrajectoryStore& operator=(const TrajectoryStore&) = delete;
+  ~TrajectoryStore();
+
+  // Simplify points once they are older than the last kRecentPointCount, by
+  // dropping those within tolerance of the polyline through the others.
+  // Only for stores with an overlap of 1, 0 (the default) disables it.
+  // Chunks being corrected are not simplified.
+  void SetSimplifyTolerance(float tolerance);
+
+  // Append a point. Timestamps are expected not to decrease.
+  void Add(double timestamp, const glm::vec3& point);
+
+  // Drop all points, including those of running corrections.
+  void Clear();
+
+  // Re-transform the points with a timestamp at or after since_timestamp,
+  // asynchronously. Points added after this call are kept as they are.
+  //
+  // @param since_timestamp: oldest timestamp to correct.
+  // @param correction: transformation applied to the points.
+  void Correct(double since_timestamp, const glm::mat4& correction);
+
+  // Wait for running corrections to be written back.
+  void WaitForCorrections();
+
+  size_t GetPointCount() const;
+
+  // Upper bound of the number of chunks, all full but the newest one.
+  size_t GetMaxChunkCount() const { return max_chunk_count_; }
+
+  // Get the most recent point.
+  //
+  // @return false if the store is empty.
+  bool GetLastPoint(glm::vec3* point) const;
+
+  // Guards the chunks while they are read, e.g. for uploading and drawing.
+  std::unique_lock<std::mutex> Lock() const {
+    return std::unique_lock<std::mutex>(mutex_);
+  }
+
+  // Chunks from oldest to newest, only valid while Lock() is held.
+  const std::deque<std::unique_ptr<Chunk>>& GetChunks() const {
+    return chunks_;
+  }
+
+  // Tell the store the renderer uploaded all points of a chunk, with Lock()
+  // held.
+  void MarkUploaded(const Chunk& chunk) const;
+
+ private:
+  struct Correction {
+    uint64_t generation;
+    double since_timestamp;
+    glm::mat4 correction;
+  };
+
+  // Thin out the older points of a full chunk, with mutex_ held.
+  void Simplify(Chunk* chunk);
+
+  void WorkerLoop();
+
+  // Copy, transform and write back the points affected by a correction.
+  void RunCorrection(const Correction& correction);
+
+  const size_t max_chunk_count_;
+  const size_t overlap_;
+  float simplify_tolerance_;
+
+  mutable std::mutex mutex_;
+  std::deque<std::unique_ptr<Chunk>> chunks_;
+  // Chunks dropped from the front, reused to avoid allocations.
+  std::vector<std::unique_ptr<Chunk>> free_chunks_;
+  uint64_t next_chunk_id_;
+  size_t point_count_;
+  // Bumped by Clear(), corrections queued before are dropped.
+  uint64_t generation_;
+
+  // Correction queue, guarded by mutex_.
+  std::condition_variable corrections_changed_;
+  std::deque<Correction> corrections_;
+  bool is_correcting_;
+  bool is_stopping_;
+  std::thread worker_;
+};
+
+// TrajectoryBuffers mirrors a TrajectoryStore in one ring vertex buffer with
+// a slot per chunk, uploading only the points that changed. Full chunks are
+// contiguous in the ring, so the whole trajectory is drawn with one draw
+// call, or two when it wraps around the end of the ring, however long it
+// is. All functions must be called on the GL thread.
+class TrajectoryBuffers {
+ public:
+  // Called once or twice per Draw() with the ring bound, to issue the draw
+  // call of a range of points.
+  typedef std::function<void(size_t first_point, size_t point_count)>
+      DrawFunction;
+
+  TrajectoryBuffers();
+  TrajectoryBuffers(const TrajectoryBuffers& other) = delete;
+  const TrajectoryBuffers& operator=(const TrajectoryBuffers&) = delete;
+
+  // Upload the changed chunks of the store and draw them from oldest to
+  // newest.
+  //
+  // @param store: the trajectory, locked while it is drawn.
+  // @param attrib_vertices: vertex attribute the points are bound to.
+  // @param draw: issues the draw calls.
+  void Draw(const TrajectoryStore& store, GLuint attrib_vertices,
+            const DrawFunction& draw);
+
+ private:
+  VertexBuffer ring_;
+  // Id of the chunk uploaded to each slot of the ring.
+  std::vector<uint64_t> slot_chunk_ids_;
+};
+}  // namespace tango_gl
+#endif  // TANGO_GL_TRAJECTORY_STORE_H_
@@ -17,10 +17,20 @@
 #ifndef TANGO_GL_TRANSFORM_H_
 #define TANGO_GL_TRANSFORM_H_
 
+#include <stdint.h>
+
 #include "glm/glm.hpp"
 #include "glm/gtc/quaternion.hpp"
 
 namespace tango_gl {
+// Position, rotation and scale of an object relative to its parent.
+//
+// The local and world matrices are cached. The local matrix is rebuilt only
+// after one of its components changed, and the world matrix only after the
+// local matrix or the parent's world matrix changed; the latter is detected
+// with a version number bumped on every rebuild, so children need no links
+// from their parents. A matrix passed to SetTransformationMatrix() is kept
+// as is and only decomposed if a component is read or changed.
 class Transform {
  public:
   Transform();
@@ -41,7 +51,9 @@ class Transform {
   void Translate(const glm::vec3& translation);
 
   void SetTransformationMatrix(const glm::mat4& transform_mat);
-  glm::mat4 GetTransformationMatrix() const;
+
+  // World matrix, including the transformations of all parents.
+  const glm::mat4& GetTransformationMatrix() const;
 
   void SetParent(Transform* transform);
 
@@ -49,11 +61,27 @@ class Transform {
   Transform* GetParent() ;
 
  private:
+  // Decompose local_mat_ if it was set directly.
+  void UpdateComponents() const;
+
   Transform* parent_;
 
-  glm::vec3 position_;
-  glm::quat rotation_;
-  glm::vec3 scale_;
+  // Valid unless are_components_dirty_.
+  mutable glm::vec3 position_;
+  mutable glm::quat rotation_;
+  mutable glm::vec3 scale_;
+  mutable bool are_components_dirty_;
+
+  // Valid unless is_local_mat_dirty_.
+  mutable glm::mat4 local_mat_;
+  mutable bool is_local_mat_dirty_;
+
+  // Valid unless is_world_mat_dirty_ or the parent's world matrix version
+  // differs from parent_world_mat_version_.
+  mutable glm::mat4 world_mat_;
+  mutable bool is_world_mat_dirty_;
+  mutable uint32_t world_mat_version_;
+  mutable uint32_t parent_world_mat_version_;
 };
 }  // namespace tango_gl
 #endif  // TANGO_GL_TRANSFORM_H_
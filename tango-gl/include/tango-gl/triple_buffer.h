@@ -0,0 +1,103 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TANGO_GL_TRIPLE_BUFFER_H_
+#define TANGO_GL_TRIPLE_BUFFER_H_
+
+#include <atomic>
+
+namespace tango_gl {
+
+// Lock-free single producer, single consumer triple buffer.
+//
+// The producer (e.g. a Tango Service callback) fills the write slot and
+// publishes it, the consumer (e.g. the GL thread) acquires the most recently
+// published slot. Neither side ever blocks the other: the two threads only
+// exchange slot indices through one atomic, and a frame that was published but
+// never acquired is overwritten by the next one instead of being queued.
+//
+// Slots are owned by exactly one side between handoffs, so the producer may
+// resize its write slot (e.g. on the first frame) without synchronization.
+// The exchange in Publish() releases the writes to the slot and the exchange
+// in Acquire() acquires them, the relaxed loads only decide whether an
+// exchange is needed. This is the handoff the examples use between the Tango
+// callback threads, worker stages and the GL thread in place of a mutex, so
+// a callback is never held up by the render thread or the other way round.
+template <typename T>
+class TripleBuffer {
+ public:
+  static const int kSlotCount = 3;
+
+  TripleBuffer() : write_index_(0), read_index_(1), shared_state_(2) {}
+  TripleBuffer(const TripleBuffer& other) = delete;
+  const TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+  // Producer side. Slot to be filled before calling Publish().
+  T* GetWriteBuffer() { return &slots_[write_index_]; }
+
+  // Producer side. Hand the write slot over to the consumer and take the
+  // shared slot back as the new write slot.
+  void Publish() {
+    int previous = shared_state_.exchange(write_index_ | kNewDataBit,
+                                          std::memory_order_acq_rel);
+    write_index_ = previous & kIndexMask;
+  }
+
+  // Consumer side. Swap in the latest published slot, if any.
+  //
+  // @return: true if a new slot was acquired, false if GetReadBuffer() still
+  //          refers to the previously acquired data.
+  bool Acquire() {
+    if ((shared_state_.load(std::memory_order_relaxed) & kNewDataBit) == 0) {
+      return false;
+    }
+    int previous =
+        shared_state_.exchange(read_index_, std::memory_order_acq_rel);
+    read_index_ = previous & kIndexMask;
+    return true;
+  }
+
+  // Consumer side. Slot acquired by the last successful Acquire().
+  T* GetReadBuffer() { return &slots_[read_index_]; }
+  const T* GetReadBuffer() const { return &slots_[read_index_]; }
+
+  // Slot by index, 0 to kSlotCount - 1. Only while no thread uses the
+  // buffer, e.g. to free what the slots hold on destruction.
+  T* GetSlot(int index) { return &slots_[index]; }
+
+  // Consumer side. True if a slot was published and not yet acquired.
+  bool HasNewData() const {
+    return (shared_state_.load(std::memory_order_relaxed) & kNewDataBit) != 0;
+  }
+
+ private:
+  static const int kIndexMask = 0x3;
+  static const int kNewDataBit = 0x4;
+
+  T slots_[kSlotCount];
+
+  // Only touched by the producer.
+  int write_index_;
+
+  // Only touched by the consumer.
+  int read_index_;
+
+  // Index of the slot in flight between the two threads, plus kNewDataBit if
+  // it holds data the consumer has not acquired yet.
+  std::atomic<int> shared_state_;
+};
+}  // namespace tango_gl
+#endif  // TANGO_GL_TRIPLE_BUFFER_H_
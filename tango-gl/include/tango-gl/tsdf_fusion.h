@@ -0,0 +1,142 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_GL_TSDF_FUSION_H_
+#define TANGO_GL_TSDF_FUSION_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "tango-gl/keyframe_selector.h"
+#include "tango-gl/point_cloud_pool.h"
+#include "tango-gl/point_projection.h"
+#include "tango-gl/tsdf_mesher.h"
+#include "tango-gl/tsdf_volume.h"
+#include "tango-gl/util.h"
+#include "tango-gl/worker_pool.h"
+
+namespace tango_gl {
+
+// TsdfFusion integrates depth frames into a TsdfVolume on a background
+// thread, so the depth callback and the GL thread never wait for it.
+//
+// Only the latest submitted frame is integrated, frames arriving while a
+// frame is being fused replace each other. The voxels of a frame are
+// integrated in parallel on a worker pool owned by the fusion.
+//
+// After each frame the blocks it changed are meshed with a TsdfMesher. The
+// block meshes wait, latest per block, until the renderer takes them.
+//
+// With keyframe options, only the frames a KeyframeSelector picks are fused,
+// so a device looking at what is already fused costs no integration.
+//
+// With a BlockStore, the blocks farther from the device than a radius are
+// paged out every few frames, and the paged out blocks within it are
+// prefetched, so long sessions are not limited by the block pool.
+class TsdfFusion {
+ public:
+  explicit TsdfFusion(const TsdfVolume::Options& options);
+  TsdfFusion(const TsdfFusion& other) = delete;
+  const TsdfFusion& operator=(const TsdfFusion&) = delete;
+  ~TsdfFusion();
+
+  // Start the fusion thread with an empty volume. Meshes taken before are
+  // stale, the renderer is expected to drop them.
+  //
+  // @param device_T_depth: fixed pose of the depth camera with respect to the
+  //        device.
+  // @param intrinsics: depth camera intrinsics.
+  void Start(const glm::mat4& device_T_depth,
+             const projection::CameraIntrinsics& intrinsics);
+
+  // Page the volume to a store while fusing. Call before Start().
+  //
+  // @param store: open store owned by the caller, nullptr to stop paging.
+  // @param resident_radius: distance in meters from the device within which
+  //        blocks stay in memory, at least the max_depth of the volume.
+  void SetBlockStore(BlockStore* store, float resident_radius);
+
+  // Only fuse keyframes. Call before Start().
+  //
+  // @param options: keyframe selection, nullptr to fuse every frame, the
+  //        default.
+  void SetKeyframeOptions(const KeyframeSelector::Options* options);
+
+  // Stop the fusion thread, dropping any pending frame. The volume keeps the
+  // frames fused so far.
+  void Stop();
+
+  // Hand a depth frame to the fusion thread. Intended to be called from the
+  // point cloud callback, the frame is shared, not copied.
+  //
+  // @param frame: points in the depth camera frame, with the device pose at
+  //        the frame timestamp with respect to start of service.
+  void Submit(const PointCloudPool::Handle& frame);
+
+  // Take the block meshes extracted since the previous call, at most one
+  // per block. Intended to be called from the GL thread, it only waits for
+  // the fusion thread to hand over a frame of meshes, never for a frame to
+  // be fused.
+  //
+  // @param meshes: output meshes, replaced.
+  void TakeMeshUpdates(std::vector<TsdfMesher::BlockMesh>* meshes);
+
+  // Number of frames fused since Start(). Can be called from any thread.
+  int GetFusedFrameCount() const { return fused_frame_count_.load(); }
+
+  // Number of frames since Start() not fused because they were no keyframe.
+  // Can be called from any thread.
+  int GetSkippedFrameCount() const { return skipped_frame_count_.load(); }
+
+ private:
+  void FusionLoop();
+
+  // The shared pool.
+  WorkerPool* worker_pool_;
+  std::thread thread_;
+
+  // Latest submitted frame, guarded by mutex_.
+  std::mutex mutex_;
+  std::condition_variable frame_available_;
+  PointCloudPool::Handle pending_frame_;
+  bool is_stopping_;
+
+  // Only touched by the fusion thread while it runs.
+  glm::mat4 device_T_depth_;
+  projection::CameraIntrinsics intrinsics_;
+  TsdfVolume volume_;
+  TsdfMesher mesher_;
+  float resident_radius_;
+  // nullptr when every frame is fused.
+  std::unique_ptr<KeyframeSelector> keyframe_selector_;
+  std::vector<TsdfMesher::BlockMesh> extracted_meshes_;
+
+  // Meshes not taken yet by TakeMeshUpdates(), by block key, guarded by
+  // mesh_mutex_.
+  std::mutex mesh_mutex_;
+  std::unordered_map<uint64_t, TsdfMesher::BlockMesh> pending_meshes_;
+
+  std::atomic<int> fused_frame_count_;
+  std::atomic<int> skipped_frame_count_;
+};
+}  // namespace tango_gl
+#endif  // TANGO_GL_TSDF_FUSION_H_
@@ -0,0 +1,79 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_GL_TSDF_MESH_RENDERER_H_
+#define TANGO_GL_TSDF_MESH_RENDERER_H_
+
+#include <stdint.h>
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "tango-gl/color.h"
+#include "tango-gl/mesh.h"
+#include "tango-gl/tsdf_mesher.h"
+#include "tango-gl/util.h"
+#include "tango-gl/view_frustum.h"
+
+namespace tango_gl {
+
+// TsdfMeshRenderer draws the block meshes of a TsdfMesher, one lit
+// tango_gl::Mesh per block. Updating a block only re-uploads the buffers of
+// that block, and blocks outside the view frustum are skipped.
+//
+// Must be created, used and destroyed on the GL thread.
+class TsdfMeshRenderer {
+ public:
+  // @param voxel_size: voxel size of the volume the meshes come from.
+  explicit TsdfMeshRenderer(float voxel_size);
+  TsdfMeshRenderer(const TsdfMeshRenderer& other) = delete;
+  const TsdfMeshRenderer& operator=(const TsdfMeshRenderer&) = delete;
+  ~TsdfMeshRenderer();
+
+  void SetColor(const Color& color);
+
+  // Replace the meshes of the updated blocks, dropping blocks with an empty
+  // mesh.
+  //
+  // @param meshes: block meshes, their vectors are consumed.
+  void Update(std::vector<TsdfMesher::BlockMesh>* meshes);
+
+  // Drop every block.
+  void Clear() { chunks_.clear(); }
+
+  // @param view_frustum: view frustum of the render camera, in the volume
+  //        frame like the meshes.
+  void Render(const glm::mat4& projection_mat, const glm::mat4& view_mat,
+              ViewFrustum* view_frustum) const;
+
+  size_t GetChunkCount() const { return chunks_.size(); }
+
+ private:
+  struct Chunk {
+    std::unique_ptr<Mesh> mesh;
+    // Bounds of the block cells.
+    glm::vec3 min;
+    glm::vec3 max;
+  };
+
+  float voxel_size_;
+  Color color_;
+  std::unordered_map<uint64_t, Chunk> chunks_;
+};
+}  // namespace tango_gl
+#endif  // TANGO_GL_TSDF_MESH_RENDERER_H_
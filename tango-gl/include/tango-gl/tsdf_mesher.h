@@ -0,0 +1,86 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_GL_TSDF_MESHER_H_
+#define TANGO_GL_TSDF_MESHER_H_
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "tango-gl/tsdf_volume.h"
+#include "tango-gl/util.h"
+#include "tango-gl/worker_pool.h"
+
+namespace tango_gl {
+
+// TsdfMesher extracts the surface of a TsdfVolume with marching cubes, one
+// mesh per block, and only for the blocks that changed since the previous
+// extraction.
+//
+// The cells of a block span its voxels and the first voxels of its +x, +y
+// and +z neighbors, so a changed block also re-meshes the neighbors whose
+// cells reach into it. Within a block mesh every lattice edge yields a
+// single vertex shared by the cells around it, and vertices on block
+// borders are interpolated from the same voxels in both blocks, so chunks
+// meet without cracks.
+//
+// Blocks are meshed in parallel on the worker pool.
+class TsdfMesher {
+ public:
+  // Surface of a block in the volume frame. Normals follow the distance
+  // gradient, i.e. point to free space, and front faces wind counter
+  // clockwise.
+  struct BlockMesh {
+    // Block coordinates, see TsdfVolume::Block.
+    int32_t x;
+    int32_t y;
+    int32_t z;
+    // Empty when the block has no surface anymore.
+    std::vector<GLfloat> vertices;
+    std::vector<GLfloat> normals;
+    std::vector<GLushort> indices;
+  };
+
+  // @param worker_pool: pool to mesh blocks in parallel on, can be nullptr to
+  //        mesh on the calling thread only.
+  explicit TsdfMesher(WorkerPool* worker_pool);
+  TsdfMesher(const TsdfMesher& other) = delete;
+  const TsdfMesher& operator=(const TsdfMesher&) = delete;
+  ~TsdfMesher();
+
+  // Forget the previous extraction, the next one meshes every block.
+  void Reset() { extracted_revision_ = 0; }
+
+  // Mesh the blocks changed since the previous call.
+  //
+  // @param volume: the volume, not modified during the call.
+  // @param meshes: output meshes, one per re-meshed block. Resized, the
+  //        vectors of existing elements are reused.
+  // @return the number of meshes.
+  size_t Extract(const TsdfVolume& volume, std::vector<BlockMesh>* meshes);
+
+ private:
+  void MeshBlock(const TsdfVolume& volume, int32_t index,
+                 BlockMesh* mesh) const;
+
+  WorkerPool* worker_pool_;
+  uint32_t extracted_revision_;
+  std::vector<int32_t> dirty_blocks_;
+};
+}  // namespace tango_gl
+#endif  // TANGO_GL_TSDF_MESHER_H_
@@ -0,0 +1,243 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_GL_TSDF_VOLUME_H_
+#define TANGO_GL_TSDF_VOLUME_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include "tango-gl/block_store.h"
+#include "tango-gl/point_projection.h"
+#include "tango-gl/util.h"
+#include "tango-gl/worker_pool.h"
+
+namespace tango_gl {
+
+// TsdfVolume fuses depth frames into a truncated signed distance field, to
+// reconstruct surfaces from the depth stream.
+//
+// Voxels are grouped in blocks of kBlockSize^3 which are only allocated
+// along the observed surfaces, within the truncation distance of a depth
+// point. Blocks come from a pool of fixed size and are found through an
+// open addressing hash table. Once the pool is exhausted new surfaces are
+// not fused anymore.
+//
+// With a BlockStore, PageOut() moves the blocks away from the device to
+// disk, freeing their pool entries, and a block is read back when a frame
+// observes it again or through PageIn(). Meshes of paged out blocks stay
+// valid, restored blocks keep their revision.
+//
+// Integrate() fuses a frame in three steps:
+//
+// 1. The points are splatted into a low resolution depth image, keeping the
+//    nearest depth per pixel.
+// 2. The blocks around every point are looked up, or allocated.
+// 3. The voxels of those blocks are projected into the depth image and
+//    their distances updated with a running weighted mean. Blocks are
+//    processed in parallel on the worker pool, and the update runs four
+//    voxels at a time on NEON capable devices.
+//
+// A TsdfVolume is not thread safe, callers serialize Integrate() and reads.
+class TsdfVolume {
+ public:
+  // Edge of a block in voxels.
+  static const int kBlockSize = 8;
+  static const int kVoxelsPerBlock = kBlockSize * kBlockSize * kBlockSize;
+
+  struct Options {
+    Options()
+        : voxel_size(0.03f),
+          truncation_distance(0.09f),
+          max_weight(64.0f),
+          max_depth(4.0f),
+          depth_image_scale(0.25f),
+          max_block_count(8192) {}
+
+    // Edge of a voxel in meters.
+    float voxel_size;
+    // Distances are truncated to [-truncation_distance,
+    // truncation_distance], voxels farther behind a surface are not updated.
+    // Must be smaller than a block.
+    float truncation_distance;
+    // Weight a voxel saturates at, lower values follow moving geometry
+    // faster.
+    float max_weight;
+    // Points farther than this in meters are ignored.
+    float max_depth;
+    // Resolution of the depth image relative to the depth camera. The depth
+    // camera returns far fewer points than it has pixels, a coarse image
+    // keeps the splatted depth dense.
+    float depth_image_scale;
+    // Number of blocks in the pool. Each block takes kBlockSize^3 * 8 bytes.
+    size_t max_block_count;
+  };
+
+  // Voxels of a block, x varying fastest. Distances are in meters, positive
+  // in front of the surface; a weight of 0 marks a voxel never observed.
+  struct Block {
+    // Block coordinates, the block spans [x, x + 1) * kBlockSize * voxel_size
+    // along x, and so on.
+    int32_t x;
+    int32_t y;
+    int32_t z;
+    // Value of GetRevision() when the block was last updated.
+    uint32_t revision;
+    float distance[kVoxelsPerBlock];
+    float weight[kVoxelsPerBlock];
+  };
+
+  // @param options: volume parameters.
+  // @param worker_pool: pool to integrate blocks in parallel on, can be
+  //        nullptr to integrate on the calling thread only.
+  TsdfVolume(const Options& options, WorkerPool* worker_pool);
+  TsdfVolume(const TsdfVolume& other) = delete;
+  const TsdfVolume& operator=(const TsdfVolume&) = delete;
+  ~TsdfVolume();
+
+  // Drop every block, including the paged out blocks.
+  void Clear();
+
+  // Page blocks out to a store.
+  //
+  // @param store: store owned by the caller, used by this volume only,
+  //        nullptr to stop paging. The blocks it holds stay there.
+  void SetBlockStore(BlockStore* store) { block_store_ = store; }
+
+  // Page out the blocks farther than a distance from a position.
+  //
+  // @param center: position in the volume frame, e.g. the device.
+  // @param radius: distance in meters from center to the nearest point of a
+  //        block.
+  // @return the number of blocks paged out.
+  size_t PageOut(const glm::vec3& center, float radius);
+
+  // Bring the paged out blocks within a distance of a position back, while
+  // the pool has free blocks.
+  //
+  // @return the number of blocks paged in.
+  size_t PageIn(const glm::vec3& center, float radius);
+
+  // Decompress the paged out blocks within a distance of a position ahead of
+  // the PageIn() or Integrate() that needs them, on the store thread.
+  void Prefetch(const glm::vec3& center, float radius);
+
+  // Fuse a depth frame.
+  //
+  // @param xyz: packed x, y, z coordinates in the depth camera frame.
+  // @param point_count: number of points.
+  // @param volume_T_depth: pose of the depth camera with respect to the
+  //        volume frame, e.g. start of service, at the frame timestamp.
+  // @param intrinsics: depth camera intrinsics.
+  // @return the number of blocks updated.
+  size_t Integrate(const float* xyz, size_t point_count,
+                   const glm::mat4& volume_T_depth,
+                   const projection::CameraIntrinsics& intrinsics);
+
+  const Options& GetOptions() const { return options_; }
+
+  // Number of Integrate() calls so far, stamped on the blocks they update.
+  uint32_t GetRevision() const { return revision_; }
+
+  // Allocated blocks, indices are stable until Clear() or PageOut().
+  size_t GetBlockCount() const { return block_count_; }
+  const Block& GetBlock(size_t index) const { return blocks_[index]; }
+
+  // Index of the block at block coordinates, -1 if it is not allocated.
+  int32_t FindBlock(int32_t x, int32_t y, int32_t z) const;
+
+  // Unique key of block coordinates, e.g. to index per block data.
+  static uint64_t BlockKey(int32_t x, int32_t y, int32_t z);
+
+ private:
+  int32_t FindBlock(uint64_t key) const;
+
+  // Index of the block at block coordinates, allocated or paged in if
+  // needed. -1 if the pool is exhausted.
+  int32_t AcquireBlock(int32_t x, int32_t y, int32_t z);
+
+  // Remove a block from the table, the last block takes its index.
+  void RemoveBlock(int32_t index);
+
+  // Collect the keys of the blocks within a distance of a position which
+  // are not in the pool, nearest first.
+  void CollectAbsentKeys(const glm::vec3& center, float radius,
+                         std::vector<uint64_t>* keys) const;
+
+  // Splat the points into depth_image_.
+  void RenderDepthImage(const float* xyz, size_t point_count,
+                        const projection::CameraIntrinsics& intrinsics);
+
+  // Collect the blocks within the truncation distance of the points into
+  // frame_blocks_.
+  void AllocateBlocks(const float* xyz, size_t point_count,
+                      const glm::mat4& volume_T_depth);
+
+  // Update the voxels of a block from depth_image_.
+  void IntegrateBlock(int32_t index, const glm::mat4& depth_T_volume);
+
+  Options options_;
+  WorkerPool* worker_pool_;
+
+  std::vector<Block> blocks_;
+  size_t block_count_;
+  uint32_t revision_;
+  bool has_logged_full_;
+
+  // Open addressing table of block indices, -1 for an empty slot. Twice the
+  // pool size, a power of two.
+  std::vector<int32_t> table_;
+  size_t table_mask_;
+
+  // Not owned, nullptr without paging.
+  BlockStore* block_store_;
+
+  // Per frame scratch, reused between frames.
+  projection::CameraIntrinsics image_intrinsics_;
+  std::vector<float> depth_image_;
+  std::vector<int32_t> pixels_;
+  std::vector<float> depths_;
+  std::vector<int32_t> frame_blocks_;
+};
+
+namespace internal {
+// Fuse depth observations into voxels, the inner loop of
+// TsdfVolume::Integrate().
+//
+// @param voxel_depths: depth of each voxel center in the camera frame.
+// @param measured_depths: depth of the surface at the pixel of each voxel,
+//        0 where there is none.
+// @param count: number of voxels.
+// @param truncation_distance: see TsdfVolume::Options.
+// @param max_weight: see TsdfVolume::Options.
+// @param distances: voxel distances, updated in place.
+// @param weights: voxel weights, updated in place.
+void UpdateVoxels(const float* voxel_depths, const float* measured_depths,
+                  size_t count, float truncation_distance, float max_weight,
+                  float* distances, float* weights);
+
+// NEON kernel, defined in tsdf_volume_neon.cpp. Updates the first
+// count & ~3 voxels; the caller updates the remaining voxels.
+void UpdateVoxelsNeon(const float* voxel_depths, const float* measured_depths,
+                      size_t count, float truncation_distance,
+                      float max_weight, float* distances, float* weights);
+}  // namespace internal
+
+}  // namespace tango_gl
+#endif  // TANGO_GL_TSDF_VOLUME_H_
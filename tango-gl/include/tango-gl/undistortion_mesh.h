@@ -0,0 +1,87 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_GL_UNDISTORTION_MESH_H_
+#define TANGO_GL_UNDISTORTION_MESH_H_
+
+#include <vector>
+
+#include "tango-gl/camera_intrinsics_registry.h"
+#include "tango-gl/util.h"
+#include "tango-gl/vertex_array.h"
+#include "tango-gl/vertex_buffer.h"
+
+namespace tango_gl {
+
+// UndistortionMesh draws a camera image undistorted with the pinhole model of
+// its intrinsics. The image is drawn as a grid over the [-1, 1] square in x
+// and y, z = 0, with the texture coordinates of every grid vertex looked up in
+// a distortion map. The map is baked once from the intrinsics, so drawing the
+// mesh costs about as much as drawing the plain quad: the per pixel work is
+// the same texture fetch, only the vertex count grows.
+//
+// Without a distortion map the mesh is the plain textured quad. Texture
+// coordinate (0, 0) is at (-1, 1). All functions must be called on the GL
+// thread.
+class UndistortionMesh {
+ public:
+  // Grid size giving sub pixel accuracy for the Tango color camera.
+  static const uint32_t kDefaultGridWidth = 32;
+  static const uint32_t kDefaultGridHeight = 24;
+
+  UndistortionMesh();
+  UndistortionMesh(const UndistortionMesh& other) = delete;
+  const UndistortionMesh& operator=(const UndistortionMesh&) = delete;
+
+  // Upload the grid of a distortion map.
+  //
+  // @param map: the distortion map, nullptr to draw the image as is. At most
+  //        65536 grid samples, the grid is indexed with GLushort.
+  void SetDistortionMap(const CameraIntrinsicsRegistry::DistortionMap* map);
+
+  // Draw the mesh with the bound program.
+  //
+  // @param attrib_vertices: vec3 position attribute.
+  // @param attrib_texture_coords: vec2 texture coordinate attribute.
+  void Draw(GLuint attrib_vertices, GLuint attrib_texture_coords) const;
+
+  // Forget the buffers of a destroyed GL context, they are uploaded again on
+  // the next draw.
+  void Invalidate();
+
+ private:
+  // Fill the client side arrays for a grid, with the texture coordinates of
+  // map or the identity if map is nullptr.
+  void BuildGrid(uint32_t grid_width, uint32_t grid_height,
+                 const CameraIntrinsicsRegistry::DistortionMap* map);
+
+  std::vector<GLfloat> vertices_;
+  std::vector<GLfloat> texture_coords_;
+  std::vector<GLushort> indices_;
+
+  // The arrays are uploaded on the first draw after they changed.
+  mutable bool is_dirty_;
+  mutable VertexBuffer vertex_buffer_;
+  mutable VertexBuffer texture_coords_buffer_;
+  mutable VertexBuffer index_buffer_;
+  mutable VertexArray vertex_array_;
+  // Attributes recorded in vertex_array_.
+  mutable GLuint recorded_attrib_vertices_;
+  mutable GLuint recorded_attrib_texture_coords_;
+};
+}  // namespace tango_gl
+#endif  // TANGO_GL_UNDISTORTION_MESH_H_
@@ -0,0 +1,121 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_GL_UPLOAD_THREAD_H_
+#define TANGO_GL_UPLOAD_THREAD_H_
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace tango_gl {
+
+// UploadThread creates and fills GL buffers and textures off the GL thread,
+// so large uploads, e.g. decoded textures or accumulated geometry, do not
+// cost the frame they arrive in.
+//
+// The thread owns a context sharing the objects of the GL thread context.
+// Each upload is followed by an EGL_KHR_fence_sync fence, and Poll() only
+// hands an upload back to the GL thread once its fence signaled, so the
+// render thread never binds an object the GPU is still filling.
+//
+// Uploads run with a context RenderState does not track: they must use
+// plain GL calls, and only create buffers and textures, which are shared
+// between the contexts, not framebuffers or vertex arrays, which are not.
+// Without a shared context or fences, e.g. on drivers lacking them, the
+// uploads run on the GL thread from Poll() instead, followed by
+// RenderState::Invalidate().
+//
+// Start(), Stop(), Post() and Poll() must be called on the GL thread.
+class UploadThread {
+ public:
+  typedef std::function<void()> Task;
+
+  UploadThread();
+  UploadThread(const UploadThread& other) = delete;
+  const UploadThread& operator=(const UploadThread&) = delete;
+  ~UploadThread();
+
+  // Create the shared context of the current one and start the thread.
+  //
+  // @return false if uploads will run on the GL thread instead.
+  bool Start();
+
+  // Run the queued uploads and their completions, then stop the thread and
+  // destroy its context. Call it before the GL thread context goes away.
+  void Stop();
+
+  // Queue an upload.
+  //
+  // @param upload: runs on the upload thread, with its context current.
+  // @param on_ready: runs on the GL thread from Poll() once the GPU finished
+  //        the upload, e.g. to swap the new object in.
+  void Post(const Task& upload, const Task& on_ready);
+
+  // Run the completions of the finished uploads, in the order they were
+  // posted. Never waits for the GPU.
+  //
+  // @return the number of completions run.
+  int Poll();
+
+  // Whether uploads run on the upload thread.
+  bool IsRunning() const { return thread_.joinable(); }
+
+  // Number of uploads posted whose completion has not run yet.
+  size_t GetPendingCount() const;
+
+ private:
+  struct Upload {
+    Task upload;
+    Task on_ready;
+    // EGL_NO_SYNC_KHR once the upload finished without a fence.
+    EGLSyncKHR fence;
+  };
+
+  // Create the context of the thread, sharing with the current one.
+  bool CreateContext();
+
+  void DestroyContext();
+
+  void ThreadLoop();
+
+  EGLDisplay display_;
+  EGLContext context_;
+  // EGL_NO_SURFACE with EGL_KHR_surfaceless_context, a 1x1 pbuffer
+  // otherwise.
+  EGLSurface surface_;
+  PFNEGLCREATESYNCKHRPROC create_sync_;
+  PFNEGLDESTROYSYNCKHRPROC destroy_sync_;
+  PFNEGLCLIENTWAITSYNCKHRPROC client_wait_sync_;
+
+  std::thread thread_;
+  mutable std::mutex mutex_;
+  std::condition_variable work_available_;
+
+  // Guarded by mutex_.
+  std::deque<Upload> queue_;
+  std::deque<Upload> uploaded_;
+  bool is_uploading_;
+  bool is_stopping_;
+};
+}  // namespace tango_gl
+#endif  // TANGO_GL_UPLOAD_THREAD_H_
@@ -43,9 +43,41 @@
 #define RADIAN_2_DEGREE 57.2957795f
 #define DEGREE_2_RADIANS 0.0174532925f
 
+// Per call GL error checking is compiled in with -DTANGO_GL_DEBUG, which
+// builds without NDEBUG (debug builds) define by default. glGetError waits
+// for the GPU on many drivers, so release builds only sample the error flags
+// once every few frames, see SetGlErrorSampleInterval().
+#if !defined(TANGO_GL_DEBUG) && !defined(NDEBUG)
+#define TANGO_GL_DEBUG
+#endif
+
 namespace tango_gl {
 namespace util {
+#ifdef TANGO_GL_DEBUG
+  // Log the GL errors raised since the last check. A no-op on a context
+  // with GL_KHR_debug output enabled, whose callback reports each error as
+  // it is raised.
   void CheckGlError(const char* operation);
+#else
+  inline void CheckGlError(const char*) {}
+#endif
+
+  // Report GL errors and warnings of the current context through a
+  // GL_KHR_debug callback, synchronously so a breakpoint in it stops at the
+  // faulty call. Debug builds only, RenderState::BeginFrame() calls it when
+  // the context changes.
+  //
+  // @return: false in release builds and without the extension.
+  bool EnableGlDebugOutput();
+
+  // Check the GL error flags once every frame_interval frames, 0 to never
+  // check. Errors raised in between are logged at the next check, without
+  // the call that raised them. Can be called from any thread.
+  void SetGlErrorSampleInterval(int frame_interval);
+
+  // Count a frame and check the error flags if it is a sampled one. Called
+  // by RenderState::BeginFrame().
+  void SampleGlErrors();
 
   GLuint CreateProgram(const char* vertex_source,
                        const char* fragment_source);
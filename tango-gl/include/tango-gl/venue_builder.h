@@ -0,0 +1,57 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_GL_VENUE_BUILDER_H_
+#define TANGO_GL_VENUE_BUILDER_H_
+
+#include "tango-gl/venue_format.h"
+
+namespace tango_gl {
+namespace venue {
+
+struct BuildOptions {
+  BuildOptions()
+      : chunk_size(8.0f), level_count(5), cluster_size(0.04f) {}
+
+  // Edge of a chunk in meters.
+  float chunk_size;
+  // Levels of detail per chunk, at most kMaxLevelCount.
+  int level_count;
+  // Cluster edge of level 1 in meters, doubled at every next level.
+  float cluster_size;
+};
+
+// Convert an OBJ model into a venue file, see venue_format.h. Meant to run
+// offline, e.g. through the venue_build host tool: the whole model is held
+// in memory while building.
+//
+// Coarser levels are built by vertex clustering: the vertices falling into
+// the same cell of a grid are merged into their mean, and triangles that
+// collapse are dropped. The grids are shared by all chunks, so chunks at the
+// same level meet without cracks.
+//
+// @param obj_path: path of the OBJ file. Vertices without normals get area
+//        weighted normals.
+// @param venue_path: path of the venue file, replaced.
+// @param options: build parameters.
+// @return false if the model could not be read or the file written.
+bool Build(const char* obj_path, const char* venue_path,
+           const BuildOptions& options);
+
+}  // namespace venue
+}  // namespace tango_gl
+#endif  // TANGO_GL_VENUE_BUILDER_H_
@@ -0,0 +1,107 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_GL_VENUE_FORMAT_H_
+#define TANGO_GL_VENUE_FORMAT_H_
+
+#include <stdint.h>
+
+namespace tango_gl {
+namespace venue {
+
+// Layout of a venue file, written offline by venue::Build() and streamed by
+// VenueStreamer.
+//
+// The model is cut into chunks on a regular grid of chunk_size meters, each
+// triangle going to the chunk of its centroid. Every chunk holds level_count
+// levels of detail, level 0 being the source triangles and each next level
+// the model clustered on a grid twice as coarse.
+//
+// The file is:
+//
+// - a FileHeader,
+// - the grid, grid_size[0] * grid_size[1] * grid_size[2] int32 chunk indices,
+//   x varying fastest, -1 for empty cells,
+// - chunk_count ChunkRecord,
+// - the level data, each level starting on a kPageSize boundary so it can be
+//   mapped on its own.
+//
+// The data of a level is part_count PartRecord, then vertex_count vertices
+// of 6 floats (position, normal), then index_count 16 bit indices. Each part
+// is one draw call of at most 65536 vertices, its indices relative to its
+// first vertex. All values are little endian.
+
+const uint32_t kMagic = 0x4E565654;  // "TVVN"
+const uint32_t kVersion = 1;
+const int kMaxLevelCount = 8;
+const uint32_t kPageSize = 4096;
+
+struct FileHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t level_count;
+  uint32_t chunk_count;
+  // Edge of a grid cell in meters.
+  float chunk_size;
+  // Chunk coordinates of the first grid cell, chunk (x, y, z) spans
+  // [x, x + 1) * chunk_size along x, and so on.
+  int32_t grid_origin[3];
+  uint32_t grid_size[3];
+  uint32_t reserved;
+  uint64_t grid_offset;
+  uint64_t chunk_offset;
+};
+
+struct LevelRecord {
+  // Offset of the level data in the file, page aligned.
+  uint64_t offset;
+  // Size of the level data in bytes.
+  uint32_t size;
+  uint32_t part_count;
+  uint32_t vertex_count;
+  uint32_t index_count;
+  // Largest distance in meters a vertex moved from the source surface,
+  // roughly; 0 for level 0.
+  float error;
+  uint32_t reserved;
+};
+
+struct ChunkRecord {
+  // Bounds of the triangles of the chunk, which may reach past its cell.
+  float min[3];
+  float max[3];
+  LevelRecord levels[kMaxLevelCount];
+};
+
+struct PartRecord {
+  uint32_t first_vertex;
+  uint32_t vertex_count;
+  uint32_t first_index;
+  uint32_t index_count;
+};
+
+// Floats per vertex.
+const int kVertexFloatCount = 6;
+
+static_assert(sizeof(FileHeader) == 64, "FileHeader layout changed.");
+static_assert(sizeof(LevelRecord) == 32, "LevelRecord layout changed.");
+static_assert(sizeof(ChunkRecord) == 280, "ChunkRecord layout changed.");
+static_assert(sizeof(PartRecord) == 16, "PartRecord layout changed.");
+
+}  // namespace venue
+}  // namespace tango_gl
+#endif  // TANGO_GL_VENUE_FORMAT_H_
@@ -0,0 +1,207 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_GL_VENUE_STREAMER_H_
+#define TANGO_GL_VENUE_STREAMER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "tango-gl/color.h"
+#include "tango-gl/upload_thread.h"
+#include "tango-gl/util.h"
+#include "tango-gl/venue_format.h"
+#include "tango-gl/view_frustum.h"
+
+namespace tango_gl {
+
+// VenueStreamer draws a venue file, see venue_format.h, keeping only the
+// chunks around the camera on the GPU, each at the level of detail its
+// distance calls for.
+//
+// Every Update() walks the grid cells within Options::max_distance of the
+// eye, so its cost depends on that distance, not on the venue size. A
+// visible chunk wants the coarsest level whose error projects to at most
+// Options::max_screen_error pixels. Missing levels are mapped from the file
+// and uploaded on an UploadThread, nearest chunks first; a chunk keeps
+// drawing its previous level until the new one is ready. Chunk levels not
+// seen for the longest time are dropped once the GPU data would exceed
+// Options::gpu_budget, and only the file pages of the chunk table stay
+// mapped, so memory does not grow with the venue either.
+//
+// Chunks at different levels may show small cracks where they meet.
+//
+// All functions must be called on the GL thread, which also has to Poll()
+// the upload thread every frame.
+class VenueStreamer {
+ public:
+  struct Options {
+    Options()
+        : max_screen_error(2.0f),
+          max_distance(150.0f),
+          gpu_budget(64u << 20),
+          max_pending_uploads(4) {}
+
+    // Largest error of a level on screen in pixels.
+    float max_screen_error;
+    // Chunks farther than this from the eye in meters are not drawn.
+    float max_distance;
+    // GPU bytes of the uploaded levels, including the ones in flight.
+    size_t gpu_budget;
+    // Levels queued on the upload thread at a time.
+    int max_pending_uploads;
+  };
+
+  // @param upload_thread: thread the levels are uploaded on, must outlive
+  //        the streamer.
+  explicit VenueStreamer(UploadThread* upload_thread);
+  VenueStreamer(const VenueStreamer& other) = delete;
+  const VenueStreamer& operator=(const VenueStreamer&) = delete;
+  ~VenueStreamer();
+
+  void SetOptions(const Options& options) { options_ = options; }
+  void SetColor(const Color& color) { color_ = color; }
+  void SetLightDirection(const glm::vec3& light_direction);
+
+  // Open a venue file, closing the previous one.
+  //
+  // @return false if the file is missing or malformed.
+  bool Open(const char* path);
+
+  // Release the GPU data and close the file.
+  void Close();
+
+  bool IsOpen() const { return file_ != nullptr; }
+
+  // Pick the chunks and levels for a camera, queue the missing levels and
+  // swap in the ones uploaded since the last call.
+  //
+  // @param projection_mat: projection matrix of the render camera.
+  // @param view_mat: view matrix of the render camera, in the venue frame.
+  // @param viewport_height: height of the viewport in pixels.
+  void Update(const glm::mat4& projection_mat, const glm::mat4& view_mat,
+              int viewport_height);
+
+  // Draw the chunks picked by the last Update() that have a level on the
+  // GPU.
+  void Render(const glm::mat4& projection_mat,
+              const glm::mat4& view_mat) const;
+
+  // Release the GPU data, the file stays open.
+  void Release();
+
+  // Forget the GPU data without deleting it. Use this when the GL context
+  // it belonged to has been destroyed.
+  void Invalidate();
+
+  // Chunks drawn by the last Render().
+  size_t GetVisibleChunkCount() const { return visible_chunks_.size(); }
+  // GPU bytes of the uploaded levels.
+  size_t GetResidentBytes() const { return resident_bytes_; }
+  // Levels queued or uploading.
+  size_t GetPendingUploadCount() const { return requests_.size(); }
+
+ private:
+  // A venue file open for reading, shared with the uploads in flight.
+  struct File;
+
+  // GPU copy of a chunk level.
+  struct LevelBuffers {
+    GLuint vertex_buffer;
+    GLuint index_buffer;
+    std::vector<venue::PartRecord> parts;
+    size_t size;
+  };
+
+  // A level upload. The upload fills buffers, then the completion sets
+  // is_ready; Update() swaps it in.
+  struct Request {
+    int32_t chunk;
+    int level;
+    venue::LevelRecord record;
+    std::shared_ptr<File> file;
+    LevelBuffers buffers;
+    bool is_ready;
+    bool is_cancelled;
+  };
+
+  struct Chunk {
+    // Level on the GPU, -1 if none.
+    int level;
+    LevelBuffers buffers;
+    // Level being uploaded, -1 if none.
+    int pending_level;
+    // Update() count when the chunk was last visible.
+    uint32_t last_visible;
+  };
+
+  const venue::ChunkRecord& GetChunkRecord(int32_t chunk) const;
+
+  // GPU bytes of a level, vertices and indices.
+  static size_t GetLevelSize(const venue::LevelRecord& record);
+
+  // Queue the upload of a chunk level.
+  void RequestLevel(int32_t chunk, int level);
+
+  // Swap in the finished uploads.
+  void CollectUploads();
+
+  // Drop the levels of chunks not visible in this Update(), least recently
+  // visible first, until size more bytes fit the budget.
+  bool MakeRoom(size_t size);
+
+  static void DeleteBuffers(LevelBuffers* buffers);
+
+  // Set up the program on first use.
+  bool AcquireProgram();
+
+  UploadThread* upload_thread_;
+  Options options_;
+  Color color_;
+  glm::vec3 light_direction_;
+
+  std::shared_ptr<File> file_;
+  venue::FileHeader header_;
+  // Grid and chunk table, mapped read only.
+  const int32_t* grid_;
+  const venue::ChunkRecord* chunk_records_;
+
+  // Chunks with a level on the GPU or in flight, by chunk index.
+  std::unordered_map<int32_t, Chunk> chunks_;
+  std::vector<std::shared_ptr<Request>> requests_;
+  size_t resident_bytes_;
+  size_t pending_bytes_;
+  uint32_t update_count_;
+
+  ViewFrustum frustum_;
+  std::vector<int32_t> visible_chunks_;
+
+  GLuint program_;
+  GLint uniform_mvp_;
+  GLint uniform_mv_;
+  GLint uniform_color_;
+  GLint uniform_light_vec_;
+  GLint uniform_ambient_;
+  GLint attrib_vertices_;
+  GLint attrib_normals_;
+};
+}  // namespace tango_gl
+#endif  // TANGO_GL_VENUE_STREAMER_H_
@@ -0,0 +1,85 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TANGO_GL_VERTEX_ARRAY_H_
+#define TANGO_GL_VERTEX_ARRAY_H_
+
+#include <stdint.h>
+
+#include "tango-gl/util.h"
+
+namespace tango_gl {
+
+// VertexArray records the vertex attribute setup of a drawable, its enabled
+// arrays, their buffers and layout and the element buffer, in a vertex array
+// object. The setup is specified once and a draw then costs a single bind:
+//
+//   if (!vertex_array_.Bind()) {
+//     vertex_buffer_.Bind();
+//     vertex_array_.EnableAttribute(attrib_vertices_);
+//     glVertexAttribPointer(attrib_vertices_, ...);
+//     index_buffer_.Bind();
+//   }
+//   glDrawElements(...);
+//   vertex_array_.Unbind();
+//
+// Without vertex array objects Bind() always returns false, so the setup is
+// specified on every draw, and Unbind() disables the enabled attributes.
+// Buffers must be uploaded before Bind(), VertexBuffer::Update() would change
+// the recorded element buffer otherwise.
+//
+// Client side arrays can not be recorded. All functions must be called on
+// the GL thread.
+class VertexArray {
+ public:
+  VertexArray();
+  VertexArray(const VertexArray& other) = delete;
+  const VertexArray& operator=(const VertexArray&) = delete;
+  ~VertexArray();
+
+  // Bind the vertex array.
+  //
+  // @return: true if the setup is recorded and drawing can start, false if
+  //          the caller has to specify it.
+  bool Bind();
+
+  // Enable an attribute array while specifying the setup.
+  void EnableAttribute(GLuint index);
+
+  // Bind the default vertex array back, so drawables specifying their setup
+  // on every draw do not change this one.
+  void Unbind();
+
+  // Record the setup again on the next Bind(), e.g. after a buffer was
+  // recreated or the attribute locations changed.
+  void Reset() { is_recorded_ = false; }
+
+  // Release the vertex array object.
+  void Release();
+
+  // Forget the vertex array object without deleting it. Use this when the GL
+  // context it belonged to has been destroyed.
+  void Invalidate();
+
+ private:
+  GLuint array_id_;
+  bool is_recorded_;
+  // Attributes enabled since Bind(), disabled by Unbind() without vertex
+  // array objects.
+  uint32_t enabled_attributes_;
+};
+}  // namespace tango_gl
+#endif  // TANGO_GL_VERTEX_ARRAY_H_
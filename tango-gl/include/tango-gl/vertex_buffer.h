@@ -0,0 +1,84 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TANGO_GL_VERTEX_BUFFER_H_
+#define TANGO_GL_VERTEX_BUFFER_H_
+
+#include <stddef.h>
+
+#include "tango-gl/util.h"
+
+namespace tango_gl {
+
+// A GPU buffer object mirroring a client side array, e.g. the vertices of a
+// drawable. Only the part of the array that changed since the last update is
+// sent to the GPU; the storage grows geometrically, so appending to the array
+// only uploads the new tail most of the time.
+//
+// The buffer is created on the first update. All functions must be called on
+// the GL thread.
+class VertexBuffer {
+ public:
+  // @param target: GL_ARRAY_BUFFER or GL_ELEMENT_ARRAY_BUFFER.
+  // @param usage: usage hint passed to glBufferData, e.g. GL_STATIC_DRAW.
+  VertexBuffer(GLenum target, GLenum usage);
+  VertexBuffer(const VertexBuffer& other) = delete;
+  const VertexBuffer& operator=(const VertexBuffer&) = delete;
+  ~VertexBuffer();
+
+  // Make the buffer content match data[0, size). Bytes before dirty_offset
+  // are assumed to be on the GPU already and are only re-sent if the storage
+  // has to grow.
+  //
+  // @param data: the client side array.
+  // @param size: size of the array in bytes.
+  // @param dirty_offset: offset of the first changed byte.
+  void Update(const void* data, size_t size, size_t dirty_offset);
+
+  // Make the storage at least capacity bytes, for buffers written in place
+  // with Write() such as rings. Growing the storage loses its content.
+  //
+  // @return true if the storage was (re)allocated.
+  bool Reserve(size_t capacity);
+
+  // Write size bytes of data at offset in the storage, which Reserve() made
+  // large enough.
+  void Write(size_t offset, const void* data, size_t size);
+
+  // Bind the buffer to its target. The caller unbinds it after drawing.
+  void Bind() const;
+
+  // Release the buffer object.
+  void Release();
+
+  // Forget the buffer object without deleting it. Use this when the GL
+  // context it belonged to has been destroyed.
+  void Invalidate();
+
+  GLuint GetBufferId() const { return buffer_id_; }
+
+  // Size in bytes of the data last passed to Update().
+  size_t GetSize() const { return size_; }
+
+ private:
+  GLenum target_;
+  GLenum usage_;
+  GLuint buffer_id_;
+  size_t capacity_;
+  size_t size_;
+};
+}  // namespace tango_gl
+#endif  // TANGO_GL_VERTEX_BUFFER_H_
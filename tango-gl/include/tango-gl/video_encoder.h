@@ -0,0 +1,139 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_GL_VIDEO_ENCODER_H_
+#define TANGO_GL_VIDEO_ENCODER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <functional>
+
+#include "tango-gl/session_format.h"
+
+namespace tango_gl {
+
+// VideoEncoder compresses NV21 camera frames into a video stream, e.g. the
+// color stream of SessionRecorder, which then takes about a hundredth of the
+// storage bandwidth of the raw frames.
+class VideoEncoder {
+ public:
+  // An access unit of the stream, valid during the callback only.
+  struct Packet {
+    const uint8_t* data;
+    size_t size;
+    // The time given to Encode() for the frame, 0 for configuration.
+    int64_t presentation_time_us;
+    // Codec configuration, e.g. the H.264 SPS and PPS, which comes before
+    // the first frame.
+    bool is_config;
+    bool is_key_frame;
+  };
+
+  typedef std::function<void(const Packet& packet)> PacketCallback;
+
+  virtual ~VideoEncoder() {}
+
+  virtual session::VideoCodec GetCodec() const = 0;
+
+  // Start a stream of frames of one size.
+  //
+  // @return false if the encoder is unavailable or rejects the size.
+  virtual bool Start(uint32_t width, uint32_t height) = 0;
+
+  // Encode a frame and hand the packets ready so far to on_packet. Packets
+  // come out a few frames after their frame went in.
+  //
+  // @param nv21: full resolution luma rows of stride bytes followed by the
+  //        interleaved V and U rows at half resolution.
+  // @param presentation_time_us: time of the frame, increasing.
+  // @return false if the frame was dropped, e.g. the encoder is busy.
+  virtual bool Encode(const uint8_t* nv21, uint32_t stride,
+                      int64_t presentation_time_us,
+                      const PacketCallback& on_packet) = 0;
+
+  // End the stream: hand the remaining packets to on_packet and stop. Start()
+  // may be called again afterwards.
+  virtual void Finish(const PacketCallback& on_packet) = 0;
+};
+
+// MediaCodecVideoEncoder encodes with the hardware H.264 or HEVC encoder of
+// the device through the NDK MediaCodec API. Frames are copied into the
+// input buffers of the codec as YUV 4:2:0 semi-planar, which has the chroma
+// of NV21 swapped.
+//
+// libmediandk first shipped in API level 21, above the platform the
+// examples build against, so its entry points are resolved at runtime and
+// Start() fails where it is missing, e.g. on the host build.
+//
+// Not thread safe, use it from one thread, e.g. the I/O thread of
+// SessionRecorder.
+class MediaCodecVideoEncoder : public VideoEncoder {
+ public:
+  struct Options {
+    Options()
+        : codec(session::kH264Codec),
+          bit_rate(4000000),
+          frame_rate(30),
+          key_frame_interval_s(1),
+          input_timeout_us(10000) {}
+
+    session::VideoCodec codec;
+    // Target bits per second.
+    int32_t bit_rate;
+    // Nominal frame rate, for the rate control.
+    int32_t frame_rate;
+    // Seconds between key frames, where a replay can start decoding.
+    int32_t key_frame_interval_s;
+    // Longest Encode() waits for a free input buffer before it drops the
+    // frame.
+    int64_t input_timeout_us;
+  };
+
+  explicit MediaCodecVideoEncoder(const Options& options = Options());
+  MediaCodecVideoEncoder(const MediaCodecVideoEncoder& other) = delete;
+  const MediaCodecVideoEncoder& operator=(const MediaCodecVideoEncoder&) =
+      delete;
+  ~MediaCodecVideoEncoder() override;
+
+  // Whether the platform has an NDK MediaCodec.
+  static bool IsSupported();
+
+  session::VideoCodec GetCodec() const override { return options_.codec; }
+  bool Start(uint32_t width, uint32_t height) override;
+  bool Encode(const uint8_t* nv21, uint32_t stride,
+              int64_t presentation_time_us,
+              const PacketCallback& on_packet) override;
+  void Finish(const PacketCallback& on_packet) override;
+
+ private:
+  // Hand the output buffers available within timeout_us to on_packet.
+  //
+  // @return true once the end of the stream came out.
+  bool Drain(int64_t timeout_us, const PacketCallback& on_packet);
+
+  // Stop and delete the codec.
+  void Release();
+
+  Options options_;
+  // AMediaCodec of the stream, nullptr when not started.
+  void* codec_;
+  uint32_t width_;
+  uint32_t height_;
+};
+}  // namespace tango_gl
+#endif  // TANGO_GL_VIDEO_ENCODER_H_
@@ -17,7 +17,9 @@
 #ifndef TANGO_GL_RENDERER_VIDEO_OVERLAY_H_
 #define TANGO_GL_RENDERER_VIDEO_OVERLAY_H_
 
+#include "tango-gl/camera_intrinsics_registry.h"
 #include "tango-gl/drawable_object.h"
+#include "tango-gl/undistortion_mesh.h"
 
 namespace tango_gl {
 class VideoOverlay : public DrawableObject {
@@ -27,13 +29,20 @@ class VideoOverlay : public DrawableObject {
   GLuint GetTextureId() const { return texture_id_; }
   void SetTextureId(GLuint texture_id) { texture_id_ = texture_id; }
 
+  // Undistort the camera image with a distortion map of its camera, see
+  // CameraIntrinsicsRegistry::GetDistortionMap(). nullptr draws the image as
+  // it comes from the camera.
+  void SetDistortionMap(const CameraIntrinsicsRegistry::DistortionMap* map) {
+    mesh_.SetDistortionMap(map);
+  }
+
  private:
   // This id is populated on construction, and is passed to the tango service.
   GLuint texture_id_;
 
   GLuint attrib_texture_coords_;
   GLuint uniform_texture_;
-  GLuint vertex_buffers_[3];
+  UndistortionMesh mesh_;
 };
 }  // namespace tango_gl
 #endif  // TANGO_GL_RENDERER_VIDEO_OVERLAY_H_
@@ -0,0 +1,94 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_GL_VIEW_FRUSTUM_H_
+#define TANGO_GL_VIEW_FRUSTUM_H_
+
+#include "tango-gl/bounding_box.h"
+#include "tango-gl/occlusion_culler.h"
+#include "tango-gl/util.h"
+
+namespace tango_gl {
+
+// ViewFrustum culls boxes against the view volume of a render camera, and
+// optionally against a maximum distance from the eye. It is conservative:
+// a box reported as culled is never visible, a box reported as visible may
+// still be just outside a corner of the frustum.
+//
+// Tests are counted between two Update() calls, so the counters hold the
+// statistics of the current frame, e.g. for FrameProfiler::SetCounter().
+class ViewFrustum {
+ public:
+  ViewFrustum();
+
+  // Extract the frustum planes of a camera and reset the counters.
+  //
+  // @param projection_mat: projection matrix of the render camera.
+  // @param view_mat: view matrix of the render camera.
+  void Update(const glm::mat4& projection_mat, const glm::mat4& view_mat);
+
+  // Cull boxes farther than this distance from the eye, in addition to the
+  // far plane. 0 disables distance culling, which is the default.
+  void SetMaxDistance(float max_distance) { max_distance_ = max_distance; }
+
+  // Also cull boxes inside the frustum that the occlusion culler reports
+  // hidden. The culler must be built for the same camera and outlive its
+  // use here; nullptr, the default, disables occlusion culling.
+  void SetOcclusionCuller(const OcclusionCuller* occlusion_culler) {
+    occlusion_culler_ = occlusion_culler;
+  }
+
+  // Whether an axis-aligned box in world coordinates may be visible.
+  bool IsBoxVisible(const glm::vec3& min, const glm::vec3& max);
+
+  // Whether a box may be visible once transformed to world coordinates.
+  //
+  // @param box: bounding box in model coordinates.
+  // @param world_T_model: model matrix of the box, may include a scale.
+  bool IsBoxVisible(const BoundingBox& box, const glm::mat4& world_T_model);
+
+  // Left, right, bottom, top, near and far planes as (normal, distance),
+  // normals pointing inside, for batch tests such as ObjectStore's.
+  const glm::vec4* GetPlanes() const { return planes_; }
+
+  // Position of the camera in world coordinates.
+  const glm::vec3& GetEye() const { return eye_; }
+
+  // Boxes tested and culled since the last Update(). The culled count
+  // includes the occluded boxes.
+  size_t GetTestedCount() const { return tested_count_; }
+  size_t GetCulledCount() const { return culled_count_; }
+  size_t GetOccludedCount() const { return occluded_count_; }
+
+ private:
+  // Test a box given by its center and half extents in world coordinates.
+  bool IsVisible(const glm::vec3& center, const glm::vec3& half_extents);
+
+  // Left, right, bottom, top, near and far planes. The normals point inside
+  // and are normalized, so the plane equation gives the signed distance.
+  glm::vec4 planes_[6];
+  glm::mat4 clip_T_world_;
+  glm::vec3 eye_;
+  float max_distance_;
+  const OcclusionCuller* occlusion_culler_;
+
+  size_t tested_count_;
+  size_t culled_count_;
+  size_t occluded_count_;
+};
+}  // namespace tango_gl
+#endif  // TANGO_GL_VIEW_FRUSTUM_H_
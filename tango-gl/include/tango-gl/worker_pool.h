@@ -0,0 +1,137 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TANGO_GL_WORKER_POOL_H_
+#define TANGO_GL_WORKER_POOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace tango_gl {
+
+// WorkerPool is a small fixed size pool of threads running data parallel
+// loops. The calling thread takes part in the work, so a pool created with
+// N worker threads runs N + 1 tasks at a time.
+//
+// Loops from several threads can run at once, e.g. depth decimation on one
+// thread and TSDF integration on another, and a task may itself run a loop
+// on the same pool. Idle workers join whichever loop has tasks left and
+// claim its tasks one at a time, so a worker that finishes early takes over
+// the remaining tasks of slower ones. A caller never waits for a task it
+// could run itself, so loops make progress even when every worker is busy.
+//
+// Most features should use GetShared() instead of starting threads of their
+// own.
+class WorkerPool {
+ public:
+  // Cores the workers may run on. Cores are told apart by their maximum
+  // frequency, on a big.LITTLE device the big cores are the fastest ones.
+  enum CoreSet {
+    kAnyCores,
+    kBigCores,
+    kLittleCores,
+  };
+
+  struct Options {
+    Options() : thread_count(-1), cores(kAnyCores), nice(0) {}
+
+    // Number of worker threads, -1 leaves kReservedCoreCount cores of the
+    // core set to the threads outside the pool, and starts at least one.
+    int thread_count;
+    // Cores the workers are pinned to. Ignored where pinning is not
+    // supported, or if the set is empty.
+    CoreSet cores;
+    // Nice value of the workers relative to normal priority. A positive
+    // value lets the GL and Tango callback threads win a contended core.
+    int nice;
+  };
+
+  // Cores left to the GL thread and the Tango callback threads by the
+  // default thread count.
+  static const int kReservedCoreCount = 2;
+
+  // @param thread_count: number of worker threads to start.
+  explicit WorkerPool(int thread_count);
+  explicit WorkerPool(const Options& options);
+  WorkerPool(const WorkerPool& other) = delete;
+  const WorkerPool& operator=(const WorkerPool&) = delete;
+  ~WorkerPool();
+
+  // Pool shared by the tango-gl compute features, created on first use with
+  // the default thread count and slightly lowered priority.
+  static WorkerPool& GetShared();
+
+  // Run task(0) .. task(task_count - 1) on the pool and the calling thread,
+  // and return once all of them are done. Tasks may run in any order, callers
+  // are expected to write disjoint outputs per task index.
+  void ParallelFor(int task_count, const std::function<void(int)>& task);
+
+  // Run task(0) .. task(task_count - 1) like ParallelFor() and fold their
+  // results with combine, in index order, so the result does not depend on
+  // which thread ran which task.
+  template <typename T, typename Task, typename Combine>
+  T ParallelReduce(int task_count, const T& identity, const Task& task,
+                   const Combine& combine) {
+    std::vector<T> results(task_count > 0 ? task_count : 0, identity);
+    ParallelFor(task_count, [&results, &task](int i) { results[i] = task(i); });
+    T result = identity;
+    for (const T& partial : results) {
+      result = combine(result, partial);
+    }
+    return result;
+  }
+
+  // Number of tasks that can run concurrently, including the caller.
+  int GetConcurrency() const { return static_cast<int>(threads_.size()) + 1; }
+
+ private:
+  // A loop run by ParallelFor(), on the caller's stack.
+  struct Job {
+    const std::function<void(int)>* task;
+    int task_count;
+    std::atomic<int> next_task;
+    // Workers running tasks of the job, guarded by mutex_.
+    int active_workers;
+  };
+
+  void Start(const Options& options);
+
+  void WorkerLoop(const std::vector<int>& cpus, int nice);
+
+  // Claim and run tasks of a job until none are left.
+  static void RunTasks(Job* job);
+
+  // Remove a job from jobs_ if it is still listed. Called with mutex_ held.
+  void RemoveJob(Job* job);
+
+  std::vector<std::thread> threads_;
+
+  std::mutex mutex_;
+  std::condition_variable work_available_;
+  std::condition_variable work_done_;
+
+  // Jobs which may have unclaimed tasks, guarded by mutex_. Idle workers
+  // take the oldest one.
+  std::vector<Job*> jobs_;
+  bool is_stopping_;
+};
+}  // namespace tango_gl
+
+#endif  // TANGO_GL_WORKER_POOL_H_
@@ -0,0 +1,126 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TANGO_GL_YUV_CONVERTER_H_
+#define TANGO_GL_YUV_CONVERTER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace tango_gl {
+namespace yuv {
+
+// Fixed-point (Q6) BT.601 full range coefficients, shared by the scalar and
+// the NEON kernels so both paths produce identical output.
+const int kFixedPointShift = 6;
+const int kVToR = 88;   // 1.370705 * 64
+const int kVToG = 45;   // 0.698001 * 64
+const int kUToG = 22;   // 0.337633 * 64
+const int kUToB = 111;  // 1.732446 * 64
+
+// Returns true if the NEON kernel is compiled in and supported by the CPU.
+// The result is computed once and cached.
+bool IsNeonAvailable();
+
+// Convert a NV21 image into a packed RGB888 buffer.
+//
+// The NV21 layout is a full resolution Y plane followed by an interleaved,
+// half resolution VU plane:
+//   [y0, y1, y2, ..., yn, v0, u0, v1, u1, ..., v(n/4), u(n/4)]
+//
+// @param nv21: NV21 image data, width * height * 3 / 2 bytes.
+// @param width: width of the image in pixels, must be even.
+// @param height: height of the image in pixels, must be even.
+// @param rgb: output buffer, width * height * 3 bytes.
+void ConvertNV21ToRGB(const uint8_t* nv21, size_t width, size_t height,
+                      uint8_t* rgb);
+
+// Convert the rows [row_begin, row_end) of a NV21 image. The destination is
+// the full RGB image, only the converted rows are written. Disjoint row ranges
+// can be converted concurrently from different threads; ranges starting on an
+// even row let the kernel share chroma between row pairs.
+//
+// @param nv21: NV21 image data, width * height * 3 / 2 bytes.
+// @param width: width of the image in pixels, must be even.
+// @param height: height of the image in pixels, must be even.
+// @param row_begin: first row to convert.
+// @param row_end: one past the last row to convert, clamped to height.
+// @param rgb: output buffer of the full image, width * height * 3 bytes.
+void ConvertNV21ToRGB(const uint8_t* nv21, size_t width, size_t height,
+                      size_t row_begin, size_t row_end, uint8_t* rgb);
+
+// Convert a rectangle of a NV21 image into a packed RGB888 buffer of its
+// size, for consumers which only need part of the frame. Only the pixels of
+// the rectangle are read and converted.
+//
+// @param nv21: NV21 image data, width * height * 3 / 2 bytes.
+// @param width: width of the image in pixels, must be even.
+// @param height: height of the image in pixels, must be even.
+// @param region_x, region_y: top left pixel of the rectangle.
+// @param region_width, region_height: size of the rectangle, clamped to the
+//        image.
+// @param rgb: output buffer, region_width * region_height * 3 bytes, rows of
+//        the clamped width.
+void ConvertNV21RegionToRGB(const uint8_t* nv21, size_t width, size_t height,
+                            size_t region_x, size_t region_y,
+                            size_t region_width, size_t region_height,
+                            uint8_t* rgb);
+
+// Convert a NV21 image into a packed RGB888 buffer of half its width and
+// height, e.g. for a preview. Each output pixel is the average of a 2x2 luma
+// block with the chroma sample of that block, the native 4:2:0 resolution,
+// so a quarter of the pixels are converted and no chroma is duplicated.
+//
+// @param nv21: NV21 image data, width * height * 3 / 2 bytes.
+// @param width: width of the image in pixels, must be even.
+// @param height: height of the image in pixels, must be even.
+// @param rgb: output buffer, (width / 2) * (height / 2) * 3 bytes.
+void ConvertNV21ToHalfRGB(const uint8_t* nv21, size_t width, size_t height,
+                          uint8_t* rgb);
+
+// Convert a single pixel of a NV21 image, with the same result as
+// ConvertNV21ToRGB() for that pixel. Meant for sparse lookups, e.g. coloring
+// depth points, where converting the whole image would be wasted.
+//
+// @param nv21: NV21 image data, width * height * 3 / 2 bytes.
+// @param width: width of the image in pixels, must be even.
+// @param height: height of the image in pixels, must be even.
+// @param x, y: the pixel, inside the image.
+// @param rgb: output, 3 bytes.
+void ConvertNV21PixelToRGB(const uint8_t* nv21, size_t width, size_t height,
+                           size_t x, size_t y, uint8_t* rgb);
+
+namespace internal {
+// Per-architecture row-pair kernel, defined in yuv_converter_neon.cpp. It
+// converts two consecutive rows sharing the same chroma row and returns the
+// number of columns converted (a multiple of 16); the caller converts the
+// remaining columns.
+size_t ConvertNV21RowPairNeon(const uint8_t* y_row0, const uint8_t* y_row1,
+                              const uint8_t* vu_row, size_t width,
+                              uint8_t* rgb_row0, uint8_t* rgb_row1);
+
+// Half resolution kernel, defined in yuv_converter_neon.cpp. It converts a
+// row pair and its chroma row into one row of half the width and returns the
+// number of output columns converted (a multiple of 16); the caller converts
+// the remaining columns.
+size_t ConvertNV21HalfRowNeon(const uint8_t* y_row0, const uint8_t* y_row1,
+                              const uint8_t* vu_row, size_t half_width,
+                              uint8_t* rgb_row);
+}  // namespace internal
+
+}  // namespace yuv
+}  // namespace tango_gl
+#endif  // TANGO_GL_YUV_CONVERTER_H_
@@ -0,0 +1,180 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "tango-gl/keyframe_selector.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+// Frustum samples: a grid of rays over the image, and depths along each ray.
+const int kOverlapGridSize = 8;
+const int kOverlapDepthCount = 4;
+
+// Resolution of the keyframe depth relative to the camera.
+const float kKeyframeImageScale = 0.25f;
+}  // namespace
+
+namespace tango_gl {
+
+KeyframeSelector::KeyframeSelector(const Options& options)
+    : options_(options),
+      intrinsics_(),
+      has_keyframe_(false),
+      world_T_keyframe_(1.0f),
+      overlap_(1.0f),
+      novelty_(0.0f),
+      keyframe_count_(0),
+      skipped_frame_count_(0) {}
+
+void KeyframeSelector::SetIntrinsics(
+    const projection::CameraIntrinsics& intrinsics) {
+  intrinsics_ = intrinsics;
+  has_keyframe_ = false;
+  frustum_samples_.clear();
+  if (intrinsics.width <= 0 || intrinsics.height <= 0) {
+    return;
+  }
+  // The volume of a frustum slice grows with the square of its depth, cube
+  // root spacing spreads the samples evenly over the volume.
+  for (int k = 0; k < kOverlapDepthCount; ++k) {
+    const float depth =
+        options_.max_depth *
+        std::cbrt((k + 0.5f) / static_cast<float>(kOverlapDepthCount));
+    for (int j = 0; j < kOverlapGridSize; ++j) {
+      const float y = (j + 0.5f) * intrinsics.height / kOverlapGridSize;
+      for (int i = 0; i < kOverlapGridSize; ++i) {
+        const float x = (i + 0.5f) * intrinsics.width / kOverlapGridSize;
+        frustum_samples_.push_back(
+            glm::vec3((x - intrinsics.cx) / intrinsics.fx,
+                      (y - intrinsics.cy) / intrinsics.fy, 1.0f) *
+            depth);
+      }
+    }
+  }
+
+  TangoCameraIntrinsics keyframe_intrinsics = TangoCameraIntrinsics();
+  keyframe_intrinsics.width = static_cast<uint32_t>(
+      std::max(1.0f, intrinsics.width * kKeyframeImageScale));
+  keyframe_intrinsics.height = static_cast<uint32_t>(
+      std::max(1.0f, intrinsics.height * kKeyframeImageScale));
+  keyframe_intrinsics.fx = intrinsics.fx * kKeyframeImageScale;
+  keyframe_intrinsics.fy = intrinsics.fy * kKeyframeImageScale;
+  keyframe_intrinsics.cx = intrinsics.cx * kKeyframeImageScale;
+  keyframe_intrinsics.cy = intrinsics.cy * kKeyframeImageScale;
+  keyframe_image_.SetIntrinsics(keyframe_intrinsics);
+}
+
+KeyframeSelector::Reason KeyframeSelector::Select(
+    const float* xyz, size_t point_count, const glm::mat4& world_T_depth) {
+  Reason reason = kNotKeyframe;
+  if (!has_keyframe_) {
+    reason = kFirstFrame;
+  } else {
+    const glm::mat4 keyframe_T_depth =
+        glm::inverse(world_T_keyframe_) * world_T_depth;
+    const glm::quat rotation = glm::quat_cast(glm::mat3(keyframe_T_depth));
+    const float angle =
+        2.0f * std::acos(std::min(1.0f, std::abs(rotation.w)));
+    if (glm::length(glm::vec3(keyframe_T_depth[3])) >
+            options_.max_translation ||
+        angle > options_.max_rotation) {
+      reason = kMoved;
+    } else if (!frustum_samples_.empty()) {
+      overlap_ = ComputeOverlap(keyframe_T_depth);
+      if (overlap_ < options_.min_overlap) {
+        reason = kLowOverlap;
+      } else {
+        novelty_ = ComputeNovelty(xyz, point_count, keyframe_T_depth);
+        if (novelty_ > options_.max_novelty) {
+          reason = kNovelDepth;
+        }
+      }
+    }
+  }
+
+  if (reason == kNotKeyframe) {
+    ++skipped_frame_count_;
+    return reason;
+  }
+  has_keyframe_ = true;
+  world_T_keyframe_ = world_T_depth;
+  if (!frustum_samples_.empty()) {
+    keyframe_image_.Update(xyz, point_count);
+  }
+  ++keyframe_count_;
+  return reason;
+}
+
+float KeyframeSelector::ComputeOverlap(
+    const glm::mat4& keyframe_T_depth) const {
+  const glm::mat3 rotation(keyframe_T_depth);
+  const glm::vec3 translation(keyframe_T_depth[3]);
+  size_t inside_count = 0;
+  for (const glm::vec3& sample : frustum_samples_) {
+    if (IsInKeyframeFrustum(rotation * sample + translation)) {
+      ++inside_count;
+    }
+  }
+  return static_cast<float>(inside_count) / frustum_samples_.size();
+}
+
+float KeyframeSelector::ComputeNovelty(
+    const float* xyz, size_t point_count,
+    const glm::mat4& keyframe_T_depth) const {
+  const glm::mat3 rotation(keyframe_T_depth);
+  const glm::vec3 translation(keyframe_T_depth[3]);
+  const size_t stride = static_cast<size_t>(std::max(1, options_.sample_stride));
+  size_t tested_count = 0;
+  size_t novel_count = 0;
+  for (size_t i = 0; i < point_count; i += stride) {
+    const float* point = xyz + i * 3;
+    if (!(point[2] > 0.0f)) {
+      continue;
+    }
+    ++tested_count;
+    const glm::vec3 position =
+        rotation * glm::vec3(point[0], point[1], point[2]) + translation;
+    int x;
+    int y;
+    if (!keyframe_image_.GetPixel(position, &x, &y)) {
+      ++novel_count;
+      continue;
+    }
+    const float keyframe_depth = keyframe_image_.GetDepth(x, y);
+    if (keyframe_depth == 0.0f ||
+        std::abs(position.z - keyframe_depth) >
+            options_.depth_tolerance * position.z) {
+      ++novel_count;
+    }
+  }
+  return tested_count == 0
+             ? 0.0f
+             : static_cast<float>(novel_count) / tested_count;
+}
+
+bool KeyframeSelector::IsInKeyframeFrustum(const glm::vec3& position) const {
+  if (!(position.z > 0.0f) || position.z > options_.max_depth) {
+    return false;
+  }
+  const float x = intrinsics_.fx * (position.x / position.z) + intrinsics_.cx;
+  const float y = intrinsics_.fy * (position.y / position.z) + intrinsics_.cy;
+  return x >= 0.0f && x < intrinsics_.width && y >= 0.0f &&
+         y < intrinsics_.height;
+}
+
+}  // namespace tango_gl
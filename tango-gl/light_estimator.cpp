@@ -0,0 +1,250 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "tango-gl/light_estimator.h"
+
+#include "tango-gl/counters.h"
+#include "tango-gl/memory_tracker.h"
+#include "tango-gl/program_cache.h"
+#include "tango-gl/render_state.h"
+#include "tango-gl/shaders.h"
+
+namespace {
+// Full screen quad as a triangle strip, in normalized device coordinates.
+const GLfloat kQuadVertices[] = {-1.0f, -1.0f, 1.0f, -1.0f,
+                                 -1.0f, 1.0f,  1.0f, 1.0f};
+
+// Side of the first target, each level is 4 times smaller.
+const GLsizei kFirstLevelSize = 64;
+
+// Weight of a new read in the smoothed estimate, so the light does not
+// flicker with the camera noise and auto exposure.
+const float kSmoothing = 0.2f;
+
+// Bound of the color ratios, for images with a nearly black channel.
+const float kMaxColorRatio = 4.0f;
+
+// Rec. 709 luminance weights.
+const glm::vec3 kLuminanceWeights(0.2126f, 0.7152f, 0.0722f);
+}  // namespace
+
+namespace tango_gl {
+
+LightEstimator::LightEstimator()
+    : is_unsupported_(false),
+      external_program_(0),
+      external_attrib_vertices_(-1),
+      external_uniform_offset_(-1),
+      program_(0),
+      attrib_vertices_(-1),
+      uniform_offset_(-1),
+      vertex_buffer_(GL_ARRAY_BUFFER, GL_STATIC_DRAW),
+      has_estimate_(false) {
+  for (Level& level : levels_) {
+    level.framebuffer = 0;
+    level.texture = 0;
+    level.size = 0;
+  }
+  estimate_.intensity = 0.0f;
+  estimate_.color = glm::vec3(1.0f);
+  estimate_.timestamp = 0.0;
+}
+
+LightEstimator::~LightEstimator() { Release(); }
+
+void LightEstimator::Update(GLuint camera_texture, double timestamp) {
+  readback_.GetPixels([this](double read_timestamp, const uint8_t* pixels) {
+    AddRead(read_timestamp, pixels);
+  });
+  if (is_unsupported_ || !Allocate()) {
+    return;
+  }
+
+  GLint viewport[4];
+  glGetIntegerv(GL_VIEWPORT, viewport);
+  RenderState::Disable(GL_BLEND);
+  RenderState::Disable(GL_DEPTH_TEST);
+  RenderState::Disable(GL_CULL_FACE);
+
+  // The taps are a quarter of an output pixel away from its center, so the
+  // passes between levels average 4x4 pixels exactly. The camera texture
+  // keeps the filtering of its owner, e.g. nearest with VideoOverlay, the
+  // first pass then samples 4 camera pixels per target pixel.
+  Downsample(external_program_, external_attrib_vertices_,
+             external_uniform_offset_, GL_TEXTURE_EXTERNAL_OES,
+             camera_texture, 0.25f / levels_[0].size, levels_[0]);
+  for (int i = 1; i < kLevelCount; ++i) {
+    Downsample(program_, attrib_vertices_, uniform_offset_, GL_TEXTURE_2D,
+               levels_[i - 1].texture, 0.25f / levels_[i].size, levels_[i]);
+  }
+  readback_.Read(timestamp);
+
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+  util::CheckGlError("LightEstimator::Update");
+}
+
+bool LightEstimator::GetEstimate(Estimate* estimate) const {
+  if (!has_estimate_) {
+    return false;
+  }
+  *estimate = estimate_;
+  return true;
+}
+
+void LightEstimator::Downsample(GLuint program, GLint attrib_vertices,
+                                GLint uniform_offset, GLenum target,
+                                GLuint texture, float texel_offset,
+                                const Level& level) {
+  glBindFramebuffer(GL_FRAMEBUFFER, level.framebuffer);
+  glViewport(0, 0, level.size, level.size);
+  RenderState::UseProgram(program);
+  RenderState::ActiveTexture(GL_TEXTURE0);
+  RenderState::BindTexture(target, texture);
+  glUniform2f(uniform_offset, texel_offset, texel_offset);
+
+  vertex_buffer_.Bind();
+  glEnableVertexAttribArray(attrib_vertices);
+  glVertexAttribPointer(attrib_vertices, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
+  Counters::Increment(Counters::kDrawCalls);
+  glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+  glDisableVertexAttribArray(attrib_vertices);
+}
+
+void LightEstimator::AddRead(double timestamp, const uint8_t* pixels) {
+  const int pixel_count = readback_.GetWidth() * readback_.GetHeight();
+  glm::vec3 sum(0.0f);
+  for (int i = 0; i < pixel_count; ++i) {
+    sum += glm::vec3(pixels[4 * i], pixels[4 * i + 1], pixels[4 * i + 2]);
+  }
+  const glm::vec3 average = sum / (255.0f * pixel_count);
+  const float intensity = glm::dot(average, kLuminanceWeights);
+  const glm::vec3 color =
+      intensity > 1.0f / 255.0f
+          ? glm::min(average / intensity, glm::vec3(kMaxColorRatio))
+          : glm::vec3(1.0f);
+
+  if (has_estimate_) {
+    estimate_.intensity += kSmoothing * (intensity - estimate_.intensity);
+    estimate_.color += kSmoothing * (color - estimate_.color);
+  } else {
+    estimate_.intensity = intensity;
+    estimate_.color = color;
+    has_estimate_ = true;
+  }
+  estimate_.timestamp = timestamp;
+}
+
+bool LightEstimator::Allocate() {
+  if (levels_[0].framebuffer != 0) {
+    return true;
+  }
+
+  external_program_ = program_cache::AcquireProgram(
+      shaders::GetCompositeVertexShader().c_str(),
+      shaders::GetExternalDownsampleFragmentShader().c_str());
+  program_ = program_cache::AcquireProgram(
+      shaders::GetCompositeVertexShader().c_str(),
+      shaders::GetDownsampleFragmentShader().c_str());
+  if (!external_program_ || !program_) {
+    LOGE("LightEstimator: could not create programs.");
+    Release();
+    is_unsupported_ = true;
+    return false;
+  }
+  external_attrib_vertices_ = glGetAttribLocation(external_program_, "vertex");
+  external_uniform_offset_ = glGetUniformLocation(external_program_, "offset");
+  attrib_vertices_ = glGetAttribLocation(program_, "vertex");
+  uniform_offset_ = glGetUniformLocation(program_, "offset");
+  RenderState::UseProgram(external_program_);
+  glUniform1i(glGetUniformLocation(external_program_, "image"), 0);
+  RenderState::UseProgram(program_);
+  glUniform1i(glGetUniformLocation(program_, "image"), 0);
+  vertex_buffer_.Update(kQuadVertices, sizeof(kQuadVertices), 0);
+
+  GLenum status = GL_FRAMEBUFFER_COMPLETE;
+  GLsizei size = kFirstLevelSize;
+  for (Level& level : levels_) {
+    level.size = size;
+    size /= 4;
+    glGenFramebuffers(1, &level.framebuffer);
+    glGenTextures(1, &level.texture);
+
+    RenderState::BindTexture(GL_TEXTURE_2D, level.texture);
+    // Linear filtering makes each tap the average of 2x2 texels.
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, level.size, level.size, 0,
+                 GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    MemoryTracker::Track(MemoryTracker::kTexture, level.texture,
+                         "LightEstimator",
+                         MemoryTracker::GetTextureSize(level.size, level.size,
+                                                       GL_RGBA,
+                                                       GL_UNSIGNED_BYTE));
+
+    glBindFramebuffer(GL_FRAMEBUFFER, level.framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                           GL_TEXTURE_2D, level.texture, 0);
+    if (status == GL_FRAMEBUFFER_COMPLETE) {
+      status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    }
+  }
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  util::CheckGlError("LightEstimator::Allocate");
+
+  if (status != GL_FRAMEBUFFER_COMPLETE) {
+    LOGE("LightEstimator: framebuffer incomplete (0x%x), light estimation "
+         "disabled.", status);
+    Release();
+    is_unsupported_ = true;
+    return false;
+  }
+  readback_.Allocate(levels_[kLevelCount - 1].size,
+                     levels_[kLevelCount - 1].size);
+  return true;
+}
+
+void LightEstimator::Release() {
+  for (Level& level : levels_) {
+    if (level.framebuffer != 0) {
+      glDeleteFramebuffers(1, &level.framebuffer);
+      RenderState::DeleteTextures(1, &level.texture);
+    }
+  }
+  program_cache::ReleaseProgram(external_program_);
+  program_cache::ReleaseProgram(program_);
+  vertex_buffer_.Release();
+  readback_.Release();
+  Invalidate();
+}
+
+void LightEstimator::Invalidate() {
+  for (Level& level : levels_) {
+    level.framebuffer = 0;
+    level.texture = 0;
+    level.size = 0;
+  }
+  is_unsupported_ = false;
+  external_program_ = 0;
+  program_ = 0;
+  vertex_buffer_.Invalidate();
+  readback_.Invalidate();
+}
+
+}  // namespace tango_gl
@@ -15,30 +15,56 @@
  */
 
 #include "tango-gl/line.h"
+#include "tango-gl/counters.h"
+#include "tango-gl/render_state.h"
 
 namespace tango_gl {
-Line::Line(float line_width, GLenum render_mode) {
+Line::Line(float line_width, GLenum render_mode)
+    : vertex_buffer_(GL_ARRAY_BUFFER, GL_STATIC_DRAW), first_dirty_vertex_(0) {
   line_width_ = line_width;
   render_mode_ = render_mode;
 }
 void Line::SetLineWidth(const float pixels) { line_width_ = pixels; }
+void Line::SetGeometry(std::shared_ptr<const Geometry> geometry) {
+  vec_vertices_.clear();
+  geometry_ = geometry;
+  vertex_array_.Reset();
+}
+void Line::UpdateVertexBuffer() const {
+  if (first_dirty_vertex_ < vec_vertices_.size()) {
+    vertex_buffer_.Update(vec_vertices_.data(),
+                          sizeof(glm::vec3) * vec_vertices_.size(),
+                          sizeof(glm::vec3) * first_dirty_vertex_);
+  }
+  first_dirty_vertex_ = vec_vertices_.size();
+}
+
 void Line::Render(const glm::mat4& projection_mat,
                   const glm::mat4& view_mat) const {
-  glUseProgram(shader_program_);
-  glLineWidth(line_width_);
-  glm::mat4 model_mat = GetTransformationMatrix();
-  glm::mat4 mvp_mat = projection_mat * view_mat * model_mat;
-  glUniformMatrix4fv(uniform_mvp_mat_, 1, GL_FALSE, glm::value_ptr(mvp_mat));
+  UpdateVertexBuffer();
 
-  glUniform4f(uniform_color_, red_, green_, blue_, alpha_);
+  RenderState::UseProgram(shader_program_);
+  RenderState::LineWidth(line_width_);
+  SetTransformUniforms(projection_mat, view_mat, GetTransformationMatrix());
 
-  glEnableVertexAttribArray(attrib_vertices_);
-  glVertexAttribPointer(attrib_vertices_, 3, GL_FLOAT, GL_FALSE,
-                        sizeof(glm::vec3), &vec_vertices_[0]);
-  glDrawArrays(render_mode_, 0, vec_vertices_.size());
+  glUniform4f(uniform_color_, red_, green_, blue_, alpha_);
 
-  glDisableVertexAttribArray(attrib_vertices_);
-  glUseProgram(0);
+  if (!vertex_array_.Bind()) {
+    GLsizei stride = sizeof(glm::vec3);
+    if (geometry_) {
+      geometry_->Bind();
+      stride = geometry_->GetStride();
+    } else {
+      vertex_buffer_.Bind();
+    }
+    vertex_array_.EnableAttribute(attrib_vertices_);
+    glVertexAttribPointer(attrib_vertices_, 3, GL_FLOAT, GL_FALSE, stride,
+                          nullptr);
+  }
+  Counters::Increment(Counters::kDrawCalls);
+  glDrawArrays(render_mode_, 0,
+               geometry_ ? geometry_->GetVertexCount() : vec_vertices_.size());
+  vertex_array_.Unbind();
 }
 
 }  // namespace tango_gl
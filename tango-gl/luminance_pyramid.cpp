@@ -0,0 +1,105 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "tango-gl/cpu_features.h"
+#include "tango-gl/luminance_pyramid.h"
+
+namespace {
+// Halve columns [column_begin, destination_width) of a row pair. Scalar
+// fallback and tail handling for the NEON kernel.
+void DownsampleRowPairScalar(const uint8_t* row0, const uint8_t* row1,
+                             size_t column_begin, size_t destination_width,
+                             uint8_t* destination) {
+  for (size_t j = column_begin; j < destination_width; ++j) {
+    const int sum = row0[2 * j] + row0[2 * j + 1] + row1[2 * j] +
+                    row1[2 * j + 1];
+    destination[j] = static_cast<uint8_t>((sum + 2) >> 2);
+  }
+}
+}  // namespace
+
+namespace tango_gl {
+
+LuminancePyramid::LuminancePyramid() : level_count_(0) {}
+
+void LuminancePyramid::Build(const uint8_t* y, int width, int height,
+                             int stride, int level_count) {
+  if (level_count > kMaxLevelCount) {
+    level_count = kMaxLevelCount;
+  }
+  levels_[0].data = y;
+  levels_[0].width = width;
+  levels_[0].height = height;
+  levels_[0].stride = stride;
+
+  // Lay the levels out first, the buffer only grows.
+  size_t buffer_size = 0;
+  int count = 1;
+  for (; count < level_count; ++count) {
+    const int level_width = levels_[count - 1].width / 2;
+    const int level_height = levels_[count - 1].height / 2;
+    if (level_width == 0 || level_height == 0) {
+      break;
+    }
+    levels_[count].width = level_width;
+    levels_[count].height = level_height;
+    levels_[count].stride = level_width;
+    buffer_size += static_cast<size_t>(level_width) * level_height;
+  }
+  if (buffer_.size() < buffer_size) {
+    buffer_.resize(buffer_size);
+  }
+
+  uint8_t* level_data = buffer_.data();
+  for (int i = 1; i < count; ++i) {
+    const Level& source = levels_[i - 1];
+    luminance_pyramid::Downsample(source.data, source.width, source.height,
+                                  source.stride, level_data);
+    levels_[i].data = level_data;
+    level_data += static_cast<size_t>(levels_[i].width) * levels_[i].height;
+  }
+  level_count_ = count;
+}
+
+namespace luminance_pyramid {
+
+void Downsample(const uint8_t* source, int width, int height, int stride,
+                uint8_t* destination) {
+  const size_t destination_width = width / 2;
+  const size_t destination_height = height / 2;
+#if defined(TANGO_GL_HAS_NEON)
+  const bool use_neon = cpu_features::IsNeonAvailable();
+#endif
+  for (size_t i = 0; i < destination_height; ++i) {
+    const uint8_t* row0 = source + 2 * i * stride;
+    const uint8_t* row1 = row0 + stride;
+    uint8_t* destination_row = destination + i * destination_width;
+
+    size_t written = 0;
+#if defined(TANGO_GL_HAS_NEON)
+    if (use_neon) {
+      written = internal::DownsampleRowPairNeon(row0, row1, destination_width,
+                                                destination_row);
+    }
+#endif
+    DownsampleRowPairScalar(row0, row1, written, destination_width,
+                            destination_row);
+  }
+}
+
+}  // namespace luminance_pyramid
+}  // namespace tango_gl
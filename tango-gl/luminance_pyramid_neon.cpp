@@ -0,0 +1,54 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// This file is only compiled with NEON enabled (the ".neon" suffix in
+// Android.mk), the kernel is selected at runtime by luminance_pyramid.cpp.
+
+#include <arm_neon.h>
+
+#include "tango-gl/luminance_pyramid.h"
+
+namespace {
+// Halve 32 columns of a row pair into 16. Horizontal pairs are added while
+// widening to 16 bits, the two rows are summed and the rounding narrow
+// divides by 4, the same (sum + 2) >> 2 as the scalar path.
+inline uint8x8_t DownsampleHalf(const uint8x16_t& row0,
+                                const uint8x16_t& row1) {
+  return vrshrn_n_u16(vaddq_u16(vpaddlq_u8(row0), vpaddlq_u8(row1)), 2);
+}
+}  // namespace
+
+namespace tango_gl {
+namespace luminance_pyramid {
+namespace internal {
+
+size_t DownsampleRowPairNeon(const uint8_t* row0, const uint8_t* row1,
+                             size_t destination_width, uint8_t* destination) {
+  const size_t aligned_width = destination_width & ~static_cast<size_t>(15);
+  for (size_t j = 0; j < aligned_width; j += 16) {
+    const uint8_t* source0 = row0 + 2 * j;
+    const uint8_t* source1 = row1 + 2 * j;
+    uint8x8_t low = DownsampleHalf(vld1q_u8(source0), vld1q_u8(source1));
+    uint8x8_t high =
+        DownsampleHalf(vld1q_u8(source0 + 16), vld1q_u8(source1 + 16));
+    vst1q_u8(destination + j, vcombine_u8(low, high));
+  }
+  return aligned_width;
+}
+
+}  // namespace internal
+}  // namespace luminance_pyramid
+}  // namespace tango_gl
@@ -0,0 +1,206 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <string.h>
+
+#include <algorithm>
+
+#include "tango-gl/lz4.h"
+
+namespace {
+// Format constraints: matches are at least 4 bytes, the last 5 bytes are
+// always literals and the last match starts at least 12 bytes before the end.
+const size_t kMinMatch = 4;
+const size_t kLastLiterals = 5;
+const size_t kMatchFindLimit = 12;
+const size_t kMaxOffset = 65535;
+// Nibble value meaning the length continues in the following bytes.
+const size_t kLengthContinues = 15;
+
+// Candidate matches are looked up by the hash of their first 4 bytes.
+const int kHashBits = 12;
+
+inline uint32_t Read32(const uint8_t* p) {
+  uint32_t value;
+  memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+inline uint32_t Hash(uint32_t value) {
+  return (value * 2654435761u) >> (32 - kHashBits);
+}
+
+// Write the bytes of a length that did not fit its token nibble.
+uint8_t* WriteLength(uint8_t* op, size_t length) {
+  length -= kLengthContinues;
+  while (length >= 255) {
+    *op++ = 255;
+    length -= 255;
+  }
+  *op++ = static_cast<uint8_t>(length);
+  return op;
+}
+
+// Read the bytes of a length whose token nibble was kLengthContinues.
+bool ReadLength(const uint8_t** ip, const uint8_t* end, size_t* length) {
+  uint8_t byte;
+  do {
+    if (*ip >= end) {
+      return false;
+    }
+    byte = *(*ip)++;
+    *length += byte;
+  } while (byte == 255);
+  return true;
+}
+
+uint8_t* WriteLiterals(uint8_t* op, const uint8_t* literals, size_t length,
+                       uint8_t** token) {
+  *token = op++;
+  **token = static_cast<uint8_t>(std::min(length, kLengthContinues) << 4);
+  if (length >= kLengthContinues) {
+    op = WriteLength(op, length);
+  }
+  if (length > 0) {
+    memcpy(op, literals, length);
+  }
+  return op + length;
+}
+}  // namespace
+
+namespace tango_gl {
+namespace lz4 {
+
+size_t GetMaxCompressedSize(size_t size) { return size + size / 255 + 16; }
+
+size_t Compress(const uint8_t* src, size_t size, uint8_t* dst,
+                size_t capacity) {
+  if (capacity < GetMaxCompressedSize(size)) {
+    return 0;
+  }
+  uint8_t* op = dst;
+  uint8_t* token;
+  const uint8_t* anchor = src;
+
+  if (size > kMatchFindLimit) {
+    // Offsets into src of the last position seen for each hash.
+    uint32_t table[1 << kHashBits];
+    memset(table, 0, sizeof(table));
+    const uint8_t* const match_limit = src + size - kMatchFindLimit;
+    const uint8_t* const match_end_limit = src + size - kLastLiterals;
+
+    const uint8_t* ip = src + 1;
+    while (ip < match_limit) {
+      const uint32_t hash = Hash(Read32(ip));
+      const uint8_t* match = src + table[hash];
+      table[hash] = static_cast<uint32_t>(ip - src);
+      if (match >= ip || static_cast<size_t>(ip - match) > kMaxOffset ||
+          Read32(match) != Read32(ip)) {
+        ++ip;
+        continue;
+      }
+
+      // Extend the match forward, then backward over pending literals.
+      const uint8_t* match_end = ip + kMinMatch;
+      const uint8_t* reference_end = match + kMinMatch;
+      while (match_end < match_end_limit && *match_end == *reference_end) {
+        ++match_end;
+        ++reference_end;
+      }
+      while (ip > anchor && match > src && ip[-1] == match[-1]) {
+        --ip;
+        --match;
+      }
+
+      op = WriteLiterals(op, anchor, ip - anchor, &token);
+      const size_t offset = ip - match;
+      *op++ = static_cast<uint8_t>(offset & 0xff);
+      *op++ = static_cast<uint8_t>(offset >> 8);
+      const size_t match_length = match_end - ip - kMinMatch;
+      *token |= static_cast<uint8_t>(std::min(match_length, kLengthContinues));
+      if (match_length >= kLengthContinues) {
+        op = WriteLength(op, match_length);
+      }
+
+      ip = anchor = match_end;
+      // Index a position inside the match, it often starts the next one.
+      table[Hash(Read32(ip - 2))] = static_cast<uint32_t>(ip - 2 - src);
+    }
+  }
+
+  op = WriteLiterals(op, anchor, src + size - anchor, &token);
+  return op - dst;
+}
+
+bool Decompress(const uint8_t* src, size_t size, uint8_t* dst,
+                size_t raw_size) {
+  const uint8_t* ip = src;
+  const uint8_t* const end = src + size;
+  uint8_t* op = dst;
+  uint8_t* const output_end = dst + raw_size;
+
+  while (ip < end) {
+    const uint8_t token = *ip++;
+
+    size_t literal_length = token >> 4;
+    if (literal_length == kLengthContinues &&
+        !ReadLength(&ip, end, &literal_length)) {
+      return false;
+    }
+    if (literal_length > static_cast<size_t>(end - ip) ||
+        literal_length > static_cast<size_t>(output_end - op)) {
+      return false;
+    }
+    if (literal_length > 0) {
+      memcpy(op, ip, literal_length);
+    }
+    ip += literal_length;
+    op += literal_length;
+    if (ip == end) {
+      // The last sequence only has literals.
+      break;
+    }
+
+    if (end - ip < 2) {
+      return false;
+    }
+    const size_t offset = ip[0] | (ip[1] << 8);
+    ip += 2;
+    if (offset == 0 || offset > static_cast<size_t>(op - dst)) {
+      return false;
+    }
+    size_t match_length = token & 0xf;
+    if (match_length == kLengthContinues &&
+        !ReadLength(&ip, end, &match_length)) {
+      return false;
+    }
+    match_length += kMinMatch;
+    if (match_length > static_cast<size_t>(output_end - op)) {
+      return false;
+    }
+    // Byte by byte, the match may overlap the bytes it produces.
+    const uint8_t* match = op - offset;
+    for (size_t i = 0; i < match_length; ++i) {
+      op[i] = match[i];
+    }
+    op += match_length;
+  }
+  return op == output_end;
+}
+
+}  // namespace lz4
+}  // namespace tango_gl
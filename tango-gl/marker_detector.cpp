@@ -0,0 +1,707 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "tango-gl/marker_detector.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+typedef tango_gl::MarkerDetector MarkerDetector;
+
+const uint8_t kDark = 0;
+const uint8_t kLight = 1;
+const uint8_t kIgnored = 2;
+
+// Codes of the dictionary differ by at least this many bits, in any
+// rotation.
+const int kMinCodeDistance = 5;
+// Codes with fewer white or dark cells look too much like a blob.
+const int kMinCodeBits = 5;
+
+// The 8 neighbors clockwise from the east, y pointing down.
+const int kNeighborX[8] = {1, 1, 0, -1, -1, -1, 0, 1};
+const int kNeighborY[8] = {0, 1, 1, 1, 0, -1, -1, -1};
+
+// Direction of a neighbor offset, indexed by (dy + 1) * 3 + dx + 1.
+const int kNeighborDirection[9] = {5, 6, 7, 4, -1, 0, 3, 2, 1};
+
+const int kCodeBitCount = MarkerDetector::kDataSize * MarkerDetector::kDataSize;
+
+// The data cells turned a quarter clockwise.
+uint16_t RotateCode(uint16_t code) {
+  const int n = MarkerDetector::kDataSize;
+  uint16_t rotated = 0;
+  for (int row = 0; row < n; ++row) {
+    for (int column = 0; column < n; ++column) {
+      // The cell at (column, row) comes from (row, n - 1 - column).
+      const int source = (n - 1 - column) * n + row;
+      if (code & (1 << (kCodeBitCount - 1 - source))) {
+        rotated |= 1 << (kCodeBitCount - 1 - (row * n + column));
+      }
+    }
+  }
+  return rotated;
+}
+
+int CountBits(uint32_t value) { return __builtin_popcount(value); }
+
+// Greedy pick of the 16 bit codes in a fixed pseudo-random order, so the
+// dictionary is the same everywhere without storing it.
+std::vector<uint16_t> BuildDictionary() {
+  std::vector<uint16_t> codes;
+  for (uint32_t i = 0; i < (1u << kCodeBitCount); ++i) {
+    const uint16_t code = static_cast<uint16_t>(i * 40503u + 12345u);
+    const int bit_count = CountBits(code);
+    if (bit_count < kMinCodeBits || bit_count > kCodeBitCount - kMinCodeBits) {
+      continue;
+    }
+    uint16_t rotations[4] = {code, 0, 0, 0};
+    bool is_valid = true;
+    for (int k = 1; k < 4 && is_valid; ++k) {
+      rotations[k] = RotateCode(rotations[k - 1]);
+      is_valid = CountBits(rotations[k] ^ code) >= kMinCodeDistance;
+    }
+    for (size_t j = 0; j < codes.size() && is_valid; ++j) {
+      for (int k = 0; k < 4 && is_valid; ++k) {
+        is_valid = CountBits(rotations[k] ^ codes[j]) >= kMinCodeDistance;
+      }
+    }
+    if (is_valid) {
+      codes.push_back(code);
+    }
+  }
+  return codes;
+}
+
+const std::vector<uint16_t>& GetDictionary() {
+  static const std::vector<uint16_t> dictionary = BuildDictionary();
+  return dictionary;
+}
+
+int Find(std::vector<int32_t>* parents, int32_t label) {
+  std::vector<int32_t>& p = *parents;
+  while (p[label] != label) {
+    p[label] = p[p[label]];
+    label = p[label];
+  }
+  return label;
+}
+
+void ApplyHomography(const double h[9], double x, double y, float* u,
+                     float* v) {
+  const double w = h[6] * x + h[7] * y + h[8];
+  *u = static_cast<float>((h[0] * x + h[1] * y + h[2]) / w);
+  *v = static_cast<float>((h[3] * x + h[4] * y + h[5]) / w);
+}
+
+// Bilinear sample of the region at continuous coordinates, -1 outside.
+int Sample(const uint8_t* image, int stride, const MarkerDetector::Roi& roi,
+           float x, float y) {
+  const float sx = x - 0.5f;
+  const float sy = y - 0.5f;
+  const int x0 = static_cast<int>(std::floor(sx));
+  const int y0 = static_cast<int>(std::floor(sy));
+  if (x0 < 0 || y0 < 0 || x0 + 1 >= roi.width || y0 + 1 >= roi.height) {
+    return -1;
+  }
+  const float fx = sx - x0;
+  const float fy = sy - y0;
+  const uint8_t* p = image + (roi.y + y0) * stride + roi.x + x0;
+  const float top = p[0] + fx * (p[1] - p[0]);
+  const float bottom = p[stride] + fx * (p[stride + 1] - p[stride]);
+  return static_cast<int>(top + fy * (bottom - top) + 0.5f);
+}
+
+float Cross(const float o[2], const float a[2], const float b[2]) {
+  return (a[0] - o[0]) * (b[1] - o[1]) - (a[1] - o[1]) * (b[0] - o[0]);
+}
+
+// Signed area, positive for a quad clockwise in the image.
+float GetArea(const float corners[4][2]) {
+  float area = 0.0f;
+  for (int i = 0; i < 4; ++i) {
+    const float* a = corners[i];
+    const float* b = corners[(i + 1) % 4];
+    area += a[0] * b[1] - b[0] * a[1];
+  }
+  return 0.5f * area;
+}
+}  // namespace
+
+namespace tango_gl {
+
+const int MarkerDetector::kDataSize;
+const int MarkerDetector::kGridSize;
+
+MarkerDetector::MarkerDetector(const Options& options) : options_(options) {}
+
+size_t MarkerDetector::Detect(const uint8_t* image, int width, int height,
+                              int stride, const Roi* roi, float scale,
+                              std::vector<Quad>* quads) {
+  Roi region = {0, 0, width, height};
+  if (roi != nullptr) {
+    region.x = std::max(roi->x, 0);
+    region.y = std::max(roi->y, 0);
+    region.width = std::min(roi->x + roi->width, width) - region.x;
+    region.height = std::min(roi->y + roi->height, height) - region.y;
+  }
+  const int min_side = static_cast<int>(options_.min_side);
+  if (region.width <= min_side + 2 || region.height <= min_side + 2) {
+    return 0;
+  }
+  Threshold(image, stride, region);
+  Label(region.width, region.height);
+
+  const size_t first_quad = quads->size();
+  for (size_t label = 0; label < components_.size(); ++label) {
+    const Component& component = components_[label];
+    const int component_width = component.max_x - component.min_x + 1;
+    const int component_height = component.max_y - component.min_y + 1;
+    // A marker needs its margin inside the region, and a border at least
+    // as long as its sides.
+    if (component_width < min_side || component_height < min_side ||
+        component.count < 2 * min_side || component.min_x == 0 ||
+        component.min_y == 0 || component.max_x == region.width - 1 ||
+        component.max_y == region.height - 1) {
+      continue;
+    }
+    TraceContour(static_cast<int>(label), component.first, region.width,
+                 region.height);
+    Quad quad;
+    if (!FitQuad(quad.corners) ||
+        !Decode(image, stride, region, quad.corners, &quad.id,
+                &quad.bit_errors)) {
+      continue;
+    }
+    for (float* corner : quad.corners) {
+      corner[0] = (corner[0] + region.x) * scale;
+      corner[1] = (corner[1] + region.y) * scale;
+    }
+    quads->push_back(quad);
+  }
+  return quads->size() - first_quad;
+}
+
+int MarkerDetector::GetDictionarySize() {
+  return static_cast<int>(GetDictionary().size());
+}
+
+uint16_t MarkerDetector::GetCode(int id) { return GetDictionary()[id]; }
+
+bool MarkerDetector::IsCellWhite(int id, int column, int row) {
+  if (column <= 0 || row <= 0 || column >= kGridSize - 1 ||
+      row >= kGridSize - 1) {
+    return false;
+  }
+  const int bit = (row - 1) * kDataSize + column - 1;
+  return (GetCode(id) & (1 << (kCodeBitCount - 1 - bit))) != 0;
+}
+
+bool MarkerDetector::ComputeHomography(const float source[4][2],
+                                       const float destination[4][2],
+                                       double h[9]) {
+  double a[8][9];
+  for (int i = 0; i < 4; ++i) {
+    const double x = source[i][0];
+    const double y = source[i][1];
+    const double u = destination[i][0];
+    const double v = destination[i][1];
+    const double row_u[9] = {x, y, 1.0, 0.0, 0.0, 0.0, -x * u, -y * u, u};
+    const double row_v[9] = {0.0, 0.0, 0.0, x, y, 1.0, -x * v, -y * v, v};
+    std::copy(row_u, row_u + 9, a[2 * i]);
+    std::copy(row_v, row_v + 9, a[2 * i + 1]);
+  }
+  // Gaussian elimination with partial pivoting.
+  for (int column = 0; column < 8; ++column) {
+    int pivot = column;
+    for (int row = column + 1; row < 8; ++row) {
+      if (std::abs(a[row][column]) > std::abs(a[pivot][column])) {
+        pivot = row;
+      }
+    }
+    if (std::abs(a[pivot][column]) < 1e-12) {
+      return false;
+    }
+    std::swap_ranges(a[column], a[column] + 9, a[pivot]);
+    for (int row = 0; row < 8; ++row) {
+      if (row == column) {
+        continue;
+      }
+      const double factor = a[row][column] / a[column][column];
+      for (int k = column; k < 9; ++k) {
+        a[row][k] -= factor * a[column][k];
+      }
+    }
+  }
+  for (int i = 0; i < 8; ++i) {
+    h[i] = a[i][8] / a[i][i];
+  }
+  h[8] = 1.0;
+  return true;
+}
+
+void MarkerDetector::Threshold(const uint8_t* image, int stride,
+                               const Roi& roi) {
+  const int tile_size = std::max(options_.tile_size, 2);
+  const int tile_columns = (roi.width + tile_size - 1) / tile_size;
+  const int tile_rows = (roi.height + tile_size - 1) / tile_size;
+  const int tile_count = tile_columns * tile_rows;
+  // The extremes of each tile, then of the 3x3 tiles around it.
+  tile_min_.assign(2 * tile_count, 255);
+  tile_max_.assign(2 * tile_count, 0);
+  for (int y = 0; y < roi.height; ++y) {
+    const uint8_t* row = image + (roi.y + y) * stride + roi.x;
+    uint8_t* tile_min = &tile_min_[(y / tile_size) * tile_columns];
+    uint8_t* tile_max = &tile_max_[(y / tile_size) * tile_columns];
+    for (int x = 0; x < roi.width; ++x) {
+      const int tile = x / tile_size;
+      tile_min[tile] = std::min(tile_min[tile], row[x]);
+      tile_max[tile] = std::max(tile_max[tile], row[x]);
+    }
+  }
+  for (int ty = 0; ty < tile_rows; ++ty) {
+    for (int tx = 0; tx < tile_columns; ++tx) {
+      uint8_t low = 255;
+      uint8_t high = 0;
+      for (int dy = std::max(ty - 1, 0); dy <= std::min(ty + 1, tile_rows - 1);
+           ++dy) {
+        for (int dx = std::max(tx - 1, 0);
+             dx <= std::min(tx + 1, tile_columns - 1); ++dx) {
+          low = std::min(low, tile_min_[dy * tile_columns + dx]);
+          high = std::max(high, tile_max_[dy * tile_columns + dx]);
+        }
+      }
+      tile_min_[tile_count + ty * tile_columns + tx] = low;
+      tile_max_[tile_count + ty * tile_columns + tx] = high;
+    }
+  }
+
+  binary_.resize(roi.width * roi.height);
+  for (int y = 0; y < roi.height; ++y) {
+    const uint8_t* row = image + (roi.y + y) * stride + roi.x;
+    const uint8_t* tile_min =
+        &tile_min_[tile_count + (y / tile_size) * tile_columns];
+    const uint8_t* tile_max =
+        &tile_max_[tile_count + (y / tile_size) * tile_columns];
+    uint8_t* out = &binary_[y * roi.width];
+    for (int x = 0; x < roi.width; ++x) {
+      const int low = tile_min[x / tile_size];
+      const int high = tile_max[x / tile_size];
+      if (high - low < options_.min_contrast) {
+        out[x] = kIgnored;
+      } else {
+        out[x] = 2 * row[x] < low + high ? kDark : kLight;
+      }
+    }
+  }
+}
+
+void MarkerDetector::Label(int width, int height) {
+  labels_.assign(width * height, -1);
+  parents_.clear();
+  for (int y = 0; y < height; ++y) {
+    for (int x = 0; x < width; ++x) {
+      const int index = y * width + x;
+      if (binary_[index] != kDark) {
+        continue;
+      }
+      // The neighbors already visited: west, north west, north, north east.
+      int32_t label = -1;
+      const int neighbors[4][2] = {{-1, 0}, {-1, -1}, {0, -1}, {1, -1}};
+      for (const int* neighbor : neighbors) {
+        const int nx = x + neighbor[0];
+        const int ny = y + neighbor[1];
+        if (nx < 0 || ny < 0 || nx >= width) {
+          continue;
+        }
+        const int32_t neighbor_label = labels_[ny * width + nx];
+        if (neighbor_label < 0) {
+          continue;
+        }
+        const int32_t root = Find(&parents_, neighbor_label);
+        if (label < 0) {
+          label = root;
+        } else if (root != label) {
+          // Parents always have the smaller label.
+          parents_[std::max(root, label)] = std::min(root, label);
+          label = std::min(root, label);
+        }
+      }
+      if (label < 0) {
+        label = static_cast<int32_t>(parents_.size());
+        parents_.push_back(label);
+      }
+      labels_[index] = label;
+    }
+  }
+
+  // Parents come first, so one pass in order flattens the trees, and a
+  // second one numbers the roots in place.
+  for (size_t i = 0; i < parents_.size(); ++i) {
+    parents_[i] = parents_[parents_[i]];
+  }
+  components_.clear();
+  for (size_t i = 0; i < parents_.size(); ++i) {
+    if (parents_[i] == static_cast<int32_t>(i)) {
+      parents_[i] = static_cast<int32_t>(components_.size());
+      Component component = {0, width, height, -1, -1, -1};
+      components_.push_back(component);
+    } else {
+      parents_[i] = parents_[parents_[i]];
+    }
+  }
+  for (int y = 0; y < height; ++y) {
+    for (int x = 0; x < width; ++x) {
+      const int index = y * width + x;
+      if (labels_[index] < 0) {
+        continue;
+      }
+      labels_[index] = parents_[labels_[index]];
+      Component& component = components_[labels_[index]];
+      if (component.count++ == 0) {
+        component.first = index;
+      }
+      component.min_x = std::min(component.min_x, x);
+      component.min_y = std::min(component.min_y, y);
+      component.max_x = std::max(component.max_x, x);
+      component.max_y = std::max(component.max_y, y);
+    }
+  }
+}
+
+void MarkerDetector::TraceContour(int label, int first, int width,
+                                  int height) {
+  contour_.clear();
+  const int start_x = first % width;
+  const int start_y = first / width;
+  int x = start_x;
+  int y = start_y;
+  // The first pixel in raster order has no component pixel to its west.
+  int backtrack_x = x - 1;
+  int backtrack_y = y;
+  int first_direction = -1;
+  // The contour of a component can not be longer than twice its pixels.
+  const size_t max_length = 2 * components_[label].count + 8;
+  while (contour_.size() < 2 * max_length) {
+    const int start_direction =
+        kNeighborDirection[(backtrack_y - y + 1) * 3 + backtrack_x - x + 1];
+    int direction = -1;
+    for (int k = 1; k <= 8; ++k) {
+      const int candidate = (start_direction + k) % 8;
+      const int nx = x + kNeighborX[candidate];
+      const int ny = y + kNeighborY[candidate];
+      if (nx >= 0 && ny >= 0 && nx < width && ny < height &&
+          labels_[ny * width + nx] == label) {
+        direction = candidate;
+        break;
+      }
+      backtrack_x = nx;
+      backtrack_y = ny;
+    }
+    if (direction < 0) {
+      // An isolated pixel.
+      contour_.push_back(x);
+      contour_.push_back(y);
+      return;
+    }
+    // Back at the start about to take the first step again: closed.
+    if (x == start_x && y == start_y) {
+      if (direction == first_direction) {
+        return;
+      }
+      if (first_direction < 0) {
+        first_direction = direction;
+      }
+    }
+    contour_.push_back(x);
+    contour_.push_back(y);
+    x += kNeighborX[direction];
+    y += kNeighborY[direction];
+  }
+}
+
+bool MarkerDetector::FitQuad(float corners[4][2]) const {
+  const int count = static_cast<int>(contour_.size() / 2);
+  if (count < 8) {
+    return false;
+  }
+  // Pixel centers.
+  auto point_x = [this](int i) { return contour_[2 * i] + 0.5f; };
+  auto point_y = [this](int i) { return contour_[2 * i + 1] + 0.5f; };
+  float center_x = 0.0f;
+  float center_y = 0.0f;
+  for (int i = 0; i < count; ++i) {
+    center_x += point_x(i);
+    center_y += point_y(i);
+  }
+  center_x /= count;
+  center_y /= count;
+
+  // Two opposite corners are the farthest points, the two others the
+  // farthest from the diagonal on each side.
+  auto farthest_from = [&](float fx, float fy) {
+    int best = 0;
+    float best_distance = -1.0f;
+    for (int i = 0; i < count; ++i) {
+      const float dx = point_x(i) - fx;
+      const float dy = point_y(i) - fy;
+      if (dx * dx + dy * dy > best_distance) {
+        best_distance = dx * dx + dy * dy;
+        best = i;
+      }
+    }
+    return best;
+  };
+  int indices[4];
+  indices[0] = farthest_from(center_x, center_y);
+  indices[2] = farthest_from(point_x(indices[0]), point_y(indices[0]));
+  const float ax = point_x(indices[0]);
+  const float ay = point_y(indices[0]);
+  const float bx = point_x(indices[2]) - ax;
+  const float by = point_y(indices[2]) - ay;
+  const float diagonal = std::sqrt(bx * bx + by * by);
+  if (diagonal < options_.min_side) {
+    return false;
+  }
+  for (int side = 0; side < 2; ++side) {
+    const int begin = indices[2 * side];
+    const int end = indices[(2 * side + 2) % 4];
+    float best_distance = 0.0f;
+    int best = -1;
+    for (int i = begin; i != end; i = (i + 1) % count) {
+      const float distance =
+          std::abs((point_x(i) - ax) * by - (point_y(i) - ay) * bx) /
+          diagonal;
+      if (distance > best_distance) {
+        best_distance = distance;
+        best = i;
+      }
+    }
+    if (best < 0 || best_distance < 0.25f * options_.min_side) {
+      return false;
+    }
+    indices[2 * side + 1] = best;
+  }
+
+  // Fit a line to the middle of each side, the contour runs through the
+  // centers of the border pixels, half a pixel inside the edge.
+  float lines[4][3];
+  for (int side = 0; side < 4; ++side) {
+    const int begin = indices[side];
+    const int end = indices[(side + 1) % 4];
+    const int length = (end - begin + count) % count;
+    const float rough_x = point_x(end) - point_x(begin);
+    const float rough_y = point_y(end) - point_y(begin);
+    const float rough_length = std::sqrt(rough_x * rough_x + rough_y * rough_y);
+    if (length < 3 || rough_length < 0.5f * options_.min_side) {
+      return false;
+    }
+    const float tolerance = std::max(1.5f, 0.06f * rough_length);
+    int outlier_count = 0;
+    double sum_x = 0.0;
+    double sum_y = 0.0;
+    int fit_count = 0;
+    const int margin = length / 6;
+    for (int k = 0; k <= length; ++k) {
+      const int i = (begin + k) % count;
+      const float distance = std::abs((point_x(i) - point_x(begin)) * rough_y -
+                                      (point_y(i) - point_y(begin)) * rough_x) /
+                             rough_length;
+      if (distance > tolerance) {
+        ++outlier_count;
+      }
+      if (k >= margin && k <= length - margin) {
+        sum_x += point_x(i);
+        sum_y += point_y(i);
+        ++fit_count;
+      }
+    }
+    if (outlier_count * 10 > length) {
+      return false;
+    }
+    const double mean_x = sum_x / fit_count;
+    const double mean_y = sum_y / fit_count;
+    double xx = 0.0;
+    double xy = 0.0;
+    double yy = 0.0;
+    for (int k = margin; k <= length - margin; ++k) {
+      const int i = (begin + k) % count;
+      const double dx = point_x(i) - mean_x;
+      const double dy = point_y(i) - mean_y;
+      xx += dx * dx;
+      xy += dx * dy;
+      yy += dy * dy;
+    }
+    const double angle = 0.5 * std::atan2(2.0 * xy, xx - yy);
+    float normal_x = static_cast<float>(-std::sin(angle));
+    float normal_y = static_cast<float>(std::cos(angle));
+    // Point the normal out of the quad, and move the line to the edge.
+    if (normal_x * (mean_x - center_x) + normal_y * (mean_y - center_y) < 0) {
+      normal_x = -normal_x;
+      normal_y = -normal_y;
+    }
+    lines[side][0] = normal_x;
+    lines[side][1] = normal_y;
+    lines[side][2] =
+        static_cast<float>(normal_x * mean_x + normal_y * mean_y) + 0.5f;
+  }
+
+  // Corner i is where side i - 1 meets side i.
+  for (int i = 0; i < 4; ++i) {
+    const float* a = lines[(i + 3) % 4];
+    const float* b = lines[i];
+    const float determinant = a[0] * b[1] - a[1] * b[0];
+    if (std::abs(determinant) < 1e-3f) {
+      return false;
+    }
+    corners[i][0] = (a[2] * b[1] - a[1] * b[2]) / determinant;
+    corners[i][1] = (a[0] * b[2] - a[2] * b[0]) / determinant;
+    const float dx = corners[i][0] - point_x(indices[i]);
+    const float dy = corners[i][1] - point_y(indices[i]);
+    if (dx * dx + dy * dy > 0.04f * diagonal * diagonal) {
+      return false;
+    }
+  }
+  if (GetArea(corners) < 0.0f) {
+    std::swap(corners[1][0], corners[3][0]);
+    std::swap(corners[1][1], corners[3][1]);
+  }
+  // Convex, with sides long enough.
+  for (int i = 0; i < 4; ++i) {
+    const float* a = corners[i];
+    const float* b = corners[(i + 1) % 4];
+    const float* c = corners[(i + 2) % 4];
+    const float side_x = b[0] - a[0];
+    const float side_y = b[1] - a[1];
+    if (Cross(a, b, c) <= 0.0f ||
+        side_x * side_x + side_y * side_y <
+            options_.min_side * options_.min_side) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool MarkerDetector::Decode(const uint8_t* image, int stride, const Roi& roi,
+                            float corners[4][2], int* id,
+                            int* bit_errors) const {
+  const float grid = static_cast<float>(kGridSize);
+  const float square[4][2] = {{0.0f, 0.0f}, {grid, 0.0f}, {grid, grid},
+                              {0.0f, grid}};
+  double h[9];
+  if (!ComputeHomography(square, corners, h)) {
+    return false;
+  }
+  auto sample_cell = [&](float column, float row) {
+    float x;
+    float y;
+    ApplyHomography(h, column, row, &x, &y);
+    return Sample(image, stride, roi, x, y);
+  };
+
+  // The border cells and the margin around them are the dark and light
+  // references.
+  int border[4 * (kGridSize - 1)];
+  int border_count = 0;
+  int dark_sum = 0;
+  int light_sum = 0;
+  int light_count = 0;
+  for (int k = 0; k < kGridSize; ++k) {
+    const float c = k + 0.5f;
+    const float cells[4][2] = {{c, 0.5f}, {c, grid - 0.5f}, {0.5f, c},
+                               {grid - 0.5f, c}};
+    const float margin[4][2] = {{c, -0.5f}, {c, grid + 0.5f}, {-0.5f, c},
+                                {grid + 0.5f, c}};
+    for (int side = 0; side < 4; ++side) {
+      // The corner cells are on two sides.
+      if (side >= 2 && (k == 0 || k == kGridSize - 1)) {
+        continue;
+      }
+      const int value = sample_cell(cells[side][0], cells[side][1]);
+      if (value < 0) {
+        return false;
+      }
+      border[border_count++] = value;
+      dark_sum += value;
+    }
+    for (int side = 0; side < 4; ++side) {
+      const int value = sample_cell(margin[side][0], margin[side][1]);
+      if (value >= 0) {
+        light_sum += value;
+        ++light_count;
+      }
+    }
+  }
+  if (light_count < 2 * kGridSize) {
+    return false;
+  }
+  const int dark = dark_sum / border_count;
+  const int light = light_sum / light_count;
+  if (light - dark < options_.min_contrast) {
+    return false;
+  }
+  const int threshold = (dark + light) / 2;
+  for (int i = 0; i < border_count; ++i) {
+    if (border[i] >= threshold) {
+      return false;
+    }
+  }
+
+  uint16_t observed = 0;
+  for (int row = 0; row < kDataSize; ++row) {
+    for (int column = 0; column < kDataSize; ++column) {
+      const int value = sample_cell(column + 1.5f, row + 1.5f);
+      if (value < 0) {
+        return false;
+      }
+      if (value >= threshold) {
+        observed |= 1 << (kCodeBitCount - 1 - (row * kDataSize + column));
+      }
+    }
+  }
+
+  // A marker turned k quarters clockwise shows its code turned as much, and
+  // its top left corner at corner k.
+  const std::vector<uint16_t>& dictionary = GetDictionary();
+  const int max_bit_errors = std::min(options_.max_bit_errors, 2);
+  uint16_t rotations[4] = {observed, 0, 0, 0};
+  for (int k = 1; k < 4; ++k) {
+    rotations[k] = RotateCode(rotations[k - 1]);
+  }
+  for (int k = 0; k < 4; ++k) {
+    const uint16_t code = rotations[(4 - k) % 4];
+    for (size_t i = 0; i < dictionary.size(); ++i) {
+      const int errors = CountBits(code ^ dictionary[i]);
+      if (errors > max_bit_errors) {
+        continue;
+      }
+      float rotated[4][2];
+      for (int c = 0; c < 4; ++c) {
+        rotated[c][0] = corners[(c + k) % 4][0];
+        rotated[c][1] = corners[(c + k) % 4][1];
+      }
+      std::copy(&rotated[0][0], &rotated[0][0] + 8, &corners[0][0]);
+      *id = static_cast<int>(i);
+      *bit_errors = errors;
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace tango_gl
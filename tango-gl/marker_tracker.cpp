@@ -0,0 +1,371 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "tango-gl/marker_tracker.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+#include "tango-gl/camera_intrinsics_registry.h"
+
+namespace {
+// How long the tracking thread sleeps when no new frame is published. Short
+// next to a camera frame.
+const std::chrono::milliseconds kIdleInterval(2);
+
+// Margin around the expected corners of a marker, as a part of its side
+// plus pixels of the frame.
+const float kRoiMargin = 0.25f;
+const float kRoiMarginPixels = 4.0f;
+
+// Points closer to the camera plane are not projected.
+const float kMinDepth = 0.01f;
+
+const double kNever = -std::numeric_limits<double>::infinity();
+}  // namespace
+
+namespace tango_gl {
+
+MarkerTracker::MarkerTracker(CameraStream* stream,
+                             const PoseHistory* pose_history,
+                             const Options& options)
+    : stream_(stream),
+      pose_history_(pose_history),
+      options_(options),
+      has_camera_(false),
+      is_stopping_(false),
+      tracking_detector_(options.detector),
+      last_detection_time_(kNever),
+      frame_scale_(1.0f),
+      detection_stage_("marker_detect", 1, -1,
+                       [this](double* timestamp) { Detect(timestamp); }),
+      is_detecting_(false),
+      detection_detector_(options.detector),
+      detection_width_(0),
+      detection_height_(0),
+      detection_level_(0),
+      has_detections_(false),
+      detection_timestamp_(0.0) {
+  memset(&intrinsics_, 0, sizeof(intrinsics_));
+}
+
+MarkerTracker::~MarkerTracker() { Stop(); }
+
+void MarkerTracker::SetCamera(const TangoCameraIntrinsics& intrinsics,
+                              const RigidTransform& device_T_camera) {
+  intrinsics_ = intrinsics;
+  device_T_camera_ = device_T_camera;
+  has_camera_ = intrinsics.width > 0 && intrinsics.fx > 0.0;
+}
+
+void MarkerTracker::Start() {
+  if (thread_.joinable()) {
+    return;
+  }
+  is_stopping_ = false;
+  last_detection_time_ = kNever;
+  detection_stage_.Start();
+  thread_ = std::thread(&MarkerTracker::TrackLoop, this);
+}
+
+void MarkerTracker::Stop() {
+  if (!thread_.joinable()) {
+    return;
+  }
+  is_stopping_ = true;
+  thread_.join();
+  detection_stage_.Stop();
+  is_detecting_ = false;
+  has_detections_ = false;
+  tracks_.clear();
+  std::lock_guard<std::mutex> lock(markers_mutex_);
+  markers_.clear();
+}
+
+size_t MarkerTracker::GetMarkers(std::vector<Marker>* markers) const {
+  std::lock_guard<std::mutex> lock(markers_mutex_);
+  *markers = markers_;
+  return markers->size();
+}
+
+void MarkerTracker::TrackLoop() {
+  while (!is_stopping_.load(std::memory_order_acquire)) {
+    bool is_new_frame = false;
+    const CameraStream::Frame* frame = stream_->Acquire(&is_new_frame);
+    if (frame == nullptr || !is_new_frame) {
+      std::this_thread::sleep_for(kIdleInterval);
+      continue;
+    }
+    ProcessFrame(*frame);
+  }
+}
+
+void MarkerTracker::ProcessFrame(const CameraStream::Frame& frame) {
+  frame_scale_ =
+      has_camera_ ? static_cast<float>(frame.width) / intrinsics_.width : 1.0f;
+  const int level_count =
+      std::min(std::max(options_.detection_level, 0),
+               LuminancePyramid::kMaxLevelCount - 1) + 1;
+  const LuminancePyramid* pyramid = &frame.pyramid;
+  if (frame.pyramid.GetLevelCount() < level_count) {
+    // The Y plane leads both formats of the stream.
+    pyramid_.Build(frame.data.data(), frame.width, frame.height, frame.width,
+                   level_count);
+    pyramid = &pyramid_;
+  }
+
+  MergeDetections();
+  for (Track& track : tracks_) {
+    if (TrackMarker(*pyramid, frame.timestamp, &track)) {
+      track.marker.timestamp = frame.timestamp;
+      track.missed_frames = 0;
+      UpdatePose(&track);
+    } else {
+      ++track.missed_frames;
+    }
+  }
+  tracks_.erase(std::remove_if(tracks_.begin(), tracks_.end(),
+                               [this](const Track& track) {
+                                 return track.missed_frames >
+                                        options_.max_missed_frames;
+                               }),
+                tracks_.end());
+
+  if (!is_detecting_.load(std::memory_order_acquire) &&
+      frame.timestamp - last_detection_time_ >= options_.detection_interval) {
+    const int level = std::min(level_count, pyramid->GetLevelCount()) - 1;
+    StartDetection(pyramid->GetLevel(level), level, frame.timestamp);
+  }
+
+  std::lock_guard<std::mutex> lock(markers_mutex_);
+  markers_.clear();
+  for (const Track& track : tracks_) {
+    if (track.missed_frames == 0) {
+      markers_.push_back(track.marker);
+    }
+  }
+}
+
+void MarkerTracker::StartDetection(const LuminancePyramid::Level& level,
+                                   int level_index, double timestamp) {
+  // The frame slot goes back to the stream with the next Acquire(), the
+  // search works on a copy.
+  detection_image_.resize(level.width * level.height);
+  for (int y = 0; y < level.height; ++y) {
+    memcpy(&detection_image_[y * level.width], level.data + y * level.stride,
+           level.width);
+  }
+  detection_width_ = level.width;
+  detection_height_ = level.height;
+  detection_level_ = level_index;
+  last_detection_time_ = timestamp;
+  is_detecting_.store(true, std::memory_order_release);
+  detection_stage_.Submit(timestamp);
+}
+
+void MarkerTracker::Detect(double* timestamp) {
+  std::vector<MarkerDetector::Quad> quads;
+  detection_detector_.Detect(detection_image_.data(), detection_width_,
+                             detection_height_, detection_width_, nullptr,
+                             static_cast<float>(1 << detection_level_), &quads);
+  {
+    std::lock_guard<std::mutex> lock(detection_mutex_);
+    detections_.swap(quads);
+    detection_timestamp_ = *timestamp;
+    has_detections_ = true;
+  }
+  is_detecting_.store(false, std::memory_order_release);
+}
+
+void MarkerTracker::MergeDetections() {
+  std::lock_guard<std::mutex> lock(detection_mutex_);
+  if (!has_detections_) {
+    return;
+  }
+  has_detections_ = false;
+  for (const MarkerDetector::Quad& quad : detections_) {
+    auto it = std::find_if(
+        tracks_.begin(), tracks_.end(),
+        [&quad](const Track& track) { return track.marker.id == quad.id; });
+    // A marker tracked in a frame since the search is more recent.
+    if (it != tracks_.end() &&
+        it->marker.timestamp >= detection_timestamp_) {
+      continue;
+    }
+    if (it == tracks_.end()) {
+      it = tracks_.insert(tracks_.end(), Track());
+    }
+    it->marker.id = quad.id;
+    it->marker.timestamp = detection_timestamp_;
+    memcpy(it->marker.corners, quad.corners, sizeof(quad.corners));
+    it->missed_frames = 0;
+    UpdatePose(&*it);
+  }
+}
+
+bool MarkerTracker::TrackMarker(const LuminancePyramid& pyramid,
+                                double timestamp, Track* track) {
+  float expected[4][2];
+  if (!PredictCorners(*track, timestamp, expected)) {
+    memcpy(expected, track->marker.corners, sizeof(expected));
+  }
+  float min_x = expected[0][0];
+  float min_y = expected[0][1];
+  float max_x = min_x;
+  float max_y = min_y;
+  for (const float* corner : expected) {
+    min_x = std::min(min_x, corner[0]);
+    min_y = std::min(min_y, corner[1]);
+    max_x = std::max(max_x, corner[0]);
+    max_y = std::max(max_y, corner[1]);
+  }
+  const float margin =
+      kRoiMargin * std::max(max_x - min_x, max_y - min_y) + kRoiMarginPixels;
+  min_x -= margin;
+  min_y -= margin;
+  max_x += margin;
+  max_y += margin;
+
+  // The finest level where the region fits.
+  const float size = std::max(max_x - min_x, max_y - min_y);
+  int level = 0;
+  while (level + 1 < pyramid.GetLevelCount() &&
+         size / (1 << level) > options_.max_roi_size) {
+    ++level;
+  }
+  const float level_scale = static_cast<float>(1 << level);
+  MarkerDetector::Roi roi;
+  roi.x = static_cast<int>(std::floor(min_x / level_scale));
+  roi.y = static_cast<int>(std::floor(min_y / level_scale));
+  roi.width = static_cast<int>(std::ceil(max_x / level_scale)) - roi.x;
+  roi.height = static_cast<int>(std::ceil(max_y / level_scale)) - roi.y;
+
+  const LuminancePyramid::Level& image = pyramid.GetLevel(level);
+  tracking_quads_.clear();
+  tracking_detector_.Detect(image.data, image.width, image.height,
+                            image.stride, &roi, level_scale, &tracking_quads_);
+  const MarkerDetector::Quad* best = nullptr;
+  float best_distance = std::numeric_limits<float>::max();
+  for (const MarkerDetector::Quad& quad : tracking_quads_) {
+    const float dx = quad.corners[0][0] - expected[0][0];
+    const float dy = quad.corners[0][1] - expected[0][1];
+    if (quad.id == track->marker.id && dx * dx + dy * dy < best_distance) {
+      best_distance = dx * dx + dy * dy;
+      best = &quad;
+    }
+  }
+  if (best == nullptr) {
+    return false;
+  }
+  memcpy(track->marker.corners, best->corners, sizeof(best->corners));
+  return true;
+}
+
+bool MarkerTracker::PredictCorners(const Track& track, double timestamp,
+                                   float corners[4][2]) const {
+  RigidTransform world_T_device;
+  if (!track.marker.has_world_pose || pose_history_ == nullptr ||
+      !pose_history_->GetPose(timestamp, &world_T_device)) {
+    return false;
+  }
+  const RigidTransform camera_T_world =
+      (world_T_device * device_T_camera_).Inverse();
+  for (int i = 0; i < 4; ++i) {
+    if (!Project(camera_T_world.Apply(track.world_corners[i]), corners[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void MarkerTracker::UpdatePose(Track* track) const {
+  Marker& marker = track->marker;
+  marker.has_pose = false;
+  marker.has_world_pose = false;
+  if (!has_camera_) {
+    return;
+  }
+  // The homography from the marker plane to the normalized image plane is
+  // [r1 r2 t] up to scale.
+  const float half_size = 0.5f * options_.marker_size;
+  const float marker_corners[4][2] = {{-half_size, -half_size},
+                                      {half_size, -half_size},
+                                      {half_size, half_size},
+                                      {-half_size, half_size}};
+  float image_corners[4][2];
+  for (int i = 0; i < 4; ++i) {
+    const glm::vec2 distorted(
+        (marker.corners[i][0] / frame_scale_ - 0.5f - intrinsics_.cx) /
+            intrinsics_.fx,
+        (marker.corners[i][1] / frame_scale_ - 0.5f - intrinsics_.cy) /
+            intrinsics_.fy);
+    const glm::vec2 position =
+        CameraIntrinsicsRegistry::Undistort(intrinsics_, distorted);
+    image_corners[i][0] = position.x;
+    image_corners[i][1] = position.y;
+  }
+  double h[9];
+  if (!MarkerDetector::ComputeHomography(marker_corners, image_corners, h)) {
+    return;
+  }
+  glm::vec3 r1(h[0], h[3], h[6]);
+  glm::vec3 r2(h[1], h[4], h[7]);
+  glm::vec3 t(h[2], h[5], h[8]);
+  float scale = 2.0f / (glm::length(r1) + glm::length(r2));
+  // The marker is in front of the camera.
+  if (t.z < 0.0f) {
+    scale = -scale;
+  }
+  r1 = glm::normalize(r1 * scale);
+  r2 = glm::normalize(r2 * scale - glm::dot(r1, r2 * scale) * r1);
+  t *= scale;
+  const glm::mat3 rotation(r1, r2, glm::cross(r1, r2));
+  marker.camera_T_marker = RigidTransform(glm::quat_cast(rotation), t);
+  marker.has_pose = true;
+
+  RigidTransform world_T_device;
+  if (pose_history_ == nullptr ||
+      !pose_history_->GetPose(marker.timestamp, &world_T_device)) {
+    return;
+  }
+  marker.world_T_marker =
+      world_T_device * device_T_camera_ * marker.camera_T_marker;
+  marker.has_world_pose = true;
+  for (int i = 0; i < 4; ++i) {
+    track->world_corners[i] = marker.world_T_marker.Apply(
+        glm::vec3(marker_corners[i][0], marker_corners[i][1], 0.0f));
+  }
+}
+
+bool MarkerTracker::Project(const glm::vec3& point, float pixel[2]) const {
+  if (point.z < kMinDepth) {
+    return false;
+  }
+  const glm::vec2 distorted = CameraIntrinsicsRegistry::Distort(
+      intrinsics_, glm::vec2(point.x / point.z, point.y / point.z));
+  pixel[0] = (intrinsics_.fx * distorted.x + intrinsics_.cx + 0.5f) *
+             frame_scale_;
+  pixel[1] = (intrinsics_.fy * distorted.y + intrinsics_.cy + 0.5f) *
+             frame_scale_;
+  return true;
+}
+
+}  // namespace tango_gl
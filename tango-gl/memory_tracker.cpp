@@ -0,0 +1,313 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+
+#include "tango-gl/memory_tracker.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+typedef tango_gl::MemoryTracker MemoryTracker;
+
+struct Entry {
+  MemoryTracker::Kind kind;
+  size_t owner;
+  size_t bytes;
+  // Context of a GL object, EGL_NO_CONTEXT for host buffers.
+  EGLContext context;
+  uint64_t last_use_frame;
+  MemoryTracker::Evictable* evictable;
+};
+
+struct Owner {
+  const char* name;
+  MemoryTracker::Usage usage;
+};
+
+struct State {
+  State() : budget(0), frame(0), eviction_count(0) {}
+
+  std::mutex mutex;
+  std::unordered_map<uint64_t, Entry> entries;
+  // In order of first use.
+  std::vector<Owner> owners;
+  MemoryTracker::Usage kinds[MemoryTracker::kKindCount];
+  MemoryTracker::Usage total;
+  size_t budget;
+  uint64_t frame;
+  size_t eviction_count;
+};
+
+// Never destroyed, objects may be untracked during static destruction.
+State& GetState() {
+  static State* state = new State();
+  return *state;
+}
+
+uint64_t GetKey(MemoryTracker::Kind kind, uintptr_t id) {
+  return (static_cast<uint64_t>(kind) << 56) ^ static_cast<uint64_t>(id);
+}
+
+void Add(MemoryTracker::Usage* usage, size_t bytes) {
+  usage->bytes += bytes;
+  ++usage->object_count;
+  usage->high_water_mark = std::max(usage->high_water_mark, usage->bytes);
+}
+
+void Subtract(MemoryTracker::Usage* usage, size_t bytes) {
+  usage->bytes -= bytes;
+  --usage->object_count;
+}
+
+// Called with the mutex held.
+void AddEntry(State* state, const Entry& entry) {
+  Add(&state->owners[entry.owner].usage, entry.bytes);
+  Add(&state->kinds[entry.kind], entry.bytes);
+  Add(&state->total, entry.bytes);
+}
+
+// Called with the mutex held.
+void SubtractEntry(State* state, const Entry& entry) {
+  Subtract(&state->owners[entry.owner].usage, entry.bytes);
+  Subtract(&state->kinds[entry.kind], entry.bytes);
+  Subtract(&state->total, entry.bytes);
+}
+
+// Called with the mutex held.
+size_t GetOwner(State* state, const char* name) {
+  for (size_t i = 0; i < state->owners.size(); ++i) {
+    if (strcmp(state->owners[i].name, name) == 0) {
+      return i;
+    }
+  }
+  Owner owner;
+  owner.name = name;
+  state->owners.push_back(owner);
+  return state->owners.size() - 1;
+}
+
+void AppendLine(const char* name, const MemoryTracker::Usage& usage,
+                std::string* report) {
+  const float kMegabyte = 1024.0f * 1024.0f;
+  char line[128];
+  snprintf(line, sizeof(line), "memory %s %zu objects %.1f MB peak %.1f MB\n",
+           name, usage.object_count, usage.bytes / kMegabyte,
+           usage.high_water_mark / kMegabyte);
+  *report += line;
+}
+}  // namespace
+
+namespace tango_gl {
+
+void MemoryTracker::Track(Kind kind, uintptr_t id, const char* owner,
+                          size_t bytes) {
+  State& state = GetState();
+  std::lock_guard<std::mutex> lock(state.mutex);
+  Entry entry;
+  entry.kind = kind;
+  entry.owner = GetOwner(&state, owner);
+  entry.bytes = bytes;
+  entry.context = kind == kHost ? EGL_NO_CONTEXT : eglGetCurrentContext();
+  entry.last_use_frame = state.frame;
+  entry.evictable = nullptr;
+  auto it = state.entries.find(GetKey(kind, id));
+  if (it != state.entries.end()) {
+    entry.evictable = it->second.evictable;
+    SubtractEntry(&state, it->second);
+    it->second = entry;
+  } else {
+    state.entries.insert(std::make_pair(GetKey(kind, id), entry));
+  }
+  AddEntry(&state, entry);
+}
+
+void MemoryTracker::Untrack(Kind kind, uintptr_t id) {
+  State& state = GetState();
+  std::lock_guard<std::mutex> lock(state.mutex);
+  auto it = state.entries.find(GetKey(kind, id));
+  if (it != state.entries.end()) {
+    SubtractEntry(&state, it->second);
+    state.entries.erase(it);
+  }
+}
+
+void MemoryTracker::SetEvictable(Kind kind, uintptr_t id,
+                                 Evictable* evictable) {
+  State& state = GetState();
+  std::lock_guard<std::mutex> lock(state.mutex);
+  auto it = state.entries.find(GetKey(kind, id));
+  if (it != state.entries.end()) {
+    it->second.evictable = evictable;
+  }
+}
+
+void MemoryTracker::Touch(Kind kind, uintptr_t id) {
+  State& state = GetState();
+  std::lock_guard<std::mutex> lock(state.mutex);
+  auto it = state.entries.find(GetKey(kind, id));
+  if (it != state.entries.end()) {
+    it->second.last_use_frame = state.frame;
+  }
+}
+
+void MemoryTracker::SetBudget(size_t bytes) {
+  State& state = GetState();
+  std::lock_guard<std::mutex> lock(state.mutex);
+  state.budget = bytes;
+}
+
+size_t MemoryTracker::GetBudget() {
+  State& state = GetState();
+  std::lock_guard<std::mutex> lock(state.mutex);
+  return state.budget;
+}
+
+void MemoryTracker::BeginFrame() {
+  State& state = GetState();
+  std::vector<Evictable*> victims;
+  {
+    std::lock_guard<std::mutex> lock(state.mutex);
+    ++state.frame;
+    if (state.budget == 0 || state.total.bytes <= state.budget) {
+      return;
+    }
+    // Objects used in the previous frame are likely used again in this one.
+    std::vector<const Entry*> candidates;
+    for (const auto& item : state.entries) {
+      const Entry& entry = item.second;
+      if (entry.evictable != nullptr &&
+          entry.last_use_frame + 1 < state.frame) {
+        candidates.push_back(&entry);
+      }
+    }
+    std::sort(candidates.begin(), candidates.end(),
+              [](const Entry* a, const Entry* b) {
+                return a->last_use_frame < b->last_use_frame;
+              });
+    size_t bytes = state.total.bytes;
+    for (const Entry* entry : candidates) {
+      if (bytes <= state.budget) {
+        break;
+      }
+      bytes -= entry->bytes;
+      victims.push_back(entry->evictable);
+    }
+    state.eviction_count += victims.size();
+  }
+  // Evict() untracks the object, which takes the mutex.
+  for (Evictable* victim : victims) {
+    victim->Evict();
+  }
+}
+
+void MemoryTracker::ReleaseContext(EGLContext context) {
+  if (context == EGL_NO_CONTEXT) {
+    return;
+  }
+  State& state = GetState();
+  std::lock_guard<std::mutex> lock(state.mutex);
+  for (auto it = state.entries.begin(); it != state.entries.end();) {
+    if (it->second.context == context) {
+      SubtractEntry(&state, it->second);
+      it = state.entries.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+MemoryTracker::Usage MemoryTracker::GetTotal() {
+  State& state = GetState();
+  std::lock_guard<std::mutex> lock(state.mutex);
+  return state.total;
+}
+
+MemoryTracker::Usage MemoryTracker::GetKindUsage(Kind kind) {
+  State& state = GetState();
+  std::lock_guard<std::mutex> lock(state.mutex);
+  return state.kinds[kind];
+}
+
+MemoryTracker::Usage MemoryTracker::GetOwnerUsage(const char* owner) {
+  State& state = GetState();
+  std::lock_guard<std::mutex> lock(state.mutex);
+  for (const Owner& item : state.owners) {
+    if (strcmp(item.name, owner) == 0) {
+      return item.usage;
+    }
+  }
+  return Usage();
+}
+
+size_t MemoryTracker::GetEvictionCount() {
+  State& state = GetState();
+  std::lock_guard<std::mutex> lock(state.mutex);
+  return state.eviction_count;
+}
+
+std::string MemoryTracker::GetReport() {
+  State& state = GetState();
+  std::lock_guard<std::mutex> lock(state.mutex);
+  std::string report;
+  AppendLine("total", state.total, &report);
+  for (const Owner& owner : state.owners) {
+    AppendLine(owner.name, owner.usage, &report);
+  }
+  return report;
+}
+
+size_t MemoryTracker::GetTextureSize(GLsizei width, GLsizei height,
+                                     GLenum format, GLenum type) {
+  size_t components;
+  switch (format) {
+    case GL_RGBA:
+      components = 4;
+      break;
+    case GL_RGB:
+      components = 3;
+      break;
+    case GL_LUMINANCE_ALPHA:
+      components = 2;
+      break;
+    default:
+      components = 1;
+      break;
+  }
+  size_t pixel_size;
+  switch (type) {
+    case GL_UNSIGNED_SHORT_5_6_5:
+    case GL_UNSIGNED_SHORT_4_4_4_4:
+    case GL_UNSIGNED_SHORT_5_5_5_1:
+      pixel_size = 2;
+      break;
+    case GL_FLOAT:
+      pixel_size = components * 4;
+      break;
+    default:
+      pixel_size = components;
+      break;
+  }
+  return static_cast<size_t>(width) * height * pixel_size;
+}
+
+}  // namespace tango_gl
@@ -14,19 +14,55 @@
  * limitations under the License.
  */
 
+#include <string.h>
+
+#include <algorithm>
+
 #include "tango-gl/mesh.h"
-#include "tango-gl/shaders.h"
+#include "tango-gl/counters.h"
+#include "tango-gl/program_cache.h"
+#include "tango-gl/render_state.h"
+#include "tango-gl/shader_variants.h"
+#include "tango-gl/simd_math.h"
+
+namespace {
+// Shared by all the lit meshes, color in rgb and intensity in a.
+glm::vec4 g_ambient_light(1.0f, 1.0f, 1.0f, 0.3f);
+
+// 32 bit indices are core in OpenGL ES 3, an extension before.
+bool SupportsUintIndices() {
+  const char* version = reinterpret_cast<const char*>(glGetString(GL_VERSION));
+  const char* extensions =
+      reinterpret_cast<const char*>(glGetString(GL_EXTENSIONS));
+  return (version != nullptr && strncmp(version, "OpenGL ES 3", 11) == 0) ||
+         (extensions != nullptr &&
+          strstr(extensions, "GL_OES_element_index_uint") != nullptr);
+}
+}  // namespace
 
 namespace tango_gl {
-Mesh::Mesh() {
+Mesh::Mesh()
+    : vertex_buffer_(GL_ARRAY_BUFFER, GL_STATIC_DRAW),
+      index_buffer_(GL_ELEMENT_ARRAY_BUFFER, GL_STATIC_DRAW),
+      has_interleaved_normals_(false),
+      vertex_count_(0),
+      index_count_(0),
+      index_type_(GL_UNSIGNED_SHORT) {
   render_mode_ = GL_TRIANGLES;
 }
-Mesh::Mesh(GLenum render_mode) {
+Mesh::Mesh(GLenum render_mode)
+    : vertex_buffer_(GL_ARRAY_BUFFER, GL_STATIC_DRAW),
+      index_buffer_(GL_ELEMENT_ARRAY_BUFFER, GL_STATIC_DRAW),
+      has_interleaved_normals_(false),
+      vertex_count_(0),
+      index_count_(0),
+      index_type_(GL_UNSIGNED_SHORT) {
   render_mode_ = render_mode;
 }
 
 void Mesh::SetShader() {
   DrawableObject::SetShader();
+  vertex_array_.Reset();
   // Default mode set to no lighting.
   is_lighting_on_ = false;
   // Default mode set to without bounding box detection.
@@ -35,20 +71,29 @@ void Mesh::SetShader() {
 
 void Mesh::SetShader(bool is_lighting_on) {
   if (is_lighting_on) {
-    shader_program_ =
-        util::CreateProgram(shaders::GetShadedVertexShader().c_str(),
-                            shaders::GetBasicFragmentShader().c_str());
-    if (!shader_program_) {
+    program_cache::ReleaseProgram(shader_program_);
+    shader_program_ = 0;
+    const shader_variants::Variant* variant =
+        shader_variants::Acquire(shader_variants::kLighting |
+                                 shader_variants::kFrameConstants);
+    if (variant == nullptr) {
       LOGE("Could not create program.");
+      return;
     }
-    uniform_mvp_mat_ = glGetUniformLocation(shader_program_, "mvp");
-    uniform_mv_mat_ = glGetUniformLocation(shader_program_, "mv");
-    uniform_light_vec_ = glGetUniformLocation(shader_program_, "lightVec");
-    uniform_color_ = glGetUniformLocation(shader_program_, "color");
+    shader_program_ = variant->program;
+    uniform_mvp_mat_ = variant->uniforms[shader_variants::kMvp];
+    uses_frame_constants_ =
+        (variant->features & shader_variants::kFrameConstants) != 0;
+    uniform_model_mat_ = variant->uniforms[shader_variants::kModel];
+    uniform_mv_mat_ = variant->uniforms[shader_variants::kMv];
+    uniform_light_vec_ = variant->uniforms[shader_variants::kLightVec];
+    uniform_ambient_ = variant->uniforms[shader_variants::kAmbient];
+    uniform_color_ = variant->uniforms[shader_variants::kColor];
 
-    attrib_vertices_ = glGetAttribLocation(shader_program_, "vertex");
-    attrib_normals_ = glGetAttribLocation(shader_program_, "normal");
+    attrib_vertices_ = variant->attributes[shader_variants::kVertexAttribute];
+    attrib_normals_ = variant->attributes[shader_variants::kNormalAttribute];
     is_lighting_on_ = true;
+    vertex_array_.Reset();
     // Set a defualt direction for directional light.
     light_direction_ = glm::vec3(-1.0f, -3.0f, -1.0f);
     light_direction_ = glm::normalize(light_direction_);
@@ -57,22 +102,92 @@ void Mesh::SetShader(bool is_lighting_on) {
   }
 }
 
+void Mesh::SetVertices(const obj_loader::MappedMesh& mesh) {
+  if (mesh.GetIndexType() == GL_UNSIGNED_INT && !SupportsUintIndices()) {
+    LOGE("Mesh::SetVertices, 32 bit indices are not supported.");
+    return;
+  }
+  vertices_.clear();
+  normals_.clear();
+  indices_.clear();
+  geometry_.reset();
+  vertex_buffer_.Update(mesh.GetVertexData(),
+                        mesh.GetVertexCount() * mesh.GetVertexStride(), 0);
+  if (mesh.GetIndexCount() > 0) {
+    index_buffer_.Update(mesh.GetIndexData(),
+                         mesh.GetIndexCount() * mesh.GetIndexSize(), 0);
+  }
+  has_interleaved_normals_ = mesh.HasNormals();
+  vertex_count_ = mesh.GetVertexCount();
+  index_count_ = mesh.GetIndexCount();
+  index_type_ = mesh.GetIndexType();
+  is_vertex_data_dirty_ = false;
+  vertex_array_.Reset();
+}
+
+void Mesh::SetGeometry(std::shared_ptr<const Geometry> geometry) {
+  vertices_.clear();
+  normals_.clear();
+  indices_.clear();
+  geometry_ = geometry;
+  has_interleaved_normals_ = !geometry_->normals.empty();
+  vertex_count_ = geometry_->GetVertexCount();
+  index_count_ = geometry_->GetIndexCount();
+  index_type_ = GL_UNSIGNED_SHORT;
+  is_vertex_data_dirty_ = false;
+  vertex_array_.Reset();
+}
+
 void Mesh::SetBoundingBox(){
   // Traverse all the vertices to define an axis-aligned
   // bounding box for this mesh, needs to be called after SetVertices().
-  if(vertices_.size()==0){
+  if(GetVertices().size()==0){
     LOGE("Please set up vertices first!");
     return;
   }
   is_bounding_box_on_ = true;
-  bounding_box_ = new BoundingBox(vertices_);
+  bounding_box_ = new BoundingBox(GetVertices());
+}
+
+void Mesh::SetTriangleBvh() {
+  if (GetVertices().size() == 0) {
+    LOGE("Please set up vertices first!");
+    return;
+  }
+  if (render_mode_ != GL_TRIANGLES) {
+    LOGE("Mesh::SetTriangleBvh, only triangle lists are supported.");
+    return;
+  }
+  triangle_bvh_.reset(new MeshBvh());
+  triangle_bvh_->Build(GetVertices(), GetIndices());
 }
 
 void Mesh::SetLightDirection(const glm::vec3& light_direction) {
   light_direction_ = light_direction;
 }
 
-bool Mesh::IsIntersecting(const Segment& segment) {
+void Mesh::SetAmbientLight(const glm::vec3& color, float intensity) {
+  g_ambient_light = glm::vec4(color, intensity);
+}
+
+const glm::vec4& Mesh::GetAmbientLight() { return g_ambient_light; }
+
+bool Mesh::IsIntersecting(const Segment& segment, glm::vec3* hit_point) {
+  if (triangle_bvh_) {
+    // Positions along the segment are kept by the transformation.
+    glm::mat4 mesh_T_world = glm::inverse(GetTransformationMatrix());
+    Segment mesh_segment(util::ApplyTransform(mesh_T_world, segment.start),
+                         util::ApplyTransform(mesh_T_world, segment.end));
+    float t;
+    if (triangle_bvh_->Raycast(mesh_segment, &t) < 0) {
+      return false;
+    }
+    if (hit_point != nullptr) {
+      *hit_point = segment.start + t * (segment.end - segment.start);
+    }
+    return true;
+  }
+
   // If there is no bounding box defined based on all vertices,
   // we can not calculate intersection.
   if (!is_bounding_box_on_) {
@@ -83,42 +198,98 @@ bool Mesh::IsIntersecting(const Segment& segment) {
                                        GetTransformationMatrix());
 }
 
+bool Mesh::IsVisible(ViewFrustum* frustum) const {
+  if (!is_bounding_box_on_) {
+    return true;
+  }
+  return frustum->IsBoxVisible(*bounding_box_, GetTransformationMatrix());
+}
+
+void Mesh::UploadVertexData() const {
+  has_interleaved_normals_ =
+      !normals_.empty() && normals_.size() == vertices_.size();
+  if (has_interleaved_normals_) {
+    // Position and normal of a vertex next to each other:
+    // [x, y, z, nx, ny, nz, x, y, z, nx, ...]
+    std::vector<GLfloat> interleaved(vertices_.size() * 2);
+    for (size_t i = 0; i < vertices_.size(); i += 3) {
+      std::copy(vertices_.begin() + i, vertices_.begin() + i + 3,
+                interleaved.begin() + i * 2);
+      std::copy(normals_.begin() + i, normals_.begin() + i + 3,
+                interleaved.begin() + i * 2 + 3);
+    }
+    vertex_buffer_.Update(interleaved.data(),
+                          interleaved.size() * sizeof(GLfloat), 0);
+  } else {
+    vertex_buffer_.Update(vertices_.data(), vertices_.size() * sizeof(GLfloat),
+                          0);
+  }
+  if (!indices_.empty()) {
+    index_buffer_.Update(indices_.data(), indices_.size() * sizeof(GLushort),
+                         0);
+  }
+  vertex_count_ = vertices_.size() / 3;
+  index_count_ = indices_.size();
+  index_type_ = GL_UNSIGNED_SHORT;
+  is_vertex_data_dirty_ = false;
+  vertex_array_.Reset();
+}
+
 void Mesh::Render(const glm::mat4& projection_mat,
                   const glm::mat4& view_mat) const {
-  glUseProgram(shader_program_);
-  glm::mat4 model_mat = GetTransformationMatrix();
-  glm::mat4 mv_mat = view_mat * model_mat;
-  glm::mat4 mvp_mat = projection_mat * mv_mat;
-  glUniformMatrix4fv(uniform_mvp_mat_, 1, GL_FALSE, glm::value_ptr(mvp_mat));
-  glUniform4f(uniform_color_, red_, green_, blue_, alpha_);
+  if (is_vertex_data_dirty_) {
+    UploadVertexData();
+  }
 
-  if (is_lighting_on_) {
+  RenderState::UseProgram(shader_program_);
+  const glm::mat4 model_mat = GetTransformationMatrix();
+  if (is_lighting_on_ && !uses_frame_constants_) {
+    glm::mat4 mv_mat = simd_math::Multiply(view_mat, model_mat);
+    glm::mat4 mvp_mat = simd_math::Multiply(projection_mat, mv_mat);
+    glUniformMatrix4fv(uniform_mvp_mat_, 1, GL_FALSE, glm::value_ptr(mvp_mat));
     glUniformMatrix4fv(uniform_mv_mat_, 1, GL_FALSE, glm::value_ptr(mv_mat));
+  } else {
+    SetTransformUniforms(projection_mat, view_mat, model_mat);
+  }
+  glUniform4f(uniform_color_, red_, green_, blue_, alpha_);
 
-    glEnableVertexAttribArray(attrib_normals_);
-    glVertexAttribPointer(attrib_normals_, 3, GL_FLOAT, GL_FALSE,
-                          3 * sizeof(GLfloat), &normals_[0]);
+  if (is_lighting_on_) {
     glm::vec3 light_direction = glm::mat3(view_mat) * light_direction_;
     glUniform3fv(uniform_light_vec_, 1, glm::value_ptr(light_direction));
+    glUniform4fv(uniform_ambient_, 1, glm::value_ptr(g_ambient_light));
   }
 
-  glEnableVertexAttribArray(attrib_vertices_);
-
-  if (!indices_.empty()) {
-    glVertexAttribPointer(attrib_vertices_, 3, GL_FLOAT, GL_FALSE,
-                          3 * sizeof(GLfloat), vertices_.data());
-    glDrawElements(render_mode_, indices_.size(), GL_UNSIGNED_SHORT,
-                   indices_.data());
-  } else {
-    glVertexAttribPointer(attrib_vertices_, 3, GL_FLOAT, GL_FALSE,
-                          3 * sizeof(GLfloat), &vertices_[0]);
-    glDrawArrays(render_mode_, 0, vertices_.size() / 3);
+  if (!vertex_array_.Bind()) {
+    GLsizei stride;
+    const GLvoid* normal_offset;
+    if (geometry_) {
+      geometry_->Bind();
+      stride = geometry_->GetStride();
+      normal_offset = geometry_->GetNormalOffset();
+    } else {
+      vertex_buffer_.Bind();
+      if (index_count_ > 0) {
+        index_buffer_.Bind();
+      }
+      stride = (has_interleaved_normals_ ? 6 : 3) * sizeof(GLfloat);
+      normal_offset = reinterpret_cast<const GLvoid*>(3 * sizeof(GLfloat));
+    }
+    if (is_lighting_on_ && has_interleaved_normals_) {
+      vertex_array_.EnableAttribute(attrib_normals_);
+      glVertexAttribPointer(attrib_normals_, 3, GL_FLOAT, GL_FALSE, stride,
+                            normal_offset);
+    }
+    vertex_array_.EnableAttribute(attrib_vertices_);
+    glVertexAttribPointer(attrib_vertices_, 3, GL_FLOAT, GL_FALSE, stride,
+                          nullptr);
   }
 
-  glDisableVertexAttribArray(attrib_vertices_);
-  if (is_lighting_on_) {
-    glDisableVertexAttribArray(attrib_normals_);
+  Counters::Increment(Counters::kDrawCalls);
+  if (index_count_ > 0) {
+    glDrawElements(render_mode_, index_count_, index_type_, nullptr);
+  } else {
+    glDrawArrays(render_mode_, 0, vertex_count_);
   }
-  glUseProgram(0);
+  vertex_array_.Unbind();
 }
 }  // namespace tango_gl
@@ -0,0 +1,588 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "tango-gl/mesh_exporter.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+
+#include "tango-gl/memory_tracker.h"
+
+namespace {
+const size_t kPageSize = 4096;
+
+// Bytes reserved for the header at the start of the file, so the vertices
+// start on a page boundary.
+const size_t kHeaderSize = kPageSize;
+
+// How long the I/O thread sleeps when no block is queued, and the producer
+// when waiting for a free block.
+const std::chrono::milliseconds kIdleInterval(2);
+
+// Vertices and faces are converted by this many at a time before being
+// copied to the blocks.
+const uint32_t kBatchSize = 256;
+
+// Largest vertex count, the PLY indices are signed.
+const uint64_t kMaxVertexCount = std::numeric_limits<int32_t>::max();
+
+// glTF constants.
+const uint32_t kGlbMagic = 0x46546c67;  // "glTF"
+const uint32_t kGlbVersion = 2;
+const uint32_t kJsonChunk = 0x4e4f534a;  // "JSON"
+const uint32_t kBinChunk = 0x004e4942;   // "BIN\0"
+const size_t kGlbPrefixSize = 12 + 8;
+const size_t kJsonSize = kHeaderSize - kGlbPrefixSize - 8;
+
+void AppendUint32(uint32_t value, std::string* bytes) {
+  bytes->append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+}  // namespace
+
+namespace tango_gl {
+
+MeshExporter::MeshExporter()
+    : format_(kPly),
+      vertex_size_(0),
+      face_size_(0),
+      storage_(nullptr),
+      free_block_count_(0),
+      file_(-1),
+      spill_file_(-1),
+      is_finishing_(false),
+      is_cancelled_(false),
+      is_done_(false),
+      has_failed_(false),
+      vertex_count_(0),
+      face_count_(0),
+      written_bytes_(0),
+      total_bytes_(0) {}
+
+MeshExporter::~MeshExporter() { Cancel(); }
+
+bool MeshExporter::Start(const char* path, Format format,
+                         const Options& options) {
+  if (IsRunning()) {
+    LOGE("MeshExporter: an export is already running.");
+    return false;
+  }
+  file_ = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (file_ < 0) {
+    LOGE("MeshExporter: could not create %s: %s", path, strerror(errno));
+    return false;
+  }
+  // The faces wait in an unlinked file, nothing is left behind on a crash.
+  const std::string spill_path = std::string(path) + ".faces";
+  spill_file_ = open(spill_path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+  if (spill_file_ < 0) {
+    LOGE("MeshExporter: could not create %s: %s", spill_path.c_str(),
+         strerror(errno));
+    close(file_);
+    file_ = -1;
+    unlink(path);
+    return false;
+  }
+  unlink(spill_path.c_str());
+
+  options_ = options;
+  options_.block_size =
+      (std::max(options.block_size, kPageSize) + kPageSize - 1) /
+      kPageSize * kPageSize;
+  options_.block_count = std::max(options.block_count, 2);
+  format_ = format;
+  path_ = path;
+  vertex_size_ = (options_.has_normals ? 6 : 3) * sizeof(float);
+  // PLY faces have a uchar count before the indices.
+  face_size_ = (format == kPly ? 1 : 0) + 3 * sizeof(uint32_t);
+
+  const size_t storage_size = options_.block_size * options_.block_count;
+  void* storage = nullptr;
+  if (posix_memalign(&storage, kPageSize, storage_size) != 0) {
+    LOGE("MeshExporter: could not allocate %zu bytes.", storage_size);
+    close(file_);
+    close(spill_file_);
+    file_ = spill_file_ = -1;
+    unlink(path);
+    return false;
+  }
+  storage_ = static_cast<uint8_t*>(storage);
+  MemoryTracker::Track(MemoryTracker::kHost,
+                       reinterpret_cast<uintptr_t>(storage_), "MeshExporter",
+                       storage_size);
+  blocks_.reset(new Block[options_.block_count]);
+  free_blocks_.reset(new BoundedQueue<int>(options_.block_count));
+  ready_blocks_.reset(new BoundedQueue<int>(options_.block_count));
+  for (int i = 0; i < options_.block_count; ++i) {
+    blocks_[i].data = storage_ + i * options_.block_size;
+    blocks_[i].size = 0;
+    blocks_[i].stream = kVertexStream;
+    free_blocks_->Push(i);
+  }
+  free_block_count_.store(options_.block_count, std::memory_order_relaxed);
+
+  for (int stream = 0; stream < kStreamCount; ++stream) {
+    current_blocks_[stream] = -1;
+  }
+  for (int i = 0; i < 3; ++i) {
+    bounds_min_[i] = std::numeric_limits<float>::max();
+    bounds_max_[i] = -std::numeric_limits<float>::max();
+  }
+  offsets_[kVertexStream] = kHeaderSize;
+  offsets_[kFaceStream] = 0;
+
+  is_finishing_.store(false, std::memory_order_relaxed);
+  is_cancelled_.store(false, std::memory_order_relaxed);
+  is_done_.store(false, std::memory_order_relaxed);
+  has_failed_.store(false, std::memory_order_relaxed);
+  vertex_count_.store(0, std::memory_order_relaxed);
+  face_count_.store(0, std::memory_order_relaxed);
+  written_bytes_.store(0, std::memory_order_relaxed);
+  total_bytes_.store(kHeaderSize, std::memory_order_relaxed);
+  thread_ = std::thread(&MeshExporter::WriteLoop, this);
+  return true;
+}
+
+bool MeshExporter::AddSegment(const float* vertices, const float* normals,
+                              uint32_t vertex_count, const uint32_t* indices,
+                              uint32_t index_count, bool wait) {
+  return AddIndexedSegment(vertices, normals, vertex_count, indices,
+                           index_count, wait);
+}
+
+bool MeshExporter::AddSegment(const float* vertices, const float* normals,
+                              uint32_t vertex_count, const GLushort* indices,
+                              uint32_t index_count, bool wait) {
+  return AddIndexedSegment(vertices, normals, vertex_count, indices,
+                           index_count, wait);
+}
+
+bool MeshExporter::AddSegment(const TangoMesh_Experimental& mesh,
+                              bool wait) {
+  const float* normals = nullptr;
+  if (options_.has_normals) {
+    if (!mesh.has_normals) {
+      LOGE("MeshExporter: the segment has no normals.");
+      return false;
+    }
+    normals = reinterpret_cast<const float*>(mesh.normals);
+  }
+  return AddIndexedSegment(reinterpret_cast<const float*>(mesh.vertices),
+                           normals, mesh.num_vertices,
+                           reinterpret_cast<const uint32_t*>(mesh.faces),
+                           mesh.num_faces * 3, wait);
+}
+
+template <typename Index>
+bool MeshExporter::AddIndexedSegment(const float* vertices,
+                                     const float* normals,
+                                     uint32_t vertex_count,
+                                     const Index* indices,
+                                     uint32_t index_count, bool wait) {
+  if (!IsRunning() || is_finishing_.load(std::memory_order_relaxed) ||
+      has_failed_.load(std::memory_order_relaxed)) {
+    return false;
+  }
+  if (index_count % 3 != 0 || (options_.has_normals && normals == nullptr &&
+                               vertex_count > 0)) {
+    LOGE("MeshExporter: invalid segment.");
+    return false;
+  }
+  for (uint32_t i = 0; i < index_count; ++i) {
+    if (indices[i] >= vertex_count) {
+      LOGE("MeshExporter: index %u out of %u vertices.",
+           static_cast<uint32_t>(indices[i]), vertex_count);
+      return false;
+    }
+  }
+  const uint64_t base = vertex_count_.load(std::memory_order_relaxed);
+  if (base + vertex_count > kMaxVertexCount) {
+    LOGE("MeshExporter: too many vertices.");
+    return false;
+  }
+  const size_t vertex_bytes = vertex_count * vertex_size_;
+  const size_t face_bytes = index_count / 3 * face_size_;
+  if (!wait && !HasSpace(vertex_bytes, face_bytes)) {
+    return false;
+  }
+
+  float vertex_batch[kBatchSize * 6];
+  for (uint32_t first = 0; first < vertex_count; first += kBatchSize) {
+    const uint32_t count = std::min(kBatchSize, vertex_count - first);
+    float* out = vertex_batch;
+    for (uint32_t i = first; i < first + count; ++i) {
+      for (int j = 0; j < 3; ++j) {
+        const float value = vertices[i * 3 + j];
+        bounds_min_[j] = std::min(bounds_min_[j], value);
+        bounds_max_[j] = std::max(bounds_max_[j], value);
+        *out++ = value;
+      }
+      if (options_.has_normals) {
+        out = std::copy(normals + i * 3, normals + i * 3 + 3, out);
+      }
+    }
+    if (!Append(kVertexStream, vertex_batch, count * vertex_size_, wait)) {
+      return false;
+    }
+  }
+
+  uint8_t face_batch[kBatchSize * (1 + 3 * sizeof(uint32_t))];
+  const uint32_t face_count = index_count / 3;
+  for (uint32_t first = 0; first < face_count; first += kBatchSize) {
+    const uint32_t count = std::min(kBatchSize, face_count - first);
+    uint8_t* out = face_batch;
+    for (uint32_t i = first; i < first + count; ++i) {
+      if (format_ == kPly) {
+        *out++ = 3;
+      }
+      for (int j = 0; j < 3; ++j) {
+        const uint32_t index = static_cast<uint32_t>(base + indices[i * 3 + j]);
+        memcpy(out, &index, sizeof(index));
+        out += sizeof(index);
+      }
+    }
+    if (!Append(kFaceStream, face_batch, count * face_size_, wait)) {
+      return false;
+    }
+  }
+
+  vertex_count_.store(base + vertex_count, std::memory_order_relaxed);
+  face_count_.fetch_add(face_count, std::memory_order_relaxed);
+  total_bytes_.fetch_add(vertex_bytes + 2 * face_bytes,
+                         std::memory_order_relaxed);
+  return true;
+}
+
+void MeshExporter::Finish() {
+  if (!IsRunning() || is_finishing_.load(std::memory_order_relaxed)) {
+    return;
+  }
+  for (int stream = 0; stream < kStreamCount; ++stream) {
+    QueueBlock(static_cast<Stream>(stream));
+    // An empty current block goes back to the I/O thread for the append.
+    if (current_blocks_[stream] >= 0) {
+      free_blocks_->Push(current_blocks_[stream]);
+      free_block_count_.fetch_add(1, std::memory_order_release);
+      current_blocks_[stream] = -1;
+    }
+  }
+  is_finishing_.store(true, std::memory_order_release);
+}
+
+bool MeshExporter::Wait() {
+  if (!IsRunning()) {
+    return false;
+  }
+  Finish();
+  Join();
+  const bool is_complete = !has_failed_.load(std::memory_order_relaxed);
+  if (!is_complete) {
+    LOGE("MeshExporter: %s is incomplete.", path_.c_str());
+  }
+  return is_complete;
+}
+
+void MeshExporter::Cancel() {
+  if (!IsRunning()) {
+    return;
+  }
+  is_cancelled_.store(true, std::memory_order_release);
+  Join();
+  unlink(path_.c_str());
+}
+
+MeshExporter::Progress MeshExporter::GetProgress() const {
+  Progress progress;
+  progress.vertex_count = vertex_count_.load(std::memory_order_relaxed);
+  progress.face_count = face_count_.load(std::memory_order_relaxed);
+  progress.written_bytes = written_bytes_.load(std::memory_order_relaxed);
+  progress.total_bytes = total_bytes_.load(std::memory_order_relaxed);
+  progress.is_done = is_done_.load(std::memory_order_acquire);
+  progress.has_failed = has_failed_.load(std::memory_order_relaxed);
+  return progress;
+}
+
+bool MeshExporter::HasSpace(size_t vertex_bytes, size_t face_bytes) const {
+  const size_t bytes[kStreamCount] = {vertex_bytes, face_bytes};
+  size_t needed_block_count = 0;
+  for (int stream = 0; stream < kStreamCount; ++stream) {
+    const int current = current_blocks_[stream];
+    const size_t remaining =
+        current >= 0 ? options_.block_size - blocks_[current].size : 0;
+    if (bytes[stream] > remaining) {
+      needed_block_count += (bytes[stream] - remaining + options_.block_size -
+                             1) / options_.block_size;
+    }
+  }
+  // Only the I/O thread adds free blocks, there are at least this many.
+  return needed_block_count <= static_cast<size_t>(free_block_count_.load(
+                                   std::memory_order_acquire));
+}
+
+bool MeshExporter::Append(Stream stream, const void* data, size_t size,
+                          bool wait) {
+  const uint8_t* bytes = static_cast<const uint8_t*>(data);
+  while (size > 0) {
+    int& current = current_blocks_[stream];
+    if (current < 0) {
+      while (!free_blocks_->Pop(&current)) {
+        if (!wait || is_cancelled_.load(std::memory_order_relaxed) ||
+            has_failed_.load(std::memory_order_relaxed)) {
+          current = -1;
+          return false;
+        }
+        std::this_thread::sleep_for(kIdleInterval);
+      }
+      free_block_count_.fetch_sub(1, std::memory_order_relaxed);
+      blocks_[current].size = 0;
+      blocks_[current].stream = stream;
+    }
+    Block& block = blocks_[current];
+    const size_t copy_size = std::min(size, options_.block_size - block.size);
+    memcpy(block.data + block.size, bytes, copy_size);
+    block.size += copy_size;
+    bytes += copy_size;
+    size -= copy_size;
+    if (block.size == options_.block_size) {
+      QueueBlock(stream);
+    }
+  }
+  return true;
+}
+
+void MeshExporter::QueueBlock(Stream stream) {
+  int& current = current_blocks_[stream];
+  if (current < 0 || blocks_[current].size == 0) {
+    return;
+  }
+  // Holds every block, never full.
+  ready_blocks_->Push(current);
+  current = -1;
+}
+
+void MeshExporter::Join() {
+  thread_.join();
+  close(file_);
+  close(spill_file_);
+  file_ = spill_file_ = -1;
+  MemoryTracker::Untrack(MemoryTracker::kHost,
+                         reinterpret_cast<uintptr_t>(storage_));
+  free(storage_);
+  storage_ = nullptr;
+  blocks_.reset();
+  free_blocks_.reset();
+  ready_blocks_.reset();
+}
+
+void MeshExporter::WriteLoop() {
+  while (!is_cancelled_.load(std::memory_order_acquire)) {
+    int block_index;
+    if (ready_blocks_->Pop(&block_index)) {
+      WriteBlock(block_index);
+      continue;
+    }
+    // Finish() sets is_finishing_ after queueing the last blocks, the queue
+    // is empty for good if it is still empty after that.
+    if (is_finishing_.load(std::memory_order_acquire)) {
+      if (ready_blocks_->Pop(&block_index)) {
+        WriteBlock(block_index);
+        continue;
+      }
+      CompleteFile();
+      is_done_.store(true, std::memory_order_release);
+      return;
+    }
+    std::this_thread::sleep_for(kIdleInterval);
+  }
+}
+
+void MeshExporter::WriteBlock(int block_index) {
+  Block& block = blocks_[block_index];
+  // After a failure the blocks are only recycled, so the producer does not
+  // wait for them forever.
+  if (!has_failed_.load(std::memory_order_relaxed)) {
+    WriteBytes(block.stream == kVertexStream ? file_ : spill_file_,
+               block.data, block.size, offsets_[block.stream]);
+  }
+  offsets_[block.stream] += block.size;
+  written_bytes_.fetch_add(block.size, std::memory_order_relaxed);
+  free_blocks_->Push(block_index);
+  free_block_count_.fetch_add(1, std::memory_order_release);
+}
+
+void MeshExporter::CompleteFile() {
+  if (format_ == kGlb && vertex_count_.load(std::memory_order_relaxed) == 0) {
+    LOGE("MeshExporter: a glTF mesh can not be empty.");
+    has_failed_.store(true, std::memory_order_relaxed);
+  }
+  if (has_failed_.load(std::memory_order_relaxed)) {
+    return;
+  }
+  // Every block is free once the producer finished.
+  int block_index;
+  if (!free_blocks_->Pop(&block_index)) {
+    has_failed_.store(true, std::memory_order_relaxed);
+    return;
+  }
+  uint8_t* data = blocks_[block_index].data;
+  const uint64_t face_bytes = offsets_[kFaceStream];
+  const uint64_t face_offset = offsets_[kVertexStream];
+  for (uint64_t offset = 0; offset < face_bytes;) {
+    if (is_cancelled_.load(std::memory_order_relaxed)) {
+      return;
+    }
+    const size_t size = static_cast<size_t>(
+        std::min<uint64_t>(options_.block_size, face_bytes - offset));
+    const ssize_t read_size = pread(spill_file_, data, size, offset);
+    if (read_size <= 0) {
+      LOGE("MeshExporter: could not read the faces: %s", strerror(errno));
+      has_failed_.store(true, std::memory_order_relaxed);
+      return;
+    }
+    if (!WriteBytes(file_, data, read_size, face_offset + offset)) {
+      return;
+    }
+    offset += read_size;
+    written_bytes_.fetch_add(read_size, std::memory_order_relaxed);
+  }
+  free_blocks_->Push(block_index);
+
+  const std::string header =
+      format_ == kPly ? GetPlyHeader() : GetGlbHeader();
+  if (WriteBytes(file_, header.data(), header.size(), 0)) {
+    written_bytes_.fetch_add(header.size(), std::memory_order_relaxed);
+  }
+}
+
+std::string MeshExporter::GetPlyHeader() const {
+  char text[512];
+  snprintf(text, sizeof(text),
+           "ply\n"
+           "format binary_little_endian 1.0\n"
+           "comment tango_gl::MeshExporter\n"
+           "element vertex %llu\n"
+           "property float x\n"
+           "property float y\n"
+           "property float z\n"
+           "%s"
+           "element face %llu\n"
+           "property list uchar int vertex_indices\n",
+           static_cast<unsigned long long>(vertex_count_.load()),
+           options_.has_normals ? "property float nx\n"
+                                  "property float ny\n"
+                                  "property float nz\n"
+                                : "",
+           static_cast<unsigned long long>(face_count_.load()));
+  std::string header = text;
+  const std::string end = "end_header\n";
+  // Fill the reserved bytes with comment lines short enough for any reader.
+  const size_t kLineSize = 64;
+  size_t remaining = kHeaderSize - header.size() - end.size();
+  while (remaining > 0) {
+    const size_t line_size =
+        remaining >= 2 * kLineSize ? kLineSize : remaining;
+    header += "comment";
+    header.append(line_size - 8, ' ');
+    header += "\n";
+    remaining -= line_size;
+  }
+  return header + end;
+}
+
+std::string MeshExporter::GetGlbHeader() const {
+  const uint64_t vertex_count = vertex_count_.load();
+  const uint64_t vertex_bytes = vertex_count * vertex_size_;
+  const uint64_t index_count = face_count_.load() * 3;
+  const uint64_t index_bytes = index_count * sizeof(uint32_t);
+  char json[kJsonSize + 1];
+  char normal_attribute[16] = "";
+  char normal_accessor[128] = "";
+  if (options_.has_normals) {
+    snprintf(normal_attribute, sizeof(normal_attribute), ",\"NORMAL\":2");
+    snprintf(normal_accessor, sizeof(normal_accessor),
+             ",{\"bufferView\":0,\"byteOffset\":12,\"componentType\":5126,"
+             "\"count\":%llu,\"type\":\"VEC3\"}",
+             static_cast<unsigned long long>(vertex_count));
+  }
+  const int json_size = snprintf(
+      json, sizeof(json),
+      "{\"asset\":{\"version\":\"2.0\",\"generator\":\"tango_gl::"
+      "MeshExporter\"},\"scene\":0,\"scenes\":[{\"nodes\":[0]}],"
+      "\"nodes\":[{\"mesh\":0}],\"meshes\":[{\"primitives\":[{"
+      "\"attributes\":{\"POSITION\":1%s},\"indices\":0}]}],"
+      "\"buffers\":[{\"byteLength\":%llu}],"
+      "\"bufferViews\":[{\"buffer\":0,\"byteOffset\":0,\"byteLength\":%llu,"
+      "\"byteStride\":%zu,\"target\":34962},{\"buffer\":0,\"byteOffset\":%llu,"
+      "\"byteLength\":%llu,\"target\":34963}],"
+      "\"accessors\":[{\"bufferView\":1,\"componentType\":5125,\"count\":%llu,"
+      "\"type\":\"SCALAR\"},{\"bufferView\":0,\"byteOffset\":0,"
+      "\"componentType\":5126,\"count\":%llu,\"type\":\"VEC3\","
+      "\"min\":[%.9g,%.9g,%.9g],\"max\":[%.9g,%.9g,%.9g]}%s]}",
+      normal_attribute,
+      static_cast<unsigned long long>(vertex_bytes + index_bytes),
+      static_cast<unsigned long long>(vertex_bytes), vertex_size_,
+      static_cast<unsigned long long>(vertex_bytes),
+      static_cast<unsigned long long>(index_bytes),
+      static_cast<unsigned long long>(index_count),
+      static_cast<unsigned long long>(vertex_count), bounds_min_[0],
+      bounds_min_[1], bounds_min_[2], bounds_max_[0], bounds_max_[1],
+      bounds_max_[2], normal_accessor);
+
+  std::string header;
+  AppendUint32(kGlbMagic, &header);
+  AppendUint32(kGlbVersion, &header);
+  AppendUint32(static_cast<uint32_t>(kHeaderSize + vertex_bytes + index_bytes),
+               &header);
+  AppendUint32(kJsonSize, &header);
+  AppendUint32(kJsonChunk, &header);
+  // The chunk is padded with spaces, as the specification allows.
+  header.append(json, std::min<size_t>(json_size, kJsonSize));
+  header.append(kJsonSize - std::min<size_t>(json_size, kJsonSize), ' ');
+  AppendUint32(static_cast<uint32_t>(vertex_bytes + index_bytes), &header);
+  AppendUint32(kBinChunk, &header);
+  return header;
+}
+
+bool MeshExporter::WriteBytes(int file, const void* data, size_t size,
+                              uint64_t offset) {
+  const uint8_t* bytes = static_cast<const uint8_t*>(data);
+  while (size > 0) {
+    const ssize_t written = pwrite(file, bytes, size, offset);
+    if (written < 0 && errno == EINTR) {
+      continue;
+    }
+    if (written <= 0) {
+      LOGE("MeshExporter: could not write %s: %s", path_.c_str(),
+           strerror(errno));
+      has_failed_.store(true, std::memory_order_relaxed);
+      return false;
+    }
+    bytes += written;
+    size -= written;
+    offset += written;
+  }
+  return true;
+}
+
+}  // namespace tango_gl
@@ -0,0 +1,334 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <math.h>
+
+#include <algorithm>
+#include <functional>
+
+#include "tango-gl/mesh_preparation.h"
+
+namespace {
+// Tasks per pool thread for loops over ranges, so uneven ranges balance out.
+const int kTasksPerThread = 4;
+
+// Forsyth's scoring parameters: modelled cache size, exponent of the score
+// decay along the cache, score of the vertices of the last face, and weight
+// and exponent of the boost given to vertices with few faces left.
+const int kCacheSize = 32;
+const float kCacheDecayPower = 1.5f;
+const float kLastFaceScore = 0.75f;
+const float kValenceBoostScale = 2.0f;
+const float kValenceBoostPower = 0.5f;
+
+void RunTasks(tango_gl::WorkerPool* pool, int task_count,
+              const std::function<void(int)>& task) {
+  if (pool == nullptr) {
+    for (int i = 0; i < task_count; ++i) {
+      task(i);
+    }
+  } else {
+    pool->ParallelFor(task_count, task);
+  }
+}
+
+int GetRangeTaskCount(tango_gl::WorkerPool* pool, size_t item_count) {
+  const size_t task_count =
+      pool == nullptr ? 1 : pool->GetConcurrency() * kTasksPerThread;
+  return static_cast<int>(std::max<size_t>(
+      1, std::min(task_count, item_count)));
+}
+
+float VertexScore(int cache_position, uint32_t active_face_count) {
+  if (active_face_count == 0) {
+    // No face left, the vertex does not matter anymore.
+    return -1.0f;
+  }
+  float score = 0.0f;
+  if (cache_position >= 0) {
+    if (cache_position < 3) {
+      // Used by the last face, deliberately lower than the next entries so
+      // the strip does not double back on itself.
+      score = kLastFaceScore;
+    } else {
+      const float scale = 1.0f / (kCacheSize - 3);
+      score = powf(1.0f - (cache_position - 3) * scale, kCacheDecayPower);
+    }
+  }
+  return score +
+         kValenceBoostScale *
+             powf(static_cast<float>(active_face_count), -kValenceBoostPower);
+}
+}  // namespace
+
+namespace tango_gl {
+namespace mesh_preparation {
+
+void ComputeNormals(const float* vertices, size_t vertex_count,
+                    const uint32_t* indices, size_t index_count,
+                    WorkerPool* pool, float* normals) {
+  const size_t face_count = index_count / 3;
+
+  // Unnormalized face normals, their length is twice the face area.
+  std::vector<glm::vec3> face_normals(face_count);
+  int task_count = GetRangeTaskCount(pool, face_count);
+  RunTasks(pool, task_count, [&](int task) {
+    const size_t begin = face_count * task / task_count;
+    const size_t end = face_count * (task + 1) / task_count;
+    for (size_t i = begin; i < end; ++i) {
+      const float* a = vertices + indices[i * 3] * 3;
+      const float* b = vertices + indices[i * 3 + 1] * 3;
+      const float* c = vertices + indices[i * 3 + 2] * 3;
+      const glm::vec3 p0(a[0], a[1], a[2]);
+      face_normals[i] =
+          glm::cross(glm::vec3(b[0], b[1], b[2]) - p0,
+                     glm::vec3(c[0], c[1], c[2]) - p0);
+    }
+  });
+
+  // Faces around each vertex, so vertices can be summed independently.
+  std::vector<uint32_t> offsets(vertex_count + 1, 0);
+  for (size_t i = 0; i < face_count * 3; ++i) {
+    ++offsets[indices[i] + 1];
+  }
+  for (size_t i = 0; i < vertex_count; ++i) {
+    offsets[i + 1] += offsets[i];
+  }
+  std::vector<uint32_t> vertex_faces(face_count * 3);
+  std::vector<uint32_t> cursors(offsets.begin(), offsets.end() - 1);
+  for (size_t i = 0; i < face_count * 3; ++i) {
+    vertex_faces[cursors[indices[i]]++] = static_cast<uint32_t>(i / 3);
+  }
+
+  task_count = GetRangeTaskCount(pool, vertex_count);
+  RunTasks(pool, task_count, [&](int task) {
+    const size_t begin = vertex_count * task / task_count;
+    const size_t end = vertex_count * (task + 1) / task_count;
+    for (size_t i = begin; i < end; ++i) {
+      glm::vec3 normal(0.0f);
+      for (uint32_t j = offsets[i]; j < offsets[i + 1]; ++j) {
+        normal += face_normals[vertex_faces[j]];
+      }
+      const float length = glm::length(normal);
+      if (length > 0.0f) {
+        normal /= length;
+      }
+      normals[i * 3] = normal.x;
+      normals[i * 3 + 1] = normal.y;
+      normals[i * 3 + 2] = normal.z;
+    }
+  });
+}
+
+void OptimizeVertexCache(size_t vertex_count, std::vector<uint32_t>* indices) {
+  const size_t face_count = indices->size() / 3;
+  if (face_count < 2) {
+    return;
+  }
+  const uint32_t* face_indices = indices->data();
+
+  // Faces around each vertex. The first active_face_counts[v] entries of a
+  // vertex are the faces not emitted yet.
+  std::vector<uint32_t> offsets(vertex_count + 1, 0);
+  for (size_t i = 0; i < face_count * 3; ++i) {
+    ++offsets[face_indices[i] + 1];
+  }
+  for (size_t i = 0; i < vertex_count; ++i) {
+    offsets[i + 1] += offsets[i];
+  }
+  std::vector<uint32_t> active_face_counts(vertex_count, 0);
+  std::vector<uint32_t> vertex_faces(face_count * 3);
+  for (size_t i = 0; i < face_count * 3; ++i) {
+    const uint32_t vertex = face_indices[i];
+    vertex_faces[offsets[vertex] + active_face_counts[vertex]++] =
+        static_cast<uint32_t>(i / 3);
+  }
+
+  std::vector<int> cache_positions(vertex_count, -1);
+  std::vector<float> vertex_scores(vertex_count);
+  for (size_t i = 0; i < vertex_count; ++i) {
+    vertex_scores[i] = VertexScore(-1, active_face_counts[i]);
+  }
+  std::vector<float> face_scores(face_count);
+  std::vector<bool> is_emitted(face_count, false);
+  size_t best_face = 0;
+  for (size_t i = 0; i < face_count; ++i) {
+    face_scores[i] = vertex_scores[face_indices[i * 3]] +
+                     vertex_scores[face_indices[i * 3 + 1]] +
+                     vertex_scores[face_indices[i * 3 + 2]];
+    if (face_scores[i] > face_scores[best_face]) {
+      best_face = i;
+    }
+  }
+
+  std::vector<uint32_t> output;
+  output.reserve(face_count * 3);
+  // Modelled LRU cache, plus room for the vertices of the face being added.
+  std::vector<uint32_t> cache;
+  std::vector<uint32_t> next_cache;
+  cache.reserve(kCacheSize + 3);
+  next_cache.reserve(kCacheSize + 3);
+  // Faces before this one have been emitted, used when the cache runs dry.
+  size_t next_unemitted_face = 0;
+  const size_t kNoFace = face_count;
+
+  for (size_t emitted = 0; emitted < face_count; ++emitted) {
+    if (best_face == kNoFace) {
+      while (is_emitted[next_unemitted_face]) {
+        ++next_unemitted_face;
+      }
+      best_face = next_unemitted_face;
+    }
+
+    is_emitted[best_face] = true;
+    next_cache.clear();
+    for (int corner = 0; corner < 3; ++corner) {
+      const uint32_t vertex = face_indices[best_face * 3 + corner];
+      output.push_back(vertex);
+
+      // Drop the face from the active faces of the vertex.
+      uint32_t* faces = &vertex_faces[offsets[vertex]];
+      uint32_t& active_count = active_face_counts[vertex];
+      for (uint32_t i = 0; i < active_count; ++i) {
+        if (faces[i] == best_face) {
+          std::swap(faces[i], faces[active_count - 1]);
+          --active_count;
+          break;
+        }
+      }
+      if (std::find(next_cache.begin(), next_cache.end(), vertex) ==
+          next_cache.end()) {
+        next_cache.push_back(vertex);
+      }
+    }
+    const size_t face_vertex_count = next_cache.size();
+    for (uint32_t vertex : cache) {
+      const auto face_vertices_end = next_cache.begin() + face_vertex_count;
+      if (std::find(next_cache.begin(), face_vertices_end, vertex) ==
+          face_vertices_end) {
+        next_cache.push_back(vertex);
+      }
+    }
+
+    // Rescore the vertices that moved in or out of the cache.
+    for (size_t i = 0; i < next_cache.size(); ++i) {
+      const uint32_t vertex = next_cache[i];
+      const int position = i < kCacheSize ? static_cast<int>(i) : -1;
+      cache_positions[vertex] = position;
+      vertex_scores[vertex] = VertexScore(position, active_face_counts[vertex]);
+    }
+
+    // Pick the next face among the active faces of the cached vertices.
+    best_face = kNoFace;
+    float best_score = -1.0f;
+    for (uint32_t vertex : next_cache) {
+      const uint32_t* faces = &vertex_faces[offsets[vertex]];
+      for (uint32_t i = 0; i < active_face_counts[vertex]; ++i) {
+        const uint32_t face = faces[i];
+        const float score = vertex_scores[face_indices[face * 3]] +
+                            vertex_scores[face_indices[face * 3 + 1]] +
+                            vertex_scores[face_indices[face * 3 + 2]];
+        face_scores[face] = score;
+        if (score > best_score) {
+          best_score = score;
+          best_face = face;
+        }
+      }
+    }
+
+    if (next_cache.size() > kCacheSize) {
+      next_cache.resize(kCacheSize);
+    }
+    cache.swap(next_cache);
+  }
+  indices->swap(output);
+}
+
+void PrepareMesh(const float* vertices, const float* normals,
+                 size_t vertex_count, const uint32_t* indices,
+                 size_t index_count, WorkerPool* pool,
+                 std::vector<MeshChunk>* chunks) {
+  std::vector<float> computed_normals;
+  if (normals == nullptr) {
+    computed_normals.resize(vertex_count * 3);
+    ComputeNormals(vertices, vertex_count, indices, index_count, pool,
+                   computed_normals.data());
+    normals = computed_normals.data();
+  }
+
+  // Assign faces to chunks in order. Each chunk records its source vertices
+  // and its faces in chunk local indices.
+  struct ChunkFaces {
+    std::vector<uint32_t> source_vertices;
+    std::vector<uint32_t> indices;
+  };
+  std::vector<ChunkFaces> chunk_faces(1);
+  // Local index of each source vertex in the current chunk, or -1.
+  std::vector<int32_t> local_indices(vertex_count, -1);
+  const size_t face_count = index_count / 3;
+  for (size_t i = 0; i < face_count; ++i) {
+    const uint32_t* face = indices + i * 3;
+    size_t new_vertex_count = 0;
+    for (int corner = 0; corner < 3; ++corner) {
+      if (local_indices[face[corner]] < 0) {
+        ++new_vertex_count;
+      }
+    }
+    if (chunk_faces.back().source_vertices.size() + new_vertex_count >
+        kMaxChunkVertexCount) {
+      for (uint32_t vertex : chunk_faces.back().source_vertices) {
+        local_indices[vertex] = -1;
+      }
+      chunk_faces.emplace_back();
+    }
+
+    ChunkFaces& chunk = chunk_faces.back();
+    for (int corner = 0; corner < 3; ++corner) {
+      int32_t& local_index = local_indices[face[corner]];
+      if (local_index < 0) {
+        local_index = static_cast<int32_t>(chunk.source_vertices.size());
+        chunk.source_vertices.push_back(face[corner]);
+      }
+      chunk.indices.push_back(static_cast<uint32_t>(local_index));
+    }
+  }
+  if (chunk_faces.back().indices.empty()) {
+    chunk_faces.pop_back();
+  }
+
+  chunks->resize(chunk_faces.size());
+  RunTasks(pool, static_cast<int>(chunk_faces.size()), [&](int task) {
+    ChunkFaces& faces = chunk_faces[task];
+    MeshChunk& chunk = (*chunks)[task];
+    const size_t chunk_vertex_count = faces.source_vertices.size();
+    OptimizeVertexCache(chunk_vertex_count, &faces.indices);
+
+    chunk.vertices.resize(chunk_vertex_count * 3);
+    chunk.normals.resize(chunk_vertex_count * 3);
+    for (size_t i = 0; i < chunk_vertex_count; ++i) {
+      const uint32_t source = faces.source_vertices[i];
+      std::copy(vertices + source * 3, vertices + source * 3 + 3,
+                chunk.vertices.begin() + i * 3);
+      std::copy(normals + source * 3, normals + source * 3 + 3,
+                chunk.normals.begin() + i * 3);
+    }
+    chunk.indices.assign(faces.indices.begin(), faces.indices.end());
+  });
+}
+
+}  // namespace mesh_preparation
+}  // namespace tango_gl
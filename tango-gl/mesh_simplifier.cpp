@@ -0,0 +1,250 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+
+#include <tango_support_api.h>
+
+#include "tango-gl/mesh_simplifier.h"
+
+namespace {
+// Interval at which the face budgets follow the view.
+const std::chrono::milliseconds kViewInterval(250);
+
+void FreeMesh(TangoMesh_Experimental* mesh) {
+  TangoSupport_freeMesh(mesh);
+  delete mesh;
+}
+}  // namespace
+
+namespace tango_gl {
+
+MeshSimplifier::MeshSimplifier(SegmentedMesh* output)
+    : output_(output),
+      has_dirty_segments_(false),
+      projection_view_mat_(1.0f),
+      is_view_set_(false),
+      is_stopping_(false) {}
+
+MeshSimplifier::~MeshSimplifier() { Stop(); }
+
+void MeshSimplifier::Start() {
+  if (thread_.joinable()) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    is_stopping_ = false;
+  }
+  thread_ = std::thread(&MeshSimplifier::SimplificationLoop, this);
+}
+
+void MeshSimplifier::Stop() {
+  if (!thread_.joinable()) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    is_stopping_ = true;
+  }
+  work_available_.notify_one();
+  thread_.join();
+}
+
+void MeshSimplifier::Clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  segments_.clear();
+  removals_.clear();
+  has_dirty_segments_ = false;
+}
+
+void MeshSimplifier::Submit(int segment_count,
+                            const TangoMesh_Experimental* segments) {
+  // Copy outside of the lock, the thread only waits for the insertion.
+  std::vector<Segment> copies(std::max(segment_count, 0));
+  for (int i = 0; i < segment_count; ++i) {
+    const TangoMesh_Experimental& segment = segments[i];
+    Segment* copy = &copies[i];
+    std::copy(segment.index, segment.index + 3, copy->index);
+    copy->output_face_count = 0;
+    copy->is_dirty = true;
+    if (segment.num_faces == 0 || segment.num_vertices == 0) {
+      continue;
+    }
+
+    TangoMesh_Experimental* full_mesh = new TangoMesh_Experimental();
+    TangoSupport_initializeEmptyMesh(full_mesh);
+    if (TangoSupport_copyMesh(&segment, full_mesh) != TANGO_SUCCESS) {
+      LOGE("MeshSimplifier: could not copy a segment.");
+      FreeMesh(full_mesh);
+      continue;
+    }
+    copy->full_mesh = SharedMesh(full_mesh, FreeMesh);
+
+    copy->min = glm::vec3(std::numeric_limits<float>::max());
+    copy->max = glm::vec3(-std::numeric_limits<float>::max());
+    for (uint32_t j = 0; j < segment.num_vertices; ++j) {
+      const glm::vec3 p(segment.vertices[j][0], segment.vertices[j][1],
+                        segment.vertices[j][2]);
+      copy->min = glm::min(copy->min, p);
+      copy->max = glm::max(copy->max, p);
+    }
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (Segment& copy : copies) {
+      const uint64_t key = SegmentedMesh::SegmentKey(copy.index);
+      if (copy.full_mesh) {
+        segments_[key] = std::move(copy);
+        has_dirty_segments_ = true;
+      } else if (segments_.erase(key) > 0) {
+        Job removal;
+        std::copy(copy.index, copy.index + 3, removal.index);
+        removal.face_count = 0;
+        removals_.push_back(std::move(removal));
+      }
+    }
+  }
+  work_available_.notify_one();
+}
+
+void MeshSimplifier::SetView(const glm::mat4& projection_view_mat) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  projection_view_mat_ = projection_view_mat;
+  is_view_set_ = true;
+}
+
+void MeshSimplifier::ForEachFullResolutionSegment(
+    const std::function<void(const TangoMesh_Experimental&)>& visitor) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (const auto& segment : segments_) {
+    visitor(*segment.second.full_mesh);
+  }
+}
+
+void MeshSimplifier::SimplificationLoop() {
+  std::vector<Job> jobs;
+  while (true) {
+    jobs.clear();
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      // Wake up for new segments, and periodically to follow the view.
+      work_available_.wait_for(lock, kViewInterval, [this] {
+        return has_dirty_segments_ || !removals_.empty() || is_stopping_;
+      });
+      if (is_stopping_) {
+        return;
+      }
+      jobs.swap(removals_);
+      has_dirty_segments_ = false;
+
+      for (auto& entry : segments_) {
+        Segment& segment = entry.second;
+        const uint32_t face_count =
+            is_view_set_ ? GetFaceBudget(segment, projection_view_mat_)
+                         : segment.full_mesh->num_faces;
+        const float ratio = options_.resimplify_ratio;
+        const bool is_budget_changed =
+            face_count > segment.output_face_count * ratio ||
+            face_count * ratio < segment.output_face_count;
+        if (!segment.is_dirty && !is_budget_changed) {
+          continue;
+        }
+        segment.is_dirty = false;
+        segment.output_face_count = face_count;
+
+        Job job;
+        std::copy(segment.index, segment.index + 3, job.index);
+        job.full_mesh = segment.full_mesh;
+        job.face_count = face_count;
+        jobs.push_back(std::move(job));
+      }
+    }
+    if (!jobs.empty()) {
+      RunJobs(jobs);
+    }
+  }
+}
+
+uint32_t MeshSimplifier::GetFaceBudget(
+    const Segment& segment, const glm::mat4& projection_view_mat) const {
+  const uint32_t full_face_count = segment.full_mesh->num_faces;
+
+  // Screen rectangle of the bounds, in normalized device coordinates.
+  glm::vec2 screen_min(std::numeric_limits<float>::max());
+  glm::vec2 screen_max(-std::numeric_limits<float>::max());
+  for (int corner = 0; corner < 8; ++corner) {
+    const glm::vec4 p((corner & 1) ? segment.max.x : segment.min.x,
+                      (corner & 2) ? segment.max.y : segment.min.y,
+                      (corner & 4) ? segment.max.z : segment.min.z, 1.0f);
+    const glm::vec4 clip = projection_view_mat * p;
+    if (clip.w <= std::numeric_limits<float>::epsilon()) {
+      // The camera is inside or next to the bounds.
+      return full_face_count;
+    }
+    const glm::vec2 ndc = glm::vec2(clip) / clip.w;
+    screen_min = glm::min(screen_min, ndc);
+    screen_max = glm::max(screen_max, ndc);
+  }
+  screen_min = glm::max(screen_min, glm::vec2(-1.0f));
+  screen_max = glm::min(screen_max, glm::vec2(1.0f));
+  const glm::vec2 extent = glm::max(screen_max - screen_min, glm::vec2(0.0f));
+  // The screen is 2 units wide and high.
+  const float coverage = extent.x * extent.y * 0.25f;
+
+  const float budget =
+      options_.min_face_count + coverage * options_.full_screen_face_count;
+  return std::min(full_face_count, static_cast<uint32_t>(budget));
+}
+
+void MeshSimplifier::RunJobs(const std::vector<Job>& jobs) {
+  std::vector<TangoMesh_Experimental> meshes(jobs.size());
+  std::vector<bool> is_simplified(jobs.size(), false);
+  for (size_t i = 0; i < jobs.size(); ++i) {
+    const Job& job = jobs[i];
+    TangoMesh_Experimental* mesh = &meshes[i];
+    TangoSupport_initializeEmptyMesh(mesh);
+    if (job.full_mesh && job.face_count < job.full_mesh->num_faces) {
+      if (TangoSupport_createSimplifiedMesh(job.full_mesh.get(),
+                                            job.face_count,
+                                            mesh) == TANGO_SUCCESS) {
+        is_simplified[i] = true;
+      } else {
+        LOGE("MeshSimplifier: could not simplify a segment.");
+      }
+    }
+    if (!is_simplified[i] && job.full_mesh) {
+      // Shallow copy, released with the job.
+      *mesh = *job.full_mesh;
+    }
+    std::copy(job.index, job.index + 3, mesh->index);
+  }
+
+  output_->OnMeshVectorAvailable(static_cast<int>(meshes.size()),
+                                 meshes.data());
+
+  for (size_t i = 0; i < meshes.size(); ++i) {
+    if (is_simplified[i]) {
+      TangoSupport_freeMesh(&meshes[i]);
+    }
+  }
+}
+
+}  // namespace tango_gl
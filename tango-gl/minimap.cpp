@@ -0,0 +1,466 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "tango-gl/minimap.h"
+
+#include <math.h>
+
+#include <algorithm>
+
+#include "tango-gl/counters.h"
+#include "tango-gl/memory_tracker.h"
+#include "tango-gl/program_cache.h"
+#include "tango-gl/render_pass.h"
+#include "tango-gl/render_state.h"
+#include "tango-gl/shaders.h"
+
+namespace {
+// Full screen quad of the composite, drawn as a strip.
+const GLfloat kQuadVertices[] = {-1.0f, -1.0f, 1.0f, -1.0f,
+                                 -1.0f, 1.0f,  1.0f, 1.0f};
+
+// Length of the device marker from its center to its tip, in pixels.
+const float kMarkerPixels = 10.0f;
+}  // namespace
+
+namespace tango_gl {
+
+Minimap::Minimap(const Options& options)
+    : options_(options),
+      is_unsupported_(false),
+      framebuffer_(0),
+      texture_(0),
+      program_(0),
+      attrib_vertices_(-1),
+      uniform_transform_(-1),
+      uniform_color_(-1),
+      composite_program_(0),
+      composite_attrib_vertices_(-1),
+      uniform_composite_transform_(-1),
+      grid_buffer_(GL_ARRAY_BUFFER, GL_STATIC_DRAW),
+      grid_vertex_count_(0),
+      quad_buffer_(GL_ARRAY_BUFFER, GL_STATIC_DRAW),
+      stream_buffer_(GL_ARRAY_BUFFER, GL_STREAM_DRAW),
+      drawn_segment_count_(0),
+      is_window_valid_(false),
+      window_origin_(0),
+      redrawn_slot_count_(0),
+      background_color_(0.92f, 0.92f, 0.92f, 1.0f),
+      grid_color_(0.78f, 0.78f, 0.78f, 1.0f),
+      trace_color_(0.22f, 0.28f, 0.67f, 1.0f),
+      marker_color_(0.9f, 0.3f, 0.1f, 1.0f) {
+  options_.tile_pixels = std::max(1, options_.tile_pixels);
+  // The window must keep a tile around the device in every direction.
+  options_.tile_count = std::max(4, options_.tile_count);
+  if (options_.grid_pixels <= 0 ||
+      options_.tile_pixels % options_.grid_pixels != 0) {
+    options_.grid_pixels = options_.tile_pixels;
+  }
+  texture_size_ = options_.tile_pixels * options_.tile_count;
+  tile_meters_ = options_.tile_pixels * options_.meters_per_pixel;
+  options_.view_size =
+      std::min(options_.view_size, (options_.tile_count - 2) * tile_meters_);
+  slot_tiles_.resize(options_.tile_count * options_.tile_count);
+}
+
+Minimap::~Minimap() { Release(); }
+
+void Minimap::AddPosition(const glm::vec3& position) {
+  const glm::vec2 point(position.x, position.z);
+  if (!positions_.empty() &&
+      glm::distance(positions_.back(), point) < options_.meters_per_pixel) {
+    return;
+  }
+  positions_.push_back(point);
+  if (positions_.size() >= 2) {
+    IndexSegment(static_cast<uint32_t>(positions_.size() - 2));
+  }
+}
+
+void Minimap::Update(const glm::vec3& device_position) {
+  redrawn_slot_count_ = 0;
+  const glm::ivec2 origin =
+      GetTile(glm::vec2(device_position.x, device_position.z)) -
+      options_.tile_count / 2;
+  const uint32_t segment_count = static_cast<uint32_t>(GetSegmentCount());
+  if (is_window_valid_ && origin == window_origin_ &&
+      drawn_segment_count_ == segment_count) {
+    return;
+  }
+  if (!Allocate()) {
+    return;
+  }
+
+  // The whole texture is redrawn the first time, or after a jump past the
+  // window, with one clear for all slots.
+  const glm::ivec2 shift = glm::abs(origin - window_origin_);
+  const bool is_redrawn = !is_window_valid_ ||
+                          shift.x >= options_.tile_count ||
+                          shift.y >= options_.tile_count;
+  RenderPass::Options pass_options;
+  pass_options.color_load = is_redrawn ? RenderPass::kClear : RenderPass::kLoad;
+  pass_options.depth_load = RenderPass::kDontCare;
+  pass_options.clear_color = background_color_;
+  GLint viewport[4];
+  glGetIntegerv(GL_VIEWPORT, viewport);
+  RenderPass::Begin(framebuffer_, texture_size_, texture_size_, pass_options);
+  RenderState::Disable(GL_DEPTH_TEST);
+  RenderState::Disable(GL_CULL_FACE);
+  RenderState::Disable(GL_BLEND);
+  RenderState::Enable(GL_SCISSOR_TEST);
+  RenderState::UseProgram(program_);
+
+  // Slots whose ground tile left the window get the tile which took its
+  // place.
+  std::vector<uint8_t> is_slot_redrawn(slot_tiles_.size(), 0);
+  window_origin_ = origin;
+  for (int j = 0; j < options_.tile_count; ++j) {
+    for (int i = 0; i < options_.tile_count; ++i) {
+      const glm::ivec2 tile = origin + glm::ivec2(i, j);
+      const glm::ivec2 slot = GetSlot(tile);
+      const int slot_index = slot.y * options_.tile_count + slot.x;
+      if (!is_redrawn && slot_tiles_[slot_index] == tile) {
+        continue;
+      }
+      slot_tiles_[slot_index] = tile;
+      is_slot_redrawn[slot_index] = 1;
+      DrawTile(tile, !is_redrawn);
+      ++redrawn_slot_count_;
+    }
+  }
+  is_window_valid_ = true;
+
+  // New segments go into the drawn slots they overlap which were not just
+  // redrawn with them.
+  std::vector<glm::ivec2> new_tiles;
+  for (uint32_t segment = drawn_segment_count_; segment < segment_count;
+       ++segment) {
+    glm::ivec2 min_tile;
+    glm::ivec2 max_tile;
+    GetSegmentTiles(segment, &min_tile, &max_tile);
+    for (int j = min_tile.y; j <= max_tile.y; ++j) {
+      for (int i = min_tile.x; i <= max_tile.x; ++i) {
+        const glm::ivec2 tile(i, j);
+        if (IsTileInWindow(tile) &&
+            std::find(new_tiles.begin(), new_tiles.end(), tile) ==
+                new_tiles.end()) {
+          new_tiles.push_back(tile);
+        }
+      }
+    }
+  }
+  for (const glm::ivec2& tile : new_tiles) {
+    const glm::ivec2 slot = GetSlot(tile);
+    if (is_slot_redrawn[slot.y * options_.tile_count + slot.x] != 0) {
+      continue;
+    }
+    SetSlotScissor(slot);
+    DrawSegments(tile, drawn_segment_count_);
+  }
+  drawn_segment_count_ = segment_count;
+
+  RenderState::Disable(GL_SCISSOR_TEST);
+  RenderPass::End();
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+  util::CheckGlError("Minimap::Update");
+}
+
+void Minimap::Composite(GLint x, GLint y, GLsizei width, GLsizei height,
+                        const glm::vec3& device_position,
+                        const glm::quat& device_rotation) {
+  if (!is_window_valid_ || framebuffer_ == 0 || width <= 0 || height <= 0) {
+    return;
+  }
+  GLint viewport[4];
+  glGetIntegerv(GL_VIEWPORT, viewport);
+  glViewport(x, y, width, height);
+  RenderState::Disable(GL_DEPTH_TEST);
+  RenderState::Disable(GL_CULL_FACE);
+  RenderState::Disable(GL_BLEND);
+
+  // Texture coordinates around the device. The texture repeats, so only the
+  // fraction of the device coordinates matters, which keeps them precise
+  // far from the origin. Screen up is -z.
+  const float meters_per_uv = texture_size_ * options_.meters_per_pixel;
+  glm::vec2 center =
+      glm::vec2(device_position.x, device_position.z) / meters_per_uv;
+  center -= glm::floor(center);
+  const float half_view = 0.5f * options_.view_size / meters_per_uv;
+  const float aspect = static_cast<float>(width) / height;
+  const glm::vec2 half_extent =
+      aspect >= 1.0f ? glm::vec2(half_view, half_view / aspect)
+                     : glm::vec2(half_view * aspect, half_view);
+  RenderState::UseProgram(composite_program_);
+  glUniform4f(uniform_composite_transform_, half_extent.x, -half_extent.y,
+              center.x, center.y);
+  RenderState::ActiveTexture(GL_TEXTURE0);
+  RenderState::BindTexture(GL_TEXTURE_2D, texture_);
+  quad_buffer_.Bind();
+  glEnableVertexAttribArray(composite_attrib_vertices_);
+  glVertexAttribPointer(composite_attrib_vertices_, 2, GL_FLOAT, GL_FALSE, 0,
+                        nullptr);
+  Counters::Increment(Counters::kDrawCalls);
+  glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+  glDisableVertexAttribArray(composite_attrib_vertices_);
+
+  // The device at the center, pointing along its -z axis on the map.
+  const glm::vec3 forward = device_rotation * glm::vec3(0.0f, 0.0f, -1.0f);
+  glm::vec2 direction(forward.x, -forward.z);
+  const float length = glm::length(direction);
+  direction = length > 0.0f ? direction / length : glm::vec2(0.0f, 1.0f);
+  const glm::vec2 side(-direction.y, direction.x);
+  const glm::vec2 tip = direction * kMarkerPixels;
+  const glm::vec2 left = (side - direction) * (0.6f * kMarkerPixels);
+  const glm::vec2 right = (-side - direction) * (0.6f * kMarkerPixels);
+  const GLfloat marker[] = {tip.x, tip.y, left.x, left.y, right.x, right.y};
+  RenderState::UseProgram(program_);
+  glUniform4f(uniform_transform_, 2.0f / width, 2.0f / height, 0.0f, 0.0f);
+  glUniform4fv(uniform_color_, 1, glm::value_ptr(marker_color_));
+  DrawStream(marker, sizeof(marker) / sizeof(marker[0]), GL_TRIANGLES);
+
+  RenderState::BindBuffer(GL_ARRAY_BUFFER, 0);
+  glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+  util::CheckGlError("Minimap::Composite");
+}
+
+void Minimap::Clear() {
+  positions_.clear();
+  tile_segments_.clear();
+  drawn_segment_count_ = 0;
+  is_window_valid_ = false;
+}
+
+glm::ivec2 Minimap::GetTile(const glm::vec2& position) const {
+  return glm::ivec2(static_cast<int>(floorf(position.x / tile_meters_)),
+                    static_cast<int>(floorf(position.y / tile_meters_)));
+}
+
+glm::ivec2 Minimap::GetSlot(const glm::ivec2& tile) const {
+  const int count = options_.tile_count;
+  return glm::ivec2(((tile.x % count) + count) % count,
+                    ((tile.y % count) + count) % count);
+}
+
+bool Minimap::IsTileInWindow(const glm::ivec2& tile) const {
+  const glm::ivec2 offset = tile - window_origin_;
+  return offset.x >= 0 && offset.x < options_.tile_count && offset.y >= 0 &&
+         offset.y < options_.tile_count;
+}
+
+void Minimap::GetSegmentTiles(uint32_t segment, glm::ivec2* min_tile,
+                              glm::ivec2* max_tile) const {
+  // The line is wider than the segment, and reaches into the tiles around
+  // it by half its width.
+  const float margin =
+      (0.5f * options_.line_width + 1.0f) * options_.meters_per_pixel;
+  const glm::vec2& start = positions_[segment];
+  const glm::vec2& end = positions_[segment + 1];
+  *min_tile = GetTile(glm::min(start, end) - margin);
+  *max_tile = GetTile(glm::max(start, end) + margin);
+}
+
+void Minimap::IndexSegment(uint32_t segment) {
+  glm::ivec2 min_tile;
+  glm::ivec2 max_tile;
+  GetSegmentTiles(segment, &min_tile, &max_tile);
+  for (int j = min_tile.y; j <= max_tile.y; ++j) {
+    for (int i = min_tile.x; i <= max_tile.x; ++i) {
+      tile_segments_[TileKey(i, j)].push_back(segment);
+    }
+  }
+}
+
+void Minimap::SetSlotScissor(const glm::ivec2& slot) {
+  glScissor(slot.x * options_.tile_pixels, slot.y * options_.tile_pixels,
+            options_.tile_pixels, options_.tile_pixels);
+}
+
+void Minimap::DrawTile(const glm::ivec2& tile, bool is_clear_needed) {
+  SetSlotScissor(GetSlot(tile));
+  if (is_clear_needed) {
+    glClearColor(background_color_.r, background_color_.g,
+                 background_color_.b, background_color_.a);
+    glClear(GL_COLOR_BUFFER_BIT);
+  }
+
+  // Every tile has the same grid, the lines of the whole texture are
+  // scissored to the slot.
+  glUniform4f(uniform_transform_, 2.0f / texture_size_, 2.0f / texture_size_,
+              -1.0f, -1.0f);
+  glUniform4fv(uniform_color_, 1, glm::value_ptr(grid_color_));
+  RenderState::LineWidth(1.0f);
+  grid_buffer_.Bind();
+  glEnableVertexAttribArray(attrib_vertices_);
+  glVertexAttribPointer(attrib_vertices_, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
+  Counters::Increment(Counters::kDrawCalls);
+  glDrawArrays(GL_LINES, 0, grid_vertex_count_);
+  glDisableVertexAttribArray(attrib_vertices_);
+
+  DrawSegments(tile, 0);
+}
+
+void Minimap::DrawSegments(const glm::ivec2& tile, uint32_t first) {
+  const auto found = tile_segments_.find(TileKey(tile.x, tile.y));
+  if (found == tile_segments_.end()) {
+    return;
+  }
+  const std::vector<uint32_t>& segments = found->second;
+  // Segments are indexed in order, the new ones are at the end.
+  std::vector<uint32_t>::const_iterator segment =
+      std::lower_bound(segments.begin(), segments.end(), first);
+  stream_vertices_.clear();
+  for (; segment != segments.end(); ++segment) {
+    const glm::vec2& start = positions_[*segment];
+    const glm::vec2& end = positions_[*segment + 1];
+    stream_vertices_.push_back(start.x);
+    stream_vertices_.push_back(start.y);
+    stream_vertices_.push_back(end.x);
+    stream_vertices_.push_back(end.y);
+  }
+  if (stream_vertices_.empty()) {
+    return;
+  }
+
+  // Meters to texture pixels, moved from the tile to its slot, to normalized
+  // device coordinates.
+  const glm::vec2 slot_offset =
+      glm::vec2(GetSlot(tile) - tile) *
+      (2.0f * options_.tile_pixels / texture_size_);
+  const float scale = 2.0f / (texture_size_ * options_.meters_per_pixel);
+  glUniform4f(uniform_transform_, scale, scale, slot_offset.x - 1.0f,
+              slot_offset.y - 1.0f);
+  glUniform4fv(uniform_color_, 1, glm::value_ptr(trace_color_));
+  RenderState::LineWidth(options_.line_width);
+  DrawStream(stream_vertices_.data(), stream_vertices_.size(), GL_LINES);
+}
+
+void Minimap::DrawStream(const GLfloat* vertices, size_t float_count,
+                         GLenum mode) {
+  stream_buffer_.Update(vertices, float_count * sizeof(GLfloat), 0);
+  stream_buffer_.Bind();
+  glEnableVertexAttribArray(attrib_vertices_);
+  glVertexAttribPointer(attrib_vertices_, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
+  Counters::Increment(Counters::kDrawCalls);
+  glDrawArrays(mode, 0, static_cast<GLsizei>(float_count / 2));
+  glDisableVertexAttribArray(attrib_vertices_);
+}
+
+bool Minimap::Allocate() {
+  if (framebuffer_ != 0) {
+    return true;
+  }
+  if (is_unsupported_) {
+    return false;
+  }
+
+  program_ = program_cache::AcquireProgram(
+      shaders::GetMinimapVertexShader().c_str(),
+      shaders::GetMinimapFragmentShader().c_str());
+  composite_program_ = program_cache::AcquireProgram(
+      shaders::GetMinimapCompositeVertexShader().c_str(),
+      shaders::GetCompositeFragmentShader().c_str());
+  if (!program_ || !composite_program_) {
+    LOGE("Minimap: could not create programs.");
+    Release();
+    is_unsupported_ = true;
+    return false;
+  }
+  attrib_vertices_ = glGetAttribLocation(program_, "vertex");
+  uniform_transform_ = glGetUniformLocation(program_, "transform");
+  uniform_color_ = glGetUniformLocation(program_, "color");
+  composite_attrib_vertices_ =
+      glGetAttribLocation(composite_program_, "vertex");
+  uniform_composite_transform_ =
+      glGetUniformLocation(composite_program_, "transform");
+  RenderState::UseProgram(composite_program_);
+  glUniform1i(glGetUniformLocation(composite_program_, "image"), 0);
+
+  // Lines through the pixel centers, every grid_pixels from the tile
+  // corners.
+  std::vector<GLfloat> grid_vertices;
+  const GLfloat size = static_cast<GLfloat>(texture_size_);
+  for (int pixel = 0; pixel < texture_size_; pixel += options_.grid_pixels) {
+    const GLfloat center = pixel + 0.5f;
+    const GLfloat lines[] = {center, 0.0f, center, size,
+                             0.0f, center, size, center};
+    grid_vertices.insert(grid_vertices.end(), lines,
+                         lines + sizeof(lines) / sizeof(lines[0]));
+  }
+  grid_vertex_count_ = static_cast<GLsizei>(grid_vertices.size() / 2);
+  grid_buffer_.Update(grid_vertices.data(),
+                      grid_vertices.size() * sizeof(GLfloat), 0);
+  quad_buffer_.Update(kQuadVertices, sizeof(kQuadVertices), 0);
+
+  glGenFramebuffers(1, &framebuffer_);
+  glGenTextures(1, &texture_);
+  RenderState::BindTexture(GL_TEXTURE_2D, texture_);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, texture_size_, texture_size_, 0,
+               GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+  MemoryTracker::Track(
+      MemoryTracker::kTexture, texture_, "Minimap",
+      MemoryTracker::GetTextureSize(texture_size_, texture_size_, GL_RGBA,
+                                    GL_UNSIGNED_BYTE));
+  glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_);
+  glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
+                         texture_, 0);
+  const GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  util::CheckGlError("Minimap::Allocate");
+
+  if (status != GL_FRAMEBUFFER_COMPLETE) {
+    LOGE("Minimap: framebuffer incomplete (0x%x), minimap disabled.", status);
+    Release();
+    is_unsupported_ = true;
+    return false;
+  }
+  // A new texture has nothing drawn.
+  is_window_valid_ = false;
+  return true;
+}
+
+void Minimap::Release() {
+  if (framebuffer_ != 0) {
+    glDeleteFramebuffers(1, &framebuffer_);
+    RenderState::DeleteTextures(1, &texture_);
+  }
+  program_cache::ReleaseProgram(program_);
+  program_cache::ReleaseProgram(composite_program_);
+  grid_buffer_.Release();
+  quad_buffer_.Release();
+  stream_buffer_.Release();
+  Invalidate();
+}
+
+void Minimap::Invalidate() {
+  framebuffer_ = 0;
+  texture_ = 0;
+  is_unsupported_ = false;
+  program_ = 0;
+  composite_program_ = 0;
+  grid_buffer_.Invalidate();
+  quad_buffer_.Invalidate();
+  stream_buffer_.Invalidate();
+  // The trajectory is kept and redrawn into the next texture.
+  is_window_valid_ = false;
+}
+
+}  // namespace tango_gl
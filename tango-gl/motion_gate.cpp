@@ -0,0 +1,69 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "tango-gl/motion_gate.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace tango_gl {
+
+MotionGate::MotionGate(const Options& options)
+    : options_(options),
+      has_reference_(false),
+      is_still_(false),
+      still_frame_count_(0),
+      skipped_frame_count_(0) {}
+
+bool MotionGate::ShouldProcess(const RigidTransform& pose) {
+  if (has_reference_) {
+    const RigidTransform delta = reference_.Inverse() * pose;
+    const float w = std::min(1.0f, std::abs(delta.GetRotation().w));
+    const float angle = 2.0f * std::acos(w);
+    is_still_ =
+        glm::length(delta.GetTranslation()) < options_.max_translation &&
+        angle < options_.max_rotation;
+  } else {
+    is_still_ = false;
+  }
+
+  if (is_still_ && ++still_frame_count_ < options_.refresh_interval) {
+    ++skipped_frame_count_;
+    return false;
+  }
+  // Refreshes keep the reference, drift is still measured from the last
+  // frame processed because of motion.
+  if (!is_still_) {
+    reference_ = pose;
+    has_reference_ = true;
+  }
+  still_frame_count_ = 0;
+  return true;
+}
+
+bool MotionGate::ShouldProcess(const PoseHistory& pose_history,
+                               double timestamp) {
+  RigidTransform pose;
+  if (!pose_history.GetPose(timestamp, &pose)) {
+    is_still_ = false;
+    still_frame_count_ = 0;
+    return true;
+  }
+  return ShouldProcess(pose);
+}
+
+}  // namespace tango_gl
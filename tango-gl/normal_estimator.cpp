@@ -0,0 +1,270 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tango-gl/normal_estimator.h"
+
+#include <math.h>
+
+#include <algorithm>
+
+#include "tango-gl/frame_arena.h"
+
+namespace {
+// Tasks per pool thread, so threads that finish early can take over rows of
+// slower ones.
+const int kTasksPerThread = 4;
+}  // namespace
+
+namespace tango_gl {
+
+const int NormalEstimator::kDefaultWindowRadius;
+const int NormalEstimator::kMinWindowPointCount;
+
+NormalEstimator::NormalEstimator(WorkerPool* worker_pool)
+    : worker_pool_(worker_pool),
+      window_radius_(kDefaultWindowRadius),
+      width_(0),
+      height_(0) {}
+
+void NormalEstimator::SetWindowRadius(int radius) {
+  window_radius_ = std::max(radius, 1);
+}
+
+size_t NormalEstimator::Compute(const RangeImage& image) {
+  width_ = image.GetWidth();
+  height_ = image.GetHeight();
+  const size_t pixel_count = static_cast<size_t>(width_) * height_;
+  normals_.resize(pixel_count);
+  if (pixel_count == 0) {
+    return 0;
+  }
+  integral_.resize(static_cast<size_t>(width_ + 1) * (height_ + 1));
+  // The first row and column stay zero, sums over empty rectangles.
+  std::fill(integral_.begin(), integral_.begin() + width_ + 1, Moments());
+
+  const int task_count = std::max(
+      1, std::min(worker_pool_ == nullptr
+                      ? 1
+                      : worker_pool_->GetConcurrency() * kTasksPerThread,
+                  height_));
+  RunTasks(task_count, [this, &image, task_count](int task) {
+    SumRows(image, height_ * task / task_count,
+            height_ * (task + 1) / task_count);
+  });
+  // Columns are added up in bands, each task walks all rows of its band.
+  const int column_task_count = std::min(task_count, width_);
+  RunTasks(column_task_count, [this, column_task_count](int task) {
+    SumColumns(width_ * task / column_task_count,
+               width_ * (task + 1) / column_task_count);
+  });
+
+  FrameArena& arena = FrameArena::ForThisThread();
+  FrameArena::Scope scope(&arena);
+  ArenaVector<size_t> counts(task_count, 0, ArenaAllocator<size_t>(&arena));
+  RunTasks(task_count, [this, &image, &counts, task_count](int task) {
+    counts[task] = ComputeRows(image, height_ * task / task_count,
+                               height_ * (task + 1) / task_count);
+  });
+  size_t normal_count = 0;
+  for (size_t count : counts) {
+    normal_count += count;
+  }
+  return normal_count;
+}
+
+void NormalEstimator::SumRows(const RangeImage& image, int begin, int end) {
+  const float* column_rays = image.GetRayTable().GetColumnRays();
+  const float* row_rays = image.GetRayTable().GetRowRays();
+  for (int y = begin; y < end; ++y) {
+    const float* depths = image.GetDepths() + static_cast<size_t>(y) * width_;
+    Moments* row = &integral_[static_cast<size_t>(y + 1) * (width_ + 1)];
+    row[0] = Moments();
+    const double ray_y = row_rays[y];
+    Moments sum = Moments();
+    for (int x = 0; x < width_; ++x) {
+      const double z = depths[x];
+      if (z > 0.0) {
+        const double px = column_rays[x] * z;
+        const double py = ray_y * z;
+        sum.count += 1.0;
+        sum.x += px;
+        sum.y += py;
+        sum.z += z;
+        sum.xx += px * px;
+        sum.xy += px * py;
+        sum.xz += px * z;
+        sum.yy += py * py;
+        sum.yz += py * z;
+        sum.zz += z * z;
+      }
+      row[x + 1] = sum;
+    }
+  }
+}
+
+void NormalEstimator::SumColumns(int begin, int end) {
+  const size_t stride = width_ + 1;
+  for (int y = 2; y <= height_; ++y) {
+    const double* above = &integral_[(y - 1) * stride + begin + 1].count;
+    double* row = &integral_[y * stride + begin + 1].count;
+    // Moments is all doubles, so the band is one flat array of them.
+    const int value_count =
+        (end - begin) * static_cast<int>(sizeof(Moments) / sizeof(double));
+    for (int i = 0; i < value_count; ++i) {
+      row[i] += above[i];
+    }
+  }
+}
+
+size_t NormalEstimator::ComputeRows(const RangeImage& image, int begin,
+                                    int end) {
+  const size_t stride = width_ + 1;
+  size_t normal_count = 0;
+  for (int y = begin; y < end; ++y) {
+    const int top = std::max(y - window_radius_, 0);
+    const int bottom = std::min(y + window_radius_ + 1, height_);
+    const Moments* top_row = &integral_[top * stride];
+    const Moments* bottom_row = &integral_[bottom * stride];
+    for (int x = 0; x < width_; ++x) {
+      glm::vec3& normal = normals_[static_cast<size_t>(y) * width_ + x];
+      normal = glm::vec3(0.0f);
+      if (!(image.GetDepth(x, y) > 0.0f)) {
+        continue;
+      }
+      const int left = std::max(x - window_radius_, 0);
+      const int right = std::min(x + window_radius_ + 1, width_);
+      const double* a = &bottom_row[right].count;
+      const double* b = &bottom_row[left].count;
+      const double* c = &top_row[right].count;
+      const double* d = &top_row[left].count;
+      Moments window;
+      double* sums = &window.count;
+      for (size_t i = 0; i < sizeof(Moments) / sizeof(double); ++i) {
+        sums[i] = a[i] - b[i] - c[i] + d[i];
+      }
+      if (window.count < kMinWindowPointCount) {
+        continue;
+      }
+
+      // Covariance times the point count, the scale does not change the
+      // eigenvectors.
+      const double inverse_count = 1.0 / window.count;
+      const double xy = window.xy - window.x * window.y * inverse_count;
+      const double xz = window.xz - window.x * window.z * inverse_count;
+      const double yz = window.yz - window.y * window.z * inverse_count;
+      const glm::dmat3 covariance(
+          window.xx - window.x * window.x * inverse_count, xy, xz, xy,
+          window.yy - window.y * window.y * inverse_count, yz, xz, yz,
+          window.zz - window.z * window.z * inverse_count);
+      glm::dvec3 eigenvector;
+      if (!SmallestEigenvector(covariance, &eigenvector)) {
+        continue;
+      }
+      // Face the camera, which looks down +z from the origin.
+      const glm::dvec3 centroid(window.x * inverse_count,
+                                window.y * inverse_count,
+                                window.z * inverse_count);
+      if (glm::dot(eigenvector, centroid) > 0.0) {
+        eigenvector = -eigenvector;
+      }
+      normal = glm::vec3(eigenvector);
+      ++normal_count;
+    }
+  }
+  return normal_count;
+}
+
+void NormalEstimator::RunTasks(int task_count,
+                               const std::function<void(int)>& task) {
+  if (worker_pool_ == nullptr) {
+    for (int i = 0; i < task_count; ++i) {
+      task(i);
+    }
+  } else {
+    worker_pool_->ParallelFor(task_count, task);
+  }
+}
+
+// From the closed form eigenvalues. The eigenvector is the largest cross
+// product of two rows of (A - lambda * I), which are orthogonal to it.
+bool SmallestEigenvector(const glm::dmat3& matrix, glm::dvec3* eigenvector) {
+  double a00 = matrix[0][0];
+  double a01 = matrix[1][0];
+  double a02 = matrix[2][0];
+  double a11 = matrix[1][1];
+  double a12 = matrix[2][1];
+  double a22 = matrix[2][2];
+  // Scaled so the eigenvalue computation neither underflows nor overflows.
+  const double scale = std::max(
+      std::max(std::max(fabs(a00), fabs(a01)), std::max(fabs(a02), fabs(a11))),
+      std::max(fabs(a12), fabs(a22)));
+  if (!(scale > 0.0)) {
+    return false;
+  }
+  a00 /= scale;
+  a01 /= scale;
+  a02 /= scale;
+  a11 /= scale;
+  a12 /= scale;
+  a22 /= scale;
+
+  const double q = (a00 + a11 + a22) / 3.0;
+  const double off_diagonal = a01 * a01 + a02 * a02 + a12 * a12;
+  const double p = sqrt(((a00 - q) * (a00 - q) + (a11 - q) * (a11 - q) +
+                         (a22 - q) * (a22 - q) + 2.0 * off_diagonal) /
+                        6.0);
+  if (!(p > 0.0)) {
+    return false;
+  }
+  const double b00 = (a00 - q) / p;
+  const double b11 = (a11 - q) / p;
+  const double b22 = (a22 - q) / p;
+  const double b01 = a01 / p;
+  const double b02 = a02 / p;
+  const double b12 = a12 / p;
+  const double half_determinant =
+      0.5 * (b00 * (b11 * b22 - b12 * b12) - b01 * (b01 * b22 - b12 * b02) +
+             b02 * (b01 * b12 - b11 * b02));
+  const double phi =
+      acos(std::min(1.0, std::max(-1.0, half_determinant))) / 3.0;
+  const double smallest = q + 2.0 * p * cos(phi + 2.0 * M_PI / 3.0);
+
+  const glm::dvec3 row0(a00 - smallest, a01, a02);
+  const glm::dvec3 row1(a01, a11 - smallest, a12);
+  const glm::dvec3 row2(a02, a12, a22 - smallest);
+  const glm::dvec3 cross01 = glm::cross(row0, row1);
+  const glm::dvec3 cross02 = glm::cross(row0, row2);
+  const glm::dvec3 cross12 = glm::cross(row1, row2);
+  const double length01 = glm::dot(cross01, cross01);
+  const double length02 = glm::dot(cross02, cross02);
+  const double length12 = glm::dot(cross12, cross12);
+  glm::dvec3 largest = cross01;
+  double largest_length = length01;
+  if (length02 > largest_length) {
+    largest = cross02;
+    largest_length = length02;
+  }
+  if (length12 > largest_length) {
+    largest = cross12;
+    largest_length = length12;
+  }
+  if (!(largest_length > 0.0)) {
+    return false;
+  }
+  *eigenvector = largest / sqrt(largest_length);
+  return true;
+}
+}  // namespace tango_gl
@@ -13,144 +13,604 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
+#include <fcntl.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 #include <string>
+#include <unordered_map>
 
 #include "tango-gl/obj_loader.h"
 
-namespace tango_gl {
-bool obj_loader::LoadOBJData(const char* path, std::vector<GLfloat>& vertices,
-                             std::vector<GLushort>& indices) {
-  FILE *file = fopen(path, "r");
+namespace {
+// "TGMB" in little endian, followed by the format version.
+const uint32_t kMeshMagic = 0x424d4754;
+const uint32_t kMeshVersion = 3;
+
+const uint32_t kFlagNormals = 1 << 0;
+const uint32_t kFlagIndices32 = 1 << 1;
+// The mesh was built for a load with normals. Vertices are then shared per
+// (v, vn) pair, so the flag tells the two layouts apart even when the file
+// has no normals.
+const uint32_t kFlagWithNormals = 1 << 2;
+
+// Largest vertex count addressable by GL_UNSIGNED_SHORT indices.
+const size_t kMaxShortIndexVertices = 65536;
+
+// Both blocks start on a 16 byte boundary of the file.
+const size_t kBlockAlignment = 16;
+
+struct MeshHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t flags;
+  uint32_t vertex_count;
+  uint32_t index_count;
+  uint32_t vertex_offset;
+  uint32_t index_offset;
+  uint32_t reserved;
+  int64_t source_size;
+  int64_t source_mtime;
+};
+
+size_t Align(size_t offset) {
+  return (offset + kBlockAlignment - 1) & ~(kBlockAlignment - 1);
+}
+
+// Lay out a binary mesh image for the given vertex data. Indices are stored
+// as 16 bit when every vertex can be addressed that way.
+std::vector<uint8_t> BuildImage(const std::vector<GLfloat>& vertices,
+                                const std::vector<GLfloat>& normals,
+                                const std::vector<GLuint>& indices,
+                                bool with_normals, int64_t source_size,
+                                int64_t source_mtime) {
+  const bool has_normals = !normals.empty();
+  const size_t floats_per_vertex = has_normals ? 6 : 3;
+  const uint32_t vertex_count = vertices.size() / 3;
+  const bool is_indices32 = vertex_count > kMaxShortIndexVertices;
+  const size_t index_size = is_indices32 ? sizeof(GLuint) : sizeof(GLushort);
+
+  MeshHeader header;
+  memset(&header, 0, sizeof(header));
+  header.magic = kMeshMagic;
+  header.version = kMeshVersion;
+  header.flags = (has_normals ? kFlagNormals : 0) |
+                 (is_indices32 ? kFlagIndices32 : 0) |
+                 (with_normals ? kFlagWithNormals : 0);
+  header.vertex_count = vertex_count;
+  header.index_count = indices.size();
+  header.vertex_offset = Align(sizeof(MeshHeader));
+  header.index_offset = Align(header.vertex_offset + vertex_count *
+                                                        floats_per_vertex *
+                                                        sizeof(GLfloat));
+  header.source_size = source_size;
+  header.source_mtime = source_mtime;
+
+  std::vector<uint8_t> image(header.index_offset + indices.size() * index_size);
+  memcpy(image.data(), &header, sizeof(header));
+  GLfloat* vertex_block =
+      reinterpret_cast<GLfloat*>(image.data() + header.vertex_offset);
+  for (uint32_t i = 0; i < vertex_count; ++i) {
+    memcpy(vertex_block + i * floats_per_vertex, &vertices[i * 3],
+           3 * sizeof(GLfloat));
+    if (has_normals) {
+      memcpy(vertex_block + i * floats_per_vertex + 3, &normals[i * 3],
+             3 * sizeof(GLfloat));
+    }
+  }
+  if (is_indices32) {
+    memcpy(image.data() + header.index_offset, indices.data(),
+           indices.size() * sizeof(GLuint));
+  } else {
+    GLushort* index_block =
+        reinterpret_cast<GLushort*>(image.data() + header.index_offset);
+    for (size_t i = 0; i < indices.size(); ++i) {
+      index_block[i] = static_cast<GLushort>(indices[i]);
+    }
+  }
+  return image;
+}
+
+// Write the image next to its final path and rename it into place, so an
+// interrupted write never leaves a truncated cache behind.
+bool WriteImage(const std::string& path, const std::vector<uint8_t>& image) {
+  const std::string temp_path = path + ".tmp";
+  FILE* file = fopen(temp_path.c_str(), "wb");
   if (file == NULL) {
-    LOGE("Failed to open file: %s", path);
     return false;
   }
+  bool is_written =
+      fwrite(image.data(), 1, image.size(), file) == image.size();
+  is_written = fclose(file) == 0 && is_written;
+  if (!is_written || rename(temp_path.c_str(), path.c_str()) != 0) {
+    unlink(temp_path.c_str());
+    return false;
+  }
+  return true;
+}
+
+// Read a whole file into memory with a single read() in the common case.
+bool ReadFile(const char* path, std::vector<char>* contents) {
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) != 0) {
+    close(fd);
+    return false;
+  }
+  contents->resize(file_stat.st_size);
+  size_t offset = 0;
+  while (offset < contents->size()) {
+    ssize_t count =
+        read(fd, contents->data() + offset, contents->size() - offset);
+    if (count <= 0) {
+      close(fd);
+      return false;
+    }
+    offset += count;
+  }
+  close(fd);
+  return true;
+}
+
+// Powers of ten exactly representable as a double.
+const double kPowersOfTen[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,
+                               1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                               1e12, 1e13, 1e14, 1e15, 1e16, 1e17,
+                               1e18, 1e19, 1e20, 1e21, 1e22};
+const int kMaxExactPower = 22;
 
-  while (1) {
-    char lineHeader[128];
-    int res = fscanf(file, "%s", lineHeader);
-    if (res == EOF) break;
-    if (strcmp(lineHeader, "v") == 0) {
-      GLfloat vertex[3];
-      int matches =
-          fscanf(file, "%f %f %f\n", &vertex[0], &vertex[1], &vertex[2]);
-      if (matches != 3) {
-        LOGE("Format of 'v float float float' required for each vertice line");
+// Line oriented tokenizer over an OBJ file held in memory.
+class ObjTokenizer {
+ public:
+  ObjTokenizer(const char* begin, const char* end)
+      : pos_(begin), end_(end), line_(1) {}
+
+  bool IsAtEnd() const { return pos_ >= end_; }
+  int GetLine() const { return line_; }
+
+  // True if only blanks or a comment are left on the current line.
+  bool IsAtLineEnd() {
+    SkipBlanks();
+    return pos_ >= end_ || *pos_ == '\n' || *pos_ == '#';
+  }
+
+  // Move past the end of the current line.
+  void NextLine() {
+    const char* newline =
+        static_cast<const char*>(memchr(pos_, '\n', end_ - pos_));
+    pos_ = newline != nullptr ? newline + 1 : end_;
+    ++line_;
+  }
+
+  // Read a keyword such as "v" or "f" and compare it against name.
+  bool ReadKeyword(const char** keyword, size_t* length) {
+    SkipBlanks();
+    *keyword = pos_;
+    while (pos_ < end_ && !IsBlank(*pos_) && *pos_ != '\n') {
+      ++pos_;
+    }
+    *length = pos_ - *keyword;
+    return *length > 0;
+  }
+
+  // Parse a decimal float, e.g. "-1.25e-3".
+  bool ReadFloat(GLfloat* value) {
+    SkipBlanks();
+    bool is_negative = false;
+    if (pos_ < end_ && (*pos_ == '-' || *pos_ == '+')) {
+      is_negative = *pos_ == '-';
+      ++pos_;
+    }
+    // Digits past the 19th do not fit the mantissa and only shift the
+    // exponent, which is still well within float precision.
+    uint64_t mantissa = 0;
+    int digits = 0;
+    int exponent = 0;
+    bool has_digits = false;
+    for (; pos_ < end_ && IsDigit(*pos_); ++pos_) {
+      has_digits = true;
+      if (digits < 19) {
+        mantissa = mantissa * 10 + (*pos_ - '0');
+        digits += mantissa != 0;
+      } else {
+        ++exponent;
+      }
+    }
+    if (pos_ < end_ && *pos_ == '.') {
+      for (++pos_; pos_ < end_ && IsDigit(*pos_); ++pos_) {
+        has_digits = true;
+        if (digits < 19) {
+          mantissa = mantissa * 10 + (*pos_ - '0');
+          digits += mantissa != 0;
+          --exponent;
+        }
+      }
+    }
+    if (!has_digits) {
+      return false;
+    }
+    if (pos_ < end_ && (*pos_ == 'e' || *pos_ == 'E')) {
+      ++pos_;
+      bool is_exponent_negative = false;
+      if (pos_ < end_ && (*pos_ == '-' || *pos_ == '+')) {
+        is_exponent_negative = *pos_ == '-';
+        ++pos_;
+      }
+      if (pos_ >= end_ || !IsDigit(*pos_)) {
         return false;
       }
-      vertices.push_back(vertex[0]);
-      vertices.push_back(vertex[1]);
-      vertices.push_back(vertex[2]);
-    } else if (strcmp(lineHeader, "f") == 0) {
-      GLushort vertexIndex[3];
-      int matches = fscanf(file, "%hu %hu %hu\n", &vertexIndex[0],
-                           &vertexIndex[1], &vertexIndex[2]);
-      if (matches != 3) {
-        LOGE("Format of 'f int int int' required for each face line");
+      int written_exponent = 0;
+      for (; pos_ < end_ && IsDigit(*pos_); ++pos_) {
+        if (written_exponent < 10000) {
+          written_exponent = written_exponent * 10 + (*pos_ - '0');
+        }
+      }
+      exponent += is_exponent_negative ? -written_exponent : written_exponent;
+    }
+
+    double result = static_cast<double>(mantissa);
+    if (exponent < 0) {
+      result = -exponent <= kMaxExactPower
+                   ? result / kPowersOfTen[-exponent]
+                   : result * pow(10.0, exponent);
+    } else if (exponent > 0) {
+      result = exponent <= kMaxExactPower ? result * kPowersOfTen[exponent]
+                                          : result * pow(10.0, exponent);
+    }
+    *value = static_cast<GLfloat>(is_negative ? -result : result);
+    return true;
+  }
+
+  // Parse a face corner, "v", "v/vt", "v//vn" or "v/vt/vn". Indices are
+  // returned as written, 1 based or negative, 0 if missing.
+  bool ReadCorner(int64_t* vertex, int64_t* normal) {
+    SkipBlanks();
+    *normal = 0;
+    if (!ReadIndex(vertex)) {
+      return false;
+    }
+    if (pos_ < end_ && *pos_ == '/') {
+      ++pos_;
+      int64_t texture_coordinate;
+      if (pos_ < end_ && *pos_ != '/' && !ReadIndex(&texture_coordinate)) {
         return false;
       }
-      indices.push_back(vertexIndex[0] - 1);
-      indices.push_back(vertexIndex[1] - 1);
-      indices.push_back(vertexIndex[2] - 1);
+      if (pos_ < end_ && *pos_ == '/') {
+        ++pos_;
+        if (!ReadIndex(normal)) {
+          return false;
+        }
+      }
     }
-    else {
-      char comments_buffer[1000];
-      fgets(comments_buffer, 1000, file);
+    return pos_ >= end_ || IsBlank(*pos_) || *pos_ == '\n';
+  }
+
+ private:
+  static bool IsBlank(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+  static bool IsDigit(char c) { return c >= '0' && c <= '9'; }
+
+  void SkipBlanks() {
+    while (pos_ < end_ && IsBlank(*pos_)) {
+      ++pos_;
     }
   }
-  fclose(file);
-  return true;
+
+  bool ReadIndex(int64_t* index) {
+    bool is_negative = false;
+    if (pos_ < end_ && *pos_ == '-') {
+      is_negative = true;
+      ++pos_;
+    }
+    if (pos_ >= end_ || !IsDigit(*pos_)) {
+      return false;
+    }
+    int64_t value = 0;
+    for (; pos_ < end_ && IsDigit(*pos_); ++pos_) {
+      if (value < INT32_MAX) {
+        value = value * 10 + (*pos_ - '0');
+      }
+    }
+    *index = is_negative ? -value : value;
+    return true;
+  }
+
+  const char* pos_;
+  const char* end_;
+  int line_;
+};
+
+bool IsKeyword(const char* keyword, size_t length, const char* name) {
+  return length == strlen(name) && memcmp(keyword, name, length) == 0;
 }
 
-bool obj_loader::LoadOBJData(const char* path, std::vector<GLfloat>& vertices,
-                             std::vector<GLfloat>& normals) {
-  std::vector<unsigned int> vertexIndices, normalIndices;
-  std::vector<GLfloat> temp_vertices, temp_normals;
+// Resolve a 1 based or negative (relative to the end) OBJ index against the
+// number of elements defined so far. Returns -1 if out of range.
+int64_t ResolveIndex(int64_t index, size_t count) {
+  int64_t resolved =
+      index > 0 ? index - 1 : static_cast<int64_t>(count) + index;
+  return (index != 0 && resolved >= 0 && resolved < static_cast<int64_t>(count))
+             ? resolved
+             : -1;
+}
 
-  FILE* file = fopen(path, "r");
-  if (file == NULL) {
+// Parse an OBJ file into an indexed triangle mesh. Polygons are triangulated
+// as fans. With use_normals, each distinct (v, vn) pair of the faces becomes
+// one output vertex; otherwise vertices are shared by position and normals
+// are ignored. Corners without a normal get a zero normal.
+bool ParseOBJ(const char* path, bool use_normals,
+              std::vector<GLfloat>* vertices, std::vector<GLfloat>* normals,
+              std::vector<GLuint>* indices) {
+  std::vector<char> contents;
+  if (!ReadFile(path, &contents)) {
     LOGE("Failed to open file: %s", path);
     return false;
   }
 
-  while (1) {
-    char lineHeader[128];
-    int res = fscanf(file, "%s", lineHeader);
-    if (res == EOF) break;
-    if (strcmp(lineHeader, "v") == 0) {
-      GLfloat vertex[3];
-      int matches =
-          fscanf(file, "%f %f %f\n", &vertex[0], &vertex[1], &vertex[2]);
-      if (matches != 3) {
-        LOGE("Format of 'v float float float' required for each vertice line");
+  std::vector<GLfloat> positions;
+  std::vector<GLfloat> file_normals;
+  std::unordered_map<uint64_t, GLuint> vertex_by_corner;
+  std::vector<GLuint> face;
+  vertices->clear();
+  normals->clear();
+  indices->clear();
+
+  ObjTokenizer tokenizer(contents.data(), contents.data() + contents.size());
+  for (; !tokenizer.IsAtEnd(); tokenizer.NextLine()) {
+    const char* keyword;
+    size_t length;
+    if (!tokenizer.ReadKeyword(&keyword, &length) || keyword[0] == '#') {
+      continue;
+    }
+    if (IsKeyword(keyword, length, "v") || IsKeyword(keyword, length, "vn")) {
+      std::vector<GLfloat>* target =
+          length == 1 ? &positions : &file_normals;
+      GLfloat value[3];
+      if (!tokenizer.ReadFloat(&value[0]) || !tokenizer.ReadFloat(&value[1]) ||
+          !tokenizer.ReadFloat(&value[2])) {
+        LOGE("%s:%d: format of '%s float float float' required", path,
+             tokenizer.GetLine(), length == 1 ? "v" : "vn");
         return false;
       }
-      temp_vertices.push_back(vertex[0]);
-      temp_vertices.push_back(vertex[1]);
-      temp_vertices.push_back(vertex[2]);
-    } else if (strcmp(lineHeader, "vn") == 0) {
-      GLfloat normal[3];
-      int matches =
-          fscanf(file, "%f %f %f\n", &normal[0], &normal[1], &normal[2]);
-      if (matches != 3) {
-        LOGE("Format of 'vn float float float' required for each normal line");
-        return false;
+      target->insert(target->end(), value, value + 3);
+    } else if (IsKeyword(keyword, length, "f")) {
+      face.clear();
+      while (!tokenizer.IsAtLineEnd()) {
+        int64_t vertex_index, normal_index;
+        if (!tokenizer.ReadCorner(&vertex_index, &normal_index)) {
+          LOGE("%s:%d: malformed face", path, tokenizer.GetLine());
+          return false;
+        }
+        int64_t vertex = ResolveIndex(vertex_index, positions.size() / 3);
+        int64_t normal = -1;
+        if (use_normals && normal_index != 0) {
+          normal = ResolveIndex(normal_index, file_normals.size() / 3);
+          if (normal < 0) {
+            LOGE("%s:%d: normal index out of range", path,
+                 tokenizer.GetLine());
+            return false;
+          }
+        }
+        if (vertex < 0) {
+          LOGE("%s:%d: vertex index out of range", path, tokenizer.GetLine());
+          return false;
+        }
+
+        const uint64_t key = (static_cast<uint64_t>(vertex) << 32) |
+                             static_cast<uint32_t>(normal + 1);
+        auto inserted = vertex_by_corner.insert(
+            std::make_pair(key, static_cast<GLuint>(vertices->size() / 3)));
+        if (inserted.second) {
+          vertices->insert(vertices->end(), &positions[vertex * 3],
+                           &positions[vertex * 3] + 3);
+          if (use_normals) {
+            const GLfloat kNoNormal[3] = {0.0f, 0.0f, 0.0f};
+            const GLfloat* source =
+                normal >= 0 ? &file_normals[normal * 3] : kNoNormal;
+            normals->insert(normals->end(), source, source + 3);
+          }
+        }
+        face.push_back(inserted.first->second);
       }
-      temp_normals.push_back(normal[0]);
-      temp_normals.push_back(normal[1]);
-      temp_normals.push_back(normal[2]);
-    } else if (strcmp(lineHeader, "f") == 0) {
-      GLushort vertexIndex[4];
-      GLushort normalIndex[4];
-      int matches = fscanf(file, "%hu//%hu %hu//%hu %hu//%hu %hu//%hu\n",
-                           &vertexIndex[0], &normalIndex[0], &vertexIndex[1], &normalIndex[1],
-                           &vertexIndex[2], &normalIndex[2], &vertexIndex[3], &normalIndex[3]);
-
-      // .obj file is 1-indexed, so subtract 1 from all indices.
-      if (matches == 6) {
-        // If triangles provided.
-        vertexIndices.push_back(vertexIndex[0] - 1);
-        vertexIndices.push_back(vertexIndex[1] - 1);
-        vertexIndices.push_back(vertexIndex[2] - 1);
-        normalIndices.push_back(normalIndex[0] - 1);
-        normalIndices.push_back(normalIndex[1] - 1);
-        normalIndices.push_back(normalIndex[2] - 1);
-      } else if(matches == 8) {
-        // If quads provided.
-        vertexIndices.push_back(vertexIndex[0] - 1);
-        vertexIndices.push_back(vertexIndex[1] - 1);
-        vertexIndices.push_back(vertexIndex[2] - 1);
-        vertexIndices.push_back(vertexIndex[0] - 1);
-        vertexIndices.push_back(vertexIndex[2] - 1);
-        vertexIndices.push_back(vertexIndex[3] - 1);
-        normalIndices.push_back(normalIndex[0] - 1);
-        normalIndices.push_back(normalIndex[1] - 1);
-        normalIndices.push_back(normalIndex[2] - 1);
-        normalIndices.push_back(normalIndex[0] - 1);
-        normalIndices.push_back(normalIndex[2] - 1);
-        normalIndices.push_back(normalIndex[3] - 1);
-      } else {
-        LOGE("Format of 'f int//int int//int int//int' required for each face");
+      if (face.size() < 3) {
+        LOGE("%s:%d: face needs at least 3 vertices", path,
+             tokenizer.GetLine());
         return false;
       }
-    } else {
-      char comments_buffer[1000];
-      fgets(comments_buffer, 1000, file);
+      for (size_t i = 2; i < face.size(); ++i) {
+        indices->push_back(face[0]);
+        indices->push_back(face[i - 1]);
+        indices->push_back(face[i]);
+      }
     }
   }
+  return true;
+}
+}  // namespace
+
+namespace tango_gl {
+namespace obj_loader {
+bool LoadOBJData(const char* path, std::vector<GLfloat>& vertices,
+                 std::vector<GLushort>& indices) {
+  std::vector<GLfloat> normals;
+  std::vector<GLuint> indices32;
+  if (!ParseOBJ(path, false, &vertices, &normals, &indices32)) {
+    return false;
+  }
+  if (vertices.size() / 3 > kMaxShortIndexVertices) {
+    LOGE("%s has too many vertices for 16 bit indices, use GLuint indices",
+         path);
+    return false;
+  }
+  indices.assign(indices32.begin(), indices32.end());
+  return true;
+}
+
+bool LoadOBJData(const char* path, std::vector<GLfloat>& vertices,
+                 std::vector<GLuint>& indices) {
+  std::vector<GLfloat> normals;
+  return ParseOBJ(path, false, &vertices, &normals, &indices);
+}
+
+bool LoadOBJData(const char* path, std::vector<GLfloat>& vertices,
+                 std::vector<GLfloat>& normals) {
+  std::vector<GLfloat> indexed_vertices;
+  std::vector<GLfloat> indexed_normals;
+  std::vector<GLuint> indices;
+  if (!ParseOBJ(path, true, &indexed_vertices, &indexed_normals, &indices)) {
+    return false;
+  }
+  vertices.clear();
+  normals.clear();
+  vertices.reserve(indices.size() * 3);
+  normals.reserve(indices.size() * 3);
+  for (GLuint index : indices) {
+    vertices.insert(vertices.end(), &indexed_vertices[index * 3],
+                    &indexed_vertices[index * 3] + 3);
+    normals.insert(normals.end(), &indexed_normals[index * 3],
+                   &indexed_normals[index * 3] + 3);
+  }
+  return true;
+}
+
+bool LoadOBJData(const char* path, std::vector<GLfloat>& vertices,
+                 std::vector<GLfloat>& normals, std::vector<GLuint>& indices) {
+  return ParseOBJ(path, true, &vertices, &normals, &indices);
+}
+
+MappedMesh::MappedMesh()
+    : mapping_(nullptr),
+      mapping_size_(0),
+      vertex_data_(nullptr),
+      vertex_count_(0),
+      has_normals_(false),
+      index_data_(nullptr),
+      index_count_(0),
+      index_type_(GL_UNSIGNED_SHORT) {}
 
-  for (unsigned int i = 0; i < vertexIndices.size(); i++) {
-    unsigned int vertexIndex = vertexIndices[i];
-    unsigned int normalIndex = normalIndices[i];
+MappedMesh::~MappedMesh() { Unmap(); }
+
+bool MappedMesh::Map(const char* path, bool with_normals,
+                     int64_t source_size, int64_t source_mtime) {
+  Unmap();
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) != 0 ||
+      file_stat.st_size < static_cast<off_t>(sizeof(MeshHeader))) {
+    close(fd);
+    return false;
+  }
+  const size_t size = file_stat.st_size;
+  void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  // The mapping keeps the file referenced on its own.
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    LOGE("MappedMesh: failed to map %s", path);
+    return false;
+  }
+  return Attach(mapping, size, with_normals, source_size, source_mtime);
+}
 
-    vertices.push_back(temp_vertices[vertexIndex * 3]);
-    vertices.push_back(temp_vertices[vertexIndex * 3 + 1]);
-    vertices.push_back(temp_vertices[vertexIndex * 3 + 2]);
-    normals.push_back(temp_normals[normalIndex * 3]);
-    normals.push_back(temp_normals[normalIndex * 3 + 1]);
-    normals.push_back(temp_normals[normalIndex * 3 + 2]);
+bool MappedMesh::Attach(void* mapping, size_t mapping_size,
+                        bool with_normals, int64_t source_size,
+                        int64_t source_mtime) {
+  MeshHeader header;
+  memcpy(&header, mapping, sizeof(header));
+  const size_t vertex_stride =
+      ((header.flags & kFlagNormals) ? 6 : 3) * sizeof(GLfloat);
+  const size_t index_size =
+      (header.flags & kFlagIndices32) ? sizeof(GLuint) : sizeof(GLushort);
+  const bool is_valid =
+      header.magic == kMeshMagic && header.version == kMeshVersion &&
+      ((header.flags & kFlagWithNormals) != 0) == with_normals &&
+      header.source_size == source_size &&
+      header.source_mtime == source_mtime &&
+      header.vertex_offset >= sizeof(MeshHeader) &&
+      header.vertex_offset + static_cast<uint64_t>(header.vertex_count) *
+                                 vertex_stride <= header.index_offset &&
+      header.index_offset + static_cast<uint64_t>(header.index_count) *
+                                index_size <= mapping_size;
+  if (!is_valid) {
+    munmap(mapping, mapping_size);
+    return false;
   }
-  fclose(file);
+
+  const uint8_t* base = static_cast<const uint8_t*>(mapping);
+  mapping_ = mapping;
+  mapping_size_ = mapping_size;
+  vertex_data_ = base + header.vertex_offset;
+  vertex_count_ = header.vertex_count;
+  has_normals_ = (header.flags & kFlagNormals) != 0;
+  index_data_ = header.index_count > 0 ? base + header.index_offset : nullptr;
+  index_count_ = header.index_count;
+  index_type_ =
+      (header.flags & kFlagIndices32) ? GL_UNSIGNED_INT : GL_UNSIGNED_SHORT;
   return true;
 }
+
+void MappedMesh::Unmap() {
+  if (mapping_ != nullptr) {
+    munmap(mapping_, mapping_size_);
+  }
+  mapping_ = nullptr;
+  mapping_size_ = 0;
+  vertex_data_ = nullptr;
+  vertex_count_ = 0;
+  has_normals_ = false;
+  index_data_ = nullptr;
+  index_count_ = 0;
+  index_type_ = GL_UNSIGNED_SHORT;
+}
+
+bool LoadOBJData(const char* path, bool with_normals, MappedMesh* mesh) {
+  struct stat source_stat;
+  if (stat(path, &source_stat) != 0) {
+    LOGE("Failed to open file: %s", path);
+    return false;
+  }
+  const int64_t source_size = source_stat.st_size;
+  const int64_t source_mtime = source_stat.st_mtime;
+  const std::string cache_path = std::string(path) + ".mesh";
+  if (mesh->Map(cache_path.c_str(), with_normals, source_size,
+                source_mtime)) {
+    return true;
+  }
+
+  std::vector<GLfloat> vertices;
+  std::vector<GLfloat> normals;
+  std::vector<GLuint> indices;
+  if (!ParseOBJ(path, with_normals, &vertices, &normals, &indices)) {
+    return false;
+  }
+
+  std::vector<uint8_t> image =
+      BuildImage(vertices, normals, indices, with_normals, source_size,
+                 source_mtime);
+  if (WriteImage(cache_path, image) &&
+      mesh->Map(cache_path.c_str(), with_normals, source_size,
+                source_mtime)) {
+    return true;
+  }
+
+  LOGE("obj_loader: could not write mesh cache %s", cache_path.c_str());
+  void* mapping = mmap(nullptr, image.size(), PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (mapping == MAP_FAILED) {
+    LOGE("obj_loader: out of memory loading %s", path);
+    return false;
+  }
+  memcpy(mapping, image.data(), image.size());
+  return mesh->Attach(mapping, image.size(), with_normals, source_size,
+                      source_mtime);
+}
+}  // namespace obj_loader
 }  // namespace tango_gl
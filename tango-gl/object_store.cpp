@@ -0,0 +1,264 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "tango-gl/object_store.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "tango-gl/cpu_features.h"
+
+namespace {
+// Half extent of the boxes of meshes without bounds. Finite, so a plane
+// normal component of 0 times it is still 0.
+const float kUnboundedExtent = 1e30f;
+
+void CullBoxesScalar(const glm::vec4 planes[6], const float* const bounds[6],
+                     size_t begin, size_t end, uint8_t* is_visible) {
+  for (size_t i = begin; i < end; ++i) {
+    uint8_t visible = 1;
+    for (int p = 0; p < 6; ++p) {
+      const glm::vec4& plane = planes[p];
+      const float distance = plane.x * bounds[0][i] + plane.y * bounds[1][i] +
+                             plane.z * bounds[2][i] + plane.w;
+      const float radius = std::abs(plane.x) * bounds[3][i] +
+                           std::abs(plane.y) * bounds[4][i] +
+                           std::abs(plane.z) * bounds[5][i];
+      if (distance + radius < 0.0f) {
+        visible = 0;
+        break;
+      }
+    }
+    is_visible[i] = visible;
+  }
+}
+}  // namespace
+
+namespace tango_gl {
+
+const ObjectStore::ObjectId ObjectStore::kNoObject;
+const uint32_t ObjectStore::kNoSlot;
+
+ObjectStore::ObjectStore() : visible_count_(0) {}
+
+uint32_t ObjectStore::AddMesh(const Mesh* prototype) {
+  MeshEntry entry;
+  entry.prototype = prototype;
+  entry.center = glm::vec3(0.0f);
+  entry.half_extents = glm::vec3(kUnboundedExtent);
+  entry.is_culled = false;
+  const std::vector<GLfloat>& vertices = prototype->GetVertices();
+  if (vertices.size() >= 3) {
+    glm::vec3 min(vertices[0], vertices[1], vertices[2]);
+    glm::vec3 max = min;
+    for (size_t i = 3; i + 2 < vertices.size(); i += 3) {
+      const glm::vec3 vertex(vertices[i], vertices[i + 1], vertices[i + 2]);
+      min = glm::min(min, vertex);
+      max = glm::max(max, vertex);
+    }
+    entry.center = 0.5f * (min + max);
+    entry.half_extents = 0.5f * (max - min);
+    entry.is_culled = true;
+  }
+  meshes_.push_back(entry);
+  return static_cast<uint32_t>(meshes_.size() - 1);
+}
+
+ObjectStore::ObjectId ObjectStore::Add(uint32_t mesh,
+                                       const glm::vec3& position,
+                                       const glm::quat& rotation,
+                                       const glm::vec3& scale,
+                                       const glm::vec4& color) {
+  ObjectId id;
+  if (free_ids_.empty()) {
+    id = static_cast<ObjectId>(slots_.size());
+    slots_.push_back(kNoSlot);
+  } else {
+    id = free_ids_.back();
+    free_ids_.pop_back();
+  }
+  const uint32_t slot = static_cast<uint32_t>(object_ids_.size());
+  slots_[id] = slot;
+  object_ids_.push_back(id);
+  mesh_ids_.push_back(mesh);
+  positions_.push_back(position);
+  rotations_.push_back(rotation);
+  scales_.push_back(scale);
+  colors_.push_back(color);
+  world_matrices_.push_back(glm::mat4(1.0f));
+  is_moved_.push_back(0);
+  MarkMoved(slot);
+  ResizeBounds();
+  return id;
+}
+
+void ObjectStore::Remove(ObjectId id) {
+  if (!Contains(id)) {
+    return;
+  }
+  const uint32_t slot = slots_[id];
+  const uint32_t last = static_cast<uint32_t>(object_ids_.size() - 1);
+  if (slot != last) {
+    // Move the last object into the freed slot.
+    object_ids_[slot] = object_ids_[last];
+    mesh_ids_[slot] = mesh_ids_[last];
+    positions_[slot] = positions_[last];
+    rotations_[slot] = rotations_[last];
+    scales_[slot] = scales_[last];
+    colors_[slot] = colors_[last];
+    world_matrices_[slot] = world_matrices_[last];
+    for (int k = 0; k < 6; ++k) {
+      bounds_[k][slot] = bounds_[k][last];
+    }
+    slots_[object_ids_[slot]] = slot;
+    if (is_moved_[last]) {
+      MarkMoved(slot);
+    }
+  }
+  object_ids_.pop_back();
+  mesh_ids_.pop_back();
+  positions_.pop_back();
+  rotations_.pop_back();
+  scales_.pop_back();
+  colors_.pop_back();
+  world_matrices_.pop_back();
+  is_moved_.pop_back();
+  ResizeBounds();
+  slots_[id] = kNoSlot;
+  free_ids_.push_back(id);
+}
+
+void ObjectStore::Clear() {
+  slots_.clear();
+  free_ids_.clear();
+  object_ids_.clear();
+  mesh_ids_.clear();
+  positions_.clear();
+  rotations_.clear();
+  scales_.clear();
+  colors_.clear();
+  world_matrices_.clear();
+  is_moved_.clear();
+  moved_slots_.clear();
+  ResizeBounds();
+  for (MeshEntry& mesh : meshes_) {
+    mesh.instances.clear();
+  }
+  visible_count_ = 0;
+}
+
+void ObjectStore::SetPose(ObjectId id, const glm::vec3& position,
+                          const glm::quat& rotation) {
+  const uint32_t slot = slots_[id];
+  positions_[slot] = position;
+  rotations_[slot] = rotation;
+  MarkMoved(slot);
+}
+
+void ObjectStore::SetScale(ObjectId id, const glm::vec3& scale) {
+  const uint32_t slot = slots_[id];
+  scales_[slot] = scale;
+  MarkMoved(slot);
+}
+
+void ObjectStore::SetColor(ObjectId id, const glm::vec4& color) {
+  colors_[slots_[id]] = color;
+}
+
+void ObjectStore::Update(const ViewFrustum& frustum) {
+  const size_t object_count = object_ids_.size();
+  for (uint32_t slot : moved_slots_) {
+    // Slots freed since they were marked are past the end.
+    if (slot >= object_count || !is_moved_[slot]) {
+      continue;
+    }
+    is_moved_[slot] = 0;
+    const glm::mat3 rotation = glm::mat3_cast(rotations_[slot]);
+    glm::mat4& world = world_matrices_[slot];
+    for (int column = 0; column < 3; ++column) {
+      world[column] = glm::vec4(rotation[column] * scales_[slot][column], 0.0f);
+    }
+    world[3] = glm::vec4(positions_[slot], 1.0f);
+
+    const MeshEntry& mesh = meshes_[mesh_ids_[slot]];
+    if (!mesh.is_culled) {
+      for (int axis = 0; axis < 3; ++axis) {
+        bounds_[axis][slot] = positions_[slot][axis];
+        bounds_[3 + axis][slot] = kUnboundedExtent;
+      }
+      continue;
+    }
+    const glm::vec3 center =
+        glm::vec3(world * glm::vec4(mesh.center, 1.0f));
+    for (int axis = 0; axis < 3; ++axis) {
+      bounds_[axis][slot] = center[axis];
+      bounds_[3 + axis][slot] =
+          std::abs(world[0][axis]) * mesh.half_extents.x +
+          std::abs(world[1][axis]) * mesh.half_extents.y +
+          std::abs(world[2][axis]) * mesh.half_extents.z;
+    }
+  }
+  moved_slots_.clear();
+
+  const size_t box_count = bounds_[0].size();
+  const float* const bounds[6] = {bounds_[0].data(), bounds_[1].data(),
+                                  bounds_[2].data(), bounds_[3].data(),
+                                  bounds_[4].data(), bounds_[5].data()};
+  size_t begin = 0;
+#if defined(TANGO_GL_HAS_NEON)
+  if (cpu_features::IsNeonAvailable()) {
+    internal::CullBoxesNeon(frustum.GetPlanes(), bounds, box_count,
+                            is_visible_.data());
+    begin = box_count;
+  }
+#endif
+  CullBoxesScalar(frustum.GetPlanes(), bounds, begin, box_count,
+                  is_visible_.data());
+
+  for (MeshEntry& mesh : meshes_) {
+    mesh.instances.clear();
+  }
+  visible_count_ = 0;
+  for (size_t slot = 0; slot < object_count; ++slot) {
+    if (!is_visible_[slot]) {
+      continue;
+    }
+    std::vector<GLfloat>& instances = meshes_[mesh_ids_[slot]].instances;
+    const GLfloat* matrix = glm::value_ptr(world_matrices_[slot]);
+    instances.insert(instances.end(), matrix, matrix + 16);
+    const GLfloat* color = glm::value_ptr(colors_[slot]);
+    instances.insert(instances.end(), color, color + 4);
+    ++visible_count_;
+  }
+}
+
+void ObjectStore::MarkMoved(uint32_t slot) {
+  if (!is_moved_[slot]) {
+    is_moved_[slot] = 1;
+    moved_slots_.push_back(slot);
+  }
+}
+
+void ObjectStore::ResizeBounds() {
+  const size_t box_count = (object_ids_.size() + 3) & ~static_cast<size_t>(3);
+  for (int k = 0; k < 6; ++k) {
+    bounds_[k].resize(box_count, 0.0f);
+  }
+  is_visible_.resize(box_count, 0);
+}
+
+}  // namespace tango_gl
@@ -0,0 +1,73 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// This file is only compiled with NEON enabled (the ".neon" suffix in
+// Android.mk), the kernel is selected at runtime by object_store.cpp.
+
+#include <arm_neon.h>
+#include <string.h>
+
+#include "tango-gl/object_store.h"
+
+namespace tango_gl {
+namespace internal {
+
+void CullBoxesNeon(const glm::vec4 planes[6], const float* const bounds[6],
+                   size_t box_count, uint8_t* is_visible) {
+  float32x4_t normal_x[6];
+  float32x4_t normal_y[6];
+  float32x4_t normal_z[6];
+  float32x4_t distance[6];
+  for (int p = 0; p < 6; ++p) {
+    normal_x[p] = vdupq_n_f32(planes[p].x);
+    normal_y[p] = vdupq_n_f32(planes[p].y);
+    normal_z[p] = vdupq_n_f32(planes[p].z);
+    distance[p] = vdupq_n_f32(planes[p].w);
+  }
+  const float32x4_t zero = vdupq_n_f32(0.0f);
+  const uint8x8_t one = vdup_n_u8(1);
+
+  for (size_t i = 0; i < box_count; i += 4) {
+    const float32x4_t center_x = vld1q_f32(bounds[0] + i);
+    const float32x4_t center_y = vld1q_f32(bounds[1] + i);
+    const float32x4_t center_z = vld1q_f32(bounds[2] + i);
+    const float32x4_t extent_x = vld1q_f32(bounds[3] + i);
+    const float32x4_t extent_y = vld1q_f32(bounds[4] + i);
+    const float32x4_t extent_z = vld1q_f32(bounds[5] + i);
+    uint32x4_t visible = vdupq_n_u32(~0u);
+    for (int p = 0; p < 6; ++p) {
+      float32x4_t d = vmlaq_f32(distance[p], normal_x[p], center_x);
+      d = vmlaq_f32(d, normal_y[p], center_y);
+      d = vmlaq_f32(d, normal_z[p], center_z);
+      // The box is outside when even its corner farthest along the normal
+      // is behind the plane.
+      d = vmlaq_f32(d, vabsq_f32(normal_x[p]), extent_x);
+      d = vmlaq_f32(d, vabsq_f32(normal_y[p]), extent_y);
+      d = vmlaq_f32(d, vabsq_f32(normal_z[p]), extent_z);
+      visible = vandq_u32(visible, vcgeq_f32(d, zero));
+    }
+    // All ones lanes to bytes of 1.
+    const uint16x4_t narrow = vmovn_u32(visible);
+    const uint8x8_t bytes =
+        vand_u8(vmovn_u16(vcombine_u16(narrow, narrow)), one);
+    const uint32_t packed = vget_lane_u32(vreinterpret_u32_u8(bytes), 0);
+    memcpy(is_visible + i, &packed, sizeof(packed));
+  }
+}
+
+}  // namespace internal
+}  // namespace tango_gl
@@ -0,0 +1,179 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "tango-gl/occlusion_culler.h"
+#include "tango-gl/point_projection.h"
+#include "tango-gl/simd_math.h"
+
+namespace {
+const float kEmptyCell = std::numeric_limits<float>::infinity();
+
+// Boxes reaching closer than this to the eye plane, in meters, have no
+// bounded screen rectangle and are never culled.
+const float kMinBoxDepth = 1e-3f;
+
+inline int ToCell(float ndc, int size) {
+  const int cell = static_cast<int>(std::floor((ndc * 0.5f + 0.5f) * size));
+  return std::min(std::max(cell, 0), size - 1);
+}
+}  // namespace
+
+namespace tango_gl {
+
+OcclusionCuller::OcclusionCuller() {}
+
+void OcclusionCuller::Build(const float* points, size_t point_count,
+                            const glm::mat4& view_T_points,
+                            const glm::mat4& projection_mat) {
+  const int width = std::max(options_.width, 1);
+  const int height = std::max(options_.height, 1);
+
+  // The render camera as pinhole intrinsics of the finest level, looking
+  // down +z as ProjectPoints() expects, with rows counted from the bottom
+  // like the normalized device coordinates.
+  projection::CameraIntrinsics intrinsics;
+  intrinsics.width = width;
+  intrinsics.height = height;
+  intrinsics.fx = projection_mat[0][0] * width * 0.5f;
+  intrinsics.fy = projection_mat[1][1] * height * 0.5f;
+  intrinsics.cx = (1.0f - projection_mat[2][0]) * width * 0.5f;
+  intrinsics.cy = (1.0f - projection_mat[2][1]) * height * 0.5f;
+  const glm::mat4 flip_z(glm::vec4(1.0f, 0.0f, 0.0f, 0.0f),
+                         glm::vec4(0.0f, 1.0f, 0.0f, 0.0f),
+                         glm::vec4(0.0f, 0.0f, -1.0f, 0.0f),
+                         glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+  const glm::mat4 camera_T_points = simd_math::Multiply(flip_z, view_T_points);
+
+  pixels_.resize(point_count);
+  point_depths_.resize(point_count);
+  projection::ProjectPoints(points, point_count, camera_T_points, intrinsics,
+                            pixels_.data(), point_depths_.data());
+
+  // Finest level: the farthest point of each cell.
+  const size_t cell_count = static_cast<size_t>(width) * height;
+  levels_.resize(1);
+  Level& finest = levels_[0];
+  finest.width = width;
+  finest.height = height;
+  finest.depths.assign(cell_count, 0.0f);
+  cell_counts_.assign(cell_count, 0);
+  for (size_t i = 0; i < point_count; ++i) {
+    if (pixels_[i] == projection::kInvalidPixel) {
+      continue;
+    }
+    const size_t cell =
+        static_cast<size_t>(projection::PixelY(pixels_[i])) * width +
+        projection::PixelX(pixels_[i]);
+    finest.depths[cell] = std::max(finest.depths[cell], point_depths_[i]);
+    if (cell_counts_[cell] < std::numeric_limits<uint16_t>::max()) {
+      ++cell_counts_[cell];
+    }
+  }
+  for (size_t cell = 0; cell < cell_count; ++cell) {
+    if (cell_counts_[cell] < options_.min_cell_points ||
+        cell_counts_[cell] == 0) {
+      finest.depths[cell] = kEmptyCell;
+    }
+  }
+
+  // Coarser levels: the farthest of the 2x2 cells below, down to one cell.
+  while (levels_.back().width > 1 || levels_.back().height > 1) {
+    const Level& fine = levels_.back();
+    Level coarse;
+    coarse.width = (fine.width + 1) / 2;
+    coarse.height = (fine.height + 1) / 2;
+    coarse.depths.resize(static_cast<size_t>(coarse.width) * coarse.height);
+    for (int y = 0; y < coarse.height; ++y) {
+      const int y0 = y * 2;
+      const int y1 = std::min(y0 + 1, fine.height - 1);
+      for (int x = 0; x < coarse.width; ++x) {
+        const int x0 = x * 2;
+        const int x1 = std::min(x0 + 1, fine.width - 1);
+        const float* row0 = &fine.depths[static_cast<size_t>(y0) * fine.width];
+        const float* row1 = &fine.depths[static_cast<size_t>(y1) * fine.width];
+        coarse.depths[static_cast<size_t>(y) * coarse.width + x] =
+            std::max(std::max(row0[x0], row0[x1]),
+                     std::max(row1[x0], row1[x1]));
+      }
+    }
+    levels_.push_back(std::move(coarse));
+  }
+}
+
+void OcclusionCuller::Clear() { levels_.clear(); }
+
+bool OcclusionCuller::IsBoxOccluded(const glm::mat4& clip_T_world,
+                                    const glm::vec3& center,
+                                    const glm::vec3& half_extents) const {
+  if (levels_.empty()) {
+    return false;
+  }
+  glm::vec4 corners[8];
+  simd_math::TransformBoxCorners(clip_T_world, center, half_extents, corners);
+
+  // With a perspective projection w is the depth in front of the camera.
+  float nearest_depth = corners[0].w;
+  for (int i = 1; i < 8; ++i) {
+    nearest_depth = std::min(nearest_depth, corners[i].w);
+  }
+  if (nearest_depth < kMinBoxDepth) {
+    return false;
+  }
+  glm::vec2 ndc_min(std::numeric_limits<float>::max());
+  glm::vec2 ndc_max(-std::numeric_limits<float>::max());
+  for (int i = 0; i < 8; ++i) {
+    const glm::vec2 ndc = glm::vec2(corners[i]) / corners[i].w;
+    ndc_min = glm::min(ndc_min, ndc);
+    ndc_max = glm::max(ndc_max, ndc);
+  }
+  if (ndc_max.x < -1.0f || ndc_min.x > 1.0f || ndc_max.y < -1.0f ||
+      ndc_min.y > 1.0f) {
+    return false;
+  }
+
+  // The finest level at which the rectangle covers at most 2x2 cells.
+  const Level& finest = levels_[0];
+  int x0 = ToCell(ndc_min.x, finest.width);
+  int x1 = ToCell(ndc_max.x, finest.width);
+  int y0 = ToCell(ndc_min.y, finest.height);
+  int y1 = ToCell(ndc_max.y, finest.height);
+  size_t level = 0;
+  while (level + 1 < levels_.size() && (x1 - x0 > 1 || y1 - y0 > 1)) {
+    x0 >>= 1;
+    x1 >>= 1;
+    y0 >>= 1;
+    y1 >>= 1;
+    ++level;
+  }
+
+  const Level& coarse = levels_[level];
+  float occluder_depth = 0.0f;
+  for (int y = y0; y <= y1; ++y) {
+    for (int x = x0; x <= x1; ++x) {
+      occluder_depth = std::max(
+          occluder_depth,
+          coarse.depths[static_cast<size_t>(y) * coarse.width + x]);
+    }
+  }
+  return nearest_depth > occluder_depth + options_.depth_bias;
+}
+
+}  // namespace tango_gl
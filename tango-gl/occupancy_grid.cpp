@@ -0,0 +1,502 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "tango-gl/occupancy_grid.h"
+
+#include <stdio.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "tango-gl/cpu_features.h"
+
+namespace {
+const uint32_t kFileMagic = 0x474f4754;  // "TGOG" in little endian.
+const uint32_t kFileVersion = 1;
+
+struct FileHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t base_frame;
+  float cell_size;
+  uint32_t tile_size;
+  uint32_t tile_count;
+};
+
+struct FileTile {
+  int32_t x;
+  int32_t y;
+};
+
+const float kTwoPi = 6.28318530718f;
+
+// Cells within this many cell sizes of an obstacle range are hit. Cell
+// centers are up to sqrt(2) cells apart along a bearing, so at least one is
+// hit whatever the direction.
+const float kHitHalfWidth = 0.75f;
+
+inline size_t HashKey(uint64_t key) {
+  key *= 0x9E3779B97F4A7C15ull;
+  return static_cast<size_t>(key ^ (key >> 32));
+}
+
+inline uint64_t TileKey(int32_t x, int32_t y) {
+  return static_cast<uint64_t>(static_cast<uint32_t>(x)) |
+         (static_cast<uint64_t>(static_cast<uint32_t>(y)) << 32);
+}
+
+inline int32_t FloorToInt(float value) {
+  return static_cast<int32_t>(std::floor(value));
+}
+
+// Division rounding toward negative infinity, for cell to tile coordinates.
+inline int32_t FloorDivide(int32_t value, int32_t divisor) {
+  return value >= 0 ? value / divisor : -((-value + divisor - 1) / divisor);
+}
+
+// Update cells [begin, end). Also the tail of the NEON kernel.
+void UpdateCellsScalar(const float* ranges, const float* hit_ranges,
+                       const float* free_ranges, size_t begin, size_t end,
+                       float hit_half_width, float log_odds_hit,
+                       float log_odds_free, float min_log_odds,
+                       float max_log_odds, float* log_odds) {
+  for (size_t i = begin; i < end; ++i) {
+    float delta;
+    if (std::abs(ranges[i] - hit_ranges[i]) <= hit_half_width) {
+      delta = log_odds_hit;
+    } else if (ranges[i] < free_ranges[i]) {
+      delta = log_odds_free;
+    } else {
+      continue;
+    }
+    log_odds[i] =
+        std::min(std::max(log_odds[i] + delta, min_log_odds), max_log_odds);
+  }
+}
+}  // namespace
+
+namespace tango_gl {
+
+const int OccupancyGrid::kTileSize;
+const int OccupancyGrid::kCellsPerTile;
+const int OccupancyGrid::kLevelCount;
+
+namespace internal {
+void UpdateCells(const float* ranges, const float* hit_ranges,
+                 const float* free_ranges, size_t count, float hit_half_width,
+                 float log_odds_hit, float log_odds_free, float min_log_odds,
+                 float max_log_odds, float* log_odds) {
+  size_t begin = 0;
+#if defined(TANGO_GL_HAS_NEON)
+  if (cpu_features::IsNeonAvailable()) {
+    begin = count & ~static_cast<size_t>(3);
+    UpdateCellsNeon(ranges, hit_ranges, free_ranges, count, hit_half_width,
+                    log_odds_hit, log_odds_free, min_log_odds, max_log_odds,
+                    log_odds);
+  }
+#endif
+  UpdateCellsScalar(ranges, hit_ranges, free_ranges, begin, count,
+                    hit_half_width, log_odds_hit, log_odds_free, min_log_odds,
+                    max_log_odds, log_odds);
+}
+}  // namespace internal
+
+OccupancyGrid::OccupancyGrid(const Options& options)
+    : options_(options),
+      tiles_(std::max<size_t>(1, options.max_tile_count)),
+      tile_count_(0),
+      revision_(0),
+      has_logged_full_(false),
+      camera_(0.0f),
+      scan_min_(0.0f),
+      scan_max_(0.0f),
+      cell_ranges_(kCellsPerTile),
+      cell_hit_ranges_(kCellsPerTile),
+      cell_free_ranges_(kCellsPerTile) {
+  size_t table_size = 1;
+  while (table_size < tiles_.size() * 2) {
+    table_size <<= 1;
+  }
+  table_.assign(table_size, -1);
+  table_mask_ = table_size - 1;
+  const int bin_count = std::max(
+      1, static_cast<int>(std::ceil(360.0f / options_.bearing_resolution)));
+  hit_ranges_.resize(bin_count);
+  free_ranges_.resize(bin_count);
+}
+
+OccupancyGrid::~OccupancyGrid() {}
+
+void OccupancyGrid::Clear() {
+  std::fill(table_.begin(), table_.end(), -1);
+  tile_count_ = 0;
+  has_logged_full_ = false;
+}
+
+size_t OccupancyGrid::Integrate(const float* xyz, size_t point_count,
+                                const glm::mat4& map_T_depth) {
+  ++revision_;
+  BuildScan(xyz, point_count, map_T_depth);
+  frame_tiles_.clear();
+  if (!(scan_min_.x <= scan_max_.x)) {
+    return 0;
+  }
+
+  const float inverse_tile_size = 1.0f / (options_.cell_size * kTileSize);
+  const int32_t min_x = FloorToInt(scan_min_.x * inverse_tile_size);
+  const int32_t min_y = FloorToInt(scan_min_.y * inverse_tile_size);
+  const int32_t max_x = FloorToInt(scan_max_.x * inverse_tile_size);
+  const int32_t max_y = FloorToInt(scan_max_.y * inverse_tile_size);
+  for (int32_t y = min_y; y <= max_y; ++y) {
+    for (int32_t x = min_x; x <= max_x; ++x) {
+      const int32_t index = AcquireTile(x, y);
+      if (index >= 0) {
+        tiles_[index].revision = revision_;
+        frame_tiles_.push_back(index);
+      }
+    }
+  }
+  for (int32_t index : frame_tiles_) {
+    IntegrateTile(index);
+    BuildCoarseLevels(&tiles_[index]);
+  }
+  return frame_tiles_.size();
+}
+
+int32_t OccupancyGrid::FindTile(int32_t x, int32_t y) const {
+  size_t slot = HashKey(TileKey(x, y)) & table_mask_;
+  while (table_[slot] >= 0) {
+    const Tile& tile = tiles_[table_[slot]];
+    if (tile.x == x && tile.y == y) {
+      return table_[slot];
+    }
+    slot = (slot + 1) & table_mask_;
+  }
+  return -1;
+}
+
+int32_t OccupancyGrid::AcquireTile(int32_t x, int32_t y) {
+  size_t slot = HashKey(TileKey(x, y)) & table_mask_;
+  while (table_[slot] >= 0) {
+    const Tile& tile = tiles_[table_[slot]];
+    if (tile.x == x && tile.y == y) {
+      return table_[slot];
+    }
+    slot = (slot + 1) & table_mask_;
+  }
+
+  if (tile_count_ == tiles_.size()) {
+    if (!has_logged_full_) {
+      LOGE("OccupancyGrid: all %zu tiles are in use.", tiles_.size());
+      has_logged_full_ = true;
+    }
+    return -1;
+  }
+  const int32_t index = static_cast<int32_t>(tile_count_++);
+  Tile& tile = tiles_[index];
+  tile.x = x;
+  tile.y = y;
+  tile.revision = 0;
+  std::fill(tile.log_odds, tile.log_odds + kCellsPerTile, 0.0f);
+  std::fill(tile.coarse_log_odds,
+            tile.coarse_log_odds + kCellsPerTile / 4 + kCellsPerTile / 16,
+            0.0f);
+  table_[slot] = index;
+  return index;
+}
+
+void OccupancyGrid::BuildScan(const float* xyz, size_t point_count,
+                              const glm::mat4& map_T_depth) {
+  const float infinity = std::numeric_limits<float>::infinity();
+  std::fill(hit_ranges_.begin(), hit_ranges_.end(), infinity);
+  std::fill(free_ranges_.begin(), free_ranges_.end(), 0.0f);
+  camera_ = glm::vec2(map_T_depth[3]);
+  scan_min_ = glm::vec2(infinity);
+  scan_max_ = glm::vec2(-infinity);
+
+  const glm::mat3 rotation(map_T_depth);
+  const glm::vec3 translation(map_T_depth[3]);
+  const float min_height = options_.floor_height + options_.min_obstacle_height;
+  const float max_height = options_.floor_height + options_.max_obstacle_height;
+  const float max_range_squared = options_.max_range * options_.max_range;
+  const int bin_count = static_cast<int>(hit_ranges_.size());
+  const float bins_per_radian = bin_count / kTwoPi;
+  bool has_point = false;
+  for (size_t i = 0; i < point_count; ++i) {
+    const float depth = xyz[i * 3 + 2];
+    if (!(depth > 0.0f)) {
+      continue;
+    }
+    const glm::vec3 point =
+        rotation * glm::vec3(xyz[i * 3], xyz[i * 3 + 1], depth) + translation;
+    const glm::vec2 offset = glm::vec2(point) - camera_;
+    const float range_squared = glm::dot(offset, offset);
+    if (point.z > max_height || range_squared > max_range_squared ||
+        range_squared < 1e-6f) {
+      continue;
+    }
+    const float range = std::sqrt(range_squared);
+    const int bin = std::min(
+        bin_count - 1,
+        static_cast<int>((std::atan2(offset.y, offset.x) + kTwoPi * 0.5f) *
+                         bins_per_radian));
+    if (point.z >= min_height) {
+      hit_ranges_[bin] = std::min(hit_ranges_[bin], range);
+    }
+    free_ranges_[bin] = std::max(free_ranges_[bin], range);
+    scan_min_ = glm::min(scan_min_, glm::vec2(point));
+    scan_max_ = glm::max(scan_max_, glm::vec2(point));
+    has_point = true;
+  }
+  if (!has_point) {
+    return;
+  }
+  // Space is only known free in front of the nearest obstacle.
+  const float hit_half_width = kHitHalfWidth * options_.cell_size;
+  for (int bin = 0; bin < bin_count; ++bin) {
+    free_ranges_[bin] =
+        std::min(free_ranges_[bin], hit_ranges_[bin] - hit_half_width);
+  }
+  scan_min_ = glm::min(scan_min_, camera_) - glm::vec2(options_.cell_size);
+  scan_max_ = glm::max(scan_max_, camera_) + glm::vec2(options_.cell_size);
+}
+
+void OccupancyGrid::IntegrateTile(int32_t index) {
+  Tile& tile = tiles_[index];
+  const float cell_size = options_.cell_size;
+  const glm::vec2 origin =
+      glm::vec2(tile.x, tile.y) * (cell_size * kTileSize) +
+      glm::vec2(0.5f * cell_size) - camera_;
+  const int bin_count = static_cast<int>(hit_ranges_.size());
+  const float bins_per_radian = bin_count / kTwoPi;
+  const float infinity = std::numeric_limits<float>::infinity();
+
+  int i = 0;
+  for (int y = 0; y < kTileSize; ++y) {
+    const float offset_y = origin.y + y * cell_size;
+    for (int x = 0; x < kTileSize; ++x, ++i) {
+      const float offset_x = origin.x + x * cell_size;
+      const float range = std::sqrt(offset_x * offset_x + offset_y * offset_y);
+      cell_ranges_[i] = range;
+      if (range > options_.max_range) {
+        cell_hit_ranges_[i] = infinity;
+        cell_free_ranges_[i] = 0.0f;
+        continue;
+      }
+      const int bin = std::min(
+          bin_count - 1,
+          static_cast<int>((std::atan2(offset_y, offset_x) + kTwoPi * 0.5f) *
+                           bins_per_radian));
+      cell_hit_ranges_[i] = hit_ranges_[bin];
+      cell_free_ranges_[i] = free_ranges_[bin];
+    }
+  }
+
+  internal::UpdateCells(cell_ranges_.data(), cell_hit_ranges_.data(),
+                        cell_free_ranges_.data(), kCellsPerTile,
+                        kHitHalfWidth * cell_size, options_.log_odds_hit,
+                        options_.log_odds_free, options_.min_log_odds,
+                        options_.max_log_odds, tile.log_odds);
+}
+
+void OccupancyGrid::BuildCoarseLevels(Tile* tile) {
+  const float* source = tile->log_odds;
+  float* destination = tile->coarse_log_odds;
+  for (int size = kTileSize / 2; size >= kTileSize >> (kLevelCount - 1);
+       size /= 2) {
+    const int source_size = size * 2;
+    for (int y = 0; y < size; ++y) {
+      const float* row = source + y * 2 * source_size;
+      for (int x = 0; x < size; ++x) {
+        destination[y * size + x] =
+            std::max(std::max(row[x * 2], row[x * 2 + 1]),
+                     std::max(row[source_size + x * 2],
+                              row[source_size + x * 2 + 1]));
+      }
+    }
+    source = destination;
+    destination += size * size;
+  }
+}
+
+namespace {
+// Cells of a level of a tile, and the edge of the level in cells.
+const float* GetLevel(const OccupancyGrid::Tile& tile, int level,
+                      int* size) {
+  *size = OccupancyGrid::kTileSize >> level;
+  if (level == 0) {
+    return tile.log_odds;
+  }
+  const float* cells = tile.coarse_log_odds;
+  for (int i = 1; i < level; ++i) {
+    cells += (OccupancyGrid::kTileSize >> i) * (OccupancyGrid::kTileSize >> i);
+  }
+  return cells;
+}
+}  // namespace
+
+float OccupancyGrid::GetLogOdds(float x, float y, int level) const {
+  const float level_cell_size = options_.cell_size * (1 << level);
+  const int32_t cell_x = FloorToInt(x / level_cell_size);
+  const int32_t cell_y = FloorToInt(y / level_cell_size);
+  const int32_t level_tile_size = kTileSize >> level;
+  const int32_t tile_x = FloorDivide(cell_x, level_tile_size);
+  const int32_t tile_y = FloorDivide(cell_y, level_tile_size);
+  const int32_t index = FindTile(tile_x, tile_y);
+  if (index < 0) {
+    return 0.0f;
+  }
+  int size;
+  const float* cells = GetLevel(tiles_[index], level, &size);
+  return cells[(cell_y - tile_y * size) * size + (cell_x - tile_x * size)];
+}
+
+glm::vec4 OccupancyGrid::UpdateTexture(float x, float y, int level,
+                                       StreamingTexture* texture) const {
+  const int width = texture->GetWidth();
+  const int height = texture->GetHeight();
+  if (texture->GetSizeInBytes() != static_cast<size_t>(width) * height * 2) {
+    LOGE("OccupancyGrid: the texture is not GL_LUMINANCE_ALPHA.");
+    return glm::vec4(0.0f);
+  }
+  uint8_t* pixels = texture->BeginUpdate();
+  if (pixels == nullptr) {
+    return glm::vec4(0.0f);
+  }
+
+  const float level_cell_size = options_.cell_size * (1 << level);
+  const int32_t start_x = FloorToInt(x / level_cell_size) - width / 2;
+  const int32_t start_y = FloorToInt(y / level_cell_size) - height / 2;
+  const int32_t level_tile_size = kTileSize >> level;
+  // Luminance 255 at min_log_odds, 128 at 0 and 0 at max_log_odds.
+  const float free_scale = 127.0f / std::max(1e-6f, -options_.min_log_odds);
+  const float occupied_scale = 128.0f / std::max(1e-6f, options_.max_log_odds);
+
+  for (int row = 0; row < height; ++row) {
+    const int32_t cell_y = start_y + row;
+    const int32_t tile_y = FloorDivide(cell_y, level_tile_size);
+    const int32_t local_y = cell_y - tile_y * level_tile_size;
+    uint8_t* pixel = pixels + row * width * 2;
+    int32_t column = 0;
+    while (column < width) {
+      // Fill the run of texels in one tile.
+      const int32_t cell_x = start_x + column;
+      const int32_t tile_x = FloorDivide(cell_x, level_tile_size);
+      const int32_t local_x = cell_x - tile_x * level_tile_size;
+      const int32_t run =
+          std::min(width - column, level_tile_size - local_x);
+      const int32_t index = FindTile(tile_x, tile_y);
+      if (index < 0) {
+        std::fill(pixel, pixel + run * 2, 0);
+      } else {
+        int size;
+        const float* cells =
+            GetLevel(tiles_[index], level, &size) + local_y * size + local_x;
+        for (int32_t i = 0; i < run; ++i) {
+          const float log_odds = cells[i];
+          if (log_odds == 0.0f) {
+            pixel[i * 2] = 0;
+            pixel[i * 2 + 1] = 0;
+            continue;
+          }
+          const float luminance =
+              log_odds < 0.0f ? 128.0f - log_odds * free_scale
+                              : 128.0f - log_odds * occupied_scale;
+          pixel[i * 2] = static_cast<uint8_t>(
+              std::min(std::max(luminance, 0.0f), 255.0f));
+          pixel[i * 2 + 1] = 255;
+        }
+      }
+      pixel += run * 2;
+      column += run;
+    }
+  }
+  texture->EndUpdate();
+  return glm::vec4(start_x * level_cell_size, start_y * level_cell_size,
+                   (start_x + width) * level_cell_size,
+                   (start_y + height) * level_cell_size);
+}
+
+bool OccupancyGrid::Save(const char* path, uint32_t base_frame) const {
+  FILE* file = fopen(path, "wb");
+  if (file == nullptr) {
+    LOGE("OccupancyGrid: could not create %s.", path);
+    return false;
+  }
+  FileHeader header;
+  header.magic = kFileMagic;
+  header.version = kFileVersion;
+  header.base_frame = base_frame;
+  header.cell_size = options_.cell_size;
+  header.tile_size = kTileSize;
+  header.tile_count = static_cast<uint32_t>(tile_count_);
+  bool is_written = fwrite(&header, sizeof(header), 1, file) == 1;
+  for (size_t i = 0; i < tile_count_ && is_written; ++i) {
+    const Tile& tile = tiles_[i];
+    FileTile file_tile;
+    file_tile.x = tile.x;
+    file_tile.y = tile.y;
+    is_written = fwrite(&file_tile, sizeof(file_tile), 1, file) == 1 &&
+                 fwrite(tile.log_odds, sizeof(float), kCellsPerTile, file) ==
+                     static_cast<size_t>(kCellsPerTile);
+  }
+  is_written = fclose(file) == 0 && is_written;
+  if (!is_written) {
+    LOGE("OccupancyGrid: could not write %s.", path);
+  }
+  return is_written;
+}
+
+bool OccupancyGrid::Load(const char* path, uint32_t* base_frame) {
+  Clear();
+  FILE* file = fopen(path, "rb");
+  if (file == nullptr) {
+    LOGE("OccupancyGrid: could not open %s.", path);
+    return false;
+  }
+  FileHeader header;
+  bool is_valid = fread(&header, sizeof(header), 1, file) == 1 &&
+                  header.magic == kFileMagic &&
+                  header.version == kFileVersion &&
+                  header.cell_size == options_.cell_size &&
+                  header.tile_size == static_cast<uint32_t>(kTileSize);
+  for (uint32_t i = 0; is_valid && i < header.tile_count; ++i) {
+    FileTile file_tile;
+    is_valid = fread(&file_tile, sizeof(file_tile), 1, file) == 1 &&
+               FindTile(file_tile.x, file_tile.y) < 0;
+    const int32_t index =
+        is_valid ? AcquireTile(file_tile.x, file_tile.y) : -1;
+    is_valid = index >= 0 &&
+               fread(tiles_[index].log_odds, sizeof(float), kCellsPerTile,
+                     file) == static_cast<size_t>(kCellsPerTile);
+    if (is_valid) {
+      BuildCoarseLevels(&tiles_[index]);
+    }
+  }
+  fclose(file);
+  if (!is_valid) {
+    LOGE("OccupancyGrid: %s is not a grid with %g m cells.", path,
+         options_.cell_size);
+    Clear();
+    return false;
+  }
+  *base_frame = header.base_frame;
+  return true;
+}
+
+}  // namespace tango_gl
@@ -0,0 +1,62 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// This file is only compiled with NEON enabled (the ".neon" suffix in
+// Android.mk), the kernel is selected at runtime by occupancy_grid.cpp.
+
+#include <arm_neon.h>
+
+#include "tango-gl/occupancy_grid.h"
+
+namespace tango_gl {
+namespace internal {
+
+void UpdateCellsNeon(const float* ranges, const float* hit_ranges,
+                     const float* free_ranges, size_t count,
+                     float hit_half_width, float log_odds_hit,
+                     float log_odds_free, float min_log_odds,
+                     float max_log_odds, float* log_odds) {
+  const float32x4_t zero = vdupq_n_f32(0.0f);
+  const float32x4_t half_width = vdupq_n_f32(hit_half_width);
+  const float32x4_t hit = vdupq_n_f32(log_odds_hit);
+  const float32x4_t free = vdupq_n_f32(log_odds_free);
+  const float32x4_t lower = vdupq_n_f32(min_log_odds);
+  const float32x4_t upper = vdupq_n_f32(max_log_odds);
+
+  const size_t vector_count = count & ~static_cast<size_t>(3);
+  for (size_t i = 0; i < vector_count; i += 4) {
+    const float32x4_t range = vld1q_f32(ranges + i);
+    // Same classification as the scalar loop: at the obstacle, in front of
+    // it, or unobserved.
+    const uint32x4_t is_hit =
+        vcleq_f32(vabdq_f32(range, vld1q_f32(hit_ranges + i)), half_width);
+    const uint32x4_t is_free = vcltq_f32(range, vld1q_f32(free_ranges + i));
+    const float32x4_t delta =
+        vbslq_f32(is_hit, hit, vbslq_f32(is_free, free, zero));
+
+    const float32x4_t old_log_odds = vld1q_f32(log_odds + i);
+    const float32x4_t new_log_odds =
+        vminq_f32(vmaxq_f32(vaddq_f32(old_log_odds, delta), lower), upper);
+    // Unobserved cells keep their value bit for bit, 0 stays unknown.
+    vst1q_f32(log_odds + i,
+              vbslq_f32(vorrq_u32(is_hit, is_free), new_log_odds,
+                        old_log_odds));
+  }
+}
+
+}  // namespace internal
+}  // namespace tango_gl
@@ -0,0 +1,102 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include "tango-gl/offscreen_context.h"
+#include "tango-gl/util.h"
+
+namespace tango_gl {
+
+OffscreenContext::OffscreenContext()
+    : display_(EGL_NO_DISPLAY),
+      surface_(EGL_NO_SURFACE),
+      context_(EGL_NO_CONTEXT) {}
+
+OffscreenContext::~OffscreenContext() {
+  if (display_ == EGL_NO_DISPLAY) {
+    return;
+  }
+  eglMakeCurrent(display_, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+  if (context_ != EGL_NO_CONTEXT) {
+    eglDestroyContext(display_, context_);
+  }
+  if (surface_ != EGL_NO_SURFACE) {
+    eglDestroySurface(display_, surface_);
+  }
+  eglTerminate(display_);
+}
+
+bool OffscreenContext::Create(int width, int height) {
+  display_ = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+#if defined(EGL_PLATFORM_SURFACELESS_MESA)
+  if (display_ == EGL_NO_DISPLAY ||
+      !eglInitialize(display_, nullptr, nullptr)) {
+    // Without a window system, e.g. on CI machines, Mesa still renders
+    // offscreen through its surfaceless platform.
+    PFNEGLGETPLATFORMDISPLAYEXTPROC get_platform_display =
+        reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+            eglGetProcAddress("eglGetPlatformDisplayEXT"));
+    display_ = get_platform_display == nullptr
+                   ? EGL_NO_DISPLAY
+                   : get_platform_display(EGL_PLATFORM_SURFACELESS_MESA,
+                                          EGL_DEFAULT_DISPLAY, nullptr);
+  }
+#endif
+  if (display_ == EGL_NO_DISPLAY ||
+      !eglInitialize(display_, nullptr, nullptr)) {
+    LOGE("OffscreenContext: No EGL display.");
+    return false;
+  }
+
+  const EGLint config_attributes[] = {
+      EGL_SURFACE_TYPE, EGL_PBUFFER_BIT, EGL_RENDERABLE_TYPE,
+      EGL_OPENGL_ES2_BIT, EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8,
+      EGL_BLUE_SIZE, 8, EGL_ALPHA_SIZE, 8, EGL_DEPTH_SIZE, 16, EGL_NONE};
+  EGLConfig config;
+  EGLint config_count = 0;
+  if (!eglChooseConfig(display_, config_attributes, &config, 1,
+                       &config_count) ||
+      config_count == 0) {
+    LOGE("OffscreenContext: No pbuffer EGL configuration.");
+    return false;
+  }
+
+  const EGLint surface_attributes[] = {EGL_WIDTH, width, EGL_HEIGHT, height,
+                                       EGL_NONE};
+  surface_ = eglCreatePbufferSurface(display_, config, surface_attributes);
+  const EGLint context_attributes[] = {EGL_CONTEXT_CLIENT_VERSION, 2,
+                                       EGL_NONE};
+  eglBindAPI(EGL_OPENGL_ES_API);
+  context_ =
+      eglCreateContext(display_, config, EGL_NO_CONTEXT, context_attributes);
+  if (surface_ == EGL_NO_SURFACE || context_ == EGL_NO_CONTEXT ||
+      !eglMakeCurrent(display_, surface_, surface_, context_)) {
+    LOGE("OffscreenContext: Could not create the GLES2 context.");
+    return false;
+  }
+  return true;
+}
+
+void OffscreenContext::SwapBuffers() {
+  if (surface_ != EGL_NO_SURFACE) {
+    eglSwapBuffers(display_, surface_);
+  }
+}
+
+}  // namespace tango_gl
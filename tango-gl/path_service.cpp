@@ -0,0 +1,255 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "tango-gl/path_service.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace {
+// Squared distance from a point to a segment.
+float SegmentDistanceSquared(const glm::vec3& point, const glm::vec3& a,
+                             const glm::vec3& b) {
+  const glm::vec3 ab = b - a;
+  const float length_squared = glm::dot(ab, ab);
+  float t = 0.0f;
+  if (length_squared > 0.0f) {
+    t = std::min(std::max(glm::dot(point - a, ab) / length_squared, 0.0f),
+                 1.0f);
+  }
+  const glm::vec3 offset = a + ab * t - point;
+  return glm::dot(offset, offset);
+}
+}  // namespace
+
+namespace tango_gl {
+
+PathService::PathService(const Options& options)
+    : options_(options),
+      active_goal_(-1),
+      use_count_(0),
+      next_revision_(1),
+      band_revision_(0),
+      has_query_(false),
+      query_goal_(0.0f),
+      is_querying_(false),
+      is_stopping_(false) {
+  worker_ = std::thread(&PathService::WorkerLoop, this);
+}
+
+PathService::~PathService() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    is_stopping_ = true;
+  }
+  query_changed_.notify_one();
+  worker_.join();
+}
+
+void PathService::SetGoal(const glm::vec3& goal) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  int index = FindGoal(goal);
+  if (index < 0) {
+    if (goals_.size() < std::max<size_t>(1, options_.max_goal_count)) {
+      goals_.push_back(Goal());
+      index = static_cast<int>(goals_.size()) - 1;
+    } else {
+      index = 0;
+      for (size_t i = 1; i < goals_.size(); ++i) {
+        if (goals_[i].last_use < goals_[index].last_use) {
+          index = static_cast<int>(i);
+        }
+      }
+    }
+    Goal& entry = goals_[index];
+    entry.position = goal;
+    entry.path.clear();
+    entry.revision = 0;
+    entry.last_error = TANGO_SUCCESS;
+    entry.last_query_time = std::chrono::steady_clock::time_point();
+  }
+  goals_[index].last_use = ++use_count_;
+  active_goal_ = index;
+}
+
+void PathService::Clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  goals_.clear();
+  active_goal_ = -1;
+  has_query_ = false;
+}
+
+void PathService::Update(const glm::vec3& device_position) {
+  const std::chrono::steady_clock::time_point now =
+      std::chrono::steady_clock::now();
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (is_querying_ || has_query_ || !NeedsQuery(device_position, now)) {
+      return;
+    }
+    Goal& goal = goals_[active_goal_];
+    goal.last_query_time = now;
+    query_goal_ = goal.position;
+    has_query_ = true;
+  }
+  query_changed_.notify_one();
+}
+
+bool PathService::GetPath(std::vector<glm::vec3>* path,
+                          uint32_t* revision) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (active_goal_ < 0 || goals_[active_goal_].revision == 0) {
+    return false;
+  }
+  *path = goals_[active_goal_].path;
+  *revision = goals_[active_goal_].revision;
+  return true;
+}
+
+bool PathService::UpdateBand(const glm::mat4& world_T_base,
+                             const glm::vec3& up, Band* band) {
+  std::vector<glm::vec3> path;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const uint32_t revision =
+        active_goal_ < 0 ? 0 : goals_[active_goal_].revision;
+    if (revision == band_revision_) {
+      return false;
+    }
+    band_revision_ = revision;
+    if (revision != 0) {
+      path = goals_[active_goal_].path;
+    }
+  }
+  for (glm::vec3& point : path) {
+    point = util::ApplyTransform(world_T_base, point);
+  }
+  if (path.empty()) {
+    band->ClearVertexArray();
+  } else {
+    band->SetVertexArray(path, up);
+  }
+  return true;
+}
+
+TangoErrorType PathService::GetLastError() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return active_goal_ < 0 ? TANGO_SUCCESS : goals_[active_goal_].last_error;
+}
+
+int PathService::FindGoal(const glm::vec3& position) const {
+  for (size_t i = 0; i < goals_.size(); ++i) {
+    if (goals_[i].position == position) {
+      return static_cast<int>(i);
+    }
+  }
+  return -1;
+}
+
+bool PathService::NeedsQuery(
+    const glm::vec3& device_position,
+    std::chrono::steady_clock::time_point now) const {
+  if (active_goal_ < 0) {
+    return false;
+  }
+  const Goal& goal = goals_[active_goal_];
+  if (goal.last_error != TANGO_SUCCESS) {
+    return now - goal.last_query_time >= options_.retry_interval;
+  }
+  if (goal.revision == 0) {
+    return goal.last_query_time == std::chrono::steady_clock::time_point();
+  }
+  const std::vector<glm::vec3>& path = goal.path;
+  // Already at the goal.
+  if (path.empty()) {
+    return false;
+  }
+  float distance_squared = std::numeric_limits<float>::max();
+  if (path.size() == 1) {
+    const glm::vec3 offset = path[0] - device_position;
+    distance_squared = glm::dot(offset, offset);
+  }
+  for (size_t i = 1; i < path.size(); ++i) {
+    distance_squared =
+        std::min(distance_squared,
+                 SegmentDistanceSquared(device_position, path[i - 1], path[i]));
+  }
+  return distance_squared >
+         options_.deviation_threshold * options_.deviation_threshold;
+}
+
+void PathService::WorkerLoop() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    query_changed_.wait(lock, [this] { return has_query_ || is_stopping_; });
+    if (is_stopping_) {
+      return;
+    }
+    const glm::vec3 goal_position = query_goal_;
+    has_query_ = false;
+    is_querying_ = true;
+    lock.unlock();
+
+    std::vector<glm::vec3> path;
+    const TangoErrorType error = Plan(goal_position, &path);
+
+    lock.lock();
+    is_querying_ = false;
+    // The goal may have been dropped or replaced in the meantime.
+    const int index = FindGoal(goal_position);
+    if (index < 0) {
+      continue;
+    }
+    Goal& goal = goals_[index];
+    goal.last_error = error;
+    if (error == TANGO_SUCCESS) {
+      goal.path.swap(path);
+      goal.revision = next_revision_++;
+    } else {
+      goal.last_query_time = std::chrono::steady_clock::now();
+    }
+  }
+}
+
+TangoErrorType PathService::Plan(const glm::vec3& goal,
+                                 std::vector<glm::vec3>* path) {
+  TangoPositionData_Experimental goal_position;
+  for (int i = 0; i < 3; ++i) {
+    goal_position.position[i] = goal[i];
+  }
+  size_t trajectory_size = 0;
+  TangoPositionData_Experimental* trajectory = nullptr;
+  const TangoErrorType error = TangoService_Experimental_getTrajectoryToGoal(
+      goal_position, options_.base_frame, &trajectory_size, &trajectory);
+  if (error == TANGO_SUCCESS) {
+    path->resize(trajectory_size);
+    for (size_t i = 0; i < trajectory_size; ++i) {
+      (*path)[i] = glm::vec3(trajectory[i].position[0],
+                             trajectory[i].position[1],
+                             trajectory[i].position[2]);
+    }
+  } else {
+    LOGE("PathService: planning failed with error %d.", error);
+  }
+  // Only a non empty trajectory was allocated.
+  if (trajectory_size > 0 && trajectory != nullptr) {
+    TangoService_Experimental_freeTrajectory(&trajectory);
+  }
+  return error;
+}
+
+}  // namespace tango_gl
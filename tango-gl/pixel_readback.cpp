@@ -0,0 +1,295 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <string.h>
+
+#include <EGL/egl.h>
+
+#include "tango-gl/memory_tracker.h"
+#include "tango-gl/pixel_readback.h"
+#include "tango-gl/render_state.h"
+
+// GLES3 tokens, the examples are built against the GLES2 headers.
+#ifndef GL_PIXEL_PACK_BUFFER
+#define GL_PIXEL_PACK_BUFFER 0x88EB
+#endif
+#ifndef GL_STREAM_READ
+#define GL_STREAM_READ 0x88E1
+#endif
+#ifndef GL_MAP_READ_BIT
+#define GL_MAP_READ_BIT 0x0001
+#endif
+#ifndef GL_SYNC_GPU_COMMANDS_COMPLETE
+#define GL_SYNC_GPU_COMMANDS_COMPLETE 0x9117
+#endif
+#ifndef GL_SYNC_FLUSH_COMMANDS_BIT
+#define GL_SYNC_FLUSH_COMMANDS_BIT 0x00000001
+#endif
+#ifndef GL_TIMEOUT_EXPIRED
+#define GL_TIMEOUT_EXPIRED 0x911B
+#endif
+
+namespace {
+typedef struct __GLsync* Sync;
+typedef void* (*MapBufferRangeFunc)(GLenum target, GLintptr offset,
+                                    GLsizeiptr length, GLbitfield access);
+typedef GLboolean (*UnmapBufferFunc)(GLenum target);
+typedef Sync (*FenceSyncFunc)(GLenum condition, GLbitfield flags);
+typedef GLenum (*ClientWaitSyncFunc)(Sync sync, GLbitfield flags,
+                                     uint64_t timeout);
+typedef void (*DeleteSyncFunc)(Sync sync);
+
+MapBufferRangeFunc map_buffer_range = nullptr;
+UnmapBufferFunc unmap_buffer = nullptr;
+FenceSyncFunc fence_sync = nullptr;
+ClientWaitSyncFunc client_wait_sync = nullptr;
+DeleteSyncFunc delete_sync = nullptr;
+
+// The GLES3 entry points are resolved at runtime so the examples keep linking
+// against libGLESv2 only and still run on GLES2 devices.
+bool LoadPixelBufferFunctions() {
+  static bool is_loaded = false;
+  if (is_loaded) {
+    return map_buffer_range != nullptr && unmap_buffer != nullptr &&
+           fence_sync != nullptr && client_wait_sync != nullptr &&
+           delete_sync != nullptr;
+  }
+  is_loaded = true;
+
+  const char* version =
+      reinterpret_cast<const char*>(glGetString(GL_VERSION));
+  if (version == nullptr || strncmp(version, "OpenGL ES 3", 11) != 0) {
+    return false;
+  }
+  map_buffer_range = reinterpret_cast<MapBufferRangeFunc>(
+      eglGetProcAddress("glMapBufferRange"));
+  unmap_buffer =
+      reinterpret_cast<UnmapBufferFunc>(eglGetProcAddress("glUnmapBuffer"));
+  fence_sync =
+      reinterpret_cast<FenceSyncFunc>(eglGetProcAddress("glFenceSync"));
+  client_wait_sync = reinterpret_cast<ClientWaitSyncFunc>(
+      eglGetProcAddress("glClientWaitSync"));
+  delete_sync =
+      reinterpret_cast<DeleteSyncFunc>(eglGetProcAddress("glDeleteSync"));
+  if (map_buffer_range == nullptr || unmap_buffer == nullptr ||
+      fence_sync == nullptr || client_wait_sync == nullptr ||
+      delete_sync == nullptr) {
+    LOGE("PixelReadback: GLES3 context without PBO or fence entry points.");
+    return false;
+  }
+  return true;
+}
+}  // namespace
+
+namespace tango_gl {
+
+PixelReadback::PixelReadback()
+    : width_(0),
+      height_(0),
+      size_in_bytes_(0),
+      next_index_(0),
+      pending_count_(0) {
+  memset(slots_, 0, sizeof(slots_));
+}
+
+PixelReadback::~PixelReadback() { Release(); }
+
+void PixelReadback::Allocate(GLsizei width, GLsizei height) {
+  if (size_in_bytes_ != 0 && width == width_ && height == height_) {
+    return;
+  }
+  Release();
+
+  width_ = width;
+  height_ = height;
+  size_in_bytes_ = static_cast<size_t>(width) * height * 4;
+
+  if (LoadPixelBufferFunctions()) {
+    for (Slot& slot : slots_) {
+      glGenBuffers(1, &slot.pixel_buffer);
+      RenderState::BindBuffer(GL_PIXEL_PACK_BUFFER, slot.pixel_buffer);
+      glBufferData(GL_PIXEL_PACK_BUFFER, size_in_bytes_, nullptr,
+                   GL_STREAM_READ);
+      MemoryTracker::Track(MemoryTracker::kBuffer, slot.pixel_buffer,
+                           "PixelReadback", size_in_bytes_);
+    }
+    RenderState::BindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    util::CheckGlError("PixelReadback::Allocate PBO");
+  }
+}
+
+void PixelReadback::Release() {
+  for (Slot& slot : slots_) {
+    if (slot.pixel_buffer != 0) {
+      RenderState::DeleteBuffers(1, &slot.pixel_buffer);
+    }
+    if (slot.fence != nullptr) {
+      delete_sync(slot.fence);
+    }
+    if (slot.texture != 0) {
+      RenderState::DeleteTextures(1, &slot.texture);
+      glDeleteFramebuffers(1, &slot.framebuffer);
+    }
+  }
+  Invalidate();
+}
+
+void PixelReadback::Invalidate() {
+  memset(slots_, 0, sizeof(slots_));
+  width_ = 0;
+  height_ = 0;
+  size_in_bytes_ = 0;
+  next_index_ = 0;
+  pending_count_ = 0;
+  staging_buffer_.clear();
+}
+
+void PixelReadback::Read(double timestamp) {
+  if (size_in_bytes_ == 0) {
+    LOGE("PixelReadback: Read() called before Allocate().");
+    return;
+  }
+  if (pending_count_ == kPixelBufferCount) {
+    DropOldestRead();
+  }
+
+  Slot& slot = slots_[next_index_];
+  if (IsUsingPixelBuffers()) {
+    // With a PBO bound the data pointer is an offset into the buffer.
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    RenderState::BindBuffer(GL_PIXEL_PACK_BUFFER, slot.pixel_buffer);
+    glReadPixels(0, 0, width_, height_, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    RenderState::BindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    slot.fence = fence_sync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    util::CheckGlError("PixelReadback::Read PBO");
+  } else {
+    // A texture copy stays on the GPU, the framebuffer is only read back
+    // when the copy is handed out. A copy can not add channels the
+    // framebuffer lacks.
+    GLint alpha_bits = 0;
+    glGetIntegerv(GL_ALPHA_BITS, &alpha_bits);
+    const GLenum format = alpha_bits > 0 ? GL_RGBA : GL_RGB;
+    if (slot.texture == 0) {
+      glGenTextures(1, &slot.texture);
+      glGenFramebuffers(1, &slot.framebuffer);
+    }
+    RenderState::BindTexture(GL_TEXTURE_2D, slot.texture);
+    if (slot.texture_format != format) {
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+      glTexImage2D(GL_TEXTURE_2D, 0, format, width_, height_, 0, format,
+                   GL_UNSIGNED_BYTE, nullptr);
+      MemoryTracker::Track(
+          MemoryTracker::kTexture, slot.texture, "PixelReadback",
+          MemoryTracker::GetTextureSize(width_, height_, format,
+                                        GL_UNSIGNED_BYTE));
+      slot.texture_format = format;
+    }
+    glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, 0, width_, height_);
+    util::CheckGlError("PixelReadback::Read copy");
+  }
+
+  slot.timestamp = timestamp;
+  next_index_ = (next_index_ + 1) % kPixelBufferCount;
+  ++pending_count_;
+}
+
+int PixelReadback::GetPixels(const PixelsCallback& callback) {
+  int count = 0;
+  while (pending_count_ > 0 && IsOldestReadComplete()) {
+    DeliverOldestRead(callback);
+    ++count;
+  }
+  return count;
+}
+
+bool PixelReadback::GetPixels(double* timestamp,
+                              std::vector<uint8_t>* pixels) {
+  if (pending_count_ == 0 || !IsOldestReadComplete()) {
+    return false;
+  }
+  DeliverOldestRead([this, timestamp, pixels](double read_timestamp,
+                                              const uint8_t* read_pixels) {
+    *timestamp = read_timestamp;
+    pixels->assign(read_pixels, read_pixels + size_in_bytes_);
+  });
+  return true;
+}
+
+bool PixelReadback::IsOldestReadComplete() {
+  if (!IsUsingPixelBuffers()) {
+    // Only copies with kPixelBufferCount - 1 newer copies queued after
+    // them, the younger ones are likely still in flight.
+    return pending_count_ == kPixelBufferCount;
+  }
+  const int index =
+      (next_index_ - pending_count_ + kPixelBufferCount) % kPixelBufferCount;
+  // A zero timeout polls. The flush makes sure the fence reaches the GPU,
+  // it would never signal otherwise.
+  return client_wait_sync(slots_[index].fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+                          0) != GL_TIMEOUT_EXPIRED;
+}
+
+void PixelReadback::DeliverOldestRead(const PixelsCallback& callback) {
+  const int index =
+      (next_index_ - pending_count_ + kPixelBufferCount) % kPixelBufferCount;
+  Slot& slot = slots_[index];
+  --pending_count_;
+
+  if (IsUsingPixelBuffers()) {
+    delete_sync(slot.fence);
+    slot.fence = nullptr;
+    RenderState::BindBuffer(GL_PIXEL_PACK_BUFFER, slot.pixel_buffer);
+    const void* source = map_buffer_range(GL_PIXEL_PACK_BUFFER, 0,
+                                          size_in_bytes_, GL_MAP_READ_BIT);
+    if (source == nullptr) {
+      LOGE("PixelReadback: failed to map the pixel buffer.");
+    } else {
+      callback(slot.timestamp, static_cast<const uint8_t*>(source));
+      unmap_buffer(GL_PIXEL_PACK_BUFFER);
+    }
+    RenderState::BindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    return;
+  }
+
+  GLint framebuffer = 0;
+  glGetIntegerv(GL_FRAMEBUFFER_BINDING, &framebuffer);
+  glBindFramebuffer(GL_FRAMEBUFFER, slot.framebuffer);
+  glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
+                         slot.texture, 0);
+  staging_buffer_.resize(size_in_bytes_);
+  glPixelStorei(GL_PACK_ALIGNMENT, 1);
+  glReadPixels(0, 0, width_, height_, GL_RGBA, GL_UNSIGNED_BYTE,
+               staging_buffer_.data());
+  glPixelStorei(GL_PACK_ALIGNMENT, 4);
+  glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+  util::CheckGlError("PixelReadback::DeliverOldestRead");
+  callback(slot.timestamp, staging_buffer_.data());
+}
+
+void PixelReadback::DropOldestRead() {
+  const int index =
+      (next_index_ - pending_count_ + kPixelBufferCount) % kPixelBufferCount;
+  if (slots_[index].fence != nullptr) {
+    delete_sync(slots_[index].fence);
+    slots_[index].fence = nullptr;
+  }
+  --pending_count_;
+}
+
+}  // namespace tango_gl
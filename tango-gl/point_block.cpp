@@ -0,0 +1,197 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "tango-gl/point_block.h"
+
+#include <cstring>
+
+#include "tango-gl/cpu_features.h"
+
+namespace {
+// Alignment of the arrays, one NEON quad register.
+const size_t kAlignment = 16;
+
+void DeinterleaveXyzScalar(const float* xyz, size_t begin, size_t end,
+                           float* x, float* y, float* z) {
+  for (size_t i = begin; i < end; ++i) {
+    x[i] = xyz[i * 3];
+    y[i] = xyz[i * 3 + 1];
+    z[i] = xyz[i * 3 + 2];
+  }
+}
+
+void InterleaveXyzScalar(const float* x, const float* y, const float* z,
+                         size_t begin, size_t end, float* xyz) {
+  for (size_t i = begin; i < end; ++i) {
+    xyz[i * 3] = x[i];
+    xyz[i * 3 + 1] = y[i];
+    xyz[i * 3 + 2] = z[i];
+  }
+}
+}  // namespace
+
+namespace tango_gl {
+
+const size_t PointBlock::kLaneCount;
+
+PointBlock::PointBlock(int channels)
+    : channels_(channels),
+      point_count_(0),
+      capacity_(0),
+      timestamp_(0.0),
+      x_(nullptr),
+      y_(nullptr),
+      z_(nullptr),
+      confidence_(nullptr),
+      color_(nullptr) {}
+
+void PointBlock::Reserve(size_t point_count) {
+  const size_t capacity = (point_count + kLaneCount - 1) & ~(kLaneCount - 1);
+  if (capacity <= capacity_) {
+    return;
+  }
+  const size_t array_count = 3 + (HasConfidence() ? 1 : 0) +
+                             (HasColor() ? 1 : 0);
+  const size_t array_size = capacity * sizeof(float);
+  std::unique_ptr<uint8_t[]> storage(
+      new uint8_t[array_count * array_size + kAlignment - 1]);
+  uint8_t* array = reinterpret_cast<uint8_t*>(
+      (reinterpret_cast<uintptr_t>(storage.get()) + kAlignment - 1) &
+      ~static_cast<uintptr_t>(kAlignment - 1));
+
+  // Points already held, with their padding.
+  const size_t kept_size = GetPaddedPointCount() * sizeof(float);
+  float** floats[] = {&x_, &y_, &z_, &confidence_};
+  for (int i = 0; i < 4; ++i) {
+    if (i == 3 && !HasConfidence()) {
+      break;
+    }
+    if (kept_size > 0) {
+      memcpy(array, *floats[i], kept_size);
+    }
+    *floats[i] = reinterpret_cast<float*>(array);
+    array += array_size;
+  }
+  if (HasColor()) {
+    if (kept_size > 0) {
+      memcpy(array, color_, kept_size);
+    }
+    color_ = reinterpret_cast<uint32_t*>(array);
+  }
+  storage_.swap(storage);
+  capacity_ = capacity;
+}
+
+void PointBlock::Resize(size_t point_count) {
+  Reserve(point_count);
+  // Points up to the padded count are zero padding already.
+  const size_t begin = GetPaddedPointCount();
+  if (point_count > begin) {
+    const size_t size = (point_count - begin) * sizeof(float);
+    memset(x_ + begin, 0, size);
+    memset(y_ + begin, 0, size);
+    memset(z_ + begin, 0, size);
+    if (HasConfidence()) {
+      memset(confidence_ + begin, 0, size);
+    }
+    if (HasColor()) {
+      memset(color_ + begin, 0, size);
+    }
+  }
+  point_count_ = point_count;
+  ClearPadding();
+}
+
+void PointBlock::CopyFromXyz(const float* xyz, size_t point_count) {
+  Reserve(point_count);
+  point_count_ = point_count;
+  size_t begin = 0;
+#if defined(TANGO_GL_HAS_NEON)
+  if (cpu_features::IsNeonAvailable()) {
+    begin = point_count & ~static_cast<size_t>(3);
+    internal::DeinterleaveXyzNeon(xyz, point_count, x_, y_, z_);
+  }
+#endif
+  DeinterleaveXyzScalar(xyz, begin, point_count, x_, y_, z_);
+  const size_t size = GetPaddedPointCount() * sizeof(float);
+  if (HasConfidence() && size > 0) {
+    memset(confidence_, 0, size);
+  }
+  if (HasColor() && size > 0) {
+    memset(color_, 0, size);
+  }
+  ClearPadding();
+}
+
+void PointBlock::CopyFromXyzij(const TangoXYZij& xyz_ij) {
+  const size_t point_count =
+      xyz_ij.xyz_count > 0 ? static_cast<size_t>(xyz_ij.xyz_count) : 0;
+  CopyFromXyz(point_count > 0 ? xyz_ij.xyz[0] : nullptr, point_count);
+  timestamp_ = xyz_ij.timestamp;
+}
+
+void PointBlock::CopyToXyz(float* xyz) const {
+  size_t begin = 0;
+#if defined(TANGO_GL_HAS_NEON)
+  if (cpu_features::IsNeonAvailable()) {
+    begin = point_count_ & ~static_cast<size_t>(3);
+    internal::InterleaveXyzNeon(x_, y_, z_, point_count_, xyz);
+  }
+#endif
+  InterleaveXyzScalar(x_, y_, z_, begin, point_count_, xyz);
+}
+
+void PointBlock::Transform(const glm::mat4& matrix) {
+  const size_t padded_count = GetPaddedPointCount();
+#if defined(TANGO_GL_HAS_NEON)
+  if (cpu_features::IsNeonAvailable()) {
+    internal::TransformPointsNeon(matrix, padded_count, x_, y_, z_);
+    ClearPadding();
+    return;
+  }
+#endif
+  // Separate arrays and no tail, compilers vectorize this loop as well.
+  for (size_t i = 0; i < padded_count; ++i) {
+    const float x = x_[i];
+    const float y = y_[i];
+    const float z = z_[i];
+    x_[i] = matrix[0][0] * x + matrix[1][0] * y + matrix[2][0] * z +
+            matrix[3][0];
+    y_[i] = matrix[0][1] * x + matrix[1][1] * y + matrix[2][1] * z +
+            matrix[3][1];
+    z_[i] = matrix[0][2] * x + matrix[1][2] * y + matrix[2][2] * z +
+            matrix[3][2];
+  }
+  ClearPadding();
+}
+
+void PointBlock::ClearPadding() {
+  const size_t end = GetPaddedPointCount();
+  for (size_t i = point_count_; i < end; ++i) {
+    x_[i] = 0.0f;
+    y_[i] = 0.0f;
+    z_[i] = 0.0f;
+    if (HasConfidence()) {
+      confidence_[i] = 0.0f;
+    }
+    if (HasColor()) {
+      color_[i] = 0;
+    }
+  }
+}
+
+}  // namespace tango_gl
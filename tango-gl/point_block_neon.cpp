@@ -0,0 +1,88 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// This file is only compiled with NEON enabled (the ".neon" suffix in
+// Android.mk), the kernels are selected at runtime by point_block.cpp.
+
+#include <arm_neon.h>
+
+#include "glm/gtc/type_ptr.hpp"
+#include "tango-gl/point_block.h"
+
+namespace tango_gl {
+namespace internal {
+
+void DeinterleaveXyzNeon(const float* xyz, size_t point_count, float* x,
+                         float* y, float* z) {
+  const size_t count = point_count & ~static_cast<size_t>(3);
+  for (size_t i = 0; i < count; i += 4) {
+    const float32x4x3_t points = vld3q_f32(xyz + i * 3);
+    vst1q_f32(x + i, points.val[0]);
+    vst1q_f32(y + i, points.val[1]);
+    vst1q_f32(z + i, points.val[2]);
+  }
+}
+
+void InterleaveXyzNeon(const float* x, const float* y, const float* z,
+                       size_t point_count, float* xyz) {
+  const size_t count = point_count & ~static_cast<size_t>(3);
+  for (size_t i = 0; i < count; i += 4) {
+    float32x4x3_t points;
+    points.val[0] = vld1q_f32(x + i);
+    points.val[1] = vld1q_f32(y + i);
+    points.val[2] = vld1q_f32(z + i);
+    vst3q_f32(xyz + i * 3, points);
+  }
+}
+
+void TransformPointsNeon(const glm::mat4& matrix, size_t point_count,
+                         float* x, float* y, float* z) {
+  // glm matrices are column major, m[column * 4 + row].
+  const float* m = glm::value_ptr(matrix);
+  const float32x4_t m00 = vdupq_n_f32(m[0]);
+  const float32x4_t m10 = vdupq_n_f32(m[1]);
+  const float32x4_t m20 = vdupq_n_f32(m[2]);
+  const float32x4_t m01 = vdupq_n_f32(m[4]);
+  const float32x4_t m11 = vdupq_n_f32(m[5]);
+  const float32x4_t m21 = vdupq_n_f32(m[6]);
+  const float32x4_t m02 = vdupq_n_f32(m[8]);
+  const float32x4_t m12 = vdupq_n_f32(m[9]);
+  const float32x4_t m22 = vdupq_n_f32(m[10]);
+  const float32x4_t m03 = vdupq_n_f32(m[12]);
+  const float32x4_t m13 = vdupq_n_f32(m[13]);
+  const float32x4_t m23 = vdupq_n_f32(m[14]);
+  for (size_t i = 0; i < point_count; i += 4) {
+    const float32x4_t px = vld1q_f32(x + i);
+    const float32x4_t py = vld1q_f32(y + i);
+    const float32x4_t pz = vld1q_f32(z + i);
+    float32x4_t tx = vmlaq_f32(m03, m00, px);
+    tx = vmlaq_f32(tx, m01, py);
+    tx = vmlaq_f32(tx, m02, pz);
+    float32x4_t ty = vmlaq_f32(m13, m10, px);
+    ty = vmlaq_f32(ty, m11, py);
+    ty = vmlaq_f32(ty, m12, pz);
+    float32x4_t tz = vmlaq_f32(m23, m20, px);
+    tz = vmlaq_f32(tz, m21, py);
+    tz = vmlaq_f32(tz, m22, pz);
+    vst1q_f32(x + i, tx);
+    vst1q_f32(y + i, ty);
+    vst1q_f32(z + i, tz);
+  }
+}
+
+}  // namespace internal
+}  // namespace tango_gl
@@ -0,0 +1,103 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tango-gl/counters.h"
+#include "tango-gl/memory_tracker.h"
+#include "tango-gl/point_cloud_buffer.h"
+#include "tango-gl/point_colorizer.h"
+#include "tango-gl/render_state.h"
+
+namespace tango_gl {
+
+PointCloudBuffer::PointCloudBuffer()
+    : buffer_id_(0),
+      capacity_(0),
+      point_count_(0),
+      timestamp_(0.0),
+      has_frame_(false) {}
+
+PointCloudBuffer::~PointCloudBuffer() { Release(); }
+
+bool PointCloudBuffer::Update(double timestamp, const float* points,
+                              size_t point_count) {
+  return Upload(timestamp, points, sizeof(GLfloat) * 3 * point_count,
+                point_count);
+}
+
+bool PointCloudBuffer::Update(double timestamp, const ColoredPoint* points,
+                              size_t point_count) {
+  return Upload(timestamp, points, sizeof(ColoredPoint) * point_count,
+                point_count);
+}
+
+bool PointCloudBuffer::Update(double timestamp,
+                              const QuantizedColoredPoint* points,
+                              size_t point_count) {
+  return Upload(timestamp, points, sizeof(QuantizedColoredPoint) * point_count,
+                point_count);
+}
+
+bool PointCloudBuffer::Upload(double timestamp, const void* data, size_t size,
+                              size_t point_count) {
+  if (has_frame_ && buffer_id_ != 0 && timestamp == timestamp_) {
+    return false;
+  }
+
+  bool is_resized = false;
+  if (buffer_id_ == 0) {
+    glGenBuffers(1, &buffer_id_);
+    is_resized = true;
+  }
+  if (size > capacity_) {
+    capacity_ = size;
+    is_resized = true;
+  }
+
+  RenderState::BindBuffer(GL_ARRAY_BUFFER, buffer_id_);
+  // Orphan the storage still in use by previous draws.
+  glBufferData(GL_ARRAY_BUFFER, capacity_, nullptr, GL_STREAM_DRAW);
+  if (size > 0) {
+    glBufferSubData(GL_ARRAY_BUFFER, 0, size, data);
+    Counters::Add(Counters::kBufferBytes, size);
+  }
+  RenderState::BindBuffer(GL_ARRAY_BUFFER, 0);
+  util::CheckGlError("PointCloudBuffer::Update");
+  if (is_resized) {
+    MemoryTracker::Track(MemoryTracker::kBuffer, buffer_id_,
+                         "PointCloudBuffer", capacity_);
+  }
+
+  point_count_ = point_count;
+  timestamp_ = timestamp;
+  has_frame_ = true;
+  return true;
+}
+
+void PointCloudBuffer::Release() {
+  if (buffer_id_ != 0) {
+    RenderState::DeleteBuffers(1, &buffer_id_);
+  }
+  Invalidate();
+}
+
+void PointCloudBuffer::Invalidate() {
+  buffer_id_ = 0;
+  capacity_ = 0;
+  point_count_ = 0;
+  has_frame_ = false;
+}
+
+}  // namespace tango_gl
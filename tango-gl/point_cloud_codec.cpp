@@ -0,0 +1,385 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <string.h>
+
+#include <algorithm>
+
+#include "tango-gl/cpu_features.h"
+#include "tango-gl/frame_arena.h"
+#include "tango-gl/point_cloud_codec.h"
+
+namespace {
+using tango_gl::point_cloud_codec::internal::Quantize;
+
+const int kCoordinateBits = tango_gl::point_cloud_codec::kCoordinateBits;
+const uint32_t kCoordinateOffset = 1u << (kCoordinateBits - 1);
+
+// Worst case per point: the six length decisions at the least likely
+// probability, about 6 bits each, plus 62 raw bits.
+const size_t kMaxEncodedPointSize = 13;
+// Bytes the range encoder flushes.
+const size_t kRangeCoderFlushSize = 5;
+
+// Adaptive binary range coder of the LZMA family: 11 bit probabilities,
+// adapting by 1/32 of the error on each bit.
+const int kProbabilityBits = 11;
+const uint16_t kProbabilityOne = 1 << kProbabilityBits;
+const uint16_t kProbabilityHalf = kProbabilityOne / 2;
+const int kAdaptationShift = 5;
+const uint32_t kRangeTop = 1u << 24;
+
+// Bit lengths of the Morton code differences, 0 to 63, coded as a 6 bit
+// binary tree in the context of the previous length.
+const int kLengthBits = 6;
+const int kLengthCount = 1 << kLengthBits;
+
+class RangeEncoder {
+ public:
+  RangeEncoder(uint8_t* dst, size_t capacity)
+      : dst_(dst),
+        capacity_(capacity),
+        size_(0),
+        low_(0),
+        range_(0xFFFFFFFFu),
+        cache_(0),
+        cache_size_(1) {}
+
+  void EncodeBit(uint16_t* probability, uint32_t bit) {
+    const uint32_t bound = (range_ >> kProbabilityBits) * *probability;
+    if (bit == 0) {
+      range_ = bound;
+      *probability += (kProbabilityOne - *probability) >> kAdaptationShift;
+    } else {
+      low_ += bound;
+      range_ -= bound;
+      *probability -= *probability >> kAdaptationShift;
+    }
+    Normalize();
+  }
+
+  // The count low bits of value, most significant first, at probability 1/2.
+  void EncodeDirectBits(uint64_t value, int count) {
+    while (count-- > 0) {
+      range_ >>= 1;
+      if ((value >> count) & 1) {
+        low_ += range_;
+      }
+      Normalize();
+    }
+  }
+
+  // @return: number of bytes written, 0 if they did not fit.
+  size_t Finish() {
+    for (size_t i = 0; i < kRangeCoderFlushSize; ++i) {
+      ShiftLow();
+    }
+    return size_ <= capacity_ ? size_ : 0;
+  }
+
+ private:
+  void Normalize() {
+    while (range_ < kRangeTop) {
+      range_ <<= 8;
+      ShiftLow();
+    }
+  }
+
+  // Output the top byte of low_, holding back 0xFF bytes until it is known
+  // whether a carry propagates into them.
+  void ShiftLow() {
+    if (static_cast<uint32_t>(low_) < 0xFF000000u || (low_ >> 32) != 0) {
+      const uint8_t carry = static_cast<uint8_t>(low_ >> 32);
+      uint8_t byte = cache_;
+      do {
+        Put(static_cast<uint8_t>(byte + carry));
+        byte = 0xFF;
+      } while (--cache_size_ != 0);
+      cache_ = static_cast<uint8_t>(low_ >> 24);
+    }
+    ++cache_size_;
+    low_ = (low_ & 0x00FFFFFFu) << 8;
+  }
+
+  void Put(uint8_t byte) {
+    if (size_ < capacity_) {
+      dst_[size_] = byte;
+    }
+    ++size_;
+  }
+
+  uint8_t* dst_;
+  size_t capacity_;
+  size_t size_;
+  uint64_t low_;
+  uint32_t range_;
+  uint8_t cache_;
+  uint64_t cache_size_;
+};
+
+class RangeDecoder {
+ public:
+  RangeDecoder(const uint8_t* src, size_t size)
+      : src_(src), size_(size), position_(0), range_(0xFFFFFFFFu), code_(0) {
+    for (size_t i = 0; i < kRangeCoderFlushSize; ++i) {
+      code_ = (code_ << 8) | Next();
+    }
+  }
+
+  uint32_t DecodeBit(uint16_t* probability) {
+    const uint32_t bound = (range_ >> kProbabilityBits) * *probability;
+    uint32_t bit;
+    if (code_ < bound) {
+      range_ = bound;
+      *probability += (kProbabilityOne - *probability) >> kAdaptationShift;
+      bit = 0;
+    } else {
+      code_ -= bound;
+      range_ -= bound;
+      *probability -= *probability >> kAdaptationShift;
+      bit = 1;
+    }
+    Normalize();
+    return bit;
+  }
+
+  uint64_t DecodeDirectBits(int count) {
+    uint64_t value = 0;
+    while (count-- > 0) {
+      range_ >>= 1;
+      const uint32_t bit = code_ >= range_ ? 1 : 0;
+      if (bit != 0) {
+        code_ -= range_;
+      }
+      value = (value << 1) | bit;
+      Normalize();
+    }
+    return value;
+  }
+
+  // False once the decoder read past the end of its input.
+  bool IsValid() const { return position_ <= size_; }
+
+ private:
+  void Normalize() {
+    while (range_ < kRangeTop) {
+      range_ <<= 8;
+      code_ = (code_ << 8) | Next();
+    }
+  }
+
+  uint8_t Next() {
+    if (position_ < size_) {
+      return src_[position_++];
+    }
+    ++position_;
+    return 0;
+  }
+
+  const uint8_t* src_;
+  size_t size_;
+  size_t position_;
+  uint32_t range_;
+  uint32_t code_;
+};
+
+// Spread the 21 low bits of value two bits apart.
+uint64_t SpreadBits(uint64_t value) {
+  value &= 0x1FFFFF;
+  value = (value | value << 32) & 0x001F00000000FFFFull;
+  value = (value | value << 16) & 0x001F0000FF0000FFull;
+  value = (value | value << 8) & 0x100F00F00F00F00Full;
+  value = (value | value << 4) & 0x10C30C30C30C30C3ull;
+  value = (value | value << 2) & 0x1249249249249249ull;
+  return value;
+}
+
+// Inverse of SpreadBits().
+uint32_t CompactBits(uint64_t value) {
+  value &= 0x1249249249249249ull;
+  value = (value ^ (value >> 2)) & 0x10C30C30C30C30C3ull;
+  value = (value ^ (value >> 4)) & 0x100F00F00F00F00Full;
+  value = (value ^ (value >> 8)) & 0x001F0000FF0000FFull;
+  value = (value ^ (value >> 16)) & 0x001F00000000FFFFull;
+  value = (value ^ (value >> 32)) & 0x1FFFFF;
+  return static_cast<uint32_t>(value);
+}
+
+// Morton codes of points [begin, end). Also the tail of the NEON kernel.
+void ComputeMortonCodesScalar(const float* points, size_t begin, size_t end,
+                              float inverse_step, uint64_t* codes) {
+  for (size_t i = begin; i < end; ++i) {
+    const float* point = points + i * 3;
+    codes[i] = SpreadBits(Quantize(point[0], inverse_step)) |
+               (SpreadBits(Quantize(point[1], inverse_step)) << 1) |
+               (SpreadBits(Quantize(point[2], inverse_step)) << 2);
+  }
+}
+
+// LSD radix sort on bytes, skipping the bytes every code has in common. The
+// codes of a frame span a few meters, so their top bytes rarely differ.
+void RadixSort(std::vector<uint64_t>* codes, std::vector<uint64_t>* buffer) {
+  if (codes->empty()) {
+    return;
+  }
+  uint64_t differing_bits = 0;
+  const uint64_t first = codes->front();
+  for (uint64_t code : *codes) {
+    differing_bits |= code ^ first;
+  }
+  buffer->resize(codes->size());
+  for (int shift = 0; shift < 64; shift += 8) {
+    if (((differing_bits >> shift) & 0xFF) == 0) {
+      continue;
+    }
+    size_t offsets[256] = {};
+    for (uint64_t code : *codes) {
+      ++offsets[(code >> shift) & 0xFF];
+    }
+    size_t offset = 0;
+    for (size_t& count : offsets) {
+      const size_t bucket_size = count;
+      count = offset;
+      offset += bucket_size;
+    }
+    for (uint64_t code : *codes) {
+      (*buffer)[offsets[(code >> shift) & 0xFF]++] = code;
+    }
+    codes->swap(*buffer);
+  }
+}
+
+int GetBitLength(uint64_t value) {
+  return value == 0 ? 0 : 64 - __builtin_clzll(value);
+}
+}  // namespace
+
+namespace tango_gl {
+namespace point_cloud_codec {
+
+size_t GetMaxEncodedSize(size_t point_count) {
+  return sizeof(Header) + point_count * kMaxEncodedPointSize +
+         kRangeCoderFlushSize;
+}
+
+bool ReadHeader(const uint8_t* data, size_t size, Header* header) {
+  if (size < sizeof(Header)) {
+    return false;
+  }
+  memcpy(header, data, sizeof(Header));
+  return header->magic == kMagic && header->step > 0.0f &&
+         header->payload_size <= size - sizeof(Header);
+}
+
+bool Decode(const uint8_t* data, size_t size, float* points,
+            size_t capacity) {
+  Header header;
+  if (!ReadHeader(data, size, &header) || header.point_count > capacity) {
+    return false;
+  }
+
+  RangeDecoder decoder(data + sizeof(Header), header.payload_size);
+  FrameArena& arena = FrameArena::ForThisThread();
+  FrameArena::Scope scope(&arena);
+  ArenaVector<uint16_t> length_probabilities(kLengthCount * kLengthCount,
+                                             kProbabilityHalf,
+                                             ArenaAllocator<uint16_t>(&arena));
+  uint64_t code = 0;
+  int previous_length = 0;
+  for (uint32_t i = 0; i < header.point_count; ++i) {
+    uint16_t* probabilities =
+        length_probabilities.data() + previous_length * kLengthCount;
+    int node = 1;
+    for (int bit = 0; bit < kLengthBits; ++bit) {
+      node = (node << 1) | decoder.DecodeBit(probabilities + node);
+    }
+    const int length = node - kLengthCount;
+    if (length > 0) {
+      code += (uint64_t(1) << (length - 1)) |
+              decoder.DecodeDirectBits(length - 1);
+    }
+    previous_length = length;
+
+    float* point = points + i * 3;
+    point[0] = (static_cast<float>(CompactBits(code)) -
+                static_cast<float>(kCoordinateOffset)) * header.step;
+    point[1] = (static_cast<float>(CompactBits(code >> 1)) -
+                static_cast<float>(kCoordinateOffset)) * header.step;
+    point[2] = (static_cast<float>(CompactBits(code >> 2)) -
+                static_cast<float>(kCoordinateOffset)) * header.step;
+  }
+  return decoder.IsValid();
+}
+
+size_t Encoder::Encode(const float* points, size_t point_count, float step,
+                       uint8_t* dst, size_t capacity) {
+  if (capacity < sizeof(Header) || !(step > 0.0f)) {
+    return 0;
+  }
+
+  codes_.resize(point_count);
+  const float inverse_step = 1.0f / step;
+  size_t begin = 0;
+#if defined(TANGO_GL_HAS_NEON)
+  if (cpu_features::IsNeonAvailable()) {
+    begin = point_count & ~static_cast<size_t>(3);
+    internal::ComputeMortonCodesNeon(points, point_count, inverse_step,
+                                     codes_.data());
+  }
+#endif
+  ComputeMortonCodesScalar(points, begin, point_count, inverse_step,
+                           codes_.data());
+  RadixSort(&codes_, &sort_buffer_);
+
+  RangeEncoder encoder(dst + sizeof(Header), capacity - sizeof(Header));
+  length_probabilities_.assign(kLengthCount * kLengthCount, kProbabilityHalf);
+  uint64_t previous_code = 0;
+  int previous_length = 0;
+  for (uint64_t code : codes_) {
+    const uint64_t delta = code - previous_code;
+    previous_code = code;
+    const int length = GetBitLength(delta);
+
+    uint16_t* probabilities =
+        length_probabilities_.data() + previous_length * kLengthCount;
+    int node = 1;
+    for (int bit = kLengthBits - 1; bit >= 0; --bit) {
+      const uint32_t value = (length >> bit) & 1;
+      encoder.EncodeBit(probabilities + node, value);
+      node = (node << 1) | value;
+    }
+    if (length > 1) {
+      encoder.EncodeDirectBits(delta, length - 1);
+    }
+    previous_length = length;
+  }
+  const size_t payload_size = encoder.Finish();
+  if (payload_size == 0) {
+    return 0;
+  }
+
+  Header header;
+  header.magic = kMagic;
+  header.point_count = static_cast<uint32_t>(point_count);
+  header.step = step;
+  header.payload_size = static_cast<uint32_t>(payload_size);
+  memcpy(dst, &header, sizeof(Header));
+  return sizeof(Header) + payload_size;
+}
+
+}  // namespace point_cloud_codec
+}  // namespace tango_gl
@@ -0,0 +1,93 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// This file is only compiled with NEON enabled (the ".neon" suffix in
+// Android.mk), the kernel is selected at runtime by point_cloud_codec.cpp.
+
+#include <arm_neon.h>
+
+#include "tango-gl/point_cloud_codec.h"
+
+namespace {
+// Spread the 21 low bits of each lane two bits apart, see SpreadBits() in
+// point_cloud_codec.cpp.
+inline uint64x2_t SpreadBits(uint64x2_t value) {
+  value = vandq_u64(value, vdupq_n_u64(0x1FFFFF));
+  value = vandq_u64(vorrq_u64(value, vshlq_n_u64(value, 32)),
+                    vdupq_n_u64(0x001F00000000FFFFull));
+  value = vandq_u64(vorrq_u64(value, vshlq_n_u64(value, 16)),
+                    vdupq_n_u64(0x001F0000FF0000FFull));
+  value = vandq_u64(vorrq_u64(value, vshlq_n_u64(value, 8)),
+                    vdupq_n_u64(0x100F00F00F00F00Full));
+  value = vandq_u64(vorrq_u64(value, vshlq_n_u64(value, 4)),
+                    vdupq_n_u64(0x10C30C30C30C30C3ull));
+  value = vandq_u64(vorrq_u64(value, vshlq_n_u64(value, 2)),
+                    vdupq_n_u64(0x1249249249249249ull));
+  return value;
+}
+}  // namespace
+
+namespace tango_gl {
+namespace point_cloud_codec {
+namespace internal {
+
+void ComputeMortonCodesNeon(const float* points, size_t point_count,
+                            float inverse_step, uint64_t* codes) {
+  // Same arithmetic as Quantize(). NaN survives the clamps and converts to
+  // 0, like in Quantize(); the conversion truncates toward zero.
+  const float32x4_t scale = vdupq_n_f32(inverse_step);
+  const int32_t kOffset = 1 << (kCoordinateBits - 1);
+  const float32x4_t min = vdupq_n_f32(-static_cast<float>(kOffset));
+  const float32x4_t max = vdupq_n_f32(static_cast<float>(kOffset) - 1.0f);
+  const uint32x4_t sign_mask = vdupq_n_u32(0x80000000u);
+  const uint32x4_t half = vreinterpretq_u32_f32(vdupq_n_f32(0.5f));
+  const int32x4_t offset = vdupq_n_s32(kOffset);
+
+  const size_t count = point_count & ~static_cast<size_t>(3);
+  for (size_t i = 0; i < count; i += 4) {
+    // De-interleave four xyz points into x, y and z vectors.
+    const float32x4x3_t xyz = vld3q_f32(points + i * 3);
+    uint32x4_t cells[3];
+    for (int axis = 0; axis < 3; ++axis) {
+      float32x4_t cell = vmulq_f32(xyz.val[axis], scale);
+      cell = vminq_f32(vmaxq_f32(cell, min), max);
+      // Add 0.5 with the sign of the cell, rounding half away from zero.
+      const float32x4_t signed_half = vreinterpretq_f32_u32(
+          vorrq_u32(vandq_u32(vreinterpretq_u32_f32(cell), sign_mask), half));
+      cell = vaddq_f32(cell, signed_half);
+      cells[axis] = vreinterpretq_u32_s32(
+          vaddq_s32(vcvtq_s32_f32(cell), offset));
+    }
+
+    uint64x2_t low = SpreadBits(vmovl_u32(vget_low_u32(cells[0])));
+    low = vorrq_u64(low, vshlq_n_u64(
+                             SpreadBits(vmovl_u32(vget_low_u32(cells[1]))), 1));
+    low = vorrq_u64(low, vshlq_n_u64(
+                             SpreadBits(vmovl_u32(vget_low_u32(cells[2]))), 2));
+    uint64x2_t high = SpreadBits(vmovl_u32(vget_high_u32(cells[0])));
+    high = vorrq_u64(
+        high, vshlq_n_u64(SpreadBits(vmovl_u32(vget_high_u32(cells[1]))), 1));
+    high = vorrq_u64(
+        high, vshlq_n_u64(SpreadBits(vmovl_u32(vget_high_u32(cells[2]))), 2));
+    vst1q_u64(codes + i, low);
+    vst1q_u64(codes + i + 2, high);
+  }
+}
+
+}  // namespace internal
+}  // namespace point_cloud_codec
+}  // namespace tango_gl
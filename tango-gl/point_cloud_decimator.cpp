@@ -0,0 +1,263 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "tango-gl/point_cloud_decimator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+// Voxel edge lengths in meters.
+const float kInitialVoxelSize = 0.02f;
+const float kMinVoxelSize = 0.005f;
+const float kMaxVoxelSize = 0.5f;
+
+// Largest change of the voxel size from one frame to the next.
+const float kMaxVoxelSizeStep = 2.0f;
+
+// The voxel size aims at slightly more voxels than the target, the stride
+// over the voxels trims the rest.
+const float kVoxelCountHeadroom = 1.1f;
+
+// Bits per voxel coordinate in a key, the grid is centered on the camera.
+const int kKeyBits = 21;
+const int32_t kKeyBias = 1 << (kKeyBits - 1);
+const uint64_t kKeyMask = (1ull << kKeyBits) - 1;
+
+// Smallest partition table, in voxels.
+const size_t kMinPartitionSize = 64;
+
+inline uint64_t VoxelKey(const float* point, float inverse_voxel_size) {
+  uint64_t key = 0;
+  for (int i = 0; i < 3; ++i) {
+    int32_t coordinate =
+        static_cast<int32_t>(std::floor(point[i] * inverse_voxel_size));
+    key = (key << kKeyBits) |
+          (static_cast<uint64_t>(coordinate + kKeyBias) & kKeyMask);
+  }
+  return key;
+}
+
+inline uint32_t VoxelHash(uint64_t key) {
+  return static_cast<uint32_t>((key * 0x9E3779B97F4A7C15ull) >> 32);
+}
+
+// The partition uses the high bits of a hash, the slot in it the low bits.
+inline int HashPartition(uint32_t hash, int partition_count) {
+  return static_cast<int>((static_cast<uint64_t>(hash) * partition_count) >>
+                          32);
+}
+
+inline size_t NextPowerOfTwo(size_t value) {
+  size_t power = 1;
+  while (power < value) {
+    power <<= 1;
+  }
+  return power;
+}
+}  // namespace
+
+namespace tango_gl {
+
+PointCloudDecimator::PointCloudDecimator()
+    : mode_(kVoxelGrid),
+      target_point_count_(0),
+      voxel_size_(kInitialVoxelSize),
+      frame_xyz_(nullptr),
+      frame_point_count_(0),
+      frame_target_point_count_(0),
+      frame_voxel_count_(0),
+      frame_output_(nullptr),
+      worker_pool_(&WorkerPool::GetShared()),
+      partition_size_(0),
+      stamp_(0) {
+  partition_count_ = worker_pool_->GetConcurrency();
+  partition_voxel_counts_.resize(partition_count_, 0);
+  partition_offsets_.resize(partition_count_, 0);
+}
+
+PointCloudDecimator::~PointCloudDecimator() {}
+
+void PointCloudDecimator::Reserve(size_t point_count) {
+  if (point_count <= keys_.size()) {
+    return;
+  }
+  keys_.resize(point_count);
+  hashes_.resize(point_count);
+
+  // Keep every partition at most half full for an even split of the voxels.
+  partition_size_ = std::max(
+      kMinPartitionSize, NextPowerOfTwo(2 * point_count / partition_count_));
+  voxels_.assign(partition_size_ * partition_count_, Voxel());
+  voxel_order_.resize(voxels_.size());
+  stamp_ = 0;
+}
+
+size_t PointCloudDecimator::Decimate(const float* xyz, size_t point_count,
+                                     float* output) {
+  if (target_point_count_ == 0 || point_count <= target_point_count_) {
+    std::memcpy(output, xyz, point_count * 3 * sizeof(float));
+    return point_count;
+  }
+
+  if (mode_ == kStride) {
+    return DecimateStride(xyz, point_count, target_point_count_, output);
+  }
+  return DecimateVoxelGrid(xyz, point_count, target_point_count_, output);
+}
+
+size_t PointCloudDecimator::DecimateStride(const float* xyz,
+                                           size_t point_count,
+                                           size_t target_point_count,
+                                           float* output) {
+  for (size_t i = 0; i < target_point_count; ++i) {
+    size_t source = static_cast<size_t>(static_cast<uint64_t>(i) *
+                                        point_count / target_point_count);
+    std::memcpy(output + i * 3, xyz + source * 3, 3 * sizeof(float));
+  }
+  return target_point_count;
+}
+
+size_t PointCloudDecimator::DecimateVoxelGrid(const float* xyz,
+                                              size_t point_count,
+                                              size_t target_point_count,
+                                              float* output) {
+  Reserve(point_count);
+  if (++stamp_ == 0) {
+    // Every stamp was used, start over from a clean table.
+    for (Voxel& voxel : voxels_) {
+      voxel.stamp = 0;
+    }
+    stamp_ = 1;
+  }
+
+  frame_xyz_ = xyz;
+  frame_point_count_ = point_count;
+  frame_target_point_count_ = target_point_count;
+  frame_output_ = output;
+
+  worker_pool_->ParallelFor(partition_count_,
+                            [this](int chunk) { HashChunk(chunk); });
+  worker_pool_->ParallelFor(partition_count_,
+                            [this](int partition) { FillPartition(partition); });
+
+  size_t voxel_count = 0;
+  for (int i = 0; i < partition_count_; ++i) {
+    partition_offsets_[i] = voxel_count;
+    voxel_count += partition_voxel_counts_[i];
+  }
+  frame_voxel_count_ = voxel_count;
+  frame_target_point_count_ = std::min(target_point_count, voxel_count);
+
+  worker_pool_->ParallelFor(
+      partition_count_, [this](int partition) { WritePartition(partition); });
+  size_t output_count = frame_target_point_count_;
+  frame_xyz_ = nullptr;
+  frame_output_ = nullptr;
+
+  // Surfaces dominate a depth frame, so the voxel count goes about with the
+  // inverse square of the voxel size.
+  if (voxel_count > 0) {
+    float ratio = static_cast<float>(voxel_count) /
+                  (kVoxelCountHeadroom * target_point_count);
+    float step = std::max(1.0f / kMaxVoxelSizeStep,
+                          std::min(kMaxVoxelSizeStep, std::sqrt(ratio)));
+    voxel_size_ =
+        std::max(kMinVoxelSize, std::min(kMaxVoxelSize, voxel_size_ * step));
+  }
+  return output_count;
+}
+
+void PointCloudDecimator::HashChunk(int chunk) {
+  const size_t begin = frame_point_count_ * chunk / partition_count_;
+  const size_t end = frame_point_count_ * (chunk + 1) / partition_count_;
+  const float inverse_voxel_size = 1.0f / voxel_size_;
+  for (size_t i = begin; i < end; ++i) {
+    keys_[i] = VoxelKey(frame_xyz_ + i * 3, inverse_voxel_size);
+    hashes_[i] = VoxelHash(keys_[i]);
+  }
+}
+
+void PointCloudDecimator::FillPartition(int partition) {
+  Voxel* table = &voxels_[partition * partition_size_];
+  uint32_t* order = &voxel_order_[partition * partition_size_];
+  const size_t slot_mask = partition_size_ - 1;
+  size_t voxel_count = 0;
+
+  for (size_t i = 0; i < frame_point_count_; ++i) {
+    const uint32_t hash = hashes_[i];
+    if (HashPartition(hash, partition_count_) != partition) {
+      continue;
+    }
+    const uint64_t key = keys_[i];
+    const float* point = frame_xyz_ + i * 3;
+    size_t slot = hash & slot_mask;
+    while (true) {
+      Voxel& voxel = table[slot];
+      if (voxel.stamp != stamp_) {
+        // A full partition only happens with a badly skewed frame, its
+        // remaining new voxels are dropped.
+        if (voxel_count + 1 >= partition_size_) {
+          break;
+        }
+        voxel.key = key;
+        voxel.sum[0] = point[0];
+        voxel.sum[1] = point[1];
+        voxel.sum[2] = point[2];
+        voxel.count = 1;
+        voxel.stamp = stamp_;
+        order[voxel_count++] = static_cast<uint32_t>(slot);
+        break;
+      }
+      if (voxel.key == key) {
+        voxel.sum[0] += point[0];
+        voxel.sum[1] += point[1];
+        voxel.sum[2] += point[2];
+        ++voxel.count;
+        break;
+      }
+      slot = (slot + 1) & slot_mask;
+    }
+  }
+  partition_voxel_counts_[partition] = voxel_count;
+}
+
+void PointCloudDecimator::WritePartition(int partition) {
+  const Voxel* table = &voxels_[partition * partition_size_];
+  const uint32_t* order = &voxel_order_[partition * partition_size_];
+  const uint64_t voxel_count = frame_voxel_count_;
+  const uint64_t target_count = frame_target_point_count_;
+  const size_t offset = partition_offsets_[partition];
+
+  for (size_t i = 0; i < partition_voxel_counts_[partition]; ++i) {
+    // Voxel g is kept if the stride crosses an output index at it.
+    const uint64_t g = offset + i;
+    const uint64_t index = g * target_count / voxel_count;
+    if ((g + 1) * target_count / voxel_count == index) {
+      continue;
+    }
+    const Voxel& voxel = table[order[i]];
+    const float inverse_count = 1.0f / voxel.count;
+    float* point = frame_output_ + index * 3;
+    point[0] = voxel.sum[0] * inverse_count;
+    point[1] = voxel.sum[1] * inverse_count;
+    point[2] = voxel.sum[2] * inverse_count;
+  }
+}
+
+}  // namespace tango_gl
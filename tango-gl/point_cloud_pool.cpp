@@ -0,0 +1,177 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "tango-gl/point_cloud_pool.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "tango-gl/memory_tracker.h"
+
+namespace tango_gl {
+
+PointCloudPool::Handle::Handle(const Handle& other)
+    : pool_(other.pool_), slot_(other.slot_) {
+  if (slot_ >= 0) {
+    pool_->AddReference(slot_);
+  }
+}
+
+PointCloudPool::Handle::Handle(Handle&& other)
+    : pool_(other.pool_), slot_(other.slot_) {
+  other.pool_ = nullptr;
+  other.slot_ = -1;
+}
+
+PointCloudPool::Handle& PointCloudPool::Handle::operator=(Handle other) {
+  std::swap(pool_, other.pool_);
+  std::swap(slot_, other.slot_);
+  return *this;
+}
+
+int PointCloudPool::Handle::Detach() {
+  const int slot = slot_;
+  pool_ = nullptr;
+  slot_ = -1;
+  return slot;
+}
+
+void PointCloudPool::Handle::Reset() {
+  if (slot_ >= 0) {
+    pool_->Release(slot_);
+  }
+  pool_ = nullptr;
+  slot_ = -1;
+}
+
+PointCloudPool::PointCloudPool(size_t max_point_count, size_t memory_budget)
+    : max_point_count_(max_point_count),
+      slot_count_(1),
+      latest_(-1),
+      publish_count_(0) {
+  const size_t cloud_size =
+      std::max<size_t>(1, max_point_count * 3 * sizeof(float));
+  slot_count_ =
+      static_cast<int>(std::max<size_t>(1, memory_budget / cloud_size));
+  storage_.resize(max_point_count * 3 * slot_count_);
+  MemoryTracker::Track(MemoryTracker::kHost, reinterpret_cast<uintptr_t>(this),
+                       "PointCloudPool", storage_.size() * sizeof(float));
+  slots_.reset(new Slot[slot_count_]);
+  for (int i = 0; i < slot_count_; ++i) {
+    TangoXYZij& cloud = slots_[i].cloud.cloud;
+    cloud.version = 0;
+    cloud.timestamp = 0.0;
+    cloud.xyz_count = 0;
+    cloud.xyz = reinterpret_cast<float(*)[3]>(
+        storage_.data() + max_point_count * 3 * i);
+    cloud.ij_rows = 0;
+    cloud.ij_cols = 0;
+    cloud.ij = nullptr;
+    cloud.color_image = nullptr;
+    slots_[i].cloud.pose = glm::mat4(1.0f);
+    slots_[i].cloud.sequence = 0;
+    slots_[i].references.store(0, std::memory_order_relaxed);
+  }
+}
+
+PointCloudPool::~PointCloudPool() {
+  MemoryTracker::Untrack(MemoryTracker::kHost,
+                         reinterpret_cast<uintptr_t>(this));
+  const int latest = latest_.exchange(-1);
+  if (latest >= 0) {
+    Release(latest);
+  }
+  for (int i = 0; i < slot_count_; ++i) {
+    if (slots_[i].references.load() != 0) {
+      LOGE("PointCloudPool: Destroyed while cloud %d is still referenced", i);
+    }
+  }
+}
+
+PointCloudPool::Handle PointCloudPool::Allocate() {
+  for (int i = 0; i < slot_count_; ++i) {
+    int unused = 0;
+    if (slots_[i].references.compare_exchange_strong(
+            unused, 1, std::memory_order_acquire)) {
+      slots_[i].cloud.cloud.timestamp = 0.0;
+      slots_[i].cloud.cloud.xyz_count = 0;
+      return Handle(this, i);
+    }
+  }
+  return Handle();
+}
+
+void PointCloudPool::Publish(const Handle& handle) {
+  if (!handle || handle.pool_ != this) {
+    LOGE("PointCloudPool: Invalid handle to publish");
+    return;
+  }
+  handle->sequence =
+      publish_count_.fetch_add(1, std::memory_order_relaxed) + 1;
+  AddReference(handle.slot_);
+  const int previous =
+      latest_.exchange(handle.slot_, std::memory_order_acq_rel);
+  if (previous >= 0) {
+    Release(previous);
+  }
+}
+
+PointCloudPool::Handle PointCloudPool::AcquireLatest() {
+  while (true) {
+    const int slot = latest_.load(std::memory_order_acquire);
+    if (slot < 0) {
+      return Handle();
+    }
+    // The slot may be replaced and recycled between the load and taking the
+    // reference, only keep it if it is still the latest frame afterwards.
+    if (TryAddReference(slot)) {
+      if (latest_.load(std::memory_order_acquire) == slot) {
+        return Handle(this, slot);
+      }
+      Release(slot);
+    }
+  }
+}
+
+PointCloudPool::Handle PointCloudPool::Attach(int slot) {
+  if (slot < 0 || slot >= slot_count_) {
+    LOGE("PointCloudPool: Invalid slot %d to attach", slot);
+    return Handle();
+  }
+  return Handle(this, slot);
+}
+
+void PointCloudPool::AddReference(int slot) {
+  slots_[slot].references.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool PointCloudPool::TryAddReference(int slot) {
+  int references = slots_[slot].references.load(std::memory_order_relaxed);
+  while (references > 0) {
+    if (slots_[slot].references.compare_exchange_weak(
+            references, references + 1, std::memory_order_acquire)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void PointCloudPool::Release(int slot) {
+  slots_[slot].references.fetch_sub(1, std::memory_order_acq_rel);
+}
+
+}  // namespace tango_gl
@@ -0,0 +1,122 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <math.h>
+
+#include "tango-gl/point_colorizer.h"
+#include "tango-gl/yuv_converter.h"
+
+namespace {
+// Color of the points the frame has no color for, see Colorize().
+const uint8_t kUncoloredGray = 128;
+const uint8_t kUncoloredAlpha = 0;
+const uint8_t kColoredAlpha = 255;
+
+const float kQuantizedPointMax = 32767.0f;
+
+void SetPosition(const float* point, tango_gl::ColoredPoint* output) {
+  output->x = point[0];
+  output->y = point[1];
+  output->z = point[2];
+}
+
+int16_t QuantizeCoordinate(float meters) {
+  float units = meters / tango_gl::kQuantizedPointScale;
+  if (units > kQuantizedPointMax) {
+    units = kQuantizedPointMax;
+  } else if (units < -kQuantizedPointMax) {
+    units = -kQuantizedPointMax;
+  }
+  return static_cast<int16_t>(lroundf(units));
+}
+
+void SetPosition(const float* point,
+                 tango_gl::QuantizedColoredPoint* output) {
+  output->x = QuantizeCoordinate(point[0]);
+  output->y = QuantizeCoordinate(point[1]);
+  output->z = QuantizeCoordinate(point[2]);
+  output->padding = 0;
+}
+}  // namespace
+
+namespace tango_gl {
+
+template <typename Point>
+size_t PointColorizer::ColorizePoints(
+    const float* points, size_t point_count, const glm::mat4& color_T_points,
+    const projection::CameraIntrinsics& intrinsics, const uint8_t* nv21,
+    Point* output) {
+  for (size_t i = 0; i < point_count; ++i) {
+    Point& colored = output[i];
+    SetPosition(points + i * 3, &colored);
+    colored.r = kUncoloredGray;
+    colored.g = kUncoloredGray;
+    colored.b = kUncoloredGray;
+    colored.a = kUncoloredAlpha;
+  }
+  if (nv21 == nullptr || point_count == 0) {
+    return 0;
+  }
+
+  // Only the largest frame so far allocates.
+  if (pixels_.size() < point_count) {
+    pixels_.resize(point_count);
+  }
+  size_t projected =
+      projection::ProjectPoints(points, point_count, color_T_points,
+                                intrinsics, pixels_.data(), nullptr);
+  if (projected == 0) {
+    return 0;
+  }
+
+  const size_t width = static_cast<size_t>(intrinsics.width);
+  const size_t height = static_cast<size_t>(intrinsics.height);
+  for (size_t i = 0; i < point_count; ++i) {
+    const int32_t pixel = pixels_[i];
+    if (pixel == projection::kInvalidPixel) {
+      continue;
+    }
+    uint8_t rgb[3];
+    yuv::ConvertNV21PixelToRGB(nv21, width, height,
+                               projection::PixelX(pixel),
+                               projection::PixelY(pixel), rgb);
+    Point& colored = output[i];
+    colored.r = rgb[0];
+    colored.g = rgb[1];
+    colored.b = rgb[2];
+    colored.a = kColoredAlpha;
+  }
+  return projected;
+}
+
+size_t PointColorizer::Colorize(const float* points, size_t point_count,
+                                const glm::mat4& color_T_points,
+                                const projection::CameraIntrinsics& intrinsics,
+                                const uint8_t* nv21, ColoredPoint* output) {
+  return ColorizePoints(points, point_count, color_T_points, intrinsics, nv21,
+                        output);
+}
+
+size_t PointColorizer::Colorize(const float* points, size_t point_count,
+                                const glm::mat4& color_T_points,
+                                const projection::CameraIntrinsics& intrinsics,
+                                const uint8_t* nv21,
+                                QuantizedColoredPoint* output) {
+  return ColorizePoints(points, point_count, color_T_points, intrinsics, nv21,
+                        output);
+}
+
+}  // namespace tango_gl
@@ -0,0 +1,731 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "tango-gl/point_map.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <utility>
+
+namespace {
+// Bits per block coordinate in a key, the grid is centered on the origin.
+const int kKeyBits = 21;
+const int32_t kKeyBias = 1 << (kKeyBits - 1);
+const uint64_t kKeyMask = (1ull << kKeyBits) - 1;
+
+// Largest weight of a voxel mean, so a voxel keeps following pose
+// corrections instead of freezing on its first observations.
+const uint32_t kMaxVoxelWeight = 32;
+
+// First entry and edge in entries of each level in Block::lod_voxels, level 0
+// being the voxels themselves.
+const int kLodOffsets[] = {0, 0, 64, 72};
+const int kLodEdges[] = {8, 4, 2, 1};
+
+// Block coordinate along an axis of a key, the inverse of BlockKey().
+inline int32_t BlockCoordinate(uint64_t key, int axis) {
+  return static_cast<int32_t>((key >> (axis * kKeyBits)) & kKeyMask) -
+         kKeyBias;
+}
+
+inline size_t HashKey(uint64_t key) {
+  key *= 0x9E3779B97F4A7C15ull;
+  return static_cast<size_t>(key ^ (key >> 32));
+}
+
+// Integer division rounding towards negative infinity.
+inline int32_t FloorDivide(int32_t value, int32_t divisor) {
+  return value >= 0 ? value / divisor : (value - divisor + 1) / divisor;
+}
+
+inline int32_t FloorToInt(float value) {
+  return static_cast<int32_t>(std::floor(value));
+}
+
+// Squared distance from a position to the nearest point of a box.
+inline float BoxDistanceSquared(const glm::vec3& min, const glm::vec3& max,
+                                const glm::vec3& position) {
+  const glm::vec3 outside =
+      glm::max(glm::max(min - position, position - max), glm::vec3(0.0f));
+  return glm::dot(outside, outside);
+}
+}  // namespace
+
+namespace tango_gl {
+
+const int PointMap::kBlockSize;
+
+PointMap::PointMap(float voxel_size, size_t max_block_count)
+    : voxel_size_(voxel_size),
+      inverse_voxel_size_(1.0f / voxel_size),
+      blocks_(std::max<size_t>(1, max_block_count)),
+      block_count_(0),
+      point_count_(0),
+      newest_(-1),
+      oldest_(-1),
+      block_store_(nullptr) {
+  size_t table_size = 1;
+  while (table_size < blocks_.size() * 2) {
+    table_size <<= 1;
+  }
+  table_.assign(table_size, -1);
+  table_mask_ = table_size - 1;
+  dirty_blocks_.reserve(blocks_.size());
+}
+
+PointMap::~PointMap() {}
+
+void PointMap::Clear() {
+  std::fill(table_.begin(), table_.end(), -1);
+  block_count_ = 0;
+  point_count_ = 0;
+  newest_ = -1;
+  oldest_ = -1;
+  if (block_store_ != nullptr) {
+    block_store_->Clear();
+  }
+}
+
+void PointMap::Insert(const float* xyz, size_t point_count,
+                      const glm::mat4& map_T_points) {
+  const glm::mat3 rotation(map_T_points);
+  const glm::vec3 translation(map_T_points[3]);
+  const int32_t max_block_coordinate = kKeyBias - 1;
+
+  // Consecutive points mostly fall into the same block, skip the lookup for
+  // those.
+  uint64_t current_key = ~0ull;
+  Block* block = nullptr;
+  for (size_t i = 0; i < point_count; ++i) {
+    const glm::vec3 point =
+        rotation * glm::vec3(xyz[i * 3], xyz[i * 3 + 1], xyz[i * 3 + 2]) +
+        translation;
+    // Also rejects NaN.
+    if (!(std::abs(point.x) < 1e6f && std::abs(point.y) < 1e6f &&
+          std::abs(point.z) < 1e6f)) {
+      continue;
+    }
+
+    int32_t voxel[3];
+    int32_t block_coordinate[3];
+    bool in_range = true;
+    for (int axis = 0; axis < 3; ++axis) {
+      voxel[axis] = FloorToInt(point[axis] * inverse_voxel_size_);
+      block_coordinate[axis] = FloorDivide(voxel[axis], kBlockSize);
+      voxel[axis] -= block_coordinate[axis] * kBlockSize;
+      in_range = in_range &&
+                 std::abs(block_coordinate[axis]) < max_block_coordinate;
+    }
+    if (!in_range) {
+      continue;
+    }
+
+    const uint64_t key = BlockKey(block_coordinate[0], block_coordinate[1],
+                                  block_coordinate[2]);
+    if (key != current_key) {
+      const int32_t block_index = AcquireBlock(key);
+      block = &blocks_[block_index];
+      current_key = key;
+      if (!block->is_lod_dirty) {
+        block->is_lod_dirty = true;
+        dirty_blocks_.push_back(block_index);
+      }
+    }
+
+    const int index =
+        (voxel[2] * kBlockSize + voxel[1]) * kBlockSize + voxel[0];
+    Voxel& target = block->voxels[index];
+    const uint64_t bit = 1ull << (index & 63);
+    if ((block->mask[index >> 6] & bit) == 0) {
+      block->mask[index >> 6] |= bit;
+      target.mean[0] = point.x;
+      target.mean[1] = point.y;
+      target.mean[2] = point.z;
+      target.count = 1;
+      ++point_count_;
+      continue;
+    }
+    target.count = std::min(target.count + 1, kMaxVoxelWeight);
+    const float weight = 1.0f / static_cast<float>(target.count);
+    target.mean[0] += (point.x - target.mean[0]) * weight;
+    target.mean[1] += (point.y - target.mean[1]) * weight;
+    target.mean[2] += (point.z - target.mean[2]) * weight;
+  }
+
+  for (int32_t index : dirty_blocks_) {
+    RebuildLods(&blocks_[index]);
+    blocks_[index].is_lod_dirty = false;
+  }
+  dirty_blocks_.clear();
+}
+
+size_t PointMap::PageOut(const glm::vec3& center, float radius) {
+  if (block_store_ == nullptr) {
+    return 0;
+  }
+  const float block_size = voxel_size_ * kBlockSize;
+  const float radius_squared = radius * radius;
+  size_t paged_out = 0;
+  // Walking down, the block moved into a removed index was already kept.
+  for (size_t i = block_count_; i-- > 0;) {
+    const Block& block = blocks_[i];
+    const glm::vec3 min = glm::vec3(BlockCoordinate(block.key, 0),
+                                    BlockCoordinate(block.key, 1),
+                                    BlockCoordinate(block.key, 2)) *
+                          block_size;
+    if (BoxDistanceSquared(min, min + glm::vec3(block_size), center) <=
+        radius_squared) {
+      continue;
+    }
+    StoreBlock(static_cast<int32_t>(i));
+    RemoveBlock(static_cast<int32_t>(i));
+    ++paged_out;
+  }
+  return paged_out;
+}
+
+size_t PointMap::PageIn(const glm::vec3& center, float radius) {
+  if (block_store_ == nullptr) {
+    return 0;
+  }
+  std::vector<uint64_t> keys;
+  CollectAbsentKeys(center, radius, &keys);
+  size_t paged_in = 0;
+  for (uint64_t key : keys) {
+    if (block_count_ == blocks_.size()) {
+      break;
+    }
+    const int32_t index = static_cast<int32_t>(block_count_);
+    blocks_[index].is_lod_dirty = false;
+    if (RestoreBlock(key, index)) {
+      ++block_count_;
+      InsertSlot(index);
+      LinkNewest(index);
+      ++paged_in;
+    }
+  }
+  return paged_in;
+}
+
+void PointMap::Prefetch(const glm::vec3& center, float radius) {
+  if (block_store_ == nullptr) {
+    return;
+  }
+  std::vector<uint64_t> keys;
+  CollectAbsentKeys(center, radius, &keys);
+  block_store_->Prefetch(keys);
+}
+
+size_t PointMap::RadiusSearch(const glm::vec3& center, float radius,
+                              std::vector<glm::vec3>* points) const {
+  points->clear();
+  if (radius < 0.0f || block_count_ == 0) {
+    return 0;
+  }
+
+  const float inverse_block_size = inverse_voxel_size_ / kBlockSize;
+  int32_t min_block[3];
+  int32_t max_block[3];
+  for (int axis = 0; axis < 3; ++axis) {
+    min_block[axis] = FloorToInt((center[axis] - radius) * inverse_block_size);
+    max_block[axis] = FloorToInt((center[axis] + radius) * inverse_block_size);
+  }
+
+  const float radius_squared = radius * radius;
+  for (int32_t z = min_block[2]; z <= max_block[2]; ++z) {
+    for (int32_t y = min_block[1]; y <= max_block[1]; ++y) {
+      for (int32_t x = min_block[0]; x <= max_block[0]; ++x) {
+        const int32_t index = FindBlock(BlockKey(x, y, z));
+        if (index < 0) {
+          continue;
+        }
+        VisitBlock(blocks_[index], [&](const glm::vec3& point) {
+          const glm::vec3 offset = point - center;
+          if (glm::dot(offset, offset) <= radius_squared) {
+            points->push_back(point);
+          }
+        });
+      }
+    }
+  }
+  return points->size();
+}
+
+size_t PointMap::NearestNeighbors(const glm::vec3& query, size_t k,
+                                  float max_distance,
+                                  std::vector<glm::vec3>* points) const {
+  points->clear();
+  if (k == 0 || max_distance < 0.0f || block_count_ == 0) {
+    return 0;
+  }
+
+  // Visit blocks in shells of growing Chebyshev distance around the block of
+  // the query. Everything beyond shell r is at least r block sizes away, so
+  // the search stops once the k-th candidate is closer than that.
+  const float block_size = voxel_size_ * kBlockSize;
+  int32_t query_block[3];
+  for (int axis = 0; axis < 3; ++axis) {
+    query_block[axis] = FloorToInt(query[axis] / block_size);
+  }
+  const int32_t max_ring =
+      static_cast<int32_t>(std::ceil(max_distance / block_size));
+  const float max_distance_squared = max_distance * max_distance;
+
+  // Max heap on the squared distance of the candidates.
+  std::vector<std::pair<float, glm::vec3>> candidates;
+  candidates.reserve(k);
+  auto farther = [](const std::pair<float, glm::vec3>& a,
+                    const std::pair<float, glm::vec3>& b) {
+    return a.first < b.first;
+  };
+  auto visit = [&](const glm::vec3& point) {
+    const glm::vec3 offset = point - query;
+    const float distance_squared = glm::dot(offset, offset);
+    if (distance_squared > max_distance_squared) {
+      return;
+    }
+    if (candidates.size() < k) {
+      candidates.push_back(std::make_pair(distance_squared, point));
+      std::push_heap(candidates.begin(), candidates.end(), farther);
+    } else if (distance_squared < candidates.front().first) {
+      std::pop_heap(candidates.begin(), candidates.end(), farther);
+      candidates.back() = std::make_pair(distance_squared, point);
+      std::push_heap(candidates.begin(), candidates.end(), farther);
+    }
+  };
+
+  for (int32_t ring = 0; ring <= max_ring; ++ring) {
+    for (int32_t dz = -ring; dz <= ring; ++dz) {
+      for (int32_t dy = -ring; dy <= ring; ++dy) {
+        const bool on_face = std::abs(dz) == ring || std::abs(dy) == ring;
+        // Inside the shell only the two x faces belong to this ring.
+        const int32_t dx_step = on_face ? 1 : std::max(1, 2 * ring);
+        for (int32_t dx = -ring; dx <= ring; dx += dx_step) {
+          const int32_t index =
+              FindBlock(BlockKey(query_block[0] + dx, query_block[1] + dy,
+                                 query_block[2] + dz));
+          if (index >= 0) {
+            VisitBlock(blocks_[index], visit);
+          }
+        }
+      }
+    }
+    const float ring_distance = ring * block_size;
+    if (candidates.size() == k &&
+        candidates.front().first <= ring_distance * ring_distance) {
+      break;
+    }
+  }
+
+  std::sort_heap(candidates.begin(), candidates.end(), farther);
+  points->reserve(candidates.size());
+  for (const std::pair<float, glm::vec3>& candidate : candidates) {
+    points->push_back(candidate.second);
+  }
+  return points->size();
+}
+
+size_t PointMap::GetVisiblePoints(ViewFrustum* frustum,
+                                  std::vector<float>* xyz) const {
+  xyz->clear();
+  const float block_size = voxel_size_ * kBlockSize;
+  for (size_t i = 0; i < block_count_; ++i) {
+    const Block& block = blocks_[i];
+    const glm::vec3 min = glm::vec3(BlockCoordinate(block.key, 0),
+                                    BlockCoordinate(block.key, 1),
+                                    BlockCoordinate(block.key, 2)) *
+                          block_size;
+    if (!frustum->IsBoxVisible(min, min + glm::vec3(block_size))) {
+      continue;
+    }
+    VisitBlock(block, [xyz](const glm::vec3& point) {
+      xyz->push_back(point.x);
+      xyz->push_back(point.y);
+      xyz->push_back(point.z);
+    });
+  }
+  return xyz->size() / 3;
+}
+
+size_t PointMap::GetLodPoints(ViewFrustum* frustum, const LodOptions& options,
+                              std::vector<float>* points) const {
+  points->clear();
+  const float block_size = voxel_size_ * kBlockSize;
+  const glm::vec3& eye = frustum->GetEye();
+
+  // Pick the level of every visible block first, to check the budget before
+  // emitting anything.
+  std::vector<std::pair<int32_t, int>> visible_blocks;
+  size_t point_count = 0;
+  for (size_t i = 0; i < block_count_; ++i) {
+    const Block& block = blocks_[i];
+    const glm::vec3 min = glm::vec3(BlockCoordinate(block.key, 0),
+                                    BlockCoordinate(block.key, 1),
+                                    BlockCoordinate(block.key, 2)) *
+                          block_size;
+    const glm::vec3 max = min + glm::vec3(block_size);
+    if (!frustum->IsBoxVisible(min, max)) {
+      continue;
+    }
+
+    // Distance from the eye to the nearest point of the block.
+    const glm::vec3 outside =
+        glm::max(glm::max(min - eye, eye - max), glm::vec3(0.0f));
+    const float distance = std::max(glm::length(outside), voxel_size_);
+    int level = 0;
+    float spacing = voxel_size_ * options.pixels_per_meter / distance;
+    while (level < kLodLevelCount - 1 && spacing < options.point_spacing) {
+      ++level;
+      spacing *= 2.0f;
+    }
+    visible_blocks.push_back(std::make_pair(static_cast<int32_t>(i), level));
+    point_count += block.lod_counts[level];
+  }
+
+  int bias = 0;
+  while (point_count > options.max_point_count && bias < kLodLevelCount - 1) {
+    ++bias;
+    point_count = 0;
+    for (const std::pair<int32_t, int>& visible : visible_blocks) {
+      const int level = std::min(visible.second + bias, kLodLevelCount - 1);
+      point_count += blocks_[visible.first].lod_counts[level];
+    }
+  }
+
+  points->reserve(std::min(point_count, options.max_point_count) * 4);
+  const size_t max_size = options.max_point_count * 4;
+  for (const std::pair<int32_t, int>& visible : visible_blocks) {
+    const int level = std::min(visible.second + bias, kLodLevelCount - 1);
+    VisitLod(blocks_[visible.first], level,
+             [points, max_size](const glm::vec3& point, float size) {
+               if (points->size() < max_size) {
+                 points->push_back(point.x);
+                 points->push_back(point.y);
+                 points->push_back(point.z);
+                 points->push_back(size);
+               }
+             });
+  }
+  return points->size() / 4;
+}
+
+uint64_t PointMap::BlockKey(int32_t x, int32_t y, int32_t z) {
+  return (static_cast<uint64_t>(x + kKeyBias) & kKeyMask) |
+         ((static_cast<uint64_t>(y + kKeyBias) & kKeyMask) << kKeyBits) |
+         ((static_cast<uint64_t>(z + kKeyBias) & kKeyMask) << (2 * kKeyBits));
+}
+
+int32_t PointMap::FindBlock(uint64_t key) const {
+  size_t slot = HashKey(key) & table_mask_;
+  while (table_[slot] >= 0) {
+    if (blocks_[table_[slot]].key == key) {
+      return table_[slot];
+    }
+    slot = (slot + 1) & table_mask_;
+  }
+  return -1;
+}
+
+int32_t PointMap::AcquireBlock(uint64_t key) {
+  int32_t index = FindBlock(key);
+  if (index >= 0) {
+    if (index != newest_) {
+      Unlink(index);
+      LinkNewest(index);
+    }
+    return index;
+  }
+
+  if (block_count_ < blocks_.size()) {
+    index = static_cast<int32_t>(block_count_++);
+  } else {
+    // The pool is full, recycle the block updated least recently.
+    index = oldest_;
+    for (int word = 0; word < kMaskWords; ++word) {
+      point_count_ -= __builtin_popcountll(blocks_[index].mask[word]);
+    }
+    if (block_store_ != nullptr) {
+      StoreBlock(index);
+    }
+    EraseSlot(index);
+    Unlink(index);
+  }
+
+  if (block_store_ == nullptr || !RestoreBlock(key, index)) {
+    Block& block = blocks_[index];
+    block.key = key;
+    std::memset(block.mask, 0, sizeof(block.mask));
+    std::memset(block.lod_counts, 0, sizeof(block.lod_counts));
+  }
+  InsertSlot(index);
+  LinkNewest(index);
+  return index;
+}
+
+void PointMap::StoreBlock(int32_t index) {
+  Block& block = blocks_[index];
+  // A block recycled during an Insert() may not have its levels yet.
+  if (block.is_lod_dirty) {
+    RebuildLods(&block);
+  }
+  // Clear the stale entries so they compress away.
+  for (int i = 0; i < kVoxelsPerBlock; ++i) {
+    if ((block.mask[i >> 6] & (1ull << (i & 63))) == 0) {
+      std::memset(&block.voxels[i], 0, sizeof(Voxel));
+    }
+  }
+  for (Voxel& lod_voxel : block.lod_voxels) {
+    if (lod_voxel.count == 0) {
+      std::memset(&lod_voxel, 0, sizeof(Voxel));
+    }
+  }
+  block_store_->Write(block.key, &block, sizeof(Block));
+}
+
+bool PointMap::RestoreBlock(uint64_t key, int32_t index) {
+  Block& block = blocks_[index];
+  const bool is_lod_dirty = block.is_lod_dirty;
+  const bool is_restored = block_store_->Take(key, &block, sizeof(Block));
+  block.is_lod_dirty = is_lod_dirty;
+  if (is_restored) {
+    for (int word = 0; word < kMaskWords; ++word) {
+      point_count_ += __builtin_popcountll(block.mask[word]);
+    }
+  }
+  return is_restored;
+}
+
+void PointMap::RemoveBlock(int32_t index) {
+  for (int word = 0; word < kMaskWords; ++word) {
+    point_count_ -= __builtin_popcountll(blocks_[index].mask[word]);
+  }
+  EraseSlot(index);
+  Unlink(index);
+
+  const int32_t last = static_cast<int32_t>(--block_count_);
+  if (index == last) {
+    return;
+  }
+  // Move the last block into the hole, then point its table slot and its
+  // recency neighbors at the new index.
+  Block& block = blocks_[index];
+  block = blocks_[last];
+  size_t slot = HashKey(block.key) & table_mask_;
+  while (table_[slot] != last) {
+    slot = (slot + 1) & table_mask_;
+  }
+  table_[slot] = index;
+  if (block.newer >= 0) {
+    blocks_[block.newer].older = index;
+  } else {
+    newest_ = index;
+  }
+  if (block.older >= 0) {
+    blocks_[block.older].newer = index;
+  } else {
+    oldest_ = index;
+  }
+}
+
+void PointMap::CollectAbsentKeys(const glm::vec3& center, float radius,
+                                 std::vector<uint64_t>* keys) const {
+  keys->clear();
+  if (!(radius >= 0.0f)) {
+    return;
+  }
+  const float block_size = voxel_size_ * kBlockSize;
+  const float inverse_block_size = 1.0f / block_size;
+  const int32_t max_block_coordinate = kKeyBias - 1;
+  int32_t min_block[3];
+  int32_t max_block[3];
+  for (int axis = 0; axis < 3; ++axis) {
+    min_block[axis] = std::max(
+        FloorToInt((center[axis] - radius) * inverse_block_size),
+        -max_block_coordinate);
+    max_block[axis] =
+        std::min(FloorToInt((center[axis] + radius) * inverse_block_size),
+                 max_block_coordinate);
+  }
+
+  const float radius_squared = radius * radius;
+  std::vector<std::pair<float, uint64_t>> candidates;
+  for (int32_t z = min_block[2]; z <= max_block[2]; ++z) {
+    for (int32_t y = min_block[1]; y <= max_block[1]; ++y) {
+      for (int32_t x = min_block[0]; x <= max_block[0]; ++x) {
+        const glm::vec3 min = glm::vec3(x, y, z) * block_size;
+        const float distance_squared =
+            BoxDistanceSquared(min, min + glm::vec3(block_size), center);
+        const uint64_t key = BlockKey(x, y, z);
+        if (distance_squared <= radius_squared && FindBlock(key) < 0) {
+          candidates.push_back(std::make_pair(distance_squared, key));
+        }
+      }
+    }
+  }
+  std::sort(candidates.begin(), candidates.end());
+  keys->reserve(candidates.size());
+  for (const std::pair<float, uint64_t>& candidate : candidates) {
+    keys->push_back(candidate.second);
+  }
+}
+
+void PointMap::InsertSlot(int32_t block) {
+  size_t slot = HashKey(blocks_[block].key) & table_mask_;
+  while (table_[slot] >= 0) {
+    slot = (slot + 1) & table_mask_;
+  }
+  table_[slot] = block;
+}
+
+void PointMap::EraseSlot(int32_t block) {
+  size_t hole = HashKey(blocks_[block].key) & table_mask_;
+  while (table_[hole] != block) {
+    hole = (hole + 1) & table_mask_;
+  }
+
+  // Shift later entries of the probe sequence back into the hole, so lookups
+  // never stop early at it.
+  size_t slot = hole;
+  while (true) {
+    slot = (slot + 1) & table_mask_;
+    const int32_t index = table_[slot];
+    if (index < 0) {
+      break;
+    }
+    const size_t home = HashKey(blocks_[index].key) & table_mask_;
+    const bool movable = slot > hole ? (home <= hole || home > slot)
+                                     : (home <= hole && home > slot);
+    if (movable) {
+      table_[hole] = index;
+      hole = slot;
+    }
+  }
+  table_[hole] = -1;
+}
+
+void PointMap::RebuildLods(Block* block) {
+  float sums[kLodVoxelCount][3];
+  uint32_t counts[kLodVoxelCount];
+  std::memset(sums, 0, sizeof(sums));
+  std::memset(counts, 0, sizeof(counts));
+
+  // Every level is the plain mean of the voxels it covers, computed straight
+  // from level 0 so coarse levels do not weigh sparse children up.
+  uint32_t voxel_count = 0;
+  for (int word = 0; word < kMaskWords; ++word) {
+    uint64_t bits = block->mask[word];
+    while (bits) {
+      const int index = word * 64 + __builtin_ctzll(bits);
+      bits &= bits - 1;
+      ++voxel_count;
+      const int x = index % kBlockSize;
+      const int y = (index / kBlockSize) % kBlockSize;
+      const int z = index / (kBlockSize * kBlockSize);
+      const Voxel& voxel = block->voxels[index];
+      for (int level = 1; level < kLodLevelCount; ++level) {
+        const int edge = kLodEdges[level];
+        const int entry = kLodOffsets[level] +
+                          ((z >> level) * edge + (y >> level)) * edge +
+                          (x >> level);
+        sums[entry][0] += voxel.mean[0];
+        sums[entry][1] += voxel.mean[1];
+        sums[entry][2] += voxel.mean[2];
+        ++counts[entry];
+      }
+    }
+  }
+
+  block->lod_counts[0] = voxel_count;
+  for (int level = 1; level < kLodLevelCount; ++level) {
+    block->lod_counts[level] = 0;
+    const int end = kLodOffsets[level] +
+                    kLodEdges[level] * kLodEdges[level] * kLodEdges[level];
+    for (int entry = kLodOffsets[level]; entry < end; ++entry) {
+      Voxel& lod_voxel = block->lod_voxels[entry];
+      lod_voxel.count = counts[entry];
+      if (counts[entry] == 0) {
+        continue;
+      }
+      const float inverse_count = 1.0f / counts[entry];
+      lod_voxel.mean[0] = sums[entry][0] * inverse_count;
+      lod_voxel.mean[1] = sums[entry][1] * inverse_count;
+      lod_voxel.mean[2] = sums[entry][2] * inverse_count;
+      ++block->lod_counts[level];
+    }
+  }
+}
+
+void PointMap::Unlink(int32_t block) {
+  Block& entry = blocks_[block];
+  if (entry.newer >= 0) {
+    blocks_[entry.newer].older = entry.older;
+  } else {
+    newest_ = entry.older;
+  }
+  if (entry.older >= 0) {
+    blocks_[entry.older].newer = entry.newer;
+  } else {
+    oldest_ = entry.newer;
+  }
+}
+
+void PointMap::LinkNewest(int32_t block) {
+  Block& entry = blocks_[block];
+  entry.newer = -1;
+  entry.older = newest_;
+  if (newest_ >= 0) {
+    blocks_[newest_].newer = block;
+  } else {
+    oldest_ = block;
+  }
+  newest_ = block;
+}
+
+template <typename Visitor>
+void PointMap::VisitLod(const Block& block, int level, Visitor visit) const {
+  const float size = voxel_size_ * (kBlockSize / kLodEdges[level]);
+  if (level == 0) {
+    VisitBlock(block, [&visit, size](const glm::vec3& point) {
+      visit(point, size);
+    });
+    return;
+  }
+  const int end = kLodOffsets[level] +
+                  kLodEdges[level] * kLodEdges[level] * kLodEdges[level];
+  for (int entry = kLodOffsets[level]; entry < end; ++entry) {
+    const Voxel& voxel = block.lod_voxels[entry];
+    if (voxel.count > 0) {
+      visit(glm::vec3(voxel.mean[0], voxel.mean[1], voxel.mean[2]), size);
+    }
+  }
+}
+
+template <typename Visitor>
+void PointMap::VisitBlock(const Block& block, Visitor visit) const {
+  for (int word = 0; word < kMaskWords; ++word) {
+    uint64_t bits = block.mask[word];
+    while (bits) {
+      const int index = word * 64 + __builtin_ctzll(bits);
+      bits &= bits - 1;
+      const Voxel& voxel = block.voxels[index];
+      visit(glm::vec3(voxel.mean[0], voxel.mean[1], voxel.mean[2]));
+    }
+  }
+}
+
+}  // namespace tango_gl
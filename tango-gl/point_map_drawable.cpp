@@ -0,0 +1,83 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "tango-gl/point_map_drawable.h"
+
+#include "tango-gl/counters.h"
+#include "tango-gl/frame_constants.h"
+#include "tango-gl/program_cache.h"
+#include "tango-gl/render_state.h"
+#include "tango-gl/shader_variants.h"
+
+namespace tango_gl {
+
+PointMapDrawable::PointMapDrawable()
+    : vertex_buffer_(GL_ARRAY_BUFFER, GL_STREAM_DRAW),
+      color_(0.85f, 0.85f, 0.85f),
+      point_size_scale_(1.0f),
+      max_point_size_(64.0f) {
+  const shader_variants::Variant* variant =
+      shader_variants::Acquire(shader_variants::kPointSprite);
+  if (variant == nullptr) {
+    LOGE("Could not create program.");
+    shader_program_ = 0;
+    return;
+  }
+  shader_program_ = variant->program;
+  attrib_vertices_ = variant->attributes[shader_variants::kVertexAttribute];
+  uniform_mvp_mat_ = variant->uniforms[shader_variants::kMvp];
+  uniform_color_ = variant->uniforms[shader_variants::kColor];
+  uniform_point_scale_ = variant->uniforms[shader_variants::kPointScale];
+  uniform_max_point_size_ = variant->uniforms[shader_variants::kMaxPointSize];
+}
+
+PointMapDrawable::~PointMapDrawable() {
+  program_cache::ReleaseProgram(shader_program_);
+}
+
+void PointMapDrawable::Render(const glm::mat4& projection_mat,
+                              const glm::mat4& view_mat,
+                              float pixels_per_meter,
+                              const std::vector<float>& points) {
+  if (points.empty()) {
+    return;
+  }
+  vertex_buffer_.Update(points.data(), points.size() * sizeof(float), 0);
+
+  RenderState::UseProgram(shader_program_);
+  RenderState::Enable(GL_VERTEX_PROGRAM_POINT_SIZE);
+  const glm::mat4 mvp_mat =
+      FrameConstants::GetViewProjection(projection_mat, view_mat);
+  glUniformMatrix4fv(uniform_mvp_mat_, 1, GL_FALSE, glm::value_ptr(mvp_mat));
+  glUniform4f(uniform_color_, color_.r, color_.g, color_.b, 1.0f);
+  glUniform1f(uniform_point_scale_, pixels_per_meter * point_size_scale_);
+  glUniform1f(uniform_max_point_size_, max_point_size_);
+
+  if (!vertex_array_.Bind()) {
+    vertex_buffer_.Bind();
+    vertex_array_.EnableAttribute(attrib_vertices_);
+    glVertexAttribPointer(attrib_vertices_, 4, GL_FLOAT, GL_FALSE, 0,
+                          nullptr);
+  }
+  Counters::Increment(Counters::kDrawCalls);
+  glDrawArrays(GL_POINTS, 0, points.size() / 4);
+  vertex_array_.Unbind();
+
+  util::CheckGlError("PointMapDrawable::Render");
+}
+
+}  // namespace tango_gl
@@ -0,0 +1,81 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tango-gl/counters.h"
+#include "tango-gl/cpu_features.h"
+#include "tango-gl/point_projection.h"
+
+namespace {
+// Project points [begin, end). Also the tail of the NEON kernel.
+size_t ProjectPointsScalar(const float* points, size_t begin, size_t end,
+                           const glm::mat4& camera_T_points,
+                           const tango_gl::projection::CameraIntrinsics& in,
+                           int32_t* pixels, float* depths) {
+  using namespace tango_gl::projection;
+  const float width = static_cast<float>(in.width);
+  const float height = static_cast<float>(in.height);
+  size_t projected = 0;
+  for (size_t i = begin; i < end; ++i) {
+    const float* point = points + i * 3;
+    glm::vec4 camera_point =
+        camera_T_points * glm::vec4(point[0], point[1], point[2], 1.0f);
+    if (depths != nullptr) {
+      depths[i] = camera_point.z;
+    }
+
+    pixels[i] = kInvalidPixel;
+    if (camera_point.z <= 0.0f) {
+      continue;
+    }
+    float pixel_x = in.fx * (camera_point.x / camera_point.z) + in.cx;
+    float pixel_y = in.fy * (camera_point.y / camera_point.z) + in.cy;
+    // Compared as floats so far away pixels never overflow the int cast.
+    if (pixel_x >= 0.0f && pixel_x < width && pixel_y >= 0.0f &&
+        pixel_y < height) {
+      pixels[i] = PackPixel(static_cast<int32_t>(pixel_x),
+                            static_cast<int32_t>(pixel_y));
+      ++projected;
+    }
+  }
+  return projected;
+}
+}  // namespace
+
+namespace tango_gl {
+namespace projection {
+
+size_t ProjectPoints(const float* points, size_t point_count,
+                     const glm::mat4& camera_T_points,
+                     const CameraIntrinsics& intrinsics, int32_t* pixels,
+                     float* depths) {
+  Counters::Add(Counters::kPointsProjected, point_count);
+  size_t begin = 0;
+  size_t projected = 0;
+#if defined(TANGO_GL_HAS_NEON)
+  if (cpu_features::IsNeonAvailable()) {
+    begin = point_count & ~static_cast<size_t>(3);
+    projected = internal::ProjectPointsNeon(points, point_count,
+                                            camera_T_points, intrinsics,
+                                            pixels, depths);
+  }
+#endif
+  return projected + ProjectPointsScalar(points, begin, point_count,
+                                         camera_T_points, intrinsics, pixels,
+                                         depths);
+}
+
+}  // namespace projection
+}  // namespace tango_gl
@@ -0,0 +1,119 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// This file is only compiled with NEON enabled (the ".neon" suffix in
+// Android.mk), the kernel is selected at runtime by point_projection.cpp.
+
+#include <arm_neon.h>
+
+#include "glm/gtc/type_ptr.hpp"
+#include "tango-gl/point_projection.h"
+
+namespace {
+// 1 / value from the reciprocal estimate and two Newton-Raphson steps, close
+// to full float precision.
+inline float32x4_t Reciprocal(const float32x4_t& value) {
+  float32x4_t reciprocal = vrecpeq_f32(value);
+  reciprocal = vmulq_f32(vrecpsq_f32(value, reciprocal), reciprocal);
+  reciprocal = vmulq_f32(vrecpsq_f32(value, reciprocal), reciprocal);
+  return reciprocal;
+}
+}  // namespace
+
+namespace tango_gl {
+namespace projection {
+namespace internal {
+
+size_t ProjectPointsNeon(const float* points, size_t point_count,
+                         const glm::mat4& camera_T_points,
+                         const CameraIntrinsics& intrinsics, int32_t* pixels,
+                         float* depths) {
+  // glm matrices are column major, m[column * 4 + row].
+  const float* m = glm::value_ptr(camera_T_points);
+  const float32x4_t m00 = vdupq_n_f32(m[0]);
+  const float32x4_t m10 = vdupq_n_f32(m[1]);
+  const float32x4_t m20 = vdupq_n_f32(m[2]);
+  const float32x4_t m01 = vdupq_n_f32(m[4]);
+  const float32x4_t m11 = vdupq_n_f32(m[5]);
+  const float32x4_t m21 = vdupq_n_f32(m[6]);
+  const float32x4_t m02 = vdupq_n_f32(m[8]);
+  const float32x4_t m12 = vdupq_n_f32(m[9]);
+  const float32x4_t m22 = vdupq_n_f32(m[10]);
+  const float32x4_t m03 = vdupq_n_f32(m[12]);
+  const float32x4_t m13 = vdupq_n_f32(m[13]);
+  const float32x4_t m23 = vdupq_n_f32(m[14]);
+
+  const float32x4_t fx = vdupq_n_f32(intrinsics.fx);
+  const float32x4_t fy = vdupq_n_f32(intrinsics.fy);
+  const float32x4_t cx = vdupq_n_f32(intrinsics.cx);
+  const float32x4_t cy = vdupq_n_f32(intrinsics.cy);
+  const float32x4_t width = vdupq_n_f32(static_cast<float>(intrinsics.width));
+  const float32x4_t height =
+      vdupq_n_f32(static_cast<float>(intrinsics.height));
+  const float32x4_t zero = vdupq_n_f32(0.0f);
+  const int32x4_t invalid = vdupq_n_s32(kInvalidPixel);
+
+  // Subtracting the all ones mask of a valid lane counts it up by one.
+  uint32x4_t projected = vdupq_n_u32(0);
+
+  const size_t count = point_count & ~static_cast<size_t>(3);
+  for (size_t i = 0; i < count; i += 4) {
+    // De-interleave four xyz points into x, y and z vectors.
+    float32x4x3_t xyz = vld3q_f32(points + i * 3);
+
+    float32x4_t camera_x = vmlaq_f32(m03, m00, xyz.val[0]);
+    camera_x = vmlaq_f32(camera_x, m01, xyz.val[1]);
+    camera_x = vmlaq_f32(camera_x, m02, xyz.val[2]);
+    float32x4_t camera_y = vmlaq_f32(m13, m10, xyz.val[0]);
+    camera_y = vmlaq_f32(camera_y, m11, xyz.val[1]);
+    camera_y = vmlaq_f32(camera_y, m12, xyz.val[2]);
+    float32x4_t camera_z = vmlaq_f32(m23, m20, xyz.val[0]);
+    camera_z = vmlaq_f32(camera_z, m21, xyz.val[1]);
+    camera_z = vmlaq_f32(camera_z, m22, xyz.val[2]);
+
+    if (depths != nullptr) {
+      vst1q_f32(depths + i, camera_z);
+    }
+
+    const float32x4_t inverse_z = Reciprocal(camera_z);
+    const float32x4_t pixel_x =
+        vmlaq_f32(cx, vmulq_f32(camera_x, inverse_z), fx);
+    const float32x4_t pixel_y =
+        vmlaq_f32(cy, vmulq_f32(camera_y, inverse_z), fy);
+
+    // Comparisons against NaN are false, so points with z == 0 are rejected
+    // as well.
+    uint32x4_t valid = vcgtq_f32(camera_z, zero);
+    valid = vandq_u32(valid, vcgeq_f32(pixel_x, zero));
+    valid = vandq_u32(valid, vcltq_f32(pixel_x, width));
+    valid = vandq_u32(valid, vcgeq_f32(pixel_y, zero));
+    valid = vandq_u32(valid, vcltq_f32(pixel_y, height));
+
+    const int32x4_t packed = vorrq_s32(vshlq_n_s32(vcvtq_s32_f32(pixel_y), 16),
+                                       vcvtq_s32_f32(pixel_x));
+    vst1q_s32(pixels + i, vbslq_s32(valid, packed, invalid));
+    projected = vsubq_u32(projected, valid);
+  }
+
+  uint32x2_t sum =
+      vadd_u32(vget_low_u32(projected), vget_high_u32(projected));
+  sum = vpadd_u32(sum, sum);
+  return vget_lane_u32(sum, 0);
+}
+
+}  // namespace internal
+}  // namespace projection
+}  // namespace tango_gl
@@ -0,0 +1,113 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "tango-gl/pose_history.h"
+#include "tango-gl/conversions.h"
+
+namespace {
+// Largest gap between two poses interpolated across, in seconds. The pose
+// callback runs at about 100Hz, larger gaps mean poses were dropped.
+const double kMaxInterpolationGap = 0.1;
+}  // namespace
+
+namespace tango_gl {
+
+PoseHistory::PoseHistory(size_t capacity)
+    : samples_(capacity > 0 ? capacity : 1), first_(0), count_(0) {}
+
+void PoseHistory::Add(double timestamp, const double* translation,
+                      const double* orientation) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (count_ > 0 && timestamp <= samples_[Index(count_ - 1)].timestamp) {
+    return;
+  }
+  Sample* sample;
+  if (count_ < samples_.size()) {
+    sample = &samples_[Index(count_)];
+    ++count_;
+  } else {
+    sample = &samples_[first_];
+    first_ = Index(1);
+  }
+  sample->timestamp = timestamp;
+  sample->pose = conversions::TransformFromArrays(translation, orientation);
+}
+
+void PoseHistory::Clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  first_ = 0;
+  count_ = 0;
+}
+
+bool PoseHistory::GetPose(double timestamp, glm::mat4* pose) const {
+  RigidTransform rigid_pose;
+  if (!GetPose(timestamp, &rigid_pose)) {
+    return false;
+  }
+  *pose = rigid_pose.ToMatrix();
+  return true;
+}
+
+bool PoseHistory::GetLatestPose(double* timestamp,
+                                RigidTransform* pose) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (count_ == 0) {
+    return false;
+  }
+  const Sample& latest = samples_[Index(count_ - 1)];
+  *timestamp = latest.timestamp;
+  *pose = latest.pose;
+  return true;
+}
+
+bool PoseHistory::GetPose(double timestamp, RigidTransform* pose) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (count_ == 0 || timestamp < samples_[first_].timestamp ||
+      timestamp > samples_[Index(count_ - 1)].timestamp) {
+    return false;
+  }
+
+  // Binary search for the first sample not older than the timestamp.
+  size_t low = 0;
+  size_t high = count_ - 1;
+  while (low < high) {
+    size_t middle = (low + high) / 2;
+    if (samples_[Index(middle)].timestamp < timestamp) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+  const Sample& after = samples_[Index(low)];
+  if (after.timestamp == timestamp) {
+    *pose = after.pose;
+    return true;
+  }
+
+  const Sample& before = samples_[Index(low - 1)];
+  const double gap = after.timestamp - before.timestamp;
+  if (gap > kMaxInterpolationGap) {
+    return false;
+  }
+  const float t = static_cast<float>((timestamp - before.timestamp) / gap);
+  *pose = RigidTransform(
+      glm::slerp(before.pose.GetRotation(), after.pose.GetRotation(), t),
+      glm::mix(before.pose.GetTranslation(), after.pose.GetTranslation(), t));
+  return true;
+}
+
+}  // namespace tango_gl
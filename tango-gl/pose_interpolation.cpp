@@ -0,0 +1,64 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <cmath>
+
+#include "tango-gl/cpu_features.h"
+#include "tango-gl/pose_interpolation.h"
+
+namespace tango_gl {
+namespace pose_interpolation {
+
+void Interpolate(const RigidTransform* before, const RigidTransform* after,
+                 const float* weights, size_t count, RigidTransform* poses) {
+#if defined(TANGO_GL_HAS_NEON)
+  if (cpu_features::IsNeonAvailable()) {
+    internal::InterpolateNeon(before, after, weights, count, poses);
+    return;
+  }
+#endif
+  for (size_t i = 0; i < count; ++i) {
+    const glm::quat& q0 = before[i].GetRotation();
+    glm::quat q1 = after[i].GetRotation();
+    const float dot = glm::dot(q0, q1);
+    if (std::abs(dot) < kMinLerpDot) {
+      poses[i] = internal::Slerp(before[i], after[i], weights[i]);
+      continue;
+    }
+    if (dot < 0.0f) {
+      q1 = -q1;
+    }
+    const float t = weights[i];
+    const glm::quat rotation = glm::normalize(q0 * (1.0f - t) + q1 * t);
+    poses[i] = RigidTransform(
+        rotation, glm::mix(before[i].GetTranslation(),
+                           after[i].GetTranslation(), t));
+  }
+}
+
+namespace internal {
+
+RigidTransform Slerp(const RigidTransform& before, const RigidTransform& after,
+                     float weight) {
+  return RigidTransform(
+      glm::slerp(before.GetRotation(), after.GetRotation(), weight),
+      glm::mix(before.GetTranslation(), after.GetTranslation(), weight));
+}
+
+}  // namespace internal
+}  // namespace pose_interpolation
+}  // namespace tango_gl
@@ -0,0 +1,91 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// This file is only compiled with NEON enabled (the ".neon" suffix in
+// Android.mk), the kernel is selected at runtime by pose_interpolation.cpp.
+
+#include <arm_neon.h>
+
+#include <cmath>
+
+#include "tango-gl/pose_interpolation.h"
+
+namespace {
+// Sum of the 4 lanes, in every lane.
+inline float32x4_t SumLanes(const float32x4_t& value) {
+  float32x2_t sum = vadd_f32(vget_low_f32(value), vget_high_f32(value));
+  sum = vpadd_f32(sum, sum);
+  return vcombine_f32(sum, sum);
+}
+
+// 1 / sqrt(value) from the estimate and two Newton-Raphson steps.
+inline float32x4_t ReciprocalSqrt(const float32x4_t& value) {
+  float32x4_t estimate = vrsqrteq_f32(value);
+  estimate = vmulq_f32(
+      vrsqrtsq_f32(vmulq_f32(value, estimate), estimate), estimate);
+  estimate = vmulq_f32(
+      vrsqrtsq_f32(vmulq_f32(value, estimate), estimate), estimate);
+  return estimate;
+}
+
+// x, y, z and 0, without reading past the vec3.
+inline float32x4_t LoadVec3(const glm::vec3& v) {
+  return vcombine_f32(vld1_f32(&v.x), vld1_lane_f32(&v.z, vdup_n_f32(0.0f), 0));
+}
+}  // namespace
+
+namespace tango_gl {
+namespace pose_interpolation {
+namespace internal {
+
+void InterpolateNeon(const RigidTransform* before, const RigidTransform* after,
+                     const float* weights, size_t count,
+                     RigidTransform* poses) {
+  for (size_t i = 0; i < count; ++i) {
+    // glm quaternions are stored x, y, z, w.
+    const float32x4_t q0 = vld1q_f32(&before[i].GetRotation().x);
+    float32x4_t q1 = vld1q_f32(&after[i].GetRotation().x);
+    const float32x4_t dot = SumLanes(vmulq_f32(q0, q1));
+    const float dot_value = vgetq_lane_f32(dot, 0);
+    if (std::abs(dot_value) < kMinLerpDot) {
+      poses[i] = Slerp(before[i], after[i], weights[i]);
+      continue;
+    }
+    if (dot_value < 0.0f) {
+      q1 = vnegq_f32(q1);
+    }
+    const float32x4_t t = vdupq_n_f32(weights[i]);
+    float32x4_t q = vmlaq_f32(q0, vsubq_f32(q1, q0), t);
+    q = vmulq_f32(q, ReciprocalSqrt(SumLanes(vmulq_f32(q, q))));
+
+    const float32x4_t p0 = LoadVec3(before[i].GetTranslation());
+    const float32x4_t p1 = LoadVec3(after[i].GetTranslation());
+    const float32x4_t p = vmlaq_f32(p0, vsubq_f32(p1, p0), t);
+
+    float rotation[4];
+    float translation[4];
+    vst1q_f32(rotation, q);
+    vst1q_f32(translation, p);
+    poses[i] = RigidTransform(
+        glm::quat(rotation[3], rotation[0], rotation[1], rotation[2]),
+        glm::vec3(translation[0], translation[1], translation[2]));
+  }
+}
+
+}  // namespace internal
+}  // namespace pose_interpolation
+}  // namespace tango_gl
@@ -0,0 +1,150 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+
+#include "tango-gl/pose_logger.h"
+#include "tango-gl/util.h"
+
+namespace {
+// How long the writer sleeps when the queue is empty. Log() never wakes it,
+// so the callback does not pay for a system call.
+const std::chrono::milliseconds kWritePeriod(5);
+}  // namespace
+
+namespace tango_gl {
+
+PoseLogger::PoseLogger(size_t queue_capacity)
+    : queue_(queue_capacity),
+      is_logging_(false),
+      is_stopping_(false),
+      dropped_count_(0),
+      file_(-1),
+      mapping_(nullptr),
+      mapping_size_(0),
+      record_count_(0) {}
+
+PoseLogger::~PoseLogger() { Stop(); }
+
+bool PoseLogger::Start(const char* path, uint32_t record_capacity) {
+  if (writer_.joinable() || record_capacity == 0) {
+    return false;
+  }
+  file_ = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (file_ < 0) {
+    LOGE("PoseLogger: Could not create %s.", path);
+    return false;
+  }
+  mapping_size_ = sizeof(pose_log::FileHeader) +
+                  static_cast<size_t>(record_capacity) *
+                      sizeof(pose_log::Record);
+  if (ftruncate(file_, mapping_size_) != 0) {
+    LOGE("PoseLogger: Could not size %s.", path);
+    close(file_);
+    file_ = -1;
+    return false;
+  }
+  mapping_ = mmap(nullptr, mapping_size_, PROT_READ | PROT_WRITE, MAP_SHARED,
+                  file_, 0);
+  if (mapping_ == MAP_FAILED) {
+    LOGE("PoseLogger: Could not map %s.", path);
+    mapping_ = nullptr;
+    close(file_);
+    file_ = -1;
+    return false;
+  }
+
+  pose_log::FileHeader* header =
+      static_cast<pose_log::FileHeader*>(mapping_);
+  header->magic = pose_log::kMagic;
+  header->version = pose_log::kVersion;
+  header->record_size = sizeof(pose_log::Record);
+  header->record_capacity = record_capacity;
+  header->record_count = 0;
+  header->dropped_count = 0;
+
+  // Poses queued after the previous Stop() belong to no log.
+  pose_log::Record stale;
+  while (queue_.Pop(&stale)) {
+  }
+  record_count_ = 0;
+  dropped_count_.store(0, std::memory_order_relaxed);
+  is_stopping_.store(false, std::memory_order_relaxed);
+  writer_ = std::thread(&PoseLogger::WriteLoop, this);
+  is_logging_.store(true, std::memory_order_release);
+  return true;
+}
+
+void PoseLogger::Stop() {
+  if (!writer_.joinable()) {
+    return;
+  }
+  is_logging_.store(false, std::memory_order_relaxed);
+  is_stopping_.store(true, std::memory_order_release);
+  writer_.join();
+
+  munmap(mapping_, mapping_size_);
+  close(file_);
+  mapping_ = nullptr;
+  file_ = -1;
+}
+
+bool PoseLogger::Log(const TangoPoseData& pose) {
+  if (!is_logging_.load(std::memory_order_acquire)) {
+    return false;
+  }
+  pose_log::Record record;
+  record.timestamp = pose.timestamp;
+  std::copy(pose.orientation, pose.orientation + 4, record.pose.orientation);
+  std::copy(pose.translation, pose.translation + 3, record.pose.translation);
+  record.pose.status_code = pose.status_code;
+  record.pose.base_frame = pose.frame.base;
+  record.pose.target_frame = pose.frame.target;
+  record.pose.reserved = 0;
+  if (!queue_.Push(record)) {
+    dropped_count_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  return true;
+}
+
+void PoseLogger::WriteLoop() {
+  while (!is_stopping_.load(std::memory_order_acquire)) {
+    WriteQueued();
+    std::this_thread::sleep_for(kWritePeriod);
+  }
+  WriteQueued();
+}
+
+void PoseLogger::WriteQueued() {
+  pose_log::FileHeader* header =
+      static_cast<pose_log::FileHeader*>(mapping_);
+  pose_log::Record* records = reinterpret_cast<pose_log::Record*>(header + 1);
+  pose_log::Record record;
+  while (queue_.Pop(&record)) {
+    records[record_count_ % header->record_capacity] = record;
+    ++record_count_;
+  }
+  header->record_count = record_count_;
+  header->dropped_count = dropped_count_.load(std::memory_order_relaxed);
+}
+
+}  // namespace tango_gl
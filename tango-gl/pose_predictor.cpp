@@ -0,0 +1,144 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "tango-gl/pose_predictor.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+// Time span over which the velocities are estimated, a few pose callbacks.
+const double kVelocityWindow = 0.03;
+// Default for the longest extrapolation.
+const double kDefaultMaxExtrapolation = 0.05;
+// Predictions kept waiting for their actual pose, a bit more than a second of
+// frames at 60Hz with the default maximum extrapolation.
+const size_t kMaxPendingPredictions = 64;
+
+// Angle of the rotation from a to b, in radians.
+float RotationAngle(const glm::quat& a, const glm::quat& b) {
+  const float w = std::min(1.0f, std::abs(glm::dot(a, b)));
+  return 2.0f * std::acos(w);
+}
+}  // namespace
+
+namespace tango_gl {
+
+PosePredictor::PosePredictor(const PoseHistory* history)
+    : history_(history),
+      latency_(0.0),
+      max_extrapolation_(kDefaultMaxExtrapolation),
+      measurement_count_(0),
+      translation_error_sum_(0.0),
+      rotation_error_sum_(0.0) {}
+
+bool PosePredictor::Predict(double timestamp, RigidTransform* pose) {
+  double latest_timestamp;
+  RigidTransform latest;
+  if (!history_->GetLatestPose(&latest_timestamp, &latest)) {
+    return false;
+  }
+  MeasurePredictions(latest_timestamp);
+
+  const double target_timestamp = timestamp + latency_;
+  if (target_timestamp <= latest_timestamp) {
+    // Nothing to predict, the actual pose is already known.
+    return history_->GetPose(target_timestamp, pose) ||
+           history_->GetPose(latest_timestamp, pose);
+  }
+
+  RigidTransform earlier;
+  if (!history_->GetPose(latest_timestamp - kVelocityWindow, &earlier)) {
+    *pose = latest;
+    return true;
+  }
+
+  // Extrapolate the motion over the velocity window to the target time.
+  const float scale = static_cast<float>(
+      std::min(target_timestamp - latest_timestamp, max_extrapolation_) /
+      kVelocityWindow);
+  const glm::vec3 translation =
+      latest.GetTranslation() +
+      scale * (latest.GetTranslation() - earlier.GetTranslation());
+  glm::quat delta =
+      latest.GetRotation() * glm::conjugate(earlier.GetRotation());
+  if (delta.w < 0.0f) {
+    delta = -delta;
+  }
+  glm::quat rotation = latest.GetRotation();
+  const float angle = RotationAngle(delta, glm::quat(1.0f, 0.0f, 0.0f, 0.0f));
+  if (angle > 0.0f) {
+    rotation = glm::normalize(glm::angleAxis(angle * scale, glm::axis(delta)) *
+                              rotation);
+  }
+  *pose = RigidTransform(rotation, translation);
+
+  if (pending_.size() == kMaxPendingPredictions) {
+    pending_.erase(pending_.begin());
+  }
+  Prediction prediction;
+  prediction.timestamp = target_timestamp;
+  prediction.pose = *pose;
+  pending_.push_back(prediction);
+  return true;
+}
+
+void PosePredictor::MeasurePredictions(double latest_timestamp) {
+  size_t measured = 0;
+  for (const Prediction& prediction : pending_) {
+    if (prediction.timestamp > latest_timestamp) {
+      break;
+    }
+    ++measured;
+    RigidTransform actual;
+    if (!history_->GetPose(prediction.timestamp, &actual)) {
+      continue;
+    }
+    const float translation_error = glm::length(
+        actual.GetTranslation() - prediction.pose.GetTranslation());
+    const float rotation_error =
+        RotationAngle(actual.GetRotation(), prediction.pose.GetRotation());
+    ++measurement_count_;
+    translation_error_sum_ += translation_error;
+    rotation_error_sum_ += rotation_error;
+    if (error_listener_) {
+      error_listener_(prediction.timestamp, translation_error, rotation_error);
+    }
+  }
+  pending_.erase(pending_.begin(), pending_.begin() + measured);
+}
+
+float PosePredictor::GetMeanTranslationError() const {
+  return measurement_count_ == 0
+             ? 0.0f
+             : static_cast<float>(translation_error_sum_ / measurement_count_);
+}
+
+float PosePredictor::GetMeanRotationError() const {
+  return measurement_count_ == 0
+             ? 0.0f
+             : static_cast<float>(rotation_error_sum_ / measurement_count_);
+}
+
+void PosePredictor::Reset() {
+  pending_.clear();
+  measurement_count_ = 0;
+  translation_error_sum_ = 0.0;
+  rotation_error_sum_ = 0.0;
+}
+
+}  // namespace tango_gl
@@ -0,0 +1,255 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <string.h>
+
+#include <cmath>
+
+#include "tango-gl/pose_stream.h"
+#include "tango-gl/counters.h"
+#include "tango-gl/util.h"
+
+namespace tango_gl {
+
+PoseStream::Slot::Slot(size_t capacity)
+    : history(new SeqLock<HistoryEntry>[capacity]),
+      history_capacity(capacity),
+      history_count(0),
+      prev_pose(),
+      pose_counter(0) {}
+
+PoseStream::PoseStream(const TangoCoordinateFramePair* pairs, int pair_count,
+                       size_t history_capacity)
+    : pair_count_(pair_count),
+      relocalization_pair_(-1),
+      is_relocalized_(false),
+      relocalization_count_(0) {
+  if (pair_count_ > kMaxFramePairs) {
+    LOGE("PoseStream: %d frame pairs, only %d are kept.", pair_count_,
+         kMaxFramePairs);
+    pair_count_ = kMaxFramePairs;
+  }
+  if (history_capacity == 0) {
+    history_capacity = 1;
+  }
+  for (int i = 0; i < pair_count_; ++i) {
+    pairs_[i] = pairs[i];
+    slots_[i].reset(new Slot(history_capacity));
+  }
+}
+
+PoseStream::~PoseStream() {}
+
+int PoseStream::FindPair(TangoCoordinateFrameType base,
+                         TangoCoordinateFrameType target) const {
+  for (int i = 0; i < pair_count_; ++i) {
+    if (pairs_[i].base == base && pairs_[i].target == target) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+void PoseStream::OnPoseAvailable(const TangoPoseData& pose) {
+  Counters::Increment(Counters::kPosesReceived);
+  int pair = FindPair(pose.frame.base, pose.frame.target);
+  if (pair < 0) {
+    return;
+  }
+  Slot* slot = slots_[pair].get();
+
+  if (slot->prev_pose.status_code != pose.status_code) {
+    // Reset pose counter when the status changed.
+    slot->pose_counter = 0;
+  }
+  ++slot->pose_counter;
+
+  Snapshot snapshot;
+  snapshot.pose = pose;
+  snapshot.delta_time = pose.timestamp - slot->prev_pose.timestamp;
+  snapshot.pose_counter = slot->pose_counter;
+  slot->latest.Store(snapshot);
+
+  HistoryEntry entry;
+  entry.index = slot->history_count.load(std::memory_order_relaxed);
+  entry.pose = pose;
+  slot->history[entry.index % slot->history_capacity].Store(entry);
+  slot->history_count.store(entry.index + 1, std::memory_order_release);
+
+  if (pair == relocalization_pair_) {
+    bool is_relocalized = (pose.status_code == TANGO_POSE_VALID);
+    if (is_relocalized && !is_relocalized_.load(std::memory_order_relaxed)) {
+      relocalization_count_.fetch_add(1, std::memory_order_release);
+    }
+    is_relocalized_.store(is_relocalized, std::memory_order_release);
+  }
+  slot->prev_pose = pose;
+
+  std::lock_guard<std::mutex> lock(subscription_mutex_);
+  for (const std::unique_ptr<Subscription>& subscription : subscriptions_) {
+    if (subscription == nullptr || subscription->pair != pair) {
+      continue;
+    }
+    if (!ShouldDeliver(*subscription, pose)) {
+      subscription->skipped_count.fetch_add(1, std::memory_order_relaxed);
+      continue;
+    }
+    subscription->has_last_pose = true;
+    subscription->last_pose = pose;
+    subscription->delivered_count.fetch_add(1, std::memory_order_relaxed);
+    subscription->subscriber(pose);
+  }
+}
+
+void PoseStream::Reset() {
+  is_relocalized_ = false;
+  relocalization_count_ = 0;
+  for (int i = 0; i < pair_count_; ++i) {
+    Slot* slot = slots_[i].get();
+    slot->latest.Store(Snapshot());
+    slot->history_count.store(0, std::memory_order_release);
+    slot->prev_pose = TangoPoseData();
+    slot->pose_counter = 0;
+  }
+  std::lock_guard<std::mutex> lock(subscription_mutex_);
+  for (const std::unique_ptr<Subscription>& subscription : subscriptions_) {
+    if (subscription != nullptr) {
+      subscription->has_last_pose = false;
+    }
+  }
+}
+
+int PoseStream::Subscribe(int pair, const SubscriberOptions& options,
+                          const Subscriber& subscriber) {
+  if (pair < 0 || pair >= pair_count_) {
+    return -1;
+  }
+  std::lock_guard<std::mutex> lock(subscription_mutex_);
+  for (int i = 0; i < kMaxSubscribers; ++i) {
+    if (subscriptions_[i] != nullptr) {
+      continue;
+    }
+    Subscription* subscription = new Subscription();
+    subscription->pair = pair;
+    subscription->subscriber = subscriber;
+    subscription->min_interval =
+        options.max_rate > 0.0 ? 1.0 / options.max_rate : 0.0;
+    subscription->min_translation_squared =
+        static_cast<double>(options.min_translation) * options.min_translation;
+    subscription->max_orientation_dot =
+        options.min_rotation > 0.0f ? std::cos(0.5 * options.min_rotation)
+                                    : -1.0;
+    subscription->is_moving_always =
+        options.min_translation <= 0.0f && options.min_rotation <= 0.0f;
+    subscription->has_last_pose = false;
+    subscription->delivered_count = 0;
+    subscription->skipped_count = 0;
+    subscriptions_[i].reset(subscription);
+    return i;
+  }
+  LOGE("PoseStream: more than %d subscribers.", kMaxSubscribers);
+  return -1;
+}
+
+void PoseStream::Unsubscribe(int subscription) {
+  if (subscription >= 0 && subscription < kMaxSubscribers) {
+    std::lock_guard<std::mutex> lock(subscription_mutex_);
+    subscriptions_[subscription].reset();
+  }
+}
+
+uint64_t PoseStream::GetDeliveredCount(int subscription) const {
+  std::lock_guard<std::mutex> lock(subscription_mutex_);
+  if (subscription < 0 || subscription >= kMaxSubscribers ||
+      subscriptions_[subscription] == nullptr) {
+    return 0;
+  }
+  return subscriptions_[subscription]->delivered_count.load(
+      std::memory_order_relaxed);
+}
+
+uint64_t PoseStream::GetSkippedCount(int subscription) const {
+  std::lock_guard<std::mutex> lock(subscription_mutex_);
+  if (subscription < 0 || subscription >= kMaxSubscribers ||
+      subscriptions_[subscription] == nullptr) {
+    return 0;
+  }
+  return subscriptions_[subscription]->skipped_count.load(
+      std::memory_order_relaxed);
+}
+
+bool PoseStream::ShouldDeliver(const Subscription& subscription,
+                               const TangoPoseData& pose) {
+  const TangoPoseData& last = subscription.last_pose;
+  if (!subscription.has_last_pose || last.status_code != pose.status_code) {
+    return true;
+  }
+  // Poses going back in time come after a reset of the service.
+  const double interval = pose.timestamp - last.timestamp;
+  if (interval >= 0.0 && interval < subscription.min_interval) {
+    return false;
+  }
+  if (subscription.is_moving_always) {
+    return true;
+  }
+  // Squared distance and quaternion dot product, no square root or arc
+  // cosine per pose.
+  double distance_squared = 0.0;
+  for (int i = 0; i < 3; ++i) {
+    const double d = pose.translation[i] - last.translation[i];
+    distance_squared += d * d;
+  }
+  if (subscription.min_translation_squared > 0.0 &&
+      distance_squared >= subscription.min_translation_squared) {
+    return true;
+  }
+  double dot = 0.0;
+  for (int i = 0; i < 4; ++i) {
+    dot += pose.orientation[i] * last.orientation[i];
+  }
+  return std::abs(dot) <= subscription.max_orientation_dot;
+}
+
+PoseStream::Snapshot PoseStream::GetLatest(int pair) const {
+  if (pair < 0 || pair >= pair_count_) {
+    return Snapshot();
+  }
+  return slots_[pair]->latest.Load();
+}
+
+size_t PoseStream::GetHistory(int pair, size_t max_count,
+                              TangoPoseData* poses) const {
+  if (pair < 0 || pair >= pair_count_) {
+    return 0;
+  }
+  const Slot* slot = slots_[pair].get();
+  uint64_t count = slot->history_count.load(std::memory_order_acquire);
+  size_t copied = 0;
+  while (copied < max_count && copied < slot->history_capacity &&
+         copied < count) {
+    uint64_t index = count - 1 - copied;
+    HistoryEntry entry = slot->history[index % slot->history_capacity].Load();
+    if (entry.index != index) {
+      // The writer lapped the reader, older entries are gone too.
+      break;
+    }
+    poses[copied++] = entry.pose;
+  }
+  return copied;
+}
+
+}  // namespace tango_gl
@@ -0,0 +1,331 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <EGL/egl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "tango-gl/memory_tracker.h"
+#include "tango-gl/program_cache.h"
+
+namespace {
+// "TGPB", first field of a program binary file.
+const uint32_t kBinaryFileMagic = 0x54475042;
+
+const uint64_t kFnvOffsetBasis = 14695981039346656037ULL;
+const uint64_t kFnvPrime = 1099511628211ULL;
+
+struct CachedProgram {
+  uint64_t hash;
+  std::string vertex_source;
+  std::string fragment_source;
+  int reference_count;
+  // False for the rare program whose hash collides with a cached one, it is
+  // then not shared.
+  bool is_shared;
+};
+
+// Header of a program binary file, followed by length bytes of binary.
+struct BinaryFileHeader {
+  uint32_t magic;
+  uint32_t format;
+  uint32_t length;
+};
+
+// FNV-1a, continuing from hash. The terminating null is hashed as well so
+// the concatenation of strings stays unambiguous.
+uint64_t HashString(const char* str, uint64_t hash) {
+  for (const char* c = str;; ++c) {
+    hash ^= static_cast<uint8_t>(*c);
+    hash *= kFnvPrime;
+    if (*c == '\0') {
+      return hash;
+    }
+  }
+}
+
+const char* GetGlString(GLenum name) {
+  const char* str = reinterpret_cast<const char*>(glGetString(name));
+  return str != nullptr ? str : "";
+}
+
+// Cache state, only touched on the GL thread.
+EGLContext g_context = EGL_NO_CONTEXT;
+std::unordered_map<uint64_t, GLuint> g_program_by_hash;
+std::unordered_map<GLuint, CachedProgram> g_programs;
+
+// Program binary support of g_context, resolved on first use.
+bool g_is_binary_support_checked = false;
+PFNGLGETPROGRAMBINARYOESPROC g_get_program_binary = nullptr;
+PFNGLPROGRAMBINARYOESPROC g_program_binary = nullptr;
+
+// Set from the UI thread, read on the GL thread.
+std::mutex g_binary_directory_mutex;
+std::string g_binary_directory;
+
+// Forget everything that belonged to another context. The programs died with
+// that context, so they are not deleted.
+void CheckContext() {
+  EGLContext context = eglGetCurrentContext();
+  if (context != g_context) {
+    g_context = context;
+    g_program_by_hash.clear();
+    g_programs.clear();
+    g_is_binary_support_checked = false;
+    g_get_program_binary = nullptr;
+    g_program_binary = nullptr;
+  }
+}
+
+bool HasProgramBinarySupport() {
+  if (!g_is_binary_support_checked) {
+    g_is_binary_support_checked = true;
+    GLint format_count = 0;
+    if (strstr(GetGlString(GL_EXTENSIONS), "GL_OES_get_program_binary")) {
+      glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS_OES, &format_count);
+    }
+    if (format_count > 0) {
+      g_get_program_binary = reinterpret_cast<PFNGLGETPROGRAMBINARYOESPROC>(
+          eglGetProcAddress("glGetProgramBinaryOES"));
+      g_program_binary = reinterpret_cast<PFNGLPROGRAMBINARYOESPROC>(
+          eglGetProcAddress("glProgramBinaryOES"));
+    }
+  }
+  return g_get_program_binary != nullptr && g_program_binary != nullptr;
+}
+
+// Path of the binary for a program, empty if binaries are not persisted.
+// Binaries are only valid for the driver that produced them, so the driver
+// identity is part of the file name.
+std::string GetBinaryPath(uint64_t source_hash) {
+  std::string directory;
+  {
+    std::lock_guard<std::mutex> lock(g_binary_directory_mutex);
+    directory = g_binary_directory;
+  }
+  if (directory.empty() || !HasProgramBinarySupport()) {
+    return std::string();
+  }
+
+  uint64_t hash = HashString(GetGlString(GL_RENDERER), source_hash);
+  hash = HashString(GetGlString(GL_VERSION), hash);
+  char file_name[64];
+  snprintf(file_name, sizeof(file_name), "/program_%016llx.bin",
+           static_cast<unsigned long long>(hash));
+  return directory + file_name;
+}
+
+GLuint LoadProgramBinary(const std::string& path) {
+  FILE* file = fopen(path.c_str(), "rb");
+  if (file == nullptr) {
+    return 0;
+  }
+
+  BinaryFileHeader header;
+  std::vector<uint8_t> binary;
+  bool is_valid = fread(&header, sizeof(header), 1, file) == 1 &&
+                  header.magic == kBinaryFileMagic && header.length > 0;
+  if (is_valid) {
+    binary.resize(header.length);
+    is_valid = fread(binary.data(), 1, binary.size(), file) == binary.size();
+  }
+  fclose(file);
+
+  GLuint program = 0;
+  if (is_valid) {
+    program = glCreateProgram();
+    g_program_binary(program, header.format, binary.data(), header.length);
+    GLint link_status = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &link_status);
+    if (link_status != GL_TRUE) {
+      // Typically a driver update, the program is rebuilt from source.
+      glDeleteProgram(program);
+      program = 0;
+    }
+  }
+  if (program == 0) {
+    remove(path.c_str());
+  }
+  return program;
+}
+
+void SaveProgramBinary(const std::string& path, GLuint program) {
+  GLint length = 0;
+  glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH_OES, &length);
+  if (length <= 0) {
+    return;
+  }
+
+  std::vector<uint8_t> binary(length);
+  GLsizei written = 0;
+  GLenum format = 0;
+  g_get_program_binary(program, length, &written, &format, binary.data());
+  if (written <= 0) {
+    return;
+  }
+
+  // Write to a temporary file first so a crash never leaves a truncated
+  // binary behind.
+  std::string temp_path = path + ".tmp";
+  FILE* file = fopen(temp_path.c_str(), "wb");
+  if (file == nullptr) {
+    LOGE("program_cache: Could not write %s", temp_path.c_str());
+    return;
+  }
+  BinaryFileHeader header;
+  header.magic = kBinaryFileMagic;
+  header.format = format;
+  header.length = written;
+  bool is_written = fwrite(&header, sizeof(header), 1, file) == 1 &&
+                    fwrite(binary.data(), 1, written, file) ==
+                        static_cast<size_t>(written);
+  is_written = fclose(file) == 0 && is_written;
+  if (!is_written || rename(temp_path.c_str(), path.c_str()) != 0) {
+    LOGE("program_cache: Could not write %s", path.c_str());
+    remove(temp_path.c_str());
+  }
+}
+
+GLuint BuildProgram(uint64_t hash, const char* vertex_source,
+                    const char* fragment_source) {
+  std::string binary_path = GetBinaryPath(hash);
+  if (!binary_path.empty()) {
+    GLuint program = LoadProgramBinary(binary_path);
+    if (program != 0) {
+      return program;
+    }
+  }
+
+  GLuint program =
+      tango_gl::util::CreateProgram(vertex_source, fragment_source);
+  if (program != 0 && !binary_path.empty()) {
+    SaveProgramBinary(binary_path, program);
+  }
+  return program;
+}
+}  // namespace
+
+namespace tango_gl {
+namespace program_cache {
+
+GLuint AcquireProgram(const char* vertex_source, const char* fragment_source) {
+  CheckContext();
+
+  uint64_t hash = HashString(fragment_source,
+                             HashString(vertex_source, kFnvOffsetBasis));
+  bool is_shared = true;
+  auto found = g_program_by_hash.find(hash);
+  if (found != g_program_by_hash.end()) {
+    CachedProgram& cached = g_programs[found->second];
+    if (cached.vertex_source == vertex_source &&
+        cached.fragment_source == fragment_source) {
+      ++cached.reference_count;
+      return found->second;
+    }
+    is_shared = false;
+  }
+
+  GLuint program = BuildProgram(hash, vertex_source, fragment_source);
+  if (program == 0) {
+    return 0;
+  }
+
+  CachedProgram& cached = g_programs[program];
+  cached.hash = hash;
+  cached.vertex_source = vertex_source;
+  cached.fragment_source = fragment_source;
+  cached.reference_count = 1;
+  cached.is_shared = is_shared;
+  if (is_shared) {
+    g_program_by_hash[hash] = program;
+  }
+  // The driver does not tell the size of a program, its binary is the
+  // closest estimate.
+  GLint binary_length = 0;
+  if (HasProgramBinarySupport()) {
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH_OES, &binary_length);
+  }
+  MemoryTracker::Track(MemoryTracker::kProgram, program, "program_cache",
+                       std::max(binary_length, 0));
+  return program;
+}
+
+void ReleaseProgram(GLuint program) {
+  if (program == 0) {
+    return;
+  }
+  CheckContext();
+
+  auto found = g_programs.find(program);
+  if (found == g_programs.end()) {
+    return;
+  }
+  if (--found->second.reference_count > 0) {
+    return;
+  }
+  if (found->second.is_shared) {
+    g_program_by_hash.erase(found->second.hash);
+  }
+  g_programs.erase(found);
+  glDeleteProgram(program);
+  MemoryTracker::Untrack(MemoryTracker::kProgram, program);
+}
+
+void SetBinaryCacheDirectory(const std::string& path) {
+  std::lock_guard<std::mutex> lock(g_binary_directory_mutex);
+  g_binary_directory = path;
+}
+
+void SetBinaryCacheDirectory(JNIEnv* env, jobject activity) {
+  jclass activity_class = env->GetObjectClass(activity);
+  jmethodID get_cache_dir =
+      env->GetMethodID(activity_class, "getCacheDir", "()Ljava/io/File;");
+  jobject cache_dir = env->CallObjectMethod(activity, get_cache_dir);
+  if (env->ExceptionCheck() || cache_dir == nullptr) {
+    env->ExceptionClear();
+    LOGE("program_cache: Could not get the cache directory.");
+    return;
+  }
+
+  jclass file_class = env->GetObjectClass(cache_dir);
+  jmethodID get_absolute_path =
+      env->GetMethodID(file_class, "getAbsolutePath", "()Ljava/lang/String;");
+  jstring path = static_cast<jstring>(
+      env->CallObjectMethod(cache_dir, get_absolute_path));
+  if (env->ExceptionCheck() || path == nullptr) {
+    env->ExceptionClear();
+    LOGE("program_cache: Could not get the cache directory path.");
+    return;
+  }
+
+  const char* path_chars = env->GetStringUTFChars(path, nullptr);
+  SetBinaryCacheDirectory(std::string(path_chars));
+  env->ReleaseStringUTFChars(path, path_chars);
+
+  env->DeleteLocalRef(path);
+  env->DeleteLocalRef(file_class);
+  env->DeleteLocalRef(cache_dir);
+  env->DeleteLocalRef(activity_class);
+}
+
+}  // namespace program_cache
+}  // namespace tango_gl
@@ -0,0 +1,304 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "tango-gl/projective_icp.h"
+
+#include <math.h>
+
+#include "tango-gl/camera.h"
+#include "tango-gl/conversions.h"
+#include "tango-gl/cpu_features.h"
+
+namespace {
+using tango_gl::internal::kTermCount;
+using tango_gl::internal::kTermSumCount;
+
+// Near plane of the model view, closer map blocks are not rendered.
+const float kNearClip = 0.1f;
+
+// Added to the diagonal of the normal matrix per pair. Directions the pairs
+// do not constrain, e.g. sliding along a single wall, then get no step
+// instead of an arbitrary one, while the constrained ones are barely damped.
+const double kDampingPerPair = 1e-4;
+
+// Add the outer products of the terms of pairs [begin, end) to sums. Also
+// the tail of the NEON kernel.
+void AccumulateTermsScalar(const float* const terms[kTermCount], size_t begin,
+                           size_t end, double sums[kTermSumCount]) {
+  for (size_t i = begin; i < end; ++i) {
+    double pair[kTermCount];
+    for (int a = 0; a < kTermCount; ++a) {
+      pair[a] = terms[a][i];
+    }
+    int sum = 0;
+    for (int a = 0; a < kTermCount; ++a) {
+      for (int b = a; b < kTermCount; ++b) {
+        sums[sum++] += pair[a] * pair[b];
+      }
+    }
+  }
+}
+
+void AccumulateTerms(const float* const terms[kTermCount], size_t count,
+                     double sums[kTermSumCount]) {
+  size_t begin = 0;
+#if defined(TANGO_GL_HAS_NEON)
+  if (tango_gl::cpu_features::IsNeonAvailable()) {
+    begin = count & ~static_cast<size_t>(3);
+    tango_gl::internal::AccumulateTermsNeon(terms, count, sums);
+  }
+#endif
+  AccumulateTermsScalar(terms, begin, count, sums);
+}
+
+// Solve the symmetric positive definite system matrix * x = rhs by Cholesky
+// decomposition. Only the lower triangle of matrix is read.
+//
+// @return false if the matrix is not positive definite.
+bool SolveCholesky(const double matrix[6][6], const double rhs[6],
+                   double x[6]) {
+  double lower[6][6];
+  for (int j = 0; j < 6; ++j) {
+    double diagonal = matrix[j][j];
+    for (int k = 0; k < j; ++k) {
+      diagonal -= lower[j][k] * lower[j][k];
+    }
+    if (!(diagonal > 0.0)) {
+      return false;
+    }
+    lower[j][j] = sqrt(diagonal);
+    for (int i = j + 1; i < 6; ++i) {
+      double value = matrix[i][j];
+      for (int k = 0; k < j; ++k) {
+        value -= lower[i][k] * lower[j][k];
+      }
+      lower[i][j] = value / lower[j][j];
+    }
+  }
+  double y[6];
+  for (int i = 0; i < 6; ++i) {
+    double value = rhs[i];
+    for (int k = 0; k < i; ++k) {
+      value -= lower[i][k] * y[k];
+    }
+    y[i] = value / lower[i][i];
+  }
+  for (int i = 5; i >= 0; --i) {
+    double value = y[i];
+    for (int k = i + 1; k < 6; ++k) {
+      value -= lower[k][i] * x[k];
+    }
+    x[i] = value / lower[i][i];
+  }
+  return true;
+}
+}  // namespace
+
+namespace tango_gl {
+
+ProjectiveIcp::ProjectiveIcp(WorkerPool* worker_pool, const Options& options)
+    : options_(options),
+      model_normals_(worker_pool),
+      projection_mat_(1.0f),
+      term_capacity_(0) {
+  frustum_.SetMaxDistance(options_.max_depth);
+}
+
+void ProjectiveIcp::SetIntrinsics(const TangoCameraIntrinsics& intrinsics) {
+  frame_image_.SetIntrinsics(intrinsics);
+
+  // The model has the same pixels as the frame. A coarser model would leave
+  // fewer holes between the voxel points, but the normals of a range image
+  // are computed from its pixel centers, and coarser pixels bias them.
+  model_image_.SetIntrinsics(intrinsics);
+  projection_mat_ = Camera::ProjectionMatrixForCameraIntrinsics(
+      intrinsics.width, intrinsics.height, intrinsics.fx, intrinsics.fy,
+      intrinsics.cx, intrinsics.cy, kNearClip, options_.max_depth);
+
+  term_capacity_ = static_cast<size_t>(intrinsics.width) * intrinsics.height;
+  terms_.resize(kTermCount * term_capacity_);
+}
+
+bool ProjectiveIcp::Refine(const PointMap& map, const float* xyz,
+                           size_t point_count, glm::mat4* map_T_depth,
+                           Result* result) {
+  Result local_result;
+  if (result == nullptr) {
+    result = &local_result;
+  }
+  result->iteration_count = 0;
+  result->pair_count = 0;
+  result->rms_distance = 0.0f;
+  result->model_pixel_count = 0;
+  if (term_capacity_ == 0) {
+    LOGE("ProjectiveIcp: Refine() called before SetIntrinsics().");
+    return false;
+  }
+
+  frame_image_.Update(xyz, point_count);
+  result->model_pixel_count = RenderModel(map, *map_T_depth);
+  if (result->model_pixel_count < options_.min_pair_count) {
+    return false;
+  }
+
+  const float* terms[kTermCount];
+  for (int a = 0; a < kTermCount; ++a) {
+    terms[a] = terms_.data() + a * term_capacity_;
+  }
+  // The model is rendered from the pose to refine, so the estimate starts
+  // at identity.
+  glm::mat4 model_T_frame(1.0f);
+  bool is_stopped = false;
+  for (int level = options_.level_count - 1; level >= 0 && !is_stopped;
+       --level) {
+    const int stride = 1 << level;
+    const float max_distance = options_.max_distance /
+                               (1 << (options_.level_count - 1 - level));
+    for (int iteration = 0; iteration < options_.iteration_count;
+         ++iteration) {
+      const size_t pair_count =
+          Associate(xyz, stride, max_distance, model_T_frame);
+      if (pair_count < options_.min_pair_count) {
+        is_stopped = true;
+        break;
+      }
+      double sums[kTermSumCount] = {0.0};
+      AccumulateTerms(terms, pair_count, sums);
+
+      double matrix[6][6];
+      double rhs[6];
+      int sum = 0;
+      for (int a = 0; a < 6; ++a) {
+        for (int b = a; b < 6; ++b) {
+          matrix[b][a] = sums[sum++];
+        }
+        // Gauss-Newton steps against the gradient.
+        rhs[a] = -sums[sum++];
+        matrix[a][a] += kDampingPerPair * pair_count;
+      }
+      const double squared_distance_sum = sums[sum];
+      double step[6];
+      if (!SolveCholesky(matrix, rhs, step)) {
+        is_stopped = true;
+        break;
+      }
+      ++result->iteration_count;
+      result->pair_count = pair_count;
+      result->rms_distance =
+          static_cast<float>(sqrt(squared_distance_sum / pair_count));
+
+      const glm::vec3 rotation_step(step[0], step[1], step[2]);
+      const glm::vec3 translation_step(step[3], step[4], step[5]);
+      const float angle = glm::length(rotation_step);
+      glm::mat4 step_T(1.0f);
+      if (angle > 0.0f) {
+        step_T = glm::mat4_cast(glm::angleAxis(angle, rotation_step / angle));
+      }
+      step_T[3] = glm::vec4(translation_step, 1.0f);
+      model_T_frame = step_T * model_T_frame;
+      if (angle < options_.min_rotation &&
+          glm::length(translation_step) < options_.min_translation) {
+        break;
+      }
+    }
+  }
+  if (result->iteration_count == 0) {
+    return false;
+  }
+  *map_T_depth = *map_T_depth * model_T_frame;
+  return true;
+}
+
+size_t ProjectiveIcp::RenderModel(const PointMap& map,
+                                  const glm::mat4& map_T_depth) {
+  const glm::mat4 depth_T_map = glm::inverse(map_T_depth);
+  frustum_.Update(projection_mat_,
+                  conversions::Inverse(conversions::CameraTOpenGlCamera()) *
+                      depth_T_map);
+  const size_t point_count = map.GetVisiblePoints(&frustum_, &model_xyz_);
+  const glm::mat3 rotation(depth_T_map);
+  const glm::vec3 translation(depth_T_map[3]);
+  for (size_t i = 0; i < point_count; ++i) {
+    float* point = model_xyz_.data() + i * 3;
+    const glm::vec3 position =
+        rotation * glm::vec3(point[0], point[1], point[2]) + translation;
+    point[0] = position.x;
+    point[1] = position.y;
+    point[2] = position.z;
+  }
+  model_image_.Update(model_xyz_.data(), point_count);
+  return model_normals_.Compute(model_image_);
+}
+
+size_t ProjectiveIcp::Associate(const float* xyz, int stride,
+                                float max_distance,
+                                const glm::mat4& model_T_frame) {
+  float* terms[kTermCount];
+  for (int a = 0; a < kTermCount; ++a) {
+    terms[a] = terms_.data() + a * term_capacity_;
+  }
+  const glm::mat3 rotation(model_T_frame);
+  const glm::vec3 translation(model_T_frame[3]);
+  const float max_squared_distance = max_distance * max_distance;
+  const glm::vec3* normals = model_normals_.GetNormals();
+  const int model_width = model_image_.GetWidth();
+
+  size_t pair_count = 0;
+  for (int y = 0; y < frame_image_.GetHeight(); y += stride) {
+    for (int x = 0; x < frame_image_.GetWidth(); x += stride) {
+      const int32_t index = frame_image_.GetPointIndex(x, y);
+      if (index == RangeImage::kNoPoint) {
+        continue;
+      }
+      const float* point = xyz + index * 3;
+      const glm::vec3 position =
+          rotation * glm::vec3(point[0], point[1], point[2]) + translation;
+      int model_x;
+      int model_y;
+      if (!model_image_.GetPixel(position, &model_x, &model_y)) {
+        continue;
+      }
+      const int32_t model_index =
+          model_image_.GetPointIndex(model_x, model_y);
+      const glm::vec3& normal = normals[model_y * model_width + model_x];
+      if (model_index == RangeImage::kNoPoint ||
+          glm::dot(normal, normal) == 0.0f) {
+        continue;
+      }
+      const float* model_point = model_xyz_.data() + model_index * 3;
+      const glm::vec3 offset =
+          position - glm::vec3(model_point[0], model_point[1], model_point[2]);
+      if (glm::dot(offset, offset) > max_squared_distance) {
+        continue;
+      }
+      // Moving the point by a small rotation w and a translation t changes
+      // its distance by dot(cross(position, normal), w) + dot(normal, t).
+      const glm::vec3 rotation_term = glm::cross(position, normal);
+      terms[0][pair_count] = rotation_term.x;
+      terms[1][pair_count] = rotation_term.y;
+      terms[2][pair_count] = rotation_term.z;
+      terms[3][pair_count] = normal.x;
+      terms[4][pair_count] = normal.y;
+      terms[5][pair_count] = normal.z;
+      terms[6][pair_count] = glm::dot(normal, offset);
+      ++pair_count;
+    }
+  }
+  return pair_count;
+}
+
+}  // namespace tango_gl
@@ -0,0 +1,79 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// This file is only compiled with NEON enabled (the ".neon" suffix in
+// Android.mk), the kernel is selected at runtime by projective_icp.cpp.
+
+#include <arm_neon.h>
+
+#include "tango-gl/projective_icp.h"
+
+namespace {
+using tango_gl::internal::kTermCount;
+using tango_gl::internal::kTermSumCount;
+
+// Iterations between flushes of the float lane sums into the double sums,
+// keeps the normal equations of a whole frame as precise as the scalar path.
+const size_t kSumFlushInterval = 256;
+
+inline double HorizontalSum(const float32x4_t& value) {
+  float32x2_t sum = vadd_f32(vget_low_f32(value), vget_high_f32(value));
+  return vget_lane_f32(vpadd_f32(sum, sum), 0);
+}
+
+inline void FlushSums(float32x4_t lane_sums[kTermSumCount],
+                      double sums[kTermSumCount]) {
+  for (int i = 0; i < kTermSumCount; ++i) {
+    sums[i] += HorizontalSum(lane_sums[i]);
+    lane_sums[i] = vdupq_n_f32(0.0f);
+  }
+}
+}  // namespace
+
+namespace tango_gl {
+namespace internal {
+
+void AccumulateTermsNeon(const float* const terms[kTermCount], size_t count,
+                         double sums[kTermSumCount]) {
+  // More accumulators than registers on armeabi-v7a, the compiler keeps the
+  // rest on the stack; they are still added four pairs at a time.
+  float32x4_t lane_sums[kTermSumCount];
+  for (int i = 0; i < kTermSumCount; ++i) {
+    lane_sums[i] = vdupq_n_f32(0.0f);
+  }
+  const size_t end = count & ~static_cast<size_t>(3);
+  for (size_t i = 0; i < end; i += 4) {
+    float32x4_t pairs[kTermCount];
+    for (int a = 0; a < kTermCount; ++a) {
+      pairs[a] = vld1q_f32(terms[a] + i);
+    }
+    int sum = 0;
+    for (int a = 0; a < kTermCount; ++a) {
+      for (int b = a; b < kTermCount; ++b) {
+        lane_sums[sum] = vmlaq_f32(lane_sums[sum], pairs[a], pairs[b]);
+        ++sum;
+      }
+    }
+    if ((i / 4) % kSumFlushInterval == kSumFlushInterval - 1) {
+      FlushSums(lane_sums, sums);
+    }
+  }
+  FlushSums(lane_sums, sums);
+}
+
+}  // namespace internal
+}  // namespace tango_gl
@@ -14,7 +14,12 @@
  * limitations under the License.
  */
 
+#include "tango-gl/counters.h"
+#include "tango-gl/frame_constants.h"
+#include "tango-gl/program_cache.h"
 #include "tango-gl/quad.h"
+#include "tango-gl/render_state.h"
+#include "tango-gl/simd_math.h"
 #include "tango-gl/util.h"
 
 namespace tango_gl {
@@ -36,14 +41,23 @@ static const char kFragmentShader[] =
     "  gl_FragColor = texture2D(inputTexture, textureCoordinate);\n"
     "}\n";
 
-static const float vertices[] = {-0.5f, -0.5f, 0.5f, -0.5f,
-                                 -0.5f, 0.5f,  0.5f, 0.5f};
+static const float vertices[] = {-0.5f, -0.5f, 0.0f, 0.5f, -0.5f, 0.0f,
+                                 -0.5f, 0.5f,  0.0f, 0.5f, 0.5f,  0.0f};
 
 static const GLfloat texture_coords[] = {0.0f, 1.0f, 1.0f, 1.0f,
                                          0.0f, 0.0f, 1.0f, 0.0f, };
 
+static void BuildQuad(Geometry* geometry) {
+  geometry->vertices.assign(vertices,
+                            vertices + sizeof(vertices) / sizeof(float));
+  geometry->texture_coords.assign(
+      texture_coords,
+      texture_coords + sizeof(texture_coords) / sizeof(GLfloat));
+}
+
 Quad::Quad() {
-  shader_program_ = util::CreateProgram(kVertexShader, kFragmentShader);
+  shader_program_ =
+      program_cache::AcquireProgram(kVertexShader, kFragmentShader);
   if (!shader_program_) {
     LOGE("Could not create program.");
   }
@@ -52,40 +66,43 @@ Quad::Quad() {
   texture_coords_ =
       glGetAttribLocation(shader_program_, "inputTextureCoordinate");
   texture_handle = glGetUniformLocation(shader_program_, "inputTexture");
-  glGenBuffers(1, &vertex_buffer_);
+  geometry_ = geometry_registry::Acquire("quad", BuildQuad);
 }
 
-Quad::~Quad() { glDeleteShader(shader_program_); }
+Quad::~Quad() { program_cache::ReleaseProgram(shader_program_); }
 
-void Quat::SetTextureId(GLuint texture_id) { texture_id_ = texture_id; }
+void Quad::SetTextureId(GLuint texture_id) { texture_id_ = texture_id; }
 
 void Quad::Render(const glm::mat4& projection_mat,
                   const glm::mat4& view_mat) const {
-  glEnable(GL_CULL_FACE);
-  glEnable(GL_BLEND);
+  RenderState::Enable(GL_CULL_FACE);
+  RenderState::Enable(GL_BLEND);
   glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-  glUseProgram(shader_program_);
+  RenderState::UseProgram(shader_program_);
 
-  glBindTexture(GL_TEXTURE_2D, texture_id_);
+  RenderState::BindTexture(GL_TEXTURE_2D, texture_id_);
   glUniform1i(texture_handle, 0);
 
-  // Calculate MVP matrix and pass it to shader.
-  glm::mat4 model_mat = GetTransformationMatrix();
-  glm::mat4 mvp_mat = projection_mat * view_mat * model_mat;
+  // Calculate MVP matrix and pass it to shader. Quad has its own program
+  // and locations, shadowing those of DrawableObject.
+  glm::mat4 mvp_mat = simd_math::Multiply(
+      FrameConstants::GetViewProjection(projection_mat, view_mat),
+      GetTransformationMatrix());
   glUniformMatrix4fv(uniform_mvp_mat_, 1, GL_FALSE, glm::value_ptr(mvp_mat));
 
-  // Vertice binding
-  glEnableVertexAttribArray(attrib_vertices_);
-  glVertexAttribPointer(attrib_vertices_, 2, GL_FLOAT, GL_FALSE, 0, vertices);
-  glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-  glEnableVertexAttribArray(texture_coords_);
-  glVertexAttribPointer(texture_coords_, 2, GL_FLOAT, GL_FALSE, 0,
-                        texture_coords);
-
-  glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-  glUseProgram(0);
-  glBindTexture(GL_TEXTURE_2D, 0);
+  if (!vertex_array_.Bind()) {
+    geometry_->Bind();
+    vertex_array_.EnableAttribute(attrib_vertices_);
+    glVertexAttribPointer(attrib_vertices_, 3, GL_FLOAT, GL_FALSE,
+                          geometry_->GetStride(), nullptr);
+    vertex_array_.EnableAttribute(texture_coords_);
+    glVertexAttribPointer(texture_coords_, 2, GL_FLOAT, GL_FALSE,
+                          geometry_->GetStride(),
+                          geometry_->GetTextureCoordOffset());
+  }
+  Counters::Increment(Counters::kDrawCalls);
+  glDrawArrays(GL_TRIANGLE_STRIP, 0, geometry_->GetVertexCount());
+  vertex_array_.Unbind();
 }
 
 }  // namespace tango_gl
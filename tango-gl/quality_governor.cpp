@@ -0,0 +1,169 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "tango-gl/quality_governor.h"
+
+#include <dlfcn.h>
+
+#include <algorithm>
+
+#include "tango-gl/util.h"
+
+namespace {
+// AThermal_getCurrentThermalStatus() is a binder call, poll it about once a
+// second.
+const size_t kThermalPollFrameCount = 60;
+
+// Upper bound of the step up backoff, relative to step_up_frame_count.
+const size_t kMaxStepUpBackoff = 16;
+
+typedef void* (*AcquireThermalManagerFunc)();
+typedef void (*ReleaseThermalManagerFunc)(void* manager);
+}  // namespace
+
+namespace tango_gl {
+
+QualityGovernor::QualityGovernor(int level_count, const Options& options)
+    : level_count_(std::max(1, level_count)),
+      options_(options),
+      level_(level_count_ - 1),
+      frame_count_(0),
+      step_up_delay_(options.step_up_frame_count),
+      is_stepped_up_(false),
+      thermal_manager_(nullptr),
+      get_thermal_status_(nullptr),
+      frames_since_thermal_poll_(kThermalPollFrameCount),
+      polled_thermal_status_(kThermalNone),
+      external_thermal_status_(kThermalNone) {
+  // The thermal API first shipped in API level 30, above the platform these
+  // examples build against, so its entry points are resolved at runtime.
+  void* android_lib = dlopen("libandroid.so", RTLD_NOW | RTLD_LOCAL);
+  if (android_lib != nullptr) {
+    AcquireThermalManagerFunc acquire_manager =
+        reinterpret_cast<AcquireThermalManagerFunc>(
+            dlsym(android_lib, "AThermal_acquireManager"));
+    get_thermal_status_ = reinterpret_cast<GetThermalStatusFunc>(
+        dlsym(android_lib, "AThermal_getCurrentThermalStatus"));
+    if (acquire_manager != nullptr && get_thermal_status_ != nullptr) {
+      thermal_manager_ = acquire_manager();
+    }
+  }
+  if (thermal_manager_ == nullptr) {
+    get_thermal_status_ = nullptr;
+  }
+}
+
+QualityGovernor::~QualityGovernor() {
+  if (thermal_manager_ == nullptr) {
+    return;
+  }
+  void* android_lib = dlopen("libandroid.so", RTLD_NOW | RTLD_LOCAL);
+  if (android_lib != nullptr) {
+    ReleaseThermalManagerFunc release_manager =
+        reinterpret_cast<ReleaseThermalManagerFunc>(
+            dlsym(android_lib, "AThermal_releaseManager"));
+    if (release_manager != nullptr) {
+      release_manager(thermal_manager_);
+    }
+  }
+}
+
+bool QualityGovernor::Update(FrameProfiler* profiler) {
+  PollThermalStatus();
+  ++frame_count_;
+
+  const int thermal_cap = GetThermalCap();
+  if (level_ > thermal_cap) {
+    LOGI("QualityGovernor: thermal status %d, level %d -> %d",
+         GetThermalStatus(), level_, thermal_cap);
+    SetLevel(thermal_cap, profiler);
+    return true;
+  }
+
+  size_t sample_count = 0;
+  const float frame_ms =
+      options_.is_gpu_time && profiler->HasGpuTimers()
+          ? profiler->GetGpuPercentile(options_.zone, options_.percentile,
+                                       &sample_count)
+          : profiler->GetCpuPercentile(options_.zone, options_.percentile,
+                                       &sample_count);
+  if (sample_count < options_.min_sample_count) {
+    return false;
+  }
+
+  if (frame_ms > options_.target_frame_ms * options_.step_down_ratio &&
+      level_ > 0) {
+    // Leaving a level shortly after stepping up to it means the device can
+    // not hold it, wait longer before trying it again.
+    if (is_stepped_up_ && frame_count_ < step_up_delay_) {
+      step_up_delay_ = std::min(step_up_delay_ * 2,
+                                options_.step_up_frame_count *
+                                    kMaxStepUpBackoff);
+    }
+    LOGI("QualityGovernor: p%.0f %.2f ms, level %d -> %d",
+         options_.percentile * 100.0f, frame_ms, level_, level_ - 1);
+    SetLevel(level_ - 1, profiler);
+    return true;
+  }
+
+  if (frame_ms < options_.target_frame_ms * options_.step_up_ratio &&
+      level_ < thermal_cap && frame_count_ >= step_up_delay_) {
+    if (is_stepped_up_) {
+      // The level held, forget the backoff.
+      step_up_delay_ = options_.step_up_frame_count;
+    }
+    LOGI("QualityGovernor: p%.0f %.2f ms, level %d -> %d",
+         options_.percentile * 100.0f, frame_ms, level_, level_ + 1);
+    SetLevel(level_ + 1, profiler);
+    return true;
+  }
+  return false;
+}
+
+void QualityGovernor::SetThermalStatus(ThermalStatus status) {
+  external_thermal_status_ = status;
+}
+
+QualityGovernor::ThermalStatus QualityGovernor::GetThermalStatus() const {
+  return static_cast<ThermalStatus>(
+      std::max(polled_thermal_status_.load(), external_thermal_status_.load()));
+}
+
+void QualityGovernor::PollThermalStatus() {
+  if (get_thermal_status_ == nullptr ||
+      ++frames_since_thermal_poll_ < kThermalPollFrameCount) {
+    return;
+  }
+  frames_since_thermal_poll_ = 0;
+  const int status = get_thermal_status_(thermal_manager_);
+  // Negative values are errors, e.g. the thermal service is unavailable.
+  polled_thermal_status_ = std::max(static_cast<int>(kThermalNone), status);
+}
+
+int QualityGovernor::GetThermalCap() const {
+  const int throttling = GetThermalStatus() - kThermalLight;
+  return std::max(0, level_count_ - 1 - std::max(0, throttling));
+}
+
+void QualityGovernor::SetLevel(int level, FrameProfiler* profiler) {
+  is_stepped_up_ = level > level_;
+  level_ = level;
+  frame_count_ = 0;
+  profiler->ClearZone(options_.zone);
+}
+
+}  // namespace tango_gl
@@ -0,0 +1,164 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tango-gl/range_image.h"
+
+#include "tango-gl/cpu_features.h"
+
+namespace {
+// Store points [begin, end). Also the tail of the NEON kernel.
+void StoreRangePointsScalar(const float* points, size_t begin, size_t end,
+                            const tango_gl::projection::CameraIntrinsics& in,
+                            tango_gl::internal::RangeImageTarget* target) {
+  const float width = static_cast<float>(in.width);
+  const float height = static_cast<float>(in.height);
+  for (size_t i = begin; i < end; ++i) {
+    const float* point = points + i * 3;
+    const float depth = point[2];
+    if (!(depth > 0.0f)) {
+      continue;
+    }
+    // Offset by half a pixel so the int cast rounds to the nearest pixel
+    // center. Compared as floats so far away pixels never overflow the cast.
+    const float inverse_depth = 1.0f / depth;
+    const float pixel_x = in.fx * (point[0] * inverse_depth) + in.cx + 0.5f;
+    const float pixel_y = in.fy * (point[1] * inverse_depth) + in.cy + 0.5f;
+    if (pixel_x >= 0.0f && pixel_x < width && pixel_y >= 0.0f &&
+        pixel_y < height) {
+      const int32_t pixel = static_cast<int32_t>(pixel_y) * in.width +
+                            static_cast<int32_t>(pixel_x);
+      tango_gl::internal::StoreRangePoint(target, pixel,
+                                          static_cast<int32_t>(i), depth);
+    }
+  }
+}
+}  // namespace
+
+namespace tango_gl {
+
+const int32_t RangeImage::kNoPoint;
+
+RangeImage::RangeImage() : filled_pixel_count_(0) {
+  intrinsics_.width = 0;
+  intrinsics_.height = 0;
+  intrinsics_.fx = 0.0f;
+  intrinsics_.fy = 0.0f;
+  intrinsics_.cx = 0.0f;
+  intrinsics_.cy = 0.0f;
+}
+
+void RangeImage::SetIntrinsics(const TangoCameraIntrinsics& intrinsics) {
+  intrinsics_.width = static_cast<int>(intrinsics.width);
+  intrinsics_.height = static_cast<int>(intrinsics.height);
+  intrinsics_.fx = static_cast<float>(intrinsics.fx);
+  intrinsics_.fy = static_cast<float>(intrinsics.fy);
+  intrinsics_.cx = static_cast<float>(intrinsics.cx);
+  intrinsics_.cy = static_cast<float>(intrinsics.cy);
+  // Update() rounds to the nearest pixel, the centers are at integer
+  // positions.
+  ray_table_.Build(intrinsics_, 0.0f);
+
+  const size_t pixel_count =
+      static_cast<size_t>(intrinsics_.width) * intrinsics_.height;
+  depths_.assign(pixel_count, 0.0f);
+  point_indices_.assign(pixel_count, kNoPoint);
+  filled_pixels_.resize(pixel_count);
+  filled_pixel_count_ = 0;
+}
+
+size_t RangeImage::Update(const float* points, size_t point_count) {
+  Clear();
+
+  internal::RangeImageTarget target;
+  target.depths = depths_.data();
+  target.point_indices = point_indices_.data();
+  target.filled_pixels = filled_pixels_.data();
+  target.filled_pixel_count = 0;
+  if (depths_.empty()) {
+    return 0;
+  }
+
+  size_t begin = 0;
+#if defined(TANGO_GL_HAS_NEON)
+  if (cpu_features::IsNeonAvailable()) {
+    begin = point_count & ~static_cast<size_t>(3);
+    internal::StoreRangePointsNeon(points, point_count, intrinsics_, &target);
+  }
+#endif
+  StoreRangePointsScalar(points, begin, point_count, intrinsics_, &target);
+  filled_pixel_count_ = target.filled_pixel_count;
+  return filled_pixel_count_;
+}
+
+size_t RangeImage::Update(const TangoXYZij& cloud) {
+  const size_t point_count = static_cast<size_t>(cloud.xyz_count);
+  if (!HasIndexGrid(cloud)) {
+    return Update(cloud.xyz[0], point_count);
+  }
+
+  Clear();
+  internal::RangeImageTarget target;
+  target.depths = depths_.data();
+  target.point_indices = point_indices_.data();
+  target.filled_pixels = filled_pixels_.data();
+  target.filled_pixel_count = 0;
+  const int32_t pixel_count =
+      static_cast<int32_t>(intrinsics_.width) * intrinsics_.height;
+  for (int32_t pixel = 0; pixel < pixel_count; ++pixel) {
+    // Cells without a point hold -1, which wraps past any valid index.
+    const uint32_t point = cloud.ij[pixel];
+    if (point < point_count && cloud.xyz[point][2] > 0.0f) {
+      internal::StoreRangePoint(&target, pixel, static_cast<int32_t>(point),
+                                cloud.xyz[point][2]);
+    }
+  }
+  filled_pixel_count_ = target.filled_pixel_count;
+  return filled_pixel_count_;
+}
+
+bool RangeImage::HasIndexGrid(const TangoXYZij& cloud) const {
+  return cloud.ij != nullptr && !depths_.empty() &&
+         cloud.ij_rows == static_cast<uint32_t>(intrinsics_.height) &&
+         cloud.ij_cols == static_cast<uint32_t>(intrinsics_.width);
+}
+
+void RangeImage::Clear() {
+  for (size_t i = 0; i < filled_pixel_count_; ++i) {
+    const int32_t pixel = filled_pixels_[i];
+    depths_[pixel] = 0.0f;
+    point_indices_[pixel] = kNoPoint;
+  }
+  filled_pixel_count_ = 0;
+}
+
+bool RangeImage::GetPixel(const glm::vec3& position, int* x, int* y) const {
+  if (!(position.z > 0.0f)) {
+    return false;
+  }
+  const float pixel_x =
+      intrinsics_.fx * (position.x / position.z) + intrinsics_.cx + 0.5f;
+  const float pixel_y =
+      intrinsics_.fy * (position.y / position.z) + intrinsics_.cy + 0.5f;
+  if (!(pixel_x >= 0.0f && pixel_x < intrinsics_.width && pixel_y >= 0.0f &&
+        pixel_y < intrinsics_.height)) {
+    return false;
+  }
+  *x = static_cast<int>(pixel_x);
+  *y = static_cast<int>(pixel_y);
+  return true;
+}
+
+}  // namespace tango_gl
@@ -0,0 +1,313 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "tango-gl/range_image_mesh.h"
+
+#include <math.h>
+
+#include <algorithm>
+#include <limits>
+
+#include "tango-gl/counters.h"
+#include "tango-gl/program_cache.h"
+#include "tango-gl/render_state.h"
+#include "tango-gl/shaders.h"
+
+namespace {
+// Most nodes 16 bit indices address.
+const int kMaxNodeCount = std::numeric_limits<GLushort>::max() + 1;
+
+bool operator!=(const tango_gl::projection::CameraIntrinsics& a,
+                const tango_gl::projection::CameraIntrinsics& b) {
+  return a.width != b.width || a.height != b.height || a.fx != b.fx ||
+         a.fy != b.fy || a.cx != b.cx || a.cy != b.cy;
+}
+
+// Fill the zeros of a line of values, from count values spaced by step,
+// with the last nonzero value before them, or after them for the leading
+// zeros.
+void FillLine(float* values, int count, int step) {
+  float last = 0.0f;
+  for (int i = 0; i < count; ++i) {
+    float& value = values[i * step];
+    if (value != 0.0f) {
+      last = value;
+    } else {
+      value = last;
+    }
+  }
+  last = 0.0f;
+  for (int i = count - 1; i >= 0; --i) {
+    float& value = values[i * step];
+    if (value != 0.0f) {
+      last = value;
+    } else {
+      value = last;
+    }
+  }
+}
+}  // namespace
+
+namespace tango_gl {
+
+RangeImageMesh::RangeImageMesh(const Options& options)
+    : options_(options),
+      color_(0.8f, 0.8f, 0.8f, 1.0f),
+      plane_(0.0f, 0.0f, 1.0f, 0.0f),
+      plane_distance_(0.0f),
+      intrinsics_(),
+      cell_size_(0),
+      grid_width_(0),
+      grid_height_(0),
+      kept_node_count_(0),
+      are_depths_dirty_(false),
+      is_layout_dirty_(false),
+      ray_buffer_(GL_ARRAY_BUFFER, GL_STATIC_DRAW),
+      index_buffer_(GL_ELEMENT_ARRAY_BUFFER, GL_STATIC_DRAW),
+      depth_buffer_(GL_ARRAY_BUFFER, GL_STREAM_DRAW),
+      shader_program_(0),
+      attrib_rays_(-1),
+      attrib_depths_(-1),
+      uniform_mvp_mat_(-1),
+      uniform_color_(-1),
+      uniform_plane_(-1),
+      uniform_plane_distance_(-1) {}
+
+RangeImageMesh::~RangeImageMesh() { Release(); }
+
+void RangeImageMesh::LayOut(const RangeImage& image) {
+  intrinsics_ = image.GetIntrinsics();
+  cell_size_ = std::max(1, options_.cell_size);
+  const int width = std::max(0, intrinsics_.width);
+  const int height = std::max(0, intrinsics_.height);
+  while (((width + cell_size_ - 1) / cell_size_) *
+             ((height + cell_size_ - 1) / cell_size_) >
+         kMaxNodeCount) {
+    ++cell_size_;
+  }
+  grid_width_ = (width + cell_size_ - 1) / cell_size_;
+  grid_height_ = (height + cell_size_ - 1) / cell_size_;
+  const size_t node_count = static_cast<size_t>(grid_width_) * grid_height_;
+
+  // A node stands for the pixel at the center of its block.
+  const RayTable& ray_table = image.GetRayTable();
+  rays_.resize(node_count * 2);
+  for (int y = 0; y < grid_height_; ++y) {
+    const int pixel_y = std::min(height - 1, y * cell_size_ + cell_size_ / 2);
+    for (int x = 0; x < grid_width_; ++x) {
+      const int pixel_x = std::min(width - 1, x * cell_size_ + cell_size_ / 2);
+      const glm::vec2 ray = ray_table.GetRay(pixel_x, pixel_y);
+      rays_[(y * grid_width_ + x) * 2] = ray.x;
+      rays_[(y * grid_width_ + x) * 2 + 1] = ray.y;
+    }
+  }
+
+  // Two triangles per cell, split along the diagonal from its top right to
+  // its bottom left node.
+  indices_.clear();
+  if (grid_width_ > 1 && grid_height_ > 1) {
+    indices_.reserve(static_cast<size_t>(grid_width_ - 1) *
+                     (grid_height_ - 1) * 6);
+  }
+  for (int y = 0; y + 1 < grid_height_; ++y) {
+    for (int x = 0; x + 1 < grid_width_; ++x) {
+      const GLushort top_left = static_cast<GLushort>(y * grid_width_ + x);
+      const GLushort top_right = static_cast<GLushort>(top_left + 1);
+      const GLushort bottom_left =
+          static_cast<GLushort>(top_left + grid_width_);
+      const GLushort bottom_right = static_cast<GLushort>(bottom_left + 1);
+      indices_.push_back(top_left);
+      indices_.push_back(bottom_left);
+      indices_.push_back(top_right);
+      indices_.push_back(top_right);
+      indices_.push_back(bottom_left);
+      indices_.push_back(bottom_right);
+    }
+  }
+  raw_depths_.assign(node_count, 0.0f);
+  depths_.assign(node_count, 0.0f);
+  is_layout_dirty_ = true;
+}
+
+size_t RangeImageMesh::Update(const RangeImage& image) {
+  if (image.GetIntrinsics() != intrinsics_ || cell_size_ == 0) {
+    LayOut(image);
+  }
+  const int width = image.GetWidth();
+  const int height = image.GetHeight();
+  const float* image_depths = image.GetDepths();
+
+  // Nearest depth of each block.
+  for (int y = 0; y < grid_height_; ++y) {
+    const int y0 = y * cell_size_;
+    const int y1 = std::min(height, y0 + cell_size_);
+    for (int x = 0; x < grid_width_; ++x) {
+      const int x0 = x * cell_size_;
+      const int x1 = std::min(width, x0 + cell_size_);
+      float nearest = 0.0f;
+      for (int pixel_y = y0; pixel_y < y1; ++pixel_y) {
+        const float* row = image_depths + pixel_y * width;
+        for (int pixel_x = x0; pixel_x < x1; ++pixel_x) {
+          const float depth = row[pixel_x];
+          if (depth > 0.0f && (nearest == 0.0f || depth < nearest)) {
+            nearest = depth;
+          }
+        }
+      }
+      raw_depths_[y * grid_width_ + x] = nearest;
+    }
+  }
+
+  // Drop the farther node of each edge of the triangles that crosses a
+  // discontinuity.
+  depths_ = raw_depths_;
+  const float max_jump = options_.max_depth_jump;
+  auto test_edge = [this, max_jump](int a, int b) {
+    const float depth_a = raw_depths_[a];
+    const float depth_b = raw_depths_[b];
+    if (depth_a == 0.0f || depth_b == 0.0f) {
+      return;
+    }
+    const float nearer = std::min(depth_a, depth_b);
+    if (fabsf(depth_a - depth_b) > max_jump * nearer) {
+      depths_[depth_a > depth_b ? a : b] = 0.0f;
+    }
+  };
+  for (int y = 0; y < grid_height_; ++y) {
+    for (int x = 0; x < grid_width_; ++x) {
+      const int node = y * grid_width_ + x;
+      if (x + 1 < grid_width_) {
+        test_edge(node, node + 1);
+      }
+      if (y + 1 < grid_height_) {
+        test_edge(node, node + grid_width_);
+        if (x + 1 < grid_width_) {
+          test_edge(node + 1, node + grid_width_);
+        }
+      }
+    }
+  }
+
+  // Nodes not kept take the depth of a kept node nearby, negated. Their
+  // triangles are discarded, but stay local instead of stretching to the
+  // camera and covering the screen with discarded fragments.
+  kept_node_count_ = 0;
+  for (float depth : depths_) {
+    if (depth > 0.0f) {
+      ++kept_node_count_;
+    }
+  }
+  raw_depths_ = depths_;
+  for (int y = 0; y < grid_height_; ++y) {
+    FillLine(raw_depths_.data() + y * grid_width_, grid_width_, 1);
+  }
+  for (int x = 0; x < grid_width_; ++x) {
+    FillLine(raw_depths_.data() + x, grid_height_, grid_width_);
+  }
+  for (size_t i = 0; i < depths_.size(); ++i) {
+    if (depths_[i] == 0.0f) {
+      depths_[i] = -raw_depths_[i];
+    }
+  }
+  are_depths_dirty_ = true;
+  return kept_node_count_;
+}
+
+void RangeImageMesh::Render(const glm::mat4& projection_mat,
+                            const glm::mat4& view_mat,
+                            const glm::mat4& model_mat) {
+  if (indices_.empty() || kept_node_count_ == 0 || !InitializeGL()) {
+    return;
+  }
+  if (is_layout_dirty_) {
+    ray_buffer_.Update(rays_.data(), rays_.size() * sizeof(GLfloat), 0);
+    index_buffer_.Update(indices_.data(), indices_.size() * sizeof(GLushort),
+                         0);
+    is_layout_dirty_ = false;
+  }
+  if (are_depths_dirty_) {
+    depth_buffer_.Update(depths_.data(), depths_.size() * sizeof(GLfloat), 0);
+    are_depths_dirty_ = false;
+  }
+
+  RenderState::UseProgram(shader_program_);
+  const glm::mat4 mvp_mat = projection_mat * view_mat * model_mat;
+  glUniformMatrix4fv(uniform_mvp_mat_, 1, GL_FALSE, glm::value_ptr(mvp_mat));
+  glUniform4fv(uniform_color_, 1, glm::value_ptr(color_));
+  glUniform4fv(uniform_plane_, 1, glm::value_ptr(plane_));
+  glUniform1f(uniform_plane_distance_, plane_distance_);
+  RenderState::Disable(GL_BLEND);
+  RenderState::Enable(GL_DEPTH_TEST);
+  // The winding flips with the side the surface is seen from.
+  RenderState::Disable(GL_CULL_FACE);
+
+  ray_buffer_.Bind();
+  glEnableVertexAttribArray(attrib_rays_);
+  glVertexAttribPointer(attrib_rays_, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
+  depth_buffer_.Bind();
+  glEnableVertexAttribArray(attrib_depths_);
+  glVertexAttribPointer(attrib_depths_, 1, GL_FLOAT, GL_FALSE, 0, nullptr);
+  index_buffer_.Bind();
+  Counters::Increment(Counters::kDrawCalls);
+  glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(indices_.size()),
+                 GL_UNSIGNED_SHORT, nullptr);
+  glDisableVertexAttribArray(attrib_rays_);
+  glDisableVertexAttribArray(attrib_depths_);
+  RenderState::BindBuffer(GL_ARRAY_BUFFER, 0);
+  RenderState::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+  util::CheckGlError("RangeImageMesh::Render");
+}
+
+bool RangeImageMesh::InitializeGL() {
+  if (shader_program_ != 0) {
+    return true;
+  }
+  shader_program_ = program_cache::AcquireProgram(
+      shaders::GetRangeImageMeshVertexShader().c_str(),
+      shaders::GetRangeImageMeshFragmentShader().c_str());
+  if (!shader_program_) {
+    LOGE("RangeImageMesh: could not create program.");
+    return false;
+  }
+  attrib_rays_ = glGetAttribLocation(shader_program_, "ray");
+  attrib_depths_ = glGetAttribLocation(shader_program_, "depth");
+  uniform_mvp_mat_ = glGetUniformLocation(shader_program_, "mvp");
+  uniform_color_ = glGetUniformLocation(shader_program_, "color");
+  uniform_plane_ = glGetUniformLocation(shader_program_, "plane");
+  uniform_plane_distance_ =
+      glGetUniformLocation(shader_program_, "plane_distance");
+  return true;
+}
+
+void RangeImageMesh::Release() {
+  program_cache::ReleaseProgram(shader_program_);
+  ray_buffer_.Release();
+  index_buffer_.Release();
+  depth_buffer_.Release();
+  Invalidate();
+}
+
+void RangeImageMesh::Invalidate() {
+  shader_program_ = 0;
+  ray_buffer_.Invalidate();
+  index_buffer_.Invalidate();
+  depth_buffer_.Invalidate();
+  is_layout_dirty_ = !indices_.empty();
+  are_depths_dirty_ = !depths_.empty();
+}
+
+}  // namespace tango_gl
@@ -0,0 +1,99 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// This file is only compiled with NEON enabled (the ".neon" suffix in
+// Android.mk), the kernel is selected at runtime by range_image.cpp.
+
+#include <arm_neon.h>
+
+#include "tango-gl/range_image.h"
+
+namespace {
+// 1 / value from the reciprocal estimate and two Newton-Raphson steps, close
+// to full float precision.
+inline float32x4_t Reciprocal(const float32x4_t& value) {
+  float32x4_t reciprocal = vrecpeq_f32(value);
+  reciprocal = vmulq_f32(vrecpsq_f32(value, reciprocal), reciprocal);
+  reciprocal = vmulq_f32(vrecpsq_f32(value, reciprocal), reciprocal);
+  return reciprocal;
+}
+}  // namespace
+
+namespace tango_gl {
+namespace internal {
+
+void StoreRangePointsNeon(const float* points, size_t point_count,
+                          const projection::CameraIntrinsics& intrinsics,
+                          RangeImageTarget* target) {
+  const float32x4_t fx = vdupq_n_f32(intrinsics.fx);
+  const float32x4_t fy = vdupq_n_f32(intrinsics.fy);
+  // Offset by half a pixel so the int conversion rounds to the nearest pixel
+  // center, like the scalar path.
+  const float32x4_t cx = vdupq_n_f32(intrinsics.cx + 0.5f);
+  const float32x4_t cy = vdupq_n_f32(intrinsics.cy + 0.5f);
+  const float32x4_t width = vdupq_n_f32(static_cast<float>(intrinsics.width));
+  const float32x4_t height =
+      vdupq_n_f32(static_cast<float>(intrinsics.height));
+  const int32x4_t row_stride = vdupq_n_s32(intrinsics.width);
+  const float32x4_t zero = vdupq_n_f32(0.0f);
+
+  int32_t pixels[4];
+  uint32_t valid_lanes[4];
+  float depths[4];
+
+  const size_t count = point_count & ~static_cast<size_t>(3);
+  for (size_t i = 0; i < count; i += 4) {
+    // De-interleave four xyz points into x, y and z vectors.
+    float32x4x3_t xyz = vld3q_f32(points + i * 3);
+
+    const float32x4_t inverse_z = Reciprocal(xyz.val[2]);
+    const float32x4_t pixel_x =
+        vmlaq_f32(cx, vmulq_f32(xyz.val[0], inverse_z), fx);
+    const float32x4_t pixel_y =
+        vmlaq_f32(cy, vmulq_f32(xyz.val[1], inverse_z), fy);
+
+    // Comparisons against NaN are false, so points with z == 0 are rejected
+    // as well.
+    uint32x4_t valid = vcgtq_f32(xyz.val[2], zero);
+    valid = vandq_u32(valid, vcgeq_f32(pixel_x, zero));
+    valid = vandq_u32(valid, vcltq_f32(pixel_x, width));
+    valid = vandq_u32(valid, vcgeq_f32(pixel_y, zero));
+    valid = vandq_u32(valid, vcltq_f32(pixel_y, height));
+
+    // Skip the scatter for the common case of four points off the image.
+    const uint32x2_t any =
+        vorr_u32(vget_low_u32(valid), vget_high_u32(valid));
+    if ((vget_lane_u32(any, 0) | vget_lane_u32(any, 1)) == 0) {
+      continue;
+    }
+
+    vst1q_s32(pixels, vmlaq_s32(vcvtq_s32_f32(pixel_x),
+                                vcvtq_s32_f32(pixel_y), row_stride));
+    vst1q_u32(valid_lanes, valid);
+    vst1q_f32(depths, xyz.val[2]);
+    // The depth test is a read-modify-write of the image, the pixels of a
+    // vector can collide, so the points are stored one by one.
+    for (int lane = 0; lane < 4; ++lane) {
+      if (valid_lanes[lane] != 0) {
+        StoreRangePoint(target, pixels[lane], static_cast<int32_t>(i + lane),
+                        depths[lane]);
+      }
+    }
+  }
+}
+
+}  // namespace internal
+}  // namespace tango_gl
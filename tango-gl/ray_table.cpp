@@ -0,0 +1,152 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "tango-gl/ray_table.h"
+
+#include <algorithm>
+
+#include "tango-gl/counters.h"
+#include "tango-gl/memory_tracker.h"
+#include "tango-gl/render_state.h"
+
+namespace {
+// Largest code of a ray coordinate in the encoded table.
+const float kMaxCode = 65535.0f;
+
+// 16 bit code of a value in [minimum, minimum + step * kMaxCode].
+inline uint16_t EncodeValue(float value, float minimum, float inverse_step) {
+  const float code = (value - minimum) * inverse_step + 0.5f;
+  return static_cast<uint16_t>(std::min(std::max(code, 0.0f), kMaxCode));
+}
+}  // namespace
+
+namespace tango_gl {
+
+RayTable::RayTable() : width_(0), height_(0), pixel_center_(0.0f) {
+  intrinsics_.width = 0;
+  intrinsics_.height = 0;
+  intrinsics_.fx = 0.0f;
+  intrinsics_.fy = 0.0f;
+  intrinsics_.cx = 0.0f;
+  intrinsics_.cy = 0.0f;
+}
+
+void RayTable::Build(const projection::CameraIntrinsics& intrinsics,
+                     float pixel_center) {
+  width_ = std::max(intrinsics.width, 0);
+  height_ = std::max(intrinsics.height, 0);
+  intrinsics_ = intrinsics;
+  pixel_center_ = pixel_center;
+  rays_.clear();
+  column_rays_.resize(width_);
+  for (int x = 0; x < width_; ++x) {
+    column_rays_[x] = (x + pixel_center - intrinsics.cx) / intrinsics.fx;
+  }
+  row_rays_.resize(height_);
+  for (int y = 0; y < height_; ++y) {
+    row_rays_[y] = (y + pixel_center - intrinsics.cy) / intrinsics.fy;
+  }
+}
+
+void RayTable::Build(
+    const projection::CameraIntrinsics& intrinsics, float pixel_center,
+    const std::function<glm::vec2(const glm::vec2&)>& undistort) {
+  Build(intrinsics, pixel_center);
+  rays_.resize(static_cast<size_t>(width_) * height_);
+  for (int y = 0; y < height_; ++y) {
+    glm::vec2* row = &rays_[static_cast<size_t>(y) * width_];
+    for (int x = 0; x < width_; ++x) {
+      row[x] = undistort(glm::vec2(column_rays_[x], row_rays_[y]));
+    }
+  }
+  column_rays_.clear();
+  row_rays_.clear();
+}
+
+bool RayTable::IsBuiltFor(const projection::CameraIntrinsics& intrinsics,
+                          float pixel_center) const {
+  return IsSeparable() && intrinsics.width == intrinsics_.width &&
+         intrinsics.height == intrinsics_.height &&
+         intrinsics.fx == intrinsics_.fx && intrinsics.fy == intrinsics_.fy &&
+         intrinsics.cx == intrinsics_.cx && intrinsics.cy == intrinsics_.cy &&
+         pixel_center == pixel_center_;
+}
+
+void RayTable::Encode(std::vector<uint8_t>* texels, glm::vec4* decode) const {
+  const size_t pixel_count = static_cast<size_t>(width_) * height_;
+  texels->resize(pixel_count * 4);
+  if (pixel_count == 0) {
+    *decode = glm::vec4(0.0f);
+    return;
+  }
+
+  glm::vec2 minimum = GetRay(0, 0);
+  glm::vec2 maximum = minimum;
+  for (int y = 0; y < height_; ++y) {
+    for (int x = 0; x < width_; ++x) {
+      const glm::vec2 ray = GetRay(x, y);
+      minimum = glm::min(minimum, ray);
+      maximum = glm::max(maximum, ray);
+    }
+  }
+  // A single row or column still needs a non zero step.
+  const glm::vec2 step =
+      glm::max(maximum - minimum, glm::vec2(1e-6f)) / kMaxCode;
+  const glm::vec2 inverse_step = 1.0f / step;
+  *decode = glm::vec4(minimum, step);
+
+  uint8_t* texel = texels->data();
+  for (int y = 0; y < height_; ++y) {
+    for (int x = 0; x < width_; ++x, texel += 4) {
+      const glm::vec2 ray = GetRay(x, y);
+      const uint16_t code_x = EncodeValue(ray.x, minimum.x, inverse_step.x);
+      const uint16_t code_y = EncodeValue(ray.y, minimum.y, inverse_step.y);
+      texel[0] = static_cast<uint8_t>(code_x >> 8);
+      texel[1] = static_cast<uint8_t>(code_x & 0xff);
+      texel[2] = static_cast<uint8_t>(code_y >> 8);
+      texel[3] = static_cast<uint8_t>(code_y & 0xff);
+    }
+  }
+}
+
+GLuint RayTable::CreateTexture(glm::vec4* decode) const {
+  if (width_ == 0 || height_ == 0) {
+    return 0;
+  }
+  std::vector<uint8_t> texels;
+  Encode(&texels, decode);
+
+  GLuint texture = 0;
+  glGenTextures(1, &texture);
+  RenderState::BindTexture(GL_TEXTURE_2D, texture);
+  // Codes must not be filtered, the bytes of a code would blend.
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width_, height_, 0, GL_RGBA,
+               GL_UNSIGNED_BYTE, texels.data());
+  Counters::Add(Counters::kTextureBytes, texels.size());
+  MemoryTracker::Track(MemoryTracker::kTexture, texture, "RayTable",
+                       MemoryTracker::GetTextureSize(width_, height_, GL_RGBA,
+                                                     GL_UNSIGNED_BYTE));
+  util::CheckGlError("RayTable::CreateTexture");
+  return texture;
+}
+
+}  // namespace tango_gl
@@ -0,0 +1,280 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <string.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "tango-gl/reconstruction_controller.h"
+#include "tango-gl/util.h"
+
+namespace {
+// The resume delay grows up to this many times Options::resume_delay.
+const double kMaxResumeBackoff = 16.0;
+
+const double kNever = -std::numeric_limits<double>::infinity();
+
+const char* const kStateNames[] = {"stopped", "running", "paused_still",
+                                   "paused_frame_time", "paused_memory"};
+
+tango_gl::MotionGate::Options GetMotionGateOptions(
+    const tango_gl::ReconstructionController::Options& options) {
+  tango_gl::MotionGate::Options gate_options;
+  gate_options.max_translation = options.still_translation;
+  gate_options.max_rotation = options.still_rotation;
+  gate_options.refresh_interval = 0;
+  return gate_options;
+}
+}  // namespace
+
+namespace tango_gl {
+
+ReconstructionController::ReconstructionController(const Options& options)
+    : options_(options),
+      state_(kStopped),
+      segment_budget_(options.max_segment_budget),
+      last_metadata_time_(kNever),
+      has_new_volumes_(false),
+      last_mesh_time_(kNever),
+      is_over_frame_budget_(false),
+      motion_gate_(GetMotionGateOptions(options)),
+      still_since_(0.0),
+      resume_time_(kNever),
+      within_budget_since_(0.0),
+      resume_delay_(options.resume_delay) {
+  memset(&metadata_, 0, sizeof(metadata_));
+}
+
+TangoErrorType ReconstructionController::Start() {
+  const TangoErrorType ret =
+      TangoService_Experimental_startSceneReconstruction();
+  if (ret != TANGO_SUCCESS) {
+    LOGE("ReconstructionController: Failed to start the reconstruction: %d",
+         ret);
+    return ret;
+  }
+  state_ = kRunning;
+  motion_gate_.Reset();
+  last_metadata_time_ = kNever;
+  resume_time_ = kNever;
+  resume_delay_ = options_.resume_delay;
+  return TANGO_SUCCESS;
+}
+
+TangoErrorType ReconstructionController::Stop() {
+  TangoErrorType ret = TANGO_SUCCESS;
+  // Paused states already stopped the service.
+  if (state_ == kRunning) {
+    ret = TangoService_Experimental_stopSceneReconstruction();
+    if (ret != TANGO_SUCCESS) {
+      LOGE("ReconstructionController: Failed to stop the reconstruction: %d",
+           ret);
+    }
+  }
+  state_ = kStopped;
+  return ret;
+}
+
+TangoErrorType ReconstructionController::Reset() {
+  TangoErrorType ret = TangoService_Experimental_resetSceneReconstruction();
+  if (ret != TANGO_SUCCESS) {
+    LOGE("ReconstructionController: Failed to reset the reconstruction: %d",
+         ret);
+    return ret;
+  }
+  memset(&metadata_, 0, sizeof(metadata_));
+  has_new_volumes_ = false;
+  if (state_ == kPausedMemory) {
+    ret = TangoService_Experimental_startSceneReconstruction();
+    if (ret != TANGO_SUCCESS) {
+      LOGE(
+          "ReconstructionController: Failed to restart the reconstruction: "
+          "%d",
+          ret);
+      return ret;
+    }
+    LOGI("ReconstructionController: reset, %s -> %s",
+         GetStateName(state_), GetStateName(kRunning));
+    state_ = kRunning;
+    motion_gate_.Reset();
+  }
+  return TANGO_SUCCESS;
+}
+
+bool ReconstructionController::Update(const RigidTransform& device_pose,
+                                      double timestamp,
+                                      FrameProfiler* profiler) {
+  if (state_ == kRunning) {
+    PollMetadata(timestamp);
+  }
+
+  size_t sample_count = 0;
+  const float frame_ms =
+      profiler != nullptr
+          ? profiler->GetCpuPercentile(options_.zone, options_.percentile,
+                                       &sample_count)
+          : 0.0f;
+  const bool has_frame_time = sample_count >= options_.min_sample_count;
+  is_over_frame_budget_ =
+      has_frame_time &&
+      frame_ms > options_.target_frame_ms * options_.pause_ratio;
+  const bool is_within_budget =
+      !has_frame_time ||
+      frame_ms < options_.target_frame_ms * options_.resume_ratio;
+  // Back off fast when the renderer falls behind, recover slowly.
+  if (is_over_frame_budget_) {
+    segment_budget_ = std::max(1, segment_budget_ / 2);
+  } else if (segment_budget_ < options_.max_segment_budget) {
+    ++segment_budget_;
+  }
+
+  motion_gate_.ShouldProcess(device_pose);
+  if (!motion_gate_.IsStill()) {
+    still_since_ = timestamp;
+  }
+  const bool is_still = timestamp - still_since_ >= options_.still_duration;
+
+  const State previous_state = state_;
+  switch (state_) {
+    case kStopped:
+    case kPausedMemory:
+      break;
+    case kRunning:
+      if (metadata_.volumes_memory_size > options_.max_volume_memory) {
+        Pause(kPausedMemory, device_pose, timestamp);
+      } else if (is_over_frame_budget_) {
+        // Pausing again soon after resuming means the device can not afford
+        // the reconstruction yet, wait longer next time.
+        if (timestamp - resume_time_ < resume_delay_) {
+          resume_delay_ = std::min(resume_delay_ * 2.0,
+                                   options_.resume_delay * kMaxResumeBackoff);
+        }
+        Pause(kPausedFrameTime, device_pose, timestamp);
+      } else if (is_still) {
+        Pause(kPausedStill, device_pose, timestamp);
+      }
+      break;
+    case kPausedStill:
+      if (IsNewTerritory(device_pose)) {
+        Resume(timestamp);
+      }
+      break;
+    case kPausedFrameTime:
+      if (!is_within_budget) {
+        within_budget_since_ = timestamp;
+      } else if (timestamp - within_budget_since_ >= resume_delay_) {
+        Resume(timestamp);
+        resume_time_ = timestamp;
+      }
+      break;
+  }
+  if (state_ == previous_state) {
+    return false;
+  }
+  LOGI("ReconstructionController: p%.0f %.2f ms, %.1f MB, %s -> %s",
+       options_.percentile * 100.0f, frame_ms,
+       metadata_.volumes_memory_size / (1024.0 * 1024.0),
+       GetStateName(previous_state), GetStateName(state_));
+  return true;
+}
+
+bool ReconstructionController::ShouldExtractMesh(double timestamp) const {
+  return has_new_volumes_ && !is_over_frame_budget_ &&
+         timestamp - last_mesh_time_ >= options_.mesh_interval;
+}
+
+TangoErrorType ReconstructionController::ExtractMesh(
+    double timestamp, TangoMesh_Experimental* mesh) {
+  last_mesh_time_ = timestamp;
+  const TangoErrorType ret = TangoService_Experimental_extractMesh(mesh);
+  if (ret != TANGO_SUCCESS) {
+    LOGE("ReconstructionController: Failed to extract the mesh: %d", ret);
+    return ret;
+  }
+  has_new_volumes_ = false;
+  return TANGO_SUCCESS;
+}
+
+const char* ReconstructionController::GetStateName(State state) {
+  return kStateNames[state];
+}
+
+void ReconstructionController::Pause(State state,
+                                     const RigidTransform& device_pose,
+                                     double timestamp) {
+  // A failure leaves the service running, the state still pauses so the
+  // service is not asked again every frame.
+  if (TangoService_Experimental_stopSceneReconstruction() != TANGO_SUCCESS) {
+    LOGE("ReconstructionController: Failed to pause the reconstruction.");
+  }
+  state_ = state;
+  pause_pose_ = device_pose;
+  within_budget_since_ = timestamp;
+}
+
+void ReconstructionController::Resume(double timestamp) {
+  if (TangoService_Experimental_startSceneReconstruction() != TANGO_SUCCESS) {
+    LOGE("ReconstructionController: Failed to resume the reconstruction.");
+    return;
+  }
+  state_ = kRunning;
+  // The stillness is measured again from here.
+  motion_gate_.Reset();
+  still_since_ = timestamp;
+}
+
+bool ReconstructionController::IsNewTerritory(
+    const RigidTransform& device_pose) const {
+  const RigidTransform delta = pause_pose_.Inverse() * device_pose;
+  const float w = std::min(1.0f, std::abs(delta.GetRotation().w));
+  if (glm::length(delta.GetTranslation()) >= options_.resume_translation ||
+      2.0f * std::acos(w) >= options_.resume_rotation) {
+    return true;
+  }
+  if (metadata_.num_volumes_allocated == 0) {
+    return false;
+  }
+  const glm::vec3& position = device_pose.GetTranslation();
+  for (int i = 0; i < 3; ++i) {
+    if (position[i] < metadata_.bbx_min[i] ||
+        position[i] > metadata_.bbx_max[i]) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void ReconstructionController::PollMetadata(double timestamp) {
+  if (timestamp - last_metadata_time_ < options_.metadata_interval) {
+    return;
+  }
+  last_metadata_time_ = timestamp;
+  TangoReconstructionMetadata_Experimental metadata;
+  if (TangoService_Experimental_getReconstructionMetadata(&metadata) !=
+      TANGO_SUCCESS) {
+    return;
+  }
+  if (metadata.num_volumes_allocated != metadata_.num_volumes_allocated ||
+      metadata.volumes_memory_size != metadata_.volumes_memory_size) {
+    has_new_volumes_ = true;
+  }
+  metadata_ = metadata;
+}
+
+}  // namespace tango_gl
@@ -0,0 +1,311 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "tango-gl/recording_surface.h"
+
+#include <android/native_window.h>
+#include <EGL/eglext.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include "tango-gl/counters.h"
+#include "tango-gl/memory_tracker.h"
+#include "tango-gl/program_cache.h"
+#include "tango-gl/render_state.h"
+#include "tango-gl/shaders.h"
+
+// From EGL_ANDROID_recordable and the GLES3 headers, the examples are built
+// against the GLES2 ones.
+#ifndef EGL_RECORDABLE_ANDROID
+#define EGL_RECORDABLE_ANDROID 0x3142
+#endif
+#ifndef GL_READ_FRAMEBUFFER
+#define GL_READ_FRAMEBUFFER 0x8CA8
+#endif
+#ifndef GL_DRAW_FRAMEBUFFER
+#define GL_DRAW_FRAMEBUFFER 0x8CA9
+#endif
+
+namespace {
+// Full screen quad as a triangle strip, in normalized device coordinates.
+const GLfloat kQuadVertices[] = {-1.0f, -1.0f, 1.0f, -1.0f,
+                                 -1.0f, 1.0f,  1.0f, 1.0f};
+
+typedef void (*BlitFramebufferFunc)(GLint src_x0, GLint src_y0, GLint src_x1,
+                                    GLint src_y1, GLint dst_x0, GLint dst_y0,
+                                    GLint dst_x1, GLint dst_y1, GLbitfield mask,
+                                    GLenum filter);
+typedef EGLBoolean (*PresentationTimeFunc)(EGLDisplay display,
+                                           EGLSurface surface,
+                                           int64_t time_ns);
+
+BlitFramebufferFunc blit_framebuffer = nullptr;
+PresentationTimeFunc presentation_time = nullptr;
+
+// glBlitFramebuffer is GLES3 and eglPresentationTimeANDROID an extension,
+// both are resolved at runtime so the examples still link against libGLESv2
+// only.
+void LoadFunctions() {
+  static bool is_loaded = false;
+  if (is_loaded) {
+    return;
+  }
+  is_loaded = true;
+
+  const char* version =
+      reinterpret_cast<const char*>(glGetString(GL_VERSION));
+  if (version != nullptr && strncmp(version, "OpenGL ES 3", 11) == 0) {
+    blit_framebuffer = reinterpret_cast<BlitFramebufferFunc>(
+        eglGetProcAddress("glBlitFramebuffer"));
+  }
+  presentation_time = reinterpret_cast<PresentationTimeFunc>(
+      eglGetProcAddress("eglPresentationTimeANDROID"));
+  if (presentation_time == nullptr) {
+    LOGE("RecordingSurface: no eglPresentationTimeANDROID, frames are timed "
+         "by the encoder.");
+  }
+}
+}  // namespace
+
+namespace tango_gl {
+
+RecordingSurface::RecordingSurface()
+    : window_(nullptr),
+      display_(EGL_NO_DISPLAY),
+      surface_(EGL_NO_SURFACE),
+      texture_(0),
+      texture_width_(0),
+      texture_height_(0),
+      shader_program_(0),
+      attrib_vertices_(-1),
+      uniform_image_(-1),
+      vertex_buffer_(GL_ARRAY_BUFFER, GL_STATIC_DRAW) {}
+
+RecordingSurface::~RecordingSurface() {
+  Stop();
+  Release();
+}
+
+bool RecordingSurface::Start(ANativeWindow* window) {
+  Stop();
+  if (window == nullptr) {
+    return false;
+  }
+  LoadFunctions();
+
+  // The surface has to have the config of the context to be made current
+  // with it.
+  EGLDisplay display = eglGetCurrentDisplay();
+  EGLContext context = eglGetCurrentContext();
+  EGLint config_id = 0;
+  if (display == EGL_NO_DISPLAY || context == EGL_NO_CONTEXT ||
+      !eglQueryContext(display, context, EGL_CONFIG_ID, &config_id)) {
+    LOGE("RecordingSurface: no current context.");
+    return false;
+  }
+  const EGLint config_attributes[] = {EGL_CONFIG_ID, config_id, EGL_NONE};
+  EGLConfig config;
+  EGLint config_count = 0;
+  if (!eglChooseConfig(display, config_attributes, &config, 1,
+                       &config_count) ||
+      config_count == 0) {
+    LOGE("RecordingSurface: config %d of the context not found.", config_id);
+    return false;
+  }
+  EGLint is_recordable = EGL_FALSE;
+  eglGetConfigAttrib(display, config, EGL_RECORDABLE_ANDROID, &is_recordable);
+  // Without EGL_RECORDABLE_ANDROID, many encoders fail to create the surface
+  // or get frames in a format they cannot read.
+  if (is_recordable != EGL_TRUE) {
+    LOGE("RecordingSurface: config %d of the context is not recordable.",
+         config_id);
+    return false;
+  }
+
+  EGLSurface surface = eglCreateWindowSurface(display, config, window,
+                                              nullptr);
+  if (surface == EGL_NO_SURFACE) {
+    LOGE("RecordingSurface: could not create a window surface (0x%x).",
+         eglGetError());
+    return false;
+  }
+  ANativeWindow_acquire(window);
+  window_ = window;
+  display_ = display;
+  surface_ = surface;
+  return true;
+}
+
+void RecordingSurface::Stop() {
+  if (surface_ != EGL_NO_SURFACE) {
+    eglDestroySurface(display_, surface_);
+    surface_ = EGL_NO_SURFACE;
+  }
+  if (window_ != nullptr) {
+    ANativeWindow_release(window_);
+    window_ = nullptr;
+  }
+  display_ = EGL_NO_DISPLAY;
+}
+
+bool RecordingSurface::RecordFrame(int64_t presentation_time_ns) {
+  if (!IsRecording()) {
+    return false;
+  }
+  EGLSurface draw_surface = eglGetCurrentSurface(EGL_DRAW);
+  EGLSurface read_surface = eglGetCurrentSurface(EGL_READ);
+  EGLContext context = eglGetCurrentContext();
+  EGLint source_width = 0;
+  EGLint source_height = 0;
+  EGLint width = 0;
+  EGLint height = 0;
+  eglQuerySurface(display_, draw_surface, EGL_WIDTH, &source_width);
+  eglQuerySurface(display_, draw_surface, EGL_HEIGHT, &source_height);
+  eglQuerySurface(display_, surface_, EGL_WIDTH, &width);
+  eglQuerySurface(display_, surface_, EGL_HEIGHT, &height);
+  if (source_width <= 0 || source_height <= 0 || width <= 0 || height <= 0) {
+    return false;
+  }
+
+  // Draw into the recording surface, read from the screen surface.
+  if (!eglMakeCurrent(display_, surface_, draw_surface, context)) {
+    LOGE("RecordingSurface: could not make the surface current (0x%x).",
+         eglGetError());
+    return false;
+  }
+
+  // Fit the frame into the window, keeping its aspect ratio.
+  const float scale =
+      std::min(static_cast<float>(width) / source_width,
+               static_cast<float>(height) / source_height);
+  const GLsizei fit_width = static_cast<GLsizei>(source_width * scale);
+  const GLsizei fit_height = static_cast<GLsizei>(source_height * scale);
+  const GLint x = (width - fit_width) / 2;
+  const GLint y = (height - fit_height) / 2;
+
+  GLint viewport[4];
+  glGetIntegerv(GL_VIEWPORT, viewport);
+  GLfloat clear_color[4];
+  glGetFloatv(GL_COLOR_CLEAR_VALUE, clear_color);
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  RenderState::Disable(GL_SCISSOR_TEST);
+  glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+  glClear(GL_COLOR_BUFFER_BIT);
+  if (blit_framebuffer != nullptr) {
+    CopyWithBlit(source_width, source_height, x, y, fit_width, fit_height);
+  } else {
+    CopyWithTexture(source_width, source_height, x, y, fit_width, fit_height);
+  }
+  glClearColor(clear_color[0], clear_color[1], clear_color[2],
+               clear_color[3]);
+  glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+  util::CheckGlError("RecordingSurface::RecordFrame");
+
+  if (presentation_time != nullptr) {
+    presentation_time(display_, surface_, presentation_time_ns);
+  }
+  const bool is_queued = eglSwapBuffers(display_, surface_) == EGL_TRUE;
+  if (!is_queued) {
+    LOGE("RecordingSurface: could not queue the frame (0x%x).",
+         eglGetError());
+  }
+  eglMakeCurrent(display_, draw_surface, read_surface, context);
+  return is_queued;
+}
+
+void RecordingSurface::CopyWithBlit(GLsizei source_width,
+                                    GLsizei source_height, GLint x, GLint y,
+                                    GLsizei width, GLsizei height) {
+  blit_framebuffer(0, 0, source_width, source_height, x, y, x + width,
+                   y + height, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+}
+
+void RecordingSurface::CopyWithTexture(GLsizei source_width,
+                                       GLsizei source_height, GLint x,
+                                       GLint y, GLsizei width,
+                                       GLsizei height) {
+  if (shader_program_ == 0) {
+    shader_program_ = program_cache::AcquireProgram(
+        shaders::GetCompositeVertexShader().c_str(),
+        shaders::GetCompositeFragmentShader().c_str());
+    if (!shader_program_) {
+      LOGE("RecordingSurface: could not create program.");
+      return;
+    }
+    attrib_vertices_ = glGetAttribLocation(shader_program_, "vertex");
+    uniform_image_ = glGetUniformLocation(shader_program_, "image");
+  }
+  if (vertex_buffer_.GetSize() == 0) {
+    vertex_buffer_.Update(kQuadVertices, sizeof(kQuadVertices), 0);
+  }
+
+  RenderState::ActiveTexture(GL_TEXTURE0);
+  if (texture_ == 0) {
+    glGenTextures(1, &texture_);
+  }
+  RenderState::BindTexture(GL_TEXTURE_2D, texture_);
+  if (texture_width_ != source_width || texture_height_ != source_height) {
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, source_width, source_height, 0,
+                 GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    MemoryTracker::Track(MemoryTracker::kTexture, texture_, "RecordingSurface",
+                         MemoryTracker::GetTextureSize(
+                             source_width, source_height, GL_RGBA,
+                             GL_UNSIGNED_BYTE));
+    texture_width_ = source_width;
+    texture_height_ = source_height;
+  }
+  // Reads the read surface, the screen.
+  glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, 0, source_width,
+                      source_height);
+
+  glViewport(x, y, width, height);
+  RenderState::Disable(GL_BLEND);
+  RenderState::Disable(GL_DEPTH_TEST);
+  RenderState::Disable(GL_CULL_FACE);
+  RenderState::UseProgram(shader_program_);
+  glUniform1i(uniform_image_, 0);
+  vertex_buffer_.Bind();
+  glEnableVertexAttribArray(attrib_vertices_);
+  glVertexAttribPointer(attrib_vertices_, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
+  Counters::Increment(Counters::kDrawCalls);
+  glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+  glDisableVertexAttribArray(attrib_vertices_);
+}
+
+void RecordingSurface::Release() {
+  if (texture_ != 0) {
+    RenderState::DeleteTextures(1, &texture_);
+  }
+  program_cache::ReleaseProgram(shader_program_);
+  vertex_buffer_.Release();
+  Invalidate();
+}
+
+void RecordingSurface::Invalidate() {
+  vertex_buffer_.Invalidate();
+  texture_ = 0;
+  texture_width_ = 0;
+  texture_height_ = 0;
+  shader_program_ = 0;
+}
+
+}  // namespace tango_gl
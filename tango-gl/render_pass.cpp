@@ -0,0 +1,151 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <EGL/egl.h>
+#include <string.h>
+
+#include "tango-gl/render_pass.h"
+
+#include "tango-gl/render_state.h"
+
+// Attachments of the default framebuffer, from GL_EXT_discard_framebuffer,
+// which OpenGL ES 3 names GL_COLOR, GL_DEPTH and GL_STENCIL.
+#ifndef GL_COLOR_EXT
+#define GL_COLOR_EXT 0x1800
+#define GL_DEPTH_EXT 0x1801
+#define GL_STENCIL_EXT 0x1802
+#endif
+
+namespace {
+typedef void (GL_APIENTRY* InvalidateFramebufferFunc)(
+    GLenum target, GLsizei count, const GLenum* attachments);
+
+// Resolved on first use, like the vertex array entry points of RenderState.
+bool g_has_resolved_invalidate = false;
+InvalidateFramebufferFunc g_invalidate_framebuffer = nullptr;
+
+// The pass between Begin() and End(), only touched on the GL thread.
+bool g_is_in_pass = false;
+GLuint g_framebuffer = 0;
+tango_gl::RenderPass::Options g_options;
+
+void ResolveInvalidate() {
+  g_has_resolved_invalidate = true;
+  const char* version = reinterpret_cast<const char*>(glGetString(GL_VERSION));
+  const char* extensions =
+      reinterpret_cast<const char*>(glGetString(GL_EXTENSIONS));
+  if (version != nullptr && strncmp(version, "OpenGL ES 3", 11) == 0) {
+    g_invalidate_framebuffer = reinterpret_cast<InvalidateFramebufferFunc>(
+        eglGetProcAddress("glInvalidateFramebuffer"));
+  } else if (extensions != nullptr &&
+             strstr(extensions, "GL_EXT_discard_framebuffer") != nullptr) {
+    g_invalidate_framebuffer = reinterpret_cast<InvalidateFramebufferFunc>(
+        eglGetProcAddress("glDiscardFramebufferEXT"));
+  }
+}
+
+// Invalidate the attachments selected by color, depth and stencil of the
+// bound framebuffer.
+void Invalidate(GLuint framebuffer, bool color, bool depth, bool stencil) {
+  GLenum attachments[3];
+  GLsizei count = 0;
+  if (color) {
+    attachments[count++] =
+        framebuffer == 0 ? GL_COLOR_EXT : GL_COLOR_ATTACHMENT0;
+  }
+  if (depth) {
+    attachments[count++] = framebuffer == 0 ? GL_DEPTH_EXT : GL_DEPTH_ATTACHMENT;
+  }
+  if (stencil) {
+    attachments[count++] =
+        framebuffer == 0 ? GL_STENCIL_EXT : GL_STENCIL_ATTACHMENT;
+  }
+  if (count > 0) {
+    g_invalidate_framebuffer(GL_FRAMEBUFFER, count, attachments);
+  }
+}
+}  // namespace
+
+namespace tango_gl {
+
+void RenderPass::Begin(GLuint framebuffer, GLint x, GLint y, GLsizei width,
+                       GLsizei height, const Options& options) {
+  if (g_is_in_pass) {
+    End();
+  }
+  g_is_in_pass = true;
+  g_framebuffer = framebuffer;
+  g_options = options;
+
+  glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+  glViewport(x, y, width, height);
+
+  // Without invalidation, a clear is the cheapest way to tell a tiler the
+  // previous contents are not needed.
+  const bool has_invalidate = HasInvalidate();
+  GLbitfield clear_mask = 0;
+  if (options.color_load == kClear ||
+      (options.color_load == kDontCare && !has_invalidate)) {
+    clear_mask |= GL_COLOR_BUFFER_BIT;
+  }
+  if (options.depth_load == kClear ||
+      (options.depth_load == kDontCare && !has_invalidate)) {
+    clear_mask |= GL_DEPTH_BUFFER_BIT;
+  }
+  if (options.stencil_load == kClear ||
+      (options.stencil_load == kDontCare && !has_invalidate)) {
+    clear_mask |= GL_STENCIL_BUFFER_BIT;
+  }
+  if (has_invalidate) {
+    Invalidate(framebuffer, options.color_load == kDontCare,
+               options.depth_load == kDontCare,
+               options.stencil_load == kDontCare);
+  }
+  if (clear_mask != 0) {
+    // The scissor would turn the clear into a partial one, which tilers
+    // have to load around.
+    RenderState::Disable(GL_SCISSOR_TEST);
+    glClearColor(options.clear_color.r, options.clear_color.g,
+                 options.clear_color.b, options.clear_color.a);
+    glClearDepthf(options.clear_depth);
+    glClearStencil(options.clear_stencil);
+    glClear(clear_mask);
+  }
+}
+
+void RenderPass::End() {
+  if (!g_is_in_pass) {
+    return;
+  }
+  g_is_in_pass = false;
+  if (HasInvalidate()) {
+    Invalidate(g_framebuffer, g_options.color_store == kDiscard,
+               g_options.depth_store == kDiscard,
+               g_options.stencil_store == kDiscard);
+  }
+}
+
+bool RenderPass::IsInPass() { return g_is_in_pass; }
+
+bool RenderPass::HasInvalidate() {
+  if (!g_has_resolved_invalidate) {
+    ResolveInvalidate();
+  }
+  return g_invalidate_framebuffer != nullptr;
+}
+
+}  // namespace tango_gl
@@ -0,0 +1,345 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "tango-gl/render_scheduler.h"
+
+#include <android/looper.h>
+#include <dlfcn.h>
+
+#include <algorithm>
+#include <chrono>
+
+#include "tango-gl/util.h"
+
+namespace {
+// Vsync period assumed by the fallback timer, and until vsyncs are measured.
+const int64_t kFallbackVsyncPeriodNs = 16666667;
+
+// A requested frame not reported rendered after this long is given up on, so
+// a request dropped by the Java layer (e.g. while paused) can't stall the
+// scheduler.
+const int64_t kMaxFrameInFlightNs = 250000000;
+
+// AChoreographer first shipped in API level 24, above the platform these
+// examples build against, so its entry points are resolved at runtime.
+typedef void (*FrameCallbackFunction)(long frame_time_nanos, void* data);
+typedef void* (*ChoreographerGetInstanceFunction)();
+typedef void (*ChoreographerPostFrameCallbackFunction)(
+    void* choreographer, FrameCallbackFunction callback, void* data);
+
+// eglPresentationTimeANDROID, an extension resolved at runtime. Times are on
+// CLOCK_MONOTONIC, the clock of std::chrono::steady_clock on Android.
+typedef EGLBoolean (*PresentationTimeFunc)(EGLDisplay display,
+                                           EGLSurface surface,
+                                           int64_t time_ns);
+
+PresentationTimeFunc GetPresentationTimeFunction() {
+  static PresentationTimeFunc presentation_time =
+      reinterpret_cast<PresentationTimeFunc>(
+          eglGetProcAddress("eglPresentationTimeANDROID"));
+  return presentation_time;
+}
+
+int64_t NowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+}  // namespace
+
+namespace tango_gl {
+
+RenderScheduler::RenderScheduler()
+    : java_vm_(nullptr),
+      env_(nullptr),
+      is_running_(false),
+      looper_(nullptr),
+      is_stopping_(false),
+      has_new_data_(false),
+      is_frame_in_flight_(false),
+      uses_choreographer_(false),
+      target_frame_rate_(0),
+      vsync_period_ns_(kFallbackVsyncPeriodNs),
+      request_vsync_time_ns_(0),
+      is_frame_callback_posted_(false),
+      last_request_time_ns_(0),
+      last_vsync_time_ns_(0),
+      paced_surface_(EGL_NO_SURFACE),
+      swap_interval_(0),
+      requests_(0),
+      frames_(0),
+      dropped_frames_(0),
+      janky_frames_(0) {
+  for (int i = 0; i < kSignalSourceCount; ++i) {
+    signals_[i] = 0;
+  }
+}
+
+RenderScheduler::~RenderScheduler() { Stop(); }
+
+bool RenderScheduler::Start(JavaVM* java_vm,
+                            const RequestRenderFunction& request_render) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (is_running_) {
+    LOGE("RenderScheduler: already started.");
+    return false;
+  }
+  if (java_vm == nullptr || !request_render) {
+    LOGE("RenderScheduler: invalid arguments.");
+    return false;
+  }
+
+  java_vm_ = java_vm;
+  request_render_ = request_render;
+  is_stopping_ = false;
+  has_new_data_ = false;
+  is_frame_in_flight_ = false;
+  for (int i = 0; i < kSignalSourceCount; ++i) {
+    signals_[i] = 0;
+  }
+  requests_ = 0;
+  frames_ = 0;
+  dropped_frames_ = 0;
+  janky_frames_ = 0;
+  last_request_time_ns_ = 0;
+  last_vsync_time_ns_ = 0;
+  request_vsync_time_ns_ = 0;
+
+  thread_ = std::thread(&RenderScheduler::ThreadLoop, this);
+  is_running_ = true;
+  return true;
+}
+
+void RenderScheduler::Stop() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!is_running_) {
+      return;
+    }
+    is_stopping_ = true;
+    if (looper_ != nullptr) {
+      ALooper_wake(looper_);
+    }
+  }
+  state_changed_.notify_all();
+  thread_.join();
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  is_running_ = false;
+  request_render_ = nullptr;
+}
+
+void RenderScheduler::Signal(SignalSource source) {
+  ++signals_[source];
+  if (has_new_data_.exchange(true)) {
+    // The scheduler already knows about pending data.
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (looper_ != nullptr) {
+      ALooper_wake(looper_);
+    }
+  }
+  state_changed_.notify_all();
+}
+
+void RenderScheduler::SetTargetFrameRate(int frames_per_second) {
+  target_frame_rate_ = frames_per_second > 0 ? frames_per_second : 0;
+}
+
+void RenderScheduler::OnFrameRendered() {
+  ++frames_;
+  const int vsyncs_per_frame = GetVsyncsPerFrame();
+  const int64_t present_time_ns =
+      request_vsync_time_ns_ + vsyncs_per_frame * vsync_period_ns_;
+  // Renders the scheduler did not request, e.g. after a surface change, have
+  // no due time.
+  const bool was_requested = is_frame_in_flight_.exchange(false);
+  if (was_requested && NowNs() > present_time_ns) {
+    ++janky_frames_;
+  }
+
+  EGLDisplay display = eglGetCurrentDisplay();
+  EGLSurface surface = eglGetCurrentSurface(EGL_DRAW);
+  if (surface == EGL_NO_SURFACE) {
+    return;
+  }
+  if (surface != paced_surface_ || vsyncs_per_frame != swap_interval_) {
+    // Drivers clamp the interval to EGL_MAX_SWAP_INTERVAL, the presentation
+    // time still paces the frames then.
+    eglSwapInterval(display, vsyncs_per_frame);
+    paced_surface_ = surface;
+    swap_interval_ = vsyncs_per_frame;
+  }
+  PresentationTimeFunc presentation_time = GetPresentationTimeFunction();
+  if (was_requested && vsyncs_per_frame > 1 && presentation_time != nullptr) {
+    presentation_time(display, surface, present_time_ns);
+  }
+}
+
+int64_t RenderScheduler::GetFrameDeadlineNs() const {
+  if (!is_frame_in_flight_) {
+    return 0;
+  }
+  return request_vsync_time_ns_ + GetVsyncsPerFrame() * vsync_period_ns_;
+}
+
+RenderScheduler::Stats RenderScheduler::GetStats() const {
+  Stats stats;
+  for (int i = 0; i < kSignalSourceCount; ++i) {
+    stats.signals[i] = signals_[i];
+  }
+  stats.requests = requests_;
+  stats.frames = frames_;
+  stats.dropped_frames = dropped_frames_;
+  stats.janky_frames = janky_frames_;
+  stats.vsync_period_ns = vsync_period_ns_;
+  stats.uses_choreographer = uses_choreographer_;
+  return stats;
+}
+
+void RenderScheduler::ThreadLoop() {
+  // Attach once for the lifetime of the thread instead of per request.
+  if (java_vm_->AttachCurrentThread(&env_, nullptr) != JNI_OK) {
+    LOGE("RenderScheduler: failed to attach the scheduler thread.");
+    return;
+  }
+
+  void* choreographer = nullptr;
+  ChoreographerPostFrameCallbackFunction post_frame_callback = nullptr;
+  void* android_lib = dlopen("libandroid.so", RTLD_NOW | RTLD_LOCAL);
+  if (android_lib != nullptr) {
+    ChoreographerGetInstanceFunction get_instance =
+        reinterpret_cast<ChoreographerGetInstanceFunction>(
+            dlsym(android_lib, "AChoreographer_getInstance"));
+    post_frame_callback =
+        reinterpret_cast<ChoreographerPostFrameCallbackFunction>(
+            dlsym(android_lib, "AChoreographer_postFrameCallback"));
+    if (get_instance != nullptr && post_frame_callback != nullptr) {
+      // The choreographer instance belongs to the calling thread's looper.
+      ALooper_prepare(ALOOPER_PREPARE_ALLOW_NON_CALLBACKS);
+      choreographer = get_instance();
+    }
+  }
+  uses_choreographer_ = choreographer != nullptr;
+
+  if (choreographer != nullptr) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      looper_ = ALooper_prepare(ALOOPER_PREPARE_ALLOW_NON_CALLBACKS);
+      ALooper_acquire(looper_);
+    }
+    is_frame_callback_posted_ = false;
+    while (!is_stopping_) {
+      // Frame callbacks must be posted from the looper thread, so Signal()
+      // only wakes the looper and the callback is posted here.
+      if (has_new_data_ && !is_frame_callback_posted_) {
+        is_frame_callback_posted_ = true;
+        post_frame_callback(choreographer, &RenderScheduler::FrameCallback,
+                            this);
+      }
+      ALooper_pollOnce(-1, nullptr, nullptr, nullptr);
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    ALooper_release(looper_);
+    looper_ = nullptr;
+  } else {
+    LOGI("RenderScheduler: AChoreographer unavailable, using a timer.");
+    while (true) {
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        state_changed_.wait(lock,
+                            [this] { return is_stopping_ || has_new_data_; });
+        if (is_stopping_) {
+          break;
+        }
+      }
+      // Sleep until the next tick of a fixed 60Hz clock so bursts of signals
+      // are coalesced into one request.
+      int64_t now = NowNs();
+      int64_t next_tick =
+          (now / kFallbackVsyncPeriodNs + 1) * kFallbackVsyncPeriodNs;
+      std::this_thread::sleep_for(std::chrono::nanoseconds(next_tick - now));
+      OnVsync(next_tick);
+    }
+  }
+
+  if (android_lib != nullptr) {
+    dlclose(android_lib);
+  }
+  env_ = nullptr;
+  java_vm_->DetachCurrentThread();
+}
+
+int RenderScheduler::GetVsyncsPerFrame() const {
+  const int target_frame_rate = target_frame_rate_;
+  if (target_frame_rate == 0) {
+    return 1;
+  }
+  const int64_t frame_period_ns = 1000000000LL / target_frame_rate;
+  const int64_t vsync_period_ns = vsync_period_ns_;
+  return std::max<int>(
+      1, (frame_period_ns + vsync_period_ns / 2) / vsync_period_ns);
+}
+
+void RenderScheduler::OnVsync(int64_t vsync_time_ns) {
+  // Frame callbacks are only posted while data is pending, so only deltas
+  // close to the current estimate are consecutive vsyncs.
+  const int64_t delta_ns = vsync_time_ns - last_vsync_time_ns_;
+  const int64_t vsync_period_ns = vsync_period_ns_;
+  if (last_vsync_time_ns_ > 0 && delta_ns > vsync_period_ns / 2 &&
+      delta_ns < vsync_period_ns + vsync_period_ns / 2) {
+    vsync_period_ns_ = (vsync_period_ns * 7 + delta_ns) / 8;
+  }
+  last_vsync_time_ns_ = vsync_time_ns;
+
+  if (!has_new_data_ || is_stopping_) {
+    return;
+  }
+  // Keep the data pending until the frame period since the previous
+  // request passed, with half a vsync of slack for jittery callbacks.
+  const int vsyncs_per_frame = GetVsyncsPerFrame();
+  if (vsyncs_per_frame > 1 &&
+      vsync_time_ns - last_request_time_ns_ <
+          vsyncs_per_frame * vsync_period_ns - vsync_period_ns / 2) {
+    return;
+  }
+  if (is_frame_in_flight_ &&
+      vsync_time_ns - last_request_time_ns_ < kMaxFrameInFlightNs) {
+    // Keep the data pending, it is picked up by the first vsync after the
+    // frame is done.
+    ++dropped_frames_;
+    return;
+  }
+  has_new_data_ = false;
+  is_frame_in_flight_ = true;
+  last_request_time_ns_ = vsync_time_ns;
+  request_vsync_time_ns_ = vsync_time_ns;
+  ++requests_;
+  request_render_(env_);
+}
+
+void RenderScheduler::FrameCallback(long /*frame_time_nanos*/, void* data) {
+  RenderScheduler* scheduler = static_cast<RenderScheduler*>(data);
+  scheduler->is_frame_callback_posted_ = false;
+  // frame_time_nanos overflows a 32 bit long, the callback runs right after
+  // the vsync.
+  scheduler->OnVsync(NowNs());
+}
+
+}  // namespace tango_gl
@@ -0,0 +1,296 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <EGL/egl.h>
+#include <string.h>
+
+#include "tango-gl/render_state.h"
+
+#include "tango-gl/counters.h"
+#include "tango-gl/frame_arena.h"
+#include "tango-gl/memory_tracker.h"
+
+#ifndef GL_PIXEL_UNPACK_BUFFER
+#define GL_PIXEL_UNPACK_BUFFER 0x88EC
+#endif
+
+namespace {
+// Marks a binding or value the shadow does not know.
+const GLuint kUnknown = 0xffffffff;
+
+const GLenum kBufferTargets[] = {GL_ARRAY_BUFFER, GL_ELEMENT_ARRAY_BUFFER,
+                                 GL_PIXEL_UNPACK_BUFFER};
+const int kBufferTargetCount = 3;
+
+const GLenum kTextureTargets[] = {GL_TEXTURE_2D, GL_TEXTURE_EXTERNAL_OES};
+const int kTextureTargetCount = 2;
+// Units beyond this are not shadowed. GL ES 2.0 guarantees 8.
+const int kTextureUnitCount = 8;
+
+const GLenum kCapabilities[] = {GL_BLEND, GL_CULL_FACE, GL_DEPTH_TEST,
+                                GL_SCISSOR_TEST, GL_STENCIL_TEST};
+const int kCapabilityCount = 5;
+
+// Shadowed state, only touched on the GL thread.
+EGLContext g_context = EGL_NO_CONTEXT;
+int g_redundant_call_count = 0;
+GLuint g_program = kUnknown;
+GLuint g_buffers[kBufferTargetCount];
+GLuint g_active_texture_unit = kUnknown;
+GLuint g_textures[kTextureUnitCount][kTextureTargetCount];
+// GL_TRUE, GL_FALSE or kUnknown.
+GLuint g_capabilities[kCapabilityCount];
+GLfloat g_line_width = -1.0f;
+GLuint g_vertex_array = kUnknown;
+
+// Vertex array entry points, resolved on first use. Their addresses do not
+// depend on the context, and every context of the process is on the same
+// driver.
+typedef void (GL_APIENTRY* GenVertexArraysFunc)(GLsizei n, GLuint* arrays);
+typedef void (GL_APIENTRY* BindVertexArrayFunc)(GLuint array);
+typedef void (GL_APIENTRY* DeleteVertexArraysFunc)(GLsizei n,
+                                                   const GLuint* arrays);
+bool g_has_resolved_vertex_arrays = false;
+GenVertexArraysFunc g_gen_vertex_arrays = nullptr;
+BindVertexArrayFunc g_bind_vertex_array = nullptr;
+DeleteVertexArraysFunc g_delete_vertex_arrays = nullptr;
+
+void ResolveVertexArrays() {
+  g_has_resolved_vertex_arrays = true;
+  const char* version = reinterpret_cast<const char*>(glGetString(GL_VERSION));
+  const char* extensions =
+      reinterpret_cast<const char*>(glGetString(GL_EXTENSIONS));
+  const bool is_es3 =
+      version != nullptr && strncmp(version, "OpenGL ES 3", 11) == 0;
+  if (!is_es3 && (extensions == nullptr ||
+                  strstr(extensions, "GL_OES_vertex_array_object") ==
+                      nullptr)) {
+    return;
+  }
+  g_gen_vertex_arrays = reinterpret_cast<GenVertexArraysFunc>(
+      eglGetProcAddress(is_es3 ? "glGenVertexArrays" : "glGenVertexArraysOES"));
+  g_bind_vertex_array = reinterpret_cast<BindVertexArrayFunc>(
+      eglGetProcAddress(is_es3 ? "glBindVertexArray" : "glBindVertexArrayOES"));
+  g_delete_vertex_arrays =
+      reinterpret_cast<DeleteVertexArraysFunc>(eglGetProcAddress(
+          is_es3 ? "glDeleteVertexArrays" : "glDeleteVertexArraysOES"));
+  if (g_gen_vertex_arrays == nullptr || g_bind_vertex_array == nullptr ||
+      g_delete_vertex_arrays == nullptr) {
+    g_gen_vertex_arrays = nullptr;
+    g_bind_vertex_array = nullptr;
+    g_delete_vertex_arrays = nullptr;
+  }
+}
+
+int GetBufferTargetIndex(GLenum target) {
+  for (int i = 0; i < kBufferTargetCount; ++i) {
+    if (kBufferTargets[i] == target) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+int GetTextureTargetIndex(GLenum target) {
+  for (int i = 0; i < kTextureTargetCount; ++i) {
+    if (kTextureTargets[i] == target) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+int GetCapabilityIndex(GLenum capability) {
+  for (int i = 0; i < kCapabilityCount; ++i) {
+    if (kCapabilities[i] == capability) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+// Update a shadowed value, returning whether the call has to reach GL.
+bool Shadow(GLuint* shadow, GLuint value) {
+  if (*shadow == value) {
+    ++g_redundant_call_count;
+    return false;
+  }
+  *shadow = value;
+  return true;
+}
+
+void SetCapability(GLenum capability, GLuint value) {
+  int index = GetCapabilityIndex(capability);
+  if (index >= 0 && !Shadow(&g_capabilities[index], value)) {
+    return;
+  }
+  if (value == GL_TRUE) {
+    glEnable(capability);
+  } else {
+    glDisable(capability);
+  }
+}
+}  // namespace
+
+namespace tango_gl {
+
+void RenderState::BeginFrame() {
+  EGLContext context = eglGetCurrentContext();
+  if (context != g_context) {
+    MemoryTracker::ReleaseContext(g_context);
+    g_context = context;
+    Invalidate();
+    util::EnableGlDebugOutput();
+  }
+  g_redundant_call_count = 0;
+  FrameArena::ForThisThread().Reset();
+  MemoryTracker::BeginFrame();
+  Counters::BeginFrame();
+  util::SampleGlErrors();
+}
+
+void RenderState::Invalidate() {
+  g_program = kUnknown;
+  for (int i = 0; i < kBufferTargetCount; ++i) {
+    g_buffers[i] = kUnknown;
+  }
+  g_active_texture_unit = kUnknown;
+  for (int unit = 0; unit < kTextureUnitCount; ++unit) {
+    for (int i = 0; i < kTextureTargetCount; ++i) {
+      g_textures[unit][i] = kUnknown;
+    }
+  }
+  for (int i = 0; i < kCapabilityCount; ++i) {
+    g_capabilities[i] = kUnknown;
+  }
+  g_line_width = -1.0f;
+  g_vertex_array = kUnknown;
+}
+
+int RenderState::GetRedundantCallCount() { return g_redundant_call_count; }
+
+void RenderState::UseProgram(GLuint program) {
+  if (Shadow(&g_program, program)) {
+    glUseProgram(program);
+    Counters::Increment(Counters::kProgramBinds);
+  }
+}
+
+void RenderState::BindBuffer(GLenum target, GLuint buffer) {
+  int index = GetBufferTargetIndex(target);
+  if (index < 0 || Shadow(&g_buffers[index], buffer)) {
+    glBindBuffer(target, buffer);
+  }
+}
+
+void RenderState::ActiveTexture(GLenum texture_unit) {
+  if (Shadow(&g_active_texture_unit, texture_unit)) {
+    glActiveTexture(texture_unit);
+  }
+}
+
+void RenderState::BindTexture(GLenum target, GLuint texture) {
+  int index = GetTextureTargetIndex(target);
+  if (index >= 0 && g_active_texture_unit != kUnknown &&
+      g_active_texture_unit - GL_TEXTURE0 <
+          static_cast<GLuint>(kTextureUnitCount)) {
+    GLuint* shadow = &g_textures[g_active_texture_unit - GL_TEXTURE0][index];
+    if (!Shadow(shadow, texture)) {
+      return;
+    }
+  }
+  glBindTexture(target, texture);
+}
+
+void RenderState::Enable(GLenum capability) {
+  SetCapability(capability, GL_TRUE);
+}
+
+void RenderState::Disable(GLenum capability) {
+  SetCapability(capability, GL_FALSE);
+}
+
+void RenderState::LineWidth(GLfloat width) {
+  if (width == g_line_width) {
+    ++g_redundant_call_count;
+    return;
+  }
+  g_line_width = width;
+  glLineWidth(width);
+}
+
+void RenderState::DeleteBuffers(GLsizei count, const GLuint* buffers) {
+  for (GLsizei i = 0; i < count; ++i) {
+    for (int target = 0; target < kBufferTargetCount; ++target) {
+      if (g_buffers[target] == buffers[i]) {
+        g_buffers[target] = 0;
+      }
+    }
+    MemoryTracker::Untrack(MemoryTracker::kBuffer, buffers[i]);
+  }
+  glDeleteBuffers(count, buffers);
+}
+
+void RenderState::DeleteTextures(GLsizei count, const GLuint* textures) {
+  for (GLsizei i = 0; i < count; ++i) {
+    for (int unit = 0; unit < kTextureUnitCount; ++unit) {
+      for (int target = 0; target < kTextureTargetCount; ++target) {
+        if (g_textures[unit][target] == textures[i]) {
+          g_textures[unit][target] = 0;
+        }
+      }
+    }
+    MemoryTracker::Untrack(MemoryTracker::kTexture, textures[i]);
+  }
+  glDeleteTextures(count, textures);
+}
+
+bool RenderState::HasVertexArrays() {
+  if (!g_has_resolved_vertex_arrays) {
+    ResolveVertexArrays();
+  }
+  return g_bind_vertex_array != nullptr;
+}
+
+void RenderState::GenVertexArrays(GLsizei count, GLuint* arrays) {
+  if (HasVertexArrays()) {
+    g_gen_vertex_arrays(count, arrays);
+  }
+}
+
+void RenderState::BindVertexArray(GLuint array) {
+  if (!HasVertexArrays() || !Shadow(&g_vertex_array, array)) {
+    return;
+  }
+  g_bind_vertex_array(array);
+  g_buffers[GetBufferTargetIndex(GL_ELEMENT_ARRAY_BUFFER)] = kUnknown;
+}
+
+void RenderState::DeleteVertexArrays(GLsizei count, const GLuint* arrays) {
+  if (!HasVertexArrays()) {
+    return;
+  }
+  for (GLsizei i = 0; i < count; ++i) {
+    if (g_vertex_array == arrays[i]) {
+      // Deleting the bound array binds the default one.
+      g_vertex_array = 0;
+      g_buffers[GetBufferTargetIndex(GL_ELEMENT_ARRAY_BUFFER)] = kUnknown;
+    }
+  }
+  g_delete_vertex_arrays(count, arrays);
+}
+
+}  // namespace tango_gl
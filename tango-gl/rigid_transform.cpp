@@ -0,0 +1,53 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "tango-gl/rigid_transform.h"
+
+namespace tango_gl {
+
+RigidTransform RigidTransform::FromMatrix(const glm::mat4& A_T_B) {
+  return RigidTransform(glm::quat_cast(glm::mat3(A_T_B)), glm::vec3(A_T_B[3]));
+}
+
+void RigidTransform::Apply(const float* B_points, size_t count,
+                           float* A_points) const {
+  const glm::mat3 rotation = glm::mat3_cast(rotation_);
+  for (size_t i = 0; i < count; ++i) {
+    const glm::vec3 point(B_points[0], B_points[1], B_points[2]);
+    const glm::vec3 transformed = rotation * point + translation_;
+    A_points[0] = transformed.x;
+    A_points[1] = transformed.y;
+    A_points[2] = transformed.z;
+    B_points += 3;
+    A_points += 3;
+  }
+}
+
+glm::mat4 RigidTransform::ToMatrix() const {
+  glm::mat4 A_T_B(glm::mat3_cast(rotation_));
+  A_T_B[3] = glm::vec4(translation_, 1.0f);
+  return A_T_B;
+}
+
+glm::mat4 InverseRigidMatrix(const glm::mat4& A_T_B) {
+  const glm::mat3 B_R_A = glm::transpose(glm::mat3(A_T_B));
+  glm::mat4 B_T_A(B_R_A);
+  B_T_A[3] = glm::vec4(B_R_A * -glm::vec3(A_T_B[3]), 1.0f);
+  return B_T_A;
+}
+
+}  // namespace tango_gl
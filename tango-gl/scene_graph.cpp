@@ -0,0 +1,210 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+
+#include "tango-gl/frame_constants.h"
+#include "tango-gl/render_state.h"
+#include "tango-gl/scene_graph.h"
+
+namespace tango_gl {
+
+SceneGraph::SceneGraph() : is_sorted_(true), drawn_count_(0) {}
+
+size_t SceneGraph::Find(const DrawableObject* drawable) const {
+  for (size_t i = 0; i < nodes_.size(); ++i) {
+    if (nodes_[i].drawable == drawable) {
+      return i;
+    }
+  }
+  return nodes_.size();
+}
+
+void SceneGraph::Add(const DrawableObject* drawable, Pass pass) {
+  size_t index = Find(drawable);
+  if (index == nodes_.size()) {
+    Node node;
+    node.drawable = drawable;
+    node.pass = pass;
+    node.is_visible = true;
+    node.has_bounds = false;
+    node.view_mask = ~0u;
+    node.sort_key = 0;
+    nodes_.push_back(node);
+  } else if (nodes_[index].pass == pass) {
+    return;
+  }
+  nodes_[index].pass = pass;
+  is_sorted_ = false;
+}
+
+void SceneGraph::Remove(const DrawableObject* drawable) {
+  size_t index = Find(drawable);
+  if (index != nodes_.size()) {
+    // Erasing keeps the order, the list stays sorted.
+    nodes_.erase(nodes_.begin() + index);
+  }
+}
+
+void SceneGraph::Clear() {
+  nodes_.clear();
+  is_sorted_ = true;
+}
+
+void SceneGraph::SetVisible(const DrawableObject* drawable, bool is_visible) {
+  size_t index = Find(drawable);
+  if (index != nodes_.size()) {
+    nodes_[index].is_visible = is_visible;
+  }
+}
+
+void SceneGraph::SetBounds(const DrawableObject* drawable,
+                           const BoundingBox& bounds) {
+  size_t index = Find(drawable);
+  if (index != nodes_.size()) {
+    nodes_[index].bounds = bounds;
+    nodes_[index].has_bounds = true;
+  }
+}
+
+void SceneGraph::SetViewMask(const DrawableObject* drawable,
+                             uint32_t view_mask) {
+  size_t index = Find(drawable);
+  if (index != nodes_.size()) {
+    nodes_[index].view_mask = view_mask;
+  }
+}
+
+void SceneGraph::Sort() {
+  for (Node& node : nodes_) {
+    node.sort_key = (static_cast<uint64_t>(node.pass) << 62) |
+                    (static_cast<uint64_t>(node.drawable->shader_program_)
+                     << 31) |
+                    (node.drawable->GetTextureId() & 0x7fffffffu);
+  }
+  // Stable, so drawables sharing all state keep the order they were added in.
+  std::stable_sort(nodes_.begin(), nodes_.end(),
+                   [](const Node& a, const Node& b) {
+                     return a.sort_key < b.sort_key;
+                   });
+  is_sorted_ = true;
+}
+
+bool SceneGraph::IsDrawn(const Node& node, ViewFrustum* view_frustum,
+                         uint32_t view_bit) const {
+  if (!node.is_visible || (node.view_mask & view_bit) == 0) {
+    return false;
+  }
+  if (!node.has_bounds || view_frustum == nullptr ||
+      node.pass == kBackground) {
+    return true;
+  }
+  return view_frustum->IsBoxVisible(node.bounds,
+                                    node.drawable->GetTransformationMatrix());
+}
+
+void SceneGraph::Render(const glm::mat4& projection_mat,
+                        const glm::mat4& view_mat, ViewFrustum* view_frustum) {
+  if (!is_sorted_) {
+    Sort();
+  }
+  drawn_count_ = 0;
+  RenderView(projection_mat, view_mat, view_frustum, 1u);
+}
+
+void SceneGraph::RenderViews(const View* views, size_t view_count) {
+  if (view_count > kMaxViewCount) {
+    LOGE("SceneGraph: %zu views, only the first %zu are drawn", view_count,
+         kMaxViewCount);
+    view_count = kMaxViewCount;
+  }
+  if (!is_sorted_) {
+    Sort();
+  }
+  drawn_count_ = 0;
+
+  // The scissor limits the clears to the viewport, glClear ignores the
+  // viewport itself.
+  RenderState::Enable(GL_SCISSOR_TEST);
+  for (size_t i = 0; i < view_count; ++i) {
+    const View& view = views[i];
+    glViewport(view.x, view.y, view.width, view.height);
+    glScissor(view.x, view.y, view.width, view.height);
+    GLbitfield clear_mask = GL_DEPTH_BUFFER_BIT;
+    if (view.is_color_cleared) {
+      glClearColor(view.clear_color.r, view.clear_color.g, view.clear_color.b,
+                   view.clear_color.a);
+      clear_mask |= GL_COLOR_BUFFER_BIT;
+    }
+    glClear(clear_mask);
+    RenderView(view.projection_mat, view.view_mat, view.view_frustum,
+               1u << i);
+  }
+  RenderState::Disable(GL_SCISSOR_TEST);
+}
+
+void SceneGraph::RenderView(const glm::mat4& projection_mat,
+                            const glm::mat4& view_mat,
+                            ViewFrustum* view_frustum, uint32_t view_bit) {
+  // Multiplied and uploaded once for every drawable of the view.
+  FrameConstants::Set(projection_mat, view_mat);
+  transparent_nodes_.clear();
+
+  const glm::mat4 identity(1.0f);
+  const glm::vec3 eye(glm::inverse(view_mat)[3]);
+  bool is_depth_test_on = false;
+  for (size_t i = 0; i < nodes_.size(); ++i) {
+    const Node& node = nodes_[i];
+    if (!IsDrawn(node, view_frustum, view_bit)) {
+      continue;
+    }
+    if (node.pass == kTransparent) {
+      const glm::vec3 position(node.drawable->GetTransformationMatrix()[3]);
+      const glm::vec3 offset = position - eye;
+      transparent_nodes_.push_back(
+          std::make_pair(glm::dot(offset, offset), i));
+      continue;
+    }
+    if (node.pass == kBackground) {
+      RenderState::Disable(GL_DEPTH_TEST);
+      node.drawable->Render(identity, identity);
+    } else {
+      if (!is_depth_test_on) {
+        RenderState::Enable(GL_DEPTH_TEST);
+        is_depth_test_on = true;
+      }
+      node.drawable->Render(projection_mat, view_mat);
+    }
+    ++drawn_count_;
+  }
+
+  if (transparent_nodes_.empty()) {
+    return;
+  }
+  // Farthest first.
+  std::sort(transparent_nodes_.begin(), transparent_nodes_.end(),
+            [](const std::pair<float, size_t>& a,
+               const std::pair<float, size_t>& b) {
+              return a.first > b.first;
+            });
+  RenderState::Enable(GL_DEPTH_TEST);
+  for (const std::pair<float, size_t>& transparent : transparent_nodes_) {
+    nodes_[transparent.second].drawable->Render(projection_mat, view_mat);
+    ++drawn_count_;
+  }
+}
+
+}  // namespace tango_gl
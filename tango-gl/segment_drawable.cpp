@@ -25,5 +25,6 @@ SegmentDrawable::SegmentDrawable() : tango_gl::Line(5.0f, GL_LINES) {
 void SegmentDrawable::UpdateSegment(const Segment& segment) {
   vec_vertices_[0] = segment.start;
   vec_vertices_[1] = segment.end;
+  MarkVerticesDirty(0);
 }
 }  // namespace tango_gl
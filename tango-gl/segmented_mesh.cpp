@@ -0,0 +1,305 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <string.h>
+
+#include <algorithm>
+#include <limits>
+
+#include "tango-gl/segmented_mesh.h"
+
+namespace {
+// Bits per grid axis in a segment key, enough for any reconstruction.
+const int kKeyBits = 21;
+const int32_t kKeyBias = 1 << (kKeyBits - 1);
+const uint64_t kKeyMask = (static_cast<uint64_t>(1) << kKeyBits) - 1;
+}  // namespace
+
+namespace tango_gl {
+
+SegmentedMesh::SegmentedMesh()
+    : pending_(nullptr),
+      free_(nullptr),
+      producer_free_(nullptr),
+      held_(nullptr),
+      color_(0.8f, 0.8f, 0.8f) {}
+
+SegmentedMesh::~SegmentedMesh() {
+  DeleteList(pending_.exchange(nullptr));
+  DeleteList(free_.exchange(nullptr));
+  DeleteList(producer_free_);
+  DeleteList(held_);
+}
+
+void SegmentedMesh::OnMeshVectorAvailable(
+    int segment_count, const TangoMesh_Experimental* segments) {
+  if (segment_count <= 0) {
+    return;
+  }
+
+  Batch* batch = producer_free_;
+  if (batch == nullptr) {
+    batch = producer_free_ = free_.exchange(nullptr, std::memory_order_acquire);
+  }
+  if (batch == nullptr) {
+    batch = new Batch();
+  } else {
+    producer_free_ = batch->next;
+  }
+
+  if (batch->segments.size() < static_cast<size_t>(segment_count)) {
+    batch->segments.resize(segment_count);
+  }
+  batch->segment_count = 0;
+  for (int i = 0; i < segment_count; ++i) {
+    SegmentData* data = &batch->segments[batch->segment_count];
+    if (!ConvertSegment(segments[i], data)) {
+      LOGE("SegmentedMesh: segment with %u vertices cannot be drawn.",
+           segments[i].num_vertices);
+      continue;
+    }
+    data->is_done = false;
+    ++batch->segment_count;
+  }
+
+  batch->next = pending_.load(std::memory_order_relaxed);
+  while (!pending_.compare_exchange_weak(batch->next, batch,
+                                         std::memory_order_release,
+                                         std::memory_order_relaxed)) {
+  }
+}
+
+int SegmentedMesh::Update(int max_update_count) {
+  Batch* head = pending_.exchange(nullptr, std::memory_order_acquire);
+  if (head != nullptr) {
+    // The new batches are newer than the held ones.
+    Batch* tail = head;
+    while (tail->next != nullptr) {
+      tail = tail->next;
+    }
+    tail->next = held_;
+    held_ = head;
+  }
+  if (held_ == nullptr) {
+    return 0;
+  }
+
+  // Batches come newest first, so the first time a key shows up is its latest
+  // version and older ones are skipped, whether the latest one is uploaded
+  // now or waits for the budget.
+  updated_keys_.clear();
+  int update_count = 0;
+  Batch* done_head = nullptr;
+  Batch* done_tail = nullptr;
+  Batch** link = &held_;
+  while (*link != nullptr) {
+    Batch* batch = *link;
+    bool is_batch_done = true;
+    for (size_t i = 0; i < batch->segment_count; ++i) {
+      SegmentData& data = batch->segments[i];
+      if (data.is_done) {
+        continue;
+      }
+      const uint64_t key = SegmentKey(data.index);
+      if (!updated_keys_.insert(key).second) {
+        data.is_done = true;
+        continue;
+      }
+      if (update_count == max_update_count) {
+        is_batch_done = false;
+        continue;
+      }
+      data.is_done = true;
+      ++update_count;
+      if (data.indices.empty()) {
+        segments_.erase(key);
+        continue;
+      }
+
+      Segment& segment = segments_[key];
+      if (!segment.mesh) {
+        segment.mesh.reset(new Mesh(GL_TRIANGLES));
+        segment.mesh->SetShader(true);
+        segment.mesh->SetColor(color_);
+      }
+      segment.mesh->SetVertices(data.vertices, data.normals, data.indices);
+      segment.min = data.min;
+      segment.max = data.max;
+    }
+    if (!is_batch_done) {
+      link = &batch->next;
+      continue;
+    }
+    *link = batch->next;
+    batch->next = done_head;
+    done_head = batch;
+    if (done_tail == nullptr) {
+      done_tail = batch;
+    }
+  }
+
+  // Hand the finished batches back to the producer, their arrays keep their
+  // capacity.
+  if (done_head != nullptr) {
+    done_tail->next = free_.load(std::memory_order_relaxed);
+    while (!free_.compare_exchange_weak(done_tail->next, done_head,
+                                        std::memory_order_release,
+                                        std::memory_order_relaxed)) {
+    }
+  }
+  return update_count;
+}
+
+void SegmentedMesh::Clear() {
+  Batch* head = pending_.exchange(nullptr, std::memory_order_acquire);
+  if (head == nullptr) {
+    head = held_;
+  } else {
+    Batch* tail = head;
+    while (tail->next != nullptr) {
+      tail = tail->next;
+    }
+    tail->next = held_;
+  }
+  held_ = nullptr;
+  if (head != nullptr) {
+    Batch* tail = head;
+    while (tail->next != nullptr) {
+      tail = tail->next;
+    }
+    tail->next = free_.load(std::memory_order_relaxed);
+    while (!free_.compare_exchange_weak(tail->next, head,
+                                        std::memory_order_release,
+                                        std::memory_order_relaxed)) {
+    }
+  }
+  segments_.clear();
+}
+
+void SegmentedMesh::SetColor(const Color& color) {
+  color_ = color;
+  for (auto& segment : segments_) {
+    segment.second.mesh->SetColor(color_);
+  }
+}
+
+void SegmentedMesh::Render(const glm::mat4& projection_mat,
+                           const glm::mat4& view_mat,
+                           ViewFrustum* view_frustum) const {
+  for (const auto& segment : segments_) {
+    if (view_frustum == nullptr ||
+        view_frustum->IsBoxVisible(segment.second.min, segment.second.max)) {
+      segment.second.mesh->Render(projection_mat, view_mat);
+    }
+  }
+}
+
+bool SegmentedMesh::ConvertSegment(const TangoMesh_Experimental& segment,
+                                   SegmentData* data) {
+  std::copy(segment.index, segment.index + 3, data->index);
+  data->vertices.clear();
+  data->normals.clear();
+  data->indices.clear();
+  if (segment.num_faces == 0 || segment.num_vertices == 0) {
+    // Marks the segment for removal.
+    return true;
+  }
+  if (segment.num_vertices > std::numeric_limits<GLushort>::max() + 1u) {
+    return false;
+  }
+
+  const size_t vertex_count = segment.num_vertices;
+  data->vertices.resize(vertex_count * 3);
+  memcpy(data->vertices.data(), segment.vertices,
+         vertex_count * 3 * sizeof(GLfloat));
+
+  data->indices.resize(segment.num_faces * 3);
+  for (uint32_t i = 0; i < segment.num_faces; ++i) {
+    for (int j = 0; j < 3; ++j) {
+      const uint32_t index = segment.faces[i][j];
+      if (index >= vertex_count) {
+        data->indices.clear();
+        return false;
+      }
+      data->indices[i * 3 + j] = static_cast<GLushort>(index);
+    }
+  }
+
+  if (segment.has_normals) {
+    data->normals.resize(vertex_count * 3);
+    memcpy(data->normals.data(), segment.normals,
+           vertex_count * 3 * sizeof(GLfloat));
+  } else {
+    // Sum of the face normals around each vertex, the cross product length
+    // weights them by area.
+    data->normals.assign(vertex_count * 3, 0.0f);
+    const GLfloat* v = data->vertices.data();
+    GLfloat* n = data->normals.data();
+    for (size_t i = 0; i < data->indices.size(); i += 3) {
+      const GLushort a = data->indices[i];
+      const GLushort b = data->indices[i + 1];
+      const GLushort c = data->indices[i + 2];
+      const glm::vec3 p0(v[a * 3], v[a * 3 + 1], v[a * 3 + 2]);
+      const glm::vec3 p1(v[b * 3], v[b * 3 + 1], v[b * 3 + 2]);
+      const glm::vec3 p2(v[c * 3], v[c * 3 + 1], v[c * 3 + 2]);
+      const glm::vec3 face_normal = glm::cross(p1 - p0, p2 - p0);
+      for (GLushort vertex : {a, b, c}) {
+        n[vertex * 3] += face_normal.x;
+        n[vertex * 3 + 1] += face_normal.y;
+        n[vertex * 3 + 2] += face_normal.z;
+      }
+    }
+    for (size_t i = 0; i < data->normals.size(); i += 3) {
+      glm::vec3 normal(n[i], n[i + 1], n[i + 2]);
+      const float length = glm::length(normal);
+      if (length > 0.0f) {
+        normal /= length;
+      }
+      n[i] = normal.x;
+      n[i + 1] = normal.y;
+      n[i + 2] = normal.z;
+    }
+  }
+
+  data->min = glm::vec3(std::numeric_limits<float>::max());
+  data->max = glm::vec3(-std::numeric_limits<float>::max());
+  for (size_t i = 0; i < vertex_count; ++i) {
+    const glm::vec3 p(segment.vertices[i][0], segment.vertices[i][1],
+                      segment.vertices[i][2]);
+    data->min = glm::min(data->min, p);
+    data->max = glm::max(data->max, p);
+  }
+  return true;
+}
+
+uint64_t SegmentedMesh::SegmentKey(const int32_t index[3]) {
+  return (static_cast<uint64_t>(index[0] + kKeyBias) & kKeyMask) |
+         ((static_cast<uint64_t>(index[1] + kKeyBias) & kKeyMask)
+          << kKeyBits) |
+         ((static_cast<uint64_t>(index[2] + kKeyBias) & kKeyMask)
+          << (2 * kKeyBits));
+}
+
+void SegmentedMesh::DeleteList(Batch* head) {
+  while (head != nullptr) {
+    Batch* next = head->next;
+    delete head;
+    head = next;
+  }
+}
+
+}  // namespace tango_gl
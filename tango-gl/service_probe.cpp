@@ -0,0 +1,253 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "tango-gl/service_probe.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include <algorithm>
+#include <atomic>
+
+#include "tango-gl/tracing.h"
+
+namespace {
+typedef tango_gl::ServiceProbe ServiceProbe;
+
+// Exact buckets below this, then 4 per octave.
+const uint64_t kLinearLimit = 8;
+
+struct SourceData {
+  std::atomic<uint64_t> count;
+  std::atomic<uint64_t> sum_us;
+  std::atomic<uint64_t> max_us;
+  std::atomic<uint64_t> early_count;
+  std::atomic<uint32_t> buckets[ServiceProbe::kBucketCount];
+};
+
+std::atomic<bool> g_is_enabled(false);
+SourceData g_sources[ServiceProbe::kSourceCount];
+
+const char* const kNames[ServiceProbe::kSourceCount] = {
+    "get_pose_at_time", "update_texture",   "get_camera_intrinsics",
+    "pose_callback",    "xyz_ij_callback", "frame_callback"};
+
+int FloorLog2(uint64_t value) {
+  int log2 = 0;
+  while (value >>= 1) {
+    ++log2;
+  }
+  return log2;
+}
+
+// Microseconds on the monotonic clock, as tracing::NowMicroseconds(), which
+// is only linked in with tracing.
+uint64_t NowMicroseconds() {
+  timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return static_cast<uint64_t>(now.tv_sec) * 1000000 + now.tv_nsec / 1000;
+}
+
+// Seconds on the clock of the Tango timestamps.
+double NowBootSeconds() {
+  timespec now;
+  clock_gettime(CLOCK_BOOTTIME, &now);
+  return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+void Record(ServiceProbe::Source source, uint64_t value_us, bool is_early) {
+  SourceData& data = g_sources[source];
+  data.count.fetch_add(1, std::memory_order_relaxed);
+  data.sum_us.fetch_add(value_us, std::memory_order_relaxed);
+  if (is_early) {
+    data.early_count.fetch_add(1, std::memory_order_relaxed);
+  }
+  uint64_t max_us = data.max_us.load(std::memory_order_relaxed);
+  while (value_us > max_us &&
+         !data.max_us.compare_exchange_weak(max_us, value_us,
+                                            std::memory_order_relaxed)) {
+  }
+  data.buckets[ServiceProbe::GetBucket(value_us)].fetch_add(
+      1, std::memory_order_relaxed);
+}
+}  // namespace
+
+namespace tango_gl {
+
+ServiceProbe::Histogram::Histogram()
+    : count(0), sum_us(0), max_us(0), early_count(0) {
+  memset(buckets, 0, sizeof(buckets));
+}
+
+float ServiceProbe::Histogram::GetPercentile(float percentile) const {
+  uint64_t total = 0;
+  for (uint32_t bucket_count : buckets) {
+    total += bucket_count;
+  }
+  if (total == 0) {
+    return 0.0f;
+  }
+  const double rank = percentile * total;
+  uint64_t below = 0;
+  for (int i = 0; i < kBucketCount; ++i) {
+    if (buckets[i] == 0 || below + buckets[i] < rank) {
+      below += buckets[i];
+      continue;
+    }
+    const double start = static_cast<double>(GetBucketStart(i));
+    double end = i + 1 < kBucketCount
+                     ? static_cast<double>(GetBucketStart(i + 1))
+                     : static_cast<double>(max_us) + 1.0;
+    // The samples of a bucket are spread evenly, but none is above max_us.
+    if (end > max_us + 1.0) {
+      end = std::max(start, max_us + 1.0);
+    }
+    const double fraction = (rank - below) / buckets[i];
+    return static_cast<float>(start + fraction * (end - start));
+  }
+  return static_cast<float>(max_us);
+}
+
+float ServiceProbe::Histogram::GetJitter() const {
+  return GetPercentile(0.9f) - GetPercentile(0.1f);
+}
+
+void ServiceProbe::SetEnabled(bool is_enabled) {
+  g_is_enabled.store(is_enabled, std::memory_order_relaxed);
+}
+
+bool ServiceProbe::IsEnabled() {
+  return g_is_enabled.load(std::memory_order_relaxed);
+}
+
+void ServiceProbe::RecordCall(Source source, uint64_t start_us,
+                              uint64_t duration_us) {
+  if (!IsEnabled()) {
+    return;
+  }
+  Record(source, duration_us, false);
+#ifdef TANGO_GL_TRACING
+  tracing::RecordSpan(kNames[source], "service", start_us, duration_us);
+#else
+  (void)start_us;
+#endif  // TANGO_GL_TRACING
+}
+
+void ServiceProbe::RecordCallback(Source source, double timestamp) {
+  if (!IsEnabled()) {
+    return;
+  }
+  const double latency = NowBootSeconds() - timestamp;
+  const bool is_early = latency < 0.0;
+  const uint64_t latency_us =
+      is_early ? 0 : static_cast<uint64_t>(latency * 1e6);
+  Record(source, latency_us, is_early);
+#ifdef TANGO_GL_TRACING
+  // A span from the sensor timestamp to the arrival, in the monotonic time
+  // of the trace.
+  const uint64_t now_us = NowMicroseconds();
+  const uint64_t duration_us = std::min(latency_us, now_us);
+  tracing::RecordSpan(kNames[source], "service", now_us - duration_us,
+                      duration_us);
+#endif  // TANGO_GL_TRACING
+}
+
+ServiceProbe::Histogram ServiceProbe::GetHistogram(Source source) {
+  const SourceData& data = g_sources[source];
+  Histogram histogram;
+  histogram.count = data.count.load(std::memory_order_relaxed);
+  histogram.sum_us = data.sum_us.load(std::memory_order_relaxed);
+  histogram.max_us = data.max_us.load(std::memory_order_relaxed);
+  histogram.early_count = data.early_count.load(std::memory_order_relaxed);
+  for (int i = 0; i < kBucketCount; ++i) {
+    histogram.buckets[i] = data.buckets[i].load(std::memory_order_relaxed);
+  }
+  return histogram;
+}
+
+void ServiceProbe::Reset() {
+  for (SourceData& data : g_sources) {
+    data.count.store(0, std::memory_order_relaxed);
+    data.sum_us.store(0, std::memory_order_relaxed);
+    data.max_us.store(0, std::memory_order_relaxed);
+    data.early_count.store(0, std::memory_order_relaxed);
+    for (std::atomic<uint32_t>& bucket : data.buckets) {
+      bucket.store(0, std::memory_order_relaxed);
+    }
+  }
+}
+
+int ServiceProbe::GetBucket(uint64_t value_us) {
+  if (value_us < kLinearLimit) {
+    return static_cast<int>(value_us);
+  }
+  const int octave = FloorLog2(value_us);
+  const int bucket = static_cast<int>(kLinearLimit) + 4 * (octave - 3) +
+                     static_cast<int>((value_us >> (octave - 2)) & 3);
+  return std::min(bucket, kBucketCount - 1);
+}
+
+uint64_t ServiceProbe::GetBucketStart(int bucket) {
+  if (bucket < static_cast<int>(kLinearLimit)) {
+    return static_cast<uint64_t>(bucket);
+  }
+  const int octave = 3 + (bucket - static_cast<int>(kLinearLimit)) / 4;
+  const uint64_t step = (bucket - kLinearLimit) % 4;
+  return (4 + step) << (octave - 2);
+}
+
+const char* ServiceProbe::GetName(Source source) { return kNames[source]; }
+
+std::string ServiceProbe::GetReport() {
+  std::string report;
+  for (int i = 0; i < kSourceCount; ++i) {
+    const Source source = static_cast<Source>(i);
+    const Histogram histogram = GetHistogram(source);
+    if (histogram.count == 0) {
+      continue;
+    }
+    char text[192];
+    snprintf(text, sizeof(text),
+             "%s n %llu p50 %.2f ms p99 %.2f ms max %.2f ms jitter %.2f ms",
+             kNames[i],
+             static_cast<unsigned long long>(histogram.count),
+             histogram.GetPercentile(0.5f) * 1e-3f,
+             histogram.GetPercentile(0.99f) * 1e-3f,
+             histogram.max_us * 1e-3f, histogram.GetJitter() * 1e-3f);
+    report += text;
+    if (histogram.early_count > 0) {
+      snprintf(text, sizeof(text), " early %llu",
+               static_cast<unsigned long long>(histogram.early_count));
+      report += text;
+    }
+    report += "\n";
+  }
+  return report;
+}
+
+ServiceProbe::ScopedCall::ScopedCall(Source source)
+    : source_(source),
+      start_us_(IsEnabled() ? NowMicroseconds() : 0) {}
+
+ServiceProbe::ScopedCall::~ScopedCall() {
+  if (start_us_ != 0) {
+    RecordCall(source_, start_us_, NowMicroseconds() - start_us_);
+  }
+}
+
+}  // namespace tango_gl
@@ -0,0 +1,446 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <string.h>
+
+#include <math.h>
+
+#include <algorithm>
+#include <chrono>
+
+#include "tango-gl/lz4.h"
+#include "tango-gl/session_recorder.h"
+#include "tango-gl/util.h"
+
+namespace {
+// How long the I/O thread sleeps when no sample is queued. Short next to a
+// camera frame, so the slots never fill up while the thread sleeps.
+const std::chrono::milliseconds kIdleInterval(2);
+
+// Frames the color encoder can hold before their packets come out, older
+// ones are forgotten, e.g. frames the encoder dropped.
+const size_t kMaxPendingFrameCount = 64;
+}  // namespace
+
+namespace tango_gl {
+
+SessionRecorder::SessionRecorder()
+    : file_(nullptr),
+      has_write_error_(false),
+      is_encoding_(false),
+      has_encoder_failed_(false),
+      encoded_record_(),
+      packet_callback_([this](const VideoEncoder::Packet& packet) {
+        WritePacket(packet);
+      }),
+      is_recording_(false),
+      is_stopping_(false),
+      active_record_count_(0),
+      dropped_count_(0),
+      written_byte_count_(0) {}
+
+SessionRecorder::~SessionRecorder() { Stop(); }
+
+bool SessionRecorder::Start(const char* path, const Options& options) {
+  if (thread_.joinable()) {
+    LOGE("SessionRecorder: a session is already being recorded.");
+    return false;
+  }
+  file_ = fopen(path, "wb");
+  if (file_ == nullptr) {
+    LOGE("SessionRecorder: could not create %s.", path);
+    return false;
+  }
+  setvbuf(file_, nullptr, _IOFBF, options.write_buffer_size);
+  options_ = options;
+  has_write_error_ = false;
+  is_encoding_ = false;
+  has_encoder_failed_ = false;
+  pending_frames_.clear();
+  dropped_count_.store(0, std::memory_order_relaxed);
+  written_byte_count_.store(0, std::memory_order_relaxed);
+
+  const int slot_counts[kStreamCount] = {options.pose_slot_count,
+                                         options.point_cloud_slot_count,
+                                         options.image_slot_count};
+  const size_t payload_sizes[kStreamCount] = {
+      sizeof(session::PoseRecord),
+      sizeof(session::PointCloudRecord) +
+          options.max_point_count * 3 * sizeof(float),
+      sizeof(session::ImageRecord) + options.max_image_data_size};
+  int total_slot_count = 0;
+  for (int stream = 0; stream < kStreamCount; ++stream) {
+    total_slot_count += slot_counts[stream];
+  }
+  slots_.clear();
+  slots_.resize(total_slot_count);
+  ready_slots_.reset(new BoundedQueue<int>(total_slot_count));
+  int slot = 0;
+  for (int stream = 0; stream < kStreamCount; ++stream) {
+    free_slots_[stream].reset(new BoundedQueue<int>(slot_counts[stream]));
+    for (int i = 0; i < slot_counts[stream]; ++i, ++slot) {
+      slots_[slot].stream = static_cast<Stream>(stream);
+      slots_[slot].payload.resize(payload_sizes[stream]);
+      free_slots_[stream]->Push(slot);
+    }
+  }
+  compressed_data_.resize(std::max(
+      lz4::GetMaxCompressedSize(std::max(payload_sizes[kPointCloudStream],
+                                         payload_sizes[kImageStream])),
+      point_cloud_codec::GetMaxEncodedSize(options.max_point_count)));
+
+  session::FileHeader header;
+  header.magic = session::kMagic;
+  header.version = session::kVersion;
+  WriteBytes(&header, sizeof(header));
+
+  is_stopping_.store(false, std::memory_order_relaxed);
+  thread_ = std::thread(&SessionRecorder::WriteLoop, this);
+  is_recording_.store(true, std::memory_order_release);
+  return true;
+}
+
+void SessionRecorder::Stop() {
+  if (!thread_.joinable()) {
+    return;
+  }
+  // Sequentially consistent with BeginRecord(): either the callback sees the
+  // flag cleared, or its count is seen here.
+  is_recording_.store(false);
+  // Wait for the callbacks filling a slot, they only copy a sample.
+  while (active_record_count_.load() > 0) {
+    std::this_thread::yield();
+  }
+  is_stopping_.store(true, std::memory_order_release);
+  thread_.join();
+
+  fclose(file_);
+  file_ = nullptr;
+  if (has_write_error_) {
+    LOGE("SessionRecorder: the session file is incomplete.");
+  }
+}
+
+bool SessionRecorder::RecordPose(const TangoPoseData& pose) {
+  if (!BeginRecord()) {
+    return false;
+  }
+  const int slot_index = AcquireSlot(kPoseStream);
+  if (slot_index >= 0) {
+    Slot& slot = slots_[slot_index];
+    slot.header.type = session::kPoseChunk;
+    slot.header.record_size = sizeof(session::PoseRecord);
+    slot.header.raw_data_size = 0;
+    slot.header.timestamp = pose.timestamp;
+
+    session::PoseRecord record;
+    std::copy(pose.orientation, pose.orientation + 4, record.orientation);
+    std::copy(pose.translation, pose.translation + 3, record.translation);
+    record.status_code = pose.status_code;
+    record.base_frame = pose.frame.base;
+    record.target_frame = pose.frame.target;
+    record.reserved = 0;
+    memcpy(slot.payload.data(), &record, sizeof(record));
+    ready_slots_->Push(slot_index);
+  }
+  EndRecord();
+  return slot_index >= 0;
+}
+
+bool SessionRecorder::RecordPointCloud(const TangoXYZij& cloud) {
+  if (!BeginRecord()) {
+    return false;
+  }
+  int slot_index = -1;
+  if (cloud.xyz_count > options_.max_point_count) {
+    dropped_count_.fetch_add(1, std::memory_order_relaxed);
+  } else {
+    slot_index = AcquireSlot(kPointCloudStream);
+  }
+  if (slot_index >= 0) {
+    Slot& slot = slots_[slot_index];
+    const size_t data_size = cloud.xyz_count * 3 * sizeof(float);
+    slot.header.type = session::kPointCloudChunk;
+    slot.header.record_size = sizeof(session::PointCloudRecord);
+    slot.header.raw_data_size = static_cast<uint32_t>(data_size);
+    slot.header.timestamp = cloud.timestamp;
+
+    session::PointCloudRecord record;
+    record.xyz_count = cloud.xyz_count;
+    record.reserved = 0;
+    memcpy(slot.payload.data(), &record, sizeof(record));
+    if (data_size > 0) {
+      memcpy(slot.payload.data() + sizeof(record), cloud.xyz, data_size);
+    }
+    ready_slots_->Push(slot_index);
+  }
+  EndRecord();
+  return slot_index >= 0;
+}
+
+bool SessionRecorder::RecordImage(TangoCameraId camera_id,
+                                  const TangoImageBuffer& image) {
+  if (!BeginRecord()) {
+    return false;
+  }
+  const size_t data_size =
+      session::GetImageDataSize(image.format, image.stride, image.height);
+  int slot_index = -1;
+  if (data_size > options_.max_image_data_size) {
+    dropped_count_.fetch_add(1, std::memory_order_relaxed);
+  } else {
+    slot_index = AcquireSlot(kImageStream);
+  }
+  if (slot_index >= 0) {
+    Slot& slot = slots_[slot_index];
+    slot.header.type = session::kImageChunk;
+    slot.header.record_size = sizeof(session::ImageRecord);
+    slot.header.raw_data_size = static_cast<uint32_t>(data_size);
+    slot.header.timestamp = image.timestamp;
+
+    session::ImageRecord record;
+    record.camera_id = camera_id;
+    record.format = image.format;
+    record.width = image.width;
+    record.height = image.height;
+    record.stride = image.stride;
+    record.reserved = 0;
+    record.frame_number = image.frame_number;
+    memcpy(slot.payload.data(), &record, sizeof(record));
+    memcpy(slot.payload.data() + sizeof(record), image.data, data_size);
+    ready_slots_->Push(slot_index);
+  }
+  EndRecord();
+  return slot_index >= 0;
+}
+
+int SessionRecorder::AcquireSlot(Stream stream) {
+  int slot_index;
+  if (!free_slots_[stream]->Pop(&slot_index)) {
+    dropped_count_.fetch_add(1, std::memory_order_relaxed);
+    return -1;
+  }
+  return slot_index;
+}
+
+bool SessionRecorder::BeginRecord() {
+  active_record_count_.fetch_add(1);
+  if (!is_recording_.load()) {
+    EndRecord();
+    return false;
+  }
+  return true;
+}
+
+void SessionRecorder::WriteLoop() {
+  while (true) {
+    int slot_index;
+    if (ready_slots_->Pop(&slot_index)) {
+      Slot& slot = slots_[slot_index];
+      WriteSlot(&slot);
+      free_slots_[slot.stream]->Push(slot_index);
+      continue;
+    }
+    // Stop() sets is_stopping_ once no callback can queue a slot anymore, the
+    // queue is empty for good if it is still empty after that.
+    if (is_stopping_.load(std::memory_order_acquire)) {
+      if (!ready_slots_->Pop(&slot_index)) {
+        FinishEncoding();
+        return;
+      }
+      Slot& slot = slots_[slot_index];
+      WriteSlot(&slot);
+      free_slots_[slot.stream]->Push(slot_index);
+      continue;
+    }
+    std::this_thread::sleep_for(kIdleInterval);
+  }
+}
+
+void SessionRecorder::WriteSlot(Slot* slot) {
+  session::ChunkHeader& header = slot->header;
+  const uint8_t* record = slot->payload.data();
+  const uint8_t* data = record + header.record_size;
+  header.flags = 0;
+  header.data_size = header.raw_data_size;
+  header.reserved = 0;
+  if (slot->stream == kImageStream &&
+      EncodeImage(header,
+                  *reinterpret_cast<const session::ImageRecord*>(record),
+                  data)) {
+    return;
+  }
+
+  const bool encode =
+      slot->stream == kPointCloudStream && options_.encode_depth;
+  const bool compress =
+      (slot->stream == kPointCloudStream && options_.compress_depth) ||
+      (slot->stream == kImageStream && options_.compress_images);
+  if (encode) {
+    const session::PointCloudRecord* point_cloud =
+        reinterpret_cast<const session::PointCloudRecord*>(record);
+    const size_t encoded_size = point_encoder_.Encode(
+        reinterpret_cast<const float*>(data), point_cloud->xyz_count,
+        options_.depth_step, compressed_data_.data(), compressed_data_.size());
+    if (encoded_size > 0) {
+      header.flags |= session::kPointCodecFlag;
+      header.data_size = static_cast<uint32_t>(encoded_size);
+      data = compressed_data_.data();
+    }
+  } else if (compress && header.raw_data_size > 0) {
+    const size_t compressed_size =
+        lz4::Compress(data, header.raw_data_size, compressed_data_.data(),
+                      compressed_data_.size());
+    // Incompressible data, e.g. noise, is stored as is.
+    if (compressed_size > 0 && compressed_size < header.raw_data_size) {
+      header.flags |= session::kCompressedFlag;
+      header.data_size = static_cast<uint32_t>(compressed_size);
+      data = compressed_data_.data();
+    }
+  }
+
+  WriteChunk(header, record, data);
+}
+
+bool SessionRecorder::EncodeImage(const session::ChunkHeader& header,
+                                  const session::ImageRecord& record,
+                                  const uint8_t* data) {
+  VideoEncoder* encoder = options_.color_encoder;
+  if (encoder == nullptr || has_encoder_failed_ ||
+      record.camera_id != TANGO_CAMERA_COLOR ||
+      record.format != TANGO_HAL_PIXEL_FORMAT_YCrCb_420_SP) {
+    return false;
+  }
+  if (is_encoding_ && (record.width != encoded_record_.width ||
+                       record.height != encoded_record_.height)) {
+    FinishEncoding();
+  }
+  if (!is_encoding_) {
+    if (!encoder->Start(record.width, record.height)) {
+      LOGE("SessionRecorder: the color encoder failed, storing images.");
+      has_encoder_failed_ = true;
+      return false;
+    }
+    is_encoding_ = true;
+    encoded_record_ = record;
+  }
+
+  // The timestamps of the packets map back to the frames, whose exact
+  // timestamps the chunks keep.
+  PendingFrame frame;
+  frame.presentation_time_us = llround(header.timestamp * 1e6);
+  frame.timestamp = header.timestamp;
+  frame.frame_number = record.frame_number;
+  if (pending_frames_.size() == kMaxPendingFrameCount) {
+    pending_frames_.pop_front();
+  }
+  pending_frames_.push_back(frame);
+  if (!encoder->Encode(data, record.stride, frame.presentation_time_us,
+                       packet_callback_)) {
+    auto dropped = std::find_if(
+        pending_frames_.begin(), pending_frames_.end(),
+        [&frame](const PendingFrame& pending) {
+          return pending.presentation_time_us == frame.presentation_time_us;
+        });
+    if (dropped != pending_frames_.end()) {
+      pending_frames_.erase(dropped);
+    }
+    dropped_count_.fetch_add(1, std::memory_order_relaxed);
+  }
+  return true;
+}
+
+void SessionRecorder::WritePacket(const VideoEncoder::Packet& packet) {
+  session::VideoRecord record;
+  record.camera_id = encoded_record_.camera_id;
+  record.codec = options_.color_encoder->GetCodec();
+  record.width = encoded_record_.width;
+  record.height = encoded_record_.height;
+  record.presentation_time_us = packet.presentation_time_us;
+
+  session::ChunkHeader header;
+  header.type = session::kVideoChunk;
+  header.flags = 0;
+  header.record_size = sizeof(record);
+  header.raw_data_size = static_cast<uint32_t>(packet.size);
+  header.data_size = header.raw_data_size;
+  header.reserved = 0;
+  if (packet.is_config) {
+    // Configuration comes before the first frame, it replays with it.
+    header.flags |= session::kVideoConfigFlag;
+    header.timestamp = pending_frames_.empty()
+                           ? 0.0
+                           : pending_frames_.front().timestamp;
+    record.frame_number = -1;
+  } else {
+    auto frame = std::find_if(
+        pending_frames_.begin(), pending_frames_.end(),
+        [&packet](const PendingFrame& pending) {
+          return pending.presentation_time_us == packet.presentation_time_us;
+        });
+    if (frame != pending_frames_.end()) {
+      header.timestamp = frame->timestamp;
+      record.frame_number = frame->frame_number;
+      pending_frames_.erase(frame);
+    } else {
+      header.timestamp = packet.presentation_time_us * 1e-6;
+      record.frame_number = -1;
+    }
+    if (packet.is_key_frame) {
+      header.flags |= session::kVideoKeyFrameFlag;
+    }
+  }
+  WriteChunk(header, &record, packet.data);
+}
+
+void SessionRecorder::FinishEncoding() {
+  if (!is_encoding_) {
+    return;
+  }
+  options_.color_encoder->Finish(packet_callback_);
+  is_encoding_ = false;
+  pending_frames_.clear();
+}
+
+void SessionRecorder::WriteChunk(const session::ChunkHeader& header,
+                                 const void* record, const void* data) {
+  static const uint8_t kPadding[session::kChunkAlignment] = {};
+  const size_t padding_size =
+      (session::kChunkAlignment - header.data_size % session::kChunkAlignment) %
+      session::kChunkAlignment;
+  if (WriteBytes(&header, sizeof(header)) &&
+      WriteBytes(record, header.record_size) &&
+      WriteBytes(data, header.data_size)) {
+    WriteBytes(kPadding, padding_size);
+  }
+}
+
+
+bool SessionRecorder::WriteBytes(const void* data, size_t size) {
+  if (has_write_error_) {
+    return false;
+  }
+  if (size > 0 && fwrite(data, 1, size, file_) != size) {
+    LOGE("SessionRecorder: write failed, recording stops here.");
+    has_write_error_ = true;
+    return false;
+  }
+  written_byte_count_.fetch_add(size, std::memory_order_relaxed);
+  return true;
+}
+
+}  // namespace tango_gl
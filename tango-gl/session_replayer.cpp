@@ -0,0 +1,517 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+
+#include "tango-gl/lz4.h"
+#include "tango-gl/point_cloud_codec.h"
+#include "tango-gl/pose_interpolation.h"
+#include "tango-gl/session_replayer.h"
+#include "tango-gl/util.h"
+
+namespace {
+// Poses GetPosesAtTimes() interpolates at once.
+const size_t kPoseBatchSize = 64;
+
+size_t GetExpectedRecordSize(uint32_t type) {
+  switch (type) {
+    case tango_gl::session::kPoseChunk:
+      return sizeof(tango_gl::session::PoseRecord);
+    case tango_gl::session::kPointCloudChunk:
+      return sizeof(tango_gl::session::PointCloudRecord);
+    case tango_gl::session::kImageChunk:
+      return sizeof(tango_gl::session::ImageRecord);
+    case tango_gl::session::kVideoChunk:
+      return sizeof(tango_gl::session::VideoRecord);
+    default:
+      return 0;
+  }
+}
+
+size_t AlignChunkSize(size_t size) {
+  const size_t alignment = tango_gl::session::kChunkAlignment;
+  return (size + alignment - 1) / alignment * alignment;
+}
+}  // namespace
+
+namespace tango_gl {
+
+SessionReplayer::SessionReplayer()
+    : mapping_(nullptr),
+      mapping_size_(0),
+      is_stopping_(false),
+      is_done_(false),
+      replay_timestamp_(0.0) {}
+
+SessionReplayer::~SessionReplayer() { Close(); }
+
+bool SessionReplayer::Open(const char* path) {
+  Close();
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    LOGE("SessionReplayer: could not open %s.", path);
+    return false;
+  }
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) != 0 ||
+      file_stat.st_size < static_cast<off_t>(sizeof(session::FileHeader))) {
+    close(fd);
+    LOGE("SessionReplayer: %s is not a session file.", path);
+    return false;
+  }
+  const size_t size = file_stat.st_size;
+  void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  // The mapping keeps the file referenced on its own.
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    LOGE("SessionReplayer: failed to map %s.", path);
+    return false;
+  }
+  mapping_ = mapping;
+  mapping_size_ = size;
+  if (!Index()) {
+    LOGE("SessionReplayer: %s is not a session file.", path);
+    Close();
+    return false;
+  }
+  return true;
+}
+
+void SessionReplayer::Close() {
+  Stop();
+  samples_.clear();
+  poses_.clear();
+  if (mapping_ != nullptr) {
+    munmap(mapping_, mapping_size_);
+    mapping_ = nullptr;
+    mapping_size_ = 0;
+  }
+}
+
+bool SessionReplayer::Index() {
+  const uint8_t* base = static_cast<const uint8_t*>(mapping_);
+  session::FileHeader file_header;
+  memcpy(&file_header, base, sizeof(file_header));
+  if (file_header.magic != session::kMagic ||
+      file_header.version == 0 || file_header.version > session::kVersion) {
+    return false;
+  }
+
+  size_t max_point_data_size = 0;
+  size_t max_image_data_size = 0;
+  size_t offset = sizeof(file_header);
+  while (mapping_size_ - offset >= sizeof(session::ChunkHeader)) {
+    const session::ChunkHeader* header =
+        reinterpret_cast<const session::ChunkHeader*>(base + offset);
+    const size_t chunk_size = AlignChunkSize(
+        sizeof(*header) + static_cast<size_t>(header->record_size) +
+        header->data_size);
+    if (chunk_size > mapping_size_ - offset) {
+      LOGE("SessionReplayer: ignoring a truncated chunk at the end.");
+      break;
+    }
+    offset += chunk_size;
+
+    // Skip chunk types this version does not know about.
+    const size_t record_size = GetExpectedRecordSize(header->type);
+    if (record_size == 0 || header->record_size < record_size) {
+      continue;
+    }
+    Sample sample;
+    sample.timestamp = header->timestamp;
+    sample.header = header;
+    samples_.push_back(sample);
+
+    if (header->type == session::kPoseChunk) {
+      const session::PoseRecord* record =
+          GetRecord<session::PoseRecord>(header);
+      if (record->status_code == TANGO_POSE_VALID) {
+        TangoCoordinateFramePair frame;
+        frame.base = static_cast<TangoCoordinateFrameType>(record->base_frame);
+        frame.target =
+            static_cast<TangoCoordinateFrameType>(record->target_frame);
+        poses_[GetFramePairKey(frame)].push_back(header);
+      }
+    } else if (header->type == session::kPointCloudChunk) {
+      max_point_data_size =
+          std::max<size_t>(max_point_data_size, header->raw_data_size);
+    } else if (header->type == session::kImageChunk) {
+      max_image_data_size =
+          std::max<size_t>(max_image_data_size, header->raw_data_size);
+    }
+  }
+
+  // Streams are written by independent callbacks, their chunks interleave
+  // slightly out of order.
+  std::stable_sort(samples_.begin(), samples_.end(),
+                   [](const Sample& a, const Sample& b) {
+                     return a.timestamp < b.timestamp;
+                   });
+  for (auto& entry : poses_) {
+    std::stable_sort(entry.second.begin(), entry.second.end(),
+                     [](const session::ChunkHeader* a,
+                        const session::ChunkHeader* b) {
+                       return a->timestamp < b->timestamp;
+                     });
+  }
+  point_buffer_.resize(max_point_data_size);
+  image_buffer_.resize(max_image_data_size);
+  return true;
+}
+
+void SessionReplayer::Run(const Callbacks& callbacks, double speed) {
+  is_done_.store(false, std::memory_order_release);
+  const auto start_time = std::chrono::steady_clock::now();
+  const double start_timestamp = GetStartTimestamp();
+  for (const Sample& sample : samples_) {
+    if (is_stopping_.load(std::memory_order_acquire)) {
+      break;
+    }
+    if (speed > 0.0) {
+      const std::chrono::duration<double> delay(
+          (sample.timestamp - start_timestamp) / speed);
+      std::this_thread::sleep_until(
+          start_time +
+          std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+              delay));
+    }
+    replay_timestamp_.store(sample.timestamp, std::memory_order_release);
+    Deliver(sample, callbacks);
+  }
+  is_done_.store(true, std::memory_order_release);
+}
+
+bool SessionReplayer::Start(const Callbacks& callbacks, double speed) {
+  if (mapping_ == nullptr || thread_.joinable()) {
+    return false;
+  }
+  is_stopping_.store(false, std::memory_order_release);
+  is_done_.store(false, std::memory_order_release);
+  thread_ = std::thread(&SessionReplayer::Run, this, callbacks, speed);
+  return true;
+}
+
+void SessionReplayer::Stop() {
+  if (!thread_.joinable()) {
+    return;
+  }
+  is_stopping_.store(true, std::memory_order_release);
+  thread_.join();
+  is_stopping_.store(false, std::memory_order_release);
+}
+
+void SessionReplayer::Deliver(const Sample& sample,
+                              const Callbacks& callbacks) {
+  const session::ChunkHeader* header = sample.header;
+  if (header->type == session::kPoseChunk) {
+    if (callbacks.on_pose_available != nullptr) {
+      const TangoPoseData pose = ToPose(header);
+      callbacks.on_pose_available(callbacks.context, &pose);
+    }
+  } else if (header->type == session::kPointCloudChunk) {
+    if (callbacks.on_xyz_ij_available == nullptr) {
+      return;
+    }
+    const session::PointCloudRecord* record =
+        GetRecord<session::PointCloudRecord>(header);
+    const uint8_t* data = GetData(header, &point_buffer_);
+    if (data == nullptr ||
+        header->raw_data_size < record->xyz_count * 3 * sizeof(float)) {
+      LOGE("SessionReplayer: skipping a malformed point cloud.");
+      return;
+    }
+    TangoXYZij xyz_ij;
+    memset(&xyz_ij, 0, sizeof(xyz_ij));
+    xyz_ij.timestamp = header->timestamp;
+    xyz_ij.xyz_count = record->xyz_count;
+    // Chunks are aligned, the data can be used as floats in place.
+    xyz_ij.xyz = reinterpret_cast<float(*)[3]>(const_cast<uint8_t*>(data));
+    callbacks.on_xyz_ij_available(callbacks.context, &xyz_ij);
+  } else if (header->type == session::kImageChunk) {
+    if (callbacks.on_frame_available == nullptr) {
+      return;
+    }
+    const session::ImageRecord* record =
+        GetRecord<session::ImageRecord>(header);
+    const TangoImageFormatType format =
+        static_cast<TangoImageFormatType>(record->format);
+    const uint8_t* data = GetData(header, &image_buffer_);
+    if (data == nullptr ||
+        header->raw_data_size < session::GetImageDataSize(
+                                    format, record->stride, record->height)) {
+      LOGE("SessionReplayer: skipping a malformed image.");
+      return;
+    }
+    TangoImageBuffer image;
+    memset(&image, 0, sizeof(image));
+    image.width = record->width;
+    image.height = record->height;
+    image.stride = record->stride;
+    image.timestamp = header->timestamp;
+    image.frame_number = record->frame_number;
+    image.format = format;
+    image.data = const_cast<uint8_t*>(data);
+    callbacks.on_frame_available(
+        callbacks.context, static_cast<TangoCameraId>(record->camera_id),
+        &image);
+  } else if (header->type == session::kVideoChunk) {
+    if (callbacks.on_video_packet_available == nullptr) {
+      return;
+    }
+    const session::VideoRecord* record =
+        GetRecord<session::VideoRecord>(header);
+    // Packets are stored as is, never compressed.
+    const uint8_t* data =
+        reinterpret_cast<const uint8_t*>(header + 1) + header->record_size;
+    if (header->data_size != header->raw_data_size) {
+      LOGE("SessionReplayer: skipping a malformed video packet.");
+      return;
+    }
+    VideoPacket packet;
+    packet.camera_id = static_cast<TangoCameraId>(record->camera_id);
+    packet.codec = static_cast<session::VideoCodec>(record->codec);
+    packet.width = record->width;
+    packet.height = record->height;
+    packet.timestamp = header->timestamp;
+    packet.frame_number = record->frame_number;
+    packet.presentation_time_us = record->presentation_time_us;
+    packet.is_config = (header->flags & session::kVideoConfigFlag) != 0;
+    packet.is_key_frame = (header->flags & session::kVideoKeyFrameFlag) != 0;
+    packet.data = data;
+    packet.size = header->data_size;
+    callbacks.on_video_packet_available(callbacks.context, &packet);
+  }
+}
+
+const uint8_t* SessionReplayer::GetData(const session::ChunkHeader* header,
+                                        std::vector<uint8_t>* buffer) const {
+  const uint8_t* data =
+      reinterpret_cast<const uint8_t*>(header + 1) + header->record_size;
+  if ((header->flags & session::kPointCodecFlag) != 0) {
+    const size_t point_count = header->raw_data_size / (3 * sizeof(float));
+    point_cloud_codec::Header codec_header;
+    if (!point_cloud_codec::ReadHeader(data, header->data_size,
+                                       &codec_header) ||
+        codec_header.point_count != point_count ||
+        !point_cloud_codec::Decode(data, header->data_size,
+                                   reinterpret_cast<float*>(buffer->data()),
+                                   point_count)) {
+      return nullptr;
+    }
+    return buffer->data();
+  }
+  if ((header->flags & session::kCompressedFlag) == 0) {
+    return header->data_size == header->raw_data_size ? data : nullptr;
+  }
+  if (!lz4::Decompress(data, header->data_size, buffer->data(),
+                       header->raw_data_size)) {
+    return nullptr;
+  }
+  return buffer->data();
+}
+
+RigidTransform SessionReplayer::ToTransform(
+    const session::ChunkHeader* header) {
+  const session::PoseRecord* record = GetRecord<session::PoseRecord>(header);
+  // Tango quaternions are x, y, z, w.
+  return RigidTransform(
+      glm::quat(static_cast<float>(record->orientation[3]),
+                static_cast<float>(record->orientation[0]),
+                static_cast<float>(record->orientation[1]),
+                static_cast<float>(record->orientation[2])),
+      glm::vec3(static_cast<float>(record->translation[0]),
+                static_cast<float>(record->translation[1]),
+                static_cast<float>(record->translation[2])));
+}
+
+TangoPoseData SessionReplayer::ToPose(const session::ChunkHeader* header) {
+  const session::PoseRecord* record = GetRecord<session::PoseRecord>(header);
+  TangoPoseData pose;
+  memset(&pose, 0, sizeof(pose));
+  pose.timestamp = header->timestamp;
+  std::copy(record->orientation, record->orientation + 4, pose.orientation);
+  std::copy(record->translation, record->translation + 3, pose.translation);
+  pose.status_code = static_cast<TangoPoseStatusType>(record->status_code);
+  pose.frame.base = static_cast<TangoCoordinateFrameType>(record->base_frame);
+  pose.frame.target =
+      static_cast<TangoCoordinateFrameType>(record->target_frame);
+  return pose;
+}
+
+bool SessionReplayer::GetPoseAtTime(double timestamp,
+                                    const TangoCoordinateFramePair& frame,
+                                    TangoPoseData* pose) const {
+  memset(pose, 0, sizeof(*pose));
+  pose->frame = frame;
+  pose->status_code = TANGO_POSE_INVALID;
+
+  auto entry = poses_.find(GetFramePairKey(frame));
+  if (entry == poses_.end() || entry->second.empty()) {
+    return false;
+  }
+  const std::vector<const session::ChunkHeader*>& history = entry->second;
+  if (timestamp == 0.0) {
+    // Latest pose delivered so far, or the first one before the replay.
+    const double replay_timestamp =
+        replay_timestamp_.load(std::memory_order_acquire);
+    auto latest = std::upper_bound(
+        history.begin(), history.end(), replay_timestamp,
+        [](double t, const session::ChunkHeader* header) {
+          return t < header->timestamp;
+        });
+    *pose = ToPose(latest == history.begin() ? history.front()
+                                             : *(latest - 1));
+    return true;
+  }
+
+  auto after = std::lower_bound(
+      history.begin(), history.end(), timestamp,
+      [](const session::ChunkHeader* header, double t) {
+        return header->timestamp < t;
+      });
+  if (after == history.end()) {
+    return false;
+  }
+  if ((*after)->timestamp == timestamp) {
+    *pose = ToPose(*after);
+    return true;
+  }
+  if (after == history.begin()) {
+    return false;
+  }
+
+  const TangoPoseData before_pose = ToPose(*(after - 1));
+  const TangoPoseData after_pose = ToPose(*after);
+  const double t = (timestamp - before_pose.timestamp) /
+                   (after_pose.timestamp - before_pose.timestamp);
+  // Tango quaternions are x, y, z, w.
+  const glm::dquat before_rotation(
+      before_pose.orientation[3], before_pose.orientation[0],
+      before_pose.orientation[1], before_pose.orientation[2]);
+  const glm::dquat after_rotation(
+      after_pose.orientation[3], after_pose.orientation[0],
+      after_pose.orientation[1], after_pose.orientation[2]);
+  const glm::dquat rotation = glm::slerp(before_rotation, after_rotation, t);
+
+  *pose = before_pose;
+  pose->timestamp = timestamp;
+  pose->orientation[0] = rotation.x;
+  pose->orientation[1] = rotation.y;
+  pose->orientation[2] = rotation.z;
+  pose->orientation[3] = rotation.w;
+  for (int i = 0; i < 3; ++i) {
+    pose->translation[i] = before_pose.translation[i] +
+                           (after_pose.translation[i] -
+                            before_pose.translation[i]) * t;
+  }
+  return true;
+}
+
+size_t SessionReplayer::GetPosesAtTimes(const double* timestamps, size_t count,
+                                        const TangoCoordinateFramePair& frame,
+                                        RigidTransform* poses,
+                                        uint8_t* is_valid) const {
+  memset(is_valid, 0, count);
+  auto entry = poses_.find(GetFramePairKey(frame));
+  if (count == 0 || entry == poses_.end() || entry->second.empty()) {
+    return 0;
+  }
+  const std::vector<const session::ChunkHeader*>& history = entry->second;
+
+  // Pairs to interpolate are gathered in batches, then written out to the
+  // indices they were asked for.
+  RigidTransform before[kPoseBatchSize];
+  RigidTransform after[kPoseBatchSize];
+  float weights[kPoseBatchSize];
+  size_t indices[kPoseBatchSize];
+  size_t batch_count = 0;
+  size_t resolved_count = 0;
+  auto flush = [&]() {
+    pose_interpolation::Interpolate(before, after, weights, batch_count,
+                                    before);
+    for (size_t k = 0; k < batch_count; ++k) {
+      poses[indices[k]] = before[k];
+      is_valid[indices[k]] = 1;
+    }
+    resolved_count += batch_count;
+    batch_count = 0;
+  };
+
+  // Index of the first recorded pose at or after the timestamp, and the
+  // transforms of the last pair converted, reused by the timestamps falling
+  // between the same two poses.
+  size_t next = 0;
+  size_t converted_first = history.size();
+  size_t converted_next = history.size();
+  RigidTransform converted_before;
+  RigidTransform converted_after;
+  double previous_timestamp = timestamps[0];
+  for (size_t i = 0; i < count; ++i) {
+    const double timestamp = timestamps[i];
+    if (timestamp < previous_timestamp) {
+      // Out of order, search again from the start.
+      next = 0;
+    }
+    previous_timestamp = timestamp;
+    while (next < history.size() && history[next]->timestamp < timestamp) {
+      ++next;
+    }
+    if (next == history.size() ||
+        (next == 0 && history[0]->timestamp != timestamp)) {
+      continue;
+    }
+    const size_t first = history[next]->timestamp == timestamp ? next
+                                                                : next - 1;
+    if (first != converted_first || next != converted_next) {
+      converted_before = ToTransform(history[first]);
+      converted_after = first == next ? converted_before
+                                      : ToTransform(history[next]);
+      converted_first = first;
+      converted_next = next;
+    }
+    const double before_timestamp = history[first]->timestamp;
+    const double interval = history[next]->timestamp - before_timestamp;
+    before[batch_count] = converted_before;
+    after[batch_count] = converted_after;
+    weights[batch_count] = interval > 0.0
+        ? static_cast<float>((timestamp - before_timestamp) / interval)
+        : 0.0f;
+    indices[batch_count] = i;
+    if (++batch_count == kPoseBatchSize) {
+      flush();
+    }
+  }
+  flush();
+  return resolved_count;
+}
+
+double SessionReplayer::GetStartTimestamp() const {
+  return samples_.empty() ? 0.0 : samples_.front().timestamp;
+}
+
+double SessionReplayer::GetEndTimestamp() const {
+  return samples_.empty() ? 0.0 : samples_.back().timestamp;
+}
+
+}  // namespace tango_gl
@@ -0,0 +1,242 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+
+#include "tango-gl/shader_variants.h"
+
+#include <EGL/egl.h>
+
+#include <unordered_map>
+
+#include "tango-gl/frame_constants.h"
+#include "tango-gl/program_cache.h"
+
+namespace {
+struct FeatureDefine {
+  uint32_t feature;
+  const char* define;
+};
+
+const FeatureDefine kFeatureDefines[] = {
+    {tango_gl::shader_variants::kLighting, "#define LIGHTING\n"},
+    {tango_gl::shader_variants::kVertexColor, "#define VERTEX_COLOR\n"},
+    {tango_gl::shader_variants::kPointSize, "#define POINT_SIZE\n"},
+    {tango_gl::shader_variants::kPointSprite, "#define POINT_SPRITE\n"},
+    {tango_gl::shader_variants::kQuantizedPositions,
+     "#define QUANTIZED_POSITIONS\n"},
+    {tango_gl::shader_variants::kInstanced, "#define INSTANCED\n"},
+    {tango_gl::shader_variants::kFrameConstants, "#define FRAME_CONSTANTS\n"},
+};
+
+// Maps the GLSL ES 1.00 keywords of the templates to GLSL ES 3.00, for
+// kFrameConstants variants. #version has to come first.
+const char kVertexVersion3[] =
+    "#version 300 es\n"
+    "#define attribute in\n"
+    "#define varying out\n";
+const char kFragmentVersion3[] =
+    "#version 300 es\n"
+    "#define varying in\n"
+    "#define FRAG_COLOR frag_color\n"
+    "precision mediump float;\n"
+    "out vec4 frag_color;\n";
+
+// In the order of shader_variants::Uniform and Attribute.
+const char* const kUniformNames[tango_gl::shader_variants::kUniformCount] = {
+    "mvp", "model", "vp", "mv", "view", "color", "lightVec", "point_size",
+    "point_scale", "max_point_size", "vertex_scale", "ambient"};
+
+const char* const kAttributeNames[tango_gl::shader_variants::kAttributeCount] =
+    {"vertex", "color", "normal", "model", "instanceColor"};
+
+const char kVertexTemplate[] =
+    "precision highp float;\n"
+    "precision mediump int;\n"
+    "attribute vec4 vertex;\n"
+    "#ifdef FRAME_CONSTANTS\n"
+    "layout(std140) uniform FrameConstants {\n"
+    "  mat4 projection;\n"
+    "  mat4 view;\n"
+    "  mat4 vp;\n"
+    "};\n"
+    "#endif\n"
+    "#ifdef INSTANCED\n"
+    "attribute mat4 model;\n"
+    "#ifndef FRAME_CONSTANTS\n"
+    "uniform mat4 vp;\n"
+    "#endif\n"
+    "#elif defined(FRAME_CONSTANTS)\n"
+    "uniform mat4 model;\n"
+    "#else\n"
+    "uniform mat4 mvp;\n"
+    "#endif\n"
+    "#if defined(VERTEX_COLOR)\n"
+    "attribute vec4 color;\n"
+    "#elif defined(INSTANCED)\n"
+    "attribute vec4 instanceColor;\n"
+    "#else\n"
+    "uniform vec4 color;\n"
+    "#endif\n"
+    "#ifdef LIGHTING\n"
+    "attribute vec3 normal;\n"
+    "uniform vec3 lightVec;\n"
+    "uniform vec4 ambient;\n"
+    "#if defined(INSTANCED) && !defined(FRAME_CONSTANTS)\n"
+    "uniform mat4 view;\n"
+    "#elif !defined(INSTANCED) && !defined(FRAME_CONSTANTS)\n"
+    "uniform mat4 mv;\n"
+    "#endif\n"
+    "#endif\n"
+    "#ifdef QUANTIZED_POSITIONS\n"
+    "uniform float vertex_scale;\n"
+    "#endif\n"
+    "#ifdef POINT_SIZE\n"
+    "uniform float point_size;\n"
+    "#endif\n"
+    "#ifdef POINT_SPRITE\n"
+    "uniform float point_scale;\n"
+    "uniform float max_point_size;\n"
+    "#endif\n"
+    "varying vec4 v_color;\n"
+    "void main() {\n"
+    "#if defined(QUANTIZED_POSITIONS)\n"
+    "  vec4 position = vec4(vertex.xyz * vertex_scale, 1.0);\n"
+    "#elif defined(POINT_SPRITE)\n"
+    "  vec4 position = vec4(vertex.xyz, 1.0);\n"
+    "#else\n"
+    "  vec4 position = vertex;\n"
+    "#endif\n"
+    "#if defined(INSTANCED) || defined(FRAME_CONSTANTS)\n"
+    "  gl_Position = vp*model*position;\n"
+    "#else\n"
+    "  gl_Position = mvp*position;\n"
+    "#endif\n"
+    "#if defined(INSTANCED) && !defined(VERTEX_COLOR)\n"
+    "  vec4 base_color = instanceColor;\n"
+    "#else\n"
+    "  vec4 base_color = color;\n"
+    "#endif\n"
+    "#ifdef LIGHTING\n"
+    "#if defined(INSTANCED) || defined(FRAME_CONSTANTS)\n"
+    "  vec3 mv_normal = vec3(view * model * vec4(normal, 0.0));\n"
+    "#else\n"
+    "  vec3 mv_normal = vec3(mv * vec4(normal, 0.0));\n"
+    "#endif\n"
+    "  float diffuse = max(-dot(mv_normal, lightVec), 0.0);\n"
+    "  v_color = vec4(base_color.rgb * ambient.rgb * (diffuse + ambient.a),\n"
+    "                 base_color.a);\n"
+    "#else\n"
+    "  v_color = base_color;\n"
+    "#endif\n"
+    "#if defined(POINT_SIZE)\n"
+    "  gl_PointSize = point_size;\n"
+    "#elif defined(POINT_SPRITE)\n"
+    "  gl_PointSize = clamp(point_scale*vertex.w/gl_Position.w, 1.0,\n"
+    "                       max_point_size);\n"
+    "#endif\n"
+    "}\n";
+
+const char kFragmentTemplate[] =
+    "#ifndef FRAG_COLOR\n"
+    "#define FRAG_COLOR gl_FragColor\n"
+    "#endif\n"
+    "precision mediump float;\n"
+    "varying vec4 v_color;\n"
+    "void main() {\n"
+    "  FRAG_COLOR = v_color;\n"
+    "}\n";
+
+struct CachedVariant {
+  std::string vertex_source;
+  std::string fragment_source;
+  tango_gl::shader_variants::Variant variant;
+};
+
+// Variants of g_context, only touched on the GL thread. Nodes are stable, so
+// the returned pointers stay valid until the context changes.
+EGLContext g_context = EGL_NO_CONTEXT;
+std::unordered_map<uint32_t, CachedVariant> g_variants;
+}  // namespace
+
+namespace tango_gl {
+namespace shader_variants {
+
+std::string GetVertexShader(uint32_t features) {
+  std::string source =
+      (features & kFrameConstants) != 0 ? kVertexVersion3 : "";
+  for (const FeatureDefine& define : kFeatureDefines) {
+    if ((features & define.feature) != 0) {
+      source += define.define;
+    }
+  }
+  return source + kVertexTemplate;
+}
+
+std::string GetFragmentShader(uint32_t features) {
+  return std::string((features & kFrameConstants) != 0 ? kFragmentVersion3
+                                                        : "") +
+         kFragmentTemplate;
+}
+
+const Variant* Acquire(uint32_t features) {
+  EGLContext context = eglGetCurrentContext();
+  if (context != g_context) {
+    g_context = context;
+    g_variants.clear();
+  }
+
+  features &= kFeatureMask;
+  if ((features & kFrameConstants) != 0 &&
+      !FrameConstants::HasUniformBuffers()) {
+    features &= ~kFrameConstants;
+  }
+  auto found = g_variants.find(features);
+  if (found == g_variants.end()) {
+    CachedVariant cached;
+    cached.vertex_source = GetVertexShader(features);
+    cached.fragment_source = GetFragmentShader(features);
+    cached.variant.features = features;
+    cached.variant.program = 0;
+    found = g_variants.insert(std::make_pair(features, cached)).first;
+  }
+  CachedVariant& cached = found->second;
+  const GLuint program = program_cache::AcquireProgram(
+      cached.vertex_source.c_str(), cached.fragment_source.c_str());
+  if (program == 0) {
+    return nullptr;
+  }
+  // A program released by all its users is relinked, possibly under a new
+  // name.
+  if (program != cached.variant.program) {
+    cached.variant.program = program;
+    if ((features & kFrameConstants) != 0) {
+      FrameConstants::BindBlock(program);
+    }
+    for (int i = 0; i < kUniformCount; ++i) {
+      cached.variant.uniforms[i] =
+          glGetUniformLocation(program, kUniformNames[i]);
+    }
+    for (int i = 0; i < kAttributeCount; ++i) {
+      cached.variant.attributes[i] =
+          glGetAttribLocation(program, kAttributeNames[i]);
+    }
+  }
+  return &cached.variant;
+}
+
+}  // namespace shader_variants
+}  // namespace tango_gl
@@ -15,80 +15,507 @@
  */
 #include "tango-gl/shaders.h"
 
+namespace {
+// Header of the occlusion fragment shaders, up to the depth decoding.
+const char kOcclusionFragmentHeader[] =
+    "#extension GL_EXT_frag_depth : require\n"
+    "#ifdef GL_FRAGMENT_PRECISION_HIGH\n"
+    "precision highp float;\n"
+    "#else\n"
+    "precision mediump float;\n"
+    "#endif\n"
+    "uniform sampler2D depth_image;\n"
+    "uniform vec2 depth_transform;\n"
+    "varying vec2 f_textureCoords;\n"
+    "float DecodeDepth(vec4 texel) {\n"
+    "  return dot(floor(texel.ba * 255.0 + 0.5), vec2(256.0, 1.0)) * 0.001;\n"
+    "}\n";
+
+// Body of the downsample fragment shaders, after the image sampler.
+const char kDownsampleFragmentBody[] =
+    "uniform vec2 offset;\n"
+    "varying vec2 f_textureCoords;\n"
+    "void main() {\n"
+    "  gl_FragColor = 0.25 * (\n"
+    "      texture2D(image, f_textureCoords - offset) +\n"
+    "      texture2D(image, f_textureCoords + vec2(offset.x, -offset.y)) +\n"
+    "      texture2D(image, f_textureCoords + vec2(-offset.x, offset.y)) +\n"
+    "      texture2D(image, f_textureCoords + offset));\n"
+    "}\n";
+}  // namespace
+
 namespace tango_gl {
 namespace shaders {
-std::string GetBasicVertexShader() {
-  return "precision mediump float;\n"
-         "precision mediump int;\n"
+std::string GetVideoOverlayVertexShader() {
+  return "precision highp float;\n"
+         "precision highp int;\n"
          "attribute vec4 vertex;\n"
+         "attribute vec2 textureCoords;\n"
+         "varying vec2 f_textureCoords;\n"
          "uniform mat4 mvp;\n"
-         "uniform vec4 color;\n"
-         "varying vec4 v_color;\n"
          "void main() {\n"
-         "  gl_Position = mvp*vertex;\n"
-         "  v_color = color;\n"
+         "  f_textureCoords = textureCoords;\n"
+         "  gl_Position = mvp * vertex;\n"
+         "}\n";
+}
+
+std::string GetVideoOverlayFragmentShader() {
+  return "#extension GL_OES_EGL_image_external : require\n"
+         "precision highp float;\n"
+         "precision highp int;\n"
+         "uniform samplerExternalOES texture;\n"
+         "varying vec2 f_textureCoords;\n"
+         "void main() {\n"
+         "  gl_FragColor = texture2D(texture, f_textureCoords);\n"
          "}\n";
 }
 
-std::string GetBasicFragmentShader() {
+std::string GetTextVertexShader() {
   return "precision mediump float;\n"
-         "varying vec4 v_color;\n"
+         "attribute vec2 vertex;\n"
+         "attribute vec2 textureCoords;\n"
+         "uniform vec2 pixel_to_ndc;\n"
+         "varying vec2 f_textureCoords;\n"
          "void main() {\n"
-         "  gl_FragColor = v_color;\n"
+         "  gl_Position = vec4(vertex * pixel_to_ndc + vec2(-1.0, 1.0),\n"
+         "                     0.0, 1.0);\n"
+         "  f_textureCoords = textureCoords;\n"
          "}\n";
 }
 
-std::string GetColorVertexShader() {
+std::string GetTextFragmentShader() {
   return "precision mediump float;\n"
-         "precision mediump int;\n"
-         "attribute vec4 vertex;\n"
-         "attribute vec4 color;\n"
-         "uniform mat4 mvp;\n"
-         "varying vec4 v_color;\n"
+         "uniform sampler2D glyphs;\n"
+         "uniform vec4 color;\n"
+         "varying vec2 f_textureCoords;\n"
          "void main() {\n"
-         "  gl_Position = mvp*vertex;\n"
-         "  v_color = color;\n"
+         "  float coverage = texture2D(glyphs, f_textureCoords).a;\n"
+         "  gl_FragColor = vec4(color.rgb, color.a * coverage);\n"
          "}\n";
 }
 
-std::string GetVideoOverlayVertexShader() {
+std::string GetSpriteVertexShader() {
   return "precision highp float;\n"
-         "precision highp int;\n"
-         "attribute vec4 vertex;\n"
+         "attribute vec3 vertex;\n"
          "attribute vec2 textureCoords;\n"
+         "attribute vec4 color;\n"
+         "uniform mat4 vp;\n"
          "varying vec2 f_textureCoords;\n"
-         "uniform mat4 mvp;\n"
+         "varying vec4 f_color;\n"
          "void main() {\n"
+         "  gl_Position = vp * vec4(vertex, 1.0);\n"
          "  f_textureCoords = textureCoords;\n"
-         "  gl_Position = mvp * vertex;\n"
+         "  f_color = color;\n"
          "}\n";
 }
 
-std::string GetVideoOverlayFragmentShader() {
+std::string GetSpriteFragmentShader() {
+  return "precision mediump float;\n"
+         "uniform sampler2D atlas;\n"
+         "varying vec2 f_textureCoords;\n"
+         "varying vec4 f_color;\n"
+         "void main() {\n"
+         "  gl_FragColor = texture2D(atlas, f_textureCoords) * f_color;\n"
+         "}\n";
+}
+
+std::string GetRangeImageMeshVertexShader() {
+  return "precision highp float;\n"
+         "attribute vec2 ray;\n"
+         "attribute float depth;\n"
+         "uniform mat4 mvp;\n"
+         "uniform vec4 color;\n"
+         "uniform vec4 plane;\n"
+         "varying vec4 f_color;\n"
+         "varying float f_kept;\n"
+         "varying float f_shade;\n"
+         "varying float f_plane_offset;\n"
+         "void main() {\n"
+         "  float z = abs(depth);\n"
+         "  vec4 position = vec4(ray * z, z, 1.0);\n"
+         "  gl_Position = mvp * position;\n"
+         "  f_kept = depth > 0.0 ? 1.0 : 0.0;\n"
+         "  f_shade = 1.0 - 0.5 * clamp(z * 0.125, 0.0, 1.0);\n"
+         "  f_color = vec4(color.rgb * f_shade, color.a);\n"
+         "  f_plane_offset = dot(plane, position);\n"
+         "}\n";
+}
+
+std::string GetRangeImageMeshFragmentShader() {
+  return "precision mediump float;\n"
+         "uniform float plane_distance;\n"
+         "varying vec4 f_color;\n"
+         "varying float f_kept;\n"
+         "varying float f_shade;\n"
+         "varying float f_plane_offset;\n"
+         "void main() {\n"
+         "  if (f_kept < 0.999) {\n"
+         "    discard;\n"
+         "  }\n"
+         "  if (plane_distance > 0.0) {\n"
+         "    vec3 side = abs(f_plane_offset) < plane_distance\n"
+         "                    ? vec3(0.0, 1.0, 0.0)\n"
+         "                    : f_plane_offset < 0.0 ? vec3(1.0, 0.0, 0.0)\n"
+         "                                           : vec3(0.0, 0.0, 1.0);\n"
+         "    gl_FragColor = vec4(side * f_shade, 1.0);\n"
+         "  } else {\n"
+         "    gl_FragColor = f_color;\n"
+         "  }\n"
+         "}\n";
+}
+
+std::string GetCompositeVertexShader() {
+  return "precision mediump float;\n"
+         "attribute vec2 vertex;\n"
+         "varying vec2 f_textureCoords;\n"
+         "void main() {\n"
+         "  gl_Position = vec4(vertex, 0.0, 1.0);\n"
+         "  f_textureCoords = vertex * 0.5 + 0.5;\n"
+         "}\n";
+}
+
+std::string GetCompositeFragmentShader() {
+  return "precision mediump float;\n"
+         "uniform sampler2D image;\n"
+         "varying vec2 f_textureCoords;\n"
+         "void main() {\n"
+         "  gl_FragColor = texture2D(image, f_textureCoords);\n"
+         "}\n";
+}
+
+std::string GetReprojectionVertexShader() {
+  return "precision highp float;\n"
+         "attribute vec2 vertex;\n"
+         "uniform mat3 reprojection;\n"
+         "varying vec3 f_coords;\n"
+         "void main() {\n"
+         "  gl_Position = vec4(vertex, 0.0, 1.0);\n"
+         "  f_coords = reprojection * vec3(vertex, 1.0);\n"
+         "}\n";
+}
+
+std::string GetReprojectionFragmentShader() {
+  return "precision mediump float;\n"
+         "uniform sampler2D image;\n"
+         "varying vec3 f_coords;\n"
+         "void main() {\n"
+         "  vec2 ndc = f_coords.xy / f_coords.z;\n"
+         "  if (f_coords.z <= 0.0 || abs(ndc.x) > 1.0 || abs(ndc.y) > 1.0) {\n"
+         "    gl_FragColor = vec4(0.0);\n"
+         "  } else {\n"
+         "    gl_FragColor = texture2D(image, ndc * 0.5 + 0.5);\n"
+         "  }\n"
+         "}\n";
+}
+
+std::string GetDownsampleFragmentShader() {
+  return std::string(
+             "precision mediump float;\n"
+             "uniform sampler2D image;\n") +
+         kDownsampleFragmentBody;
+}
+
+std::string GetExternalDownsampleFragmentShader() {
+  return std::string(
+             "#extension GL_OES_EGL_image_external : require\n"
+             "precision mediump float;\n"
+             "uniform samplerExternalOES image;\n") +
+         kDownsampleFragmentBody;
+}
+
+std::string GetExternalGrayDownsampleFragmentShader() {
   return "#extension GL_OES_EGL_image_external : require\n"
-         "precision highp float;\n"
-         "precision highp int;\n"
-         "uniform samplerExternalOES texture;\n"
+         "precision mediump float;\n"
+         "uniform samplerExternalOES image;\n"
+         "uniform vec2 offset;\n"
+         "uniform float pixel_width;\n"
          "varying vec2 f_textureCoords;\n"
+         "float Gray(vec2 center) {\n"
+         "  vec4 color = 0.25 * (\n"
+         "      texture2D(image, center - offset) +\n"
+         "      texture2D(image, center + vec2(offset.x, -offset.y)) +\n"
+         "      texture2D(image, center + vec2(-offset.x, offset.y)) +\n"
+         "      texture2D(image, center + offset));\n"
+         "  return dot(color.rgb, vec3(0.299, 0.587, 0.114));\n"
+         "}\n"
          "void main() {\n"
-         "  gl_FragColor = texture2D(texture, f_textureCoords);\n"
+         "  vec2 first = f_textureCoords - vec2(1.5 * pixel_width, 0.0);\n"
+         "  gl_FragColor = vec4(\n"
+         "      Gray(first), Gray(first + vec2(pixel_width, 0.0)),\n"
+         "      Gray(first + vec2(2.0 * pixel_width, 0.0)),\n"
+         "      Gray(first + vec2(3.0 * pixel_width, 0.0)));\n"
+         "}\n";
+}
+
+std::string GetCoverageSplatFragmentShader() {
+  return "precision mediump float;\n"
+         "uniform vec4 weight;\n"
+         "void main() {\n"
+         "  gl_FragColor = weight;\n"
+         "}\n";
+}
+
+std::string GetCoverageVertexShader() {
+  return "precision highp float;\n"
+         "attribute vec2 vertex;\n"
+         "uniform mat4 mvp;\n"
+         "uniform float height;\n"
+         "uniform float inverse_extent;\n"
+         "varying vec2 f_textureCoords;\n"
+         "void main() {\n"
+         "  gl_Position = mvp * vec4(vertex.x, height, vertex.y, 1.0);\n"
+         "  f_textureCoords = vertex * inverse_extent + 0.5;\n"
+         "}\n";
+}
+
+std::string GetCoverageFragmentShader() {
+  return "precision mediump float;\n"
+         "uniform sampler2D coverage;\n"
+         "uniform vec4 low_color;\n"
+         "uniform vec4 high_color;\n"
+         "varying vec2 f_textureCoords;\n"
+         "void main() {\n"
+         "  float value = texture2D(coverage, f_textureCoords).r;\n"
+         "  if (value <= 0.0) {\n"
+         "    discard;\n"
+         "  }\n"
+         "  gl_FragColor = mix(low_color, high_color, value);\n"
+         "}\n";
+}
+
+std::string GetMinimapVertexShader() {
+  return "precision highp float;\n"
+         "attribute vec2 vertex;\n"
+         "uniform vec4 transform;\n"
+         "void main() {\n"
+         "  vec2 position = vertex * transform.xy + transform.zw;\n"
+         "  gl_Position = vec4(position, 0.0, 1.0);\n"
+         "}\n";
+}
+
+std::string GetMinimapFragmentShader() {
+  return "precision mediump float;\n"
+         "uniform vec4 color;\n"
+         "void main() {\n"
+         "  gl_FragColor = color;\n"
+         "}\n";
+}
+
+std::string GetMinimapCompositeVertexShader() {
+  return "precision highp float;\n"
+         "attribute vec2 vertex;\n"
+         "uniform vec4 transform;\n"
+         "varying vec2 f_textureCoords;\n"
+         "void main() {\n"
+         "  gl_Position = vec4(vertex, 0.0, 1.0);\n"
+         "  f_textureCoords = vertex * transform.xy + transform.zw;\n"
+         "}\n";
+}
+
+std::string GetGridVertexShader() {
+  return "precision highp float;\n"
+         "attribute vec4 vertex;\n"
+         "uniform mat4 mvp;\n"
+         "uniform vec3 camera;\n"
+         "uniform vec2 origin;\n"
+         "uniform float density;\n"
+         "uniform float fade_distance;\n"
+         "varying vec2 f_cell;\n"
+         "varying vec3 f_offset;\n"
+         "void main() {\n"
+         "  vec3 position = vec3(camera.x + vertex.x * fade_distance, 0.0,\n"
+         "                       camera.z + vertex.z * fade_distance);\n"
+         "  gl_Position = mvp * vec4(position, 1.0);\n"
+         "  f_cell = (position.xz - origin) / density;\n"
+         "  f_offset = position - camera;\n"
+         "}\n";
+}
+
+std::string GetGridFragmentShader() {
+  return "#extension GL_OES_standard_derivatives : enable\n"
+         "#ifdef GL_FRAGMENT_PRECISION_HIGH\n"
+         "precision highp float;\n"
+         "#else\n"
+         "precision mediump float;\n"
+         "#endif\n"
+         "uniform vec4 color;\n"
+         "uniform float fade_distance;\n"
+         "uniform float line_width;\n"
+         "varying vec2 f_cell;\n"
+         "varying vec3 f_offset;\n"
+         "void main() {\n"
+         "  vec2 cells_per_pixel = fwidth(f_cell);\n"
+         "  vec2 pixels = abs(fract(f_cell - 0.5) - 0.5) / cells_per_pixel;\n"
+         "  float coverage = 1.0 - clamp(min(pixels.x, pixels.y) -\n"
+         "                               0.5 * line_width + 0.5, 0.0, 1.0);\n"
+         "  coverage *= 1.0 - smoothstep(0.5 * fade_distance, fade_distance,\n"
+         "                               length(f_offset));\n"
+         "  coverage *= 1.0 - smoothstep(0.25, 0.5,\n"
+         "                               max(cells_per_pixel.x,\n"
+         "                                   cells_per_pixel.y));\n"
+         "  gl_FragColor = vec4(color.rgb, color.a * coverage);\n"
          "}\n";
 }
 
-std::string GetShadedVertexShader() {
-  return "attribute vec4 vertex;\n"
-         "attribute vec3 normal;\n"
+std::string GetRibbonVertexShader() {
+  return "#version 300 es\n"
+         "precision highp float;\n"
+         "precision highp int;\n"
          "uniform mat4 mvp;\n"
-         "uniform mat4 mv;\n"
+         "uniform highp sampler2D samples;\n"
+         "uniform int first;\n"
+         "uniform int count;\n"
+         "uniform int capacity;\n"
+         "uniform float half_width;\n"
+         "uniform vec3 up;\n"
+         "vec3 Sample(int i) {\n"
+         "  int ring = (first + i) % capacity;\n"
+         "  int width = textureSize(samples, 0).x;\n"
+         "  return texelFetch(samples, ivec2(ring % width, ring / width),\n"
+         "                    0).xyz;\n"
+         "}\n"
+         "void main() {\n"
+         "  int body_count = 2 * count;\n"
+         "  int i = min(gl_VertexID / 2, count - 1);\n"
+         "  vec3 center = Sample(i);\n"
+         "  vec3 direction =\n"
+         "      Sample(min(i + 1, count - 1)) - Sample(max(i - 1, 0));\n"
+         "  vec3 right = cross(direction, up);\n"
+         "  float length2 = dot(right, right);\n"
+         "  right = length2 > 1e-12 ? right * inversesqrt(length2)\n"
+         "                          : vec3(1.0, 0.0, 0.0);\n"
+         "  vec3 position;\n"
+         "  if (gl_VertexID < body_count) {\n"
+         "    float side = gl_VertexID % 2 == 0 ? -1.0 : 1.0;\n"
+         "    position = center + right * (side * half_width);\n"
+         "  } else {\n"
+         "    int corner = gl_VertexID - body_count;\n"
+         "    vec3 offset = corner == 2 ? cross(up, right)\n"
+         "                              : right * (corner == 0 ? -1.0 : 1.0);\n"
+         "    position = center + offset * (1.5 * half_width);\n"
+         "  }\n"
+         "  gl_Position = mvp * vec4(position, 1.0);\n"
+         "}\n";
+}
+
+std::string GetRibbonFragmentShader() {
+  return "#version 300 es\n"
+         "precision mediump float;\n"
          "uniform vec4 color;\n"
-         "uniform vec3 lightVec;\n"
-         "varying vec4 v_color;\n"
-         "void main() {\n"
-         "  vec3 mvNormal = vec3(mv * vec4(normal, 0.0));\n"
-         "  float diffuse = max(-dot(mvNormal, lightVec), 0.0);\n"
-         "  v_color.a = color.a;\n"
-         "  v_color.xyz = color.xyz * diffuse + color.xyz * 0.3;\n"
-         "  gl_Position = mvp*vertex;\n"
+         "out vec4 frag_color;\n"
+         "void main() {\n"
+         "  frag_color = color;\n"
+         "}\n";
+}
+
+std::string GetPointTransformVertexShader() {
+  return "#version 300 es\n"
+         "precision highp float;\n"
+         "in vec3 vertex;\n"
+         "uniform mat4 world_T_depth;\n"
+         "out vec3 world_position;\n"
+         "void main() {\n"
+         "  world_position = (world_T_depth * vec4(vertex, 1.0)).xyz;\n"
+         "}\n";
+}
+
+std::string GetPointTransformFragmentShader() {
+  return "#version 300 es\n"
+         "precision mediump float;\n"
+         "out vec4 frag_color;\n"
+         "void main() {\n"
+         "  frag_color = vec4(0.0);\n"
+         "}\n";
+}
+
+std::string GetDepthSplatVertexShader() {
+  return "precision highp float;\n"
+         "attribute vec4 vertex;\n"
+         "uniform mat4 mvp;\n"
+         "uniform mat4 color_T_depth;\n"
+         "uniform float point_size;\n"
+         "varying mediump vec2 v_depth;\n"
+         "void main() {\n"
+         "  gl_Position = mvp * vertex;\n"
+         "  gl_PointSize = point_size;\n"
+         "  float z = (color_T_depth * vertex).z;\n"
+         "  float millimeters = floor(clamp(z * 1000.0, 0.0, 65535.0) + 0.5);\n"
+         "  float high = floor(millimeters / 256.0);\n"
+         "  v_depth = vec2(high, millimeters - high * 256.0) / 255.0;\n"
+         "}\n";
+}
+
+std::string GetDepthSplatFragmentShader() {
+  return "precision mediump float;\n"
+         "varying vec2 v_depth;\n"
+         "void main() {\n"
+         "  gl_FragColor = vec4(0.0, 0.0, v_depth);\n"
+         "}\n";
+}
+
+std::string GetOcclusionVertexShader() {
+  return "precision mediump float;\n"
+         "attribute vec2 vertex;\n"
+         "varying vec2 f_textureCoords;\n"
+         "void main() {\n"
+         "  gl_Position = vec4(vertex, 0.0, 1.0);\n"
+         "  f_textureCoords = vec2(0.5 + 0.5 * vertex.x,\n"
+         "                         0.5 - 0.5 * vertex.y);\n"
+         "}\n";
+}
+
+std::string GetOcclusionFragmentShader() {
+  return std::string(kOcclusionFragmentHeader) +
+         "void main() {\n"
+         "  float depth = DecodeDepth(texture2D(depth_image, "
+         "f_textureCoords));\n"
+         "  if (depth <= 0.0) {\n"
+         "    discard;\n"
+         "  }\n"
+         "  gl_FragDepthEXT = 0.5 + 0.5 * (depth_transform.x +\n"
+         "                                 depth_transform.y / depth);\n"
+         "  gl_FragColor = vec4(0.0);\n"
+         "}\n";
+}
+
+std::string GetEdgeAwareOcclusionFragmentShader() {
+  return std::string(kOcclusionFragmentHeader) +
+         "uniform vec2 texel_size;\n"
+         "uniform float edge_threshold;\n"
+         "void main() {\n"
+         "  vec2 position = f_textureCoords / texel_size - 0.5;\n"
+         "  vec2 base = floor(position);\n"
+         "  vec2 f = position - base;\n"
+         "  vec2 coords = (base + 0.5) * texel_size;\n"
+         "  vec4 depths = vec4(\n"
+         "      DecodeDepth(texture2D(depth_image, coords)),\n"
+         "      DecodeDepth(texture2D(depth_image,\n"
+         "                            coords + vec2(texel_size.x, 0.0))),\n"
+         "      DecodeDepth(texture2D(depth_image,\n"
+         "                            coords + vec2(0.0, texel_size.y))),\n"
+         "      DecodeDepth(texture2D(depth_image, coords + texel_size)));\n"
+         "  vec4 valid = step(0.0005, depths);\n"
+         "  if (dot(valid, valid) == 0.0) {\n"
+         "    discard;\n"
+         "  }\n"
+         "  vec2 near = step(0.5, f);\n"
+         "  float reference = mix(mix(depths.x, depths.y, near.x),\n"
+         "                        mix(depths.z, depths.w, near.x), near.y);\n"
+         "  if (reference <= 0.0) {\n"
+         "    vec4 candidates = mix(vec4(65.536), depths, valid);\n"
+         "    reference = min(min(candidates.x, candidates.y),\n"
+         "                    min(candidates.z, candidates.w));\n"
+         "  }\n"
+         "  vec4 same = valid * step(abs(depths - reference),\n"
+         "                           vec4(edge_threshold * reference));\n"
+         "  vec4 weights = vec4((1.0 - f.x) * (1.0 - f.y), f.x * (1.0 - f.y),\n"
+         "                      (1.0 - f.x) * f.y, f.x * f.y);\n"
+         "  weights = same * (weights + 0.0001);\n"
+         "  float inverse_depth = dot(weights, 1.0 / max(depths, 0.001)) /\n"
+         "                        dot(weights, vec4(1.0));\n"
+         "  gl_FragDepthEXT = 0.5 + 0.5 * (depth_transform.x +\n"
+         "                                 depth_transform.y * inverse_depth);\n"
+         "  gl_FragColor = vec4(0.0);\n"
          "}\n";
 }
 }  // namespace shaders
@@ -0,0 +1,235 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "tango-gl/sprite_batch.h"
+
+#include <algorithm>
+
+#include "tango-gl/counters.h"
+#include "tango-gl/program_cache.h"
+#include "tango-gl/render_state.h"
+#include "tango-gl/shaders.h"
+
+namespace {
+// Position, texture coordinates and color.
+const int kFloatsPerVertex = 3 + 2 + 4;
+const int kVerticesPerQuad = 6;
+
+void AddVertex(const glm::vec3& position, float u, float v,
+               const glm::vec4& color, GLfloat* vertex) {
+  vertex[0] = position.x;
+  vertex[1] = position.y;
+  vertex[2] = position.z;
+  vertex[3] = u;
+  vertex[4] = v;
+  vertex[5] = color.r;
+  vertex[6] = color.g;
+  vertex[7] = color.b;
+  vertex[8] = color.a;
+}
+}  // namespace
+
+namespace tango_gl {
+
+SpriteBatch::SpriteBatch(const TextureAtlas* atlas)
+    : atlas_(atlas),
+      vertex_buffer_(GL_ARRAY_BUFFER, GL_DYNAMIC_DRAW),
+      shader_program_(0),
+      attrib_vertices_(-1),
+      attrib_texture_coords_(-1),
+      attrib_colors_(-1),
+      uniform_vp_mat_(-1) {}
+
+SpriteBatch::~SpriteBatch() { Release(); }
+
+void SpriteBatch::AddBillboard(int sprite, const glm::vec3& position,
+                               const glm::vec2& size,
+                               const glm::vec4& color) {
+  Quad quad;
+  quad.sprite = sprite;
+  quad.center = position;
+  quad.half_right = glm::vec3(0.0f);
+  quad.half_up = glm::vec3(0.0f);
+  quad.size = size;
+  quad.color = color;
+  quads_.push_back(quad);
+}
+
+void SpriteBatch::AddQuad(int sprite, const glm::mat4& model_mat,
+                          const glm::vec4& color) {
+  Quad quad;
+  quad.sprite = sprite;
+  quad.center = glm::vec3(model_mat[3]);
+  quad.half_right = 0.5f * glm::vec3(model_mat[0]);
+  quad.half_up = 0.5f * glm::vec3(model_mat[1]);
+  quad.size = glm::vec2(0.0f);
+  quad.color = color;
+  quads_.push_back(quad);
+}
+
+void SpriteBatch::Render(const glm::mat4& projection_mat,
+                         const glm::mat4& view_mat) {
+  const size_t page_count = atlas_->GetPageCount();
+  if (quads_.empty() || page_count == 0 || !InitializeGL()) {
+    quads_.clear();
+    return;
+  }
+
+  // Vertices are grouped by page, quads keep their order within a page.
+  page_starts_.assign(page_count + 1, 0);
+  for (const Quad& quad : quads_) {
+    if (atlas_->IsLoaded(quad.sprite)) {
+      page_starts_[atlas_->GetSprite(quad.sprite).page + 1] +=
+          kVerticesPerQuad;
+    }
+  }
+  for (size_t page = 1; page <= page_count; ++page) {
+    page_starts_[page] += page_starts_[page - 1];
+  }
+  vertices_.resize(page_starts_[page_count] * kFloatsPerVertex);
+  std::vector<GLsizei> page_ends(page_starts_.begin(), page_starts_.end() - 1);
+
+  // Rows of the view rotation, the camera right and up in world space.
+  const glm::vec3 camera_right(view_mat[0][0], view_mat[1][0],
+                               view_mat[2][0]);
+  const glm::vec3 camera_up(view_mat[0][1], view_mat[1][1], view_mat[2][1]);
+  for (const Quad& quad : quads_) {
+    if (!atlas_->IsLoaded(quad.sprite)) {
+      continue;
+    }
+    const TextureAtlas::Sprite& sprite = atlas_->GetSprite(quad.sprite);
+    glm::vec3 half_right = quad.half_right;
+    glm::vec3 half_up = quad.half_up;
+    if (quad.size != glm::vec2(0.0f)) {
+      half_right = 0.5f * quad.size.x * camera_right;
+      half_up = 0.5f * quad.size.y * camera_up;
+    }
+    const glm::vec3 bottom_left = quad.center - half_right - half_up;
+    const glm::vec3 bottom_right = quad.center + half_right - half_up;
+    const glm::vec3 top_left = quad.center - half_right + half_up;
+    const glm::vec3 top_right = quad.center + half_right + half_up;
+    // The first row of the image is at uv_min.y.
+    const glm::vec2& uv_min = sprite.uv_min;
+    const glm::vec2& uv_max = sprite.uv_max;
+    GLfloat* vertex =
+        vertices_.data() + page_ends[sprite.page] * kFloatsPerVertex;
+    AddVertex(bottom_left, uv_min.x, uv_max.y, quad.color, vertex);
+    AddVertex(bottom_right, uv_max.x, uv_max.y, quad.color,
+              vertex + kFloatsPerVertex);
+    AddVertex(top_left, uv_min.x, uv_min.y, quad.color,
+              vertex + 2 * kFloatsPerVertex);
+    AddVertex(top_left, uv_min.x, uv_min.y, quad.color,
+              vertex + 3 * kFloatsPerVertex);
+    AddVertex(bottom_right, uv_max.x, uv_max.y, quad.color,
+              vertex + 4 * kFloatsPerVertex);
+    AddVertex(top_right, uv_max.x, uv_min.y, quad.color,
+              vertex + 5 * kFloatsPerVertex);
+    page_ends[sprite.page] += kVerticesPerQuad;
+  }
+  quads_.clear();
+  if (vertices_.empty()) {
+    return;
+  }
+
+  // Only the vertices from the first changed one on are uploaded.
+  size_t dirty_count = std::min(vertices_.size(), uploaded_vertices_.size());
+  dirty_count = std::mismatch(vertices_.begin(),
+                              vertices_.begin() + dirty_count,
+                              uploaded_vertices_.begin()).first -
+                vertices_.begin();
+  if (dirty_count < vertices_.size() ||
+      vertices_.size() != uploaded_vertices_.size()) {
+    vertex_buffer_.Update(vertices_.data(), vertices_.size() * sizeof(GLfloat),
+                          dirty_count * sizeof(GLfloat));
+    uploaded_vertices_.swap(vertices_);
+  }
+
+  RenderState::UseProgram(shader_program_);
+  const glm::mat4 vp_mat = projection_mat * view_mat;
+  glUniformMatrix4fv(uniform_vp_mat_, 1, GL_FALSE, glm::value_ptr(vp_mat));
+  RenderState::ActiveTexture(GL_TEXTURE0);
+  RenderState::Enable(GL_BLEND);
+  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+  RenderState::Enable(GL_DEPTH_TEST);
+  // Quads added with AddQuad() can be seen from behind.
+  RenderState::Disable(GL_CULL_FACE);
+  glDepthMask(GL_FALSE);
+
+  const GLsizei stride = kFloatsPerVertex * sizeof(GLfloat);
+  vertex_buffer_.Bind();
+  glEnableVertexAttribArray(attrib_vertices_);
+  glVertexAttribPointer(attrib_vertices_, 3, GL_FLOAT, GL_FALSE, stride,
+                        nullptr);
+  glEnableVertexAttribArray(attrib_texture_coords_);
+  glVertexAttribPointer(attrib_texture_coords_, 2, GL_FLOAT, GL_FALSE, stride,
+                        reinterpret_cast<const GLvoid*>(3 * sizeof(GLfloat)));
+  glEnableVertexAttribArray(attrib_colors_);
+  glVertexAttribPointer(attrib_colors_, 4, GL_FLOAT, GL_FALSE, stride,
+                        reinterpret_cast<const GLvoid*>(5 * sizeof(GLfloat)));
+  for (size_t page = 0; page < page_count; ++page) {
+    const GLsizei count = page_starts_[page + 1] - page_starts_[page];
+    if (count == 0) {
+      continue;
+    }
+    RenderState::BindTexture(GL_TEXTURE_2D,
+                             atlas_->GetPageTexture(static_cast<int>(page)));
+    Counters::Increment(Counters::kDrawCalls);
+    glDrawArrays(GL_TRIANGLES, page_starts_[page], count);
+  }
+  glDisableVertexAttribArray(attrib_vertices_);
+  glDisableVertexAttribArray(attrib_texture_coords_);
+  glDisableVertexAttribArray(attrib_colors_);
+
+  glDepthMask(GL_TRUE);
+  RenderState::Disable(GL_BLEND);
+  util::CheckGlError("SpriteBatch::Render");
+}
+
+bool SpriteBatch::InitializeGL() {
+  if (shader_program_ != 0) {
+    return true;
+  }
+  shader_program_ =
+      program_cache::AcquireProgram(shaders::GetSpriteVertexShader().c_str(),
+                                    shaders::GetSpriteFragmentShader().c_str());
+  if (!shader_program_) {
+    LOGE("SpriteBatch: could not create program.");
+    return false;
+  }
+  attrib_vertices_ = glGetAttribLocation(shader_program_, "vertex");
+  attrib_texture_coords_ =
+      glGetAttribLocation(shader_program_, "textureCoords");
+  attrib_colors_ = glGetAttribLocation(shader_program_, "color");
+  uniform_vp_mat_ = glGetUniformLocation(shader_program_, "vp");
+  RenderState::UseProgram(shader_program_);
+  glUniform1i(glGetUniformLocation(shader_program_, "atlas"), 0);
+  return true;
+}
+
+void SpriteBatch::Release() {
+  program_cache::ReleaseProgram(shader_program_);
+  vertex_buffer_.Release();
+  Invalidate();
+}
+
+void SpriteBatch::Invalidate() {
+  shader_program_ = 0;
+  vertex_buffer_.Invalidate();
+  uploaded_vertices_.clear();
+}
+
+}  // namespace tango_gl
@@ -0,0 +1,227 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "tango-gl/startup_orchestrator.h"
+
+#include <stdio.h>
+
+#include <algorithm>
+
+#include "tango-gl/tracing.h"
+#include "tango-gl/util.h"
+
+namespace tango_gl {
+
+StartupOrchestrator::StartupOrchestrator()
+    : is_started_(false), error_(0), start_us_(0), first_frame_us_(0) {}
+
+StartupOrchestrator::~StartupOrchestrator() { Stop(); }
+
+int StartupOrchestrator::AddTask(const char* name, Thread thread, Task task,
+                                 std::initializer_list<int> dependencies) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  TaskInfo info;
+  info.name = name;
+  info.thread = thread;
+  info.task = task;
+  info.dependencies = dependencies;
+  info.state = kPending;
+  info.start_us = 0;
+  info.duration_us = 0;
+  tasks_.push_back(info);
+  return static_cast<int>(tasks_.size()) - 1;
+}
+
+void StartupOrchestrator::Start() {
+  Stop();
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (TaskInfo& task : tasks_) {
+    task.state = kPending;
+    task.start_us = 0;
+    task.duration_us = 0;
+  }
+  is_started_ = true;
+  error_ = 0;
+  start_us_ = tracing::NowMicroseconds();
+  first_frame_us_ = 0;
+  DispatchWorkers();
+}
+
+void StartupOrchestrator::Stop() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  is_started_ = false;
+  // A finishing worker may have started the next ones before it saw the
+  // stop, so join until no threads are left.
+  while (!threads_.empty()) {
+    std::vector<std::thread> threads;
+    threads.swap(threads_);
+    lock.unlock();
+    for (std::thread& thread : threads) {
+      thread.join();
+    }
+    lock.lock();
+  }
+}
+
+void StartupOrchestrator::RunGLTasks() {
+  while (true) {
+    int id = -1;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (!is_started_) {
+        return;
+      }
+      for (size_t i = 0; i < tasks_.size(); ++i) {
+        if (tasks_[i].thread == kGLThread && IsReady(tasks_[i])) {
+          tasks_[i].state = kRunning;
+          id = static_cast<int>(i);
+          break;
+        }
+      }
+    }
+    if (id < 0) {
+      return;
+    }
+    RunTask(id);
+  }
+}
+
+bool StartupOrchestrator::IsStarted() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return is_started_;
+}
+
+bool StartupOrchestrator::IsComplete() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (const TaskInfo& task : tasks_) {
+    if (task.state != kSucceeded) {
+      return false;
+    }
+  }
+  return true;
+}
+
+int StartupOrchestrator::GetError() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return error_;
+}
+
+void StartupOrchestrator::MarkFirstFrame() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!is_started_ || first_frame_us_ != 0) {
+    return;
+  }
+  // Kept non zero, 0 means not marked.
+  first_frame_us_ =
+      std::max<uint64_t>(1, tracing::NowMicroseconds() - start_us_);
+  LOGI("StartupOrchestrator: time to first frame %.1f ms",
+       first_frame_us_ / 1000.0f);
+}
+
+float StartupOrchestrator::GetTimeToFirstFrameMs() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return first_frame_us_ / 1000.0f;
+}
+
+std::string StartupOrchestrator::GetReport() const {
+  std::string report;
+  char line[128];
+  std::lock_guard<std::mutex> lock(mutex_);
+  snprintf(line, sizeof(line), "time to first frame %.1f ms\n",
+           first_frame_us_ / 1000.0f);
+  report += line;
+  for (const TaskInfo& task : tasks_) {
+    const char* thread = task.thread == kGLThread ? "gl" : "worker";
+    switch (task.state) {
+      case kPending:
+        snprintf(line, sizeof(line), "%s %s pending\n", task.name, thread);
+        break;
+      case kRunning:
+        snprintf(line, sizeof(line), "%s %s +%.1f ms running\n", task.name,
+                 thread, task.start_us / 1000.0f);
+        break;
+      case kSucceeded:
+      case kFailed:
+        snprintf(line, sizeof(line), "%s %s +%.1f ms %.1f ms%s\n", task.name,
+                 thread, task.start_us / 1000.0f, task.duration_us / 1000.0f,
+                 task.state == kFailed ? " failed" : "");
+        break;
+    }
+    report += line;
+  }
+  return report;
+}
+
+bool StartupOrchestrator::IsReady(const TaskInfo& task) const {
+  if (task.state != kPending) {
+    return false;
+  }
+  for (int dependency : task.dependencies) {
+    if (tasks_[dependency].state != kSucceeded) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void StartupOrchestrator::DispatchWorkers() {
+  if (!is_started_) {
+    return;
+  }
+  for (size_t i = 0; i < tasks_.size(); ++i) {
+    if (tasks_[i].thread == kWorker && IsReady(tasks_[i])) {
+      tasks_[i].state = kRunning;
+      threads_.push_back(std::thread([this, i]() {
+        TANGO_GL_TRACE_THREAD_NAME("StartupWorker");
+        RunTask(static_cast<int>(i));
+      }));
+    }
+  }
+}
+
+void StartupOrchestrator::RunTask(int id) {
+  const char* name;
+  Task task;
+  uint64_t run_start_us;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    name = tasks_[id].name;
+    task = tasks_[id].task;
+    run_start_us = tracing::NowMicroseconds();
+    tasks_[id].start_us = run_start_us - start_us_;
+  }
+
+  int ret = task();
+
+  const uint64_t duration_us = tracing::NowMicroseconds() - run_start_us;
+  tracing::RecordSpan(name, "startup", run_start_us, duration_us);
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  tasks_[id].duration_us = duration_us;
+  if (ret == 0) {
+    tasks_[id].state = kSucceeded;
+  } else {
+    tasks_[id].state = kFailed;
+    LOGE("StartupOrchestrator: %s failed with error code %d", name, ret);
+    if (error_ == 0) {
+      error_ = ret;
+    }
+  }
+  DispatchWorkers();
+}
+
+}  // namespace tango_gl
@@ -0,0 +1,234 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+
+#include <EGL/egl.h>
+
+#include "tango-gl/counters.h"
+#include "tango-gl/memory_tracker.h"
+#include "tango-gl/render_state.h"
+#include "tango-gl/streaming_texture.h"
+
+// GLES3 tokens, the examples are built against the GLES2 headers.
+#ifndef GL_PIXEL_UNPACK_BUFFER
+#define GL_PIXEL_UNPACK_BUFFER 0x88EC
+#endif
+#ifndef GL_MAP_WRITE_BIT
+#define GL_MAP_WRITE_BIT 0x0002
+#endif
+#ifndef GL_MAP_INVALIDATE_BUFFER_BIT
+#define GL_MAP_INVALIDATE_BUFFER_BIT 0x0008
+#endif
+
+namespace {
+typedef void* (*MapBufferRangeFunc)(GLenum target, GLintptr offset,
+                                    GLsizeiptr length, GLbitfield access);
+typedef GLboolean (*UnmapBufferFunc)(GLenum target);
+
+MapBufferRangeFunc map_buffer_range = nullptr;
+UnmapBufferFunc unmap_buffer = nullptr;
+
+// The GLES3 entry points are resolved at runtime so the examples keep linking
+// against libGLESv2 only and still run on GLES2 devices.
+bool LoadPixelBufferFunctions() {
+  static bool is_loaded = false;
+  if (is_loaded) {
+    return map_buffer_range != nullptr && unmap_buffer != nullptr;
+  }
+  is_loaded = true;
+
+  const char* version =
+      reinterpret_cast<const char*>(glGetString(GL_VERSION));
+  if (version == nullptr || strncmp(version, "OpenGL ES 3", 11) != 0) {
+    return false;
+  }
+  map_buffer_range = reinterpret_cast<MapBufferRangeFunc>(
+      eglGetProcAddress("glMapBufferRange"));
+  unmap_buffer =
+      reinterpret_cast<UnmapBufferFunc>(eglGetProcAddress("glUnmapBuffer"));
+  if (map_buffer_range == nullptr || unmap_buffer == nullptr) {
+    LOGE("StreamingTexture: GLES3 context without PBO entry points.");
+    return false;
+  }
+  return true;
+}
+
+int BytesPerPixel(GLenum format) {
+  switch (format) {
+    case GL_LUMINANCE:
+      return 1;
+    case GL_LUMINANCE_ALPHA:
+      return 2;
+    case GL_RGB:
+      return 3;
+    case GL_RGBA:
+      return 4;
+    default:
+      LOGE("StreamingTexture: unsupported format 0x%x", format);
+      return 0;
+  }
+}
+}  // namespace
+
+namespace tango_gl {
+
+StreamingTexture::StreamingTexture()
+    : texture_id_(0),
+      width_(0),
+      height_(0),
+      format_(GL_RGB),
+      size_in_bytes_(0),
+      pixel_buffer_index_(0),
+      is_updating_(false) {
+  memset(pixel_buffers_, 0, sizeof(pixel_buffers_));
+}
+
+StreamingTexture::~StreamingTexture() { Release(); }
+
+void StreamingTexture::Allocate(GLsizei width, GLsizei height,
+                                GLenum format) {
+  if (IsAllocated() && width == width_ && height == height_ &&
+      format == format_) {
+    return;
+  }
+  Release();
+
+  width_ = width;
+  height_ = height;
+  format_ = format;
+  size_in_bytes_ = static_cast<size_t>(width) * height * BytesPerPixel(format);
+
+  glGenTextures(1, &texture_id_);
+  RenderState::BindTexture(GL_TEXTURE_2D, texture_id_);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glTexImage2D(GL_TEXTURE_2D, 0, format_, width_, height_, 0, format_,
+               GL_UNSIGNED_BYTE, nullptr);
+  RenderState::BindTexture(GL_TEXTURE_2D, 0);
+  util::CheckGlError("StreamingTexture::Allocate");
+  MemoryTracker::Track(MemoryTracker::kTexture, texture_id_,
+                       "StreamingTexture", size_in_bytes_);
+
+  if (LoadPixelBufferFunctions()) {
+    glGenBuffers(kPixelBufferCount, pixel_buffers_);
+    for (int i = 0; i < kPixelBufferCount; ++i) {
+      RenderState::BindBuffer(GL_PIXEL_UNPACK_BUFFER, pixel_buffers_[i]);
+      glBufferData(GL_PIXEL_UNPACK_BUFFER, size_in_bytes_, nullptr,
+                   GL_STREAM_DRAW);
+      MemoryTracker::Track(MemoryTracker::kBuffer, pixel_buffers_[i],
+                           "StreamingTexture", size_in_bytes_);
+    }
+    RenderState::BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    util::CheckGlError("StreamingTexture::Allocate PBO");
+  }
+}
+
+void StreamingTexture::Release() {
+  if (pixel_buffers_[0] != 0) {
+    RenderState::DeleteBuffers(kPixelBufferCount, pixel_buffers_);
+  }
+  if (texture_id_ != 0) {
+    RenderState::DeleteTextures(1, &texture_id_);
+  }
+  Invalidate();
+}
+
+void StreamingTexture::Invalidate() {
+  texture_id_ = 0;
+  memset(pixel_buffers_, 0, sizeof(pixel_buffers_));
+  staging_buffer_.clear();
+  pixel_buffer_index_ = 0;
+  is_updating_ = false;
+}
+
+void StreamingTexture::Update(const void* data) {
+  if (!IsAllocated()) {
+    LOGE("StreamingTexture: Update() called before Allocate().");
+    return;
+  }
+
+  if (!IsUsingPixelBuffers()) {
+    UploadFromBoundBuffer(data);
+    return;
+  }
+
+  uint8_t* destination = BeginUpdate();
+  if (destination != nullptr) {
+    memcpy(destination, data, size_in_bytes_);
+  }
+  EndUpdate();
+}
+
+uint8_t* StreamingTexture::BeginUpdate() {
+  if (!IsAllocated()) {
+    LOGE("StreamingTexture: BeginUpdate() called before Allocate().");
+    return nullptr;
+  }
+  is_updating_ = true;
+
+  if (!IsUsingPixelBuffers()) {
+    staging_buffer_.resize(size_in_bytes_);
+    return staging_buffer_.data();
+  }
+
+  // Invalidating the whole buffer lets the driver hand out fresh memory
+  // instead of waiting for a transfer still reading from this PBO.
+  RenderState::BindBuffer(GL_PIXEL_UNPACK_BUFFER,
+                          pixel_buffers_[pixel_buffer_index_]);
+  void* destination =
+      map_buffer_range(GL_PIXEL_UNPACK_BUFFER, 0, size_in_bytes_,
+                       GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+  if (destination == nullptr) {
+    LOGE("StreamingTexture: failed to map the pixel buffer.");
+    RenderState::BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    is_updating_ = false;
+  }
+  return static_cast<uint8_t*>(destination);
+}
+
+void StreamingTexture::EndUpdate() {
+  if (!is_updating_) {
+    return;
+  }
+  is_updating_ = false;
+
+  if (!IsUsingPixelBuffers()) {
+    UploadFromBoundBuffer(staging_buffer_.data());
+    return;
+  }
+
+  unmap_buffer(GL_PIXEL_UNPACK_BUFFER);
+  // With a PBO bound the data pointer is an offset into the buffer.
+  UploadFromBoundBuffer(nullptr);
+  RenderState::BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+  pixel_buffer_index_ = (pixel_buffer_index_ + 1) % kPixelBufferCount;
+}
+
+void StreamingTexture::UploadFromBoundBuffer(const void* data) {
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  RenderState::BindTexture(GL_TEXTURE_2D, texture_id_);
+  glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width_, height_, format_,
+                  GL_UNSIGNED_BYTE, data);
+  Counters::Add(Counters::kTextureBytes, size_in_bytes_);
+  RenderState::BindTexture(GL_TEXTURE_2D, 0);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+  util::CheckGlError("StreamingTexture::Upload");
+}
+
+}  // namespace tango_gl
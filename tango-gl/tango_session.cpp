@@ -0,0 +1,277 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "tango-gl/tango_session.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+#include "tango-gl/util.h"
+
+namespace {
+bool IsValidCamera(TangoCameraId camera) {
+  return camera >= TANGO_CAMERA_COLOR && camera < TANGO_MAX_CAMERA_ID;
+}
+}  // namespace
+
+namespace tango_gl {
+
+TangoSession::TangoSession(const Options& options)
+    : options_(options),
+      config_(nullptr),
+      is_connected_(false),
+      dropped_depth_count_(0),
+      dropped_image_count_(0) {
+  if (options_.enable_depth) {
+    depth_pool_.reset(new PointCloudPool(
+        options_.max_point_count,
+        options_.depth_frame_count * options_.max_point_count * 3 *
+            sizeof(float)));
+  }
+  for (TangoCameraId camera : options_.cameras) {
+    if (!IsValidCamera(camera) || image_pools_[camera]) {
+      LOGE("TangoSession: Invalid or repeated camera %d", camera);
+      continue;
+    }
+    image_pools_[camera].reset(
+        new ImagePool(options_.max_image_size,
+                      options_.image_frame_count * options_.max_image_size));
+  }
+}
+
+TangoSession::~TangoSession() {
+  Disconnect();
+  if (config_ != nullptr) {
+    TangoConfig_free(config_);
+  }
+}
+
+TangoErrorType TangoSession::SetupConfig() {
+  if (config_ != nullptr) {
+    TangoConfig_free(config_);
+  }
+  config_ = TangoService_getConfig(TANGO_CONFIG_DEFAULT);
+  if (config_ == nullptr) {
+    LOGE("TangoSession: Failed to get the default config");
+    return TANGO_ERROR;
+  }
+  TangoErrorType ret = TangoConfig_setBool(
+      config_, "config_enable_auto_recovery", options_.enable_auto_recovery);
+  if (ret != TANGO_SUCCESS) {
+    LOGE("TangoSession: config_enable_auto_recovery failed with error code: %d",
+         ret);
+    return ret;
+  }
+  ret = TangoConfig_setBool(config_, "config_enable_depth",
+                            options_.enable_depth);
+  if (ret != TANGO_SUCCESS) {
+    LOGE("TangoSession: config_enable_depth failed with error code: %d", ret);
+    return ret;
+  }
+  if (image_pools_[TANGO_CAMERA_COLOR]) {
+    ret = TangoConfig_setBool(config_, "config_enable_color_camera", true);
+    if (ret != TANGO_SUCCESS) {
+      LOGE("TangoSession: config_enable_color_camera failed with error code: "
+           "%d", ret);
+      return ret;
+    }
+  }
+  return TANGO_SUCCESS;
+}
+
+void TangoSession::AddDepthHandler(const DepthHandler& handler) {
+  if (is_connected_ || !depth_pool_) {
+    LOGE("TangoSession: Depth handler added while connected or without "
+         "depth");
+    return;
+  }
+  depth_handlers_.push_back(handler);
+}
+
+void TangoSession::AddFrameHandler(TangoCameraId camera,
+                                   const FrameHandler& handler) {
+  if (is_connected_ || !IsValidCamera(camera) || !image_pools_[camera]) {
+    LOGE("TangoSession: Frame handler of camera %d added while connected or "
+         "for a camera not in the options", camera);
+    return;
+  }
+  frame_handlers_[camera].push_back(handler);
+}
+
+void TangoSession::AddPoseHandler(const PoseHandler& handler) {
+  if (is_connected_) {
+    LOGE("TangoSession: Pose handler added while connected");
+    return;
+  }
+  pose_handlers_.push_back(handler);
+}
+
+void TangoSession::AddEventHandler(const EventHandler& handler) {
+  if (is_connected_) {
+    LOGE("TangoSession: Event handler added while connected");
+    return;
+  }
+  event_handlers_.push_back(handler);
+}
+
+TangoErrorType TangoSession::Connect() {
+  if (is_connected_) {
+    return TANGO_SUCCESS;
+  }
+  if (config_ == nullptr) {
+    LOGE("TangoSession: Connect() called before SetupConfig()");
+    return TANGO_ERROR;
+  }
+  TangoErrorType ret = ConnectCallbacks();
+  if (ret != TANGO_SUCCESS) {
+    return ret;
+  }
+  ret = TangoService_connect(this, config_);
+  if (ret != TANGO_SUCCESS) {
+    LOGE("TangoSession: Failed to connect to the Tango service with error "
+         "code: %d", ret);
+    return ret;
+  }
+  is_connected_ = true;
+  return TANGO_SUCCESS;
+}
+
+void TangoSession::Disconnect() {
+  if (!is_connected_) {
+    return;
+  }
+  // Returns once the callbacks are done, no handler runs afterwards.
+  TangoService_disconnect();
+  is_connected_ = false;
+}
+
+TangoErrorType TangoSession::ConnectCallbacks() {
+  TangoErrorType ret;
+  // Streams without a module are not connected, so the service does not
+  // deliver them.
+  if (depth_pool_) {
+    ret = TangoService_connectOnXYZijAvailable(OnXYZijAvailableRouter);
+    if (ret != TANGO_SUCCESS) {
+      LOGE("TangoSession: Failed to connect the point cloud callback with "
+           "error code: %d", ret);
+      return ret;
+    }
+  }
+  for (int camera = 0; camera < TANGO_MAX_CAMERA_ID; ++camera) {
+    if (!image_pools_[camera]) {
+      continue;
+    }
+    ret = TangoService_connectOnFrameAvailable(
+        static_cast<TangoCameraId>(camera), this, OnFrameAvailableRouter);
+    if (ret != TANGO_SUCCESS) {
+      LOGE("TangoSession: Failed to connect the frame callback of camera %d "
+           "with error code: %d", camera, ret);
+      return ret;
+    }
+  }
+  if (!options_.frame_pairs.empty()) {
+    ret = TangoService_connectOnPoseAvailable(
+        static_cast<uint32_t>(options_.frame_pairs.size()),
+        options_.frame_pairs.data(), OnPoseAvailableRouter);
+    if (ret != TANGO_SUCCESS) {
+      LOGE("TangoSession: Failed to connect the pose callback with error "
+           "code: %d", ret);
+      return ret;
+    }
+  }
+  if (!event_handlers_.empty()) {
+    ret = TangoService_connectOnTangoEvent(OnTangoEventRouter);
+    if (ret != TANGO_SUCCESS) {
+      LOGE("TangoSession: Failed to connect the event callback with error "
+           "code: %d", ret);
+      return ret;
+    }
+  }
+  return TANGO_SUCCESS;
+}
+
+PointCloudPool::Handle TangoSession::AcquireLatestPointCloud() {
+  return depth_pool_ ? depth_pool_->AcquireLatest() : PointCloudPool::Handle();
+}
+
+ImagePool::Handle TangoSession::AcquireLatestImage(TangoCameraId camera) {
+  if (!IsValidCamera(camera) || !image_pools_[camera]) {
+    return ImagePool::Handle();
+  }
+  return image_pools_[camera]->AcquireLatest();
+}
+
+void TangoSession::OnXYZijAvailableRouter(void* context,
+                                          const TangoXYZij* xyz_ij) {
+  static_cast<TangoSession*>(context)->OnXYZijAvailable(xyz_ij);
+}
+
+void TangoSession::OnFrameAvailableRouter(void* context, TangoCameraId camera,
+                                          const TangoImageBuffer* buffer) {
+  static_cast<TangoSession*>(context)->OnFrameAvailable(camera, buffer);
+}
+
+void TangoSession::OnPoseAvailableRouter(void* context,
+                                         const TangoPoseData* pose) {
+  const TangoSession* session = static_cast<TangoSession*>(context);
+  for (const PoseHandler& handler : session->pose_handlers_) {
+    handler(*pose);
+  }
+}
+
+void TangoSession::OnTangoEventRouter(void* context, const TangoEvent* event) {
+  const TangoSession* session = static_cast<TangoSession*>(context);
+  for (const EventHandler& handler : session->event_handlers_) {
+    handler(*event);
+  }
+}
+
+void TangoSession::OnXYZijAvailable(const TangoXYZij* xyz_ij) {
+  PointCloudPool::Handle frame = depth_pool_->Allocate();
+  if (!frame) {
+    ++dropped_depth_count_;
+    return;
+  }
+  const size_t point_count =
+      std::min<size_t>(xyz_ij->xyz_count, depth_pool_->GetCapacity());
+  memcpy(frame->cloud.xyz, xyz_ij->xyz, point_count * 3 * sizeof(float));
+  frame->cloud.xyz_count = static_cast<uint32_t>(point_count);
+  frame->cloud.timestamp = xyz_ij->timestamp;
+  depth_pool_->Publish(frame);
+  for (const DepthHandler& handler : depth_handlers_) {
+    handler(frame);
+  }
+}
+
+void TangoSession::OnFrameAvailable(TangoCameraId camera,
+                                    const TangoImageBuffer* buffer) {
+  if (!IsValidCamera(camera) || !image_pools_[camera]) {
+    return;
+  }
+  ImagePool::Handle frame = image_pools_[camera]->Copy(*buffer);
+  if (!frame) {
+    ++dropped_image_count_;
+    return;
+  }
+  image_pools_[camera]->Publish(frame);
+  for (const FrameHandler& handler : frame_handlers_[camera]) {
+    handler(camera, frame);
+  }
+}
+
+}  // namespace tango_gl
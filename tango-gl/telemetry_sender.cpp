@@ -0,0 +1,378 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <netdb.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include "tango-gl/service_probe.h"
+#include "tango-gl/telemetry_sender.h"
+#include "tango-gl/util.h"
+
+namespace {
+tango_gl::telemetry::PoseRecord ToRecord(const TangoPoseData& pose) {
+  tango_gl::telemetry::PoseRecord record;
+  record.timestamp = pose.timestamp;
+  for (int i = 0; i < 3; ++i) {
+    record.translation[i] = static_cast<float>(pose.translation[i]);
+  }
+  for (int i = 0; i < 4; ++i) {
+    record.orientation[i] = static_cast<float>(pose.orientation[i]);
+  }
+  record.status_code = static_cast<uint8_t>(pose.status_code);
+  record.base_frame = static_cast<uint8_t>(pose.frame.base);
+  record.target_frame = static_cast<uint8_t>(pose.frame.target);
+  record.reserved = 0;
+  return record;
+}
+}  // namespace
+
+namespace tango_gl {
+
+TelemetrySender::TelemetrySender()
+    : poses_(nullptr),
+      socket_(-1),
+      sequence_(0),
+      frame_id_(0),
+      is_running_(false),
+      is_stopping_(false),
+      active_send_count_(0),
+      sent_packet_count_(0),
+      sent_byte_count_(0),
+      dropped_frame_count_(0),
+      dropped_pose_count_(0),
+      failed_packet_count_(0) {
+  for (int& subscription : subscriptions_) {
+    subscription = -1;
+  }
+}
+
+TelemetrySender::~TelemetrySender() { Stop(); }
+
+bool TelemetrySender::Start(const char* host, const char* port,
+                            PoseStream* poses, const Options& options) {
+  if (thread_.joinable()) {
+    LOGE("TelemetrySender: already running.");
+    return false;
+  }
+  const size_t min_datagram_size =
+      sizeof(telemetry::PacketHeader) +
+      std::max(std::max(sizeof(telemetry::PoseBatchHeader) +
+                            sizeof(telemetry::PoseRecord),
+                        sizeof(telemetry::DepthFragmentHeader) + 1),
+               sizeof(telemetry::ProbeRecord) +
+                   ServiceProbe::kBucketCount * sizeof(uint32_t));
+  if (options.max_datagram_size < min_datagram_size) {
+    LOGE("TelemetrySender: datagrams of %zu bytes are too small.",
+         options.max_datagram_size);
+    return false;
+  }
+
+  addrinfo hints;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_DGRAM;
+  addrinfo* addresses = nullptr;
+  const int error = getaddrinfo(host, port, &hints, &addresses);
+  if (error != 0) {
+    LOGE("TelemetrySender: could not resolve %s:%s, %s.", host, port,
+         gai_strerror(error));
+    return false;
+  }
+  // A connected socket only needs send() and reports ICMP errors.
+  for (addrinfo* address = addresses; address != nullptr;
+       address = address->ai_next) {
+    socket_ = socket(address->ai_family, address->ai_socktype,
+                     address->ai_protocol);
+    if (socket_ < 0) {
+      continue;
+    }
+    if (connect(socket_, address->ai_addr, address->ai_addrlen) == 0) {
+      break;
+    }
+    close(socket_);
+    socket_ = -1;
+  }
+  freeaddrinfo(addresses);
+  if (socket_ < 0) {
+    LOGE("TelemetrySender: could not connect a socket to %s:%s.", host, port);
+    return false;
+  }
+
+  options_ = options;
+  poses_ = poses;
+  sequence_ = 0;
+  frame_id_ = 0;
+  datagram_.resize(options.max_datagram_size);
+  encoded_frame_.resize(
+      point_cloud_codec::GetMaxEncodedSize(options.max_point_count));
+  pose_records_.reset(
+      new BoundedQueue<telemetry::PoseRecord>(options.pose_queue_capacity));
+  sent_packet_count_.store(0, std::memory_order_relaxed);
+  sent_byte_count_.store(0, std::memory_order_relaxed);
+  dropped_frame_count_.store(0, std::memory_order_relaxed);
+  dropped_pose_count_.store(0, std::memory_order_relaxed);
+  failed_packet_count_.store(0, std::memory_order_relaxed);
+
+  slots_.clear();
+  slots_.resize(options.point_cloud_slot_count);
+  free_slots_.reset(new BoundedQueue<int>(slots_.size()));
+  ready_slots_.reset(new BoundedQueue<int>(slots_.size()));
+  for (size_t i = 0; i < slots_.size(); ++i) {
+    slots_[i].points.resize(options.max_point_count * 3);
+    free_slots_->Push(static_cast<int>(i));
+  }
+
+  is_stopping_.store(false, std::memory_order_relaxed);
+  thread_ = std::thread(&TelemetrySender::SendLoop, this);
+  is_running_.store(true, std::memory_order_release);
+
+  // Only poses arriving from now on are sent.
+  if (poses_ != nullptr) {
+    for (int pair = 0; pair < poses_->GetPairCount(); ++pair) {
+      subscriptions_[pair] = poses_->Subscribe(
+          pair, options.pose_options,
+          [this](const TangoPoseData& pose) { QueuePose(pose); });
+    }
+  }
+  return true;
+}
+
+void TelemetrySender::Stop() {
+  if (!thread_.joinable()) {
+    return;
+  }
+  // No pose is queued once the subscriptions are gone.
+  for (int& subscription : subscriptions_) {
+    if (subscription >= 0) {
+      poses_->Unsubscribe(subscription);
+      subscription = -1;
+    }
+  }
+  // Sequentially consistent with BeginSend(): either the callback sees the
+  // flag cleared, or its count is seen here.
+  is_running_.store(false);
+  while (active_send_count_.load() > 0) {
+    std::this_thread::yield();
+  }
+  is_stopping_.store(true, std::memory_order_release);
+  thread_.join();
+
+  close(socket_);
+  socket_ = -1;
+}
+
+bool TelemetrySender::SendPointCloud(const TangoXYZij& cloud) {
+  if (!BeginSend()) {
+    return false;
+  }
+  int slot_index = -1;
+  if (cloud.xyz_count > options_.max_point_count ||
+      !free_slots_->Pop(&slot_index)) {
+    dropped_frame_count_.fetch_add(1, std::memory_order_relaxed);
+    EndSend();
+    return false;
+  }
+  PointCloudSlot& slot = slots_[slot_index];
+  slot.timestamp = cloud.timestamp;
+  slot.point_count = cloud.xyz_count;
+  if (cloud.xyz_count > 0) {
+    memcpy(slot.points.data(), cloud.xyz[0],
+           cloud.xyz_count * 3 * sizeof(float));
+  }
+  ready_slots_->Push(slot_index);
+  EndSend();
+  return true;
+}
+
+void TelemetrySender::QueuePose(const TangoPoseData& pose) {
+  if (!pose_records_->Push(ToRecord(pose))) {
+    dropped_pose_count_.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+bool TelemetrySender::BeginSend() {
+  active_send_count_.fetch_add(1);
+  if (!is_running_.load()) {
+    EndSend();
+    return false;
+  }
+  return true;
+}
+
+void TelemetrySender::SendLoop() {
+  std::chrono::steady_clock::time_point next_batch_time =
+      std::chrono::steady_clock::now();
+  std::chrono::steady_clock::time_point next_probe_time = next_batch_time;
+  while (!is_stopping_.load(std::memory_order_acquire)) {
+    // Poses first, a depth frame takes a few milliseconds to encode and
+    // send.
+    SendPoses();
+    SendNewestPointCloud();
+    std::chrono::steady_clock::time_point now =
+        std::chrono::steady_clock::now();
+    if (now >= next_probe_time) {
+      SendProbes();
+      next_probe_time = now + options_.probe_interval;
+    }
+    next_batch_time += options_.pose_batch_interval;
+    now = std::chrono::steady_clock::now();
+    if (next_batch_time > now) {
+      std::this_thread::sleep_until(next_batch_time);
+    } else {
+      // Fell behind, e.g. a large depth frame, do not try to catch up.
+      next_batch_time = now;
+    }
+  }
+}
+
+void TelemetrySender::SendPoses() {
+  const size_t header_size =
+      sizeof(telemetry::PacketHeader) + sizeof(telemetry::PoseBatchHeader);
+  const size_t batch_capacity =
+      (datagram_.size() - header_size) / sizeof(telemetry::PoseRecord);
+  uint8_t* records = datagram_.data() + header_size;
+  size_t batch_size = 0;
+
+  // Queued in the order the poses arrived, across all frame pairs.
+  telemetry::PoseRecord record;
+  while (pose_records_->Pop(&record)) {
+    memcpy(records + batch_size * sizeof(record), &record, sizeof(record));
+    if (++batch_size == batch_capacity) {
+      SendPoseBatch(batch_size);
+      batch_size = 0;
+    }
+  }
+  if (batch_size > 0) {
+    SendPoseBatch(batch_size);
+  }
+}
+
+void TelemetrySender::SendPoseBatch(size_t pose_count) {
+  telemetry::PoseBatchHeader header;
+  header.pose_count = static_cast<uint32_t>(pose_count);
+  header.reserved = 0;
+  memcpy(datagram_.data() + sizeof(telemetry::PacketHeader), &header,
+         sizeof(header));
+  SendDatagram(telemetry::kPosePacket,
+               sizeof(header) + pose_count * sizeof(telemetry::PoseRecord));
+}
+
+void TelemetrySender::SendNewestPointCloud() {
+  int slot_index;
+  if (!ready_slots_->Pop(&slot_index)) {
+    return;
+  }
+  // Only the newest frame is worth the bandwidth.
+  int newer_index;
+  while (ready_slots_->Pop(&newer_index)) {
+    free_slots_->Push(slot_index);
+    dropped_frame_count_.fetch_add(1, std::memory_order_relaxed);
+    slot_index = newer_index;
+  }
+
+  const PointCloudSlot& slot = slots_[slot_index];
+  const size_t frame_size =
+      encoder_.Encode(slot.points.data(), slot.point_count, options_.depth_step,
+                      encoded_frame_.data(), encoded_frame_.size());
+  const double timestamp = slot.timestamp;
+  free_slots_->Push(slot_index);
+  if (frame_size == 0) {
+    dropped_frame_count_.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+
+  const size_t header_size =
+      sizeof(telemetry::PacketHeader) + sizeof(telemetry::DepthFragmentHeader);
+  const size_t fragment_capacity = datagram_.size() - header_size;
+  const size_t fragment_count =
+      (frame_size + fragment_capacity - 1) / fragment_capacity;
+  if (fragment_count > UINT16_MAX) {
+    dropped_frame_count_.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  telemetry::DepthFragmentHeader header;
+  header.timestamp = timestamp;
+  header.frame_id = frame_id_++;
+  header.frame_size = static_cast<uint32_t>(frame_size);
+  header.fragment_count = static_cast<uint16_t>(fragment_count);
+  for (size_t i = 0; i < fragment_count; ++i) {
+    const size_t offset = i * fragment_capacity;
+    const size_t size = std::min(fragment_capacity, frame_size - offset);
+    header.offset = static_cast<uint32_t>(offset);
+    header.fragment_index = static_cast<uint16_t>(i);
+    memcpy(datagram_.data() + sizeof(telemetry::PacketHeader), &header,
+           sizeof(header));
+    memcpy(datagram_.data() + header_size, encoded_frame_.data() + offset,
+           size);
+    SendDatagram(telemetry::kDepthPacket, sizeof(header) + size);
+  }
+}
+
+void TelemetrySender::SendProbes() {
+  if (!ServiceProbe::IsEnabled()) {
+    return;
+  }
+  const size_t header_size =
+      sizeof(telemetry::PacketHeader) + sizeof(telemetry::ProbeRecord);
+  for (int i = 0; i < ServiceProbe::kSourceCount; ++i) {
+    const ServiceProbe::Histogram histogram =
+        ServiceProbe::GetHistogram(static_cast<ServiceProbe::Source>(i));
+    if (histogram.count == 0) {
+      continue;
+    }
+    telemetry::ProbeRecord record;
+    memset(&record, 0, sizeof(record));
+    record.source = static_cast<uint8_t>(i);
+    record.bucket_count = ServiceProbe::kBucketCount;
+    record.count = histogram.count;
+    record.sum_us = histogram.sum_us;
+    record.max_us = histogram.max_us;
+    record.early_count = histogram.early_count;
+    memcpy(datagram_.data() + sizeof(telemetry::PacketHeader), &record,
+           sizeof(record));
+    memcpy(datagram_.data() + header_size, histogram.buckets,
+           sizeof(histogram.buckets));
+    SendDatagram(telemetry::kProbePacket,
+                 sizeof(record) + sizeof(histogram.buckets));
+  }
+}
+
+void TelemetrySender::SendDatagram(telemetry::PacketType type,
+                                   size_t payload_size) {
+  telemetry::PacketHeader header;
+  header.magic = telemetry::kMagic;
+  header.version = telemetry::kVersion;
+  header.type = type;
+  header.sequence = sequence_++;
+  header.reserved = 0;
+  memcpy(datagram_.data(), &header, sizeof(header));
+
+  const size_t size = sizeof(header) + payload_size;
+  if (send(socket_, datagram_.data(), size, 0) != static_cast<ssize_t>(size)) {
+    failed_packet_count_.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  sent_packet_count_.fetch_add(1, std::memory_order_relaxed);
+  sent_byte_count_.fetch_add(size, std::memory_order_relaxed);
+}
+
+}  // namespace tango_gl
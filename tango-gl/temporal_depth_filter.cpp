@@ -0,0 +1,216 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "tango-gl/temporal_depth_filter.h"
+
+#include <algorithm>
+
+#include "tango-gl/cpu_features.h"
+
+namespace {
+// Fuse pixels [begin, end). Also the tail of the NEON kernel.
+void FuseTemporalDepthsScalar(
+    const float* measured_depths, size_t begin, size_t end,
+    const tango_gl::TemporalDepthFilter::Options& options,
+    tango_gl::internal::TemporalDepthState* state) {
+  const float threshold2 =
+      options.outlier_threshold * options.outlier_threshold;
+  for (size_t i = begin; i < end; ++i) {
+    const float measured_depth = measured_depths[i];
+    float mean = state->means[i];
+    float variance = state->variances[i];
+    float weight = state->weights[i];
+
+    if (measured_depth > 0.0f) {
+      const float sigma =
+          options.noise_coefficient * measured_depth * measured_depth;
+      const float noise = sigma * sigma;
+      const float difference = measured_depth - mean;
+      if (weight > 0.0f &&
+          difference * difference <= threshold2 * (variance + noise)) {
+        weight = std::min(weight + 1.0f, options.max_weight);
+        const float alpha = 1.0f / weight;
+        mean += alpha * difference;
+        variance = std::max(
+            (1.0f - alpha) * (variance + alpha * difference * difference),
+            tango_gl::internal::kTemporalDepthMinVariance);
+      } else {
+        mean = measured_depth;
+        variance = noise;
+        weight = 1.0f;
+      }
+    } else if (weight > 0.0f) {
+      weight -= 1.0f;
+    }
+
+    state->means[i] = mean;
+    state->variances[i] = variance;
+    state->weights[i] = weight;
+    if (weight > 0.0f) {
+      const float sigma = options.noise_coefficient * mean * mean;
+      const float noise = sigma * sigma;
+      state->depths[i] = mean;
+      state->confidences[i] =
+          weight / options.max_weight * (noise / (noise + variance));
+    } else {
+      state->depths[i] = 0.0f;
+      state->confidences[i] = 0.0f;
+    }
+  }
+}
+
+// Whether a transform leaves every point where it was.
+bool IsIdentity(const glm::mat4& transform) {
+  return transform == glm::mat4(1.0f);
+}
+}  // namespace
+
+namespace tango_gl {
+
+namespace internal {
+void FuseTemporalDepths(const float* measured_depths, size_t count,
+                        const TemporalDepthFilter::Options& options,
+                        TemporalDepthState* state) {
+  size_t begin = 0;
+#if defined(TANGO_GL_HAS_NEON)
+  if (cpu_features::IsNeonAvailable()) {
+    begin = count & ~static_cast<size_t>(3);
+    FuseTemporalDepthsNeon(measured_depths, count, options, state);
+  }
+#endif
+  FuseTemporalDepthsScalar(measured_depths, begin, count, options, state);
+}
+}  // namespace internal
+
+TemporalDepthFilter::TemporalDepthFilter(const Options& options)
+    : options_(options), world_T_previous_(1.0f), has_previous_(false) {
+  options_.max_weight = std::max(options_.max_weight, 1.0f);
+  intrinsics_.width = 0;
+  intrinsics_.height = 0;
+  intrinsics_.fx = 0.0f;
+  intrinsics_.fy = 0.0f;
+  intrinsics_.cx = 0.0f;
+  intrinsics_.cy = 0.0f;
+}
+
+void TemporalDepthFilter::Reset() {
+  std::fill(weights_.begin(), weights_.end(), 0.0f);
+  std::fill(depths_.begin(), depths_.end(), 0.0f);
+  std::fill(confidences_.begin(), confidences_.end(), 0.0f);
+  has_previous_ = false;
+}
+
+size_t TemporalDepthFilter::Update(
+    const float* depths, const projection::CameraIntrinsics& intrinsics,
+    const glm::mat4& world_T_camera) {
+  const size_t pixel_count =
+      static_cast<size_t>(intrinsics.width) * intrinsics.height;
+  if (intrinsics.width != intrinsics_.width ||
+      intrinsics.height != intrinsics_.height) {
+    means_.assign(pixel_count, 0.0f);
+    variances_.assign(pixel_count, 0.0f);
+    weights_.assign(pixel_count, 0.0f);
+    depths_.assign(pixel_count, 0.0f);
+    confidences_.assign(pixel_count, 0.0f);
+    has_previous_ = false;
+  }
+  intrinsics_ = intrinsics;
+  if (!ray_table_.IsBuiltFor(intrinsics, 0.5f)) {
+    ray_table_.Build(intrinsics, 0.5f);
+  }
+
+  if (has_previous_) {
+    const glm::mat4 current_T_previous =
+        glm::inverse(world_T_camera) * world_T_previous_;
+    if (!IsIdentity(current_T_previous)) {
+      WarpState(current_T_previous);
+    }
+  }
+  world_T_previous_ = world_T_camera;
+  has_previous_ = true;
+
+  internal::TemporalDepthState state;
+  state.means = means_.data();
+  state.variances = variances_.data();
+  state.weights = weights_.data();
+  state.depths = depths_.data();
+  state.confidences = confidences_.data();
+  internal::FuseTemporalDepths(depths, pixel_count, options_, &state);
+
+  return pixel_count -
+         std::count(depths_.begin(), depths_.end(), 0.0f);
+}
+
+size_t TemporalDepthFilter::Update(const RangeImage& image,
+                                   const glm::mat4& world_T_camera) {
+  return Update(image.GetDepths(), image.GetIntrinsics(), world_T_camera);
+}
+
+void TemporalDepthFilter::WarpState(const glm::mat4& current_T_previous) {
+  const projection::CameraIntrinsics& in = intrinsics_;
+  const size_t pixel_count = means_.size();
+  warped_means_.assign(pixel_count, 0.0f);
+  warped_variances_.assign(pixel_count, 0.0f);
+  warped_weights_.assign(pixel_count, 0.0f);
+
+  const glm::mat3 rotation(current_T_previous);
+  const glm::vec3 translation(current_T_previous[3]);
+  const float width = static_cast<float>(in.width);
+  const float height = static_cast<float>(in.height);
+  const float* column_rays = ray_table_.GetColumnRays();
+  const float* row_rays = ray_table_.GetRowRays();
+  for (int y = 0; y < in.height; ++y) {
+    const float ray_y = row_rays[y];
+    for (int x = 0; x < in.width; ++x) {
+      const size_t index = static_cast<size_t>(y) * in.width + x;
+      const float weight = weights_[index];
+      if (!(weight > 0.0f)) {
+        continue;
+      }
+      const float mean = means_[index];
+      const glm::vec3 point =
+          rotation * glm::vec3(column_rays[x] * mean, ray_y * mean, mean) +
+          translation;
+      if (!(point.z > 0.0f)) {
+        continue;
+      }
+      // Compared as floats so far away pixels never overflow the int cast.
+      const float inverse_depth = 1.0f / point.z;
+      const float pixel_x = in.fx * point.x * inverse_depth + in.cx;
+      const float pixel_y = in.fy * point.y * inverse_depth + in.cy;
+      if (!(pixel_x >= 0.0f && pixel_x < width && pixel_y >= 0.0f &&
+            pixel_y < height)) {
+        continue;
+      }
+      const size_t target = static_cast<size_t>(pixel_y) * in.width +
+                            static_cast<size_t>(pixel_x);
+      // The nearest surface wins, like in the depth image.
+      if (warped_weights_[target] > 0.0f &&
+          warped_means_[target] <= point.z) {
+        continue;
+      }
+      warped_means_[target] = point.z;
+      warped_variances_[target] = variances_[index];
+      warped_weights_[target] = weight;
+    }
+  }
+  means_.swap(warped_means_);
+  variances_.swap(warped_variances_);
+  weights_.swap(warped_weights_);
+}
+
+}  // namespace tango_gl
@@ -0,0 +1,112 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// This file is only compiled with NEON enabled (the ".neon" suffix in
+// Android.mk), the kernel is selected at runtime by
+// temporal_depth_filter.cpp.
+
+#include <arm_neon.h>
+
+#include "tango-gl/temporal_depth_filter.h"
+
+namespace {
+// Reciprocal of positive values, two Newton steps refine the estimate to
+// about float precision.
+inline float32x4_t Reciprocal(const float32x4_t& value) {
+  float32x4_t inverse = vrecpeq_f32(value);
+  inverse = vmulq_f32(vrecpsq_f32(value, inverse), inverse);
+  return vmulq_f32(vrecpsq_f32(value, inverse), inverse);
+}
+
+// Expected variance of the sensor at a depth.
+inline float32x4_t Noise(const float32x4_t& depth,
+                         const float32x4_t& coefficient) {
+  const float32x4_t sigma = vmulq_f32(vmulq_f32(depth, depth), coefficient);
+  return vmulq_f32(sigma, sigma);
+}
+}  // namespace
+
+namespace tango_gl {
+namespace internal {
+
+void FuseTemporalDepthsNeon(const float* measured_depths, size_t count,
+                            const TemporalDepthFilter::Options& options,
+                            TemporalDepthState* state) {
+  const float32x4_t zero = vdupq_n_f32(0.0f);
+  const float32x4_t one = vdupq_n_f32(1.0f);
+  const float32x4_t weight_limit = vdupq_n_f32(options.max_weight);
+  const float32x4_t inverse_weight_limit =
+      vdupq_n_f32(1.0f / options.max_weight);
+  const float32x4_t coefficient = vdupq_n_f32(options.noise_coefficient);
+  const float32x4_t min_variance = vdupq_n_f32(kTemporalDepthMinVariance);
+  const float32x4_t threshold2 =
+      vdupq_n_f32(options.outlier_threshold * options.outlier_threshold);
+
+  const size_t vector_count = count & ~static_cast<size_t>(3);
+  for (size_t i = 0; i < vector_count; i += 4) {
+    const float32x4_t measured_depth = vld1q_f32(measured_depths + i);
+    const float32x4_t mean = vld1q_f32(state->means + i);
+    const float32x4_t variance = vld1q_f32(state->variances + i);
+    const float32x4_t weight = vld1q_f32(state->weights + i);
+
+    const uint32x4_t is_measured = vcgtq_f32(measured_depth, zero);
+    const uint32x4_t has_history = vcgtq_f32(weight, zero);
+    const float32x4_t noise = Noise(measured_depth, coefficient);
+    const float32x4_t difference = vsubq_f32(measured_depth, mean);
+    const float32x4_t difference2 = vmulq_f32(difference, difference);
+    // Same test as the scalar loop, a measured depth close to the mean of a
+    // pixel with history updates it, any other measured depth restarts it.
+    const uint32x4_t is_inlier = vandq_u32(
+        has_history,
+        vcleq_f32(difference2,
+                  vmulq_f32(threshold2, vaddq_f32(variance, noise))));
+
+    const float32x4_t next_weight =
+        vminq_f32(vaddq_f32(weight, one), weight_limit);
+    const float32x4_t alpha = Reciprocal(next_weight);
+    const float32x4_t next_mean = vmlaq_f32(mean, alpha, difference);
+    const float32x4_t next_variance = vmaxq_f32(
+        vmulq_f32(vsubq_f32(one, alpha),
+                  vmlaq_f32(variance, alpha, difference2)),
+        min_variance);
+
+    // Fused, restarted, decayed, or untouched without history.
+    const float32x4_t decayed_weight =
+        vbslq_f32(has_history, vsubq_f32(weight, one), weight);
+    const float32x4_t new_weight = vbslq_f32(
+        is_measured, vbslq_f32(is_inlier, next_weight, one), decayed_weight);
+    const float32x4_t new_mean = vbslq_f32(
+        is_measured, vbslq_f32(is_inlier, next_mean, measured_depth), mean);
+    const float32x4_t new_variance = vbslq_f32(
+        is_measured, vbslq_f32(is_inlier, next_variance, noise), variance);
+    vst1q_f32(state->means + i, new_mean);
+    vst1q_f32(state->variances + i, new_variance);
+    vst1q_f32(state->weights + i, new_weight);
+
+    // Lanes without a mean are masked out, whatever their division gave.
+    const uint32x4_t is_valid = vcgtq_f32(new_weight, zero);
+    const float32x4_t mean_noise = Noise(new_mean, coefficient);
+    const float32x4_t confidence = vmulq_f32(
+        vmulq_f32(new_weight, inverse_weight_limit),
+        vmulq_f32(mean_noise, Reciprocal(vaddq_f32(mean_noise, new_variance))));
+    vst1q_f32(state->depths + i, vbslq_f32(is_valid, new_mean, zero));
+    vst1q_f32(state->confidences + i, vbslq_f32(is_valid, confidence, zero));
+  }
+}
+
+}  // namespace internal
+}  // namespace tango_gl
@@ -0,0 +1,277 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+#include <algorithm>
+
+#include "tango-gl/counters.h"
+#include "tango-gl/memory_tracker.h"
+#include "tango-gl/program_cache.h"
+#include "tango-gl/render_state.h"
+#include "tango-gl/shaders.h"
+#include "tango-gl/text_overlay.h"
+
+namespace {
+const int kAtlasWidth = 512;
+// Empty pixels around each glyph, so linear filtering never bleeds in a
+// neighbour.
+const int kGlyphPadding = 1;
+const int kFloatsPerVertex = 4;
+}  // namespace
+
+namespace tango_gl {
+
+const char TextOverlay::kDefaultFontPath[] = "/system/fonts/DroidSansMono.ttf";
+
+TextOverlay::TextOverlay()
+    : line_height_(0.0f),
+      ascender_(0.0f),
+      atlas_texture_(0),
+      shader_program_(0),
+      attrib_vertices_(-1),
+      attrib_texture_coords_(-1),
+      uniform_glyphs_(-1),
+      uniform_color_(-1),
+      uniform_pixel_to_ndc_(-1),
+      red_(1.0f),
+      green_(1.0f),
+      blue_(1.0f),
+      alpha_(1.0f),
+      vertex_buffer_(GL_ARRAY_BUFFER, GL_DYNAMIC_DRAW) {
+  memset(glyphs_, 0, sizeof(glyphs_));
+}
+
+TextOverlay::~TextOverlay() { Release(); }
+
+bool TextOverlay::Initialize(const char* font_path, int pixel_size) {
+  Release();
+
+  FT_Library library;
+  if (FT_Init_FreeType(&library) != 0) {
+    LOGE("TextOverlay: failed to initialize FreeType.");
+    return false;
+  }
+  FT_Face face;
+  if (FT_New_Face(library, font_path, 0, &face) != 0) {
+    LOGE("TextOverlay: failed to load font %s", font_path);
+    FT_Done_FreeType(library);
+    return false;
+  }
+  FT_Set_Pixel_Sizes(face, 0, pixel_size);
+  line_height_ = face->size->metrics.height / 64.0f;
+  ascender_ = face->size->metrics.ascender / 64.0f;
+
+  // Pack the glyphs in rows, growing the atlas height as needed.
+  std::vector<uint8_t> atlas;
+  int pen_x = 0;
+  int pen_y = 0;
+  int row_height = 0;
+  for (char c = kFirstGlyph; c <= kLastGlyph; ++c) {
+    Glyph& glyph = glyphs_[c - kFirstGlyph];
+    if (FT_Load_Char(face, c, FT_LOAD_RENDER) != 0) {
+      continue;
+    }
+    const FT_GlyphSlot slot = face->glyph;
+    const int width = slot->bitmap.width;
+    const int height = slot->bitmap.rows;
+    if (pen_x + width + kGlyphPadding > kAtlasWidth) {
+      pen_x = 0;
+      pen_y += row_height + kGlyphPadding;
+      row_height = 0;
+    }
+    const int x = pen_x + kGlyphPadding;
+    const int y = pen_y + kGlyphPadding;
+    atlas.resize(std::max<size_t>(atlas.size(),
+                                  (y + height + kGlyphPadding) * kAtlasWidth));
+    for (int row = 0; row < height; ++row) {
+      memcpy(&atlas[(y + row) * kAtlasWidth + x],
+             slot->bitmap.buffer + row * slot->bitmap.pitch, width);
+    }
+
+    glyph.left = slot->bitmap_left;
+    glyph.top = -slot->bitmap_top;
+    glyph.width = width;
+    glyph.height = height;
+    glyph.advance = slot->advance.x / 64.0f;
+    glyph.u0 = x;
+    glyph.v0 = y;
+    glyph.u1 = x + width;
+    glyph.v1 = y + height;
+    pen_x = x + width;
+    row_height = std::max(row_height, height + kGlyphPadding);
+  }
+  FT_Done_Face(face);
+  FT_Done_FreeType(library);
+
+  // Round the height up to a power of two for GLES2 filtering.
+  int atlas_height = 1;
+  while (atlas_height * kAtlasWidth < static_cast<int>(atlas.size())) {
+    atlas_height <<= 1;
+  }
+  atlas.resize(atlas_height * kAtlasWidth);
+  for (Glyph& glyph : glyphs_) {
+    glyph.u0 /= kAtlasWidth;
+    glyph.u1 /= kAtlasWidth;
+    glyph.v0 /= atlas_height;
+    glyph.v1 /= atlas_height;
+  }
+
+  glGenTextures(1, &atlas_texture_);
+  RenderState::BindTexture(GL_TEXTURE_2D, atlas_texture_);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_ALPHA, kAtlasWidth, atlas_height, 0,
+               GL_ALPHA, GL_UNSIGNED_BYTE, atlas.data());
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+  util::CheckGlError("TextOverlay::Initialize");
+  MemoryTracker::Track(MemoryTracker::kTexture, atlas_texture_, "TextOverlay",
+                       atlas.size());
+
+  shader_program_ =
+      program_cache::AcquireProgram(shaders::GetTextVertexShader().c_str(),
+                                    shaders::GetTextFragmentShader().c_str());
+  if (!shader_program_) {
+    LOGE("Could not create program.");
+    return false;
+  }
+  attrib_vertices_ = glGetAttribLocation(shader_program_, "vertex");
+  attrib_texture_coords_ =
+      glGetAttribLocation(shader_program_, "textureCoords");
+  uniform_glyphs_ = glGetUniformLocation(shader_program_, "glyphs");
+  uniform_color_ = glGetUniformLocation(shader_program_, "color");
+  uniform_pixel_to_ndc_ =
+      glGetUniformLocation(shader_program_, "pixel_to_ndc");
+  return true;
+}
+
+void TextOverlay::Release() {
+  if (atlas_texture_ != 0) {
+    RenderState::DeleteTextures(1, &atlas_texture_);
+  }
+  program_cache::ReleaseProgram(shader_program_);
+  vertex_buffer_.Release();
+  uploaded_vertices_.clear();
+  atlas_texture_ = 0;
+  shader_program_ = 0;
+}
+
+void TextOverlay::Invalidate() {
+  vertex_buffer_.Invalidate();
+  uploaded_vertices_.clear();
+  atlas_texture_ = 0;
+  shader_program_ = 0;
+}
+
+void TextOverlay::SetColor(float red, float green, float blue, float alpha) {
+  red_ = red;
+  green_ = green;
+  blue_ = blue;
+  alpha_ = alpha;
+}
+
+void TextOverlay::AddText(const std::string& text, float x, float y) {
+  float pen_x = x;
+  float baseline = y + ascender_;
+  for (char c : text) {
+    if (c == '\n') {
+      pen_x = x;
+      baseline += line_height_;
+      continue;
+    }
+    if (c < kFirstGlyph || c > kLastGlyph) {
+      continue;
+    }
+    const Glyph& glyph = glyphs_[c - kFirstGlyph];
+    const float x0 = pen_x + glyph.left;
+    const float x1 = x0 + glyph.width;
+    const float y0 = baseline + glyph.top;
+    const float y1 = y0 + glyph.height;
+    const GLfloat quad[] = {x0, y0, glyph.u0, glyph.v0,
+                            x0, y1, glyph.u0, glyph.v1,
+                            x1, y0, glyph.u1, glyph.v0,
+                            x1, y0, glyph.u1, glyph.v0,
+                            x0, y1, glyph.u0, glyph.v1,
+                            x1, y1, glyph.u1, glyph.v1};
+    vertices_.insert(vertices_.end(), quad,
+                     quad + sizeof(quad) / sizeof(quad[0]));
+    pen_x += glyph.advance;
+  }
+}
+
+void TextOverlay::Draw(int viewport_width, int viewport_height) {
+  if (atlas_texture_ == 0 || shader_program_ == 0 || viewport_width <= 0 ||
+      viewport_height <= 0 || vertices_.empty()) {
+    vertices_.clear();
+    return;
+  }
+
+  // Only the vertices from the first changed one on are uploaded.
+  size_t dirty_count = std::min(vertices_.size(), uploaded_vertices_.size());
+  dirty_count = std::mismatch(vertices_.begin(),
+                              vertices_.begin() + dirty_count,
+                              uploaded_vertices_.begin()).first -
+                vertices_.begin();
+  if (dirty_count < vertices_.size() ||
+      vertices_.size() != uploaded_vertices_.size()) {
+    vertex_buffer_.Update(vertices_.data(), vertices_.size() * sizeof(GLfloat),
+                          dirty_count * sizeof(GLfloat));
+    uploaded_vertices_.swap(vertices_);
+  }
+  vertices_.clear();
+
+  RenderState::UseProgram(shader_program_);
+  RenderState::ActiveTexture(GL_TEXTURE0);
+  RenderState::BindTexture(GL_TEXTURE_2D, atlas_texture_);
+  glUniform1i(uniform_glyphs_, 0);
+  glUniform4f(uniform_color_, red_, green_, blue_, alpha_);
+  // Pixels to normalized device coordinates, y pointing down.
+  glUniform2f(uniform_pixel_to_ndc_, 2.0f / viewport_width,
+              -2.0f / viewport_height);
+  RenderState::Enable(GL_BLEND);
+  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+  RenderState::Disable(GL_DEPTH_TEST);
+
+  const GLsizei stride = kFloatsPerVertex * sizeof(GLfloat);
+  vertex_buffer_.Bind();
+  glEnableVertexAttribArray(attrib_vertices_);
+  glVertexAttribPointer(attrib_vertices_, 2, GL_FLOAT, GL_FALSE, stride,
+                        nullptr);
+  glEnableVertexAttribArray(attrib_texture_coords_);
+  glVertexAttribPointer(attrib_texture_coords_, 2, GL_FLOAT, GL_FALSE, stride,
+                        reinterpret_cast<const GLvoid*>(2 * sizeof(GLfloat)));
+  Counters::Increment(Counters::kDrawCalls);
+  glDrawArrays(GL_TRIANGLES, 0,
+               uploaded_vertices_.size() / kFloatsPerVertex);
+  glDisableVertexAttribArray(attrib_vertices_);
+  glDisableVertexAttribArray(attrib_texture_coords_);
+
+  RenderState::Disable(GL_BLEND);
+  util::CheckGlError("TextOverlay::Draw");
+}
+
+void TextOverlay::Render(const std::string& text, float x, float y,
+                         int viewport_width, int viewport_height) {
+  AddText(text, x, y);
+  Draw(viewport_width, viewport_height);
+}
+
+}  // namespace tango_gl
@@ -13,95 +13,561 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
+#include <EGL/egl.h>
+#include <setjmp.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <algorithm>
+#include <string>
+
+#include "tango-gl/counters.h"
+#include "tango-gl/render_state.h"
 #include "tango-gl/texture.h"
 #include "tango-gl/util.h"
 
-namespace tango_gl {
+namespace {
+// OpenGL ES 3 ETC2 formats, not in the GLES2 headers.
+const GLenum kCompressedRgb8Etc2 = 0x9274;
+const GLenum kCompressedRgb8PunchthroughAlpha1Etc2 = 0x9276;
+const GLenum kCompressedRgba8Etc2Eac = 0x9278;
 
-static const int kMaxExponentiation = 12;
+const uint8_t kKtxIdentifier[12] = {0xAB, 0x4B, 0x54, 0x58, 0x20, 0x31,
+                                    0x31, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A};
+const uint32_t kKtxEndianness = 0x04030201;
 
-static int RoundUpPowerOfTwo(int w) {
-  int start = 2;
-  for (int i = 0; i <= MAX_EXPONENTIATION; ++i) {
-    if (w < start) {
-      w = start;
-      break;
-    } else {
-      start = start << 1;
+struct KtxHeader {
+  uint8_t identifier[12];
+  uint32_t endianness;
+  uint32_t gl_type;
+  uint32_t gl_type_size;
+  uint32_t gl_format;
+  uint32_t gl_internal_format;
+  uint32_t gl_base_internal_format;
+  uint32_t pixel_width;
+  uint32_t pixel_height;
+  uint32_t pixel_depth;
+  uint32_t number_of_array_elements;
+  uint32_t number_of_faces;
+  uint32_t number_of_mipmap_levels;
+  uint32_t bytes_of_key_value_data;
+};
+
+// PKM header, 16 bit fields are big endian.
+const size_t kPkmHeaderSize = 16;
+const uint16_t kPkmEtc1Rgb = 0;
+const uint16_t kPkmEtc2Rgb = 1;
+const uint16_t kPkmEtc2Rgba = 3;
+const uint16_t kPkmEtc2RgbA1 = 4;
+
+// Shared placeholder, owned by the GL context it was created in.
+EGLContext g_placeholder_context = EGL_NO_CONTEXT;
+GLuint g_placeholder_texture = 0;
+
+png_uint_32 RoundUpPowerOfTwo(png_uint_32 value) {
+  png_uint_32 power = 1;
+  while (power < value) {
+    power <<= 1;
+  }
+  return power;
+}
+
+bool IsPowerOfTwo(png_uint_32 value) { return (value & (value - 1)) == 0; }
+
+bool HasNpotSupport() {
+  const char* version = reinterpret_cast<const char*>(glGetString(GL_VERSION));
+  const char* extensions =
+      reinterpret_cast<const char*>(glGetString(GL_EXTENSIONS));
+  return (version != nullptr && strncmp(version, "OpenGL ES 3", 11) == 0) ||
+         (extensions != nullptr &&
+          strstr(extensions, "GL_OES_texture_npot") != nullptr);
+}
+
+// Set the wrap and filter modes of an image on the bound GL_TEXTURE_2D.
+//
+// @return whether the mip levels are generated after the upload.
+bool SetSamplingParameters(const tango_gl::Texture::Image& image) {
+  // Compressed textures keep their size, and so do PNG images on contexts
+  // with non power of two support. Plain OpenGL ES 2 only repeats and
+  // mipmaps power of two textures.
+  const bool is_power_of_two =
+      IsPowerOfTwo(image.width) && IsPowerOfTwo(image.height);
+  const bool has_npot = is_power_of_two || HasNpotSupport();
+  const GLint wrap = has_npot ? GL_REPEAT : GL_CLAMP_TO_EDGE;
+  const bool generates_mipmaps = !image.is_compressed && has_npot;
+  const bool has_mipmaps =
+      generates_mipmaps ||
+      (image.is_compressed && image.level_sizes.size() > 1);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrap);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrap);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+                  has_mipmaps ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  return generates_mipmaps;
+}
+
+// GPU memory of the texture of an image.
+size_t GetStorageSize(const tango_gl::Texture::Image& image,
+                      bool generates_mipmaps) {
+  size_t size_in_bytes = 0;
+  if (image.is_compressed) {
+    for (size_t level_size : image.level_sizes) {
+      size_in_bytes += level_size;
+    }
+  } else {
+    size_in_bytes = tango_gl::MemoryTracker::GetTextureSize(
+        image.width, image.height, image.format, GL_UNSIGNED_BYTE);
+    if (generates_mipmaps) {
+      // The mip levels add a third.
+      size_in_bytes += size_in_bytes / 3;
     }
   }
-  return w;
+  return size_in_bytes;
+}
+
+GLuint GetPlaceholderTexture() {
+  EGLContext context = eglGetCurrentContext();
+  if (context != g_placeholder_context) {
+    // The previous placeholder went away with its context.
+    g_placeholder_context = context;
+    g_placeholder_texture = 0;
+  }
+  if (g_placeholder_texture == 0) {
+    const GLubyte kWhite[4] = {255, 255, 255, 255};
+    glGenTextures(1, &g_placeholder_texture);
+    tango_gl::RenderState::BindTexture(GL_TEXTURE_2D, g_placeholder_texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA,
+                 GL_UNSIGNED_BYTE, kWhite);
+    tango_gl::util::CheckGlError("Texture placeholder");
+    tango_gl::MemoryTracker::Track(tango_gl::MemoryTracker::kTexture,
+                                   g_placeholder_texture, "Texture",
+                                   sizeof(kWhite));
+  }
+  return g_placeholder_texture;
+}
+
+bool ReadWholeFile(const char* file_path, std::vector<uint8_t>* contents) {
+  FILE* file = fopen(file_path, "rb");
+  if (file == NULL) {
+    return false;
+  }
+  fseek(file, 0, SEEK_END);
+  long size = ftell(file);
+  fseek(file, 0, SEEK_SET);
+  bool is_read = size >= 0;
+  if (is_read) {
+    contents->resize(size);
+    is_read = fread(contents->data(), 1, size, file) ==
+              static_cast<size_t>(size);
+  }
+  fclose(file);
+  return is_read;
+}
+
+uint16_t ReadBigEndian16(const uint8_t* data) {
+  return static_cast<uint16_t>((data[0] << 8) | data[1]);
+}
+
+// Parse a KTX 1.1 container holding a single compressed 2D texture.
+bool ParseKTX(const std::vector<uint8_t>& contents,
+              tango_gl::Texture::Image* image) {
+  KtxHeader header;
+  if (contents.size() < sizeof(header)) {
+    return false;
+  }
+  memcpy(&header, contents.data(), sizeof(header));
+  if (header.endianness != kKtxEndianness) {
+    LOGE("Texture: byte swapped KTX files are not supported");
+    return false;
+  }
+  if (header.gl_type != 0 || header.pixel_depth > 1 ||
+      header.number_of_array_elements > 0 || header.number_of_faces != 1) {
+    LOGE("Texture: only compressed 2D KTX textures are supported");
+    return false;
+  }
+
+  image->width = header.pixel_width;
+  image->height = header.pixel_height;
+  image->format = header.gl_internal_format;
+  image->is_compressed = true;
+  image->pixels.clear();
+  image->level_sizes.clear();
+  const uint32_t level_count = std::max(1u, header.number_of_mipmap_levels);
+  size_t offset = sizeof(header) + header.bytes_of_key_value_data;
+  for (uint32_t level = 0; level < level_count; ++level) {
+    uint32_t image_size;
+    if (offset + sizeof(image_size) > contents.size()) {
+      return false;
+    }
+    memcpy(&image_size, contents.data() + offset, sizeof(image_size));
+    offset += sizeof(image_size);
+    if (offset + image_size > contents.size()) {
+      return false;
+    }
+    image->pixels.insert(image->pixels.end(), contents.begin() + offset,
+                         contents.begin() + offset + image_size);
+    image->level_sizes.push_back(image_size);
+    // Levels are padded to 4 bytes.
+    offset += (image_size + 3) & ~3u;
+  }
+  return true;
+}
+
+// Parse a PKM file, a single ETC1 or ETC2 level.
+bool ParsePKM(const std::vector<uint8_t>& contents,
+              tango_gl::Texture::Image* image) {
+  if (contents.size() < kPkmHeaderSize) {
+    return false;
+  }
+  const uint8_t* header = contents.data();
+  const uint16_t data_type = ReadBigEndian16(header + 6);
+  const uint16_t extended_width = ReadBigEndian16(header + 8);
+  const uint16_t extended_height = ReadBigEndian16(header + 10);
+  size_t block_size = 8;
+  switch (data_type) {
+    case kPkmEtc1Rgb:
+      image->format = GL_ETC1_RGB8_OES;
+      break;
+    case kPkmEtc2Rgb:
+      image->format = kCompressedRgb8Etc2;
+      break;
+    case kPkmEtc2RgbA1:
+      image->format = kCompressedRgb8PunchthroughAlpha1Etc2;
+      break;
+    case kPkmEtc2Rgba:
+      image->format = kCompressedRgba8Etc2Eac;
+      block_size = 16;
+      break;
+    default:
+      LOGE("Texture: unsupported PKM data type %d", data_type);
+      return false;
+  }
+  const size_t data_size =
+      (extended_width / 4) * (extended_height / 4) * block_size;
+  if (kPkmHeaderSize + data_size > contents.size()) {
+    return false;
+  }
+  image->width = ReadBigEndian16(header + 12);
+  image->height = ReadBigEndian16(header + 14);
+  image->is_compressed = true;
+  image->pixels.assign(contents.begin() + kPkmHeaderSize,
+                       contents.begin() + kPkmHeaderSize + data_size);
+  image->level_sizes.assign(1, data_size);
+  return true;
+}
+
+// The PNG file used when a compressed file can not be used.
+std::string GetFallbackPath(const char* file_path) {
+  std::string path(file_path);
+  size_t slash = path.find_last_of('/');
+  size_t dot = path.find_last_of('.');
+  if (dot != std::string::npos && (slash == std::string::npos || dot > slash)) {
+    path.erase(dot);
+  }
+  return path + ".png";
+}
+
+// Reads the image rows, separate from DecodePNG() so no object with a
+// destructor lives across the setjmp().
+bool ReadImage(png_structp png_ptr, png_infop info_ptr, FILE* file,
+               bool pad_to_power_of_two, tango_gl::Texture::Image* image,
+               std::vector<png_bytep>* row_pointers) {
+  if (setjmp(png_jmpbuf(png_ptr))) {
+    return false;
+  }
+  png_init_io(png_ptr, file);
+  png_set_sig_bytes(png_ptr, 8);
+  png_read_info(png_ptr, info_ptr);
+
+  png_uint_32 width, height;
+  int bit_depth, color_type;
+  png_get_IHDR(png_ptr, info_ptr, &width, &height, &bit_depth, &color_type,
+               NULL, NULL, NULL);
+  image->width = pad_to_power_of_two ? RoundUpPowerOfTwo(width) : width;
+  image->height = pad_to_power_of_two ? RoundUpPowerOfTwo(height) : height;
+  image->format = color_type == PNG_COLOR_TYPE_RGBA ? GL_RGBA : GL_RGB;
+  image->is_compressed = false;
+  image->level_sizes.clear();
+
+  const size_t row = image->GetRowSize();
+  image->pixels.assign(row * image->height, 0);
+  row_pointers->resize(height);
+  for (png_uint_32 i = 0; i < height; ++i) {
+    (*row_pointers)[i] = image->pixels.data() + i * row;
+  }
+  png_read_image(png_ptr, row_pointers->data());
+  return true;
 }
+}  // namespace
+
+namespace tango_gl {
 
-Texture::Texture(const char* file_path) {
+Texture::Texture()
+    : width_(0),
+      height_(0),
+      texture_id_(0),
+      is_loaded_(false),
+      is_evicted_(false),
+      generates_mipmaps_(false) {}
+
+Texture::Texture(const char* file_path)
+    : width_(0),
+      height_(0),
+      texture_id_(0),
+      is_loaded_(false),
+      is_evicted_(false),
+      generates_mipmaps_(false) {
   if (!LoadFromPNG(file_path)) {
     LOGE("Texture initialing error");
   }
 }
 
-bool Texture::LoadFromPNG(const char* file_path) {
+bool Texture::DecodePNG(const char* file_path, bool pad_to_power_of_two,
+                        Image* image) {
   FILE* file = fopen(file_path, "rb");
-
   if (file == NULL) {
     LOGE("fp not loaded: %s", strerror(errno));
     return false;
   }
 
-  fseek(file, 8, SEEK_CUR);
+  png_byte signature[8];
+  if (fread(signature, 1, sizeof(signature), file) != sizeof(signature) ||
+      png_sig_cmp(signature, 0, sizeof(signature)) != 0) {
+    LOGE("Texture: %s is not a PNG file", file_path);
+    fclose(file);
+    return false;
+  }
 
   png_structp png_ptr =
       png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
   png_infop info_ptr = png_create_info_struct(png_ptr);
+  std::vector<png_bytep> row_pointers;
+  bool is_decoded = png_ptr != NULL && info_ptr != NULL &&
+                    ReadImage(png_ptr, info_ptr, file, pad_to_power_of_two,
+                              image, &row_pointers);
+  png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
+  fclose(file);
+  if (!is_decoded) {
+    LOGE("Texture: failed to decode %s", file_path);
+  }
+  return is_decoded;
+}
 
-  png_init_io(png_ptr, file);
-  png_set_sig_bytes(png_ptr, 8);
-  png_read_info(png_ptr, info_ptr);
-  png_get_IHDR(png_ptr, info_ptr, &width_, &height_, &bit_depth_, &color_type_,
-               NULL, NULL, NULL);
+bool Texture::DecodeFile(const char* file_path,
+                         const Capabilities& capabilities, Image* image) {
+  std::vector<uint8_t> contents;
+  if (!ReadWholeFile(file_path, &contents)) {
+    LOGE("fp not loaded: %s", strerror(errno));
+    return false;
+  }
 
-  width_ = RoundUpPowerOfTwo(width_);
-  height_ = RoundUpPowerOfTwo(height_);
-  int row = width_ * (color_type_ == PNG_COLOR_TYPE_RGBA ? 4 : 3);
-  byte_data_ = new char[row * height_];
+  bool is_parsed;
+  if (contents.size() >= sizeof(kKtxIdentifier) &&
+      memcmp(contents.data(), kKtxIdentifier, sizeof(kKtxIdentifier)) == 0) {
+    is_parsed = ParseKTX(contents, image);
+  } else if (contents.size() >= 4 && memcmp(contents.data(), "PKM ", 4) == 0) {
+    is_parsed = ParsePKM(contents, image);
+  } else {
+    return DecodePNG(file_path, !capabilities.has_npot, image);
+  }
 
-  png_bytep* row_pointers = new png_bytep[height_];
-  for (uint i = 0; i < height_; ++i) {
-    row_pointers[i] = (png_bytep)(byte_data_ + i * row);
+  const std::vector<GLenum>& formats = capabilities.compressed_formats;
+  if (is_parsed &&
+      std::find(formats.begin(), formats.end(), image->format) !=
+          formats.end()) {
+    return true;
   }
-  png_read_image(png_ptr, row_pointers);
-  png_destroy_read_struct(&png_ptr, &info_ptr, 0);
+  if (is_parsed) {
+    LOGE("Texture: format 0x%x of %s is not supported by the GPU",
+         image->format, file_path);
+  } else {
+    LOGE("Texture: failed to parse %s", file_path);
+  }
+  return DecodePNG(GetFallbackPath(file_path).c_str(), !capabilities.has_npot,
+                   image);
+}
 
-  glGenTextures(1, &texture_id_);
-  glBindTexture(GL_TEXTURE_2D, texture_id_);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-  util::CheckGlError("glBindTexture");
-  if (color_type_ == PNG_COLOR_TYPE_RGBA) {
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width_, height_, 0, GL_RGBA,
-                 GL_UNSIGNED_BYTE, byte_data_);
+Texture::Capabilities Texture::GetCapabilities() {
+  Capabilities capabilities;
+  GLint format_count = 0;
+  glGetIntegerv(GL_NUM_COMPRESSED_TEXTURE_FORMATS, &format_count);
+  std::vector<GLint> formats(format_count);
+  if (format_count > 0) {
+    glGetIntegerv(GL_COMPRESSED_TEXTURE_FORMATS, formats.data());
+  }
+  capabilities.compressed_formats.assign(formats.begin(), formats.end());
+  capabilities.has_npot = HasNpotSupport();
+  return capabilities;
+}
+
+bool Texture::LoadFromPNG(const char* file_path) {
+  Image image;
+  if (!DecodePNG(file_path, !HasNpotSupport(), &image)) {
+    return false;
+  }
+  file_path_ = file_path;
+  Allocate(image);
+  UploadRows(image, 0, image.height);
+  return true;
+}
+
+bool Texture::LoadFromFile(const char* file_path) {
+  Image image;
+  if (!DecodeFile(file_path, GetCapabilities(), &image)) {
+    return false;
+  }
+  file_path_ = file_path;
+  Allocate(image);
+  if (image.is_compressed) {
+    for (size_t level = 0; level < image.level_sizes.size(); ++level) {
+      UploadLevel(image, level);
+    }
+  } else {
+    UploadRows(image, 0, image.height);
+  }
+  return true;
+}
+
+void Texture::Allocate(const Image& image) {
+  if (texture_id_ == 0) {
+    glGenTextures(1, &texture_id_);
+  }
+  width_ = image.width;
+  height_ = image.height;
+  is_loaded_ = false;
+  RenderState::BindTexture(GL_TEXTURE_2D, texture_id_);
+  generates_mipmaps_ = SetSamplingParameters(image);
+  if (!image.is_compressed) {
+    glTexImage2D(GL_TEXTURE_2D, 0, image.format, width_, height_, 0,
+                 image.format, GL_UNSIGNED_BYTE, NULL);
+  }
+  util::CheckGlError("Texture::Allocate");
+  MemoryTracker::Track(MemoryTracker::kTexture, texture_id_, "Texture",
+                       GetStorageSize(image, generates_mipmaps_));
+  if (!file_path_.empty()) {
+    MemoryTracker::SetEvictable(MemoryTracker::kTexture, texture_id_, this);
+  }
+}
+
+void Texture::UploadLevel(const Image& image, size_t level) {
+  size_t offset = 0;
+  for (size_t i = 0; i < level; ++i) {
+    offset += image.level_sizes[i];
+  }
+  RenderState::BindTexture(GL_TEXTURE_2D, texture_id_);
+  glCompressedTexImage2D(GL_TEXTURE_2D, level, image.format,
+                         std::max<png_uint_32>(1, image.width >> level),
+                         std::max<png_uint_32>(1, image.height >> level), 0,
+                         image.level_sizes[level],
+                         image.pixels.data() + offset);
+  Counters::Add(Counters::kTextureBytes, image.level_sizes[level]);
+  util::CheckGlError("Texture::UploadLevel");
+  if (level + 1 >= image.level_sizes.size()) {
+    is_loaded_ = true;
+  }
+}
+
+void Texture::UploadRows(const Image& image, png_uint_32 first_row,
+                         png_uint_32 row_count) {
+  RenderState::BindTexture(GL_TEXTURE_2D, texture_id_);
+  // RGB rows are not necessarily 4 byte aligned.
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  glTexSubImage2D(GL_TEXTURE_2D, 0, 0, first_row, image.width, row_count,
+                  image.format, GL_UNSIGNED_BYTE,
+                  image.pixels.data() + first_row * image.GetRowSize());
+  Counters::Add(Counters::kTextureBytes,
+                static_cast<uint64_t>(row_count) * image.GetRowSize());
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+  if (first_row + row_count >= image.height) {
+    if (generates_mipmaps_) {
+      glGenerateMipmap(GL_TEXTURE_2D);
+    }
+    is_loaded_ = true;
+  }
+  util::CheckGlError("Texture::UploadRows");
+}
+
+GLuint Texture::CreateTexture(const Image& image) {
+  GLuint texture_id = 0;
+  glGenTextures(1, &texture_id);
+  glBindTexture(GL_TEXTURE_2D, texture_id);
+  const bool generates_mipmaps = SetSamplingParameters(image);
+  if (image.is_compressed) {
+    size_t offset = 0;
+    for (size_t level = 0; level < image.level_sizes.size(); ++level) {
+      glCompressedTexImage2D(
+          GL_TEXTURE_2D, level, image.format,
+          std::max<png_uint_32>(1, image.width >> level),
+          std::max<png_uint_32>(1, image.height >> level), 0,
+          image.level_sizes[level], image.pixels.data() + offset);
+      offset += image.level_sizes[level];
+    }
   } else {
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width_, height_, 0, GL_RGB,
-                 GL_UNSIGNED_BYTE, byte_data_);
+    // RGB rows are not necessarily 4 byte aligned.
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, image.format, image.width, image.height,
+                 0, image.format, GL_UNSIGNED_BYTE, image.pixels.data());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    if (generates_mipmaps) {
+      glGenerateMipmap(GL_TEXTURE_2D);
+    }
   }
-  util::CheckGlError("glTexImage2D");
   glBindTexture(GL_TEXTURE_2D, 0);
+  util::CheckGlError("Texture::CreateTexture");
+  return texture_id;
+}
 
-  fclose(file);
-  delete[] row_pointers;
-  delete[] byte_data_;
+void Texture::AdoptTexture(GLuint texture_id, const Image& image) {
+  if (texture_id_ != 0) {
+    RenderState::DeleteTextures(1, &texture_id_);
+  }
+  texture_id_ = texture_id;
+  width_ = image.width;
+  height_ = image.height;
+  generates_mipmaps_ = !image.is_compressed &&
+                       ((IsPowerOfTwo(width_) && IsPowerOfTwo(height_)) ||
+                        HasNpotSupport());
+  is_loaded_ = true;
+  is_evicted_ = false;
+  Counters::Add(Counters::kTextureBytes, image.pixels.size());
+  MemoryTracker::Track(MemoryTracker::kTexture, texture_id_, "Texture",
+                       GetStorageSize(image, generates_mipmaps_));
+  if (!file_path_.empty()) {
+    MemoryTracker::SetEvictable(MemoryTracker::kTexture, texture_id_, this);
+  }
+}
 
-  return true;
+GLuint Texture::GetTextureID() {
+  if (is_evicted_) {
+    is_evicted_ = false;
+    const std::string file_path = file_path_;
+    if (!LoadFromFile(file_path.c_str())) {
+      LOGE("Texture: failed to reload %s", file_path.c_str());
+    }
+  }
+  if (!is_loaded_) {
+    return GetPlaceholderTexture();
+  }
+  MemoryTracker::Touch(MemoryTracker::kTexture, texture_id_);
+  return texture_id_;
 }
 
-GLuint Texture::GetTextureID() const { return texture_id_; }
+void Texture::Evict() {
+  if (texture_id_ == 0) {
+    return;
+  }
+  RenderState::DeleteTextures(1, &texture_id_);
+  texture_id_ = 0;
+  is_loaded_ = false;
+  is_evicted_ = true;
+}
 
 Texture::~Texture() {
-  if (byte_data_ != NULL) {
-    delete[] byte_data_;
+  if (texture_id_ != 0) {
+    RenderState::DeleteTextures(1, &texture_id_);
   }
-  byte_data_ = NULL;
 }
 
 }  // namespace tango_gl
@@ -0,0 +1,181 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "tango-gl/texture_atlas.h"
+
+#include <algorithm>
+
+#include "tango-gl/asset_loader.h"
+#include "tango-gl/render_state.h"
+
+namespace {
+// Pixels of edge copy around each image.
+const GLsizei kBorder = 1;
+}  // namespace
+
+namespace tango_gl {
+
+TextureAtlas::TextureAtlas(GLsizei page_size)
+    : page_size_(std::max<GLsizei>(page_size, 2 * kBorder + 1)) {}
+
+TextureAtlas::~TextureAtlas() { Release(); }
+
+int TextureAtlas::AddSprite() {
+  Sprite sprite;
+  sprite.page = -1;
+  sprite.uv_min = glm::vec2(0.0f);
+  sprite.uv_max = glm::vec2(0.0f);
+  sprite.width = 0;
+  sprite.height = 0;
+  sprites_.push_back(sprite);
+  return static_cast<int>(sprites_.size()) - 1;
+}
+
+int TextureAtlas::LoadSprite(AssetLoader* loader, const char* file_path) {
+  const int sprite = AddSprite();
+  loader->LoadSprite(file_path, this, sprite);
+  return sprite;
+}
+
+bool TextureAtlas::SetImage(int sprite, const Texture::Image& image) {
+  if (image.is_compressed ||
+      (image.format != GL_RGB && image.format != GL_RGBA)) {
+    LOGE("TextureAtlas: sprite %d is not an uncompressed RGB(A) image.",
+         sprite);
+    return false;
+  }
+  const GLsizei width = static_cast<GLsizei>(image.width);
+  const GLsizei height = static_cast<GLsizei>(image.height);
+  const GLsizei padded_width = width + 2 * kBorder;
+  const GLsizei padded_height = height + 2 * kBorder;
+  int page;
+  GLsizei x;
+  GLsizei y;
+  if (width <= 0 || height <= 0 ||
+      !Pack(padded_width, padded_height, &page, &x, &y)) {
+    LOGE("TextureAtlas: sprite %d of %dx%d does not fit a %d page.", sprite,
+         width, height, page_size_);
+    return false;
+  }
+
+  // Expand to RGBA and copy the edge pixels into the border.
+  const int channel_count = image.format == GL_RGBA ? 4 : 3;
+  const size_t row_size = image.GetRowSize();
+  staging_buffer_.resize(static_cast<size_t>(padded_width) * padded_height *
+                         4);
+  uint8_t* output = staging_buffer_.data();
+  for (GLsizei row = 0; row < padded_height; ++row) {
+    const GLsizei source_row =
+        std::min(height - 1, std::max<GLsizei>(0, row - kBorder));
+    const uint8_t* source_pixels = image.pixels.data() + source_row * row_size;
+    for (GLsizei column = 0; column < padded_width; ++column) {
+      const GLsizei source_column =
+          std::min(width - 1, std::max<GLsizei>(0, column - kBorder));
+      const uint8_t* source = source_pixels + source_column * channel_count;
+      output[0] = source[0];
+      output[1] = source[1];
+      output[2] = source[2];
+      output[3] = channel_count == 4 ? source[3] : 255;
+      output += 4;
+    }
+  }
+  RenderState::BindTexture(GL_TEXTURE_2D, pages_[page].texture);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+  glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, padded_width, padded_height,
+                  GL_RGBA, GL_UNSIGNED_BYTE, staging_buffer_.data());
+  util::CheckGlError("TextureAtlas::SetImage");
+
+  Sprite& entry = sprites_[sprite];
+  entry.page = page;
+  entry.uv_min = glm::vec2(x + kBorder, y + kBorder) /
+                 static_cast<float>(page_size_);
+  entry.uv_max = glm::vec2(x + kBorder + width, y + kBorder + height) /
+                 static_cast<float>(page_size_);
+  entry.width = width;
+  entry.height = height;
+  return true;
+}
+
+bool TextureAtlas::Pack(GLsizei width, GLsizei height, int* page, GLsizei* x,
+                        GLsizei* y) {
+  if (width > page_size_ || height > page_size_) {
+    return false;
+  }
+  for (size_t i = 0; i < pages_.size(); ++i) {
+    // The shortest shelf the rectangle fits, so tall shelves stay for tall
+    // images.
+    Shelf* best_shelf = nullptr;
+    for (Shelf& shelf : pages_[i].shelves) {
+      if (shelf.height >= height && shelf.x + width <= page_size_ &&
+          (best_shelf == nullptr || shelf.height < best_shelf->height)) {
+        best_shelf = &shelf;
+      }
+    }
+    if (best_shelf == nullptr && pages_[i].free_y + height <= page_size_) {
+      Shelf shelf;
+      shelf.y = pages_[i].free_y;
+      shelf.height = height;
+      shelf.x = 0;
+      pages_[i].shelves.push_back(shelf);
+      pages_[i].free_y += height;
+      best_shelf = &pages_[i].shelves.back();
+    }
+    if (best_shelf != nullptr) {
+      *page = static_cast<int>(i);
+      *x = best_shelf->x;
+      *y = best_shelf->y;
+      best_shelf->x += width;
+      return true;
+    }
+  }
+  AddPage();
+  return Pack(width, height, page, x, y);
+}
+
+void TextureAtlas::AddPage() {
+  Page page;
+  page.free_y = 0;
+  glGenTextures(1, &page.texture);
+  RenderState::BindTexture(GL_TEXTURE_2D, page.texture);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, page_size_, page_size_, 0, GL_RGBA,
+               GL_UNSIGNED_BYTE, nullptr);
+  MemoryTracker::Track(MemoryTracker::kTexture, page.texture, "TextureAtlas",
+                       MemoryTracker::GetTextureSize(page_size_, page_size_,
+                                                     GL_RGBA,
+                                                     GL_UNSIGNED_BYTE));
+  pages_.push_back(page);
+}
+
+void TextureAtlas::Release() {
+  for (Page& page : pages_) {
+    RenderState::DeleteTextures(1, &page.texture);
+  }
+  Invalidate();
+}
+
+void TextureAtlas::Invalidate() {
+  pages_.clear();
+  for (Sprite& sprite : sprites_) {
+    sprite.page = -1;
+  }
+}
+
+}  // namespace tango_gl
@@ -0,0 +1,272 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "tango-gl/thread_policy.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <mutex>
+#include <thread>
+
+#if defined(__linux__)
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "tango-gl/util.h"
+
+namespace {
+using tango_gl::WorkerPool;
+using tango_gl::thread_policy::kRoleCount;
+using tango_gl::thread_policy::Policy;
+using tango_gl::thread_policy::Role;
+
+const char* const kRoleNames[kRoleCount] = {"render", "pose",   "depth",
+                                            "camera", "worker", "background"};
+
+struct TaggedThread {
+  Role role;
+  int thread_id;
+  // Last CPU time read, final once the thread has ended.
+  double cpu_time_ms;
+  bool has_ended;
+};
+
+std::mutex g_mutex;
+// Guarded by g_mutex.
+Policy g_policies[kRoleCount] = {
+    // The GL thread gets the priority Android gives its display threads.
+    Policy(WorkerPool::kBigCores, -4), Policy(WorkerPool::kAnyCores, -2),
+    Policy(WorkerPool::kBigCores, 0), Policy(WorkerPool::kBigCores, 0),
+    Policy(WorkerPool::kAnyCores, 0), Policy(WorkerPool::kLittleCores, 10)};
+std::vector<TaggedThread> g_threads;
+
+// Maximum frequency of a core in kHz, 0 if it is unknown.
+long GetCoreMaxFrequency(int cpu) {
+  char path[96];
+  snprintf(path, sizeof(path),
+           "/sys/devices/system/cpu/cpu%d/cpufreq/cpuinfo_max_freq", cpu);
+  FILE* file = fopen(path, "r");
+  if (file == nullptr) {
+    return 0;
+  }
+  long frequency = 0;
+  if (fscanf(file, "%ld", &frequency) != 1) {
+    frequency = 0;
+  }
+  fclose(file);
+  return frequency;
+}
+
+int GetCurrentThreadId() {
+#if defined(__linux__)
+  return static_cast<int>(syscall(SYS_gettid));
+#else
+  return 0;
+#endif
+}
+
+// User and system time of a thread of this process, in milliseconds.
+//
+// @return false if the thread is gone or the time is not readable.
+bool ReadThreadCpuTime(int thread_id, double* cpu_time_ms) {
+#if defined(__linux__)
+  char path[64];
+  snprintf(path, sizeof(path), "/proc/self/task/%d/stat", thread_id);
+  FILE* file = fopen(path, "r");
+  if (file == nullptr) {
+    return false;
+  }
+  char line[512];
+  const bool has_line = fgets(line, sizeof(line), file) != nullptr;
+  fclose(file);
+  // The thread name, in parentheses, may hold spaces; the fields after it
+  // start with the state, utime and stime are the 12th and 13th.
+  const char* fields = has_line ? strrchr(line, ')') : nullptr;
+  unsigned long long user_ticks;
+  unsigned long long system_ticks;
+  if (fields == nullptr ||
+      sscanf(fields + 1,
+             " %*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %llu %llu",
+             &user_ticks, &system_ticks) != 2) {
+    return false;
+  }
+  *cpu_time_ms = 1000.0 * (user_ticks + system_ticks) / sysconf(_SC_CLK_TCK);
+  return true;
+#else
+  (void)thread_id;
+  (void)cpu_time_ms;
+  return false;
+#endif
+}
+
+// Tag of the calling thread. Its destructor runs as the thread ends, while
+// its CPU time is still readable, and keeps the final time.
+struct CurrentThreadTag {
+  CurrentThreadTag() : role(kRoleCount), index(0) {}
+  ~CurrentThreadTag() {
+    if (role == kRoleCount) {
+      return;
+    }
+    double cpu_time_ms;
+    const bool has_cpu_time = ReadThreadCpuTime(GetCurrentThreadId(),
+                                                &cpu_time_ms);
+    std::lock_guard<std::mutex> lock(g_mutex);
+    TaggedThread& thread = g_threads[index];
+    if (has_cpu_time) {
+      thread.cpu_time_ms = std::max(thread.cpu_time_ms, cpu_time_ms);
+    }
+    thread.has_ended = true;
+  }
+
+  // kRoleCount if the thread is not tagged.
+  Role role;
+  size_t index;
+};
+
+CurrentThreadTag& GetCurrentThreadTag() {
+  static thread_local CurrentThreadTag tag;
+  return tag;
+}
+
+void Tag(Role role) {
+  TaggedThread thread;
+  thread.role = role;
+  thread.thread_id = GetCurrentThreadId();
+  thread.cpu_time_ms = 0.0;
+  thread.has_ended = false;
+  CurrentThreadTag& tag = GetCurrentThreadTag();
+  std::lock_guard<std::mutex> lock(g_mutex);
+  tag.role = role;
+  tag.index = g_threads.size();
+  g_threads.push_back(thread);
+}
+
+void ApplyPolicy(Role role, const Policy& policy) {
+#if defined(__linux__)
+  const std::vector<int> cpus =
+      tango_gl::thread_policy::GetCores(policy.cores);
+  if (!cpus.empty()) {
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    for (int cpu : cpus) {
+      CPU_SET(cpu, &cpu_set);
+    }
+    // A pid of 0 is the calling thread.
+    if (sched_setaffinity(0, sizeof(cpu_set), &cpu_set) != 0) {
+      LOGE("thread_policy: Failed to set the affinity of a %s thread",
+           kRoleNames[role]);
+    }
+  }
+  // On Linux the nice value is per thread.
+  const id_t thread_id = static_cast<id_t>(GetCurrentThreadId());
+  if (getpriority(PRIO_PROCESS, thread_id) != policy.nice &&
+      setpriority(PRIO_PROCESS, thread_id, policy.nice) != 0) {
+    LOGE("thread_policy: Failed to set the nice value of a %s thread to %d",
+         kRoleNames[role], policy.nice);
+  }
+#else
+  (void)role;
+  (void)policy;
+#endif
+}
+}  // namespace
+
+namespace tango_gl {
+namespace thread_policy {
+
+void SetPolicy(Role role, const Policy& policy) {
+  std::lock_guard<std::mutex> lock(g_mutex);
+  g_policies[role] = policy;
+}
+
+Policy GetPolicy(Role role) {
+  std::lock_guard<std::mutex> lock(g_mutex);
+  return g_policies[role];
+}
+
+void EnterRole(Role role) {
+  if (GetCurrentThreadTag().role != kRoleCount) {
+    return;
+  }
+  Tag(role);
+  ApplyPolicy(role, GetPolicy(role));
+}
+
+void TagCurrentThread(Role role) {
+  if (GetCurrentThreadTag().role == kRoleCount) {
+    Tag(role);
+  }
+}
+
+Statistics GetStatistics(Role role) {
+  Statistics statistics;
+  statistics.thread_count = 0;
+  statistics.cpu_time_ms = 0.0;
+  std::lock_guard<std::mutex> lock(g_mutex);
+  for (TaggedThread& thread : g_threads) {
+    if (thread.role != role) {
+      continue;
+    }
+    double cpu_time_ms;
+    if (!thread.has_ended &&
+        ReadThreadCpuTime(thread.thread_id, &cpu_time_ms)) {
+      thread.cpu_time_ms = std::max(thread.cpu_time_ms, cpu_time_ms);
+    }
+    ++statistics.thread_count;
+    statistics.cpu_time_ms += thread.cpu_time_ms;
+  }
+  return statistics;
+}
+
+const char* GetRoleName(Role role) {
+  return role < kRoleCount ? kRoleNames[role] : "none";
+}
+
+std::vector<int> GetCores(WorkerPool::CoreSet core_set) {
+  std::vector<int> cores;
+  if (core_set == WorkerPool::kAnyCores) {
+    return cores;
+  }
+  const int core_count = static_cast<int>(std::thread::hardware_concurrency());
+  std::vector<long> frequencies(core_count);
+  for (int i = 0; i < core_count; ++i) {
+    frequencies[i] = GetCoreMaxFrequency(i);
+    if (frequencies[i] == 0) {
+      return cores;
+    }
+  }
+  if (frequencies.empty()) {
+    return cores;
+  }
+  const long fastest =
+      *std::max_element(frequencies.begin(), frequencies.end());
+  for (int i = 0; i < core_count; ++i) {
+    const bool is_big = frequencies[i] == fastest;
+    if (is_big == (core_set == WorkerPool::kBigCores)) {
+      cores.push_back(i);
+    }
+  }
+  return cores;
+}
+
+}  // namespace thread_policy
+}  // namespace tango_gl
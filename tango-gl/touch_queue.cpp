@@ -0,0 +1,61 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "tango-gl/touch_queue.h"
+
+namespace tango_gl {
+
+TouchQueue::TouchQueue() : touches_(kCapacity) {}
+
+bool TouchQueue::Push(int touch_count, GestureCamera::TouchEvent event,
+                      float x0, float y0, float x1, float y1) {
+  const Touch touch = {touch_count, event, x0, y0, x1, y1};
+  return touches_.Push(touch);
+}
+
+size_t TouchQueue::Drain(const std::function<void(const Touch&)>& apply) {
+  size_t applied_count = 0;
+  bool has_pending_move = false;
+  Touch pending_move;
+  Touch touch;
+  while (touches_.Pop(&touch)) {
+    const bool is_move = touch.event == GestureCamera::kTouchMove;
+    if (has_pending_move) {
+      if (is_move && touch.touch_count == pending_move.touch_count) {
+        pending_move = touch;
+        continue;
+      }
+      apply(pending_move);
+      ++applied_count;
+      has_pending_move = false;
+    }
+    if (is_move) {
+      pending_move = touch;
+      has_pending_move = true;
+      continue;
+    }
+    apply(touch);
+    ++applied_count;
+  }
+  if (has_pending_move) {
+    apply(pending_move);
+    ++applied_count;
+  }
+  return applied_count;
+}
+
+}  // namespace tango_gl
@@ -14,25 +14,60 @@
  * limitations under the License.
  */
 
+#include "tango-gl/counters.h"
+#include "tango-gl/render_state.h"
 #include "tango-gl/trace.h"
 
 namespace tango_gl {
 
 static const int kMaxTraceLength = 5000;
 static const float kDistanceCheck = 0.05f;
+// Older points closer than this to the simplified trace are dropped.
+static const float kSimplifyTolerance = 0.02f;
 
-Trace::Trace() : Line(3.0f, GL_LINE_STRIP) { SetShader(); }
+Trace::Trace()
+    : line_width_(3.0f),
+      next_index_key_(0.0),
+      store_(kMaxTraceLength, 1) {
+  render_mode_ = GL_LINE_STRIP;
+  SetShader();
+  store_.SetSimplifyTolerance(kSimplifyTolerance);
+}
 
 void Trace::UpdateVertexArray(const glm::vec3& v) {
-  if (vec_vertices_.size() == 0) {
-    vec_vertices_.push_back(v);
-  } else {
-    float dist = glm::distance(vec_vertices_[vec_vertices_.size() - 1], v);
-    if (dist >= kDistanceCheck) {
-      vec_vertices_.push_back(v);
-    }
+  UpdateVertexArray(next_index_key_, v);
+}
+
+void Trace::UpdateVertexArray(double timestamp, const glm::vec3& v) {
+  glm::vec3 last_position;
+  if (!store_.GetLastPoint(&last_position) ||
+      glm::distance(last_position, v) >= kDistanceCheck) {
+    store_.Add(timestamp, v);
+    next_index_key_ = timestamp + 1.0;
   }
 }
 
-void Trace::ClearVertexArray() { vec_vertices_.clear(); }
+void Trace::ClearVertexArray() {
+  store_.Clear();
+  next_index_key_ = 0.0;
+}
+
+void Trace::Correct(double since_timestamp, const glm::mat4& correction) {
+  store_.Correct(since_timestamp, correction);
+}
+
+void Trace::Render(const glm::mat4& projection_mat,
+                   const glm::mat4& view_mat) const {
+  RenderState::UseProgram(shader_program_);
+  RenderState::LineWidth(line_width_);
+  SetTransformUniforms(projection_mat, view_mat, GetTransformationMatrix());
+
+  glUniform4f(uniform_color_, red_, green_, blue_, alpha_);
+
+  buffers_.Draw(store_, attrib_vertices_,
+                [this](size_t first_point, size_t point_count) {
+                  Counters::Increment(Counters::kDrawCalls);
+                  glDrawArrays(render_mode_, first_point, point_count);
+                });
+}
 }  // namespace tango_gl
@@ -0,0 +1,181 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <stdio.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <memory>
+#include <vector>
+
+#include "tango-gl/tracing.h"
+#include "tango-gl/util.h"
+
+namespace {
+// Events kept per thread, about a minute of a busy render thread.
+const size_t kEventsPerThread = 16384;
+
+struct Event {
+  const char* name;
+  const char* category;
+  uint64_t start_us;
+  uint64_t duration_us;
+};
+
+// Ring buffer of one thread. Its mutex is only contended while a dump reads
+// the buffer.
+struct ThreadBuffer {
+  std::mutex mutex;
+  pid_t tid;
+  const char* thread_name;
+  std::vector<Event> events;
+  size_t next;
+  bool has_wrapped;
+};
+
+// Buffers of every thread that recorded an event. Buffers are never freed,
+// so events of exited threads are still dumped.
+std::mutex g_buffers_mutex;
+std::vector<std::unique_ptr<ThreadBuffer>>* g_buffers = nullptr;
+
+ThreadBuffer* GetThreadBuffer() {
+  static thread_local ThreadBuffer* buffer = nullptr;
+  if (buffer == nullptr) {
+    std::unique_ptr<ThreadBuffer> new_buffer(new ThreadBuffer());
+    new_buffer->tid = static_cast<pid_t>(syscall(__NR_gettid));
+    new_buffer->thread_name = nullptr;
+    new_buffer->events.resize(kEventsPerThread);
+    new_buffer->next = 0;
+    new_buffer->has_wrapped = false;
+    buffer = new_buffer.get();
+
+    std::lock_guard<std::mutex> lock(g_buffers_mutex);
+    if (g_buffers == nullptr) {
+      g_buffers = new std::vector<std::unique_ptr<ThreadBuffer>>();
+    }
+    g_buffers->push_back(std::move(new_buffer));
+  }
+  return buffer;
+}
+
+// Write a string literal as a JSON string, escaping what needs to be.
+void WriteJsonString(FILE* file, const char* str) {
+  fputc('"', file);
+  for (const char* c = str; *c != '\0'; ++c) {
+    if (*c == '"' || *c == '\\') {
+      fputc('\\', file);
+    }
+    fputc(*c >= ' ' ? *c : '?', file);
+  }
+  fputc('"', file);
+}
+}  // namespace
+
+namespace tango_gl {
+namespace tracing {
+
+uint64_t NowMicroseconds() {
+  timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return static_cast<uint64_t>(now.tv_sec) * 1000000 + now.tv_nsec / 1000;
+}
+
+void RecordSpan(const char* name, const char* category, uint64_t start_us,
+                uint64_t duration_us) {
+  ThreadBuffer* buffer = GetThreadBuffer();
+  std::lock_guard<std::mutex> lock(buffer->mutex);
+  Event& event = buffer->events[buffer->next];
+  event.name = name;
+  event.category = category;
+  event.start_us = start_us;
+  event.duration_us = duration_us;
+  if (++buffer->next == kEventsPerThread) {
+    buffer->next = 0;
+    buffer->has_wrapped = true;
+  }
+}
+
+void SetThreadName(const char* name) {
+  ThreadBuffer* buffer = GetThreadBuffer();
+  std::lock_guard<std::mutex> lock(buffer->mutex);
+  buffer->thread_name = name;
+}
+
+bool DumpChromeTrace(const char* path) {
+  FILE* file = fopen(path, "w");
+  if (file == NULL) {
+    LOGE("tracing: could not open %s", path);
+    return false;
+  }
+  const int pid = getpid();
+  fprintf(file, "{\"traceEvents\":[\n");
+  bool is_first = true;
+  std::vector<Event> events;
+
+  std::lock_guard<std::mutex> buffers_lock(g_buffers_mutex);
+  if (g_buffers != nullptr) {
+    for (const std::unique_ptr<ThreadBuffer>& buffer : *g_buffers) {
+      // Copy the ring out so its thread is only blocked for the copy.
+      const char* thread_name;
+      {
+        std::lock_guard<std::mutex> lock(buffer->mutex);
+        thread_name = buffer->thread_name;
+        if (buffer->has_wrapped) {
+          events.assign(buffer->events.begin() + buffer->next,
+                        buffer->events.end());
+        } else {
+          events.clear();
+        }
+        events.insert(events.end(), buffer->events.begin(),
+                      buffer->events.begin() + buffer->next);
+      }
+
+      if (thread_name != nullptr) {
+        fprintf(file,
+                "%s{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":%d,"
+                "\"tid\":%d,\"args\":{\"name\":",
+                is_first ? "" : ",\n", pid, buffer->tid);
+        WriteJsonString(file, thread_name);
+        fprintf(file, "}}");
+        is_first = false;
+      }
+      for (const Event& event : events) {
+        fprintf(file, "%s{\"ph\":\"X\",\"name\":", is_first ? "" : ",\n");
+        WriteJsonString(file, event.name);
+        fprintf(file, ",\"cat\":");
+        WriteJsonString(file, event.category);
+        fprintf(file,
+                ",\"ts\":%llu,\"dur\":%llu,\"pid\":%d,\"tid\":%d}",
+                static_cast<unsigned long long>(event.start_us),
+                static_cast<unsigned long long>(event.duration_us), pid,
+                buffer->tid);
+        is_first = false;
+      }
+    }
+  }
+  fprintf(file, "\n]}\n");
+  bool is_written = ferror(file) == 0;
+  is_written = fclose(file) == 0 && is_written;
+  if (!is_written) {
+    LOGE("tracing: failed to write %s", path);
+  }
+  return is_written;
+}
+
+}  // namespace tracing
+}  // namespace tango_gl
@@ -0,0 +1,363 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <algorithm>
+#include <limits>
+
+#include "tango-gl/trajectory_store.h"
+
+namespace {
+// Aged points simplified at once. Simplification keeps both ends of the
+// points it looks at, so smaller batches would hardly drop anything.
+const size_t kMinSimplifyCount = 64;
+
+float DistanceToSegment(const glm::vec3& point, const glm::vec3& start,
+                        const glm::vec3& end) {
+  glm::vec3 direction = end - start;
+  float length2 = glm::dot(direction, direction);
+  float t = length2 > 0.0f
+                ? glm::clamp(glm::dot(point - start, direction) / length2,
+                             0.0f, 1.0f)
+                : 0.0f;
+  return glm::distance(point, start + t * direction);
+}
+
+// Douglas-Peucker over points[first, last], flagging the points to keep.
+// Both ends are kept.
+void MarkKeptPoints(const std::vector<glm::vec3>& points, size_t first,
+                    size_t last, float tolerance, std::vector<bool>* keep) {
+  (*keep)[first] = true;
+  (*keep)[last] = true;
+  std::vector<std::pair<size_t, size_t>> ranges;
+  ranges.push_back(std::make_pair(first, last));
+  while (!ranges.empty()) {
+    std::pair<size_t, size_t> range = ranges.back();
+    ranges.pop_back();
+    float max_distance = 0.0f;
+    size_t farthest = range.first;
+    for (size_t i = range.first + 1; i < range.second; ++i) {
+      float distance = DistanceToSegment(points[i], points[range.first],
+                                         points[range.second]);
+      if (distance > max_distance) {
+        max_distance = distance;
+        farthest = i;
+      }
+    }
+    if (max_distance > tolerance) {
+      (*keep)[farthest] = true;
+      ranges.push_back(std::make_pair(range.first, farthest));
+      ranges.push_back(std::make_pair(farthest, range.second));
+    }
+  }
+}
+}  // namespace
+
+namespace tango_gl {
+
+TrajectoryStore::TrajectoryStore(size_t max_point_count, size_t overlap)
+    : max_chunk_count_(std::max<size_t>(
+          2, (max_point_count + kChunkSize - 1) / kChunkSize)),
+      overlap_(std::min(overlap, kChunkSize - 1)),
+      simplify_tolerance_(0.0f),
+      next_chunk_id_(0),
+      point_count_(0),
+      generation_(0),
+      is_correcting_(false),
+      is_stopping_(false) {}
+
+TrajectoryStore::~TrajectoryStore() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    is_stopping_ = true;
+    corrections_changed_.notify_all();
+  }
+  if (worker_.joinable()) {
+    worker_.join();
+  }
+}
+
+void TrajectoryStore::SetSimplifyTolerance(float tolerance) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  simplify_tolerance_ = overlap_ <= 1 ? tolerance : 0.0f;
+}
+
+void TrajectoryStore::Add(double timestamp, const glm::vec3& point) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!chunks_.empty() && chunks_.back()->points.size() >= kChunkSize &&
+      simplify_tolerance_ > 0.0f && corrections_.empty() && !is_correcting_) {
+    // The correction worker writes points back by index, chunks may only
+    // shrink while it is idle.
+    Simplify(chunks_.back().get());
+  }
+  if (chunks_.empty() || chunks_.back()->points.size() >= kChunkSize) {
+    std::unique_ptr<Chunk> chunk;
+    if (chunks_.size() >= max_chunk_count_) {
+      point_count_ -= chunks_.front()->points.size();
+      chunk = std::move(chunks_.front());
+      chunks_.pop_front();
+    } else if (!free_chunks_.empty()) {
+      chunk = std::move(free_chunks_.back());
+      free_chunks_.pop_back();
+    } else {
+      chunk.reset(new Chunk());
+      chunk->timestamps.reserve(kChunkSize);
+      chunk->points.reserve(kChunkSize);
+    }
+    chunk->id = next_chunk_id_++;
+    chunk->timestamps.clear();
+    chunk->points.clear();
+    chunk->first_dirty_point = 0;
+    chunk->simplified_point_count = 0;
+
+    // Repeat the end of the previous chunk so the strips connect.
+    if (!chunks_.empty()) {
+      const Chunk& previous = *chunks_.back();
+      for (size_t i = kChunkSize - overlap_; i < kChunkSize; ++i) {
+        chunk->timestamps.push_back(previous.timestamps[i]);
+        chunk->points.push_back(previous.points[i]);
+      }
+      point_count_ += overlap_;
+    }
+    chunks_.push_back(std::move(chunk));
+  }
+
+  Chunk* chunk = chunks_.back().get();
+  chunk->timestamps.push_back(timestamp);
+  chunk->points.push_back(point);
+  ++point_count_;
+}
+
+void TrajectoryStore::Clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  ++generation_;
+  corrections_.clear();
+  while (!chunks_.empty()) {
+    free_chunks_.push_back(std::move(chunks_.back()));
+    chunks_.pop_back();
+  }
+  point_count_ = 0;
+}
+
+void TrajectoryStore::Correct(double since_timestamp,
+                              const glm::mat4& correction) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!worker_.joinable()) {
+    worker_ = std::thread(&TrajectoryStore::WorkerLoop, this);
+  }
+  Correction job;
+  job.generation = generation_;
+  job.since_timestamp = since_timestamp;
+  job.correction = correction;
+  corrections_.push_back(job);
+  corrections_changed_.notify_all();
+}
+
+void TrajectoryStore::WaitForCorrections() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  corrections_changed_.wait(
+      lock, [this] { return corrections_.empty() && !is_correcting_; });
+}
+
+size_t TrajectoryStore::GetPointCount() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return point_count_;
+}
+
+bool TrajectoryStore::GetLastPoint(glm::vec3* point) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (chunks_.empty()) {
+    return false;
+  }
+  *point = chunks_.back()->points.back();
+  return true;
+}
+
+void TrajectoryStore::Simplify(Chunk* chunk) {
+  // Start from the last simplified point, or the last repeated one, both
+  // already final.
+  size_t first = std::max(chunk->simplified_point_count, overlap_);
+  first = first > 0 ? first - 1 : 0;
+  const size_t last = chunk->points.size() - kRecentPointCount - 1;
+  if (last < first + kMinSimplifyCount) {
+    return;
+  }
+
+  std::vector<bool> keep(chunk->points.size(), false);
+  MarkKeptPoints(chunk->points, first, last, simplify_tolerance_, &keep);
+  size_t kept = first + 1;
+  for (size_t i = first + 1; i < chunk->points.size(); ++i) {
+    if (i > last || keep[i]) {
+      if (i == last) {
+        chunk->simplified_point_count = kept + 1;
+      }
+      chunk->points[kept] = chunk->points[i];
+      chunk->timestamps[kept] = chunk->timestamps[i];
+      ++kept;
+    }
+  }
+  point_count_ -= chunk->points.size() - kept;
+  chunk->points.resize(kept);
+  chunk->timestamps.resize(kept);
+  chunk->first_dirty_point = std::min(chunk->first_dirty_point, first + 1);
+}
+
+void TrajectoryStore::MarkUploaded(const Chunk& chunk) const {
+  chunk.first_dirty_point = chunk.points.size();
+}
+
+void TrajectoryStore::WorkerLoop() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    corrections_changed_.wait(
+        lock, [this] { return is_stopping_ || !corrections_.empty(); });
+    if (is_stopping_) {
+      return;
+    }
+    Correction correction = corrections_.front();
+    corrections_.pop_front();
+    is_correcting_ = true;
+    lock.unlock();
+    RunCorrection(correction);
+    lock.lock();
+    is_correcting_ = false;
+    corrections_changed_.notify_all();
+  }
+}
+
+void TrajectoryStore::RunCorrection(const Correction& correction) {
+  // Copy of the points of an affected chunk, written back by chunk id.
+  struct ChunkCopy {
+    uint64_t id;
+    size_t first_point;
+    std::vector<glm::vec3> points;
+  };
+  std::vector<ChunkCopy> copies;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (correction.generation != generation_) {
+      return;
+    }
+    // Chunks are ordered by time, find the first one ending after the
+    // timestamp.
+    auto first = std::lower_bound(
+        chunks_.begin(), chunks_.end(), correction.since_timestamp,
+        [](const std::unique_ptr<Chunk>& chunk, double timestamp) {
+          return chunk->timestamps.back() < timestamp;
+        });
+    for (auto it = first; it != chunks_.end(); ++it) {
+      const Chunk& chunk = **it;
+      ChunkCopy copy;
+      copy.id = chunk.id;
+      copy.first_point = std::lower_bound(chunk.timestamps.begin(),
+                                          chunk.timestamps.end(),
+                                          correction.since_timestamp) -
+                         chunk.timestamps.begin();
+      copy.points.assign(chunk.points.begin() + copy.first_point,
+                         chunk.points.end());
+      copies.push_back(std::move(copy));
+    }
+  }
+
+  for (ChunkCopy& copy : copies) {
+    for (glm::vec3& point : copy.points) {
+      point = glm::vec3(correction.correction * glm::vec4(point, 1.0f));
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (correction.generation != generation_) {
+    return;
+  }
+  // Chunks only leave from the front and ids grow, so the copies are matched
+  // against the chunks in one pass. Points appended meanwhile are kept.
+  size_t chunk_index = 0;
+  for (const ChunkCopy& copy : copies) {
+    while (chunk_index < chunks_.size() && chunks_[chunk_index]->id < copy.id) {
+      ++chunk_index;
+    }
+    if (chunk_index == chunks_.size()) {
+      break;
+    }
+    Chunk* chunk = chunks_[chunk_index].get();
+    if (chunk->id != copy.id) {
+      continue;
+    }
+    std::copy(copy.points.begin(), copy.points.end(),
+              chunk->points.begin() + copy.first_point);
+    chunk->first_dirty_point =
+        std::min(chunk->first_dirty_point, copy.first_point);
+  }
+}
+
+TrajectoryBuffers::TrajectoryBuffers()
+    : ring_(GL_ARRAY_BUFFER, GL_DYNAMIC_DRAW) {}
+
+void TrajectoryBuffers::Draw(const TrajectoryStore& store,
+                             GLuint attrib_vertices, const DrawFunction& draw) {
+  const size_t kChunkSize = TrajectoryStore::kChunkSize;
+  const size_t slot_count = store.GetMaxChunkCount();
+  if (ring_.Reserve(slot_count * kChunkSize * sizeof(glm::vec3))) {
+    // New storage, every chunk has to be uploaded again.
+    slot_chunk_ids_.assign(slot_count, std::numeric_limits<uint64_t>::max());
+  }
+
+  std::unique_lock<std::mutex> lock = store.Lock();
+  const std::deque<std::unique_ptr<TrajectoryStore::Chunk>>& chunks =
+      store.GetChunks();
+  if (chunks.empty()) {
+    return;
+  }
+
+  // Chunk ids are consecutive, so chunks take the slots in turn and a full
+  // chunk ends where the next one starts.
+  for (const std::unique_ptr<TrajectoryStore::Chunk>& chunk : chunks) {
+    const size_t slot = chunk->id % slot_count;
+    if (slot_chunk_ids_[slot] != chunk->id) {
+      slot_chunk_ids_[slot] = chunk->id;
+      chunk->first_dirty_point = 0;
+    }
+    if (chunk->first_dirty_point < chunk->points.size()) {
+      ring_.Write(
+          sizeof(glm::vec3) * (slot * kChunkSize + chunk->first_dirty_point),
+          chunk->points.data() + chunk->first_dirty_point,
+          sizeof(glm::vec3) *
+              (chunk->points.size() - chunk->first_dirty_point));
+      store.MarkUploaded(*chunk);
+    }
+  }
+
+  const size_t first_point = (chunks.front()->id % slot_count) * kChunkSize;
+  const size_t end_point =
+      (chunks.back()->id % slot_count) * kChunkSize +
+      chunks.back()->points.size();
+
+  ring_.Bind();
+  glEnableVertexAttribArray(attrib_vertices);
+  glVertexAttribPointer(attrib_vertices, 3, GL_FLOAT, GL_FALSE,
+                        sizeof(glm::vec3), nullptr);
+  if (first_point < end_point) {
+    draw(first_point, end_point - first_point);
+  } else {
+    // Wrapped around, the overlap at the start of the first slot connects
+    // the two ranges.
+    draw(first_point, slot_count * kChunkSize - first_point);
+    draw(0, end_point);
+  }
+  glDisableVertexAttribArray(attrib_vertices);
+}
+
+}  // namespace tango_gl
@@ -15,6 +15,7 @@
  */
 
 #include "tango-gl/transform.h"
+#include "tango-gl/simd_math.h"
 #include "tango-gl/util.h"
 
 namespace tango_gl {
@@ -23,7 +24,14 @@ Transform::Transform()
   : parent_(nullptr),
     position_(0.0f, 0.0f, 0.0f),
     rotation_(1.0f, 0.0f, 0.0f, 0.0f),
-    scale_(1.0f, 1.0f, 1.0f) {
+    scale_(1.0f, 1.0f, 1.0f),
+    are_components_dirty_(false),
+    local_mat_(1.0f),
+    is_local_mat_dirty_(false),
+    world_mat_(1.0f),
+    is_world_mat_dirty_(false),
+    world_mat_version_(0),
+    parent_world_mat_version_(0) {
 }
 
 Transform::~Transform() {
@@ -31,52 +39,81 @@ Transform::~Transform() {
 }
 
 void Transform::SetPosition(const glm::vec3& position) {
+  UpdateComponents();
   position_ = position;
+  is_local_mat_dirty_ = true;
 }
 
 glm::vec3 Transform::GetPosition() const {
+  UpdateComponents();
   return position_;
 }
 
 void Transform::SetRotation(const glm::quat& rotation) {
+  UpdateComponents();
   rotation_ = rotation;
+  is_local_mat_dirty_ = true;
 }
 
 glm::quat Transform::GetRotation() const {
+  UpdateComponents();
   return rotation_;
 }
 
 void Transform::SetScale(const glm::vec3& scale) {
+  UpdateComponents();
   scale_ = scale;
+  is_local_mat_dirty_ = true;
 }
 
 glm::vec3 Transform::GetScale() const {
+  UpdateComponents();
   return scale_;
 }
 
 void Transform::Translate(const glm::vec3& translation) {
+  UpdateComponents();
   position_ += translation;
+  is_local_mat_dirty_ = true;
 }
 
 void Transform::SetTransformationMatrix(const glm::mat4& transform_mat) {
-  util::DecomposeMatrix(transform_mat, position_, rotation_, scale_);
+  local_mat_ = transform_mat;
+  is_local_mat_dirty_ = false;
+  are_components_dirty_ = true;
+  is_world_mat_dirty_ = true;
 }
 
-glm::mat4 Transform::GetTransformationMatrix() const {
-  glm::mat4 trans_mat = glm::scale(glm::mat4_cast(rotation_), scale_);
-  trans_mat[3][0] = position_.x;
-  trans_mat[3][1] = position_.y;
-  trans_mat[3][2] = position_.z;
-  glm::mat4 parent_mat = glm::mat4(1.0f);
-  if (parent_ != NULL) {
-    parent_mat = parent_->GetTransformationMatrix();
-    trans_mat = parent_mat * trans_mat;
+const glm::mat4& Transform::GetTransformationMatrix() const {
+  if (is_local_mat_dirty_) {
+    local_mat_ = glm::scale(glm::mat4_cast(rotation_), scale_);
+    local_mat_[3][0] = position_.x;
+    local_mat_[3][1] = position_.y;
+    local_mat_[3][2] = position_.z;
+    is_local_mat_dirty_ = false;
+    is_world_mat_dirty_ = true;
   }
-  return  trans_mat;
+
+  if (parent_ != nullptr) {
+    const glm::mat4& parent_mat = parent_->GetTransformationMatrix();
+    if (is_world_mat_dirty_ ||
+        parent_->world_mat_version_ != parent_world_mat_version_) {
+      simd_math::Multiply(parent_mat, local_mat_, &world_mat_);
+      parent_world_mat_version_ = parent_->world_mat_version_;
+      is_world_mat_dirty_ = false;
+      ++world_mat_version_;
+    }
+  } else if (is_world_mat_dirty_) {
+    world_mat_ = local_mat_;
+    is_world_mat_dirty_ = false;
+    ++world_mat_version_;
+  }
+  return world_mat_;
 }
 
 void Transform::SetParent(Transform* transform) {
   parent_ = transform;
+  is_world_mat_dirty_ = true;
 }
 
 const Transform* Transform::GetParent() const {
@@ -87,4 +124,11 @@ Transform* Transform::GetParent() {
   return parent_;
 }
 
+void Transform::UpdateComponents() const {
+  if (are_components_dirty_) {
+    util::DecomposeMatrix(local_mat_, position_, rotation_, scale_);
+    are_components_dirty_ = false;
+  }
+}
+
 }  // namespace tango_gl
@@ -0,0 +1,158 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "tango-gl/tsdf_fusion.h"
+
+namespace {
+// Frames between two paging passes. A pass visits every resident block and
+// every block within the resident radius.
+const int kPagingPeriod = 15;
+}  // namespace
+
+namespace tango_gl {
+
+TsdfFusion::TsdfFusion(const TsdfVolume::Options& options)
+    : worker_pool_(&WorkerPool::GetShared()),
+      is_stopping_(false),
+      device_T_depth_(1.0f),
+      intrinsics_(),
+      volume_(options, worker_pool_),
+      mesher_(worker_pool_),
+      resident_radius_(0.0f),
+      fused_frame_count_(0),
+      skipped_frame_count_(0) {}
+
+TsdfFusion::~TsdfFusion() { Stop(); }
+
+void TsdfFusion::Start(const glm::mat4& device_T_depth,
+                       const projection::CameraIntrinsics& intrinsics) {
+  if (thread_.joinable()) {
+    return;
+  }
+  // The fusion thread is not running, nothing else touches these.
+  device_T_depth_ = device_T_depth;
+  intrinsics_ = intrinsics;
+  volume_.Clear();
+  mesher_.Reset();
+  if (keyframe_selector_) {
+    keyframe_selector_->SetIntrinsics(intrinsics);
+  }
+  fused_frame_count_ = 0;
+  skipped_frame_count_ = 0;
+  {
+    std::lock_guard<std::mutex> lock(mesh_mutex_);
+    pending_meshes_.clear();
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    is_stopping_ = false;
+  }
+  thread_ = std::thread(&TsdfFusion::FusionLoop, this);
+}
+
+void TsdfFusion::SetBlockStore(BlockStore* store, float resident_radius) {
+  if (thread_.joinable()) {
+    LOGE("TsdfFusion: SetBlockStore() called while fusing.");
+    return;
+  }
+  volume_.SetBlockStore(store);
+  resident_radius_ = resident_radius;
+}
+
+void TsdfFusion::SetKeyframeOptions(const KeyframeSelector::Options* options) {
+  if (thread_.joinable()) {
+    LOGE("TsdfFusion: SetKeyframeOptions() called while fusing.");
+    return;
+  }
+  keyframe_selector_.reset(options == nullptr ? nullptr
+                                              : new KeyframeSelector(*options));
+}
+
+void TsdfFusion::Stop() {
+  if (!thread_.joinable()) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    is_stopping_ = true;
+    pending_frame_.Reset();
+  }
+  frame_available_.notify_one();
+  thread_.join();
+}
+
+void TsdfFusion::Submit(const PointCloudPool::Handle& frame) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    pending_frame_ = frame;
+  }
+  frame_available_.notify_one();
+}
+
+void TsdfFusion::TakeMeshUpdates(std::vector<TsdfMesher::BlockMesh>* meshes) {
+  meshes->clear();
+  std::lock_guard<std::mutex> lock(mesh_mutex_);
+  meshes->reserve(pending_meshes_.size());
+  for (auto& pending : pending_meshes_) {
+    meshes->push_back(std::move(pending.second));
+  }
+  pending_meshes_.clear();
+}
+
+void TsdfFusion::FusionLoop() {
+  while (true) {
+    PointCloudPool::Handle frame;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      frame_available_.wait(
+          lock, [this] { return pending_frame_ || is_stopping_; });
+      if (is_stopping_) {
+        return;
+      }
+      frame = std::move(pending_frame_);
+    }
+
+    const TangoXYZij& cloud = frame->cloud;
+    const glm::mat4 world_T_depth = frame->pose * device_T_depth_;
+    if (keyframe_selector_ &&
+        !keyframe_selector_->IsKeyframe(cloud.xyz[0], cloud.xyz_count,
+                                        world_T_depth)) {
+      ++skipped_frame_count_;
+      continue;
+    }
+    volume_.Integrate(cloud.xyz[0], cloud.xyz_count, world_T_depth,
+                      intrinsics_);
+    const glm::vec3 device_position(frame->pose[3]);
+    frame.Reset();
+    mesher_.Extract(volume_, &extracted_meshes_);
+    // After Extract(), which holds block indices, paging moves blocks.
+    if (fused_frame_count_ % kPagingPeriod == 0) {
+      volume_.PageOut(device_position, resident_radius_);
+      volume_.Prefetch(device_position, resident_radius_);
+    }
+    {
+      std::lock_guard<std::mutex> lock(mesh_mutex_);
+      for (TsdfMesher::BlockMesh& mesh : extracted_meshes_) {
+        pending_meshes_[TsdfVolume::BlockKey(mesh.x, mesh.y, mesh.z)] =
+            std::move(mesh);
+      }
+    }
+    ++fused_frame_count_;
+  }
+}
+
+}  // namespace tango_gl
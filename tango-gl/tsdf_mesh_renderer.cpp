@@ -0,0 +1,72 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "tango-gl/tsdf_mesh_renderer.h"
+
+namespace tango_gl {
+
+TsdfMeshRenderer::TsdfMeshRenderer(float voxel_size)
+    : voxel_size_(voxel_size), color_(0.8f, 0.8f, 0.8f) {}
+
+TsdfMeshRenderer::~TsdfMeshRenderer() {}
+
+void TsdfMeshRenderer::SetColor(const Color& color) {
+  color_ = color;
+  for (auto& chunk : chunks_) {
+    chunk.second.mesh->SetColor(color_);
+  }
+}
+
+void TsdfMeshRenderer::Update(std::vector<TsdfMesher::BlockMesh>* meshes) {
+  const float block_size = voxel_size_ * TsdfVolume::kBlockSize;
+  for (TsdfMesher::BlockMesh& block_mesh : *meshes) {
+    const uint64_t key =
+        TsdfVolume::BlockKey(block_mesh.x, block_mesh.y, block_mesh.z);
+    if (block_mesh.indices.empty()) {
+      chunks_.erase(key);
+      continue;
+    }
+
+    Chunk& chunk = chunks_[key];
+    if (!chunk.mesh) {
+      chunk.mesh.reset(new Mesh(GL_TRIANGLES));
+      chunk.mesh->SetShader(true);
+      chunk.mesh->SetColor(color_);
+      // Cells run from the first voxel center of the block to the first
+      // voxel center of the next one.
+      chunk.min =
+          glm::vec3(block_mesh.x, block_mesh.y, block_mesh.z) * block_size +
+          glm::vec3(0.5f * voxel_size_);
+      chunk.max = chunk.min + glm::vec3(block_size);
+    }
+    chunk.mesh->SetVertices(block_mesh.vertices, block_mesh.normals,
+                            block_mesh.indices);
+  }
+  meshes->clear();
+}
+
+void TsdfMeshRenderer::Render(const glm::mat4& projection_mat,
+                              const glm::mat4& view_mat,
+                              ViewFrustum* view_frustum) const {
+  for (const auto& chunk : chunks_) {
+    if (view_frustum->IsBoxVisible(chunk.second.min, chunk.second.max)) {
+      chunk.second.mesh->Render(projection_mat, view_mat);
+    }
+  }
+}
+
+}  // namespace tango_gl
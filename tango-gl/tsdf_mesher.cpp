@@ -0,0 +1,373 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "tango-gl/tsdf_mesher.h"
+
+#include <algorithm>
+
+namespace {
+const int kBlockSize = tango_gl::TsdfVolume::kBlockSize;
+// Lattice points of the cells of a block along an axis.
+const int kLatticeSize = kBlockSize + 1;
+
+// Most triangles a cube configuration can produce: every edge crossed, in
+// four corner triangles.
+const int kMaxCaseTriangles = 12;
+
+// Marching cubes cases. Corner c of a cell is at offset (c & 1, c >> 1 & 1,
+// c >> 2 & 1), edge e is along axis e / 4, from corner edge_corners[e][0]
+// to edge_corners[e][1]. A case is indexed by the mask of the corners with
+// a negative distance and lists the crossed edges of its triangles.
+struct CaseTable {
+  int edge_corners[12][2];
+  int triangle_count[256];
+  int edges[256][kMaxCaseTriangles * 3];
+};
+
+inline int CornerAxis(int corner, int axis) { return (corner >> axis) & 1; }
+
+glm::vec3 CornerOffset(int corner) {
+  return glm::vec3(CornerAxis(corner, 0), CornerAxis(corner, 1),
+                   CornerAxis(corner, 2));
+}
+
+// The table is derived from the cube topology rather than transcribed: the
+// crossed edges of each face are paired up, which links them into closed
+// loops around the cube, and each loop is fanned into triangles. Faces with
+// all four edges crossed are split so the negative corners are separated.
+// The choice only depends on the face, so neighboring cells agree on it and
+// the surface stays closed.
+CaseTable BuildCaseTable() {
+  CaseTable table;
+  int edge_count = 0;
+  for (int axis = 0; axis < 3; ++axis) {
+    for (int corner = 0; corner < 8; ++corner) {
+      if (!CornerAxis(corner, axis)) {
+        table.edge_corners[edge_count][0] = corner;
+        table.edge_corners[edge_count][1] = corner | (1 << axis);
+        ++edge_count;
+      }
+    }
+  }
+  auto edge_of = [&table](int corner0, int corner1) {
+    for (int edge = 0; edge < 12; ++edge) {
+      const int* corners = table.edge_corners[edge];
+      if ((corners[0] == corner0 && corners[1] == corner1) ||
+          (corners[0] == corner1 && corners[1] == corner0)) {
+        return edge;
+      }
+    }
+    return -1;
+  };
+
+  for (int mask = 0; mask < 256; ++mask) {
+    auto is_inside = [mask](int corner) { return ((mask >> corner) & 1) != 0; };
+    auto is_crossed = [&](int edge) {
+      return is_inside(table.edge_corners[edge][0]) !=
+             is_inside(table.edge_corners[edge][1]);
+    };
+
+    int links[12][2];
+    int link_count[12] = {0};
+    auto link = [&](int edge0, int edge1) {
+      links[edge0][link_count[edge0]++] = edge1;
+      links[edge1][link_count[edge1]++] = edge0;
+    };
+    for (int axis = 0; axis < 3; ++axis) {
+      for (int side = 0; side < 2; ++side) {
+        // Corners of the face in cyclic order, and the edges between them.
+        const int axis1 = (axis + 1) % 3;
+        const int axis2 = (axis + 2) % 3;
+        const int cycle[4][2] = {{0, 0}, {1, 0}, {1, 1}, {0, 1}};
+        int corners[4];
+        for (int i = 0; i < 4; ++i) {
+          corners[i] = (side << axis) | (cycle[i][0] << axis1) |
+                       (cycle[i][1] << axis2);
+        }
+        int edges[4];
+        int crossed[4];
+        int crossed_count = 0;
+        for (int i = 0; i < 4; ++i) {
+          edges[i] = edge_of(corners[i], corners[(i + 1) % 4]);
+          if (is_crossed(edges[i])) {
+            crossed[crossed_count++] = edges[i];
+          }
+        }
+        if (crossed_count == 2) {
+          link(crossed[0], crossed[1]);
+        } else if (crossed_count == 4) {
+          // Cut off each negative corner with the two edges around it.
+          for (int i = 0; i < 4; ++i) {
+            if (is_inside(corners[i])) {
+              link(edges[(i + 3) % 4], edges[i]);
+            }
+          }
+        }
+      }
+    }
+
+    table.triangle_count[mask] = 0;
+    bool is_visited[12] = {false};
+    for (int start = 0; start < 12; ++start) {
+      if (!is_crossed(start) || is_visited[start]) {
+        continue;
+      }
+      int loop[12];
+      int loop_size = 0;
+      int previous = -1;
+      int edge = start;
+      do {
+        is_visited[edge] = true;
+        loop[loop_size++] = edge;
+        const int next =
+            links[edge][0] != previous ? links[edge][0] : links[edge][1];
+        previous = edge;
+        edge = next;
+      } while (edge != start);
+
+      // Wind the loop counter clockwise seen from the positive side.
+      glm::vec3 normal(0.0f);
+      glm::vec3 outward(0.0f);
+      for (int i = 0; i < loop_size; ++i) {
+        const int* corners = table.edge_corners[loop[i]];
+        const int* next_corners = table.edge_corners[loop[(i + 1) % loop_size]];
+        const glm::vec3 point =
+            0.5f * (CornerOffset(corners[0]) + CornerOffset(corners[1]));
+        const glm::vec3 next_point = 0.5f * (CornerOffset(next_corners[0]) +
+                                             CornerOffset(next_corners[1]));
+        normal += glm::cross(point, next_point);
+        const float sign = is_inside(corners[0]) ? 1.0f : -1.0f;
+        outward += sign * (CornerOffset(corners[1]) - CornerOffset(corners[0]));
+      }
+      if (glm::dot(normal, outward) < 0.0f) {
+        std::reverse(loop, loop + loop_size);
+      }
+
+      for (int i = 1; i + 1 < loop_size; ++i) {
+        int* triangle = table.edges[mask] + table.triangle_count[mask] * 3;
+        triangle[0] = loop[0];
+        triangle[1] = loop[i];
+        triangle[2] = loop[i + 1];
+        ++table.triangle_count[mask];
+      }
+    }
+  }
+  return table;
+}
+
+const CaseTable& GetCaseTable() {
+  static const CaseTable table = BuildCaseTable();
+  return table;
+}
+
+// Voxels of a block and its 26 neighbors, addressed in voxel coordinates
+// relative to the block, from -kBlockSize to 2 * kBlockSize - 1.
+class VoxelNeighborhood {
+ public:
+  VoxelNeighborhood(const tango_gl::TsdfVolume& volume,
+                    const tango_gl::TsdfVolume::Block& block) {
+    for (int z = 0; z < 3; ++z) {
+      for (int y = 0; y < 3; ++y) {
+        for (int x = 0; x < 3; ++x) {
+          const int32_t index = volume.FindBlock(
+              block.x + x - 1, block.y + y - 1, block.z + z - 1);
+          blocks_[(z * 3 + y) * 3 + x] =
+              index >= 0 ? &volume.GetBlock(index) : nullptr;
+        }
+      }
+    }
+  }
+
+  // Distance of an observed voxel.
+  //
+  // @return false if the voxel was never observed.
+  bool GetDistance(int x, int y, int z, float* distance) const {
+    const int block_x = (x + kBlockSize) / kBlockSize;
+    const int block_y = (y + kBlockSize) / kBlockSize;
+    const int block_z = (z + kBlockSize) / kBlockSize;
+    const tango_gl::TsdfVolume::Block* block =
+        blocks_[(block_z * 3 + block_y) * 3 + block_x];
+    if (block == nullptr) {
+      return false;
+    }
+    const int voxel =
+        (((z + kBlockSize) % kBlockSize) * kBlockSize +
+         (y + kBlockSize) % kBlockSize) * kBlockSize +
+        (x + kBlockSize) % kBlockSize;
+    if (!(block->weight[voxel] > 0.0f)) {
+      return false;
+    }
+    *distance = block->distance[voxel];
+    return true;
+  }
+
+  // Distance gradient by central differences, one sided next to unobserved
+  // voxels.
+  glm::vec3 GetGradient(const glm::ivec3& voxel, float distance) const {
+    glm::vec3 gradient(0.0f);
+    for (int axis = 0; axis < 3; ++axis) {
+      glm::ivec3 step(0);
+      step[axis] = 1;
+      const glm::ivec3 forward = voxel + step;
+      const glm::ivec3 backward = voxel - step;
+      float forward_distance = distance;
+      float backward_distance = distance;
+      const bool has_forward = GetDistance(forward.x, forward.y, forward.z,
+                                           &forward_distance);
+      const bool has_backward = GetDistance(backward.x, backward.y, backward.z,
+                                            &backward_distance);
+      const float span = (has_forward ? 1.0f : 0.0f) +
+                         (has_backward ? 1.0f : 0.0f);
+      if (span > 0.0f) {
+        gradient[axis] = (forward_distance - backward_distance) / span;
+      }
+    }
+    return gradient;
+  }
+
+ private:
+  const tango_gl::TsdfVolume::Block* blocks_[27];
+};
+}  // namespace
+
+namespace tango_gl {
+
+TsdfMesher::TsdfMesher(WorkerPool* worker_pool)
+    : worker_pool_(worker_pool), extracted_revision_(0) {}
+
+TsdfMesher::~TsdfMesher() {}
+
+size_t TsdfMesher::Extract(const TsdfVolume& volume,
+                           std::vector<BlockMesh>* meshes) {
+  // A changed block invalidates its own cells and the cells of its lower
+  // neighbors, which reach into it.
+  dirty_blocks_.clear();
+  for (size_t i = 0; i < volume.GetBlockCount(); ++i) {
+    const TsdfVolume::Block& block = volume.GetBlock(i);
+    if (block.revision <= extracted_revision_) {
+      continue;
+    }
+    for (int corner = 0; corner < 8; ++corner) {
+      const int32_t index = volume.FindBlock(block.x - CornerAxis(corner, 0),
+                                             block.y - CornerAxis(corner, 1),
+                                             block.z - CornerAxis(corner, 2));
+      if (index >= 0) {
+        dirty_blocks_.push_back(index);
+      }
+    }
+  }
+  std::sort(dirty_blocks_.begin(), dirty_blocks_.end());
+  dirty_blocks_.erase(std::unique(dirty_blocks_.begin(), dirty_blocks_.end()),
+                      dirty_blocks_.end());
+  extracted_revision_ = volume.GetRevision();
+
+  const int block_count = static_cast<int>(dirty_blocks_.size());
+  meshes->resize(block_count);
+  if (worker_pool_ != nullptr) {
+    worker_pool_->ParallelFor(block_count, [&](int i) {
+      MeshBlock(volume, dirty_blocks_[i], &(*meshes)[i]);
+    });
+  } else {
+    for (int i = 0; i < block_count; ++i) {
+      MeshBlock(volume, dirty_blocks_[i], &(*meshes)[i]);
+    }
+  }
+  return meshes->size();
+}
+
+void TsdfMesher::MeshBlock(const TsdfVolume& volume, int32_t index,
+                           BlockMesh* mesh) const {
+  const CaseTable& table = GetCaseTable();
+  const TsdfVolume::Block& block = volume.GetBlock(index);
+  const VoxelNeighborhood neighborhood(volume, block);
+  const float voxel_size = volume.GetOptions().voxel_size;
+  const glm::ivec3 block_voxel =
+      glm::ivec3(block.x, block.y, block.z) * kBlockSize;
+
+  mesh->x = block.x;
+  mesh->y = block.y;
+  mesh->z = block.z;
+  mesh->vertices.clear();
+  mesh->normals.clear();
+  mesh->indices.clear();
+
+  // Vertex of each lattice edge, indexed by its lower lattice point and axis.
+  int32_t edge_vertices[kLatticeSize * kLatticeSize * kLatticeSize * 3];
+  std::fill(edge_vertices, edge_vertices + sizeof(edge_vertices) /
+                                               sizeof(edge_vertices[0]),
+            -1);
+
+  for (int z = 0; z < kBlockSize; ++z) {
+    for (int y = 0; y < kBlockSize; ++y) {
+      for (int x = 0; x < kBlockSize; ++x) {
+        float distances[8];
+        int mask = 0;
+        bool is_observed = true;
+        for (int corner = 0; corner < 8 && is_observed; ++corner) {
+          is_observed = neighborhood.GetDistance(
+              x + CornerAxis(corner, 0), y + CornerAxis(corner, 1),
+              z + CornerAxis(corner, 2), &distances[corner]);
+          if (is_observed && distances[corner] < 0.0f) {
+            mask |= 1 << corner;
+          }
+        }
+        if (!is_observed || table.triangle_count[mask] == 0) {
+          continue;
+        }
+
+        const glm::ivec3 cell(x, y, z);
+        const int* edges = table.edges[mask];
+        for (int i = 0; i < table.triangle_count[mask] * 3; ++i) {
+          const int* corners = table.edge_corners[edges[i]];
+          const glm::ivec3 start =
+              cell + glm::ivec3(CornerOffset(corners[0]));
+          const glm::ivec3 end = cell + glm::ivec3(CornerOffset(corners[1]));
+          const int slot =
+              ((start.z * kLatticeSize + start.y) * kLatticeSize + start.x) *
+                  3 +
+              edges[i] / 4;
+          if (edge_vertices[slot] < 0) {
+            const float start_distance = distances[corners[0]];
+            const float end_distance = distances[corners[1]];
+            const float t = start_distance / (start_distance - end_distance);
+            // Computed from global voxel coordinates, so both blocks sharing
+            // a border vertex compute exactly the same position. Voxel
+            // centers are at (voxel + 0.5) * voxel_size.
+            glm::vec3 position = glm::vec3(block_voxel + start) + 0.5f;
+            position[edges[i] / 4] += t;
+            position *= voxel_size;
+            glm::vec3 normal = glm::mix(
+                neighborhood.GetGradient(start, start_distance),
+                neighborhood.GetGradient(end, end_distance), t);
+            const float length = glm::length(normal);
+            normal = length > 0.0f ? normal / length : glm::vec3(0.0f);
+
+            edge_vertices[slot] =
+                static_cast<int32_t>(mesh->vertices.size() / 3);
+            mesh->vertices.insert(mesh->vertices.end(),
+                                  {position.x, position.y, position.z});
+            mesh->normals.insert(mesh->normals.end(),
+                                 {normal.x, normal.y, normal.z});
+          }
+          mesh->indices.push_back(static_cast<GLushort>(edge_vertices[slot]));
+        }
+      }
+    }
+  }
+}
+
+}  // namespace tango_gl
@@ -0,0 +1,475 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "tango-gl/tsdf_volume.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+#include "tango-gl/cpu_features.h"
+
+namespace {
+// Bits per block coordinate in a key, the grid is centered on the origin.
+const int kKeyBits = 21;
+const int32_t kKeyBias = 1 << (kKeyBits - 1);
+const uint64_t kKeyMask = (1ull << kKeyBits) - 1;
+
+inline size_t HashKey(uint64_t key) {
+  key *= 0x9E3779B97F4A7C15ull;
+  return static_cast<size_t>(key ^ (key >> 32));
+}
+
+inline int32_t FloorToInt(float value) {
+  return static_cast<int32_t>(std::floor(value));
+}
+
+// Squared distance from a position to the nearest point of a box.
+inline float BoxDistanceSquared(const glm::vec3& min, const glm::vec3& max,
+                                const glm::vec3& position) {
+  const glm::vec3 outside =
+      glm::max(glm::max(min - position, position - max), glm::vec3(0.0f));
+  return glm::dot(outside, outside);
+}
+
+// Update voxels [begin, end). Also the tail of the NEON kernel.
+void UpdateVoxelsScalar(const float* voxel_depths,
+                        const float* measured_depths, size_t begin,
+                        size_t end, float truncation_distance,
+                        float max_weight, float* distances, float* weights) {
+  for (size_t i = begin; i < end; ++i) {
+    const float measured_depth = measured_depths[i];
+    const float distance = measured_depth - voxel_depths[i];
+    // No surface at the pixel, or the voxel is hidden behind it.
+    if (!(measured_depth > 0.0f) || distance < -truncation_distance) {
+      continue;
+    }
+    const float weight = weights[i];
+    distances[i] = (distances[i] * weight +
+                    std::min(distance, truncation_distance)) /
+                   (weight + 1.0f);
+    weights[i] = std::min(weight + 1.0f, max_weight);
+  }
+}
+}  // namespace
+
+namespace tango_gl {
+
+const int TsdfVolume::kBlockSize;
+const int TsdfVolume::kVoxelsPerBlock;
+
+namespace internal {
+void UpdateVoxels(const float* voxel_depths, const float* measured_depths,
+                  size_t count, float truncation_distance, float max_weight,
+                  float* distances, float* weights) {
+  size_t begin = 0;
+#if defined(TANGO_GL_HAS_NEON)
+  if (cpu_features::IsNeonAvailable()) {
+    begin = count & ~static_cast<size_t>(3);
+    UpdateVoxelsNeon(voxel_depths, measured_depths, count, truncation_distance,
+                     max_weight, distances, weights);
+  }
+#endif
+  UpdateVoxelsScalar(voxel_depths, measured_depths, begin, count,
+                     truncation_distance, max_weight, distances, weights);
+}
+}  // namespace internal
+
+TsdfVolume::TsdfVolume(const Options& options, WorkerPool* worker_pool)
+    : options_(options),
+      worker_pool_(worker_pool),
+      blocks_(std::max<size_t>(1, options.max_block_count)),
+      block_count_(0),
+      revision_(0),
+      has_logged_full_(false),
+      block_store_(nullptr),
+      image_intrinsics_() {
+  size_t table_size = 1;
+  while (table_size < blocks_.size() * 2) {
+    table_size <<= 1;
+  }
+  table_.assign(table_size, -1);
+  table_mask_ = table_size - 1;
+}
+
+TsdfVolume::~TsdfVolume() {}
+
+void TsdfVolume::Clear() {
+  std::fill(table_.begin(), table_.end(), -1);
+  block_count_ = 0;
+  has_logged_full_ = false;
+  if (block_store_ != nullptr) {
+    block_store_->Clear();
+  }
+}
+
+size_t TsdfVolume::Integrate(const float* xyz, size_t point_count,
+                             const glm::mat4& volume_T_depth,
+                             const projection::CameraIntrinsics& intrinsics) {
+  ++revision_;
+  RenderDepthImage(xyz, point_count, intrinsics);
+  AllocateBlocks(xyz, point_count, volume_T_depth);
+
+  const glm::mat4 depth_T_volume = glm::inverse(volume_T_depth);
+  const int block_count = static_cast<int>(frame_blocks_.size());
+  if (worker_pool_ != nullptr) {
+    worker_pool_->ParallelFor(block_count, [&](int i) {
+      IntegrateBlock(frame_blocks_[i], depth_T_volume);
+    });
+  } else {
+    for (int i = 0; i < block_count; ++i) {
+      IntegrateBlock(frame_blocks_[i], depth_T_volume);
+    }
+  }
+  return frame_blocks_.size();
+}
+
+size_t TsdfVolume::PageOut(const glm::vec3& center, float radius) {
+  if (block_store_ == nullptr) {
+    return 0;
+  }
+  const float block_size = options_.voxel_size * kBlockSize;
+  const float radius_squared = radius * radius;
+  size_t paged_out = 0;
+  // Walking down, the block moved into a removed index was already kept.
+  for (size_t i = block_count_; i-- > 0;) {
+    const Block& block = blocks_[i];
+    const glm::vec3 min = glm::vec3(block.x, block.y, block.z) * block_size;
+    if (BoxDistanceSquared(min, min + glm::vec3(block_size), center) <=
+        radius_squared) {
+      continue;
+    }
+    block_store_->Write(BlockKey(block.x, block.y, block.z), &block,
+                        sizeof(Block));
+    RemoveBlock(static_cast<int32_t>(i));
+    ++paged_out;
+  }
+  if (paged_out > 0) {
+    has_logged_full_ = false;
+  }
+  return paged_out;
+}
+
+size_t TsdfVolume::PageIn(const glm::vec3& center, float radius) {
+  if (block_store_ == nullptr) {
+    return 0;
+  }
+  std::vector<uint64_t> keys;
+  CollectAbsentKeys(center, radius, &keys);
+  size_t paged_in = 0;
+  for (uint64_t key : keys) {
+    if (block_count_ == blocks_.size()) {
+      break;
+    }
+    Block& block = blocks_[block_count_];
+    if (!block_store_->Take(key, &block, sizeof(Block))) {
+      continue;
+    }
+    size_t slot = HashKey(key) & table_mask_;
+    while (table_[slot] >= 0) {
+      slot = (slot + 1) & table_mask_;
+    }
+    table_[slot] = static_cast<int32_t>(block_count_++);
+    ++paged_in;
+  }
+  return paged_in;
+}
+
+void TsdfVolume::Prefetch(const glm::vec3& center, float radius) {
+  if (block_store_ == nullptr) {
+    return;
+  }
+  std::vector<uint64_t> keys;
+  CollectAbsentKeys(center, radius, &keys);
+  block_store_->Prefetch(keys);
+}
+
+int32_t TsdfVolume::FindBlock(int32_t x, int32_t y, int32_t z) const {
+  return FindBlock(BlockKey(x, y, z));
+}
+
+uint64_t TsdfVolume::BlockKey(int32_t x, int32_t y, int32_t z) {
+  return (static_cast<uint64_t>(x + kKeyBias) & kKeyMask) |
+         ((static_cast<uint64_t>(y + kKeyBias) & kKeyMask) << kKeyBits) |
+         ((static_cast<uint64_t>(z + kKeyBias) & kKeyMask) << (2 * kKeyBits));
+}
+
+int32_t TsdfVolume::FindBlock(uint64_t key) const {
+  size_t slot = HashKey(key) & table_mask_;
+  while (table_[slot] >= 0) {
+    const Block& block = blocks_[table_[slot]];
+    if (BlockKey(block.x, block.y, block.z) == key) {
+      return table_[slot];
+    }
+    slot = (slot + 1) & table_mask_;
+  }
+  return -1;
+}
+
+int32_t TsdfVolume::AcquireBlock(int32_t x, int32_t y, int32_t z) {
+  const uint64_t key = BlockKey(x, y, z);
+  size_t slot = HashKey(key) & table_mask_;
+  while (table_[slot] >= 0) {
+    const Block& block = blocks_[table_[slot]];
+    if (block.x == x && block.y == y && block.z == z) {
+      return table_[slot];
+    }
+    slot = (slot + 1) & table_mask_;
+  }
+
+  if (block_count_ == blocks_.size()) {
+    if (!has_logged_full_) {
+      LOGE("TsdfVolume: all %zu blocks are in use.", blocks_.size());
+      has_logged_full_ = true;
+    }
+    return -1;
+  }
+  const int32_t index = static_cast<int32_t>(block_count_++);
+  Block& block = blocks_[index];
+  if (block_store_ == nullptr ||
+      !block_store_->Take(key, &block, sizeof(Block))) {
+    block.x = x;
+    block.y = y;
+    block.z = z;
+    block.revision = 0;
+    std::fill(block.distance, block.distance + kVoxelsPerBlock,
+              options_.truncation_distance);
+    std::fill(block.weight, block.weight + kVoxelsPerBlock, 0.0f);
+  }
+  table_[slot] = index;
+  return index;
+}
+
+void TsdfVolume::RemoveBlock(int32_t index) {
+  const Block& removed = blocks_[index];
+  size_t hole = HashKey(BlockKey(removed.x, removed.y, removed.z)) &
+                table_mask_;
+  while (table_[hole] != index) {
+    hole = (hole + 1) & table_mask_;
+  }
+
+  // Shift later entries of the probe sequence back into the hole, so lookups
+  // never stop early at it.
+  size_t slot = hole;
+  while (true) {
+    slot = (slot + 1) & table_mask_;
+    const int32_t entry = table_[slot];
+    if (entry < 0) {
+      break;
+    }
+    const Block& block = blocks_[entry];
+    const size_t home =
+        HashKey(BlockKey(block.x, block.y, block.z)) & table_mask_;
+    const bool movable = slot > hole ? (home <= hole || home > slot)
+                                     : (home <= hole && home > slot);
+    if (movable) {
+      table_[hole] = entry;
+      hole = slot;
+    }
+  }
+  table_[hole] = -1;
+
+  // Move the last block into the freed index.
+  const int32_t last = static_cast<int32_t>(--block_count_);
+  if (index == last) {
+    return;
+  }
+  Block& block = blocks_[index];
+  block = blocks_[last];
+  slot = HashKey(BlockKey(block.x, block.y, block.z)) & table_mask_;
+  while (table_[slot] != last) {
+    slot = (slot + 1) & table_mask_;
+  }
+  table_[slot] = index;
+}
+
+void TsdfVolume::CollectAbsentKeys(const glm::vec3& center, float radius,
+                                   std::vector<uint64_t>* keys) const {
+  keys->clear();
+  if (!(radius >= 0.0f)) {
+    return;
+  }
+  const float block_size = options_.voxel_size * kBlockSize;
+  const float inverse_block_size = 1.0f / block_size;
+  const int32_t max_block_coordinate = kKeyBias - 1;
+  int32_t min_block[3];
+  int32_t max_block[3];
+  for (int axis = 0; axis < 3; ++axis) {
+    min_block[axis] = std::max(
+        FloorToInt((center[axis] - radius) * inverse_block_size),
+        -max_block_coordinate);
+    max_block[axis] =
+        std::min(FloorToInt((center[axis] + radius) * inverse_block_size),
+                 max_block_coordinate);
+  }
+
+  const float radius_squared = radius * radius;
+  std::vector<std::pair<float, uint64_t>> candidates;
+  for (int32_t z = min_block[2]; z <= max_block[2]; ++z) {
+    for (int32_t y = min_block[1]; y <= max_block[1]; ++y) {
+      for (int32_t x = min_block[0]; x <= max_block[0]; ++x) {
+        const glm::vec3 min = glm::vec3(x, y, z) * block_size;
+        const float distance_squared =
+            BoxDistanceSquared(min, min + glm::vec3(block_size), center);
+        const uint64_t key = BlockKey(x, y, z);
+        if (distance_squared <= radius_squared && FindBlock(key) < 0) {
+          candidates.push_back(std::make_pair(distance_squared, key));
+        }
+      }
+    }
+  }
+  std::sort(candidates.begin(), candidates.end());
+  keys->reserve(candidates.size());
+  for (const std::pair<float, uint64_t>& candidate : candidates) {
+    keys->push_back(candidate.second);
+  }
+}
+
+void TsdfVolume::RenderDepthImage(
+    const float* xyz, size_t point_count,
+    const projection::CameraIntrinsics& intrinsics) {
+  const float scale = options_.depth_image_scale;
+  image_intrinsics_.width =
+      std::max(1, static_cast<int>(intrinsics.width * scale));
+  image_intrinsics_.height =
+      std::max(1, static_cast<int>(intrinsics.height * scale));
+  image_intrinsics_.fx = intrinsics.fx * scale;
+  image_intrinsics_.fy = intrinsics.fy * scale;
+  image_intrinsics_.cx = intrinsics.cx * scale;
+  image_intrinsics_.cy = intrinsics.cy * scale;
+
+  depth_image_.assign(image_intrinsics_.width * image_intrinsics_.height,
+                      0.0f);
+  pixels_.resize(point_count);
+  depths_.resize(point_count);
+  projection::ProjectPoints(xyz, point_count, glm::mat4(1.0f),
+                            image_intrinsics_, pixels_.data(), depths_.data());
+
+  for (size_t i = 0; i < point_count; ++i) {
+    const float depth = depths_[i];
+    if (pixels_[i] == projection::kInvalidPixel ||
+        depth > options_.max_depth) {
+      continue;
+    }
+    float& pixel = depth_image_[projection::PixelY(pixels_[i]) *
+                                    image_intrinsics_.width +
+                                projection::PixelX(pixels_[i])];
+    if (pixel == 0.0f || depth < pixel) {
+      pixel = depth;
+    }
+  }
+}
+
+void TsdfVolume::AllocateBlocks(const float* xyz, size_t point_count,
+                                const glm::mat4& volume_T_depth) {
+  frame_blocks_.clear();
+  const glm::mat3 rotation(volume_T_depth);
+  const glm::vec3 camera(volume_T_depth[3]);
+  const float inverse_block_size =
+      1.0f / (options_.voxel_size * kBlockSize);
+  const float truncation = options_.truncation_distance;
+  // Sample the band around each point densely enough not to skip a block.
+  const float step = std::max(
+      1e-3f, std::min(truncation, 0.5f * options_.voxel_size * kBlockSize));
+  const int32_t max_block_coordinate = kKeyBias - 1;
+
+  int32_t last_block[3] = {0, 0, 0};
+  bool has_last_block = false;
+  for (size_t i = 0; i < point_count; ++i) {
+    const float depth = xyz[i * 3 + 2];
+    if (!(depth > 0.0f && depth <= options_.max_depth)) {
+      continue;
+    }
+    const glm::vec3 point =
+        rotation * glm::vec3(xyz[i * 3], xyz[i * 3 + 1], depth) + camera;
+    const glm::vec3 ray = glm::normalize(point - camera);
+
+    for (float offset = -truncation; offset <= truncation + 1e-6f;
+         offset += step) {
+      const glm::vec3 sample = point + ray * offset;
+      int32_t block[3];
+      bool in_range = true;
+      for (int axis = 0; axis < 3; ++axis) {
+        block[axis] = FloorToInt(sample[axis] * inverse_block_size);
+        in_range = in_range && std::abs(block[axis]) < max_block_coordinate;
+      }
+      // Neighboring samples mostly fall into the same block.
+      if (!in_range || (has_last_block && block[0] == last_block[0] &&
+                        block[1] == last_block[1] &&
+                        block[2] == last_block[2])) {
+        continue;
+      }
+      std::copy(block, block + 3, last_block);
+      has_last_block = true;
+
+      const int32_t index = AcquireBlock(block[0], block[1], block[2]);
+      if (index >= 0 && blocks_[index].revision != revision_) {
+        blocks_[index].revision = revision_;
+        frame_blocks_.push_back(index);
+      }
+    }
+  }
+}
+
+void TsdfVolume::IntegrateBlock(int32_t index,
+                                const glm::mat4& depth_T_volume) {
+  Block& block = blocks_[index];
+  const float voxel_size = options_.voxel_size;
+  const glm::vec3 origin =
+      glm::vec3(block.x, block.y, block.z) * (voxel_size * kBlockSize) +
+      glm::vec3(0.5f * voxel_size);
+
+  // Walk the voxel centers in the camera frame incrementally.
+  const glm::mat3 rotation(depth_T_volume);
+  const glm::vec3 step_x = rotation[0] * voxel_size;
+  const glm::vec3 step_y = rotation[1] * voxel_size;
+  const glm::vec3 step_z = rotation[2] * voxel_size;
+  const projection::CameraIntrinsics& image = image_intrinsics_;
+
+  float voxel_depths[kVoxelsPerBlock];
+  float measured_depths[kVoxelsPerBlock];
+  glm::vec3 plane_start = glm::vec3(depth_T_volume * glm::vec4(origin, 1.0f));
+  int i = 0;
+  for (int z = 0; z < kBlockSize; ++z, plane_start += step_z) {
+    glm::vec3 row_start = plane_start;
+    for (int y = 0; y < kBlockSize; ++y, row_start += step_y) {
+      glm::vec3 voxel = row_start;
+      for (int x = 0; x < kBlockSize; ++x, ++i, voxel += step_x) {
+        voxel_depths[i] = voxel.z;
+        measured_depths[i] = 0.0f;
+        if (!(voxel.z > 0.0f)) {
+          continue;
+        }
+        const float inverse_depth = 1.0f / voxel.z;
+        const float pixel_x = image.fx * voxel.x * inverse_depth + image.cx;
+        const float pixel_y = image.fy * voxel.y * inverse_depth + image.cy;
+        if (pixel_x >= 0.0f && pixel_x < image.width && pixel_y >= 0.0f &&
+            pixel_y < image.height) {
+          measured_depths[i] =
+              depth_image_[static_cast<int>(pixel_y) * image.width +
+                           static_cast<int>(pixel_x)];
+        }
+      }
+    }
+  }
+
+  internal::UpdateVoxels(voxel_depths, measured_depths, kVoxelsPerBlock,
+                         options_.truncation_distance, options_.max_weight,
+                         block.distance, block.weight);
+}
+
+}  // namespace tango_gl
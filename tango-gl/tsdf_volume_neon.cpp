@@ -0,0 +1,69 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// This file is only compiled with NEON enabled (the ".neon" suffix in
+// Android.mk), the kernel is selected at runtime by tsdf_volume.cpp.
+
+#include <arm_neon.h>
+
+#include "tango-gl/tsdf_volume.h"
+
+namespace tango_gl {
+namespace internal {
+
+void UpdateVoxelsNeon(const float* voxel_depths, const float* measured_depths,
+                      size_t count, float truncation_distance,
+                      float max_weight, float* distances, float* weights) {
+  const float32x4_t zero = vdupq_n_f32(0.0f);
+  const float32x4_t one = vdupq_n_f32(1.0f);
+  const float32x4_t truncation = vdupq_n_f32(truncation_distance);
+  const float32x4_t negative_truncation = vdupq_n_f32(-truncation_distance);
+  const float32x4_t weight_limit = vdupq_n_f32(max_weight);
+
+  const size_t vector_count = count & ~static_cast<size_t>(3);
+  for (size_t i = 0; i < vector_count; i += 4) {
+    const float32x4_t measured_depth = vld1q_f32(measured_depths + i);
+    const float32x4_t distance =
+        vsubq_f32(measured_depth, vld1q_f32(voxel_depths + i));
+    // Same rejection as the scalar loop: no surface at the pixel, or the
+    // voxel is hidden behind it.
+    const uint32x4_t is_observed =
+        vandq_u32(vcgtq_f32(measured_depth, zero),
+                  vcgeq_f32(distance, negative_truncation));
+
+    const float32x4_t weight = vld1q_f32(weights + i);
+    const float32x4_t old_distance = vld1q_f32(distances + i);
+    const float32x4_t next_weight = vaddq_f32(weight, one);
+    // The weight is at least 1, two Newton steps refine the estimate to
+    // about float precision.
+    float32x4_t inverse = vrecpeq_f32(next_weight);
+    inverse = vmulq_f32(vrecpsq_f32(next_weight, inverse), inverse);
+    inverse = vmulq_f32(vrecpsq_f32(next_weight, inverse), inverse);
+
+    const float32x4_t sum = vmlaq_f32(vminq_f32(distance, truncation),
+                                      old_distance, weight);
+    const float32x4_t new_distance = vmulq_f32(sum, inverse);
+    const float32x4_t new_weight = vminq_f32(next_weight, weight_limit);
+
+    vst1q_f32(distances + i, vbslq_f32(is_observed, new_distance,
+                                       old_distance));
+    vst1q_f32(weights + i, vbslq_f32(is_observed, new_weight, weight));
+  }
+}
+
+}  // namespace internal
+}  // namespace tango_gl
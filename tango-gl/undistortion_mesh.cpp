@@ -0,0 +1,139 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "tango-gl/undistortion_mesh.h"
+#include "tango-gl/counters.h"
+
+namespace {
+// The grid is indexed with GLushort.
+const uint32_t kMaxGridSamples = 65536;
+}  // namespace
+
+namespace tango_gl {
+
+UndistortionMesh::UndistortionMesh()
+    : is_dirty_(true),
+      vertex_buffer_(GL_ARRAY_BUFFER, GL_STATIC_DRAW),
+      texture_coords_buffer_(GL_ARRAY_BUFFER, GL_STATIC_DRAW),
+      index_buffer_(GL_ELEMENT_ARRAY_BUFFER, GL_STATIC_DRAW),
+      recorded_attrib_vertices_(0),
+      recorded_attrib_texture_coords_(0) {
+  BuildGrid(2, 2, nullptr);
+}
+
+void UndistortionMesh::SetDistortionMap(
+    const CameraIntrinsicsRegistry::DistortionMap* map) {
+  if (map == nullptr) {
+    BuildGrid(2, 2, nullptr);
+    return;
+  }
+  if (map->grid_width < 2 || map->grid_height < 2 ||
+      map->grid_width * map->grid_height > kMaxGridSamples ||
+      map->texture_coords.size() != map->grid_width * map->grid_height) {
+    LOGE("UndistortionMesh: Unsupported distortion map of %u by %u samples.",
+         map->grid_width, map->grid_height);
+    BuildGrid(2, 2, nullptr);
+    return;
+  }
+  BuildGrid(map->grid_width, map->grid_height, map);
+}
+
+void UndistortionMesh::BuildGrid(
+    uint32_t grid_width, uint32_t grid_height,
+    const CameraIntrinsicsRegistry::DistortionMap* map) {
+  const uint32_t sample_count = grid_width * grid_height;
+  vertices_.resize(sample_count * 3);
+  texture_coords_.resize(sample_count * 2);
+  for (uint32_t j = 0; j < grid_height; ++j) {
+    const float v = static_cast<float>(j) / (grid_height - 1);
+    for (uint32_t i = 0; i < grid_width; ++i) {
+      const float u = static_cast<float>(i) / (grid_width - 1);
+      const uint32_t sample = j * grid_width + i;
+      vertices_[sample * 3] = 2.0f * u - 1.0f;
+      vertices_[sample * 3 + 1] = 1.0f - 2.0f * v;
+      vertices_[sample * 3 + 2] = 0.0f;
+      const glm::vec2 uv =
+          map != nullptr ? map->texture_coords[sample] : glm::vec2(u, v);
+      texture_coords_[sample * 2] = uv.x;
+      texture_coords_[sample * 2 + 1] = uv.y;
+    }
+  }
+
+  indices_.clear();
+  indices_.reserve((grid_width - 1) * (grid_height - 1) * 6);
+  for (uint32_t j = 0; j + 1 < grid_height; ++j) {
+    for (uint32_t i = 0; i + 1 < grid_width; ++i) {
+      const GLushort top_left = static_cast<GLushort>(j * grid_width + i);
+      const GLushort bottom_left = static_cast<GLushort>(top_left + grid_width);
+      indices_.push_back(top_left);
+      indices_.push_back(bottom_left);
+      indices_.push_back(top_left + 1);
+      indices_.push_back(top_left + 1);
+      indices_.push_back(bottom_left);
+      indices_.push_back(bottom_left + 1);
+    }
+  }
+  is_dirty_ = true;
+}
+
+void UndistortionMesh::Draw(GLuint attrib_vertices,
+                            GLuint attrib_texture_coords) const {
+  if (is_dirty_) {
+    vertex_buffer_.Update(vertices_.data(), vertices_.size() * sizeof(GLfloat),
+                          0);
+    texture_coords_buffer_.Update(texture_coords_.data(),
+                                  texture_coords_.size() * sizeof(GLfloat), 0);
+    index_buffer_.Update(indices_.data(), indices_.size() * sizeof(GLushort),
+                         0);
+    is_dirty_ = false;
+    vertex_array_.Reset();
+  }
+  if (attrib_vertices != recorded_attrib_vertices_ ||
+      attrib_texture_coords != recorded_attrib_texture_coords_) {
+    recorded_attrib_vertices_ = attrib_vertices;
+    recorded_attrib_texture_coords_ = attrib_texture_coords;
+    vertex_array_.Reset();
+  }
+
+  if (!vertex_array_.Bind()) {
+    vertex_buffer_.Bind();
+    vertex_array_.EnableAttribute(attrib_vertices);
+    glVertexAttribPointer(attrib_vertices, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
+
+    texture_coords_buffer_.Bind();
+    vertex_array_.EnableAttribute(attrib_texture_coords);
+    glVertexAttribPointer(attrib_texture_coords, 2, GL_FLOAT, GL_FALSE, 0,
+                          nullptr);
+
+    index_buffer_.Bind();
+  }
+  Counters::Increment(Counters::kDrawCalls);
+  glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(indices_.size()),
+                 GL_UNSIGNED_SHORT, 0);
+  vertex_array_.Unbind();
+  util::CheckGlError("UndistortionMesh::Draw");
+}
+
+void UndistortionMesh::Invalidate() {
+  vertex_buffer_.Invalidate();
+  texture_coords_buffer_.Invalidate();
+  index_buffer_.Invalidate();
+  vertex_array_.Invalidate();
+  is_dirty_ = true;
+}
+
+}  // namespace tango_gl
@@ -0,0 +1,254 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <string.h>
+
+#include <vector>
+
+#include "tango-gl/render_state.h"
+#include "tango-gl/upload_thread.h"
+#include "tango-gl/util.h"
+
+namespace {
+bool HasExtension(EGLDisplay display, const char* name) {
+  const char* extensions = eglQueryString(display, EGL_EXTENSIONS);
+  return extensions != nullptr && strstr(extensions, name) != nullptr;
+}
+}  // namespace
+
+namespace tango_gl {
+
+UploadThread::UploadThread()
+    : display_(EGL_NO_DISPLAY),
+      context_(EGL_NO_CONTEXT),
+      surface_(EGL_NO_SURFACE),
+      create_sync_(nullptr),
+      destroy_sync_(nullptr),
+      client_wait_sync_(nullptr),
+      is_uploading_(false),
+      is_stopping_(false) {}
+
+UploadThread::~UploadThread() { Stop(); }
+
+bool UploadThread::Start() {
+  if (IsRunning()) {
+    return true;
+  }
+  if (!CreateContext()) {
+    DestroyContext();
+    return false;
+  }
+  is_stopping_ = false;
+  thread_ = std::thread(&UploadThread::ThreadLoop, this);
+  return true;
+}
+
+void UploadThread::Stop() {
+  if (IsRunning()) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      is_stopping_ = true;
+    }
+    work_available_.notify_one();
+    // The thread runs the queued uploads before it exits.
+    thread_.join();
+    for (Upload& upload : uploaded_) {
+      if (upload.fence != EGL_NO_SYNC_KHR) {
+        client_wait_sync_(display_, upload.fence, 0, EGL_FOREVER_KHR);
+      }
+    }
+  }
+  Poll();
+  DestroyContext();
+}
+
+void UploadThread::Post(const Task& upload, const Task& on_ready) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    queue_.push_back(Upload{upload, on_ready, EGL_NO_SYNC_KHR});
+  }
+  if (IsRunning()) {
+    work_available_.notify_one();
+  }
+}
+
+int UploadThread::Poll() {
+  std::vector<Upload> inline_uploads;
+  std::vector<Upload> ready;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!IsRunning()) {
+      inline_uploads.assign(queue_.begin(), queue_.end());
+      queue_.clear();
+    }
+    while (!uploaded_.empty()) {
+      Upload& upload = uploaded_.front();
+      if (upload.fence != EGL_NO_SYNC_KHR) {
+        if (client_wait_sync_(display_, upload.fence, 0, 0) !=
+            EGL_CONDITION_SATISFIED_KHR) {
+          break;
+        }
+        destroy_sync_(display_, upload.fence);
+      }
+      ready.push_back(std::move(upload));
+      uploaded_.pop_front();
+    }
+  }
+
+  // Outside the lock, completions may post further uploads.
+  if (!inline_uploads.empty()) {
+    for (Upload& upload : inline_uploads) {
+      if (upload.upload) {
+        upload.upload();
+      }
+    }
+    // The uploads bound objects behind the back of RenderState.
+    RenderState::Invalidate();
+    for (Upload& upload : inline_uploads) {
+      ready.push_back(std::move(upload));
+    }
+  }
+  for (Upload& upload : ready) {
+    if (upload.on_ready) {
+      upload.on_ready();
+    }
+  }
+  return static_cast<int>(ready.size());
+}
+
+size_t UploadThread::GetPendingCount() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return queue_.size() + uploaded_.size() + (is_uploading_ ? 1 : 0);
+}
+
+bool UploadThread::CreateContext() {
+  display_ = eglGetCurrentDisplay();
+  EGLContext shared_context = eglGetCurrentContext();
+  if (display_ == EGL_NO_DISPLAY || shared_context == EGL_NO_CONTEXT) {
+    LOGE("UploadThread: no current context, uploading on the GL thread.");
+    return false;
+  }
+  if (!HasExtension(display_, "EGL_KHR_fence_sync")) {
+    LOGE("UploadThread: no EGL_KHR_fence_sync, uploading on the GL thread.");
+    return false;
+  }
+  create_sync_ = reinterpret_cast<PFNEGLCREATESYNCKHRPROC>(
+      eglGetProcAddress("eglCreateSyncKHR"));
+  destroy_sync_ = reinterpret_cast<PFNEGLDESTROYSYNCKHRPROC>(
+      eglGetProcAddress("eglDestroySyncKHR"));
+  client_wait_sync_ = reinterpret_cast<PFNEGLCLIENTWAITSYNCKHRPROC>(
+      eglGetProcAddress("eglClientWaitSyncKHR"));
+  if (create_sync_ == nullptr || destroy_sync_ == nullptr ||
+      client_wait_sync_ == nullptr) {
+    LOGE("UploadThread: no fence functions, uploading on the GL thread.");
+    return false;
+  }
+
+  // The shared context uses the configuration and client version of the GL
+  // thread context, contexts of different versions may not share.
+  EGLint config_id = 0;
+  EGLint client_version = 2;
+  eglQueryContext(display_, shared_context, EGL_CONFIG_ID, &config_id);
+  eglQueryContext(display_, shared_context, EGL_CONTEXT_CLIENT_VERSION,
+                  &client_version);
+  const bool is_surfaceless =
+      HasExtension(display_, "EGL_KHR_surfaceless_context");
+  const EGLint config_attributes[] = {EGL_CONFIG_ID, config_id, EGL_NONE};
+  const EGLint pbuffer_config_attributes[] = {
+      EGL_SURFACE_TYPE, EGL_PBUFFER_BIT, EGL_RENDERABLE_TYPE,
+      EGL_OPENGL_ES2_BIT, EGL_NONE};
+  EGLConfig config;
+  EGLint config_count = 0;
+  if (!eglChooseConfig(display_,
+                       is_surfaceless ? config_attributes
+                                      : pbuffer_config_attributes,
+                       &config, 1, &config_count) ||
+      config_count == 0) {
+    LOGE("UploadThread: no EGL configuration, uploading on the GL thread.");
+    return false;
+  }
+  if (!is_surfaceless) {
+    const EGLint surface_attributes[] = {EGL_WIDTH, 1, EGL_HEIGHT, 1,
+                                         EGL_NONE};
+    surface_ = eglCreatePbufferSurface(display_, config, surface_attributes);
+    if (surface_ == EGL_NO_SURFACE) {
+      LOGE("UploadThread: no pbuffer, uploading on the GL thread.");
+      return false;
+    }
+  }
+  const EGLint context_attributes[] = {EGL_CONTEXT_CLIENT_VERSION,
+                                       client_version, EGL_NONE};
+  context_ = eglCreateContext(display_, config, shared_context,
+                              context_attributes);
+  if (context_ == EGL_NO_CONTEXT) {
+    LOGE("UploadThread: could not create the shared context (0x%x), "
+         "uploading on the GL thread.", eglGetError());
+    return false;
+  }
+  return true;
+}
+
+void UploadThread::DestroyContext() {
+  if (context_ != EGL_NO_CONTEXT) {
+    eglDestroyContext(display_, context_);
+  }
+  if (surface_ != EGL_NO_SURFACE) {
+    eglDestroySurface(display_, surface_);
+  }
+  context_ = EGL_NO_CONTEXT;
+  surface_ = EGL_NO_SURFACE;
+  display_ = EGL_NO_DISPLAY;
+}
+
+void UploadThread::ThreadLoop() {
+  if (!eglMakeCurrent(display_, surface_, surface_, context_)) {
+    LOGE("UploadThread: could not make the shared context current (0x%x).",
+         eglGetError());
+  }
+  while (true) {
+    Upload upload;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      work_available_.wait(
+          lock, [this] { return is_stopping_ || !queue_.empty(); });
+      if (queue_.empty()) {
+        break;
+      }
+      upload = std::move(queue_.front());
+      queue_.pop_front();
+      is_uploading_ = true;
+    }
+
+    if (upload.upload) {
+      upload.upload();
+    }
+    upload.fence = create_sync_(display_, EGL_SYNC_FENCE_KHR, nullptr);
+    if (upload.fence == EGL_NO_SYNC_KHR) {
+      glFinish();
+    } else {
+      // The fence only signals once it reached the GPU.
+      glFlush();
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    uploaded_.push_back(std::move(upload));
+    is_uploading_ = false;
+  }
+  eglMakeCurrent(display_, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+}
+
+}  // namespace tango_gl
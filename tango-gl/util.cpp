@@ -14,15 +14,124 @@
  * limitations under the License.
  */
 
+#include <EGL/egl.h>
+#include <string.h>
+
+#include <atomic>
+
 #include "tango-gl/util.h"
+#include "tango-gl/simd_math.h"
+
+namespace {
+// GL_KHR_debug, resolved at runtime since the platform headers of the
+// examples may predate it.
+const GLenum kDebugOutput = 0x92E0;
+const GLenum kDebugOutputSynchronous = 0x8242;
+const GLenum kDebugTypeError = 0x824C;
+const GLenum kDebugSeverityNotification = 0x826B;
+const GLenum kDontCare = 0x1100;
+
+typedef void (GL_APIENTRY* DebugProc)(GLenum source, GLenum type, GLuint id,
+                                      GLenum severity, GLsizei length,
+                                      const GLchar* message,
+                                      const void* user_param);
+typedef void (GL_APIENTRY* DebugMessageCallbackFunc)(DebugProc callback,
+                                                     const void* user_param);
+typedef void (GL_APIENTRY* DebugMessageControlFunc)(GLenum source, GLenum type,
+                                                    GLenum severity,
+                                                    GLsizei count,
+                                                    const GLuint* ids,
+                                                    GLboolean enabled);
+
+// About every 10 seconds at 30 frames per second.
+const int kDefaultGlErrorSampleInterval = 300;
+
+std::atomic<int> g_gl_error_sample_interval(kDefaultGlErrorSampleInterval);
+int g_frames_since_gl_error_sample = 0;
+
+#ifdef TANGO_GL_DEBUG
+// Context the debug callback is installed in.
+EGLContext g_debug_output_context = EGL_NO_CONTEXT;
+
+void GL_APIENTRY OnGlDebugMessage(GLenum, GLenum type, GLuint id, GLenum,
+                                  GLsizei, const GLchar* message,
+                                  const void*) {
+  if (type == kDebugTypeError) {
+    LOGE("GL error %u: %s", id, message);
+  } else {
+    LOGI("GL debug %u: %s", id, message);
+  }
+}
+#endif  // TANGO_GL_DEBUG
+}  // namespace
 
 namespace tango_gl {
 
+#ifdef TANGO_GL_DEBUG
 void util::CheckGlError(const char* operation) {
+  if (g_debug_output_context != EGL_NO_CONTEXT &&
+      eglGetCurrentContext() == g_debug_output_context) {
+    return;
+  }
   for (GLint error = glGetError(); error; error = glGetError()) {
     LOGI("after %s() glError (0x%x)\n", operation, error);
   }
 }
+#endif  // TANGO_GL_DEBUG
+
+bool util::EnableGlDebugOutput() {
+#ifdef TANGO_GL_DEBUG
+  const EGLContext context = eglGetCurrentContext();
+  if (context == EGL_NO_CONTEXT) {
+    return false;
+  }
+  if (context == g_debug_output_context) {
+    return true;
+  }
+  const char* extensions =
+      reinterpret_cast<const char*>(glGetString(GL_EXTENSIONS));
+  if (extensions == nullptr || strstr(extensions, "GL_KHR_debug") == nullptr) {
+    return false;
+  }
+  DebugMessageCallbackFunc debug_message_callback =
+      reinterpret_cast<DebugMessageCallbackFunc>(
+          eglGetProcAddress("glDebugMessageCallbackKHR"));
+  DebugMessageControlFunc debug_message_control =
+      reinterpret_cast<DebugMessageControlFunc>(
+          eglGetProcAddress("glDebugMessageControlKHR"));
+  if (debug_message_callback == nullptr) {
+    return false;
+  }
+  glEnable(kDebugOutput);
+  glEnable(kDebugOutputSynchronous);
+  debug_message_callback(OnGlDebugMessage, nullptr);
+  if (debug_message_control != nullptr) {
+    // Drivers are chatty about buffer placement and shader recompiles.
+    debug_message_control(kDontCare, kDontCare, kDebugSeverityNotification, 0,
+                          nullptr, GL_FALSE);
+  }
+  g_debug_output_context = context;
+  LOGI("GL_KHR_debug output enabled.");
+  return true;
+#else
+  return false;
+#endif  // TANGO_GL_DEBUG
+}
+
+void util::SetGlErrorSampleInterval(int frame_interval) {
+  g_gl_error_sample_interval = frame_interval;
+}
+
+void util::SampleGlErrors() {
+  const int interval = g_gl_error_sample_interval;
+  if (interval <= 0 || ++g_frames_since_gl_error_sample < interval) {
+    return;
+  }
+  g_frames_since_gl_error_sample = 0;
+  for (GLint error = glGetError(); error; error = glGetError()) {
+    LOGE("glError (0x%x) in the last %d frames", error, interval);
+  }
+}
 
 // Convenience function used in CreateProgram below.
 static GLuint LoadShader(GLenum shader_type, const char* shader_source) {
@@ -212,7 +321,7 @@ bool util::SegmentAABBIntersect(const glm::vec3& aabb_min,
 }
 
 glm::vec3 util::ApplyTransform(const glm::mat4& mat, const glm::vec3& vec) {
-  return glm::vec3(mat * glm::vec4(vec, 1.0f));
+  return simd_math::TransformPoint(mat, vec);
 }
 
 }  // namespace tango_gl
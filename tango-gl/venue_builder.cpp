@@ -0,0 +1,388 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "tango-gl/venue_builder.h"
+
+#include <stdio.h>
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <limits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "tango-gl/obj_loader.h"
+#include "tango-gl/util.h"
+
+namespace {
+// Bits per coordinate in a cell key, the grid is centered on the origin.
+const int kKeyBits = 21;
+const int32_t kKeyBias = 1 << (kKeyBits - 1);
+const uint64_t kKeyMask = (1ull << kKeyBits) - 1;
+
+// Vertices per part, the range of a 16 bit index.
+const uint32_t kMaxPartVertexCount = 65536;
+
+inline int32_t FloorToInt(float value) {
+  return static_cast<int32_t>(std::floor(value));
+}
+
+inline uint64_t CellKey(int32_t x, int32_t y, int32_t z) {
+  return (static_cast<uint64_t>(x + kKeyBias) & kKeyMask) |
+         ((static_cast<uint64_t>(y + kKeyBias) & kKeyMask) << kKeyBits) |
+         ((static_cast<uint64_t>(z + kKeyBias) & kKeyMask) << (2 * kKeyBits));
+}
+
+inline int32_t CellCoordinate(uint64_t key, int axis) {
+  return static_cast<int32_t>((key >> (axis * kKeyBits)) & kKeyMask) -
+         kKeyBias;
+}
+
+inline uint64_t PointCellKey(const glm::vec3& point, float inverse_size) {
+  return CellKey(FloorToInt(point.x * inverse_size),
+                 FloorToInt(point.y * inverse_size),
+                 FloorToInt(point.z * inverse_size));
+}
+
+// The model at one level: vertices, and the vertex of every source vertex.
+struct LevelModel {
+  std::vector<glm::vec3> positions;
+  std::vector<glm::vec3> normals;
+  std::vector<uint32_t> remap;
+  float error;
+};
+
+// Level data of a chunk, laid out as in the file.
+struct LevelData {
+  std::vector<tango_gl::venue::PartRecord> parts;
+  std::vector<float> vertices;
+  std::vector<uint16_t> indices;
+};
+
+// Merge the vertices of a model on a grid of cells.
+void ClusterModel(const LevelModel& source, float cell_size,
+                  LevelModel* level) {
+  const float inverse_size = 1.0f / cell_size;
+  std::unordered_map<uint64_t, uint32_t> clusters;
+  std::vector<float> counts;
+  level->positions.clear();
+  level->normals.clear();
+  level->remap.resize(source.positions.size());
+  for (size_t i = 0; i < source.positions.size(); ++i) {
+    const uint64_t key = PointCellKey(source.positions[i], inverse_size);
+    auto inserted = clusters.insert(
+        std::make_pair(key, static_cast<uint32_t>(level->positions.size())));
+    const uint32_t cluster = inserted.first->second;
+    if (inserted.second) {
+      level->positions.push_back(glm::vec3(0.0f));
+      level->normals.push_back(glm::vec3(0.0f));
+      counts.push_back(0.0f);
+    }
+    level->positions[cluster] += source.positions[i];
+    level->normals[cluster] += source.normals[i];
+    counts[cluster] += 1.0f;
+    level->remap[i] = cluster;
+  }
+  for (size_t i = 0; i < level->positions.size(); ++i) {
+    level->positions[i] /= counts[i];
+    const float length = glm::length(level->normals[i]);
+    level->normals[i] = length > 1e-6f ? level->normals[i] / length
+                                       : glm::vec3(0.0f, 1.0f, 0.0f);
+  }
+  level->error = cell_size;
+}
+
+// Collect the triangles of a chunk at a level into parts, dropping the
+// triangles that collapsed.
+void BuildLevelData(const std::vector<uint32_t>& source_indices,
+                    const std::vector<uint32_t>& triangles,
+                    const LevelModel& model, LevelData* data,
+                    std::unordered_map<uint32_t, uint16_t>* local_indices) {
+  data->parts.clear();
+  data->vertices.clear();
+  data->indices.clear();
+  tango_gl::venue::PartRecord part = {0, 0, 0, 0};
+  local_indices->clear();
+  for (uint32_t triangle : triangles) {
+    uint32_t corners[3];
+    for (int k = 0; k < 3; ++k) {
+      corners[k] = model.remap[source_indices[triangle * 3 + k]];
+    }
+    if (corners[0] == corners[1] || corners[1] == corners[2] ||
+        corners[2] == corners[0]) {
+      continue;
+    }
+    uint32_t new_count = 0;
+    for (int k = 0; k < 3; ++k) {
+      new_count += local_indices->count(corners[k]) == 0 ? 1 : 0;
+    }
+    if (part.vertex_count + new_count > kMaxPartVertexCount) {
+      data->parts.push_back(part);
+      part.first_vertex += part.vertex_count;
+      part.first_index += part.index_count;
+      part.vertex_count = 0;
+      part.index_count = 0;
+      local_indices->clear();
+    }
+    for (int k = 0; k < 3; ++k) {
+      auto inserted = local_indices->insert(std::make_pair(
+          corners[k], static_cast<uint16_t>(part.vertex_count)));
+      if (inserted.second) {
+        const glm::vec3& position = model.positions[corners[k]];
+        const glm::vec3& normal = model.normals[corners[k]];
+        data->vertices.insert(data->vertices.end(),
+                              {position.x, position.y, position.z, normal.x,
+                               normal.y, normal.z});
+        ++part.vertex_count;
+      }
+      data->indices.push_back(inserted.first->second);
+      ++part.index_count;
+    }
+  }
+  if (part.index_count > 0) {
+    data->parts.push_back(part);
+  }
+}
+
+bool WriteAll(FILE* file, const void* data, size_t size) {
+  return size == 0 || fwrite(data, size, 1, file) == 1;
+}
+
+// Pad the file with zeros to the next page boundary.
+bool PadToPage(FILE* file, uint64_t* offset) {
+  static const uint8_t kZeros[tango_gl::venue::kPageSize] = {};
+  const uint64_t padding =
+      (tango_gl::venue::kPageSize - *offset % tango_gl::venue::kPageSize) %
+      tango_gl::venue::kPageSize;
+  *offset += padding;
+  return WriteAll(file, kZeros, padding);
+}
+}  // namespace
+
+namespace tango_gl {
+namespace venue {
+
+bool Build(const char* obj_path, const char* venue_path,
+           const BuildOptions& options) {
+  if (options.level_count < 1 || options.level_count > kMaxLevelCount ||
+      !(options.chunk_size > 0.0f) || !(options.cluster_size > 0.0f)) {
+    LOGE("venue::Build: invalid options.");
+    return false;
+  }
+  std::vector<GLfloat> vertices;
+  std::vector<GLfloat> normals;
+  std::vector<GLuint> indices;
+  if (!obj_loader::LoadOBJData(obj_path, vertices, normals, indices)) {
+    return false;
+  }
+
+  // Level 0 is the source model, with area weighted normals where the file
+  // has none.
+  std::vector<LevelModel> levels(options.level_count);
+  LevelModel& source = levels[0];
+  const size_t vertex_count = vertices.size() / 3;
+  source.positions.resize(vertex_count);
+  source.normals.resize(vertex_count);
+  source.remap.resize(vertex_count);
+  source.error = 0.0f;
+  std::vector<glm::vec3> face_normals(vertex_count, glm::vec3(0.0f));
+  for (size_t i = 0; i < vertex_count; ++i) {
+    source.positions[i] = glm::vec3(vertices[i * 3], vertices[i * 3 + 1],
+                                    vertices[i * 3 + 2]);
+    source.normals[i] =
+        glm::vec3(normals[i * 3], normals[i * 3 + 1], normals[i * 3 + 2]);
+    source.remap[i] = static_cast<uint32_t>(i);
+  }
+  const size_t triangle_count = indices.size() / 3;
+  for (size_t t = 0; t < triangle_count; ++t) {
+    const glm::vec3& a = source.positions[indices[t * 3]];
+    const glm::vec3& b = source.positions[indices[t * 3 + 1]];
+    const glm::vec3& c = source.positions[indices[t * 3 + 2]];
+    const glm::vec3 normal = glm::cross(b - a, c - a);
+    for (int k = 0; k < 3; ++k) {
+      face_normals[indices[t * 3 + k]] += normal;
+    }
+  }
+  for (size_t i = 0; i < vertex_count; ++i) {
+    if (glm::length(source.normals[i]) < 1e-6f) {
+      const float length = glm::length(face_normals[i]);
+      source.normals[i] = length > 1e-12f ? face_normals[i] / length
+                                          : glm::vec3(0.0f, 1.0f, 0.0f);
+    }
+  }
+  std::vector<GLfloat>().swap(vertices);
+  std::vector<GLfloat>().swap(normals);
+  std::vector<glm::vec3>().swap(face_normals);
+  for (int level = 1; level < options.level_count; ++level) {
+    ClusterModel(source,
+                 options.cluster_size * static_cast<float>(1 << (level - 1)),
+                 &levels[level]);
+  }
+
+  // Triangles grouped by the chunk of their centroid.
+  const float inverse_chunk_size = 1.0f / options.chunk_size;
+  std::vector<std::pair<uint64_t, uint32_t>> keyed_triangles;
+  keyed_triangles.reserve(triangle_count);
+  for (size_t t = 0; t < triangle_count; ++t) {
+    const glm::vec3 centroid = (source.positions[indices[t * 3]] +
+                                source.positions[indices[t * 3 + 1]] +
+                                source.positions[indices[t * 3 + 2]]) /
+                               3.0f;
+    keyed_triangles.push_back(std::make_pair(
+        PointCellKey(centroid, inverse_chunk_size), static_cast<uint32_t>(t)));
+  }
+  std::sort(keyed_triangles.begin(), keyed_triangles.end());
+
+  std::vector<std::pair<size_t, size_t>> chunk_ranges;
+  int32_t grid_min[3];
+  int32_t grid_max[3];
+  std::fill(grid_min, grid_min + 3, std::numeric_limits<int32_t>::max());
+  std::fill(grid_max, grid_max + 3, std::numeric_limits<int32_t>::min());
+  for (size_t i = 0; i < keyed_triangles.size();) {
+    size_t end = i;
+    while (end < keyed_triangles.size() &&
+           keyed_triangles[end].first == keyed_triangles[i].first) {
+      ++end;
+    }
+    chunk_ranges.push_back(std::make_pair(i, end));
+    for (int axis = 0; axis < 3; ++axis) {
+      const int32_t coordinate = CellCoordinate(keyed_triangles[i].first, axis);
+      grid_min[axis] = std::min(grid_min[axis], coordinate);
+      grid_max[axis] = std::max(grid_max[axis], coordinate);
+    }
+    i = end;
+  }
+  if (chunk_ranges.empty()) {
+    LOGE("venue::Build: %s has no triangles.", obj_path);
+    return false;
+  }
+
+  FileHeader header = {};
+  header.magic = kMagic;
+  header.version = kVersion;
+  header.level_count = static_cast<uint32_t>(options.level_count);
+  header.chunk_count = static_cast<uint32_t>(chunk_ranges.size());
+  header.chunk_size = options.chunk_size;
+  size_t grid_cell_count = 1;
+  for (int axis = 0; axis < 3; ++axis) {
+    header.grid_origin[axis] = grid_min[axis];
+    header.grid_size[axis] =
+        static_cast<uint32_t>(grid_max[axis] - grid_min[axis] + 1);
+    grid_cell_count *= header.grid_size[axis];
+  }
+  header.grid_offset = sizeof(FileHeader);
+  header.chunk_offset = header.grid_offset + grid_cell_count * sizeof(int32_t);
+
+  std::vector<int32_t> grid(grid_cell_count, -1);
+  std::vector<ChunkRecord> chunks(chunk_ranges.size());
+  for (size_t i = 0; i < chunk_ranges.size(); ++i) {
+    const uint64_t key = keyed_triangles[chunk_ranges[i].first].first;
+    size_t cell = 0;
+    for (int axis = 2; axis >= 0; --axis) {
+      cell = cell * header.grid_size[axis] +
+             (CellCoordinate(key, axis) - grid_min[axis]);
+    }
+    grid[cell] = static_cast<int32_t>(i);
+  }
+
+  FILE* file = fopen(venue_path, "wb");
+  if (file == nullptr) {
+    LOGE("venue::Build: could not create %s.", venue_path);
+    return false;
+  }
+  // The chunk table is written again once the levels are placed.
+  bool is_written = WriteAll(file, &header, sizeof(header)) &&
+                    WriteAll(file, grid.data(), grid.size() * sizeof(int32_t)) &&
+                    WriteAll(file, chunks.data(),
+                             chunks.size() * sizeof(ChunkRecord));
+  uint64_t offset = header.chunk_offset + chunks.size() * sizeof(ChunkRecord);
+
+  std::vector<uint32_t> triangles;
+  LevelData data;
+  std::unordered_map<uint32_t, uint16_t> local_indices;
+  for (size_t i = 0; i < chunk_ranges.size() && is_written; ++i) {
+    triangles.clear();
+    for (size_t k = chunk_ranges[i].first; k < chunk_ranges[i].second; ++k) {
+      triangles.push_back(keyed_triangles[k].second);
+    }
+    ChunkRecord& chunk = chunks[i];
+    glm::vec3 min(FLT_MAX);
+    glm::vec3 max(-FLT_MAX);
+    for (int level = 0; level < options.level_count && is_written; ++level) {
+      BuildLevelData(indices, triangles, levels[level], &data,
+                     &local_indices);
+      const size_t level_vertex_count =
+          data.vertices.size() / kVertexFloatCount;
+      for (size_t v = 0; v < level_vertex_count; ++v) {
+        const glm::vec3 position(data.vertices[v * kVertexFloatCount],
+                                 data.vertices[v * kVertexFloatCount + 1],
+                                 data.vertices[v * kVertexFloatCount + 2]);
+        min = glm::min(min, position);
+        max = glm::max(max, position);
+      }
+
+      is_written = PadToPage(file, &offset);
+      LevelRecord& record = chunk.levels[level];
+      record.offset = offset;
+      record.size = static_cast<uint32_t>(
+          data.parts.size() * sizeof(PartRecord) +
+          data.vertices.size() * sizeof(float) +
+          data.indices.size() * sizeof(uint16_t));
+      record.part_count = static_cast<uint32_t>(data.parts.size());
+      record.vertex_count = static_cast<uint32_t>(level_vertex_count);
+      record.index_count = static_cast<uint32_t>(data.indices.size());
+      record.error = levels[level].error;
+      is_written =
+          is_written &&
+          WriteAll(file, data.parts.data(),
+                   data.parts.size() * sizeof(PartRecord)) &&
+          WriteAll(file, data.vertices.data(),
+                   data.vertices.size() * sizeof(float)) &&
+          WriteAll(file, data.indices.data(),
+                   data.indices.size() * sizeof(uint16_t));
+      offset += record.size;
+    }
+    if (min.x > max.x) {
+      // Every level collapsed, e.g. a chunk of degenerate triangles.
+      min = max = glm::vec3(0.0f);
+    }
+    for (int axis = 0; axis < 3; ++axis) {
+      chunk.min[axis] = min[axis];
+      chunk.max[axis] = max[axis];
+    }
+  }
+
+  is_written = is_written &&
+               fseek(file, static_cast<long>(header.chunk_offset), SEEK_SET) ==
+                   0 &&
+               WriteAll(file, chunks.data(),
+                        chunks.size() * sizeof(ChunkRecord));
+  is_written = fclose(file) == 0 && is_written;
+  if (!is_written) {
+    LOGE("venue::Build: could not write %s.", venue_path);
+    remove(venue_path);
+    return false;
+  }
+  LOGI("venue::Build: %zu triangles in %zu chunks of %d levels.",
+       triangle_count, chunk_ranges.size(), options.level_count);
+  return true;
+}
+
+}  // namespace venue
+}  // namespace tango_gl
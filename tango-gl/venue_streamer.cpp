@@ -0,0 +1,547 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <utility>
+
+#include "tango-gl/counters.h"
+#include "tango-gl/memory_tracker.h"
+#include "tango-gl/mesh.h"
+#include "tango-gl/program_cache.h"
+#include "tango-gl/render_state.h"
+#include "tango-gl/shader_variants.h"
+#include "tango-gl/venue_streamer.h"
+
+namespace {
+const GLsizei kVertexStride =
+    tango_gl::venue::kVertexFloatCount * sizeof(GLfloat);
+
+inline int32_t FloorToInt(float value) {
+  return static_cast<int32_t>(std::floor(value));
+}
+
+// Whether the counts of a level add up to its size, and it lies in the file.
+bool IsValidLevel(const tango_gl::venue::LevelRecord& record,
+                  uint64_t file_size) {
+  const uint64_t size =
+      static_cast<uint64_t>(record.part_count) *
+          sizeof(tango_gl::venue::PartRecord) +
+      static_cast<uint64_t>(record.vertex_count) * kVertexStride +
+      static_cast<uint64_t>(record.index_count) * sizeof(GLushort);
+  return size == record.size && record.offset % tango_gl::venue::kPageSize == 0 &&
+         record.offset <= file_size && record.size <= file_size - record.offset;
+}
+}  // namespace
+
+namespace tango_gl {
+
+struct VenueStreamer::File {
+  File() : descriptor(-1), mapping(nullptr), mapping_size(0), size(0) {}
+  ~File() {
+    if (mapping != nullptr) {
+      munmap(mapping, mapping_size);
+    }
+    if (descriptor >= 0) {
+      close(descriptor);
+    }
+  }
+
+  int descriptor;
+  // Header, grid and chunk table.
+  void* mapping;
+  size_t mapping_size;
+  uint64_t size;
+};
+
+VenueStreamer::VenueStreamer(UploadThread* upload_thread)
+    : upload_thread_(upload_thread),
+      color_(0.8f, 0.8f, 0.8f),
+      light_direction_(glm::normalize(glm::vec3(-1.0f, -3.0f, -1.0f))),
+      grid_(nullptr),
+      chunk_records_(nullptr),
+      resident_bytes_(0),
+      pending_bytes_(0),
+      update_count_(0),
+      program_(0),
+      uniform_mvp_(-1),
+      uniform_mv_(-1),
+      uniform_color_(-1),
+      uniform_light_vec_(-1),
+      uniform_ambient_(-1),
+      attrib_vertices_(-1),
+      attrib_normals_(-1) {
+  std::memset(&header_, 0, sizeof(header_));
+}
+
+VenueStreamer::~VenueStreamer() { Close(); }
+
+void VenueStreamer::SetLightDirection(const glm::vec3& light_direction) {
+  light_direction_ = glm::normalize(light_direction);
+}
+
+bool VenueStreamer::Open(const char* path) {
+  Close();
+  std::shared_ptr<File> file = std::make_shared<File>();
+  file->descriptor = open(path, O_RDONLY);
+  if (file->descriptor < 0) {
+    LOGE("VenueStreamer: Could not open %s.", path);
+    return false;
+  }
+  struct stat file_stat;
+  venue::FileHeader header;
+  if (fstat(file->descriptor, &file_stat) != 0 ||
+      pread(file->descriptor, &header, sizeof(header), 0) !=
+          static_cast<ssize_t>(sizeof(header))) {
+    LOGE("VenueStreamer: Could not read %s.", path);
+    return false;
+  }
+  file->size = static_cast<uint64_t>(file_stat.st_size);
+  const uint64_t cell_count = static_cast<uint64_t>(header.grid_size[0]) *
+                              header.grid_size[1] * header.grid_size[2];
+  const uint64_t table_end =
+      header.chunk_offset +
+      static_cast<uint64_t>(header.chunk_count) * sizeof(venue::ChunkRecord);
+  if (header.magic != venue::kMagic || header.version != venue::kVersion ||
+      header.level_count == 0 || header.level_count > venue::kMaxLevelCount ||
+      header.chunk_count == 0 || !(header.chunk_size > 0.0f) ||
+      header.grid_offset != sizeof(header) ||
+      header.chunk_offset != header.grid_offset + cell_count * sizeof(int32_t) ||
+      table_end > file->size) {
+    LOGE("VenueStreamer: %s is not a venue file.", path);
+    return false;
+  }
+
+  // Pages of the table are only read in for the cells near the camera.
+  file->mapping_size = static_cast<size_t>(table_end);
+  file->mapping = mmap(nullptr, file->mapping_size, PROT_READ, MAP_PRIVATE,
+                       file->descriptor, 0);
+  if (file->mapping == MAP_FAILED) {
+    file->mapping = nullptr;
+    LOGE("VenueStreamer: Could not map %s.", path);
+    return false;
+  }
+  const uint8_t* base = static_cast<const uint8_t*>(file->mapping);
+  grid_ = reinterpret_cast<const int32_t*>(base + header.grid_offset);
+  chunk_records_ =
+      reinterpret_cast<const venue::ChunkRecord*>(base + header.chunk_offset);
+  header_ = header;
+  file_ = file;
+  return true;
+}
+
+void VenueStreamer::Close() {
+  Release();
+  file_.reset();
+  grid_ = nullptr;
+  chunk_records_ = nullptr;
+  std::memset(&header_, 0, sizeof(header_));
+}
+
+void VenueStreamer::Update(const glm::mat4& projection_mat,
+                           const glm::mat4& view_mat, int viewport_height) {
+  CollectUploads();
+  visible_chunks_.clear();
+  if (!file_ || !AcquireProgram()) {
+    return;
+  }
+  ++update_count_;
+  frustum_.SetMaxDistance(options_.max_distance);
+  frustum_.Update(projection_mat, view_mat);
+  const glm::vec3& eye = frustum_.GetEye();
+  const float pixels_per_meter =
+      projection_mat[1][1] * static_cast<float>(viewport_height) * 0.5f;
+  const float max_error = std::max(options_.max_screen_error, 1e-3f);
+
+  // Triangles may reach past their cell, look one cell farther.
+  const float reach = options_.max_distance + header_.chunk_size;
+  const float inverse_chunk_size = 1.0f / header_.chunk_size;
+  int32_t begin[3];
+  int32_t end[3];
+  for (int axis = 0; axis < 3; ++axis) {
+    const int32_t size = static_cast<int32_t>(header_.grid_size[axis]);
+    begin[axis] = std::max(
+        FloorToInt((eye[axis] - reach) * inverse_chunk_size) -
+            header_.grid_origin[axis],
+        0);
+    end[axis] = std::min(
+        FloorToInt((eye[axis] + reach) * inverse_chunk_size) -
+            header_.grid_origin[axis] + 1,
+        size);
+    if (begin[axis] >= end[axis]) {
+      return;
+    }
+  }
+
+  // Visible chunks without their level, by distance.
+  struct Candidate {
+    float distance;
+    int32_t chunk;
+    int level;
+    bool operator<(const Candidate& other) const {
+      return distance < other.distance;
+    }
+  };
+  std::vector<Candidate> candidates;
+  const int coarsest_level = static_cast<int>(header_.level_count) - 1;
+  for (int32_t z = begin[2]; z < end[2]; ++z) {
+    for (int32_t y = begin[1]; y < end[1]; ++y) {
+      const size_t row =
+          (static_cast<size_t>(z) * header_.grid_size[1] + y) *
+          header_.grid_size[0];
+      for (int32_t x = begin[0]; x < end[0]; ++x) {
+        const int32_t index = grid_[row + x];
+        if (index < 0 || static_cast<uint32_t>(index) >= header_.chunk_count) {
+          continue;
+        }
+        const venue::ChunkRecord& record = chunk_records_[index];
+        const glm::vec3 min(record.min[0], record.min[1], record.min[2]);
+        const glm::vec3 max(record.max[0], record.max[1], record.max[2]);
+        if (!frustum_.IsBoxVisible(min, max)) {
+          continue;
+        }
+        const glm::vec3 outside =
+            glm::max(glm::max(min - eye, eye - max), glm::vec3(0.0f));
+        const float distance = std::max(glm::length(outside), 1e-3f);
+        int level = coarsest_level;
+        while (level > 0 && record.levels[level].error * pixels_per_meter >
+                                max_error * distance) {
+          --level;
+        }
+        visible_chunks_.push_back(index);
+
+        auto chunk = chunks_.find(index);
+        if (chunk != chunks_.end()) {
+          chunk->second.last_visible = update_count_;
+          if (chunk->second.level == level ||
+              chunk->second.pending_level >= 0) {
+            continue;
+          }
+        }
+        candidates.push_back(Candidate{distance, index, level});
+      }
+    }
+  }
+
+  std::sort(candidates.begin(), candidates.end());
+  for (const Candidate& candidate : candidates) {
+    if (requests_.size() >=
+        static_cast<size_t>(std::max(options_.max_pending_uploads, 1))) {
+      break;
+    }
+    const venue::ChunkRecord& record = chunk_records_[candidate.chunk];
+    auto chunk = chunks_.find(candidate.chunk);
+    const bool has_level = chunk != chunks_.end() && chunk->second.level >= 0;
+    int level = candidate.level;
+    if (!MakeRoom(GetLevelSize(record.levels[level]))) {
+      // A chunk already drawn keeps its level, others get the coarsest.
+      if (has_level) {
+        continue;
+      }
+      level = coarsest_level;
+      if (!MakeRoom(GetLevelSize(record.levels[level]))) {
+        continue;
+      }
+    }
+    RequestLevel(candidate.chunk, level);
+  }
+}
+
+void VenueStreamer::Render(const glm::mat4& projection_mat,
+                           const glm::mat4& view_mat) const {
+  if (program_ == 0 || visible_chunks_.empty()) {
+    return;
+  }
+  RenderState::UseProgram(program_);
+  const glm::mat4 mvp_mat = projection_mat * view_mat;
+  glUniformMatrix4fv(uniform_mvp_, 1, GL_FALSE, glm::value_ptr(mvp_mat));
+  glUniformMatrix4fv(uniform_mv_, 1, GL_FALSE, glm::value_ptr(view_mat));
+  glUniform4f(uniform_color_, color_.r, color_.g, color_.b, 1.0f);
+  const glm::vec3 light_direction = glm::mat3(view_mat) * light_direction_;
+  glUniform3fv(uniform_light_vec_, 1, glm::value_ptr(light_direction));
+  glUniform4fv(uniform_ambient_, 1, glm::value_ptr(Mesh::GetAmbientLight()));
+
+  glEnableVertexAttribArray(attrib_vertices_);
+  glEnableVertexAttribArray(attrib_normals_);
+  for (int32_t index : visible_chunks_) {
+    auto chunk = chunks_.find(index);
+    if (chunk == chunks_.end() || chunk->second.level < 0 ||
+        chunk->second.buffers.parts.empty()) {
+      continue;
+    }
+    const LevelBuffers& buffers = chunk->second.buffers;
+    RenderState::BindBuffer(GL_ARRAY_BUFFER, buffers.vertex_buffer);
+    RenderState::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffers.index_buffer);
+    for (const venue::PartRecord& part : buffers.parts) {
+      const size_t vertex_offset =
+          static_cast<size_t>(part.first_vertex) * kVertexStride;
+      glVertexAttribPointer(attrib_vertices_, 3, GL_FLOAT, GL_FALSE,
+                            kVertexStride,
+                            reinterpret_cast<const GLvoid*>(vertex_offset));
+      glVertexAttribPointer(
+          attrib_normals_, 3, GL_FLOAT, GL_FALSE, kVertexStride,
+          reinterpret_cast<const GLvoid*>(vertex_offset +
+                                          3 * sizeof(GLfloat)));
+      Counters::Increment(Counters::kDrawCalls);
+      glDrawElements(GL_TRIANGLES, part.index_count, GL_UNSIGNED_SHORT,
+                     reinterpret_cast<const GLvoid*>(
+                         static_cast<size_t>(part.first_index) *
+                         sizeof(GLushort)));
+    }
+  }
+  glDisableVertexAttribArray(attrib_vertices_);
+  glDisableVertexAttribArray(attrib_normals_);
+  util::CheckGlError("VenueStreamer::Render");
+}
+
+void VenueStreamer::Release() {
+  for (const std::shared_ptr<Request>& request : requests_) {
+    // The completion deletes the buffers of a cancelled upload.
+    request->is_cancelled = true;
+  }
+  requests_.clear();
+  for (auto& chunk : chunks_) {
+    DeleteBuffers(&chunk.second.buffers);
+  }
+  chunks_.clear();
+  visible_chunks_.clear();
+  resident_bytes_ = 0;
+  pending_bytes_ = 0;
+  program_cache::ReleaseProgram(program_);
+  program_ = 0;
+}
+
+void VenueStreamer::Invalidate() {
+  for (const std::shared_ptr<Request>& request : requests_) {
+    request->is_cancelled = true;
+  }
+  requests_.clear();
+  chunks_.clear();
+  visible_chunks_.clear();
+  resident_bytes_ = 0;
+  pending_bytes_ = 0;
+  program_ = 0;
+}
+
+const venue::ChunkRecord& VenueStreamer::GetChunkRecord(int32_t chunk) const {
+  return chunk_records_[chunk];
+}
+
+size_t VenueStreamer::GetLevelSize(const venue::LevelRecord& record) {
+  return static_cast<size_t>(record.vertex_count) * kVertexStride +
+         static_cast<size_t>(record.index_count) * sizeof(GLushort);
+}
+
+void VenueStreamer::RequestLevel(int32_t chunk, int level) {
+  std::shared_ptr<Request> request = std::make_shared<Request>();
+  request->chunk = chunk;
+  request->level = level;
+  request->record = GetChunkRecord(chunk).levels[level];
+  request->file = file_;
+  request->buffers.vertex_buffer = 0;
+  request->buffers.index_buffer = 0;
+  request->buffers.size = GetLevelSize(request->record);
+  request->is_ready = false;
+  request->is_cancelled = false;
+  if (!IsValidLevel(request->record, file_->size)) {
+    LOGE("VenueStreamer: Level %d of chunk %d is malformed.", level, chunk);
+    return;
+  }
+
+  auto inserted = chunks_.insert(std::make_pair(chunk, Chunk()));
+  Chunk& entry = inserted.first->second;
+  if (inserted.second) {
+    entry.level = -1;
+    entry.buffers.vertex_buffer = 0;
+    entry.buffers.index_buffer = 0;
+    entry.buffers.size = 0;
+    entry.last_visible = update_count_;
+  }
+  entry.pending_level = level;
+  pending_bytes_ += request->buffers.size;
+  requests_.push_back(request);
+
+  // The upload only touches the request, the streamer may go away
+  // meanwhile. It runs with another context, so it uses plain GL.
+  upload_thread_->Post(
+      [request] {
+        const venue::LevelRecord& record = request->record;
+        if (record.size == 0) {
+          return;
+        }
+        void* mapping =
+            mmap(nullptr, record.size, PROT_READ, MAP_PRIVATE,
+                 request->file->descriptor, static_cast<off_t>(record.offset));
+        if (mapping == MAP_FAILED) {
+          return;
+        }
+        const uint8_t* data = static_cast<const uint8_t*>(mapping);
+        const venue::PartRecord* parts =
+            reinterpret_cast<const venue::PartRecord*>(data);
+        bool is_valid = true;
+        for (uint32_t i = 0; i < record.part_count; ++i) {
+          is_valid = is_valid && parts[i].first_vertex <= record.vertex_count &&
+                     parts[i].vertex_count <=
+                         record.vertex_count - parts[i].first_vertex &&
+                     parts[i].vertex_count <= 65536 &&
+                     parts[i].first_index <= record.index_count &&
+                     parts[i].index_count <=
+                         record.index_count - parts[i].first_index;
+        }
+        if (is_valid) {
+          request->buffers.parts.assign(parts, parts + record.part_count);
+          const uint8_t* vertices =
+              data + record.part_count * sizeof(venue::PartRecord);
+          const uint8_t* indices =
+              vertices + static_cast<size_t>(record.vertex_count) *
+                             kVertexStride;
+          GLuint buffers[2];
+          glGenBuffers(2, buffers);
+          glBindBuffer(GL_ARRAY_BUFFER, buffers[0]);
+          glBufferData(GL_ARRAY_BUFFER,
+                       static_cast<GLsizeiptr>(record.vertex_count) *
+                           kVertexStride,
+                       vertices, GL_STATIC_DRAW);
+          glBindBuffer(GL_ARRAY_BUFFER, 0);
+          glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffers[1]);
+          glBufferData(GL_ELEMENT_ARRAY_BUFFER,
+                       static_cast<GLsizeiptr>(record.index_count) *
+                           sizeof(GLushort),
+                       indices, GL_STATIC_DRAW);
+          glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+          request->buffers.vertex_buffer = buffers[0];
+          request->buffers.index_buffer = buffers[1];
+        }
+        munmap(mapping, record.size);
+      },
+      [request] {
+        if (request->is_cancelled) {
+          DeleteBuffers(&request->buffers);
+        }
+        request->is_ready = true;
+      });
+}
+
+void VenueStreamer::CollectUploads() {
+  size_t kept = 0;
+  for (size_t i = 0; i < requests_.size(); ++i) {
+    std::shared_ptr<Request>& request = requests_[i];
+    if (!request->is_ready) {
+      if (kept != i) {
+        requests_[kept] = std::move(request);
+      }
+      ++kept;
+      continue;
+    }
+    pending_bytes_ -= request->buffers.size;
+    auto chunk = chunks_.find(request->chunk);
+    if (chunk == chunks_.end()) {
+      DeleteBuffers(&request->buffers);
+      continue;
+    }
+    Chunk& entry = chunk->second;
+    entry.pending_level = -1;
+    if (request->record.size > 0 && request->buffers.vertex_buffer == 0) {
+      LOGE("VenueStreamer: Could not load level %d of chunk %d.",
+           request->level, request->chunk);
+      if (entry.level < 0) {
+        chunks_.erase(chunk);
+      }
+      continue;
+    }
+    if (entry.level >= 0) {
+      resident_bytes_ -= entry.buffers.size;
+      DeleteBuffers(&entry.buffers);
+    }
+    entry.level = request->level;
+    entry.buffers = std::move(request->buffers);
+    resident_bytes_ += entry.buffers.size;
+    if (entry.buffers.vertex_buffer != 0) {
+      MemoryTracker::Track(
+          MemoryTracker::kBuffer, entry.buffers.vertex_buffer, "VenueStreamer",
+          static_cast<size_t>(request->record.vertex_count) * kVertexStride);
+      MemoryTracker::Track(
+          MemoryTracker::kBuffer, entry.buffers.index_buffer, "VenueStreamer",
+          static_cast<size_t>(request->record.index_count) * sizeof(GLushort));
+    }
+  }
+  requests_.resize(kept);
+}
+
+bool VenueStreamer::MakeRoom(size_t size) {
+  if (resident_bytes_ + pending_bytes_ + size <= options_.gpu_budget) {
+    return true;
+  }
+  std::vector<std::pair<uint32_t, int32_t>> unused;
+  for (const auto& chunk : chunks_) {
+    if (chunk.second.last_visible != update_count_ &&
+        chunk.second.pending_level < 0) {
+      unused.push_back(
+          std::make_pair(chunk.second.last_visible, chunk.first));
+    }
+  }
+  std::sort(unused.begin(), unused.end());
+  for (const std::pair<uint32_t, int32_t>& entry : unused) {
+    if (resident_bytes_ + pending_bytes_ + size <= options_.gpu_budget) {
+      break;
+    }
+    auto chunk = chunks_.find(entry.second);
+    resident_bytes_ -= chunk->second.buffers.size;
+    DeleteBuffers(&chunk->second.buffers);
+    chunks_.erase(chunk);
+  }
+  return resident_bytes_ + pending_bytes_ + size <= options_.gpu_budget;
+}
+
+void VenueStreamer::DeleteBuffers(LevelBuffers* buffers) {
+  if (buffers->vertex_buffer != 0) {
+    RenderState::DeleteBuffers(1, &buffers->vertex_buffer);
+    RenderState::DeleteBuffers(1, &buffers->index_buffer);
+  }
+  buffers->vertex_buffer = 0;
+  buffers->index_buffer = 0;
+  buffers->parts.clear();
+}
+
+bool VenueStreamer::AcquireProgram() {
+  if (program_ != 0) {
+    return true;
+  }
+  const shader_variants::Variant* variant =
+      shader_variants::Acquire(shader_variants::kLighting);
+  if (variant == nullptr) {
+    LOGE("VenueStreamer: Could not create program.");
+    return false;
+  }
+  program_ = variant->program;
+  uniform_mvp_ = variant->uniforms[shader_variants::kMvp];
+  uniform_mv_ = variant->uniforms[shader_variants::kMv];
+  uniform_color_ = variant->uniforms[shader_variants::kColor];
+  uniform_light_vec_ = variant->uniforms[shader_variants::kLightVec];
+  uniform_ambient_ = variant->uniforms[shader_variants::kAmbient];
+  attrib_vertices_ = variant->attributes[shader_variants::kVertexAttribute];
+  attrib_normals_ = variant->attributes[shader_variants::kNormalAttribute];
+  return true;
+}
+
+}  // namespace tango_gl
@@ -0,0 +1,78 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tango-gl/render_state.h"
+#include "tango-gl/vertex_array.h"
+
+namespace tango_gl {
+
+VertexArray::VertexArray()
+    : array_id_(0), is_recorded_(false), enabled_attributes_(0) {}
+
+VertexArray::~VertexArray() { Release(); }
+
+bool VertexArray::Bind() {
+  enabled_attributes_ = 0;
+  if (!RenderState::HasVertexArrays()) {
+    return false;
+  }
+  if (array_id_ == 0) {
+    RenderState::GenVertexArrays(1, &array_id_);
+    is_recorded_ = false;
+  }
+  RenderState::BindVertexArray(array_id_);
+  if (is_recorded_) {
+    return true;
+  }
+  // The caller records the setup now.
+  is_recorded_ = true;
+  return false;
+}
+
+void VertexArray::EnableAttribute(GLuint index) {
+  glEnableVertexAttribArray(index);
+  if (index < 32) {
+    enabled_attributes_ |= 1u << index;
+  }
+}
+
+void VertexArray::Unbind() {
+  if (array_id_ != 0) {
+    RenderState::BindVertexArray(0);
+    return;
+  }
+  for (GLuint index = 0; enabled_attributes_ != 0; ++index) {
+    if ((enabled_attributes_ & (1u << index)) != 0) {
+      glDisableVertexAttribArray(index);
+      enabled_attributes_ &= ~(1u << index);
+    }
+  }
+}
+
+void VertexArray::Release() {
+  if (array_id_ != 0) {
+    RenderState::DeleteVertexArrays(1, &array_id_);
+  }
+  Invalidate();
+}
+
+void VertexArray::Invalidate() {
+  array_id_ = 0;
+  is_recorded_ = false;
+  enabled_attributes_ = 0;
+}
+
+}  // namespace tango_gl
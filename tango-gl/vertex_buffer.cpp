@@ -0,0 +1,107 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdint.h>
+#include <algorithm>
+
+#include "tango-gl/counters.h"
+#include "tango-gl/memory_tracker.h"
+#include "tango-gl/render_state.h"
+#include "tango-gl/vertex_buffer.h"
+
+namespace tango_gl {
+
+VertexBuffer::VertexBuffer(GLenum target, GLenum usage)
+    : target_(target), usage_(usage), buffer_id_(0), capacity_(0), size_(0) {}
+
+VertexBuffer::~VertexBuffer() { Release(); }
+
+void VertexBuffer::Update(const void* data, size_t size, size_t dirty_offset) {
+  if (buffer_id_ == 0) {
+    glGenBuffers(1, &buffer_id_);
+    capacity_ = 0;
+  }
+  RenderState::BindBuffer(target_, buffer_id_);
+  if (size > capacity_) {
+    // Grow geometrically so arrays growing one element at a time are not
+    // reallocated on every update.
+    capacity_ = std::max(size, capacity_ * 2);
+    if (capacity_ == size) {
+      // The whole array fits exactly, upload it with the allocation.
+      glBufferData(target_, capacity_, data, usage_);
+      Counters::Add(Counters::kBufferBytes, size);
+      dirty_offset = size;
+    } else {
+      glBufferData(target_, capacity_, nullptr, usage_);
+      dirty_offset = 0;
+    }
+    MemoryTracker::Track(MemoryTracker::kBuffer, buffer_id_, "VertexBuffer",
+                         capacity_);
+  }
+  if (dirty_offset < size) {
+    glBufferSubData(target_, dirty_offset, size - dirty_offset,
+                    static_cast<const uint8_t*>(data) + dirty_offset);
+    Counters::Add(Counters::kBufferBytes, size - dirty_offset);
+  }
+  size_ = size;
+  RenderState::BindBuffer(target_, 0);
+  util::CheckGlError("VertexBuffer::Update");
+}
+
+bool VertexBuffer::Reserve(size_t capacity) {
+  if (buffer_id_ != 0 && capacity <= capacity_) {
+    return false;
+  }
+  if (buffer_id_ == 0) {
+    glGenBuffers(1, &buffer_id_);
+  }
+  RenderState::BindBuffer(target_, buffer_id_);
+  glBufferData(target_, capacity, nullptr, usage_);
+  RenderState::BindBuffer(target_, 0);
+  MemoryTracker::Track(MemoryTracker::kBuffer, buffer_id_, "VertexBuffer",
+                       capacity);
+  capacity_ = capacity;
+  size_ = capacity;
+  util::CheckGlError("VertexBuffer::Reserve");
+  return true;
+}
+
+void VertexBuffer::Write(size_t offset, const void* data, size_t size) {
+  RenderState::BindBuffer(target_, buffer_id_);
+  glBufferSubData(target_, offset, size, data);
+  Counters::Add(Counters::kBufferBytes, size);
+  RenderState::BindBuffer(target_, 0);
+  util::CheckGlError("VertexBuffer::Write");
+}
+
+void VertexBuffer::Bind() const {
+  RenderState::BindBuffer(target_, buffer_id_);
+}
+
+void VertexBuffer::Release() {
+  if (buffer_id_ != 0) {
+    RenderState::DeleteBuffers(1, &buffer_id_);
+  }
+  Invalidate();
+}
+
+void VertexBuffer::Invalidate() {
+  buffer_id_ = 0;
+  capacity_ = 0;
+  size_ = 0;
+}
+
+}  // namespace tango_gl
@@ -0,0 +1,324 @@
+/*
+ * Copyright 2015 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "tango-gl/video_encoder.h"
+
+#include <dlfcn.h>
+#include <string.h>
+#include <sys/types.h>
+
+#include <mutex>
+
+#include "tango-gl/util.h"
+
+namespace {
+// The NDK MediaCodec declarations, from media/NdkMediaCodec.h and
+// media/NdkMediaFormat.h, which the platform of the examples does not have.
+typedef int32_t MediaStatus;
+const MediaStatus kMediaOk = 0;
+
+struct MediaCodecBufferInfo {
+  int32_t offset;
+  int32_t size;
+  int64_t presentation_time_us;
+  uint32_t flags;
+};
+
+const uint32_t kConfigureFlagEncode = 1;
+const uint32_t kBufferFlagKeyFrame = 1;
+const uint32_t kBufferFlagCodecConfig = 2;
+const uint32_t kBufferFlagEndOfStream = 4;
+const ssize_t kInfoTryAgainLater = -1;
+const ssize_t kInfoOutputBuffersChanged = -3;
+
+// MediaCodecInfo.CodecCapabilities.COLOR_FormatYUV420SemiPlanar.
+const int32_t kColorFormatYuv420SemiPlanar = 21;
+
+// Most Drain() calls Finish() waits for the end of the stream, each up to
+// kFinishTimeoutUs.
+const int kFinishDrainCount = 100;
+const int64_t kFinishTimeoutUs = 10000;
+
+typedef void* (*CreateEncoderByTypeFunction)(const char* mime_type);
+typedef MediaStatus (*ConfigureFunction)(void* codec, const void* format,
+                                         void* surface, void* crypto,
+                                         uint32_t flags);
+typedef MediaStatus (*CodecFunction)(void* codec);
+typedef ssize_t (*DequeueInputBufferFunction)(void* codec, int64_t timeout_us);
+typedef uint8_t* (*GetBufferFunction)(void* codec, size_t index,
+                                      size_t* size);
+typedef MediaStatus (*QueueInputBufferFunction)(void* codec, size_t index,
+                                                off_t offset, size_t size,
+                                                uint64_t time_us,
+                                                uint32_t flags);
+typedef ssize_t (*DequeueOutputBufferFunction)(void* codec,
+                                               MediaCodecBufferInfo* info,
+                                               int64_t timeout_us);
+typedef MediaStatus (*ReleaseOutputBufferFunction)(void* codec, size_t index,
+                                                   bool render);
+typedef void* (*FormatNewFunction)();
+typedef MediaStatus (*FormatDeleteFunction)(void* format);
+typedef void (*FormatSetStringFunction)(void* format, const char* name,
+                                        const char* value);
+typedef void (*FormatSetInt32Function)(void* format, const char* name,
+                                       int32_t value);
+
+// Functions resolved once, from any thread.
+struct Functions {
+  CreateEncoderByTypeFunction create_encoder_by_type;
+  ConfigureFunction configure;
+  CodecFunction start;
+  CodecFunction stop;
+  CodecFunction destroy;
+  DequeueInputBufferFunction dequeue_input_buffer;
+  GetBufferFunction get_input_buffer;
+  QueueInputBufferFunction queue_input_buffer;
+  DequeueOutputBufferFunction dequeue_output_buffer;
+  GetBufferFunction get_output_buffer;
+  ReleaseOutputBufferFunction release_output_buffer;
+  FormatNewFunction format_new;
+  FormatDeleteFunction format_delete;
+  FormatSetStringFunction format_set_string;
+  FormatSetInt32Function format_set_int32;
+  bool is_complete;
+};
+
+const Functions& GetFunctions() {
+  static Functions functions;
+  static std::once_flag once;
+  std::call_once(once, []() {
+    memset(&functions, 0, sizeof(functions));
+    void* library = dlopen("libmediandk.so", RTLD_NOW | RTLD_LOCAL);
+    if (library == nullptr) {
+      return;
+    }
+    functions.create_encoder_by_type =
+        reinterpret_cast<CreateEncoderByTypeFunction>(
+            dlsym(library, "AMediaCodec_createEncoderByType"));
+    functions.configure = reinterpret_cast<ConfigureFunction>(
+        dlsym(library, "AMediaCodec_configure"));
+    functions.start =
+        reinterpret_cast<CodecFunction>(dlsym(library, "AMediaCodec_start"));
+    functions.stop =
+        reinterpret_cast<CodecFunction>(dlsym(library, "AMediaCodec_stop"));
+    functions.destroy =
+        reinterpret_cast<CodecFunction>(dlsym(library, "AMediaCodec_delete"));
+    functions.dequeue_input_buffer =
+        reinterpret_cast<DequeueInputBufferFunction>(
+            dlsym(library, "AMediaCodec_dequeueInputBuffer"));
+    functions.get_input_buffer = reinterpret_cast<GetBufferFunction>(
+        dlsym(library, "AMediaCodec_getInputBuffer"));
+    functions.queue_input_buffer = reinterpret_cast<QueueInputBufferFunction>(
+        dlsym(library, "AMediaCodec_queueInputBuffer"));
+    functions.dequeue_output_buffer =
+        reinterpret_cast<DequeueOutputBufferFunction>(
+            dlsym(library, "AMediaCodec_dequeueOutputBuffer"));
+    functions.get_output_buffer = reinterpret_cast<GetBufferFunction>(
+        dlsym(library, "AMediaCodec_getOutputBuffer"));
+    functions.release_output_buffer =
+        reinterpret_cast<ReleaseOutputBufferFunction>(
+            dlsym(library, "AMediaCodec_releaseOutputBuffer"));
+    functions.format_new =
+        reinterpret_cast<FormatNewFunction>(dlsym(library, "AMediaFormat_new"));
+    functions.format_delete = reinterpret_cast<FormatDeleteFunction>(
+        dlsym(library, "AMediaFormat_delete"));
+    functions.format_set_string = reinterpret_cast<FormatSetStringFunction>(
+        dlsym(library, "AMediaFormat_setString"));
+    functions.format_set_int32 = reinterpret_cast<FormatSetInt32Function>(
+        dlsym(library, "AMediaFormat_setInt32"));
+    functions.is_complete =
+        functions.create_encoder_by_type != nullptr &&
+        functions.configure != nullptr && functions.start != nullptr &&
+        functions.stop != nullptr && functions.destroy != nullptr &&
+        functions.dequeue_input_buffer != nullptr &&
+        functions.get_input_buffer != nullptr &&
+        functions.queue_input_buffer != nullptr &&
+        functions.dequeue_output_buffer != nullptr &&
+        functions.get_output_buffer != nullptr &&
+        functions.release_output_buffer != nullptr &&
+        functions.format_new != nullptr && functions.format_delete != nullptr &&
+        functions.format_set_string != nullptr &&
+        functions.format_set_int32 != nullptr;
+  });
+  return functions;
+}
+
+const char* GetMimeType(tango_gl::session::VideoCodec codec) {
+  return codec == tango_gl::session::kHevcCodec ? "video/hevc" : "video/avc";
+}
+}  // namespace
+
+namespace tango_gl {
+
+MediaCodecVideoEncoder::MediaCodecVideoEncoder(const Options& options)
+    : options_(options), codec_(nullptr), width_(0), height_(0) {}
+
+MediaCodecVideoEncoder::~MediaCodecVideoEncoder() { Release(); }
+
+bool MediaCodecVideoEncoder::IsSupported() {
+  return GetFunctions().is_complete;
+}
+
+bool MediaCodecVideoEncoder::Start(uint32_t width, uint32_t height) {
+  Release();
+  const Functions& functions = GetFunctions();
+  if (!functions.is_complete) {
+    LOGE("MediaCodecVideoEncoder: NDK MediaCodec unavailable.");
+    return false;
+  }
+  const char* mime_type = GetMimeType(options_.codec);
+  codec_ = functions.create_encoder_by_type(mime_type);
+  if (codec_ == nullptr) {
+    LOGE("MediaCodecVideoEncoder: no %s encoder.", mime_type);
+    return false;
+  }
+  void* format = functions.format_new();
+  functions.format_set_string(format, "mime", mime_type);
+  functions.format_set_int32(format, "width", static_cast<int32_t>(width));
+  functions.format_set_int32(format, "height", static_cast<int32_t>(height));
+  functions.format_set_int32(format, "color-format",
+                             kColorFormatYuv420SemiPlanar);
+  functions.format_set_int32(format, "bitrate", options_.bit_rate);
+  functions.format_set_int32(format, "frame-rate", options_.frame_rate);
+  functions.format_set_int32(format, "i-frame-interval",
+                             options_.key_frame_interval_s);
+  const MediaStatus status = functions.configure(
+      codec_, format, nullptr, nullptr, kConfigureFlagEncode);
+  functions.format_delete(format);
+  if (status != kMediaOk || functions.start(codec_) != kMediaOk) {
+    LOGE("MediaCodecVideoEncoder: %s encoder rejected %ux%u (%d).",
+         mime_type, width, height, status);
+    functions.destroy(codec_);
+    codec_ = nullptr;
+    return false;
+  }
+  width_ = width;
+  height_ = height;
+  return true;
+}
+
+bool MediaCodecVideoEncoder::Encode(const uint8_t* nv21, uint32_t stride,
+                                    int64_t presentation_time_us,
+                                    const PacketCallback& on_packet) {
+  if (codec_ == nullptr) {
+    return false;
+  }
+  const Functions& functions = GetFunctions();
+  const ssize_t index =
+      functions.dequeue_input_buffer(codec_, options_.input_timeout_us);
+  if (index < 0) {
+    Drain(0, on_packet);
+    return false;
+  }
+  size_t capacity = 0;
+  uint8_t* input = functions.get_input_buffer(codec_, index, &capacity);
+  const size_t luma_size = static_cast<size_t>(width_) * height_;
+  const size_t frame_size = luma_size * 3 / 2;
+  if (input == nullptr || capacity < frame_size) {
+    LOGE("MediaCodecVideoEncoder: input buffer of %zu bytes, %zu needed.",
+         capacity, frame_size);
+    functions.queue_input_buffer(codec_, index, 0, 0, presentation_time_us,
+                                 0);
+    Drain(0, on_packet);
+    return false;
+  }
+  const uint8_t* source = nv21;
+  for (uint32_t y = 0; y < height_; ++y, source += stride) {
+    memcpy(input + y * width_, source, width_);
+  }
+  // NV21 interleaves V then U, the semi-planar input U then V.
+  source = nv21 + static_cast<size_t>(stride) * height_;
+  uint8_t* chroma = input + luma_size;
+  for (uint32_t y = 0; y < height_ / 2; ++y, source += stride) {
+    uint8_t* row = chroma + y * width_;
+    for (uint32_t x = 0; x + 1 < width_; x += 2) {
+      row[x] = source[x + 1];
+      row[x + 1] = source[x];
+    }
+  }
+  functions.queue_input_buffer(codec_, index, 0, frame_size,
+                               presentation_time_us, 0);
+  Drain(0, on_packet);
+  return true;
+}
+
+void MediaCodecVideoEncoder::Finish(const PacketCallback& on_packet) {
+  if (codec_ == nullptr) {
+    return;
+  }
+  const Functions& functions = GetFunctions();
+  const ssize_t index =
+      functions.dequeue_input_buffer(codec_, options_.input_timeout_us);
+  if (index >= 0) {
+    functions.queue_input_buffer(codec_, index, 0, 0, 0,
+                                 kBufferFlagEndOfStream);
+    int drain_count = 0;
+    while (!Drain(kFinishTimeoutUs, on_packet) &&
+           ++drain_count < kFinishDrainCount) {
+    }
+  } else {
+    LOGE("MediaCodecVideoEncoder: the last frames of the stream are lost.");
+  }
+  Release();
+}
+
+bool MediaCodecVideoEncoder::Drain(int64_t timeout_us,
+                                   const PacketCallback& on_packet) {
+  const Functions& functions = GetFunctions();
+  while (true) {
+    MediaCodecBufferInfo info;
+    const ssize_t index =
+        functions.dequeue_output_buffer(codec_, &info, timeout_us);
+    // Format and buffer changes need no action with getOutputBuffer(),
+    // anything below them is an error.
+    if (index == kInfoTryAgainLater || index < kInfoOutputBuffersChanged) {
+      return false;
+    }
+    if (index < 0) {
+      continue;
+    }
+    size_t capacity = 0;
+    const uint8_t* output =
+        functions.get_output_buffer(codec_, index, &capacity);
+    if (output != nullptr && info.size > 0 &&
+        static_cast<size_t>(info.offset) + info.size <= capacity) {
+      Packet packet;
+      packet.data = output + info.offset;
+      packet.size = static_cast<size_t>(info.size);
+      packet.presentation_time_us = info.presentation_time_us;
+      packet.is_config = (info.flags & kBufferFlagCodecConfig) != 0;
+      packet.is_key_frame = (info.flags & kBufferFlagKeyFrame) != 0;
+      on_packet(packet);
+    }
+    functions.release_output_buffer(codec_, index, false);
+    if ((info.flags & kBufferFlagEndOfStream) != 0) {
+      return true;
+    }
+  }
+}
+
+void MediaCodecVideoEncoder::Release() {
+  if (codec_ == nullptr) {
+    return;
+  }
+  const Functions& functions = GetFunctions();
+  functions.stop(codec_);
+  functions.destroy(codec_);
+  codec_ = nullptr;
+}
+
+}  // namespace tango_gl
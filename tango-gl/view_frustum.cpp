@@ -0,0 +1,104 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "tango-gl/view_frustum.h"
+
+namespace tango_gl {
+
+ViewFrustum::ViewFrustum()
+    : clip_T_world_(1.0f),
+      eye_(0.0f),
+      max_distance_(0.0f),
+      occlusion_culler_(nullptr),
+      tested_count_(0),
+      culled_count_(0),
+      occluded_count_(0) {
+  for (glm::vec4& plane : planes_) {
+    plane = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+  }
+}
+
+void ViewFrustum::Update(const glm::mat4& projection_mat,
+                         const glm::mat4& view_mat) {
+  // Gribb and Hartmann: in clip space a point is inside when
+  // -w <= x, y, z <= w, which gives each plane as a sum or difference of two
+  // rows of the view projection matrix.
+  clip_T_world_ = projection_mat * view_mat;
+  const glm::mat4 rows = glm::transpose(clip_T_world_);
+  for (int axis = 0; axis < 3; ++axis) {
+    planes_[axis * 2] = rows[3] + rows[axis];
+    planes_[axis * 2 + 1] = rows[3] - rows[axis];
+  }
+  for (glm::vec4& plane : planes_) {
+    plane /= glm::length(glm::vec3(plane));
+  }
+
+  eye_ = glm::vec3(glm::inverse(view_mat)[3]);
+  tested_count_ = 0;
+  culled_count_ = 0;
+  occluded_count_ = 0;
+}
+
+bool ViewFrustum::IsBoxVisible(const glm::vec3& min, const glm::vec3& max) {
+  return IsVisible((min + max) * 0.5f, (max - min) * 0.5f);
+}
+
+bool ViewFrustum::IsBoxVisible(const BoundingBox& box,
+                               const glm::mat4& world_T_model) {
+  const glm::vec3 center = (box.GetMin() + box.GetMax()) * 0.5f;
+  const glm::vec3 half_extents = (box.GetMax() - box.GetMin()) * 0.5f;
+
+  // The world axis-aligned box enclosing the transformed box (Arvo).
+  const glm::mat3 rotation(world_T_model);
+  glm::vec3 world_half_extents(0.0f);
+  for (int column = 0; column < 3; ++column) {
+    world_half_extents += glm::abs(rotation[column]) * half_extents[column];
+  }
+  return IsVisible(glm::vec3(world_T_model * glm::vec4(center, 1.0f)),
+                   world_half_extents);
+}
+
+bool ViewFrustum::IsVisible(const glm::vec3& center,
+                            const glm::vec3& half_extents) {
+  ++tested_count_;
+  for (const glm::vec4& plane : planes_) {
+    const glm::vec3 normal(plane);
+    const float radius = glm::dot(glm::abs(normal), half_extents);
+    if (glm::dot(normal, center) + plane.w < -radius) {
+      ++culled_count_;
+      return false;
+    }
+  }
+
+  if (max_distance_ > 0.0f) {
+    const glm::vec3 outside =
+        glm::max(glm::abs(eye_ - center) - half_extents, glm::vec3(0.0f));
+    if (glm::dot(outside, outside) > max_distance_ * max_distance_) {
+      ++culled_count_;
+      return false;
+    }
+  }
+  if (occlusion_culler_ != nullptr &&
+      occlusion_culler_->IsBoxOccluded(clip_T_world_, center, half_extents)) {
+    ++culled_count_;
+    ++occluded_count_;
+    return false;
+  }
+  return true;
+}
+
+}  // namespace tango_gl
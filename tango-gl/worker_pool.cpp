@@ -0,0 +1,191 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "tango-gl/worker_pool.h"
+
+#include <algorithm>
+
+#if defined(__linux__)
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "tango-gl/thread_policy.h"
+#include "tango-gl/util.h"
+
+namespace {
+// Nice value of the shared pool's workers.
+const int kSharedWorkerNice = 2;
+
+// Restrict the calling thread to some cores and adjust its priority, as far
+// as the platform allows.
+void ApplySchedulingHints(const std::vector<int>& cpus, int nice) {
+#if defined(__linux__)
+  if (!cpus.empty()) {
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    for (int cpu : cpus) {
+      CPU_SET(cpu, &cpu_set);
+    }
+    // A pid of 0 is the calling thread.
+    if (sched_setaffinity(0, sizeof(cpu_set), &cpu_set) != 0) {
+      LOGE("WorkerPool: Failed to set the worker affinity");
+    }
+  }
+  if (nice != 0) {
+    // On Linux the nice value is per thread.
+    const id_t thread_id = static_cast<id_t>(syscall(SYS_gettid));
+    if (setpriority(PRIO_PROCESS, thread_id,
+                    getpriority(PRIO_PROCESS, thread_id) + nice) != 0) {
+      LOGE("WorkerPool: Failed to set the worker priority");
+    }
+  }
+#else
+  (void)cpus;
+  (void)nice;
+#endif
+}
+}  // namespace
+
+namespace tango_gl {
+
+WorkerPool::WorkerPool(int thread_count) : is_stopping_(false) {
+  Options options;
+  options.thread_count = thread_count;
+  Start(options);
+}
+
+WorkerPool::WorkerPool(const Options& options) : is_stopping_(false) {
+  Start(options);
+}
+
+WorkerPool::~WorkerPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    is_stopping_ = true;
+  }
+  work_available_.notify_all();
+  for (std::thread& thread : threads_) {
+    thread.join();
+  }
+}
+
+WorkerPool& WorkerPool::GetShared() {
+  // Never destroyed, so it outlives every static object that may use it.
+  static WorkerPool* shared = [] {
+    Options options;
+    options.nice = kSharedWorkerNice;
+    return new WorkerPool(options);
+  }();
+  return *shared;
+}
+
+void WorkerPool::Start(const Options& options) {
+  const std::vector<int> cpus = thread_policy::GetCores(options.cores);
+  int thread_count = options.thread_count;
+  if (thread_count < 0) {
+    const int core_count =
+        cpus.empty() ? static_cast<int>(std::thread::hardware_concurrency())
+                     : static_cast<int>(cpus.size());
+    thread_count = std::max(1, core_count - kReservedCoreCount);
+  }
+  for (int i = 0; i < thread_count; ++i) {
+    threads_.push_back(
+        std::thread(&WorkerPool::WorkerLoop, this, cpus, options.nice));
+  }
+}
+
+void WorkerPool::ParallelFor(int task_count,
+                             const std::function<void(int)>& task) {
+  if (task_count <= 0) {
+    return;
+  }
+  if (threads_.empty() || task_count == 1) {
+    for (int i = 0; i < task_count; ++i) {
+      task(i);
+    }
+    return;
+  }
+
+  Job job;
+  job.task = &task;
+  job.task_count = task_count;
+  job.next_task = 0;
+  job.active_workers = 0;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    jobs_.push_back(&job);
+  }
+  work_available_.notify_all();
+
+  RunTasks(&job);
+
+  // The job lives on the caller's stack, wait until every worker has left
+  // it before returning. Once it is unlisted no worker can join it.
+  std::unique_lock<std::mutex> lock(mutex_);
+  RemoveJob(&job);
+  work_done_.wait(lock, [&job] { return job.active_workers == 0; });
+}
+
+void WorkerPool::WorkerLoop(const std::vector<int>& cpus, int nice) {
+  ApplySchedulingHints(cpus, nice);
+  thread_policy::TagCurrentThread(thread_policy::kWorker);
+  while (true) {
+    Job* job;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      work_available_.wait(lock,
+                           [this] { return is_stopping_ || !jobs_.empty(); });
+      if (is_stopping_) {
+        return;
+      }
+      job = jobs_.front();
+      ++job->active_workers;
+    }
+
+    RunTasks(job);
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      // Every task is claimed, idle workers should not pick the job again.
+      RemoveJob(job);
+      --job->active_workers;
+    }
+    work_done_.notify_all();
+  }
+}
+
+void WorkerPool::RunTasks(Job* job) {
+  while (true) {
+    int index = job->next_task.fetch_add(1);
+    if (index >= job->task_count) {
+      return;
+    }
+    (*job->task)(index);
+  }
+}
+
+void WorkerPool::RemoveJob(Job* job) {
+  std::vector<Job*>::iterator it = std::find(jobs_.begin(), jobs_.end(), job);
+  if (it != jobs_.end()) {
+    jobs_.erase(it);
+  }
+}
+
+}  // namespace tango_gl
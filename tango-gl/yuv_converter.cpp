@@ -0,0 +1,180 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+
+#include "tango-gl/cpu_features.h"
+#include "tango-gl/yuv_converter.h"
+
+namespace {
+inline uint8_t ClampToByte(int value) {
+  return static_cast<uint8_t>(value < 0 ? 0 : (value > 255 ? 255 : value));
+}
+
+// Convert a single pixel with its chroma.
+inline void ConvertPixel(int luma, const uint8_t* vu, uint8_t* rgb) {
+  using namespace tango_gl::yuv;
+  const int kRound = 1 << (kFixedPointShift - 1);
+  int v = vu[0] - 128;
+  int u = vu[1] - 128;
+  int y = (luma << kFixedPointShift) + kRound;
+  rgb[0] = ClampToByte((y + kVToR * v) >> kFixedPointShift);
+  rgb[1] = ClampToByte((y - kVToG * v - kUToG * u) >> kFixedPointShift);
+  rgb[2] = ClampToByte((y + kUToB * u) >> kFixedPointShift);
+}
+
+// Convert columns [column_begin, column_end) of a single row, rgb_row is the
+// output of column_begin. Scalar fallback and tail handling for the NEON
+// kernel.
+void ConvertRowScalar(const uint8_t* y_row, const uint8_t* vu_row,
+                      size_t column_begin, size_t column_end,
+                      uint8_t* rgb_row) {
+  for (size_t j = column_begin; j < column_end; ++j) {
+    ConvertPixel(y_row[j], vu_row + (j & ~static_cast<size_t>(1)),
+                 rgb_row + (j - column_begin) * 3);
+  }
+}
+
+// Convert columns [column_begin, column_end) of two rows sharing vu_row.
+void ConvertRowPair(const uint8_t* y_row0, const uint8_t* y_row1,
+                    const uint8_t* vu_row, size_t column_begin,
+                    size_t column_end, bool use_neon, uint8_t* rgb_row0,
+                    uint8_t* rgb_row1) {
+  size_t j = column_begin;
+  // The kernel starts on the first pixel of a chroma pair.
+  if (j < column_end && (j & 1) != 0) {
+    ConvertRowScalar(y_row0, vu_row, j, j + 1, rgb_row0);
+    ConvertRowScalar(y_row1, vu_row, j, j + 1, rgb_row1);
+    ++j;
+  }
+#if defined(TANGO_GL_HAS_NEON)
+  if (use_neon && j < column_end) {
+    const size_t offset = (j - column_begin) * 3;
+    j += tango_gl::yuv::internal::ConvertNV21RowPairNeon(
+        y_row0 + j, y_row1 + j, vu_row + j, column_end - j, rgb_row0 + offset,
+        rgb_row1 + offset);
+  }
+#else
+  (void)use_neon;
+#endif
+  const size_t offset = (j - column_begin) * 3;
+  ConvertRowScalar(y_row0, vu_row, j, column_end, rgb_row0 + offset);
+  ConvertRowScalar(y_row1, vu_row, j, column_end, rgb_row1 + offset);
+}
+
+// Convert the rectangle [column_begin, column_end) x [row_begin, row_end)
+// into rgb, rows of rgb_stride bytes starting with the top left pixel.
+void ConvertRegion(const uint8_t* nv21, size_t width, size_t height,
+                   size_t column_begin, size_t column_end, size_t row_begin,
+                   size_t row_end, size_t rgb_stride, uint8_t* rgb) {
+  const uint8_t* vu_plane = nv21 + width * height;
+  const bool use_neon = tango_gl::yuv::IsNeonAvailable();
+
+  size_t i = row_begin;
+  // An odd starting row does not share its chroma row with the next one.
+  if (i < row_end && (i & 1) != 0) {
+    ConvertRowScalar(nv21 + i * width, vu_plane + (i / 2) * width,
+                     column_begin, column_end, rgb);
+    ++i;
+  }
+
+  for (; i + 1 < row_end; i += 2) {
+    const uint8_t* y_row0 = nv21 + i * width;
+    uint8_t* rgb_row0 = rgb + (i - row_begin) * rgb_stride;
+    ConvertRowPair(y_row0, y_row0 + width, vu_plane + (i / 2) * width,
+                   column_begin, column_end, use_neon, rgb_row0,
+                   rgb_row0 + rgb_stride);
+  }
+
+  if (i < row_end) {
+    ConvertRowScalar(nv21 + i * width, vu_plane + (i / 2) * width,
+                     column_begin, column_end,
+                     rgb + (i - row_begin) * rgb_stride);
+  }
+}
+}  // namespace
+
+namespace tango_gl {
+namespace yuv {
+
+bool IsNeonAvailable() { return cpu_features::IsNeonAvailable(); }
+
+void ConvertNV21ToRGB(const uint8_t* nv21, size_t width, size_t height,
+                      uint8_t* rgb) {
+  ConvertNV21ToRGB(nv21, width, height, 0, height, rgb);
+}
+
+void ConvertNV21ToRGB(const uint8_t* nv21, size_t width, size_t height,
+                      size_t row_begin, size_t row_end, uint8_t* rgb) {
+  if (row_end > height) {
+    row_end = height;
+  }
+  const size_t rgb_stride = width * 3;
+  ConvertRegion(nv21, width, height, 0, width, row_begin, row_end, rgb_stride,
+                rgb + row_begin * rgb_stride);
+}
+
+void ConvertNV21RegionToRGB(const uint8_t* nv21, size_t width, size_t height,
+                            size_t region_x, size_t region_y,
+                            size_t region_width, size_t region_height,
+                            uint8_t* rgb) {
+  if (region_x >= width || region_y >= height) {
+    return;
+  }
+  const size_t column_end = std::min(region_x + region_width, width);
+  const size_t row_end = std::min(region_y + region_height, height);
+  ConvertRegion(nv21, width, height, region_x, column_end, region_y, row_end,
+                (column_end - region_x) * 3, rgb);
+}
+
+void ConvertNV21ToHalfRGB(const uint8_t* nv21, size_t width, size_t height,
+                          uint8_t* rgb) {
+  const uint8_t* vu_plane = nv21 + width * height;
+  const size_t half_width = width / 2;
+  const size_t half_height = height / 2;
+#if defined(TANGO_GL_HAS_NEON)
+  const bool use_neon = IsNeonAvailable();
+#endif
+  for (size_t i = 0; i < half_height; ++i) {
+    const uint8_t* y_row0 = nv21 + 2 * i * width;
+    const uint8_t* y_row1 = y_row0 + width;
+    const uint8_t* vu_row = vu_plane + i * width;
+    uint8_t* rgb_row = rgb + i * half_width * 3;
+
+    size_t j = 0;
+#if defined(TANGO_GL_HAS_NEON)
+    if (use_neon) {
+      j = internal::ConvertNV21HalfRowNeon(y_row0, y_row1, vu_row, half_width,
+                                           rgb_row);
+    }
+#endif
+    for (; j < half_width; ++j) {
+      const int luma = (y_row0[2 * j] + y_row0[2 * j + 1] + y_row1[2 * j] +
+                        y_row1[2 * j + 1] + 2) >> 2;
+      ConvertPixel(luma, vu_row + 2 * j, rgb_row + j * 3);
+    }
+  }
+}
+
+void ConvertNV21PixelToRGB(const uint8_t* nv21, size_t width, size_t height,
+                           size_t x, size_t y, uint8_t* rgb) {
+  const uint8_t* vu_row = nv21 + width * height + (y / 2) * width;
+  ConvertPixel(nv21[y * width + x], vu_row + (x & ~static_cast<size_t>(1)),
+               rgb);
+}
+
+}  // namespace yuv
+}  // namespace tango_gl
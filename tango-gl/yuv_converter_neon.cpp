@@ -0,0 +1,145 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// This file is only compiled with NEON enabled (the ".neon" suffix in
+// Android.mk), the kernel is selected at runtime by yuv_converter.cpp.
+
+#include <arm_neon.h>
+
+#include "tango-gl/yuv_converter.h"
+
+namespace {
+// Compute one channel for 16 pixels of a row. The luma is widened to Q6 and
+// the chroma term, already duplicated for each pixel pair, is added before a
+// rounding, saturating narrow back to 8 bits.
+inline uint8x16_t ComputeChannel(const int16x8_t& y_low,
+                                 const int16x8_t& y_high,
+                                 const int16x8x2_t& chroma) {
+  using tango_gl::yuv::kFixedPointShift;
+  return vcombine_u8(
+      vqrshrun_n_s16(vaddq_s16(y_low, chroma.val[0]), kFixedPointShift),
+      vqrshrun_n_s16(vaddq_s16(y_high, chroma.val[1]), kFixedPointShift));
+}
+
+inline void ConvertRow16(const uint8_t* y_row, const int16x8x2_t& r_chroma,
+                         const int16x8x2_t& g_chroma,
+                         const int16x8x2_t& b_chroma, uint8_t* rgb_row) {
+  using tango_gl::yuv::kFixedPointShift;
+  uint8x16_t y = vld1q_u8(y_row);
+  int16x8_t y_low = vreinterpretq_s16_u16(
+      vshll_n_u8(vget_low_u8(y), kFixedPointShift));
+  int16x8_t y_high = vreinterpretq_s16_u16(
+      vshll_n_u8(vget_high_u8(y), kFixedPointShift));
+
+  uint8x16x3_t rgb;
+  rgb.val[0] = ComputeChannel(y_low, y_high, r_chroma);
+  rgb.val[1] = ComputeChannel(y_low, y_high, g_chroma);
+  rgb.val[2] = ComputeChannel(y_low, y_high, b_chroma);
+  vst3q_u8(rgb_row, rgb);
+}
+
+// Compute one channel for 8 pixels with their own chroma term.
+inline uint8x8_t ComputeHalfChannel(const int16x8_t& y,
+                                    const int16x8_t& chroma) {
+  using tango_gl::yuv::kFixedPointShift;
+  return vqrshrun_n_s16(vaddq_s16(y, chroma), kFixedPointShift);
+}
+
+// Convert 8 pixels of the half resolution image from their averaged luma and
+// their VU pairs.
+inline void ConvertHalf8(const uint8x8_t& luma, const uint8x8_t& v8,
+                         const uint8x8_t& u8, uint8_t* rgb) {
+  using namespace tango_gl::yuv;
+  const uint8x8_t kChromaBias = vdup_n_u8(128);
+  int16x8_t v = vreinterpretq_s16_u16(vsubl_u8(v8, kChromaBias));
+  int16x8_t u = vreinterpretq_s16_u16(vsubl_u8(u8, kChromaBias));
+  int16x8_t y = vreinterpretq_s16_u16(vshll_n_u8(luma, kFixedPointShift));
+
+  int16x8_t r = vmulq_s16(v, vdupq_n_s16(kVToR));
+  int16x8_t g = vnegq_s16(
+      vmlaq_s16(vmulq_s16(v, vdupq_n_s16(kVToG)), u, vdupq_n_s16(kUToG)));
+  int16x8_t b = vmulq_s16(u, vdupq_n_s16(kUToB));
+
+  uint8x8x3_t pixels;
+  pixels.val[0] = ComputeHalfChannel(y, r);
+  pixels.val[1] = ComputeHalfChannel(y, g);
+  pixels.val[2] = ComputeHalfChannel(y, b);
+  vst3_u8(rgb, pixels);
+}
+
+// Average 2x2 luma blocks, 16 columns of a row pair into 8.
+inline uint8x8_t AverageLuma(const uint8_t* y_row0, const uint8_t* y_row1) {
+  return vrshrn_n_u16(
+      vaddq_u16(vpaddlq_u8(vld1q_u8(y_row0)), vpaddlq_u8(vld1q_u8(y_row1))),
+      2);
+}
+}  // namespace
+
+namespace tango_gl {
+namespace yuv {
+namespace internal {
+
+size_t ConvertNV21RowPairNeon(const uint8_t* y_row0, const uint8_t* y_row1,
+                              const uint8_t* vu_row, size_t width,
+                              uint8_t* rgb_row0, uint8_t* rgb_row1) {
+  const uint8x8_t kChromaBias = vdup_n_u8(128);
+  const int16x8_t kVToRVec = vdupq_n_s16(kVToR);
+  const int16x8_t kVToGVec = vdupq_n_s16(kVToG);
+  const int16x8_t kUToGVec = vdupq_n_s16(kUToG);
+  const int16x8_t kUToBVec = vdupq_n_s16(kUToB);
+
+  const size_t aligned_width = width & ~static_cast<size_t>(15);
+  for (size_t j = 0; j < aligned_width; j += 16) {
+    // 8 VU pairs cover the 16 pixels of both rows.
+    uint8x8x2_t vu = vld2_u8(vu_row + j);
+    int16x8_t v = vreinterpretq_s16_u16(vsubl_u8(vu.val[0], kChromaBias));
+    int16x8_t u = vreinterpretq_s16_u16(vsubl_u8(vu.val[1], kChromaBias));
+
+    int16x8_t r = vmulq_s16(v, kVToRVec);
+    int16x8_t g = vnegq_s16(vmlaq_s16(vmulq_s16(v, kVToGVec), u, kUToGVec));
+    int16x8_t b = vmulq_s16(u, kUToBVec);
+
+    // Each chroma sample is shared by two horizontal pixels.
+    int16x8x2_t r_chroma = vzipq_s16(r, r);
+    int16x8x2_t g_chroma = vzipq_s16(g, g);
+    int16x8x2_t b_chroma = vzipq_s16(b, b);
+
+    ConvertRow16(y_row0 + j, r_chroma, g_chroma, b_chroma, rgb_row0 + j * 3);
+    ConvertRow16(y_row1 + j, r_chroma, g_chroma, b_chroma, rgb_row1 + j * 3);
+  }
+  return aligned_width;
+}
+
+size_t ConvertNV21HalfRowNeon(const uint8_t* y_row0, const uint8_t* y_row1,
+                              const uint8_t* vu_row, size_t half_width,
+                              uint8_t* rgb_row) {
+  const size_t aligned_width = half_width & ~static_cast<size_t>(15);
+  for (size_t j = 0; j < aligned_width; j += 16) {
+    // One VU pair per output pixel, no duplication.
+    uint8x16x2_t vu = vld2q_u8(vu_row + 2 * j);
+    ConvertHalf8(AverageLuma(y_row0 + 2 * j, y_row1 + 2 * j),
+                 vget_low_u8(vu.val[0]), vget_low_u8(vu.val[1]),
+                 rgb_row + j * 3);
+    ConvertHalf8(AverageLuma(y_row0 + 2 * j + 16, y_row1 + 2 * j + 16),
+                 vget_high_u8(vu.val[0]), vget_high_u8(vu.val[1]),
+                 rgb_row + (j + 8) * 3);
+  }
+  return aligned_width;
+}
+
+}  // namespace internal
+}  // namespace yuv
+}  // namespace tango_gl
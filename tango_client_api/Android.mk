@@ -8,11 +8,19 @@
 #   $(call module-add-static-depends,<MY_MODULE>,AndroidSystemLibs)
 LOCAL_PATH := $(call my-dir)
 
+# The armeabi-v7a libraries are in lib/, the ones of other ABIs, e.g. the
+# 64-bit libraries of the Tango SDK, go in lib/$(TARGET_ARCH_ABI)/.
+ifeq ($(TARGET_ARCH_ABI),armeabi-v7a)
+TANGO_CLIENT_API_LIB_PATH := $(LOCAL_PATH)/lib
+else
+TANGO_CLIENT_API_LIB_PATH := $(LOCAL_PATH)/lib/$(TARGET_ARCH_ABI)
+endif
+
 include $(CLEAR_VARS)
 LOCAL_MODULE := tango_client_api
-LOCAL_EXPORT_LDLIBS := -L$(LOCAL_PATH)/lib \
+LOCAL_EXPORT_LDLIBS := -L$(TANGO_CLIENT_API_LIB_PATH) \
                        -ltango_client_api
 LOCAL_EXPORT_C_INCLUDES := $(LOCAL_PATH)/include
-LOCAL_SRC_FILES := $(LOCAL_PATH)/lib/libtango_client_stub.a
+LOCAL_SRC_FILES := $(TANGO_CLIENT_API_LIB_PATH)/libtango_client_stub.a
 
 include $(PREBUILT_STATIC_LIBRARY)
@@ -15,10 +15,18 @@
 LOCAL_PATH := $(call my-dir)
 PROJECT_ROOT:= $(LOCAL_PATH)/..
 
+# As for tango_client_api, libraries of ABIs other than armeabi-v7a go in
+# lib/$(TARGET_ARCH_ABI)/.
+ifeq ($(TARGET_ARCH_ABI),armeabi-v7a)
+TANGO_SUPPORT_API_LIB_PATH := $(LOCAL_PATH)/lib
+else
+TANGO_SUPPORT_API_LIB_PATH := $(LOCAL_PATH)/lib/$(TARGET_ARCH_ABI)
+endif
+
 include $(CLEAR_VARS)
 LOCAL_MODULE := tango_support_api
 LOCAL_EXPORT_C_INCLUDES := $(LOCAL_PATH)/include
-LOCAL_SRC_FILES := $(LOCAL_PATH)/lib/libtango_support_api.so
+LOCAL_SRC_FILES := $(TANGO_SUPPORT_API_LIB_PATH)/libtango_support_api.so
 include $(PREBUILT_SHARED_LIBRARY)
 
 $(call import-add-path,$(PROJECT_ROOT))
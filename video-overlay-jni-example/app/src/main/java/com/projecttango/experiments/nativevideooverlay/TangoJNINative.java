@@ -40,7 +40,8 @@ public class TangoJNINative {
   // holding from the Tango Service.
   public static native void disconnect();
 
-  // Release all OpenGL resources that are allocated from the program.
+  // Release all OpenGL resources that are allocated from the program. Must be
+  // called on the GL thread, e.g. through GLSurfaceView.queueEvent().
   public static native void freeGLContent();
 
   // Allocate OpenGL resources for rendering.
@@ -57,4 +58,10 @@ public class TangoJNINative {
 
   // Set texture method.
   public static native void setTextureMethod();
+
+  // Set texture method, the YUV conversion is done in the fragment shader.
+  public static native void setYUVShaderMethod();
+
+  // Show the fisheye camera in grayscale in a corner of the view.
+  public static native void setFisheyeEnabled(boolean enabled);
 }
@@ -29,11 +29,14 @@ public class VideoOverlayActivity extends Activity
     implements View.OnClickListener {
   public enum TextureMethod {
     YUV,
-    TEXTURE_ID
+    TEXTURE_ID,
+    YUV_SHADER
   }
 
   private GLSurfaceView glView;
   private ToggleButton mYUVRenderSwitcher;
+  private ToggleButton mYUVShaderSwitcher;
+  private ToggleButton mFisheyeSwitcher;
 
   @Override
   protected void onCreate(Bundle savedInstanceState) {
@@ -41,10 +44,18 @@ public class VideoOverlayActivity extends Activity
 
     setContentView(R.layout.activity_video_overlay);
     glView = (GLSurfaceView) findViewById(R.id.surfaceview);
+    // Keep the GL content across pause and resume, so resuming only
+    // reconnects to the Tango Service. The content is created again in
+    // onSurfaceCreated() if the context is lost anyway.
+    glView.setPreserveEGLContextOnPause(true);
     glView.setRenderer(new Renderer());
 
     mYUVRenderSwitcher = (ToggleButton) findViewById(R.id.yuv_switcher);
     mYUVRenderSwitcher.setOnClickListener(this);
+    mYUVShaderSwitcher = (ToggleButton) findViewById(R.id.yuv_shader_switcher);
+    mYUVShaderSwitcher.setOnClickListener(this);
+    mFisheyeSwitcher = (ToggleButton) findViewById(R.id.fisheye_switcher);
+    mFisheyeSwitcher.setOnClickListener(this);
 
     // Initialize Tango Service, this function starts the communication
     // between the application and Tango Service.
@@ -65,6 +76,7 @@ public class VideoOverlayActivity extends Activity
     TangoJNINative.connect();
 
     EnableYUVTexture(mYUVRenderSwitcher.isChecked());
+    TangoJNINative.setFisheyeEnabled(mFisheyeSwitcher.isChecked());
   }
 
   @Override
@@ -74,22 +86,29 @@ public class VideoOverlayActivity extends Activity
     // Disconnect from Tango Service, release all the resources that the app is
     // holding from Tango Service.
     TangoJNINative.disconnect();
-    TangoJNINative.freeGLContent();
   }
 
   @Override
   public void onClick(View v) {
     switch (v.getId()) {
     case R.id.yuv_switcher:
+    case R.id.yuv_shader_switcher:
       EnableYUVTexture(mYUVRenderSwitcher.isChecked());
       break;
+    case R.id.fisheye_switcher:
+      TangoJNINative.setFisheyeEnabled(mFisheyeSwitcher.isChecked());
+      break;
     }
   }
 
   private void EnableYUVTexture(boolean isEnabled) {
     if (isEnabled) {
-        // Turn on YUV
-        TangoJNINative.setYUVMethod();
+        // Turn on YUV, converted either on the GPU or on the CPU.
+        if (mYUVShaderSwitcher.isChecked()) {
+          TangoJNINative.setYUVShaderMethod();
+        } else {
+          TangoJNINative.setYUVMethod();
+        }
       } else {
         TangoJNINative.setTextureMethod();
       }
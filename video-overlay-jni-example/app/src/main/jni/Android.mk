@@ -21,22 +21,65 @@ include $(CLEAR_VARS)
 
 LOCAL_MODULE    := libvideo_overlay_jni_example
 LOCAL_SHARED_LIBRARIES := tango_client_api
+LOCAL_STATIC_LIBRARIES := cpufeatures
 LOCAL_CFLAGS    := -std=c++11
+# Uncomment to record a Chrome trace, written to the sdcard on disconnect.
+# LOCAL_CFLAGS    += -DTANGO_GL_TRACING
+# Per frame matrix math on NEON, part of the arm64-v8a baseline. armeabi-v7a
+# keeps the scalar glm path, see tango-gl/simd_math.h.
+ifeq ($(TARGET_ARCH_ABI),arm64-v8a)
+LOCAL_CFLAGS    += -DTANGO_GL_SIMD_MATH
+endif
 
 LOCAL_SRC_FILES := jni_interface.cc \
                    yuv_drawable.cc \
                    video_overlay_app.cc \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/camera_stream.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/counters.cpp \
                    $(PROJECT_ROOT_FROM_JNI)/tango-gl/drawable_object.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/energy_monitor.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/frame_arena.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/frame_constants.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/frame_profiler.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/geometry_registry.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/hardware_frame_queue.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/luminance_pyramid.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/memory_tracker.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/program_cache.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/render_pass.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/render_state.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/shader_variants.cpp \
                    $(PROJECT_ROOT_FROM_JNI)/tango-gl/shaders.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/streaming_texture.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/tracing.cpp \
                    $(PROJECT_ROOT_FROM_JNI)/tango-gl/transform.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/undistortion_mesh.cpp \
                    $(PROJECT_ROOT_FROM_JNI)/tango-gl/util.cpp \
-                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/video_overlay.cpp
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/vertex_array.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/vertex_buffer.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/video_overlay.cpp \
+                   $(PROJECT_ROOT_FROM_JNI)/tango-gl/yuv_converter.cpp
+
+# The NEON kernels are built with NEON enabled and selected at runtime, so the
+# library still runs on armeabi-v7a devices without NEON. arm64-v8a always
+# has NEON and needs no .neon suffix.
+TANGO_GL_NEON_SOURCES := $(PROJECT_ROOT_FROM_JNI)/tango-gl/luminance_pyramid_neon.cpp \
+                         $(PROJECT_ROOT_FROM_JNI)/tango-gl/yuv_converter_neon.cpp
+ifeq ($(TARGET_ARCH_ABI),armeabi-v7a)
+LOCAL_CFLAGS    += -DTANGO_GL_HAS_NEON
+LOCAL_SRC_FILES += $(addsuffix .neon,$(TANGO_GL_NEON_SOURCES))
+endif
+ifeq ($(TARGET_ARCH_ABI),arm64-v8a)
+LOCAL_CFLAGS    += -DTANGO_GL_HAS_NEON
+LOCAL_SRC_FILES += $(TANGO_GL_NEON_SOURCES)
+endif
 
 LOCAL_C_INCLUDES := $(PROJECT_ROOT)/tango-gl/include \
                     $(PROJECT_ROOT)/third-party/glm
 
-LOCAL_LDLIBS    := -llog -lGLESv2 -L$(SYSROOT)/usr/lib
+LOCAL_LDLIBS    := -llog -ldl -lGLESv2 -lEGL -L$(SYSROOT)/usr/lib
 include $(BUILD_SHARED_LIBRARY)
 
 $(call import-add-path, $(PROJECT_ROOT))
 $(call import-module,tango_client_api)
+$(call import-module,android/cpufeatures)
@@ -17,73 +17,87 @@
 #define GLM_FORCE_RADIANS
 
 #include <jni.h>
+#include <tango-gl/jni_natives.h>
 #include <tango-video-overlay/video_overlay_app.h>
 
-static tango_video_overlay::VideoOverlayApp app;
+namespace {
+tango_video_overlay::VideoOverlayApp app;
 
-#ifdef __cplusplus
-extern "C" {
-#endif
-JNIEXPORT jint JNICALL
-Java_com_projecttango_experiments_nativevideooverlay_TangoJNINative_initialize(
-    JNIEnv* env, jobject, jobject activity) {
+jint Initialize(JNIEnv* env, jobject, jobject activity) {
   return app.TangoInitialize(env, activity);
 }
 
-JNIEXPORT jint JNICALL
-Java_com_projecttango_experiments_nativevideooverlay_TangoJNINative_setupConfig(
-    JNIEnv*, jobject) {
+jint SetupConfig(JNIEnv*, jobject) {
   return app.TangoSetupConfig();
 }
 
-JNIEXPORT jint JNICALL
-Java_com_projecttango_experiments_nativevideooverlay_TangoJNINative_connect(
-    JNIEnv*, jobject) {
+jint Connect(JNIEnv*, jobject) {
   return app.TangoConnect();
 }
 
-JNIEXPORT void JNICALL
-Java_com_projecttango_experiments_nativevideooverlay_TangoJNINative_disconnect(
-    JNIEnv*, jobject) {
+void Disconnect(JNIEnv*, jobject) {
   app.TangoDisconnect();
 }
 
-JNIEXPORT void JNICALL
-Java_com_projecttango_experiments_nativevideooverlay_TangoJNINative_initGlContent(
-    JNIEnv*, jobject) {
+void InitGlContent(JNIEnv*, jobject) {
   app.InitializeGLContent();
 }
 
-JNIEXPORT void JNICALL
-Java_com_projecttango_experiments_nativevideooverlay_TangoJNINative_setupGraphic(
-    JNIEnv*, jobject, jint width, jint height) {
+void SetupGraphic(JNIEnv*, jobject, jint width, jint height) {
   app.SetViewPort(width, height);
 }
 
-JNIEXPORT void JNICALL
-Java_com_projecttango_experiments_nativevideooverlay_TangoJNINative_render(
-    JNIEnv*, jobject) {
+void Render(JNIEnv*, jobject) {
   app.Render();
 }
 
-JNIEXPORT void JNICALL
-Java_com_projecttango_experiments_nativevideooverlay_TangoJNINative_freeGLContent(
-    JNIEnv*, jobject) {
+void FreeGLContent(JNIEnv*, jobject) {
   app.FreeGLContent();
 }
 
-JNIEXPORT void JNICALL
-Java_com_projecttango_experiments_nativevideooverlay_TangoJNINative_setYUVMethod(
-    JNIEnv*, jobject) {
+void SetYUVMethod(JNIEnv*, jobject) {
   app.SetTextureMethod(0);
 }
 
-JNIEXPORT void JNICALL
-Java_com_projecttango_experiments_nativevideooverlay_TangoJNINative_setTextureMethod(
-    JNIEnv*, jobject) {
+void SetTextureMethod(JNIEnv*, jobject) {
   app.SetTextureMethod(1);
 }
 
+void SetYUVShaderMethod(JNIEnv*, jobject) {
+  app.SetTextureMethod(2);
+}
+
+void SetFisheyeEnabled(JNIEnv*, jobject, jboolean enabled) {
+  app.SetFisheyeEnabled(enabled);
+}
+
+const JNINativeMethod kNativeMethods[] = {
+    {"initialize",
+     "(Lcom/projecttango/experiments/nativevideooverlay/"
+     "VideoOverlayActivity;)I",
+     reinterpret_cast<void*>(Initialize)},
+    {"setupConfig", "()I", reinterpret_cast<void*>(SetupConfig)},
+    {"connect", "()I", reinterpret_cast<void*>(Connect)},
+    {"disconnect", "()V", reinterpret_cast<void*>(Disconnect)},
+    {"initGlContent", "()V", reinterpret_cast<void*>(InitGlContent)},
+    {"setupGraphic", "(II)V", reinterpret_cast<void*>(SetupGraphic)},
+    {"render", "()V", reinterpret_cast<void*>(Render)},
+    {"freeGLContent", "()V", reinterpret_cast<void*>(FreeGLContent)},
+    {"setYUVMethod", "()V", reinterpret_cast<void*>(SetYUVMethod)},
+    {"setTextureMethod", "()V", reinterpret_cast<void*>(SetTextureMethod)},
+    {"setYUVShaderMethod", "()V", reinterpret_cast<void*>(SetYUVShaderMethod)},
+    {"setFisheyeEnabled", "(Z)V", reinterpret_cast<void*>(SetFisheyeEnabled)},
+};
+}  // namespace
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+jint JNI_OnLoad(JavaVM* vm, void*) {
+  return tango_gl::jni::RegisterNatives(
+      vm, "com/projecttango/experiments/nativevideooverlay/TangoJNINative",
+      kNativeMethods);
+}
 #ifdef __cplusplus
 }
 #endif
@@ -17,12 +17,16 @@
 #ifndef TANGO_VIDEO_OVERLAY_VIDEO_OVERLAY_APP_H_
 #define TANGO_VIDEO_OVERLAY_VIDEO_OVERLAY_APP_H_
 
+#include <EGL/egl.h>
 #include <atomic>
 #include <jni.h>
 #include <memory>
 #include <mutex>
 
 #include <tango_client_api.h>  // NOLINT
+#include <tango-gl/camera_stream.h>
+#include <tango-gl/energy_monitor.h>
+#include <tango-gl/hardware_frame_queue.h>
 #include <tango-gl/util.h>
 #include <tango-video-overlay/yuv_drawable.h>
 #include <tango-gl/video_overlay.h>
@@ -37,12 +41,16 @@ class VideoOverlayApp {
   ~VideoOverlayApp();
 
   enum TextureMethod {
+    // Convert the NV21 frame to RGB on the CPU and upload it.
     kYUV,
-    kTextureId
+    // Let Tango Service update the external OES texture.
+    kTextureId,
+    // Upload the NV21 planes and convert them in the fragment shader.
+    kYUVShader
   };
 
-  // YUV data callback.
-  void OnFrameAvailable(const TangoImageBuffer* buffer);
+  // YUV data callback of the color and the fisheye camera.
+  void OnFrameAvailable(TangoCameraId camera, const TangoImageBuffer* buffer);
 
   // Initialize Tango Service, this function starts the communication
   // between the application and Tango Service.
@@ -63,6 +71,8 @@ class VideoOverlayApp {
   void TangoDisconnect();
 
   // Allocate OpenGL resources for rendering, mainly initializing the Scene.
+  // The resources are kept if they belong to the current EGL context, so a
+  // resume with a preserved context only reconnects to the Tango Service.
   void InitializeGLContent();
 
   // Setup the view port width and height.
@@ -71,13 +81,15 @@ class VideoOverlayApp {
   // Main render loop.
   void Render();
 
-  // Release all OpenGL resources that allocate from the program.
+  // Release all OpenGL resources that allocate from the program. Must be
+  // called on the GL thread.
   void FreeGLContent();
 
   // Set texture method.
-  void SetTextureMethod(int method) {
-    current_texture_method_ = static_cast<TextureMethod>(method);
-  }
+  void SetTextureMethod(int method);
+
+  // Show the fisheye camera in a corner, next to the color camera.
+  void SetFisheyeEnabled(bool enabled);
 
  private:
   // Tango configration file, this object is for configuring Tango Service setup
@@ -88,24 +100,54 @@ class VideoOverlayApp {
   // video_overlay_ render the camera video feedback onto the screen.
   tango_gl::VideoOverlay* video_overlay_drawable_;
   YUVDrawable* yuv_drawable_;
+  YUVDrawable* fisheye_drawable_;
+
+  // The EGL context the drawables were created in.
+  EGLContext gl_context_;
+
+  // Color camera texture of video_overlay_drawable_, 0 without GL content.
+  // Read by TangoConnect() on the UI thread.
+  std::atomic<GLuint> camera_texture_id_;
 
   TextureMethod current_texture_method_;
 
-  std::vector<uint8_t> yuv_buffer_;
-  std::vector<uint8_t> yuv_temp_buffer_;
-  std::vector<GLubyte> rgb_buffer_;
+  // Last YUV method rendered, used to refresh the textures when switching.
+  TextureMethod last_yuv_method_;
+
+  // Size of the GL view, picks the resolution of the RGB conversion.
+  int viewport_width_;
+  int viewport_height_;
+
+  // NV21 frames of the color camera handed from its callback thread to the
+  // GL thread.
+  tango_gl::CameraStream color_stream_;
 
-  std::atomic<bool> is_yuv_texture_available_;
-  std::atomic<bool> swap_buffer_signal_;
-  std::mutex yuv_buffer_mutex_;
+  // NV21 frames of the YUV shader method, written by the camera callback
+  // straight into buffers the GPU samples. Used when the platform supports
+  // it, set on the GL thread; color_stream_ and the texture uploads are the
+  // fallback.
+  tango_gl::HardwareFrameQueue hardware_frames_;
+  std::atomic<bool> use_hardware_frames_;
 
-  size_t yuv_width_;
-  size_t yuv_height_;
-  size_t yuv_size_;
-  size_t uv_buffer_offset_;
+  // Grayscale frames of the fisheye camera, at a lower frame rate.
+  tango_gl::CameraStream fisheye_stream_;
+  std::atomic<bool> is_fisheye_enabled_;
+
+  // Battery power per texture method, logged on disconnect, to compare the
+  // methods by energy per frame.
+  tango_gl::EnergyMonitor energy_monitor_;
 
-  void AllocateTexture(GLuint texture_id, int width, int height);
   void RenderYUV();
+  void RenderYUVShader();
+  void RenderHardwareFrame();
+  void RenderFisheye();
+
+  // Connect camera_texture_id_ to the color camera.
+  void ConnectCameraTexture();
+
+  // Attribute the energy from now on to the texture method and fisheye view.
+  void UpdateEnergyState();
+
   void RenderTextureId();
 };
 }  // namespace tango_video_overlay
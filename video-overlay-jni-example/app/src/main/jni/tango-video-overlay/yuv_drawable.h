@@ -18,22 +18,79 @@
 #define TANGO_VIDEO_OVERLAY_YUV_DRAWABLE_H_
 
 #include "tango-gl/drawable_object.h"
+#include "tango-gl/streaming_texture.h"
 
 namespace tango_video_overlay {
 class YUVDrawable : public tango_gl::DrawableObject {
  public:
+  // Texture layout sampled by the drawable.
+  enum TextureFormat {
+    // A single RGB texture, converted from YUV on the CPU.
+    kRGB,
+    // The raw NV21 planes: a GL_LUMINANCE Y texture and a half resolution
+    // GL_LUMINANCE_ALPHA VU texture, converted in the fragment shader.
+    kNV21,
+    // A GL_TEXTURE_EXTERNAL_OES texture of a hardware buffer, converted by
+    // the driver when sampled.
+    kExternal,
+    // A GL_LUMINANCE texture of a Y plane, drawn in grayscale.
+    kLuminance
+  };
+
   YUVDrawable();
+  ~YUVDrawable();
   void Render(const glm::mat4& projection_mat, const glm::mat4& view_mat) const;
-  GLuint GetTextureId() const { return texture_id_; }
-  void SetTextureId(GLuint texture_id) { texture_id_ = texture_id; }
 
- private:
-  // This id is populated on construction, and is passed to the tango service.
-  GLuint texture_id_;
+  // Returns the RGB texture id, 0 until the first RGB update.
+  GLuint GetTextureId() const { return rgb_texture_.GetTextureId(); }
+
+  // Start writing a RGB888 image in place, see
+  // tango_gl::StreamingTexture::BeginUpdate(). The texture is (re)allocated if
+  // the size changed.
+  uint8_t* BeginRGBUpdate(int width, int height);
+
+  // Upload the RGB image written since BeginRGBUpdate().
+  void EndRGBUpdate();
+
+  // Upload the Y and VU planes of a NV21 image.
+  void UpdateNV21(const uint8_t* nv21, int width, int height);
+
+  // Upload a Y plane, width * height bytes, for the kLuminance format.
+  void UpdateLuminance(const uint8_t* y, int width, int height);
+
+  // Set the external texture sampled by the kExternal format, it is owned by
+  // the caller.
+  void SetExternalTexture(GLuint texture) { external_texture_ = texture; }
 
+  void SetTextureFormat(TextureFormat format) { texture_format_ = format; }
+
+ private:
   GLuint attrib_texture_coords_;
   GLuint uniform_texture_;
   GLuint vertex_buffers_[3];
+
+  TextureFormat texture_format_;
+
+  tango_gl::StreamingTexture rgb_texture_;
+
+  // NV21 textures and the program doing the colorspace conversion. The Y
+  // texture alone is the kLuminance image.
+  tango_gl::StreamingTexture y_texture_;
+  tango_gl::StreamingTexture uv_texture_;
+  GLuint nv21_shader_program_;
+  GLuint nv21_attrib_vertices_;
+  GLuint nv21_attrib_texture_coords_;
+  GLuint nv21_uniform_mvp_mat_;
+  GLuint nv21_uniform_y_texture_;
+  GLuint nv21_uniform_uv_texture_;
+
+  // External texture and its program.
+  GLuint external_texture_;
+  GLuint external_shader_program_;
+  GLuint external_attrib_vertices_;
+  GLuint external_attrib_texture_coords_;
+  GLuint external_uniform_mvp_mat_;
+  GLuint external_uniform_texture_;
 };
 }  // namespace tango_video_overlay
 #endif  // TANGO_VIDEO_OVERLAY_YUV_DRAWABLE_H_
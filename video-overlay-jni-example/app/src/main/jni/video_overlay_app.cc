@@ -14,32 +14,58 @@
  * limitations under the License.
  */
 
+#include <string>
+
+#include <tango-gl/program_cache.h>
+#include <tango-gl/render_pass.h>
+#include <tango-gl/render_state.h>
+#include <tango-gl/tracing.h>
+#include <tango-gl/yuv_converter.h>
+
 #include "tango-video-overlay/video_overlay_app.h"
 
 namespace {
-void OnFrameAvailableRouter(void* context, TangoCameraId,
+// Where TangoDisconnect() writes the trace when built with TANGO_GL_TRACING.
+const char kTracePath[] = "/sdcard/video_overlay_trace.json";
+
+// The fisheye camera is a monitor next to the color camera, it keeps the Y
+// plane of at most this many frames per second.
+const double kFisheyeFrameRate = 15.0;
+
+// Size of the fisheye view in the corner, in normalized device coordinates.
+const float kFisheyeViewScale = 0.35f;
+
+tango_gl::CameraStream::Options GetFisheyeStreamOptions() {
+  tango_gl::CameraStream::Options options;
+  options.format = tango_gl::CameraStream::kLuminance;
+  options.max_frame_rate = kFisheyeFrameRate;
+  return options;
+}
+
+void OnFrameAvailableRouter(void* context, TangoCameraId camera,
                             const TangoImageBuffer* buffer) {
   using namespace tango_video_overlay;
   VideoOverlayApp* app = static_cast<VideoOverlayApp*>(context);
-  app->OnFrameAvailable(buffer);
-}
-
-// We could do this conversion in a fragment shader if all we care about is
-// rendering, but we show it here as an example of how people can use RGB data
-// on the CPU.
-inline void Yuv2Rgb(uint8_t yValue, uint8_t uValue, uint8_t vValue, uint8_t* r,
-                    uint8_t* g, uint8_t* b) {
-  *r = yValue + (1.370705 * (vValue - 128));
-  *g = yValue - (0.698001 * (vValue - 128)) - (0.337633 * (uValue - 128));
-  *b = yValue + (1.732446 * (uValue - 128));
+  app->OnFrameAvailable(camera, buffer);
 }
 }
 
 namespace tango_video_overlay {
 
-VideoOverlayApp::VideoOverlayApp() {
-  is_yuv_texture_available_ = false;
-  swap_buffer_signal_ = false;
+VideoOverlayApp::VideoOverlayApp()
+    : color_stream_(TANGO_CAMERA_COLOR, tango_gl::CameraStream::Options()),
+      fisheye_stream_(TANGO_CAMERA_FISHEYE, GetFisheyeStreamOptions()) {
+  tango_config_ = nullptr;
+  gl_context_ = EGL_NO_CONTEXT;
+  camera_texture_id_ = 0;
+  use_hardware_frames_ = false;
+  is_fisheye_enabled_ = false;
+  last_yuv_method_ = TextureMethod::kTextureId;
+  viewport_width_ = 0;
+  viewport_height_ = 0;
+  yuv_drawable_ = nullptr;
+  fisheye_drawable_ = nullptr;
+  video_overlay_drawable_ = nullptr;
 }
 
 VideoOverlayApp::~VideoOverlayApp() {
@@ -48,13 +74,19 @@ VideoOverlayApp::~VideoOverlayApp() {
   }
 }
 
-void VideoOverlayApp::OnFrameAvailable(const TangoImageBuffer* buffer) {
-  if (current_texture_method_ != TextureMethod::kYUV) {
+void VideoOverlayApp::OnFrameAvailable(TangoCameraId camera,
+                                       const TangoImageBuffer* buffer) {
+  TANGO_GL_TRACE_THREAD_NAME("OnFrameAvailable");
+  TANGO_GL_TRACE_SCOPE("OnFrameAvailable");
+  // Each camera calls back on its own thread, the streams are independent.
+  if (camera == TANGO_CAMERA_FISHEYE) {
+    if (is_fisheye_enabled_) {
+      fisheye_stream_.OnFrameAvailable(buffer);
+    }
     return;
   }
 
-  if (yuv_drawable_->GetTextureId() == 0) {
-    LOGE("VideoOverlayApp::yuv texture id not valid");
+  if (current_texture_method_ == TextureMethod::kTextureId) {
     return;
   }
 
@@ -63,30 +95,25 @@ void VideoOverlayApp::OnFrameAvailable(const TangoImageBuffer* buffer) {
     return;
   }
 
-  // The memory needs to be allocated after we get the first frame because we
-  // need to know the size of the image.
-  if (!is_yuv_texture_available_) {
-    yuv_width_ = buffer->width;
-    yuv_height_ = buffer->height;
-    uv_buffer_offset_ = yuv_width_ * yuv_height_;
-
-    yuv_size_ = yuv_width_ * yuv_height_ + yuv_width_ * yuv_height_ / 2;
-
-    // Reserve and resize the buffer size for RGB and YUV data.
-    yuv_buffer_.resize(yuv_size_);
-    yuv_temp_buffer_.resize(yuv_size_);
-    rgb_buffer_.resize(yuv_width_ * yuv_height_ * 3);
-
-    AllocateTexture(yuv_drawable_->GetTextureId(), yuv_width_, yuv_height_);
-    is_yuv_texture_available_ = true;
+  // The camera writes the frame once, into a buffer the GPU samples as is.
+  if (current_texture_method_ == TextureMethod::kYUVShader &&
+      use_hardware_frames_) {
+    if (hardware_frames_.PublishNV21(buffer->data, buffer->width,
+                                     buffer->height, buffer->stride)) {
+      return;
+    }
+    LOGE("VideoOverlayApp: Falling back to texture uploads");
+    use_hardware_frames_ = false;
   }
 
-  std::lock_guard<std::mutex> lock(yuv_buffer_mutex_);
-  memcpy(&yuv_temp_buffer_[0], buffer->data, yuv_size_);
-  swap_buffer_signal_ = true;
+  // The textures are (re)allocated on the GL thread, from the frame size.
+  color_stream_.OnFrameAvailable(buffer);
 }
 
 int VideoOverlayApp::TangoInitialize(JNIEnv* env, jobject caller_activity) {
+  // Linked shader programs are persisted in the app cache directory.
+  tango_gl::program_cache::SetBinaryCacheDirectory(env, caller_activity);
+
   // The first thing we need to do for any Tango enabled application is to
   // initialize the service. We'll do that here, passing on the JNI environment
   // and jobject corresponding to the Android activity that is calling us.
@@ -94,30 +121,45 @@ int VideoOverlayApp::TangoInitialize(JNIEnv* env, jobject caller_activity) {
 }
 
 int VideoOverlayApp::TangoSetupConfig() {
-  // Here, we'll configure the service to run in the way we'd want. For this
-  // application, we'll start from the default configuration
-  // (TANGO_CONFIG_DEFAULT). This enables basic motion tracking capabilities.
-  tango_config_ = TangoService_getConfig(TANGO_CONFIG_DEFAULT);
+  // The configuration is kept across pause and resume, only the callbacks
+  // have to be registered again after a disconnect.
   if (tango_config_ == nullptr) {
-    LOGE("VideoOverlayApp: Failed to get default config form");
-    return TANGO_ERROR;
-  }
+    // Here, we'll configure the service to run in the way we'd want. For this
+    // application, we'll start from the default configuration
+    // (TANGO_CONFIG_DEFAULT). This enables basic motion tracking
+    // capabilities.
+    tango_config_ = TangoService_getConfig(TANGO_CONFIG_DEFAULT);
+    if (tango_config_ == nullptr) {
+      LOGE("VideoOverlayApp: Failed to get default config form");
+      return TANGO_ERROR;
+    }
 
-  // Enable color camera from config.
-  int ret =
-      TangoConfig_setBool(tango_config_, "config_enable_color_camera", true);
-  if (ret != TANGO_SUCCESS) {
-    LOGE(
-        "VideoOverlayApp: config_enable_color_camera() failed with error"
-        "code: %d",
-        ret);
-    return ret;
+    // Enable color camera from config.
+    int ret =
+        TangoConfig_setBool(tango_config_, "config_enable_color_camera", true);
+    if (ret != TANGO_SUCCESS) {
+      LOGE(
+          "VideoOverlayApp: config_enable_color_camera() failed with error"
+          "code: %d",
+          ret);
+      TangoConfig_free(tango_config_);
+      tango_config_ = nullptr;
+      return ret;
+    }
   }
 
-  ret = TangoService_connectOnFrameAvailable(TANGO_CAMERA_COLOR, this,
+  int ret = TangoService_connectOnFrameAvailable(TANGO_CAMERA_COLOR, this,
                                              OnFrameAvailableRouter);
   if (ret != TANGO_SUCCESS) {
     LOGE("VideoOverlayApp: Error connecting color frame %d", ret);
+    return ret;
+  }
+
+  // The fisheye view is optional, the app runs without it.
+  if (TangoService_connectOnFrameAvailable(TANGO_CAMERA_FISHEYE, this,
+                                           OnFrameAvailableRouter) !=
+      TANGO_SUCCESS) {
+    LOGE("VideoOverlayApp: Error connecting fisheye frame");
   }
   return ret;
 }
@@ -133,30 +175,62 @@ int VideoOverlayApp::TangoConnect() {
         ret);
     return ret;
   }
+
+  // On a warm resume the GL context, and the camera texture with it, was
+  // kept, so InitializeGLContent() is not called again to connect it.
+  if (camera_texture_id_ != 0) {
+    ConnectCameraTexture();
+  }
+  energy_monitor_.Start();
   return ret;
 }
 
 void VideoOverlayApp::TangoDisconnect() {
-  // When disconnecting from the Tango Service, it is important to make sure to
-  // free your configuration object. Note that disconnecting from the service,
-  // resets all configuration, and disconnects all callbacks. If an application
-  // resumes after disconnecting, it must re-register configuration and
-  // callbacks with the service.
-  TangoConfig_free(tango_config_);
-  tango_config_ = nullptr;
+  // Disconnecting from the service disconnects all callbacks, so an
+  // application resuming after disconnecting must re-register them with the
+  // service. The configuration object is kept for the next connection and
+  // freed with the application.
   TangoService_disconnect();
+  TANGO_GL_TRACE_DUMP(kTracePath);
+  energy_monitor_.Stop();
+  LOGI("VideoOverlayApp: energy\n%s", energy_monitor_.GetReport().c_str());
 }
 
 void VideoOverlayApp::InitializeGLContent() {
+  // The GL content survives pause and resume as long as the EGL context is
+  // preserved, this is only called again when the context was lost.
+  EGLContext context = eglGetCurrentContext();
+  if (video_overlay_drawable_ != nullptr && context == gl_context_) {
+    return;
+  }
+  // The objects of a lost context are gone. Nothing has been allocated in the
+  // new context yet, so deleting their stale ids is a no-op.
+  FreeGLContent();
+  gl_context_ = context;
+
+  // Anything RenderState remembers belongs to the previous GL context.
+  tango_gl::RenderState::Invalidate();
+
   video_overlay_drawable_ = new tango_gl::VideoOverlay();
   yuv_drawable_ = new YUVDrawable();
+  fisheye_drawable_ = new YUVDrawable();
+  fisheye_drawable_->SetScale(
+      glm::vec3(kFisheyeViewScale, kFisheyeViewScale, 1.0f));
+  fisheye_drawable_->SetPosition(
+      glm::vec3(1.0f - kFisheyeViewScale, kFisheyeViewScale - 1.0f, 0.0f));
+  use_hardware_frames_ = tango_gl::HardwareFrameQueue::IsSupported();
 
   // Connect color camera texture. TangoService_connectTextureId expects a valid
   // texture id from the caller, so we will need to wait until the GL content is
   // properly allocated.
-  int texture_id = static_cast<int>(video_overlay_drawable_->GetTextureId());
+  camera_texture_id_ = video_overlay_drawable_->GetTextureId();
+  ConnectCameraTexture();
+}
+
+void VideoOverlayApp::ConnectCameraTexture() {
   TangoErrorType ret = TangoService_connectTextureId(
-      TANGO_CAMERA_COLOR, texture_id, nullptr, nullptr);
+      TANGO_CAMERA_COLOR, static_cast<int>(camera_texture_id_.load()), nullptr,
+      nullptr);
   if (ret != TANGO_SUCCESS) {
     LOGE(
         "VideoOverlayApp: Failed to connect the texture id with error"
@@ -166,12 +240,26 @@ void VideoOverlayApp::InitializeGLContent() {
 }
 
 void VideoOverlayApp::SetViewPort(int width, int height) {
+  viewport_width_ = width;
+  viewport_height_ = height;
   glViewport(0, 0, width, height);
 }
 
 void VideoOverlayApp::Render() {
-  glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
-  glClear(GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT);
+  TANGO_GL_TRACE_THREAD_NAME("GLThread");
+  TANGO_GL_TRACE_SCOPE("Render");
+  tango_gl::RenderState::BeginFrame();
+
+  // Nothing is drawn with depth. The texture id method draws the camera
+  // image over every pixel, the YUV methods draw nothing until the first
+  // frame arrives.
+  tango_gl::RenderPass::Options pass;
+  pass.clear_color = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
+  pass.depth_load = tango_gl::RenderPass::kDontCare;
+  if (current_texture_method_ == TextureMethod::kTextureId) {
+    pass.color_load = tango_gl::RenderPass::kDontCare;
+  }
+  tango_gl::RenderPass::Begin(0, viewport_width_, viewport_height_, pass);
   switch (current_texture_method_) {
     case TextureMethod::kYUV:
       RenderYUV();
@@ -179,69 +267,168 @@ void VideoOverlayApp::Render() {
     case TextureMethod::kTextureId:
       RenderTextureId();
       break;
+    case TextureMethod::kYUVShader:
+      RenderYUVShader();
+      break;
   }
+  if (is_fisheye_enabled_) {
+    RenderFisheye();
+  }
+  tango_gl::RenderPass::End();
+  energy_monitor_.OnFrame();
+}
+
+void VideoOverlayApp::SetTextureMethod(int method) {
+  current_texture_method_ = static_cast<TextureMethod>(method);
+  UpdateEnergyState();
+}
+
+void VideoOverlayApp::SetFisheyeEnabled(bool enabled) {
+  is_fisheye_enabled_ = enabled;
+  UpdateEnergyState();
+}
+
+void VideoOverlayApp::UpdateEnergyState() {
+  std::string state;
+  switch (current_texture_method_) {
+    case TextureMethod::kYUV:
+      state = "yuv";
+      break;
+    case TextureMethod::kTextureId:
+      state = "texture_id";
+      break;
+    case TextureMethod::kYUVShader:
+      state = "yuv_shader";
+      break;
+  }
+  if (is_fisheye_enabled_) {
+    state += " fisheye";
+  }
+  energy_monitor_.SetState(state);
 }
 
 void VideoOverlayApp::FreeGLContent() {
-  is_yuv_texture_available_ = false;
-  swap_buffer_signal_ = false;
-  rgb_buffer_.clear();
-  yuv_buffer_.clear();
-  yuv_temp_buffer_.clear();
+  camera_texture_id_ = 0;
+  gl_context_ = EGL_NO_CONTEXT;
+  last_yuv_method_ = TextureMethod::kTextureId;
+  hardware_frames_.ReleaseGL();
   delete yuv_drawable_;
+  delete fisheye_drawable_;
   delete video_overlay_drawable_;
+  yuv_drawable_ = nullptr;
+  fisheye_drawable_ = nullptr;
+  video_overlay_drawable_ = nullptr;
 }
 
-void VideoOverlayApp::AllocateTexture(GLuint texture_id, int width,
-                                      int height) {
+void VideoOverlayApp::RenderYUV() {
+  bool is_new_frame = false;
+  const tango_gl::CameraStream::Frame* yuv_frame =
+      color_stream_.Acquire(&is_new_frame);
+  if (yuv_frame == nullptr) {
+    return;
+  }
+
+  // Switching from another texture method, the texture may be stale.
+  if (last_yuv_method_ != TextureMethod::kYUV) {
+    is_new_frame = true;
+  }
+  last_yuv_method_ = TextureMethod::kYUV;
+
+  // We could do this conversion in a fragment shader if all we care about is
+  // rendering, but we show it here as an example of how people can use RGB
+  // data on the CPU. The converter uses a NEON kernel when the CPU supports
+  // it and falls back to a fixed-point scalar loop otherwise.
+  //
+  // The YUV texture format is NV21,
+  // yuv_frame buffer layout:
+  //   [y0, y1, y2, ..., yn, v0, u0, v1, u1, ..., v(n/4), u(n/4)]
+  //
+  // The texture is left untouched until the camera delivers a new frame. The
+  // RGB data is written straight into the texture's upload buffer. A view
+  // with no more than half the frame's pixels in each direction gets a half
+  // resolution image, a quarter of the pixels to convert and upload.
+  if (is_new_frame) {
+    const bool is_half_resolution =
+        viewport_width_ > 0 && viewport_height_ > 0 &&
+        2 * viewport_width_ <= yuv_frame->width &&
+        2 * viewport_height_ <= yuv_frame->height;
+    const int scale = is_half_resolution ? 2 : 1;
+    uint8_t* rgb = yuv_drawable_->BeginRGBUpdate(yuv_frame->width / scale,
+                                                 yuv_frame->height / scale);
+    if (rgb != nullptr && is_half_resolution) {
+      tango_gl::yuv::ConvertNV21ToHalfRGB(
+          yuv_frame->data.data(), yuv_frame->width, yuv_frame->height, rgb);
+    } else if (rgb != nullptr) {
+      tango_gl::yuv::ConvertNV21ToRGB(yuv_frame->data.data(), yuv_frame->width,
+                                      yuv_frame->height, rgb);
+    }
+    yuv_drawable_->EndRGBUpdate();
+  }
 
-  glBindTexture(GL_TEXTURE_2D, texture_id);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB,
-               GL_UNSIGNED_BYTE, rgb_buffer_.data());
+  yuv_drawable_->SetTextureFormat(YUVDrawable::kRGB);
+  yuv_drawable_->Render(glm::mat4(1.0f), glm::mat4(1.0f));
 }
 
-void VideoOverlayApp::RenderYUV() {
-  if (!is_yuv_texture_available_) {
+void VideoOverlayApp::RenderYUVShader() {
+  if (use_hardware_frames_) {
+    RenderHardwareFrame();
     return;
   }
-  {
-    std::lock_guard<std::mutex> lock(yuv_buffer_mutex_);
-    if (swap_buffer_signal_) {
-      std::swap(yuv_buffer_, yuv_temp_buffer_);
-      swap_buffer_signal_ = false;
-    }
+
+  bool is_new_frame = false;
+  const tango_gl::CameraStream::Frame* yuv_frame =
+      color_stream_.Acquire(&is_new_frame);
+  if (yuv_frame == nullptr) {
+    return;
   }
 
-  for (size_t i = 0; i < yuv_height_; ++i) {
-    for (size_t j = 0; j < yuv_width_; ++j) {
-      size_t x_index = j;
-      if (j % 2 != 0) {
-        x_index = j - 1;
-      }
-
-      size_t rgb_index = (i * yuv_width_ + j) * 3;
-
-      // The YUV texture format is NV21,
-      // yuv_buffer_ buffer layout:
-      //   [y0, y1, y2, ..., yn, v0, u0, v1, u1, ..., v(n/4), u(n/4)]
-      Yuv2Rgb(
-          yuv_buffer_[i * yuv_width_ + j],
-          yuv_buffer_[uv_buffer_offset_ + (i / 2) * yuv_width_ + x_index + 1],
-          yuv_buffer_[uv_buffer_offset_ + (i / 2) * yuv_width_ + x_index],
-          &rgb_buffer_[rgb_index], &rgb_buffer_[rgb_index + 1],
-          &rgb_buffer_[rgb_index + 2]);
-    }
+  if (last_yuv_method_ != TextureMethod::kYUVShader) {
+    is_new_frame = true;
   }
+  last_yuv_method_ = TextureMethod::kYUVShader;
 
-  glBindTexture(GL_TEXTURE_2D, yuv_drawable_->GetTextureId());
-  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, yuv_width_, yuv_height_, 0, GL_RGB,
-               GL_UNSIGNED_BYTE, rgb_buffer_.data());
+  // The fragment shader of yuv_drawable_ does the colorspace conversion.
+  if (is_new_frame) {
+    yuv_drawable_->UpdateNV21(yuv_frame->data.data(), yuv_frame->width,
+                              yuv_frame->height);
+  }
 
+  yuv_drawable_->SetTextureFormat(YUVDrawable::kNV21);
   yuv_drawable_->Render(glm::mat4(1.0f), glm::mat4(1.0f));
 }
 
+void VideoOverlayApp::RenderHardwareFrame() {
+  bool is_new_frame = false;
+  GLuint texture = hardware_frames_.AcquireTexture(&is_new_frame);
+  if (texture == 0) {
+    return;
+  }
+  last_yuv_method_ = TextureMethod::kYUVShader;
+
+  // Nothing is uploaded, the driver converts the colors when sampling.
+  yuv_drawable_->SetExternalTexture(texture);
+  yuv_drawable_->SetTextureFormat(YUVDrawable::kExternal);
+  yuv_drawable_->Render(glm::mat4(1.0f), glm::mat4(1.0f));
+  hardware_frames_.EndRead();
+}
+
+void VideoOverlayApp::RenderFisheye() {
+  bool is_new_frame = false;
+  const tango_gl::CameraStream::Frame* frame =
+      fisheye_stream_.Acquire(&is_new_frame);
+  if (frame == nullptr) {
+    return;
+  }
+
+  // Only the Y plane was kept, it is drawn as a grayscale texture.
+  if (is_new_frame) {
+    fisheye_drawable_->UpdateLuminance(frame->data.data(), frame->width,
+                                       frame->height);
+  }
+  fisheye_drawable_->SetTextureFormat(YUVDrawable::kLuminance);
+  fisheye_drawable_->Render(glm::mat4(1.0f), glm::mat4(1.0f));
+}
+
 void VideoOverlayApp::RenderTextureId() {
   double timestamp;
   // TangoService_updateTexture() updates target camera's
@@ -253,6 +440,8 @@ void VideoOverlayApp::RenderTextureId() {
         "%d",
         ret);
   }
+  // TangoService_updateTexture() binds the camera texture directly.
+  tango_gl::RenderState::Invalidate();
   video_overlay_drawable_->Render(glm::mat4(1.0f), glm::mat4(1.0f));
 }
 
@@ -14,6 +14,12 @@
  * limitations under the License.
  */
 
+#include <tango-gl/counters.h>
+#include <tango-gl/memory_tracker.h>
+#include <tango-gl/program_cache.h>
+#include <tango-gl/render_state.h>
+#include <tango-gl/shaders.h>
+
 #include "tango-video-overlay/yuv_drawable.h"
 
 namespace {
@@ -44,95 +50,211 @@ const std::string kFragmetnShader =
     "void main() {\n"
     "  gl_FragColor = texture2D(texture, f_textureCoords);\n"
     "}\n";
+
+// NV21 to RGB conversion with the same BT.601 coefficients as the CPU path.
+// The VU texture is GL_LUMINANCE_ALPHA, so V is replicated in rgb and U is
+// stored in alpha.
+const std::string kNV21FragmentShader =
+    "precision highp float;\n"
+    "precision highp int;\n"
+    "uniform sampler2D y_texture;\n"
+    "uniform sampler2D uv_texture;\n"
+    "varying vec2 f_textureCoords;\n"
+    "void main() {\n"
+    "  float y = texture2D(y_texture, f_textureCoords).r;\n"
+    "  vec4 vu = texture2D(uv_texture, f_textureCoords);\n"
+    "  float v = vu.r - 0.5019608;\n"
+    "  float u = vu.a - 0.5019608;\n"
+    "  gl_FragColor = vec4(y + 1.370705 * v,\n"
+    "                      y - 0.698001 * v - 0.337633 * u,\n"
+    "                      y + 1.732446 * u, 1.0);\n"
+    "}\n";
 }
 
 namespace tango_video_overlay {
 
-YUVDrawable::YUVDrawable() {
-  glEnable(GL_VERTEX_PROGRAM_POINT_SIZE);
-  shader_program_ = tango_gl::util::CreateProgram(kVertexShader.c_str(),
-                                                  kFragmetnShader.c_str());
+YUVDrawable::YUVDrawable() : texture_format_(kRGB), external_texture_(0) {
+  tango_gl::RenderState::Enable(GL_VERTEX_PROGRAM_POINT_SIZE);
+  shader_program_ = tango_gl::program_cache::AcquireProgram(
+      kVertexShader.c_str(), kFragmetnShader.c_str());
   if (!shader_program_) {
     LOGE("Could not create program.");
   }
 
-  glGenTextures(1, &texture_id_);
-  glBindTexture(GL_TEXTURE_2D, texture_id_);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
   uniform_texture_ = glGetUniformLocation(shader_program_, "texture");
 
   glGenBuffers(3, vertex_buffers_);
   // Allocate vertices buffer.
-  glBindBuffer(GL_ARRAY_BUFFER, vertex_buffers_[0]);
+  tango_gl::RenderState::BindBuffer(GL_ARRAY_BUFFER, vertex_buffers_[0]);
   glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * 3 * 4, kVertices,
                GL_STATIC_DRAW);
-  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  tango_gl::MemoryTracker::Track(tango_gl::MemoryTracker::kBuffer,
+                                 vertex_buffers_[0], "YuvDrawable",
+                                 sizeof(GLfloat) * 3 * 4);
+  tango_gl::RenderState::BindBuffer(GL_ARRAY_BUFFER, 0);
 
   // Allocate triangle indices buffer.
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, vertex_buffers_[1]);
+  tango_gl::RenderState::BindBuffer(GL_ELEMENT_ARRAY_BUFFER,
+                                    vertex_buffers_[1]);
   glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(GLushort) * 6, kIndices,
                GL_STATIC_DRAW);
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+  tango_gl::MemoryTracker::Track(tango_gl::MemoryTracker::kBuffer,
+                                 vertex_buffers_[1], "YuvDrawable",
+                                 sizeof(GLushort) * 6);
+  tango_gl::RenderState::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 
   // Allocate texture coordinates buufer.
-  glBindBuffer(GL_ARRAY_BUFFER, vertex_buffers_[2]);
+  tango_gl::RenderState::BindBuffer(GL_ARRAY_BUFFER, vertex_buffers_[2]);
   glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * 2 * 4, kTextureCoords,
                GL_STATIC_DRAW);
-  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  tango_gl::MemoryTracker::Track(tango_gl::MemoryTracker::kBuffer,
+                                 vertex_buffers_[2], "YuvDrawable",
+                                 sizeof(GLfloat) * 2 * 4);
+  tango_gl::RenderState::BindBuffer(GL_ARRAY_BUFFER, 0);
 
   // Assign the vertices attribute data.
   attrib_vertices_ = glGetAttribLocation(shader_program_, "vertex");
-  glBindBuffer(GL_ARRAY_BUFFER, vertex_buffers_[0]);
+  tango_gl::RenderState::BindBuffer(GL_ARRAY_BUFFER, vertex_buffers_[0]);
   glEnableVertexAttribArray(attrib_vertices_);
   glVertexAttribPointer(attrib_vertices_, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
-  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  tango_gl::RenderState::BindBuffer(GL_ARRAY_BUFFER, 0);
 
   // Assign the texture coordinates attribute data.
   attrib_texture_coords_ =
       glGetAttribLocation(shader_program_, "textureCoords");
-  glBindBuffer(GL_ARRAY_BUFFER, vertex_buffers_[2]);
+  tango_gl::RenderState::BindBuffer(GL_ARRAY_BUFFER, vertex_buffers_[2]);
   glEnableVertexAttribArray(attrib_texture_coords_);
   glVertexAttribPointer(attrib_texture_coords_, 2, GL_FLOAT, GL_FALSE, 0,
                         nullptr);
-  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  tango_gl::RenderState::BindBuffer(GL_ARRAY_BUFFER, 0);
 
   uniform_mvp_mat_ = glGetUniformLocation(shader_program_, "mvp");
+
+  // The NV21 program shares the vertex shader and the vertex buffers.
+  nv21_shader_program_ = tango_gl::program_cache::AcquireProgram(
+      kVertexShader.c_str(), kNV21FragmentShader.c_str());
+  if (!nv21_shader_program_) {
+    LOGE("Could not create NV21 program.");
+  }
+  nv21_attrib_vertices_ = glGetAttribLocation(nv21_shader_program_, "vertex");
+  nv21_attrib_texture_coords_ =
+      glGetAttribLocation(nv21_shader_program_, "textureCoords");
+  nv21_uniform_mvp_mat_ = glGetUniformLocation(nv21_shader_program_, "mvp");
+  nv21_uniform_y_texture_ =
+      glGetUniformLocation(nv21_shader_program_, "y_texture");
+  nv21_uniform_uv_texture_ =
+      glGetUniformLocation(nv21_shader_program_, "uv_texture");
+
+  // The external program samples with the video overlay fragment shader.
+  external_shader_program_ = tango_gl::program_cache::AcquireProgram(
+      kVertexShader.c_str(),
+      tango_gl::shaders::GetVideoOverlayFragmentShader().c_str());
+  if (!external_shader_program_) {
+    LOGE("Could not create external texture program.");
+  }
+  external_attrib_vertices_ =
+      glGetAttribLocation(external_shader_program_, "vertex");
+  external_attrib_texture_coords_ =
+      glGetAttribLocation(external_shader_program_, "textureCoords");
+  external_uniform_mvp_mat_ =
+      glGetUniformLocation(external_shader_program_, "mvp");
+  external_uniform_texture_ =
+      glGetUniformLocation(external_shader_program_, "texture");
+}
+
+YUVDrawable::~YUVDrawable() {
+  tango_gl::program_cache::ReleaseProgram(nv21_shader_program_);
+  tango_gl::program_cache::ReleaseProgram(external_shader_program_);
+}
+
+uint8_t* YUVDrawable::BeginRGBUpdate(int width, int height) {
+  rgb_texture_.Allocate(width, height, GL_RGB);
+  return rgb_texture_.BeginUpdate();
+}
+
+void YUVDrawable::EndRGBUpdate() { rgb_texture_.EndUpdate(); }
+
+void YUVDrawable::UpdateNV21(const uint8_t* nv21, int width, int height) {
+  // The Y plane is a full resolution GL_LUMINANCE texture, and the
+  // interleaved VU plane a half resolution GL_LUMINANCE_ALPHA texture.
+  y_texture_.Allocate(width, height, GL_LUMINANCE);
+  uv_texture_.Allocate(width / 2, height / 2, GL_LUMINANCE_ALPHA);
+  y_texture_.Update(nv21);
+  uv_texture_.Update(nv21 + width * height);
+}
+
+void YUVDrawable::UpdateLuminance(const uint8_t* y, int width, int height) {
+  y_texture_.Allocate(width, height, GL_LUMINANCE);
+  y_texture_.Update(y);
 }
 
 void YUVDrawable::Render(const glm::mat4& projection_mat,
                          const glm::mat4& view_mat) const {
-  glUseProgram(shader_program_);
+  GLuint attrib_vertices = attrib_vertices_;
+  GLuint attrib_texture_coords = attrib_texture_coords_;
+  GLuint uniform_mvp_mat = uniform_mvp_mat_;
+
+  if (texture_format_ == kNV21) {
+    tango_gl::RenderState::UseProgram(nv21_shader_program_);
+    attrib_vertices = nv21_attrib_vertices_;
+    attrib_texture_coords = nv21_attrib_texture_coords_;
+    uniform_mvp_mat = nv21_uniform_mvp_mat_;
+
+    glUniform1i(nv21_uniform_y_texture_, 2);
+    tango_gl::RenderState::ActiveTexture(GL_TEXTURE2);
+    tango_gl::RenderState::BindTexture(GL_TEXTURE_2D,
+                                       y_texture_.GetTextureId());
 
-  glUniform1i(uniform_texture_, 2);
-  glActiveTexture(GL_TEXTURE2);
-  glBindTexture(GL_TEXTURE_2D, texture_id_);
+    glUniform1i(nv21_uniform_uv_texture_, 3);
+    tango_gl::RenderState::ActiveTexture(GL_TEXTURE3);
+    tango_gl::RenderState::BindTexture(GL_TEXTURE_2D,
+                                       uv_texture_.GetTextureId());
+  } else if (texture_format_ == kExternal) {
+    tango_gl::RenderState::UseProgram(external_shader_program_);
+    attrib_vertices = external_attrib_vertices_;
+    attrib_texture_coords = external_attrib_texture_coords_;
+    uniform_mvp_mat = external_uniform_mvp_mat_;
+
+    glUniform1i(external_uniform_texture_, 2);
+    tango_gl::RenderState::ActiveTexture(GL_TEXTURE2);
+    tango_gl::RenderState::BindTexture(GL_TEXTURE_EXTERNAL_OES,
+                                       external_texture_);
+  } else {
+    tango_gl::RenderState::UseProgram(shader_program_);
+
+    // A luminance texture samples as (y, y, y, 1).
+    glUniform1i(uniform_texture_, 2);
+    tango_gl::RenderState::ActiveTexture(GL_TEXTURE2);
+    tango_gl::RenderState::BindTexture(
+        GL_TEXTURE_2D, texture_format_ == kLuminance
+                           ? y_texture_.GetTextureId()
+                           : rgb_texture_.GetTextureId());
+  }
 
   glm::mat4 model_mat = GetTransformationMatrix();
   glm::mat4 mvp_mat = projection_mat * view_mat * model_mat;
-  glUniformMatrix4fv(uniform_mvp_mat_, 1, GL_FALSE, glm::value_ptr(mvp_mat));
+  glUniformMatrix4fv(uniform_mvp_mat, 1, GL_FALSE, glm::value_ptr(mvp_mat));
 
   // Bind vertices buffer.
-  glBindBuffer(GL_ARRAY_BUFFER, vertex_buffers_[0]);
-  glEnableVertexAttribArray(attrib_vertices_);
-  glVertexAttribPointer(attrib_vertices_, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
-  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  tango_gl::RenderState::BindBuffer(GL_ARRAY_BUFFER, vertex_buffers_[0]);
+  glEnableVertexAttribArray(attrib_vertices);
+  glVertexAttribPointer(attrib_vertices, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
 
   // Bind texture coordinates buffer.
-  glBindBuffer(GL_ARRAY_BUFFER, vertex_buffers_[2]);
-  glEnableVertexAttribArray(attrib_texture_coords_);
-  glVertexAttribPointer(attrib_texture_coords_, 2, GL_FLOAT, GL_FALSE, 0,
+  tango_gl::RenderState::BindBuffer(GL_ARRAY_BUFFER, vertex_buffers_[2]);
+  glEnableVertexAttribArray(attrib_texture_coords);
+  glVertexAttribPointer(attrib_texture_coords, 2, GL_FLOAT, GL_FALSE, 0,
                         nullptr);
-  glBindBuffer(GL_ARRAY_BUFFER, 0);
 
   // Bind element array buffer.
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, vertex_buffers_[1]);
+  tango_gl::RenderState::BindBuffer(GL_ELEMENT_ARRAY_BUFFER,
+                                    vertex_buffers_[1]);
+  tango_gl::Counters::Increment(tango_gl::Counters::kDrawCalls);
   glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, 0);
   tango_gl::util::CheckGlError("glDrawElements");
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 
-  glUseProgram(0);
-  tango_gl::util::CheckGlError("glUseProgram()");
+  // The Tango C-API binds the color texture to the active unit.
+  tango_gl::RenderState::ActiveTexture(GL_TEXTURE0);
 }
 
 }  // namespace tango_video_overlay